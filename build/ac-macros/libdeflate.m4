@@ -0,0 +1,95 @@
+dnl ===================================================================
+dnl   Licensed to the Apache Software Foundation (ASF) under one
+dnl   or more contributor license agreements.  See the NOTICE file
+dnl   distributed with this work for additional information
+dnl   regarding copyright ownership.  The ASF licenses this file
+dnl   to you under the Apache License, Version 2.0 (the
+dnl   "License"); you may not use this file except in compliance
+dnl   with the License.  You may obtain a copy of the License at
+dnl
+dnl     http://www.apache.org/licenses/LICENSE-2.0
+dnl
+dnl   Unless required by applicable law or agreed to in writing,
+dnl   software distributed under the License is distributed on an
+dnl   "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+dnl   KIND, either express or implied.  See the License for the
+dnl   specific language governing permissions and limitations
+dnl   under the License.
+dnl ===================================================================
+dnl
+dnl libdeflate is optional.  The default behaviour is to use pkg-config
+dnl to look for a libdeflate library and if that fails to simply try
+dnl linking -ldeflate.  If neither works, whole buffer zlib compression
+dnl (svndiff1 and others) falls back to the stock zlib routines.
+dnl
+dnl The user can specify --with-libdeflate=PREFIX to look in PREFIX or
+dnl --without-libdeflate to disable libdeflate support.
+
+AC_DEFUN(SVN_LIBDEFLATE,
+[
+  AC_ARG_WITH([libdeflate],
+    [AS_HELP_STRING([--with-libdeflate=PREFIX],
+                    [look for libdeflate in PREFIX])],
+    [libdeflate_prefix="$withval"],
+    [libdeflate_prefix=std])
+
+  libdeflate_found=no
+  if test "$libdeflate_prefix" = "no"; then
+    AC_MSG_NOTICE([libdeflate support disabled])
+  else
+    if test "$libdeflate_prefix" = "std" \
+       || test "$libdeflate_prefix" = "yes"; then
+      SVN_LIBDEFLATE_STD
+    else
+      SVN_LIBDEFLATE_PREFIX
+    fi
+    if test "$libdeflate_found" = "yes"; then
+      AC_DEFINE([SVN_HAVE_LIBDEFLATE], [1],
+                [Defined if libdeflate is used for zlib compression])
+    elif test "$libdeflate_prefix" != "std"; then
+      AC_MSG_ERROR([libdeflate was requested but could not be found])
+    else
+      AC_MSG_NOTICE([libdeflate not found, using zlib for all compression])
+    fi
+  fi
+  AC_SUBST(SVN_LIBDEFLATE_INCLUDES)
+  AC_SUBST(SVN_LIBDEFLATE_LIBS)
+])
+
+AC_DEFUN(SVN_LIBDEFLATE_STD,
+[
+  if test -n "$PKG_CONFIG"; then
+    AC_MSG_CHECKING([for libdeflate library via pkg-config])
+    if $PKG_CONFIG libdeflate --atleast-version=1.0; then
+      AC_MSG_RESULT([yes])
+      libdeflate_found=yes
+      SVN_LIBDEFLATE_INCLUDES=`$PKG_CONFIG libdeflate --cflags`
+      SVN_LIBDEFLATE_LIBS=`$PKG_CONFIG libdeflate --libs`
+      SVN_LIBDEFLATE_LIBS="`SVN_REMOVE_STANDARD_LIB_DIRS($SVN_LIBDEFLATE_LIBS)`"
+    else
+      AC_MSG_RESULT([no])
+    fi
+  else
+    AC_MSG_NOTICE([libdeflate configuration without pkg-config])
+    AC_CHECK_LIB(deflate, libdeflate_zlib_compress, [
+      libdeflate_found=yes
+      SVN_LIBDEFLATE_LIBS="-ldeflate"
+    ])
+  fi
+])
+
+AC_DEFUN(SVN_LIBDEFLATE_PREFIX,
+[
+  AC_MSG_NOTICE([libdeflate configuration via prefix])
+  save_cppflags="$CPPFLAGS"
+  CPPFLAGS="$CPPFLAGS -I$libdeflate_prefix/include"
+  save_ldflags="$LDFLAGS"
+  LDFLAGS="$LDFLAGS -L$libdeflate_prefix/lib"
+  AC_CHECK_LIB(deflate, libdeflate_zlib_compress, [
+    libdeflate_found=yes
+    SVN_LIBDEFLATE_INCLUDES="-I$libdeflate_prefix/include"
+    SVN_LIBDEFLATE_LIBS="`SVN_REMOVE_STANDARD_LIB_DIRS(-L$libdeflate_prefix/lib)` -ldeflate"
+  ])
+  LDFLAGS="$save_ldflags"
+  CPPFLAGS="$save_cppflags"
+])
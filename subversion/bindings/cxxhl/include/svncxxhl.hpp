@@ -30,6 +30,8 @@
 
 // Expose the whole API and alias the default version namespace
 #include "svncxxhl/exception.hpp"
+#include "svncxxhl/result.hpp"
+#include "svncxxhl/string_view.hpp"
 #include "svncxxhl/tristate.hpp"
 
 namespace SVN = ::apache::subversion::cxxhl;
@@ -0,0 +1,101 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#ifndef __cplusplus
+#error "This is a C++ header file."
+#endif
+
+#ifndef SVN_CXXHL_RESULT_HPP
+#define SVN_CXXHL_RESULT_HPP
+
+#include "svncxxhl/_compat.hpp"
+#include "svncxxhl/string_view.hpp"
+
+namespace apache {
+namespace subversion {
+namespace cxxhl {
+
+// Forward declaration
+namespace apr {
+class Pool;
+} // namespace apr
+
+/**
+ * Base class for result objects whose data are allocated in an APR
+ * pool (the "arena") owned by the result.
+ *
+ * Copies of a result share its arena, so copying a result never
+ * duplicates its data. String views returned by a result remain valid
+ * for as long as any copy of that result exists.
+ */
+class Result
+{
+public:
+  /**
+   * Return @c true if this result has an arena, i.e., if it was
+   * not default-constructed.
+   */
+  bool valid() const throw()
+    {
+      return (m_arena.get() != 0);
+    }
+
+protected:
+  typedef compat::shared_ptr<apr::Pool> Arena;
+
+  Result() {}
+
+  explicit Result(const Arena& arena)
+    : m_arena(arena)
+    {}
+
+  /**
+   * Create a new, empty arena for a result.
+   */
+  static Arena make_arena();
+
+  /**
+   * Return the arena of this result.
+   */
+  const Arena& arena() const throw()
+    {
+      return m_arena;
+    }
+
+  /**
+   * Copy @a str into the arena and return a view of the copy.
+   * Used when results are filled from data that the arena does not
+   * own, e.g., strings that live in a scratch pool. This result
+   * must be valid().
+   */
+  StringView intern(const StringView& str) const;
+
+private:
+  Arena m_arena;
+};
+
+} // namespace cxxhl
+} // namespace subversion
+} // namespace apache
+
+#endif  // SVN_CXXHL_RESULT_HPP
@@ -0,0 +1,138 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#ifndef __cplusplus
+#error "This is a C++ header file."
+#endif
+
+#ifndef SVN_CXXHL_STRING_VIEW_HPP
+#define SVN_CXXHL_STRING_VIEW_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace apache {
+namespace subversion {
+namespace cxxhl {
+
+/**
+ * Non-owning, immutable reference to a sequence of characters.
+ *
+ * Used by result objects to expose strings that live in their APR
+ * pools without copying them. A view is only valid for as long as the
+ * object that it was obtained from.
+ */
+class StringView
+{
+public:
+  typedef char value_type;
+  typedef std::size_t size_type;
+  typedef const char* const_iterator;
+
+  /**
+   * Create an empty view.
+   */
+  StringView() throw()
+    : m_data(""), m_size(0)
+    {}
+
+  /**
+   * Create a view of the NUL-terminated string @a str.
+   */
+  StringView(const char* str) throw()
+    : m_data(str), m_size(std::strlen(str))
+    {}
+
+  /**
+   * Create a view of the first @a size characters at @a data.
+   */
+  StringView(const char* data, size_type size) throw()
+    : m_data(data), m_size(size)
+    {}
+
+  /**
+   * Create a view of the contents of @a str.
+   */
+  StringView(const std::string& str) throw()
+    : m_data(str.data()), m_size(str.size())
+    {}
+
+  const char* data() const throw() { return m_data; }
+  size_type size() const throw() { return m_size; }
+  size_type length() const throw() { return m_size; }
+  bool empty() const throw() { return !m_size; }
+
+  const_iterator begin() const throw() { return m_data; }
+  const_iterator end() const throw() { return m_data + m_size; }
+
+  char operator[](size_type index) const throw()
+    {
+      return m_data[index];
+    }
+
+  /**
+   * Return a copy of the viewed characters.
+   */
+  std::string str() const
+    {
+      return std::string(m_data, m_size);
+    }
+
+  /**
+   * Compare with @a that like std::string::compare.
+   */
+  int compare(const StringView& that) const throw()
+    {
+      const size_type len = (m_size < that.m_size ? m_size : that.m_size);
+      const int cmp = (len ? std::memcmp(m_data, that.m_data, len) : 0);
+      if (cmp)
+        return cmp;
+      return (m_size < that.m_size ? -1 : (m_size > that.m_size ? 1 : 0));
+    }
+
+private:
+  const char* m_data;
+  size_type m_size;
+};
+
+inline bool operator==(const StringView& a, const StringView& b) throw()
+{
+  return a.size() == b.size() && !a.compare(b);
+}
+
+inline bool operator!=(const StringView& a, const StringView& b) throw()
+{
+  return !(a == b);
+}
+
+inline bool operator<(const StringView& a, const StringView& b) throw()
+{
+  return a.compare(b) < 0;
+}
+
+} // namespace cxxhl
+} // namespace subversion
+} // namespace apache
+
+#endif  // SVN_CXXHL_STRING_VIEW_HPP
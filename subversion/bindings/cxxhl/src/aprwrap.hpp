@@ -28,6 +28,7 @@
 #include "aprwrap/pool.hpp"
 #include "aprwrap/hash.hpp"
 #include "aprwrap/array.hpp"
+#include "aprwrap/allocator.hpp"
 
 namespace APR = ::apache::subversion::cxxhl::apr;
 
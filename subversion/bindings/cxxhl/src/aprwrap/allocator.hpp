@@ -0,0 +1,150 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#ifndef SVN_CXXHL_PRIVATE_APRWRAP_ALLOCATOR_H
+#define SVN_CXXHL_PRIVATE_APRWRAP_ALLOCATOR_H
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+#include "pool.hpp"
+
+namespace apache {
+namespace subversion {
+namespace cxxhl {
+namespace apr {
+
+/**
+ * Standard allocator that allocates memory from an APR pool.
+ *
+ * Use this to build standard containers directly inside a pool, e.g.,
+ * @c std::vector<T, PoolAllocator<T> >. Deallocation is a no-op; the
+ * memory is released together with the pool, so containers using
+ * this allocator must not outlive it. Containers that repeatedly grow
+ * and shrink will keep consuming pool memory.
+ */
+template<typename T>
+class PoolAllocator
+{
+public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+
+  template<typename U>
+  struct rebind
+  {
+    typedef PoolAllocator<U> other;
+  };
+
+  /**
+   * Create an allocator that uses @a pool.
+   */
+  explicit PoolAllocator(const Pool& pool) throw()
+    : m_pool(pool.get())
+    {}
+
+  /**
+   * Create an allocator that uses the APR pool @a pool.
+   */
+  explicit PoolAllocator(apr_pool_t* pool) throw()
+    : m_pool(pool)
+    {}
+
+  template<typename U>
+  PoolAllocator(const PoolAllocator<U>& that) throw()
+    : m_pool(that.pool())
+    {}
+
+  /**
+   * Return the APR pool used by this allocator.
+   */
+  apr_pool_t* pool() const throw()
+    {
+      return m_pool;
+    }
+
+  pointer address(reference value) const throw()
+    {
+      return &value;
+    }
+
+  const_pointer address(const_reference value) const throw()
+    {
+      return &value;
+    }
+
+  pointer allocate(size_type count, const void* = 0)
+    {
+      if (count > max_size())
+        throw std::bad_alloc();
+      return static_cast<pointer>(apr_palloc(m_pool, count * sizeof(T)));
+    }
+
+  void deallocate(pointer, size_type) throw()
+    {}
+
+  size_type max_size() const throw()
+    {
+      return std::numeric_limits<size_type>::max() / sizeof(T);
+    }
+
+  void construct(pointer ptr, const_reference value)
+    {
+      new(static_cast<void*>(ptr)) T(value);
+    }
+
+  void destroy(pointer ptr)
+    {
+      ptr->~T();
+    }
+
+private:
+  apr_pool_t* m_pool;
+};
+
+template<typename T, typename U>
+inline bool operator==(const PoolAllocator<T>& a,
+                       const PoolAllocator<U>& b) throw()
+{
+  return a.pool() == b.pool();
+}
+
+template<typename T, typename U>
+inline bool operator!=(const PoolAllocator<T>& a,
+                       const PoolAllocator<U>& b) throw()
+{
+  return !(a == b);
+}
+
+} // namespace apr
+} // namespace cxxhl
+} // namespace subversion
+} // namespace apache
+
+#endif // SVN_CXXHL_PRIVATE_APRWRAP_ALLOCATOR_H
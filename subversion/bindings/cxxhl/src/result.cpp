@@ -0,0 +1,48 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#include <cstring>
+
+#include "svncxxhl/result.hpp"
+#include "aprwrap.hpp"
+
+namespace apache {
+namespace subversion {
+namespace cxxhl {
+
+Result::Arena Result::make_arena()
+{
+  return Arena(new apr::Pool());
+}
+
+StringView Result::intern(const StringView& str) const
+{
+  char* const copy = m_arena->alloc<char>(str.size() + 1);
+  std::memcpy(copy, str.data(), str.size());
+  copy[str.size()] = 0;
+  return StringView(copy, str.size());
+}
+
+} // namespace cxxhl
+} // namespace subversion
+} // namespace apache
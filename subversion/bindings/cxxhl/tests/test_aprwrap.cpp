@@ -20,7 +20,10 @@
  */
 
 #include <algorithm>
+#include <functional>
+#include <map>
 #include <stdexcept>
+#include <vector>
 
 #include "../src/aprwrap.hpp"
 
@@ -433,3 +436,37 @@ TEST(Hashes, Iterate)
 
   hash.iterate(callback, pool);
 }
+
+//
+// Allocators
+//
+
+TEST(Allocators, Vector)
+{
+  typedef APR::PoolAllocator<int> Allocator;
+
+  APR::Pool pool;
+  std::vector<int, Allocator> vec((Allocator(pool)));
+  for (int i = 0; i < 1000; ++i)
+    vec.push_back(i);
+
+  EXPECT_EQ(1000, vec.size());
+  EXPECT_EQ(999, vec.back());
+  EXPECT_EQ(pool.get(), vec.get_allocator().pool());
+}
+
+TEST(Allocators, Map)
+{
+  typedef std::pair<const int, const char*> Value;
+  typedef APR::PoolAllocator<Value> Allocator;
+  typedef std::map<int, const char*, std::less<int>, Allocator> Map;
+
+  APR::Pool pool;
+  Map map((std::less<int>()), Allocator(pool));
+  map[2] = "secundus";
+  map[1] = "primus";
+
+  EXPECT_EQ(2, map.size());
+  EXPECT_STREQ("primus", map.begin()->second);
+  EXPECT_TRUE(map.get_allocator() == APR::PoolAllocator<int>(pool));
+}
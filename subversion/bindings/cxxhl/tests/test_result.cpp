@@ -0,0 +1,113 @@
+/*
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <algorithm>
+
+#include <string>
+
+#include "svncxxhl.hpp"
+
+#include <gmock/gmock.h>
+
+//
+// StringView
+//
+
+TEST(StringViews, Construct)
+{
+  const std::string str("primus");
+  const SVN::StringView empty;
+  const SVN::StringView cstr("secundus");
+  const SVN::StringView sized("tertius", 3);
+  const SVN::StringView fromstr(str);
+
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(0, empty.size());
+  EXPECT_EQ(8, cstr.size());
+  EXPECT_EQ("ter", sized.str());
+  EXPECT_EQ(str.data(), fromstr.data());
+  EXPECT_EQ(str.size(), fromstr.length());
+}
+
+TEST(StringViews, Compare)
+{
+  EXPECT_TRUE(SVN::StringView("abc") == SVN::StringView("abcd", 3));
+  EXPECT_TRUE(SVN::StringView("abc") != SVN::StringView("abd"));
+  EXPECT_TRUE(SVN::StringView("ab") < SVN::StringView("abc"));
+  EXPECT_TRUE(SVN::StringView("abc") < SVN::StringView("b"));
+  EXPECT_FALSE(SVN::StringView("b") < SVN::StringView("b"));
+  EXPECT_EQ(0, SVN::StringView().compare(SVN::StringView("")));
+}
+
+//
+// Result
+//
+
+namespace {
+class TestResult : public SVN::Result
+{
+public:
+  TestResult() {}
+
+  explicit TestResult(const char* name)
+    : SVN::Result(make_arena())
+    {
+      m_name = intern(name);
+    }
+
+  SVN::StringView name() const { return m_name; }
+  const void* arena_ptr() const { return arena().get(); }
+
+private:
+  SVN::StringView m_name;
+};
+} // anonymous namespace
+
+TEST(Results, DefaultIsInvalid)
+{
+  TestResult result;
+  EXPECT_FALSE(result.valid());
+}
+
+TEST(Results, InternCopies)
+{
+  char name[] = "quartus";
+  TestResult result(name);
+  name[0] = 'Q';
+
+  EXPECT_TRUE(result.valid());
+  EXPECT_NE(static_cast<const char*>(name), result.name().data());
+  EXPECT_EQ("quartus", result.name().str());
+}
+
+TEST(Results, CopiesShareArena)
+{
+  TestResult copy;
+  {
+    TestResult result("quintus");
+    copy = result;
+    EXPECT_EQ(result.arena_ptr(), copy.arena_ptr());
+    EXPECT_EQ(result.name().data(), copy.name().data());
+  }
+
+  // The arena must survive the original result.
+  EXPECT_EQ("quintus", copy.name().str());
+}
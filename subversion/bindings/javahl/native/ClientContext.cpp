@@ -39,7 +39,8 @@
 #include "svn_private_config.h"
 
 ClientContext::ClientContext(jobject jsvnclient, SVN::Pool &pool)
-    : OperationContext(pool)
+    : OperationContext(pool),
+      m_activeOperations(0)
 {
     static jfieldID ctxFieldID = 0;
     attachJavaObject(jsvnclient, JAVAHL_ARG("/SVNClient$ClientContext;"), "clientContext", &ctxFieldID);
@@ -100,72 +101,48 @@ void ClientContext::setTunnelCallback(jobject jtunnelcb)
     }
 }
 
-/* Helper function to make sure that we don't keep dangling pointers in ctx.
-   Note that this function might be called multiple times if getContext()
-   is called on the same pool.
-
-   The use of this function assumes a proper subpool behavior by its user,
-   (read: SVNClient) usually per request.
- */
-extern "C" {
-
-struct clearctx_baton_t
-{
-  svn_client_ctx_t *ctx;
-  svn_client_ctx_t *backup;
-};
-
-static apr_status_t clear_ctx_ptrs(void *ptr)
-{
-    clearctx_baton_t *bt = reinterpret_cast<clearctx_baton_t*>(ptr);
-
-    /* Reset all values to those before overwriting by getContext. */
-    *bt->ctx = *bt->backup;
-
-    return APR_SUCCESS;
-}
-
-};
-
 svn_client_ctx_t *
 ClientContext::getContext(CommitMessage *message, SVN::Pool &in_pool)
 {
     apr_pool_t *pool = in_pool.getPool();
-    svn_client_ctx_t *ctx = m_context;
-
-    /* Make a temporary copy of ctx to restore at pool cleanup to avoid
-       leaving references to dangling pointers.
-
-       Note that this allows creating a stack of context changes if
-       the function is invoked multiple times with different pools.
-     */
-    clearctx_baton_t *bt =
-      reinterpret_cast<clearctx_baton_t *>(apr_pcalloc(pool, sizeof(*bt)));
-    bt->ctx = ctx;
-    bt->backup =
-      reinterpret_cast<svn_client_ctx_t*>(apr_pmemdup(pool, ctx, sizeof(*ctx)));
-    apr_pool_cleanup_register(in_pool.getPool(), bt, clear_ctx_ptrs,
-                              clear_ctx_ptrs);
-
-    if (!ctx->config)
-      {
-        apr_hash_t * configData = getConfigData();
 
-        ctx->config = configData;
-        bt->backup->config = ctx->config;
-      }
+    /* Every operation gets its own client context, allocated in its
+       request pool, so that concurrent operations on the same client
+       object do not share any mutable state.  M_CONTEXT only serves as
+       the template for the callbacks. */
+    apr_hash_t *configData = getConfigData(in_pool);
+    if (configData == NULL)
+      return NULL;
+
+    svn_client_ctx_t *ctx;
+    SVN_JNI_ERR(svn_client_create_context2(&ctx, configData, pool), NULL);
 
-    ctx->auth_baton = getAuthBaton(in_pool);
+    svn_wc_context_t *wc_ctx = ctx->wc_ctx;
+    *ctx = *m_context;
+    ctx->wc_ctx = wc_ctx;
+    ctx->config = configData;
+
+    ctx->auth_baton = getAuthBaton(in_pool, configData);
     ctx->log_msg_baton3 = message;
-    resetCancelRequest();
 
-    SVN_JNI_ERR(svn_wc_context_create(&ctx->wc_ctx, NULL,
-                                      in_pool.getPool(), in_pool.getPool()),
-                NULL);
+    /* Don't drop a cancellation request that is still pending for
+       other running operations. */
+    if (svn_atomic_inc(&m_activeOperations) == 0)
+      resetCancelRequest();
+    apr_pool_cleanup_register(pool, this, operationDone,
+                              apr_pool_cleanup_null);
 
     return ctx;
 }
 
+apr_status_t
+ClientContext::operationDone(void *baton)
+{
+    ClientContext *that = static_cast<ClientContext *>(baton);
+    svn_atomic_dec(&that->m_activeOperations);
+    return APR_SUCCESS;
+}
+
 void
 ClientContext::notify(void *baton,
                       const svn_wc_notify_t *notify,
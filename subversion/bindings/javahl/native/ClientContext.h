@@ -48,8 +48,13 @@ class CommitMessage;
 class ClientContext : public OperationContext
 {
  private:
+  /* Template for the per-operation contexts. */
   svn_client_ctx_t *m_context;
 
+  /* Number of operations currently using a context from getContext. */
+  volatile svn_atomic_t m_activeOperations;
+  static apr_status_t operationDone(void *baton);
+
  protected:
   static void notify(void *baton, const svn_wc_notify_t *notify,
                      apr_pool_t *pool);
@@ -66,6 +71,11 @@ class ClientContext : public OperationContext
   virtual ~ClientContext();
   virtual void setTunnelCallback(jobject jtunnelcb);
 
+  /**
+   * Returns a new client context for a single operation, allocated in
+   * @a in_pool. Contexts are never shared between operations, so
+   * operations on the same client may run concurrently.
+   */
   svn_client_ctx_t *getContext(CommitMessage *message, SVN::Pool &in_pool);
 };
 
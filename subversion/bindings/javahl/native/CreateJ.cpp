@@ -28,6 +28,7 @@
 
 #include "JNIUtil.h"
 #include "JNIStringHolder.h"
+#include "jniwrapper/jni_object.hpp"
 #include "EnumMapper.h"
 #include "RevisionRange.h"
 #include "RevisionRangeList.h"
@@ -40,6 +41,15 @@
 #include "svn_mergeinfo.h"
 #include "private/svn_wc_private.h"
 
+namespace {
+// Returns a cached reference to the class CLASS_NAME.  The reference
+// is owned by the class cache and must not be deleted.
+inline jclass findClass(JNIEnv *env, const char *class_name)
+{
+  return Java::ClassCache::get_named_class(Java::Env(env), class_name);
+}
+} // anonymous namespace
+
 jobject
 CreateJ::ConflictDescriptor(const svn_wc_conflict_description2_t *desc)
 {
@@ -54,7 +64,7 @@ CreateJ::ConflictDescriptor(const svn_wc_conflict_description2_t *desc)
     return NULL;
 
   // Create an instance of the conflict descriptor.
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/ConflictDescriptor"));
+  jclass clazz = findClass(env, JAVAHL_CLASS("/ConflictDescriptor"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -177,7 +187,7 @@ CreateJ::ConflictVersion(const svn_wc_conflict_version_t *version)
     return NULL;
 
   // Create an instance of the conflict version.
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/types/ConflictVersion"));
+  jclass clazz = findClass(env, JAVAHL_CLASS("/types/ConflictVersion"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -228,7 +238,7 @@ CreateJ::Checksum(const svn_checksum_t *checksum)
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/types/Checksum"));
+  jclass clazz = findClass(env, JAVAHL_CLASS("/types/Checksum"));
   if (JNIUtil::isExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -273,7 +283,7 @@ CreateJ::DirEntry(const char *path, const char *absPath,
   if (JNIUtil::isJavaExceptionThrown())
     return SVN_NO_ERROR;
 
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/types/DirEntry"));
+  jclass clazz = findClass(env, JAVAHL_CLASS("/types/DirEntry"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -327,7 +337,7 @@ CreateJ::Info(const char *path, const svn_client_info2_t *info)
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/types/Info"));
+  jclass clazz = findClass(env, JAVAHL_CLASS("/types/Info"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -473,7 +483,7 @@ CreateJ::Lock(const svn_lock_t *lock)
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/types/Lock"));
+  jclass clazz = findClass(env, JAVAHL_CLASS("/types/Lock"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -524,7 +534,7 @@ CreateJ::LockMap(const apr_hash_t *locks, apr_pool_t *pool)
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
-  jclass clazz = env->FindClass("java/util/HashMap");
+  jclass clazz = findClass(env, "java/util/HashMap");
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -587,7 +597,7 @@ CreateJ::ChangedPath(const char *path, svn_log_changed_path2_t *log_item)
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
-  jclass clazzCP = env->FindClass(JAVAHL_CLASS("/types/ChangePath"));
+  jclass clazzCP = findClass(env, JAVAHL_CLASS("/types/ChangePath"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -649,7 +659,7 @@ CreateJ::Status(svn_wc_context_t *wc_ctx,
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/types/Status"));
+  jclass clazz = findClass(env, JAVAHL_CLASS("/types/Status"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -792,7 +802,7 @@ CreateJ::ClientNotifyInformation(const svn_wc_notify_t *wcNotify)
     return NULL;
 
   static jmethodID midCT = 0;
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/ClientNotifyInformation"));
+  jclass clazz = findClass(env, JAVAHL_CLASS("/ClientNotifyInformation"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -925,7 +935,7 @@ CreateJ::ReposNotifyInformation(const svn_repos_notify_t *reposNotify)
     return NULL;
 
   static jmethodID midCT = 0;
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/ReposNotifyInformation"));
+  jclass clazz = findClass(env, JAVAHL_CLASS("/ReposNotifyInformation"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -983,7 +993,7 @@ CreateJ::CommitItem(svn_client_commit_item3_t *item)
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/CommitItem"));
+  jclass clazz = findClass(env, JAVAHL_CLASS("/CommitItem"));
   if (JNIUtil::isExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -1065,7 +1075,7 @@ CreateJ::CommitInfo(const svn_commit_info_t *commit_info)
     return NULL;
 
   static jmethodID midCT = 0;
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/CommitInfo"));
+  jclass clazz = findClass(env, JAVAHL_CLASS("/CommitInfo"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -1235,7 +1245,7 @@ jobject property_map(apr_hash_t *prop_hash, apr_array_header_t* prop_diffs,
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
-  jclass clazz = env->FindClass("java/util/HashMap");
+  jclass clazz = findClass(env, "java/util/HashMap");
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -1304,7 +1314,7 @@ jobject CreateJ::InheritedProps(apr_array_header_t *iprops)
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
-  jclass list_cls = env->FindClass("java/util/ArrayList");
+  jclass list_cls = findClass(env, "java/util/ArrayList");
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -1325,7 +1335,7 @@ jobject CreateJ::InheritedProps(apr_array_header_t *iprops)
         POP_AND_RETURN_NULL;
     }
 
-  jclass item_cls = env->FindClass(
+  jclass item_cls = findClass(env,
       JAVAHL_CLASS("/callback/InheritedProplistCallback$InheritedItem"));
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
@@ -1379,7 +1389,7 @@ jobject CreateJ::Mergeinfo(svn_mergeinfo_t mergeinfo, apr_pool_t* scratch_pool)
 
   // Transform mergeinfo into Java Mergeinfo object.
   JNIEnv *env = JNIUtil::getEnv();
-  jclass clazz = env->FindClass(JAVAHL_CLASS("/types/Mergeinfo"));
+  jclass clazz = findClass(env, JAVAHL_CLASS("/types/Mergeinfo"));
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
@@ -1427,8 +1437,6 @@ jobject CreateJ::Mergeinfo(svn_mergeinfo_t mergeinfo, apr_pool_t* scratch_pool)
       env->DeleteLocalRef(jpath);
     }
 
-  env->DeleteLocalRef(clazz);
-
   return jmergeinfo;
 }
 
@@ -1442,7 +1450,7 @@ jobject CreateJ::Set(std::vector<jobject> &objects)
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
-  jclass clazz = env->FindClass("java/util/HashSet");
+  jclass clazz = findClass(env, "java/util/HashSet");
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
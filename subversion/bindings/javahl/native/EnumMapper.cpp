@@ -30,6 +30,7 @@
 #include "EnumMapper.h"
 #include "JNIUtil.h"
 #include "JNIStringHolder.h"
+#include "jniwrapper/jni_object.hpp"
 #include "../include/org_apache_subversion_javahl_CommitItemStateFlags.h"
 
 jobject EnumMapper::mapChangePathAction(const char action)
@@ -248,10 +249,6 @@ jobject EnumMapper::mapEnum(const char *clazzName, int index)
   // both the C and Java enums.  Should those values ever change,
   // the World Will End.
 
-  std::string methodSig("()[L");
-  methodSig.append(clazzName);
-  methodSig.append(";");
-
   JNIEnv *env = JNIUtil::getEnv();
 
   // Create a local frame for our references
@@ -259,15 +256,9 @@ jobject EnumMapper::mapEnum(const char *clazzName, int index)
   if (JNIUtil::isJavaExceptionThrown())
     return NULL;
 
-  jclass clazz = env->FindClass(clazzName);
-  if (JNIUtil::isJavaExceptionThrown())
-    POP_AND_RETURN_NULL;
-
-  jmethodID mid = env->GetStaticMethodID(clazz, "values", methodSig.c_str());
-  if (JNIUtil::isJavaExceptionThrown())
-    POP_AND_RETURN_NULL;
-
-  jobjectArray jvalues = (jobjectArray) env->CallStaticObjectMethod(clazz, mid);
+  // The values() array is shared by all callers; don't modify it.
+  jobjectArray jvalues =
+    Java::ClassCache::get_enum_values(Java::Env(env), clazzName);
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN_NULL;
 
@@ -287,13 +278,20 @@ int EnumMapper::getOrdinal(const char *clazzName, jobject jenum)
   if (JNIUtil::isJavaExceptionThrown())
     return -1;
 
-  jclass clazz = env->FindClass(clazzName);
-  if (JNIUtil::isJavaExceptionThrown())
-    POP_AND_RETURN(-1);
-
-  jmethodID mid = env->GetMethodID(clazz, "ordinal", "()I");
-  if (JNIUtil::isJavaExceptionThrown())
-    POP_AND_RETURN(-1);
+  // Enum.ordinal() is final, so its method ID is valid for all
+  // enumerations, whatever CLAZZNAME is.
+  static jmethodID mid = 0;
+  if (mid == 0)
+    {
+      jclass clazz =
+        Java::ClassCache::get_named_class(Java::Env(env), "java/lang/Enum");
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(-1);
+
+      mid = env->GetMethodID(clazz, "ordinal", "()I");
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(-1);
+    }
 
   jint jorder = env->CallIntMethod(jenum, mid);
   if (JNIUtil::isJavaExceptionThrown())
@@ -71,6 +71,10 @@
 apr_pool_t *JNIUtil::g_pool = NULL;
 std::list<SVNBase*> JNIUtil::g_finalizedObjects;
 JNIMutex *JNIUtil::g_finalizedObjectsMutex = NULL;
+
+/* Non-zero if g_finalizedObjects may be non-empty.  Lets JNIInit skip
+   the lock, which every native call would contend for otherwise. */
+static volatile svn_atomic_t g_finalizedObjectsPending = 0;
 JNIMutex *JNIUtil::g_logMutex = NULL;
 JNIMutex *JNIUtil::g_configMutex = NULL;
 bool JNIUtil::g_initException;
@@ -100,19 +104,28 @@ bool JNIUtil::JNIInit(JNIEnv *env)
   // Clear all standing exceptions.
   env->ExceptionClear();
 
-  // Lock the list of finalized objects.
-  JNICriticalSection cs(*g_finalizedObjectsMutex) ;
-  if (isExceptionThrown())
-    return false;
+  if (!svn_atomic_read(&g_finalizedObjectsPending))
+    return true;
+
+  // Take the list of finalized objects, so that we don't hold the
+  // lock while deleting them.
+  std::list<SVNBase*> finalizedObjects;
+  {
+    JNICriticalSection cs(*g_finalizedObjectsMutex);
+    if (isExceptionThrown())
+      return false;
+
+    finalizedObjects.swap(g_finalizedObjects);
+    svn_atomic_set(&g_finalizedObjectsPending, 0);
+  }
 
   // Delete all finalized, but not yet deleted objects.
-  for (std::list<SVNBase*>::iterator it = g_finalizedObjects.begin();
-       it != g_finalizedObjects.end();
+  for (std::list<SVNBase*>::iterator it = finalizedObjects.begin();
+       it != finalizedObjects.end();
        ++it)
     {
       delete *it;
     }
-  g_finalizedObjects.clear();
 
   return true;
 }
@@ -278,6 +291,10 @@ bool JNIUtil::JNIGlobalInit(JNIEnv *env)
   if (isExceptionThrown())
     return false;
 
+  SVN::Pool::initRecycling(g_pool);
+  if (isExceptionThrown())
+    return false;
+
   // Set a malfunction handler that tries not to call abort, because
   // that would prevent the JVM from creating a crash and stack log file.
   svn_error_set_malfunction_handler(gently_crash_the_jvm);
@@ -737,7 +754,10 @@ void JNIUtil::enqueueForDeletion(SVNBase *object)
 {
   JNICriticalSection cs(*g_finalizedObjectsMutex);
   if (!isExceptionThrown())
-    g_finalizedObjects.push_back(object);
+    {
+      g_finalizedObjects.push_back(object);
+      svn_atomic_set(&g_finalizedObjectsPending, 1);
+    }
 }
 
 /**
@@ -860,6 +880,79 @@ jstring JNIUtil::makeJString(const char *txt)
   return env->NewStringUTF(txt);
 }
 
+bool JNIUtil::isInstanceOf(jobject obj, const char *className)
+{
+  if (obj == NULL)
+    return false;
+
+  JNIEnv *env = getEnv();
+  jclass clazz = env->FindClass(className);
+  if (isJavaExceptionThrown())
+    return false;
+
+  bool result = env->IsInstanceOf(obj, clazz) ? true : false;
+  env->DeleteLocalRef(clazz);
+
+  return result;
+}
+
+jobjectArray JNIUtil::newGlobalObjectArray(const char *className,
+                                           jsize length)
+{
+  JNIEnv *env = getEnv();
+  jclass clazz = env->FindClass(className);
+  if (isJavaExceptionThrown())
+    return NULL;
+
+  jobjectArray array = env->NewObjectArray(length, clazz, NULL);
+  env->DeleteLocalRef(clazz);
+  if (isJavaExceptionThrown())
+    return NULL;
+
+  jobjectArray result = static_cast<jobjectArray>(env->NewGlobalRef(array));
+  env->DeleteLocalRef(array);
+
+  return result;
+}
+
+jobjectArray JNIUtil::truncateObjectArray(jobjectArray array,
+                                          const char *className,
+                                          jsize length)
+{
+  JNIEnv *env = getEnv();
+  if (env->GetArrayLength(array) == length)
+    return static_cast<jobjectArray>(env->NewLocalRef(array));
+
+  jclass clazz = env->FindClass(className);
+  if (isJavaExceptionThrown())
+    return NULL;
+
+  jobjectArray result = env->NewObjectArray(length, clazz, NULL);
+  env->DeleteLocalRef(clazz);
+  if (isJavaExceptionThrown())
+    return NULL;
+
+  for (jsize i = 0; i < length; ++i)
+    {
+      jobject element = env->GetObjectArrayElement(array, i);
+      if (isJavaExceptionThrown())
+        return NULL;
+
+      env->SetObjectArrayElement(result, i, element);
+      env->DeleteLocalRef(element);
+      if (isJavaExceptionThrown())
+        return NULL;
+    }
+
+  return result;
+}
+
+void JNIUtil::deleteGlobalRef(jobject obj)
+{
+  if (obj != NULL)
+    getEnv()->DeleteGlobalRef(obj);
+}
+
 /**
  * Initialite the log file.
  * @param level the log level
@@ -92,6 +92,35 @@ class JNIUtil
   static jstring makeJString(const char *txt);
   static JNIEnv *getEnv();
 
+  /**
+   * @return Whether @a obj is not null and an instance of the class
+   * named @a className.
+   */
+  static bool isInstanceOf(jobject obj, const char *className);
+
+  /**
+   * Create an array of @a length null elements of the class named
+   * @a className and return a global reference to it.  Release it with
+   * deleteGlobalRef().
+   */
+  static jobjectArray newGlobalObjectArray(const char *className,
+                                           jsize length);
+
+  /**
+   * Return a local reference to an array that contains the first
+   * @a length elements of @a array, whose elements are of the class
+   * named @a className.  If @a length is the length of @a array, no
+   * copy will be made.
+   */
+  static jobjectArray truncateObjectArray(jobjectArray array,
+                                          const char *className,
+                                          jsize length);
+
+  /**
+   * Delete the global reference @a obj, which may be NULL.
+   */
+  static void deleteGlobalRef(jobject obj);
+
   /**
    * @return Whether any Throwable has been raised.
    */
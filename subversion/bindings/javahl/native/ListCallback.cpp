@@ -35,8 +35,13 @@
  * @param jcallback the Java callback object.
  */
 ListCallback::ListCallback(jobject jcallback)
+  : m_dirents(NULL), m_locks(NULL),
+    m_externalParentURLs(NULL), m_externalTargets(NULL),
+    m_count(0)
 {
   m_callback = jcallback;
+  m_batched = JNIUtil::isInstanceOf(
+      jcallback, JAVAHL_CLASS("/callback/ListItemBatchCallback"));
 }
 
 /**
@@ -46,6 +51,7 @@ ListCallback::~ListCallback()
 {
   // The m_callback does not need to be destroyed, because it is the passed
   // in parameter to the Java SVNClient.list method.
+  releaseBatch();
 }
 
 svn_error_t *
@@ -89,7 +95,7 @@ ListCallback::doList(const char *path,
   // The method id will not change during the time this library is
   // loaded, so it can be cached.
   static jmethodID mid = 0;
-  if (mid == 0)
+  if (mid == 0 && !m_batched)
     {
       jclass clazz = env->FindClass(JAVAHL_CLASS("/callback/ListItemCallback"));
       if (JNIUtil::isJavaExceptionThrown())
@@ -127,12 +133,151 @@ ListCallback::doList(const char *path,
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN(SVN_NO_ERROR);
 
+  if (m_batched)
+    {
+      // Collect the entry and only call into Java once the batch is full.
+      if (m_dirents == NULL)
+        {
+          m_dirents = JNIUtil::newGlobalObjectArray(
+                          JAVAHL_CLASS("/types/DirEntry"), BATCH_SIZE);
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+
+          m_locks = JNIUtil::newGlobalObjectArray(
+                        JAVAHL_CLASS("/types/Lock"), BATCH_SIZE);
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+
+          m_externalParentURLs = JNIUtil::newGlobalObjectArray(
+                                     "java/lang/String", BATCH_SIZE);
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+
+          m_externalTargets = JNIUtil::newGlobalObjectArray(
+                                  "java/lang/String", BATCH_SIZE);
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+        }
+
+      env->SetObjectArrayElement(m_dirents, m_count, jdirentry);
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      env->SetObjectArrayElement(m_locks, m_count, jlock);
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      env->SetObjectArrayElement(m_externalParentURLs, m_count,
+                                 jexternalParentURL);
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      env->SetObjectArrayElement(m_externalTargets, m_count,
+                                 jexternalTarget);
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      env->PopLocalFrame(NULL);
+      if (++m_count == BATCH_SIZE)
+        return flush();
+
+      return SVN_NO_ERROR;
+    }
+
   // call the Java method
   env->CallVoidMethod(m_callback, mid, jdirentry, jlock, jexternalParentURL, jexternalTarget);
 
   POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
 }
 
+/**
+ * Pass the collected entries to the Java batch callback.
+ */
+svn_error_t *
+ListCallback::flush()
+{
+  if (m_count == 0)
+    return SVN_NO_ERROR;
+
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // Create a local frame for our references
+  env->PushLocalFrame(LOCAL_FRAME_SIZE);
+  if (JNIUtil::isJavaExceptionThrown())
+    return SVN_NO_ERROR;
+
+  // The method id will not change during the time this library is
+  // loaded, so it can be cached.
+  static jmethodID mid = 0;
+  if (mid == 0)
+    {
+      jclass clazz
+        = env->FindClass(JAVAHL_CLASS("/callback/ListItemBatchCallback"));
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      mid = env->GetMethodID(clazz, "doEntries",
+                             "("
+                             "[" JAVAHL_ARG("/types/DirEntry;")
+                             "[" JAVAHL_ARG("/types/Lock;")
+                             "[Ljava/lang/String;"
+                             "[Ljava/lang/String;"
+                             ")V");
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        POP_AND_RETURN(SVN_NO_ERROR);
+    }
+
+  // The last batch is usually not full.
+  jobjectArray jdirents = JNIUtil::truncateObjectArray(
+                              m_dirents, JAVAHL_CLASS("/types/DirEntry"),
+                              m_count);
+  if (JNIUtil::isJavaExceptionThrown())
+    POP_AND_RETURN(SVN_NO_ERROR);
+
+  jobjectArray jlocks = JNIUtil::truncateObjectArray(
+                            m_locks, JAVAHL_CLASS("/types/Lock"), m_count);
+  if (JNIUtil::isJavaExceptionThrown())
+    POP_AND_RETURN(SVN_NO_ERROR);
+
+  jobjectArray jexternalParentURLs = JNIUtil::truncateObjectArray(
+                                         m_externalParentURLs,
+                                         "java/lang/String", m_count);
+  if (JNIUtil::isJavaExceptionThrown())
+    POP_AND_RETURN(SVN_NO_ERROR);
+
+  jobjectArray jexternalTargets = JNIUtil::truncateObjectArray(
+                                      m_externalTargets,
+                                      "java/lang/String", m_count);
+  if (JNIUtil::isJavaExceptionThrown())
+    POP_AND_RETURN(SVN_NO_ERROR);
+
+  // Start with fresh arrays for the next batch, so the callback may keep
+  // the ones it receives.
+  releaseBatch();
+
+  env->CallVoidMethod(m_callback, mid, jdirents, jlocks,
+                      jexternalParentURLs, jexternalTargets);
+
+  POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
+}
+
+/**
+ * Drop the arrays of the current batch.
+ */
+void
+ListCallback::releaseBatch()
+{
+  JNIUtil::deleteGlobalRef(m_dirents);
+  JNIUtil::deleteGlobalRef(m_locks);
+  JNIUtil::deleteGlobalRef(m_externalParentURLs);
+  JNIUtil::deleteGlobalRef(m_externalTargets);
+  m_dirents = NULL;
+  m_locks = NULL;
+  m_externalParentURLs = NULL;
+  m_externalTargets = NULL;
+  m_count = 0;
+}
+
 /**
  * Create a DirEntry Java object from the svn_dirent_t structure.
  */
@@ -40,6 +40,12 @@ public:
   ListCallback(jobject jcallback);
   ~ListCallback();
 
+  /**
+   * Pass any pending entries to a batch callback.  Must be called after
+   * the last entry has been received.
+   */
+  svn_error_t *flush();
+
   static svn_error_t *callback(void *baton,
                                const char *path,
                                const svn_dirent_t *dirent,
@@ -59,11 +65,36 @@ protected:
                       apr_pool_t *pool);
 
 private:
+  /**
+   * Number of entries passed to a batch callback at once.
+   */
+  enum { BATCH_SIZE = 256 };
+
+  void releaseBatch();
+
   /**
    * This a local reference to the Java object.
    */
   jobject m_callback;
 
+  /**
+   * Whether the Java object is a ListItemBatchCallback.
+   */
+  bool m_batched;
+
+  /**
+   * Global references to the arrays of the current batch, or NULL.
+   */
+  jobjectArray m_dirents;
+  jobjectArray m_locks;
+  jobjectArray m_externalParentURLs;
+  jobjectArray m_externalTargets;
+
+  /**
+   * Number of entries in the current batch.
+   */
+  jsize m_count;
+
   jobject createJavaDirEntry(const char *path,
                              const char *absPath,
                              const svn_dirent_t *dirent);
@@ -25,11 +25,72 @@
 
 #include "jniwrapper/jni_stack.hpp"
 #include "jniwrapper/jni_exception.hpp"
+#include "jniwrapper/jni_channel.hpp"
 
 #include "svn_private_config.h"
 
 namespace JavaHL {
 
+namespace {
+class StreamReader : public ::Java::ChannelReader
+{
+public:
+  explicit StreamReader(svn_stream_t* stream)
+    : m_stream(stream)
+    {}
+
+  virtual jint operator()(::Java::Env env, void* buffer, jint length)
+    {
+      if (!length)
+        return 0;
+
+      apr_size_t len = length;
+      if (svn_stream_supports_partial_read(m_stream))
+        SVN_JAVAHL_CHECK(env, svn_stream_read2(
+                                  m_stream, static_cast<char*>(buffer),
+                                  &len));
+      else
+        SVN_JAVAHL_CHECK(env, svn_stream_read_full(
+                                  m_stream, static_cast<char*>(buffer),
+                                  &len));
+      if (len == 0)
+        return -1;              // EOF
+      if (len <= apr_size_t(length))
+        return jint(len);
+      ::Java::IOException(env).raise(_("Read from native stream failed"));
+      return -1;
+    }
+
+private:
+  svn_stream_t* const m_stream;
+};
+
+class StreamWriter : public ::Java::ChannelWriter
+{
+public:
+  explicit StreamWriter(svn_stream_t* stream)
+    : m_stream(stream)
+    {}
+
+  virtual jint operator()(::Java::Env env, const void* buffer, jint length)
+    {
+      if (!length)
+        return 0;
+
+      apr_size_t len = length;
+      SVN_JAVAHL_CHECK(env, svn_stream_write(
+                                m_stream, static_cast<const char*>(buffer),
+                                &len));
+      if (len != apr_size_t(length))
+        ::Java::IOException(env).raise(_("Write to native stream failed"));
+      return jint(len);
+    }
+
+private:
+  svn_stream_t* const m_stream;
+};
+} // anonymous namespace
+
 // Class JavaHL::NativeInputStream
 
 const char* const NativeInputStream::m_class_name =
@@ -127,6 +188,15 @@ jint NativeInputStream::read(::Java::Env env,
   return -1;
 }
 
+jint NativeInputStream::read(::Java::Env env, jobject dst)
+{
+  if (!dst)
+    ::Java::NullPointerException(env).raise();
+
+  StreamReader reader(m_stream);
+  return ::Java::ReadableByteChannel(env, reader).read(dst);
+}
+
 jlong NativeInputStream::skip(::Java::Env env, jlong count)
 {
   const apr_size_t len = count;
@@ -203,6 +273,15 @@ void NativeOutputStream::write(::Java::Env env,
     ::Java::IOException(env).raise(_("Write to native stream failed"));
 }
 
+jint NativeOutputStream::write(::Java::Env env, jobject src)
+{
+  if (!src)
+    ::Java::NullPointerException(env).raise();
+
+  StreamWriter writer(m_stream);
+  return ::Java::WritableByteChannel(env, writer).write(src);
+}
+
 void NativeOutputStream::dispose(jobject jthis)
 {
   jfieldID fid_cppaddr = NULL;
@@ -295,6 +374,19 @@ Java_org_apache_subversion_javahl_types_NativeInputStream_read___3BII(
   return 0;
 }
 
+JNIEXPORT jint JNICALL
+Java_org_apache_subversion_javahl_types_NativeInputStream_read__Ljava_nio_ByteBuffer_2(
+    JNIEnv* jenv, jobject jthis, jobject jdst)
+{
+  SVN_JAVAHL_JNI_TRY(NativeInputStream, read)
+    {
+      SVN_JAVAHL_GET_BOUND_OBJECT(JavaHL::NativeInputStream, self);
+      return self->read(Java::Env(jenv), jdst);
+    }
+  SVN_JAVAHL_JNI_CATCH_TO_EXCEPTION(Java::IOException);
+  return 0;
+}
+
 JNIEXPORT jlong JNICALL
 Java_org_apache_subversion_javahl_types_NativeInputStream_skip(
     JNIEnv* jenv, jobject jthis, jlong jcount)
@@ -366,6 +458,19 @@ Java_org_apache_subversion_javahl_types_NativeOutputStream_write___3BII(
   SVN_JAVAHL_JNI_CATCH_TO_EXCEPTION(Java::IOException);
 }
 
+JNIEXPORT jint JNICALL
+Java_org_apache_subversion_javahl_types_NativeOutputStream_write__Ljava_nio_ByteBuffer_2(
+    JNIEnv* jenv, jobject jthis, jobject jsrc)
+{
+  SVN_JAVAHL_JNI_TRY(NativeOutputStream, write)
+    {
+      SVN_JAVAHL_GET_BOUND_OBJECT(JavaHL::NativeOutputStream, self);
+      return self->write(Java::Env(jenv), jsrc);
+    }
+  SVN_JAVAHL_JNI_CATCH_TO_EXCEPTION(Java::IOException);
+  return 0;
+}
+
 JNIEXPORT void JNICALL
 Java_org_apache_subversion_javahl_types_NativeOutputStream_finalize(
     JNIEnv* jenv, jobject jthis)
@@ -118,6 +118,12 @@ public:
             ::Java::ByteArray::MutableContents& dst,
             jint offset, jint length);
 
+  /**
+   * Implements @c ReadableByteChannel.read(ByteBuffer).
+   * Direct buffers will be filled without intermediate copies.
+   */
+  jint read(::Java::Env env, jobject dst);
+
   /**
    * Implements @c InputStream.skip(long).
    */
@@ -199,6 +205,12 @@ public:
              const ::Java::ByteArray::Contents& src,
              jint offset, jint length);
 
+  /**
+   * Implements @c WritableByteChannel.write(ByteBuffer).
+   * Direct buffers will be written without intermediate copies.
+   */
+  jint write(::Java::Env env, jobject src);
+
 private:
   virtual void dispose(jobject jthis);
 
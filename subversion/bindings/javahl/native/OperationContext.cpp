@@ -43,6 +43,7 @@
 
 OperationContext::OperationContext(SVN::Pool &pool)
   : m_config(NULL),
+    m_configMutex(pool.getPool()),
     m_prompter(NULL),
     m_cancelOperation(0),
     m_pool(&pool),
@@ -102,6 +103,7 @@ OperationContext::getConfigData()
       JNIUtil::throwNullPointerException("pool is null");
     }
 
+  JNICriticalSection lock(m_configMutex);
   if (m_config == NULL)
     {
       const char *configDir = m_configDir.c_str();
@@ -115,14 +117,34 @@ OperationContext::getConfigData()
   return m_config;
 }
 
+apr_hash_t *
+OperationContext::getConfigData(SVN::Pool &in_pool)
+{
+  /* Reading the configuration may modify it, e.g. when values get
+     expanded, so don't hand out the shared instance. */
+  JNICriticalSection lock(m_configMutex);
+  apr_hash_t *configData = getConfigData();
+  if (configData == NULL)
+    return NULL;
+
+  apr_hash_t *copy;
+  SVN_JNI_ERR(svn_config_copy_config(&copy, configData, in_pool.getPool()),
+              NULL);
+  return copy;
+}
+
 svn_auth_baton_t *
 OperationContext::getAuthBaton(SVN::Pool &in_pool)
+{
+  return getAuthBaton(in_pool, getConfigData(in_pool));
+}
+
+svn_auth_baton_t *
+OperationContext::getAuthBaton(SVN::Pool &in_pool, apr_hash_t *configData)
 {
   svn_auth_baton_t *ab;
   apr_pool_t *pool = in_pool.getPool();
 
-  apr_hash_t * configData = getConfigData();
-
   if (configData == NULL)
     {
       return NULL;
@@ -264,6 +286,7 @@ OperationContext::setConfigDirectory(const char *configDir)
   SVN::Pool requestPool;
   SVN_JNI_ERR(svn_config_ensure(configDir, requestPool.getPool()), );
 
+  JNICriticalSection lock(m_configMutex);
   m_configDir = (configDir == NULL ? "" : configDir);
 
   m_config = NULL;
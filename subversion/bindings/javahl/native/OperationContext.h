@@ -36,6 +36,7 @@
 
 #include <jni.h>
 #include "Pool.h"
+#include "JNIMutex.h"
 #include "JNIStringHolder.h"
 
 class Prompter;
@@ -52,6 +53,9 @@ class OperationContext
 
   apr_hash_t * m_config;
 
+  /* Serializes loading and resetting M_CONFIG. */
+  JNIMutex m_configMutex;
+
   std::auto_ptr<Prompter> m_prompter;
   svn_atomic_t m_cancelOperation;
 
@@ -81,6 +85,9 @@ class OperationContext
   static void closeTunnel(
       void *tunnel_context, void *tunnel_baton);
 
+  svn_auth_baton_t *getAuthBaton(SVN::Pool &in_pool,
+                                 apr_hash_t *configData);
+
  public:
   OperationContext(SVN::Pool &pool);
   void attachJavaObject(jobject contextHolder, const char *contextClassType, const char *contextFieldName, jfieldID * ctxFieldID);
@@ -115,6 +122,12 @@ class OperationContext
    */
   apr_hash_t *getConfigData();
 
+  /**
+   * Returns a copy of the configuration, allocated in @a in_pool,
+   * that the caller may use without synchronizing with other threads.
+   */
+  apr_hash_t *getConfigData(SVN::Pool &in_pool);
+
   void setConfigEventHandler(jobject jcfgcb);
   jobject getConfigEventHandler() const;
 
@@ -35,6 +35,8 @@
 OutputStream::OutputStream(jobject jthis)
 {
   m_jthis = jthis;
+  m_isChannel = JNIUtil::isInstanceOf(jthis,
+                                      "java/nio/channels/WritableByteChannel");
 }
 
 /**
@@ -57,7 +59,8 @@ svn_stream_t *OutputStream::getStream(const SVN::Pool &pool)
   // Create a stream with this as the baton and set the write and
   // close functions.
   svn_stream_t *ret = svn_stream_create(this, pool.getPool());
-  svn_stream_set_write(ret, OutputStream::write);
+  svn_stream_set_write(ret, m_isChannel ? OutputStream::writeChannel
+                                        : OutputStream::write);
   svn_stream_set_close(ret, OutputStream::close);
   return ret;
 }
@@ -109,6 +112,67 @@ svn_error_t *OutputStream::write(void *baton, const char *buffer,
   return SVN_NO_ERROR;
 }
 
+/**
+ * Implements svn_write_fn_t to write data out from Subversion to a Java
+ * object that implements WritableByteChannel.  The data is passed to
+ * the channel in a direct ByteBuffer without copying it.
+ * @param baton     an OutputStream object for the callback
+ * @param buffer    the buffer for the write data
+ * @param len       on input the buffer len, on output the number of written
+ *                  bytes
+ * @return a subversion error or SVN_NO_ERROR
+ */
+svn_error_t *OutputStream::writeChannel(void *baton, const char *buffer,
+                                        apr_size_t *len)
+{
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // An object of our class is passed in as the baton.
+  OutputStream *that = static_cast<OutputStream *>(baton);
+
+  // The method id will not change during the time this library is
+  // loaded, so it can be cached.
+  static jmethodID mid = 0;
+  if (mid == 0)
+    {
+      jclass clazz = env->FindClass("java/nio/channels/WritableByteChannel");
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      mid = env->GetMethodID(clazz, "write", "(Ljava/nio/ByteBuffer;)I");
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        return SVN_NO_ERROR;
+
+      env->DeleteLocalRef(clazz);
+    }
+
+  // The buffer only remains valid until we return.  Channels must not
+  // keep a reference to it.
+  jobject data = env->NewDirectByteBuffer(const_cast<char *>(buffer),
+                                          static_cast<jlong>(*len));
+  if (JNIUtil::isJavaExceptionThrown())
+    return SVN_NO_ERROR;
+
+  // The JVM does not support direct buffers.
+  if (data == NULL)
+    return write(baton, buffer, len);
+
+  // A blocking channel may still write less than the whole buffer.
+  apr_size_t remaining = *len;
+  while (remaining > 0)
+    {
+      jint written = env->CallIntMethod(that->m_jthis, mid, data);
+      if (JNIUtil::isJavaExceptionThrown())
+        return SVN_NO_ERROR;
+
+      remaining -= written;
+    }
+
+  env->DeleteLocalRef(data);
+
+  return SVN_NO_ERROR;
+}
+
 /**
  * Implements svn_close_fn_t to close the output stream.
  * @param baton     an OutputStream object for the callback
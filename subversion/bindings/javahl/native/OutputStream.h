@@ -33,7 +33,9 @@
 
 /**
  * This class contains a Java objects implementing the interface OutputStream
- * and implements the functions write & close of svn_stream_t
+ * and implements the functions write & close of svn_stream_t.  If the Java
+ * object also implements WritableByteChannel, data will be written through
+ * that interface, which avoids copying it into Java arrays.
  */
 class OutputStream
 {
@@ -41,8 +43,16 @@ class OutputStream
    * A local reference to the Java object.
    */
   jobject m_jthis;
+
+  /**
+   * Whether m_jthis is also a WritableByteChannel.
+   */
+  bool m_isChannel;
+
   static svn_error_t *write(void *baton,
                             const char *buffer, apr_size_t *len);
+  static svn_error_t *writeChannel(void *baton,
+                                   const char *buffer, apr_size_t *len);
   static svn_error_t *close(void *baton);
  public:
   OutputStream(jobject jthis);
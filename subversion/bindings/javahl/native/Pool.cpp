@@ -30,18 +30,67 @@
 #include "JNICriticalSection.h"
 #include "svn_pools.h"
 
+#include <vector>
+
+namespace {
+/* Keep at most this many unused request pools around. */
+const std::size_t MAX_UNUSED_POOLS = 32;
+
+/* The allocator of each recycled pool keeps at most this many bytes
+   of free memory, so that a single large request does not pin its
+   memory forever. */
+const apr_size_t MAX_FREE_PER_POOL = 1024 * 1024;
+
+/* Recycled root pools that are currently unused, and the mutex that
+   serializes access to them.  Both are NULL until initRecycling(). */
+std::vector<apr_pool_t *> *unusedPools = NULL;
+JNIMutex *unusedPoolsMutex = NULL;
+} // anonymous namespace
+
+void SVN::Pool::initRecycling(apr_pool_t *pool)
+{
+  unusedPoolsMutex = new JNIMutex(pool);
+  unusedPools = new std::vector<apr_pool_t *>;
+  unusedPools->reserve(MAX_UNUSED_POOLS);
+}
+
 /**
- * Constructor to create one apr pool as the subpool of the global pool.
+ * Constructor to create one apr pool as a request pool.  Reuse an
+ * unused root pool if there is one, so that frequent small requests
+ * don't keep allocating and releasing memory.
  */
 SVN::Pool::Pool()
+  : m_pool(NULL),
+    m_recycled(unusedPoolsMutex != NULL)
 {
-  m_pool = svn_pool_create(JNIUtil::getPool());
+  if (!m_recycled)
+    {
+      m_pool = svn_pool_create(JNIUtil::getPool());
+      return;
+    }
+
+  {
+    JNICriticalSection cs(*unusedPoolsMutex);
+    if (!unusedPools->empty())
+      {
+        m_pool = unusedPools->back();
+        unusedPools->pop_back();
+      }
+  }
+
+  if (!m_pool)
+    {
+      apr_allocator_t *allocator = svn_pool_create_allocator(FALSE);
+      apr_allocator_max_free_set(allocator, MAX_FREE_PER_POOL);
+      m_pool = apr_allocator_owner_get(allocator);
+    }
 }
 
 /**
  * Constructor to create one apr pool as a subpool of the passed pool.
  */
 SVN::Pool::Pool(const Pool &parent_pool)
+  : m_recycled(false)
 {
   m_pool = svn_pool_create(parent_pool.m_pool);
 }
@@ -50,16 +99,29 @@ SVN::Pool::Pool(const Pool &parent_pool)
  * Constructor to create one apr pool as a subpool of the passed pool.
  */
 SVN::Pool::Pool(apr_pool_t *parent_pool)
+  : m_recycled(false)
 {
   m_pool = svn_pool_create(parent_pool);
 }
 
 /**
- * Destructor to destroy the apr pool and to clear the request pool
- * pointer.
+ * Destructor to destroy (or recycle) the apr pool and to clear the
+ * request pool pointer.
  */
 SVN::Pool::~Pool()
 {
+  if (m_pool && m_recycled)
+    {
+      svn_pool_clear(m_pool);
+
+      JNICriticalSection cs(*unusedPoolsMutex);
+      if (unusedPools->size() < MAX_UNUSED_POOLS)
+        {
+          unusedPools->push_back(m_pool);
+          m_pool = NULL;
+        }
+    }
+
   if (m_pool)
     {
       svn_pool_destroy(m_pool);
@@ -34,6 +34,10 @@ namespace SVN {
    * This class manages one APR pool.  Objects of this class are
    * allocated on the stack of the SVNClient and SVNAdmin methods as the
    * request pool.  Leaving the methods will destroy the pool.
+   *
+   * Request pools created by the default constructor are recycled
+   * root pools once initRecycling() has been called.  Like any other
+   * request pool, they must only be used by one thread at a time.
    */
   class Pool
   {
@@ -45,12 +49,23 @@ namespace SVN {
     apr_pool_t *getPool() const;
     void clear() const;
 
+    /**
+     * Enable recycling of request pools; use @a pool for the internal
+     * bookkeeping. Called once, by JNIUtil::JNIGlobalInit.
+     */
+    static void initRecycling(apr_pool_t *pool);
+
   private:
     /**
      * The apr pool request pool.
      */
     apr_pool_t *m_pool;
 
+    /**
+     * Whether m_pool is a recycled root pool.
+     */
+    bool m_recycled;
+
     /**
      * We declare the assignment operator private here, so that the compiler
      * won't inadvertently use them for us.
@@ -193,6 +193,7 @@ void SVNClient::list(const char *url, Revision &revision,
                                  ListCallback::callback,
                                  callback,
                                  ctx, subPool.getPool()), );
+    SVN_JNI_ERR(callback->flush(), );
 }
 
 void
@@ -225,6 +226,7 @@ SVNClient::status(const char *path, svn_depth_t depth,
                                    changelists.array(subPool),
                                    StatusCallback::callback, callback,
                                    subPool.getPool()), );
+    SVN_JNI_ERR(callback->flush(), );
 }
 
 /* Convert a vector of revision ranges to an APR array of same. */
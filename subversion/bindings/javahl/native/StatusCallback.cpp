@@ -35,8 +35,11 @@
  * @param jcallback the Java callback object.
  */
 StatusCallback::StatusCallback(jobject jcallback)
+  : m_paths(NULL), m_statuses(NULL), m_count(0)
 {
   m_callback = jcallback;
+  m_batched = JNIUtil::isInstanceOf(
+      jcallback, JAVAHL_CLASS("/callback/StatusBatchCallback"));
 }
 
 /**
@@ -46,6 +49,7 @@ StatusCallback::~StatusCallback()
 {
   // the m_callback does not need to be destroyed, because it is the passed
   // in parameter to the Java SVNClient.status method.
+  releaseBatch();
 }
 
 svn_error_t *
@@ -79,7 +83,7 @@ StatusCallback::doStatus(const char *local_abspath,
   static jmethodID mid = 0; // the method id will not change during
   // the time this library is loaded, so
   // it can be cached.
-  if (mid == 0)
+  if (mid == 0 && !m_batched)
     {
       jclass clazz = env->FindClass(JAVAHL_CLASS("/callback/StatusCallback"));
       if (JNIUtil::isJavaExceptionThrown())
@@ -100,11 +104,110 @@ StatusCallback::doStatus(const char *local_abspath,
   if (JNIUtil::isJavaExceptionThrown())
     POP_AND_RETURN(SVN_NO_ERROR);
 
+  if (m_batched)
+    {
+      // Collect the item and only call into Java once the batch is full.
+      if (m_paths == NULL)
+        {
+          m_paths = JNIUtil::newGlobalObjectArray("java/lang/String",
+                                                  BATCH_SIZE);
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+
+          m_statuses = JNIUtil::newGlobalObjectArray(
+                                    JAVAHL_CLASS("/types/Status"),
+                                    BATCH_SIZE);
+          if (JNIUtil::isJavaExceptionThrown())
+            POP_AND_RETURN(SVN_NO_ERROR);
+        }
+
+      env->SetObjectArrayElement(m_paths, m_count, jPath);
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      env->SetObjectArrayElement(m_statuses, m_count, jStatus);
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      env->PopLocalFrame(NULL);
+      if (++m_count == BATCH_SIZE)
+        return flush();
+
+      return SVN_NO_ERROR;
+    }
+
   env->CallVoidMethod(m_callback, mid, jPath, jStatus);
 
   POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
 }
 
+/**
+ * Pass the collected status items to the Java batch callback.
+ */
+svn_error_t *
+StatusCallback::flush()
+{
+  if (m_count == 0)
+    return SVN_NO_ERROR;
+
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // Create a local frame for our references
+  env->PushLocalFrame(LOCAL_FRAME_SIZE);
+  if (JNIUtil::isJavaExceptionThrown())
+    return SVN_NO_ERROR;
+
+  static jmethodID mid = 0; // the method id will not change during
+  // the time this library is loaded, so
+  // it can be cached.
+  if (mid == 0)
+    {
+      jclass clazz
+        = env->FindClass(JAVAHL_CLASS("/callback/StatusBatchCallback"));
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      mid = env->GetMethodID(clazz, "doStatus",
+                             "([Ljava/lang/String;"
+                             "[" JAVAHL_ARG("/types/Status;") ")V");
+      if (JNIUtil::isJavaExceptionThrown() || mid == 0)
+        POP_AND_RETURN(SVN_NO_ERROR);
+    }
+
+  // The last batch is usually not full.
+  jobjectArray jpaths = JNIUtil::truncateObjectArray(
+                            m_paths, "java/lang/String", m_count);
+  if (JNIUtil::isJavaExceptionThrown())
+    POP_AND_RETURN(SVN_NO_ERROR);
+
+  jobjectArray jstatuses = JNIUtil::truncateObjectArray(
+                               m_statuses, JAVAHL_CLASS("/types/Status"),
+                               m_count);
+  if (JNIUtil::isJavaExceptionThrown())
+    POP_AND_RETURN(SVN_NO_ERROR);
+
+  // Start with fresh arrays for the next batch, so the callback may keep
+  // the ones it receives.
+  releaseBatch();
+
+  env->CallVoidMethod(m_callback, mid, jpaths, jstatuses);
+
+  POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
+}
+
+/**
+ * Drop the arrays of the current batch.
+ */
+void
+StatusCallback::releaseBatch()
+{
+  JNIUtil::deleteGlobalRef(m_paths);
+  JNIUtil::deleteGlobalRef(m_statuses);
+  m_paths = NULL;
+  m_statuses = NULL;
+  m_count = 0;
+}
+
 void
 StatusCallback::setWcCtx(svn_wc_context_t *wc_ctx_in)
 {
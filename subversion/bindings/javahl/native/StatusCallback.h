@@ -42,6 +42,12 @@ class StatusCallback
 
   void setWcCtx(svn_wc_context_t *);
 
+  /**
+   * Pass any pending status items to a batch callback.  Must be called
+   * after the last item has been received.
+   */
+  svn_error_t *flush();
+
   static svn_error_t* callback(void *baton,
                                const char *local_abspath,
                                const svn_client_status_t *status,
@@ -53,11 +59,34 @@ class StatusCallback
                         apr_pool_t *pool);
 
  private:
+  /**
+   * Number of status items passed to a batch callback at once.
+   */
+  enum { BATCH_SIZE = 256 };
+
+  void releaseBatch();
+
   /**
    * This a local reference to the Java object.
    */
   jobject m_callback;
 
+  /**
+   * Whether the Java object is a StatusBatchCallback.
+   */
+  bool m_batched;
+
+  /**
+   * Global references to the arrays of the current batch, or NULL.
+   */
+  jobjectArray m_paths;
+  jobjectArray m_statuses;
+
+  /**
+   * Number of items in the current batch.
+   */
+  jsize m_count;
+
   svn_wc_context_t *wc_ctx;
 };
 
@@ -21,7 +21,9 @@
  * @endcopyright
  */
 
+#include <cstring>
 #include <stdexcept>
+#include <string>
 
 #include <apr_atomic.h>
 
@@ -92,6 +94,36 @@ private:
 
   mutable volatile void* m_ptr;
 };
+
+/* An entry in the cache of classes looked up by name. */
+struct NamedClass
+{
+  NamedClass(::Java::Env env, const char* name, jclass cls)
+    : m_name(name),
+      m_class(env, cls),
+      m_values(NULL)
+  {}
+
+  ~NamedClass()
+    {
+      delete static_cast< ::Java::GlobalObject*>(
+          apr_atomic_casptr(&m_values, NULL, NULL));
+    }
+
+  /* The class name, usually a string literal in the caller. */
+  const std::string m_name;
+
+  /* Global reference to the class. */
+  ::Java::GlobalClass m_class;
+
+  /* For enumerations, a GlobalObject* holding the result of values(). */
+  volatile void* m_values;
+
+private:
+  // Non-copyable
+  NamedClass(const NamedClass&);
+  NamedClass& operator=(const NamedClass&);
+};
 } // anonymous namespace
 
 
@@ -102,6 +134,59 @@ class ClassCacheImpl
 
   friend class ClassCache;
 
+  // Number of slots in the cache of classes looked up by name.  This
+  // is more than the number of distinct classes that JavaHL creates
+  // through the non-wrapper code.
+  enum { named_class_slots = 128 };
+
+  // Slots of the by-name cache, each holding a NamedClass*.  Entries
+  // are only ever added, never removed, until the cache is destroyed.
+  volatile void* m_named[named_class_slots];
+
+  // Returns the cache entry for CLASS_NAME, creating it if necessary.
+  // Returns NULL if the cache is full or if the class could not be
+  // found; in the latter case, a Java exception will be pending.
+  // Never throws C++ exceptions.
+  NamedClass* get_named(Env env, const char* class_name)
+    {
+      ::JNIEnv* const jenv = env.get();
+      for (int i = 0; i < named_class_slots; ++i)
+        {
+          NamedClass* entry = static_cast<NamedClass*>(
+              apr_atomic_casptr(&m_named[i], NULL, NULL));
+          if (!entry)
+            {
+              const jclass cls = jenv->FindClass(class_name);
+              if (jenv->ExceptionCheck())
+                return NULL;
+
+              std::auto_ptr<NamedClass> tmp;
+              try
+                {
+                  tmp.reset(new NamedClass(env, class_name, cls));
+                }
+              catch (...)
+                {
+                  jenv->DeleteLocalRef(cls);
+                  return NULL;
+                }
+              jenv->DeleteLocalRef(cls);
+
+              entry = static_cast<NamedClass*>(
+                  apr_atomic_casptr(&m_named[i], tmp.get(), NULL));
+              if (!entry)
+                return tmp.release();
+
+              // Another thread filled this slot first; check its entry.
+            }
+
+          if (entry->m_name == class_name)
+            return entry;
+        }
+
+      return NULL;
+    }
+
   // We only statically initialize a few of the common class wrappers.
   explicit ClassCacheImpl(Env env) :
 
@@ -113,7 +198,17 @@ class ClassCacheImpl
       JNIWRAPPER_INIT_CACHED_CLASS(throwable, Exception),
       JNIWRAPPER_INIT_CACHED_CLASS(string, String)
 #undef JNIWRAPPER_INIT_CACHED_CLASS
-    {}
+    {
+      for (int i = 0; i < named_class_slots; ++i)
+        m_named[i] = NULL;
+    }
+
+  ~ClassCacheImpl()
+    {
+      for (int i = 0; i < named_class_slots; ++i)
+        delete static_cast<NamedClass*>(
+            apr_atomic_casptr(&m_named[i], NULL, NULL));
+    }
 
   // We can't do this in the constructor above, because the satic
   // initializers will expect that ClassCache::m_impl is already set;
@@ -323,4 +418,71 @@ JNIWRAPPER_IMPL_CLASS_CACHE_ACCESSOR(editor_provide_props_cb_ret);
 JNIWRAPPER_IMPL_CLASS_CACHE_ACCESSOR(editor_get_kind_cb);
 #undef JNIWRAPPER_IMPL_CLASS_CACHE_ACCESSOR
 
+jclass ClassCache::get_named_class(Env env, const char* class_name)
+{
+  const NamedClass* const entry = m_impl->get_named(env, class_name);
+  if (entry)
+    return entry->m_class.get();
+
+  ::JNIEnv* const jenv = env.get();
+  if (jenv->ExceptionCheck())
+    return NULL;
+
+  // The cache is full; fall back to a local reference.
+  return jenv->FindClass(class_name);
+}
+
+jobjectArray ClassCache::get_enum_values(Env env, const char* class_name)
+{
+  ::JNIEnv* const jenv = env.get();
+  NamedClass* const entry = m_impl->get_named(env, class_name);
+  jclass cls;
+  if (entry)
+    {
+      const GlobalObject* const values = static_cast<GlobalObject*>(
+          apr_atomic_casptr(&entry->m_values, NULL, NULL));
+      if (values)
+        return jobjectArray(values->get());
+      cls = entry->m_class.get();
+    }
+  else
+    {
+      if (jenv->ExceptionCheck())
+        return NULL;
+      cls = jenv->FindClass(class_name);
+      if (jenv->ExceptionCheck())
+        return NULL;
+    }
+
+  std::string signature("()[L");
+  signature.append(class_name);
+  signature.append(";");
+
+  const jmethodID mid =
+    jenv->GetStaticMethodID(cls, "values", signature.c_str());
+  if (jenv->ExceptionCheck())
+    return NULL;
+
+  const jobject jvalues = jenv->CallStaticObjectMethod(cls, mid);
+  if (jenv->ExceptionCheck() || !entry)
+    return jobjectArray(jvalues);
+
+  std::auto_ptr<GlobalObject> tmp;
+  try
+    {
+      tmp.reset(new GlobalObject(env, jvalues));
+    }
+  catch (...)
+    {
+      return jobjectArray(jvalues);
+    }
+  jenv->DeleteLocalRef(jvalues);
+
+  const GlobalObject* values = static_cast<GlobalObject*>(
+      apr_atomic_casptr(&entry->m_values, tmp.get(), NULL));
+  if (!values)
+    values = tmp.release();
+  return jobjectArray(values->get());
+}
+
 } // namespace Java
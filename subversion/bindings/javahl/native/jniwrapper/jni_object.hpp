@@ -207,6 +207,28 @@ public:
   JNIWRAPPER_DECLARE_CACHED_CLASS_ACCESSOR(editor_provide_props_cb_ret);
   JNIWRAPPER_DECLARE_CACHED_CLASS_ACCESSOR(editor_get_kind_cb);
 #undef JNIWRAPPER_DECLARE_CACHED_CLASS
+
+  /**
+   * Returns a reference to the class named @a class_name, for code
+   * that does not use the object wrappers. The reference is usually
+   * global and held by the cache, so the caller must never delete
+   * it. If the class cannot be found, returns @c NULL and leaves a
+   * pending Java exception. Does not throw C++ exceptions.
+   *
+   * @since New in 1.10.
+   */
+  static jclass get_named_class(Env env, const char* class_name);
+
+  /**
+   * Returns the array returned by the static @c values() method of
+   * the enumeration named @a class_name. The array is computed once
+   * and shared by all callers, so it must not be modified or deleted.
+   * On error, returns @c NULL and leaves a pending Java exception.
+   * Does not throw C++ exceptions.
+   *
+   * @since New in 1.10.
+   */
+  static jobjectArray get_enum_values(Env env, const char* class_name);
 };
 
 
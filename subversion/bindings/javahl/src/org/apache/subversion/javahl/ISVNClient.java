@@ -35,6 +35,20 @@ import java.util.Map;
 /**
  * This interface is the commom interface for all subversion
  * operations. It is implemented by SVNClient
+ * <p>
+ * <b>Concurrency:</b> Since 1.10, each operation runs with its own
+ * native client context, configuration and memory pools. Several
+ * threads may therefore invoke operations on the same client object
+ * at the same time. Operations on <em>different</em> working copies
+ * then run fully in parallel. Operations on the same working copy
+ * are still serialized by the working copy locks.
+ * <p>
+ * Settings such as the user name, prompter or configuration directory
+ * take effect for operations started after they have been changed.
+ * Callbacks passed to or registered with the client may be invoked
+ * from several threads at once and must be thread-safe.
+ * {@link #cancelOperation} affects all operations currently running
+ * on the client object.
  *
  * @since 1.7
  */
@@ -80,6 +94,9 @@ public interface ISVNClient
 
     /**
      * Return the status of the working copy and maybe repository.
+     * <p>
+     * If <code>callback</code> is a {@link StatusBatchCallback}, it
+     * will receive the status items in batches.
      *
      * @param path        Path to explore.
      * @param depth       How deep to recurse into subdirectories.
@@ -120,6 +137,8 @@ public interface ISVNClient
 
     /**
      * Lists the directory entries of a url on the server.
+     * If <code>callback</code> is a {@link ListItemBatchCallback}, it
+     * will receive the entries in batches.
      * @param url             the url to list
      * @param revision        the revision to list
      * @param pegRevision     the revision to interpret url
@@ -1452,7 +1471,9 @@ public interface ISVNClient
     ConfigEvent getConfigEventHandler() throws ClientException;
 
     /**
-     * cancel the active operation
+     * cancel the active operation.
+     * If several operations are running on this object, all of
+     * them are cancelled.
      * @throws ClientException
      */
     void cancelOperation() throws ClientException;
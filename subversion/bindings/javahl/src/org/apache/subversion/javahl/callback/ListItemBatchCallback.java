@@ -0,0 +1,51 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+
+package org.apache.subversion.javahl.callback;
+
+import org.apache.subversion.javahl.ISVNClient;
+import org.apache.subversion.javahl.types.DirEntry;
+import org.apache.subversion.javahl.types.Lock;
+
+/**
+ * A {@link ListItemCallback} that receives the directory entries of the
+ * {@link ISVNClient#list} call in batches instead of one at a time.
+ * This saves a transition between native and Java code per entry.
+ * <p>
+ * If the callback object implements this interface, only
+ * {@link #doEntries} will be called.
+ * @since 1.10
+ */
+public interface ListItemBatchCallback extends ListItemCallback
+{
+    /**
+     * This method will be called for each batch of directory entries.
+     * All arrays have the same length and the elements at the same index
+     * describe the same entry, like the parameters of
+     * {@link ListItemCallback#doEntry} do.
+     */
+    public void doEntries(DirEntry[] dirents, Lock[] locks,
+                          String[] externalParentURLs,
+                          String[] externalTargets);
+}
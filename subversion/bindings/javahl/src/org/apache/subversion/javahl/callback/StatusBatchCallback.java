@@ -0,0 +1,50 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+
+package org.apache.subversion.javahl.callback;
+
+import org.apache.subversion.javahl.ISVNClient;
+import org.apache.subversion.javahl.types.Status;
+
+/**
+ * A {@link StatusCallback} that receives the status items of the
+ * {@link ISVNClient#status} call in batches instead of one at a time.
+ * This saves a transition between native and Java code per item.
+ * <p>
+ * If the callback object implements this interface, only
+ * {@link #doStatus(String[], Status[])} will be called.
+ * @since 1.10
+ */
+public interface StatusBatchCallback extends StatusCallback
+{
+    /**
+     * The method will be called for each batch of status items, in the
+     * same order in which {@link StatusCallback#doStatus} would have
+     * been called for them.
+     * @param paths     the paths of the objects
+     * @param statuses  the status objects, with the same length
+     *                  as <code>paths</code>; elements may be null
+     */
+    public void doStatus(String[] paths, Status[] statuses);
+}
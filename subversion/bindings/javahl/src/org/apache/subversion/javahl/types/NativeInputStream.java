@@ -27,14 +27,21 @@ import org.apache.subversion.javahl.NativeResources;
 
 import java.io.IOException;
 import java.io.InputStream;
+import java.nio.ByteBuffer;
+import java.nio.channels.ReadableByteChannel;
 
 /**
  * Implementation class for {@link InputStream} objects returned from
  * JavaHL methods.
+ * <p>
+ * Since 1.10, the stream can also be used as a
+ * {@link ReadableByteChannel}.  Reading into a direct
+ * {@link ByteBuffer} avoids copying the data through Java arrays.
  *
  * @since 1.9
  */
 public class NativeInputStream extends InputStream
+    implements ReadableByteChannel
 {
     /**
      * Load the required native library.
@@ -85,6 +92,23 @@ public class NativeInputStream extends InputStream
     @Override
     public native int read(byte[] b, int off, int len) throws IOException;
 
+    /**
+     * Reads up to <code>dst.remaining()</code> bytes into
+     * <code>dst</code> from the underlying native stream.
+     * @see ReadableByteChannel.read(ByteBuffer)
+     * @since 1.10
+     */
+    public native int read(ByteBuffer dst) throws IOException;
+
+    /**
+     * @see java.nio.channels.Channel.isOpen()
+     * @since 1.10
+     */
+    public boolean isOpen()
+    {
+        return cppAddr != 0;
+    }
+
     /**
      * @see InputStream.skip(long)
      */
@@ -27,14 +27,21 @@ import org.apache.subversion.javahl.NativeResources;
 
 import java.io.IOException;
 import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.nio.channels.WritableByteChannel;
 
 /**
  * Implementation class for {@link OutputStream} objects returned from
  * JavaHL methods.
+ * <p>
+ * Since 1.10, the stream can also be used as a
+ * {@link WritableByteChannel}.  Writing from a direct
+ * {@link ByteBuffer} avoids copying the data through Java arrays.
  *
  * @since 1.9
  */
 public class NativeOutputStream extends OutputStream
+    implements WritableByteChannel
 {
     /**
      * Load the required native library.
@@ -67,6 +74,23 @@ public class NativeOutputStream extends OutputStream
     @Override
     public native void write(byte[] b, int off, int len) throws IOException;
 
+    /**
+     * Writes all remaining bytes of <code>src</code> to the
+     * underlying native stream.
+     * @see WritableByteChannel.write(ByteBuffer)
+     * @since 1.10
+     */
+    public native int write(ByteBuffer src) throws IOException;
+
+    /**
+     * @see java.nio.channels.Channel.isOpen()
+     * @since 1.10
+     */
+    public boolean isOpen()
+    {
+        return cppAddr != 0;
+    }
+
 
     private long cppAddr;
 
@@ -0,0 +1,88 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+
+package org.apache.subversion.javahl.util;
+
+import java.io.IOException;
+import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.nio.channels.WritableByteChannel;
+
+/**
+ * An {@link OutputStream} that writes to a {@link WritableByteChannel}.
+ * <p>
+ * When passed to JavaHL methods that write file contents to an
+ * {@link OutputStream}, such as
+ * {@link org.apache.subversion.javahl.ISVNClient#streamFileContent} or
+ * {@link org.apache.subversion.javahl.ISVNRemote#getFile}, the native
+ * data will be handed to the channel in direct {@link ByteBuffer}s,
+ * without copying it into Java arrays first.  Those buffers are only
+ * valid during the call to {@link #write(ByteBuffer)}.
+ * <p>
+ * The channel should be in blocking mode.
+ * @since 1.10
+ */
+public class ChannelOutputStream extends OutputStream
+    implements WritableByteChannel
+{
+    private final WritableByteChannel channel;
+
+    /**
+     * Create a stream that writes to <code>channel</code>.
+     */
+    public ChannelOutputStream(WritableByteChannel channel)
+    {
+        this.channel = channel;
+    }
+
+    public int write(ByteBuffer src) throws IOException
+    {
+        return channel.write(src);
+    }
+
+    @Override
+    public void write(byte[] b, int off, int len) throws IOException
+    {
+        ByteBuffer src = ByteBuffer.wrap(b, off, len);
+        while (src.hasRemaining())
+            channel.write(src);
+    }
+
+    @Override
+    public void write(int b) throws IOException
+    {
+        write(new byte[] { (byte) b }, 0, 1);
+    }
+
+    public boolean isOpen()
+    {
+        return channel.isOpen();
+    }
+
+    @Override
+    public void close() throws IOException
+    {
+        channel.close();
+    }
+}
@@ -24,6 +24,7 @@ package org.apache.subversion.javahl;
 
 import org.apache.subversion.javahl.callback.*;
 import org.apache.subversion.javahl.types.*;
+import org.apache.subversion.javahl.util.ChannelOutputStream;
 
 import java.io.File;
 import java.io.FileOutputStream;
@@ -309,6 +310,79 @@ public class BasicTests extends SVNTests
         assertEquals(1, branchRange.size());
     }
 
+    /**
+     * Test that batch callbacks receive the same items as the
+     * single-item callbacks of SVNClient.status and SVNClient.list.
+     * @throws Throwable
+     */
+    public void testBatchCallbacks() throws Throwable
+    {
+        OneTest thisTest = new OneTest();
+        final List<String> batchPaths = new ArrayList<String>();
+        final List<String> paths = new ArrayList<String>();
+
+        client.status(thisTest.getWorkingCopy().getPath(), Depth.infinity,
+                      false, true, true, false, false, false, null,
+                      new StatusBatchCallback() {
+            public void doStatus(String[] statusPaths, Status[] statuses)
+            {
+                assertEquals(statusPaths.length, statuses.length);
+                batchPaths.addAll(Arrays.asList(statusPaths));
+            }
+
+            public void doStatus(String path, Status status)
+            {
+                fail("Single-item callback called for a batch callback");
+            }
+        });
+        client.status(thisTest.getWorkingCopy().getPath(), Depth.infinity,
+                      false, true, true, false, false, false, null,
+                      new StatusCallback() {
+            public void doStatus(String path, Status status)
+            {
+                paths.add(path);
+            }
+        });
+        assertFalse(paths.isEmpty());
+        assertEquals(paths, batchPaths);
+
+        batchPaths.clear();
+        paths.clear();
+        client.list(thisTest.getUrl().toString(), Revision.HEAD,
+                    Revision.HEAD, null, Depth.infinity, DirEntry.Fields.all,
+                    false, false, new ListItemBatchCallback() {
+            public void doEntries(DirEntry[] dirents, Lock[] locks,
+                                  String[] externalParentURLs,
+                                  String[] externalTargets)
+            {
+                assertEquals(dirents.length, locks.length);
+                assertEquals(dirents.length, externalParentURLs.length);
+                assertEquals(dirents.length, externalTargets.length);
+                for (DirEntry dirent : dirents)
+                    batchPaths.add(dirent.getPath());
+            }
+
+            public void doEntry(DirEntry dirent, Lock lock,
+                                String externalParentURL,
+                                String externalTarget)
+            {
+                fail("Single-item callback called for a batch callback");
+            }
+        });
+        client.list(thisTest.getUrl().toString(), Revision.HEAD,
+                    Revision.HEAD, null, Depth.infinity, DirEntry.Fields.all,
+                    false, false, new ListItemCallback() {
+            public void doEntry(DirEntry dirent, Lock lock,
+                                String externalParentURL,
+                                String externalTarget)
+            {
+                paths.add(dirent.getPath());
+            }
+        });
+        assertFalse(paths.isEmpty());
+        assertEquals(paths, batchPaths);
+    }
+
     /**
      * Test the basic SVNClient.status functionality.
      * @throws Throwable
@@ -2303,6 +2377,15 @@ public class BasicTests extends SVNTests
 
         // the content should be the same
         assertTrue("content changed", Arrays.equals(content, testContent));
+
+        // the same, but through a channel
+        baos = new ByteArrayOutputStream();
+        client.streamFileContent(thisTest.getWCPath() + "/A/mu", null, null,
+                                 new ChannelOutputStream(
+                                     java.nio.channels.Channels.newChannel(
+                                         baos)));
+        assertTrue("content changed through channel",
+                   Arrays.equals(baos.toByteArray(), testContent));
     }
 
     /**
@@ -0,0 +1,464 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+package org.apache.subversion.javahl;
+
+import org.apache.subversion.javahl.callback.*;
+import org.apache.subversion.javahl.types.*;
+
+import java.io.ByteArrayInputStream;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.OutputStream;
+import java.nio.charset.Charset;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+
+/**
+ * Microbenchmarks for the JavaHL bindings.
+ * <p>
+ * These are not part of the default test suite.  Each test repeats
+ * one operation against a local repository or working copy and
+ * reports the average time per operation and per reported item.
+ * Comparing that with the time the command line client needs for
+ * the same operation shows the overhead of the JNI layer.
+ * <p>
+ * Run them with <code>make check-javahl-perf</code>.  The system
+ * properties <code>test.perf.files</code>,
+ * <code>test.perf.filesize</code>, <code>test.perf.warmup</code> and
+ * <code>test.perf.iterations</code> control the size of the test
+ * tree and the number of runs.
+ */
+public class PerfTests extends SVNTests
+{
+    private static final Charset UTF8 = Charset.forName("UTF-8");
+
+    /**
+     * The number of files in the test tree.
+     */
+    private final int fileCount =
+        Integer.getInteger("test.perf.files", 1000).intValue();
+
+    /**
+     * The size of the file fetched by {@link #testGetFile}.
+     */
+    private final int fileSize =
+        Integer.getInteger("test.perf.filesize", 1024 * 1024).intValue();
+
+    /**
+     * The number of untimed runs before the measurement.
+     */
+    private final int warmup =
+        Integer.getInteger("test.perf.warmup", 5).intValue();
+
+    /**
+     * The number of timed runs.
+     */
+    private final int iterations =
+        Integer.getInteger("test.perf.iterations", 20).intValue();
+
+    /**
+     * The files in the test tree, relative to the repository root.
+     */
+    private List<String> files;
+
+    /**
+     * The number of files already modified by {@link #alterFiles}.
+     */
+    private int altered;
+
+    protected OneTest thisTest;
+
+    public PerfTests()
+    {
+        init();
+    }
+
+    public PerfTests(String name)
+    {
+        super(name);
+        init();
+    }
+
+    /**
+     * Initialize the testBaseName and the testCounter, if this is the
+     * first test of this class.
+     */
+    private void init()
+    {
+        if (!testName.equals(testBaseName))
+        {
+            testCounter = 0;
+            testBaseName = testName;
+        }
+    }
+
+    /**
+     * Create the test repository and working copy, and add the test
+     * tree in r2.
+     */
+    protected void setUp() throws Exception
+    {
+        super.setUp();
+
+        thisTest = new OneTest();
+        files = new ArrayList<String>(fileCount);
+        altered = 0;
+
+        File perf = new File(thisTest.getWorkingCopy(), "perf");
+        for (int i = 0; i < fileCount; i++)
+        {
+            String relpath = String.format("perf/d%03d/f%05d", i / 100, i);
+            File file = new File(thisTest.getWorkingCopy(), relpath);
+
+            file.getParentFile().mkdirs();
+            writeFile(file, fileContents(relpath, 0));
+            files.add(relpath);
+        }
+
+        byte[] big = new byte[fileSize];
+        for (int i = 0; i < big.length; i++)
+            big[i] = (byte) (i % 251);
+        writeFile(new File(perf, "big"), big);
+
+        client.add(perf.getPath(), Depth.infinity, false, false, false);
+        client.commit(thisTest.getWCPathSet(), Depth.infinity,
+                      false, false, null, null,
+                      new ConstMsg("Add the benchmark tree"), null);
+        client.update(thisTest.getWCPathSet(), Revision.HEAD, Depth.unknown,
+                      false, false, false, false);
+    }
+
+    /**
+     * Measure a working copy status walk with one callback per node.
+     */
+    public void testStatus() throws Exception
+    {
+        measure("status", new Operation() {
+            public long run() throws ClientException
+            {
+                final long[] count = { 0 };
+
+                client.status(thisTest.getWCPath(), Depth.infinity,
+                              false, true, true, false, false, false, null,
+                              new StatusCallback() {
+                    public void doStatus(String path, Status status)
+                    { count[0]++; }
+                });
+                return count[0];
+            }
+        });
+    }
+
+    /**
+     * Measure a working copy status walk with batched callbacks.
+     */
+    public void testStatusBatch() throws Exception
+    {
+        measure("status (batched)", new Operation() {
+            public long run() throws ClientException
+            {
+                final long[] count = { 0 };
+
+                client.status(thisTest.getWCPath(), Depth.infinity,
+                              false, true, true, false, false, false, null,
+                              new StatusBatchCallback() {
+                    public void doStatus(String path, Status status)
+                    { count[0]++; }
+
+                    public void doStatus(String[] paths, Status[] statuses)
+                    { count[0] += statuses.length; }
+                });
+                return count[0];
+            }
+        });
+    }
+
+    /**
+     * Measure retrieving the working copy information of every node.
+     */
+    public void testInfo() throws Exception
+    {
+        measure("info", new Operation() {
+            public long run() throws ClientException
+            {
+                final long[] count = { 0 };
+
+                client.info(thisTest.getWCPath(), null, null, Depth.infinity,
+                            false, true, false, null, new InfoCallback() {
+                    public void singleInfo(Info info)
+                    { count[0]++; }
+                });
+                return count[0];
+            }
+        });
+    }
+
+    /**
+     * Measure retrieving the full history, including changed paths.
+     */
+    public void testLogMessages() throws Exception
+    {
+        ISVNRemote session = getSession();
+
+        /* One revision for each of the first hundred files */
+        try
+        {
+            alterFiles(session, Math.min(100, fileCount), 1);
+        }
+        finally
+        {
+            session.dispose();
+        }
+
+        final List<RevisionRange> ranges = new ArrayList<RevisionRange>();
+        ranges.add(new RevisionRange(Revision.HEAD, Revision.getInstance(1)));
+
+        measure("logMessages", new Operation() {
+            public long run() throws ClientException
+            {
+                final long[] count = { 0 };
+
+                client.logMessages(thisTest.getUrl().toString(), Revision.HEAD,
+                                   ranges, false, true, false, null, true, 0,
+                                   new LogMessageCallback() {
+                    public void singleMessage(Set<ChangePath> changedPaths,
+                                              long revision,
+                                              Map<String, byte[]> revprops,
+                                              boolean hasChildren)
+                    { count[0]++; }
+                });
+                return count[0];
+            }
+        });
+    }
+
+    /**
+     * Measure streaming a large file out of the repository.
+     */
+    public void testGetFile() throws Exception
+    {
+        final ISVNRemote session = getSession();
+
+        try
+        {
+            measure("getFile", new Operation() {
+                public long run() throws ClientException
+                {
+                    CountingStream contents = new CountingStream();
+
+                    session.getFile(Revision.SVN_INVALID_REVNUM, "perf/big",
+                                    contents, null);
+                    assertEquals(fileSize, contents.count);
+                    return 1;
+                }
+            });
+        }
+        finally
+        {
+            session.dispose();
+        }
+    }
+
+    /**
+     * Measure commits through the commit editor, modifying ten files
+     * in each.
+     */
+    public void testCommitEditor() throws Exception
+    {
+        final int filesPerCommit = 10;
+        final ISVNRemote session = getSession();
+
+        assertTrue("test.perf.files too small for the number of commits",
+                   (warmup + iterations) * filesPerCommit <= fileCount);
+
+        try
+        {
+            measure("commit editor", new Operation() {
+                public long run() throws Exception
+                {
+                    alterFiles(session, 1, filesPerCommit);
+                    return filesPerCommit;
+                }
+            });
+        }
+        finally
+        {
+            session.dispose();
+        }
+    }
+
+    /**
+     * An operation to measure.
+     */
+    private interface Operation
+    {
+        /**
+         * Run the operation once.
+         * @return the number of items the operation reported.
+         */
+        long run() throws Exception;
+    }
+
+    /**
+     * Run OP {@link #warmup} times, then time {@link #iterations}
+     * runs of it and print the result under NAME.
+     */
+    private void measure(String name, Operation op) throws Exception
+    {
+        long items = 0;
+        long start;
+        long elapsed;
+
+        for (int i = 0; i < warmup; i++)
+            op.run();
+
+        start = System.nanoTime();
+        for (int i = 0; i < iterations; i++)
+            items += op.run();
+        elapsed = System.nanoTime() - start;
+
+        assertTrue(name + " reported no items", items > 0);
+        System.out.println(String.format(
+            "%-20s %12.1f us/op %10.3f us/item %8d items/op",
+            name,
+            elapsed / 1000.0 / iterations,
+            elapsed / 1000.0 / items,
+            items / iterations));
+    }
+
+    /**
+     * Commit COMMITS revisions through the commit editor of SESSION,
+     * each of which modifies FILES_PER_COMMIT files of the test tree
+     * that were not modified before.
+     */
+    private void alterFiles(ISVNRemote session, int commits,
+                            int filesPerCommit)
+        throws Exception
+    {
+        for (int i = 0; i < commits; i++)
+        {
+            CommitContext cc = new CommitContext(session);
+
+            try
+            {
+                for (int j = 0; j < filesPerCommit; j++)
+                {
+                    String relpath = files.get(altered++);
+                    byte[] contents = fileContents(relpath, 1);
+
+                    cc.editor.alterFile(relpath, 2,
+                                        new Checksum(SHA1(contents),
+                                                     Checksum.Kind.SHA1),
+                                        new ByteArrayInputStream(contents),
+                                        null);
+                }
+                cc.editor.complete();
+            }
+            finally
+            {
+                cc.editor.dispose();
+            }
+        }
+    }
+
+    private ISVNRemote getSession()
+    {
+        return SVNRemoteTests.getSession(thisTest.getUrl().toString(),
+                                         super.conf.getAbsolutePath());
+    }
+
+    private static byte[] fileContents(String relpath, int version)
+    {
+        return ("This is version " + version + " of '" + relpath + "'.\n")
+            .getBytes(UTF8);
+    }
+
+    private static void writeFile(File file, byte[] contents)
+        throws IOException
+    {
+        FileOutputStream out = new FileOutputStream(file);
+
+        try
+        {
+            out.write(contents);
+        }
+        finally
+        {
+            out.close();
+        }
+    }
+
+    private static byte[] SHA1(byte[] text) throws NoSuchAlgorithmException
+    {
+        MessageDigest md = MessageDigest.getInstance("SHA-1");
+        return md.digest(text);
+    }
+
+    /**
+     * An output stream that only counts the bytes written to it.
+     */
+    private static final class CountingStream extends OutputStream
+    {
+        public long count;
+
+        public void write(int b) { count++; }
+
+        public void write(byte[] b, int off, int len) { count += len; }
+    }
+
+    private static final class CommitContext implements CommitCallback
+    {
+        public final ISVNEditor editor;
+
+        public CommitContext(ISVNRemote session) throws ClientException
+        {
+            HashMap<String, byte[]> revprops = new HashMap<String, byte[]>();
+            revprops.put("svn:log", "Benchmark commit".getBytes(UTF8));
+
+            editor = session.getCommitEditor(revprops, this, null, false);
+        }
+
+        public void commitInfo(CommitInfo info) {}
+    }
+
+    private static final class ConstMsg implements CommitMessageCallback
+    {
+        private final String message;
+
+        ConstMsg(String message)
+        {
+            this.message = message;
+        }
+
+        public String getLogMessage(Set<CommitItem> items)
+        {
+            return message;
+        }
+    }
+}
@@ -435,6 +435,43 @@
 }
 #endif
 
+/* -----------------------------------------------------------------------
+   read from a stream into a caller-provided, writable Python buffer
+   (e.g. a bytearray or memoryview) without an intermediate copy
+*/
+#ifdef SWIGPYTHON
+%typemap(in) (char *readinto_buffer, apr_size_t *readinto_len)
+             ($*2_type temp, Py_buffer view, int have_view = 0) {
+    if (PyObject_GetBuffer($input, &view, PyBUF_WRITABLE) != 0)
+        SWIG_fail;
+    have_view = 1;
+    $1 = view.buf;
+    temp = view.len;
+    $2 = ($2_ltype)&temp;
+}
+
+%typemap(argout) (char *readinto_buffer, apr_size_t *readinto_len) {
+  %append_output(PyInt_FromLong(*$2));
+}
+
+%typemap(freearg) (char *readinto_buffer, apr_size_t *readinto_len) {
+  if (have_view$argnum)
+    PyBuffer_Release(&view$argnum);
+}
+
+%inline %{
+/* Fill READINTO_BUFFER from STREAM as far as possible, like
+   svn_stream_read_full(); used by svn.core.Stream.readinto(). */
+static svn_error_t *
+svn_swig_py_stream_readinto(svn_stream_t *stream,
+                            char *readinto_buffer,
+                            apr_size_t *readinto_len)
+{
+  return svn_stream_read_full(stream, readinto_buffer, readinto_len);
+}
+%}
+#endif
+
 /* -----------------------------------------------------------------------
    fix up the svn_stream_write() ptr/len arguments
 */
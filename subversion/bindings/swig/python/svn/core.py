@@ -176,6 +176,15 @@ class Stream:
     # read the amount specified
     return svn_stream_read(self._stream, int(amt))
 
+  def readinto(self, buf):
+    """Read up to len(buf) bytes into BUF, which must support the
+    writable buffer protocol (e.g. a bytearray or memoryview), and
+    return the number of bytes read.  Return 0 at the end of the
+    stream."""
+    if self._stream is None:
+      raise ValueError
+    return svn_swig_py_stream_readinto(self._stream, buf)
+
   def write(self, buf):
     if self._stream is None:
       raise ValueError
@@ -170,6 +170,24 @@ class SubversionCoreTestCase(unittest.TestCase):
     self.assertEqual(
       svn.core.svn_config_enumerate_sections2(cfg, enumerator), 1)
 
+  def test_stream_readinto(self):
+    stream = svn.core.Stream(svn.core.svn_stream_from_stringbuf("0123456789"))
+
+    buf = bytearray(4)
+    self.assertEqual(stream.readinto(buf), 4)
+    self.assertEqual(str(buf), "0123")
+
+    # Partial reads must not touch the rest of the buffer.
+    view = memoryview(buf)
+    self.assertEqual(stream.readinto(view[1:]), 3)
+    self.assertEqual(str(buf), "0456")
+    self.assertEqual(stream.readinto(buf), 3)
+    self.assertEqual(str(buf[:3]), "789")
+    self.assertEqual(stream.readinto(buf), 0)
+
+    self.assertRaises(TypeError, stream.readinto, "immutable")
+    stream.close()
+
 def suite():
     return unittest.defaultTestLoader.loadTestsFromTestCase(
       SubversionCoreTestCase)
@@ -241,6 +241,24 @@ svn_auth__make_session_auth(svn_auth_baton_t **session_auth_baton,
                             apr_pool_t *result_pool,
                             apr_pool_t *scratch_pool);
 
+/* Set *THREAD_AUTH_BATON to a new auth baton, allocated in RESULT_POOL,
+   for a thread other than the one that uses AUTH_BATON.
+
+   While *DETACHED is FALSE, requests for credentials are passed on to
+   AUTH_BATON, which may prompt, on the calling thread.  What they return
+   is cached in *THREAD_AUTH_BATON.  Once the caller sets *DETACHED,
+   *THREAD_AUTH_BATON only provides the cached credentials and those of
+   the disk cache, and never touches AUTH_BATON again.  This lets the
+   other thread authenticate further connections without prompting.
+
+   The run-time parameters relevant for this are copied from AUTH_BATON.
+ */
+void
+svn_auth__make_thread_auth(svn_auth_baton_t **thread_auth_baton,
+                           svn_auth_baton_t *auth_baton,
+                           const svn_boolean_t *detached,
+                           apr_pool_t *result_pool);
+
 #if (defined(WIN32) && !defined(__MINGW32__)) || defined(DOXYGEN)
 /**
  * Set @a *provider to an authentication provider that implements
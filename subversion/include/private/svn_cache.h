@@ -310,6 +310,52 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   svn_boolean_t allow_blocking_writes,
                                   apr_pool_t *result_pool);
 
+/**
+ * Like svn_cache__membuffer_cache_create() but, if @a huge_pages is set,
+ * ask the OS to back the cache memory with (transparent) huge pages.
+ * If @a numa_interleave is set, ask it to spread the cache memory evenly
+ * across all NUMA nodes.  Both settings are hints and are silently
+ * ignored where the OS does not support them.
+ */
+svn_error_t *
+svn_cache__membuffer_cache_create2(svn_membuffer_t **cache,
+                                   apr_size_t total_size,
+                                   apr_size_t directory_size,
+                                   apr_size_t segment_count,
+                                   svn_boolean_t thread_safe,
+                                   svn_boolean_t allow_blocking_writes,
+                                   svn_boolean_t huge_pages,
+                                   svn_boolean_t numa_interleave,
+                                   apr_pool_t *result_pool);
+
+/**
+ * Add a persistent, disk-based cache level to the membuffer @a cache.
+ * Items evicted from memory will be written to the file at @a path and
+ * read back into memory upon later cache misses.  The file will not grow
+ * beyond @a size bytes.  About 2% of that will be allocated in memory for
+ * the index, plus up to 2MB for buffering evicted items.  The file will
+ * only be written after the cache locks have been released.
+ *
+ * If @a path already contains data from a previous run, the index will be
+ * rebuilt from it and the cached items become available again.  The file
+ * will be locked exclusively, i.e. it cannot be shared between processes.
+ * Set @a thread_safe if @a cache has been created as thread-safe.
+ *
+ * This must be called before @a cache is being used.  Failures to read or
+ * write the file during cache operation silently disable the disk tier
+ * and empty the file.
+ *
+ * Allocations will be made in @a result_pool, temporaries in
+ * @a scratch_pool.
+ */
+svn_error_t *
+svn_cache__membuffer_enable_disk_tier(svn_membuffer_t *cache,
+                                      const char *path,
+                                      apr_uint64_t size,
+                                      svn_boolean_t thread_safe,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool);
+
 /**
  * @defgroup Standard priority classes for #svn_cache__create_membuffer_cache.
  * @{
@@ -363,6 +409,11 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
  * Typically, some UUID is used as part of the prefix in that scenario.
  * This flag is a mere hint and does not affect functionality.
  *
+ * svn_cache__get_info() reports the capacity of the whole shared
+ * @a membuffer but only the entries written through this cache as used,
+ * i.e. the share of @a membuffer that this cache currently occupies.
+ * Since that requires scanning all entries, don't call it too often.
+ *
  * These caches do not support svn_cache__iter.
  */
 svn_error_t *
@@ -391,6 +442,24 @@ svn_cache__create_null(svn_cache__t **cache_p,
                        const char *id,
                        apr_pool_t *result_pool);
 
+/**
+ * Creates a cache instance in @a *cache_p, allocated from @a result_pool,
+ * that puts @a near_cache in front of @a far_cache.  Lookups try
+ * @a near_cache first and copy entries found in @a far_cache into it.
+ * New data gets written to both caches.
+ *
+ * This allows e.g. a per-process membuffer cache to keep a local copy of
+ * what a memcached shared between many servers provides.  Both caches
+ * must use the same key length and (de-)serialization functions.
+ *
+ * The resulting cache does not support iteration.
+ */
+svn_error_t *
+svn_cache__create_tiered(svn_cache__t **cache_p,
+                         svn_cache__t *near_cache,
+                         svn_cache__t *far_cache,
+                         apr_pool_t *result_pool);
+
 /**
  * Sets @a handler to be @a cache's error handling routine.  If any
  * error is returned from a call to svn_cache__get or svn_cache__set, @a
@@ -433,6 +502,22 @@ svn_cache__get(void **value,
                const void *key,
                apr_pool_t *result_pool);
 
+/**
+ * Looks up all @a keys, an array of <tt>const void *</tt>, in @a cache
+ * and sets @a *values to an array of <tt>void *</tt> of the same length.
+ * Its elements are the values found for the respective keys, copied into
+ * @a result_pool like svn_cache__get() does, or NULL for keys that are
+ * not in the cache.  Keys may be NULL.
+ *
+ * Caches backed by a remote server fetch all keys in a single round-trip.
+ * Don't use this function with caches that may contain NULL values.
+ */
+svn_error_t *
+svn_cache__get_multi(apr_array_header_t **values,
+                     svn_cache__t *cache,
+                     const apr_array_header_t *keys,
+                     apr_pool_t *result_pool);
+
 /**
  * Looks for an entry indexed by @a key in @a cache,  setting @a *found
  * to TRUE if an entry has been found and FALSE otherwise.  @a key may be
@@ -561,6 +646,14 @@ svn_cache__get_global_membuffer_cache(void);
 svn_cache__info_t *
 svn_cache__membuffer_get_global_info(apr_pool_t *pool);
 
+/**
+ * Return the size stats of each segment of the global membuffer cache as
+ * an array of svn_cache__info_t, allocated in POOL.  The array will be
+ * empty if there is no global membuffer cache.
+ */
+apr_array_header_t *
+svn_cache__membuffer_get_global_segment_infos(apr_pool_t *pool);
+
 /**
  * Remove all current contents from CACHE.
  *
@@ -204,6 +204,27 @@ svn_client__mtcc_check_path(svn_node_kind_t *kind,
                             svn_client__mtcc_t *mtcc,
                             apr_pool_t *scratch_pool);
 
+/** Looks up the kinds of all @a relpaths (const char *) in @a revision of
+ * the repository of @a mtcc at once, with a single network round trip
+ * where the RA layer supports it, and caches them for the checks of the
+ * operations added to @a mtcc later.  If @a revision is
+ * #SVN_INVALID_REVNUM, use the HEAD revision, like
+ * svn_client__mtcc_add_copy() does.
+ *
+ * Callers that know the paths of their operations in advance should call
+ * this before adding them.  Failures to look up the paths are ignored, as
+ * the operations check the paths themselves.
+ *
+ * Perform temporary allocations in @a scratch_pool.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_client__mtcc_prefetch_kinds(const apr_array_header_t *relpaths,
+                                svn_revnum_t revision,
+                                svn_client__mtcc_t *mtcc,
+                                apr_pool_t *scratch_pool);
+
 /** Commits all operations stored in @a mtcc as a new revision and destroys
  * @a mtcc.
  *
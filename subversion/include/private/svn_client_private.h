@@ -341,6 +341,29 @@ svn_client__mergeinfo_log(svn_boolean_t finding_merged,
                           apr_pool_t *result_pool,
                           apr_pool_t *scratch_pool);
 
+/* Same as the public svn_client_log5 API, except for the addition of
+ * SEARCH_PATTERNS.
+ *
+ * If SEARCH_PATTERNS is not NULL, the repository may skip revisions that
+ * do not match it, see svn_ra__get_log_search().  This is only a hint to
+ * save bandwidth: REAL_RECEIVER may still be invoked for revisions that
+ * do not match and must do its own filtering.
+ */
+svn_error_t *
+svn_client__log_search(const apr_array_header_t *targets,
+                       const svn_opt_revision_t *peg_revision,
+                       const apr_array_header_t *opt_rev_ranges,
+                       int limit,
+                       svn_boolean_t discover_changed_paths,
+                       svn_boolean_t strict_node_history,
+                       svn_boolean_t include_merged_revisions,
+                       const apr_array_header_t *revprops,
+                       const apr_array_header_t *search_patterns,
+                       svn_log_entry_receiver_t real_receiver,
+                       void *real_receiver_baton,
+                       svn_client_ctx_t *ctx,
+                       apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
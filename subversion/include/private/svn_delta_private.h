@@ -108,6 +108,59 @@ svn_txdelta__read_raw_window_len(apr_size_t *window_len,
                                  svn_stream_t *stream,
                                  apr_pool_t *pool);
 
+/** Append the 4 byte header of an svndiff stream in version
+    @a svndiff_version to @a output. */
+void
+svn_txdelta__append_svndiff_header(svn_stringbuf_t *output,
+                                   int svndiff_version);
+
+/** Append the svndiff representation of @a window to @a output, using
+    svndiff version @a svndiff_version and @a compression_level.  This
+    produces the same data as the handler returned by
+    svn_txdelta_to_svndiff3() but does not depend on any previous window,
+    so consecutive windows of a delta may be encoded concurrently and be
+    concatenated afterwards.  Use @a scratch_pool for temporaries. */
+svn_error_t *
+svn_txdelta__append_svndiff_window(svn_stringbuf_t *output,
+                                   svn_txdelta_window_t *window,
+                                   int svndiff_version,
+                                   int compression_level,
+                                   apr_pool_t *scratch_pool);
+
+/** Like svn_txdelta_to_svndiff3() but compress up to @a thread_count
+    windows concurrently in worker threads.  The output is the same and
+    gets written to @a output in window order by the thread calling the
+    handler.  Falls back to svn_txdelta_to_svndiff3() if @a thread_count
+    is 1 or less, if there is no compression to parallelize or if threads
+    are not available. */
+void
+svn_txdelta__to_svndiff_parallel(svn_txdelta_window_handler_t *handler,
+                                 void **handler_baton,
+                                 svn_stream_t *output,
+                                 int svndiff_version,
+                                 int compression_level,
+                                 int thread_count,
+                                 apr_pool_t *pool);
+
+/** Opaque scratch memory for svn_txdelta__compose_windows(). */
+typedef struct svn_txdelta__composer_t svn_txdelta__composer_t;
+
+/** Return a new delta window composer allocated in @a result_pool.
+    All scratch memory needed for compositions will be allocated
+    from that pool as well and will be reused by later compositions. */
+svn_txdelta__composer_t *
+svn_txdelta__composer_create(apr_pool_t *result_pool);
+
+/** Like svn_txdelta_compose_windows() but use the scratch memory of
+    @a composer instead of allocating temporary data structures for
+    each call.  Composing long chains of windows with the same
+    @a composer keeps the number of allocations low. */
+svn_txdelta_window_t *
+svn_txdelta__compose_windows(svn_txdelta__composer_t *composer,
+                             const svn_txdelta_window_t *window_A,
+                             const svn_txdelta_window_t *window_B,
+                             apr_pool_t *pool);
+
 /* Return a debug editor that wraps @a wrapped_editor.
  *
  * The debug editor simply prints an indication of what callbacks are being
@@ -30,6 +30,7 @@
 
 #include "svn_types.h"
 #include "svn_io.h"
+#include "svn_diff.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -148,6 +149,114 @@ svn_diff_hunk__create_deletes_single_line(svn_diff_hunk_t **hunk,
 svn_linenum_t
 svn_diff_hunk__get_fuzz_penalty(const svn_diff_hunk_t *hunk);
 
+/** Make the hunks and the binary patch of @a patch read their texts from
+ * @a apr_file, which must be another handle on the patch file that
+ * @a patch has been parsed from.  This allows the patches of a patch file
+ * to be read from several threads, while the file is still being parsed.
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_diff__patch_set_file(svn_patch_t *patch,
+                         apr_file_t *apr_file,
+                         apr_pool_t *scratch_pool);
+
+/** One chunk of blame: the lines from token @a start up to the start of
+ * the next chunk are attributed to @a rev, which is opaque to the diff
+ * library.
+ */
+typedef struct svn_diff__blame_t
+{
+  const void *rev;                  /* the responsible revision */
+  apr_off_t start;                  /* the starting diff-token (line) */
+  struct svn_diff__blame_t *next;   /* the next chunk */
+} svn_diff__blame_t;
+
+/** A chain of blame chunks, mapping all lines of a file to revisions. */
+typedef struct svn_diff__blame_chain_t
+{
+  svn_diff__blame_t *blame;         /* linked list of blame chunks */
+  svn_diff__blame_t *avail;         /* linked list of free blame chunks */
+  apr_pool_t *pool;                 /* Allocate members from this pool. */
+} svn_diff__blame_chain_t;
+
+/** Return a new, empty blame chain allocated in @a result_pool.
+ *
+ * @since New in 1.10.
+ */
+svn_diff__blame_chain_t *
+svn_diff__blame_chain_create(apr_pool_t *result_pool);
+
+/** Return a blame chunk associated with @a rev for a change starting at
+ * token @a start, allocated in @a chain's pool.  The chunk is not linked
+ * into @a chain.
+ *
+ * @since New in 1.10.
+ */
+svn_diff__blame_t *
+svn_diff__blame_create(svn_diff__blame_chain_t *chain,
+                       const void *rev,
+                       apr_off_t start);
+
+/** Add the blame for the diffs between @a last_file and @a cur_file to
+ * @a chain, attributing changed lines to @a rev.  @a last_file may be
+ * NULL, in which case blame is added for every line of @a cur_file.
+ * Compare the files using @a diff_options.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_diff__blame_add_file(svn_diff__blame_chain_t *chain,
+                         const char *last_file,
+                         const char *cur_file,
+                         const void *rev,
+                         const svn_diff_file_options_t *diff_options,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *scratch_pool);
+
+/** Ensure that @a chain and @a chain_merged have the same number of
+ * chunks, and that corresponding chunks start at the same token.  Neither
+ * chain may be empty.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_diff__blame_normalize(svn_diff__blame_chain_t *chain,
+                          svn_diff__blame_chain_t *chain_merged);
+
+/** Like svn_diff_get_binary_diff_original_stream(), but if @a bpatch
+ * describes the original version as a git delta, apply it to the resulting
+ * version in @a result_file.  @a result_file may be NULL if the resulting
+ * version doesn't exist.
+ *
+ * Reading the stream fails with #SVN_ERR_DIFF_BASE_MISMATCH if the delta
+ * doesn't apply to @a result_file.
+ *
+ * @since New in 1.10.
+ */
+svn_stream_t *
+svn_diff__get_binary_diff_original_stream(
+                        const svn_diff_binary_patch_t *bpatch,
+                        apr_file_t *result_file,
+                        apr_pool_t *result_pool);
+
+/** Like svn_diff_get_binary_diff_result_stream(), but if @a bpatch
+ * describes the resulting version as a git delta, apply it to the original
+ * version in @a original_file.  @a original_file may be NULL if the
+ * original version doesn't exist.
+ *
+ * Reading the stream fails with #SVN_ERR_DIFF_BASE_MISMATCH if the delta
+ * doesn't apply to @a original_file.
+ *
+ * @since New in 1.10.
+ */
+svn_stream_t *
+svn_diff__get_binary_diff_result_stream(const svn_diff_binary_patch_t *bpatch,
+                                        apr_file_t *original_file,
+                                        apr_pool_t *result_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -62,6 +62,15 @@ extern "C" {
 char *
 svn_eol__find_eol_start(char *buf, apr_size_t len);
 
+/* Like svn_eol__find_eol_start but also stop at the first occurrence
+ * of @a c.  If any such byte is found, return the pointer to it, else
+ * return NULL.
+ *
+ * @since New in 1.10
+ */
+char *
+svn_eol__find_eol_or_char(char *buf, apr_size_t len, char c);
+
 /* Return the first eol marker found in buffer @a buf as a NUL-terminated
  * string, or NULL if no eol marker is found. Do not examine more than
  * @a len bytes in @a buf.
@@ -259,11 +259,20 @@ typedef struct svn_fs_fs__stats_t
 /* Scan all contents of the repository FS and return statistics in *STATS,
  * allocated in RESULT_POOL.  Report progress through PROGRESS_FUNC with
  * PROGRESS_BATON, if PROGRESS_FUNC is not NULL.
+ *
+ * Read up to JOBS shards in parallel, provided that the caches have been
+ * configured to be thread-safe.  If CACHE_DIR is not NULL, keep a summary
+ * file per packed shard in that directory and reuse it in later calls as
+ * long as the respective pack file has not been modified.  So, repeated
+ * calls will only read the shards that were added in the meantime.
+ *
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
+                     int jobs,
+                     const char *cache_dir,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
                      svn_cancel_func_t cancel_func,
@@ -46,6 +46,15 @@ extern "C" {
  */
 #define SVN_FS__TXN_MAX_LEN 220
 
+/** Flag for svn_fs_begin_txn2(): the transaction will be committed or
+ * aborted by this process and no other process will access it before
+ * that, e.g. a hook script.  The FS back-end may then keep parts of the
+ * transaction in memory instead of writing them to disk.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_TXN__IN_MEMORY                    0x10000
+
 /** Retrieve the lock-tokens associated in the context @a access_ctx.
  * The tokens are in a hash keyed with <tt>const char *</tt> tokens,
  * and with <tt>const char *</tt> values for the paths associated.
@@ -211,6 +220,133 @@ svn_fs__get_deleted_node(svn_fs_root_t **node_root,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
+/** Try to locate the contents of file @a path in @a root as a contiguous,
+ * unmodified byte range of some file on disk.  If that is possible, open
+ * that file in @a result_pool and return it in @a *file, setting
+ * @a *offset and @a *length to the position of the contents within it.
+ * Otherwise, set @a *file to NULL.
+ *
+ * This allows the contents to be sent to the network without copying them
+ * through user space.  It will typically only succeed for committed,
+ * non-deltified file contents.  Use @a scratch_pool for temporaries.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs__try_get_file_range(apr_file_t **file,
+                           apr_off_t *offset,
+                           svn_filesize_t *length,
+                           svn_fs_root_t *root,
+                           const char *path,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/** Like svn_fs__try_get_file_range() but for the svndiff data that turns
+ * the contents of file @a source_path in @a source_root into those of
+ * @a target_path in @a target_root.  As with svn_fs_get_file_delta_stream(),
+ * a NULL @a source_root means the empty file.
+ *
+ * This will only succeed if the backend happens to store the target
+ * contents as a delta against exactly that source.  The data found in
+ * the range is a complete svndiff stream, including its header, of any
+ * svndiff version.  Use @a scratch_pool for temporaries.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs__try_get_file_delta_range(apr_file_t **file,
+                                 apr_off_t *offset,
+                                 svn_filesize_t *length,
+                                 svn_fs_root_t *source_root,
+                                 const char *source_path,
+                                 svn_fs_root_t *target_root,
+                                 const char *target_path,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
+/** Tell the FS that the directory entries of all @a paths (const char *)
+ * in @a root will be requested soon, so it can read them in bulk and in
+ * whatever order is most efficient for its storage.  Subsequent calls to
+ * svn_fs_dir_entries() for these paths will then usually be served from
+ * the FS caches.
+ *
+ * This is merely a hint.  Paths that don't exist or aren't directories
+ * are ignored, and back-ends may ignore the request entirely.
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs__prefetch_dir_entries(svn_fs_root_t *root,
+                             const apr_array_header_t *paths,
+                             apr_pool_t *scratch_pool);
+
+/** Consult the changed-paths index of @a fs, if it has one, for the
+ * youngest revision older than @a before in which @a path or anything
+ * below it got changed.  Return that revision in @a *revision.
+ *
+ * If @a path itself or any of its parents got added, deleted or replaced
+ * in that revision or between it and @a before, set @a *structural to
+ * TRUE.  Callers following the history of a node must then fall back to
+ * the node history as @a path may refer to a different node there.
+ *
+ * Set @a *revision to #SVN_INVALID_REVNUM if the index does not cover
+ * the revisions in question or if there is no index at all.  In that
+ * case, the caller has to fall back to svn_fs_node_history2().
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs__changed_paths_prev(svn_revnum_t *revision,
+                           svn_boolean_t *structural,
+                           svn_fs_t *fs,
+                           const char *path,
+                           svn_revnum_t before,
+                           apr_pool_t *scratch_pool);
+
+/** Consult the changed-paths index of @a fs, if it has one, for the
+ * oldest revision younger than @a after but not younger than @a until
+ * in which @a path or any of its parents got added, deleted or replaced.
+ * Return that revision in @a *revision, or #SVN_INVALID_REVNUM if there
+ * is no such revision.
+ *
+ * Set @a *indexed to FALSE and ignore @a *revision if the index does not
+ * cover the whole revision range or if there is no index at all.
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs__changed_paths_next_structural(svn_revnum_t *revision,
+                                      svn_boolean_t *indexed,
+                                      svn_fs_t *fs,
+                                      const char *path,
+                                      svn_revnum_t after,
+                                      svn_revnum_t until,
+                                      apr_pool_t *scratch_pool);
+
+/** Consult the revision dates index of @a fs, if it has one, for the
+ * youngest revision whose @c svn:date is not younger than @a tm.  Return
+ * that revision in @a *revision, or 0 if @a tm predates all revisions.
+ *
+ * The index may lag behind revision property changes that bypassed the
+ * filesystem, e.g. during hotcopies.  Callers should check the answer
+ * against the actual revision properties.
+ *
+ * Set @a *revision to #SVN_INVALID_REVNUM if the index does not cover
+ * the revisions in question or if there is no index at all.  In that
+ * case, the caller has to search the revision properties.
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs__dated_revision(svn_revnum_t *revision,
+                       svn_fs_t *fs,
+                       apr_time_t tm,
+                       apr_pool_t *scratch_pool);
+
 
 /** @} */
 
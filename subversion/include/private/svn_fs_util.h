@@ -244,6 +244,158 @@ svn_fs__prop_lists_equal(apr_hash_t *a,
                          apr_hash_t *b,
                          apr_pool_t *pool);
 
+/* Infrastructure for efficiently calling fsync on files and directories.
+ *
+ * The idea is to have a container of open file handles (including
+ * directory handles on POSIX), at most one per file.  During the course
+ * of an FS operation that needs to be fsync'ed, all touched files and
+ * folders accumulate in the container.
+ *
+ * At the end of the FS operation, all file changes will be written the
+ * physical disk, once per file and folder.  Afterwards, all handles will
+ * be closed and the container is ready for reuse.
+ *
+ * To minimize the delay caused by the batch flush, run all fsync calls
+ * concurrently - if the OS supports multi-threading.
+ */
+
+/* Opaque container type.
+ */
+typedef struct svn_fs__batch_fsync_t svn_fs__batch_fsync_t;
+
+/* Initialize the concurrent fsync infrastructure.  Clean it up when
+ * OWNING_POOL gets cleared.
+ *
+ * This function must be called before using any of the other functions in
+ * in this module.  Repeated calls are harmless; only the first one has
+ * any effect.
+ */
+svn_error_t *
+svn_fs__batch_fsync_init(apr_pool_t *owning_pool);
+
+/* Set *RESULT_P to a new batch fsync structure, allocated in RESULT_POOL.
+ * If FLUSH_TO_DISK is not set, the resulting struct will not actually use
+ * fsync. */
+svn_error_t *
+svn_fs__batch_fsync_create(svn_fs__batch_fsync_t **result_p,
+                           svn_boolean_t flush_to_disk,
+                           apr_pool_t *result_pool);
+
+/* Open the file at FILENAME for read and write access.  Return it in *FILE
+ * and schedule it for fsync in BATCH.  If BATCH already contains an open
+ * file for FILENAME, return that instead creating a new instance.
+ *
+ * Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs__batch_fsync_open_file(apr_file_t **file,
+                              svn_fs__batch_fsync_t *batch,
+                              const char *filename,
+                              apr_pool_t *scratch_pool);
+
+/* Schedule the existing file at FILENAME for fsync in BATCH.  Unlike
+ * svn_fs__batch_fsync_open_file, this does not require write access to
+ * the file on platforms that can fsync without it.  Scheduling the same
+ * file more than once is harmless.
+ *
+ * Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs__batch_fsync_add_file(svn_fs__batch_fsync_t *batch,
+                             const char *filename,
+                             apr_pool_t *scratch_pool);
+
+/* Inform the BATCH that a file or directory has been created at PATH.
+ * "Created" means either newly created to renamed to PATH - even if another
+ * item with the same name existed before.  Depending on the OS, the correct
+ * path will scheduled for fsync.
+ *
+ * Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs__batch_fsync_new_path(svn_fs__batch_fsync_t *batch,
+                             const char *path,
+                             apr_pool_t *scratch_pool);
+
+/* For all files and directories in BATCH, flush all changes to disk and
+ * close the file handles.  Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs__batch_fsync_run(svn_fs__batch_fsync_t *batch,
+                        apr_pool_t *scratch_pool);
+
+/* Access logging for rev and pack file based backends.
+ *
+ * An access log is a fixed-size binary file that acts as a ring buffer:
+ * once CAPACITY records have been written, new records overwrite the
+ * oldest ones.  Any number of processes and filesystem instances may
+ * write to the same log file.  Records get buffered in memory and are
+ * written to disk in batches, as well as when the log object gets
+ * cleaned up.
+ */
+
+/* Opaque access log writer.
+ */
+typedef struct svn_fs__access_log_t svn_fs__access_log_t;
+
+/* A single access log record.
+ */
+typedef struct svn_fs__access_t
+{
+  /* Revision that the item belongs to. */
+  svn_revnum_t revision;
+
+  /* Set if REVISION had been packed at the time of the access. */
+  svn_boolean_t packed;
+
+  /* Byte offset of the item within the rev / pack file.  -1 if unknown,
+   * which is always the case for cache hits. */
+  apr_off_t offset;
+
+  /* Size of the item on disk in bytes.  0 if unknown. */
+  apr_uint32_t size;
+
+  /* Backend-specific item type, e.g. SVN_FS_FS__ITEM_TYPE_*. */
+  int item_type;
+
+  /* Whether the item has been served from cache instead of the file. */
+  svn_boolean_t cache_hit;
+} svn_fs__access_t;
+
+/* Open the access log at PATH, creating it with room for CAPACITY records
+ * if it does not exist, yet.  BLOCK_SIZE and SHARD_SIZE describe the
+ * repository and will be recorded in new log files for later analysis.
+ * Return the writer in *LOG, allocated in RESULT_POOL.  Remaining buffered
+ * records will be flushed when RESULT_POOL gets cleaned up.
+ */
+svn_error_t *
+svn_fs__access_log_open(svn_fs__access_log_t **log,
+                        const char *path,
+                        apr_uint32_t capacity,
+                        apr_uint32_t block_size,
+                        apr_uint32_t shard_size,
+                        apr_pool_t *result_pool);
+
+/* Add ACCESS to LOG.  This may write buffered records to disk.
+ */
+svn_error_t *
+svn_fs__access_log_add(svn_fs__access_log_t *log,
+                       const svn_fs__access_t *access);
+
+/* Write all records buffered in LOG to disk.
+ */
+svn_error_t *
+svn_fs__access_log_flush(svn_fs__access_log_t *log);
+
+/* Read the access log at PATH.  Return its svn_fs__access_t records in
+ * *ACCESSES, oldest first, and the repository's block and shard size
+ * as recorded in the log in *BLOCK_SIZE and *SHARD_SIZE, respectively.
+ * Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs__access_log_read(apr_array_header_t **accesses,
+                        apr_uint32_t *block_size,
+                        apr_uint32_t *shard_size,
+                        const char *path,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -85,6 +85,40 @@ svn_io__file_lock_autocreate(const char *lock_file,
                              apr_pool_t *pool);
 
 
+/** Tell the operating system that the @a length bytes starting at
+ * @a offset in @a file will be read soon, so that it may start fetching
+ * them in the background.  This is merely a hint.  It is a no-op on
+ * platforms that don't support it and any errors will be ignored.
+ */
+void
+svn_io__file_prefetch(apr_file_t *file,
+                      apr_off_t offset,
+                      apr_off_t length);
+
+
+/** Copy all of @a from_file, which must be positioned at its start, to
+ * the empty @a to_file.  Where possible, let the operating system do the
+ * copying or make both files share their data on copy-on-write file
+ * systems.
+ * Use @a pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__file_copy_contents(apr_file_t *from_file,
+                           apr_file_t *to_file,
+                           apr_pool_t *pool);
+
+
+/** Create @a to_path as a hard link to the existing file @a from_path.
+ * Fail if @a to_path exists or if the file system does not support
+ * hard links between those locations.
+ * Use @a pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__file_link(const char *from_path,
+                  const char *to_path,
+                  apr_pool_t *pool);
+
+
 /** Return the underlying file, if any, associated with the stream, or
  * NULL if not available.  Accessing the file bypasses the stream.
  */
@@ -287,6 +287,21 @@ svn_rangelist__merge_many(svn_rangelist_t *merged_rangelist,
                           apr_pool_t *result_pool,
                           apr_pool_t *scratch_pool);
 
+/* Intersect the given INTERSECTED_RANGELIST with every rangelist in the
+ * hash RANGELISTS, which maps arbitrary keys to rangelists.  New elements
+ * of INTERSECTED_RANGELIST are allocated in RESULT_POOL.  See
+ * svn_rangelist_intersect() for the meaning of CONSIDER_INHERITANCE.
+ *
+ * Like svn_rangelist__merge_many(), this works on a packed copy of the
+ * rangelists and is much cheaper than one svn_rangelist_intersect() call
+ * per element of RANGELISTS. */
+svn_error_t *
+svn_rangelist__intersect_many(svn_rangelist_t *intersected_rangelist,
+                              apr_hash_t *rangelists,
+                              svn_boolean_t consider_inheritance,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
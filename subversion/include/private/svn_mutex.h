@@ -104,6 +104,77 @@ do {                                                    \
   SVN_ERR(svn_mutex__unlock(svn_mutex__m, (expr)));     \
 } while (0)
 
+/**
+ * This is a simple wrapper around @c apr_thread_rwlock_t and will be a
+ * valid identifier even if APR does not support threading.
+ */
+
+/** A reader-writer lock for synchronization between threads.  Any number
+ * of threads may hold it in shared mode at the same time but only one in
+ * exclusive mode.  Like #svn_mutex__t, it may be NULL, in which case no
+ * synchronization will take place.
+ */
+typedef struct svn_rwlock__t svn_rwlock__t;
+
+/** Initialize the @a *lock. If @a lock_required is TRUE, the lock will
+ * actually be created with a lifetime defined by @a result_pool. Otherwise,
+ * the pointer will be set to @c NULL and the locking functions will be
+ * no-ops.
+ *
+ * Recursive locking is not supported in either mode.
+ *
+ * If threading is not supported by APR, this function is a no-op.
+ */
+svn_error_t *
+svn_rwlock__init(svn_rwlock__t **lock,
+                 svn_boolean_t lock_required,
+                 apr_pool_t *result_pool);
+
+/** Acquire the @a lock in shared mode, i.e. for read access.  Make sure
+ * to call svn_rwlock__unlock() some time later in the same thread.
+ *
+ * @note You should use #SVN_RWLOCK__WITH_READ_LOCK instead of explicit
+ * lock acquisition and release.
+ */
+svn_error_t *
+svn_rwlock__read_lock(svn_rwlock__t *lock);
+
+/** Acquire the @a lock in exclusive mode, i.e. for write access.  Make
+ * sure to call svn_rwlock__unlock() some time later in the same thread.
+ *
+ * @note You should use #SVN_RWLOCK__WITH_WRITE_LOCK instead of explicit
+ * lock acquisition and release.
+ */
+svn_error_t *
+svn_rwlock__write_lock(svn_rwlock__t *lock);
+
+/** Release the @a lock, previously acquired in either mode.  @a err is
+ * being handled as in svn_mutex__unlock().
+ */
+svn_error_t *
+svn_rwlock__unlock(svn_rwlock__t *lock,
+                   svn_error_t *err);
+
+/** Acquires the @a lock in shared mode, executes the expression @a expr
+ * and finally releases the @a lock, like #SVN_MUTEX__WITH_LOCK.
+ */
+#define SVN_RWLOCK__WITH_READ_LOCK(lock, expr)          \
+do {                                                    \
+  svn_rwlock__t *svn_rwlock__l = (lock);                \
+  SVN_ERR(svn_rwlock__read_lock(svn_rwlock__l));        \
+  SVN_ERR(svn_rwlock__unlock(svn_rwlock__l, (expr)));   \
+} while (0)
+
+/** Acquires the @a lock in exclusive mode, executes the expression @a expr
+ * and finally releases the @a lock, like #SVN_MUTEX__WITH_LOCK.
+ */
+#define SVN_RWLOCK__WITH_WRITE_LOCK(lock, expr)         \
+do {                                                    \
+  svn_rwlock__t *svn_rwlock__l = (lock);                \
+  SVN_ERR(svn_rwlock__write_lock(svn_rwlock__l));       \
+  SVN_ERR(svn_rwlock__unlock(svn_rwlock__l, (expr)));   \
+} while (0)
+
 #if APR_HAS_THREADS
 
 /** Return the APR mutex encapsulated in @a mutex.
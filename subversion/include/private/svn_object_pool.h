@@ -74,12 +74,16 @@ typedef struct svn_object_pool__t svn_object_pool__t;
  * If THREAD_SAFE is not set, neither the object pool nor the object
  * references returned from it may be accessed from multiple threads.
  *
+ * If EXCLUSIVE is set, each object will be referenced at most once.
+ * Released objects get parked and may be handed out by a later lookup.
+ *
  * It is not legal to call any API on the object pool after POOL got
  * cleared or destroyed nor to use any objects from this object pool.
  */
 svn_error_t *
 svn_object_pool__create(svn_object_pool__t **object_pool,
                         svn_boolean_t thread_safe,
+                        svn_boolean_t exclusive,
                         apr_pool_t *pool);
 
 /* Return a pool to allocate the new object.
@@ -89,6 +93,7 @@ svn_object_pool__new_item_pool(svn_object_pool__t *object_pool);
 
 /* In OBJECT_POOL, look for an available object by KEY and return a
  * reference to it in *OBJECT.  If none can be found, *OBJECT will be NULL.
+ * In exclusive mode, only objects not referenced by anyone are available.
  *
  * The reference will be returned when *RESULT_POOL and may be destroyed
  * or recycled by OBJECT_POOL.
@@ -175,6 +175,18 @@ svn_packed__data_write(svn_stream_t *stream,
                        svn_packed__data_root_t *root,
                        apr_pool_t *scratch_pool);
 
+/* Like svn_packed__data_write() but compress the contents of all byte
+ * sequence streams using the preset DICTIONARY.  The same DICTIONARY must
+ * be passed to svn_packed__data_read2() to read the data back.  If
+ * DICTIONARY is NULL or empty, this is equivalent to
+ * svn_packed__data_write().
+ */
+svn_error_t *
+svn_packed__data_write2(svn_stream_t *stream,
+                        svn_packed__data_root_t *root,
+                        const svn_string_t *dictionary,
+                        apr_pool_t *scratch_pool);
+
 
 /* Reading data. */
 
@@ -253,6 +265,16 @@ svn_packed__data_read(svn_packed__data_root_t **root_p,
                       apr_pool_t *result_pool,
                       apr_pool_t *scratch_pool);
 
+/* Like svn_packed__data_read() but for data that has been written by
+ * svn_packed__data_write2() using the same DICTIONARY.
+ */
+svn_error_t *
+svn_packed__data_read2(svn_packed__data_root_t **root_p,
+                       svn_stream_t *stream,
+                       const svn_string_t *dictionary,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -32,6 +32,7 @@
 #include "svn_error.h"
 #include "svn_ra.h"
 #include "svn_delta.h"
+#include "svn_diff.h"
 #include "svn_editor.h"
 #include "svn_io.h"
 
@@ -66,6 +67,247 @@ svn_ra__dup_session(svn_ra_session_t **new_session,
                     apr_pool_t *result_pool,
                     apr_pool_t *scratch_pool);
 
+/**
+ * Like svn_ra_stat() but for all relpaths in @a paths at once.  Set
+ * @a *dirents to a hash mapping each of those paths that exists in
+ * @a revision to its #svn_dirent_t.  Non-existent paths will not be
+ * in that hash.
+ *
+ * RA layers may send all requests before waiting for the first response,
+ * so that the whole batch takes only a single network round trip.
+ *
+ * Allocate @a *dirents in @a result_pool. Perform temporary allocations
+ * in @a scratch_pool.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra__stat_many(svn_ra_session_t *session,
+                  apr_hash_t **dirents,
+                  const apr_array_header_t *paths,
+                  svn_revnum_t revision,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool);
+
+/**
+ * Receive one chunk of blame from svn_ra__get_file_blame(): the lines
+ * from @a start_line (zero-based) up to the @a start_line of the next
+ * chunk, or up to the end of the file for the last chunk, were last
+ * changed in @a revision, which has the revision properties
+ * @a rev_props.  @a revision is #SVN_INVALID_REVNUM and @a rev_props is
+ * NULL for lines that predate the start of the blame range.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_ra__blame_receiver_t)(void *baton,
+                                                 apr_int64_t start_line,
+                                                 svn_revnum_t revision,
+                                                 apr_hash_t *rev_props,
+                                                 apr_pool_t *scratch_pool);
+
+/**
+ * Let the server compute the blame of the file @a path, relative to the
+ * session URL, from @a start to @a end, and report the resulting chunks
+ * in order to @a receiver with @a receiver_baton.  The chunks refer to
+ * the lines of @a path in @a end.  @a start must not be greater than
+ * @a end.  The server compares subsequent revisions using
+ * @a diff_options.  Merged revisions are not taken into account.
+ *
+ * This saves transferring all intermediate file revisions, as
+ * svn_ra_get_file_revs2() would.  Return #SVN_ERR_RA_NOT_IMPLEMENTED if
+ * the RA layer or the server does not support this.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra__get_file_blame(svn_ra_session_t *session,
+                       const char *path,
+                       svn_revnum_t start,
+                       svn_revnum_t end,
+                       const svn_diff_file_options_t *diff_options,
+                       svn_ra__blame_receiver_t receiver,
+                       void *receiver_baton,
+                       apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_ra_get_log2() with @a include_merged_revisions set to
+ * @c FALSE, but let the server skip revisions that do not match
+ * @a search_patterns.  See svn_repos__get_logs_search() for how the
+ * groups of patterns in @a search_patterns are matched.
+ *
+ * The server may ignore @a search_patterns and send all revisions,
+ * e.g. if it does not support searching, so the caller must still
+ * filter the received entries itself.  As with svn_ra_get_log2(),
+ * @a limit counts the revisions examined, not the ones sent.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra__get_log_search(svn_ra_session_t *session,
+                       const apr_array_header_t *paths,
+                       svn_revnum_t start,
+                       svn_revnum_t end,
+                       int limit,
+                       svn_boolean_t discover_changed_paths,
+                       svn_boolean_t strict_node_history,
+                       const apr_array_header_t *revprops,
+                       const apr_array_header_t *search_patterns,
+                       svn_log_entry_receiver_t receiver,
+                       void *receiver_baton,
+                       apr_pool_t *pool);
+
+/** Queue of outstanding RA requests on a single session.
+ *
+ * Requests get queued with svn_ra__async_stat() etc. and report their
+ * results to completion callbacks once svn_ra__async_run() is called.
+ * This allows a single thread to have many requests in flight without
+ * waiting for each response in turn.
+ *
+ * @since New in 1.10.
+ */
+typedef struct svn_ra__async_t svn_ra__async_t;
+
+/** Completion callback for svn_ra__async_stat().  @a dirent is the
+ * #svn_dirent_t of @a path, or @c NULL if it does not exist.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_ra__async_stat_cb_t)(void *baton,
+                                                const char *path,
+                                                const svn_dirent_t *dirent,
+                                                apr_pool_t *scratch_pool);
+
+/** Completion callback for svn_ra__async_get_file().  @a props are the
+ * properties of @a path in @a fetched_rev.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_ra__async_file_cb_t)(void *baton,
+                                                const char *path,
+                                                svn_revnum_t fetched_rev,
+                                                apr_hash_t *props,
+                                                apr_pool_t *scratch_pool);
+
+/** Completion callback for svn_ra__async_get_dir().  @a dirents and
+ * @a props are as returned by svn_ra_get_dir2() for @a path in
+ * @a fetched_rev.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_ra__async_dir_cb_t)(void *baton,
+                                               const char *path,
+                                               apr_hash_t *dirents,
+                                               svn_revnum_t fetched_rev,
+                                               apr_hash_t *props,
+                                               apr_pool_t *scratch_pool);
+
+/** Completion callback for svn_ra__async_get_log(), invoked after the
+ * last log entry has been received.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_ra__async_log_cb_t)(void *baton,
+                                               apr_pool_t *scratch_pool);
+
+/**
+ * Set @a *async to a new, empty request queue for @a session, allocated
+ * in @a result_pool.  @a session must not be used for anything else
+ * while svn_ra__async_run() is being executed.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra__async_create(svn_ra__async_t **async,
+                     svn_ra_session_t *session,
+                     apr_pool_t *result_pool);
+
+/**
+ * Queue a svn_ra_stat() of @a path in @a revision on @a async and report
+ * the result to @a callback with @a baton.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra__async_stat(svn_ra__async_t *async,
+                   const char *path,
+                   svn_revnum_t revision,
+                   svn_ra__async_stat_cb_t callback,
+                   void *baton);
+
+/**
+ * Queue a svn_ra_get_file() of @a path in @a revision on @a async.  The
+ * contents will be written to @a stream, which will not be closed.
+ * Report the completion to @a callback with @a baton.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra__async_get_file(svn_ra__async_t *async,
+                       const char *path,
+                       svn_revnum_t revision,
+                       svn_stream_t *stream,
+                       svn_ra__async_file_cb_t callback,
+                       void *baton);
+
+/**
+ * Queue a svn_ra_get_dir2() of @a path in @a revision with
+ * @a dirent_fields on @a async and report the result to @a callback
+ * with @a baton.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra__async_get_dir(svn_ra__async_t *async,
+                      const char *path,
+                      svn_revnum_t revision,
+                      apr_uint32_t dirent_fields,
+                      svn_ra__async_dir_cb_t callback,
+                      void *baton);
+
+/**
+ * Queue a svn_ra_get_log2() on @a async.  All parameters up to
+ * @a receiver_baton are as for svn_ra_get_log2() and must remain valid
+ * until svn_ra__async_run() returns.  After the last log entry, call
+ * @a callback with @a baton unless it is @c NULL.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra__async_get_log(svn_ra__async_t *async,
+                      const apr_array_header_t *paths,
+                      svn_revnum_t start,
+                      svn_revnum_t end,
+                      int limit,
+                      svn_boolean_t discover_changed_paths,
+                      svn_boolean_t strict_node_history,
+                      svn_boolean_t include_merged_revisions,
+                      const apr_array_header_t *revprops,
+                      svn_log_entry_receiver_t receiver,
+                      void *receiver_baton,
+                      svn_ra__async_log_cb_t callback,
+                      void *baton);
+
+/**
+ * Execute all requests queued on @a async and invoke their completion
+ * callbacks.  The queue will be empty afterwards.
+ *
+ * All stat requests for the same revision are sent as a single batch
+ * through svn_ra__stat_many(), i.e. pipelined by ra_svn and issued as
+ * concurrent requests by ra_serf.  Their callbacks get invoked before
+ * those of the other requests, which are executed in the order they
+ * were queued.  Stop at the first error, discarding the remaining
+ * requests.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra__async_run(svn_ra__async_t *async,
+                  apr_pool_t *scratch_pool);
+
 /* Equivalent to svn_ra__assert_capable_server()
    for SVN_RA_CAPABILITY_MERGEINFO. */
 svn_error_t *
@@ -164,6 +164,35 @@ svn_ra_svn__write_string(svn_ra_svn_conn_t *conn,
                          apr_pool_t *pool,
                          const svn_string_t *str);
 
+/** From now on, send and receive all data over @a conn as LZ4 compressed
+ * frames.  Anything still in the write buffer gets sent uncompressed.
+ * Both sides must switch at the same point in the protocol flow, i.e.
+ * right after the client's response to the server's greeting when both
+ * announced #SVN_RA_SVN_CAP_LZ4_STREAM.  Use @a pool for temporaries.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra_svn__enable_stream_compression(svn_ra_svn_conn_t *conn,
+                                      apr_pool_t *pool);
+
+/** Write @a len bytes of @a file, starting at @a offset, over the net
+ * as a single string.
+ *
+ * If @a conn talks to a plain socket and the platform supports it, the
+ * data is sent directly from @a file without being copied into the write
+ * buffer.  Otherwise, it gets read and written chunk by chunk.  Use
+ * @a pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra_svn__write_file_range(svn_ra_svn_conn_t *conn,
+                             apr_pool_t *pool,
+                             apr_file_t *file,
+                             apr_off_t offset,
+                             apr_size_t len);
+
 /** Write a cstring over the net.
  *
  * Writes will be buffered until the next read or flush.
@@ -847,6 +876,19 @@ svn_ra_svn__write_cmd_stat(svn_ra_svn_conn_t *conn,
                            const char *path,
                            svn_revnum_t rev);
 
+/** Send a "pipeline" command over connection @a conn, starting or,
+ * depending on @a pipelined, ending a batch of commands that are sent
+ * without waiting for their responses.  There is no response to this
+ * command.  The server must have the #SVN_RA_SVN_CAP_PIPELINED_COMMANDS
+ * capability.  Use @a pool for allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra_svn__write_cmd_pipeline(svn_ra_svn_conn_t *conn,
+                               apr_pool_t *pool,
+                               svn_boolean_t pipelined);
+
 /** Send a "get-file-revs" command over connection @a conn.
  * Use @a pool for allocations.
  *
@@ -860,6 +902,23 @@ svn_ra_svn__write_cmd_get_file_revs(svn_ra_svn_conn_t *conn,
                                     svn_revnum_t end,
                                     svn_boolean_t include_merged_revisions);
 
+/** Send a "get-file-blame" command over connection @a conn.  The diff
+ * options are given as @a diff_args, an array of const char * as
+ * accepted by svn_diff_file_options_parse().  The server must have the
+ * #SVN_RA_SVN_CAP_FILE_BLAME capability.  Use @a pool for allocations.
+ *
+ * @see #svn_ra__get_file_blame for a description.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_ra_svn__write_cmd_get_file_blame(svn_ra_svn_conn_t *conn,
+                                     apr_pool_t *pool,
+                                     const char *path,
+                                     svn_revnum_t start,
+                                     svn_revnum_t end,
+                                     const apr_array_header_t *diff_args);
+
 /** Send a "lock" command over connection @a conn.
  * Use @a pool for allocations.
  *
@@ -33,6 +33,7 @@
 #include "svn_repos.h"
 #include "svn_editor.h"
 #include "svn_config.h"
+#include "svn_diff.h"
 
 #include "private/svn_object_pool.h"
 #include "private/svn_string_private.h"
@@ -134,6 +135,10 @@ svn_repos__replay_ev2(svn_fs_root_t *root,
  * Since the mapping of log5 to ra_get_log is would basically duplicate the
  * log5->log4 adapter, we provide this log4 wrapper that does not create a
  * deprecation warning.
+ *
+ * If @a search_patterns is not @c NULL and @a include_merged_revisions
+ * is not set, this uses svn_repos__get_logs_search() instead of
+ * svn_repos_get_logs5().
  */
 svn_error_t *
 svn_repos__get_logs_compat(svn_repos_t *repos,
@@ -145,12 +150,49 @@ svn_repos__get_logs_compat(svn_repos_t *repos,
                            svn_boolean_t strict_node_history,
                            svn_boolean_t include_merged_revisions,
                            const apr_array_header_t *revprops,
+                           const apr_array_header_t *search_patterns,
                            svn_repos_authz_func_t authz_read_func,
                            void *authz_read_baton,
                            svn_log_entry_receiver_t receiver,
                            void *receiver_baton,
                            apr_pool_t *pool);
 
+/**
+ * Like svn_repos_get_logs5() with @a include_merged_revisions set to
+ * @c FALSE, but only invoke the receivers for revisions that match
+ * @a search_patterns.
+ *
+ * @a search_patterns is an array of groups, each an
+ * <tt>apr_array_header_t *</tt> of <tt>const char *</tt> glob patterns.
+ * A revision matches if all patterns of at least one group match; a
+ * pattern matches if it matches a substring of the author, date or log
+ * message revprops in @a revprops that are readable, or of a changed
+ * path (or its copy source) that is sent to @a path_change_receiver.
+ * Matching is case- and accent-insensitive like <tt>svn log --search</tt>.
+ * If @a search_patterns is @c NULL or empty, all revisions are sent.
+ *
+ * @a limit counts the revisions examined, not the ones that matched, so
+ * that the result agrees with filtering a limited log on the client.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos__get_logs_search(svn_repos_t *repos,
+                           const apr_array_header_t *paths,
+                           svn_revnum_t start,
+                           svn_revnum_t end,
+                           int limit,
+                           svn_boolean_t strict_node_history,
+                           const apr_array_header_t *revprops,
+                           const apr_array_header_t *search_patterns,
+                           svn_repos_authz_func_t authz_read_func,
+                           void *authz_read_baton,
+                           svn_repos_path_change_receiver_t path_change_receiver,
+                           void *path_change_receiver_baton,
+                           svn_repos_log_entry_receiver_t revision_receiver,
+                           void *revision_receiver_baton,
+                           apr_pool_t *scratch_pool);
+
 /**
  * @defgroup svn_config_pool Configuration object pool API
  * @{
@@ -161,8 +203,12 @@ svn_repos__get_logs_compat(svn_repos_t *repos,
  * Instances handed out are read-only and may be given to multiple callers
  * from multiple threads.  Configuration objects no longer referenced by
  * any user may linger for a while before being cleaned up.
+ *
+ * For local files, the pool also remembers their timestamps and sizes,
+ * so that repeated requests for unchanged files need neither read nor
+ * parse them again.
  */
-typedef svn_object_pool__t svn_repos__config_pool_t;
+typedef struct svn_repos__config_pool_t svn_repos__config_pool_t;
 
 /* Create a new configuration pool object with a lifetime determined by
  * POOL and return it in *CONFIG_POOL.
@@ -203,6 +249,49 @@ svn_repos__config_pool_get(svn_config_t **cfg,
 
 /** @} */
 
+/**
+ * @defgroup svn_repos_pool Repository object pool API
+ * @{
+ */
+
+/* Opaque thread-safe container for open repository objects.
+ *
+ * Each instance handed out is referenced by a single user only.  When
+ * that reference gets released, the instance is parked and may be handed
+ * out again for the same repository, saving the cost of re-opening it.
+ */
+typedef svn_object_pool__t svn_repos__repos_pool_t;
+
+/* Create a new repository pool object with a lifetime determined by
+ * POOL and return it in *REPOS_POOL.
+ *
+ * The THREAD_SAFE flag indicates whether the pool actually needs to be
+ * thread-safe and POOL must be also be thread-safe if this flag is set.
+ */
+svn_error_t *
+svn_repos__repos_pool_create(svn_repos__repos_pool_t **repos_pool,
+                             svn_boolean_t thread_safe,
+                             apr_pool_t *pool);
+
+/* Set *REPOS_P to an exclusive reference to the repository at PATH.
+ * Re-use an idle instance from REPOS_POOL, if available, or open a new
+ * one using FS_CONFIG otherwise.  All calls on the same REPOS_POOL must
+ * pass the same FS_CONFIG.
+ *
+ * The reference will be returned to REPOS_POOL when RESULT_POOL gets
+ * cleaned up.  The FS access context and warning handler will be reset
+ * at that point.  SCRATCH_POOL is used for temporary allocations.
+ */
+svn_error_t *
+svn_repos__repos_pool_get(svn_repos_t **repos_p,
+                          svn_repos__repos_pool_t *repos_pool,
+                          const char *path,
+                          apr_hash_t *fs_config,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/** @} */
+
 /* Adjust mergeinfo paths and revisions in ways that are useful when loading
  * a dump stream.
  *
@@ -325,6 +414,154 @@ svn_repos__dump_node_record(svn_stream_t *dump_stream,
                             svn_boolean_t content_length_always,
                             apr_pool_t *scratch_pool);
 
+/* Read the manifest of the segmented dump in DIR_PATH, as written by
+ * svn_repos_dump_fs_segments(), and return the absolute paths of all
+ * segment files in *SEGMENTS (const char *), in the order they need to
+ * be loaded.  Allocate *SEGMENTS in RESULT_POOL and use SCRATCH_POOL for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_repos__read_dump_manifest(apr_array_header_t **segments,
+                              const char *dir_path,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+/* Let svn_repos_finish_report() compute the text deltas of upcoming
+ * files on up to JOBS worker threads while the editor is being driven
+ * for the report REPORT_BATON, as returned by svn_repos_begin_report3().
+ * The editor calls will still be made in the usual order from the
+ * calling thread.  JOBS values below 2 disable the prefetching, which is
+ * also the default.  This has no effect if APR has no thread support.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_repos__report_set_prefetch_jobs(void *report_baton,
+                                    int jobs);
+
+/* Let svn_repos_finish_report() send the contents of files that have no
+ * delta source, e.g. all files of a checkout, as plain fulltext windows
+ * if SEND_FULLTEXTS is set.  That saves the CPU time for compressing them
+ * against themselves but produces larger windows.  Only consumers that
+ * don't transmit the windows over the network, like ra_local, should
+ * enable this.  REPORT_BATON is as returned by svn_repos_begin_report3().
+ *
+ * @since New in 1.10.
+ */
+void
+svn_repos__report_set_send_fulltexts(void *report_baton,
+                                     svn_boolean_t send_fulltexts);
+
+/* Defer the post-commit hooks of REPOS to a queue stored in the
+ * repository if ASYNC is set, instead of running them before the commit
+ * returns.  Servers that enable this must call
+ * svn_repos__run_post_commit_queue() after every commit, once they have
+ * sent the response to the client.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_repos__set_async_post_commit(svn_repos_t *repos,
+                                 svn_boolean_t async);
+
+/* Run the post-commit hooks queued for REPOS in revision order and remove
+ * them from the queue.  Do nothing if the queue is empty or another thread
+ * or process is already running it; that one will pick up new entries.
+ * A hook that could not be run to completion, e.g. due to a crash, will
+ * be run again by the next call.  Return the errors of failed hooks only
+ * after all hooks have been run.  Use SCRATCH_POOL for temporaries.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos__run_post_commit_queue(svn_repos_t *repos,
+                                 apr_pool_t *scratch_pool);
+
+/* Receive one chunk of blame from svn_repos__get_file_blame(): the lines
+ * from START_LINE (zero-based) up to the START_LINE of the next chunk, or
+ * up to the end of the file for the last chunk, were last changed in
+ * REVISION, which has the revision properties REV_PROPS.  REVISION is
+ * SVN_INVALID_REVNUM for lines that predate the start of the blame range.
+ * REV_PROPS is NULL in that case.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+typedef svn_error_t *(*svn_repos__blame_receiver_t)(
+  void *baton,
+  apr_int64_t start_line,
+  svn_revnum_t revision,
+  apr_hash_t *rev_props,
+  apr_pool_t *scratch_pool);
+
+/* Compute the blame of the file PATH in REPOS from START to END, like
+ * svn_client_blame5() does without merged revisions, and report the
+ * resulting chunks in order to RECEIVER with RECEIVER_BATON.  The blame
+ * refers to the lines of PATH in END.  START must not be greater than
+ * END.  Compare subsequent revisions using DIFF_OPTIONS.
+ *
+ * The history of PATH is traced like svn_repos_get_file_revs2() does,
+ * subject to AUTHZ_READ_FUNC and AUTHZ_READ_BATON.  The successive file
+ * contents are kept in temporary files.
+ *
+ * If USE_CACHE is set and there is no AUTHZ_READ_FUNC, keep the result
+ * in the global membuffer cache, keyed by the node revision of PATH in
+ * END, START and DIFF_OPTIONS.  Later calls then only need to process
+ * the revisions that are newer than the latest cached node revision in
+ * the history of PATH.  The cache persists across processes if it has
+ * a disk tier.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos__get_file_blame(svn_repos_t *repos,
+                          const char *path,
+                          svn_revnum_t start,
+                          svn_revnum_t end,
+                          const svn_diff_file_options_t *diff_options,
+                          svn_repos_authz_func_t authz_read_func,
+                          void *authz_read_baton,
+                          svn_boolean_t use_cache,
+                          svn_repos__blame_receiver_t receiver,
+                          void *receiver_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool);
+
+/* Like svn_repos_authz_check_access() but for all PATHS at once.
+ * Set ACCESS_GRANTED[i] to indicate whether USER has the REQUIRED_ACCESS
+ * to the i-th path in PATHS.  ACCESS_GRANTED must have room for
+ * PATHS->NELTS elements.  The elements of PATHS are const char * fspaths
+ * and must not be NULL.
+ *
+ * PATHS may be in any order but if it is sorted, each path will only
+ * walk the rule tree from the deepest parent path that it shares with
+ * its predecessor.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos__authz_check_access_many(svn_boolean_t *access_granted,
+                                   svn_authz_t *authz,
+                                   const char *repos_name,
+                                   const apr_array_header_t *paths,
+                                   const char *user,
+                                   svn_repos_authz_access_t required_access,
+                                   apr_pool_t *scratch_pool);
+
+/* Return the revision that the DAV URI PATH explicitly addresses through
+ * one of the revision-specific resources below SPECIAL_URI, e.g.
+ * "/!svn/rev/5/trunk" or "/!svn/bc/5".  PATH is relative to the
+ * repository root.  Return SVN_INVALID_REVNUM for all other paths.
+ *
+ * @since New in 1.10.
+ */
+svn_revnum_t
+svn_repos__dav_uri_revision(const char *path,
+                            const char *special_uri);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
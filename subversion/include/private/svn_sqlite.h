@@ -96,6 +96,13 @@ svn_sqlite__insert(apr_int64_t *row_id, svn_sqlite__stmt_t *stmt);
 svn_error_t *
 svn_sqlite__update(int *affected_rows, svn_sqlite__stmt_t *stmt);
 
+/* Return the number of rows inserted, updated or deleted through DB since
+   it was opened, including changes made by triggers.  Comparing two
+   results tells whether DB was modified through this connection in
+   between. */
+int
+svn_sqlite__total_changes(svn_sqlite__db_t *db);
+
 /* Return in *VERSION the version of the schema in DB. Use SCRATCH_POOL
    for temporary allocations.  */
 svn_error_t *
@@ -129,6 +136,43 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  apr_int32_t timeout,
                  apr_pool_t *result_pool, apr_pool_t *scratch_pool);
 
+/* Switch DB to write-ahead logging if ENABLE is TRUE, or back to the
+   default rollback journal if it is FALSE.  Set *WAL to whether DB uses
+   write-ahead logging afterwards: the file system may not support it,
+   and DB stays in WAL mode while other connections use it.
+
+   With write-ahead logging, readers don't block the writer and vice
+   versa.  It needs shared memory between all users of DB, so it must
+   not be used on network file systems. */
+svn_error_t *
+svn_sqlite__set_wal(svn_boolean_t *wal,
+                    svn_sqlite__db_t *db,
+                    svn_boolean_t enable,
+                    apr_pool_t *scratch_pool);
+
+/* Make DB keep track of the pages that deletions leave unused, so that
+   svn_sqlite__incremental_vacuum() can return them to the file system
+   without rebuilding DB with a full VACUUM.  This must be called before
+   the first table is created.  For an existing DB, it only takes effect
+   after the next full VACUUM. */
+svn_error_t *
+svn_sqlite__enable_incremental_vacuum(svn_sqlite__db_t *db);
+
+/* If DB supports incremental vacuuming, set *SUPPORTED to TRUE and return
+   up to MAX_PAGES unused pages of DB to the file system.  Set *DONE to
+   whether DB has no unused pages left afterwards.  Otherwise, set both
+   *SUPPORTED and *DONE to FALSE.
+
+   Unlike VACUUM, this only holds the write lock on DB while it frees
+   MAX_PAGES, so calling it repeatedly lets other connections use DB in
+   between.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_sqlite__incremental_vacuum(svn_boolean_t *supported,
+                               svn_boolean_t *done,
+                               svn_sqlite__db_t *db,
+                               int max_pages,
+                               apr_pool_t *scratch_pool);
+
 /* Explicitly close the connection in DB. */
 svn_error_t *
 svn_sqlite__close(svn_sqlite__db_t *db);
@@ -131,6 +131,23 @@ svn_membuf__nzero(svn_membuf_t *membuf, apr_size_t size);
 svn_string_t *
 svn_stringbuf__morph_into_string(svn_stringbuf_t *strbuf);
 
+/** Initialize @a strbuf as an empty string that uses the caller-provided
+ * @a buffer of @a size bytes, including the NUL terminator, as its initial
+ * storage.  Only when the contents outgrow @a buffer, they will be moved
+ * to a new buffer allocated in @a pool.  @a size must not be 0.
+ *
+ * This is meant for temporary strings that are usually short, where
+ * both @a strbuf and @a buffer live on the stack.  The contents must be
+ * copied, e.g. with svn_string_ncreate(), if they shall outlive
+ * @a buffer, and @a strbuf must not be passed to
+ * svn_stringbuf__morph_into_string().
+ */
+void
+svn_stringbuf__init(svn_stringbuf_t *strbuf,
+                    char *buffer,
+                    apr_size_t size,
+                    apr_pool_t *pool);
+
 /** Utility macro to define static svn_string_t objects.  @a value must
  * be a static string; the "" in the macro declaration tries to ensure this.
  *
@@ -309,6 +326,21 @@ svn_prefix_string__t *
 svn_prefix_string__create(svn_prefix_tree__t *tree,
                           const char *s);
 
+/**
+ * Return the string with the value @a s stored in @a tree.  If no such
+ * string exists, return @c NULL.  Unlike svn_prefix_string__create(),
+ * this never modifies @a tree.
+ */
+svn_prefix_string__t *
+svn_prefix_string__find(const svn_prefix_tree__t *tree,
+                        const char *s);
+
+/**
+ * Return the number of distinct strings stored in @a tree.
+ */
+apr_size_t
+svn_prefix_tree__count(const svn_prefix_tree__t *tree);
+
 /**
  * Return the contents of @a s as a new string object allocated in @a pool.
  */
@@ -104,6 +104,20 @@ svn_spillbuf__create_extended(apr_size_t blocksize,
                               const char* dirpath,
                               apr_pool_t *result_pool);
 
+/* Create a spill buffer like svn_spillbuf__create() does, which appends
+   to its spill file from a background thread, so that writes don't wait
+   for the disk.  Content waits in two buffers of fixed size while it is
+   written.  Reads that catch up with the writer wait for it.
+
+   Only use the returned buffer through svn_spillbuf__write(),
+   svn_spillbuf__read() and svn_spillbuf__process(): the spill file may
+   lag behind what has been written.  Without thread support, this is
+   the same as svn_spillbuf__create().  */
+svn_spillbuf_t *
+svn_spillbuf__create_write_behind(apr_size_t blocksize,
+                                  apr_size_t maxsize,
+                                  apr_pool_t *result_pool);
+
 /* Determine how much content is stored in the spill buffer.  */
 svn_filesize_t
 svn_spillbuf__get_size(const svn_spillbuf_t *buf);
@@ -295,6 +309,54 @@ svn_checksum__wrap_write_stream_fnv1a_32x4(apr_uint32_t *digest,
                                            svn_stream_t *inner_stream,
                                            apr_pool_t *pool);
 
+/**
+ * Checksum context that calculates several checksums of different kinds
+ * in a single pass over the data.
+ */
+typedef struct svn_checksum__multi_ctx_t svn_checksum__multi_ctx_t;
+
+/**
+ * Return a new context that calculates checksums of the @a count kinds
+ * given in @a kinds over the same data.  Allocate it in @a pool.
+ */
+svn_checksum__multi_ctx_t *
+svn_checksum__multi_ctx_create(const svn_checksum_kind_t *kinds,
+                               int count,
+                               apr_pool_t *pool);
+
+/**
+ * Feed @a len bytes from @a data into all checksums calculated by @a ctx.
+ * The data gets processed in blocks small enough to stay in the CPU
+ * caches while each checksum passes over them.
+ */
+svn_error_t *
+svn_checksum__multi_update(svn_checksum__multi_ctx_t *ctx,
+                           const void *data,
+                           apr_size_t len);
+
+/**
+ * Return the checksum of type @a kind over all data fed into @a ctx in
+ * @a *checksum, allocated in @a pool.  Return #SVN_ERR_BAD_CHECKSUM_KIND
+ * if @a ctx does not calculate that kind of checksum.
+ */
+svn_error_t *
+svn_checksum__multi_final(svn_checksum_t **checksum,
+                          const svn_checksum__multi_ctx_t *ctx,
+                          svn_checksum_kind_t kind,
+                          apr_pool_t *pool);
+
+/**
+ * Like svn_checksum__wrap_write_stream but calculate both, the MD5 and
+ * the SHA-1 checksum in a single pass over the data and write them to
+ * @a *md5_checksum and @a *sha1_checksum, respectively.  Either of them
+ * may be NULL, in which case that checksum will not be calculated.
+ */
+svn_stream_t *
+svn_checksum__wrap_write_stream_multi(svn_checksum_t **md5_checksum,
+                                      svn_checksum_t **sha1_checksum,
+                                      svn_stream_t *inner_stream,
+                                      apr_pool_t *pool);
+
 /**
  * Return a 32 bit FNV-1a checksum for the first @a len bytes in @a input.
  *
@@ -303,6 +365,20 @@ svn_checksum__wrap_write_stream_fnv1a_32x4(apr_uint32_t *digest,
 apr_uint32_t
 svn__fnv1a_32(const void *input, apr_size_t len);
 
+/**
+ * Continue a 32 bit FNV-1a style checksum over @a len more bytes in
+ * @a input.  @a hash is the value returned by the previous call over the
+ * preceding data, or 0 for the first block.  Feeding the data in several
+ * blocks gives the same result as feeding it all at once.
+ *
+ * @note The result differs from svn__fnv1a_32() by a constant and is
+ *       only meant to be compared with other results of this function.
+ *
+ * @since New in 1.10
+ */
+apr_uint32_t
+svn__fnv1a_32_update(apr_uint32_t hash, const void *input, apr_size_t len);
+
 /**
  * Return a 32 bit modified FNV-1a checksum for the first @a len bytes in
  * @a input.
@@ -319,6 +395,42 @@ svn__fnv1a_32x4(const void *input, apr_size_t len);
 /** @} */
 
 
+/**
+ * @defgroup svn_cpu CPU feature detection
+ * @{
+ */
+
+/* Instruction set extensions that optimized code paths may require.
+ * Features that don't apply to the current architecture are never
+ * reported as available. */
+typedef enum svn_cpu__feature_t
+{
+  /* x86 / x86-64 */
+  svn_cpu__sse2 = 0x0001,
+  svn_cpu__ssse3 = 0x0002,
+  svn_cpu__sse41 = 0x0004,
+  svn_cpu__avx2 = 0x0008,
+  svn_cpu__sha = 0x0010,
+
+  /* ARM / AArch64 */
+  svn_cpu__neon = 0x0100
+} svn_cpu__feature_t;
+
+/* Return TRUE if the CPU we run on, and the OS, support all of the
+ * svn_cpu__feature_t flags in FEATURES.  The detection runs only once,
+ * so this is cheap enough to be called when selecting an implementation
+ * for every call.
+ *
+ * Code using the features still needs to be compiled for them, either
+ * for the whole build, e.g. SSE2 on x86-64, or per function via target
+ * attributes.
+ */
+svn_boolean_t
+svn_cpu__has_features(unsigned int features);
+
+/** @} */
+
+
 /**
  * @defgroup svn_hash_support Hash table serialization support
  * @{
@@ -573,6 +685,26 @@ svn__decompress_zlib(const void *data, apr_size_t len,
                      svn_stringbuf_t *out,
                      apr_size_t limit);
 
+/* Same as svn__compress_zlib(), but prime the compressor with the preset
+ * DICTIONARY.  Because the dictionary makes even short inputs
+ * compressible, DATA will be compressed regardless of its size.  If
+ * DICTIONARY is NULL or empty, this is equivalent to svn__compress_zlib().
+ */
+svn_error_t *
+svn__compress_zlib_dict(const void *data, apr_size_t len,
+                        svn_stringbuf_t *out,
+                        int compression_method,
+                        const svn_string_t *dictionary);
+
+/* Same as svn__decompress_zlib(), but for data that has been compressed
+ * by svn__compress_zlib_dict() with the same DICTIONARY.
+ */
+svn_error_t *
+svn__decompress_zlib_dict(const void *data, apr_size_t len,
+                          svn_stringbuf_t *out,
+                          apr_size_t limit,
+                          const svn_string_t *dictionary);
+
 /* Same as svn__compress_zlib(), but use LZ4 compression.  Note that
  * while the declaration of this function uses apr_size_t, it expects
  * blocks of size not exceeding LZ4_MAX_INPUT_SIZE.  The caller should
@@ -591,6 +723,29 @@ svn__decompress_lz4(const void *data, apr_size_t len,
                     svn_stringbuf_t *out,
                     apr_size_t limit);
 
+/* Return TRUE if this build of Subversion has been linked against zstd,
+ * i.e. if svn__compress_zstd() and svn__decompress_zstd() are usable.
+ */
+svn_boolean_t
+svn__zstd_supported(void);
+
+/* Same as svn__compress_zlib(), but use zstd compression at LEVEL, which
+ * is clipped to the range supported by the zstd library.  Return
+ * SVN_ERR_UNSUPPORTED_FEATURE if svn__zstd_supported() is FALSE.
+ */
+svn_error_t *
+svn__compress_zstd(const void *data, apr_size_t len,
+                   svn_stringbuf_t *out,
+                   int level);
+
+/* Same as svn__decompress_zlib(), but use zstd compression.  Return
+ * SVN_ERR_UNSUPPORTED_FEATURE if svn__zstd_supported() is FALSE.
+ */
+svn_error_t *
+svn__decompress_zstd(const void *data, apr_size_t len,
+                     svn_stringbuf_t *out,
+                     apr_size_t limit);
+
 /** @} */
 
 /**
@@ -726,6 +881,233 @@ svn_dso__pool(void);
 /** @} */
 
 
+/**
+ * @defgroup svn_hash_map Open-addressing hash map API
+ * @{
+ */
+
+/* This opaque data struct is an alternative to apr_hash_t for large,
+ * frequently accessed maps.
+ *
+ * Entries are stored in a single power-of-two sized table with linear
+ * probing.  A separate array of one-byte tags, derived from the key's
+ * hash, allows most probes to be resolved without touching the entries
+ * themselves.  There is no per-entry allocation and removals do not leave
+ * tombstones behind.  When growing, the old table gets released.
+ *
+ * Like with apr_hash_t, keys and values are not copied and must remain
+ * valid as long as they are in the map.
+ */
+typedef struct svn_hash_map__t svn_hash_map__t;
+
+/* Return a new, empty hash map allocated in POOL.  COUNT is a mere hint
+ * for the number of entries expected.
+ */
+svn_hash_map__t *
+svn_hash_map__create(apr_size_t count,
+                     apr_pool_t *pool);
+
+/* Return the value stored in MAP for the KLEN bytes of KEY or NULL,
+ * if there is no such entry.  KLEN may be APR_HASH_KEY_STRING.
+ */
+void *
+svn_hash_map__get(svn_hash_map__t *map,
+                  const void *key,
+                  apr_ssize_t klen);
+
+/* Set the value for the KLEN bytes of KEY in MAP to VALUE.  A NULL VALUE
+ * removes the entry.  KLEN may be APR_HASH_KEY_STRING.
+ */
+void
+svn_hash_map__set(svn_hash_map__t *map,
+                  const void *key,
+                  apr_ssize_t klen,
+                  const void *value);
+
+/* Return the number of entries in MAP.
+ */
+apr_size_t
+svn_hash_map__count(svn_hash_map__t *map);
+
+/* Remove all entries from MAP.  The allocated table will be kept.
+ */
+void
+svn_hash_map__clear(svn_hash_map__t *map);
+
+/* Iterate over MAP in no particular order.  Set *ITER to 0 before the
+ * first call.  If there is another entry, return its KEY, KLEN and VALUE
+ * and return TRUE.  Return FALSE at the end of the map.  Any of the
+ * output parameters may be NULL.
+ *
+ * The map must not be modified during the iteration, except for setting
+ * new, non-NULL values for existing keys.
+ */
+svn_boolean_t
+svn_hash_map__next(const void **key,
+                   apr_ssize_t *klen,
+                   void **value,
+                   svn_hash_map__t *map,
+                   apr_size_t *iter);
+
+/** @} */
+
+
+/**
+ * @defgroup svn_pool_stats Pool usage statistics
+ * @{
+ */
+
+/* Start collecting usage statistics for all pools created from now on,
+ * attributed to the source location that created them.  This should be
+ * called early in main(), before any other threads get started.
+ *
+ * The statistics count the pools created and released per location.
+ * Their sizes are only available if APR has been built with pool
+ * debugging.
+ */
+void
+svn_pool__stats_enable(void);
+
+/* Return a table of the LIMIT pool creation sites with the largest peak
+ * usage, or of all sites if LIMIT is 0.  Pools that have not been cleared
+ * or destroyed, yet, are not accounted for.  Return an empty string if
+ * statistics have not been enabled.  Allocate the result in RESULT_POOL.
+ */
+svn_string_t *
+svn_pool__stats_format(int limit,
+                       apr_pool_t *result_pool);
+
+/** @} */
+
+
+/**
+ * @defgroup svn_metrics Process-wide metrics
+ * @{
+ */
+
+/* A process-wide event counter.  Libraries define their counters
+ * statically and make them visible through svn_metrics__register().
+ *
+ * Increments are not atomic, i.e. under heavy concurrency, some events
+ * may not be counted.  The values are meant for monitoring only.
+ */
+typedef struct svn_metrics__counter_t
+{
+  /* Metric name, e.g. "svn_fsfs_commits_total".  Must be a valid
+   * Prometheus metric name. */
+  const char *name;
+
+  /* One-line description of what gets counted. */
+  const char *help;
+
+  /* Number of events counted so far. */
+  apr_uint64_t value;
+} svn_metrics__counter_t;
+
+/* A set of COUNT COUNTERS to be registered in one go.  Instances
+ * should be static; NEXT is used by the registry and must be NULL
+ * initially.
+ */
+typedef struct svn_metrics__group_t
+{
+  svn_metrics__counter_t *counters;
+  int count;
+  struct svn_metrics__group_t *next;
+} svn_metrics__group_t;
+
+/* Count an event on COUNTER, an svn_metrics__counter_t. */
+#define SVN_METRICS__INC(counter) ((void)++(counter).value)
+
+/* Make the counters in GROUP visible to svn_metrics__format_prometheus().
+ * Registering the same GROUP again has no effect.  This is thread-safe.
+ */
+void
+svn_metrics__register(svn_metrics__group_t *group);
+
+/* Return the statistics of the global membuffer cache, including the
+ * fill level of each of its segments, and the values of all registered
+ * counters in the Prometheus text exposition format.  Allocate the result
+ * in RESULT_POOL.
+ */
+svn_string_t *
+svn_metrics__format_prometheus(apr_pool_t *result_pool);
+
+/** @} */
+
+
+/**
+ * @defgroup svn_trace Request tracing
+ * @{
+ */
+
+/* A timed section of work, e.g. one ra_svn command or one block read.
+ * Spans of the same thread that lie within each other's time frame are
+ * considered nested. */
+typedef struct svn_trace__span_t svn_trace__span_t;
+
+/* Supported export formats for svn_trace__export(). */
+typedef enum svn_trace__format_t
+{
+  /* Chrome's "Trace Event" JSON format, as read by chrome://tracing. */
+  svn_trace__format_chrome,
+
+  /* OpenTelemetry's OTLP/JSON encoding of an ExportTraceServiceRequest. */
+  svn_trace__format_otlp
+} svn_trace__format_t;
+
+/* Start recording spans in this process and keep the most recent
+ * MAX_SPANS of them.  Only the first call has any effect.  Until then,
+ * all other tracing functions are no-ops that cost no more than a
+ * function call.
+ */
+svn_error_t *
+svn_trace__enable(apr_size_t max_spans);
+
+/* Return TRUE if svn_trace__enable() has been called successfully. */
+svn_boolean_t
+svn_trace__is_enabled(void);
+
+/* Return a new span called NAME starting now, or NULL if tracing has not
+ * been enabled.  NAME must remain valid for the rest of the process'
+ * lifetime, i.e. should be a string literal.
+ *
+ * The span gets allocated in POOL.  If it has not been ended explicitly
+ * when POOL gets cleared, e.g. because of an early error return, it will
+ * be ended at that point.
+ */
+svn_trace__span_t *
+svn_trace__span_begin(const char *name,
+                      apr_pool_t *pool);
+
+/* Attach the attribute KEY with VALUE to SPAN.  KEY must be a string
+ * literal, VALUE will be copied.  SPAN may be NULL.  Attributes beyond
+ * the first few of a span will be ignored.
+ */
+void
+svn_trace__span_attr(svn_trace__span_t *span,
+                     const char *key,
+                     const char *value);
+
+/* Like svn_trace__span_attr() but for an integer VALUE. */
+void
+svn_trace__span_attr_int(svn_trace__span_t *span,
+                         const char *key,
+                         apr_int64_t value);
+
+/* End SPAN now and record it.  SPAN may be NULL. */
+void
+svn_trace__span_end(svn_trace__span_t *span);
+
+/* Return all recorded spans in the given FORMAT, allocated in
+ * RESULT_POOL.  The result is valid but empty if tracing is disabled.
+ */
+svn_string_t *
+svn_trace__export(svn_trace__format_t format,
+                  apr_pool_t *result_pool);
+
+/** @} */
+
+
 /* Return the xml (expat) version we compiled against. */
 const char *svn_xml__compiled_version(void);
 
@@ -738,6 +1120,10 @@ const char *svn_zlib__compiled_version(void);
 /* Return the zlib version we run against. */
 const char *svn_zlib__runtime_version(void);
 
+/* Return the libdeflate version we compiled against, or NULL if whole
+   buffer zlib compression does not use libdeflate. */
+const char *svn_zlib__libdeflate_version(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -50,6 +50,13 @@ svn_utf__is_valid(const char *src, apr_size_t len);
 svn_boolean_t
 svn_utf__cstring_is_valid(const char *src);
 
+/* Return TRUE if the string SRC of length LEN consists of 7 bit ASCII
+ * characters only.  Such strings are valid UTF-8 and already in any
+ * Unicode normalization form.
+ */
+svn_boolean_t
+svn_utf__is_ascii(const char *src, apr_size_t len);
+
 /* Return a pointer to the first character after the last valid UTF-8
  * potentially multi-byte character in the string SRC of length LEN.
  * Validity of bytes from SRC to SRC+LEN-1, inclusively, is checked.
@@ -338,6 +338,54 @@ svn_wc__is_wcroot(svn_boolean_t *is_wcroot,
                   apr_pool_t *scratch_pool);
 
 
+/** Callback type used to fetch the pristine text of a file that a
+ * working copy using the lazy-pristines option no longer stores.
+ *
+ * Write the text of @a repos_relpath in @a revision of the repository
+ * at @a repos_root_url to @a stream, and leave @a stream open.  Use
+ * @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_wc__pristine_fetch_func_t)(
+  void *baton,
+  svn_stream_t *stream,
+  const char *repos_root_url,
+  const char *repos_relpath,
+  svn_revnum_t revision,
+  apr_pool_t *scratch_pool);
+
+/** Let the working copies accessed through @a wc_ctx fetch pristine
+ * texts they do not store by calling @a fetch_func with @a fetch_baton.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_wc__context_set_pristine_fetch(svn_wc_context_t *wc_ctx,
+                                   svn_wc__pristine_fetch_func_t fetch_func,
+                                   void *fetch_baton);
+
+/** Start answering repeated queries for the same nodes through
+ * @a wc_ctx from memory, until the working copy is modified through
+ * @a wc_ctx.  Every call must be matched by a call to
+ * svn_wc__read_cache_end(); calls nest.
+ *
+ * Modifications made by other processes are not noticed, so only use
+ * this while holding the write lock on the nodes that are read.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_wc__read_cache_begin(svn_wc_context_t *wc_ctx);
+
+/** Undo one svn_wc__read_cache_begin() on @a wc_ctx.
+ *
+ * @since New in 1.10.
+ */
+void
+svn_wc__read_cache_end(svn_wc_context_t *wc_ctx);
+
+
 /** Set @a *wcroot_abspath to the local abspath of the root of the
  * working copy in which @a local_abspath resides.
  */
@@ -382,6 +430,43 @@ svn_wc__status2_from_3(svn_wc_status2_t **status,
                        apr_pool_t *result_pool,
                        apr_pool_t *scratch_pool);
 
+/**
+ * Callback type used by the status walk to learn whether anything may
+ * have changed on disk in the directory @a local_abspath since the time
+ * @a since: an entry added, removed or renamed, or the contents or
+ * metadata of any immediate child modified.  Implementations typically
+ * sit on top of a file system change notification service.
+ *
+ * Set @a *changed to FALSE only if such changes can be ruled out; e.g.
+ * if the notification service was not running at @a since, or may have
+ * dropped events, set it to TRUE.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *(*svn_wc__dir_changed_func_t)(svn_boolean_t *changed,
+                                                   void *baton,
+                                                   const char *local_abspath,
+                                                   apr_time_t since,
+                                                   apr_pool_t *scratch_pool);
+
+/**
+ * Make svn_wc_walk_status() on @a wc_ctx remember the directory listings
+ * that it reads from disk, and reuse them during later walks for all
+ * directories for which @a changed_func, called with @a changed_baton,
+ * reports no change since the listing was read.  This saves most of the
+ * I/O of repeated status walks over large, mostly unchanged working
+ * copies.
+ *
+ * The remembered listings are allocated in @a wc_ctx's state pool.
+ * Passing NULL for @a changed_func drops them and disables the reuse.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_wc__status_set_dir_changed_func(svn_wc_context_t *wc_ctx,
+                                    svn_wc__dir_changed_func_t changed_func,
+                                    void *changed_baton);
+
 /**
  * Set @a *children to a new array of the immediate children of the working
  * node at @a dir_abspath.  The elements of @a *children are (const char *)
@@ -974,6 +1059,55 @@ svn_wc__node_get_commit_status(svn_boolean_t *added,
                                apr_pool_t *result_pool,
                                apr_pool_t *scratch_pool);
 
+/* A file whose text delta svn_wc__transmit_text_deltas_batch() sends.
+ * The caller fills in the first fields, the function the checksums. */
+typedef struct svn_wc__text_delta_target_t
+{
+  /* The file, and whether to send it as full text. */
+  const char *local_abspath;
+  svn_boolean_t fulltext;
+
+  /* The editor's baton for the file. */
+  void *file_baton;
+
+  /* For the caller's use. */
+  void *baton;
+
+  /* The checksums of the new text base, as they would be returned by
+     svn_wc_transmit_text_deltas3(). */
+  const svn_checksum_t *new_text_base_md5_checksum;
+  const svn_checksum_t *new_text_base_sha1_checksum;
+} svn_wc__text_delta_target_t;
+
+/* Like calling svn_wc_transmit_text_deltas3() for each of the
+ * svn_wc__text_delta_target_t * in TARGETS in turn, with both checksums
+ * requested.
+ *
+ * The deltas of the following files are computed on other threads while
+ * the EDITOR receives the current one, so that the CPU bound delta and
+ * checksum calculations overlap.  Computed deltas are kept in memory up
+ * to a limit and on disk beyond it.  EDITOR is driven in order from the
+ * calling thread only.
+ *
+ * If SENDING_FUNC is not NULL, call it with SENDING_BATON and the target
+ * just before sending each delta.
+ *
+ * On error, set *FAILED_TARGET to the target that failed, if any.
+ */
+svn_error_t *
+svn_wc__transmit_text_deltas_batch(
+                  const svn_wc__text_delta_target_t **failed_target,
+                  const apr_array_header_t *targets,
+                  svn_wc_context_t *wc_ctx,
+                  const svn_delta_editor_t *editor,
+                  svn_error_t *(*sending_func)(
+                                  void *baton,
+                                  const svn_wc__text_delta_target_t *target,
+                                  apr_pool_t *scratch_pool),
+                  void *sending_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool);
+
 /* Gets the md5 checksum for the pristine file identified by a sha1_checksum in the
    working copy identified by wri_abspath.
 
@@ -83,6 +83,46 @@ svn_cache_config_get(void);
 void
 svn_cache_config_set(const svn_cache_config_t *settings);
 
+/** Add a persistent second-level cache to the process-global cache.
+   Data evicted from memory will be stored in the file at @a path, which
+   will not grow beyond @a size bytes.  Upon a memory cache miss, data will
+   be read back from there.  The contents of the file are being reused when
+   the process gets restarted.  The file cannot be shared between processes.
+
+   Pass a @c NULL @a path or a @a size of 0 to disable the disk cache,
+   which is the default.  @a path must remain valid until the cache gets
+   created upon first use.
+
+   Like svn_cache_config_set(), this is not thread-safe and should be
+   called from the processes' initialization code only.
+
+   @since New in 1.10.
+ */
+void
+svn_cache_config_set_disk_cache(const char *path,
+                                apr_uint64_t size);
+
+/** Control the placement of the process-global cache in memory.
+
+   If @a huge_pages is set, the cache will be backed by huge pages where
+   the OS supports them, e.g. transparent huge pages on Linux.  That
+   reduces TLB misses for large caches.
+
+   If @a numa_interleave is set, the cache memory will be spread evenly
+   across all NUMA nodes, where supported.  On multi-socket machines, this
+   balances the load on the memory controllers instead of placing the
+   whole cache on the node of the thread that created it.
+
+   Both are disabled by default.  Like svn_cache_config_set(), this is not
+   thread-safe and should be called from the processes' initialization
+   code only.
+
+   @since New in 1.10.
+ */
+void
+svn_cache_config_set_memory_placement(svn_boolean_t huge_pages,
+                                      svn_boolean_t numa_interleave);
+
 /** @} */
 
 /** @} */
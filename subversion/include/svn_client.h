@@ -7530,6 +7530,27 @@ svn_client_open_ra_session2(svn_ra_session_t **session,
                            apr_pool_t *result_pool,
                            apr_pool_t *scratch_pool);
 
+/** Let @a ctx keep up to @a max_sessions RA sessions opened for URL-only
+ * operations, i.e. without a working copy, and reuse them for later
+ * operations on the same repository.  This saves the connection setup
+ * and authentication for tools that perform many operations through the
+ * same client context.
+ *
+ * A session becomes available for reuse when the pool that it has been
+ * returned in gets cleaned up.  Idle sessions older than @a idle_timeout
+ * will be closed.  Cached sessions keep the authentication baton and the
+ * other settings of @a ctx that were current when they got opened.
+ *
+ * Pass 0 for @a max_sessions to disable the cache, which is the default.
+ * Already cached sessions get closed once they become idle.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_client_set_ra_session_cache(svn_client_ctx_t *ctx,
+                                int max_sessions,
+                                apr_interval_time_t idle_timeout);
+
 /** Similar to svn_client_open_ra_session2(), but with @ wri_abspath
  * always passed as NULL, and with the same pool used as both @a
  * result_pool and @a scratch_pool.
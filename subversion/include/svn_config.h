@@ -112,6 +112,10 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_HTTP_MAX_CONNECTIONS      "http-max-connections"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS     "http-chunked-requests"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_HTTP_HTTP2                "http-http2"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_HTTP_BASELINE_CACHE       "http-baseline-cache"
 
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SERF_LOG_COMPONENTS       "serf-log-components"
@@ -161,6 +165,10 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_MEMORY_CACHE_SIZE         "memory-cache-size"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_DIFF_IGNORE_CONTENT_TYPE  "diff-ignore-content-type"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_EXTERNALS_CONCURRENCY     "externals-concurrency"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_LOG_CACHE                 "log-cache"
 #define SVN_CONFIG_SECTION_TUNNELS              "tunnels"
 #define SVN_CONFIG_SECTION_AUTO_PROPS           "auto-props"
 /** @since New in 1.8. */
@@ -171,6 +179,14 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SQLITE_EXCLUSIVE_CLIENTS  "exclusive-locking-clients"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_SQLITE_BUSY_TIMEOUT       "busy-timeout"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_COMPRESS_PRISTINES        "compress-pristines"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE     "shared-pristine-store"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_WAL_JOURNALING            "wal-journaling"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_LAZY_PRISTINES            "lazy-pristines"
 /** @} */
 
 /** @name Repository conf directory configuration files strings
@@ -191,6 +207,8 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_FORCE_USERNAME_CASE       "force-username-case"
 /** @since New in 1.8. */
 #define SVN_CONFIG_OPTION_HOOKS_ENV                 "hooks-env"
+/** @since New in 1.10. */
+#define SVN_CONFIG_OPTION_ASYNC_POST_COMMIT         "async-post-commit"
 /** @since New in 1.5. */
 #define SVN_CONFIG_SECTION_SASL                 "sasl"
 /** @since New in 1.5. */
@@ -522,7 +522,10 @@ svn_txdelta_apply(svn_stream_t *source,
  *
  * @since New in 1.7.  Since 1.10, @a svndiff_version can be 2 for the
  * svndiff2 format.  @a compression_level is currently ignored if
- * @a svndiff_version is set to 2.
+ * @a svndiff_version is set to 2.  Since 1.10, @a svndiff_version can
+ * also be 3 for the zstd-based svndiff3 format, in which case
+ * @a compression_level is the zstd compression level; producing and
+ * parsing svndiff3 requires a build of Subversion with zstd support.
  */
 void
 svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
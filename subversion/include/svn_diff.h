@@ -455,6 +455,22 @@ typedef enum svn_diff_file_ignore_space_t
   svn_diff_file_ignore_space_all
 } svn_diff_file_ignore_space_t;
 
+/** The algorithm used to find the differences between files.
+ *
+ * @since New in 1.10.
+ */
+typedef enum svn_diff_algorithm_t
+{
+  /** Find minimal differences, with an O(NP) algorithm. */
+  svn_diff_algorithm_default,
+
+  /** Use the histogram diff, which splits the files at common lines that
+   * occur rarely.  It takes near linear time on most files with many
+   * changes, where the default algorithm degrades, but does not always
+   * find minimal differences. */
+  svn_diff_algorithm_histogram
+} svn_diff_algorithm_t;
+
 /** Options to control the behaviour of the file diff routines.
  *
  * @since New in 1.4.
@@ -487,6 +503,12 @@ typedef struct svn_diff_file_options_t
    *
    * @since New in 1.9 */
   int context_size;
+
+  /** The algorithm used to find the differences.  The default is
+   * @c svn_diff_algorithm_default.
+   *
+   * @since New in 1.10 */
+  svn_diff_algorithm_t algorithm;
 } svn_diff_file_options_t;
 
 /** Allocate a @c svn_diff_file_options_t structure in @a pool, initializing
@@ -511,6 +533,7 @@ svn_diff_file_options_create(apr_pool_t *pool);
  * - --show-c-function, -p @since New in 1.5.
  * - --context, -U ARG @since New in 1.9.
  * - --unified, -u (for compatibility, does nothing).
+ * - --histogram @since New in 1.10.
  */
 svn_error_t *
 svn_diff_file_options_parse(svn_diff_file_options_t *options,
@@ -787,7 +810,8 @@ svn_diff_file_output_merge(svn_stream_t *output_stream,
 /** Creates a git-like binary diff hunk describing the differences between
  * @a original and @a latest. It does this by either producing either the
  * literal content of both versions in a compressed format, or by describing
- * one way transforms.
+ * one way transforms.  The latter are git deltas, used for larger versions
+ * when they are shorter than the literal content.
  *
  * Either @a original or @a latest may be NULL to describe that the version
  * didn't exist.
@@ -1226,6 +1250,10 @@ typedef struct svn_diff_binary_patch_t svn_diff_binary_patch_t;
  * as reading from the backing patch file. Therefore it is recommended to
  * read the whole stream before using other functions on the same patch file.
  *
+ * @note If the patch describes this version as a git delta against the
+ * resulting version, reading the stream fails with
+ * #SVN_ERR_DIFF_BASE_MISMATCH.
+ *
  * @since New in 1.10 */
 svn_stream_t *
 svn_diff_get_binary_diff_original_stream(const svn_diff_binary_patch_t *bpatch,
@@ -1239,6 +1267,10 @@ svn_diff_get_binary_diff_original_stream(const svn_diff_binary_patch_t *bpatch,
  * as reading from the backing patch file. Therefore it is recommended to
  * read the whole stream before using other functions on the same patch file.
  *
+ * @note If the patch describes this version as a git delta against the
+ * original version, reading the stream fails with
+ * #SVN_ERR_DIFF_BASE_MISMATCH.
+ *
  * @since New in 1.10 */
 svn_stream_t *
 svn_diff_get_binary_diff_result_stream(const svn_diff_binary_patch_t *bpatch,
@@ -138,6 +138,7 @@
 #include <apr_tables.h>
 
 #include "svn_types.h"
+#include "svn_string.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -236,6 +237,17 @@ svn_relpath_join(const char *base,
                  const char *component,
                  apr_pool_t *result_pool);
 
+/** Like svn_relpath_join() but write the result into @a buf, replacing
+ * its previous contents.  @a buf only grows if needed, so a buffer that
+ * is being reused in a loop will soon stop allocating memory.
+ *
+ * The result becomes invalid once @a buf gets modified.
+ */
+void
+svn_relpath__join_buf(svn_stringbuf_t *buf,
+                      const char *base,
+                      const char *component);
+
 /** Gets the name of the specified canonicalized @a dirent as it is known
  * within its parent directory. If the @a dirent is root, return "". The
  * returned value will not have slashes in it.
@@ -516,6 +528,27 @@ const char *
 svn_uri_canonicalize(const char *uri,
                      apr_pool_t *result_pool);
 
+/** Like svn_relpath_canonicalize() but return @a relpath itself if it is
+ * already canonical.  Only if it is not, allocate the result in
+ * @a result_pool.
+ *
+ * Use this instead of svn_relpath_canonicalize() if @a relpath lives at
+ * least as long as the result is needed.
+ */
+const char *
+svn_relpath__canonicalize_lazy(const char *relpath,
+                               apr_pool_t *result_pool);
+
+/** Like svn_uri_canonicalize() but return @a uri itself if it is already
+ * canonical.  Only if it is not, allocate the result in @a result_pool.
+ *
+ * Use this instead of svn_uri_canonicalize() if @a uri lives at least
+ * as long as the result is needed.
+ */
+const char *
+svn_uri__canonicalize_lazy(const char *uri,
+                           apr_pool_t *result_pool);
+
 /** Return @c TRUE iff @a dirent is canonical.
  *
  * Use @a scratch_pool for temporary allocations.
@@ -1477,6 +1477,16 @@ SVN_ERROR_START
              SVN_ERR_MISC_CATEGORY_START + 46,
              "LZ4 decompression failed")
 
+  /** @since New in 1.10. */
+  SVN_ERRDEF(SVN_ERR_ZSTD_COMPRESSION_FAILED,
+             SVN_ERR_MISC_CATEGORY_START + 47,
+             "zstd compression failed")
+
+  /** @since New in 1.10. */
+  SVN_ERRDEF(SVN_ERR_ZSTD_DECOMPRESSION_FAILED,
+             SVN_ERR_MISC_CATEGORY_START + 48,
+             "zstd decompression failed")
+
   /* command-line client errors */
 
   SVN_ERRDEF(SVN_ERR_CL_ARG_PARSING_ERROR,
@@ -1644,6 +1654,11 @@ SVN_ERROR_START
              SVN_ERR_DIFF_CATEGORY_START + 1,
              "Diff data unexpected")
 
+  /** @since New in 1.10 */
+  SVN_ERRDEF(SVN_ERR_DIFF_BASE_MISMATCH,
+             SVN_ERR_DIFF_CATEGORY_START + 2,
+             "Binary diff delta doesn't apply to its base")
+
   /* libsvn_ra_serf errors */
   /** @since New in 1.5.
       @deprecated SSPI now handled by serf rather than libsvn_ra_serf. */
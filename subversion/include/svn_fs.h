@@ -166,6 +166,30 @@ typedef struct svn_fs_t svn_fs_t;
  */
 #define SVN_FS_CONFIG_FSFS_LOG_ADDRESSING       "fsfs-log-addressing"
 
+/** Enable / disable LZ4 compressed changed paths lists in FSFS format 8
+ * for a newly created repository.  Older releases of the same format
+ * will not be able to open such repositories.
+ *
+ * This option will only be used during the creation of new repositories
+ * and is otherwise ignored.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_COMPRESSED_CHANGES   "fsfs-compressed-changes"
+
+/** Enable / disable the binary property list encoding in FSFS format 8
+ * for a newly created repository.  Node and revision properties are then
+ * stored length-prefixed instead of in hash dump format, which makes
+ * reading them much cheaper.  Older releases of the same format will not
+ * be able to open such repositories.
+ *
+ * This option will only be used during the creation of new repositories
+ * and is otherwise ignored.
+ *
+ * @since New in 1.10.
+ */
+#define SVN_FS_CONFIG_FSFS_BINARY_PROPERTIES    "fsfs-binary-properties"
+
 /* Note to maintainers: if you add further SVN_FS_CONFIG_FSFS_CACHE_* knobs,
    update fs_fs.c:verify_as_revision_before_current_plus_plus(). */
 
@@ -549,14 +573,38 @@ typedef void (*svn_fs_hotcopy_notify_t)(void *baton,
  * is not triggered by the BDB backend.  @a notify_func may be @c NULL
  * if this notification is not required.
  *
+ * If @a jobs is larger than 1 and APR has thread support, copy up to
+ * @a jobs shards concurrently.  @a notify_func will still be called from
+ * the calling thread and in revision order.  Currently, only the FSFS
+ * backend copies shards concurrently; the others ignore @a jobs.
+ *
  * The optional @a cancel_func callback will be invoked with
  * @a cancel_baton as usual to allow the user to preempt this potentially
  * lengthy operation.
  *
  * Use @a scratch_pool for temporary allocations.
  *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_hotcopy4(const char *src_path,
+                const char *dest_path,
+                svn_boolean_t clean,
+                svn_boolean_t incremental,
+                int jobs,
+                svn_fs_hotcopy_notify_t notify_func,
+                void *notify_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_fs_hotcopy4(), but with @a jobs set to 1.
+ *
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  * @since New in 1.9.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_hotcopy3(const char *src_path,
                 const char *dest_path,
@@ -2011,6 +2059,27 @@ svn_fs_node_has_props(svn_boolean_t *has_props,
                       const char *path,
                       apr_pool_t *scratch_pool);
 
+/** Like svn_fs_node_proplist() but for all @a paths (const char *) in
+ * @a root at once.  Set @a *proplists_p to a hash mapping each of those
+ * paths to its property list, as returned by svn_fs_node_proplist().
+ *
+ * Back-ends may read the property lists in whatever order is most
+ * efficient for their storage, e.g. in the order they are located on
+ * disk.  To get the properties of all entries of a directory, pass the
+ * paths of those entries.
+ *
+ * Allocate @a *proplists_p in @a result_pool.  Perform temporary
+ * allocations in @a scratch_pool.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_fs_node_proplists(apr_hash_t **proplists_p,
+                      svn_fs_root_t *root,
+                      const apr_array_header_t *paths,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool);
+
 
 /** Change a node's property's value, or add/delete a property.
  *
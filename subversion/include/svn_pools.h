@@ -61,11 +61,11 @@ svn_pool_create_ex_debug(apr_pool_t *parent_pool,
                          apr_allocator_t *allocator,
                          const char *file_line);
 
-#if APR_POOL_DEBUG
+/* Always pass the creation site, so pool statistics can be attributed
+ * to it even if APR's pool debugging is disabled. */
 #define svn_pool_create_ex(pool, allocator) \
 svn_pool_create_ex_debug(pool, allocator, APR_POOL__FILE_LINE__)
 
-#endif /* APR_POOL_DEBUG */
 #endif /* DOXYGEN_SHOULD_SKIP_THIS */
 
 
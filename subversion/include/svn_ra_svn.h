@@ -50,6 +50,7 @@ extern "C" {
 #define SVN_RA_SVN_CAP_EDIT_PIPELINE "edit-pipeline"
 #define SVN_RA_SVN_CAP_SVNDIFF1 "svndiff1"
 #define SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED "accepts-svndiff2"
+#define SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED "accepts-svndiff3"
 #define SVN_RA_SVN_CAP_ABSENT_ENTRIES "absent-entries"
 /* maps to SVN_RA_CAPABILITY_COMMIT_REVPROPS: */
 #define SVN_RA_SVN_CAP_COMMIT_REVPROPS "commit-revprops"
@@ -71,6 +72,14 @@ extern "C" {
 #define SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE "file-revs-reverse"
 /* maps to SVN_RA_CAPABILITY_LIST */
 #define SVN_RA_SVN_CAP_LIST "list"
+/* server understands the pipeline command */
+#define SVN_RA_SVN_CAP_PIPELINED_COMMANDS "pipelined-commands"
+/* server understands the get-file-blame command */
+#define SVN_RA_SVN_CAP_FILE_BLAME "file-blame"
+/* server understands search patterns in the log command */
+#define SVN_RA_SVN_CAP_LOG_SEARCH "log-search"
+/* all data after the client's greeting response gets LZ4 compressed */
+#define SVN_RA_SVN_CAP_LZ4_STREAM "lz4-stream"
 
 
 /** ra_svn passes @c svn_dirent_t fields over the wire as a list of
@@ -658,14 +658,38 @@ svn_repos_fs_type(svn_repos_t *repos,
  * notification is not triggered by the BDB backend. @a notify_func
  * may be @c NULL if this notification is not required.
  *
+ * If @a jobs is larger than 1 and APR has thread support, copy up to
+ * @a jobs shards of the filesystem concurrently, as far as the backend
+ * supports that.  @a notify_func will still be called from the calling
+ * thread and in revision order.
+ *
  * The optional @a cancel_func callback will be invoked with
  * @a cancel_baton as usual to allow the user to preempt this potentially
  * lengthy operation.
  * 
  * Use @a scratch_pool for temporary allocations.
  *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_hotcopy4(const char *src_path,
+                   const char *dst_path,
+                   svn_boolean_t clean_logs,
+                   svn_boolean_t incremental,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_hotcopy4(), but with @a jobs set to 1.
+ *
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  * @since New in 1.9.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_hotcopy3(const char *src_path,
                    const char *dst_path,
@@ -3199,12 +3223,40 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  * cancel_baton as argument to see if the caller wishes to cancel the
  * verification.
  *
+ * If @a jobs is larger than 1 and APR has thread support, verify up to
+ * @a jobs shards of the repository concurrently, each using a separate
+ * filesystem object.  The callbacks above will still be invoked from the
+ * calling thread and in the same order as for sequential verification.
+ * However, @a cancel_func may be called from any of the worker threads.
+ *
  * Use @a scratch_pool for temporary allocation.
  *
  * @see svn_repos_verify_callback_t
  *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_verify_fs4(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     int jobs,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_verify_fs4(), but with @a jobs set to 1.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_verify_fs3(svn_repos_t *repos,
                      svn_revnum_t start_rev,
@@ -3258,6 +3310,26 @@ svn_repos_verify_fs(svn_repos_t *repos,
                     void *cancel_baton,
                     apr_pool_t *pool);
 
+/**
+ * Callback type for use with svn_repos_dump_fs4(), in order to filter
+ * the nodes being dumped.  Set @a *include to @c TRUE if the node at the
+ * absolute repository path @a path in @a root shall be dumped and to
+ * @c FALSE otherwise.  Excluding a directory excludes its whole subtree.
+ *
+ * The root of the repository, i.e. @c "/", is always included and will
+ * not be passed to this function.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.10.
+ */
+typedef svn_error_t *
+(*svn_repos_dump_filter_func_t)(svn_boolean_t *include,
+                                svn_fs_root_t *root,
+                                const char *path,
+                                void *baton,
+                                apr_pool_t *scratch_pool);
+
 /**
  * Dump the contents of the filesystem within already-open @a repos into
  * writable @a dumpstream.  If @a dumpstream is
@@ -3285,6 +3357,11 @@ svn_repos_verify_fs(svn_repos_t *repos,
  * If @a include_changes is @c TRUE, output the revision contents, i.e.
  * tree and node changes.
  *
+ * If @a filter_func is not @c NULL, it is called with @a filter_baton
+ * for the changed paths and copy sources to decide which nodes to dump.
+ * Excluded subtrees will not be read from the filesystem.  Copies from
+ * excluded paths are dumped as plain additions of the copied contents.
+ *
  * If @a notify_func is not null, then call it with @a notify_baton and
  * with a notification structure in which the fields are set as follows.
  * (For a warning or error notification that does not apply to a specific
@@ -3327,15 +3404,53 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                    svn_boolean_t use_deltas,
                    svn_boolean_t include_revprops,
                    svn_boolean_t include_changes,
+                   svn_repos_dump_filter_func_t filter_func,
+                   void *filter_baton,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
                    apr_pool_t *pool);
 
+/**
+ * Like svn_repos_dump_fs4(), but instead of writing a single stream,
+ * split the dump into segments and write them as separate files into
+ * the directory @a dir_path, which will be created if necessary.
+ *
+ * Segments cover shard-aligned ranges of revisions.  Each segment is a
+ * valid dump stream of its own.  All segments but the first are always
+ * incremental, regardless of @a incremental.  Once all segments have been
+ * written, a manifest listing them in order is added to @a dir_path.
+ * svn_repos_load_fs_segments() uses it to load the segments.
+ *
+ * Up to @a jobs segments are dumped concurrently.  The notifications are
+ * still sent in revision order and from the calling thread.
+ * @a filter_func and @a cancel_func may be called from any thread.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_dump_fs_segments(svn_repos_t *repos,
+                           const char *dir_path,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           svn_boolean_t incremental,
+                           svn_boolean_t use_deltas,
+                           svn_boolean_t include_revprops,
+                           svn_boolean_t include_changes,
+                           svn_repos_dump_filter_func_t filter_func,
+                           void *filter_baton,
+                           int jobs,
+                           svn_repos_notify_func_t notify_func,
+                           void *notify_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *pool);
+
 /**
  * Similar to svn_repos_dump_fs4(), but with @a include_revprops and 
- * @a include_changes both set to @c TRUE.
+ * @a include_changes both set to @c TRUE and @a filter_func set to
+ * @c NULL.
  *
  * @since New in 1.7.
  * @deprecated Provided for backward compatibility with the 1.9 API.
@@ -3443,8 +3558,64 @@ svn_repos_dump_fs(svn_repos_t *repos,
  * @a cancel_baton as argument to see if the client wishes to cancel
  * the load.
  *
+ * If @a pipelined is set and thread support is available, read, parse
+ * and decode @a dumpstream in a separate thread, so that this work
+ * overlaps with committing the revisions.  All callbacks are still
+ * invoked from the calling thread.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_load_fs6(svn_repos_t *repos,
+                   svn_stream_t *dumpstream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   enum svn_repos_load_uuid uuid_action,
+                   const char *parent_dir,
+                   svn_boolean_t use_pre_commit_hook,
+                   svn_boolean_t use_post_commit_hook,
+                   svn_boolean_t validate_props,
+                   svn_boolean_t ignore_dates,
+                   svn_boolean_t pipelined,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool);
+
+/**
+ * Like svn_repos_load_fs6(), but read the segmented dump that
+ * svn_repos_dump_fs_segments() wrote to @a dir_path instead of a single
+ * dump stream.  The segments are loaded in the order given by the
+ * manifest as if they were a single stream.
+ *
+ * @since New in 1.10.
+ */
+svn_error_t *
+svn_repos_load_fs_segments(svn_repos_t *repos,
+                           const char *dir_path,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           enum svn_repos_load_uuid uuid_action,
+                           const char *parent_dir,
+                           svn_boolean_t use_pre_commit_hook,
+                           svn_boolean_t use_post_commit_hook,
+                           svn_boolean_t validate_props,
+                           svn_boolean_t ignore_dates,
+                           svn_boolean_t pipelined,
+                           svn_repos_notify_func_t notify_func,
+                           void *notify_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *pool);
+
+/** Similar to svn_repos_load_fs6(), but with @a pipelined always passed
+ * as FALSE.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.9 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_load_fs5(svn_repos_t *repos,
                    svn_stream_t *dumpstream,
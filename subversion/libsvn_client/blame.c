@@ -38,11 +38,11 @@
 #include "svn_sorts.h"
 
 #include "private/svn_wc_private.h"
+#include "private/svn_diff_private.h"
+#include "private/svn_ra_private.h"
 
 #include "svn_private_config.h"
 
-#include <assert.h>
-
 /* The metadata associated with a particular revision. */
 struct rev
 {
@@ -52,28 +52,6 @@ struct rev
   const char *path;      /* the absolute repository path */
 };
 
-/* One chunk of blame */
-struct blame
-{
-  const struct rev *rev;    /* the responsible revision */
-  apr_off_t start;          /* the starting diff-token (line) */
-  struct blame *next;       /* the next chunk */
-};
-
-/* A chain of blame chunks */
-struct blame_chain
-{
-  struct blame *blame;      /* linked list of blame chunks */
-  struct blame *avail;      /* linked list of free blame chunks */
-  struct apr_pool_t *pool;  /* Allocate members from this pool. */
-};
-
-/* The baton use for the diff output routine. */
-struct diff_baton {
-  struct blame_chain *chain;
-  const struct rev *rev;
-};
-
 /* The baton used for a file revision. Lives the entire operation */
 struct file_rev_baton {
   svn_revnum_t start_rev, end_rev;
@@ -84,7 +62,7 @@ struct file_rev_baton {
   /* name of file containing the previous revision of the file */
   const char *last_filename;
   struct rev *last_rev;   /* the rev of the last modification */
-  struct blame_chain *chain;      /* the original blame chain. */
+  svn_diff__blame_chain_t *chain;  /* the original blame chain. */
   const char *repos_root_url;    /* To construct a url */
   apr_pool_t *mainpool;  /* lives during the whole sequence of calls */
   apr_pool_t *lastpool;  /* pool used during previous call */
@@ -92,7 +70,7 @@ struct file_rev_baton {
 
   /* These are used for tracking merged revisions. */
   svn_boolean_t include_merged_revisions;
-  struct blame_chain *merged_chain;  /* the merged blame chain. */
+  svn_diff__blame_chain_t *merged_chain;  /* the merged blame chain. */
   /* name of file containing the previous merged revision of the file */
   const char *last_original_filename;
   /* pools for files which may need to persist for more than one rev. */
@@ -122,202 +100,14 @@ struct delta_baton {
 
 
 
-
-/* Return a blame chunk associated with REV for a change starting
-   at token START, and allocated in CHAIN->mainpool. */
-static struct blame *
-blame_create(struct blame_chain *chain,
-             const struct rev *rev,
-             apr_off_t start)
-{
-  struct blame *blame;
-  if (chain->avail)
-    {
-      blame = chain->avail;
-      chain->avail = blame->next;
-    }
-  else
-    blame = apr_palloc(chain->pool, sizeof(*blame));
-  blame->rev = rev;
-  blame->start = start;
-  blame->next = NULL;
-  return blame;
-}
-
-/* Destroy a blame chunk. */
-static void
-blame_destroy(struct blame_chain *chain,
-              struct blame *blame)
-{
-  blame->next = chain->avail;
-  chain->avail = blame;
-}
-
-/* Return the blame chunk that contains token OFF, starting the search at
-   BLAME. */
-static struct blame *
-blame_find(struct blame *blame, apr_off_t off)
-{
-  struct blame *prev = NULL;
-  while (blame)
-    {
-      if (blame->start > off) break;
-      prev = blame;
-      blame = blame->next;
-    }
-  return prev;
-}
-
-/* Shift the start-point of BLAME and all subsequence blame-chunks
-   by ADJUST tokens */
-static void
-blame_adjust(struct blame *blame, apr_off_t adjust)
-{
-  while (blame)
-    {
-      blame->start += adjust;
-      blame = blame->next;
-    }
-}
-
-/* Delete the blame associated with the region from token START to
-   START + LENGTH */
-static svn_error_t *
-blame_delete_range(struct blame_chain *chain,
-                   apr_off_t start,
-                   apr_off_t length)
-{
-  struct blame *first = blame_find(chain->blame, start);
-  struct blame *last = blame_find(chain->blame, start + length);
-  struct blame *tail = last->next;
-
-  if (first != last)
-    {
-      struct blame *walk = first->next;
-      while (walk != last)
-        {
-          struct blame *next = walk->next;
-          blame_destroy(chain, walk);
-          walk = next;
-        }
-      first->next = last;
-      last->start = start;
-      if (first->start == start)
-        {
-          *first = *last;
-          blame_destroy(chain, last);
-          last = first;
-        }
-    }
-
-  if (tail && tail->start == last->start + length)
-    {
-      *last = *tail;
-      blame_destroy(chain, tail);
-      tail = last->next;
-    }
-
-  blame_adjust(tail, -length);
-
-  return SVN_NO_ERROR;
-}
-
-/* Insert a chunk of blame associated with REV starting
-   at token START and continuing for LENGTH tokens */
-static svn_error_t *
-blame_insert_range(struct blame_chain *chain,
-                   const struct rev *rev,
-                   apr_off_t start,
-                   apr_off_t length)
-{
-  struct blame *head = chain->blame;
-  struct blame *point = blame_find(head, start);
-  struct blame *insert;
-
-  if (point->start == start)
-    {
-      insert = blame_create(chain, point->rev, point->start + length);
-      point->rev = rev;
-      insert->next = point->next;
-      point->next = insert;
-    }
-  else
-    {
-      struct blame *middle;
-      middle = blame_create(chain, rev, start);
-      insert = blame_create(chain, point->rev, start + length);
-      middle->next = insert;
-      insert->next = point->next;
-      point->next = middle;
-    }
-  blame_adjust(insert->next, length);
-
-  return SVN_NO_ERROR;
-}
-
-/* Callback for diff between subsequent revisions */
-static svn_error_t *
-output_diff_modified(void *baton,
-                     apr_off_t original_start,
-                     apr_off_t original_length,
-                     apr_off_t modified_start,
-                     apr_off_t modified_length,
-                     apr_off_t latest_start,
-                     apr_off_t latest_length)
-{
-  struct diff_baton *db = baton;
-
-  if (original_length)
-    SVN_ERR(blame_delete_range(db->chain, modified_start, original_length));
-
-  if (modified_length)
-    SVN_ERR(blame_insert_range(db->chain, db->rev, modified_start,
-                               modified_length));
-
-  return SVN_NO_ERROR;
-}
-
-static const svn_diff_output_fns_t output_fns = {
-        NULL,
-        output_diff_modified
+/* The baton used to collect the blame computed by the server. */
+struct server_blame_baton {
+  svn_diff__blame_chain_t *chain;
+  svn_diff__blame_t *last;  /* the last chunk appended to CHAIN */
+  apr_hash_t *revs;         /* svn_revnum_t -> struct rev * */
+  apr_pool_t *pool;
 };
 
-/* Add the blame for the diffs between LAST_FILE and CUR_FILE to CHAIN,
-   for revision REV.  LAST_FILE may be NULL in which
-   case blame is added for every line of CUR_FILE. */
-static svn_error_t *
-add_file_blame(const char *last_file,
-               const char *cur_file,
-               struct blame_chain *chain,
-               struct rev *rev,
-               const svn_diff_file_options_t *diff_options,
-               svn_cancel_func_t cancel_func,
-               void *cancel_baton,
-               apr_pool_t *pool)
-{
-  if (!last_file)
-    {
-      SVN_ERR_ASSERT(chain->blame == NULL);
-      chain->blame = blame_create(chain, rev, 0);
-    }
-  else
-    {
-      svn_diff_t *diff;
-      struct diff_baton diff_baton;
-
-      diff_baton.chain = chain;
-      diff_baton.rev = rev;
-
-      /* We have a previous file.  Get the diff and adjust blame info. */
-      SVN_ERR(svn_diff_file_diff_2(&diff, last_file, cur_file,
-                                   diff_options, pool));
-      SVN_ERR(svn_diff_output2(diff, &diff_baton, &output_fns,
-                               cancel_func, cancel_baton));
-    }
-
-  return SVN_NO_ERROR;
-}
-
 /* Record the blame information for the revision in BATON->file_rev_baton.
  */
 static svn_error_t *
@@ -325,7 +115,7 @@ update_blame(void *baton)
 {
   struct delta_baton *dbaton = baton;
   struct file_rev_baton *frb = dbaton->file_rev_baton;
-  struct blame_chain *chain;
+  svn_diff__blame_chain_t *chain;
 
   /* Close the source file used for the delta.
      It is important to do this early, since otherwise, they will be deleted
@@ -342,11 +132,12 @@ update_blame(void *baton)
     chain = frb->chain;
 
   /* Process this file. */
-  SVN_ERR(add_file_blame(frb->last_filename,
-                         dbaton->filename, chain, dbaton->rev,
-                         frb->diff_options,
-                         frb->ctx->cancel_func, frb->ctx->cancel_baton,
-                         frb->currpool));
+  SVN_ERR(svn_diff__blame_add_file(chain, frb->last_filename,
+                                   dbaton->filename, dbaton->rev,
+                                   frb->diff_options,
+                                   frb->ctx->cancel_func,
+                                   frb->ctx->cancel_baton,
+                                   frb->currpool));
 
   /* If we are including merged revisions, and the current revision is not a
      merged one, we need to add its blame info to the chain for the original
@@ -355,11 +146,13 @@ update_blame(void *baton)
     {
       apr_pool_t *tmppool;
 
-      SVN_ERR(add_file_blame(frb->last_original_filename,
-                             dbaton->filename, frb->chain, dbaton->rev,
-                             frb->diff_options,
-                             frb->ctx->cancel_func, frb->ctx->cancel_baton,
-                             frb->currpool));
+      SVN_ERR(svn_diff__blame_add_file(frb->chain,
+                                       frb->last_original_filename,
+                                       dbaton->filename, dbaton->rev,
+                                       frb->diff_options,
+                                       frb->ctx->cancel_func,
+                                       frb->ctx->cancel_baton,
+                                       frb->currpool));
 
       /* This filename could be around for a while, potentially, so
          use the longer lifetime pool, and switch it with the previous one*/
@@ -591,68 +384,75 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
   return SVN_NO_ERROR;
 }
 
-/* Ensure that CHAIN_ORIG and CHAIN_MERGED have the same number of chunks,
-   and that for every chunk C, CHAIN_ORIG[C] and CHAIN_MERGED[C] have the
-   same starting value.  Both CHAIN_ORIG and CHAIN_MERGED should not be
-   NULL.  */
-static void
-normalize_blames(struct blame_chain *chain,
-                 struct blame_chain *chain_merged,
-                 apr_pool_t *pool)
+/* Append one chunk of blame computed by the server to BATON's chain.
+
+   Implements svn_ra__blame_receiver_t. */
+static svn_error_t *
+server_blame_receiver(void *baton,
+                      apr_int64_t start_line,
+                      svn_revnum_t revision,
+                      apr_hash_t *rev_props,
+                      apr_pool_t *scratch_pool)
 {
-  struct blame *walk, *walk_merged;
+  struct server_blame_baton *sbb = baton;
+  svn_diff__blame_t *blame;
+  struct rev *rev;
 
-  /* Walk over the CHAIN's blame chunks and CHAIN_MERGED's blame chunks,
-     creating new chunks as needed. */
-  for (walk = chain->blame, walk_merged = chain_merged->blame;
-       walk->next && walk_merged->next;
-       walk = walk->next, walk_merged = walk_merged->next)
+  /* Share one rev struct between all chunks of the same revision. */
+  rev = apr_hash_get(sbb->revs, &revision, sizeof(revision));
+  if (!rev)
     {
-      /* The current chunks should always be starting at the same offset. */
-      assert(walk->start == walk_merged->start);
+      rev = apr_pcalloc(sbb->pool, sizeof(*rev));
+      rev->revision = revision;
+      if (SVN_IS_VALID_REVNUM(revision) && rev_props)
+        rev->rev_props = svn_prop_hash_dup(rev_props, sbb->pool);
+      apr_hash_set(sbb->revs, &rev->revision, sizeof(rev->revision), rev);
+    }
 
-      if (walk->next->start < walk_merged->next->start)
-        {
-          /* insert a new chunk in CHAIN_MERGED. */
-          struct blame *tmp = blame_create(chain_merged, walk_merged->rev,
-                                           walk->next->start);
-          tmp->next = walk_merged->next;
-          walk_merged->next = tmp;
-        }
+  blame = svn_diff__blame_create(sbb->chain, rev, start_line);
+  if (sbb->last)
+    sbb->last->next = blame;
+  else
+    sbb->chain->blame = blame;
+  sbb->last = blame;
 
-      if (walk->next->start > walk_merged->next->start)
-        {
-          /* insert a new chunk in CHAIN. */
-          struct blame *tmp = blame_create(chain, walk->rev,
-                                           walk_merged->next->start);
-          tmp->next = walk->next;
-          walk->next = tmp;
-        }
-    }
+  return SVN_NO_ERROR;
+}
 
-  /* If both NEXT pointers are null, the lists are equally long, otherwise
-     we need to extend one of them.  If CHAIN is longer, append new chunks
-     to CHAIN_MERGED until its length matches that of CHAIN. */
-  while (walk->next != NULL)
-    {
-      struct blame *tmp = blame_create(chain_merged, walk_merged->rev,
-                                       walk->next->start);
-      walk_merged->next = tmp;
+/* Let the server behind RA_SESSION compute the blame of its session URL
+   from START to END and store it in FRB->chain.  Fetch the contents of
+   the file in END and put the name of that file in FRB->last_filename.
 
-      walk_merged = walk_merged->next;
-      walk = walk->next;
-    }
+   Return #SVN_ERR_RA_NOT_IMPLEMENTED if the server can't do this. */
+static svn_error_t *
+get_server_blame(struct file_rev_baton *frb,
+                 svn_ra_session_t *ra_session,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 apr_pool_t *pool)
+{
+  struct server_blame_baton sbb;
+  svn_stream_t *stream;
+  const char *filename;
 
-  /* Same as above, only extend CHAIN to match CHAIN_MERGED. */
-  while (walk_merged->next != NULL)
-    {
-      struct blame *tmp = blame_create(chain, walk->rev,
-                                       walk_merged->next->start);
-      walk->next = tmp;
+  sbb.chain = frb->chain;
+  sbb.last = NULL;
+  sbb.revs = apr_hash_make(pool);
+  sbb.pool = pool;
 
-      walk = walk->next;
-      walk_merged = walk_merged->next;
-    }
+  SVN_ERR(svn_ra__get_file_blame(ra_session, "", start, end,
+                                 frb->diff_options,
+                                 server_blame_receiver, &sbb, pool));
+
+  SVN_ERR(svn_stream_open_unique(&stream, &filename, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 pool, pool));
+  SVN_ERR(svn_ra_get_file(ra_session, "", end, stream, NULL, NULL, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  frb->last_filename = filename;
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -671,7 +471,7 @@ svn_client_blame5(const char *target,
   struct file_rev_baton frb;
   svn_ra_session_t *ra_session;
   svn_revnum_t start_revnum, end_revnum;
-  struct blame *walk, *walk_merged = NULL;
+  svn_diff__blame_t *walk, *walk_merged = NULL;
   apr_pool_t *iterpool;
   svn_stream_t *last_stream;
   svn_stream_t *stream;
@@ -776,17 +576,9 @@ svn_client_blame5(const char *target,
   frb.last_filename = NULL;
   frb.last_rev = NULL;
   frb.last_original_filename = NULL;
-  frb.chain = apr_palloc(pool, sizeof(*frb.chain));
-  frb.chain->blame = NULL;
-  frb.chain->avail = NULL;
-  frb.chain->pool = pool;
+  frb.chain = svn_diff__blame_chain_create(pool);
   if (include_merged_revisions)
-    {
-      frb.merged_chain = apr_palloc(pool, sizeof(*frb.merged_chain));
-      frb.merged_chain->blame = NULL;
-      frb.merged_chain->avail = NULL;
-      frb.merged_chain->pool = pool;
-    }
+    frb.merged_chain = svn_diff__blame_chain_create(pool);
   frb.backwards = (frb.start_rev > frb.end_rev);
   frb.last_revnum = SVN_INVALID_REVNUM;
   frb.last_props = NULL;
@@ -806,16 +598,35 @@ svn_client_blame5(const char *target,
       frb.prevfilepool = svn_pool_create(pool);
     }
 
+  /* Let the server compute the blame if it can, which saves us
+     transferring every single revision of the file. */
+  if (!include_merged_revisions && !frb.backwards)
+    {
+      svn_error_t *err = get_server_blame(&frb, ra_session, start_revnum,
+                                          end_revnum, pool);
+
+      if (err && err->apr_err == SVN_ERR_RA_NOT_IMPLEMENTED)
+        {
+          svn_error_clear(err);
+
+          /* Drop any chunks that were received before the error. */
+          frb.chain = svn_diff__blame_chain_create(pool);
+        }
+      else
+        SVN_ERR(err);
+    }
+
   /* Collect all blame information.
      We need to ensure that we get one revision before the start_rev,
      if available so that we can know what was actually changed in the start
      revision. */
-  SVN_ERR(svn_ra_get_file_revs2(ra_session, "",
-                                frb.backwards ? start_revnum
-                                              : MAX(0, start_revnum-1),
-                                end_revnum,
-                                include_merged_revisions,
-                                file_rev_handler, &frb, pool));
+  if (!frb.last_filename)
+    SVN_ERR(svn_ra_get_file_revs2(ra_session, "",
+                                  frb.backwards ? start_revnum
+                                                : MAX(0, start_revnum-1),
+                                  end_revnum,
+                                  include_merged_revisions,
+                                  file_rev_handler, &frb, pool));
 
   if (end->kind == svn_opt_revision_working)
     {
@@ -869,9 +680,10 @@ svn_client_blame5(const char *target,
           SVN_ERR(svn_stream_copy3(wcfile, tempfile, ctx->cancel_func,
                                    ctx->cancel_baton, pool));
 
-          SVN_ERR(add_file_blame(frb.last_filename, temppath, frb.chain, NULL,
-                                 frb.diff_options,
-                                 ctx->cancel_func, ctx->cancel_baton, pool));
+          SVN_ERR(svn_diff__blame_add_file(frb.chain, frb.last_filename,
+                                           temppath, NULL, frb.diff_options,
+                                           ctx->cancel_func,
+                                           ctx->cancel_baton, pool));
 
           frb.last_filename = temppath;
         }
@@ -901,15 +713,16 @@ svn_client_blame5(const char *target,
          the most recently changed revision.  ### Is this really what we want
          to do here?  Do the sematics of copy change? */
       if (!frb.chain->blame)
-        frb.chain->blame = blame_create(frb.chain, frb.last_rev, 0);
+        frb.chain->blame = svn_diff__blame_create(frb.chain, frb.last_rev, 0);
 
-      normalize_blames(frb.chain, frb.merged_chain, pool);
+      svn_diff__blame_normalize(frb.chain, frb.merged_chain);
       walk_merged = frb.merged_chain->blame;
     }
 
   /* Process each blame item. */
   for (walk = frb.chain->blame; walk; walk = walk->next)
     {
+      const struct rev *rev = walk->rev;
       apr_off_t line_no;
       svn_revnum_t merged_rev;
       const char *merged_path;
@@ -917,9 +730,11 @@ svn_client_blame5(const char *target,
 
       if (walk_merged)
         {
-          merged_rev = walk_merged->rev->revision;
-          merged_rev_props = walk_merged->rev->rev_props;
-          merged_path = walk_merged->rev->path;
+          const struct rev *merged = walk_merged->rev;
+
+          merged_rev = merged->revision;
+          merged_rev_props = merged->rev_props;
+          merged_path = merged->path;
         }
       else
         {
@@ -941,10 +756,10 @@ svn_client_blame5(const char *target,
             SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
           if (!eof || sb->len)
             {
-              if (walk->rev)
+              if (rev)
                 SVN_ERR(receiver(receiver_baton, start_revnum, end_revnum,
-                                 line_no, walk->rev->revision,
-                                 walk->rev->rev_props, merged_rev,
+                                 line_no, rev->revision,
+                                 rev->rev_props, merged_rev,
                                  merged_rev_props, merged_path,
                                  sb->data, FALSE, iterpool));
               else
@@ -63,6 +63,25 @@ typedef struct svn_client__private_ctx_t
   /* Total number of bytes transferred over network across all RA sessions. */
   apr_off_t total_progress;
 
+  /* The pool that this context has been allocated in. */
+  apr_pool_t *pool;
+
+  /* RA sessions kept for reuse, see svn_client_set_ra_session_cache().
+     Opaque element type, managed by ra.c.  NULL if no session has been
+     cached yet. */
+  apr_array_header_t *ra_sessions;
+
+  /* Maximum number of entries in RA_SESSIONS.  0 disables the cache. */
+  int max_ra_sessions;
+
+  /* Idle sessions older than this get closed upon the next lookup. */
+  apr_interval_time_t ra_session_timeout;
+
+  /* Repository logs recently scanned by the tree conflict resolver.
+     Opaque element type, managed by conflicts.c.  NULL if no log has
+     been scanned yet. */
+  apr_array_header_t *log_scans;
+
   /* The public context. */
   svn_client_ctx_t public_ctx;
 } svn_client__private_ctx_t;
@@ -91,6 +110,46 @@ svn_client__get_copy_source(const char **original_repos_relpath,
                             apr_pool_t *result_pool,
                             apr_pool_t *scratch_pool);
 
+/* A persistent cache of log entries in the user's configuration area,
+   see log_cache.c. */
+typedef struct svn_client__log_cache_t svn_client__log_cache_t;
+
+/* Set *CACHE to the log cache of the repository RA_SESSION is connected
+   to, or to NULL if the log-cache option in CTX's configuration is not
+   enabled.  Allocate *CACHE in RESULT_POOL. */
+svn_error_t *
+svn_client__log_cache_open(svn_client__log_cache_t **cache,
+                           svn_ra_session_t *ra_session,
+                           svn_client_ctx_t *ctx,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/* Like svn_ra_get_log2(), but take the revision properties and changed
+   paths of the reported revisions from CACHE, fetching those that it does
+   not have and adding them to CACHE. */
+svn_error_t *
+svn_client__log_cache_get_log(svn_client__log_cache_t *cache,
+                              svn_ra_session_t *ra_session,
+                              const apr_array_header_t *paths,
+                              svn_revnum_t start,
+                              svn_revnum_t end,
+                              int limit,
+                              svn_boolean_t discover_changed_paths,
+                              svn_boolean_t strict_node_history,
+                              svn_boolean_t include_merged_revisions,
+                              const apr_array_header_t *revprops,
+                              svn_log_entry_receiver_t receiver,
+                              void *receiver_baton,
+                              apr_pool_t *scratch_pool);
+
+/* Remove REVISION of the repository RA_SESSION is connected to from the
+   log cache of CTX, after its revision properties have been changed. */
+svn_error_t *
+svn_client__log_cache_invalidate(svn_ra_session_t *ra_session,
+                                 svn_revnum_t revision,
+                                 svn_client_ctx_t *ctx,
+                                 apr_pool_t *scratch_pool);
+
 /* Set *START_URL and *START_REVISION (and maybe *END_URL
    and *END_REVISION) to the revisions and repository URLs of one
    (or two) points of interest along a particular versioned resource's
@@ -663,6 +722,11 @@ svn_client__get_inheritable_props(apr_hash_t **wcroot_iprops,
    This must be FALSE if the edit producer is not sending text deltas,
    otherwise the file content checksum comparisons will fail.
 
+   The editor checks for cancellation with the callback of CTX.  It
+   fetches files from additional sessions to the URL of RA_SESSION,
+   opened with the configuration and credentials of CTX, on other
+   threads.  It invokes the callbacks of CTX only on the calling thread.
+
    EDITOR/EDIT_BATON return the newly created editor and baton.
 
    @since New in 1.8.
@@ -675,8 +739,7 @@ svn_client__get_diff_editor2(const svn_delta_editor_t **editor,
                              svn_revnum_t revision,
                              svn_boolean_t text_deltas,
                              const svn_diff_tree_processor_t *processor,
-                             svn_cancel_func_t cancel_func,
-                             void *cancel_baton,
+                             svn_client_ctx_t *ctx,
                              apr_pool_t *result_pool);
 
 /* ---------------------------------------------------------------- */
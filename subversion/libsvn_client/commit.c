@@ -624,6 +624,8 @@ svn_client_commit6(const apr_array_header_t *targets,
     cukb.repos_root_url = NULL;
     cukb.ctx = ctx;
 
+    /* The crawl reads most nodes several times, and we hold the locks. */
+    svn_wc__read_cache_begin(ctx->wc_ctx);
     cmt_err = svn_error_trace(
                    svn_client__harvest_committables(&committables,
                                                     &lock_tokens,
@@ -638,6 +640,7 @@ svn_client_commit6(const apr_array_header_t *targets,
                                                     ctx,
                                                     pool,
                                                     iterpool));
+    svn_wc__read_cache_end(ctx->wc_ctx);
 
     svn_pool_clear(iterpool);
   }
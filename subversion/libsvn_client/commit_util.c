@@ -1834,6 +1834,41 @@ fixup_error:
                                             err, ctx, pool));
 }
 
+/* Baton for notify_text_delta(). */
+struct notify_text_delta_baton_t
+{
+  svn_client_ctx_t *ctx;
+  const char *notify_path_prefix;
+};
+
+/* Check for cancellation and notify that the text delta of TARGET is
+   about to be transmitted.  Implements the SENDING_FUNC of
+   svn_wc__transmit_text_deltas_batch(). */
+static svn_error_t *
+notify_text_delta(void *baton,
+                  const svn_wc__text_delta_target_t *target,
+                  apr_pool_t *scratch_pool)
+{
+  struct notify_text_delta_baton_t *b = baton;
+  svn_client_ctx_t *ctx = b->ctx;
+
+  if (ctx->cancel_func)
+    SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+
+  if (ctx->notify_func2)
+    {
+      svn_wc_notify_t *notify;
+      notify = svn_wc_create_notify(target->local_abspath,
+                                    svn_wc_notify_commit_postfix_txdelta,
+                                    scratch_pool);
+      notify->kind = svn_node_file;
+      notify->path_prefix = b->notify_path_prefix;
+      ctx->notify_func2(ctx->notify_baton2, notify, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client__do_commit(const char *base_url,
                       const apr_array_header_t *commit_items,
@@ -1851,6 +1886,10 @@ svn_client__do_commit(const char *base_url,
   apr_hash_index_t *hi;
   int i;
   struct item_commit_baton cb_baton;
+  struct notify_text_delta_baton_t send_baton;
+  apr_array_header_t *targets;
+  const svn_wc__text_delta_target_t *failed_target;
+  svn_error_t *err;
   apr_array_header_t *paths =
     apr_array_make(scratch_pool, commit_items->nelts, sizeof(const char *));
 
@@ -1884,57 +1923,62 @@ svn_client__do_commit(const char *base_url,
                                  do_item_commit, &cb_baton, scratch_pool));
 
   /* Transmit outstanding text deltas. */
+  targets = apr_array_make(scratch_pool, apr_hash_count(file_mods),
+                           sizeof(svn_wc__text_delta_target_t *));
   for (hi = apr_hash_first(scratch_pool, file_mods);
        hi;
        hi = apr_hash_next(hi))
     {
       struct file_mod_t *mod = apr_hash_this_val(hi);
       const svn_client_commit_item3_t *item = mod->item;
-      const svn_checksum_t *new_text_base_md5_checksum;
-      const svn_checksum_t *new_text_base_sha1_checksum;
-      svn_boolean_t fulltext = FALSE;
-      svn_error_t *err;
-
-      svn_pool_clear(iterpool);
-
-      /* Transmit the entry. */
-      if (ctx->cancel_func)
-        SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+      svn_wc__text_delta_target_t *target = apr_pcalloc(scratch_pool,
+                                                        sizeof(*target));
 
-      if (ctx->notify_func2)
-        {
-          svn_wc_notify_t *notify;
-          notify = svn_wc_create_notify(item->path,
-                                        svn_wc_notify_commit_postfix_txdelta,
-                                        iterpool);
-          notify->kind = svn_node_file;
-          notify->path_prefix = notify_path_prefix;
-          ctx->notify_func2(ctx->notify_baton2, notify, iterpool);
-        }
+      target->local_abspath = item->path;
+      target->file_baton = mod->file_baton;
+      target->baton = mod;
 
       /* If the node has no history, transmit full text */
       if ((item->state_flags & SVN_CLIENT_COMMIT_ITEM_ADD)
           && ! (item->state_flags & SVN_CLIENT_COMMIT_ITEM_IS_COPY))
-        fulltext = TRUE;
+        target->fulltext = TRUE;
 
-      err = svn_wc_transmit_text_deltas3(&new_text_base_md5_checksum,
-                                         &new_text_base_sha1_checksum,
-                                         ctx->wc_ctx, item->path,
-                                         fulltext, editor, mod->file_baton,
-                                         result_pool, iterpool);
+      APR_ARRAY_PUSH(targets, svn_wc__text_delta_target_t *) = target;
+    }
 
-      if (err)
+  send_baton.ctx = ctx;
+  send_baton.notify_path_prefix = notify_path_prefix;
+  err = svn_wc__transmit_text_deltas_batch(&failed_target, targets,
+                                           ctx->wc_ctx, editor,
+                                           notify_text_delta, &send_baton,
+                                           result_pool, iterpool);
+  if (err)
+    {
+      svn_pool_destroy(iterpool); /* Close tempfiles */
+
+      if (failed_target)
         {
-          svn_pool_destroy(iterpool); /* Close tempfiles */
-          return svn_error_trace(fixup_commit_error(item->path,
+          const struct file_mod_t *mod = failed_target->baton;
+
+          return svn_error_trace(fixup_commit_error(mod->item->path,
                                                     base_url,
-                                                    item->session_relpath,
+                                                    mod->item->session_relpath,
                                                     svn_node_file,
                                                     err, ctx, scratch_pool));
         }
 
+      return svn_error_trace(err);
+    }
+
+  for (i = 0; i < targets->nelts; i++)
+    {
+      const svn_wc__text_delta_target_t *target
+        = APR_ARRAY_IDX(targets, i, const svn_wc__text_delta_target_t *);
+      struct file_mod_t *mod = target->baton;
+
       if (sha1_checksums)
-        svn_hash_sets(*sha1_checksums, item->path, new_text_base_sha1_checksum);
+        svn_hash_sets(*sha1_checksums, mod->item->path,
+                      target->new_text_base_sha1_checksum);
 
       svn_pool_destroy(mod->file_pool);
     }
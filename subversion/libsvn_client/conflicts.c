@@ -514,6 +514,156 @@ find_moves_in_revision(svn_ra_session_t *ra_session,
   return SVN_NO_ERROR;
 }
 
+/* Maximum number of log scans kept in the client context. */
+#define MAX_LOG_SCANS 8
+
+/* The log of a repository node, as recorded by scan_log(). */
+typedef struct log_scan_t
+{
+  /* The node's URL and the revision to trace its history back from. */
+  const char *url;
+  svn_revnum_t peg_rev;
+
+  /* The oldest revision covered by this scan. */
+  svn_revnum_t oldest_rev;
+
+  /* The svn_log_entry_t * elements, youngest first. */
+  apr_array_header_t *entries;
+
+  /* Pool holding this structure and all of its data. */
+  apr_pool_t *pool;
+} log_scan_t;
+
+/* Implements svn_log_entry_receiver_t.  Append a copy of LOG_ENTRY to the
+ * log_scan_t * BATON. */
+static svn_error_t *
+record_log_entry(void *baton,
+                 svn_log_entry_t *log_entry,
+                 apr_pool_t *scratch_pool)
+{
+  log_scan_t *scan = baton;
+
+  APR_ARRAY_PUSH(scan->entries, svn_log_entry_t *)
+    = svn_log_entry_dup(log_entry, scan->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Invoke RECEIVER with RECEIVER_BATON for each revision between START_REV
+ * and END_REV in the log of the node at URL, in that order.  Behave like
+ * svn_ra_get_log2() with changed paths, the author revprop, no limit and
+ * no strict node history, including returning the first error raised by
+ * RECEIVER.
+ *
+ * Resolving the tree conflicts of a large merge asks for the log of the
+ * same directory over the same revisions many times over.  Since history
+ * does not change, the log is only fetched through RA_SESSION, which must
+ * point at URL, if none of the scans kept in CTX covers the requested
+ * range.
+ */
+static svn_error_t *
+scan_log(svn_ra_session_t *ra_session,
+         const char *url,
+         svn_revnum_t start_rev,
+         svn_revnum_t end_rev,
+         svn_log_entry_receiver_t receiver,
+         void *receiver_baton,
+         svn_client_ctx_t *ctx,
+         apr_pool_t *scratch_pool)
+{
+  svn_client__private_ctx_t *private_ctx = svn_client__get_private_ctx(ctx);
+  svn_revnum_t peg_rev = MAX(start_rev, end_rev);
+  svn_revnum_t oldest_rev = MIN(start_rev, end_rev);
+  log_scan_t *scan = NULL;
+  apr_pool_t *iterpool;
+  int i, count;
+
+  if (private_ctx->log_scans == NULL)
+    private_ctx->log_scans = apr_array_make(private_ctx->pool, MAX_LOG_SCANS,
+                                            sizeof(log_scan_t *));
+
+  /* The log of a shorter range is the younger part of a longer one. */
+  for (i = 0; i < private_ctx->log_scans->nelts; i++)
+    {
+      log_scan_t *candidate = APR_ARRAY_IDX(private_ctx->log_scans, i,
+                                            log_scan_t *);
+      if (candidate->peg_rev == peg_rev
+          && candidate->oldest_rev <= oldest_rev
+          && strcmp(candidate->url, url) == 0)
+        {
+          scan = candidate;
+          break;
+        }
+    }
+
+  if (scan == NULL)
+    {
+      apr_array_header_t *paths;
+      apr_array_header_t *revprops;
+      apr_pool_t *scan_pool = svn_pool_create(private_ctx->pool);
+      svn_error_t *err;
+
+      scan = apr_pcalloc(scan_pool, sizeof(*scan));
+      scan->url = apr_pstrdup(scan_pool, url);
+      scan->peg_rev = peg_rev;
+      scan->oldest_rev = oldest_rev;
+      scan->entries = apr_array_make(scan_pool, 0, sizeof(svn_log_entry_t *));
+      scan->pool = scan_pool;
+
+      paths = apr_array_make(scratch_pool, 1, sizeof(const char *));
+      APR_ARRAY_PUSH(paths, const char *) = "";
+
+      revprops = apr_array_make(scratch_pool, 1, sizeof(const char *));
+      APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_AUTHOR;
+
+      err = svn_ra_get_log2(ra_session, paths, peg_rev, oldest_rev,
+                            0, /* no limit */
+                            TRUE, /* need the changed paths list */
+                            FALSE, /* need to traverse copies */
+                            FALSE, /* no need for merged revisions */
+                            revprops,
+                            record_log_entry, scan,
+                            scratch_pool);
+      if (err)
+        {
+          svn_pool_destroy(scan_pool);
+          return svn_error_trace(err);
+        }
+
+      /* Make room by dropping the oldest scan. */
+      if (private_ctx->log_scans->nelts == MAX_LOG_SCANS)
+        {
+          log_scan_t *oldest = APR_ARRAY_IDX(private_ctx->log_scans, 0,
+                                             log_scan_t *);
+          svn_pool_destroy(oldest->pool);
+          svn_sort__array_delete(private_ctx->log_scans, 0, 1);
+        }
+
+      APR_ARRAY_PUSH(private_ctx->log_scans, log_scan_t *) = scan;
+    }
+
+  /* Replay the part of the log within the requested range. */
+  count = scan->entries->nelts;
+  while (count > 0
+         && APR_ARRAY_IDX(scan->entries, count - 1,
+                          svn_log_entry_t *)->revision < oldest_rev)
+    count--;
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < count; i++)
+    {
+      int idx = start_rev >= end_rev ? i : count - 1 - i;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(receiver(receiver_baton,
+                       APR_ARRAY_IDX(scan->entries, idx, svn_log_entry_t *),
+                       iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 struct find_deleted_rev_baton
 {
   /* Variables below are arguments provided by the caller of
@@ -1442,15 +1592,17 @@ find_moves(void *baton, svn_log_entry_t *log_entry, apr_pool_t *scratch_pool)
           struct copy_info *copy;
           apr_array_header_t *copies_with_same_source_path;
 
-          if (log_item->copyfrom_path[0] == '/')
-            log_item->copyfrom_path++;
-
           copy = apr_palloc(scratch_pool, sizeof(*copy));
           copy->copyto_path = changed_path;
           copy->copyfrom_path = log_item->copyfrom_path;
           copy->copyfrom_rev = log_item->copyfrom_rev;
+
+          /* LOG_ITEM may be shared with other log scans, see scan_log(). */
+          if (copy->copyfrom_path[0] == '/')
+            copy->copyfrom_path++;
+
           copies_with_same_source_path = apr_hash_get(copies,
-                                                      log_item->copyfrom_path,
+                                                      copy->copyfrom_path,
                                                       APR_HASH_KEY_STRING);
           if (copies_with_same_source_path == NULL)
             {
@@ -1513,8 +1665,6 @@ find_moves_in_revision_range(struct apr_hash_t **moves_table,
   svn_ra_session_t *ra_session;
   const char *url;
   const char *corrected_url;
-  apr_array_header_t *paths;
-  apr_array_header_t *revprops;
   const char *repos_root_url;
   const char *repos_uuid;
   struct find_moves_baton b = { 0 };
@@ -1531,12 +1681,6 @@ find_moves_in_revision_range(struct apr_hash_t **moves_table,
                                                ctx, scratch_pool,
                                                scratch_pool));
 
-  paths = apr_array_make(scratch_pool, 1, sizeof(const char *));
-  APR_ARRAY_PUSH(paths, const char *) = "";
-
-  revprops = apr_array_make(scratch_pool, 1, sizeof(const char *));
-  APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_AUTHOR;
-
   b.repos_root_url = repos_root_url;
   b.repos_uuid = repos_uuid;
   b.ctx = ctx;
@@ -1547,14 +1691,8 @@ find_moves_in_revision_range(struct apr_hash_t **moves_table,
   SVN_ERR(svn_ra__dup_session(&b.extra_ra_session, ra_session, NULL,
                               scratch_pool, scratch_pool));
 
-  SVN_ERR(svn_ra_get_log2(ra_session, paths, start_rev, end_rev,
-                          0, /* no limit */
-                          TRUE, /* need the changed paths list */
-                          FALSE, /* need to traverse copies */
-                          FALSE, /* no need for merged revisions */
-                          revprops,
-                          find_moves, &b,
-                          scratch_pool));
+  SVN_ERR(scan_log(ra_session, url, start_rev, end_rev,
+                   find_moves, &b, ctx, scratch_pool));
 
   *moves_table = b.moves_table;
 
@@ -1851,8 +1989,6 @@ find_revision_for_suspected_deletion(svn_revnum_t *deleted_rev,
   svn_ra_session_t *ra_session;
   const char *url;
   const char *corrected_url;
-  apr_array_header_t *paths;
-  apr_array_header_t *revprops;
   const char *repos_root_url;
   const char *repos_uuid;
   struct find_deleted_rev_baton b = { 0 };
@@ -1876,12 +2012,6 @@ find_revision_for_suspected_deletion(svn_revnum_t *deleted_rev,
                                                ctx, scratch_pool,
                                                scratch_pool));
 
-  paths = apr_array_make(scratch_pool, 1, sizeof(const char *));
-  APR_ARRAY_PUSH(paths, const char *) = "";
-
-  revprops = apr_array_make(scratch_pool, 1, sizeof(const char *));
-  APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_AUTHOR;
-
   victim_abspath = svn_client_conflict_get_local_abspath(conflict);
   b.victim_abspath = victim_abspath;
   b.deleted_repos_relpath = svn_relpath_join(parent_repos_relpath,
@@ -1898,14 +2028,8 @@ find_revision_for_suspected_deletion(svn_revnum_t *deleted_rev,
   SVN_ERR(svn_ra__dup_session(&b.extra_ra_session, ra_session, NULL,
                               scratch_pool, scratch_pool));
 
-  err = svn_ra_get_log2(ra_session, paths, start_rev, end_rev,
-                        0, /* no limit */
-                        TRUE, /* need the changed paths list */
-                        FALSE, /* need to traverse copies */
-                        FALSE, /* no need for merged revisions */
-                        revprops,
-                        find_deleted_rev, &b,
-                        scratch_pool);
+  err = scan_log(ra_session, url, start_rev, end_rev,
+                 find_deleted_rev, &b, ctx, scratch_pool);
   if (err)
     {
       if (err->apr_err == SVN_ERR_CEASE_INVOCATION &&
@@ -5021,8 +5145,6 @@ conflict_tree_get_details_incoming_edit(svn_client_conflict_t *conflict,
   const char *url;
   const char *corrected_url;
   svn_ra_session_t *ra_session;
-  apr_array_header_t *paths;
-  apr_array_header_t *revprops;
   struct find_modified_rev_baton b = { 0 };
 
   SVN_ERR(svn_client_conflict_get_incoming_old_repos_location(
@@ -5070,12 +5192,6 @@ conflict_tree_get_details_incoming_edit(svn_client_conflict_t *conflict,
                                                scratch_pool,
                                                scratch_pool));
 
-  paths = apr_array_make(scratch_pool, 1, sizeof(const char *));
-  APR_ARRAY_PUSH(paths, const char *) = "";
-
-  revprops = apr_array_make(scratch_pool, 1, sizeof(const char *));
-  APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_AUTHOR;
-
   b.ctx = ctx;
   b.victim_abspath = svn_client_conflict_get_local_abspath(conflict);
   b.result_pool = conflict->pool;
@@ -5084,16 +5200,10 @@ conflict_tree_get_details_incoming_edit(svn_client_conflict_t *conflict,
                conflict->pool, 0,
                sizeof(struct conflict_tree_incoming_edit_details *));
 
-  SVN_ERR(svn_ra_get_log2(ra_session, paths,
-                          old_rev < new_rev ? old_rev : new_rev,
-                          old_rev < new_rev ? new_rev : old_rev,
-                          0, /* no limit */
-                          TRUE, /* need the changed paths list */
-                          FALSE, /* need to traverse copies */
-                          FALSE, /* no need for merged revisions */
-                          revprops,
-                          find_modified_rev, &b,
-                          scratch_pool));
+  SVN_ERR(scan_log(ra_session, url,
+                   old_rev < new_rev ? old_rev : new_rev,
+                   old_rev < new_rev ? new_rev : old_rev,
+                   find_modified_rev, &b, ctx, scratch_pool));
 
   conflict->tree_conflict_incoming_details = b.edits;
 
@@ -6824,8 +6934,7 @@ merge_newly_added_dir(const char *added_repos_relpath,
   SVN_ERR(svn_client__get_diff_editor2(
                 &diff_editor, &diff_edit_baton,
                 extra_ra_session, svn_depth_infinity, rev1, TRUE,
-                diff_processor, ctx->cancel_func, ctx->cancel_baton,
-                scratch_pool));
+                diff_processor, ctx, scratch_pool));
 
   /* We want to switch our txn into URL2 */
   SVN_ERR(svn_ra_do_diff3(ra_session, &reporter, &reporter_baton,
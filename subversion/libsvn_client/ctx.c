@@ -32,6 +32,7 @@
 #include "svn_hash.h"
 #include "svn_client.h"
 #include "svn_error.h"
+#include "svn_ra.h"
 
 #include "private/svn_wc_private.h"
 
@@ -79,6 +80,28 @@ call_conflict_func(svn_wc_conflict_result_t **result,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_wc__pristine_fetch_func_t, using the client context
+   BATON to open an RA session.  With svn_client_set_ra_session_cache(),
+   subsequent fetches reuse that session. */
+static svn_error_t *
+fetch_pristine(void *baton,
+               svn_stream_t *stream,
+               const char *repos_root_url,
+               const char *repos_relpath,
+               svn_revnum_t revision,
+               apr_pool_t *scratch_pool)
+{
+  svn_client_ctx_t *ctx = baton;
+  svn_ra_session_t *ra_session;
+
+  SVN_ERR(svn_client_open_ra_session2(&ra_session, repos_root_url, NULL,
+                                      ctx, scratch_pool, scratch_pool));
+
+  return svn_error_trace(svn_ra_get_file(ra_session, repos_relpath, revision,
+                                         stream, NULL, NULL,
+                                         scratch_pool));
+}
+
 /* The magic number in client_ctx_t.magic_id. */
 #define CLIENT_CTX_MAGIC APR_UINT64_C(0xDEADBEEF600DF00D)
 
@@ -106,6 +129,7 @@ svn_client_create_context2(svn_client_ctx_t **ctx,
 
   private_ctx->magic_null = 0;
   private_ctx->magic_id = CLIENT_CTX_MAGIC;
+  private_ctx->pool = pool;
 
   public_ctx->notify_func2 = call_notify_func;
   public_ctx->notify_baton2 = public_ctx;
@@ -122,6 +146,8 @@ svn_client_create_context2(svn_client_ctx_t **ctx,
 
   SVN_ERR(svn_wc_context_create(&public_ctx->wc_ctx, cfg_config,
                                 pool, pool));
+  svn_wc__context_set_pristine_fetch(public_ctx->wc_ctx, fetch_pristine,
+                                     public_ctx);
   *ctx = public_ctx;
 
   return SVN_NO_ERROR;
@@ -2014,7 +2014,7 @@ diff_repos_repos(const char **root_relpath,
                 rev1,
                 text_deltas,
                 diff_processor,
-                ctx->cancel_func, ctx->cancel_baton,
+                ctx,
                 scratch_pool));
 
   /* We want to switch our txn into URL2 */
@@ -29,6 +29,11 @@
 
 #include <apr_file_io.h>
 #include <apr_md5.h>
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#endif
 #include "svn_types.h"
 #include "svn_client.h"
 #include "svn_string.h"
@@ -511,6 +516,10 @@ struct edit_baton
   void *cancel_baton;
   svn_wc_notify_func2_t notify_func;
   void *notify_baton;
+
+  /* Files waiting to be installed by worker threads, or NULL if files
+     are installed by close_file() itself. */
+  struct finish_queue_t *finish_queue;
 };
 
 
@@ -785,6 +794,331 @@ change_dir_prop(void *dir_baton,
 }
 
 
+/* A file received by the export editor, to be translated and moved
+   to its final location by finish_file(). */
+typedef struct finish_job_t
+{
+  /* The final and the temporary location of the file. */
+  const char *path;
+  const char *tmppath;
+
+  /* Whether and how to translate the file; see
+     svn_subst_copy_and_translate4(). */
+  svn_boolean_t translate;
+  const char *eol;
+  svn_boolean_t repair;
+  apr_hash_t *keywords;
+  svn_boolean_t special;
+
+  svn_boolean_t executable;
+  apr_time_t date;
+
+  /* NULL for jobs run by a worker thread: client callbacks may only be
+     invoked from the thread that drives the editor. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* When run by a worker thread: the root pool holding everything of
+     this job, and its result.  DONE is protected by the mutex of the
+     finish_queue_t. */
+  apr_pool_t *pool;
+  svn_boolean_t done;
+  svn_error_t *err;
+} finish_job_t;
+
+/* Translate the temporary file of JOB and move it into place. */
+static svn_error_t *
+finish_file(const finish_job_t *job,
+            apr_pool_t *scratch_pool)
+{
+  if (!job->translate)
+    {
+      SVN_ERR(svn_io_file_rename2(job->tmppath, job->path, FALSE,
+                                  scratch_pool));
+    }
+  else
+    {
+      SVN_ERR(svn_subst_copy_and_translate4(job->tmppath, job->path,
+                                            job->eol, job->repair,
+                                            job->keywords,
+                                            TRUE, /* expand */
+                                            job->special,
+                                            job->cancel_func,
+                                            job->cancel_baton,
+                                            scratch_pool));
+
+      SVN_ERR(svn_io_remove_file2(job->tmppath, FALSE, scratch_pool));
+    }
+
+  if (job->executable)
+    SVN_ERR(svn_io_set_file_executable(job->path, TRUE, FALSE,
+                                       scratch_pool));
+
+  if (job->date && (! job->special))
+    SVN_ERR(svn_io_set_file_affected_time(job->date, job->path,
+                                          scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Send the notification that file PATH has been exported. */
+static void
+notify_file_added(struct edit_baton *eb,
+                  const char *path,
+                  apr_pool_t *scratch_pool)
+{
+  if (eb->notify_func)
+    {
+      svn_wc_notify_t *notify = svn_wc_create_notify(path,
+                                                     svn_wc_notify_update_add,
+                                                     scratch_pool);
+      notify->kind = svn_node_file;
+      (*eb->notify_func)(eb->notify_baton, notify, scratch_pool);
+    }
+}
+
+#if APR_HAS_THREADS
+
+/* Number of threads translating and installing exported files while the
+   editor receives the following ones. */
+#define FINISH_THREADS 4
+
+/* Maximum number of received files waiting to be installed.  These only
+   hold closed temporary files; at most one file per thread is open. */
+#define FINISH_AHEAD (4 * FINISH_THREADS)
+
+/* The files of an export edit that wait to be installed. */
+typedef struct finish_queue_t
+{
+  /* Ring buffer of the jobs numbered FIRST up to SUBMITTED, in the
+     order of their submission.  Jobs before NEXT have been taken by a
+     thread.  FIRST and SUBMITTED are only modified by the thread that
+     drives the editor. */
+  finish_job_t *jobs[FINISH_AHEAD];
+  int first;
+  int next;
+  int submitted;
+
+  /* Set when the threads should exit. */
+  svn_boolean_t stop;
+
+  /* Protects the fields above and the DONE flags of the jobs. */
+  apr_thread_mutex_t *mutex;
+
+  /* Signalled when a job has been submitted or finished. */
+  apr_thread_cond_t *cond;
+
+  apr_thread_t *threads[FINISH_THREADS];
+  int thread_count;
+
+  /* The pool that stop_finish_threads() is registered with. */
+  apr_pool_t *pool;
+} finish_queue_t;
+
+/* Run JOB of QUEUE and signal its completion.  The caller must have
+   taken JOB from QUEUE, and not hold the lock of QUEUE. */
+static void
+run_finish_job(finish_queue_t *queue,
+               finish_job_t *job,
+               apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = finish_file(job, scratch_pool);
+
+  apr_thread_mutex_lock(queue->mutex);
+  job->err = err;
+  job->done = TRUE;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+}
+
+/* Implements apr_thread_start_t for the finish_queue_t at DATA. */
+static void * APR_THREAD_FUNC
+finish_thread(apr_thread_t *tid, void *data)
+{
+  finish_queue_t *queue = data;
+  apr_pool_t *iterpool = svn_pool_create(NULL);
+
+  while (TRUE)
+    {
+      finish_job_t *job = NULL;
+
+      apr_thread_mutex_lock(queue->mutex);
+      while (!queue->stop && queue->next == queue->submitted)
+        apr_thread_cond_wait(queue->cond, queue->mutex);
+      if (!queue->stop)
+        job = queue->jobs[queue->next++ % FINISH_AHEAD];
+      apr_thread_mutex_unlock(queue->mutex);
+
+      if (!job)
+        break;
+
+      svn_pool_clear(iterpool);
+      run_finish_job(queue, job, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Report and release the jobs of the finish queue of EB that have been
+   finished, in the order of their submission.  Wait for all jobs
+   numbered below WAIT_UNTIL, running them on this thread if no other
+   thread took them yet, and checking for cancellation whenever a job
+   finishes meanwhile.  Return the first error of a job. */
+static svn_error_t *
+reap_finished_files(struct edit_baton *eb,
+                    int wait_until,
+                    apr_pool_t *scratch_pool)
+{
+  finish_queue_t *queue = eb->finish_queue;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  apr_thread_mutex_lock(queue->mutex);
+  while (!err && queue->first < queue->submitted)
+    {
+      finish_job_t *job = queue->jobs[queue->first % FINISH_AHEAD];
+
+      if (!job->done)
+        {
+          if (queue->first >= wait_until)
+            break;
+
+          if (queue->next == queue->first)
+            {
+              queue->next++;
+              apr_thread_mutex_unlock(queue->mutex);
+              run_finish_job(queue, job, scratch_pool);
+              apr_thread_mutex_lock(queue->mutex);
+            }
+          else
+            {
+              apr_thread_cond_wait(queue->cond, queue->mutex);
+
+              if (eb->cancel_func)
+                {
+                  apr_thread_mutex_unlock(queue->mutex);
+                  err = eb->cancel_func(eb->cancel_baton);
+                  apr_thread_mutex_lock(queue->mutex);
+                }
+            }
+
+          continue;
+        }
+
+      queue->jobs[queue->first++ % FINISH_AHEAD] = NULL;
+      apr_thread_mutex_unlock(queue->mutex);
+
+      err = job->err;
+      if (!err)
+        notify_file_added(eb, job->path, scratch_pool);
+      svn_pool_destroy(job->pool);
+
+      apr_thread_mutex_lock(queue->mutex);
+    }
+  apr_thread_mutex_unlock(queue->mutex);
+
+  return svn_error_trace(err);
+}
+
+/* Stop the threads of the finish_queue_t at DATA and remove the files
+   of the jobs that are left.  Implements apr_pool_cleanup_t. */
+static apr_status_t
+stop_finish_threads(void *data)
+{
+  finish_queue_t *queue = data;
+  int i;
+
+  apr_thread_mutex_lock(queue->mutex);
+  queue->stop = TRUE;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  for (i = 0; i < queue->thread_count; i++)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, queue->threads[i]);
+    }
+
+  for (i = queue->first; i < queue->submitted; i++)
+    {
+      finish_job_t *job = queue->jobs[i % FINISH_AHEAD];
+
+      if (!job->done)
+        svn_error_clear(svn_io_remove_file2(job->tmppath, TRUE, job->pool));
+      svn_error_clear(job->err);
+      svn_pool_destroy(job->pool);
+    }
+
+  queue->first = queue->submitted;
+  queue->thread_count = 0;
+
+  return APR_SUCCESS;
+}
+
+/* Set up the finish queue of EB in POOL, if threads are available. */
+static void
+start_finish_threads(struct edit_baton *eb,
+                     apr_pool_t *pool)
+{
+  finish_queue_t *queue = apr_pcalloc(pool, sizeof(*queue));
+  int i;
+
+  queue->pool = pool;
+  if (apr_thread_mutex_create(&queue->mutex, APR_THREAD_MUTEX_DEFAULT, pool)
+      || apr_thread_cond_create(&queue->cond, pool))
+    return;
+
+  for (i = 0; i < FINISH_THREADS; i++)
+    {
+      if (apr_thread_create(&queue->threads[queue->thread_count], NULL,
+                            finish_thread, queue, pool))
+        break;
+
+      ++queue->thread_count;
+    }
+
+  if (!queue->thread_count)
+    return;
+
+  /* Registered after the mutex and the condition, so that this runs
+     before they are destroyed. */
+  apr_pool_cleanup_register(pool, queue, stop_finish_threads,
+                            apr_pool_cleanup_null);
+  eb->finish_queue = queue;
+}
+
+/* Queue JOB, allocated in JOB->POOL, to be finished by the threads of
+   the finish queue of EB. */
+static svn_error_t *
+submit_finish_job(struct edit_baton *eb,
+                  finish_job_t *job,
+                  apr_pool_t *scratch_pool)
+{
+  finish_queue_t *queue = eb->finish_queue;
+  svn_error_t *err;
+
+  /* Make room, reporting what has been finished so far. */
+  err = reap_finished_files(eb, queue->submitted - FINISH_AHEAD + 1,
+                            scratch_pool);
+  if (err)
+    {
+      svn_error_clear(svn_io_remove_file2(job->tmppath, TRUE, job->pool));
+      svn_pool_destroy(job->pool);
+      return svn_error_trace(err);
+    }
+
+  apr_thread_mutex_lock(queue->mutex);
+  queue->jobs[queue->submitted++ % FINISH_AHEAD] = job;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Move the tmpfile to file, and send feedback. */
 static svn_error_t *
 close_file(void *file_baton,
@@ -795,6 +1129,8 @@ close_file(void *file_baton,
   struct edit_baton *eb = fb->edit_baton;
   svn_checksum_t *text_checksum;
   svn_checksum_t *actual_checksum;
+  finish_job_t *job;
+  apr_pool_t *job_pool = fb->pool;
 
   /* Was a txdelta even sent? */
   if (! fb->tmppath)
@@ -814,55 +1150,84 @@ close_file(void *file_baton,
                                      _("Checksum mismatch for '%s'"),
                                      svn_dirent_local_style(fb->path, pool));
 
-  if ((! fb->eol_style_val) && (! fb->keywords_val) && (! fb->special))
-    {
-      SVN_ERR(svn_io_file_rename2(fb->tmppath, fb->path, FALSE, pool));
-    }
-  else
+#if APR_HAS_THREADS
+  /* Queued jobs must not depend on FB->POOL, which is gone when this
+     function returns. */
+  if (eb->finish_queue)
+    job_pool = svn_pool_create(NULL);
+#endif
+
+  job = apr_pcalloc(job_pool, sizeof(*job));
+  job->pool = job_pool;
+  job->path = apr_pstrdup(job_pool, fb->path);
+  job->tmppath = apr_pstrdup(job_pool, fb->tmppath);
+  job->special = fb->special;
+  job->executable = (fb->executable_val != NULL);
+  job->date = fb->date;
+
+  if (fb->eol_style_val || fb->keywords_val || fb->special)
     {
       svn_subst_eol_style_t style;
       const char *eol = NULL;
-      svn_boolean_t repair = FALSE;
-      apr_hash_t *final_kw = NULL;
+      svn_error_t *err = SVN_NO_ERROR;
 
+      job->translate = TRUE;
       if (fb->eol_style_val)
         {
-          SVN_ERR(get_eol_style(&style, &eol, fb->eol_style_val->data,
-                                eb->native_eol));
-          repair = TRUE;
+          err = get_eol_style(&style, &eol, fb->eol_style_val->data,
+                              eb->native_eol);
+          job->eol = eol ? apr_pstrdup(job_pool, eol) : NULL;
+          job->repair = TRUE;
         }
 
-      if (fb->keywords_val)
-        SVN_ERR(svn_subst_build_keywords3(&final_kw, fb->keywords_val->data,
-                                          fb->revision, fb->url,
-                                          fb->repos_root_url, fb->date,
-                                          fb->author, pool));
-
-      SVN_ERR(svn_subst_copy_and_translate4(fb->tmppath, fb->path,
-                                            eol, repair, final_kw,
-                                            TRUE, /* expand */
-                                            fb->special,
-                                            eb->cancel_func, eb->cancel_baton,
-                                            pool));
+      if (!err && fb->keywords_val)
+        err = svn_subst_build_keywords3(&job->keywords,
+                                        fb->keywords_val->data,
+                                        fb->revision, fb->url,
+                                        fb->repos_root_url, fb->date,
+                                        fb->author, job_pool);
 
-      SVN_ERR(svn_io_remove_file2(fb->tmppath, FALSE, pool));
+      if (err)
+        {
+          if (job_pool != fb->pool)
+            svn_pool_destroy(job_pool);
+          return svn_error_trace(err);
+        }
     }
 
-  if (fb->executable_val)
-    SVN_ERR(svn_io_set_file_executable(fb->path, TRUE, FALSE, pool));
+#if APR_HAS_THREADS
+  if (eb->finish_queue)
+    return svn_error_trace(submit_finish_job(eb, job, pool));
+#endif
+
+  job->cancel_func = eb->cancel_func;
+  job->cancel_baton = eb->cancel_baton;
+  SVN_ERR(finish_file(job, pool));
 
-  if (fb->date && (! fb->special))
-    SVN_ERR(svn_io_set_file_affected_time(fb->date, fb->path, pool));
+  notify_file_added(eb, job->path, pool);
+
+  return SVN_NO_ERROR;
+}
 
-  if (fb->edit_baton->notify_func)
+/* Install the files that are still queued and stop the threads.
+   Implements svn_delta_editor_t.close_edit. */
+static svn_error_t *
+close_edit(void *edit_baton,
+           apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  struct edit_baton *eb = edit_baton;
+
+  if (eb->finish_queue)
     {
-      svn_wc_notify_t *notify = svn_wc_create_notify(fb->path,
-                                                     svn_wc_notify_update_add,
-                                                     pool);
-      notify->kind = svn_node_file;
-      (*fb->edit_baton->notify_func)(fb->edit_baton->notify_baton, notify,
-                                     pool);
+      finish_queue_t *queue = eb->finish_queue;
+
+      SVN_ERR(reap_finished_files(eb, queue->submitted, pool));
+
+      eb->finish_queue = NULL;
+      apr_pool_cleanup_run(queue->pool, queue, stop_finish_threads);
     }
+#endif
 
   return SVN_NO_ERROR;
 }
@@ -914,6 +1279,11 @@ get_editor_ev1(const svn_delta_editor_t **export_editor,
   editor->close_file = close_file;
   editor->change_file_prop = change_file_prop;
   editor->change_dir_prop = change_dir_prop;
+  editor->close_edit = close_edit;
+
+#if APR_HAS_THREADS
+  start_finish_threads(eb, result_pool);
+#endif
 
   SVN_ERR(svn_delta_get_cancellation_editor(ctx->cancel_func,
                                             ctx->cancel_baton,
@@ -28,6 +28,9 @@
 /*** Includes. ***/
 
 #include <apr_uri.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
 #include "svn_hash.h"
 #include "svn_wc.h"
 #include "svn_pools.h"
@@ -38,9 +41,11 @@
 #include "svn_path.h"
 #include "svn_props.h"
 #include "svn_config.h"
+#include "svn_sorts.h"
 #include "client.h"
 
 #include "svn_private_config.h"
+#include "private/svn_auth_private.h"
 #include "private/svn_wc_private.h"
 
 
@@ -141,7 +146,398 @@ relegate_dir_external(svn_wc_context_t *wc_ctx,
   return svn_error_trace(err);
 }
 
+/* Register the directory external LOCAL_ABSPATH, just checked out from
+   URL, in the working copy defining it at DEFINING_ABSPATH. */
+static svn_error_t *
+register_new_dir_external(const char *local_abspath,
+                          const char *url,
+                          const char *defining_abspath,
+                          svn_revnum_t external_peg_rev,
+                          svn_revnum_t external_rev,
+                          svn_client_ctx_t *ctx,
+                          apr_pool_t *scratch_pool)
+{
+  const char *repos_root_url;
+  const char *repos_uuid;
+
+  SVN_ERR(svn_wc__node_get_repos_info(NULL, NULL,
+                                      &repos_root_url,
+                                      &repos_uuid,
+                                      ctx->wc_ctx, local_abspath,
+                                      scratch_pool, scratch_pool));
+
+  return svn_error_trace(svn_wc__external_register(ctx->wc_ctx,
+                                    defining_abspath,
+                                    local_abspath, svn_node_dir,
+                                    repos_root_url, repos_uuid,
+                                    svn_uri_skip_ancestor(repos_root_url,
+                                                          url, scratch_pool),
+                                    external_peg_rev,
+                                    external_rev,
+                                    scratch_pool));
+}
+
+/* New directory externals checked out concurrently, each into its own
+   working copy, while svn_client__handle_externals() goes on with the
+   other externals.  All access to the defining working copies, and all
+   calls to the callbacks of the client context, stay on the calling
+   thread. */
+typedef struct external_batch_t external_batch_t;
+
+#if APR_HAS_THREADS
+
+/* How long the calling thread waits for checkouts before it checks
+   for cancellation again. */
+#define CHECKOUT_POLL_INTERVAL apr_time_from_msec(100)
+
+struct external_batch_t
+{
+  /* Maximum number of concurrent checkouts, and the number running. */
+  int limit;
+  int running;
+
+  /* The external_checkout_t * started so far. */
+  apr_array_header_t *checkouts;
+
+  /* Protects RUNNING, CANCELLED and the notifications below. */
+  apr_thread_mutex_t *mutex;
+
+  /* Signalled when a checkout finishes or sends a notification. */
+  apr_thread_cond_t *cond;
+
+  /* Set when the client has cancelled the operation. */
+  svn_boolean_t cancelled;
+
+  /* The notifications sent by the checkouts that have not been passed
+     to the client yet, as svn_wc_notify_t *, allocated in NOTIFY_POOL. */
+  apr_array_header_t *notifications;
+  apr_pool_t *notify_pool;
+
+  /* The client context. */
+  svn_client_ctx_t *ctx;
+
+  /* The pool of this batch. */
+  apr_pool_t *pool;
+};
+
+/* A directory external checked out by a thread of an external_batch_t. */
+typedef struct external_checkout_t
+{
+  external_batch_t *batch;
+
+  const char *local_abspath;
+  const char *url;
+  svn_opt_revision_t peg_revision;
+  svn_opt_revision_t revision;
+  const char *defining_abspath;
+  svn_revnum_t external_peg_rev;
+  svn_revnum_t external_rev;
+
+  /* A client context and RA session of this checkout alone. */
+  svn_client_ctx_t *ctx;
+  svn_ra_session_t *ra_session;
+
+  /* Set once the checkout no longer runs on the calling thread, and may
+     not use the client's auth baton anymore. */
+  svn_boolean_t detached;
+
+  svn_boolean_t timestamp_sleep;
+  svn_error_t *err;
+
+  apr_thread_t *thread;
+
+  /* Root pool of this checkout. */
+  apr_pool_t *pool;
+} external_checkout_t;
+
+/* Implements svn_wc_notify_func2_t, queueing NOTIFY until the calling
+   thread of the external_batch_t at BATON passes it to the client. */
+static void
+queue_notify(void *baton,
+             const svn_wc_notify_t *notify,
+             apr_pool_t *pool)
+{
+  external_batch_t *batch = baton;
+
+  apr_thread_mutex_lock(batch->mutex);
+  APR_ARRAY_PUSH(batch->notifications, svn_wc_notify_t *)
+    = svn_wc_dup_notify(notify, batch->notify_pool);
+  apr_thread_cond_broadcast(batch->cond);
+  apr_thread_mutex_unlock(batch->mutex);
+}
+
+/* Implements svn_cancel_func_t for the checkouts of the external_batch_t
+   at CANCEL_BATON, whose calling thread asks the client. */
+static svn_error_t *
+batch_cancel(void *cancel_baton)
+{
+  external_batch_t *batch = cancel_baton;
+  svn_boolean_t cancelled;
+
+  apr_thread_mutex_lock(batch->mutex);
+  cancelled = batch->cancelled;
+  apr_thread_mutex_unlock(batch->mutex);
+
+  if (cancelled)
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait until no more than MAX_RUNNING checkouts of BATCH are running.
+   Meanwhile, pass their notifications to the client and check for
+   cancellation, which the checkouts then see through batch_cancel(). */
+static svn_error_t *
+wait_for_checkouts(external_batch_t *batch,
+                   int max_running,
+                   apr_pool_t *scratch_pool)
+{
+  svn_client_ctx_t *ctx = batch->ctx;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_boolean_t done = FALSE;
+
+  while (!done)
+    {
+      apr_array_header_t *notifications = NULL;
+      apr_pool_t *notify_pool = NULL;
+      int i;
+
+      svn_pool_clear(iterpool);
+
+      apr_thread_mutex_lock(batch->mutex);
+      if (batch->running > max_running && !batch->notifications->nelts)
+        apr_thread_cond_timedwait(batch->cond, batch->mutex,
+                                  CHECKOUT_POLL_INTERVAL);
+
+      done = (batch->running <= max_running);
+      if (batch->notifications->nelts)
+        {
+          notifications = batch->notifications;
+          notify_pool = batch->notify_pool;
+          batch->notify_pool = svn_pool_create(batch->pool);
+          batch->notifications = apr_array_make(batch->notify_pool, 0,
+                                                sizeof(svn_wc_notify_t *));
+        }
+      apr_thread_mutex_unlock(batch->mutex);
+
+      if (notifications)
+        {
+          for (i = 0; i < notifications->nelts; i++)
+            ctx->notify_func2(ctx->notify_baton2,
+                              APR_ARRAY_IDX(notifications, i,
+                                            svn_wc_notify_t *),
+                              iterpool);
+          svn_pool_destroy(notify_pool);
+        }
+
+      if (!done && !err && ctx->cancel_func)
+        {
+          err = ctx->cancel_func(ctx->cancel_baton);
+          if (err)
+            {
+              apr_thread_mutex_lock(batch->mutex);
+              batch->cancelled = TRUE;
+              apr_thread_mutex_unlock(batch->mutex);
+            }
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+/* Check out CO, and release its client context. */
+static svn_error_t *
+run_external_checkout(external_checkout_t *co)
+{
+  svn_error_t *err;
+
+  err = svn_client__checkout_internal(NULL, &co->timestamp_sleep,
+                                      co->url, co->local_abspath,
+                                      &co->peg_revision, &co->revision,
+                                      svn_depth_infinity,
+                                      FALSE, FALSE,
+                                      co->ra_session,
+                                      co->ctx, co->pool);
+
+  /* Close the new working copy, so that the defining one can open it. */
+  return svn_error_compose_create(err,
+                                  svn_wc_context_destroy(co->ctx->wc_ctx));
+}
+
+/* Implements apr_thread_start_t for the external_checkout_t at DATA. */
+static void * APR_THREAD_FUNC
+external_checkout_thread(apr_thread_t *tid, void *data)
+{
+  external_checkout_t *co = data;
+  external_batch_t *batch = co->batch;
+
+  co->err = run_external_checkout(co);
+
+  apr_thread_mutex_lock(batch->mutex);
+  batch->running--;
+  apr_thread_cond_signal(batch->cond);
+  apr_thread_mutex_unlock(batch->mutex);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+#endif /* APR_HAS_THREADS */
+
+static svn_error_t *
+finish_external_checkouts(external_batch_t *batch,
+                          svn_boolean_t *timestamp_sleep,
+                          apr_pool_t *scratch_pool);
+
+/* Start checking out the new directory external LOCAL_ABSPATH in BATCH,
+   with the arguments of switch_dir_external().  Wait for earlier
+   checkouts first if they are nested in it or the other way around,
+   or if the maximum number of checkouts is running. */
+static svn_error_t *
+start_external_checkout(external_batch_t *batch,
+                        const char *local_abspath,
+                        const char *url,
+                        const svn_opt_revision_t *peg_revision,
+                        const svn_opt_revision_t *revision,
+                        const char *defining_abspath,
+                        svn_revnum_t external_peg_rev,
+                        svn_revnum_t external_rev,
+                        svn_boolean_t *timestamp_sleep,
+                        apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  svn_client_ctx_t *ctx = batch->ctx;
+  external_checkout_t *co;
+  apr_pool_t *co_pool;
+  apr_hash_t *config;
+  svn_config_t *cfg;
+  svn_client_ctx_t *co_ctx;
+  svn_error_t *err;
+  int i;
+
+  for (i = 0; i < batch->checkouts->nelts; i++)
+    {
+      co = APR_ARRAY_IDX(batch->checkouts, i, external_checkout_t *);
+
+      if (svn_dirent_is_ancestor(co->local_abspath, local_abspath)
+          || svn_dirent_is_ancestor(local_abspath, co->local_abspath))
+        {
+          SVN_ERR(finish_external_checkouts(batch, timestamp_sleep,
+                                            scratch_pool));
+          break;
+        }
+    }
+
+  SVN_ERR(wait_for_checkouts(batch, batch->limit - 1, scratch_pool));
+
+  co_pool = svn_pool_create(NULL);
+  co = apr_pcalloc(co_pool, sizeof(*co));
+  co->batch = batch;
+  co->pool = co_pool;
+  co->local_abspath = apr_pstrdup(co_pool, local_abspath);
+  co->url = apr_pstrdup(co_pool, url);
+  co->peg_revision = *peg_revision;
+  co->revision = *revision;
+  co->defining_abspath = apr_pstrdup(co_pool, defining_abspath);
+  co->external_peg_rev = external_peg_rev;
+  co->external_rev = external_rev;
+
+  /* The checkout gets its own copy of the configuration, since reading
+     a configuration may modify it, and checks out its own externals one
+     at a time. */
+  err = svn_config_copy_config(&config, ctx->config, co_pool);
+  if (!err)
+    {
+      cfg = svn_hash_gets(config, SVN_CONFIG_CATEGORY_CONFIG);
+      if (cfg)
+        svn_config_set_int64(cfg, SVN_CONFIG_SECTION_MISCELLANY,
+                             SVN_CONFIG_OPTION_EXTERNALS_CONCURRENCY, 1);
+
+      err = svn_client_create_context2(&co_ctx, config, co_pool);
+    }
+
+  if (!err)
+    {
+      svn_wc_context_t *wc_ctx = co_ctx->wc_ctx;
+
+      /* Share the rest of the client context, but never invoke its
+         callbacks from another thread: queue the notifications, get
+         cancellation from the batch, don't report progress and
+         postpone conflicts. */
+      *co_ctx = *ctx;
+      co_ctx->config = config;
+      co_ctx->wc_ctx = wc_ctx;
+      co_ctx->notify_func = NULL;
+      co_ctx->notify_baton = NULL;
+      if (ctx->notify_func2)
+        {
+          co_ctx->notify_func2 = queue_notify;
+          co_ctx->notify_baton2 = batch;
+        }
+      co_ctx->cancel_func = batch_cancel;
+      co_ctx->cancel_baton = batch;
+      co_ctx->progress_func = NULL;
+      co_ctx->progress_baton = NULL;
+      co_ctx->conflict_func = NULL;
+      co_ctx->conflict_func2 = NULL;
+      co->ctx = co_ctx;
+
+      /* Prompt on this thread, and cache for the checkout what it needs
+         to authenticate further connections. */
+      if (ctx->auth_baton)
+        svn_auth__make_thread_auth(&co_ctx->auth_baton, ctx->auth_baton,
+                                   &co->detached, co_pool);
+
+      /* Open the session here, so that any prompting happens on this
+         thread, and the credentials it needs are cached for the
+         checkout. */
+      err = svn_client__ra_session_from_path2(&co->ra_session, NULL, url,
+                                              NULL, peg_revision, revision,
+                                              co_ctx, co_pool);
+      if (err)
+        err = svn_error_compose_create(err, svn_wc_context_destroy(wc_ctx));
+    }
+
+  if (err)
+    {
+      svn_pool_destroy(co_pool);
+      return svn_error_trace(err);
+    }
+
+  apr_thread_mutex_lock(batch->mutex);
+  batch->running++;
+  apr_thread_mutex_unlock(batch->mutex);
+
+  APR_ARRAY_PUSH(batch->checkouts, external_checkout_t *) = co;
+
+  co->detached = TRUE;
+  if (apr_thread_create(&co->thread, NULL, external_checkout_thread, co,
+                        co_pool))
+    {
+      /* Check it out here instead. */
+      co->thread = NULL;
+      co->detached = FALSE;
+      co->ctx->cancel_func = ctx->cancel_func;
+      co->ctx->cancel_baton = ctx->cancel_baton;
+      co->err = run_external_checkout(co);
+
+      apr_thread_mutex_lock(batch->mutex);
+      batch->running--;
+      apr_thread_mutex_unlock(batch->mutex);
+    }
+
+  return SVN_NO_ERROR;
+#else
+  SVN_ERR_MALFUNCTION();
+#endif
+}
+
 /* Try to update a directory external at PATH to URL at REVISION.
+   If it is to be checked out anew and BATCH is not NULL, start its
+   checkout in BATCH instead.
    Use POOL for temporary allocations, and use the client context CTX. */
 static svn_error_t *
 switch_dir_external(const char *local_abspath,
@@ -152,6 +548,7 @@ switch_dir_external(const char *local_abspath,
                     const char *defining_abspath,
                     svn_boolean_t *timestamp_sleep,
                     svn_ra_session_t *ra_session,
+                    external_batch_t *batch,
                     svn_client_ctx_t *ctx,
                     apr_pool_t *pool)
 {
@@ -405,6 +802,16 @@ switch_dir_external(const char *local_abspath,
          the path leading down to the last component. */
       const char *parent = svn_dirent_dirname(local_abspath, pool);
       SVN_ERR(svn_io_make_dir_recursively(parent, pool));
+
+      if (batch)
+        return svn_error_trace(start_external_checkout(batch, local_abspath,
+                                                       url, peg_revision,
+                                                       revision,
+                                                       defining_abspath,
+                                                       external_peg_rev,
+                                                       external_rev,
+                                                       timestamp_sleep,
+                                                       pool));
     }
 
   /* ... Hello, new hotness. */
@@ -415,21 +822,9 @@ switch_dir_external(const char *local_abspath,
                                         ra_session,
                                         ctx, pool));
 
-  SVN_ERR(svn_wc__node_get_repos_info(NULL, NULL,
-                                      &repos_root_url,
-                                      &repos_uuid,
-                                      ctx->wc_ctx, local_abspath,
-                                      pool, pool));
-
-  SVN_ERR(svn_wc__external_register(ctx->wc_ctx,
-                                    defining_abspath,
-                                    local_abspath, svn_node_dir,
-                                    repos_root_url, repos_uuid,
-                                    svn_uri_skip_ancestor(repos_root_url,
-                                                          url, pool),
-                                    external_peg_rev,
-                                    external_rev,
-                                    pool));
+  SVN_ERR(register_new_dir_external(local_abspath, url, defining_abspath,
+                                    external_peg_rev, external_rev,
+                                    ctx, pool));
 
  cleanup:
   /* Issues #4123 and #4130: We don't need to keep the newly checked
@@ -754,6 +1149,7 @@ handle_external_item_change(svn_client_ctx_t *ctx,
                             const char *old_defining_abspath,
                             const svn_wc_external_item2_t *new_item,
                             svn_ra_session_t *ra_session,
+                            external_batch_t *batch,
                             svn_boolean_t *timestamp_sleep,
                             apr_pool_t *scratch_pool)
 {
@@ -858,7 +1254,7 @@ handle_external_item_change(svn_client_ctx_t *ctx,
                                     &(new_item->peg_revision),
                                     &(new_item->revision),
                                     parent_dir_abspath,
-                                    timestamp_sleep, ra_session, ctx,
+                                    timestamp_sleep, ra_session, batch, ctx,
                                     scratch_pool));
         break;
       case svn_node_file:
@@ -958,6 +1354,130 @@ wrap_external_error(const svn_client_ctx_t *ctx,
   return err;
 }
 
+/* Set *BATCH to a batch for checking out new directory externals
+   concurrently, if CTX asks for that, or to NULL. */
+static svn_error_t *
+open_external_batch(external_batch_t **batch,
+                    svn_client_ctx_t *ctx,
+                    apr_pool_t *result_pool)
+{
+#if APR_HAS_THREADS
+  svn_config_t *cfg;
+  apr_int64_t limit;
+  external_batch_t *b;
+
+  *batch = NULL;
+
+  cfg = ctx->config
+        ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+        : NULL;
+  SVN_ERR(svn_config_get_int64(cfg, &limit, SVN_CONFIG_SECTION_MISCELLANY,
+                               SVN_CONFIG_OPTION_EXTERNALS_CONCURRENCY, 1));
+  if (limit <= 1)
+    return SVN_NO_ERROR;
+
+  b = apr_pcalloc(result_pool, sizeof(*b));
+  b->limit = (int)MIN(limit, 64);
+  b->checkouts = apr_array_make(result_pool, 0,
+                                sizeof(external_checkout_t *));
+  b->ctx = ctx;
+  b->pool = result_pool;
+  b->notify_pool = svn_pool_create(result_pool);
+  b->notifications = apr_array_make(b->notify_pool, 0,
+                                    sizeof(svn_wc_notify_t *));
+
+  if (apr_thread_mutex_create(&b->mutex, APR_THREAD_MUTEX_DEFAULT,
+                              result_pool)
+      || apr_thread_cond_create(&b->cond, result_pool))
+    return SVN_NO_ERROR;
+
+  *batch = b;
+#else
+  *batch = NULL;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the checkouts started in BATCH, and register the new
+   externals in their defining working copies.  Notify failures like
+   for other externals. */
+static svn_error_t *
+finish_external_checkouts(external_batch_t *batch,
+                          svn_boolean_t *timestamp_sleep,
+                          apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  svn_client_ctx_t *ctx = batch->ctx;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err;
+  int i;
+
+  err = wait_for_checkouts(batch, 0, scratch_pool);
+
+  for (i = 0; i < batch->checkouts->nelts; i++)
+    {
+      external_checkout_t *co = APR_ARRAY_IDX(batch->checkouts, i,
+                                              external_checkout_t *);
+
+      if (co->thread)
+        {
+          apr_status_t retval;
+          apr_thread_join(&retval, co->thread);
+        }
+    }
+
+  for (i = 0; i < batch->checkouts->nelts; i++)
+    {
+      external_checkout_t *co = APR_ARRAY_IDX(batch->checkouts, i,
+                                              external_checkout_t *);
+      svn_error_t *co_err = co->err;
+
+      svn_pool_clear(iterpool);
+
+      if (co->timestamp_sleep)
+        *timestamp_sleep = TRUE;
+
+      if (err)
+        svn_error_clear(co_err);
+      else
+        {
+          if (!co_err)
+            co_err = register_new_dir_external(co->local_abspath, co->url,
+                                               co->defining_abspath,
+                                               co->external_peg_rev,
+                                               co->external_rev,
+                                               ctx, iterpool);
+          if (!co_err)
+            co_err = svn_wc__close_db(co->local_abspath, ctx->wc_ctx,
+                                      iterpool);
+
+          err = wrap_external_error(ctx, co->local_abspath, co_err,
+                                    iterpool);
+        }
+
+      svn_pool_destroy(co->pool);
+    }
+
+  apr_array_clear(batch->checkouts);
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+#else
+  return SVN_NO_ERROR;
+#endif
+}
+
+/* Finish the checkouts of BATCH. */
+static svn_error_t *
+close_external_batch(external_batch_t *batch,
+                     svn_boolean_t *timestamp_sleep,
+                     apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(finish_external_checkouts(batch, timestamp_sleep,
+                                                   scratch_pool));
+}
+
 static svn_error_t *
 handle_externals_change(svn_client_ctx_t *ctx,
                         const char *repos_root_url,
@@ -968,6 +1488,7 @@ handle_externals_change(svn_client_ctx_t *ctx,
                         svn_depth_t ambient_depth,
                         svn_depth_t requested_depth,
                         svn_ra_session_t *ra_session,
+                        external_batch_t *batch,
                         apr_pool_t *scratch_pool)
 {
   apr_array_header_t *new_desc;
@@ -1037,7 +1558,7 @@ handle_externals_change(svn_client_ctx_t *ctx,
                                                   target_abspath,
                                                   old_defining_abspath,
                                                   new_item, ra_session,
-                                                  timestamp_sleep,
+                                                  batch, timestamp_sleep,
                                                   iterpool),
                       iterpool));
 
@@ -1066,6 +1587,8 @@ svn_client__handle_externals(apr_hash_t *externals_new,
   apr_hash_t *old_external_defs;
   apr_hash_index_t *hi;
   apr_pool_t *iterpool;
+  external_batch_t *batch;
+  svn_error_t *err = SVN_NO_ERROR;
 
   SVN_ERR_ASSERT(repos_root_url);
 
@@ -1075,6 +1598,8 @@ svn_client__handle_externals(apr_hash_t *externals_new,
                                           ctx->wc_ctx, target_abspath,
                                           scratch_pool, iterpool));
 
+  SVN_ERR(open_external_batch(&batch, ctx, scratch_pool));
+
   for (hi = apr_hash_first(scratch_pool, externals_new);
        hi;
        hi = apr_hash_next(hi))
@@ -1094,10 +1619,11 @@ svn_client__handle_externals(apr_hash_t *externals_new,
 
           if (ambient_depth_w == NULL)
             {
-              return svn_error_createf(
+              err = svn_error_createf(
                         SVN_ERR_WC_CORRUPT, NULL,
                         _("Traversal of '%s' found no ambient depth"),
                         svn_dirent_local_style(local_abspath, scratch_pool));
+              break;
             }
           else
             {
@@ -1105,13 +1631,22 @@ svn_client__handle_externals(apr_hash_t *externals_new,
             }
         }
 
-      SVN_ERR(handle_externals_change(ctx, repos_root_url, timestamp_sleep,
-                                      local_abspath,
-                                      desc_text, old_external_defs,
-                                      ambient_depth, requested_depth,
-                                      ra_session, iterpool));
+      err = handle_externals_change(ctx, repos_root_url, timestamp_sleep,
+                                    local_abspath,
+                                    desc_text, old_external_defs,
+                                    ambient_depth, requested_depth,
+                                    ra_session, batch, iterpool);
+      if (err)
+        break;
     }
 
+  if (batch)
+    err = svn_error_compose_create(err,
+                                   close_external_batch(batch,
+                                                        timestamp_sleep,
+                                                        iterpool));
+  SVN_ERR(err);
+
   /* Remove the remaining externals */
   for (hi = apr_hash_first(scratch_pool, old_external_defs);
        hi;
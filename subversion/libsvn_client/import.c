@@ -31,6 +31,11 @@
 #include <apr_strings.h>
 #include <apr_hash.h>
 #include <apr_md5.h>
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#endif
 
 #include "svn_hash.h"
 #include "svn_ra.h"
@@ -56,6 +61,8 @@
 
 /* Import context baton. */
 
+typedef struct prepare_queue_t prepare_queue_t;
+
 typedef struct import_ctx_t
 {
   /* Whether any changes were made to the repository */
@@ -71,8 +78,40 @@ typedef struct import_ctx_t
      svn:executable, simply map the property name to an empty string.
      May be NULL if autoprops are disabled. */
   apr_hash_t *autoprops;
+
+  /* Threads preparing the text deltas of the files to import ahead of
+     the editor drive.  NULL if files are only read when sent. */
+  prepare_queue_t *prepare_queue;
 } import_ctx_t;
 
+/* A file whose properties have been determined, and whose text delta
+   against the empty file may be computed before it is sent. */
+typedef struct prepared_file_t
+{
+  const char *local_abspath;
+
+  /* The properties to set on the file and its detected mime-type,
+     see svn_client__get_paths_auto_props(). */
+  apr_hash_t *properties;
+  const char *mimetype;
+
+  /* Root pool holding this structure and everything referenced by it. */
+  apr_pool_t *pool;
+
+  /* The svn_txdelta_window_t * of the text delta and the MD5 checksum
+     of the file's normalized contents, once DONE. */
+  apr_array_header_t *windows;
+  svn_checksum_t *md5_checksum;
+
+  /* Set once the delta has been computed, or failed with ERR.  Protected
+     by the mutex of the prepare_queue_t. */
+  svn_boolean_t done;
+  svn_error_t *err;
+
+  /* Next file waiting for a thread, while in the prepare_queue_t. */
+  struct prepared_file_t *next;
+} prepared_file_t;
+
 typedef struct open_txdelta_stream_baton_t
 {
   svn_boolean_t need_reset;
@@ -103,29 +142,20 @@ open_txdelta_stream(svn_txdelta_stream_t **txdelta_stream_p,
   return SVN_NO_ERROR;
 }
 
-/* Apply LOCAL_ABSPATH's contents (as a delta against the empty string) to
-   FILE_BATON in EDITOR.  Use POOL for any temporary allocation.
-   PROPERTIES is the set of node properties set on this file.
-
-   Return the resulting checksum in *RESULT_MD5_CHECKSUM_P. */
-
-/* ### how does this compare against svn_wc_transmit_text_deltas2() ??? */
-
+/* Set *CONTENTS to a stream reading LOCAL_ABSPATH's contents in
+   repository-normal form, given the PROPERTIES that will be set on the
+   file (which may be NULL).  Allocate *CONTENTS in RESULT_POOL. */
 static svn_error_t *
-send_file_contents(svn_checksum_t **result_md5_checksum_p,
+open_file_contents(svn_stream_t **contents,
                    const char *local_abspath,
-                   void *file_baton,
-                   const svn_delta_editor_t *editor,
                    apr_hash_t *properties,
-                   apr_pool_t *pool)
+                   apr_pool_t *result_pool)
 {
-  svn_stream_t *contents;
   const svn_string_t *eol_style_val = NULL, *keywords_val = NULL;
   svn_boolean_t special = FALSE;
   svn_subst_eol_style_t eol_style;
   const char *eol;
   apr_hash_t *keywords;
-  open_txdelta_stream_baton_t baton = { 0 };
 
   /* If there are properties, look for EOL-style and keywords ones. */
   if (properties)
@@ -149,19 +179,20 @@ send_file_contents(svn_checksum_t **result_md5_checksum_p,
   if (keywords_val)
     SVN_ERR(svn_subst_build_keywords3(&keywords, keywords_val->data,
                                       APR_STRINGIFY(SVN_INVALID_REVNUM),
-                                      "", "", 0, "", pool));
+                                      "", "", 0, "", result_pool));
   else
     keywords = NULL;
 
   if (special)
     {
-      SVN_ERR(svn_subst_read_specialfile(&contents, local_abspath,
-                                         pool, pool));
+      SVN_ERR(svn_subst_read_specialfile(contents, local_abspath,
+                                         result_pool, result_pool));
     }
   else
     {
       /* Open the working copy file. */
-      SVN_ERR(svn_stream_open_readonly(&contents, local_abspath, pool, pool));
+      SVN_ERR(svn_stream_open_readonly(contents, local_abspath,
+                                       result_pool, result_pool));
 
       /* If we have EOL styles or keywords, then detranslate the file. */
       if (svn_subst_translation_required(eol_style, eol, keywords,
@@ -173,7 +204,7 @@ send_file_contents(svn_checksum_t **result_md5_checksum_p,
                                       "unrecognized EOL-style '%s'"),
                                     SVN_PROP_EOL_STYLE,
                                     svn_dirent_local_style(local_abspath,
-                                                           pool),
+                                                           result_pool),
                                     eol_style_val->data);
 
           /* We're importing, so translate files with 'native' eol-style to
@@ -182,15 +213,39 @@ send_file_contents(svn_checksum_t **result_md5_checksum_p,
             eol = SVN_SUBST_NATIVE_EOL_STR;
 
           /* Wrap the working copy stream with a filter to detranslate it. */
-          contents = svn_subst_stream_translated(contents,
-                                                 eol,
-                                                 TRUE /* repair */,
-                                                 keywords,
-                                                 FALSE /* expand */,
-                                                 pool);
+          *contents = svn_subst_stream_translated(*contents,
+                                                  eol,
+                                                  TRUE /* repair */,
+                                                  keywords,
+                                                  FALSE /* expand */,
+                                                  result_pool);
         }
     }
 
+  return SVN_NO_ERROR;
+}
+
+/* Apply LOCAL_ABSPATH's contents (as a delta against the empty string) to
+   FILE_BATON in EDITOR.  Use POOL for any temporary allocation.
+   PROPERTIES is the set of node properties set on this file.
+
+   Return the resulting checksum in *RESULT_MD5_CHECKSUM_P. */
+
+/* ### how does this compare against svn_wc_transmit_text_deltas2() ??? */
+
+static svn_error_t *
+send_file_contents(svn_checksum_t **result_md5_checksum_p,
+                   const char *local_abspath,
+                   void *file_baton,
+                   const svn_delta_editor_t *editor,
+                   apr_hash_t *properties,
+                   apr_pool_t *pool)
+{
+  svn_stream_t *contents;
+  open_txdelta_stream_baton_t baton = { 0 };
+
+  SVN_ERR(open_file_contents(&contents, local_abspath, properties, pool));
+
   /* Arrange the stream to calculate the resulting MD5. */
   contents = svn_stream_checksummed2(contents, result_md5_checksum_p, NULL,
                                      svn_checksum_md5, TRUE, pool);
@@ -204,6 +259,350 @@ send_file_contents(svn_checksum_t **result_md5_checksum_p,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* Compute the text delta and the checksum of PREPARED.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+prepare_file_delta(prepared_file_t *prepared,
+                   apr_pool_t *scratch_pool)
+{
+  svn_stream_t *contents;
+  svn_txdelta_stream_t *delta_stream;
+  svn_txdelta_window_t *window;
+
+  SVN_ERR(open_file_contents(&contents, prepared->local_abspath,
+                             prepared->properties, scratch_pool));
+  contents = svn_stream_checksummed2(contents, &prepared->md5_checksum,
+                                     NULL, svn_checksum_md5, TRUE,
+                                     prepared->pool);
+
+  svn_txdelta2(&delta_stream, svn_stream_empty(scratch_pool), contents,
+               FALSE, scratch_pool);
+
+  prepared->windows = apr_array_make(prepared->pool, 4, sizeof(window));
+  do
+    {
+      SVN_ERR(svn_txdelta_next_window(&window, delta_stream,
+                                      prepared->pool));
+      if (window)
+        APR_ARRAY_PUSH(prepared->windows, svn_txdelta_window_t *) = window;
+    }
+  while (window);
+
+  return svn_error_trace(svn_stream_close(contents));
+}
+
+/* Baton for replaying the windows of a prepared_file_t. */
+typedef struct replay_baton_t
+{
+  const prepared_file_t *prepared;
+  int idx;
+} replay_baton_t;
+
+/* Implements svn_txdelta_next_window_fn_t */
+static svn_error_t *
+replay_next_window(svn_txdelta_window_t **window,
+                   void *baton,
+                   apr_pool_t *pool)
+{
+  replay_baton_t *b = baton;
+
+  if (b->idx < b->prepared->windows->nelts)
+    *window = APR_ARRAY_IDX(b->prepared->windows, b->idx++,
+                            svn_txdelta_window_t *);
+  else
+    *window = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_md5_digest_fn_t */
+static const unsigned char *
+replay_md5_digest(void *baton)
+{
+  replay_baton_t *b = baton;
+
+  return b->prepared->md5_checksum->digest;
+}
+
+/* Implements svn_txdelta_stream_open_func_t */
+static svn_error_t *
+open_prepared_txdelta_stream(svn_txdelta_stream_t **txdelta_stream_p,
+                             void *baton,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  replay_baton_t *b = apr_pcalloc(result_pool, sizeof(*b));
+
+  /* Restarting is cheap: just replay the windows from the start. */
+  b->prepared = baton;
+  *txdelta_stream_p = svn_txdelta_stream_create(b, replay_next_window,
+                                                replay_md5_digest,
+                                                result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Number of threads computing text deltas ahead of the editor drive. */
+#define PREPARE_THREADS 4
+
+/* Number of files per directory whose delta may be prepared ahead of
+   the one being sent. */
+#define PREPARE_AHEAD (4 * PREPARE_THREADS)
+
+/* Only prepare files up to this size, as their deltas are kept in
+   memory until they are sent.  Larger files are read while sending. */
+#define PREPARE_MAX_SIZE (1024 * 1024)
+
+/* The files whose text delta is waiting to be computed. */
+struct prepare_queue_t
+{
+  /* Files not taken by any thread yet, in the order of their
+     submission. */
+  prepared_file_t *head;
+  prepared_file_t *tail;
+
+  /* Set when the threads should exit. */
+  svn_boolean_t stop;
+
+  /* Protects the fields above and the DONE flags of the files. */
+  apr_thread_mutex_t *mutex;
+
+  /* Signalled when a file has been submitted or prepared. */
+  apr_thread_cond_t *cond;
+
+  apr_thread_t *threads[PREPARE_THREADS];
+  int thread_count;
+};
+
+/* Prepare PREPARED and signal its completion to QUEUE.  The caller must
+   have taken PREPARED from QUEUE, and not hold the lock of QUEUE. */
+static void
+run_prepare_job(prepare_queue_t *queue,
+                prepared_file_t *prepared,
+                apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = prepare_file_delta(prepared, scratch_pool);
+
+  apr_thread_mutex_lock(queue->mutex);
+  prepared->err = err;
+  prepared->done = TRUE;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+}
+
+/* Implements apr_thread_start_t for the prepare_queue_t at DATA. */
+static void * APR_THREAD_FUNC
+prepare_thread(apr_thread_t *tid, void *data)
+{
+  prepare_queue_t *queue = data;
+  apr_pool_t *iterpool = svn_pool_create(NULL);
+
+  while (TRUE)
+    {
+      prepared_file_t *prepared = NULL;
+
+      apr_thread_mutex_lock(queue->mutex);
+      while (!queue->stop && !queue->head)
+        apr_thread_cond_wait(queue->cond, queue->mutex);
+      if (!queue->stop)
+        {
+          prepared = queue->head;
+          queue->head = prepared->next;
+          prepared->next = NULL;
+        }
+      apr_thread_mutex_unlock(queue->mutex);
+
+      if (!prepared)
+        break;
+
+      svn_pool_clear(iterpool);
+      run_prepare_job(queue, prepared, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Remove PREPARED from QUEUE if no thread took it yet and return TRUE
+   in that case.  The caller must hold the lock of QUEUE. */
+static svn_boolean_t
+unqueue_prepared_file(prepare_queue_t *queue,
+                      prepared_file_t *prepared)
+{
+  prepared_file_t **link = &queue->head;
+  prepared_file_t *previous = NULL;
+
+  while (*link && *link != prepared)
+    {
+      previous = *link;
+      link = &previous->next;
+    }
+
+  if (!*link)
+    return FALSE;
+
+  *link = prepared->next;
+  if (queue->tail == prepared)
+    queue->tail = previous;
+  prepared->next = NULL;
+
+  return TRUE;
+}
+
+/* Wait until PREPARED, submitted to QUEUE, has been prepared, preparing
+   it on this thread if no other thread took it yet. */
+static svn_error_t *
+wait_for_prepared_file(prepare_queue_t *queue,
+                       prepared_file_t *prepared,
+                       apr_pool_t *scratch_pool)
+{
+  svn_boolean_t run_here;
+
+  apr_thread_mutex_lock(queue->mutex);
+  run_here = unqueue_prepared_file(queue, prepared);
+  if (!run_here)
+    while (!prepared->done)
+      apr_thread_cond_wait(queue->cond, queue->mutex);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  if (run_here)
+    run_prepare_job(queue, prepared, scratch_pool);
+
+  return svn_error_dup(prepared->err);
+}
+
+/* Release PREPARED, submitted to QUEUE, whether or not it has been
+   prepared yet. */
+static void
+discard_prepared_file(prepare_queue_t *queue,
+                      prepared_file_t *prepared)
+{
+  apr_thread_mutex_lock(queue->mutex);
+  if (!unqueue_prepared_file(queue, prepared))
+    while (!prepared->done)
+      apr_thread_cond_wait(queue->cond, queue->mutex);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  svn_error_clear(prepared->err);
+  svn_pool_destroy(prepared->pool);
+}
+
+/* Let the threads of QUEUE prepare PREPARED. */
+static void
+submit_prepared_file(prepare_queue_t *queue,
+                     prepared_file_t *prepared)
+{
+  apr_thread_mutex_lock(queue->mutex);
+  if (queue->head)
+    queue->tail->next = prepared;
+  else
+    queue->head = prepared;
+  queue->tail = prepared;
+  apr_thread_cond_signal(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+}
+
+/* Stop the threads of the prepare_queue_t at DATA.  Implements
+   apr_pool_cleanup_t. */
+static apr_status_t
+stop_prepare_threads(void *data)
+{
+  prepare_queue_t *queue = data;
+  int i;
+
+  apr_thread_mutex_lock(queue->mutex);
+  queue->stop = TRUE;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  for (i = 0; i < queue->thread_count; i++)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, queue->threads[i]);
+    }
+
+  queue->thread_count = 0;
+
+  return APR_SUCCESS;
+}
+
+/* Return a new prepare queue with running threads, allocated in POOL,
+   or NULL if threads are not available. */
+static prepare_queue_t *
+start_prepare_threads(apr_pool_t *pool)
+{
+  prepare_queue_t *queue = apr_pcalloc(pool, sizeof(*queue));
+  int i;
+
+  if (apr_thread_mutex_create(&queue->mutex, APR_THREAD_MUTEX_DEFAULT, pool)
+      || apr_thread_cond_create(&queue->cond, pool))
+    return NULL;
+
+  for (i = 0; i < PREPARE_THREADS; i++)
+    {
+      if (apr_thread_create(&queue->threads[queue->thread_count], NULL,
+                            prepare_thread, queue, pool))
+        break;
+
+      ++queue->thread_count;
+    }
+
+  if (!queue->thread_count)
+    return NULL;
+
+  /* Registered after the mutex and the condition, so that this runs
+     before they are destroyed. */
+  apr_pool_cleanup_register(pool, queue, stop_prepare_threads,
+                            apr_pool_cleanup_null);
+  return queue;
+}
+
+/* Determine the properties of file LOCAL_ABSPATH with DIRENT, to be
+   imported, and return them in a new prepared_file_t in *PREPARED_P,
+   allocated in a new root pool. */
+static svn_error_t *
+get_file_properties(prepared_file_t **prepared_p,
+                    const char *local_abspath,
+                    const svn_io_dirent2_t *dirent,
+                    import_ctx_t *import_ctx,
+                    svn_client_ctx_t *ctx,
+                    apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  prepared_file_t *prepared = apr_pcalloc(pool, sizeof(*prepared));
+  svn_error_t *err = SVN_NO_ERROR;
+
+  prepared->pool = pool;
+  prepared->local_abspath = apr_pstrdup(pool, local_abspath);
+
+  if (! dirent->special)
+    {
+      /* add automatic properties */
+      err = svn_client__get_paths_auto_props(&prepared->properties,
+                                             &prepared->mimetype,
+                                             local_abspath,
+                                             import_ctx->magic_cookie,
+                                             import_ctx->autoprops,
+                                             ctx, pool, scratch_pool);
+    }
+  else
+    prepared->properties = apr_hash_make(pool);
+
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  *prepared_p = prepared;
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
 
 /* Import file PATH as EDIT_PATH in the repository directory indicated
  * by DIR_BATON in EDITOR.
@@ -214,6 +613,10 @@ send_file_contents(svn_checksum_t **result_md5_checksum_p,
  * If CTX->NOTIFY_FUNC is non-null, invoke it with CTX->NOTIFY_BATON
  * for each file.
  *
+ * If PREPARED is not NULL, it holds the properties of the file, as
+ * returned by get_file_properties(), and has been submitted to the
+ * prepare queue of IMPORT_CTX.  Send the text delta computed there.
+ *
  * Use POOL for any temporary allocation.
  */
 static svn_error_t *
@@ -222,6 +625,7 @@ import_file(const svn_delta_editor_t *editor,
             const char *local_abspath,
             const char *edit_path,
             const svn_io_dirent2_t *dirent,
+            prepared_file_t *prepared,
             import_ctx_t *import_ctx,
             svn_client_ctx_t *ctx,
             apr_pool_t *pool)
@@ -242,7 +646,12 @@ import_file(const svn_delta_editor_t *editor,
   /* Remember that the repository was modified */
   import_ctx->repos_changed = TRUE;
 
-  if (! dirent->special)
+  if (prepared)
+    {
+      properties = prepared->properties;
+      mimetype = prepared->mimetype;
+    }
+  else if (! dirent->special)
     {
       /* add automatic properties */
       SVN_ERR(svn_client__get_paths_auto_props(&properties, &mimetype,
@@ -292,8 +701,20 @@ import_file(const svn_delta_editor_t *editor,
     }
 
   /* Now, transmit the file contents. */
-  SVN_ERR(send_file_contents(&result_md5_checksum, local_abspath,
-                             file_baton, editor, properties, pool));
+#if APR_HAS_THREADS
+  if (prepared)
+    {
+      SVN_ERR(wait_for_prepared_file(import_ctx->prepare_queue, prepared,
+                                     pool));
+      SVN_ERR(editor->apply_textdelta_stream(editor, file_baton, NULL,
+                                             open_prepared_txdelta_stream,
+                                             prepared, pool));
+      result_md5_checksum = prepared->md5_checksum;
+    }
+  else
+#endif
+    SVN_ERR(send_file_contents(&result_md5_checksum, local_abspath,
+                               file_baton, editor, properties, pool));
 
   /* Finally, close the file. */
   text_checksum = svn_checksum_to_cstring(result_md5_checksum, pool);
@@ -419,6 +840,37 @@ import_dir(const svn_delta_editor_t *editor,
            svn_client_ctx_t *ctx,
            apr_pool_t *pool);
 
+#if APR_HAS_THREADS
+/* The files of one directory submitted to a prepare queue. */
+typedef struct lookahead_t
+{
+  prepare_queue_t *queue;
+
+  /* COUNT entries, one per child in import order.  Non-NULL for files
+     submitted to QUEUE but not imported yet. */
+  prepared_file_t **files;
+  int count;
+} lookahead_t;
+
+/* Discard the files of the lookahead_t at DATA that have not been
+   imported.  Implements apr_pool_cleanup_t. */
+static apr_status_t
+discard_lookahead(void *data)
+{
+  lookahead_t *lookahead = data;
+  int i;
+
+  for (i = 0; i < lookahead->count; i++)
+    if (lookahead->files[i])
+      {
+        discard_prepared_file(lookahead->queue, lookahead->files[i]);
+        lookahead->files[i] = NULL;
+      }
+
+  return APR_SUCCESS;
+}
+#endif
+
 
 /* Import the children of DIR_ABSPATH, with other arguments similar to
  * import_dir(). */
@@ -443,9 +895,29 @@ import_children(const char *dir_abspath,
   apr_array_header_t *sorted_dirents;
   int i;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err;
+#if APR_HAS_THREADS
+  lookahead_t *lookahead = NULL;
+  int ahead = 0;
+#endif
 
   sorted_dirents = svn_sort__hash(dirents, svn_sort_compare_items_lexically,
                                   scratch_pool);
+
+#if APR_HAS_THREADS
+  if (import_ctx->prepare_queue && depth >= svn_depth_files)
+    {
+      lookahead = apr_pcalloc(scratch_pool, sizeof(*lookahead));
+      lookahead->queue = import_ctx->prepare_queue;
+      lookahead->files = apr_pcalloc(scratch_pool,
+                                     sorted_dirents->nelts
+                                       * sizeof(*lookahead->files));
+      lookahead->count = sorted_dirents->nelts;
+      apr_pool_cleanup_register(scratch_pool, lookahead, discard_lookahead,
+                                apr_pool_cleanup_null);
+    }
+#endif
+
   for (i = 0; i < sorted_dirents->nelts; i++)
     {
       const char *this_abspath, *this_edit_path;
@@ -459,6 +931,32 @@ import_children(const char *dir_abspath,
       if (ctx->cancel_func)
         SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
 
+#if APR_HAS_THREADS
+      /* Let the threads read and delta the next few small files while
+         we send this one. */
+      for (; lookahead && ahead < sorted_dirents->nelts
+             && ahead <= i + PREPARE_AHEAD; ahead++)
+        {
+          svn_sort__item_t ahead_item
+            = APR_ARRAY_IDX(sorted_dirents, ahead, svn_sort__item_t);
+          const svn_io_dirent2_t *ahead_dirent = ahead_item.value;
+
+          if (ahead_dirent->kind == svn_node_file
+              && !ahead_dirent->special
+              && ahead_dirent->filesize <= PREPARE_MAX_SIZE)
+            {
+              const char *ahead_abspath
+                = svn_dirent_join(dir_abspath, ahead_item.key, iterpool);
+
+              SVN_ERR(get_file_properties(&lookahead->files[ahead],
+                                          ahead_abspath, ahead_dirent,
+                                          import_ctx, ctx, iterpool));
+              submit_prepared_file(lookahead->queue,
+                                   lookahead->files[ahead]);
+            }
+        }
+#endif
+
       /* Typically, we started importing from ".", in which case
          edit_path is "".  So below, this_path might become "./blah",
          and this_edit_path might become "blah", for example. */
@@ -480,9 +978,24 @@ import_children(const char *dir_abspath,
         }
       else if (dirent->kind == svn_node_file && depth >= svn_depth_files)
         {
-          SVN_ERR(import_file(editor, dir_baton, this_abspath,
-                              this_edit_path, dirent,
-                              import_ctx, ctx, iterpool));
+          prepared_file_t *prepared = NULL;
+
+#if APR_HAS_THREADS
+          if (lookahead)
+            {
+              prepared = lookahead->files[i];
+              lookahead->files[i] = NULL;
+            }
+#endif
+
+          err = import_file(editor, dir_baton, this_abspath,
+                            this_edit_path, dirent, prepared,
+                            import_ctx, ctx, iterpool);
+#if APR_HAS_THREADS
+          if (prepared)
+            discard_prepared_file(import_ctx->prepare_queue, prepared);
+#endif
+          SVN_ERR(err);
         }
       else if (dirent->kind != svn_node_dir && dirent->kind != svn_node_file)
         {
@@ -692,6 +1205,9 @@ import(svn_boolean_t *updated_repository,
 
   import_ctx.autoprops = autoprops;
   SVN_ERR(svn_magic__init(&import_ctx.magic_cookie, ctx->config, pool));
+#if APR_HAS_THREADS
+  import_ctx.prepare_queue = start_prepare_threads(pool);
+#endif
 
   /* Get a root dir baton.  We pass the revnum we used for testing our
      assumptions and obtaining inherited properties. */
@@ -757,7 +1273,7 @@ import(svn_boolean_t *updated_repository,
 
       if (!ignores_match)
         SVN_ERR(import_file(editor, root_baton, local_abspath, edit_path,
-                            dirent, &import_ctx, ctx, pool));
+                            dirent, NULL, &import_ctx, ctx, pool));
     }
   else if (dirent->kind == svn_node_dir)
     {
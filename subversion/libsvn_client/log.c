@@ -41,6 +41,7 @@
 
 #include "svn_private_config.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_ra_private.h"
 
 #include <assert.h>
 
@@ -635,7 +636,8 @@ compare_rev_to_segment(const void *key_p,
 
    The TARGETS, LIMIT, DISCOVER_CHANGED_PATHS, STRICT_NODE_HISTORY,
    INCLUDE_MERGED_REVISIONS, REVPROPS, REAL_RECEIVER, and REAL_RECEIVER_BATON
-   parameters are all as per the svn_client_log5 API. */
+   parameters are all as per the svn_client_log5 API.  SEARCH_PATTERNS is
+   as per svn_client__log_search. */
 static svn_error_t *
 run_ra_get_log(apr_array_header_t *revision_ranges,
                apr_array_header_t *paths,
@@ -649,6 +651,7 @@ run_ra_get_log(apr_array_header_t *revision_ranges,
                svn_boolean_t strict_node_history,
                svn_boolean_t include_merged_revisions,
                const apr_array_header_t *revprops,
+               const apr_array_header_t *search_patterns,
                svn_log_entry_receiver_t real_receiver,
                void *real_receiver_baton,
                svn_client_ctx_t *ctx,
@@ -658,11 +661,24 @@ run_ra_get_log(apr_array_header_t *revision_ranges,
   pre_15_receiver_baton_t rb = {0};
   apr_pool_t *iterpool;
   svn_boolean_t has_log_revprops;
+  svn_client__log_cache_t *log_cache = NULL;
 
   SVN_ERR(svn_ra_has_capability(ra_session, &has_log_revprops,
                                 SVN_RA_CAPABILITY_LOG_REVPROPS,
                                 scratch_pool));
 
+  /* Only let the server filter if it does not change what LIMIT counts:
+     the limit_receiver() used for multiple ranges counts the revisions it
+     receives, while the server counts all revisions it examines. */
+  if (!has_log_revprops || revision_ranges->nelts > 1
+      || include_merged_revisions)
+    search_patterns = NULL;
+
+  /* The cache can't filter by SEARCH_PATTERNS. */
+  if (has_log_revprops && !search_patterns)
+    SVN_ERR(svn_client__log_cache_open(&log_cache, ra_session, ctx,
+                                       scratch_pool, scratch_pool));
+
   if (!has_log_revprops)
     {
       /* See above pre-1.5 notes. */
@@ -806,18 +822,46 @@ run_ra_get_log(apr_array_header_t *revision_ranges,
           passed_receiver_baton = &lb;
         }
 
-      SVN_ERR(svn_ra_get_log2(ra_session,
-                              paths,
-                              range->range_start,
-                              range->range_end,
-                              limit,
-                              discover_changed_paths,
-                              strict_node_history,
-                              include_merged_revisions,
-                              passed_receiver_revprops,
-                              passed_receiver,
-                              passed_receiver_baton,
-                              iterpool));
+      if (search_patterns)
+        SVN_ERR(svn_ra__get_log_search(ra_session,
+                                       paths,
+                                       range->range_start,
+                                       range->range_end,
+                                       limit,
+                                       discover_changed_paths,
+                                       strict_node_history,
+                                       passed_receiver_revprops,
+                                       search_patterns,
+                                       passed_receiver,
+                                       passed_receiver_baton,
+                                       iterpool));
+      else if (log_cache)
+        SVN_ERR(svn_client__log_cache_get_log(log_cache,
+                                              ra_session,
+                                              paths,
+                                              range->range_start,
+                                              range->range_end,
+                                              limit,
+                                              discover_changed_paths,
+                                              strict_node_history,
+                                              include_merged_revisions,
+                                              passed_receiver_revprops,
+                                              passed_receiver,
+                                              passed_receiver_baton,
+                                              iterpool));
+      else
+        SVN_ERR(svn_ra_get_log2(ra_session,
+                                paths,
+                                range->range_start,
+                                range->range_end,
+                                limit,
+                                discover_changed_paths,
+                                strict_node_history,
+                                include_merged_revisions,
+                                passed_receiver_revprops,
+                                passed_receiver,
+                                passed_receiver_baton,
+                                iterpool));
 
       if (limit && revision_ranges->nelts > 1)
         {
@@ -833,21 +877,21 @@ run_ra_get_log(apr_array_header_t *revision_ranges,
   return SVN_NO_ERROR;
 }
 
-/*** Public Interface. ***/
-
-svn_error_t *
-svn_client_log5(const apr_array_header_t *targets,
-                const svn_opt_revision_t *peg_revision,
-                const apr_array_header_t *opt_rev_ranges,
-                int limit,
-                svn_boolean_t discover_changed_paths,
-                svn_boolean_t strict_node_history,
-                svn_boolean_t include_merged_revisions,
-                const apr_array_header_t *revprops,
-                svn_log_entry_receiver_t real_receiver,
-                void *real_receiver_baton,
-                svn_client_ctx_t *ctx,
-                apr_pool_t *pool)
+/* Implement svn_client_log5() and svn_client__log_search(). */
+static svn_error_t *
+client_log(const apr_array_header_t *targets,
+           const svn_opt_revision_t *peg_revision,
+           const apr_array_header_t *opt_rev_ranges,
+           int limit,
+           svn_boolean_t discover_changed_paths,
+           svn_boolean_t strict_node_history,
+           svn_boolean_t include_merged_revisions,
+           const apr_array_header_t *revprops,
+           const apr_array_header_t *search_patterns,
+           svn_log_entry_receiver_t real_receiver,
+           void *real_receiver_baton,
+           svn_client_ctx_t *ctx,
+           apr_pool_t *pool)
 {
   svn_ra_session_t *ra_session;
   const char *old_session_url;
@@ -944,7 +988,56 @@ svn_client_log5(const apr_array_header_t *targets,
                          actual_loc, ra_session, targets, limit,
                          discover_changed_paths, strict_node_history,
                          include_merged_revisions, revprops,
+                         search_patterns,
                          real_receiver, real_receiver_baton, ctx, pool));
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_client__log_search(const apr_array_header_t *targets,
+                       const svn_opt_revision_t *peg_revision,
+                       const apr_array_header_t *opt_rev_ranges,
+                       int limit,
+                       svn_boolean_t discover_changed_paths,
+                       svn_boolean_t strict_node_history,
+                       svn_boolean_t include_merged_revisions,
+                       const apr_array_header_t *revprops,
+                       const apr_array_header_t *search_patterns,
+                       svn_log_entry_receiver_t real_receiver,
+                       void *real_receiver_baton,
+                       svn_client_ctx_t *ctx,
+                       apr_pool_t *pool)
+{
+  return svn_error_trace(client_log(targets, peg_revision, opt_rev_ranges,
+                                    limit, discover_changed_paths,
+                                    strict_node_history,
+                                    include_merged_revisions, revprops,
+                                    search_patterns,
+                                    real_receiver, real_receiver_baton,
+                                    ctx, pool));
+}
+
+/*** Public Interface. ***/
+
+svn_error_t *
+svn_client_log5(const apr_array_header_t *targets,
+                const svn_opt_revision_t *peg_revision,
+                const apr_array_header_t *opt_rev_ranges,
+                int limit,
+                svn_boolean_t discover_changed_paths,
+                svn_boolean_t strict_node_history,
+                svn_boolean_t include_merged_revisions,
+                const apr_array_header_t *revprops,
+                svn_log_entry_receiver_t real_receiver,
+                void *real_receiver_baton,
+                svn_client_ctx_t *ctx,
+                apr_pool_t *pool)
+{
+  return svn_error_trace(client_log(targets, peg_revision, opt_rev_ranges,
+                                    limit, discover_changed_paths,
+                                    strict_node_history,
+                                    include_merged_revisions, revprops, NULL,
+                                    real_receiver, real_receiver_baton,
+                                    ctx, pool));
+}
@@ -0,0 +1,624 @@
+/*
+ * log_cache.c:  a persistent client-side cache of log entries
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* The cache lives in the "log-cache" directory of the user's runtime
+ * configuration area, with one sub-directory per repository UUID.  It
+ * holds one file per revision with all revision properties and all
+ * changed paths of that revision, as far as the user may read them.
+ * Apart from revision properties, that data never changes.
+ *
+ * Which revisions a log request returns depends on the history of the
+ * requested paths, so we still ask the server for that; but without any
+ * revision properties or changed paths, which make up most of the data.
+ * Revisions not found in the cache get fetched from the repository root,
+ * a run of nearby revisions at a time, and stored for later requests.
+ */
+
+#include <apr_strings.h>
+
+#include "svn_pools.h"
+#include "svn_client.h"
+#include "svn_config.h"
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_props.h"
+#include "svn_ra.h"
+#include "svn_sorts.h"
+
+#include "private/svn_sorts_private.h"
+
+#include "client.h"
+
+#include "svn_private_config.h"
+
+/* Number of revisions per cache sub-directory. */
+#define LOG_CACHE_SHARD_SIZE 1000
+
+/* Missing revisions that are at most this far apart get fetched with a
+   single request, including everything between them. */
+#define LOG_CACHE_MAX_GAP 100
+
+/* Key prefixes used in the cache files. */
+#define REVPROP_PREFIX "P "
+#define CHANGED_PATH_PREFIX "C "
+
+struct svn_client__log_cache_t
+{
+  /* The cache directory of the repository. */
+  const char *dir_abspath;
+};
+
+/* The cached data of one revision. */
+typedef struct cached_rev_t
+{
+  /* const char * name -> svn_string_t * value */
+  apr_hash_t *revprops;
+
+  /* const char * path -> svn_log_changed_path2_t * */
+  apr_hash_t *changed_paths;
+} cached_rev_t;
+
+/* A log entry as returned by the server without any revprops or
+   changed paths. */
+typedef struct skeleton_entry_t
+{
+  svn_revnum_t revision;
+  svn_boolean_t has_children;
+  svn_boolean_t non_inheritable;
+  svn_boolean_t subtractive_merge;
+} skeleton_entry_t;
+
+/* Set *DIR_ABSPATH to the log cache directory of the repository with
+   REPOS_UUID, as configured for CTX, or to NULL if there is none. */
+static svn_error_t *
+get_cache_dir(const char **dir_abspath,
+              const char *repos_uuid,
+              svn_client_ctx_t *ctx,
+              apr_pool_t *result_pool)
+{
+  const char *config_dir = NULL;
+  const char *cache_dir;
+
+  if (ctx->auth_baton)
+    config_dir = svn_auth_get_parameter(ctx->auth_baton,
+                                        SVN_AUTH_PARAM_CONFIG_DIR);
+
+  SVN_ERR(svn_config_get_user_config_path(&cache_dir, config_dir,
+                                          "log-cache", result_pool));
+  if (cache_dir)
+    *dir_abspath = svn_dirent_join(cache_dir, repos_uuid, result_pool);
+  else
+    *dir_abspath = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the cache file of REVISION in CACHE_DIR_ABSPATH. */
+static const char *
+get_rev_fname(const char *cache_dir_abspath,
+              svn_revnum_t revision,
+              apr_pool_t *result_pool)
+{
+  return svn_dirent_join_many(result_pool, cache_dir_abspath,
+                              apr_psprintf(result_pool, "%ld",
+                                           revision / LOG_CACHE_SHARD_SIZE),
+                              apr_psprintf(result_pool, "%ld", revision),
+                              SVN_VA_NULL);
+}
+
+/* Return a word for TRISTATE that svn_tristate__from_word() accepts. */
+static const char *
+tristate_to_word(svn_tristate_t tristate)
+{
+  const char *word = svn_tristate__to_word(tristate);
+
+  return word ? word : "unknown";
+}
+
+/* Return the serialized form of CHANGE. */
+static svn_string_t *
+serialize_changed_path(const svn_log_changed_path2_t *change,
+                       apr_pool_t *result_pool)
+{
+  return svn_string_createf(result_pool, "%c %s %s %s %ld %s",
+                            change->action,
+                            svn_node_kind_to_word(change->node_kind),
+                            tristate_to_word(change->text_modified),
+                            tristate_to_word(change->props_modified),
+                            change->copyfrom_rev,
+                            change->copyfrom_path ? change->copyfrom_path
+                                                  : "");
+}
+
+/* Set *CHANGE to the changed path serialized as VALUE. */
+static svn_error_t *
+parse_changed_path(svn_log_changed_path2_t **change,
+                   const svn_string_t *value,
+                   apr_pool_t *result_pool)
+{
+  char *fields[5];
+  char *p = apr_pstrmemdup(result_pool, value->data, value->len);
+  int i;
+
+  for (i = 0; i < 5; i++)
+    {
+      char *space = strchr(p, ' ');
+
+      if (! space)
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                _("Malformed changed path in log cache"));
+      *space = '\0';
+      fields[i] = p;
+      p = space + 1;
+    }
+
+  *change = svn_log_changed_path2_create(result_pool);
+  (*change)->action = fields[0][0];
+  (*change)->node_kind = svn_node_kind_from_word(fields[1]);
+  (*change)->text_modified = svn_tristate__from_word(fields[2]);
+  (*change)->props_modified = svn_tristate__from_word(fields[3]);
+  (*change)->copyfrom_rev = SVN_STR_TO_REV(fields[4]);
+  (*change)->copyfrom_path = *p ? p : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CACHED to the data of REVISION found in CACHE, or to NULL if
+   there is none. */
+static svn_error_t *
+read_cached_rev(cached_rev_t **cached,
+                svn_client__log_cache_t *cache,
+                svn_revnum_t revision,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  apr_hash_t *hash = apr_hash_make(scratch_pool);
+  apr_hash_index_t *hi;
+  svn_stream_t *stream;
+  svn_error_t *err;
+
+  *cached = NULL;
+
+  err = svn_stream_open_readonly(&stream,
+                                 get_rev_fname(cache->dir_abspath, revision,
+                                               scratch_pool),
+                                 scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_hash_read2(hash, stream, SVN_HASH_TERMINATOR, scratch_pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  *cached = apr_pcalloc(result_pool, sizeof(**cached));
+  (*cached)->revprops = apr_hash_make(result_pool);
+  (*cached)->changed_paths = apr_hash_make(result_pool);
+
+  for (hi = apr_hash_first(scratch_pool, hash); hi; hi = apr_hash_next(hi))
+    {
+      const char *key = apr_hash_this_key(hi);
+      const svn_string_t *value = apr_hash_this_val(hi);
+
+      if (strncmp(key, REVPROP_PREFIX, sizeof(REVPROP_PREFIX) - 1) == 0)
+        {
+          svn_hash_sets((*cached)->revprops,
+                        apr_pstrdup(result_pool,
+                                    key + sizeof(REVPROP_PREFIX) - 1),
+                        svn_string_dup(value, result_pool));
+        }
+      else if (strncmp(key, CHANGED_PATH_PREFIX,
+                       sizeof(CHANGED_PATH_PREFIX) - 1) == 0)
+        {
+          svn_log_changed_path2_t *change;
+
+          SVN_ERR(parse_changed_path(&change, value, result_pool));
+          svn_hash_sets((*cached)->changed_paths,
+                        apr_pstrdup(result_pool,
+                                    key + sizeof(CHANGED_PATH_PREFIX) - 1),
+                        change);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the revprops and changed paths of LOG_ENTRY in CACHE. */
+static svn_error_t *
+write_cached_rev(svn_client__log_cache_t *cache,
+                 const svn_log_entry_t *log_entry,
+                 apr_pool_t *scratch_pool)
+{
+  apr_hash_t *hash = apr_hash_make(scratch_pool);
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(scratch_pool);
+  const char *fname = get_rev_fname(cache->dir_abspath, log_entry->revision,
+                                    scratch_pool);
+  apr_hash_index_t *hi;
+
+  if (log_entry->revprops)
+    for (hi = apr_hash_first(scratch_pool, log_entry->revprops);
+         hi;
+         hi = apr_hash_next(hi))
+      svn_hash_sets(hash,
+                    apr_pstrcat(scratch_pool, REVPROP_PREFIX,
+                                apr_hash_this_key(hi), SVN_VA_NULL),
+                    apr_hash_this_val(hi));
+
+  if (log_entry->changed_paths2)
+    for (hi = apr_hash_first(scratch_pool, log_entry->changed_paths2);
+         hi;
+         hi = apr_hash_next(hi))
+      svn_hash_sets(hash,
+                    apr_pstrcat(scratch_pool, CHANGED_PATH_PREFIX,
+                                apr_hash_this_key(hi), SVN_VA_NULL),
+                    serialize_changed_path(apr_hash_this_val(hi),
+                                           scratch_pool));
+
+  SVN_ERR(svn_hash_write2(hash, svn_stream_from_stringbuf(buf, scratch_pool),
+                          SVN_HASH_TERMINATOR, scratch_pool));
+  SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(fname,
+                                                         scratch_pool),
+                                      scratch_pool));
+
+  return svn_error_trace(svn_io_write_atomic2(fname, buf->data, buf->len,
+                                              NULL, FALSE, scratch_pool));
+}
+
+/* Baton for collect_skeleton(). */
+typedef struct skeleton_baton_t
+{
+  /* Array of skeleton_entry_t. */
+  apr_array_header_t *entries;
+} skeleton_baton_t;
+
+/* Implements svn_log_entry_receiver_t, collecting the log entries
+   into a skeleton_baton_t BATON. */
+static svn_error_t *
+collect_skeleton(void *baton,
+                 svn_log_entry_t *log_entry,
+                 apr_pool_t *pool)
+{
+  skeleton_baton_t *sb = baton;
+  skeleton_entry_t *entry = apr_array_push(sb->entries);
+
+  entry->revision = log_entry->revision;
+  entry->has_children = log_entry->has_children;
+  entry->non_inheritable = log_entry->non_inheritable;
+  entry->subtractive_merge = log_entry->subtractive_merge;
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for fill_cache(). */
+typedef struct fill_baton_t
+{
+  svn_client__log_cache_t *cache;
+
+  /* svn_revnum_t revision -> cached_rev_t *, allocated in POOL. */
+  apr_hash_t *revs;
+  apr_pool_t *pool;
+} fill_baton_t;
+
+/* Set REVISION in REVS to CACHED. */
+static void
+set_rev(apr_hash_t *revs,
+        svn_revnum_t revision,
+        cached_rev_t *cached)
+{
+  apr_pool_t *pool = apr_hash_pool_get(revs);
+  svn_revnum_t *key = apr_palloc(pool, sizeof(*key));
+
+  *key = revision;
+  apr_hash_set(revs, key, sizeof(*key), cached);
+}
+
+/* Return the entry of REVISION in REVS, or NULL. */
+static cached_rev_t *
+get_rev(apr_hash_t *revs,
+        svn_revnum_t revision)
+{
+  return apr_hash_get(revs, &revision, sizeof(revision));
+}
+
+/* Implements svn_log_entry_receiver_t, storing each log entry in the
+   cache of fill_baton_t BATON and in its REVS. */
+static svn_error_t *
+fill_cache(void *baton,
+           svn_log_entry_t *log_entry,
+           apr_pool_t *pool)
+{
+  fill_baton_t *fb = baton;
+  cached_rev_t *cached;
+  apr_hash_index_t *hi;
+
+  if (! SVN_IS_VALID_REVNUM(log_entry->revision))
+    return SVN_NO_ERROR;
+
+  cached = apr_pcalloc(fb->pool, sizeof(*cached));
+  cached->revprops = log_entry->revprops
+                   ? svn_prop_hash_dup(log_entry->revprops, fb->pool)
+                   : apr_hash_make(fb->pool);
+  cached->changed_paths = apr_hash_make(fb->pool);
+  if (log_entry->changed_paths2)
+    for (hi = apr_hash_first(pool, log_entry->changed_paths2);
+         hi;
+         hi = apr_hash_next(hi))
+      svn_hash_sets(cached->changed_paths,
+                    apr_pstrdup(fb->pool, apr_hash_this_key(hi)),
+                    svn_log_changed_path2_dup(apr_hash_this_val(hi),
+                                              fb->pool));
+  set_rev(fb->revs, log_entry->revision, cached);
+
+  /* The cache is an optimization: failing to update it is no error. */
+  svn_error_clear(write_cached_rev(fb->cache, log_entry, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch the revisions in MISSING, an array of svn_revnum_t sorted from
+   youngest to oldest, into FB, using RA_SESSION. */
+static svn_error_t *
+fetch_missing_revs(fill_baton_t *fb,
+                   const apr_array_header_t *missing,
+                   svn_ra_session_t *ra_session,
+                   apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *root_paths = apr_array_make(scratch_pool, 1,
+                                                  sizeof(const char *));
+  const char *repos_root_url;
+  const char *old_session_url;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i = 0;
+
+  APR_ARRAY_PUSH(root_paths, const char *) = "";
+
+  SVN_ERR(svn_ra_get_repos_root2(ra_session, &repos_root_url, scratch_pool));
+  SVN_ERR(svn_client__ensure_ra_session_url(&old_session_url, ra_session,
+                                            repos_root_url, scratch_pool));
+
+  while (i < missing->nelts)
+    {
+      svn_revnum_t youngest = APR_ARRAY_IDX(missing, i, svn_revnum_t);
+      svn_revnum_t oldest = youngest;
+
+      svn_pool_clear(iterpool);
+
+      for (++i; i < missing->nelts; ++i)
+        {
+          svn_revnum_t rev = APR_ARRAY_IDX(missing, i, svn_revnum_t);
+
+          if (oldest - rev > LOG_CACHE_MAX_GAP)
+            break;
+          oldest = rev;
+        }
+
+      SVN_ERR(svn_ra_get_log2(ra_session, root_paths, youngest, oldest, 0,
+                              TRUE, TRUE, FALSE, NULL,
+                              fill_cache, fb, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_ra_reparent(ra_session, old_session_url,
+                                         scratch_pool));
+}
+
+svn_error_t *
+svn_client__log_cache_open(svn_client__log_cache_t **cache,
+                           svn_ra_session_t *ra_session,
+                           svn_client_ctx_t *ctx,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  svn_boolean_t enabled;
+  const char *repos_uuid;
+  const char *dir_abspath;
+
+  *cache = NULL;
+
+  SVN_ERR(svn_config_get_bool(cfg, &enabled, SVN_CONFIG_SECTION_MISCELLANY,
+                              SVN_CONFIG_OPTION_LOG_CACHE, FALSE));
+  if (! enabled)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_ra_get_uuid2(ra_session, &repos_uuid, scratch_pool));
+  SVN_ERR(get_cache_dir(&dir_abspath, repos_uuid, ctx, result_pool));
+  if (! dir_abspath)
+    return SVN_NO_ERROR;
+
+  *cache = apr_pcalloc(result_pool, sizeof(**cache));
+  (*cache)->dir_abspath = dir_abspath;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_client__log_cache_get_log(svn_client__log_cache_t *cache,
+                              svn_ra_session_t *ra_session,
+                              const apr_array_header_t *paths,
+                              svn_revnum_t start,
+                              svn_revnum_t end,
+                              int limit,
+                              svn_boolean_t discover_changed_paths,
+                              svn_boolean_t strict_node_history,
+                              svn_boolean_t include_merged_revisions,
+                              const apr_array_header_t *revprops,
+                              svn_log_entry_receiver_t receiver,
+                              void *receiver_baton,
+                              apr_pool_t *scratch_pool)
+{
+  skeleton_baton_t sb;
+  fill_baton_t fb;
+  apr_array_header_t *missing;
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Nothing to save if only revision numbers are wanted. */
+  if (! discover_changed_paths && revprops && revprops->nelts == 0)
+    return svn_error_trace(svn_ra_get_log2(ra_session, paths, start, end,
+                                           limit, discover_changed_paths,
+                                           strict_node_history,
+                                           include_merged_revisions,
+                                           revprops, receiver,
+                                           receiver_baton, scratch_pool));
+
+  /* Find out which revisions to report. */
+  sb.entries = apr_array_make(scratch_pool, 16, sizeof(skeleton_entry_t));
+  SVN_ERR(svn_ra_get_log2(ra_session, paths, start, end, limit,
+                          FALSE, strict_node_history,
+                          include_merged_revisions,
+                          apr_array_make(scratch_pool, 0,
+                                         sizeof(const char *)),
+                          collect_skeleton, &sb, scratch_pool));
+
+  /* Look them up in the cache. */
+  fb.cache = cache;
+  fb.revs = apr_hash_make(scratch_pool);
+  fb.pool = scratch_pool;
+  missing = apr_array_make(scratch_pool, 0, sizeof(svn_revnum_t));
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < sb.entries->nelts; i++)
+    {
+      svn_revnum_t rev = APR_ARRAY_IDX(sb.entries, i,
+                                       skeleton_entry_t).revision;
+      cached_rev_t *cached;
+      svn_error_t *err;
+
+      if (! SVN_IS_VALID_REVNUM(rev) || get_rev(fb.revs, rev))
+        continue;
+
+      svn_pool_clear(iterpool);
+      err = read_cached_rev(&cached, cache, rev, scratch_pool, iterpool);
+      if (err)
+        {
+          /* Just fetch corrupt entries again. */
+          svn_error_clear(err);
+          cached = NULL;
+        }
+
+      if (cached)
+        set_rev(fb.revs, rev, cached);
+      else
+        APR_ARRAY_PUSH(missing, svn_revnum_t) = rev;
+    }
+
+  if (missing->nelts)
+    {
+      svn_sort__array(missing, svn_sort_compare_revisions);
+      SVN_ERR(fetch_missing_revs(&fb, missing, ra_session, scratch_pool));
+
+      /* Revisions that the root log did not return are unreadable there
+         for this user; let the server handle those requests as usual. */
+      for (i = 0; i < missing->nelts; i++)
+        if (! get_rev(fb.revs, APR_ARRAY_IDX(missing, i, svn_revnum_t)))
+          {
+            svn_pool_destroy(iterpool);
+            return svn_error_trace(svn_ra_get_log2(ra_session, paths,
+                                                   start, end, limit,
+                                                   discover_changed_paths,
+                                                   strict_node_history,
+                                                   include_merged_revisions,
+                                                   revprops, receiver,
+                                                   receiver_baton,
+                                                   scratch_pool));
+          }
+    }
+
+  /* Replay the log from the cached data. */
+  for (i = 0; i < sb.entries->nelts; i++)
+    {
+      const skeleton_entry_t *entry = &APR_ARRAY_IDX(sb.entries, i,
+                                                     skeleton_entry_t);
+      svn_log_entry_t *log_entry;
+      cached_rev_t *cached;
+
+      svn_pool_clear(iterpool);
+
+      log_entry = svn_log_entry_create(iterpool);
+      log_entry->revision = entry->revision;
+      log_entry->has_children = entry->has_children;
+      log_entry->non_inheritable = entry->non_inheritable;
+      log_entry->subtractive_merge = entry->subtractive_merge;
+
+      cached = SVN_IS_VALID_REVNUM(entry->revision)
+               ? get_rev(fb.revs, entry->revision) : NULL;
+      if (cached)
+        {
+          if (revprops)
+            {
+              int j;
+
+              log_entry->revprops = apr_hash_make(iterpool);
+              for (j = 0; j < revprops->nelts; j++)
+                {
+                  const char *name = APR_ARRAY_IDX(revprops, j,
+                                                   const char *);
+                  svn_string_t *value = svn_hash_gets(cached->revprops,
+                                                      name);
+
+                  if (value)
+                    svn_hash_sets(log_entry->revprops, name, value);
+                }
+            }
+          else
+            log_entry->revprops = cached->revprops;
+
+          if (discover_changed_paths)
+            {
+              log_entry->changed_paths2 = cached->changed_paths;
+              log_entry->changed_paths = cached->changed_paths;
+            }
+        }
+
+      SVN_ERR(receiver(receiver_baton, log_entry, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_client__log_cache_invalidate(svn_ra_session_t *ra_session,
+                                 svn_revnum_t revision,
+                                 svn_client_ctx_t *ctx,
+                                 apr_pool_t *scratch_pool)
+{
+  const char *repos_uuid;
+  const char *dir_abspath;
+
+  SVN_ERR(svn_ra_get_uuid2(ra_session, &repos_uuid, scratch_pool));
+  SVN_ERR(get_cache_dir(&dir_abspath, repos_uuid, ctx, scratch_pool));
+  if (! dir_abspath)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_io_remove_file2(get_rev_fname(dir_abspath,
+                                                           revision,
+                                                           scratch_pool),
+                                             TRUE, scratch_pool));
+}
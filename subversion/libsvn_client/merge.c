@@ -236,6 +236,11 @@ typedef struct merge_cmd_baton_t {
                                          merge or not. */
   const merge_target_t *target;       /* Description of merge target node */
 
+  /* Repository mergeinfo of the merge target's tree, shared by all the
+     subtrees whose mergeinfo must be fetched from the repository.  NULL
+     if the target is locally added. */
+  svn_client__repos_mergeinfo_cache_t *mergeinfo_cache;
+
   /* The left and right URLs and revs.  The value of this field changes to
      reflect the merge_source_t *currently* being merged by do_merge(). */
   merge_source_t merge_source;
@@ -4210,6 +4215,10 @@ fix_deleted_subtree_ranges(const merge_source_t *source,
    RA_SESSION is an RA session open to the repository in which TARGET_ABSPATH
    lives.  It may be temporarily reparented as needed by this function.
 
+   MERGEINFO_CACHE, if not NULL, is used to look up inherited repository
+   mergeinfo for *RECORDED_MERGEINFO, see
+   svn_client__get_wc_or_repos_mergeinfo().
+
    Allocate *RECORDED_MERGEINFO and *IMPLICIT_MERGEINFO in RESULT_POOL.
    Use SCRATCH_POOL for any temporary allocations. */
 static svn_error_t *
@@ -4218,6 +4227,7 @@ get_full_mergeinfo(svn_mergeinfo_t *recorded_mergeinfo,
                    svn_boolean_t *inherited,
                    svn_mergeinfo_inheritance_t inherit,
                    svn_ra_session_t *ra_session,
+                   svn_client__repos_mergeinfo_cache_t *mergeinfo_cache,
                    const char *target_abspath,
                    svn_revnum_t start,
                    svn_revnum_t end,
@@ -4233,6 +4243,7 @@ get_full_mergeinfo(svn_mergeinfo_t *recorded_mergeinfo,
                                                     NULL /* from_repos */,
                                                     FALSE,
                                                     inherit, ra_session,
+                                                    mergeinfo_cache,
                                                     target_abspath,
                                                     ctx, result_pool));
     }
@@ -4323,7 +4334,7 @@ inherit_implicit_mergeinfo_from_parent(svn_client__merge_path_t *parent,
   if (!parent->implicit_mergeinfo)
     SVN_ERR(get_full_mergeinfo(NULL, &(parent->implicit_mergeinfo),
                                NULL, svn_mergeinfo_inherited,
-                               ra_session, child->abspath,
+                               ra_session, NULL, child->abspath,
                                MAX(revision1, revision2),
                                MIN(revision1, revision2),
                                ctx, result_pool, scratch_pool));
@@ -4388,7 +4399,7 @@ ensure_implicit_mergeinfo(svn_client__merge_path_t *parent,
     SVN_ERR(get_full_mergeinfo(NULL,
                                &(child->implicit_mergeinfo),
                                NULL, svn_mergeinfo_inherited,
-                               ra_session, child->abspath,
+                               ra_session, NULL, child->abspath,
                                MAX(revision1, revision2),
                                MIN(revision1, revision2),
                                ctx, result_pool, scratch_pool));
@@ -5026,7 +5037,7 @@ populate_remaining_ranges(apr_array_header_t *children_with_mergeinfo,
                                          &(child->implicit_mergeinfo),
                                          NULL, /* child->inherited_mergeinfo */
                                          svn_mergeinfo_inherited, ra_session,
-                                         child->abspath,
+                                         NULL, child->abspath,
                                          MAX(source->loc1->rev,
                                              source->loc2->rev),
                                          MIN(source->loc1->rev,
@@ -5131,7 +5142,7 @@ populate_remaining_ranges(apr_array_header_t *children_with_mergeinfo,
         (i == 0) ? &(child->implicit_mergeinfo) : NULL,
         &(child->inherited_mergeinfo),
         svn_mergeinfo_inherited, ra_session,
-        child->abspath,
+        merge_b->mergeinfo_cache, child->abspath,
         MAX(source->loc1->rev, source->loc2->rev),
         MIN(source->loc1->rev, source->loc2->rev),
         merge_b->ctx, result_pool, iterpool));
@@ -5765,8 +5776,7 @@ drive_merge_report_editor(const char *target_abspath,
                                        source->loc1->rev,
                                        TRUE /* text_deltas */,
                                        processor,
-                                       merge_b->ctx->cancel_func,
-                                       merge_b->ctx->cancel_baton,
+                                       merge_b->ctx,
                                        scratch_pool));
   SVN_ERR(svn_ra_do_diff3(merge_b->ra_session1,
                           &reporter, &report_baton, source->loc2->rev,
@@ -7491,7 +7501,8 @@ do_file_merge(svn_mergeinfo_catalog_t result_catalog,
       err = get_full_mergeinfo(&target_mergeinfo,
                                &(merge_target->implicit_mergeinfo),
                                &inherited, svn_mergeinfo_inherited,
-                               merge_b->ra_session1, target_abspath,
+                               merge_b->ra_session1,
+                               merge_b->mergeinfo_cache, target_abspath,
                                MAX(source->loc1->rev, source->loc2->rev),
                                MIN(source->loc1->rev, source->loc2->rev),
                                ctx, scratch_pool, iterpool);
@@ -7899,7 +7910,7 @@ process_children_with_new_mergeinfo(merge_cmd_baton_t *merge_b,
             NULL, NULL,
             FALSE,
             svn_mergeinfo_nearest_ancestor, /* We only want inherited MI */
-            merge_b->ra_session2,
+            merge_b->ra_session2, NULL,
             abspath_with_new_mergeinfo,
             merge_b->ctx,
             iterpool));
@@ -9868,6 +9879,14 @@ do_merge(apr_hash_t **modified_subtrees,
   merge_cmd_baton.ctx = ctx;
   merge_cmd_baton.reintegrate_merge = reintegrate_merge;
   merge_cmd_baton.target = target;
+  merge_cmd_baton.mergeinfo_cache = NULL;
+  if (target->loc.url)
+    merge_cmd_baton.mergeinfo_cache
+      = svn_client__repos_mergeinfo_cache_create(
+          target->loc.repos_root_url,
+          svn_uri_skip_ancestor(target->loc.repos_root_url, target->loc.url,
+                                scratch_pool),
+          target->loc.rev, scratch_pool);
   merge_cmd_baton.pool = iterpool;
   merge_cmd_baton.merge_options = merge_options;
   merge_cmd_baton.diff3_cmd = diff3_cmd;
@@ -9972,25 +9991,38 @@ do_merge(apr_hash_t **modified_subtrees,
        * done. */
       do
         {
+          svn_error_t *err;
+
+          /* The merge reads the same nodes over and over.  Unless this is
+           * a dry run, our caller holds the write lock, so let the working
+           * copy answer those reads from memory until it is modified. */
+          if (! dry_run)
+            svn_wc__read_cache_begin(ctx->wc_ctx);
+
           /* Merge as far as possible without resolving any conflicts */
           if (src1_kind != svn_node_dir)
             {
-              SVN_ERR(do_file_merge(result_catalog, &conflicted_range_report,
-                                    source, target->abspath,
-                                    processor,
-                                    sources_related,
-                                    squelch_mergeinfo_notifications,
-                                    &merge_cmd_baton, iterpool, iterpool));
+              err = do_file_merge(result_catalog, &conflicted_range_report,
+                                  source, target->abspath,
+                                  processor,
+                                  sources_related,
+                                  squelch_mergeinfo_notifications,
+                                  &merge_cmd_baton, iterpool, iterpool);
             }
           else /* Directory */
             {
-              SVN_ERR(do_directory_merge(result_catalog, &conflicted_range_report,
-                                         source, target->abspath,
-                                         processor,
-                                         depth, squelch_mergeinfo_notifications,
-                                         &merge_cmd_baton, iterpool, iterpool));
+              err = do_directory_merge(result_catalog,
+                                       &conflicted_range_report,
+                                       source, target->abspath,
+                                       processor,
+                                       depth, squelch_mergeinfo_notifications,
+                                       &merge_cmd_baton, iterpool, iterpool);
             }
 
+          if (! dry_run)
+            svn_wc__read_cache_end(ctx->wc_ctx);
+          SVN_ERR(err);
+
           /* Give the conflict resolver callback the opportunity to
            * resolve any conflicts that were raised.  If it resolves all
            * of them, go around again to merge the next sub-range (if any). */
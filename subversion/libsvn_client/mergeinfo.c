@@ -550,6 +550,130 @@ svn_client__get_repos_mergeinfo_catalog(svn_mergeinfo_catalog_t *mergeinfo_cat,
   return SVN_NO_ERROR;
 }
 
+struct svn_client__repos_mergeinfo_cache_t
+{
+  /* The tree whose mergeinfo is cached. */
+  const char *repos_root_url;
+  const char *root_relpath;
+  svn_revnum_t rev;
+
+  /* TRUE once CATALOG has been fetched from the repository. */
+  svn_boolean_t fetched;
+
+  /* The mergeinfo of ROOT_RELPATH (explicit or inherited) and the explicit
+     mergeinfo of all its subtrees, keyed by repository root-relative
+     path.  May be NULL if there is none. */
+  svn_mergeinfo_catalog_t catalog;
+
+  /* Pool for CATALOG. */
+  apr_pool_t *pool;
+};
+
+svn_client__repos_mergeinfo_cache_t *
+svn_client__repos_mergeinfo_cache_create(const char *repos_root_url,
+                                         const char *root_relpath,
+                                         svn_revnum_t rev,
+                                         apr_pool_t *result_pool)
+{
+  svn_client__repos_mergeinfo_cache_t *cache
+    = apr_pcalloc(result_pool, sizeof(*cache));
+
+  cache->repos_root_url = apr_pstrdup(result_pool, repos_root_url);
+  cache->root_relpath = apr_pstrdup(result_pool, root_relpath);
+  cache->rev = rev;
+  cache->pool = result_pool;
+
+  return cache;
+}
+
+/* Set *MERGEINFO_CAT to the inherited mergeinfo of REPOS_RELPATH@REV in
+   the repository at REPOS_ROOT_URL, keyed by REPOS_RELPATH, the way
+   svn_client__get_repos_mergeinfo_catalog() would return it for
+   svn_mergeinfo_inherited without descendants.  Derive it from CACHE,
+   fetching CACHE's catalog through RA_SESSION first if necessary.
+
+   Set *HANDLED to FALSE and leave *MERGEINFO_CAT untouched if CACHE does
+   not cover REPOS_RELPATH@REV, otherwise set it to TRUE.
+
+   Allocate *MERGEINFO_CAT in RESULT_POOL.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+get_cached_repos_mergeinfo(svn_boolean_t *handled,
+                           svn_mergeinfo_catalog_t *mergeinfo_cat,
+                           svn_client__repos_mergeinfo_cache_t *cache,
+                           svn_ra_session_t *ra_session,
+                           const char *repos_root_url,
+                           const char *repos_relpath,
+                           svn_revnum_t rev,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  const char *relpath;
+  svn_mergeinfo_t mergeinfo = NULL;
+
+  *handled = FALSE;
+  if (rev != cache->rev
+      || strcmp(repos_root_url, cache->repos_root_url) != 0
+      || !svn_relpath_skip_ancestor(cache->root_relpath, repos_relpath))
+    return SVN_NO_ERROR;
+
+  if (!cache->fetched)
+    {
+      const char *url = svn_path_url_add_component2(cache->repos_root_url,
+                                                    cache->root_relpath,
+                                                    scratch_pool);
+
+      SVN_ERR(svn_client__get_repos_mergeinfo_catalog(&cache->catalog,
+                                                      ra_session, url,
+                                                      cache->rev,
+                                                      svn_mergeinfo_inherited,
+                                                      TRUE, TRUE,
+                                                      cache->pool,
+                                                      scratch_pool));
+      cache->fetched = TRUE;
+    }
+
+  *handled = TRUE;
+  *mergeinfo_cat = NULL;
+
+  /* Find the nearest path with mergeinfo, just like the repository. */
+  relpath = repos_relpath;
+  while (cache->catalog)
+    {
+      mergeinfo = svn_hash_gets(cache->catalog, relpath);
+      if (mergeinfo || strcmp(relpath, cache->root_relpath) == 0)
+        break;
+
+      relpath = svn_relpath_dirname(relpath, scratch_pool);
+    }
+
+  if (!mergeinfo)
+    return SVN_NO_ERROR;
+
+  if (strcmp(relpath, repos_relpath) != 0)
+    {
+      /* Only inheritable ranges are inherited, adjusted to the path of
+         REPOS_RELPATH below RELPATH. */
+      SVN_ERR(svn_mergeinfo_inheritable2(&mergeinfo, mergeinfo, NULL,
+                                         SVN_INVALID_REVNUM,
+                                         SVN_INVALID_REVNUM, TRUE,
+                                         scratch_pool, scratch_pool));
+      SVN_ERR(svn_mergeinfo__add_suffix_to_mergeinfo(
+                &mergeinfo, mergeinfo,
+                svn_relpath_skip_ancestor(relpath, repos_relpath),
+                result_pool, scratch_pool));
+    }
+  else
+    {
+      mergeinfo = svn_mergeinfo_dup(mergeinfo, result_pool);
+    }
+
+  *mergeinfo_cat = apr_hash_make(result_pool);
+  svn_hash_sets(*mergeinfo_cat, apr_pstrdup(result_pool, repos_relpath),
+                mergeinfo);
+
+  return SVN_NO_ERROR;
+}
 
 svn_error_t *
 svn_client__get_wc_or_repos_mergeinfo(svn_mergeinfo_t *target_mergeinfo,
@@ -558,6 +682,8 @@ svn_client__get_wc_or_repos_mergeinfo(svn_mergeinfo_t *target_mergeinfo,
                                       svn_boolean_t repos_only,
                                       svn_mergeinfo_inheritance_t inherit,
                                       svn_ra_session_t *ra_session,
+                                      svn_client__repos_mergeinfo_cache_t
+                                        *cache,
                                       const char *target_wcpath,
                                       svn_client_ctx_t *ctx,
                                       apr_pool_t *pool)
@@ -571,7 +697,7 @@ svn_client__get_wc_or_repos_mergeinfo(svn_mergeinfo_t *target_mergeinfo,
                                                         FALSE,
                                                         repos_only,
                                                         FALSE, inherit,
-                                                        ra_session,
+                                                        ra_session, cache,
                                                         target_wcpath, ctx,
                                                         pool, pool));
   if (tgt_mergeinfo_cat && apr_hash_count(tgt_mergeinfo_cat))
@@ -599,6 +725,7 @@ svn_client__get_wc_or_repos_mergeinfo_catalog(
   svn_boolean_t ignore_invalid_mergeinfo,
   svn_mergeinfo_inheritance_t inherit,
   svn_ra_session_t *ra_session,
+  svn_client__repos_mergeinfo_cache_t *cache,
   const char *target_wcpath,
   svn_client_ctx_t *ctx,
   apr_pool_t *result_pool,
@@ -680,6 +807,7 @@ svn_client__get_wc_or_repos_mergeinfo_catalog(
           if (!svn_hash_gets(original_props, SVN_PROP_MERGEINFO))
             {
               apr_pool_t *sesspool = NULL;
+              svn_boolean_t cached = FALSE;
 
               if (! ra_session)
                 {
@@ -689,11 +817,21 @@ svn_client__get_wc_or_repos_mergeinfo_catalog(
                                                       sesspool, sesspool));
                 }
 
-              SVN_ERR(svn_client__get_repos_mergeinfo_catalog(
-                        &target_mergeinfo_cat_repos, ra_session,
-                        url, target_rev, inherit,
-                        TRUE, include_descendants,
-                        result_pool, scratch_pool));
+              /* The subtrees of a merge target usually share one tree's
+                 mergeinfo, so ask CACHE rather than the repository. */
+              if (cache && inherit == svn_mergeinfo_inherited
+                  && !include_descendants)
+                SVN_ERR(get_cached_repos_mergeinfo(
+                          &cached, &target_mergeinfo_cat_repos, cache,
+                          ra_session, repos_root, repos_relpath, target_rev,
+                          result_pool, scratch_pool));
+
+              if (!cached)
+                SVN_ERR(svn_client__get_repos_mergeinfo_catalog(
+                          &target_mergeinfo_cat_repos, ra_session,
+                          url, target_rev, inherit,
+                          TRUE, include_descendants,
+                          result_pool, scratch_pool));
 
               if (target_mergeinfo_cat_repos
                   && svn_hash_gets(target_mergeinfo_cat_repos, repos_relpath))
@@ -978,7 +1116,7 @@ svn_client__elide_mergeinfo(const char *target_abspath,
           err = svn_client__get_wc_or_repos_mergeinfo(
             &mergeinfo, NULL, NULL, TRUE,
             svn_mergeinfo_nearest_ancestor,
-            NULL, target_abspath, ctx, pool);
+            NULL, NULL, target_abspath, ctx, pool);
           if (err)
             {
               if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
@@ -1093,7 +1231,7 @@ get_mergeinfo(svn_mergeinfo_catalog_t *mergeinfo_catalog,
       SVN_ERR(svn_client__get_wc_or_repos_mergeinfo_catalog(
         mergeinfo_catalog, NULL, NULL, include_descendants, FALSE,
         ignore_invalid_mergeinfo, svn_mergeinfo_inherited,
-        ra_session, path_or_url, ctx,
+        ra_session, NULL, path_or_url, ctx,
         result_pool, scratch_pool));
     }
 
@@ -2048,33 +2186,30 @@ svn_client__mergeinfo_log(svn_boolean_t finding_merged,
      logs_for_mergeinfo_rangelist). */
   if (master_inheritable_rangelist->nelts)
     {
-      for (hi = apr_hash_first(scratch_pool, inheritable_subtree_merges);
-           hi;
-           hi = apr_hash_next(hi))
-        {
-          svn_rangelist_t *deleted_rangelist;
-          svn_rangelist_t *added_rangelist;
-          svn_rangelist_t *subtree_merged_rangelist = apr_hash_this_val(hi);
-
-          svn_pool_clear(iterpool);
+      svn_rangelist_t *fully_merged_rangelist
+        = svn_rangelist_dup(master_inheritable_rangelist, scratch_pool);
+      svn_rangelist_t *deleted_rangelist;
+      svn_rangelist_t *added_rangelist;
 
-          SVN_ERR(svn_rangelist_diff(&deleted_rangelist, &added_rangelist,
-                                     master_inheritable_rangelist,
-                                     subtree_merged_rangelist, TRUE,
-                                     iterpool));
+      svn_pool_clear(iterpool);
 
-          if (deleted_rangelist->nelts)
-            {
-              svn_rangelist__set_inheritance(deleted_rangelist, FALSE);
-              SVN_ERR(svn_rangelist_merge2(master_noninheritable_rangelist,
-                                           deleted_rangelist,
-                                           scratch_pool, iterpool));
-              SVN_ERR(svn_rangelist_remove(&master_inheritable_rangelist,
-                                           deleted_rangelist,
-                                           master_inheritable_rangelist,
-                                           FALSE,
-                                           scratch_pool));
-            }
+      /* All these rangelists are inheritable, so ignoring inheritance
+         doesn't change the result. */
+      SVN_ERR(svn_rangelist__intersect_many(fully_merged_rangelist,
+                                            inheritable_subtree_merges,
+                                            FALSE, scratch_pool, iterpool));
+      SVN_ERR(svn_rangelist_diff(&deleted_rangelist, &added_rangelist,
+                                 master_inheritable_rangelist,
+                                 fully_merged_rangelist, TRUE,
+                                 iterpool));
+
+      if (deleted_rangelist->nelts)
+        {
+          svn_rangelist__set_inheritance(deleted_rangelist, FALSE);
+          SVN_ERR(svn_rangelist_merge2(master_noninheritable_rangelist,
+                                       deleted_rangelist,
+                                       scratch_pool, iterpool));
+          master_inheritable_rangelist = fully_merged_rangelist;
         }
     }
 
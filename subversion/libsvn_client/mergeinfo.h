@@ -103,6 +103,26 @@ svn_client__merge_path_t *
 svn_client__merge_path_create(const char *abspath,
                               apr_pool_t *pool);
 
+/* A cache of the repository mergeinfo of a tree at a fixed revision,
+   see svn_client__repos_mergeinfo_cache_create(). */
+typedef struct svn_client__repos_mergeinfo_cache_t
+  svn_client__repos_mergeinfo_cache_t;
+
+/* Return a new mergeinfo cache for the tree ROOT_RELPATH@REV in the
+   repository at REPOS_ROOT_URL, allocated in RESULT_POOL.
+
+   The first lookup that is not answered by the working copy fetches the
+   explicit mergeinfo of all paths within the tree (and the inherited
+   mergeinfo of its root) in a single request.  Later lookups of paths at
+   REV within the tree derive their inherited mergeinfo from that catalog
+   instead of contacting the repository again.  The catalog is kept in
+   RESULT_POOL. */
+svn_client__repos_mergeinfo_cache_t *
+svn_client__repos_mergeinfo_cache_create(const char *repos_root_url,
+                                         const char *root_relpath,
+                                         svn_revnum_t rev,
+                                         apr_pool_t *result_pool);
+
 
 
 /*** Functions ***/
@@ -230,6 +250,10 @@ svn_client__get_repos_mergeinfo_catalog(svn_mergeinfo_catalog_t *mergeinfo_cat,
    temporarily reparented.  If RA_SESSION is NULL, then a temporary session
    is opened as needed.
 
+   If CACHE is not NULL and covers TARGET_WCPATH's repository location,
+   inherited mergeinfo is taken from CACHE rather than being requested
+   for TARGET_WCPATH alone.
+
    Store any mergeinfo obtained for TARGET_WCPATH in
    *TARGET_MERGEINFO, if no mergeinfo is found *TARGET_MERGEINFO is
    NULL.
@@ -255,6 +279,8 @@ svn_client__get_wc_or_repos_mergeinfo(svn_mergeinfo_t *target_mergeinfo,
                                       svn_boolean_t repos_only,
                                       svn_mergeinfo_inheritance_t inherit,
                                       svn_ra_session_t *ra_session,
+                                      svn_client__repos_mergeinfo_cache_t
+                                        *cache,
                                       const char *target_wcpath,
                                       svn_client_ctx_t *ctx,
                                       apr_pool_t *pool);
@@ -284,6 +310,7 @@ svn_client__get_wc_or_repos_mergeinfo_catalog(
   svn_boolean_t ignore_invalid_mergeinfo,
   svn_mergeinfo_inheritance_t inherit,
   svn_ra_session_t *ra_session,
+  svn_client__repos_mergeinfo_cache_t *cache,
   const char *target_wcpath,
   svn_client_ctx_t *ctx,
   apr_pool_t *result_pool,
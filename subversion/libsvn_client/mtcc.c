@@ -30,6 +30,7 @@
 #include "svn_subst.h"
 
 #include "private/svn_client_mtcc.h"
+#include "private/svn_ra_private.h"
 
 
 #include "svn_private_config.h"
@@ -88,6 +89,10 @@ struct svn_client__mtcc_t
   svn_ra_session_t *ra_session;
   svn_client_ctx_t *ctx;
 
+  /* Kinds of the repository nodes looked up so far, mapping
+     "REV:RELPATH", relative to the session URL, to svn_node_kind_t *. */
+  apr_hash_t *repos_kinds;
+
   mtcc_op_t *root_op;
 };
 
@@ -323,6 +328,76 @@ mtcc_get_origin(const char **origin_relpath,
   return SVN_NO_ERROR;
 }
 
+/* Return the cached kind of RELPATH in REVISION of the repository of
+   MTCC, or NULL if it has not been looked up yet. */
+static const svn_node_kind_t *
+repos_kind_get(svn_client__mtcc_t *mtcc,
+               const char *relpath,
+               svn_revnum_t revision,
+               apr_pool_t *scratch_pool)
+{
+  return svn_hash_gets(mtcc->repos_kinds,
+                       apr_psprintf(scratch_pool, "%ld:%s",
+                                    revision, relpath));
+}
+
+/* Cache KIND as the kind of RELPATH in REVISION of the repository of
+   MTCC. */
+static void
+repos_kind_set(svn_client__mtcc_t *mtcc,
+               const char *relpath,
+               svn_revnum_t revision,
+               svn_node_kind_t kind)
+{
+  svn_node_kind_t *cached = apr_palloc(mtcc->pool, sizeof(*cached));
+
+  *cached = kind;
+  svn_hash_sets(mtcc->repos_kinds,
+                apr_psprintf(mtcc->pool, "%ld:%s", revision, relpath),
+                cached);
+}
+
+/* Like svn_ra_check_path() on the session of MTCC, but remember the
+   result.  Below a node that is known to be a file or not to exist,
+   nothing exists, without asking the repository. */
+static svn_error_t *
+mtcc_repos_kind(svn_node_kind_t *kind,
+                svn_client__mtcc_t *mtcc,
+                const char *relpath,
+                svn_revnum_t revision,
+                apr_pool_t *scratch_pool)
+{
+  const svn_node_kind_t *cached;
+  const char *ancestor = relpath;
+
+  cached = repos_kind_get(mtcc, relpath, revision, scratch_pool);
+  if (cached)
+    {
+      *kind = *cached;
+      return SVN_NO_ERROR;
+    }
+
+  while (*ancestor)
+    {
+      ancestor = svn_relpath_dirname(ancestor, scratch_pool);
+      cached = repos_kind_get(mtcc, ancestor, revision, scratch_pool);
+
+      if (cached && *cached != svn_node_dir)
+        {
+          *kind = svn_node_none;
+          return SVN_NO_ERROR;
+        }
+      else if (cached)
+        break;
+    }
+
+  SVN_ERR(svn_ra_check_path(mtcc->ra_session, relpath, revision, kind,
+                            scratch_pool));
+  repos_kind_set(mtcc, relpath, revision, *kind);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_client__mtcc_create(svn_client__mtcc_t **mtcc,
                         const char *anchor_url,
@@ -341,6 +416,7 @@ svn_client__mtcc_create(svn_client__mtcc_t **mtcc,
   (*mtcc)->root_op = mtcc_op_create(NULL, FALSE, TRUE, mtcc_pool);
 
   (*mtcc)->ctx = ctx;
+  (*mtcc)->repos_kinds = apr_hash_make(mtcc_pool);
 
   SVN_ERR(svn_client_open_ra_session2(&(*mtcc)->ra_session, anchor_url,
                                       NULL /* wri_abspath */, ctx,
@@ -415,6 +491,9 @@ mtcc_reparent(const char *new_anchor_url,
   /* Update copy origins recursively...:( */
   SVN_ERR(update_copy_src(mtcc->root_op, up, mtcc->pool));
 
+  /* The cached kinds are relative to the old session URL */
+  mtcc->repos_kinds = apr_hash_make(mtcc->pool);
+
   SVN_ERR(svn_ra_reparent(mtcc->ra_session, new_anchor_url, scratch_pool));
 
   /* Create directory open operations for new ancestors */
@@ -541,8 +620,7 @@ svn_client__mtcc_add_copy(const char *src_relpath,
   SVN_ERR(mtcc_verify_create(mtcc, dst_relpath, scratch_pool));
 
   /* Subversion requires the kind of a copy */
-  SVN_ERR(svn_ra_check_path(mtcc->ra_session, src_relpath, revision, &kind,
-                            scratch_pool));
+  SVN_ERR(mtcc_repos_kind(&kind, mtcc, src_relpath, revision, scratch_pool));
 
   if (kind != svn_node_dir && kind != svn_node_file)
     {
@@ -1001,8 +1079,8 @@ svn_client__mtcc_check_path(svn_node_kind_t *kind,
       && !mtcc->root_op->performed_stat)
     {
       /* We know nothing about the root. Perhaps it is a file? */
-      SVN_ERR(svn_ra_check_path(mtcc->ra_session, "", mtcc->base_revision,
-                                kind, scratch_pool));
+      SVN_ERR(mtcc_repos_kind(kind, mtcc, "", mtcc->base_revision,
+                              scratch_pool));
 
       mtcc->root_op->performed_stat = TRUE;
       if (*kind == svn_node_file)
@@ -1025,8 +1103,8 @@ svn_client__mtcc_check_path(svn_node_kind_t *kind,
       if (!origin_relpath)
         *kind = svn_node_none;
       else
-        SVN_ERR(svn_ra_check_path(mtcc->ra_session, origin_relpath,
-                                  origin_rev, kind, scratch_pool));
+        SVN_ERR(mtcc_repos_kind(kind, mtcc, origin_relpath, origin_rev,
+                                scratch_pool));
 
       if (op && *kind == svn_node_dir)
         {
@@ -1072,6 +1150,62 @@ svn_client__mtcc_check_path(svn_node_kind_t *kind,
   SVN_ERR_MALFUNCTION(); /* No other kinds defined as delete is filtered */
 }
 
+svn_error_t *
+svn_client__mtcc_prefetch_kinds(const apr_array_header_t *relpaths,
+                                svn_revnum_t revision,
+                                svn_client__mtcc_t *mtcc,
+                                apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *paths;
+  apr_hash_t *seen = apr_hash_make(scratch_pool);
+  apr_hash_t *dirents;
+  svn_error_t *err;
+  int i;
+
+  if (! SVN_IS_VALID_REVNUM(revision))
+    revision = mtcc->head_revision;
+  else if (revision > mtcc->head_revision)
+    return SVN_NO_ERROR; /* The operation itself reports this */
+
+  paths = apr_array_make(scratch_pool, relpaths->nelts, sizeof(const char *));
+  for (i = 0; i < relpaths->nelts; i++)
+    {
+      const char *relpath = APR_ARRAY_IDX(relpaths, i, const char *);
+
+      SVN_ERR_ASSERT(svn_relpath_is_canonical(relpath));
+
+      if (svn_hash_gets(seen, relpath)
+          || repos_kind_get(mtcc, relpath, revision, scratch_pool))
+        continue;
+
+      svn_hash_sets(seen, relpath, relpath);
+      APR_ARRAY_PUSH(paths, const char *) = relpath;
+    }
+
+  if (! paths->nelts)
+    return SVN_NO_ERROR;
+
+  err = svn_ra__stat_many(mtcc->ra_session, &dirents, paths, revision,
+                          scratch_pool, scratch_pool);
+  if (err)
+    {
+      /* Leave it to the checks of the operations */
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *relpath = APR_ARRAY_IDX(paths, i, const char *);
+      const svn_dirent_t *dirent = svn_hash_gets(dirents, relpath);
+
+      repos_kind_set(mtcc, relpath, revision,
+                     dirent ? dirent->kind : svn_node_none);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 commit_properties(const svn_delta_editor_t *editor,
                   const mtcc_op_t *op,
@@ -29,6 +29,12 @@
 
 #include <apr_hash.h>
 #include <apr_fnmatch.h>
+#include <apr_lib.h>
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#endif
 #include "svn_client.h"
 #include "svn_dirent_uri.h"
 #include "svn_diff.h"
@@ -73,6 +79,22 @@ typedef struct hunk_info_t {
   svn_linenum_t report_fuzz;
 } hunk_info_t;
 
+/* Hashes of a line of content, used to find candidate locations for
+ * hunks without reading the content again. */
+typedef struct line_hash_t {
+  /* Hash of the line, as returned by readline(). */
+  apr_uint32_t exact;
+
+  /* Hash of the line without any whitespace. */
+  apr_uint32_t ignore_whitespace;
+} line_hash_t;
+
+/* An entry of the index of lines by hash. */
+typedef struct line_index_entry_t {
+  apr_uint32_t hash;
+  svn_linenum_t line;
+} line_index_entry_t;
+
 /* A struct carrying information related to the patched and unpatched
  * content of a target, be it a property or the text of a file. */
 typedef struct target_content_t {
@@ -95,6 +117,18 @@ typedef struct target_content_t {
    * each line in the unpatched content. */
   apr_array_header_t *lines;
 
+  /* An array containing the line_hash_t hashes of the lines in LINES. */
+  apr_array_header_t *line_hashes;
+
+  /* True if LINES covers all of the unpatched content. */
+  svn_boolean_t indexed;
+
+  /* Arrays of line_index_entry_t for all lines, sorted by hash, for
+   * the exact hashes and for the hashes ignoring whitespace.  Created
+   * on demand, once INDEXED is TRUE. */
+  apr_array_header_t *exact_index;
+  apr_array_header_t *ignore_whitespace_index;
+
   /* An array containing hunk_info_t structures for hunks already matched. */
   apr_array_header_t *hunks;
 
@@ -759,6 +793,7 @@ init_prop_target(prop_patch_target_t **prop_target,
   content->current_line = 1;
   content->eol_style = svn_subst_eol_style_none;
   content->lines = apr_array_make(result_pool, 0, sizeof(apr_off_t));
+  content->line_hashes = apr_array_make(result_pool, 0, sizeof(line_hash_t));
   content->hunks = apr_array_make(result_pool, 0, sizeof(hunk_info_t *));
   content->keywords = apr_hash_make(result_pool);
 
@@ -1028,6 +1063,7 @@ init_patch_target(patch_target_t **patch_target,
   content->current_line = 1;
   content->eol_style = svn_subst_eol_style_none;
   content->lines = apr_array_make(result_pool, 0, sizeof(apr_off_t));
+  content->line_hashes = apr_array_make(result_pool, 0, sizeof(line_hash_t));
   content->hunks = apr_array_make(result_pool, 0, sizeof(hunk_info_t *));
   content->keywords = apr_hash_make(result_pool);
 
@@ -1440,8 +1476,29 @@ init_patch_target(patch_target_t **patch_target,
   return SVN_NO_ERROR;
 }
 
+/* Set *HASH to the hashes of LINE.  Lines that compare equal, either
+ * exactly or after apr_collapse_spaces(), get the same respective hash. */
+static void
+hash_line(line_hash_t *hash, const char *line)
+{
+  /* 32 bit FNV-1a */
+  apr_uint32_t exact = 0x811c9dc5;
+  apr_uint32_t ignore_whitespace = 0x811c9dc5;
+
+  for (; *line; line++)
+    {
+      exact = (exact ^ (unsigned char)*line) * 0x01000193;
+      if (!apr_isspace(*line))
+        ignore_whitespace = (ignore_whitespace ^ (unsigned char)*line)
+                          * 0x01000193;
+    }
+
+  hash->exact = exact;
+  hash->ignore_whitespace = ignore_whitespace;
+}
+
 /* Read a *LINE from CONTENT. If the line has not been read before
- * mark the line in CONTENT->LINES.
+ * mark the line in CONTENT->LINES and its hashes in CONTENT->LINE_HASHES.
  * If a line could be read successfully, increase CONTENT->CURRENT_LINE,
  * and allocate *LINE in RESULT_POOL.
  * Do temporary allocations in SCRATCH_POOL.
@@ -1455,6 +1512,7 @@ readline(target_content_t *content,
   svn_stringbuf_t *line_raw;
   const char *eol_str;
   svn_linenum_t max_line = (svn_linenum_t)content->lines->nelts + 1;
+  svn_boolean_t new_line;
 
   if (content->eof || content->readline == NULL)
     {
@@ -1463,7 +1521,8 @@ readline(target_content_t *content,
     }
 
   SVN_ERR_ASSERT(content->current_line <= max_line);
-  if (content->current_line == max_line)
+  new_line = (content->current_line == max_line);
+  if (new_line)
     {
       apr_off_t offset;
 
@@ -1489,6 +1548,9 @@ readline(target_content_t *content,
   else
     *line = "";
 
+  if (new_line)
+    hash_line(apr_array_push(content->line_hashes), *line);
+
   if ((line_raw && line_raw->len > 0) || eol_str)
     content->current_line++;
 
@@ -1660,6 +1722,230 @@ match_hunk(svn_boolean_t *matched, target_content_t *content,
   return SVN_NO_ERROR;
 }
 
+/* Make sure that CONTENT->LINES and CONTENT->LINE_HASHES cover all of
+ * CONTENT.  When this function returns, neither CONTENT->CURRENT_LINE
+ * nor the file offset in the target file will have changed.
+ * Do temporary allocations in SCRATCH_POOL. */
+static svn_error_t *
+index_content(target_content_t *content,
+              apr_pool_t *scratch_pool)
+{
+  svn_linenum_t saved_line;
+  svn_boolean_t saved_eof;
+
+  if (content->indexed)
+    return SVN_NO_ERROR;
+
+  if (content->readline == NULL)
+    {
+      content->indexed = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  saved_line = content->current_line;
+  saved_eof = content->eof;
+
+  /* Continue reading at the last line we know of. */
+  if (content->lines->nelts > 0)
+    SVN_ERR(seek_to_line(content, content->lines->nelts, scratch_pool));
+  SVN_ERR(seek_to_line(content, SVN_LINENUM_MAX_VALUE, scratch_pool));
+
+  content->indexed = TRUE;
+  SVN_ERR(seek_to_line(content, saved_line, scratch_pool));
+  content->eof = saved_eof;
+
+  return SVN_NO_ERROR;
+}
+
+/* Sort line_index_entry_t elements by hash, then by line.
+ * Implements the qsort() comparison function. */
+static int
+compare_line_index_entries(const void *a, const void *b)
+{
+  const line_index_entry_t *entry1 = a;
+  const line_index_entry_t *entry2 = b;
+
+  if (entry1->hash != entry2->hash)
+    return entry1->hash < entry2->hash ? -1 : 1;
+  if (entry1->line != entry2->line)
+    return entry1->line < entry2->line ? -1 : 1;
+
+  return 0;
+}
+
+/* Set *INDEX to the sorted index of the exact line hashes of CONTENT, or
+ * of those ignoring whitespace if IGNORE_WHITESPACE is set.  CONTENT must
+ * have been indexed by index_content(). */
+static void
+get_line_index(const apr_array_header_t **index,
+               target_content_t *content,
+               svn_boolean_t ignore_whitespace)
+{
+  apr_array_header_t **cached = ignore_whitespace
+                              ? &content->ignore_whitespace_index
+                              : &content->exact_index;
+
+  if (! *cached)
+    {
+      apr_array_header_t *entries;
+      int i;
+
+      entries = apr_array_make(content->lines->pool,
+                               content->line_hashes->nelts,
+                               sizeof(line_index_entry_t));
+      for (i = 0; i < content->line_hashes->nelts; i++)
+        {
+          const line_hash_t *hash = &APR_ARRAY_IDX(content->line_hashes, i,
+                                                   line_hash_t);
+          line_index_entry_t *entry = apr_array_push(entries);
+
+          entry->hash = ignore_whitespace ? hash->ignore_whitespace
+                                          : hash->exact;
+          entry->line = i + 1;
+        }
+
+      qsort(entries->elts, entries->nelts, entries->elt_size,
+            compare_line_index_entries);
+      *cached = entries;
+    }
+
+  *index = *cached;
+}
+
+/* Set *HASHES to an array of the line_hash_t hashes of the lines of HUNK
+ * that match_hunk() compares, with keywords contracted as in CONTENT.
+ * MATCH_MODIFIED as in match_hunk().  Allocate *HASHES in RESULT_POOL.
+ * Do temporary allocations in SCRATCH_POOL. */
+static svn_error_t *
+get_hunk_hashes(apr_array_header_t **hashes,
+                const target_content_t *content,
+                svn_diff_hunk_t *hunk,
+                svn_boolean_t match_modified,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  *hashes = apr_array_make(result_pool, 0, sizeof(line_hash_t));
+
+  if (match_modified)
+    svn_diff_hunk_reset_modified_text(hunk);
+  else
+    svn_diff_hunk_reset_original_text(hunk);
+
+  while (TRUE)
+    {
+      svn_stringbuf_t *hunk_line;
+      const char *hunk_line_translated;
+      svn_boolean_t hunk_eof;
+
+      svn_pool_clear(iterpool);
+
+      if (match_modified)
+        SVN_ERR(svn_diff_hunk_readline_modified_text(hunk, &hunk_line,
+                                                     NULL, &hunk_eof,
+                                                     iterpool, iterpool));
+      else
+        SVN_ERR(svn_diff_hunk_readline_original_text(hunk, &hunk_line,
+                                                     NULL, &hunk_eof,
+                                                     iterpool, iterpool));
+
+      if (hunk_eof && hunk_line->len == 0)
+        break;
+
+      SVN_ERR(svn_subst_translate_cstring2(hunk_line->data,
+                                           &hunk_line_translated,
+                                           NULL, FALSE,
+                                           content->keywords, FALSE,
+                                           iterpool));
+      hash_line(apr_array_push(*hashes), hunk_line_translated);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the index in HASHES of the first line of HUNK that match_hunk()
+ * compares with fuzz factor FUZZ, rather than assuming it matches, or -1
+ * if there is no such line.  FUZZ does not include the fuzz penalty of
+ * HUNK.  HASHES and MATCH_MODIFIED as for get_hunk_hashes(). */
+static int
+find_anchor_line(const apr_array_header_t *hashes,
+                 svn_diff_hunk_t *hunk, svn_linenum_t fuzz,
+                 svn_boolean_t match_modified)
+{
+  svn_linenum_t leading_context = svn_diff_hunk_get_leading_context(hunk);
+  svn_linenum_t trailing_context = svn_diff_hunk_get_trailing_context(hunk);
+  svn_linenum_t hunk_length;
+  int i;
+
+  if (match_modified)
+    hunk_length = svn_diff_hunk_get_modified_length(hunk);
+  else
+    hunk_length = svn_diff_hunk_get_original_length(hunk);
+
+  for (i = 0; i < hashes->nelts; i++)
+    {
+      svn_linenum_t lines_read = i + 1;
+
+      if (! ((lines_read <= fuzz && leading_context > fuzz) ||
+             (lines_read > hunk_length - fuzz && trailing_context > fuzz)))
+        return i;
+    }
+
+  return -1;
+}
+
+/* Return FALSE if match_hunk() would certainly not match HUNK, whose lines
+ * have the HASHES, at LINE of CONTENT with fuzz factor FUZZ, and TRUE
+ * if it might.  FUZZ does not include the fuzz penalty of HUNK.
+ * CONTENT must have been indexed by index_content().
+ * IGNORE_WHITESPACE and MATCH_MODIFIED as in match_hunk(). */
+static svn_boolean_t
+hunk_may_match(const target_content_t *content,
+               const apr_array_header_t *hashes,
+               svn_diff_hunk_t *hunk, svn_linenum_t line,
+               svn_linenum_t fuzz, svn_boolean_t ignore_whitespace,
+               svn_boolean_t match_modified)
+{
+  svn_linenum_t leading_context = svn_diff_hunk_get_leading_context(hunk);
+  svn_linenum_t trailing_context = svn_diff_hunk_get_trailing_context(hunk);
+  svn_linenum_t hunk_length;
+  int i;
+
+  if (match_modified)
+    hunk_length = svn_diff_hunk_get_modified_length(hunk);
+  else
+    hunk_length = svn_diff_hunk_get_original_length(hunk);
+
+  for (i = 0; i < hashes->nelts; i++)
+    {
+      svn_linenum_t lines_read = i + 1;
+      const line_hash_t *hunk_hash;
+      const line_hash_t *target_hash;
+
+      /* Leave it to match_hunk() to detect the end of the content. */
+      if (line + i > (svn_linenum_t)content->line_hashes->nelts)
+        return TRUE;
+
+      /* Leading/trailing fuzzy lines always match. */
+      if ((lines_read <= fuzz && leading_context > fuzz) ||
+          (lines_read > hunk_length - fuzz && trailing_context > fuzz))
+        continue;
+
+      hunk_hash = &APR_ARRAY_IDX(hashes, i, line_hash_t);
+      target_hash = &APR_ARRAY_IDX(content->line_hashes, line + i - 1,
+                                   line_hash_t);
+      if (ignore_whitespace
+          ? hunk_hash->ignore_whitespace != target_hash->ignore_whitespace
+          : hunk_hash->exact != target_hash->exact)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 /* Scan lines of CONTENT for a match of the original text of HUNK,
  * up to but not including the specified UPPER_LINE. Use fuzz factor FUZZ.
  * If UPPER_LINE is zero scan until EOF occurs when reading from TARGET.
@@ -1685,58 +1971,163 @@ scan_for_match(svn_linenum_t *matched_line,
                apr_pool_t *pool)
 {
   apr_pool_t *iterpool;
+  svn_linenum_t fuzz_penalty;
+  svn_linenum_t line_count;
+  svn_linenum_t end_line;
+  svn_linenum_t line = content->current_line;
 
   *matched_line = 0;
+
+  if (content->eof)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(index_content(content, pool));
+  line_count = content->lines->nelts;
+
+  /* The first line not to scan. */
+  if (upper_line > 0 && upper_line <= line_count)
+    end_line = upper_line;
+  else
+    end_line = line_count + 1;
+
+  if (line >= end_line)
+    return SVN_NO_ERROR;
+
   iterpool = svn_pool_create(pool);
-  while ((content->current_line < upper_line || upper_line == 0) &&
-         ! content->eof)
+
+  /* Otherwise, the hunk can't match anywhere. */
+  fuzz_penalty = svn_diff_hunk__get_fuzz_penalty(hunk);
+  if (fuzz_penalty <= fuzz)
     {
-      svn_boolean_t matched;
+      apr_array_header_t *hashes;
+      const apr_array_header_t *index = NULL;
+      apr_uint32_t anchor_hash = 0;
+      int anchor;
+      int next = 0;
+
+      SVN_ERR(get_hunk_hashes(&hashes, content, hunk, match_modified,
+                              pool, iterpool));
+
+      /* Use the index to only try the lines where the first line of the
+       * hunk that needs to match does match.  Without such a line, try
+       * all lines. */
+      anchor = find_anchor_line(hashes, hunk, fuzz - fuzz_penalty,
+                                match_modified);
+      if (anchor >= 0)
+        {
+          const line_hash_t *hash = &APR_ARRAY_IDX(hashes, anchor,
+                                                   line_hash_t);
+          int high;
 
-      svn_pool_clear(iterpool);
+          anchor_hash = ignore_whitespace ? hash->ignore_whitespace
+                                          : hash->exact;
+          get_line_index(&index, content, ignore_whitespace);
 
-      if (cancel_func)
-        SVN_ERR(cancel_func(cancel_baton));
+          /* Find the first entry at or after LINE + ANCHOR. */
+          high = index->nelts;
+          while (next < high)
+            {
+              int middle = next + (high - next) / 2;
+              const line_index_entry_t *entry
+                = &APR_ARRAY_IDX(index, middle, line_index_entry_t);
+
+              if (entry->hash < anchor_hash
+                  || (entry->hash == anchor_hash
+                      && entry->line < line + anchor))
+                next = middle + 1;
+              else
+                high = middle;
+            }
+        }
 
-      SVN_ERR(match_hunk(&matched, content, hunk, fuzz, ignore_whitespace,
-                         match_modified, iterpool));
-      if (matched)
+      while (TRUE)
         {
-          svn_boolean_t taken = FALSE;
-          int i;
+          svn_boolean_t matched;
 
-          /* Don't allow hunks to match at overlapping locations. */
-          for (i = 0; i < content->hunks->nelts; i++)
+          if (anchor >= 0)
             {
-              const hunk_info_t *hi;
-              svn_linenum_t length;
+              const line_index_entry_t *entry;
 
-              hi = APR_ARRAY_IDX(content->hunks, i, const hunk_info_t *);
+              if (next == index->nelts)
+                break;
 
-              if (match_modified)
-                length = svn_diff_hunk_get_modified_length(hi->hunk);
-              else
-                length = svn_diff_hunk_get_original_length(hi->hunk);
+              entry = &APR_ARRAY_IDX(index, next++, line_index_entry_t);
+              if (entry->hash != anchor_hash)
+                break;
 
-              taken = (! hi->rejected &&
-                       content->current_line >= hi->matched_line &&
-                       content->current_line < (hi->matched_line + length));
-              if (taken)
+              line = entry->line - anchor;
+              if (line >= end_line)
                 break;
+
+              if (! hunk_may_match(content, hashes, hunk, line,
+                                   fuzz - fuzz_penalty, ignore_whitespace,
+                                   match_modified))
+                continue;
             }
+          else if (line >= end_line)
+            break;
+
+          svn_pool_clear(iterpool);
 
-          if (! taken)
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          SVN_ERR(seek_to_line(content, line, iterpool));
+          SVN_ERR(match_hunk(&matched, content, hunk, fuzz, ignore_whitespace,
+                             match_modified, iterpool));
+          if (matched)
             {
-              *matched_line = content->current_line;
-              if (match_first)
-                break;
+              svn_boolean_t taken = FALSE;
+              int i;
+
+              /* Don't allow hunks to match at overlapping locations. */
+              for (i = 0; i < content->hunks->nelts; i++)
+                {
+                  const hunk_info_t *hi;
+                  svn_linenum_t length;
+
+                  hi = APR_ARRAY_IDX(content->hunks, i, const hunk_info_t *);
+
+                  if (match_modified)
+                    length = svn_diff_hunk_get_modified_length(hi->hunk);
+                  else
+                    length = svn_diff_hunk_get_original_length(hi->hunk);
+
+                  taken = (! hi->rejected &&
+                           line >= hi->matched_line &&
+                           line < (hi->matched_line + length));
+                  if (taken)
+                    break;
+                }
+
+              if (! taken)
+                {
+                  *matched_line = line;
+                  if (match_first)
+                    {
+                      svn_pool_destroy(iterpool);
+                      return SVN_NO_ERROR;
+                    }
+                }
             }
+
+          /* Only at the last line, which is empty. */
+          if (content->eof)
+            break;
+
+          line++;
         }
+    }
 
-      if (! content->eof)
-        SVN_ERR(seek_to_line(content, content->current_line + 1,
-                             iterpool));
+  /* Leave CONTENT where scanning line by line would have stopped. */
+  if (end_line > line_count)
+    {
+      SVN_ERR(seek_to_line(content, line_count, iterpool));
+      SVN_ERR(seek_to_line(content, line_count + 1, iterpool));
     }
+  else
+    SVN_ERR(seek_to_line(content, end_line, iterpool));
+
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
@@ -2505,29 +2896,21 @@ sort_matched_hunks(const void *a, const void *b)
 }
 
 
-/* Apply a PATCH to a working copy at ABS_WC_PATH and put the result
- * into temporary files, to be installed in the working copy later.
- * Return information about the patch target in *PATCH_TARGET, allocated
- * in RESULT_POOL. Use WC_CTX as the working copy context.
- * STRIP_COUNT specifies the number of leading path components
- * which should be stripped from target paths in the patch.
- * REMOVE_TEMPFILES, PATCH_FUNC, and PATCH_BATON as in svn_client_patch().
+/* Apply a PATCH to TARGET, as set up by init_patch_target(), and put
+ * the result into temporary files, to be installed in the working copy
+ * later.  Update the information about the patch target in TARGET,
+ * allocating it in RESULT_POOL.  This does not access the working copy.
  * IGNORE_WHITESPACE tells whether whitespace should be considered when
  * doing the matching.
  * Call cancel CANCEL_FUNC with baton CANCEL_BATON to trigger cancellation.
  * Do temporary allocations in SCRATCH_POOL. */
 static svn_error_t *
-apply_one_patch(patch_target_t **patch_target, svn_patch_t *patch,
-                const char *abs_wc_path, svn_wc_context_t *wc_ctx,
-                int strip_count,
+apply_one_patch(patch_target_t *target, svn_patch_t *patch,
                 svn_boolean_t ignore_whitespace,
-                svn_boolean_t remove_tempfiles,
-                const apr_array_header_t *targets_info,
                 svn_cancel_func_t cancel_func,
                 void *cancel_baton,
                 apr_pool_t *result_pool, apr_pool_t *scratch_pool)
 {
-  patch_target_t *target;
   apr_pool_t *iterpool;
   int i;
   static const svn_linenum_t MAX_FUZZ = 2;
@@ -2535,14 +2918,8 @@ apply_one_patch(patch_target_t **patch_target, svn_patch_t *patch,
   svn_linenum_t previous_offset = 0;
   apr_array_header_t *prop_targets;
 
-  SVN_ERR(init_patch_target(&target, patch, abs_wc_path, wc_ctx, strip_count,
-                            remove_tempfiles, targets_info,
-                            result_pool, scratch_pool));
   if (target->skipped)
-    {
-      *patch_target = target;
-      return SVN_NO_ERROR;
-    }
+    return SVN_NO_ERROR;
 
   iterpool = svn_pool_create(scratch_pool);
 
@@ -2628,18 +3005,59 @@ apply_one_patch(patch_target_t **patch_target, svn_patch_t *patch,
   else if (patch->binary_patch)
     {
       svn_stream_t *orig_stream;
+      apr_file_t *result_file;
       svn_boolean_t same;
+      svn_error_t *err;
 
-      if (target->file)
-        orig_stream = svn_stream_from_aprfile2(target->file, TRUE, iterpool);
+      /* Compute the result, as if the target is the original version.
+         The patch may describe the result as a delta against that, so
+         this may fail when the target is not the original version. */
+      SVN_ERR(svn_io_open_unique_file3(&result_file, NULL, NULL,
+                                       svn_io_file_del_on_pool_cleanup,
+                                       scratch_pool, iterpool));
+      err = svn_stream_copy3(
+              svn_diff__get_binary_diff_result_stream(patch->binary_patch,
+                                                      target->file,
+                                                      iterpool),
+              svn_stream_from_aprfile2(result_file, TRUE, iterpool),
+              cancel_func, cancel_baton,
+              iterpool);
+
+      if (err && err->apr_err == SVN_ERR_DIFF_BASE_MISMATCH)
+        {
+          svn_error_clear(err);
+          same = FALSE;
+        }
       else
-        orig_stream = svn_stream_empty(iterpool);
+        {
+          SVN_ERR(err);
 
-      SVN_ERR(svn_stream_contents_same2(
-                &same, orig_stream,
-                svn_diff_get_binary_diff_original_stream(patch->binary_patch,
-                                                         iterpool),
-                iterpool));
+          if (target->file)
+            {
+              apr_off_t start = 0;
+
+              SVN_ERR(svn_io_file_seek(target->file, APR_SET, &start,
+                                       iterpool));
+              orig_stream = svn_stream_from_aprfile2(target->file, TRUE,
+                                                     iterpool);
+            }
+          else
+            orig_stream = svn_stream_empty(iterpool);
+
+          err = svn_stream_contents_same2(
+                  &same, orig_stream,
+                  svn_diff__get_binary_diff_original_stream(
+                                                  patch->binary_patch,
+                                                  result_file, iterpool),
+                  iterpool);
+          if (err && err->apr_err == SVN_ERR_DIFF_BASE_MISMATCH)
+            {
+              svn_error_clear(err);
+              same = FALSE;
+            }
+          else
+            SVN_ERR(err);
+        }
       svn_pool_clear(iterpool);
 
       if (same)
@@ -2653,23 +3071,51 @@ apply_one_patch(patch_target_t **patch_target, svn_patch_t *patch,
       else
         {
           /* Perhaps the file is identical to the resulting version, implying
-             that the patch has already been applied */
-          if (target->file)
+             that the patch has already been applied.  Derive the original
+             version from the target as if it were the result, and see if
+             the patch turns that back into the target. */
+          apr_file_t *original_file;
+
+          SVN_ERR(svn_io_open_unique_file3(&original_file, NULL, NULL,
+                                           svn_io_file_del_on_pool_cleanup,
+                                           iterpool, iterpool));
+          err = svn_stream_copy3(
+                  svn_diff__get_binary_diff_original_stream(
+                                                  patch->binary_patch,
+                                                  target->file, iterpool),
+                  svn_stream_from_aprfile2(original_file, TRUE, iterpool),
+                  cancel_func, cancel_baton,
+                  iterpool);
+
+          if (!err)
             {
-              apr_off_t start = 0;
+              if (target->file)
+                {
+                  apr_off_t start = 0;
 
-              SVN_ERR(svn_io_file_seek(target->file, APR_SET, &start, iterpool));
+                  SVN_ERR(svn_io_file_seek(target->file, APR_SET, &start,
+                                           iterpool));
+                  orig_stream = svn_stream_from_aprfile2(target->file, TRUE,
+                                                         iterpool);
+                }
+              else
+                orig_stream = svn_stream_empty(iterpool);
+
+              err = svn_stream_contents_same2(
+                      &same, orig_stream,
+                      svn_diff__get_binary_diff_result_stream(
+                                                  patch->binary_patch,
+                                                  original_file, iterpool),
+                      iterpool);
+            }
 
-              orig_stream = svn_stream_from_aprfile2(target->file, TRUE, iterpool);
+          if (err && err->apr_err == SVN_ERR_DIFF_BASE_MISMATCH)
+            {
+              svn_error_clear(err);
+              same = FALSE;
             }
           else
-            orig_stream = svn_stream_empty(iterpool);
-
-          SVN_ERR(svn_stream_contents_same2(
-                    &same, orig_stream,
-                    svn_diff_get_binary_diff_result_stream(patch->binary_patch,
-                                                           iterpool),
-                    iterpool));
+            SVN_ERR(err);
           svn_pool_clear(iterpool);
 
           if (same)
@@ -2678,9 +3124,30 @@ apply_one_patch(patch_target_t **patch_target, svn_patch_t *patch,
 
       if (same)
         {
+          svn_stream_t *result_stream;
+          apr_off_t start = 0;
+
+          /* If the patch has already been applied, the target is the
+             resulting version. */
+          if (target->had_already_applied && target->file)
+            {
+              SVN_ERR(svn_io_file_seek(target->file, APR_SET, &start,
+                                       iterpool));
+              result_stream = svn_stream_from_aprfile2(target->file, TRUE,
+                                                       iterpool);
+            }
+          else if (target->had_already_applied)
+            result_stream = svn_stream_empty(iterpool);
+          else
+            {
+              SVN_ERR(svn_io_file_seek(result_file, APR_SET, &start,
+                                       iterpool));
+              result_stream = svn_stream_from_aprfile2(result_file, TRUE,
+                                                       iterpool);
+            }
+
           SVN_ERR(svn_stream_copy3(
-                svn_diff_get_binary_diff_result_stream(patch->binary_patch,
-                                                       iterpool),
+                result_stream,
                 svn_stream_from_aprfile2(target->patched_file, TRUE,
                                          iterpool),
                 cancel_func, cancel_baton,
@@ -2969,8 +3436,6 @@ apply_one_patch(patch_target_t **patch_target, svn_patch_t *patch,
 
   SVN_ERR(svn_io_file_close(target->patched_file, scratch_pool));
 
-  *patch_target = target;
-
   return SVN_NO_ERROR;
 }
 
@@ -3605,6 +4070,586 @@ check_ancestor_delete(const char *deleted_target,
   return SVN_NO_ERROR;
 }
 
+/* The state of applying a patch file, shared by apply_patches() and the
+ * functions it uses to patch the individual targets. */
+typedef struct apply_baton_t {
+  /* The arguments of apply_patches(). */
+  const char *patch_abspath;
+  const char *root_abspath;
+  svn_boolean_t dry_run;
+  int strip_count;
+  svn_boolean_t ignore_whitespace;
+  svn_boolean_t remove_tempfiles;
+  svn_client_patch_func_t patch_func;
+  void *patch_baton;
+  svn_client_ctx_t *ctx;
+
+  /* Information about the targets installed so far, allocated in POOL. */
+  apr_array_header_t *targets_info;
+  apr_pool_t *pool;
+
+  /* The targets being patched by worker threads, or NULL if targets are
+   * patched one after the other. */
+  struct patch_queue_t *queue;
+} apply_baton_t;
+
+/* A single patch of the patch file and its target. */
+typedef struct patch_job_t {
+  svn_patch_t *patch;
+  patch_target_t *target;
+
+  /* The paths that installing TARGET may modify.  A NULL element stands
+   * for any path. */
+  apr_array_header_t *paths;
+
+  /* Whether installing TARGET may add or delete nodes, which may affect
+   * other paths than PATHS as well. */
+  svn_boolean_t changes_tree;
+
+  /* The pool holding everything of this job.  When run by a worker
+   * thread, this is a root pool and ERR is its result.  DONE is protected
+   * by the mutex of the patch_queue_t. */
+  apr_pool_t *pool;
+  svn_boolean_t done;
+  svn_error_t *err;
+} patch_job_t;
+
+/* Add the path that PATH_FROM_PATCHFILE refers to within the working
+ * copy of AB to PATHS, as far as it can be determined without looking
+ * at the working copy.  Allocate it in RESULT_POOL. */
+static void
+add_target_path(apr_array_header_t *paths,
+                const apply_baton_t *ab,
+                const char *path_from_patchfile,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  const char *path = svn_dirent_internal_style(path_from_patchfile,
+                                               scratch_pool);
+
+  if (ab->strip_count > 0)
+    {
+      svn_error_t *err = strip_path(&path, path, ab->strip_count,
+                                    scratch_pool, scratch_pool);
+
+      if (err)
+        {
+          /* Applying the patch will fail, so make it wait for all
+           * patches before it. */
+          svn_error_clear(err);
+          APR_ARRAY_PUSH(paths, const char *) = NULL;
+          return;
+        }
+    }
+
+  APR_ARRAY_PUSH(paths, const char *)
+    = svn_dirent_join(ab->root_abspath, path, result_pool);
+}
+
+/* Return TRUE if any path in PATHS1 is the same as, an ancestor of, or
+ * a descendant of any path in PATHS2. */
+static svn_boolean_t
+paths_related(const apr_array_header_t *paths1,
+              const apr_array_header_t *paths2)
+{
+  int i, j;
+
+  for (i = 0; i < paths1->nelts; i++)
+    {
+      const char *path1 = APR_ARRAY_IDX(paths1, i, const char *);
+
+      for (j = 0; j < paths2->nelts; j++)
+        {
+          const char *path2 = APR_ARRAY_IDX(paths2, j, const char *);
+
+          if (!path1 || !path2
+              || svn_dirent_is_ancestor(path1, path2)
+              || svn_dirent_is_ancestor(path2, path1))
+            return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+/* Match and apply the hunks of JOB to the contents of its target, as
+ * described by AB.  If AB has a queue, this may run on a worker thread
+ * and must not invoke any client callback. */
+static svn_error_t *
+patch_target_contents(const apply_baton_t *ab,
+                      patch_job_t *job,
+                      apr_pool_t *scratch_pool)
+{
+  svn_cancel_func_t cancel_func = NULL;
+  void *cancel_baton = NULL;
+
+  if (job->target->skipped)
+    return SVN_NO_ERROR;
+
+  if (!ab->queue)
+    {
+      cancel_func = ab->ctx->cancel_func;
+      cancel_baton = ab->ctx->cancel_baton;
+    }
+  else
+    {
+      apr_file_t *apr_file;
+
+      /* Read the hunks through a file handle of our own, while the patch
+       * file is being parsed further. */
+      SVN_ERR(svn_io_file_open(&apr_file, ab->patch_abspath,
+                               APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
+                               job->pool));
+      svn_diff__patch_set_file(job->patch, apr_file, scratch_pool);
+    }
+
+  return svn_error_trace(apply_one_patch(job->target, job->patch,
+                                         ab->ignore_whitespace,
+                                         cancel_func, cancel_baton,
+                                         job->pool, scratch_pool));
+}
+
+/* Install TARGET, whose contents have been patched by apply_one_patch(),
+ * in the working copy and notify about it, as described by AB. */
+static svn_error_t *
+complete_patch_target(apply_baton_t *ab,
+                     patch_target_t *target,
+                     apr_pool_t *scratch_pool)
+{
+  svn_boolean_t filtered = FALSE;
+  patch_target_info_t *target_info;
+
+  if (!target->skipped && ab->patch_func)
+    {
+      SVN_ERR(ab->patch_func(ab->patch_baton, &filtered,
+                             target->canon_path_from_patchfile,
+                             target->patched_path, target->reject_path,
+                             scratch_pool));
+    }
+
+  if (filtered)
+    return SVN_NO_ERROR;
+
+  /* Save info we'll still need when we're done patching. */
+  target_info = apr_pcalloc(ab->pool, sizeof(patch_target_info_t));
+  target_info->local_abspath = apr_pstrdup(ab->pool, target->local_abspath);
+  target_info->deleted = target->deleted;
+  target_info->added = target->added;
+
+  if (! target->skipped)
+    {
+      if (target->has_text_changes
+          || target->added
+          || target->move_target_abspath
+          || target->deleted)
+        SVN_ERR(install_patched_target(target, ab->root_abspath,
+                                       ab->ctx, ab->dry_run,
+                                       ab->targets_info, scratch_pool));
+
+      if (target->has_prop_changes && (!target->deleted))
+        SVN_ERR(install_patched_prop_targets(target, ab->ctx,
+                                             ab->dry_run, scratch_pool));
+
+      SVN_ERR(write_out_rejected_hunks(target, ab->root_abspath,
+                                       ab->dry_run, scratch_pool));
+
+      APR_ARRAY_PUSH(ab->targets_info, patch_target_info_t *) = target_info;
+    }
+  SVN_ERR(send_patch_notification(target, ab->ctx, scratch_pool));
+
+  if (target->deleted && !target->skipped)
+    {
+      SVN_ERR(check_ancestor_delete(target_info->local_abspath,
+                                    ab->targets_info, ab->root_abspath,
+                                    ab->dry_run, ab->ctx,
+                                    ab->pool, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Number of threads matching and applying hunks, while the working copy
+ * is updated for the preceding targets. */
+#define PATCH_THREADS 4
+
+/* Maximum number of targets being patched ahead of the one that is
+ * installed next. */
+#define PATCH_AHEAD (4 * PATCH_THREADS)
+
+/* The targets of a patch file that are being patched ahead. */
+typedef struct patch_queue_t
+{
+  /* Ring buffer of the jobs numbered FIRST up to SUBMITTED, in the order
+   * of the patch file.  Jobs before NEXT have been taken by a thread.
+   * FIRST and SUBMITTED are only modified by the thread that runs
+   * apply_patches(). */
+  patch_job_t *jobs[PATCH_AHEAD];
+  int first;
+  int next;
+  int submitted;
+
+  /* Set when the threads should exit. */
+  svn_boolean_t stop;
+
+  /* Protects the fields above and the DONE flags of the jobs. */
+  apr_thread_mutex_t *mutex;
+
+  /* Signalled when a job has been submitted or finished. */
+  apr_thread_cond_t *cond;
+
+  apr_thread_t *threads[PATCH_THREADS];
+  int thread_count;
+
+  /* What the jobs are about. */
+  const apply_baton_t *ab;
+
+  /* The pool that stop_patch_threads() is registered with. */
+  apr_pool_t *pool;
+} patch_queue_t;
+
+/* Run JOB of QUEUE and signal its completion.  The caller must have
+ * taken JOB from QUEUE, and not hold the lock of QUEUE. */
+static void
+run_patch_job(patch_queue_t *queue,
+              patch_job_t *job,
+              apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = patch_target_contents(queue->ab, job, scratch_pool);
+
+  apr_thread_mutex_lock(queue->mutex);
+  job->err = err;
+  job->done = TRUE;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+}
+
+/* Implements apr_thread_start_t for the patch_queue_t at DATA. */
+static void * APR_THREAD_FUNC
+patch_thread(apr_thread_t *tid, void *data)
+{
+  patch_queue_t *queue = data;
+  apr_pool_t *iterpool = svn_pool_create(NULL);
+
+  while (TRUE)
+    {
+      patch_job_t *job = NULL;
+
+      apr_thread_mutex_lock(queue->mutex);
+      while (!queue->stop && queue->next == queue->submitted)
+        apr_thread_cond_wait(queue->cond, queue->mutex);
+      if (!queue->stop)
+        job = queue->jobs[queue->next++ % PATCH_AHEAD];
+      apr_thread_mutex_unlock(queue->mutex);
+
+      if (!job)
+        break;
+
+      svn_pool_clear(iterpool);
+      run_patch_job(queue, job, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Install and release the targets in the queue of AB that have been
+ * patched, in the order of the patch file.  Wait for all jobs numbered
+ * below WAIT_UNTIL, running them on this thread if no other thread took
+ * them yet, and checking for cancellation whenever a job finishes
+ * meanwhile.  Return the first error of a job. */
+static svn_error_t *
+reap_patch_jobs(apply_baton_t *ab,
+                int wait_until,
+                apr_pool_t *scratch_pool)
+{
+  patch_queue_t *queue = ab->queue;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  apr_thread_mutex_lock(queue->mutex);
+  while (!err && queue->first < queue->submitted)
+    {
+      patch_job_t *job = queue->jobs[queue->first % PATCH_AHEAD];
+
+      if (!job->done)
+        {
+          if (queue->first >= wait_until)
+            break;
+
+          if (queue->next == queue->first)
+            {
+              queue->next++;
+              apr_thread_mutex_unlock(queue->mutex);
+              svn_pool_clear(iterpool);
+              run_patch_job(queue, job, iterpool);
+              apr_thread_mutex_lock(queue->mutex);
+            }
+          else
+            {
+              apr_thread_cond_wait(queue->cond, queue->mutex);
+
+              if (ab->ctx->cancel_func)
+                {
+                  apr_thread_mutex_unlock(queue->mutex);
+                  err = ab->ctx->cancel_func(ab->ctx->cancel_baton);
+                  apr_thread_mutex_lock(queue->mutex);
+                }
+            }
+
+          continue;
+        }
+
+      queue->jobs[queue->first++ % PATCH_AHEAD] = NULL;
+      apr_thread_mutex_unlock(queue->mutex);
+
+      svn_pool_clear(iterpool);
+      err = job->err;
+      if (!err)
+        err = complete_patch_target(ab, job->target, iterpool);
+      svn_pool_destroy(job->pool);
+
+      apr_thread_mutex_lock(queue->mutex);
+    }
+  apr_thread_mutex_unlock(queue->mutex);
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+/* Return TRUE if a job with PATHS must not be set up before the jobs in
+ * QUEUE have been installed, because these might change what the job
+ * finds in the working copy. */
+static svn_boolean_t
+must_wait_for_queue(const patch_queue_t *queue,
+                    const apr_array_header_t *paths)
+{
+  int i;
+
+  for (i = queue->first; i < queue->submitted; i++)
+    {
+      const patch_job_t *job = queue->jobs[i % PATCH_AHEAD];
+
+      if (job->changes_tree || paths_related(job->paths, paths))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Stop the threads of the patch_queue_t at DATA and release the jobs
+ * that are left.  Implements apr_pool_cleanup_t. */
+static apr_status_t
+stop_patch_threads(void *data)
+{
+  patch_queue_t *queue = data;
+  int i;
+
+  apr_thread_mutex_lock(queue->mutex);
+  queue->stop = TRUE;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  for (i = 0; i < queue->thread_count; i++)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, queue->threads[i]);
+    }
+
+  for (i = queue->first; i < queue->submitted; i++)
+    {
+      patch_job_t *job = queue->jobs[i % PATCH_AHEAD];
+
+      svn_error_clear(job->err);
+      svn_pool_destroy(job->pool);
+    }
+
+  queue->first = queue->submitted;
+  queue->thread_count = 0;
+
+  return APR_SUCCESS;
+}
+
+/* Set up the queue of AB in POOL, if threads are available. */
+static void
+start_patch_threads(apply_baton_t *ab,
+                    apr_pool_t *pool)
+{
+  patch_queue_t *queue = apr_pcalloc(pool, sizeof(*queue));
+  int i;
+
+  queue->ab = ab;
+  queue->pool = pool;
+  if (apr_thread_mutex_create(&queue->mutex, APR_THREAD_MUTEX_DEFAULT, pool)
+      || apr_thread_cond_create(&queue->cond, pool))
+    return;
+
+  for (i = 0; i < PATCH_THREADS; i++)
+    {
+      if (apr_thread_create(&queue->threads[queue->thread_count], NULL,
+                            patch_thread, queue, pool))
+        break;
+
+      ++queue->thread_count;
+    }
+
+  if (!queue->thread_count)
+    return;
+
+  /* Registered after the mutex and the condition, so that this runs
+   * before they are destroyed. */
+  apr_pool_cleanup_register(pool, queue, stop_patch_threads,
+                            apr_pool_cleanup_null);
+  ab->queue = queue;
+}
+
+/* Queue JOB, allocated in JOB->POOL, to be patched by the threads of the
+ * queue of AB. */
+static svn_error_t *
+submit_patch_job(apply_baton_t *ab,
+                 patch_job_t *job,
+                 apr_pool_t *scratch_pool)
+{
+  patch_queue_t *queue = ab->queue;
+  svn_error_t *err;
+
+  /* Make room, installing what has been patched so far. */
+  err = reap_patch_jobs(ab, queue->submitted - PATCH_AHEAD + 1,
+                        scratch_pool);
+  if (err)
+    {
+      svn_pool_destroy(job->pool);
+      return svn_error_trace(err);
+    }
+
+  apr_thread_mutex_lock(queue->mutex);
+  queue->jobs[queue->submitted++ % PATCH_AHEAD] = job;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  return SVN_NO_ERROR;
+}
+
+/* Close and remove the temporary files of TARGET, which has been set up
+ * by init_patch_target() but is not going to be patched. */
+static svn_error_t *
+discard_patch_target(patch_target_t *target,
+                     svn_boolean_t remove_tempfiles,
+                     apr_pool_t *scratch_pool)
+{
+  if (target->file)
+    SVN_ERR(svn_io_file_close(target->file, scratch_pool));
+  if (target->patched_file)
+    SVN_ERR(svn_io_file_close(target->patched_file, scratch_pool));
+  if (target->reject_stream)
+    SVN_ERR(svn_stream_close(target->reject_stream));
+
+  /* Otherwise, they are removed with the pool of the target. */
+  if (! remove_tempfiles)
+    {
+      if (target->patched_path)
+        SVN_ERR(svn_io_remove_file2(target->patched_path, TRUE,
+                                    scratch_pool));
+      if (target->reject_path)
+        SVN_ERR(svn_io_remove_file2(target->reject_path, TRUE,
+                                    scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Parse the next patch from PATCH_FILE and set up its target in the
+ * working copy of AB.  Return it in *JOB, allocated in JOB_POOL, or set
+ * *JOB to NULL if there are no more patches.  REVERSE as in
+ * svn_client_patch(). */
+static svn_error_t *
+init_patch_job(patch_job_t **job,
+               apply_baton_t *ab,
+               svn_patch_file_t *patch_file,
+               svn_boolean_t reverse,
+               apr_pool_t *job_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_patch_t *patch;
+  patch_job_t *new_job;
+
+  SVN_ERR(svn_diff_parse_next_patch(&patch, patch_file,
+                                    reverse, ab->ignore_whitespace,
+                                    job_pool, scratch_pool));
+  if (!patch)
+    {
+      *job = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  new_job = apr_pcalloc(job_pool, sizeof(*new_job));
+  new_job->patch = patch;
+  new_job->pool = job_pool;
+  new_job->paths = apr_array_make(job_pool, 4, sizeof(const char *));
+
+#if APR_HAS_THREADS
+  if (ab->queue)
+    {
+      /* Setting up the target depends on the working copy as left by the
+       * patches before it.  Make sure that those which might matter have
+       * been installed. */
+      add_target_path(new_job->paths, ab, patch->old_filename,
+                      job_pool, scratch_pool);
+      add_target_path(new_job->paths, ab, patch->new_filename,
+                      job_pool, scratch_pool);
+
+      if (must_wait_for_queue(ab->queue, new_job->paths))
+        SVN_ERR(reap_patch_jobs(ab, ab->queue->submitted, scratch_pool));
+    }
+#endif
+
+  SVN_ERR(init_patch_target(&new_job->target, patch, ab->root_abspath,
+                            ab->ctx->wc_ctx, ab->strip_count,
+                            ab->remove_tempfiles, ab->targets_info,
+                            job_pool, scratch_pool));
+
+#if APR_HAS_THREADS
+  if (ab->queue)
+    {
+      if (new_job->target->local_abspath)
+        APR_ARRAY_PUSH(new_job->paths, const char *)
+          = new_job->target->local_abspath;
+      if (new_job->target->move_target_abspath)
+        APR_ARRAY_PUSH(new_job->paths, const char *)
+          = new_job->target->move_target_abspath;
+
+      /* Following a local move may have led us to the target of a patch
+       * that is still pending.  Set up the target again once that has
+       * been installed. */
+      if (must_wait_for_queue(ab->queue, new_job->paths))
+        {
+          SVN_ERR(reap_patch_jobs(ab, ab->queue->submitted, scratch_pool));
+          SVN_ERR(discard_patch_target(new_job->target, ab->remove_tempfiles,
+                                       scratch_pool));
+          SVN_ERR(init_patch_target(&new_job->target, patch,
+                                    ab->root_abspath, ab->ctx->wc_ctx,
+                                    ab->strip_count, ab->remove_tempfiles,
+                                    ab->targets_info,
+                                    job_pool, scratch_pool));
+        }
+
+      new_job->changes_tree = (! new_job->target->skipped
+                               && (new_job->target->added
+                                   || new_job->target->deleted
+                                   || new_job->target->move_target_abspath));
+    }
+#endif
+
+  *job = new_job;
+  return SVN_NO_ERROR;
+}
+
 /* This function is the main entry point into the patch code. */
 static svn_error_t *
 apply_patches(/* The path to the patch file. */
@@ -3628,91 +4673,86 @@ apply_patches(/* The path to the patch file. */
               svn_client_ctx_t *ctx,
               apr_pool_t *scratch_pool)
 {
-  svn_patch_t *patch;
   apr_pool_t *iterpool;
   svn_patch_file_t *patch_file;
-  apr_array_header_t *targets_info;
+  apply_baton_t ab = { 0 };
+  patch_job_t *job;
 
   /* Try to open the patch file. */
   SVN_ERR(svn_diff_open_patch_file(&patch_file, patch_abspath, scratch_pool));
 
+  ab.patch_abspath = patch_abspath;
+  ab.root_abspath = root_abspath;
+  ab.dry_run = dry_run;
+  ab.strip_count = strip_count;
+  ab.ignore_whitespace = ignore_whitespace;
+  ab.remove_tempfiles = remove_tempfiles;
+  ab.patch_func = patch_func;
+  ab.patch_baton = patch_baton;
+  ab.ctx = ctx;
+  ab.targets_info = apr_array_make(scratch_pool, 0,
+                                   sizeof(patch_target_info_t *));
+  ab.pool = scratch_pool;
+
+#if APR_HAS_THREADS
+  /* Match and apply hunks on worker threads, while this thread keeps
+   * parsing the patch file and updates the working copy in the order of
+   * the patch file. */
+  start_patch_threads(&ab, scratch_pool);
+#endif
+
   /* Apply patches. */
-  targets_info = apr_array_make(scratch_pool, 0,
-                                sizeof(patch_target_info_t *));
   iterpool = svn_pool_create(scratch_pool);
   do
     {
+      apr_pool_t *job_pool = iterpool;
+      svn_error_t *err;
+
       svn_pool_clear(iterpool);
 
       if (ctx->cancel_func)
         SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
 
-      SVN_ERR(svn_diff_parse_next_patch(&patch, patch_file,
-                                        reverse, ignore_whitespace,
-                                        iterpool, iterpool));
-      if (patch)
+#if APR_HAS_THREADS
+      /* Queued jobs must not share a pool with this thread. */
+      if (ab.queue)
+        job_pool = svn_pool_create(NULL);
+#endif
+
+      err = init_patch_job(&job, &ab, patch_file, reverse,
+                           job_pool, iterpool);
+      if (err || !job)
         {
-          patch_target_t *target;
-          svn_boolean_t filtered = FALSE;
+          if (job_pool != iterpool)
+            svn_pool_destroy(job_pool);
+          SVN_ERR(err);
+          continue;
+        }
 
-          SVN_ERR(apply_one_patch(&target, patch, root_abspath,
-                                  ctx->wc_ctx, strip_count,
-                                  ignore_whitespace, remove_tempfiles,
-                                  targets_info,
-                                  ctx->cancel_func, ctx->cancel_baton,
-                                  iterpool, iterpool));
+#if APR_HAS_THREADS
+      if (ab.queue)
+        {
+          SVN_ERR(submit_patch_job(&ab, job, iterpool));
+          continue;
+        }
+#endif
 
-          if (!target->skipped && patch_func)
-            {
-              SVN_ERR(patch_func(patch_baton, &filtered,
-                                 target->canon_path_from_patchfile,
-                                 target->patched_path, target->reject_path,
-                                 iterpool));
-            }
+      SVN_ERR(patch_target_contents(&ab, job, iterpool));
+      SVN_ERR(complete_patch_target(&ab, job->target, iterpool));
+    }
+  while (job);
 
-          if (! filtered)
-            {
-              /* Save info we'll still need when we're done patching. */
-              patch_target_info_t *target_info =
-                apr_pcalloc(scratch_pool, sizeof(patch_target_info_t));
-              target_info->local_abspath = apr_pstrdup(scratch_pool,
-                                                       target->local_abspath);
-              target_info->deleted = target->deleted;
-              target_info->added = target->added;
-
-              if (! target->skipped)
-                {
-                  if (target->has_text_changes
-                      || target->added
-                      || target->move_target_abspath
-                      || target->deleted)
-                    SVN_ERR(install_patched_target(target, root_abspath,
-                                                   ctx, dry_run,
-                                                   targets_info, iterpool));
-
-                  if (target->has_prop_changes && (!target->deleted))
-                    SVN_ERR(install_patched_prop_targets(target, ctx,
-                                                         dry_run, iterpool));
-
-                  SVN_ERR(write_out_rejected_hunks(target, root_abspath,
-                                                   dry_run, iterpool));
-
-                  APR_ARRAY_PUSH(targets_info,
-                                 patch_target_info_t *) = target_info;
-              }
-              SVN_ERR(send_patch_notification(target, ctx, iterpool));
+#if APR_HAS_THREADS
+  if (ab.queue)
+    {
+      patch_queue_t *queue = ab.queue;
 
-              if (target->deleted && !target->skipped)
-                {
-                  SVN_ERR(check_ancestor_delete(target_info->local_abspath,
-                                                targets_info, root_abspath,
-                                                dry_run, ctx,
-                                                scratch_pool, iterpool));
-                }
-            }
-        }
+      SVN_ERR(reap_patch_jobs(&ab, queue->submitted, iterpool));
+
+      ab.queue = NULL;
+      apr_pool_cleanup_run(queue->pool, queue, stop_patch_threads);
     }
-  while (patch);
+#endif
 
   SVN_ERR(svn_diff_close_patch_file(patch_file, iterpool));
   svn_pool_destroy(iterpool);
@@ -511,6 +511,10 @@ svn_client_revprop_set2(const char *propname,
                                     original_propval, propval, pool));
     }
 
+  /* The change is made; a stale log cache entry is no reason to fail. */
+  svn_error_clear(svn_client__log_cache_invalidate(ra_session, *set_rev,
+                                                   ctx, pool));
+
   if (ctx->notify_func2)
     {
       svn_wc_notify_t *notify = svn_wc_create_notify_url(URL,
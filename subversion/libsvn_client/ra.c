@@ -318,17 +318,19 @@ progress_func(apr_off_t progress,
 
 #define SVN_CLIENT__MAX_REDIRECT_ATTEMPTS 3 /* ### TODO:  Make configurable. */
 
-svn_error_t *
-svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
-                                     const char **corrected_url,
-                                     const char *base_url,
-                                     const char *base_dir_abspath,
-                                     const apr_array_header_t *commit_items,
-                                     svn_boolean_t write_dav_props,
-                                     svn_boolean_t read_dav_props,
-                                     svn_client_ctx_t *ctx,
-                                     apr_pool_t *result_pool,
-                                     apr_pool_t *scratch_pool)
+/* Implement svn_client__open_ra_session_internal without using the
+   session cache. */
+static svn_error_t *
+open_ra_session(svn_ra_session_t **ra_session,
+                const char **corrected_url,
+                const char *base_url,
+                const char *base_dir_abspath,
+                const apr_array_header_t *commit_items,
+                svn_boolean_t write_dav_props,
+                svn_boolean_t read_dav_props,
+                svn_client_ctx_t *ctx,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
 {
   svn_ra_callbacks2_t *cbtable;
   callback_baton_t *cb = apr_pcalloc(result_pool, sizeof(*cb));
@@ -461,6 +463,231 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
 }
 #undef SVN_CLIENT__MAX_REDIRECT_ATTEMPTS
 
+/* An entry in svn_client__private_ctx_t.ra_sessions. */
+typedef struct cached_session_t
+{
+  /* The client context that this entry belongs to. */
+  svn_client__private_ctx_t *private_ctx;
+
+  /* The session, allocated in POOL.  NULL for unused entries. */
+  svn_ra_session_t *session;
+
+  /* Repository root URL of SESSION, allocated in POOL. */
+  const char *root_url;
+
+  /* Set while SESSION has been handed out to some caller. */
+  svn_boolean_t in_use;
+
+  /* When SESSION has last been released. */
+  apr_time_t released;
+
+  /* Owns SESSION and ROOT_URL.  Cleared whenever SESSION gets closed. */
+  apr_pool_t *pool;
+} cached_session_t;
+
+/* Close the session in ENTRY and mark it as unused. */
+static void
+close_cached_session(cached_session_t *entry)
+{
+  svn_pool_clear(entry->pool);
+  entry->session = NULL;
+  entry->root_url = NULL;
+  entry->in_use = FALSE;
+}
+
+/* Pool cleanup function making the session in the cached_session_t BATON
+   available for reuse again. */
+static apr_status_t
+release_cached_session(void *baton)
+{
+  cached_session_t *entry = baton;
+
+  entry->in_use = FALSE;
+  entry->released = apr_time_now();
+
+  /* Has the cache been disabled in the meantime? */
+  if (entry->private_ctx->max_ra_sessions == 0)
+    close_cached_session(entry);
+
+  return APR_SUCCESS;
+}
+
+/* Hand out the session in ENTRY until RESULT_POOL gets cleaned up. */
+static void
+claim_cached_session(cached_session_t *entry,
+                     apr_pool_t *result_pool)
+{
+  entry->in_use = TRUE;
+  apr_pool_cleanup_register(result_pool, entry, release_cached_session,
+                            apr_pool_cleanup_null);
+}
+
+/* Set *RA_SESSION to an idle session from PRIVATE_CTX's session cache
+   that can be reparented to BASE_URL.  Reparent and claim it for
+   RESULT_POOL.  Set *RA_SESSION to NULL if there is no such session.
+   In that case, set *FREE_ENTRY to an unused cache entry or NULL if the
+   cache is full.  Close idle sessions that exceeded the idle timeout.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+find_cached_session(svn_ra_session_t **ra_session,
+                    cached_session_t **free_entry,
+                    svn_client__private_ctx_t *private_ctx,
+                    const char *base_url,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *sessions = private_ctx->ra_sessions;
+  apr_time_t now = apr_time_now();
+  int i;
+
+  *ra_session = NULL;
+  *free_entry = NULL;
+
+  if (sessions == NULL)
+    sessions = private_ctx->ra_sessions
+             = apr_array_make(private_ctx->pool, private_ctx->max_ra_sessions,
+                              sizeof(cached_session_t *));
+
+  for (i = 0; i < sessions->nelts; ++i)
+    {
+      cached_session_t *entry = APR_ARRAY_IDX(sessions, i,
+                                              cached_session_t *);
+      if (entry->in_use)
+        continue;
+
+      if (   entry->session
+          && now - entry->released > private_ctx->ra_session_timeout)
+        close_cached_session(entry);
+
+      if (entry->session == NULL)
+        {
+          if (*free_entry == NULL)
+            *free_entry = entry;
+        }
+      else if (svn_uri__is_ancestor(entry->root_url, base_url))
+        {
+          /* The connection may have been closed by the server while
+             being idle.  Don't report that but open a new one. */
+          svn_error_t *err = svn_ra_reparent(entry->session, base_url,
+                                             scratch_pool);
+          if (err)
+            {
+              svn_error_clear(err);
+              close_cached_session(entry);
+              if (*free_entry == NULL)
+                *free_entry = entry;
+              continue;
+            }
+
+          claim_cached_session(entry, result_pool);
+          *ra_session = entry->session;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  if (*free_entry == NULL && sessions->nelts < private_ctx->max_ra_sessions)
+    {
+      cached_session_t *entry = apr_pcalloc(private_ctx->pool,
+                                            sizeof(*entry));
+      entry->private_ctx = private_ctx;
+      entry->pool = svn_pool_create(private_ctx->pool);
+      APR_ARRAY_PUSH(sessions, cached_session_t *) = entry;
+
+      *free_entry = entry;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
+                                     const char **corrected_url,
+                                     const char *base_url,
+                                     const char *base_dir_abspath,
+                                     const apr_array_header_t *commit_items,
+                                     svn_boolean_t write_dav_props,
+                                     svn_boolean_t read_dav_props,
+                                     svn_client_ctx_t *ctx,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  svn_client__private_ctx_t *private_ctx = svn_client__get_private_ctx(ctx);
+  cached_session_t *entry = NULL;
+  svn_error_t *err;
+
+  /* Sessions with working copy callbacks are specific to their caller
+     and cannot be shared. */
+  if (private_ctx->max_ra_sessions > 0
+      && base_dir_abspath == NULL
+      && commit_items == NULL)
+    {
+      SVN_ERR(find_cached_session(ra_session, &entry, private_ctx, base_url,
+                                  result_pool, scratch_pool));
+      if (*ra_session)
+        {
+          if (corrected_url)
+            *corrected_url = NULL;
+
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Cache full or caching not applicable? */
+  if (entry == NULL)
+    return svn_error_trace(open_ra_session(ra_session, corrected_url,
+                                           base_url, base_dir_abspath,
+                                           commit_items, write_dav_props,
+                                           read_dav_props, ctx,
+                                           result_pool, scratch_pool));
+
+  /* Open a new session in the free cache ENTRY. */
+  err = open_ra_session(ra_session, corrected_url, base_url, NULL, NULL,
+                        FALSE, FALSE, ctx, entry->pool, scratch_pool);
+  if (!err)
+    err = svn_ra_get_repos_root2(*ra_session, &entry->root_url, entry->pool);
+
+  if (err)
+    {
+      close_cached_session(entry);
+      return svn_error_trace(err);
+    }
+
+  /* A redirected URL must be returned in RESULT_POOL. */
+  if (corrected_url && *corrected_url)
+    *corrected_url = apr_pstrdup(result_pool, *corrected_url);
+
+  entry->session = *ra_session;
+  claim_cached_session(entry, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_client_set_ra_session_cache(svn_client_ctx_t *ctx,
+                                int max_sessions,
+                                apr_interval_time_t idle_timeout)
+{
+  svn_client__private_ctx_t *private_ctx = svn_client__get_private_ctx(ctx);
+
+  private_ctx->max_ra_sessions = MAX(max_sessions, 0);
+  private_ctx->ra_session_timeout = idle_timeout;
+
+  /* Close idle sessions right away when disabling the cache. */
+  if (private_ctx->max_ra_sessions == 0 && private_ctx->ra_sessions)
+    {
+      int i;
+      for (i = 0; i < private_ctx->ra_sessions->nelts; ++i)
+        {
+          cached_session_t *entry
+            = APR_ARRAY_IDX(private_ctx->ra_sessions, i, cached_session_t *);
+          if (!entry->in_use && entry->session)
+            close_cached_session(entry);
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_client_open_ra_session2(svn_ra_session_t **session,
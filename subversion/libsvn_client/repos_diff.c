@@ -35,6 +35,11 @@
 #include <apr_uri.h>
 #include <apr_md5.h>
 #include <assert.h>
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#endif
 
 #include "svn_checksum.h"
 #include "svn_hash.h"
@@ -48,9 +53,20 @@
 
 #include "client.h"
 
+#include "private/svn_auth_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_editor.h"
+#include "private/svn_ra_private.h"
+
+/* Number of threads, each with its own RA session, that fetch the left
+   sides of opened files while the editor receives the following ones. */
+#define FETCH_THREADS 4
+
+/* Maximum number of fetches whose files have not been released yet, and
+   of closed files that wait to be reported.  These only hold temporary
+   files. */
+#define FETCH_AHEAD (4 * FETCH_THREADS)
 
 /* Overall crawler editor baton.  */
 struct edit_baton {
@@ -88,6 +104,20 @@ struct edit_baton {
   /* A baton to pass to the cancellation callback. */
   void *cancel_baton;
 
+  /* The client context, used to open the sessions of the fetch threads. */
+  svn_client_ctx_t *ctx;
+
+  /* The threads fetching the left sides of opened files, if any, and
+     whether starting them has been tried. */
+  struct fetch_queue_t *fetch_queue;
+  svn_boolean_t fetch_tried;
+
+  /* The closed files that have not been reported yet, in the order they
+     were closed, the last of them and their number. */
+  struct file_baton *closed_files;
+  struct file_baton *last_closed;
+  int closed_count;
+
   apr_pool_t *pool;
 };
 
@@ -193,6 +223,21 @@ struct file_baton {
   /* Holds the checksum of the start revision file */
   svn_checksum_t *start_md5_checksum;
 
+  /* The fetch of the start revision, while it has not been taken over
+     into PATH_START_REVISION, START_MD5_CHECKSUM and PRISTINE_PROPS. */
+  struct fetch_job_t *fetch;
+
+  /* The text delta received while FETCH was running, as svndiff in a
+     temporary file, and the expected checksum of its base. */
+  const char *delta_path;
+  const char *base_md5_digest;
+
+  /* The expected checksum of the second revision, from close_file(). */
+  const char *expected_md5_digest;
+
+  /* The next file in the list of closed files of the edit baton. */
+  struct file_baton *next_closed;
+
   /* Holds the resulting md5 digest of a textdelta transform */
   unsigned char result_digest[APR_MD5_DIGESTSIZE];
   svn_checksum_t *result_md5_checksum;
@@ -352,6 +397,431 @@ get_file_from_ra(struct file_baton *fb,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+finish_closed_files(struct edit_baton *eb,
+                    svn_boolean_t all);
+
+#if APR_HAS_THREADS
+
+typedef struct fetch_queue_t fetch_queue_t;
+
+/* The fetch of revision REVISION of PATH, relative to the session URL,
+   by a thread of QUEUE.  The job lives in the pool of its file baton,
+   while everything that the fetch allocates lives in POOL. */
+typedef struct fetch_job_t
+{
+  fetch_queue_t *queue;
+  const char *path;
+  svn_revnum_t revision;
+  svn_boolean_t props_only;
+
+  /* The temporary file with the text, unless PROPS_ONLY, its MD5
+     checksum and the properties of the file. */
+  const char *tmppath;
+  svn_checksum_t *md5_checksum;
+  apr_hash_t *props;
+  svn_error_t *err;
+
+  /* Set once the fetch has completed. */
+  svn_boolean_t done;
+
+  /* The next job that no thread has taken yet. */
+  struct fetch_job_t *next;
+
+  apr_pool_t *pool;
+} fetch_job_t;
+
+/* A thread of a fetch_queue_t, with an RA session and a client context
+   of its own.  POOL is a root pool holding both. */
+typedef struct fetch_thread_t
+{
+  fetch_queue_t *queue;
+  svn_ra_session_t *ra_session;
+  apr_thread_t *thread;
+  apr_pool_t *pool;
+} fetch_thread_t;
+
+/* The fetches of a diff edit. */
+struct fetch_queue_t
+{
+  /* The jobs that no thread has taken yet, oldest first. */
+  fetch_job_t *pending;
+
+  /* Number of jobs that have not been released yet.  Only used by the
+     thread that drives the editor. */
+  int count;
+
+  /* Set when the threads should exit. */
+  svn_boolean_t stop;
+
+  /* Set once the threads run, and their sessions may no longer ask the
+     auth baton of the client for credentials. */
+  svn_boolean_t detached;
+
+  /* Protects PENDING, STOP and the DONE flags and results of the jobs. */
+  apr_thread_mutex_t *mutex;
+
+  /* Signalled when a job has been submitted or finished. */
+  apr_thread_cond_t *cond;
+
+  fetch_thread_t threads[FETCH_THREADS];
+  int thread_count;
+};
+
+/* Fetch the text, unless JOB->PROPS_ONLY, and the properties of the file
+   of JOB through RA_SESSION, like get_file_from_ra() does. */
+static svn_error_t *
+run_fetch_job(fetch_job_t *job,
+              svn_ra_session_t *ra_session)
+{
+  svn_stream_t *fstream = NULL;
+
+  if (! job->props_only)
+    {
+      SVN_ERR(svn_stream_open_unique(&fstream, &job->tmppath, NULL,
+                                     svn_io_file_del_on_pool_cleanup,
+                                     job->pool, job->pool));
+
+      fstream = svn_stream_checksummed2(fstream, NULL, &job->md5_checksum,
+                                        svn_checksum_md5, TRUE, job->pool);
+    }
+
+  SVN_ERR(svn_ra_get_file(ra_session, job->path, job->revision,
+                          fstream, NULL, &job->props, job->pool));
+
+  if (fstream)
+    SVN_ERR(svn_stream_close(fstream));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements apr_thread_start_t for the fetch_thread_t at DATA. */
+static void * APR_THREAD_FUNC
+fetch_thread(apr_thread_t *tid, void *data)
+{
+  fetch_thread_t *thread = data;
+  fetch_queue_t *queue = thread->queue;
+
+  apr_thread_mutex_lock(queue->mutex);
+  while (!queue->stop)
+    {
+      fetch_job_t *job = queue->pending;
+      svn_error_t *err;
+
+      if (!job)
+        {
+          apr_thread_cond_wait(queue->cond, queue->mutex);
+          continue;
+        }
+
+      queue->pending = job->next;
+      apr_thread_mutex_unlock(queue->mutex);
+
+      err = run_fetch_job(job, thread->ra_session);
+
+      apr_thread_mutex_lock(queue->mutex);
+      job->err = err;
+      job->done = TRUE;
+      apr_thread_cond_broadcast(queue->cond);
+    }
+  apr_thread_mutex_unlock(queue->mutex);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Remove JOB from the pending jobs of its queue and return TRUE, or, if
+   a thread took it already, wait for it to finish and return FALSE.
+   The caller must hold the lock of the queue. */
+static svn_boolean_t
+take_fetch_job(fetch_job_t *job)
+{
+  fetch_queue_t *queue = job->queue;
+  fetch_job_t **link;
+
+  for (link = &queue->pending; *link; link = &(*link)->next)
+    if (*link == job)
+      {
+        *link = job->next;
+        return TRUE;
+      }
+
+  while (!job->done)
+    apr_thread_cond_wait(queue->cond, queue->mutex);
+
+  return FALSE;
+}
+
+/* Release the fetch_job_t at DATA, waiting for it if a thread is still
+   fetching it.  Implements apr_pool_cleanup_t. */
+static apr_status_t
+release_fetch_job(void *data)
+{
+  fetch_job_t *job = data;
+  fetch_queue_t *queue = job->queue;
+
+  apr_thread_mutex_lock(queue->mutex);
+  take_fetch_job(job);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  queue->count--;
+  svn_error_clear(job->err);
+  svn_pool_destroy(job->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Stop the threads of the fetch_queue_t at DATA and close their RA
+   sessions.  Implements apr_pool_cleanup_t. */
+static apr_status_t
+stop_fetch_threads(void *data)
+{
+  fetch_queue_t *queue = data;
+  int i;
+
+  apr_thread_mutex_lock(queue->mutex);
+  queue->stop = TRUE;
+  apr_thread_cond_broadcast(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  for (i = 0; i < queue->thread_count; i++)
+    {
+      apr_status_t retval;
+
+      apr_thread_join(&retval, queue->threads[i].thread);
+      svn_pool_destroy(queue->threads[i].pool);
+    }
+
+  queue->thread_count = 0;
+
+  return APR_SUCCESS;
+}
+
+/* Implements svn_cancel_func_t for the sessions of the fetch threads.
+   BATON is the fetch_queue_t. */
+static svn_error_t *
+fetch_cancel(void *baton)
+{
+  fetch_queue_t *queue = baton;
+  svn_boolean_t stop;
+
+  apr_thread_mutex_lock(queue->mutex);
+  stop = queue->stop;
+  apr_thread_mutex_unlock(queue->mutex);
+
+  return stop ? svn_error_create(SVN_ERR_CANCELLED, NULL, NULL)
+              : SVN_NO_ERROR;
+}
+
+/* Open the RA session of THREAD to SESSION_URL, in THREAD->pool.  Give
+   it a client context of its own, so that the thread never invokes the
+   callbacks of CTX: it gets its cancellation from the queue, doesn't
+   report progress and has an auth baton of its own.  Any prompting
+   happens here, on the calling thread.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+open_fetch_session(fetch_thread_t *thread,
+                   const char *session_url,
+                   svn_client_ctx_t *ctx,
+                   apr_pool_t *scratch_pool)
+{
+  svn_client_ctx_t *thread_ctx;
+
+  SVN_ERR(svn_client_create_context2(&thread_ctx, ctx->config,
+                                     thread->pool));
+  if (ctx->auth_baton)
+    svn_auth__make_thread_auth(&thread_ctx->auth_baton, ctx->auth_baton,
+                               &thread->queue->detached, thread->pool);
+  thread_ctx->client_name = ctx->client_name;
+  thread_ctx->check_tunnel_func = ctx->check_tunnel_func;
+  thread_ctx->open_tunnel_func = ctx->open_tunnel_func;
+  thread_ctx->tunnel_baton = ctx->tunnel_baton;
+  thread_ctx->cancel_func = fetch_cancel;
+  thread_ctx->cancel_baton = thread->queue;
+
+  return svn_error_trace(svn_client_open_ra_session2(&thread->ra_session,
+                                                     session_url, NULL,
+                                                     thread_ctx,
+                                                     thread->pool,
+                                                     scratch_pool));
+}
+
+/* Set up the fetch queue of EB in EB->POOL, if threads and additional
+   RA sessions are available.  Use SCRATCH_POOL for temporary
+   allocations. */
+static void
+start_fetch_threads(struct edit_baton *eb,
+                    apr_pool_t *scratch_pool)
+{
+  fetch_queue_t *queue = apr_pcalloc(eb->pool, sizeof(*queue));
+  const char *session_url;
+  svn_error_t *err;
+  int opened;
+  int i;
+
+  err = svn_ra_get_session_url(eb->ra_session, &session_url, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  if (apr_thread_mutex_create(&queue->mutex, APR_THREAD_MUTEX_DEFAULT,
+                              eb->pool)
+      || apr_thread_cond_create(&queue->cond, eb->pool))
+    return;
+
+  for (opened = 0; opened < FETCH_THREADS; opened++)
+    {
+      fetch_thread_t *thread = &queue->threads[opened];
+
+      thread->queue = queue;
+      thread->pool = svn_pool_create(NULL);
+
+      err = open_fetch_session(thread, session_url, eb->ctx, scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          svn_pool_destroy(thread->pool);
+          break;
+        }
+    }
+
+  /* From here on, the sessions only use the credentials they have. */
+  queue->detached = TRUE;
+
+  for (i = 0; i < opened; i++)
+    {
+      fetch_thread_t *thread = &queue->threads[i];
+
+      if (apr_thread_create(&thread->thread, NULL, fetch_thread, thread,
+                            eb->pool))
+        break;
+
+      ++queue->thread_count;
+    }
+
+  for (; i < opened; i++)
+    svn_pool_destroy(queue->threads[i].pool);
+
+  if (!queue->thread_count)
+    return;
+
+  /* Registered after the mutex and the condition, so that this runs
+     before they are destroyed.  The file batons, and thereby the jobs,
+     live in subpools of EB->POOL and are released before this runs. */
+  apr_pool_cleanup_register(eb->pool, queue, stop_fetch_threads,
+                            apr_pool_cleanup_null);
+  eb->fetch_queue = queue;
+}
+
+/* Start fetching revision FB->base_revision of the file of FB on the
+   fetch threads, starting them first if needed.  Do nothing if there
+   are no threads.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+queue_fetch(struct file_baton *fb,
+            apr_pool_t *scratch_pool)
+{
+  struct edit_baton *eb = fb->edit_baton;
+  fetch_queue_t *queue;
+  fetch_job_t *job;
+  fetch_job_t **link;
+
+  if (!eb->fetch_tried)
+    {
+      eb->fetch_tried = TRUE;
+      start_fetch_threads(eb, scratch_pool);
+    }
+
+  queue = eb->fetch_queue;
+  if (!queue)
+    return SVN_NO_ERROR;
+
+  /* Make room by reporting the files that are closed already.  If the
+     jobs all belong to open files, fetch this one when it is needed. */
+  if (queue->count >= FETCH_AHEAD)
+    SVN_ERR(finish_closed_files(eb, TRUE));
+  if (queue->count >= FETCH_AHEAD)
+    return SVN_NO_ERROR;
+
+  job = apr_pcalloc(fb->pool, sizeof(*job));
+  job->queue = queue;
+  job->pool = svn_pool_create(NULL);
+  job->path = apr_pstrdup(job->pool, fb->path);
+  job->revision = fb->base_revision;
+  job->props_only = ! eb->text_deltas;
+
+  apr_thread_mutex_lock(queue->mutex);
+  for (link = &queue->pending; *link; link = &(*link)->next)
+    ;
+  *link = job;
+  apr_thread_cond_signal(queue->cond);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  queue->count++;
+  apr_pool_cleanup_register(fb->pool, job, release_fetch_job,
+                            apr_pool_cleanup_null);
+  fb->fetch = job;
+
+  return SVN_NO_ERROR;
+}
+
+/* Take over the results of the fetch of FB, running the fetch on this
+   thread if no other thread took it yet. */
+static svn_error_t *
+claim_fetch(struct file_baton *fb)
+{
+  fetch_job_t *job = fb->fetch;
+  svn_boolean_t taken;
+  svn_error_t *err;
+
+  apr_thread_mutex_lock(job->queue->mutex);
+  taken = take_fetch_job(job);
+  apr_thread_mutex_unlock(job->queue->mutex);
+
+  if (taken)
+    {
+      job->err = run_fetch_job(job, fb->edit_baton->ra_session);
+      job->done = TRUE;
+    }
+
+  fb->fetch = NULL;
+  err = job->err;
+  job->err = NULL;
+  SVN_ERR(err);
+
+  if (! job->props_only)
+    {
+      fb->path_start_revision = job->tmppath;
+      fb->start_md5_checksum = job->md5_checksum;
+    }
+  fb->pristine_props = job->props;
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Return TRUE if FB waits for a fetch that has not completed yet. */
+static svn_boolean_t
+fetch_pending(struct file_baton *fb)
+{
+#if APR_HAS_THREADS
+  svn_boolean_t done;
+
+  if (!fb->fetch)
+    return FALSE;
+
+  apr_thread_mutex_lock(fb->fetch->queue->mutex);
+  done = fb->fetch->done;
+  apr_thread_mutex_unlock(fb->fetch->queue->mutex);
+
+  return !done;
+#else
+  return FALSE;
+#endif
+}
+
 /* Remove every no-op property change from CHANGES: that is, remove every
    entry in which the target value is the same as the value of the
    corresponding property in PRISTINE_PROPS.
@@ -635,6 +1105,8 @@ delete_entry(const char *path,
   if (pb->skip_children)
     return SVN_NO_ERROR;
 
+  SVN_ERR(finish_closed_files(eb, TRUE));
+
   scratch_pool = svn_pool_create(eb->pool);
 
   /* We need to know if this is a directory or a file */
@@ -825,6 +1297,11 @@ open_file(const char *path,
                                      eb->processor,
                                      fb->pool, fb->pool));
 
+#if APR_HAS_THREADS
+  if (! fb->skip)
+    SVN_ERR(queue_fetch(fb, pool));
+#endif
+
   return SVN_NO_ERROR;
 }
 
@@ -878,6 +1355,32 @@ lazy_open_result(svn_stream_t **stream,
   return SVN_NO_ERROR;
 }
 
+/* Return an error if BASE_MD5_DIGEST is not NULL and does not match
+   FB->start_md5_checksum. */
+static svn_error_t *
+verify_base_checksum(struct file_baton *fb,
+                     const char *base_md5_digest,
+                     apr_pool_t *scratch_pool)
+{
+  svn_checksum_t *base_md5_checksum;
+
+  if (base_md5_digest == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_checksum_parse_hex(&base_md5_checksum, svn_checksum_md5,
+                                 base_md5_digest, scratch_pool));
+
+  if (!svn_checksum_match(base_md5_checksum, fb->start_md5_checksum))
+    return svn_error_trace(svn_checksum_mismatch_err(
+                                  base_md5_checksum,
+                                  fb->start_md5_checksum,
+                                  scratch_pool,
+                                  _("Base checksum mismatch for '%s'"),
+                                  fb->path));
+
+  return SVN_NO_ERROR;
+}
+
 /* An svn_delta_editor_t function.  */
 static svn_error_t *
 apply_textdelta(void *file_baton,
@@ -912,29 +1415,42 @@ apply_textdelta(void *file_baton,
       return SVN_NO_ERROR;
     }
 
+#if APR_HAS_THREADS
+  /* Rather than waiting for the pristine file, keep the delta until
+     the file is reported. */
+  if (fetch_pending(fb))
+    {
+      svn_stream_t *delta_stream;
+
+      SVN_ERR(svn_stream_open_unique(&delta_stream, &fb->delta_path, NULL,
+                                     svn_io_file_del_on_pool_cleanup,
+                                     fb->pool, scratch_pool));
+      if (base_md5_digest)
+        fb->base_md5_digest = apr_pstrdup(fb->pool, base_md5_digest);
+
+      svn_txdelta_to_svndiff3(handler, handler_baton, delta_stream, 0,
+                              SVN_DELTA_COMPRESSION_LEVEL_NONE, fb->pool);
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
   /* We need the expected pristine file, so go get it */
   if (!fb->added)
-    SVN_ERR(get_file_from_ra(fb, FALSE, scratch_pool));
+    {
+#if APR_HAS_THREADS
+      if (fb->fetch)
+        SVN_ERR(claim_fetch(fb));
+      else
+#endif
+        SVN_ERR(get_file_from_ra(fb, FALSE, scratch_pool));
+    }
   else
     SVN_ERR(get_empty_file(fb->edit_baton, &(fb->path_start_revision)));
 
   SVN_ERR_ASSERT(fb->path_start_revision != NULL);
 
-  if (base_md5_digest != NULL)
-    {
-      svn_checksum_t *base_md5_checksum;
-
-      SVN_ERR(svn_checksum_parse_hex(&base_md5_checksum, svn_checksum_md5,
-                                     base_md5_digest, scratch_pool));
-
-      if (!svn_checksum_match(base_md5_checksum, fb->start_md5_checksum))
-        return svn_error_trace(svn_checksum_mismatch_err(
-                                      base_md5_checksum,
-                                      fb->start_md5_checksum,
-                                      scratch_pool,
-                                      _("Base checksum mismatch for '%s'"),
-                                      fb->path));
-    }
+  SVN_ERR(verify_base_checksum(fb, base_md5_digest, scratch_pool));
 
   /* Open the file to be used as the base for second revision */
   src_stream = svn_stream_lazyopen_create(lazy_open_source, fb, TRUE,
@@ -957,48 +1473,75 @@ apply_textdelta(void *file_baton,
   return SVN_NO_ERROR;
 }
 
-/* An svn_delta_editor_t function.  When the file is closed we have a temporary
- * file containing a pristine version of the repository file. This can
- * be compared against the working copy.
- *
- * ### Ignore TEXT_CHECKSUM for now.  Someday we can use it to verify
- * ### the integrity of the file being diffed.  Done efficiently, this
- * ### would probably involve calculating the checksum as the data is
- * ### received, storing the final checksum in the file_baton, and
- * ### comparing against it here.
- */
+#if APR_HAS_THREADS
+/* Take over the fetched start revision of FB and apply the text delta
+   that was kept while it was fetched, if any. */
 static svn_error_t *
-close_file(void *file_baton,
-           const char *expected_md5_digest,
-           apr_pool_t *pool)
+finish_fetch(struct file_baton *fb,
+             apr_pool_t *scratch_pool)
 {
-  struct file_baton *fb = file_baton;
-  struct dir_baton *pb = fb->parent_baton;
   struct edit_baton *eb = fb->edit_baton;
-  apr_pool_t *scratch_pool;
+  svn_stream_t *src_stream;
+  svn_stream_t *result_stream;
+  svn_stream_t *delta_stream;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
 
-  /* Skip *everything* within a newly tree-conflicted directory. */
-  if (fb->skip)
-    {
-      svn_pool_destroy(fb->pool);
-      SVN_ERR(release_dir(pb));
-      return SVN_NO_ERROR;
-    }
+  SVN_ERR(claim_fetch(fb));
+
+  if (! fb->delta_path)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(verify_base_checksum(fb, fb->base_md5_digest, scratch_pool));
+
+  SVN_ERR(svn_stream_open_readonly(&src_stream, fb->path_start_revision,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(lazy_open_result(&result_stream, fb, fb->pool, scratch_pool));
+
+  svn_txdelta_apply(src_stream, result_stream, fb->result_digest,
+                    fb->path, scratch_pool, &handler, &handler_baton);
+
+  SVN_ERR(svn_stream_open_readonly(&delta_stream, fb->delta_path,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_copy3(delta_stream,
+                           svn_txdelta_parse_svndiff(handler, handler_baton,
+                                                     TRUE, scratch_pool),
+                           eb->cancel_func, eb->cancel_baton,
+                           scratch_pool));
 
-  scratch_pool = fb->pool;
+  fb->result_md5_checksum = svn_checksum__from_digest_md5(fb->result_digest,
+                                                          fb->pool);
 
-  if (expected_md5_digest && eb->text_deltas)
+  return SVN_NO_ERROR;
+}
+#endif
+
+/* Report the closed file FB to the diff processor and release it. */
+static svn_error_t *
+finish_file(struct file_baton *fb)
+{
+  struct dir_baton *pb = fb->parent_baton;
+  struct edit_baton *eb = fb->edit_baton;
+  apr_pool_t *scratch_pool = fb->pool;
+
+#if APR_HAS_THREADS
+  if (fb->fetch
+      && (fb->delta_path || fb->path_end_revision || fb->has_propchange))
+    SVN_ERR(finish_fetch(fb, scratch_pool));
+#endif
+
+  if (fb->expected_md5_digest && eb->text_deltas)
     {
       svn_checksum_t *expected_md5_checksum;
 
       SVN_ERR(svn_checksum_parse_hex(&expected_md5_checksum, svn_checksum_md5,
-                                     expected_md5_digest, scratch_pool));
+                                     fb->expected_md5_digest, scratch_pool));
 
       if (!svn_checksum_match(expected_md5_checksum, fb->result_md5_checksum))
         return svn_error_trace(svn_checksum_mismatch_err(
                                       expected_md5_checksum,
                                       fb->result_md5_checksum,
-                                      pool,
+                                      scratch_pool,
                                       _("Checksum mismatch for '%s'"),
                                       fb->path));
     }
@@ -1055,6 +1598,75 @@ close_file(void *file_baton,
   return SVN_NO_ERROR;
 }
 
+/* Report the closed files of EB to the diff processor, in the order
+   they were closed.  Unless ALL is TRUE, stop at the first file that
+   waits for its fetch, as long as no more than FETCH_AHEAD files are
+   closed. */
+static svn_error_t *
+finish_closed_files(struct edit_baton *eb,
+                    svn_boolean_t all)
+{
+  while (eb->closed_files)
+    {
+      struct file_baton *fb = eb->closed_files;
+
+      if (!all && eb->closed_count <= FETCH_AHEAD && fetch_pending(fb))
+        break;
+
+      eb->closed_files = fb->next_closed;
+      if (!eb->closed_files)
+        eb->last_closed = NULL;
+      eb->closed_count--;
+
+      SVN_ERR(finish_file(fb));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* An svn_delta_editor_t function.  When the file is closed we have a temporary
+ * file containing a pristine version of the repository file. This can
+ * be compared against the working copy.
+ *
+ * Files whose start revision is still being fetched, and all files closed
+ * after them, are reported later by finish_closed_files(), so that the
+ * diff processor sees them in the order they were closed.
+ */
+static svn_error_t *
+close_file(void *file_baton,
+           const char *expected_md5_digest,
+           apr_pool_t *pool)
+{
+  struct file_baton *fb = file_baton;
+  struct dir_baton *pb = fb->parent_baton;
+  struct edit_baton *eb = fb->edit_baton;
+
+  /* Skip *everything* within a newly tree-conflicted directory. */
+  if (fb->skip)
+    {
+      svn_pool_destroy(fb->pool);
+      SVN_ERR(release_dir(pb));
+      return SVN_NO_ERROR;
+    }
+
+  if (expected_md5_digest)
+    fb->expected_md5_digest = apr_pstrdup(fb->pool, expected_md5_digest);
+
+  if (fb->fetch || eb->closed_files)
+    {
+      if (eb->last_closed)
+        eb->last_closed->next_closed = fb;
+      else
+        eb->closed_files = fb;
+      eb->last_closed = fb;
+      eb->closed_count++;
+
+      return svn_error_trace(finish_closed_files(eb, FALSE));
+    }
+
+  return svn_error_trace(finish_file(fb));
+}
+
 /* Report any accumulated prop changes via the 'dir_props_changed' callback,
  * and then call the 'dir_closed' callback.  Notify about any deleted paths
  * within this directory that have not already been notified, and then about
@@ -1072,6 +1684,8 @@ close_directory(void *dir_baton,
   apr_hash_t *pristine_props;
   svn_boolean_t send_changed = FALSE;
 
+  SVN_ERR(finish_closed_files(eb, TRUE));
+
   scratch_pool = db->pool;
 
   if ((db->has_propchange || db->added) && !db->skip)
@@ -1209,6 +1823,8 @@ close_edit(void *edit_baton,
 {
   struct edit_baton *eb = edit_baton;
 
+  SVN_ERR(finish_closed_files(eb, TRUE));
+
   svn_pool_destroy(eb->pool);
 
   return SVN_NO_ERROR;
@@ -1224,6 +1840,7 @@ absent_directory(const char *path,
   struct dir_baton *pb = parent_baton;
   struct edit_baton *eb = pb->edit_baton;
 
+  SVN_ERR(finish_closed_files(eb, TRUE));
   SVN_ERR(eb->processor->node_absent(path, pb->pdb, eb->processor, pool));
 
   return SVN_NO_ERROR;
@@ -1240,6 +1857,7 @@ absent_file(const char *path,
   struct dir_baton *pb = parent_baton;
   struct edit_baton *eb = pb->edit_baton;
 
+  SVN_ERR(finish_closed_files(eb, TRUE));
   SVN_ERR(eb->processor->node_absent(path, pb->pdb, eb->processor, pool));
 
   return SVN_NO_ERROR;
@@ -1351,8 +1969,7 @@ svn_client__get_diff_editor2(const svn_delta_editor_t **editor,
                              svn_revnum_t revision,
                              svn_boolean_t text_deltas,
                              const svn_diff_tree_processor_t *processor,
-                             svn_cancel_func_t cancel_func,
-                             void *cancel_baton,
+                             svn_client_ctx_t *ctx,
                              apr_pool_t *result_pool)
 {
   apr_pool_t *editor_pool = svn_pool_create(result_pool);
@@ -1373,8 +1990,9 @@ svn_client__get_diff_editor2(const svn_delta_editor_t **editor,
   eb->empty_file = NULL;
   eb->empty_hash = apr_hash_make(eb->pool);
   eb->text_deltas = text_deltas;
-  eb->cancel_func = cancel_func;
-  eb->cancel_baton = cancel_baton;
+  eb->cancel_func = ctx->cancel_func;
+  eb->cancel_baton = ctx->cancel_baton;
+  eb->ctx = ctx;
 
   tree_editor->set_target_revision = set_target_revision;
   tree_editor->open_root = open_root;
@@ -1392,7 +2010,8 @@ svn_client__get_diff_editor2(const svn_delta_editor_t **editor,
   tree_editor->absent_directory = absent_directory;
   tree_editor->absent_file = absent_file;
 
-  SVN_ERR(svn_delta_get_cancellation_editor(cancel_func, cancel_baton,
+  SVN_ERR(svn_delta_get_cancellation_editor(ctx->cancel_func,
+                                            ctx->cancel_baton,
                                             tree_editor, eb,
                                             editor, edit_baton,
                                             eb->pool));
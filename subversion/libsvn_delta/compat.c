@@ -37,6 +37,7 @@
 
 #include "private/svn_delta_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
 #include "svn_private_config.h"
 
 
@@ -118,6 +119,10 @@ struct ev2_edit_baton
 
   apr_hash_t *changes;  /* REPOS_RELPATH -> struct change_node  */
 
+  /* REPOS_RELPATH -> apr_array_header_t * of the basenames of all
+     immediate children in CHANGES.  */
+  apr_hash_t *children;
+
   apr_array_header_t *path_order;
   int paths_processed;
 
@@ -157,7 +162,11 @@ struct ev2_file_baton
   struct ev2_edit_baton *eb;
   const char *path;
   svn_revnum_t base_revision;
-  const char *delta_base;
+
+  /* Where the delta base comes from, NULL for plain adds.  We fetch it
+     only when a text delta actually arrives.  */
+  const char *delta_base_relpath;
+  svn_revnum_t delta_base_rev;
 };
 
 enum restructure_action_t
@@ -192,6 +201,7 @@ struct change_node
 
   svn_boolean_t contents_changed; /* the file contents changed */
   const char *contents_abspath;  /* file containing new fulltext  */
+  svn_spillbuf_t *contents_spill;  /* or the new fulltext itself  */
   svn_checksum_t *checksum;  /* checksum of new fulltext  */
 
   /* If COPYFROM_PATH is not NULL, then copy PATH@REV to this node.
@@ -225,6 +235,24 @@ locate_change(struct ev2_edit_baton *eb,
 
   svn_hash_sets(eb->changes, relpath, change);
 
+  /* Index RELPATH by its parent for get_children().  */
+  if (*relpath)
+    {
+      const char *parent_relpath = svn_relpath_dirname(relpath,
+                                                       eb->edit_pool);
+      apr_array_header_t *children = svn_hash_gets(eb->children,
+                                                   parent_relpath);
+
+      if (children == NULL)
+        {
+          children = apr_array_make(eb->edit_pool, 1, sizeof(const char *));
+          svn_hash_sets(eb->children, parent_relpath, children);
+        }
+
+      APR_ARRAY_PUSH(children, const char *)
+        = svn_relpath_basename(relpath, NULL);
+    }
+
   return change;
 }
 
@@ -283,33 +311,17 @@ apply_propedit(struct ev2_edit_baton *eb,
 }
 
 
-/* Find all the paths which are immediate children of PATH and return their
-   basenames in a list. */
-static apr_array_header_t *
+/* Return the basenames of all paths which are immediate children of PATH
+   in a list.  Allocate a new, empty list in POOL if there are none. */
+static const apr_array_header_t *
 get_children(struct ev2_edit_baton *eb,
              const char *path,
              apr_pool_t *pool)
 {
-  apr_array_header_t *children = apr_array_make(pool, 1, sizeof(const char *));
-  apr_hash_index_t *hi;
-
-  for (hi = apr_hash_first(pool, eb->changes); hi; hi = apr_hash_next(hi))
-    {
-      const char *repos_relpath = apr_hash_this_key(hi);
-      const char *child;
+  const apr_array_header_t *children = svn_hash_gets(eb->children, path);
 
-      /* Find potential children. */
-      child = svn_relpath_skip_ancestor(path, repos_relpath);
-      if (!child || !*child)
-        continue;
-
-      /* If we have a path separator, it's a deep child, so just ignore it.
-         ### Is there an API we should be using for this? */
-      if (strchr(child, '/') != NULL)
-        continue;
-
-      APR_ARRAY_PUSH(children, const char *) = child;
-    }
+  if (children == NULL)
+    children = apr_array_make(pool, 0, sizeof(const char *));
 
   return children;
 }
@@ -358,9 +370,12 @@ process_actions(struct ev2_edit_baton *eb,
 
       if (change->contents_abspath)
         {
-          /* ### the checksum might be in CHANGE->CHECKSUM  */
-          SVN_ERR(svn_io_file_checksum2(&checksum, change->contents_abspath,
-                                        svn_checksum_sha1, scratch_pool));
+          /* The checksum has been calculated while writing the file.  */
+          checksum = change->checksum;
+          if (checksum == NULL)
+            SVN_ERR(svn_io_file_checksum2(&checksum,
+                                          change->contents_abspath,
+                                          svn_checksum_sha1, scratch_pool));
           SVN_ERR(svn_stream_open_readonly(&contents, change->contents_abspath,
                                            scratch_pool, scratch_pool));
         }
@@ -708,12 +723,7 @@ ev2_add_file(const char *path,
   fb->base_revision = pb->base_revision;
   *file_baton = fb;
 
-  if (!copyfrom_path)
-    {
-      /* Don't bother fetching the base, as in an add we don't have a base. */
-      fb->delta_base = NULL;
-    }
-  else
+  if (copyfrom_path)
     {
       /* A copy */
 
@@ -721,11 +731,8 @@ ev2_add_file(const char *path,
                                                    fb->eb->edit_pool);
       change->copyfrom_rev = copyfrom_revision;
 
-      SVN_ERR(fb->eb->fetch_base_func(&fb->delta_base,
-                                      fb->eb->fetch_base_baton,
-                                      change->copyfrom_path,
-                                      change->copyfrom_rev,
-                                      result_pool, scratch_pool));
+      fb->delta_base_relpath = change->copyfrom_path;
+      fb->delta_base_rev = change->copyfrom_rev;
     }
 
   return SVN_NO_ERROR;
@@ -753,21 +760,15 @@ ev2_open_file(const char *path,
       /* We're in a copied directory, so the delta base is going to be
          based up on the copy source. */
       const char *name = svn_relpath_basename(relpath, scratch_pool);
-      const char *copyfrom_relpath = svn_relpath_join(pb->copyfrom_relpath,
-                                                      name,
-                                                      scratch_pool);
-
-      SVN_ERR(fb->eb->fetch_base_func(&fb->delta_base,
-                                      fb->eb->fetch_base_baton,
-                                      copyfrom_relpath, pb->copyfrom_rev,
-                                      result_pool, scratch_pool));
+
+      fb->delta_base_relpath = svn_relpath_join(pb->copyfrom_relpath, name,
+                                                result_pool);
+      fb->delta_base_rev = pb->copyfrom_rev;
     }
   else
     {
-      SVN_ERR(fb->eb->fetch_base_func(&fb->delta_base,
-                                      fb->eb->fetch_base_baton,
-                                      relpath, base_revision,
-                                      result_pool, scratch_pool));
+      fb->delta_base_relpath = fb->path;
+      fb->delta_base_rev = base_revision;
     }
 
   *file_baton = fb;
@@ -835,6 +836,7 @@ ev2_apply_textdelta(void *file_baton,
   struct handler_baton *hb = apr_pcalloc(handler_pool, sizeof(*hb));
   struct change_node *change;
   svn_stream_t *target;
+  const char *delta_base = NULL;
 
   change = locate_change(fb->eb, fb->path);
   SVN_ERR_ASSERT(!change->contents_changed);
@@ -843,16 +845,29 @@ ev2_apply_textdelta(void *file_baton,
                  || change->changing == fb->base_revision);
   change->changing = fb->base_revision;
 
-  if (! fb->delta_base)
+  /* Property-only changes never get here, so this is the first time
+     that we actually need the base text.  */
+  if (fb->delta_base_relpath)
+    SVN_ERR(fb->eb->fetch_base_func(&delta_base, fb->eb->fetch_base_baton,
+                                    fb->delta_base_relpath,
+                                    fb->delta_base_rev,
+                                    handler_pool, handler_pool));
+
+  if (! delta_base)
     hb->source = svn_stream_empty(handler_pool);
   else
     hb->source = svn_stream_lazyopen_create(open_delta_base,
-                                            (char*)fb->delta_base,
+                                            (char*)delta_base,
                                             FALSE, handler_pool);
 
+  /* Calculate the checksum on the fly, so process_actions() doesn't
+     need to read the result again.  */
   change->contents_changed = TRUE;
   target = svn_stream_lazyopen_create(open_delta_target, change,
                                       FALSE, fb->eb->edit_pool);
+  target = svn_stream_checksummed2(target, NULL, &change->checksum,
+                                   svn_checksum_sha1, FALSE,
+                                   fb->eb->edit_pool);
 
   svn_txdelta_apply(hb->source, target,
                     NULL, NULL,
@@ -1006,6 +1021,7 @@ svn_delta__delta_from_editor(const svn_delta_editor_t **deditor,
 
   eb->editor = editor;
   eb->changes = apr_hash_make(pool);
+  eb->children = apr_hash_make(pool);
   eb->path_order = apr_array_make(pool, 1, sizeof(const char *));
   eb->edit_pool = pool;
   eb->found_abs_paths = found_abs_paths;
@@ -1057,10 +1073,23 @@ struct editor_baton
   /* REPOS_RELPATH -> struct change_node *  */
   apr_hash_t *changes;
 
+  /* Number of bytes of file contents that CHANGES keeps in memory.  */
+  apr_size_t spooled_in_memory;
+
   apr_pool_t *edit_pool;
 };
 
 
+/* Block size of the spill buffers holding file contents.  */
+#define SPOOL_BLOCKSIZE (16 * 1024)
+
+/* Keep file contents in memory as long as a single file does not exceed
+   SPOOL_MAX_FILE_MEMORY and all of them together stay below
+   SPOOL_MAX_EDIT_MEMORY.  Everything else spills to temporary files.  */
+#define SPOOL_MAX_FILE_MEMORY (256 * 1024)
+#define SPOOL_MAX_EDIT_MEMORY (16 * 1024 * 1024)
+
+
 /* Insert a new change for RELPATH, or return an existing one.  */
 static struct change_node *
 insert_change(const char *relpath,
@@ -1086,6 +1115,46 @@ insert_change(const char *relpath,
 }
 
 
+/* Copy CONTENTS into a new spill buffer of CHANGE and store the MD5
+   checksum of the copied data in CHANGE as well.  CHECKSUM may already
+   be that MD5 checksum.  Use SCRATCH_POOL for temporary allocations.  */
+static svn_error_t *
+spool_contents(struct editor_baton *eb,
+               struct change_node *change,
+               const svn_checksum_t *checksum,
+               svn_stream_t *contents,
+               apr_pool_t *scratch_pool)
+{
+  apr_size_t maxsize = 0;
+  svn_checksum_t *md5_checksum;
+
+  if (eb->spooled_in_memory < SPOOL_MAX_EDIT_MEMORY)
+    maxsize = MIN(SPOOL_MAX_EDIT_MEMORY - eb->spooled_in_memory,
+                  SPOOL_MAX_FILE_MEMORY);
+
+  /* We may need to re-checksum these contents */
+  if (checksum && checksum->kind == svn_checksum_md5)
+    md5_checksum = (svn_checksum_t *)checksum;
+  else
+    contents = svn_stream_checksummed2(contents, &md5_checksum, NULL,
+                                       svn_checksum_md5, TRUE, scratch_pool);
+
+  change->contents_spill = svn_spillbuf__create(SPOOL_BLOCKSIZE, maxsize,
+                                                eb->edit_pool);
+  SVN_ERR(svn_stream_copy3(contents,
+                           svn_stream__from_spillbuf(change->contents_spill,
+                                                     scratch_pool),
+                           NULL, NULL, scratch_pool));
+  eb->spooled_in_memory
+    += (apr_size_t)svn_spillbuf__get_memory_size(change->contents_spill);
+
+  change->contents_changed = TRUE;
+  change->checksum = svn_checksum_dup(md5_checksum, eb->edit_pool);
+
+  return SVN_NO_ERROR;
+}
+
+
 /* This implements svn_editor_cb_add_directory_t */
 static svn_error_t *
 add_directory_cb(void *baton,
@@ -1117,31 +1186,15 @@ add_file_cb(void *baton,
             apr_pool_t *scratch_pool)
 {
   struct editor_baton *eb = baton;
-  const char *tmp_filename;
-  svn_stream_t *tmp_stream;
-  svn_checksum_t *md5_checksum;
   struct change_node *change = insert_change(relpath, eb->changes);
 
-  /* We may need to re-checksum these contents */
-  if (!(checksum && checksum->kind == svn_checksum_md5))
-    contents = svn_stream_checksummed2(contents, &md5_checksum, NULL,
-                                       svn_checksum_md5, TRUE, scratch_pool);
-  else
-    md5_checksum = (svn_checksum_t *)checksum;
-
-  /* Spool the contents to a tempfile, and provide that to the driver. */
-  SVN_ERR(svn_stream_open_unique(&tmp_stream, &tmp_filename, NULL,
-                                 svn_io_file_del_on_pool_cleanup,
-                                 eb->edit_pool, scratch_pool));
-  SVN_ERR(svn_stream_copy3(contents, tmp_stream, NULL, NULL, scratch_pool));
+  /* Spool the contents, and provide them to the driver later. */
+  SVN_ERR(spool_contents(eb, change, checksum, contents, scratch_pool));
 
   change->action = RESTRUCTURE_ADD;
   change->kind = svn_node_file;
   change->deleting = replaces_rev;
   change->props = svn_prop_hash_dup(props, eb->edit_pool);
-  change->contents_changed = TRUE;
-  change->contents_abspath = tmp_filename;
-  change->checksum = svn_checksum_dup(md5_checksum, eb->edit_pool);
 
   return SVN_NO_ERROR;
 }
@@ -1223,7 +1276,6 @@ alter_file_cb(void *baton,
               apr_pool_t *scratch_pool)
 {
   struct editor_baton *eb = baton;
-  svn_stream_t *tmp_stream;
   struct change_node *change = insert_change(relpath, eb->changes);
 
   /* Note: this node may already have information in CHANGE as a result
@@ -1235,30 +1287,9 @@ alter_file_cb(void *baton,
   if (props != NULL)
     change->props = svn_prop_hash_dup(props, eb->edit_pool);
 
+  /* Spool the contents, and provide them to the driver later. */
   if (contents)
-    {
-      const char *tmp_filename;
-      svn_checksum_t *md5_checksum;
-
-      /* We may need to re-checksum these contents */
-      if (checksum && checksum->kind == svn_checksum_md5)
-        md5_checksum = (svn_checksum_t *)checksum;
-      else
-        contents = svn_stream_checksummed2(contents, &md5_checksum, NULL,
-                                           svn_checksum_md5, TRUE,
-                                           scratch_pool);
-
-      /* Spool the contents to a tempfile, and provide that to the driver. */
-      SVN_ERR(svn_stream_open_unique(&tmp_stream, &tmp_filename, NULL,
-                                     svn_io_file_del_on_pool_cleanup,
-                                     eb->edit_pool, scratch_pool));
-      SVN_ERR(svn_stream_copy3(contents, tmp_stream, NULL, NULL,
-                               scratch_pool));
-
-      change->contents_changed = TRUE;
-      change->contents_abspath = tmp_filename;
-      change->checksum = svn_checksum_dup(md5_checksum, eb->edit_pool);
-    }
+    SVN_ERR(spool_contents(eb, change, checksum, contents, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -1695,7 +1726,7 @@ apply_change(void **dir_baton,
   else
     SVN_ERR(drive_ev1_props(eb, relpath, change, file_baton, scratch_pool));
 
-  if (change->contents_changed && change->contents_abspath)
+  if (change->contents_changed && change->contents_spill)
     {
       svn_txdelta_window_handler_t handler;
       void *handler_baton;
@@ -1705,8 +1736,8 @@ apply_change(void **dir_baton,
          ### shim code...  */
       SVN_ERR(eb->deditor->apply_textdelta(file_baton, NULL, scratch_pool,
                                            &handler, &handler_baton));
-      SVN_ERR(svn_stream_open_readonly(&contents, change->contents_abspath,
-                                       scratch_pool, scratch_pool));
+      contents = svn_stream__from_spillbuf(change->contents_spill,
+                                           scratch_pool);
       /* ### it would be nice to send a true txdelta here, but whatever.  */
       SVN_ERR(svn_txdelta_send_stream(contents, handler, handler_baton,
                                       NULL, scratch_pool));
@@ -23,11 +23,13 @@
 
 
 #include <assert.h>
+#include <string.h>
 
 #include <apr_general.h>        /* For APR_INLINE */
 
 #include "svn_delta.h"
 #include "svn_pools.h"
+#include "private/svn_delta_private.h"
 #include "delta.h"
 
 /* Define a MIN macro if this platform doesn't already have one. */
@@ -35,15 +37,21 @@
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
 
+/* Define a MAX macro if this platform doesn't already have one. */
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+/* Minimum number of elements to allocate for any of the scratch arrays. */
+#define MIN_SCRATCH_CAPACITY 16
+
+
 
 /* ==================================================================== */
-/* Support for efficient small-block allocation from pools. */
-
-/* The following structs will be allocated and freed often: */
+/* Reusable scratch arrays. */
 
-/* A node in the range index tree. */
-typedef struct range_index_node_t range_index_node_t;
-struct range_index_node_t
+/* An entry in the range index. */
+typedef struct range_index_node_t
 {
   /* 'offset' and 'limit' define the range in the source window. */
   apr_size_t offset;
@@ -51,23 +59,16 @@ struct range_index_node_t
 
   /* 'target_offset' is where that range is represented in the target. */
   apr_size_t target_offset;
+} range_index_node_t;
 
-  /* 'left' and 'right' link the node into a splay tree. */
-  range_index_node_t *left, *right;
-
-  /* 'prev' and 'next' link it into an ordered, doubly-linked list. */
-  range_index_node_t *prev, *next;
-};
-
-/* A node in a list of ranges for source and target op copies. */
+/* An entry in a list of ranges for source and target op copies. */
 enum range_kind
   {
     range_from_source,
     range_from_target
   };
 
-typedef struct range_list_node_t range_list_node_t;
-struct range_list_node_t
+typedef struct range_list_node_t
 {
   /* Where does the range come from?
      'offset' and 'limit' always refer to the "virtual" source data
@@ -82,47 +83,33 @@ struct range_list_node_t
 
   /* 'target_offset' is the start of the range in the target. */
   apr_size_t target_offset;
-
-  /* 'prev' and 'next' link the node into an ordered, doubly-linked list. */
-  range_list_node_t *prev, *next;
-};
-
-
-/* This is what will be allocated: */
-typedef union alloc_block_t alloc_block_t;
-union alloc_block_t
+} range_list_node_t;
+
+
+/* Make sure that ARRAY, which has room for *CAPACITY elements of
+   ELT_SIZE bytes each and contains USED of them, can hold at least
+   NEEDED elements.  Return the array, which will be reallocated from
+   POOL if it was too small.  Since the old array does not get freed,
+   grow exponentially to keep the total allocation linear. */
+static void *
+ensure_capacity(void *array,
+                apr_size_t *capacity,
+                apr_size_t needed,
+                apr_size_t used,
+                apr_size_t elt_size,
+                apr_pool_t *pool)
 {
-  range_index_node_t index_node;
-  range_list_node_t list_node;
-
-  /* Links free blocks into a freelist. */
-  alloc_block_t *next_free;
-};
+  void *new_array;
 
+  if (needed <= *capacity)
+    return array;
 
-/* Allocate a block. */
-static APR_INLINE void *
-alloc_block(apr_pool_t *pool, alloc_block_t **free_list)
-{
-  alloc_block_t *block;
-  if (*free_list == NULL)
-    block = apr_palloc(pool, sizeof(*block));
-  else
-    {
-      block = *free_list;
-      *free_list = block->next_free;
-    }
-  return block;
-}
+  *capacity = MAX(MAX(needed, 2 * *capacity), MIN_SCRATCH_CAPACITY);
+  new_array = apr_palloc(pool, *capacity * elt_size);
+  if (used)
+    memcpy(new_array, array, used * elt_size);
 
-/* Return the block back to the free list. */
-static APR_INLINE void
-free_block(void *ptr, alloc_block_t **free_list)
-{
-  /* Wrapper functions take care of type safety. */
-  alloc_block_t *const block = ptr;
-  block->next_free = *free_list;
-  *free_list = block;
+  return new_array;
 }
 
 
@@ -134,20 +121,25 @@ typedef struct offset_index_t
 {
   int length;
   apr_size_t *offs;
+
+  /* Number of elements that OFFS can hold. */
+  apr_size_t capacity;
 } offset_index_t;
 
-/* Create an index mapping target stream offsets to delta ops in
-   WINDOW. Allocate from POOL. */
+/* Fill NDX with an index mapping target stream offsets to delta ops in
+   WINDOW.  Grow the index from POOL if necessary. */
 
-static offset_index_t *
-create_offset_index(const svn_txdelta_window_t *window, apr_pool_t *pool)
+static void
+fill_offset_index(offset_index_t *ndx,
+                  const svn_txdelta_window_t *window,
+                  apr_pool_t *pool)
 {
-  offset_index_t *ndx = apr_palloc(pool, sizeof(*ndx));
   apr_size_t offset = 0;
   int i;
 
   ndx->length = window->num_ops;
-  ndx->offs = apr_palloc(pool, (ndx->length + 1) * sizeof(*ndx->offs));
+  ndx->offs = ensure_capacity(ndx->offs, &ndx->capacity, ndx->length + 1,
+                              0, sizeof(*ndx->offs), pool);
 
   for (i = 0; i < ndx->length; ++i)
     {
@@ -155,8 +147,6 @@ create_offset_index(const svn_txdelta_window_t *window, apr_pool_t *pool)
       offset += window->ops[i].length;
     }
   ndx->offs[ndx->length] = offset;
-
-  return ndx;
 }
 
 /* Find the index of the delta op thet defines that data at OFFSET in
@@ -212,164 +202,88 @@ search_offset_index(const offset_index_t *ndx,
 /* ==================================================================== */
 /* Mapping ranges in the source stream to ranges in the composed delta. */
 
-/* The range index tree. */
+/* The range index.  This is a flat array of non-redundant ranges,
+   sorted by 'offset'.  Both, the offsets and the limits of the ranges
+   are strictly increasing, so a simple binary search finds the range
+   that covers a given offset and its successors are simply the next
+   elements in the array.  Since new ranges typically get appended at
+   the end or close to it, inserting and cleaning up is cheap, too. */
 typedef struct range_index_t
 {
-  range_index_node_t *tree;
-  alloc_block_t *free_list;
+  /* The ranges and how many of them there are. */
+  range_index_node_t *nodes;
+  apr_size_t length;
+
+  /* Number of elements that NODES can hold. */
+  apr_size_t capacity;
+
+  /* Scratch array for the results of build_range_list(). */
+  range_list_node_t *list;
+  apr_size_t list_capacity;
+
+  /* Scratch arrays get (re-)allocated in this pool. */
   apr_pool_t *pool;
 } range_index_t;
 
-/* Create a range index tree. Allocate from POOL. */
+/* Create an empty range index. Allocate from POOL. */
 static range_index_t *
 create_range_index(apr_pool_t *pool)
 {
-  range_index_t *ndx = apr_palloc(pool, sizeof(*ndx));
-  ndx->tree = NULL;
+  range_index_t *ndx = apr_pcalloc(pool, sizeof(*ndx));
   ndx->pool = pool;
-  ndx->free_list = NULL;
   return ndx;
 }
 
-/* Allocate a node for the range index tree. */
-static range_index_node_t *
-alloc_range_index_node(range_index_t *ndx,
-                       apr_size_t offset,
-                       apr_size_t limit,
-                       apr_size_t target_offset)
+/* Return the number of ranges in NDX that start at or before OFFSET,
+   i.e. the position of the first range that starts after OFFSET. */
+static apr_size_t
+search_range_index(const range_index_t *ndx, apr_size_t offset)
 {
-  range_index_node_t *const node = alloc_block(ndx->pool, &ndx->free_list);
-  node->offset = offset;
-  node->limit = limit;
-  node->target_offset = target_offset;
-  node->left = node->right = NULL;
-  node->prev = node->next = NULL;
-  return node;
-}
+  apr_size_t lo = 0;
+  apr_size_t hi = ndx->length;
 
-/* Free a node from the range index tree. */
-static void
-free_range_index_node(range_index_t *ndx, range_index_node_t *node)
-{
-  if (node->next)
-    node->next->prev = node->prev;
-  if (node->prev)
-    node->prev->next = node->next;
-  free_block(node, &ndx->free_list);
-}
+  /* Most of the time, we look behind the last range. */
+  if (hi == 0 || ndx->nodes[hi - 1].offset <= offset)
+    return hi;
 
+  while (lo < hi)
+    {
+      const apr_size_t mid = lo + (hi - lo) / 2;
+      if (ndx->nodes[mid].offset <= offset)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
 
-/* Splay the index tree, using OFFSET as the key. */
+  return lo;
+}
 
+/* Insert the range [OFFSET, LIMIT) mapped to TARGET_OFFSET at position
+   POS into NDX. */
 static void
-splay_range_index(apr_size_t offset, range_index_t *ndx)
+insert_range_node(range_index_t *ndx,
+                  apr_size_t pos,
+                  apr_size_t offset,
+                  apr_size_t limit,
+                  apr_size_t target_offset)
 {
-  range_index_node_t *tree = ndx->tree;
-  range_index_node_t scratch_node;
-  range_index_node_t *left, *right;
-
-  if (tree == NULL)
-    return;
-
-  scratch_node.left = scratch_node.right = NULL;
-  left = right = &scratch_node;
-
-  for (;;)
-    {
-      if (offset < tree->offset)
-        {
-          if (tree->left != NULL
-              && offset < tree->left->offset)
-            {
-              /* Right rotation */
-              range_index_node_t *const node = tree->left;
-              tree->left = node->right;
-              node->right = tree;
-              tree = node;
-            }
-          if (tree->left == NULL)
-            break;
-
-          /* Remember the right subtree */
-          right->left = tree;
-          right = tree;
-          tree = tree->left;
-        }
-      else if (offset > tree->offset)
-        {
-          if (tree->right != NULL
-              && offset > tree->right->offset)
-            {
-              /* Left rotation */
-              range_index_node_t *const node = tree->right;
-              tree->right = node->left;
-              node->left = tree;
-              tree = node;
-            }
-          if (tree->right == NULL)
-            break;
-
-          /* Remember the left subtree */
-          left->right = tree;
-          left = tree;
-          tree = tree->right;
-        }
-      else
-        break;
-    }
+  range_index_node_t *node;
 
-  /* Link in the left and right subtrees */
-  left->right = tree->left;
-  right->left = tree->right;
-  tree->left  = scratch_node.right;
-  tree->right = scratch_node.left;
-
-  /* The basic top-down splay is finished, but we may still need to
-     turn the tree around. What we want is to put the node with the
-     largest offset where node->offset <= offset at the top of the
-     tree, so that we can insert the new data (or search for existing
-     ranges) to the right of the root. This makes cleaning up the
-     tree after an insert much simpler, and -- incidentally -- makes
-     the whole range index magic work. */
-  if (offset < tree->offset && tree->left != NULL)
-    {
-      if (tree->left->right == NULL)
-        {
-          /* A single right rotation is enough. */
-          range_index_node_t *const node = tree->left;
-          tree->left = node->right; /* Which is always NULL. */
-          node->right = tree;
-          tree = node;
-        }
-      else
-        {
-          /* Slide down to the rightmost node in the left subtree. */
-          range_index_node_t **nodep = &tree->left;
-          while ((*nodep)->right != NULL)
-            nodep = &(*nodep)->right;
-
-          /* Now move this node to root in one giant promotion. */
-          right = tree;
-          left = tree->left;
-          tree = *nodep;
-          *nodep = tree->left;
-          right->left = tree->right; /* Which is always NULL, too. */
-          tree->left = left;
-          tree->right = right;
-        }
-    }
+  ndx->nodes = ensure_capacity(ndx->nodes, &ndx->capacity, ndx->length + 1,
+                               ndx->length, sizeof(*ndx->nodes), ndx->pool);
+  node = &ndx->nodes[pos];
+  memmove(node + 1, node, (ndx->length - pos) * sizeof(*node));
+  ++ndx->length;
 
-  /* Sanity check ... */
-  assert((offset >= tree->offset)
-         || ((tree->left == NULL)
-             && (tree->prev == NULL)));
-  ndx->tree = tree;
+  node->offset = offset;
+  node->limit = limit;
+  node->target_offset = target_offset;
 }
 
-
-/* Remove all ranges from NDX that fall into the root's range.  To
-   keep the range index as small as possible, we must also remove
-   nodes that don't fall into the new range, but have become redundant
+/* Remove all ranges from NDX that follow the range at position POS and
+   that have been superseded by it.  LIMIT is the limit of that range.
+   To keep the range index as small as possible, we must also remove
+   ranges that don't fall into the new range, but have become redundant
    because the new range overlaps the beginning of the next range.
    Like this:
 
@@ -382,131 +296,94 @@ splay_range_index(apr_size_t offset, range_index_t *ndx)
    range-1, which has become redundant now.
 
    FIXME: But, of course, there's a catch. range-1 must still remain
-   in the tree if we want to optimize the number of target copy ops in
+   in the index if we want to optimize the number of target copy ops in
    the case were a copy falls within range-1, but starts before
    range-2 and ends after new-range. */
 
 static void
-delete_subtree(range_index_t *ndx, range_index_node_t *node)
-{
-  if (node != NULL)
-    {
-      delete_subtree(ndx, node->left);
-      delete_subtree(ndx, node->right);
-      free_range_index_node(ndx, node);
-    }
-}
-
-static void
-clean_tree(range_index_t *ndx, apr_size_t limit)
+clean_range_index(range_index_t *ndx, apr_size_t pos, apr_size_t limit)
 {
-  apr_size_t top_offset = limit + 1;
-  range_index_node_t **nodep = &ndx->tree->right;
-  while (*nodep != NULL)
+  apr_size_t first = pos + 1;
+  apr_size_t last = first;
+
+  /* Because offsets and limits are ordered, the superseded ranges
+     form a contiguous block. */
+  while (last < ndx->length
+         && (ndx->nodes[last].limit <= limit
+             || (ndx->nodes[last].offset < limit
+                 && last + 1 < ndx->length
+                 && ndx->nodes[last + 1].offset < limit)))
+    ++last;
+
+  if (last > first)
     {
-      range_index_node_t *const node = *nodep;
-      apr_size_t const offset =
-        (node->right != NULL && node->right->offset < top_offset
-         ? node->right->offset
-         : top_offset);
-
-      if (node->limit <= limit
-          || (node->offset < limit && offset < limit))
-        {
-          *nodep = node->right;
-          node->right = NULL;
-          delete_subtree(ndx, node);
-        }
-      else
-        {
-          top_offset = node->offset;
-          nodep = &node->left;
-        }
+      memmove(&ndx->nodes[first], &ndx->nodes[last],
+              (ndx->length - last) * sizeof(*ndx->nodes));
+      ndx->length -= last - first;
     }
 }
 
 
 /* Add a range [OFFSET, LIMIT) into NDX. If NDX already contains a
    range that encloses [OFFSET, LIMIT), do nothing. Otherwise, remove
-   all ranges from NDX that are superseded by the new range.
-   NOTE: The range index must be splayed to OFFSET! */
+   all ranges from NDX that are superseded by the new range. */
 
 static void
 insert_range(apr_size_t offset, apr_size_t limit, apr_size_t target_offset,
              range_index_t *ndx)
 {
-  range_index_node_t *node = NULL;
+  /* The range with the largest offset not after OFFSET, if any. */
+  const apr_size_t count = search_range_index(ndx, offset);
+  range_index_node_t *node;
+  apr_size_t pos;
+
+  if (count == 0)
+    {
+      /* Insert the range in front of all others. */
+      pos = 0;
+      insert_range_node(ndx, pos, offset, limit, target_offset);
+      clean_range_index(ndx, pos, limit);
+      return;
+    }
+
+  pos = count - 1;
+  node = &ndx->nodes[pos];
+  if (limit <= node->limit)
+    /* Ignore the range */
+    return;
 
-  if (ndx->tree == NULL)
+  if (offset == node->offset)
     {
-      node = alloc_range_index_node(ndx, offset, limit, target_offset);
-      ndx->tree = node;
+      node->limit = limit;
+      node->target_offset = target_offset;
     }
   else
     {
-      if (offset == ndx->tree->offset
-          && limit > ndx->tree->limit)
+      /* The new range may be completely covered by NODE and its
+         successor. */
+      if (count < ndx->length
+          && node->limit >= node[1].offset
+          && limit <= node[1].limit)
+        return;
+
+      /* Again, we have to check if the new range and the one
+         to the left of NODE override NODE's range. */
+      if (pos > 0 && node[-1].limit > offset)
         {
-          ndx->tree->limit = limit;
-          ndx->tree->target_offset = target_offset;
-          clean_tree(ndx, limit);
-        }
-      else if (offset > ndx->tree->offset
-               && limit > ndx->tree->limit)
-        {
-          /* We have to make the same sort of checks as clean_tree()
-             does for superseded ranges. Have to merge these someday. */
-
-          const svn_boolean_t insert_range_p =
-            (!ndx->tree->next
-             || ndx->tree->limit < ndx->tree->next->offset
-             || limit > ndx->tree->next->limit);
-
-          if (insert_range_p)
-            {
-              /* Again, we have to check if the new node and the one
-                 to the left of the root override root's range. */
-              if (ndx->tree->prev && ndx->tree->prev->limit > offset)
-                {
-                  /* Replace the data in the splayed node. */
-                  ndx->tree->offset = offset;
-                  ndx->tree->limit = limit;
-                  ndx->tree->target_offset = target_offset;
-                }
-              else
-                {
-                  /* Insert the range to the right of the splayed node. */
-                  node = alloc_range_index_node(ndx, offset, limit,
-                                                target_offset);
-                  if ((node->next = ndx->tree->next) != NULL)
-                    node->next->prev = node;
-                  ndx->tree->next = node;
-                  node->prev = ndx->tree;
-
-                  node->right = ndx->tree->right;
-                  ndx->tree->right = NULL;
-                  node->left = ndx->tree;
-                  ndx->tree = node;
-                }
-              clean_tree(ndx, limit);
-            }
-          else
-            /* Ignore the range */;
+          /* Replace the data in NODE. */
+          node->offset = offset;
+          node->limit = limit;
+          node->target_offset = target_offset;
         }
-      else if (offset < ndx->tree->offset)
+      else
         {
-          assert(ndx->tree->left == NULL);
-
-          /* Insert the range left of the splayed node */
-          node = alloc_range_index_node(ndx, offset, limit, target_offset);
-          node->left = node->prev = NULL;
-          node->right = node->next = ndx->tree;
-          ndx->tree = node->next->prev = node;
-          clean_tree(ndx, limit);
+          /* Insert the range to the right of NODE. */
+          ++pos;
+          insert_range_node(ndx, pos, offset, limit, target_offset);
         }
-      else
-        /* Ignore the range */;
     }
+
+  clean_range_index(ndx, pos, limit);
 }
 
 
@@ -514,80 +391,67 @@ insert_range(apr_size_t offset, apr_size_t limit, apr_size_t target_offset,
 /* ==================================================================== */
 /* Juggling with lists of ranges. */
 
-/* Allocate a node and add it to the range list. LIST is the head of
-   the range list, TAIL is the last node in the list. NDX holds the
-   freelist; OFFSET, LIMIT and KIND are node data. */
-static range_list_node_t *
-alloc_range_list(range_list_node_t **list,
-                 range_list_node_t **tail,
-                 range_index_t *ndx,
-                 enum range_kind kind,
-                 apr_size_t offset,
-                 apr_size_t limit,
-                 apr_size_t target_offset)
+/* Append a range to NDX's list of ranges, which currently contains
+   *COUNT entries. KIND, OFFSET, LIMIT and TARGET_OFFSET are the data. */
+static APR_INLINE void
+append_range(range_index_t *ndx,
+             apr_size_t *count,
+             enum range_kind kind,
+             apr_size_t offset,
+             apr_size_t limit,
+             apr_size_t target_offset)
 {
-  range_list_node_t *const node = alloc_block(ndx->pool, &ndx->free_list);
+  range_list_node_t *const node = &ndx->list[(*count)++];
   node->kind = kind;
   node->offset = offset;
   node->limit = limit;
   node->target_offset = target_offset;
-  if (*list == NULL)
-    {
-      node->prev = node->next = NULL;
-      *list = *tail = node;
-    }
-  else
-    {
-      node->prev = *tail;
-      node->next = NULL;
-      (*tail)->next = node;
-      *tail = node;
-    }
-  return *list;
-}
-
-/* Free a range list. LIST is the head of the list, NDX holds the freelist. */
-static void
-free_range_list(range_list_node_t *list, range_index_t *ndx)
-{
-  while (list)
-    {
-      range_list_node_t *const node = list;
-      list = node->next;
-      free_block(node, &ndx->free_list);
-    }
 }
 
 
 /* Based on the data in NDX, build a list of ranges that cover
-   [OFFSET, LIMIT) in the "virtual" source data.
-   NOTE: The range index must be splayed to OFFSET! */
+   [OFFSET, LIMIT) in the "virtual" source data.  The result will be
+   in NDX->LIST, ordered by offset.  Return the number of ranges. */
 
-static range_list_node_t *
+static apr_size_t
 build_range_list(apr_size_t offset, apr_size_t limit, range_index_t *ndx)
 {
-  range_list_node_t *range_list = NULL;
-  range_list_node_t *last_range = NULL;
-  range_index_node_t *node = ndx->tree;
+  apr_size_t count = 0;
+  apr_size_t i = search_range_index(ndx, offset);
+
+  /* Start at the range that contains OFFSET, if there is any. */
+  if (i > 0)
+    --i;
+
+  /* Every range in the index contributes at most one source and one
+     target range to the list. */
+  ndx->list = ensure_capacity(ndx->list, &ndx->list_capacity,
+                              2 * (ndx->length - i) + 1, 0,
+                              sizeof(*ndx->list), ndx->pool);
 
   while (offset < limit)
     {
-      if (node == NULL)
-        return alloc_range_list(&range_list, &last_range, ndx,
-                                range_from_source,
-                                offset, limit, 0);
+      const range_index_node_t *node;
+
+      if (i == ndx->length)
+        {
+          append_range(ndx, &count, range_from_source, offset, limit, 0);
+          return count;
+        }
 
+      node = &ndx->nodes[i];
       if (offset < node->offset)
         {
           if (limit <= node->offset)
-            return alloc_range_list(&range_list, &last_range, ndx,
-                                    range_from_source,
-                                    offset, limit, 0);
+            {
+              append_range(ndx, &count, range_from_source,
+                           offset, limit, 0);
+              return count;
+            }
           else
             {
-              alloc_range_list(&range_list, &last_range, ndx,
-                               range_from_source,
-                               offset, node->offset, 0);
+              append_range(ndx, &count, range_from_source,
+                           offset, node->offset, 0);
               offset = node->offset;
             }
         }
@@ -600,23 +464,24 @@ build_range_list(apr_size_t offset, apr_size_t limit, range_index_t *ndx)
              uses vdelta). */
 
           if (offset >= node->limit)
-            node = node->next;
+            ++i;
           else
             {
               const apr_size_t target_offset =
                 offset - node->offset + node->target_offset;
 
               if (limit <= node->limit)
-                return alloc_range_list(&range_list, &last_range, ndx,
-                                        range_from_target,
-                                        offset, limit, target_offset);
+                {
+                  append_range(ndx, &count, range_from_target,
+                               offset, limit, target_offset);
+                  return count;
+                }
               else
                 {
-                  alloc_range_list(&range_list, &last_range, ndx,
-                                   range_from_target,
-                                   offset, node->limit, target_offset);
+                  append_range(ndx, &count, range_from_target,
+                               offset, node->limit, target_offset);
                   offset = node->limit;
-                  node = node->next;
+                  ++i;
                 }
             }
         }
@@ -759,20 +624,45 @@ copy_source_ops(apr_size_t offset, apr_size_t limit,
 /* ==================================================================== */
 /* Bringing it all together. */
 
+struct svn_txdelta__composer_t
+{
+  /* Maps window_A's target offsets to its ops. */
+  offset_index_t offset_index;
+
+  /* Maps ranges of window_A's target to the composite's target. */
+  range_index_t *range_index;
+
+  /* All scratch arrays are allocated from this pool. */
+  apr_pool_t *pool;
+};
+
+svn_txdelta__composer_t *
+svn_txdelta__composer_create(apr_pool_t *result_pool)
+{
+  svn_txdelta__composer_t *composer = apr_pcalloc(result_pool,
+                                                  sizeof(*composer));
+  composer->range_index = create_range_index(result_pool);
+  composer->pool = result_pool;
+
+  return composer;
+}
 
 svn_txdelta_window_t *
-svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
-                            const svn_txdelta_window_t *window_B,
-                            apr_pool_t *pool)
+svn_txdelta__compose_windows(svn_txdelta__composer_t *composer,
+                             const svn_txdelta_window_t *window_A,
+                             const svn_txdelta_window_t *window_B,
+                             apr_pool_t *pool)
 {
   svn_txdelta__ops_baton_t build_baton = { 0 };
   svn_txdelta_window_t *composite;
-  apr_pool_t *subpool = svn_pool_create(pool);
-  offset_index_t *offset_index = create_offset_index(window_A, subpool);
-  range_index_t *range_index = create_range_index(subpool);
+  offset_index_t *offset_index = &composer->offset_index;
+  range_index_t *range_index = composer->range_index;
   apr_size_t target_offset = 0;
   int i;
 
+  fill_offset_index(offset_index, window_A, composer->pool);
+  range_index->length = 0;
+
   /* Read the description of the delta composition algorithm in
      notes/fs-improvements.txt before going any further.
      You have been warned. */
@@ -799,14 +689,14 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
              same as window_A's _target_ stream! */
           const apr_size_t offset = op->offset;
           const apr_size_t limit = op->offset + op->length;
-          range_list_node_t *range_list, *range;
+          apr_size_t range_count, k;
           apr_size_t tgt_off = target_offset;
 
-          splay_range_index(offset, range_index);
-          range_list = build_range_list(offset, limit, range_index);
+          range_count = build_range_list(offset, limit, range_index);
 
-          for (range = range_list; range; range = range->next)
+          for (k = 0; k < range_count; ++k)
             {
+              const range_list_node_t *const range = &range_index->list[k];
               if (range->kind == range_from_target)
                 svn_txdelta__insert_op(&build_baton, svn_txdelta_target,
                                        range->target_offset,
@@ -821,7 +711,6 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
             }
           assert(tgt_off == target_offset + op->length);
 
-          free_range_list(range_list, range_index);
           insert_range(offset, limit, target_offset, range_index);
         }
 
@@ -829,11 +718,25 @@ svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
       target_offset += op->length;
     }
 
-  svn_pool_destroy(subpool);
-
   composite = svn_txdelta__make_window(&build_baton, pool);
   composite->sview_offset = window_A->sview_offset;
   composite->sview_len = window_A->sview_len;
   composite->tview_len = window_B->tview_len;
   return composite;
 }
+
+svn_txdelta_window_t *
+svn_txdelta_compose_windows(const svn_txdelta_window_t *window_A,
+                            const svn_txdelta_window_t *window_B,
+                            apr_pool_t *pool)
+{
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_txdelta__composer_t *composer = svn_txdelta__composer_create(subpool);
+  svn_txdelta_window_t *composite;
+
+  composite = svn_txdelta__compose_windows(composer, window_A, window_B,
+                                           pool);
+  svn_pool_destroy(subpool);
+
+  return composite;
+}
@@ -24,6 +24,11 @@
 
 #include <assert.h>
 #include <string.h>
+
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+
 #include "svn_delta.h"
 #include "svn_io.h"
 #include "delta.h"
@@ -39,13 +44,16 @@
 static const char SVNDIFF_V0[] = { 'S', 'V', 'N', 0 };
 static const char SVNDIFF_V1[] = { 'S', 'V', 'N', 1 };
 static const char SVNDIFF_V2[] = { 'S', 'V', 'N', 2 };
+static const char SVNDIFF_V3[] = { 'S', 'V', 'N', 3 };
 
 #define SVNDIFF_HEADER_SIZE (sizeof(SVNDIFF_V0))
 
 static const char *
 get_svndiff_header(int version)
 {
-  if (version == 2)
+  if (version == 3)
+    return SVNDIFF_V3;
+  else if (version == 2)
     return SVNDIFF_V2;
   else if (version == 1)
     return SVNDIFF_V1;
@@ -198,7 +206,15 @@ encode_window(svn_stringbuf_t **instructions_p,
   append_encoded_int(header, window->sview_offset);
   append_encoded_int(header, window->sview_len);
   append_encoded_int(header, window->tview_len);
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *compressed_instructions;
+      compressed_instructions = svn_stringbuf_create_empty(pool);
+      SVN_ERR(svn__compress_zstd(instructions->data, instructions->len,
+                                 compressed_instructions, compression_level));
+      instructions = compressed_instructions;
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *compressed_instructions;
       compressed_instructions = svn_stringbuf_create_empty(pool);
@@ -217,7 +233,15 @@ encode_window(svn_stringbuf_t **instructions_p,
   append_encoded_int(header, instructions->len);
 
   /* Encode the data. */
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__compress_zstd(window->new_data->data, window->new_data->len,
+                                 compressed, compression_level));
+      newdata = svn_stringbuf__morph_into_string(compressed);
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
 
@@ -245,6 +269,32 @@ encode_window(svn_stringbuf_t **instructions_p,
   return SVN_NO_ERROR;
 }
 
+/* Write the parts of an encoded window, as returned by encode_window(),
+   to OUTPUT. */
+static svn_error_t *
+write_encoded_window(svn_stream_t *output,
+                     const svn_stringbuf_t *header,
+                     const svn_stringbuf_t *instructions,
+                     const svn_string_t *newdata)
+{
+  apr_size_t len;
+
+  len = header->len;
+  SVN_ERR(svn_stream_write(output, header->data, &len));
+  if (instructions->len > 0)
+    {
+      len = instructions->len;
+      SVN_ERR(svn_stream_write(output, instructions->data, &len));
+    }
+  if (newdata->len > 0)
+    {
+      len = newdata->len;
+      SVN_ERR(svn_stream_write(output, newdata->data, &len));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Note: When changing things here, check the related comment in
    the svn_txdelta_to_svndiff_stream() function.  */
 static svn_error_t *
@@ -285,21 +335,8 @@ window_handler(svn_txdelta_window_t *window, void *baton)
                         eb->version, eb->compression_level,
                         eb->scratch_pool));
 
-  /* Write out the window.  */
-  len = header->len;
-  SVN_ERR(svn_stream_write(eb->output, header->data, &len));
-  if (instructions->len > 0)
-    {
-      len = instructions->len;
-      SVN_ERR(svn_stream_write(eb->output, instructions->data, &len));
-    }
-  if (newdata->len > 0)
-    {
-      len = newdata->len;
-      SVN_ERR(svn_stream_write(eb->output, newdata->data, &len));
-    }
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(write_encoded_window(eb->output, header,
+                                              instructions, newdata));
 }
 
 void
@@ -323,6 +360,349 @@ svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
   *handler_baton = eb;
 }
 
+#if APR_HAS_THREADS
+
+/* Parallel svndiff encoding.
+ *
+ * Windows are independent of each other once produced, so worker threads
+ * may compress them concurrently.  The calling thread copies each window
+ * into the next free slot of a ring buffer and writes the encoded slots
+ * to the output stream in order.  QUEUED, STARTED and SHUTDOWN in
+ * parallel_encoder_t as well as the STATE of all slots must only be
+ * modified while holding MUTEX.  A slot's other members belong to the
+ * calling thread while the slot is empty or done and to a worker while
+ * it is busy.
+ */
+
+/* Processing state of a window slot. */
+typedef enum slot_state_t
+{
+  slot_empty,
+  slot_pending,
+  slot_busy,
+  slot_done
+} slot_state_t;
+
+/* A window and, once encoded, its svndiff representation. */
+typedef struct encoder_slot_t
+{
+  slot_state_t state;
+
+  /* Copy of the window to encode, allocated in POOL. */
+  svn_txdelta_window_t *window;
+
+  /* Encoder results, allocated in POOL. */
+  svn_stringbuf_t *instructions;
+  svn_stringbuf_t *header;
+  const svn_string_t *newdata;
+  svn_error_t *err;
+
+  /* Root pool with its own allocator, so it may be used by any thread. */
+  apr_pool_t *pool;
+} encoder_slot_t;
+
+/* Baton for the parallel window handler. */
+typedef struct parallel_encoder_t
+{
+  /* Encoder parameters. */
+  svn_stream_t *output;
+  int version;
+  int compression_level;
+  svn_boolean_t header_done;
+
+  /* Ring buffer of window slots and its size. */
+  encoder_slot_t *slots;
+  int slot_count;
+
+  /* Number of windows queued, picked up by workers and written so far.
+   * Window N lives in slot N % SLOT_COUNT. */
+  apr_size_t queued;
+  apr_size_t started;
+  apr_size_t written;
+
+  /* If set, workers shall terminate. */
+  svn_boolean_t shutdown;
+
+  /* Serialization and signalling of state changes. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+
+  /* The worker threads.  They only get started once the second window
+   * arrives, so small deltas never pay for thread creation. */
+  apr_thread_t **threads;
+  int thread_count;
+  int max_threads;
+
+  /* If set, encode all windows on the calling thread. */
+  svn_boolean_t serial;
+
+  /* Pool for the threads and for windows encoded on the calling thread. */
+  apr_pool_t *pool;
+  apr_pool_t *scratch_pool;
+} parallel_encoder_t;
+
+/* Worker thread main function.  DATA is the parallel_encoder_t.
+ * Encode queued windows until told to shut down.
+ */
+static void *
+APR_THREAD_FUNC encoder_thread_func(apr_thread_t *tid, void *data)
+{
+  parallel_encoder_t *pe = data;
+
+  while (TRUE)
+    {
+      encoder_slot_t *slot;
+
+      apr_thread_mutex_lock(pe->mutex);
+      while (!pe->shutdown && pe->started == pe->queued)
+        apr_thread_cond_wait(pe->changed, pe->mutex);
+
+      if (pe->shutdown)
+        {
+          apr_thread_mutex_unlock(pe->mutex);
+          break;
+        }
+
+      slot = &pe->slots[pe->started % pe->slot_count];
+      slot->state = slot_busy;
+      ++pe->started;
+      apr_thread_mutex_unlock(pe->mutex);
+
+      slot->err = encode_window(&slot->instructions, &slot->header,
+                                &slot->newdata, slot->window, pe->version,
+                                pe->compression_level, slot->pool);
+
+      apr_thread_mutex_lock(pe->mutex);
+      slot->state = slot_done;
+      apr_thread_cond_broadcast(pe->changed);
+      apr_thread_mutex_unlock(pe->mutex);
+    }
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Stop and join all workers of the parallel_encoder_t DATA and release
+ * the window slots.  Calling this more than once is harmless.
+ * Implements an APR pool cleanup function.
+ */
+static apr_status_t
+shutdown_encoder(void *data)
+{
+  parallel_encoder_t *pe = data;
+  int i;
+
+  apr_thread_mutex_lock(pe->mutex);
+  pe->shutdown = TRUE;
+  apr_thread_cond_broadcast(pe->changed);
+  apr_thread_mutex_unlock(pe->mutex);
+
+  for (i = 0; i < pe->thread_count; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, pe->threads[i]);
+    }
+
+  for (i = 0; i < pe->slot_count; ++i)
+    {
+      svn_error_clear(pe->slots[i].err);
+      svn_pool_destroy(pe->slots[i].pool);
+    }
+
+  pe->thread_count = 0;
+  pe->slot_count = 0;
+
+  return APR_SUCCESS;
+}
+
+/* Wait for the oldest window queued in PE to be encoded and write it to
+ * PE's output. */
+static svn_error_t *
+write_next_window(parallel_encoder_t *pe)
+{
+  encoder_slot_t *slot = &pe->slots[pe->written % pe->slot_count];
+  svn_error_t *err;
+
+  apr_thread_mutex_lock(pe->mutex);
+  while (slot->state != slot_done)
+    apr_thread_cond_wait(pe->changed, pe->mutex);
+  apr_thread_mutex_unlock(pe->mutex);
+
+  err = slot->err;
+  slot->err = SVN_NO_ERROR;
+  if (!err)
+    err = write_encoded_window(pe->output, slot->header,
+                               slot->instructions, slot->newdata);
+
+  svn_pool_clear(slot->pool);
+  apr_thread_mutex_lock(pe->mutex);
+  slot->state = slot_empty;
+  apr_thread_mutex_unlock(pe->mutex);
+  ++pe->written;
+
+  return svn_error_trace(err);
+}
+
+/* Start the worker threads and create the window slots for PE.
+ * Return FALSE if no thread could be started.
+ */
+static svn_boolean_t
+start_workers(parallel_encoder_t *pe)
+{
+  apr_status_t status;
+  int i;
+
+  status = apr_thread_mutex_create(&pe->mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   pe->pool);
+  if (!status)
+    status = apr_thread_cond_create(&pe->changed, pe->pool);
+  if (status)
+    return FALSE;
+
+  /* Allow for some windows to queue up while all workers are busy. */
+  pe->slot_count = 2 * pe->max_threads;
+  pe->slots = apr_pcalloc(pe->pool, pe->slot_count * sizeof(*pe->slots));
+  for (i = 0; i < pe->slot_count; ++i)
+    pe->slots[i].pool = svn_pool_create(NULL);
+
+  /* Make sure the workers get stopped even if the handler never sees
+   * the final NULL window, e.g. due to errors.  This must happen before
+   * the threads' sub-pools get destroyed. */
+  apr_pool_pre_cleanup_register(pe->pool, pe, shutdown_encoder);
+
+  pe->threads = apr_pcalloc(pe->pool,
+                            pe->max_threads * sizeof(*pe->threads));
+  for (i = 0; i < pe->max_threads; ++i)
+    {
+      status = apr_thread_create(&pe->threads[i], NULL, encoder_thread_func,
+                                 pe, pe->pool);
+      if (status)
+        break;
+
+      ++pe->thread_count;
+    }
+
+  if (pe->thread_count == 0)
+    {
+      shutdown_encoder(pe);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Encode WINDOW on the calling thread and write it to PE's output. */
+static svn_error_t *
+encode_window_serially(parallel_encoder_t *pe,
+                       svn_txdelta_window_t *window)
+{
+  svn_stringbuf_t *instructions;
+  svn_stringbuf_t *header;
+  const svn_string_t *newdata;
+
+  svn_pool_clear(pe->scratch_pool);
+  SVN_ERR(encode_window(&instructions, &header, &newdata, window,
+                        pe->version, pe->compression_level,
+                        pe->scratch_pool));
+
+  return svn_error_trace(write_encoded_window(pe->output, header,
+                                              instructions, newdata));
+}
+
+/* Implements svn_txdelta_window_handler_t for parallel_encoder_t BATON.
+ */
+static svn_error_t *
+parallel_window_handler(svn_txdelta_window_t *window,
+                        void *baton)
+{
+  parallel_encoder_t *pe = baton;
+  encoder_slot_t *slot;
+
+  /* Make sure we write the header.  */
+  if (!pe->header_done)
+    {
+      apr_size_t len = SVNDIFF_HEADER_SIZE;
+      SVN_ERR(svn_stream_write(pe->output, get_svndiff_header(pe->version),
+                               &len));
+      pe->header_done = TRUE;
+
+      /* Many deltas consist of a single window.  Don't start any threads
+       * before we know that there is more than one. */
+      if (window)
+        return svn_error_trace(encode_window_serially(pe, window));
+    }
+
+  if (window == NULL)
+    {
+      /* Flush all pending windows, then clean up. */
+      while (pe->written < pe->queued)
+        SVN_ERR(write_next_window(pe));
+
+      if (pe->thread_count)
+        shutdown_encoder(pe);
+      svn_pool_destroy(pe->scratch_pool);
+
+      return svn_error_trace(svn_stream_close(pe->output));
+    }
+
+  if (!pe->serial && !pe->thread_count)
+    pe->serial = !start_workers(pe);
+
+  if (pe->serial)
+    return svn_error_trace(encode_window_serially(pe, window));
+
+  /* Wait for a free slot. */
+  if (pe->queued - pe->written == (apr_size_t)pe->slot_count)
+    SVN_ERR(write_next_window(pe));
+
+  /* WINDOW may be gone once we return.  Give the workers a copy. */
+  slot = &pe->slots[pe->queued % pe->slot_count];
+  slot->window = svn_txdelta_window_dup(window, slot->pool);
+
+  apr_thread_mutex_lock(pe->mutex);
+  slot->state = slot_pending;
+  ++pe->queued;
+  apr_thread_cond_broadcast(pe->changed);
+  apr_thread_mutex_unlock(pe->mutex);
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+void
+svn_txdelta__to_svndiff_parallel(svn_txdelta_window_handler_t *handler,
+                                 void **handler_baton,
+                                 svn_stream_t *output,
+                                 int svndiff_version,
+                                 int compression_level,
+                                 int thread_count,
+                                 apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  /* Uncompressed svndiff is cheap to produce, so it is not worth the
+   * extra copy of every window. */
+  if (thread_count > 1 && svndiff_version > 0)
+    {
+      parallel_encoder_t *pe = apr_pcalloc(pool, sizeof(*pe));
+
+      pe->output = output;
+      pe->version = svndiff_version;
+      pe->compression_level = compression_level;
+      pe->max_threads = thread_count;
+      pe->pool = pool;
+      pe->scratch_pool = svn_pool_create(pool);
+
+      *handler = parallel_window_handler;
+      *handler_baton = pe;
+      return;
+    }
+#endif
+
+  svn_txdelta_to_svndiff3(handler, handler_baton, output, svndiff_version,
+                          compression_level, pool);
+}
+
 void
 svn_txdelta_to_svndiff2(svn_txdelta_window_handler_t *handler,
                         void **handler_baton,
@@ -344,6 +724,35 @@ svn_txdelta_to_svndiff(svn_stream_t *output,
                           SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, pool);
 }
 
+void
+svn_txdelta__append_svndiff_header(svn_stringbuf_t *output,
+                                   int svndiff_version)
+{
+  svn_stringbuf_appendbytes(output, get_svndiff_header(svndiff_version),
+                            SVNDIFF_HEADER_SIZE);
+}
+
+svn_error_t *
+svn_txdelta__append_svndiff_window(svn_stringbuf_t *output,
+                                   svn_txdelta_window_t *window,
+                                   int svndiff_version,
+                                   int compression_level,
+                                   apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *instructions;
+  svn_stringbuf_t *header;
+  const svn_string_t *newdata;
+
+  SVN_ERR(encode_window(&instructions, &header, &newdata, window,
+                        svndiff_version, compression_level, scratch_pool));
+
+  svn_stringbuf_appendstr(output, header);
+  svn_stringbuf_appendstr(output, instructions);
+  svn_stringbuf_appendbytes(output, newdata->data, newdata->len);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* ----- svndiff to text delta ----- */
 
@@ -565,7 +974,23 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
 
   insend = data + inslen;
 
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
+      svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__decompress_zstd(insend, newlen, ndout,
+                                   SVN_DELTA_WINDOW_SIZE));
+      SVN_ERR(svn__decompress_zstd(data, insend - data, instout,
+                                   MAX_INSTRUCTION_SECTION_LEN));
+
+      newlen = ndout->len;
+      data = (unsigned char *)instout->data;
+      insend = (unsigned char *)instout->data + instout->len;
+
+      new_data = svn_stringbuf__morph_into_string(ndout);
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
       svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
@@ -653,6 +1078,8 @@ write_handler(void *baton,
         db->version = 1;
       else if (memcmp(buffer, SVNDIFF_V2 + db->header_bytes, nheader) == 0)
         db->version = 2;
+      else if (memcmp(buffer, SVNDIFF_V3 + db->header_bytes, nheader) == 0)
+        db->version = 3;
       else
         return svn_error_create(SVN_ERR_SVNDIFF_INVALID_HEADER, NULL,
                                 _("Svndiff has invalid header"));
@@ -622,29 +622,58 @@ size_buffer(char **buf, apr_size_t *buf_size,
   return SVN_NO_ERROR;
 }
 
+/* Copy LEN bytes from SOURCE to TARGET, optimizing for short LEN.
+ * Most delta instructions are only a few bytes long and calling memcpy()
+ * for them costs more than the copying itself. */
+static APR_INLINE void
+fast_memcpy(char *target, const char *source, apr_size_t len)
+{
+  if (len > 7)
+    {
+      memcpy(target, source, len);
+    }
+  else
+    {
+      const char *end = source + len;
+      for (; source != end; source++)
+        *(target++) = *source;
+    }
+}
+
 /* Copy LEN bytes from SOURCE to TARGET.  Unlike memmove() or memcpy(),
  * create repeating patterns if the source and target ranges overlap.
  * Return a pointer to the first byte after the copied target range.  */
 static APR_INLINE char *
 patterning_copy(char *target, const char *source, apr_size_t len)
 {
-  /* If the source and target overlap, repeat the overlapping pattern
-     in the target buffer. Always copy from the source buffer because
-     presumably it will be in the L1 cache after the first iteration
-     and doing this should avoid pipeline stalls due to write/read
-     dependencies. */
-  const apr_size_t overlap = target - source;
-  while (len > overlap)
+  /* The distance between source and target is the length of the pattern
+     to repeat.  Once we copied the pattern, the range SOURCE to TARGET
+     contains twice the pattern, i.e. the chunks that we can copy without
+     overlap double with every iteration.  Always copy from the source
+     buffer because presumably it will be in the L1 cache after the first
+     iteration and doing this should avoid pipeline stalls due to
+     write/read dependencies. */
+  apr_size_t chunk = target - source;
+
+  /* Runs of the same character are the most frequent case. */
+  if (chunk == 1)
+    {
+      memset(target, *source, len);
+      return target + len;
+    }
+
+  while (len > chunk)
     {
-      memcpy(target, source, overlap);
-      target += overlap;
-      len -= overlap;
+      fast_memcpy(target, source, chunk);
+      target += chunk;
+      len -= chunk;
+      chunk = target - source;
     }
 
   /* Copy any remaining source pattern. */
   if (len)
     {
-      memcpy(target, source, len);
+      fast_memcpy(target, source, len);
       target += len;
     }
 
@@ -678,7 +707,7 @@ svn_txdelta_apply_instructions(svn_txdelta_window_t *window,
           /* Copy from source area.  */
           assert(sbuf);
           assert(op->offset + op->length <= window->sview_len);
-          memcpy(tbuf + tpos, sbuf + op->offset, buf_len);
+          fast_memcpy(tbuf + tpos, sbuf + op->offset, buf_len);
           break;
 
         case svn_txdelta_target:
@@ -695,9 +724,9 @@ svn_txdelta_apply_instructions(svn_txdelta_window_t *window,
         case svn_txdelta_new:
           /* Copy from window new area.  */
           assert(op->offset + op->length <= window->new_data->len);
-          memcpy(tbuf + tpos,
-                 window->new_data->data + op->offset,
-                 buf_len);
+          fast_memcpy(tbuf + tpos,
+                      window->new_data->data + op->offset,
+                      buf_len);
           break;
 
         default:
@@ -45,13 +45,18 @@
 #define MATCH_BLOCKSIZE 64
 
 /* Size of the checksum presence FLAGS array in BLOCKS_T.  With standard
-   MATCH_BLOCKSIZE and SVN_DELTA_WINDOW_SIZE, 32k entries is about 20x
-   the number of checksums that actually occur, i.e. we expect a >95%
+   MATCH_BLOCKSIZE and SVN_DELTA_WINDOW_SIZE, 64k entries is about 40x
+   the number of checksums that actually occur, i.e. we expect a >97%
    probability that non-matching checksums get already detected by checking
-   against the FLAGS array.
+   against the FLAGS array.  At 8kB, the array still fits into L1 cache.
    Must be a power of 2.
  */
-#define FLAGS_COUNT (32 * 1024)
+#define FLAGS_COUNT (64 * 1024)
+
+/* Alignment of the SLOTS array in BLOCKS_T.  Aligning it to cache lines
+   makes sure that every probe sequence touches as few lines as possible.
+ */
+#define SLOTS_ALIGNMENT 64
 
 /* "no" / "invalid" / "unused" value for positions within the delta windows
  */
@@ -140,8 +145,8 @@ struct blocks
      the bits in that byte by the additive part of adler32. */
   char flags[FLAGS_COUNT / 8];
 
-  /* The vector of blocks.  A pos value of NO_POSITION represents an unused
-     slot. */
+  /* The vector of blocks, aligned to SLOTS_ALIGNMENT.  A pos value of
+     NO_POSITION represents an unused slot. */
   struct block *slots;
 };
 
@@ -239,13 +244,14 @@ init_blocks_table(const char *data,
   SVN_ERR_ASSERT_NO_RETURN(wnslots == nslots);
   blocks->max = nslots - 1;
   blocks->data = data;
-  blocks->slots = apr_palloc(pool, nslots * sizeof(*(blocks->slots)));
-  for (i = 0; i < nslots; ++i)
-    {
-      /* Avoid using an indeterminate value in the lookup. */
-      blocks->slots[i].adlersum = 0;
-      blocks->slots[i].pos = NO_POSITION;
-    }
+  blocks->slots = apr_palloc(pool, nslots * sizeof(*(blocks->slots))
+                                   + SLOTS_ALIGNMENT - 1);
+  blocks->slots = (struct block *)APR_ALIGN((apr_uintptr_t)blocks->slots,
+                                            SLOTS_ALIGNMENT);
+
+  /* All bits set gives POS == NO_POSITION in every slot.  The ADLERSUM
+     of unused slots will never be looked at. */
+  memset(blocks->slots, 0xff, nslots * sizeof(*(blocks->slots)));
 
   /* No checksum entries in SLOTS, yet => reset all checksum flags. */
   memset(blocks->flags, 0, sizeof(blocks->flags));
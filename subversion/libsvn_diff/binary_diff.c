@@ -25,7 +25,9 @@
 
 #include "svn_pools.h"
 #include "svn_error.h"
+#include "svn_delta.h"
 #include "svn_diff.h"
+#include "svn_sorts.h"
 #include "svn_types.h"
 
 #include "diff.h"
@@ -33,9 +35,11 @@
 #include "svn_private_config.h"
 
 /* Copies the data from ORIGINAL_STREAM to a temporary file, returning both
-   the original and compressed size. */
+   the original and compressed size.  If PLAIN_COPY is not NULL, also copy
+   the uncompressed data to a new temporary file in *PLAIN_COPY. */
 static svn_error_t *
 create_compressed(apr_file_t **result,
+                  apr_file_t **plain_copy,
                   svn_filesize_t *full_size,
                   svn_filesize_t *compressed_size,
                   svn_stream_t *original_stream,
@@ -45,6 +49,7 @@ create_compressed(apr_file_t **result,
                   apr_pool_t *scratch_pool)
 {
   svn_stream_t *compressed;
+  svn_stream_t *plain = NULL;
   svn_filesize_t bytes_read = 0;
   apr_size_t rd;
 
@@ -56,6 +61,15 @@ create_compressed(apr_file_t **result,
                   svn_stream_from_aprfile2(*result, TRUE, scratch_pool),
                   scratch_pool);
 
+  if (plain_copy)
+    {
+      SVN_ERR(svn_io_open_uniquely_named(plain_copy, NULL, NULL, "diffbin",
+                                         NULL,
+                                         svn_io_file_del_on_pool_cleanup,
+                                         result_pool, scratch_pool));
+      plain = svn_stream_from_aprfile2(*plain_copy, TRUE, scratch_pool);
+    }
+
   if (original_stream)
     do
     {
@@ -69,6 +83,8 @@ create_compressed(apr_file_t **result,
 
       bytes_read += rd;
       SVN_ERR(svn_stream_write(compressed, buffer, &rd));
+      if (plain)
+        SVN_ERR(svn_stream_write(plain, buffer, &rd));
     }
     while(rd == SVN__STREAM_CHUNK_SIZE);
   else
@@ -85,9 +101,218 @@ create_compressed(apr_file_t **result,
   return SVN_NO_ERROR;
 }
 
+/* Versions whose compressed form is smaller than this are always written
+   as literals.  For those, a delta would save little, and the literal
+   can be applied without the other version. */
+#define MIN_DELTA_SIZE 4096
+
+/* Baton for read_handler_keep */
+typedef struct keep_baton_t
+{
+  svn_stream_t *inner;
+
+  /* Everything read from INNER that the caller didn't consume yet. */
+  svn_stringbuf_t *data;
+} keep_baton_t;
+
+/* Implements svn_read_fn_t, reading from the inner stream of the
+   keep_baton_t at BATON while keeping a copy of the data. */
+static svn_error_t *
+read_handler_keep(void *baton, char *buffer, apr_size_t *len)
+{
+  keep_baton_t *kb = baton;
+
+  SVN_ERR(svn_stream_read_full(kb->inner, buffer, len));
+  svn_stringbuf_appendbytes(kb->data, buffer, *len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Appends VALUE to BUF in the variable length encoding of git deltas. */
+static void
+append_varint(svn_stringbuf_t *buf, svn_filesize_t value)
+{
+  while (value >= 0x80)
+    {
+      svn_stringbuf_appendbyte(buf, (char)(0x80 | (value & 0x7f)));
+      value >>= 7;
+    }
+
+  svn_stringbuf_appendbyte(buf, (char)value);
+}
+
+/* Appends git delta instructions to BUF that insert LEN bytes of DATA. */
+static void
+append_insert(svn_stringbuf_t *buf, const char *data, apr_size_t len)
+{
+  while (len)
+    {
+      apr_size_t chunk = MIN(len, 0x7f);
+
+      svn_stringbuf_appendbyte(buf, (char)chunk);
+      svn_stringbuf_appendbytes(buf, data, chunk);
+      data += chunk;
+      len -= chunk;
+    }
+}
+
+/* Appends git delta instructions to BUF that copy SIZE bytes at OFFSET
+   from the base version. */
+static void
+append_copy(svn_stringbuf_t *buf, apr_uint32_t offset, apr_size_t size)
+{
+  while (size)
+    {
+      /* A size of 0x10000 is encoded without any size bytes. */
+      apr_uint32_t chunk = (apr_uint32_t)MIN(size, 0x10000);
+      unsigned char op[8];
+      apr_size_t op_len = 1;
+      int i;
+
+      op[0] = 0x80;
+      for (i = 0; i < 4; i++)
+        if ((offset >> (8 * i)) & 0xff)
+          {
+            op[0] |= 1 << i;
+            op[op_len++] = (unsigned char)(offset >> (8 * i));
+          }
+      for (i = 0; i < 2; i++)
+        if ((chunk >> (8 * i)) & 0xff)
+          {
+            op[0] |= 0x10 << i;
+            op[op_len++] = (unsigned char)(chunk >> (8 * i));
+          }
+
+      svn_stringbuf_appendbytes(buf, (const char *)op, op_len);
+      offset += chunk;
+      size -= chunk;
+    }
+}
+
+/* Creates a compressed git delta in a temporary file *RESULT that
+   transforms the BASE_SIZE bytes in BASE_FILE into the TARGET_SIZE bytes
+   in TARGET_FILE, using the xdelta engine of libsvn_delta.  Returns the
+   uncompressed and compressed size of the delta.  Sets *RESULT to NULL if
+   the base is too large to be described by a git delta. */
+static svn_error_t *
+create_delta(apr_file_t **result,
+             svn_filesize_t *delta_size,
+             svn_filesize_t *compressed_size,
+             apr_file_t *base_file,
+             svn_filesize_t base_size,
+             apr_file_t *target_file,
+             svn_filesize_t target_size,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  svn_stream_t *compressed;
+  svn_stream_t *target;
+  svn_txdelta_stream_t *delta_stream;
+  svn_txdelta_window_t *window;
+  svn_stringbuf_t *ops = svn_stringbuf_create_empty(scratch_pool);
+  keep_baton_t kb;
+  apr_off_t start = 0;
+  apr_pool_t *iterpool;
+
+  /* Copy instructions have 32 bit offsets. */
+  if (base_size > APR_UINT32_MAX)
+    {
+      *result = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_io_file_seek(base_file, APR_SET, &start, scratch_pool));
+  start = 0;
+  SVN_ERR(svn_io_file_seek(target_file, APR_SET, &start, scratch_pool));
+
+  /* The windows don't contain the target data that they copy from the
+     target itself, so keep that data around until each window is done. */
+  kb.inner = svn_stream_from_aprfile2(target_file, TRUE, scratch_pool);
+  kb.data = svn_stringbuf_create_empty(scratch_pool);
+  target = svn_stream_create(&kb, scratch_pool);
+  svn_stream_set_read2(target, NULL /* only full read support */,
+                       read_handler_keep);
+
+  svn_txdelta2(&delta_stream,
+               svn_stream_from_aprfile2(base_file, TRUE, scratch_pool),
+               target, FALSE, scratch_pool);
+
+  SVN_ERR(svn_io_open_uniquely_named(result, NULL, NULL, "diffgz",
+                                     NULL, svn_io_file_del_on_pool_cleanup,
+                                     result_pool, scratch_pool));
+
+  compressed = svn_stream_compressed(
+                  svn_stream_from_aprfile2(*result, TRUE, scratch_pool),
+                  scratch_pool);
+
+  append_varint(ops, base_size);
+  append_varint(ops, target_size);
+  *delta_size = 0;
+
+  iterpool = svn_pool_create(scratch_pool);
+  do
+    {
+      apr_size_t len;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_txdelta_next_window(&window, delta_stream, iterpool));
+
+      if (window)
+        {
+          apr_size_t tpos = 0;
+          apr_size_t insert_len = 0;
+          int i;
+
+          /* Git deltas only know copies from the base and inserts, so
+             turn everything that doesn't come from the source view into
+             inserts of the target data. */
+          for (i = 0; i < window->num_ops; i++)
+            {
+              const svn_txdelta_op_t *op = &window->ops[i];
+
+              if (op->action_code == svn_txdelta_source)
+                {
+                  append_insert(ops, kb.data->data + tpos - insert_len,
+                                insert_len);
+                  insert_len = 0;
+                  append_copy(ops,
+                              (apr_uint32_t)(window->sview_offset
+                                             + op->offset),
+                              op->length);
+                }
+              else
+                insert_len += op->length;
+
+              tpos += op->length;
+            }
+
+          append_insert(ops, kb.data->data + tpos - insert_len, insert_len);
+          svn_stringbuf_remove(kb.data, 0, window->tview_len);
+        }
+
+      len = ops->len;
+      SVN_ERR(svn_stream_write(compressed, ops->data, &len));
+      *delta_size += ops->len;
+      svn_stringbuf_setempty(ops);
+    }
+  while (window);
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_stream_close(compressed)); /* Flush compression */
+  SVN_ERR(svn_io_file_size_get(compressed_size, *result, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 #define GIT_BASE85_CHUNKSIZE 52
 
-/* Git Base-85 table for write_literal */
+/* Git Base-85 table for write_blob */
 static const char b85str[] =
     "0123456789"
     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
@@ -154,28 +379,29 @@ svn_diff__base85_decode_line(char *output_data,
 }
 
 
-/* Git length encoding table for write_literal */
+/* Git length encoding table for write_blob */
 static const char b85lenstr[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
     "abcdefghijklmnopqrstuvwxyz";
 
-/* Writes out a git-like literal output of the compressed data in
-   COMPRESSED_DATA to OUTPUT_STREAM, describing that its normal length is
-   UNCOMPRESSED_SIZE. */
+/* Writes out a git-like blob of type TYPE ("literal" or "delta") of the
+   compressed data in COMPRESSED_DATA to OUTPUT_STREAM, describing that its
+   normal length is UNCOMPRESSED_SIZE. */
 static svn_error_t *
-write_literal(svn_filesize_t uncompressed_size,
-              svn_stream_t *compressed_data,
-              svn_stream_t *output_stream,
-              svn_cancel_func_t cancel_func,
-              void *cancel_baton,
-              apr_pool_t *scratch_pool)
+write_blob(const char *type,
+           svn_filesize_t uncompressed_size,
+           svn_stream_t *compressed_data,
+           svn_stream_t *output_stream,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *scratch_pool)
 {
   apr_size_t rd;
   SVN_ERR(svn_stream_seek(compressed_data, NULL)); /* Seek to start */
 
   SVN_ERR(svn_stream_printf(output_stream, scratch_pool,
-                            "literal %" SVN_FILESIZE_T_FMT APR_EOL_STR,
-                            uncompressed_size));
+                            "%s %" SVN_FILESIZE_T_FMT APR_EOL_STR,
+                            type, uncompressed_size));
 
   do
     {
@@ -237,44 +463,86 @@ svn_diff_output_binary(svn_stream_t *output_stream,
                        apr_pool_t *scratch_pool)
 {
   apr_file_t *original_apr;
+  apr_file_t *original_plain = NULL;
   svn_filesize_t original_full;
   svn_filesize_t original_deflated;
   apr_file_t *latest_apr;
+  apr_file_t *latest_plain = NULL;
   svn_filesize_t latest_full;
   svn_filesize_t latest_deflated;
+  apr_file_t *forward_apr = NULL;
+  svn_filesize_t forward_full;
+  svn_filesize_t forward_deflated;
+  apr_file_t *reverse_apr = NULL;
+  svn_filesize_t reverse_full;
+  svn_filesize_t reverse_deflated;
+  svn_boolean_t both = (original && latest);
   apr_pool_t *subpool = svn_pool_create(scratch_pool);
 
-  SVN_ERR(create_compressed(&original_apr, &original_full, &original_deflated,
+  /* When both versions exist, keep plain copies to delta them. */
+  SVN_ERR(create_compressed(&original_apr, both ? &original_plain : NULL,
+                            &original_full, &original_deflated,
                             original, cancel_func, cancel_baton,
                             scratch_pool, subpool));
   svn_pool_clear(subpool);
 
-  SVN_ERR(create_compressed(&latest_apr, &latest_full, &latest_deflated,
+  SVN_ERR(create_compressed(&latest_apr, both ? &latest_plain : NULL,
+                            &latest_full, &latest_deflated,
                             latest,  cancel_func, cancel_baton,
                             scratch_pool, subpool));
   svn_pool_clear(subpool);
 
+  /* Like git, describe a version as a delta against the other one when
+     that is shorter than the compressed data. */
+  if (both && latest_deflated >= MIN_DELTA_SIZE)
+    {
+      SVN_ERR(create_delta(&forward_apr, &forward_full, &forward_deflated,
+                           original_plain, original_full,
+                           latest_plain, latest_full,
+                           cancel_func, cancel_baton,
+                           scratch_pool, subpool));
+      svn_pool_clear(subpool);
+    }
+
+  if (both && original_deflated >= MIN_DELTA_SIZE)
+    {
+      SVN_ERR(create_delta(&reverse_apr, &reverse_full, &reverse_deflated,
+                           latest_plain, latest_full,
+                           original_plain, original_full,
+                           cancel_func, cancel_baton,
+                           scratch_pool, subpool));
+      svn_pool_clear(subpool);
+    }
+
   SVN_ERR(svn_stream_puts(output_stream, "GIT binary patch" APR_EOL_STR));
 
-  /* ### git would first calculate if a git-delta latest->original would be
-         shorter than the zipped data. For now lets assume that it is not
-         and just dump the literal data */
-  SVN_ERR(write_literal(latest_full,
-                        svn_stream_from_aprfile2(latest_apr, FALSE, subpool),
-                        output_stream,
-                        cancel_func, cancel_baton,
-                        scratch_pool));
+  if (forward_apr && forward_deflated < latest_deflated)
+    SVN_ERR(write_blob("delta", forward_full,
+                       svn_stream_from_aprfile2(forward_apr, FALSE, subpool),
+                       output_stream,
+                       cancel_func, cancel_baton,
+                       scratch_pool));
+  else
+    SVN_ERR(write_blob("literal", latest_full,
+                       svn_stream_from_aprfile2(latest_apr, FALSE, subpool),
+                       output_stream,
+                       cancel_func, cancel_baton,
+                       scratch_pool));
   svn_pool_clear(subpool);
   SVN_ERR(svn_stream_puts(output_stream, APR_EOL_STR));
 
-  /* ### git would first calculate if a git-delta original->latest would be
-         shorter than the zipped data. For now lets assume that it is not
-         and just dump the literal data */
-  SVN_ERR(write_literal(original_full,
-                        svn_stream_from_aprfile2(original_apr, FALSE, subpool),
-                        output_stream,
-                        cancel_func, cancel_baton,
-                        scratch_pool));
+  if (reverse_apr && reverse_deflated < original_deflated)
+    SVN_ERR(write_blob("delta", reverse_full,
+                       svn_stream_from_aprfile2(reverse_apr, FALSE, subpool),
+                       output_stream,
+                       cancel_func, cancel_baton,
+                       scratch_pool));
+  else
+    SVN_ERR(write_blob("literal", original_full,
+                       svn_stream_from_aprfile2(original_apr, FALSE, subpool),
+                       output_stream,
+                       cancel_func, cancel_baton,
+                       scratch_pool));
   svn_pool_destroy(subpool);
 
   return SVN_NO_ERROR;
@@ -0,0 +1,306 @@
+/*
+ * blame.c :  maintaining line-to-revision maps from successive diffs
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <assert.h>
+
+#include <apr_pools.h>
+
+#include "svn_error.h"
+#include "svn_diff.h"
+
+#include "private/svn_diff_private.h"
+
+
+/* The baton use for the diff output routine. */
+struct diff_baton {
+  svn_diff__blame_chain_t *chain;
+  const void *rev;
+};
+
+
+svn_diff__blame_chain_t *
+svn_diff__blame_chain_create(apr_pool_t *result_pool)
+{
+  svn_diff__blame_chain_t *chain = apr_palloc(result_pool, sizeof(*chain));
+
+  chain->blame = NULL;
+  chain->avail = NULL;
+  chain->pool = result_pool;
+
+  return chain;
+}
+
+svn_diff__blame_t *
+svn_diff__blame_create(svn_diff__blame_chain_t *chain,
+                       const void *rev,
+                       apr_off_t start)
+{
+  svn_diff__blame_t *blame;
+  if (chain->avail)
+    {
+      blame = chain->avail;
+      chain->avail = blame->next;
+    }
+  else
+    blame = apr_palloc(chain->pool, sizeof(*blame));
+  blame->rev = rev;
+  blame->start = start;
+  blame->next = NULL;
+  return blame;
+}
+
+/* Destroy a blame chunk. */
+static void
+blame_destroy(svn_diff__blame_chain_t *chain,
+              svn_diff__blame_t *blame)
+{
+  blame->next = chain->avail;
+  chain->avail = blame;
+}
+
+/* Return the blame chunk that contains token OFF, starting the search at
+   BLAME. */
+static svn_diff__blame_t *
+blame_find(svn_diff__blame_t *blame, apr_off_t off)
+{
+  svn_diff__blame_t *prev = NULL;
+  while (blame)
+    {
+      if (blame->start > off) break;
+      prev = blame;
+      blame = blame->next;
+    }
+  return prev;
+}
+
+/* Shift the start-point of BLAME and all subsequence blame-chunks
+   by ADJUST tokens */
+static void
+blame_adjust(svn_diff__blame_t *blame, apr_off_t adjust)
+{
+  while (blame)
+    {
+      blame->start += adjust;
+      blame = blame->next;
+    }
+}
+
+/* Delete the blame associated with the region from token START to
+   START + LENGTH */
+static svn_error_t *
+blame_delete_range(svn_diff__blame_chain_t *chain,
+                   apr_off_t start,
+                   apr_off_t length)
+{
+  svn_diff__blame_t *first = blame_find(chain->blame, start);
+  svn_diff__blame_t *last = blame_find(chain->blame, start + length);
+  svn_diff__blame_t *tail = last->next;
+
+  if (first != last)
+    {
+      svn_diff__blame_t *walk = first->next;
+      while (walk != last)
+        {
+          svn_diff__blame_t *next = walk->next;
+          blame_destroy(chain, walk);
+          walk = next;
+        }
+      first->next = last;
+      last->start = start;
+      if (first->start == start)
+        {
+          *first = *last;
+          blame_destroy(chain, last);
+          last = first;
+        }
+    }
+
+  if (tail && tail->start == last->start + length)
+    {
+      *last = *tail;
+      blame_destroy(chain, tail);
+      tail = last->next;
+    }
+
+  blame_adjust(tail, -length);
+
+  return SVN_NO_ERROR;
+}
+
+/* Insert a chunk of blame associated with REV starting
+   at token START and continuing for LENGTH tokens */
+static svn_error_t *
+blame_insert_range(svn_diff__blame_chain_t *chain,
+                   const void *rev,
+                   apr_off_t start,
+                   apr_off_t length)
+{
+  svn_diff__blame_t *head = chain->blame;
+  svn_diff__blame_t *point = blame_find(head, start);
+  svn_diff__blame_t *insert;
+
+  if (point->start == start)
+    {
+      insert = svn_diff__blame_create(chain, point->rev,
+                                      point->start + length);
+      point->rev = rev;
+      insert->next = point->next;
+      point->next = insert;
+    }
+  else
+    {
+      svn_diff__blame_t *middle;
+      middle = svn_diff__blame_create(chain, rev, start);
+      insert = svn_diff__blame_create(chain, point->rev, start + length);
+      middle->next = insert;
+      insert->next = point->next;
+      point->next = middle;
+    }
+  blame_adjust(insert->next, length);
+
+  return SVN_NO_ERROR;
+}
+
+/* Callback for diff between subsequent revisions */
+static svn_error_t *
+output_diff_modified(void *baton,
+                     apr_off_t original_start,
+                     apr_off_t original_length,
+                     apr_off_t modified_start,
+                     apr_off_t modified_length,
+                     apr_off_t latest_start,
+                     apr_off_t latest_length)
+{
+  struct diff_baton *db = baton;
+
+  if (original_length)
+    SVN_ERR(blame_delete_range(db->chain, modified_start, original_length));
+
+  if (modified_length)
+    SVN_ERR(blame_insert_range(db->chain, db->rev, modified_start,
+                               modified_length));
+
+  return SVN_NO_ERROR;
+}
+
+static const svn_diff_output_fns_t output_fns = {
+        NULL,
+        output_diff_modified
+};
+
+svn_error_t *
+svn_diff__blame_add_file(svn_diff__blame_chain_t *chain,
+                         const char *last_file,
+                         const char *cur_file,
+                         const void *rev,
+                         const svn_diff_file_options_t *diff_options,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *scratch_pool)
+{
+  if (!last_file)
+    {
+      SVN_ERR_ASSERT(chain->blame == NULL);
+      chain->blame = svn_diff__blame_create(chain, rev, 0);
+    }
+  else
+    {
+      svn_diff_t *diff;
+      struct diff_baton diff_baton;
+
+      diff_baton.chain = chain;
+      diff_baton.rev = rev;
+
+      /* We have a previous file.  Get the diff and adjust blame info. */
+      SVN_ERR(svn_diff_file_diff_2(&diff, last_file, cur_file,
+                                   diff_options, scratch_pool));
+      SVN_ERR(svn_diff_output2(diff, &diff_baton, &output_fns,
+                               cancel_func, cancel_baton));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_diff__blame_normalize(svn_diff__blame_chain_t *chain,
+                          svn_diff__blame_chain_t *chain_merged)
+{
+  svn_diff__blame_t *walk, *walk_merged;
+
+  /* Walk over the CHAIN's blame chunks and CHAIN_MERGED's blame chunks,
+     creating new chunks as needed. */
+  for (walk = chain->blame, walk_merged = chain_merged->blame;
+       walk->next && walk_merged->next;
+       walk = walk->next, walk_merged = walk_merged->next)
+    {
+      /* The current chunks should always be starting at the same offset. */
+      assert(walk->start == walk_merged->start);
+
+      if (walk->next->start < walk_merged->next->start)
+        {
+          /* insert a new chunk in CHAIN_MERGED. */
+          svn_diff__blame_t *tmp
+            = svn_diff__blame_create(chain_merged, walk_merged->rev,
+                                     walk->next->start);
+          tmp->next = walk_merged->next;
+          walk_merged->next = tmp;
+        }
+
+      if (walk->next->start > walk_merged->next->start)
+        {
+          /* insert a new chunk in CHAIN. */
+          svn_diff__blame_t *tmp
+            = svn_diff__blame_create(chain, walk->rev,
+                                     walk_merged->next->start);
+          tmp->next = walk->next;
+          walk->next = tmp;
+        }
+    }
+
+  /* If both NEXT pointers are null, the lists are equally long, otherwise
+     we need to extend one of them.  If CHAIN is longer, append new chunks
+     to CHAIN_MERGED until its length matches that of CHAIN. */
+  while (walk->next != NULL)
+    {
+      svn_diff__blame_t *tmp
+        = svn_diff__blame_create(chain_merged, walk_merged->rev,
+                                 walk->next->start);
+      walk_merged->next = tmp;
+
+      walk_merged = walk_merged->next;
+      walk = walk->next;
+    }
+
+  /* Same as above, only extend CHAIN to match CHAIN_MERGED. */
+  while (walk_merged->next != NULL)
+    {
+      svn_diff__blame_t *tmp
+        = svn_diff__blame_create(chain, walk->rev,
+                                 walk_merged->next->start);
+      walk->next = tmp;
+
+      walk = walk->next;
+      walk_merged = walk_merged->next;
+    }
+}
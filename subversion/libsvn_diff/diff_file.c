@@ -49,9 +49,16 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
-#include "private/svn_adler32.h"
+#include "private/svn_subr_private.h"
 #include "private/svn_diff_private.h"
 
+/* SSE2 is part of every x86-64 CPU, so there is no need to detect it. */
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SVN_DIFF__SSE2
+#endif
+
 /* A token, i.e. a line read from a file. */
 typedef struct svn_diff__file_token_t
 {
@@ -79,6 +86,7 @@ typedef struct svn_diff__file_baton_t
     /* All the following fields are active while this datasource is open */
     apr_file_t *file;  /* handle of this file */
     apr_off_t size;    /* total raw size in bytes of this file */
+    char *map;         /* read-only mapping of the whole file, or NULL */
 
     /* The current chunk: CHUNK_SIZE bytes except for the last chunk. */
     int chunk;     /* the current chunk number, zero-based */
@@ -134,6 +142,12 @@ datasource_to_index(svn_diff_datasource_e datasource)
 #define offset_to_chunk(offset) ((offset) >> CHUNK_SHIFT)
 #define offset_in_chunk(offset) ((offset) & (CHUNK_SIZE - 1))
 
+/* Regular files of at least this size are memory mapped, when no
+ * normalization is requested, instead of being read chunk by chunk.
+ * Their "chunks" then simply point into the mapping.
+ */
+#define MMAP_MIN_SIZE (1024 * 1024)
+
 
 /* Read a chunk from a FILE into BUFFER, starting from OFFSET, going for
  * *LENGTH.  The actual bytes read are stored in *LENGTH on return.
@@ -151,6 +165,61 @@ read_chunk(apr_file_t *file,
                                 NULL, NULL, scratch_pool);
 }
 
+/* Make the current chunk of FILE, LENGTH bytes long, available at
+ * FILE->BUFFER.  For mapped files, this just points into the mapping.
+ */
+static APR_INLINE svn_error_t *
+load_chunk(struct file_info *file, apr_off_t length,
+           apr_pool_t *scratch_pool)
+{
+  if (file->map)
+    {
+      file->buffer = file->map + chunk_to_offset(file->chunk);
+      return SVN_NO_ERROR;
+    }
+
+  return read_chunk(file->file, file->buffer, length,
+                    chunk_to_offset(file->chunk), scratch_pool);
+}
+
+/* Try to map FILE, which has been opened already, into memory as a whole.
+ * Leave FILE->MAP as NULL if the file is not suitable or mapping fails.
+ * OPTIONS are the diff options in effect.  Allocate the mapping in POOL.
+ */
+static svn_error_t *
+map_datasource(struct file_info *file,
+               const svn_diff_file_options_t *options,
+               apr_pool_t *pool)
+{
+#if APR_HAS_MMAP
+  apr_finfo_t finfo;
+  apr_mmap_t *mm;
+
+  file->map = NULL;
+
+  /* Normalization modifies the chunks in place, which a read-only mapping
+     does not allow. */
+  if (options->ignore_space || options->ignore_eol_style)
+    return SVN_NO_ERROR;
+
+  if (file->size < MMAP_MIN_SIZE || file->size > APR_SIZE_MAX)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_TYPE, file->file, pool));
+  if (finfo.filetype != APR_REG)
+    return SVN_NO_ERROR;
+
+  /* On failure we just fall back to reading chunks. */
+  if (apr_mmap_create(&mm, file->file, 0, (apr_size_t) file->size,
+                      APR_MMAP_READ, pool) == APR_SUCCESS)
+    file->map = mm->mm;
+#else
+  file->map = NULL;
+#endif /* APR_HAS_MMAP */
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Map or read a file at PATH. *BUFFER will point to the file
  * contents; if the file was mapped, *FILE and *MM will contain the
@@ -288,9 +357,7 @@ increment_chunk(struct file_info *file, apr_pool_t *pool)
       file->chunk++;
       length = file->chunk == last_chunk ?
         offset_in_chunk(file->size) : CHUNK_SIZE;
-      SVN_ERR(read_chunk(file->file, file->buffer,
-                         length, chunk_to_offset(file->chunk),
-                         pool));
+      SVN_ERR(load_chunk(file, length, pool));
       file->endp = file->buffer + length;
       file->curp = file->buffer;
     }
@@ -315,9 +382,7 @@ decrement_chunk(struct file_info *file, apr_pool_t *pool)
     {
       /* Read previous chunk and reset pointers. */
       file->chunk--;
-      SVN_ERR(read_chunk(file->file, file->buffer,
-                         CHUNK_SIZE, chunk_to_offset(file->chunk),
-                         pool));
+      SVN_ERR(load_chunk(file, CHUNK_SIZE, pool));
       file->endp = file->buffer + CHUNK_SIZE;
       file->curp = file->endp - 1;
     }
@@ -370,7 +435,124 @@ static svn_boolean_t contains_eol(apr_uintptr_t chunk)
 
   return (r_test & n_test & SVN__BIT_7_SET) != SVN__BIT_7_SET;
 }
+
+/* The number of bytes compared at once by identical_blocks() and
+ * identical_blocks_backward(). */
+#ifdef SVN_DIFF__SSE2
+#define BLOCK_SIZE 16
+#else
+#define BLOCK_SIZE sizeof(apr_uintptr_t)
+#endif
+
+/* Return TRUE if the BLOCK_SIZE bytes at A and B are identical. */
+static APR_INLINE svn_boolean_t
+is_same_block(const char *a, const char *b)
+{
+#ifdef SVN_DIFF__SSE2
+  __m128i va = _mm_loadu_si128((const __m128i *)a);
+  __m128i vb = _mm_loadu_si128((const __m128i *)b);
+
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) == 0xffff;
+#else
+  return *(const apr_uintptr_t *)a == *(const apr_uintptr_t *)b;
 #endif
+}
+
+/* Return the number of bytes, a multiple of BLOCK_SIZE but not more
+ * than MAX_LEN, from the start of the FILE_LEN buffers at START that
+ * are identical in all of them. */
+static apr_size_t
+identical_blocks(const char *start[], apr_size_t file_len,
+                 apr_size_t max_len)
+{
+  apr_size_t len;
+  apr_size_t i;
+
+  for (len = 0; len + BLOCK_SIZE <= max_len; len += BLOCK_SIZE)
+    for (i = 1; i < file_len; i++)
+      if (!is_same_block(start[0] + len, start[i] + len))
+        return len;
+
+  return len;
+}
+
+/* Like identical_blocks(), but for the bytes before the FILE_LEN
+ * positions at END. */
+static apr_size_t
+identical_blocks_backward(const char *end[], apr_size_t file_len,
+                          apr_size_t max_len)
+{
+  apr_size_t len;
+  apr_size_t i;
+
+  for (len = 0; len + BLOCK_SIZE <= max_len; len += BLOCK_SIZE)
+    for (i = 1; i < file_len; i++)
+      if (!is_same_block(end[0] - len - BLOCK_SIZE,
+                         end[i] - len - BLOCK_SIZE))
+        return len;
+
+  return len;
+}
+
+#ifdef SVN_DIFF__SSE2
+/* Return the number of bits set in X. */
+static APR_INLINE apr_off_t
+count_bits(apr_uint32_t x)
+{
+  x = x - ((x >> 1) & 0x55555555);
+  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+  return (((x + (x >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+}
+#endif
+
+/* Return the number of eol sequences (\n, \r\n or \r) ending in the LEN
+ * bytes at BUF, counting a \n at the very start even if a \r precedes it.
+ */
+static apr_off_t
+count_eols(const char *buf, apr_size_t len)
+{
+  apr_off_t count = 0;
+  apr_size_t i = 0;
+  apr_size_t j;
+
+#ifdef SVN_DIFF__SSE2
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  apr_uint32_t prev_cr = 0;
+
+  for (; i + 16 <= len; i += 16)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+      apr_uint32_t crs = _mm_movemask_epi8(_mm_cmpeq_epi8(v, cr));
+      apr_uint32_t lfs = _mm_movemask_epi8(_mm_cmpeq_epi8(v, lf));
+
+      /* A \n right after a \r only completes its \r\n. */
+      if (crs | lfs)
+        count += count_bits(crs) + count_bits(lfs)
+                 - count_bits(lfs & ((crs << 1) | prev_cr));
+
+      prev_cr = crs >> 15;
+    }
+#endif
+
+  for (; i < len; i = j)
+    {
+      j = i + sizeof(apr_uintptr_t);
+      if (j <= len && !contains_eol(*(const apr_uintptr_t *)(buf + i)))
+        continue;
+
+      if (j > len)
+        j = len;
+
+      for (; i < j; i++)
+        if (buf[i] == '\r'
+            || (buf[i] == '\n' && (i == 0 || buf[i - 1] != '\r')))
+          count++;
+    }
+
+  return count;
+}
+#endif /* SVN_UNALIGNED_ACCESS_IS_OK */
 
 /* Find the prefix which is identical between all elements of the FILE array.
  * Return the number of prefix lines in PREFIX_LINES.  REACHED_ONE_EOF will be
@@ -398,6 +580,7 @@ find_identical_prefix(svn_boolean_t *reached_one_eof, apr_off_t *prefix_lines,
     {
 #if SVN_UNALIGNED_ACCESS_IS_OK
       apr_ssize_t max_delta, delta;
+      const char *start[4];
 #endif /* SVN_UNALIGNED_ACCESS_IS_OK */
 
       /* ### TODO: see if we can take advantage of
@@ -421,48 +604,36 @@ find_identical_prefix(svn_boolean_t *reached_one_eof, apr_off_t *prefix_lines,
 
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
-      /* Try to advance as far as possible with machine-word granularity.
-       * Determine how far we may advance with chunky ops without reaching
+      /* Try to advance as far as possible in whole blocks, counting the
+       * lines we skip.  Determine how far we may advance without reaching
        * endp for any of the files.
        * Signedness is important here if curp gets close to endp.
        */
-      max_delta = file[0].endp - file[0].curp - sizeof(apr_uintptr_t);
-      for (i = 1; i < file_len; i++)
+      max_delta = file[0].endp - file[0].curp - 1;
+      for (i = 0; i < file_len; i++)
         {
-          delta = file[i].endp - file[i].curp - sizeof(apr_uintptr_t);
+          delta = file[i].endp - file[i].curp - 1;
           if (delta < max_delta)
             max_delta = delta;
-        }
 
-      is_match = TRUE;
-      for (delta = 0; delta < max_delta; delta += sizeof(apr_uintptr_t))
-        {
-          apr_uintptr_t chunk = *(const apr_uintptr_t *)(file[0].curp + delta);
-          if (contains_eol(chunk))
-            break;
-
-          for (i = 1; i < file_len; i++)
-            if (chunk != *(const apr_uintptr_t *)(file[i].curp + delta))
-              {
-                is_match = FALSE;
-                break;
-              }
-
-          if (! is_match)
-            break;
+          start[i] = file[i].curp;
         }
 
+      delta = max_delta > 0
+            ? identical_blocks(start, file_len, max_delta)
+            : 0;
+
       if (delta /* > 0*/)
         {
-          /* We either found a mismatch or an EOL at or shortly behind curp+delta
-           * or we cannot proceed with chunky ops without exceeding endp.
-           * In any way, everything up to curp + delta is equal and not an EOL.
-           */
+          /* Everything up to curp + delta is equal.  A leading \n ends
+           * the line of a \r we already counted. */
+          lines += count_eols(file[0].curp, delta);
+          if (had_cr && *file[0].curp == '\n')
+            lines--;
+          had_cr = file[0].curp[delta - 1] == '\r';
+
           for (i = 0; i < file_len; i++)
             file[i].curp += delta;
-
-          /* Skipped data without EOL markers, so last char was not a CR. */
-          had_cr = FALSE;
         }
 #endif
 
@@ -554,6 +725,7 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
       file_for_suffix[i].path = file[i].path;
       file_for_suffix[i].file = file[i].file;
       file_for_suffix[i].size = file[i].size;
+      file_for_suffix[i].map = file[i].map;
       file_for_suffix[i].chunk =
         (int) offset_to_chunk(file_for_suffix[i].size); /* last chunk */
       length[i] = offset_in_chunk(file_for_suffix[i].size);
@@ -573,11 +745,9 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
         {
           /* There is at least more than 1 chunk,
              so allocate full chunk size buffer */
-          file_for_suffix[i].buffer = apr_palloc(pool, CHUNK_SIZE);
-          SVN_ERR(read_chunk(file_for_suffix[i].file,
-                             file_for_suffix[i].buffer, length[i],
-                             chunk_to_offset(file_for_suffix[i].chunk),
-                             pool));
+          if (!file_for_suffix[i].map)
+            file_for_suffix[i].buffer = apr_palloc(pool, CHUNK_SIZE);
+          SVN_ERR(load_chunk(&file_for_suffix[i], length[i], pool));
         }
       file_for_suffix[i].endp = file_for_suffix[i].buffer + length[i];
       file_for_suffix[i].curp = file_for_suffix[i].endp - 1;
@@ -614,7 +784,8 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
 #if SVN_UNALIGNED_ACCESS_IS_OK
       /* Initialize the minimum pointer positions. */
       const char *min_curp[4];
-      svn_boolean_t can_read_word;
+      const char *end[4];
+      apr_ssize_t max_delta, delta;
 #endif /* SVN_UNALIGNED_ACCESS_IS_OK */
 
       /* ### TODO: see if we can take advantage of
@@ -646,48 +817,38 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
       if (file_for_suffix[0].chunk == suffix_min_chunk0)
         min_curp[0] += suffix_min_offset0;
 
-      /* Scan quickly by reading with machine-word granularity. */
-      for (i = 0, can_read_word = TRUE; can_read_word && i < file_len; i++)
-        can_read_word = ((file_for_suffix[i].curp + 1 - sizeof(apr_uintptr_t))
-                         > min_curp[i]);
-
-      while (can_read_word)
+      /* Scan quickly in whole blocks, counting the lines we skip, but
+         leave the byte at min_curp for the byte-wise checks below. */
+      max_delta = file_for_suffix[0].curp - min_curp[0];
+      for (i = 0; i < file_len; i++)
         {
-          apr_uintptr_t chunk;
+          delta = file_for_suffix[i].curp - min_curp[i];
+          if (delta < max_delta)
+            max_delta = delta;
 
-          /* For each file curp is positioned at the current byte, but we
-             want to examine the current byte and the ones before the current
-             location as one machine word. */
+          end[i] = file_for_suffix[i].curp + 1;
+        }
 
-          chunk = *(const apr_uintptr_t *)(file_for_suffix[0].curp + 1
-                                             - sizeof(apr_uintptr_t));
-          if (contains_eol(chunk))
-            break;
+      delta = max_delta > 0
+            ? identical_blocks_backward(end, file_len, max_delta)
+            : 0;
 
-          for (i = 1, is_match = TRUE; is_match && i < file_len; i++)
-            is_match = (chunk
-                           == *(const apr_uintptr_t *)
-                                    (file_for_suffix[i].curp + 1
-                                       - sizeof(apr_uintptr_t)));
+      if (delta /* > 0*/)
+        {
+          const char *first = end[0] - delta;
 
-          if (! is_match)
-            break;
+          /* A trailing \r belongs to the \r\n we already counted. */
+          lines += count_eols(first, delta);
+          if (had_nl && *file_for_suffix[0].curp == '\r')
+            lines--;
+          had_nl = *first == '\n';
 
           for (i = 0; i < file_len; i++)
-            {
-              file_for_suffix[i].curp -= sizeof(apr_uintptr_t);
-              can_read_word = can_read_word
-                              && (  (file_for_suffix[i].curp + 1
-                                       - sizeof(apr_uintptr_t))
-                                  > min_curp[i]);
-            }
-
-          /* We skipped some bytes, so there are no closing EOLs */
-          had_nl = FALSE;
+            file_for_suffix[i].curp -= delta;
         }
 
-      /* The > min_curp[i] check leaves at least one final byte for checking
-         in the non block optimized case below. */
+      /* Stopping short of min_curp[i] leaves at least one final byte for
+         checking in the non block optimized case below. */
 #endif
 
       reached_prefix = file_for_suffix[0].chunk == suffix_min_chunk0
@@ -798,10 +959,12 @@ datasources_open(void *baton,
                                APR_READ, APR_OS_DEFAULT, file_baton->pool));
       SVN_ERR(svn_io_file_size_get(&filesize, file->file, file_baton->pool));
       file->size = filesize;
+      file->chunk = 0;
       length[i] = filesize > CHUNK_SIZE ? CHUNK_SIZE : filesize;
-      file->buffer = apr_palloc(file_baton->pool, (apr_size_t) length[i]);
-      SVN_ERR(read_chunk(file->file, file->buffer,
-                         length[i], 0, file_baton->pool));
+      SVN_ERR(map_datasource(file, file_baton->options, file_baton->pool));
+      if (!file->map)
+        file->buffer = apr_palloc(file_baton->pool, (apr_size_t) length[i]);
+      SVN_ERR(load_chunk(file, length[i], file_baton->pool));
       file->endp = file->buffer + length[i];
       file->curp = file->buffer;
       /* Set suffix_start_chunk to a guard value, so if suffix scanning is
@@ -950,15 +1113,12 @@ datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
             file_token->norm_offset += (c - curp);
           }
         file_token->length += length;
-        h = svn__adler32(h, c, length);
+        h = svn__fnv1a_32_update(h, c, length);
       }
 
-      curp = endp = file->buffer;
       file->chunk++;
       length = file->chunk == last_chunk ?
         offset_in_chunk(file->size) : CHUNK_SIZE;
-      endp += length;
-      file->endp = endp;
 
       /* Issue #4283: Normally we should have checked for reaching the skipped
          suffix here, but because we assume that a suffix always starts on a
@@ -968,10 +1128,10 @@ datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
          When changing things here, make sure the whitespace settings are
          applied, or we might not reach the exact suffix boundary as token
          boundary. */
-      SVN_ERR(read_chunk(file->file,
-                         curp, length,
-                         chunk_to_offset(file->chunk),
-                         file_baton->pool));
+      SVN_ERR(load_chunk(file, length, file_baton->pool));
+      curp = file->buffer;
+      endp = curp + length;
+      file->endp = endp;
 
       /* If the last chunk ended in a CR, we're done. */
       if (had_cr)
@@ -1007,7 +1167,7 @@ datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
 
       file_token->length += length;
 
-      *hash = svn__adler32(h, c, length);
+      *hash = svn__fnv1a_32_update(h, c, length);
       *token = file_token;
     }
 
@@ -1070,6 +1230,15 @@ token_compare(void *baton, void *token1, void *token2, int *compare)
           bufp[i] = file[i]->buffer;
           bufp[i] += offset_in_chunk(offset[i]);
 
+          length[i] = total_length;
+          raw_length[i] = 0;
+        }
+      else if (file[i]->map)
+        {
+          /* Mapped files are not normalized, so the token is available
+           * as is. */
+          bufp[i] = file[i]->map + offset[i];
+
           length[i] = total_length;
           raw_length[i] = 0;
         }
@@ -1181,6 +1350,7 @@ static const svn_diff_fns2_t svn_diff__file_vtable =
 
 /* Id for the --ignore-eol-style option, which doesn't have a short name. */
 #define SVN_DIFF__OPT_IGNORE_EOL_STYLE 256
+#define SVN_DIFF__OPT_HISTOGRAM 257
 
 /* Options supported by svn_diff_file_options_parse(). */
 static const apr_getopt_option_t diff_options[] =
@@ -1193,6 +1363,7 @@ static const apr_getopt_option_t diff_options[] =
    * ### we don't have optional argument support. */
   { "unified", 'u', 0, NULL },
   { "context", 'U', 1, NULL },
+  { "histogram", SVN_DIFF__OPT_HISTOGRAM, 0, NULL },
   { NULL, 0, 0, NULL }
 };
 
@@ -1292,6 +1463,9 @@ svn_diff_file_options_parse(svn_diff_file_options_t *options,
         case SVN_DIFF__OPT_IGNORE_EOL_STYLE:
           options->ignore_eol_style = TRUE;
           break;
+        case SVN_DIFF__OPT_HISTOGRAM:
+          options->algorithm = svn_diff_algorithm_histogram;
+          break;
         case 'p':
           options->show_c_function = TRUE;
           break;
@@ -1326,7 +1500,8 @@ svn_diff_file_diff_2(svn_diff_t **diff,
   baton.files[1].path = modified;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff_2(diff, &baton, &svn_diff__file_vtable,
+                           options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1348,7 +1523,8 @@ svn_diff_file_diff3_2(svn_diff_t **diff,
   baton.files[2].path = latest;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff3_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff3_2(diff, &baton, &svn_diff__file_vtable,
+                            options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1372,7 +1548,8 @@ svn_diff_file_diff4_2(svn_diff_t **diff,
   baton.files[3].path = ancestor;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff4_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff4_2(diff, &baton, &svn_diff__file_vtable,
+                            options->algorithm, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
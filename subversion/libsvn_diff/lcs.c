@@ -22,10 +22,14 @@
  */
 
 
+#include <stdlib.h>
+
 #include <apr.h>
 #include <apr_pools.h>
 #include <apr_general.h>
 
+#include "svn_pools.h"
+#include "svn_sorts.h"
 #include "diff.h"
 
 
@@ -228,15 +232,17 @@ prepend_lcs(svn_diff__lcs_t *lcs, apr_off_t lines,
 }
 
 
-svn_diff__lcs_t *
-svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
-              svn_diff__position_t *position_list2, /* pointer to tail (ring) */
-              svn_diff__token_index_t *token_counts_list1, /* array of counts */
-              svn_diff__token_index_t *token_counts_list2, /* array of counts */
-              svn_diff__token_index_t num_tokens,
-              apr_off_t prefix_lines,
-              apr_off_t suffix_lines,
-              apr_pool_t *pool)
+/* Return the matches of the O(NP) algorithm described above between
+ * the non-empty rings POSITION_LIST1 and POSITION_LIST2 (pointers to their
+ * tails), given TOKEN_COUNTS_LIST1 and TOKEN_COUNTS_LIST2 of the NUM_TOKENS
+ * tokens in them, in reverse order.  Allocate the result in POOL. */
+static svn_diff__lcs_t *
+lcs_onp(svn_diff__position_t *position_list1,
+        svn_diff__position_t *position_list2,
+        svn_diff__token_index_t *token_counts_list1,
+        svn_diff__token_index_t *token_counts_list2,
+        svn_diff__token_index_t num_tokens,
+        apr_pool_t *pool)
 {
   apr_off_t length[2];
   svn_diff__token_index_t *token_counts[2];
@@ -250,35 +256,6 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
 
   svn_diff__position_t sentinel_position[2];
 
-  /* Since EOF is always a sync point we tack on an EOF link
-   * with sentinel positions
-   */
-  lcs = apr_palloc(pool, sizeof(*lcs));
-  lcs->position[0] = apr_pcalloc(pool, sizeof(*lcs->position[0]));
-  lcs->position[0]->offset = position_list1
-                             ? position_list1->offset + suffix_lines + 1
-                             : prefix_lines + suffix_lines + 1;
-  lcs->position[1] = apr_pcalloc(pool, sizeof(*lcs->position[1]));
-  lcs->position[1]->offset = position_list2
-                             ? position_list2->offset + suffix_lines + 1
-                             : prefix_lines + suffix_lines + 1;
-  lcs->length = 0;
-  lcs->refcount = 1;
-  lcs->next = NULL;
-
-  if (position_list1 == NULL || position_list2 == NULL)
-    {
-      if (suffix_lines)
-        lcs = prepend_lcs(lcs, suffix_lines,
-                          lcs->position[0]->offset - suffix_lines,
-                          lcs->position[1]->offset - suffix_lines,
-                          pool);
-      if (prefix_lines)
-        lcs = prepend_lcs(lcs, prefix_lines, 1, 1, pool);
-
-      return lcs;
-    }
-
   unique_count[1] = unique_count[0] = 0;
   for (token_index = 0; token_index < num_tokens; token_index++)
     {
@@ -355,19 +332,383 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
     }
   while (fp[0].position[1] != &sentinel_position[1]);
 
+  lcs = fp[0].lcs;
+
+  position_list1->next = sentinel_position[0].next;
+  position_list2->next = sentinel_position[1].next;
+
+  return lcs;
+}
+
+/*
+ * Histogram diff, an extension of patience diff.
+ *
+ * Within a region of both sources, find the longest run of common tokens
+ * around the token that occurs least often in the first source, and split
+ * the region there.  Tokens that occur more than HISTOGRAM_MAX_CHAIN times
+ * in a region are not used to find a run; if no run is found only because
+ * of that, the region is passed to the O(NP) algorithm above.  For most
+ * real-world sources this takes near linear time, and it tends to match
+ * distinctive lines rather than braces and blank lines.
+ */
+
+/* The maximum number of occurrences of a token in a region of the first
+ * source, for a run of the histogram diff to be found around it. */
+#define HISTOGRAM_MAX_CHAIN 64
+
+/* A region of both sources, or a run of common tokens of LENGTH
+ * starting at A and B. */
+typedef struct histogram_region_t
+{
+  apr_off_t a, a_end;
+  apr_off_t b, b_end;
+} histogram_region_t;
+
+typedef struct histogram_match_t
+{
+  apr_off_t a;
+  apr_off_t b;
+  apr_off_t length;
+} histogram_match_t;
+
+/* The state of a histogram diff. */
+typedef struct histogram_t
+{
+  /* The positions of both sources, in order. */
+  svn_diff__position_t **position[2];
+
+  /* For each token, the number of occurrences in the first source within
+   * the current region, and the index of its last one. */
+  apr_off_t *count;
+  apr_off_t *last;
+
+  /* For each index of the first source, the index of the previous
+   * occurrence of its token within the current region, or -1. */
+  apr_off_t *prev;
+
+  /* The histogram_match_t runs found so far, in no particular order. */
+  apr_array_header_t *matches;
+
+  svn_diff__token_index_t num_tokens;
+} histogram_t;
+
+#define TOKEN(h, s, i) ((h)->position[s][i]->token_index)
+
+/* Set *MATCH to the run of common tokens in REGION of H around the least
+ * frequent token, and return TRUE, or return FALSE if there is none.  Set
+ * *TOO_MANY if tokens were skipped for occurring too often. */
+static svn_boolean_t
+histogram_find_match(histogram_match_t *match,
+                     svn_boolean_t *too_many,
+                     histogram_t *h,
+                     const histogram_region_t *region)
+{
+  apr_off_t best_count = HISTOGRAM_MAX_CHAIN + 1;
+  apr_off_t ai, bi, b_next;
+
+  *too_many = FALSE;
+  match->length = 0;
+
+  for (ai = region->a; ai < region->a_end; ai++)
+    {
+      svn_diff__token_index_t t = TOKEN(h, 0, ai);
+
+      h->prev[ai] = h->count[t] ? h->last[t] : -1;
+      h->last[t] = ai;
+      h->count[t]++;
+    }
+
+  for (bi = region->b; bi < region->b_end; bi = b_next)
+    {
+      svn_diff__token_index_t t = TOKEN(h, 1, bi);
+
+      b_next = bi + 1;
+
+      if (h->count[t] == 0)
+        continue;
+
+      if (h->count[t] > HISTOGRAM_MAX_CHAIN)
+        {
+          *too_many = TRUE;
+          continue;
+        }
+
+      for (ai = h->last[t]; ai >= 0; ai = h->prev[ai])
+        {
+          apr_off_t a_start = ai, a_end = ai + 1;
+          apr_off_t b_start = bi, b_end = bi + 1;
+          apr_off_t run_count = h->count[t];
+
+          while (a_start > region->a && b_start > region->b
+                 && TOKEN(h, 0, a_start - 1) == TOKEN(h, 1, b_start - 1))
+            {
+              a_start--;
+              b_start--;
+              run_count = MIN(run_count, h->count[TOKEN(h, 0, a_start)]);
+            }
+
+          while (a_end < region->a_end && b_end < region->b_end
+                 && TOKEN(h, 0, a_end) == TOKEN(h, 1, b_end))
+            {
+              run_count = MIN(run_count, h->count[TOKEN(h, 0, a_end)]);
+              a_end++;
+              b_end++;
+            }
+
+          /* Don't look for runs starting within this one again. */
+          if (b_end > b_next)
+            b_next = b_end;
+
+          if (run_count < best_count
+              || (run_count == best_count && a_end - a_start > match->length))
+            {
+              best_count = run_count;
+              match->a = a_start;
+              match->b = b_start;
+              match->length = a_end - a_start;
+            }
+        }
+    }
+
+  for (ai = region->a; ai < region->a_end; ai++)
+    h->count[TOKEN(h, 0, ai)] = 0;
+
+  return match->length > 0;
+}
+
+/* Add the runs the O(NP) algorithm finds in REGION of H to H's matches.
+ * Use SCRATCH_POOL for temporary allocations. */
+static void
+histogram_fallback(histogram_t *h,
+                   const histogram_region_t *region,
+                   apr_pool_t *scratch_pool)
+{
+  svn_diff__position_t *tail[2];
+  svn_diff__position_t *saved_next[2];
+  svn_diff__token_index_t *token_counts[2];
+  apr_off_t base[2];
+  svn_diff__lcs_t *lcs;
+
+  /* Temporarily close REGION of each source into a ring. */
+  tail[0] = h->position[0][region->a_end - 1];
+  tail[1] = h->position[1][region->b_end - 1];
+  saved_next[0] = tail[0]->next;
+  saved_next[1] = tail[1]->next;
+  tail[0]->next = h->position[0][region->a];
+  tail[1]->next = h->position[1][region->b];
+  base[0] = h->position[0][0]->offset;
+  base[1] = h->position[1][0]->offset;
+
+  token_counts[0] = svn_diff__get_token_counts(tail[0], h->num_tokens,
+                                               scratch_pool);
+  token_counts[1] = svn_diff__get_token_counts(tail[1], h->num_tokens,
+                                               scratch_pool);
+
+  for (lcs = lcs_onp(tail[0], tail[1], token_counts[0], token_counts[1],
+                     h->num_tokens, scratch_pool);
+       lcs;
+       lcs = lcs->next)
+    {
+      histogram_match_t *match = apr_array_push(h->matches);
+
+      match->a = lcs->position[0]->offset - base[0];
+      match->b = lcs->position[1]->offset - base[1];
+      match->length = lcs->length;
+    }
+
+  tail[0]->next = saved_next[0];
+  tail[1]->next = saved_next[1];
+}
+
+/* Sort histogram_match_t by position. */
+static int
+compare_matches(const void *a, const void *b)
+{
+  const histogram_match_t *match_a = a;
+  const histogram_match_t *match_b = b;
+
+  return match_a->a < match_b->a ? -1 : (match_a->a > match_b->a ? 1 : 0);
+}
+
+/* Like lcs_onp(), but using the histogram diff. */
+static svn_diff__lcs_t *
+lcs_histogram(svn_diff__position_t *position_list1,
+              svn_diff__position_t *position_list2,
+              svn_diff__token_index_t num_tokens,
+              apr_pool_t *pool)
+{
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_diff__position_t *position_list[2];
+  apr_off_t length[2];
+  apr_array_header_t *regions;
+  histogram_t h;
+  svn_diff__lcs_t *lcs = NULL;
+  int i;
+  int s;
+
+  position_list[0] = position_list1;
+  position_list[1] = position_list2;
+
+  for (s = 0; s < 2; s++)
+    {
+      svn_diff__position_t *position = position_list[s]->next;
+      apr_off_t j;
+
+      length[s] = position_list[s]->offset - position->offset + 1;
+      h.position[s] = apr_palloc(scratch_pool,
+                                 length[s] * sizeof(*h.position[s]));
+      for (j = 0; j < length[s]; j++, position = position->next)
+        h.position[s][j] = position;
+    }
+
+  h.num_tokens = num_tokens;
+  h.count = apr_pcalloc(scratch_pool, num_tokens * sizeof(*h.count));
+  h.last = apr_palloc(scratch_pool, num_tokens * sizeof(*h.last));
+  h.prev = apr_palloc(scratch_pool, length[0] * sizeof(*h.prev));
+  h.matches = apr_array_make(scratch_pool, 16, sizeof(histogram_match_t));
+
+  /* Split regions until no common runs are left, without recursing. */
+  regions = apr_array_make(scratch_pool, 16, sizeof(histogram_region_t));
+  {
+    histogram_region_t *region = apr_array_push(regions);
+
+    region->a = 0;
+    region->a_end = length[0];
+    region->b = 0;
+    region->b_end = length[1];
+  }
+
+  while (regions->nelts)
+    {
+      histogram_region_t region
+        = *(histogram_region_t *)apr_array_pop(regions);
+      histogram_match_t match;
+      svn_boolean_t too_many;
+
+      if (region.a == region.a_end || region.b == region.b_end)
+        continue;
+
+      if (histogram_find_match(&match, &too_many, &h, &region))
+        {
+          histogram_region_t *before = apr_array_push(regions);
+          histogram_region_t *after;
+
+          before->a = region.a;
+          before->a_end = match.a;
+          before->b = region.b;
+          before->b_end = match.b;
+
+          after = apr_array_push(regions);
+          after->a = match.a + match.length;
+          after->a_end = region.a_end;
+          after->b = match.b + match.length;
+          after->b_end = region.b_end;
+
+          APR_ARRAY_PUSH(h.matches, histogram_match_t) = match;
+        }
+      else if (too_many)
+        {
+          svn_pool_clear(iterpool);
+          histogram_fallback(&h, &region, iterpool);
+        }
+    }
+
+  qsort(h.matches->elts, h.matches->nelts, h.matches->elt_size,
+        compare_matches);
+
+  /* Build the matches in reverse order, joining adjacent ones. */
+  for (i = 0; i < h.matches->nelts; i++)
+    {
+      const histogram_match_t *match = &APR_ARRAY_IDX(h.matches, i,
+                                                      histogram_match_t);
+
+      if (lcs
+          && lcs->position[0]->offset + lcs->length
+             == h.position[0][match->a]->offset
+          && lcs->position[1]->offset + lcs->length
+             == h.position[1][match->b]->offset)
+        {
+          lcs->length += match->length;
+          continue;
+        }
+
+      {
+        svn_diff__lcs_t *new_lcs = apr_palloc(pool, sizeof(*new_lcs));
+
+        new_lcs->position[0] = h.position[0][match->a];
+        new_lcs->position[1] = h.position[1][match->b];
+        new_lcs->length = match->length;
+        new_lcs->refcount = 1;
+        new_lcs->next = lcs;
+        lcs = new_lcs;
+      }
+    }
+
+  svn_pool_destroy(scratch_pool);
+
+  return lcs;
+}
+
+svn_diff__lcs_t *
+svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
+              svn_diff__position_t *position_list2, /* pointer to tail (ring) */
+              svn_diff__token_index_t *token_counts_list1, /* array of counts */
+              svn_diff__token_index_t *token_counts_list2, /* array of counts */
+              svn_diff__token_index_t num_tokens,
+              apr_off_t prefix_lines,
+              apr_off_t suffix_lines,
+              svn_diff_algorithm_t algorithm,
+              apr_pool_t *pool)
+{
+  svn_diff__lcs_t *lcs, *matches;
+
+  /* Since EOF is always a sync point we tack on an EOF link
+   * with sentinel positions
+   */
+  lcs = apr_palloc(pool, sizeof(*lcs));
+  lcs->position[0] = apr_pcalloc(pool, sizeof(*lcs->position[0]));
+  lcs->position[0]->offset = position_list1
+                             ? position_list1->offset + suffix_lines + 1
+                             : prefix_lines + suffix_lines + 1;
+  lcs->position[1] = apr_pcalloc(pool, sizeof(*lcs->position[1]));
+  lcs->position[1]->offset = position_list2
+                             ? position_list2->offset + suffix_lines + 1
+                             : prefix_lines + suffix_lines + 1;
+  lcs->length = 0;
+  lcs->refcount = 1;
+  lcs->next = NULL;
+
+  if (position_list1 == NULL || position_list2 == NULL)
+    {
+      if (suffix_lines)
+        lcs = prepend_lcs(lcs, suffix_lines,
+                          lcs->position[0]->offset - suffix_lines,
+                          lcs->position[1]->offset - suffix_lines,
+                          pool);
+      if (prefix_lines)
+        lcs = prepend_lcs(lcs, prefix_lines, 1, 1, pool);
+
+      return lcs;
+    }
+
+  if (algorithm == svn_diff_algorithm_histogram)
+    matches = lcs_histogram(position_list1, position_list2, num_tokens,
+                            pool);
+  else
+    matches = lcs_onp(position_list1, position_list2, token_counts_list1,
+                      token_counts_list2, num_tokens, pool);
+
   if (suffix_lines)
-    lcs->next = prepend_lcs(fp[0].lcs, suffix_lines,
+    lcs->next = prepend_lcs(matches, suffix_lines,
                             lcs->position[0]->offset - suffix_lines,
                             lcs->position[1]->offset - suffix_lines,
                             pool);
   else
-    lcs->next = fp[0].lcs;
+    lcs->next = matches;
 
   lcs = svn_diff__lcs_reverse(lcs);
 
-  position_list1->next = sentinel_position[0].next;
-  position_list2->next = sentinel_position[1].next;
-
   if (prefix_lines)
     return prepend_lcs(lcs, prefix_lines, 1, 1, pool);
   else
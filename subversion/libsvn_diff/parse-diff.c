@@ -106,11 +106,13 @@ struct svn_diff_binary_patch_t {
   apr_off_t src_start;
   apr_off_t src_end;
   svn_filesize_t src_filesize; /* Expanded/final size */
+  svn_boolean_t src_is_delta;  /* Git delta against the dst version */
 
   /* Offsets inside APR_FILE representing the location of the patch */
   apr_off_t dst_start;
   apr_off_t dst_end;
   svn_filesize_t dst_filesize; /* Expanded/final size */
+  svn_boolean_t dst_is_delta;  /* Git delta against the src version */
 };
 
 /* Common guts of svn_diff_hunk__create_adds_single_line() and
@@ -295,6 +297,40 @@ svn_diff_hunk__get_fuzz_penalty(const svn_diff_hunk_t *hunk)
   return hunk->patch->reverse ? hunk->original_fuzz : hunk->modified_fuzz;
 }
 
+/* Make the hunks in the array HUNKS read from APR_FILE. */
+static void
+set_hunks_file(apr_array_header_t *hunks,
+               apr_file_t *apr_file)
+{
+  int i;
+
+  for (i = 0; i < hunks->nelts; i++)
+    APR_ARRAY_IDX(hunks, i, svn_diff_hunk_t *)->apr_file = apr_file;
+}
+
+void
+svn_diff__patch_set_file(svn_patch_t *patch,
+                         apr_file_t *apr_file,
+                         apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+
+  if (patch->hunks)
+    set_hunks_file(patch->hunks, apr_file);
+
+  if (patch->binary_patch)
+    patch->binary_patch->apr_file = apr_file;
+
+  for (hi = apr_hash_first(scratch_pool, patch->prop_patches);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_prop_patch_t *prop_patch = apr_hash_this_val(hi);
+
+      set_hunks_file(prop_patch->hunks, apr_file);
+    }
+}
+
 /* Baton for the base85 stream implementation */
 struct base85_baton_t
 {
@@ -475,34 +511,269 @@ get_verify_length_stream(svn_stream_t *inner,
   return len_stream;
 }
 
+/* Baton for the git delta application stream functions */
+struct undelta_baton_t
+{
+  /* The delta instructions, and the version they apply to (or NULL). */
+  svn_stream_t *delta;
+  apr_file_t *base;
+  svn_filesize_t base_size;
+
+  /* Whether we read the header of DELTA yet, and how many bytes of the
+     result are still to be produced. */
+  svn_boolean_t header_read;
+  svn_filesize_t remaining;
+
+  /* The rest of the current copy or insert instruction. */
+  apr_off_t copy_offset;
+  apr_size_t copy_left;
+  apr_size_t insert_left;
+
+  apr_pool_t *scratch_pool;
+};
+
+/* Read a single byte from the delta stream of UB into *BYTE. */
+static svn_error_t *
+read_delta_byte(unsigned char *byte, struct undelta_baton_t *ub)
+{
+  apr_size_t len = 1;
+
+  SVN_ERR(svn_stream_read_full(ub->delta, (char *)byte, &len));
+  if (len != 1)
+    return svn_error_create(SVN_ERR_DIFF_UNEXPECTED_DATA, NULL,
+                            _("Unexpected end of binary delta"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read a size in the variable length encoding of git deltas from the
+   delta stream of UB into *SIZE. */
+static svn_error_t *
+read_delta_size(svn_filesize_t *size, struct undelta_baton_t *ub)
+{
+  unsigned char byte;
+  int shift = 0;
+
+  *size = 0;
+  do
+    {
+      SVN_ERR(read_delta_byte(&byte, ub));
+
+      if (shift > 56)
+        return svn_error_create(SVN_ERR_DIFF_UNEXPECTED_DATA, NULL,
+                                _("Invalid size in binary delta"));
+
+      *size |= (svn_filesize_t)(byte & 0x7f) << shift;
+      shift += 7;
+    }
+  while (byte & 0x80);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next copy or insert instruction from the delta stream of UB. */
+static svn_error_t *
+read_delta_instruction(struct undelta_baton_t *ub)
+{
+  unsigned char cmd;
+
+  SVN_ERR(read_delta_byte(&cmd, ub));
+
+  if (cmd & 0x80)
+    {
+      apr_uint32_t offset = 0;
+      apr_uint32_t size = 0;
+      unsigned char byte;
+      int i;
+
+      for (i = 0; i < 4; i++)
+        if (cmd & (1 << i))
+          {
+            SVN_ERR(read_delta_byte(&byte, ub));
+            offset |= (apr_uint32_t)byte << (8 * i);
+          }
+      for (i = 0; i < 3; i++)
+        if (cmd & (0x10 << i))
+          {
+            SVN_ERR(read_delta_byte(&byte, ub));
+            size |= (apr_uint32_t)byte << (8 * i);
+          }
+
+      if (size == 0)
+        size = 0x10000;
+
+      if ((svn_filesize_t)offset + size > ub->base_size)
+        return svn_error_create(SVN_ERR_DIFF_BASE_MISMATCH, NULL,
+                                _("Binary delta copies beyond the end "
+                                  "of its base"));
+
+      ub->copy_offset = offset;
+      ub->copy_left = size;
+    }
+  else if (cmd)
+    ub->insert_left = cmd;
+  else
+    return svn_error_create(SVN_ERR_DIFF_UNEXPECTED_DATA, NULL,
+                            _("Invalid instruction in binary delta"));
+
+  if (ub->copy_left + ub->insert_left > ub->remaining)
+    return svn_error_create(SVN_ERR_DIFF_UNEXPECTED_DATA, NULL,
+                            _("Binary delta expands to longer than "
+                              "declared"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_read_fn_t for the git delta application stream */
+static svn_error_t *
+read_handler_undelta(void *baton, char *buffer, apr_size_t *len)
+{
+  struct undelta_baton_t *ub = baton;
+  apr_size_t remaining = *len;
+
+  svn_pool_clear(ub->scratch_pool);
+
+  if (!ub->header_read)
+    {
+      svn_filesize_t base_size;
+      svn_filesize_t actual_size = 0;
+
+      SVN_ERR(read_delta_size(&base_size, ub));
+      SVN_ERR(read_delta_size(&ub->remaining, ub));
+
+      if (ub->base)
+        SVN_ERR(svn_io_file_size_get(&actual_size, ub->base,
+                                     ub->scratch_pool));
+
+      if (!ub->base || base_size != actual_size)
+        return svn_error_create(SVN_ERR_DIFF_BASE_MISMATCH, NULL,
+                                _("Binary delta doesn't apply to the "
+                                  "file it is based on"));
+
+      ub->base_size = base_size;
+      ub->header_read = TRUE;
+    }
+
+  while (remaining && ub->remaining)
+    {
+      apr_size_t chunk;
+
+      if (ub->copy_left)
+        {
+          chunk = MIN(remaining, ub->copy_left);
+
+          SVN_ERR(svn_io_file_seek(ub->base, APR_SET, &ub->copy_offset,
+                                   ub->scratch_pool));
+          SVN_ERR(svn_io_file_read_full2(ub->base, buffer, chunk, NULL, NULL,
+                                         ub->scratch_pool));
+          ub->copy_offset += chunk;
+          ub->copy_left -= chunk;
+        }
+      else if (ub->insert_left)
+        {
+          chunk = MIN(remaining, ub->insert_left);
+
+          SVN_ERR(svn_stream_read_full(ub->delta, buffer, &chunk));
+          if (chunk == 0)
+            return svn_error_create(SVN_ERR_DIFF_UNEXPECTED_DATA, NULL,
+                                    _("Unexpected end of binary delta"));
+          ub->insert_left -= chunk;
+        }
+      else
+        {
+          SVN_ERR(read_delta_instruction(ub));
+          continue;
+        }
+
+      buffer += chunk;
+      remaining -= chunk;
+      ub->remaining -= chunk;
+    }
+
+  *len -= remaining;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t for the git delta application stream */
+static svn_error_t *
+close_handler_undelta(void *baton)
+{
+  struct undelta_baton_t *ub = baton;
+
+  svn_pool_destroy(ub->scratch_pool);
+
+  return svn_error_trace(svn_stream_close(ub->delta));
+}
+
+/* Gets a stream that reads the result of applying the git delta read from
+   DELTA to BASE, which may be NULL if the base version doesn't exist. */
+static svn_stream_t *
+get_undelta_stream(svn_stream_t *delta,
+                   apr_file_t *base,
+                   apr_pool_t *result_pool)
+{
+  struct undelta_baton_t *ub = apr_pcalloc(result_pool, sizeof(*ub));
+  svn_stream_t *s = svn_stream_create(ub, result_pool);
+
+  ub->delta = delta;
+  ub->base = base;
+  ub->scratch_pool = svn_pool_create(result_pool);
+
+  svn_stream_set_read2(s, NULL /* only full read support */,
+                       read_handler_undelta);
+  svn_stream_set_close(s, close_handler_undelta);
+
+  return s;
+}
+
 svn_stream_t *
-svn_diff_get_binary_diff_original_stream(const svn_diff_binary_patch_t *bpatch,
-                                         apr_pool_t *result_pool)
+svn_diff__get_binary_diff_original_stream(
+                        const svn_diff_binary_patch_t *bpatch,
+                        apr_file_t *result_file,
+                        apr_pool_t *result_pool)
 {
   svn_stream_t *s = get_base85_data_stream(bpatch->apr_file, bpatch->src_start,
                                            bpatch->src_end, result_pool);
 
   s = svn_stream_compressed(s, result_pool);
+  s = get_verify_length_stream(s, bpatch->src_filesize, result_pool);
 
-  /* ### If we (ever) want to support the DELTA format, then we should hook the
-         undelta handling here */
+  if (bpatch->src_is_delta)
+    s = get_undelta_stream(s, result_file, result_pool);
 
-  return get_verify_length_stream(s, bpatch->src_filesize, result_pool);
+  return s;
 }
 
 svn_stream_t *
-svn_diff_get_binary_diff_result_stream(const svn_diff_binary_patch_t *bpatch,
-                                       apr_pool_t *result_pool)
+svn_diff__get_binary_diff_result_stream(const svn_diff_binary_patch_t *bpatch,
+                                        apr_file_t *original_file,
+                                        apr_pool_t *result_pool)
 {
   svn_stream_t *s = get_base85_data_stream(bpatch->apr_file, bpatch->dst_start,
                                            bpatch->dst_end, result_pool);
 
   s = svn_stream_compressed(s, result_pool);
+  s = get_verify_length_stream(s, bpatch->dst_filesize, result_pool);
 
-  /* ### If we (ever) want to support the DELTA format, then we should hook the
-  undelta handling here */
+  if (bpatch->dst_is_delta)
+    s = get_undelta_stream(s, original_file, result_pool);
+
+  return s;
+}
+
+svn_stream_t *
+svn_diff_get_binary_diff_original_stream(const svn_diff_binary_patch_t *bpatch,
+                                         apr_pool_t *result_pool)
+{
+  return svn_diff__get_binary_diff_original_stream(bpatch, NULL, result_pool);
+}
 
-  return get_verify_length_stream(s, bpatch->dst_filesize, result_pool);
+svn_stream_t *
+svn_diff_get_binary_diff_result_stream(const svn_diff_binary_patch_t *bpatch,
+                                       apr_pool_t *result_pool)
+{
+  return svn_diff__get_binary_diff_result_stream(bpatch, NULL, result_pool);
 }
 
 /* Try to parse a positive number from a decimal number encoded
@@ -2053,11 +2324,13 @@ parse_binary_patch(svn_patch_t *patch, apr_file_t *apr_file,
               in_src = TRUE;
             }
         }
-      else if (starts_with(line->data, "literal "))
+      else if (starts_with(line->data, "literal ")
+               || starts_with(line->data, "delta "))
         {
+          svn_boolean_t is_delta = (line->data[0] == 'd');
           apr_uint64_t expanded_size;
           svn_error_t *err = svn_cstring_strtoui64(&expanded_size,
-                                                   &line->data[8],
+                                                   strchr(line->data, ' ') + 1,
                                                    0, APR_UINT64_MAX, 10);
 
           if (err)
@@ -2070,16 +2343,18 @@ parse_binary_patch(svn_patch_t *patch, apr_file_t *apr_file,
             {
               bpatch->src_start = pos;
               bpatch->src_filesize = expanded_size;
+              bpatch->src_is_delta = is_delta;
             }
           else
             {
               bpatch->dst_start = pos;
               bpatch->dst_filesize = expanded_size;
+              bpatch->dst_is_delta = is_delta;
             }
           in_blob = TRUE;
         }
       else
-        break; /* We don't support GIT deltas (yet) */
+        break; /* Bad patch */
     }
   svn_pool_destroy(iterpool);
 
@@ -2099,14 +2374,17 @@ parse_binary_patch(svn_patch_t *patch, apr_file_t *apr_file,
       apr_off_t tmp_start = bpatch->src_start;
       apr_off_t tmp_end = bpatch->src_end;
       svn_filesize_t tmp_filesize = bpatch->src_filesize;
+      svn_boolean_t tmp_is_delta = bpatch->src_is_delta;
 
       bpatch->src_start = bpatch->dst_start;
       bpatch->src_end = bpatch->dst_end;
       bpatch->src_filesize = bpatch->dst_filesize;
+      bpatch->src_is_delta = bpatch->dst_is_delta;
 
       bpatch->dst_start = tmp_start;
       bpatch->dst_end = tmp_end;
       bpatch->dst_filesize = tmp_filesize;
+      bpatch->dst_is_delta = tmp_is_delta;
     }
 
   return SVN_NO_ERROR;
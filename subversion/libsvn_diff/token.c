@@ -34,17 +34,17 @@
 
 
 /*
- * Prime number to use as the size of the hash table.  This number was
- * not selected by testing of any kind and may need tweaking.
+ * Initial number of slots in the token hash table.  Must be a power of 2.
+ * The table doubles whenever it becomes half full.
  */
-#define SVN_DIFF__HASH_SIZE 127
+#define SVN_DIFF__HASH_SIZE 1024
 
+/* A slot in the open-addressed token table.  Unused slots have a NULL
+ * TOKEN.  The full HASH is kept to reject most mismatches without
+ * calling back into the datasource.
+ */
 struct svn_diff__node_t
 {
-  svn_diff__node_t       *parent;
-  svn_diff__node_t       *left;
-  svn_diff__node_t       *right;
-
   apr_uint32_t            hash;
   svn_diff__token_index_t index;
   void                   *token;
@@ -52,7 +52,8 @@ struct svn_diff__node_t
 
 struct svn_diff__tree_t
 {
-  svn_diff__node_t       *root[SVN_DIFF__HASH_SIZE];
+  svn_diff__node_t       *nodes;
+  apr_size_t              mask;
   apr_pool_t             *pool;
   svn_diff__token_index_t node_count;
 };
@@ -68,7 +69,7 @@ svn_diff__get_node_count(svn_diff__tree_t *tree)
 }
 
 /*
- * Support functions to build a tree of token positions
+ * Support functions to build a table of token positions
  */
 
 void
@@ -77,66 +78,96 @@ svn_diff__tree_create(svn_diff__tree_t **tree, apr_pool_t *pool)
   *tree = apr_pcalloc(pool, sizeof(**tree));
   (*tree)->pool = pool;
   (*tree)->node_count = 0;
+  (*tree)->mask = SVN_DIFF__HASH_SIZE - 1;
+  (*tree)->nodes = apr_pcalloc(pool, SVN_DIFF__HASH_SIZE
+                                     * sizeof(*(*tree)->nodes));
 }
 
+/* Return the first slot to probe for HASH.  The datasource hashes need
+ * not be well distributed in their lower bits, so mix them first.
+ */
+static APR_INLINE apr_size_t
+hash_slot(apr_uint32_t hash, apr_size_t mask)
+{
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6b;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35;
+  hash ^= hash >> 16;
+
+  return hash & mask;
+}
+
+/* Double the number of slots in TREE and re-insert all tokens. */
+static void
+grow_table(svn_diff__tree_t *tree)
+{
+  svn_diff__node_t *old_nodes = tree->nodes;
+  apr_size_t old_size = tree->mask + 1;
+  apr_size_t i;
+
+  tree->mask = old_size * 2 - 1;
+  tree->nodes = apr_pcalloc(tree->pool, old_size * 2 * sizeof(*tree->nodes));
+
+  for (i = 0; i < old_size; ++i)
+    if (old_nodes[i].token)
+      {
+        apr_size_t slot = hash_slot(old_nodes[i].hash, tree->mask);
+
+        while (tree->nodes[slot].token)
+          slot = (slot + 1) & tree->mask;
+
+        tree->nodes[slot] = old_nodes[i];
+      }
+}
 
 static svn_error_t *
-tree_insert_token(svn_diff__node_t **node, svn_diff__tree_t *tree,
+tree_insert_token(svn_diff__token_index_t *index, svn_diff__tree_t *tree,
                   void *diff_baton,
                   const svn_diff_fns2_t *vtable,
                   apr_uint32_t hash, void *token)
 {
-  svn_diff__node_t *new_node;
-  svn_diff__node_t **node_ref;
-  svn_diff__node_t *parent;
+  svn_diff__node_t *node;
+  apr_size_t slot;
   int rv;
 
   SVN_ERR_ASSERT(token);
 
-  parent = NULL;
-  node_ref = &tree->root[hash % SVN_DIFF__HASH_SIZE];
+  /* Keep the load factor at or below 1/2 so probe sequences stay short. */
+  if ((apr_size_t)tree->node_count * 2 >= tree->mask)
+    grow_table(tree);
 
-  while (*node_ref != NULL)
+  for (slot = hash_slot(hash, tree->mask);
+       tree->nodes[slot].token != NULL;
+       slot = (slot + 1) & tree->mask)
     {
-      parent = *node_ref;
-
-      rv = hash - parent->hash;
-      if (!rv)
-        SVN_ERR(vtable->token_compare(diff_baton, parent->token, token, &rv));
+      node = &tree->nodes[slot];
+      if (node->hash != hash)
+        continue;
 
+      SVN_ERR(vtable->token_compare(diff_baton, node->token, token, &rv));
       if (rv == 0)
         {
           /* Discard the previous token.  This helps in cases where
            * only recently read tokens are still in memory.
            */
           if (vtable->token_discard != NULL)
-            vtable->token_discard(diff_baton, parent->token);
+            vtable->token_discard(diff_baton, node->token);
 
-          parent->token = token;
-          *node = parent;
+          node->token = token;
+          *index = node->index;
 
           return SVN_NO_ERROR;
         }
-      else if (rv > 0)
-        {
-          node_ref = &parent->left;
-        }
-      else
-        {
-          node_ref = &parent->right;
-        }
     }
 
-  /* Create a new node */
-  new_node = apr_palloc(tree->pool, sizeof(*new_node));
-  new_node->parent = parent;
-  new_node->left = NULL;
-  new_node->right = NULL;
-  new_node->hash = hash;
-  new_node->token = token;
-  new_node->index = tree->node_count++;
+  /* Fill the empty slot */
+  node = &tree->nodes[slot];
+  node->hash = hash;
+  node->token = token;
+  node->index = tree->node_count++;
 
-  *node = *node_ref = new_node;
+  *index = node->index;
 
   return SVN_NO_ERROR;
 }
@@ -158,7 +189,7 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
   svn_diff__position_t *start_position;
   svn_diff__position_t *position = NULL;
   svn_diff__position_t **position_ref;
-  svn_diff__node_t *node;
+  svn_diff__token_index_t index;
   void *token;
   apr_off_t offset;
   apr_uint32_t hash;
@@ -176,12 +207,12 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
         break;
 
       offset++;
-      SVN_ERR(tree_insert_token(&node, tree, diff_baton, vtable, hash, token));
+      SVN_ERR(tree_insert_token(&index, tree, diff_baton, vtable, hash, token));
 
       /* Create a new position */
       position = apr_palloc(pool, sizeof(*position));
       position->next = NULL;
-      position->token_index = node->index;
+      position->token_index = index;
       position->offset = offset;
 
       *position_ref = position;
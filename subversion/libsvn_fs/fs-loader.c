@@ -645,8 +645,9 @@ svn_fs_delete_fs(const char *path, apr_pool_t *pool)
 }
 
 svn_error_t *
-svn_fs_hotcopy3(const char *src_path, const char *dst_path,
+svn_fs_hotcopy4(const char *src_path, const char *dst_path,
                 svn_boolean_t clean, svn_boolean_t incremental,
+                int jobs,
                 svn_fs_hotcopy_notify_t notify_func,
                 void *notify_baton,
                 svn_cancel_func_t cancel_func,
@@ -703,7 +704,7 @@ svn_fs_hotcopy3(const char *src_path, const char *dst_path,
     }
 
   SVN_ERR(vtable->hotcopy(src_fs, dst_fs, src_path, dst_path, clean,
-                          incremental, notify_func, notify_baton,
+                          incremental, jobs, notify_func, notify_baton,
                           cancel_func, cancel_baton, common_pool_lock,
                           scratch_pool, common_pool));
   return svn_error_trace(write_fs_type(dst_path, src_fs_type, scratch_pool));
@@ -816,8 +817,8 @@ svn_error_t *
 svn_fs_hotcopy_berkeley(const char *src_path, const char *dest_path,
                         svn_boolean_t clean_logs, apr_pool_t *pool)
 {
-  return svn_error_trace(svn_fs_hotcopy3(src_path, dest_path, clean_logs,
-                                         FALSE, NULL, NULL, NULL, NULL,
+  return svn_error_trace(svn_fs_hotcopy4(src_path, dest_path, clean_logs,
+                                         FALSE, 1, NULL, NULL, NULL, NULL,
                                          pool));
 }
 
@@ -1331,6 +1332,35 @@ svn_fs_node_has_props(svn_boolean_t *has_props,
                                                       scratch_pool));
 }
 
+svn_error_t *
+svn_fs_node_proplists(apr_hash_t **proplists_p,
+                      svn_fs_root_t *root,
+                      const apr_array_header_t *paths,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  int i;
+
+  if (root->vtable->node_proplists)
+    return svn_error_trace(root->vtable->node_proplists(proplists_p, root,
+                                                        paths, result_pool,
+                                                        scratch_pool));
+
+  /* Fall back to fetching one property list at a time. */
+  *proplists_p = apr_hash_make(result_pool);
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      apr_hash_t *proplist;
+
+      SVN_ERR(root->vtable->node_proplist(&proplist, root, path,
+                                          result_pool));
+      svn_hash_sets(*proplists_p, apr_pstrdup(result_pool, path), proplist);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_change_node_prop(svn_fs_root_t *root, const char *path,
                         const char *name, const svn_string_t *value,
@@ -1475,6 +1505,74 @@ svn_fs_dir_optimal_order(apr_array_header_t **ordered_p,
                                                          scratch_pool));
 }
 
+svn_error_t *
+svn_fs__prefetch_dir_entries(svn_fs_root_t *root,
+                             const apr_array_header_t *paths,
+                             apr_pool_t *scratch_pool)
+{
+  /* This is merely a hint that the FS is free to ignore. */
+  if (root->vtable->prefetch_dir_entries == NULL || paths->nelts == 0)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(root->vtable->prefetch_dir_entries(root, paths,
+                                                            scratch_pool));
+}
+
+svn_error_t *
+svn_fs__changed_paths_prev(svn_revnum_t *revision,
+                           svn_boolean_t *structural,
+                           svn_fs_t *fs,
+                           const char *path,
+                           svn_revnum_t before,
+                           apr_pool_t *scratch_pool)
+{
+  *structural = FALSE;
+  if (fs->vtable->changed_paths_prev == NULL)
+    {
+      *revision = SVN_INVALID_REVNUM;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(fs->vtable->changed_paths_prev(revision, structural,
+                                                        fs, path, before,
+                                                        scratch_pool));
+}
+
+svn_error_t *
+svn_fs__changed_paths_next_structural(svn_revnum_t *revision,
+                                      svn_boolean_t *indexed,
+                                      svn_fs_t *fs,
+                                      const char *path,
+                                      svn_revnum_t after,
+                                      svn_revnum_t until,
+                                      apr_pool_t *scratch_pool)
+{
+  *revision = SVN_INVALID_REVNUM;
+  *indexed = FALSE;
+  if (fs->vtable->changed_paths_next_structural == NULL)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(fs->vtable->changed_paths_next_structural(
+                           revision, indexed, fs, path, after, until,
+                           scratch_pool));
+}
+
+svn_error_t *
+svn_fs__dated_revision(svn_revnum_t *revision,
+                       svn_fs_t *fs,
+                       apr_time_t tm,
+                       apr_pool_t *scratch_pool)
+{
+  if (fs->vtable->dated_revision == NULL)
+    {
+      *revision = SVN_INVALID_REVNUM;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(fs->vtable->dated_revision(revision, fs, tm,
+                                                    scratch_pool));
+}
+
 svn_error_t *
 svn_fs_make_dir(svn_fs_root_t *root, const char *path, apr_pool_t *pool)
 {
@@ -1564,6 +1662,28 @@ svn_fs_try_process_file_contents(svn_boolean_t *success,
                          processor, baton, pool));
 }
 
+svn_error_t *
+svn_fs__try_get_file_range(apr_file_t **file,
+                           apr_off_t *offset,
+                           svn_filesize_t *length,
+                           svn_fs_root_t *root,
+                           const char *path,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  /* if the FS doesn't implement this function, report a "failed" attempt */
+  if (root->vtable->try_get_file_range == NULL)
+    {
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(root->vtable->try_get_file_range(file, offset,
+                                                          length, root, path,
+                                                          result_pool,
+                                                          scratch_pool));
+}
+
 svn_error_t *
 svn_fs_make_file(svn_fs_root_t *root, const char *path, apr_pool_t *pool)
 {
@@ -1728,6 +1848,31 @@ svn_fs_get_file_delta_stream(svn_txdelta_stream_t **stream_p,
                            target_root, target_path, pool));
 }
 
+svn_error_t *
+svn_fs__try_get_file_delta_range(apr_file_t **file,
+                                 apr_off_t *offset,
+                                 svn_filesize_t *length,
+                                 svn_fs_root_t *source_root,
+                                 const char *source_path,
+                                 svn_fs_root_t *target_root,
+                                 const char *target_path,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool)
+{
+  /* if the FS doesn't implement this function, report a "failed" attempt */
+  if (target_root->vtable->try_get_file_delta_range == NULL)
+    {
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(target_root->vtable->try_get_file_delta_range(
+                           file, offset, length,
+                           source_root, source_path,
+                           target_root, target_path,
+                           result_pool, scratch_pool));
+}
+
 svn_error_t *
 svn_fs__get_deleted_node(svn_fs_root_t **node_root,
                          const char **node_path,
@@ -118,6 +118,7 @@ typedef struct fs_library_vtable_t
                           const char *dst_path,
                           svn_boolean_t clean,
                           svn_boolean_t incremental,
+                          int jobs,
                           svn_fs_hotcopy_notify_t notify_func,
                           void *notify_baton,
                           svn_cancel_func_t cancel_func,
@@ -266,6 +267,26 @@ typedef struct fs_vtable_t
   svn_error_t *(*bdb_set_errcall)(svn_fs_t *fs,
                                   void (*handler)(const char *errpfx,
                                                   char *msg));
+  /* May be NULL if the back-end keeps no changed-paths index. */
+  svn_error_t *(*changed_paths_prev)(svn_revnum_t *revision,
+                                     svn_boolean_t *structural,
+                                     svn_fs_t *fs,
+                                     const char *path,
+                                     svn_revnum_t before,
+                                     apr_pool_t *scratch_pool);
+  /* May be NULL if the back-end keeps no changed-paths index. */
+  svn_error_t *(*changed_paths_next_structural)(svn_revnum_t *revision,
+                                                svn_boolean_t *indexed,
+                                                svn_fs_t *fs,
+                                                const char *path,
+                                                svn_revnum_t after,
+                                                svn_revnum_t until,
+                                                apr_pool_t *scratch_pool);
+  /* May be NULL if the back-end keeps no revision dates index. */
+  svn_error_t *(*dated_revision)(svn_revnum_t *revision,
+                                 svn_fs_t *fs,
+                                 apr_time_t tm,
+                                 apr_pool_t *scratch_pool);
 } fs_vtable_t;
 
 
@@ -352,6 +373,11 @@ typedef struct root_vtable_t
                                 const char *path, apr_pool_t *pool);
   svn_error_t *(*node_has_props)(svn_boolean_t *has_props, svn_fs_root_t *root,
                                  const char *path, apr_pool_t *scratch_pool);
+  svn_error_t *(*node_proplists)(apr_hash_t **proplists_p,
+                                 svn_fs_root_t *root,
+                                 const apr_array_header_t *paths,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
   svn_error_t *(*change_node_prop)(svn_fs_root_t *root, const char *path,
                                    const char *name,
                                    const svn_string_t *value,
@@ -369,6 +395,9 @@ typedef struct root_vtable_t
                                     apr_hash_t *entries,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
+  svn_error_t *(*prefetch_dir_entries)(svn_fs_root_t *root,
+                                       const apr_array_header_t *paths,
+                                       apr_pool_t *scratch_pool);
   svn_error_t *(*make_dir)(svn_fs_root_t *root, const char *path,
                            apr_pool_t *pool);
 
@@ -387,6 +416,13 @@ typedef struct root_vtable_t
                                             svn_fs_process_contents_func_t processor,
                                             void* baton,
                                             apr_pool_t *pool);
+  svn_error_t *(*try_get_file_range)(apr_file_t **file,
+                                     apr_off_t *offset,
+                                     svn_filesize_t *length,
+                                     svn_fs_root_t *root,
+                                     const char *path,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
   svn_error_t *(*make_file)(svn_fs_root_t *root, const char *path,
                             apr_pool_t *pool);
   svn_error_t *(*apply_textdelta)(svn_txdelta_window_handler_t *contents_p,
@@ -408,6 +444,15 @@ typedef struct root_vtable_t
                                         svn_fs_root_t *target_root,
                                         const char *target_path,
                                         apr_pool_t *pool);
+  svn_error_t *(*try_get_file_delta_range)(apr_file_t **file,
+                                           apr_off_t *offset,
+                                           svn_filesize_t *length,
+                                           svn_fs_root_t *source_root,
+                                           const char *source_path,
+                                           svn_fs_root_t *target_root,
+                                           const char *target_path,
+                                           apr_pool_t *result_pool,
+                                           apr_pool_t *scratch_pool);
 
   /* Merging. */
   svn_error_t *(*merge)(const char **conflict_p,
@@ -35,6 +35,7 @@
 #include "../trail.h"
 #include "../key-gen.h"
 #include "../id.h"
+#include "../caching.h"
 #include "../../libsvn_fs/fs-loader.h"
 #include "bdb-err.h"
 #include "nodes-table.h"
@@ -204,6 +205,19 @@ svn_fs_bdb__get_node_revision(node_revision_t **noderev_p,
   svn_skel_t *skel;
   int db_err;
   DBT key, value;
+  const char *cache_key = NULL;
+
+  /* Node revisions of committed txns may be in our cache. */
+  if (noderev_p && bfd->node_revision_cache)
+    {
+      svn_boolean_t found;
+
+      cache_key = svn_fs_base__id_unparse(id, pool)->data;
+      SVN_ERR(svn_cache__get((void **) noderev_p, &found,
+                             bfd->node_revision_cache, cache_key, pool));
+      if (found)
+        return SVN_NO_ERROR;
+    }
 
   svn_fs_base__trail_debug(trail, "nodes", "get");
   db_err = bfd->nodes->get(bfd->nodes, trail->db_txn,
@@ -230,6 +244,20 @@ svn_fs_bdb__get_node_revision(node_revision_t **noderev_p,
   /* Convert to a native FS type. */
   SVN_ERR(svn_fs_base__parse_node_revision_skel(&noderev, skel, pool));
   *noderev_p = noderev;
+
+  /* Mutable node revisions must not be cached. */
+  if (cache_key)
+    {
+      svn_boolean_t committed;
+
+      SVN_ERR(svn_fs_base__txn_is_committed(&committed, fs,
+                                            svn_fs_base__id_txn_id(id),
+                                            trail, pool));
+      if (committed)
+        SVN_ERR(svn_cache__set(bfd->node_revision_cache, cache_key,
+                               noderev, pool));
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -0,0 +1,462 @@
+/* caching.c : in-memory caching of immutable filesystem data
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* Berkeley DB transactions give us no hook to invalidate cached data
+ * when a trail commits or aborts.  Hence, we only ever cache data that
+ * can't change anymore: node revisions and representations created by
+ * committed Subversion transactions.  Data of unfinished transactions
+ * is always read from the database.  Since transaction ids and
+ * representation keys are never reused, cached entries stay valid for
+ * the lifetime of the repository.
+ *
+ * Note that deltification may change how a committed representation is
+ * stored but never its contents, so the fulltext cache is not affected.
+ *
+ * As with FSFS repositories without an instance ID, the cache keys are
+ * derived from the repository UUID and path only.  Replacing a repository
+ * with one of the same UUID at the same path while the cache is alive
+ * may therefore return stale data.
+ */
+
+#include <string.h>
+
+#include "svn_fs.h"
+#include "svn_hash.h"
+#include "svn_pools.h"
+
+#include "fs.h"
+#include "err.h"
+#include "id.h"
+#include "trail.h"
+#include "caching.h"
+#include "bdb/txn-table.h"
+#include "../libsvn_fs/fs-loader.h"
+
+#include "private/svn_subr_private.h"
+#include "private/svn_temp_serializer.h"
+#include "svn_private_config.h"
+
+
+
+/*** Configuration ***/
+
+/* Take the ORIGINAL string and replace all occurrences of ":" without
+ * limiting the key space.  Allocate the result in POOL.
+ */
+static const char *
+normalize_key_part(const char *original,
+                   apr_pool_t *pool)
+{
+  apr_size_t i;
+  apr_size_t len = strlen(original);
+  svn_stringbuf_t *normalized = svn_stringbuf_create_ensure(len, pool);
+
+  for (i = 0; i < len; ++i)
+    {
+      char c = original[i];
+      switch (c)
+        {
+        case ':': svn_stringbuf_appendbytes(normalized, "%_", 2);
+                  break;
+        case '%': svn_stringbuf_appendbytes(normalized, "%%", 2);
+                  break;
+        default : svn_stringbuf_appendbyte(normalized, c);
+        }
+    }
+
+  return normalized->data;
+}
+
+/* Implements svn_cache__error_handler_t.
+ * Log the error and pass it on to the caller.
+ */
+static svn_error_t *
+warn_and_fail_on_cache_errors(svn_error_t *err,
+                              void *baton,
+                              apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  (fs->warning)(fs->warning_baton, err);
+  return err;
+}
+
+/* Set *CACHE_P to a new cache in MEMBUFFER using SERIALIZER,
+ * DESERIALIZER, KLEN and PREFIX.  Use PRIORITY as the membuffer
+ * priority class.  Report errors to FS's warning callback.
+ *
+ * Allocate the cache in RESULT_POOL and temporaries in SCRATCH_POOL.
+ */
+static svn_error_t *
+create_cache(svn_cache__t **cache_p,
+             svn_membuffer_t *membuffer,
+             svn_cache__serialize_func_t serializer,
+             svn_cache__deserialize_func_t deserializer,
+             apr_ssize_t klen,
+             const char *prefix,
+             apr_uint32_t priority,
+             svn_boolean_t has_namespace,
+             svn_fs_t *fs,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_cache__create_membuffer_cache(cache_p, membuffer,
+                                            serializer, deserializer,
+                                            klen, prefix, priority,
+                                            FALSE, has_namespace,
+                                            result_pool, scratch_pool));
+  return svn_error_trace(svn_cache__set_error_handler(
+                           *cache_p, warn_and_fail_on_cache_errors, fs,
+                           result_pool));
+}
+
+
+
+/*** Serialization ***/
+
+/* Implements svn_cache__serialize_func_t for svn_revnum_t.
+ */
+static svn_error_t *
+serialize_revnum(void **data,
+                 apr_size_t *data_len,
+                 void *in,
+                 apr_pool_t *pool)
+{
+  *data = apr_pmemdup(pool, in, sizeof(svn_revnum_t));
+  *data_len = sizeof(svn_revnum_t);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t for svn_revnum_t.
+ */
+static svn_error_t *
+deserialize_revnum(void **out,
+                   void *data,
+                   apr_size_t data_len,
+                   apr_pool_t *pool)
+{
+  /* DATA has already been copied into POOL. */
+  *out = data;
+
+  return SVN_NO_ERROR;
+}
+
+/* The serialized form of a node_revision_t.  IDs have no serialization
+ * support of their own, so we store the predecessor in unparsed form.
+ */
+typedef struct cached_noderev_t
+{
+  /* The node revision with PREDECESSOR_ID set to NULL.  This must be
+     the first member. */
+  node_revision_t noderev;
+
+  /* The unparsed predecessor ID.  May be NULL. */
+  const char *predecessor_id;
+} cached_noderev_t;
+
+/* Implements svn_cache__serialize_func_t for node_revision_t.
+ */
+static svn_error_t *
+serialize_node_revision(void **data,
+                        apr_size_t *data_len,
+                        void *in,
+                        apr_pool_t *pool)
+{
+  const node_revision_t *noderev = in;
+  cached_noderev_t cached;
+  svn_temp_serializer__context_t *context;
+  svn_stringbuf_t *serialized;
+
+  cached.noderev = *noderev;
+  cached.noderev.predecessor_id = NULL;
+  cached.predecessor_id
+    = noderev->predecessor_id
+    ? svn_fs_base__id_unparse(noderev->predecessor_id, pool)->data
+    : NULL;
+
+  context = svn_temp_serializer__init(&cached, sizeof(cached), 256, pool);
+  svn_temp_serializer__add_string(context, &cached.noderev.prop_key);
+  svn_temp_serializer__add_string(context, &cached.noderev.data_key);
+  svn_temp_serializer__add_string(context,
+                                  &cached.noderev.data_key_uniquifier);
+  svn_temp_serializer__add_string(context, &cached.noderev.edit_key);
+  svn_temp_serializer__add_string(context, &cached.noderev.created_path);
+  svn_temp_serializer__add_string(context, &cached.predecessor_id);
+
+  serialized = svn_temp_serializer__get(context);
+  *data = serialized->data;
+  *data_len = serialized->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t for node_revision_t.
+ */
+static svn_error_t *
+deserialize_node_revision(void **out,
+                          void *data,
+                          apr_size_t data_len,
+                          apr_pool_t *pool)
+{
+  cached_noderev_t *cached = data;
+  node_revision_t *noderev = &cached->noderev;
+
+  svn_temp_deserializer__resolve(cached, (void **)&noderev->prop_key);
+  svn_temp_deserializer__resolve(cached, (void **)&noderev->data_key);
+  svn_temp_deserializer__resolve(cached,
+                                 (void **)&noderev->data_key_uniquifier);
+  svn_temp_deserializer__resolve(cached, (void **)&noderev->edit_key);
+  svn_temp_deserializer__resolve(cached, (void **)&noderev->created_path);
+  svn_temp_deserializer__resolve(cached, (void **)&cached->predecessor_id);
+
+  if (cached->predecessor_id)
+    noderev->predecessor_id
+      = svn_fs_base__id_parse(cached->predecessor_id,
+                              strlen(cached->predecessor_id), pool);
+
+  *out = noderev;
+  return SVN_NO_ERROR;
+}
+
+/* A directory entry in serialized form.  Both members are C strings.
+ */
+typedef struct cached_dirent_t
+{
+  const char *name;
+  const char *id;
+} cached_dirent_t;
+
+/* The serialized form of a directory's entries list.
+ */
+typedef struct cached_entries_t
+{
+  /* Number of elements in ENTRIES. */
+  int count;
+
+  /* The entries in no particular order. */
+  cached_dirent_t *entries;
+} cached_entries_t;
+
+/* Implements svn_cache__serialize_func_t for an apr_hash_t of entry
+ * name -> svn_fs_dirent_t.
+ */
+static svn_error_t *
+serialize_dir_entries(void **data,
+                      apr_size_t *data_len,
+                      void *in,
+                      apr_pool_t *pool)
+{
+  apr_hash_t *entries = in;
+  apr_hash_index_t *hi;
+  cached_entries_t cached;
+  svn_temp_serializer__context_t *context;
+  svn_stringbuf_t *serialized;
+  int i;
+
+  cached.count = 0;
+  cached.entries = apr_palloc(pool, apr_hash_count(entries)
+                                    * sizeof(*cached.entries));
+  for (hi = apr_hash_first(pool, entries); hi; hi = apr_hash_next(hi))
+    {
+      const svn_fs_dirent_t *dirent = apr_hash_this_val(hi);
+      cached_dirent_t *entry = &cached.entries[cached.count++];
+
+      entry->name = dirent->name;
+      entry->id = svn_fs_base__id_unparse(dirent->id, pool)->data;
+    }
+
+  /* Directories are often large and entry names are short.  Reserve
+     some 40 bytes of name and id per entry. */
+  context = svn_temp_serializer__init(&cached, sizeof(cached),
+                                      cached.count
+                                        * (sizeof(*cached.entries) + 40)
+                                        + 64,
+                                      pool);
+  svn_temp_serializer__push(context,
+                            (const void * const *)&cached.entries,
+                            cached.count * sizeof(*cached.entries));
+  for (i = 0; i < cached.count; ++i)
+    {
+      svn_temp_serializer__add_string(context, &cached.entries[i].name);
+      svn_temp_serializer__add_string(context, &cached.entries[i].id);
+    }
+  svn_temp_serializer__pop(context);
+
+  serialized = svn_temp_serializer__get(context);
+  *data = serialized->data;
+  *data_len = serialized->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t for an apr_hash_t of entry
+ * name -> svn_fs_dirent_t.
+ */
+static svn_error_t *
+deserialize_dir_entries(void **out,
+                        void *data,
+                        apr_size_t data_len,
+                        apr_pool_t *pool)
+{
+  cached_entries_t *cached = data;
+  apr_hash_t *entries = apr_hash_make(pool);
+  int i;
+
+  svn_temp_deserializer__resolve(cached, (void **)&cached->entries);
+  for (i = 0; i < cached->count; ++i)
+    {
+      cached_dirent_t *entry = &cached->entries[i];
+      svn_fs_dirent_t *dirent = apr_palloc(pool, sizeof(*dirent));
+
+      svn_temp_deserializer__resolve(cached->entries, (void **)&entry->name);
+      svn_temp_deserializer__resolve(cached->entries, (void **)&entry->id);
+
+      dirent->name = entry->name;
+      dirent->id = svn_fs_base__id_parse(entry->id, strlen(entry->id), pool);
+      dirent->kind = svn_node_unknown;
+      svn_hash_sets(entries, dirent->name, dirent);
+    }
+
+  *out = entries;
+  return SVN_NO_ERROR;
+}
+
+
+
+/*** Public interface ***/
+
+svn_error_t *
+svn_fs_base__initialize_caches(svn_fs_t *fs,
+                               apr_pool_t *scratch_pool)
+{
+  base_fs_data_t *bfd = fs->fsap_data;
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *cache_namespace;
+  svn_boolean_t has_namespace;
+  const char *prefix;
+
+  /* Without a membuffer, there is nothing to do.  We don't fall back to
+     inprocess caches because those would only duplicate what the BDB
+     buffer cache already provides. */
+  if (! membuffer)
+    return SVN_NO_ERROR;
+
+  /* Same options as for FSFS. */
+  cache_namespace
+    = normalize_key_part(svn_hash__get_cstring(fs->config,
+                                               SVN_FS_CONFIG_FSFS_CACHE_NS,
+                                               ""),
+                         scratch_pool);
+  has_namespace = *cache_namespace != '\0';
+  prefix = apr_pstrcat(scratch_pool,
+                       "ns:", cache_namespace, ":",
+                       "fsbase:", fs->uuid,
+                       "/", normalize_key_part(fs->path, scratch_pool),
+                       ":",
+                       SVN_VA_NULL);
+
+  /* Needed for each node revision and rep to cache.  High priority as
+     it is tiny and guards everything else. */
+  SVN_ERR(create_cache(&bfd->committed_txns_cache, membuffer,
+                       serialize_revnum, deserialize_revnum,
+                       APR_HASH_KEY_STRING,
+                       apr_pstrcat(scratch_pool, prefix, "TXN",
+                                   SVN_VA_NULL),
+                       SVN_CACHE__MEMBUFFER_HIGH_PRIORITY, has_namespace,
+                       fs, fs->pool, scratch_pool));
+
+  SVN_ERR(create_cache(&bfd->node_revision_cache, membuffer,
+                       serialize_node_revision, deserialize_node_revision,
+                       APR_HASH_KEY_STRING,
+                       apr_pstrcat(scratch_pool, prefix, "NODEREVS",
+                                   SVN_VA_NULL),
+                       SVN_CACHE__MEMBUFFER_HIGH_PRIORITY, has_namespace,
+                       fs, fs->pool, scratch_pool));
+
+  SVN_ERR(create_cache(&bfd->dir_entries_cache, membuffer,
+                       serialize_dir_entries, deserialize_dir_entries,
+                       APR_HASH_KEY_STRING,
+                       apr_pstrcat(scratch_pool, prefix, "DIR",
+                                   SVN_VA_NULL),
+                       SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, has_namespace,
+                       fs, fs->pool, scratch_pool));
+
+  /* Fulltexts can be reconstructed from the database and tend to be
+     large, so they get low priority. */
+  if (svn_hash__get_bool(fs->config, SVN_FS_CONFIG_FSFS_CACHE_FULLTEXTS,
+                         TRUE))
+    SVN_ERR(create_cache(&bfd->fulltext_cache, membuffer,
+                         NULL, NULL,
+                         APR_HASH_KEY_STRING,
+                         apr_pstrcat(scratch_pool, prefix, "TEXT",
+                                     SVN_VA_NULL),
+                         SVN_CACHE__MEMBUFFER_LOW_PRIORITY, has_namespace,
+                         fs, fs->pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_fs_base__txn_is_committed(svn_boolean_t *committed,
+                              svn_fs_t *fs,
+                              const char *txn_id,
+                              trail_t *trail,
+                              apr_pool_t *pool)
+{
+  base_fs_data_t *bfd = fs->fsap_data;
+  transaction_t *txn;
+  svn_boolean_t found;
+  void *dummy;
+
+  /* Data without an owning txn can't be modified by anyone. */
+  if (! txn_id || ! *txn_id)
+    {
+      *committed = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Without caches, there is no point in asking. */
+  if (! bfd->committed_txns_cache)
+    {
+      *committed = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_cache__get(&dummy, &found, bfd->committed_txns_cache, txn_id,
+                         pool));
+  if (found)
+    {
+      *committed = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Unfinished transactions may get committed later, so we only cache
+     the positive answer. */
+  SVN_ERR(svn_fs_bdb__get_txn(&txn, fs, txn_id, trail, pool));
+  *committed = txn->kind == transaction_kind_committed;
+  if (*committed)
+    SVN_ERR(svn_cache__set(bfd->committed_txns_cache, txn_id,
+                           &txn->revision, pool));
+
+  return SVN_NO_ERROR;
+}
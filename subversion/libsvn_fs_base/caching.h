@@ -0,0 +1,67 @@
+/* caching.h : in-memory caching of immutable filesystem data
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_CACHING_H
+#define SVN_LIBSVN_FS_CACHING_H
+
+#include "svn_fs.h"
+
+#include "fs.h"
+#include "trail.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+
+/* Initialize the node revision, directory entries and fulltext caches
+   of FS, allocated in FS->POOL.  All of them live in the global
+   membuffer cache and stay NULL if there is none.  Use SCRATCH_POOL
+   for temporary allocations.
+
+   FS->UUID must already be set. */
+svn_error_t *svn_fs_base__initialize_caches(svn_fs_t *fs,
+                                            apr_pool_t *scratch_pool);
+
+
+/* Set *COMMITTED to TRUE if data created by the transaction TXN_ID in
+   FS can never change anymore, i.e. if TXN_ID is NULL or empty or names
+   a committed transaction.  Set it to FALSE otherwise.  Do this as part
+   of TRAIL, using POOL for temporary allocations.
+
+   Only data for which this returns TRUE may be put into the caches of
+   FS.  Because a transaction becomes committed only at the very end of
+   the trail that commits it, no trail ever sees data as committed that
+   it may still roll back. */
+svn_error_t *svn_fs_base__txn_is_committed(svn_boolean_t *committed,
+                                           svn_fs_t *fs,
+                                           const char *txn_id,
+                                           trail_t *trail,
+                                           apr_pool_t *pool);
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_CACHING_H */
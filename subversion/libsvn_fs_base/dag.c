@@ -39,6 +39,7 @@
 #include "reps-strings.h"
 #include "revs-txns.h"
 #include "id.h"
+#include "caching.h"
 
 #include "util/fs_skels.h"
 
@@ -270,22 +271,26 @@ svn_fs_base__dag_init_fs(svn_fs_t *fs)
 
 /* Some of these are helpers for functions outside this section. */
 
-/* Given directory NODEREV in FS, set *ENTRIES_P to its entries list
-   hash, as part of TRAIL, or to NULL if NODEREV has no entries.  The
-   entries list will be allocated in POOL, and the entries in that
-   list will not have interesting value in their 'kind' fields.  If
-   NODEREV is not a directory, return the error SVN_ERR_FS_NOT_DIRECTORY. */
+/* Given directory NODEREV with node revision ID ID in FS, set *ENTRIES_P
+   to its entries list hash, as part of TRAIL, or to NULL if NODEREV has
+   no entries.  The entries list will be allocated in POOL, and the
+   entries in that list will not have interesting value in their 'kind'
+   fields.  If NODEREV is not a directory, return the error
+   SVN_ERR_FS_NOT_DIRECTORY. */
 static svn_error_t *
 get_dir_entries(apr_hash_t **entries_p,
                 svn_fs_t *fs,
+                const svn_fs_id_t *id,
                 node_revision_t *noderev,
                 trail_t *trail,
                 apr_pool_t *pool)
 {
+  base_fs_data_t *bfd = fs->fsap_data;
   apr_hash_t *entries = NULL;
   apr_hash_index_t *hi;
   svn_string_t entries_raw;
   svn_skel_t *entries_skel;
+  svn_boolean_t use_cache = FALSE;
 
   /* Error if this is not a directory. */
   if (noderev->kind != svn_node_dir)
@@ -293,6 +298,25 @@ get_dir_entries(apr_hash_t **entries_p,
       (SVN_ERR_FS_NOT_DIRECTORY, NULL,
        _("Attempted to get entries of a non-directory node"));
 
+  /* Only entries lists that can't change anymore go through the cache.
+     A committed node revision only refers to committed representations,
+     so the node's own txn tells us without reading the representation. */
+  if (noderev->data_key && bfd->dir_entries_cache)
+    SVN_ERR(svn_fs_base__txn_is_committed(&use_cache, fs,
+                                          svn_fs_base__id_txn_id(id),
+                                          trail, pool));
+
+  if (use_cache)
+    {
+      svn_boolean_t found;
+
+      SVN_ERR(svn_cache__get((void **) entries_p, &found,
+                             bfd->dir_entries_cache, noderev->data_key,
+                             pool));
+      if (found)
+        return SVN_NO_ERROR;
+    }
+
   /* If there's a DATA-KEY, there might be entries to fetch. */
   if (noderev->data_key)
     {
@@ -329,6 +353,10 @@ get_dir_entries(apr_hash_t **entries_p,
       apr_hash_set(*entries_p, key, klen, dirent);
     }
 
+  if (use_cache)
+    SVN_ERR(svn_cache__set(bfd->dir_entries_cache, noderev->data_key,
+                           *entries_p, pool));
+
   /* Return our findings. */
   return SVN_NO_ERROR;
 }
@@ -510,7 +538,8 @@ svn_fs_base__dag_dir_entries(apr_hash_t **entries,
   node_revision_t *noderev;
   SVN_ERR(svn_fs_bdb__get_node_revision(&noderev, node->fs, node->id,
                                         trail, pool));
-  return get_dir_entries(entries, node->fs, noderev, trail, pool);
+  return get_dir_entries(entries, node->fs, node->id, noderev, trail,
+                         pool);
 }
 
 
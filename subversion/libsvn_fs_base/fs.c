@@ -40,6 +40,7 @@
 #include "dag.h"
 #include "revs-txns.h"
 #include "uuid.h"
+#include "caching.h"
 #include "tree.h"
 #include "id.h"
 #include "lock.h"
@@ -574,6 +575,9 @@ static fs_vtable_t fs_vtable = {
   base_bdb_verify_root,
   base_bdb_freeze,
   base_bdb_set_errcall,
+  NULL, /* changed_paths_prev */
+  NULL, /* changed_paths_next_structural */
+  NULL /* dated_revision */
 };
 
 /* Where the format number is stored. */
@@ -732,6 +736,7 @@ static svn_error_t *
 populate_opened_fs(svn_fs_t *fs, apr_pool_t *scratch_pool)
 {
   SVN_ERR(svn_fs_base__populate_uuid(fs, scratch_pool));
+  SVN_ERR(svn_fs_base__initialize_caches(fs, scratch_pool));
   return SVN_NO_ERROR;
 }
 
@@ -1301,6 +1306,7 @@ base_hotcopy(svn_fs_t *src_fs,
              const char *dest_path,
              svn_boolean_t clean_logs,
              svn_boolean_t incremental,
+             int jobs,
              svn_fs_hotcopy_notify_t notify_func,
              void *notify_baton,
              svn_cancel_func_t cancel_func,
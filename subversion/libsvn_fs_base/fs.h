@@ -30,6 +30,8 @@
 #include <apr_hash.h>
 #include "svn_fs.h"
 
+#include "private/svn_cache.h"
+
 #include "bdb/env.h"
 
 #ifdef __cplusplus
@@ -115,6 +117,24 @@ typedef struct base_fs_data_t
   /* The format number of this FS. */
   int format;
 
+  /* Caches of immutable data, i.e. of data created by committed
+     transactions.  These are NULL if no membuffer cache is available.
+     See caching.c for details. */
+
+  /* Committed transaction id -> svn_revnum_t */
+  svn_cache__t *committed_txns_cache;
+
+  /* Unparsed node revision id -> node_revision_t */
+  svn_cache__t *node_revision_cache;
+
+  /* Representation key of a directory's entries list -> apr_hash_t of
+     entry name -> svn_fs_dirent_t */
+  svn_cache__t *dir_entries_cache;
+
+  /* Representation key -> svn_stringbuf_t fulltext.  NULL if fulltext
+     caching has been disabled. */
+  svn_cache__t *fulltext_cache;
+
 } base_fs_data_t;
 
 
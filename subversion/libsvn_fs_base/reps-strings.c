@@ -25,10 +25,13 @@
 #include "svn_fs.h"
 #include "svn_pools.h"
 
+#include "private/svn_delta_private.h"
+
 #include "fs.h"
 #include "err.h"
 #include "trail.h"
 #include "reps-strings.h"
+#include "caching.h"
 
 #include "bdb/reps-table.h"
 #include "bdb/strings-table.h"
@@ -178,6 +181,9 @@ struct compose_handler_baton
      the stream, and we have to ignore that; but we must also know
      when it's appropriate to push a NULL window at the combiner. */
   svn_boolean_t init;
+
+  /* Scratch memory for combining windows, shared along the chain. */
+  svn_txdelta__composer_t *composer;
 };
 
 
@@ -221,8 +227,9 @@ compose_handler(svn_txdelta_window_t *window, void *baton)
           apr_pool_t *composite_pool = svn_pool_create(cb->trail->pool);
           svn_txdelta_window_t *composite;
 
-          composite = svn_txdelta_compose_windows(window, cb->window,
-                                                  composite_pool);
+          composite = svn_txdelta__compose_windows(cb->composer,
+                                                   window, cb->window,
+                                                   composite_pool);
           svn_pool_destroy(cb->window_pool);
           cb->window = composite;
           cb->window_pool = composite_pool;
@@ -332,6 +339,7 @@ rep_undeltify_range(svn_fs_t *fs,
                     trail_t *trail,
                     apr_pool_t *pool)
 {
+  svn_txdelta__composer_t *composer = svn_txdelta__composer_create(pool);
   apr_size_t len_read = 0;
 
   do
@@ -343,6 +351,7 @@ rep_undeltify_range(svn_fs_t *fs,
 
       cb.trail = trail;
       cb.done = FALSE;
+      cb.composer = composer;
       for (cur_rep = 0; !cb.done && cur_rep < deltas->nelts; ++cur_rep)
         {
           representation_t *const rep =
@@ -784,10 +793,27 @@ svn_fs_base__rep_contents(svn_string_t *str,
                           trail_t *trail,
                           apr_pool_t *pool)
 {
+  base_fs_data_t *bfd = fs->fsap_data;
   svn_filesize_t contents_size;
   apr_size_t len;
   char *data;
 
+  /* Contents of committed reps may be in our cache. */
+  if (bfd->fulltext_cache)
+    {
+      svn_stringbuf_t *fulltext;
+      svn_boolean_t found;
+
+      SVN_ERR(svn_cache__get((void **) &fulltext, &found,
+                             bfd->fulltext_cache, rep_key, pool));
+      if (found)
+        {
+          str->data = fulltext->data;
+          str->len = fulltext->len;
+          return SVN_NO_ERROR;
+        }
+    }
+
   SVN_ERR(svn_fs_base__rep_contents_size(&contents_size, fs, rep_key,
                                          trail, pool));
 
@@ -802,7 +828,9 @@ svn_fs_base__rep_contents(svn_string_t *str,
   else
     str->len = (apr_size_t) contents_size;
 
-  data = apr_palloc(pool, str->len);
+  /* Leave room for a terminating NUL so we can cache the contents
+     as a stringbuf without copying them. */
+  data = apr_palloc(pool, str->len + 1);
   str->data = data;
   len = str->len;
   SVN_ERR(rep_read_range(fs, rep_key, 0, data, &len, trail, pool));
@@ -812,6 +840,7 @@ svn_fs_base__rep_contents(svn_string_t *str,
     return svn_error_createf
       (SVN_ERR_FS_CORRUPT, NULL,
        _("Failure reading representation '%s'"), rep_key);
+  data[len] = '\0';
 
   /* Just the standard paranoia. */
   {
@@ -829,6 +858,26 @@ svn_fs_base__rep_contents(svn_string_t *str,
                             _("Checksum mismatch on representation '%s'"),
                             rep_key),
                 NULL);
+
+    /* Only cache contents that can't change anymore. */
+    if (bfd->fulltext_cache)
+      {
+        svn_boolean_t committed;
+
+        SVN_ERR(svn_fs_base__txn_is_committed(&committed, fs, rep->txn_id,
+                                              trail, pool));
+        if (committed)
+          {
+            svn_stringbuf_t fulltext;
+
+            fulltext.pool = pool;
+            fulltext.data = data;
+            fulltext.len = str->len;
+            fulltext.blocksize = str->len + 1;
+            SVN_ERR(svn_cache__set(bfd->fulltext_cache, rep_key, &fulltext,
+                                   pool));
+          }
+      }
   }
 
   return SVN_NO_ERROR;
@@ -5526,20 +5526,24 @@ static root_vtable_t root_vtable = {
   base_node_prop,
   base_node_proplist,
   base_node_has_props,
+  NULL,
   base_change_node_prop,
   base_props_changed,
   base_dir_entries,
   base_dir_optimal_order,
+  NULL,
   base_make_dir,
   base_file_length,
   base_file_checksum,
   base_file_contents,
   NULL,
+  NULL,
   base_make_file,
   base_apply_textdelta,
   base_apply_text,
   base_contents_changed,
   base_get_file_delta_stream,
+  NULL,
   base_merge,
   base_get_mergeinfo,
 };
@@ -40,6 +40,7 @@
 #include "pack.h"
 #include "util.h"
 #include "temp_serializer.h"
+#include "txn-store.h"
 
 #include "../libsvn_fs/fs-loader.h"
 #include "../libsvn_delta/delta.h"  /* for SVN_DELTA_WINDOW_SIZE */
@@ -193,6 +194,50 @@ dbg_log_access(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* If access logging has been enabled for FS, record an access to the item
+ * of ITEM_TYPE (SVN_FS_FS__ITEM_TYPE_*) in REVISION.  OFFSET and SIZE give
+ * its location in the rev / pack file if known, -1 and 0 otherwise.
+ * CACHE_HIT tells whether the item has been served from cache.
+ */
+static svn_error_t *
+log_access(svn_fs_t *fs,
+           svn_revnum_t revision,
+           apr_off_t offset,
+           apr_off_t size,
+           apr_uint32_t item_type,
+           svn_boolean_t cache_hit)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs__access_t access;
+
+  if (!ffd->access_log)
+    return SVN_NO_ERROR;
+
+  access.revision = revision;
+  access.packed = svn_fs_fs__is_packed_rev(fs, revision);
+  access.offset = offset;
+  access.size = (apr_uint32_t)MIN(MAX(size, 0), APR_UINT32_MAX);
+  access.item_type = item_type;
+  access.cache_hit = cache_hit;
+
+  return svn_error_trace(svn_fs__access_log_add(ffd->access_log, &access));
+}
+
+/* Call log_access for a cache hit on the ITEM_TYPE contents of REP in FS.
+ * No-op for NULL and uncommitted REPs.
+ */
+static svn_error_t *
+log_rep_hit(svn_fs_t *fs,
+            const representation_t *rep,
+            apr_uint32_t item_type)
+{
+  if (!rep || svn_fs_fs__id_txn_used(&rep->txn_id))
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(log_access(fs, rep->revision, -1, 0, item_type,
+                                    TRUE));
+}
+
 /* Convenience wrapper around svn_io_file_aligned_seek, taking filesystem
    FS instead of a block size. */
 static svn_error_t *
@@ -416,15 +461,15 @@ get_node_revision_body(node_revision_t **noderev_p,
 
   if (svn_fs_fs__id_is_txn(id))
     {
-      apr_file_t *file;
+      svn_stream_t *stream;
+      const char *path = svn_fs_fs__path_txn_node_rev(fs, id, scratch_pool);
 
       /* This is a transaction node-rev.  Its storage logic is very
          different from that of rev / pack files. */
-      err = svn_io_file_open(&file,
-                             svn_fs_fs__path_txn_node_rev(fs, id,
-                             scratch_pool),
-                             APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
-                             scratch_pool);
+      err = svn_fs_fs__txn_store_open_readonly(&stream, fs,
+                                               svn_fs_fs__id_txn_id(id),
+                                               path, scratch_pool,
+                                               scratch_pool);
       if (err && APR_STATUS_IS_ENOENT(err->apr_err))
         {
           svn_error_clear(err);
@@ -435,10 +480,7 @@ get_node_revision_body(node_revision_t **noderev_p,
           return svn_error_trace(err);
         }
 
-      SVN_ERR(svn_fs_fs__read_noderev(noderev_p,
-                                      svn_stream_from_aprfile2(file,
-                                                               FALSE,
-                                                               scratch_pool),
+      SVN_ERR(svn_fs_fs__read_noderev(noderev_p, stream,
                                       result_pool, scratch_pool));
     }
   else
@@ -461,7 +503,9 @@ get_node_revision_body(node_revision_t **noderev_p,
                                  &key,
                                  result_pool));
           if (is_cached)
-            return SVN_NO_ERROR;
+            return svn_error_trace(log_access(fs, rev_item->revision, -1, 0,
+                                              SVN_FS_FS__ITEM_TYPE_NODEREV,
+                                              TRUE));
         }
 
       /* read the data from disk */
@@ -483,7 +527,13 @@ get_node_revision_body(node_revision_t **noderev_p,
         }
       else
         {
+          apr_off_t offset;
+
           /* physical addressing mode reading, parsing and caching */
+          SVN_ERR(svn_io_file_get_offset(&offset, revision_file->file,
+                                         scratch_pool));
+          SVN_ERR(log_access(fs, rev_item->revision, offset, 0,
+                             SVN_FS_FS__ITEM_TYPE_NODEREV, FALSE));
           SVN_ERR(svn_fs_fs__read_noderev(noderev_p,
                                           revision_file->stream,
                                           result_pool,
@@ -771,6 +821,67 @@ rs_aligned_seek(rep_state_t *rs,
                                                   pool));
 }
 
+/* Position the data source of RS at OFFSET.  That is the memory mapped
+ * image of the rev file, if available, or the rev file itself otherwise.
+ * Use POOL for temporary allocations. */
+static svn_error_t *
+rs_seek_data(rep_state_t *rs,
+             apr_off_t offset,
+             apr_pool_t *pool)
+{
+  svn_fs_fs__revision_file_t *rfile = rs->sfile->rfile;
+  if (rfile->mmap)
+    return svn_error_trace(svn_fs_fs__rev_file_mmap_seek(rfile, offset));
+
+  return svn_error_trace(rs_aligned_seek(rs, NULL, offset, pool));
+}
+
+/* Set *OFFSET to the current read position within the data source of RS.
+ * Use POOL for temporary allocations. */
+static svn_error_t *
+rs_data_offset(apr_off_t *offset,
+               rep_state_t *rs,
+               apr_pool_t *pool)
+{
+  svn_fs_fs__revision_file_t *rfile = rs->sfile->rfile;
+  if (rfile->mmap)
+    {
+      *offset = rfile->mmap_offset;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(get_file_offset(offset, rs, pool));
+}
+
+/* Return the stream to read data from the data source of RS. */
+static svn_stream_t *
+rs_data_stream(rep_state_t *rs)
+{
+  svn_fs_fs__revision_file_t *rfile = rs->sfile->rfile;
+  return rfile->mmap ? rfile->mmap_stream : rfile->stream;
+}
+
+/* Skip the svndiff window at the current read position within the data
+ * source of RS.  Use POOL for temporary allocations. */
+static svn_error_t *
+rs_skip_window(rep_state_t *rs,
+               apr_pool_t *pool)
+{
+  svn_fs_fs__revision_file_t *rfile = rs->sfile->rfile;
+  if (rfile->mmap)
+    {
+      /* There is no skip function for streams but parsing the window
+       * from memory is cheap enough. */
+      svn_txdelta_window_t *window;
+      return svn_error_trace(
+                svn_txdelta_read_svndiff_window(&window, rfile->mmap_stream,
+                                                rs->ver, pool));
+    }
+
+  return svn_error_trace(svn_txdelta_skip_svndiff_window(rfile->file,
+                                                         rs->ver, pool));
+}
+
 /* Open FILE->FILE and FILE->STREAM if they haven't been opened, yet. */
 static svn_error_t*
 auto_open_shared_file(shared_file_t *file)
@@ -893,6 +1004,8 @@ create_rep_state_body(rep_state_t **rep_state,
   if (ffd->rep_header_cache && !svn_fs_fs__id_txn_used(&rep->txn_id))
     SVN_ERR(svn_cache__get((void **) &rh, &is_cached,
                            ffd->rep_header_cache, &key, result_pool));
+  if (is_cached)
+    SVN_ERR(log_rep_hit(fs, rep, SVN_FS_FS__ITEM_TYPE_ANY_REP));
 
   /* initialize the (shared) FILE member in RS */
   if (reuse_shared_file)
@@ -946,6 +1059,9 @@ create_rep_state_body(rep_state_t **rep_state,
       /* populate the cache if appropriate */
       if (! svn_fs_fs__id_txn_used(&rep->txn_id))
         {
+          SVN_ERR(log_access(fs, rep->revision, rs->start - rh->header_size,
+                             rep->size + rh->header_size,
+                             SVN_FS_FS__ITEM_TYPE_ANY_REP, FALSE));
           if (use_block_read(fs))
             SVN_ERR(block_read(NULL, fs, rep->revision, rep->item_index,
                                rs->sfile->rfile, result_pool, scratch_pool));
@@ -1422,6 +1538,54 @@ set_cached_combined_window(svn_stringbuf_t *window,
   return SVN_NO_ERROR;
 }
 
+/* Tell the OS to fetch the on-disk data of all representations in LIST
+ * that are not in our caches, yet.  Together with SRC_STATE, LIST describes
+ * a delta chain as produced by build_rep_list.  This allows the OS to read
+ * data from multiple rev / pack files in parallel instead of one window
+ * after another.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+prefetch_rep_list(apr_array_header_t *list,
+                  rep_state_t *src_state,
+                  apr_pool_t *scratch_pool)
+{
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  for (i = 0; i <= list->nelts; ++i)
+    {
+      rep_state_t *rs = i < list->nelts
+                      ? APR_ARRAY_IDX(list, i, rep_state_t *)
+                      : src_state;
+
+      svn_pool_clear(iterpool);
+
+      /* Skip txn data and the pseudo state for cached base windows. */
+      if (!rs || !SVN_IS_VALID_REVNUM(rs->revision) || rs->start == 0)
+        continue;
+
+      /* If the first window is cached, the others most likely are, too. */
+      if (rs->window_cache)
+        {
+          svn_boolean_t is_cached;
+          window_cache_key_t key = { 0 };
+
+          SVN_ERR(svn_cache__has_key(&is_cached, rs->window_cache,
+                                     get_window_key(&key, rs), iterpool));
+          if (is_cached)
+            continue;
+        }
+
+      SVN_ERR(auto_open_shared_file(rs->sfile));
+      SVN_ERR(auto_set_start_offset(rs, iterpool));
+      svn_io__file_prefetch(rs->sfile->rfile->file, rs->start, rs->size);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Build an array of rep_state structures in *LIST giving the delta
    reps from first_rep to a plain-text or self-compressed rep.  Set
    *SRC_STATE to the plain-text rep we find at the end of the chain,
@@ -1439,6 +1603,7 @@ build_rep_list(apr_array_header_t **list,
                representation_t *first_rep,
                apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   representation_t rep;
   rep_state_t *rs = NULL;
   svn_fs_fs__rep_header_t *rep_header;
@@ -1501,6 +1666,11 @@ build_rep_list(apr_array_header_t **list,
     }
   svn_pool_destroy(iterpool);
 
+  /* Single reps will be read as soon as the caller asks for them.  For
+   * longer chains, let the OS fetch all reps' data concurrently. */
+  if (ffd->prefetch_delta_chains && (*list)->nelts > 1)
+    SVN_ERR(prefetch_rep_list(*list, *src_state, pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -1595,17 +1765,16 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
   /* RS->FILE may be shared between RS instances -> make sure we point
    * to the right data. */
   start_offset = rs->start + rs->current;
-  SVN_ERR(rs_aligned_seek(rs, NULL, start_offset, scratch_pool));
+  SVN_ERR(rs_seek_data(rs, start_offset, scratch_pool));
 
   /* Skip windows to reach the current chunk if we aren't there yet. */
   iterpool = svn_pool_create(scratch_pool);
   while (rs->chunk_index < this_chunk)
     {
       svn_pool_clear(iterpool);
-      SVN_ERR(svn_txdelta_skip_svndiff_window(rs->sfile->rfile->file,
-                                              rs->ver, iterpool));
+      SVN_ERR(rs_skip_window(rs, iterpool));
       rs->chunk_index++;
-      SVN_ERR(get_file_offset(&start_offset, rs, iterpool));
+      SVN_ERR(rs_data_offset(&start_offset, rs, iterpool));
       rs->current = start_offset - rs->start;
       if (rs->current >= rs->size)
         return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
@@ -1616,9 +1785,9 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
   svn_pool_destroy(iterpool);
 
   /* Actually read the next window. */
-  SVN_ERR(svn_txdelta_read_svndiff_window(nwin, rs->sfile->rfile->stream,
+  SVN_ERR(svn_txdelta_read_svndiff_window(nwin, rs_data_stream(rs),
                                           rs->ver, result_pool));
-  SVN_ERR(get_file_offset(&end_offset, rs, scratch_pool));
+  SVN_ERR(rs_data_offset(&end_offset, rs, scratch_pool));
   rs->current = end_offset - rs->start;
   if (rs->current > rs->size)
     return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
@@ -1647,13 +1816,24 @@ read_plain_window(svn_stringbuf_t **nwin, rep_state_t *rs,
   SVN_ERR(auto_set_start_offset(rs, scratch_pool));
 
   offset = rs->start + rs->current;
-  SVN_ERR(rs_aligned_seek(rs, NULL, offset, scratch_pool));
+  if (rs->sfile->rfile->mmap)
+    {
+      /* Copy the plain data straight from the mapped image. */
+      const char *data;
+      SVN_ERR(svn_fs_fs__rev_file_mmap_data(&data, rs->sfile->rfile,
+                                            offset, size));
+      *nwin = svn_stringbuf_ncreate(data, size, result_pool);
+    }
+  else
+    {
+      SVN_ERR(rs_aligned_seek(rs, NULL, offset, scratch_pool));
 
-  /* Read the plain data. */
-  *nwin = svn_stringbuf_create_ensure(size, result_pool);
-  SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, (*nwin)->data, size,
-                                 NULL, NULL, result_pool));
-  (*nwin)->data[size] = 0;
+      /* Read the plain data. */
+      *nwin = svn_stringbuf_create_ensure(size, result_pool);
+      SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, (*nwin)->data,
+                                     size, NULL, NULL, result_pool));
+      (*nwin)->data[size] = 0;
+    }
 
   /* Update RS. */
   rs->current += (apr_off_t)size;
@@ -2115,9 +2295,14 @@ rep_read_contents(void *baton,
   if (rb->fulltext_cache)
     {
       svn_boolean_t cached;
+      svn_boolean_t first_read = rb->fulltext_delivered == 0;
+
       SVN_ERR(get_contents_from_fulltext(&cached, rb, buf, len));
       if (cached)
-        return SVN_NO_ERROR;
+        return first_read
+             ? svn_error_trace(log_rep_hit(rb->fs, &rb->rep,
+                                           SVN_FS_FS__ITEM_TYPE_FILE_REP))
+             : SVN_NO_ERROR;
 
       /* Cache miss.  From now on, we will never read from the fulltext
        * cache for this representation anymore. */
@@ -2195,6 +2380,8 @@ svn_fs_fs__get_contents(svn_stream_t **contents_p,
                         svn_boolean_t cache_fulltext,
                         apr_pool_t *pool)
 {
+  SVN_FS_FS__COUNT(svn_fs_fs__metric_contents_reads);
+
   if (! rep)
     {
       *contents_p = svn_stream_empty(pool);
@@ -2205,12 +2392,19 @@ svn_fs_fs__get_contents(svn_stream_t **contents_p,
       struct rep_read_baton *rb;
 
       pair_cache_key_t fulltext_cache_key = { 0 };
+      svn_trace__span_t *span;
+
       fulltext_cache_key.revision = rep->revision;
       fulltext_cache_key.second = rep->item_index;
 
+      span = svn_trace__span_begin("fsfs get_contents", pool);
+      svn_trace__span_attr_int(span, "revision", rep->revision);
+      svn_trace__span_attr_int(span, "item", rep->item_index);
+
       /* Initialize the reader baton.  Some members may added lazily
        * while reading from the stream */
       SVN_ERR(rep_read_get_baton(&rb, fs, rep, fulltext_cache_key, pool));
+      svn_trace__span_end(span);
 
       /* Make the stream attempt fulltext cache lookups if the fulltext
        * is cacheable.  If it is not, then also don't try to buffer and
@@ -2396,6 +2590,119 @@ svn_fs_fs__try_process_file_contents(svn_boolean_t *success,
   return SVN_NO_ERROR;
 }
 
+/* If REP in FS is a committed representation of type TYPE, open the rev
+   or pack file containing it in RESULT_POOL and return it in *FILE.  Set
+   *OFFSET and *LENGTH to the location of the rep's data within that file.
+   For svn_fs_fs__rep_delta, BASE must be REP's delta base as well.
+   Otherwise, set *FILE to NULL.
+   Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+try_get_rep_range(apr_file_t **file,
+                  apr_off_t *offset,
+                  svn_filesize_t *length,
+                  svn_fs_t *fs,
+                  representation_t *rep,
+                  svn_fs_fs__rep_type_t type,
+                  representation_t *base,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__rep_header_t *rep_header;
+  apr_off_t rep_offset;
+  const char *file_path;
+  svn_error_t *err;
+
+  *file = NULL;
+
+  /* Only committed reps are stable enough to be sent from disk. */
+  if (!rep || svn_fs_fs__id_txn_used(&rep->txn_id))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(rep->revision, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rep->revision,
+                                           scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__item_offset(&rep_offset, fs, rev_file, rep->revision,
+                                 NULL, rep->item_index, scratch_pool));
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL, rep_offset, scratch_pool));
+  SVN_ERR(svn_fs_fs__read_rep_header(&rep_header, rev_file->stream,
+                                     scratch_pool, scratch_pool));
+
+  /* Any other kind of data must be reconstructed and cannot be sent
+   * as-is. */
+  if (   rep_header->type != type
+      || (   type == svn_fs_fs__rep_delta
+          && (   rep_header->base_revision != base->revision
+              || rep_header->base_item_index != base->item_index)))
+    return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+
+  /* The caller will read from the file directly, i.e. bypassing the APR
+   * buffer, or even hand it to sendfile().  So, open a separate,
+   * unbuffered handle to the same file. */
+  SVN_ERR(svn_io_file_name_get(&file_path, rev_file->file, scratch_pool));
+  err = svn_io_file_open(file, file_path, APR_READ | APR_SENDFILE_ENABLED,
+                         APR_OS_DEFAULT, result_pool);
+
+  /* The revision might just have been packed.  Let the caller fall back to
+   * the standard code path in that case. */
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *file = NULL;
+    }
+  else
+    {
+      SVN_ERR(err);
+      *offset = rep_offset + rep_header->header_size;
+      *length = rep->size;
+    }
+
+  return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+}
+
+svn_error_t *
+svn_fs_fs__try_get_file_range(apr_file_t **file,
+                              apr_off_t *offset,
+                              svn_filesize_t *length,
+                              svn_fs_t *fs,
+                              node_revision_t *noderev,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(try_get_rep_range(file, offset, length, fs,
+                                           noderev->data_rep,
+                                           svn_fs_fs__rep_plain, NULL,
+                                           result_pool, scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__try_get_file_delta_range(apr_file_t **file,
+                                    apr_off_t *offset,
+                                    svn_filesize_t *length,
+                                    svn_fs_t *fs,
+                                    node_revision_t *source,
+                                    node_revision_t *target,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool)
+{
+  /* An empty SOURCE can't be the base of a stored delta. */
+  if (source && !source->data_rep)
+    {
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* Without a SOURCE, we need a self-delta.  Again, a delta against some
+     other base would not do. */
+  return svn_error_trace(try_get_rep_range(file, offset, length, fs,
+                                           target->data_rep,
+                                           source ? svn_fs_fs__rep_delta
+                                                  : svn_fs_fs__rep_self_delta,
+                                           source ? source->data_rep : NULL,
+                                           result_pool, scratch_pool));
+}
+
 
 /* Baton used when reading delta windows. */
 struct delta_read_baton
@@ -2812,6 +3119,67 @@ locate_dir_cache(svn_fs_t *fs,
     }
 }
 
+/* Return the cache object in FS for directories too large for the cache
+ * returned by locate_dir_cache() plus the corresponding *KEY for NODEREV.
+ * If no such cache exists, return NULL.  Allocate *KEY in POOL.
+ */
+static svn_cache__t *
+locate_large_dir_cache(svn_fs_t *fs,
+                       const char **key,
+                       node_revision_t *noderev,
+                       apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  if (!noderev->data_rep || !ffd->large_dir_cache)
+    {
+      *key = NULL;
+      return NULL;
+    }
+
+  /* Use the same keys as the txn dir cache for in-txn data.  Committed
+   * data gets keys that can never match an ID. */
+  if (svn_fs_fs__id_txn_used(&noderev->data_rep->txn_id))
+    *key = svn_fs_fs__id_unparse(noderev->id, pool)->data;
+  else
+    *key = apr_psprintf(pool, "%ld:%" APR_UINT64_T_FMT,
+                        noderev->data_rep->revision,
+                        noderev->data_rep->item_index);
+
+  return ffd->large_dir_cache;
+}
+
+/* Put the contents DIR of directory NODEREV in FS into CACHE under KEY,
+ * as returned by locate_dir_cache().  If it is too large for CACHE, put
+ * it into the large dir cache instead.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+cache_dir_contents(svn_fs_t *fs,
+                   svn_cache__t *cache,
+                   const void *key,
+                   node_revision_t *noderev,
+                   svn_fs_fs__dir_data_t *dir,
+                   apr_pool_t *scratch_pool)
+{
+  svn_cache__t *large_cache;
+  const char *large_key;
+
+  if (!cache)
+    return SVN_NO_ERROR;
+
+  /* Don't even attempt to serialize very large directories into CACHE;
+   * it would cause an unnecessary memory allocation peak.  150 bytes /
+   * entry is about right. */
+  if (svn_cache__is_cachable(cache, 150 * dir->entries->nelts))
+    return svn_error_trace(svn_cache__set(cache, key, dir, scratch_pool));
+
+  large_cache = locate_large_dir_cache(fs, &large_key, noderev,
+                                       scratch_pool);
+  if (large_cache)
+    SVN_ERR(svn_cache__set(large_cache, large_key, dir, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
                             svn_fs_t *fs,
@@ -2826,6 +3194,8 @@ svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
   /* find the cache we may use */
   svn_cache__t *cache = locate_dir_cache(fs, &key, &pair_key, noderev,
                                          scratch_pool);
+
+  SVN_FS_FS__COUNT(svn_fs_fs__metric_dir_reads);
   if (cache)
     {
       svn_boolean_t found;
@@ -2843,7 +3213,33 @@ svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
             {
               /* Still valid. Done. */
               *entries_p = dir->entries;
-              return SVN_NO_ERROR;
+              return svn_error_trace(log_rep_hit(fs, noderev->data_rep,
+                                         SVN_FS_FS__ITEM_TYPE_DIR_REP));
+            }
+        }
+      else
+        {
+          /* Very large directories are kept in a separate cache. */
+          const char *large_key;
+          svn_cache__t *large_cache = locate_large_dir_cache(fs, &large_key,
+                                                             noderev,
+                                                             scratch_pool);
+          if (large_cache)
+            SVN_ERR(svn_cache__get((void **)&dir, &found, large_cache,
+                                   large_key, result_pool));
+
+          if (found)
+            {
+              svn_filesize_t filesize;
+              SVN_ERR(get_txn_dir_info(&filesize, fs, noderev,
+                                       scratch_pool));
+
+              if (filesize == dir->txn_filesize)
+                {
+                  *entries_p = dir->entries;
+                  return svn_error_trace(log_rep_hit(fs, noderev->data_rep,
+                                         SVN_FS_FS__ITEM_TYPE_DIR_REP));
+                }
             }
         }
     }
@@ -2853,13 +3249,181 @@ svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
   SVN_ERR(get_dir_contents(dir, fs, noderev, result_pool, scratch_pool));
   *entries_p = dir->entries;
 
-  /* Update the cache, if we are to use one.
-   *
-   * Don't even attempt to serialize very large directories; it would cause
-   * an unnecessary memory allocation peak.  150 bytes/entry is about right.
-   */
-  if (cache && svn_cache__is_cachable(cache, 150 * dir->entries->nelts))
-    SVN_ERR(svn_cache__set(cache, key, dir, scratch_pool));
+  /* Update the cache, if we are to use one. */
+  SVN_ERR(cache_dir_contents(fs, cache, key, noderev, dir, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* A representation to be read by svn_fs_fs__prefetch_dir_contents or
+ * svn_fs_fs__get_proplists and its location.
+ */
+typedef struct rep_prefetch_t
+{
+  node_revision_t *noderev;
+
+  /* The rep to read, either NODEREV's data or property rep. */
+  representation_t *rep;
+
+  /* Index of NODEREV in the caller's array. */
+  int index;
+
+  /* First revision in the rev / pack file containing the rep. */
+  svn_revnum_t file_rev;
+
+  /* Offset of the rep within that file. */
+  apr_off_t offset;
+} rep_prefetch_t;
+
+/* Order rep_prefetch_t * by revision and item index of their reps.
+ * Implements the qsort() interface. */
+static int
+compare_rep_prefetch_items(const void *a,
+                           const void *b)
+{
+  const representation_t *lhs = (*(const rep_prefetch_t * const *)a)->rep;
+  const representation_t *rhs = (*(const rep_prefetch_t * const *)b)->rep;
+
+  if (lhs->revision != rhs->revision)
+    return lhs->revision < rhs->revision ? -1 : 1;
+
+  if (lhs->item_index != rhs->item_index)
+    return lhs->item_index < rhs->item_index ? -1 : 1;
+
+  return 0;
+}
+
+/* Order rep_prefetch_t * by file and offset within that file.
+ * Implements the qsort() interface. */
+static int
+compare_rep_prefetch_offsets(const void *a,
+                             const void *b)
+{
+  const rep_prefetch_t *lhs = *(const rep_prefetch_t * const *)a;
+  const rep_prefetch_t *rhs = *(const rep_prefetch_t * const *)b;
+
+  if (lhs->file_rev != rhs->file_rev)
+    return lhs->file_rev < rhs->file_rev ? -1 : 1;
+
+  if (lhs->offset != rhs->offset)
+    return lhs->offset < rhs->offset ? -1 : 1;
+
+  return 0;
+}
+
+/* Return a new rep_prefetch_t for REP of NODEREV at INDEX in FS,
+ * allocated in RESULT_POOL. */
+static rep_prefetch_t *
+create_rep_prefetch(svn_fs_t *fs,
+                    node_revision_t *noderev,
+                    representation_t *rep,
+                    int index,
+                    apr_pool_t *result_pool)
+{
+  rep_prefetch_t *item = apr_pcalloc(result_pool, sizeof(*item));
+  item->noderev = noderev;
+  item->rep = rep;
+  item->index = index;
+  item->file_rev = svn_fs_fs__packed_base_rev(fs, rep->revision);
+  item->offset = (apr_off_t)rep->item_index;
+
+  return item;
+}
+
+/* Sort the rep_prefetch_t * in ITEMS of committed reps in FS by their
+ * location on disk.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+sort_rep_prefetch_items(svn_fs_t *fs,
+                        apr_array_header_t *items,
+                        apr_pool_t *scratch_pool)
+{
+  int i;
+
+  /* With physical addressing, this is also the order on disk. */
+  svn_sort__array(items, compare_rep_prefetch_items);
+
+  if (svn_fs_fs__use_log_addressing(fs) && items->nelts > 1)
+    {
+      apr_array_header_t *ids
+        = apr_array_make(scratch_pool, items->nelts,
+                         sizeof(svn_fs_fs__id_part_t));
+      apr_array_header_t *offsets;
+
+      for (i = 0; i < items->nelts; ++i)
+        {
+          rep_prefetch_t *item = APR_ARRAY_IDX(items, i, rep_prefetch_t *);
+          svn_fs_fs__id_part_t *id = apr_array_push(ids);
+
+          id->revision = item->rep->revision;
+          id->number = item->rep->item_index;
+        }
+
+      SVN_ERR(svn_fs_fs__item_offsets(&offsets, fs, NULL, ids,
+                                      scratch_pool, scratch_pool));
+      for (i = 0; i < items->nelts; ++i)
+        APR_ARRAY_IDX(items, i, rep_prefetch_t *)->offset
+          = APR_ARRAY_IDX(offsets, i, apr_off_t);
+
+      svn_sort__array(items, compare_rep_prefetch_offsets);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__prefetch_dir_contents(svn_fs_t *fs,
+                                 const apr_array_header_t *noderevs,
+                                 apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *dirs
+    = apr_array_make(scratch_pool, noderevs->nelts,
+                     sizeof(rep_prefetch_t *));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  /* Select what needs to be read. */
+  for (i = 0; i < noderevs->nelts; ++i)
+    {
+      node_revision_t *noderev
+        = APR_ARRAY_IDX(noderevs, i, node_revision_t *);
+      pair_cache_key_t pair_key = { 0 };
+      const void *key;
+      svn_cache__t *cache;
+
+      if (   noderev->kind != svn_node_dir
+          || noderev->data_rep == NULL
+          || svn_fs_fs__id_txn_used(&noderev->data_rep->txn_id))
+        continue;
+
+      cache = locate_dir_cache(fs, &key, &pair_key, noderev, iterpool);
+      if (cache)
+        {
+          svn_boolean_t found;
+
+          SVN_ERR(svn_cache__has_key(&found, cache, key, iterpool));
+          if (found)
+            continue;
+        }
+
+      APR_ARRAY_PUSH(dirs, rep_prefetch_t *)
+        = create_rep_prefetch(fs, noderev, noderev->data_rep, i,
+                              scratch_pool);
+    }
+
+  SVN_ERR(sort_rep_prefetch_items(fs, dirs, scratch_pool));
+
+  /* Read them in that order.  This puts them into the cache. */
+  for (i = 0; i < dirs->nelts; ++i)
+    {
+      rep_prefetch_t *dir = APR_ARRAY_IDX(dirs, i, rep_prefetch_t *);
+      apr_array_header_t *entries;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, fs, dir->noderev,
+                                          iterpool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
@@ -2905,10 +3469,33 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                      svn_fs_fs__extract_dir_entry,
                                      &baton,
                                      result_pool));
+
+      /* Very large directories are kept in a separate cache.  The lookup
+       * there is a binary search, too, and does not copy the directory. */
+      if (!found)
+        {
+          const char *large_key;
+          svn_cache__t *large_cache = locate_large_dir_cache(fs, &large_key,
+                                                             noderev,
+                                                             scratch_pool);
+          if (large_cache)
+            SVN_ERR(svn_cache__get_partial((void **)dirent,
+                                           &found,
+                                           large_cache,
+                                           large_key,
+                                           svn_fs_fs__extract_dir_entry,
+                                           &baton,
+                                           result_pool));
+        }
     }
 
   /* fetch data from disk if we did not find it in the cache */
-  if (! found || baton.out_of_date)
+  if (found && !baton.out_of_date)
+    {
+      SVN_ERR(log_rep_hit(fs, noderev->data_rep,
+                          SVN_FS_FS__ITEM_TYPE_DIR_REP));
+    }
+  else
     {
       svn_fs_dirent_t *entry;
       svn_fs_dirent_t *entry_copy = NULL;
@@ -2918,13 +3505,9 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
       SVN_ERR(get_dir_contents(&dir, fs, noderev, scratch_pool,
                                scratch_pool));
 
-      /* Update the cache, if we are to use one.
-       *
-       * Don't even attempt to serialize very large directories; it would
-       * cause an unnecessary memory allocation peak.  150 bytes / entry is
-       * about right. */
-      if (cache && svn_cache__is_cachable(cache, 150 * dir.entries->nelts))
-        SVN_ERR(svn_cache__set(cache, key, &dir, scratch_pool));
+      /* Update the cache, if we are to use one. */
+      SVN_ERR(cache_dir_contents(fs, cache, key, noderev, &dir,
+                                 scratch_pool));
 
       /* find desired entry and return a copy in POOL, if found */
       entry = svn_fs_fs__find_dir_entry(dir.entries, name, NULL);
@@ -2958,7 +3541,9 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
         = svn_fs_fs__path_txn_node_props(fs, noderev->id, pool);
       proplist = apr_hash_make(pool);
 
-      SVN_ERR(svn_stream_open_readonly(&stream, filename, pool, pool));
+      SVN_ERR(svn_fs_fs__txn_store_open_readonly(
+                  &stream, fs, svn_fs_fs__id_txn_id(noderev->id), filename,
+                  pool, pool));
       err = svn_hash_read2(proplist, stream, SVN_HASH_TERMINATOR, pool);
       if (err)
         {
@@ -2977,6 +3562,7 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
       fs_fs_data_t *ffd = fs->fsap_data;
       representation_t *rep = noderev->prop_rep;
       pair_cache_key_t key = { 0 };
+      svn_string_t *content;
 
       key.revision = rep->revision;
       key.second = rep->item_index;
@@ -2986,23 +3572,28 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
           SVN_ERR(svn_cache__get((void **) proplist_p, &is_cached,
                                  ffd->properties_cache, &key, pool));
           if (is_cached)
-            return SVN_NO_ERROR;
+            return svn_error_trace(log_rep_hit(fs, rep,
+                                     noderev->kind == svn_node_dir
+                                       ? SVN_FS_FS__ITEM_TYPE_DIR_PROPS
+                                       : SVN_FS_FS__ITEM_TYPE_FILE_PROPS));
         }
 
-      proplist = apr_hash_make(pool);
+      /* Binary property lists get parsed in place, i.e. CONTENT must
+         be allocated in POOL. */
       SVN_ERR(svn_fs_fs__get_contents(&stream, fs, noderev->prop_rep, FALSE,
                                       pool));
-      err = svn_hash_read2(proplist, stream, SVN_HASH_TERMINATOR, pool);
+      SVN_ERR(svn_string_from_stream2(&content, stream,
+                                      (apr_size_t)rep->expanded_size,
+                                      pool));
+      err = svn_fs_fs__parse_proplist(&proplist, content, TRUE, pool);
       if (err)
         {
           svn_string_t *id_str = svn_fs_fs__id_unparse(noderev->id, pool);
 
-          err = svn_error_compose_create(err, svn_stream_close(stream));
           return svn_error_quick_wrapf(err,
                    _("malformed property list for node-revision '%s'"),
                    id_str->data);
         }
-      SVN_ERR(svn_stream_close(stream));
 
       if (ffd->properties_cache && SVN_IS_VALID_REVNUM(rep->revision))
         SVN_ERR(svn_cache__set(ffd->properties_cache, &key, proplist, pool));
@@ -3018,6 +3609,72 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_proplists(apr_array_header_t **proplists_p,
+                         svn_fs_t *fs,
+                         const apr_array_header_t *noderevs,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *proplists
+    = apr_array_make(result_pool, noderevs->nelts, sizeof(apr_hash_t *));
+  apr_array_header_t *reps
+    = apr_array_make(scratch_pool, noderevs->nelts,
+                     sizeof(rep_prefetch_t *));
+  int i;
+
+  /* Property lists in txns or in the cache are cheap to get.  Collect
+   * all others. */
+  for (i = 0; i < noderevs->nelts; ++i)
+    {
+      node_revision_t *noderev
+        = APR_ARRAY_IDX(noderevs, i, node_revision_t *);
+      apr_hash_t *proplist = NULL;
+
+      if (   noderev->prop_rep == NULL
+          || svn_fs_fs__id_txn_used(&noderev->prop_rep->txn_id))
+        {
+          SVN_ERR(svn_fs_fs__get_proplist(&proplist, fs, noderev,
+                                          result_pool));
+        }
+      else
+        {
+          fs_fs_data_t *ffd = fs->fsap_data;
+          pair_cache_key_t key = { 0 };
+          svn_boolean_t is_cached = FALSE;
+
+          key.revision = noderev->prop_rep->revision;
+          key.second = noderev->prop_rep->item_index;
+          if (ffd->properties_cache)
+            SVN_ERR(svn_cache__get((void **) &proplist, &is_cached,
+                                   ffd->properties_cache, &key,
+                                   result_pool));
+
+          if (!is_cached)
+            APR_ARRAY_PUSH(reps, rep_prefetch_t *)
+              = create_rep_prefetch(fs, noderev, noderev->prop_rep, i,
+                                    scratch_pool);
+        }
+
+      APR_ARRAY_PUSH(proplists, apr_hash_t *) = proplist;
+    }
+
+  /* Read the remaining ones in the order they are stored on disk. */
+  SVN_ERR(sort_rep_prefetch_items(fs, reps, scratch_pool));
+  for (i = 0; i < reps->nelts; ++i)
+    {
+      rep_prefetch_t *rep = APR_ARRAY_IDX(reps, i, rep_prefetch_t *);
+
+      SVN_ERR(svn_fs_fs__get_proplist(&APR_ARRAY_IDX(proplists, rep->index,
+                                                     apr_hash_t *),
+                                      fs, rep->noderev, result_pool));
+    }
+
+  *proplists_p = proplists;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__create_changes_context(svn_fs_fs__changes_context_t **context,
                                   svn_fs_t *fs,
@@ -3061,6 +3718,10 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
       found = FALSE;
     }
 
+  if (found)
+    SVN_ERR(log_access(context->fs, context->revision, -1, 0,
+                       SVN_FS_FS__ITEM_TYPE_CHANGES, TRUE));
+
   if (!found)
     {
       /* read changes from revision file */
@@ -3136,6 +3797,11 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
                                          scratch_pool));
           changes_list->end_offset -= changes_offset;
           changes_list->start_offset = context->next_offset;
+          SVN_ERR(log_access(context->fs, context->revision,
+                             changes_offset + context->next_offset,
+                             changes_list->end_offset
+                               - changes_list->start_offset,
+                             SVN_FS_FS__ITEM_TYPE_CHANGES, FALSE));
           changes_list->count = (*changes)->nelts;
           changes_list->changes = (change_t **)(*changes)->elts;
           changes_list->eol = changes_list->count < SVN_FS_FS__CHANGES_BLOCK_SIZE;
@@ -3485,12 +4151,25 @@ read_item(svn_stream_t **stream,
   svn_checksum_t *expected, *actual;
   apr_uint32_t plain_digest;
 
+  svn_stringbuf_t *text;
+
   /* Read item into string buffer. */
-  svn_stringbuf_t *text = svn_stringbuf_create_ensure(entry->size, pool);
-  text->len = entry->size;
-  text->data[text->len] = 0;
-  SVN_ERR(svn_io_file_read_full2(rev_file->file, text->data, text->len,
-                                 NULL, NULL, pool));
+  if (rev_file->mmap)
+    {
+      /* Copy straight from the mapped image; no seek / read syscalls. */
+      const char *data;
+      SVN_ERR(svn_fs_fs__rev_file_mmap_data(&data, rev_file, entry->offset,
+                                            (apr_size_t)entry->size));
+      text = svn_stringbuf_ncreate(data, (apr_size_t)entry->size, pool);
+    }
+  else
+    {
+      text = svn_stringbuf_create_ensure(entry->size, pool);
+      text->len = entry->size;
+      text->data[text->len] = 0;
+      SVN_ERR(svn_io_file_read_full2(rev_file->file, text->data, text->len,
+                                     NULL, NULL, pool));
+    }
 
   /* Return (construct, calculate) stream and checksum. */
   *stream = svn_stream_from_stringbuf(text, pool);
@@ -3657,12 +4336,17 @@ block_read(void **result,
   int run_count = 0;
   int i;
   apr_pool_t *iterpool;
+  svn_trace__span_t *span;
 
   /* Block read is an optional feature. If the caller does not want anything
    * specific we may not have to read anything. */
   if (!result)
     return SVN_NO_ERROR;
 
+  span = svn_trace__span_begin("fsfs block_read", scratch_pool);
+  svn_trace__span_attr_int(span, "revision", revision);
+  svn_trace__span_attr_int(span, "item", item_index);
+
   iterpool = svn_pool_create(scratch_pool);
 
   /* don't try this on transaction protorev files */
@@ -3675,6 +4359,14 @@ block_read(void **result,
 
   offset = wanted_offset;
 
+  /* Let the OS fetch the block(s) that we are going to read while we are
+   * busy with the P2L index lookup.  The heuristics below may continue
+   * into the next block, so include that one as well. */
+  if (ffd->prefetch_block_reads)
+    svn_io__file_prefetch(revision_file->file,
+                          offset - (offset % ffd->block_size),
+                          2 * ffd->block_size);
+
   /* Heuristics:
    *
    * Read this block.  If the last item crosses the block boundary, read
@@ -3695,6 +4387,9 @@ block_read(void **result,
       SVN_ERR(aligned_seek(fs, revision_file->file, &block_start, offset,
                            iterpool));
 
+      /* Dump, verify etc. scan whole files.  Let the OS read ahead. */
+      svn_fs_fs__rev_file_read_ahead(revision_file, block_start);
+
       /* read all items from the block */
       for (i = 0; i < entries->nelts; ++i)
         {
@@ -3727,6 +4422,8 @@ block_read(void **result,
               void *item = NULL;
               SVN_ERR(svn_io_file_seek(revision_file->file, APR_SET,
                                        &entry->offset, iterpool));
+              SVN_ERR(log_access(fs, entry->item.revision, entry->offset,
+                                 entry->size, entry->type, FALSE));
               switch (entry->type)
                 {
                   case SVN_FS_FS__ITEM_TYPE_FILE_REP:
@@ -3775,6 +4472,7 @@ block_read(void **result,
   /* if the caller requested a result, we must have provided one by now */
   assert(!result || *result);
   svn_pool_destroy(iterpool);
+  svn_trace__span_end(span);
 
   return SVN_NO_ERROR;
 }
@@ -119,6 +119,40 @@ svn_fs_fs__try_process_file_contents(svn_boolean_t *success,
                                      void* baton,
                                      apr_pool_t *pool);
 
+/* If the text representation of node-revision NODEREV in filesystem FS is
+   stored as a PLAIN rep in a committed revision, open the rev or pack file
+   containing it in RESULT_POOL and return it in *FILE.  Set *OFFSET and
+   *LENGTH to the location of the fulltext within that file.  Otherwise,
+   set *FILE to NULL.
+   Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__try_get_file_range(apr_file_t **file,
+                              apr_off_t *offset,
+                              svn_filesize_t *length,
+                              svn_fs_t *fs,
+                              node_revision_t *noderev,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+/* If the text representation of node-revision TARGET in filesystem FS is
+   stored in a committed revision as a delta against the text of SOURCE,
+   open the rev or pack file containing it in RESULT_POOL and return it in
+   *FILE.  Set *OFFSET and *LENGTH to the location of the svndiff data
+   within that file.  If SOURCE is NULL, look for a self-delta instead.
+   Otherwise, set *FILE to NULL.
+   Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__try_get_file_delta_range(apr_file_t **file,
+                                    apr_off_t *offset,
+                                    svn_filesize_t *length,
+                                    svn_fs_t *fs,
+                                    node_revision_t *source,
+                                    node_revision_t *target,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool);
+
 /* Set *STREAM_P to a delta stream turning the contents of the file SOURCE into
    the contents of the file TARGET, allocated in POOL.
    If SOURCE is null, the empty string will be used. */
@@ -140,6 +174,16 @@ svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
                             apr_pool_t *result_pool,
                             apr_pool_t *scratch_pool);
 
+/* Read the directory contents of all NODEREVS (node_revision_t *) in FS
+   into the directory cache, unless they are cached already.  The
+   contents are read in the order of their location on disk.  Noderevs
+   that aren't committed directories are ignored.  SCRATCH_POOL is used
+   for temporary allocations. */
+svn_error_t *
+svn_fs_fs__prefetch_dir_contents(svn_fs_t *fs,
+                                 const apr_array_header_t *noderevs,
+                                 apr_pool_t *scratch_pool);
+
 /* Return the directory entry from ENTRIES that matches NAME.  If no such
    entry exists, return NULL.  If HINT is not NULL, set *HINT to the array
    index of the entry returned.  Successive calls in a linear scan scenario
@@ -170,6 +214,18 @@ svn_fs_fs__get_proplist(apr_hash_t **proplist,
                         node_revision_t *noderev,
                         apr_pool_t *pool);
 
+/* Set *PROPLISTS_P to an array containing the property list (apr_hash_t *)
+   of each node-revision in NODEREVS (node_revision_t *) in FS, in the same
+   order.  Property lists that are neither cached nor in a transaction get
+   read in the order of their location on disk.  Allocate the result in
+   RESULT_POOL; use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__get_proplists(apr_array_header_t **proplists_p,
+                         svn_fs_t *fs,
+                         const apr_array_header_t *noderevs,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
 /* Create a changes retrieval context object in *RESULT_POOL and return it
  * in *CONTEXT.  It will allow svn_fs_x__get_changes to fetch consecutive
  * blocks (one per invocation) from REV's changed paths list in FS. */
@@ -33,7 +33,9 @@
 #include "svn_cache_config.h"
 
 #include "svn_private_config.h"
+#include "svn_dirent_uri.h"
 #include "svn_hash.h"
+#include "svn_io.h"
 #include "svn_pools.h"
 
 #include "private/svn_debug.h"
@@ -66,6 +68,36 @@ normalize_key_part(const char *original,
   return normalized->data;
 }
 
+/* Set *STAMP to a string that identifies this instance of the repository
+   FS.  A copy restored from some backup or re-created at the same location
+   will get a different stamp.  Since cached data may outlive the process,
+   e.g. in a disk cache, it must not be shared between such instances.
+
+   Formats without an instance ID use the time the UUID file of FS has been
+   written.  Allocate *STAMP in POOL. */
+static svn_error_t *
+get_instance_stamp(const char **stamp,
+                   svn_fs_t *fs,
+                   apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_time_t uuid_time;
+
+  if (ffd->format >= SVN_FS_FS__MIN_INSTANCE_ID_FORMAT)
+    {
+      *stamp = ffd->instance_id;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_io_file_affected_time(&uuid_time,
+                                    svn_dirent_join(fs->path, PATH_UUID,
+                                                    pool),
+                                    pool));
+  *stamp = apr_psprintf(pool, "%" APR_TIME_T_FMT, uuid_time);
+
+  return SVN_NO_ERROR;
+}
+
 /* *CACHE_TXDELTAS, *CACHE_FULLTEXTS, *CACHE_NODEPROPS flags will be set
    according to FS->CONFIG. *CACHE_NAMESPACE receives the cache prefix to
    use.
@@ -278,10 +310,12 @@ init_callbacks(svn_cache__t *cache,
 
 /* Sets *CACHE_P to cache instance based on provided options.
  * Creates memcache if MEMCACHE is not NULL. Creates membuffer cache if
- * MEMBUFFER is not NULL. Fallbacks to inprocess cache if MEMCACHE and
- * MEMBUFFER are NULL and pages is non-zero.  Sets *CACHE_P to NULL
- * otherwise.  Use the given PRIORITY class for the new cache.  If it
- * is 0, then use the default priority class.  HAS_NAMESPACE indicates
+ * MEMBUFFER is not NULL.  If both are given, the membuffer cache acts as
+ * a near cache in front of memcache.  Fallbacks to inprocess cache if
+ * MEMCACHE and MEMBUFFER are NULL and pages is non-zero.  Sets *CACHE_P
+ * to NULL otherwise.  Use the given PRIORITY class for the new cache.  If
+ * it is 0, then use the default priority class.  In either case, weigh it
+ * with the repository's cache priority.  HAS_NAMESPACE indicates
  * whether we prefixed this cache instance with a namespace.
  *
  * Unless NO_HANDLER is true, register an error handler that reports errors
@@ -306,13 +340,43 @@ create_cache(svn_cache__t **cache_p,
              apr_pool_t *result_pool,
              apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   svn_cache__error_handler_t error_handler = no_handler
                                            ? NULL
                                            : warn_and_fail_on_cache_errors;
   if (priority == 0)
     priority = SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY;
 
-  if (memcache)
+  /* Apply the repository's weight relative to other repositories sharing
+   * the same membuffer. */
+  priority = (apr_uint32_t)(priority * ffd->cache_priority / 100);
+
+  if (memcache && membuffer)
+    {
+      svn_cache__t *near_cache, *far_cache;
+
+      /* Serve hot items from the membuffer and only go to memcached for
+       * the misses.  Memcached failures are never fatal. */
+      SVN_ERR(svn_cache__create_membuffer_cache(
+                &near_cache, membuffer, serializer, deserializer,
+                klen, prefix, priority, FALSE, has_namespace,
+                result_pool, scratch_pool));
+      SVN_ERR(init_callbacks(near_cache, fs, error_handler, result_pool));
+
+      SVN_ERR(svn_cache__create_memcache(&far_cache, memcache,
+                                         serializer, deserializer, klen,
+                                         prefix, result_pool));
+      SVN_ERR(init_callbacks(far_cache, fs,
+                             no_handler
+                               ? NULL
+                               : warn_and_continue_on_cache_errors,
+                             result_pool));
+
+      SVN_ERR(svn_cache__create_tiered(cache_p, near_cache, far_cache,
+                                       result_pool));
+      error_handler = NULL;
+    }
+  else if (memcache)
     {
       SVN_ERR(svn_cache__create_memcache(cache_p, memcache,
                                          serializer, deserializer, klen,
@@ -351,11 +415,8 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                              apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  const char *prefix = apr_pstrcat(pool,
-                                   "fsfs:", fs->uuid,
-                                   "/", normalize_key_part(fs->path, pool),
-                                   ":",
-                                   SVN_VA_NULL);
+  const char *prefix;
+  const char *stamp;
   svn_membuffer_t *membuffer;
   svn_boolean_t no_handler = ffd->fail_stop;
   svn_boolean_t cache_txdeltas;
@@ -364,6 +425,15 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   const char *cache_namespace;
   svn_boolean_t has_namespace;
 
+  /* Keys must identify the repository instance, not just its location. */
+  SVN_ERR(get_instance_stamp(&stamp, fs, pool));
+  prefix = apr_pstrcat(pool,
+                       "fsfs:", fs->uuid,
+                       "/", normalize_key_part(fs->path, pool),
+                       ":", stamp,
+                       ":",
+                       SVN_VA_NULL);
+
   /* Evaluating the cache configuration. */
   SVN_ERR(read_config(&cache_namespace,
                       &cache_txdeltas,
@@ -453,6 +523,25 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        no_handler,
                        fs->pool, pool));
 
+  /* Directories with tens of thousands of entries exceed the size limit
+   * of DIR_CACHE.  Keep the few most recently used of them in a local
+   * cache, so that lookups in them don't need to re-read and sort all
+   * entries each time.  Leave some room for in-place updates of in-txn
+   * directories. */
+  SVN_ERR(create_cache(&(ffd->large_dir_cache),
+                       NULL,
+                       NULL,
+                       4, 1,
+                       svn_fs_fs__serialize_txndir_entries,
+                       svn_fs_fs__deserialize_dir_entries,
+                       APR_HASH_KEY_STRING,
+                       apr_pstrcat(pool, prefix, "LDIR", SVN_VA_NULL),
+                       0,
+                       has_namespace,
+                       fs,
+                       no_handler,
+                       fs->pool, pool));
+
   /* 8 kBytes per entry (1000 revs / shared, one file offset per rev).
      Covering about 8 pack files gives us an "o.k." hit rate. */
   SVN_ERR(create_cache(&(ffd->packed_offset_cache),
@@ -515,15 +604,38 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        no_handler,
                        fs->pool, pool));
 
-  /* if enabled, cache revprops */
-  SVN_ERR(create_cache(&(ffd->revprop_cache),
+  /* initialize node history chunk cache, if caching has been enabled */
+  SVN_ERR(create_cache(&(ffd->history_cache),
                        NULL,
                        membuffer,
+                       0, 0, /* Do not use the inprocess cache */
+                       /* Values are svn_stringbuf_t */
+                       NULL, NULL,
+                       sizeof(pair_cache_key_t),
+                       apr_pstrcat(pool, prefix, "HISTORY", SVN_VA_NULL),
+                       0,
+                       has_namespace,
+                       fs,
+                       no_handler,
+                       fs->pool, pool));
+
+  /* if enabled, cache revprops.  The keys contain the on-disk revprop
+     generation, so memcached may share them between processes.  Mirrors
+     and copies of a repository may have the same UUID and path, and
+     restart at generation 0.  Hence, share revprops only between users
+     of the same repository instance, and not at all for formats without
+     an instance ID.  The prefix changed with the cached encoding. */
+  SVN_ERR(create_cache(&(ffd->revprop_cache),
+                       ffd->format >= SVN_FS_FS__MIN_INSTANCE_ID_FORMAT
+                         ? ffd->memcache
+                         : NULL,
+                       membuffer,
                        8, 20, /* ~400 bytes / entry, capa for ~2 packs */
                        svn_fs_fs__serialize_revprops,
                        svn_fs_fs__deserialize_revprops,
                        sizeof(pair_cache_key_t),
-                       apr_pstrcat(pool, prefix, "REVPROP", SVN_VA_NULL),
+                       apr_pstrcat(pool, prefix, "REVPROP2:",
+                                   ffd->instance_id, SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
                        TRUE, /* contents is short-lived */
                        fs,
@@ -576,12 +688,28 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            fs,
                            no_handler,
                            fs->pool, pool));
+
+      SVN_ERR(create_cache(&(ffd->explicit_mergeinfo_cache),
+                           NULL,
+                           membuffer,
+                           0, 0, /* Do not use the inprocess cache */
+                           svn_fs_fs__serialize_mergeinfo,
+                           svn_fs_fs__deserialize_mergeinfo,
+                           sizeof(pair_cache_key_t),
+                           apr_pstrcat(pool, prefix, "EXPLICIT_MERGEINFO",
+                                       SVN_VA_NULL),
+                           0,
+                           has_namespace,
+                           fs,
+                           no_handler,
+                           fs->pool, pool));
     }
   else
     {
       ffd->fulltext_cache = NULL;
       ffd->mergeinfo_cache = NULL;
       ffd->mergeinfo_existence_cache = NULL;
+      ffd->explicit_mergeinfo_cache = NULL;
     }
 
   /* if enabled, cache node properties */
@@ -727,6 +855,29 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__clone_fs(svn_fs_t **clone,
+                    svn_fs_t *fs,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *new_fs = apr_pmemdup(pool, fs, sizeof(*fs));
+  fs_fs_data_t *ffd = apr_pmemdup(pool, fs->fsap_data, sizeof(*ffd));
+
+  /* Only the caches refer to data that cannot be shared.  We don't
+   * need the rep-cache nor the locks in the clone. */
+  ffd->rep_cache_db = NULL;
+  ffd->rep_cache_db_opened = 0;
+  ffd->has_write_lock = FALSE;
+  ffd->txn_dir_cache = NULL;
+
+  new_fs->pool = pool;
+  new_fs->fsap_data = ffd;
+  SVN_ERR(svn_fs_fs__initialize_caches(new_fs, pool));
+
+  *clone = new_fs;
+  return SVN_NO_ERROR;
+}
+
 /* Baton to be used for the remove_txn_cache() pool cleanup function, */
 struct txn_cleanup_baton_t
 {
@@ -0,0 +1,91 @@
+/* changed-paths-db.sql -- schema for the changed-paths index
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+-- STMT_CREATE_SCHEMA
+/* All revisions that changed PATH or anything below it.  The root path
+   is not recorded as every revision touches it. */
+CREATE TABLE path_revs (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  PRIMARY KEY (path, revision)
+  );
+
+/* Revisions in which PATH got added, deleted or replaced.  History
+   beyond such a change cannot be followed by path alone. */
+CREATE TABLE structural_changes (
+  path TEXT NOT NULL,
+  revision INTEGER NOT NULL,
+  PRIMARY KEY (path, revision)
+  );
+
+/* The contiguous range of revisions covered by the tables above.
+   Holds at most one row. */
+CREATE TABLE indexed_range (
+  first_revision INTEGER NOT NULL,
+  last_revision INTEGER NOT NULL
+  );
+
+PRAGMA USER_VERSION = 1;
+
+
+-- STMT_GET_INDEXED_RANGE
+SELECT first_revision, last_revision
+FROM indexed_range
+
+-- STMT_INSERT_INDEXED_RANGE
+INSERT INTO indexed_range (first_revision, last_revision)
+VALUES (?1, ?2)
+
+-- STMT_SET_INDEXED_RANGE
+UPDATE indexed_range
+SET first_revision = ?1, last_revision = ?2
+
+-- STMT_ADD_PATH_REV
+INSERT OR IGNORE INTO path_revs (path, revision)
+VALUES (?1, ?2)
+
+-- STMT_ADD_STRUCTURAL_CHANGE
+INSERT OR IGNORE INTO structural_changes (path, revision)
+VALUES (?1, ?2)
+
+-- STMT_GET_PREV_PATH_REV
+SELECT revision
+FROM path_revs
+WHERE path = ?1 AND revision < ?2
+ORDER BY revision DESC
+LIMIT 1
+
+-- STMT_GET_PREV_STRUCTURAL_CHANGE
+SELECT revision
+FROM structural_changes
+WHERE path = ?1 AND revision < ?2
+ORDER BY revision DESC
+LIMIT 1
+
+-- STMT_GET_NEXT_STRUCTURAL_CHANGE
+SELECT revision
+FROM structural_changes
+WHERE path = ?1 AND revision > ?2
+ORDER BY revision ASC
+LIMIT 1
@@ -0,0 +1,483 @@
+/* changed-paths-index.c --- index of the revisions that touched a path
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+
+#include "svn_private_config.h"
+
+#include "fs_fs.h"
+#include "fs.h"
+#include "transaction.h"
+#include "changed-paths-index.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_fs_util.h"
+#include "private/svn_sqlite.h"
+
+#include "changed-paths-db.h"
+
+/* A few magic values */
+#define CHANGED_PATHS_SCHEMA_FORMAT   1
+
+/* Maximum number of revisions other than the one just committed that a
+   single commit adds to the index.  This bounds the extra time a commit
+   may spend catching up on older revisions. */
+#define MAX_CATCH_UP_REVISIONS        100
+
+CHANGED_PATHS_DB_SQL_DECLARE_STATEMENTS(statements);
+
+
+
+/** Helper functions. **/
+static APR_INLINE const char *
+path_changed_paths_db(const char *fs_path,
+                      apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs_path, CHANGED_PATHS_DB_NAME, result_pool);
+}
+
+/* Body of svn_fs_fs__open_changed_paths_index().
+   Implements svn_atomic__init_once().init_func.
+ */
+static svn_error_t *
+open_changed_paths_db(void *baton,
+                      apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  const char *db_path;
+  int version;
+
+  db_path = path_changed_paths_db(fs->path, pool);
+#ifndef WIN32
+  {
+    /* We want to extend the permissions that apply to the repository
+       as a whole when creating a new index and not simply default
+       to umask. */
+    svn_node_kind_t kind;
+
+    SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+    if (kind == svn_node_none)
+      {
+        const char *current = svn_fs_fs__path_current(fs, pool);
+        svn_error_t *err = svn_io_file_create_empty(db_path, pool);
+
+        if (err && !APR_STATUS_IS_EEXIST(err->apr_err))
+          /* A real error. */
+          return svn_error_trace(err);
+        else if (err)
+          /* Some other thread/process created the file. */
+          svn_error_clear(err);
+        else
+          /* We created the file. */
+          SVN_ERR(svn_io_copy_perms(current, db_path, pool));
+      }
+  }
+#endif
+  SVN_ERR(svn_sqlite__open(&sdb, db_path,
+                           svn_sqlite__mode_rwcreate, statements,
+                           0, NULL, 0,
+                           fs->pool, pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb, pool),
+                        sdb);
+  if (version < CHANGED_PATHS_SCHEMA_FORMAT)
+    {
+      /* Must be 0 -- an uninitialized (no schema) database. Create
+         the schema. Results in schema version of 1.  */
+      SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb,
+                                                        STMT_CREATE_SCHEMA),
+                            sdb);
+    }
+
+  /* This is used as a flag that the database is available so don't
+     set it earlier. */
+  ffd->changed_paths_db = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__open_changed_paths_index(svn_fs_t *fs,
+                                    apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err = svn_atomic__init_once(&ffd->changed_paths_db_opened,
+                                           open_changed_paths_db, fs, pool);
+  return svn_error_quick_wrapf(err,
+                               _("Couldn't open changed-paths index '%s'"),
+                               svn_dirent_local_style(
+                                 path_changed_paths_db(fs->path, pool),
+                                 pool));
+}
+
+svn_error_t *
+svn_fs_fs__close_changed_paths_index(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (ffd->changed_paths_db)
+    {
+      svn_sqlite__db_t *sdb = ffd->changed_paths_db;
+
+      ffd->changed_paths_db = NULL;
+      ffd->changed_paths_db_opened = 0;
+      SVN_ERR(svn_sqlite__close(sdb));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__remove_changed_paths_index(svn_fs_t *fs,
+                                      apr_pool_t *pool)
+{
+  SVN_ERR(svn_fs_fs__close_changed_paths_index(fs));
+  SVN_ERR(svn_io_remove_file2(path_changed_paths_db(fs->path, pool), TRUE,
+                              pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the range of revisions covered by the index in SDB into *FIRST
+   and *LAST.  Set *HAVE_RANGE to FALSE if the index is still empty. */
+static svn_error_t *
+get_indexed_range(svn_boolean_t *have_range,
+                  svn_revnum_t *first,
+                  svn_revnum_t *last,
+                  svn_sqlite__db_t *sdb)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_INDEXED_RANGE));
+  SVN_ERR(svn_sqlite__step(have_range, stmt));
+  if (*have_range)
+    {
+      *first = svn_sqlite__column_revnum(stmt, 0);
+      *last = svn_sqlite__column_revnum(stmt, 1);
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Execute the insertion statement STMT_IDX in SDB for PATH and REVISION. */
+static svn_error_t *
+add_row(svn_sqlite__db_t *sdb,
+        int stmt_idx,
+        const char *path,
+        svn_revnum_t revision)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, stmt_idx));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", path, revision));
+
+  return svn_error_trace(svn_sqlite__insert(NULL, stmt));
+}
+
+/* Add the changed paths of revision REV in FS to the index in SDB.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+index_revision(svn_fs_t *fs,
+               svn_sqlite__db_t *sdb,
+               svn_revnum_t rev,
+               apr_pool_t *scratch_pool)
+{
+  apr_hash_t *changes;
+  apr_hash_t *parents = apr_hash_make(scratch_pool);
+  apr_hash_index_t *hi;
+
+  SVN_ERR(svn_fs_fs__paths_changed(&changes, fs, rev, scratch_pool));
+  for (hi = apr_hash_first(scratch_pool, changes); hi; hi = apr_hash_next(hi))
+    {
+      const char *path = apr_hash_this_key(hi);
+      svn_fs_path_change2_t *change = apr_hash_this_val(hi);
+
+      /* Every revision touches the root.  There is no point in listing
+         them all. */
+      if (svn_fspath__is_root(path, strlen(path)))
+        continue;
+
+      SVN_ERR(add_row(sdb, STMT_ADD_PATH_REV, path, rev));
+      if (   change->change_kind == svn_fs_path_change_add
+          || change->change_kind == svn_fs_path_change_delete
+          || change->change_kind == svn_fs_path_change_replace)
+        SVN_ERR(add_row(sdb, STMT_ADD_STRUCTURAL_CHANGE, path, rev));
+
+      /* The parents got modified as well. */
+      for (path = svn_fspath__dirname(path, scratch_pool);
+           !svn_fspath__is_root(path, strlen(path))
+             && !svn_hash_gets(parents, path);
+           path = svn_fspath__dirname(path, scratch_pool))
+        {
+          svn_hash_sets(parents, path, path);
+          SVN_ERR(add_row(sdb, STMT_ADD_PATH_REV, path, rev));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Body of svn_fs_fs__update_changed_paths_index() to be run within an
+   SQLite transaction on SDB. */
+static svn_error_t *
+update_index(svn_fs_t *fs,
+             svn_sqlite__db_t *sdb,
+             svn_revnum_t new_rev,
+             apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_range;
+  svn_revnum_t first, last;
+  int budget = MAX_CATCH_UP_REVISIONS;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(get_indexed_range(&have_range, &first, &last, sdb));
+  if (! have_range)
+    {
+      /* Start with an empty range right before NEW_REV. */
+      first = new_rev;
+      last = new_rev - 1;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                        STMT_INSERT_INDEXED_RANGE));
+      SVN_ERR(svn_sqlite__bindf(stmt, "rr", first, last));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+
+  /* Revisions committed while the index was disabled or whose commits
+     failed to update it must come first to keep the range contiguous.
+     If there are too many of them, NEW_REV will be added by a later
+     commit. */
+  while (last < new_rev && (last + 1 == new_rev || budget > 0))
+    {
+      svn_pool_clear(iterpool);
+      if (last + 1 < new_rev)
+        --budget;
+
+      SVN_ERR(index_revision(fs, sdb, last + 1, iterpool));
+      ++last;
+    }
+
+  /* Spend what is left on revisions from before the index got enabled. */
+  while (first > 0 && budget > 0)
+    {
+      svn_pool_clear(iterpool);
+      --budget;
+
+      SVN_ERR(index_revision(fs, sdb, first - 1, iterpool));
+      --first;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_INDEXED_RANGE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "rr", first, last));
+
+  return svn_error_trace(svn_sqlite__update(NULL, stmt));
+}
+
+svn_error_t *
+svn_fs_fs__update_changed_paths_index(svn_fs_t *fs,
+                                      svn_revnum_t new_rev,
+                                      apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+
+  if (! ffd->changed_paths_db)
+    SVN_ERR(svn_fs_fs__open_changed_paths_index(fs, pool));
+
+  /* Take the write lock right away.  Concurrent commits would otherwise
+     fail to upgrade their read locks after reading the indexed range. */
+  sdb = ffd->changed_paths_db;
+  SVN_ERR(svn_sqlite__begin_immediate_transaction(sdb));
+  SVN_ERR(svn_sqlite__finish_transaction(sdb,
+                                         update_index(fs, sdb, new_rev,
+                                                      pool)));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *REVISION to the revision that the query STMT_IDX in SDB returns
+   for PATH and the revision bound BOUND, i.e. the closest revision before
+   or after BOUND recorded for PATH.  Set it to SVN_INVALID_REVNUM if there
+   is no such revision. */
+static svn_error_t *
+get_row_revision(svn_revnum_t *revision,
+                 svn_sqlite__db_t *sdb,
+                 int stmt_idx,
+                 const char *path,
+                 svn_revnum_t bound)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, stmt_idx));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", path, bound));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *revision = have_row ? svn_sqlite__column_revnum(stmt, 0)
+                       : SVN_INVALID_REVNUM;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Set *SDB to the changed-paths index database of FS, opening it if
+   necessary.  Set it to NULL if the index is disabled or does not exist.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_existing_index(svn_sqlite__db_t **sdb,
+                   svn_fs_t *fs,
+                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  *sdb = NULL;
+  if (! ffd->changed_paths_index)
+    return SVN_NO_ERROR;
+
+  /* Don't create the index just for reading it. */
+  if (! ffd->changed_paths_db)
+    {
+      svn_node_kind_t kind;
+
+      SVN_ERR(svn_io_check_path(path_changed_paths_db(fs->path,
+                                                      scratch_pool),
+                                &kind, scratch_pool));
+      if (kind != svn_node_file)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(svn_fs_fs__open_changed_paths_index(fs, scratch_pool));
+    }
+
+  *sdb = ffd->changed_paths_db;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__changed_paths_prev(svn_revnum_t *revision,
+                              svn_boolean_t *structural,
+                              svn_fs_t *fs,
+                              const char *path,
+                              svn_revnum_t before,
+                              apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_boolean_t have_range;
+  svn_revnum_t first, last, changed;
+
+  *revision = SVN_INVALID_REVNUM;
+  *structural = FALSE;
+
+  path = svn_fs__canonicalize_abspath(path, scratch_pool);
+  if (svn_fspath__is_root(path, strlen(path)))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_existing_index(&sdb, fs, scratch_pool));
+  if (! sdb)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_indexed_range(&have_range, &first, &last, sdb));
+  if (! have_range || before - 1 > last)
+    return SVN_NO_ERROR;
+
+  /* Without a matching row, the answer lies before the indexed range. */
+  SVN_ERR(get_row_revision(&changed, sdb, STMT_GET_PREV_PATH_REV, path,
+                           before));
+  if (! SVN_IS_VALID_REVNUM(changed) || changed < first)
+    return SVN_NO_ERROR;
+
+  /* PATH may have been a different node in CHANGED if it or any of its
+     parents got added, deleted or replaced since then. */
+  for (; !svn_fspath__is_root(path, strlen(path));
+       path = svn_fspath__dirname(path, scratch_pool))
+    {
+      svn_revnum_t structural_change;
+
+      SVN_ERR(get_row_revision(&structural_change, sdb,
+                               STMT_GET_PREV_STRUCTURAL_CHANGE, path,
+                               before));
+      if (SVN_IS_VALID_REVNUM(structural_change)
+          && structural_change >= changed)
+        {
+          *structural = TRUE;
+          break;
+        }
+    }
+
+  *revision = changed;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__changed_paths_next_structural(svn_revnum_t *revision,
+                                         svn_boolean_t *indexed,
+                                         svn_fs_t *fs,
+                                         const char *path,
+                                         svn_revnum_t after,
+                                         svn_revnum_t until,
+                                         apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_boolean_t have_range;
+  svn_revnum_t first, last;
+
+  *revision = SVN_INVALID_REVNUM;
+  *indexed = FALSE;
+
+  SVN_ERR(get_existing_index(&sdb, fs, scratch_pool));
+  if (! sdb)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_indexed_range(&have_range, &first, &last, sdb));
+  if (! have_range || first > after + 1 || last < until)
+    return SVN_NO_ERROR;
+
+  /* The root never gets added, deleted or replaced after r0. */
+  for (path = svn_fs__canonicalize_abspath(path, scratch_pool);
+       !svn_fspath__is_root(path, strlen(path));
+       path = svn_fspath__dirname(path, scratch_pool))
+    {
+      svn_revnum_t structural_change;
+
+      SVN_ERR(get_row_revision(&structural_change, sdb,
+                               STMT_GET_NEXT_STRUCTURAL_CHANGE, path,
+                               after));
+      if (   SVN_IS_VALID_REVNUM(structural_change)
+          && structural_change <= until
+          && (   ! SVN_IS_VALID_REVNUM(*revision)
+              || structural_change < *revision))
+        *revision = structural_change;
+    }
+
+  *indexed = TRUE;
+
+  return SVN_NO_ERROR;
+}
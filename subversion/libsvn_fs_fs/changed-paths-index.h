@@ -0,0 +1,89 @@
+/* changed-paths-index.h : interface to the changed-paths index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#ifndef SVN_LIBSVN_FS_FS_CHANGED_PATHS_INDEX_H
+#define SVN_LIBSVN_FS_FS_CHANGED_PATHS_INDEX_H
+
+#include "svn_error.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+#define CHANGED_PATHS_DB_NAME    "changed-paths.db"
+
+/* Open and create, if needed, the changed-paths index database of FS.
+   Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__open_changed_paths_index(svn_fs_t *fs,
+                                    apr_pool_t *pool);
+
+/* Close the changed-paths index database of FS. */
+svn_error_t *
+svn_fs_fs__close_changed_paths_index(svn_fs_t *fs);
+
+/* Close and remove the changed-paths index database of FS, if it exists.
+   The index will be rebuilt from the next commit onwards.  Use POOL for
+   temporary allocations. */
+svn_error_t *
+svn_fs_fs__remove_changed_paths_index(svn_fs_t *fs,
+                                      apr_pool_t *pool);
+
+/* Add revision NEW_REV, which has just been committed to FS, to the
+   changed-paths index of FS.  Also add a bounded number of older
+   revisions that the index does not cover yet.  Use POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__update_changed_paths_index(svn_fs_t *fs,
+                                      svn_revnum_t new_rev,
+                                      apr_pool_t *pool);
+
+/* Implements fs_vtable_t.changed_paths_prev(); see there and
+   svn_fs__changed_paths_prev(). */
+svn_error_t *
+svn_fs_fs__changed_paths_prev(svn_revnum_t *revision,
+                              svn_boolean_t *structural,
+                              svn_fs_t *fs,
+                              const char *path,
+                              svn_revnum_t before,
+                              apr_pool_t *scratch_pool);
+
+/* Implements fs_vtable_t.changed_paths_next_structural(); see there and
+   svn_fs__changed_paths_next_structural(). */
+svn_error_t *
+svn_fs_fs__changed_paths_next_structural(svn_revnum_t *revision,
+                                         svn_boolean_t *indexed,
+                                         svn_fs_t *fs,
+                                         const char *path,
+                                         svn_revnum_t after,
+                                         svn_revnum_t until,
+                                         apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_CHANGED_PATHS_INDEX_H */
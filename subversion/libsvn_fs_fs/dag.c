@@ -526,7 +526,8 @@ svn_fs_fs__dag_has_props(svn_boolean_t *has_props,
   else
     {
       /* Properties are stored as a standard hash stream,
-         always ending with "END\n" (4 bytes) */
+         always ending with "END\n" (4 bytes), or in the binary encoding
+         that takes 2 bytes for an empty list. */
       *has_props = noderev->prop_rep->expanded_size > 4;
     }
 
@@ -1020,6 +1021,59 @@ svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
 }
 
 
+svn_error_t *
+svn_fs_fs__dag_try_get_file_range(apr_file_t **file,
+                                  apr_off_t *offset,
+                                  svn_filesize_t *length,
+                                  dag_node_t *node,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  node_revision_t *noderev;
+
+  if (node->kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL,
+       "Attempted to get textual contents of a *non*-file node");
+
+  SVN_ERR(get_node_revision(&noderev, node));
+
+  return svn_fs_fs__try_get_file_range(file, offset, length, node->fs,
+                                       noderev, result_pool, scratch_pool);
+}
+
+
+svn_error_t *
+svn_fs_fs__dag_try_get_file_delta_range(apr_file_t **file,
+                                        apr_off_t *offset,
+                                        svn_filesize_t *length,
+                                        dag_node_t *source,
+                                        dag_node_t *target,
+                                        apr_pool_t *result_pool,
+                                        apr_pool_t *scratch_pool)
+{
+  node_revision_t *src_noderev;
+  node_revision_t *tgt_noderev;
+
+  if ((source && source->kind != svn_node_file)
+      || target->kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL,
+       "Attempted to get textual contents of a *non*-file node");
+
+  if (source)
+    SVN_ERR(get_node_revision(&src_noderev, source));
+  else
+    src_noderev = NULL;
+  SVN_ERR(get_node_revision(&tgt_noderev, target));
+
+  return svn_fs_fs__try_get_file_delta_range(file, offset, length,
+                                             target->fs, src_noderev,
+                                             tgt_noderev, result_pool,
+                                             scratch_pool);
+}
+
+
 svn_error_t *
 svn_fs_fs__dag_file_length(svn_filesize_t *length,
                            dag_node_t *file,
@@ -426,6 +426,38 @@ svn_fs_fs__dag_try_process_file_contents(svn_boolean_t *success,
                                          void* baton,
                                          apr_pool_t *pool);
 
+/* If the contents of NODE are stored as-is in a committed revision, open
+   the file containing them in RESULT_POOL and set *FILE to it.  Set
+   *OFFSET and *LENGTH to the location of the contents within that file.
+   Otherwise, set *FILE to NULL.
+
+   Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__dag_try_get_file_range(apr_file_t **file,
+                                  apr_off_t *offset,
+                                  svn_filesize_t *length,
+                                  dag_node_t *node,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
+/* If the contents of TARGET are stored in a committed revision as a delta
+   against the contents of SOURCE, open the file containing that delta in
+   RESULT_POOL and set *FILE to it.  Set *OFFSET and *LENGTH to the
+   location of the svndiff data within that file.  If SOURCE is null, look
+   for a delta against the empty string.  Otherwise, set *FILE to NULL.
+
+   Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__dag_try_get_file_delta_range(apr_file_t **file,
+                                        apr_off_t *offset,
+                                        svn_filesize_t *length,
+                                        dag_node_t *source,
+                                        dag_node_t *target,
+                                        apr_pool_t *result_pool,
+                                        apr_pool_t *scratch_pool);
+
 
 /* Set *STREAM_P to a delta stream that will turn the contents of SOURCE into
    the contents of TARGET, allocated in POOL.  If SOURCE is null, the empty
@@ -40,9 +40,12 @@
 #include "id.h"
 #include "pack.h"
 #include "recovery.h"
+#include "changed-paths-index.h"
+#include "revision-dates.h"
 #include "rep-cache.h"
 #include "revprops.h"
 #include "transaction.h"
+#include "txn-store.h"
 #include "util.h"
 #include "verify.h"
 #include "svn_private_config.h"
@@ -123,6 +126,27 @@ fs_serialized_init(svn_fs_t *fs, apr_pool_t *common_pool, apr_pool_t *pool)
          transaction list and free transaction pointer. */
       SVN_ERR(svn_mutex__init(&ffsd->txn_list_lock, TRUE, common_pool));
 
+      /* The rep-cache filter comes with its own lock. */
+      SVN_ERR(svn_fs_fs__rep_filter_create(&ffsd->rep_filter, common_pool));
+
+      /* So does the cache of open rev / pack files. */
+      SVN_ERR(svn_fs_fs__file_handle_cache_create(&ffsd->file_handle_cache,
+                                                  common_pool));
+
+      /* And the store of in-memory transactions. */
+      SVN_ERR(svn_fs_fs__txn_store_create(&ffsd->txn_store, common_pool));
+
+#if APR_HAS_THREADS
+      /* Finally, in-process group commit needs to coordinate the
+         committing threads. */
+      SVN_ERR(svn_mutex__init(&ffsd->commit_queue_lock, TRUE, common_pool));
+      status = apr_thread_cond_create(&ffsd->commit_queue_changed,
+                                      common_pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create FSFS commit queue"));
+#endif
+
       key = apr_pstrdup(common_pool, key);
       status = apr_pool_userdata_set(ffsd, key, NULL, common_pool);
       if (status)
@@ -279,7 +303,10 @@ static fs_vtable_t fs_vtable = {
   fs_info,
   svn_fs_fs__verify_root,
   fs_freeze,
-  fs_set_errcall
+  fs_set_errcall,
+  svn_fs_fs__changed_paths_prev,
+  svn_fs_fs__changed_paths_next_structural,
+  svn_fs_fs__dated_revision
 };
 
 
@@ -291,8 +318,9 @@ initialize_fs_struct(svn_fs_t *fs)
 {
   fs_fs_data_t *ffd = apr_pcalloc(fs->pool, sizeof(*ffd));
   ffd->use_log_addressing = FALSE;
-  ffd->revprop_prefix = 0;
+  ffd->revprop_generation = -1;
   ffd->flush_to_disk = TRUE;
+  ffd->cache_priority = 100;
 
   fs->vtable = &fs_vtable;
   fs->fsap_data = ffd;
@@ -485,7 +513,8 @@ fs_pack(svn_fs_t *fs,
 /* This implements the fs_library_vtable_t.hotcopy() API.  Copy a
    possibly live Subversion filesystem SRC_FS from SRC_PATH to a
    DST_FS at DEST_PATH. If INCREMENTAL is TRUE, make an effort not to
-   re-copy data which already exists in DST_FS.
+   re-copy data which already exists in DST_FS.  Copy up to JOBS shards
+   concurrently.
    The CLEAN_LOGS argument is ignored and included for Subversion
    1.0.x compatibility.  Indicate progress via the optional NOTIFY_FUNC
    callback using NOTIFY_BATON.  Perform all temporary allocations in POOL. */
@@ -496,6 +525,7 @@ fs_hotcopy(svn_fs_t *src_fs,
            const char *dst_path,
            svn_boolean_t clean_logs,
            svn_boolean_t incremental,
+           int jobs,
            svn_fs_hotcopy_notify_t notify_func,
            void *notify_baton,
            svn_cancel_func_t cancel_func,
@@ -514,7 +544,7 @@ fs_hotcopy(svn_fs_t *src_fs,
      can't be opened.
    */
   return svn_fs_fs__hotcopy(src_fs, dst_fs, src_path, dst_path,
-                            incremental, notify_func, notify_baton,
+                            incremental, jobs, notify_func, notify_baton,
                             cancel_func, cancel_baton, common_pool_lock,
                             pool, common_pool);
 }
@@ -585,6 +615,28 @@ fs_info_dup(const void *fsfs_info_void,
 }
 
 
+/* Counters, see fs.h.  Order must match svn_fs_fs__metric_t. */
+svn_metrics__counter_t svn_fs_fs__metrics[] =
+  {
+    { "svn_fsfs_commits_total",
+      "Revisions committed.", 0 },
+    { "svn_fsfs_contents_reads_total",
+      "File contents streams opened.", 0 },
+    { "svn_fsfs_dir_reads_total",
+      "Directory listings read.", 0 },
+    { "svn_fsfs_l2p_lookups_total",
+      "Log-to-phys index lookups.", 0 },
+    { "svn_fsfs_p2l_lookups_total",
+      "Phys-to-log index lookups.", 0 },
+    { "svn_fsfs_rep_cache_queries_total",
+      "Representation cache lookups.", 0 },
+    { "svn_fsfs_rep_cache_hits_total",
+      "Representation cache lookups that found a match.", 0 }
+  };
+
+static svn_metrics__group_t metrics_group =
+  { svn_fs_fs__metrics, svn_fs_fs__metric_count, NULL };
+
 /* Base FS library vtable, used by the FS loader library. */
 
 static fs_library_vtable_t library_vtable = {
@@ -625,6 +677,9 @@ svn_fs_fs__init(const svn_version_t *loader_version,
                              loader_version->major);
   SVN_ERR(svn_ver_check_list2(fs_version(), checklist, svn_ver_equal));
 
+  SVN_ERR(svn_fs__batch_fsync_init(common_pool));
+  svn_metrics__register(&metrics_group);
+
   *vtable = &library_vtable;
   return SVN_NO_ERROR;
 }
@@ -28,14 +28,17 @@
 #include <apr_network_io.h>
 #include <apr_md5.h>
 #include <apr_sha1.h>
+#include <apr_thread_cond.h>
 
 #include "svn_fs.h"
 #include "svn_config.h"
 #include "private/svn_atomic.h"
 #include "private/svn_cache.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_fs_util.h"
 #include "private/svn_sqlite.h"
 #include "private/svn_mutex.h"
+#include "private/svn_subr_private.h"
 
 #include "rev_file.h"
 
@@ -100,13 +103,25 @@ extern "C" {
 /* Names of sections and options in fsfs.conf. */
 #define CONFIG_SECTION_CACHES            "caches"
 #define CONFIG_OPTION_FAIL_STOP          "fail-stop"
+#define CONFIG_OPTION_CACHE_PRIORITY     "priority"
 #define CONFIG_SECTION_REP_SHARING       "rep-sharing"
 #define CONFIG_OPTION_ENABLE_REP_SHARING "enable-rep-sharing"
+#define CONFIG_OPTION_REP_CACHE_SHARDS   "rep-cache-shards"
+#define CONFIG_OPTION_REP_CACHE_FILTER   "rep-cache-filter"
+#define CONFIG_SECTION_CHANGED_PATHS_INDEX       "changed-paths-index"
+#define CONFIG_OPTION_ENABLE_CHANGED_PATHS_INDEX "enable-changed-paths-index"
+#define CONFIG_SECTION_REVISION_DATES_INDEX      "revision-dates-index"
+#define CONFIG_OPTION_ENABLE_REVISION_DATES_INDEX "enable-revision-dates-index"
+#define CONFIG_SECTION_MERGEINFO_INDEX           "mergeinfo-index"
+#define CONFIG_OPTION_ENABLE_MERGEINFO_INDEX     "enable-mergeinfo-index"
+#define CONFIG_SECTION_LOCK_DATABASE             "lock-database"
+#define CONFIG_OPTION_ENABLE_LOCK_DATABASE       "enable-lock-database"
 #define CONFIG_SECTION_DELTIFICATION     "deltification"
 #define CONFIG_OPTION_ENABLE_DIR_DELTIFICATION   "enable-dir-deltification"
 #define CONFIG_OPTION_ENABLE_PROPS_DELTIFICATION "enable-props-deltification"
 #define CONFIG_OPTION_MAX_DELTIFICATION_WALK     "max-deltification-walk"
 #define CONFIG_OPTION_MAX_LINEAR_DELTIFICATION   "max-linear-deltification"
+#define CONFIG_OPTION_DELTA_BASE_POLICY          "delta-base-policy"
 #define CONFIG_OPTION_COMPRESSION_LEVEL  "compression-level"
 #define CONFIG_SECTION_PACKED_REVPROPS   "packed-revprops"
 #define CONFIG_OPTION_REVPROP_PACK_SIZE  "revprop-pack-size"
@@ -115,10 +130,21 @@ extern "C" {
 #define CONFIG_OPTION_BLOCK_SIZE         "block-size"
 #define CONFIG_OPTION_L2P_PAGE_SIZE      "l2p-page-size"
 #define CONFIG_OPTION_P2L_PAGE_SIZE      "p2l-page-size"
+#define CONFIG_OPTION_MMAP_PACKED_FILES  "mmap-packed-files"
+#define CONFIG_OPTION_PREFETCH_DELTA_CHAINS "prefetch-delta-chains"
+#define CONFIG_OPTION_PREFETCH_BLOCK_READS "prefetch-block-reads"
+#define CONFIG_OPTION_READ_AHEAD_BLOCKS  "read-ahead-blocks"
+#define CONFIG_OPTION_CACHED_FILE_HANDLES "cached-file-handles"
+#define CONFIG_OPTION_PACK_JOBS          "pack-jobs"
+#define CONFIG_OPTION_GROUP_COMMIT       "group-commit"
+#define CONFIG_OPTION_IN_MEMORY_TXN_SIZE "in-memory-txn-size"
 #define CONFIG_SECTION_DEBUG             "debug"
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
 #define CONFIG_OPTION_VERIFY_BEFORE_COMMIT "verify-before-commit"
+#define CONFIG_OPTION_ACCESS_LOG         "access-log"
+#define CONFIG_OPTION_ACCESS_LOG_SIZE    "access-log-size"
 #define CONFIG_OPTION_COMPRESSION        "compression"
+#define CONFIG_OPTION_COMPRESSION_THREADS "compression-threads"
 
 /* The format number of this filesystem.
    This is independent of the repository format number, and
@@ -153,6 +179,10 @@ extern "C" {
 /* The minimum format number that allows rep sharing. */
 #define SVN_FS_FS__MIN_REP_SHARING_FORMAT 4
 
+/* Upper limit to the number of rep-cache database files.  SHA1 keys are
+   distributed across them by their first byte. */
+#define SVN_FS_FS__MAX_REP_CACHE_SHARDS 256
+
 /* The minimum format number that supports packed shards. */
 #define SVN_FS_FS__MIN_PACKED_FORMAT 4
 
@@ -188,6 +218,21 @@ extern "C" {
 /* The minimum format number that supports svndiff version 2. */
 #define SVN_FS_FS__MIN_SVNDIFF2_FORMAT 8
 
+/* The minimum format number that supports svndiff version 3. */
+#define SVN_FS_FS__MIN_SVNDIFF3_FORMAT 8
+
+/* The minimum format number that supports the 'changes' format option,
+   i.e. compressed changed paths lists. */
+#define SVN_FS_FS__MIN_COMPRESSED_CHANGES_FORMAT 8
+
+/* The minimum format number that supports the 'properties' format option,
+   i.e. binary property lists. */
+#define SVN_FS_FS__MIN_BINARY_PROPERTIES_FORMAT 8
+
+/* The minimum format number that supports the 'deltas' format option,
+   i.e. zstd compressed deltas. */
+#define SVN_FS_FS__MIN_ZSTD_DELTAS_FORMAT SVN_FS_FS__MIN_SVNDIFF3_FORMAT
+
 /* On most operating systems apr implements file locks per process, not
    per file.  On Windows apr implements the locking as per file handle
    locks, so we don't have to add our own mutex for just in-process
@@ -200,7 +245,9 @@ extern "C" {
 
 /* Maximum number of changes we deliver per request when listing the
    changed paths for a given revision.   Anything > 0 will do.
-   At 100..300 bytes per entry, this limits the allocation to ~30kB. */
+   At 100..300 bytes per entry, this limits the allocation to ~30kB.
+   Compressed changes lists are written in blocks of this many entries
+   but remain readable if this value should ever change. */
 #define SVN_FS_FS__CHANGES_BLOCK_SIZE 100
 
 /* Private FSFS-specific data shared between all svn_txn_t objects that
@@ -227,6 +274,16 @@ typedef struct fs_fs_shared_txn_data_t
   apr_pool_t *pool;
 } fs_fs_shared_txn_data_t;
 
+/* A commit waiting to be written as part of a commit group.
+   See transaction.c. */
+typedef struct fs_fs_commit_request_t fs_fs_commit_request_t;
+
+/* An in-memory filter over the keys of the rep-cache.  See rep-cache.c. */
+typedef struct fs_fs_rep_filter_t fs_fs_rep_filter_t;
+
+/* Transaction metadata files that are kept in memory.  See txn-store.c. */
+typedef struct fs_fs_txn_store_t fs_fs_txn_store_t;
+
 /* Private FSFS-specific data shared between all svn_fs_t objects that
    relate to a particular filesystem, as identified by filesystem UUID.
    Objects of this type are allocated in the common pool. */
@@ -246,7 +303,10 @@ typedef struct fs_fs_shared_data_t
      declaration here.  Any subset may be acquired and held at any given
      time but their relative acquisition order must not change.
 
-     (lock 'txn-current' before 'pack' before 'write' before 'txn-list') */
+     (lock 'txn-current' before 'pack' before 'write' before 'txn-list')
+
+     The COMMIT_QUEUE_LOCK below is never held while acquiring any of
+     these but may be acquired while holding the 'write' lock. */
 
   /* A lock for intra-process synchronization when accessing the TXNS list. */
   svn_mutex__t *txn_list_lock;
@@ -263,6 +323,36 @@ typedef struct fs_fs_shared_data_t
      txn-current file. */
   svn_mutex__t *txn_current_lock;
 
+#if APR_HAS_THREADS
+  /* Commits waiting to be written by the current commit group leader,
+     in the order they arrived, or NULL if there are none.  All access
+     to this list as well as to the COMMIT_LEADER_ACTIVE flag is
+     synchronised under COMMIT_QUEUE_LOCK. */
+  fs_fs_commit_request_t *commit_queue;
+
+  /* Set while some thread writes a commit group to the repository. */
+  svn_boolean_t commit_leader_active;
+
+  /* A lock for intra-process synchronization when accessing the
+     COMMIT_QUEUE. */
+  svn_mutex__t *commit_queue_lock;
+
+  /* Signalled whenever a commit group has been completed. */
+  apr_thread_cond_t *commit_queue_changed;
+#endif
+
+  /* Tells which SHA1 keys are certainly not in the rep-cache.  It has its
+     own lock which may be acquired while holding any of the above. */
+  fs_fs_rep_filter_t *rep_filter;
+
+  /* Open rev and pack files that are currently not in use by any of the
+     svn_fs_t objects.  It has its own lock, just like REP_FILTER. */
+  fs_fs_file_handle_cache_t *file_handle_cache;
+
+  /* Metadata files of transactions that are kept in memory.  It has its
+     own lock as well. */
+  fs_fs_txn_store_t *txn_store;
+
   /* The common pool, under which this object is allocated, subpools
      of which are used to allocate the transaction objects. */
   apr_pool_t *common_pool;
@@ -303,9 +393,20 @@ typedef enum compression_type_t
 {
   compression_type_none,
   compression_type_zlib,
-  compression_type_lz4
+  compression_type_lz4,
+  compression_type_zstd
 } compression_type_t;
 
+/* How to select the delta base for new representations. */
+typedef enum delta_base_policy_t
+{
+  /* Skip-delta arithmetic on the predecessor count. */
+  delta_base_policy_skip_delta,
+
+  /* Based on the reconstruction cost of the actual candidate reps. */
+  delta_base_policy_cost
+} delta_base_policy_t;
+
 /* Private (non-shared) FSFS-specific data for each svn_fs_t object.
    Any caches in here may be NULL. */
 typedef struct fs_fs_data_t
@@ -321,6 +422,18 @@ typedef struct fs_fs_data_t
      physical addressing. */
   svn_boolean_t use_log_addressing;
 
+  /* If set, new revisions store their changed paths lists in compressed
+     blocks.  Set by the 'changes' format option. */
+  svn_boolean_t compressed_changes;
+
+  /* If set, new node and revision property lists get stored in the binary
+     encoding.  Set by the 'properties' format option. */
+  svn_boolean_t binary_properties;
+
+  /* If set, revisions may contain svndiff3, i.e. zstd compressed, deltas.
+     Set by the 'deltas' format option. */
+  svn_boolean_t zstd_deltas;
+
   /* Rev / pack file read granularity in bytes. */
   apr_int64_t block_size;
 
@@ -335,6 +448,41 @@ typedef struct fs_fs_data_t
    * (not just the one bit that we need, atm). */
   svn_boolean_t use_block_read;
 
+  /* If set, pack files opened for reading will be memory-mapped and
+   * representation data will be read from the mapped image. */
+  svn_boolean_t mmap_packed_files;
+
+  /* If set, ask the OS to fetch the data of all representations within
+   * a delta chain in the background as soon as the chain is known. */
+  svn_boolean_t prefetch_delta_chains;
+
+  /* If set, ask the OS to fetch the rev file blocks and index pages of a
+   * block read in the background before we need them, so that they get
+   * read in parallel with the index lookups. */
+  svn_boolean_t prefetch_block_reads;
+
+  /* Number of blocks to read ahead once sequential access to a rev or
+   * pack file has been detected.  0 disables read-ahead. */
+  apr_int64_t read_ahead_blocks;
+
+  /* Maximum number of idle rev / pack file handles to keep open for
+   * reuse within this process.  0 disables that cache. */
+  int cached_file_handles;
+
+  /* Maximum number of shards to pack concurrently.  1 means sequential
+   * packing. */
+  apr_int64_t pack_jobs;
+
+  /* If set, concurrent commits from within the same process may be
+   * written to the repository as a group, sharing the write lock and
+   * the final flush to disk. */
+  svn_boolean_t group_commit;
+
+  /* Maximum size in bytes of the metadata files of a transaction that
+   * may be kept in memory instead of the txn directory.  0 disables
+   * in-memory transactions. */
+  apr_size_t in_memory_txn_size;
+
   /* The revision that was youngest, last time we checked. */
   svn_revnum_t youngest_rev_cache;
 
@@ -348,6 +496,10 @@ typedef struct fs_fs_data_t
      e.g. memcached may be ignored as caching is an optional feature. */
   svn_boolean_t fail_stop;
 
+  /* Weight in percent applied to the priorities of all entries that this
+     repository puts into the shared membuffer cache.  100 is neutral. */
+  apr_int64_t cache_priority;
+
   /* A cache of revision root IDs, mapping from (svn_revnum_t *) to
      (svn_fs_id_t *).  (Not threadsafe.) */
   svn_cache__t *rev_root_id_cache;
@@ -364,15 +516,23 @@ typedef struct fs_fs_data_t
      names to (svn_fs_dirent_t *). */
   svn_cache__t *dir_cache;
 
+  /* A small, process-local cache of directories that are too large for
+     DIR_CACHE and TXN_DIR_CACHE, committed or in a transaction; maps from
+     the dir rep ("REV:ITEM") or unparsed FS ID (in-txn) to
+     svn_fs_fs__dir_data_t.  Its entries are searched and updated in-place
+     without deserializing the whole directory. */
+  svn_cache__t *large_dir_cache;
+
   /* Fulltext cache; currently only used with memcached.  Maps from
      rep key (revision/offset) to svn_stringbuf_t. */
   svn_cache__t *fulltext_cache;
 
-  /* The current prefix to be used for revprop cache entries.
-     If this is 0, a new unique prefix must be chosen. */
-  apr_uint64_t revprop_prefix;
+  /* The revprop generation as read from PATH_REVPROP_GENERATION, to be
+     used in revprop cache keys.  If this is negative, it must be re-read
+     before accessing the cache. */
+  apr_int64_t revprop_generation;
 
-  /* Revision property cache.  Maps from (rev,prefix) to apr_hash_t.
+  /* Revision property cache.  Maps from (rev,generation) to apr_hash_t.
      Unparsed svn_string_t representations of the serialized hash
      will be written to the cache but the getter returns apr_hash_t. */
   svn_cache__t *revprop_cache;
@@ -417,6 +577,16 @@ typedef struct fs_fs_data_t
      if the node has mergeinfo, "0" if it doesn't. */
   svn_cache__t *mergeinfo_existence_cache;
 
+  /* Cache for the parsed svn:mergeinfo of immutable nodes as
+     svn_mergeinfo_t objects; the key is the (revision, item index) pair
+     of the node-revision ID. */
+  svn_cache__t *explicit_mergeinfo_cache;
+
+  /* Cache for chunks of predecessor chains as svn_stringbuf_t objects;
+     the key is the (revision, item index) pair of the node-revision ID
+     at which the chunk starts. */
+  svn_cache__t *history_cache;
+
   /* Cache for l2p_header_t objects; the key is (revision, is-packed).
      Will be NULL for pre-format7 repos */
   svn_cache__t *l2p_header_cache;
@@ -447,12 +617,39 @@ typedef struct fs_fs_data_t
   /* Data shared between all svn_fs_t objects for a given filesystem. */
   fs_fs_shared_data_t *shared;
 
-  /* The sqlite database used for rep caching. */
-  svn_sqlite__db_t *rep_cache_db;
+  /* The sqlite databases used for rep caching, one per shard.  The
+     shard for a given SHA1 is determined by svn_fs_fs__rep_cache_shard.
+     NULL until the rep-cache has been opened. */
+  svn_sqlite__db_t **rep_cache_db;
+
+  /* Number of rep-cache database files (1 .. SVN_FS_FS__MAX_REP_CACHE_SHARDS).
+     1 means the traditional single rep-cache.db file. */
+  int rep_cache_shards;
 
   /* Thread-safe boolean */
   svn_atomic_t rep_cache_db_opened;
 
+  /* The sqlite database holding the changed-paths index.
+     NULL until it has been opened. */
+  svn_sqlite__db_t *changed_paths_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t changed_paths_db_opened;
+
+  /* The sqlite database holding the mergeinfo index.
+     NULL until it has been opened. */
+  svn_sqlite__db_t *mergeinfo_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t mergeinfo_db_opened;
+
+  /* The sqlite database holding the locks, if they are not stored in
+     digest files.  NULL until it has been opened. */
+  svn_sqlite__db_t *lock_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t lock_db_opened;
+
   /* The oldest revision not in a pack file.  It also applies to revprops
    * if revprop packing has been enabled by the FSFS format version. */
   svn_revnum_t min_unpacked_rev;
@@ -461,6 +658,23 @@ typedef struct fs_fs_data_t
    * and allowed by the configuration. */
   svn_boolean_t rep_sharing_allowed;
 
+  /* Whether rep-cache lookups shall consult the shared in-memory filter
+   * first, skipping the database query for keys known to be absent. */
+  svn_boolean_t rep_cache_filter;
+
+  /* Whether commits shall maintain the changed-paths index. */
+  svn_boolean_t changed_paths_index;
+
+  /* Whether commits and revprop changes shall maintain the revision
+     dates index. */
+  svn_boolean_t revision_dates_index;
+
+  /* Whether commits shall maintain the mergeinfo index. */
+  svn_boolean_t mergeinfo_index;
+
+  /* Whether lock changes shall move the locks into the lock database. */
+  svn_boolean_t lock_database;
+
   /* File size limit in bytes up to which multiple revprops shall be packed
    * into a single file. */
   apr_int64_t revprop_pack_size;
@@ -481,18 +695,29 @@ typedef struct fs_fs_data_t
    * deltification history after which skip deltas will be used. */
   apr_int64_t max_linear_deltification;
 
+  /* Strategy used to select delta bases. */
+  delta_base_policy_t delta_base_policy;
+
   /* Compression type to use with txdelta storage format in new revs. */
   compression_type_t delta_compression_type;
 
-  /* Compression level (currently, only used with compression_type_zlib). */
+  /* Compression level (used with compression_type_zlib and
+     compression_type_zstd). */
   int delta_compression_level;
 
+  /* Number of threads compressing delta windows concurrently when writing
+   * representations.  1 means compression on the calling thread. */
+  int delta_compression_threads;
+
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
   /* Verify each new revision before commit. */
   svn_boolean_t verify_before_commit;
 
+  /* Record item accesses in this log.  NULL if disabled. */
+  svn_fs__access_log_t *access_log;
+
   /* Per-instance filesystem ID, which provides an additional level of
      uniqueness for filesystems that share the same UUID, but should
      still be distinguishable (e.g. backups produced by svn_fs_hotcopy()
@@ -685,6 +910,31 @@ typedef struct svn_fs_fs__dir_data_t
   svn_filesize_t txn_filesize;
 } svn_fs_fs__dir_data_t;
 
+/*** Process-wide operation counters ***/
+
+/* Indexes into svn_fs_fs__metrics. */
+typedef enum svn_fs_fs__metric_t
+{
+  svn_fs_fs__metric_commits,
+  svn_fs_fs__metric_contents_reads,
+  svn_fs_fs__metric_dir_reads,
+  svn_fs_fs__metric_l2p_lookups,
+  svn_fs_fs__metric_p2l_lookups,
+  svn_fs_fs__metric_rep_cache_queries,
+  svn_fs_fs__metric_rep_cache_hits,
+
+  /* Number of counters.  Must be last. */
+  svn_fs_fs__metric_count
+} svn_fs_fs__metric_t;
+
+/* Counters for all FSFS repositories in this process.  They get
+ * registered with svn_metrics__register() when the module is loaded. */
+extern svn_metrics__counter_t svn_fs_fs__metrics[];
+
+/* Count one event of type METRIC, an svn_fs_fs__metric_t. */
+#define SVN_FS_FS__COUNT(metric) \
+  SVN_METRICS__INC(svn_fs_fs__metrics[metric])
+
 
 #ifdef __cplusplus
 }
@@ -38,6 +38,7 @@
 #include "id.h"
 #include "index.h"
 #include "rep-cache.h"
+#include "revision-dates.h"
 #include "revprops.h"
 #include "transaction.h"
 #include "tree.h"
@@ -457,19 +458,29 @@ check_format(int format)
 }
 
 /* Read the format number and maximum number of files per directory
-   from PATH and return them in *PFORMAT, *MAX_FILES_PER_DIR and
-   USE_LOG_ADDRESSIONG respectively.
+   from PATH and return them in *PFORMAT, *MAX_FILES_PER_DIR,
+   USE_LOG_ADDRESSIONG, *COMPRESSED_CHANGES, *BINARY_PROPERTIES and
+   *ZSTD_DELTAS respectively.
 
    *MAX_FILES_PER_DIR is obtained from the 'layout' format option, and
    will be set to zero if a linear scheme should be used.
    *USE_LOG_ADDRESSIONG is obtained from the 'addressing' format option,
    and will be set to FALSE for physical addressing.
+   *COMPRESSED_CHANGES is obtained from the 'changes' format option,
+   and will be set to FALSE for plain changed paths lists.
+   *BINARY_PROPERTIES is obtained from the 'properties' format option,
+   and will be set to FALSE for property lists in hash dump format.
+   *ZSTD_DELTAS is obtained from the 'deltas' format option, and will be
+   set to FALSE if no zstd compressed deltas may be present.
 
    Use POOL for temporary allocation. */
 static svn_error_t *
 read_format(int *pformat,
             int *max_files_per_dir,
             svn_boolean_t *use_log_addressing,
+            svn_boolean_t *compressed_changes,
+            svn_boolean_t *binary_properties,
+            svn_boolean_t *zstd_deltas,
             const char *path,
             apr_pool_t *pool)
 {
@@ -493,6 +504,9 @@ read_format(int *pformat,
       *pformat = 1;
       *max_files_per_dir = 0;
       *use_log_addressing = FALSE;
+      *compressed_changes = FALSE;
+      *binary_properties = FALSE;
+      *zstd_deltas = FALSE;
 
       return SVN_NO_ERROR;
     }
@@ -518,6 +532,9 @@ read_format(int *pformat,
   /* Set the default values for anything that can be set via an option. */
   *max_files_per_dir = 0;
   *use_log_addressing = FALSE;
+  *compressed_changes = FALSE;
+  *binary_properties = FALSE;
+  *zstd_deltas = FALSE;
 
   /* Read any options. */
   while (!eos)
@@ -560,6 +577,51 @@ read_format(int *pformat,
             }
         }
 
+      if (*pformat >= SVN_FS_FS__MIN_COMPRESSED_CHANGES_FORMAT &&
+          strncmp(buf->data, "changes ", 8) == 0)
+        {
+          if (strcmp(buf->data + 8, "plain") == 0)
+            {
+              *compressed_changes = FALSE;
+              continue;
+            }
+
+          if (strcmp(buf->data + 8, "lz4") == 0)
+            {
+              *compressed_changes = TRUE;
+              continue;
+            }
+        }
+
+      if (*pformat >= SVN_FS_FS__MIN_BINARY_PROPERTIES_FORMAT &&
+          strncmp(buf->data, "properties ", 11) == 0)
+        {
+          if (strcmp(buf->data + 11, "hash") == 0)
+            {
+              *binary_properties = FALSE;
+              continue;
+            }
+
+          if (strcmp(buf->data + 11, "binary") == 0)
+            {
+              *binary_properties = TRUE;
+              continue;
+            }
+        }
+
+      if (*pformat >= SVN_FS_FS__MIN_ZSTD_DELTAS_FORMAT &&
+          strcmp(buf->data, "deltas zstd") == 0)
+        {
+          if (!svn__zstd_supported())
+            return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+               _("'%s' requires zstd support, which is not available in "
+                 "this build of Subversion"),
+               svn_dirent_local_style(path, pool));
+
+          *zstd_deltas = TRUE;
+          continue;
+        }
+
       return svn_error_createf(SVN_ERR_BAD_VERSION_FILE_FORMAT, NULL,
          _("'%s' contains invalid filesystem format option '%s'"),
          svn_dirent_local_style(path, pool), buf->data);
@@ -577,9 +639,10 @@ read_format(int *pformat,
   return SVN_NO_ERROR;
 }
 
-/* Write the format number, maximum number of files per directory and
-   the addressing scheme to a new format file in PATH, possibly expecting
-   to overwrite a previously existing file.
+/* Write the format number, maximum number of files per directory, the
+   addressing scheme, the changes list and property list encodings and
+   whether zstd compressed deltas may be present to a new format file in
+   PATH, possibly expecting to overwrite a previously existing file.
 
    Use POOL for temporary allocation. */
 svn_error_t *
@@ -613,6 +676,16 @@ svn_fs_fs__write_format(svn_fs_t *fs,
         svn_stringbuf_appendcstr(sb, "addressing physical\n");
     }
 
+  /* Only mention the changes list and property list encodings when they
+     are not the default, such that older releases of the same format are
+     not locked out. */
+  if (ffd->compressed_changes)
+    svn_stringbuf_appendcstr(sb, "changes lz4\n");
+  if (ffd->binary_properties)
+    svn_stringbuf_appendcstr(sb, "properties binary\n");
+  if (ffd->zstd_deltas)
+    svn_stringbuf_appendcstr(sb, "deltas zstd\n");
+
   /* svn_io_write_version_file() does a load of magic to allow it to
      replace version files that already exist.  We only need to do
      that when we're allowed to overwrite an existing file. */
@@ -683,6 +756,41 @@ verify_block_size(apr_int64_t block_size,
   return SVN_NO_ERROR;
 }
 
+/* Set *POLICY_P according to the delta-base-policy option in CONFIG. */
+static svn_error_t *
+parse_delta_base_policy(delta_base_policy_t *policy_p,
+                        svn_config_t *config)
+{
+  const char *value;
+
+  /* delta-base-policy = skip-delta | cost */
+  svn_config_get(config, &value, CONFIG_SECTION_DELTIFICATION,
+                 CONFIG_OPTION_DELTA_BASE_POLICY, "skip-delta");
+  if (strcmp(value, "skip-delta") == 0)
+    *policy_p = delta_base_policy_skip_delta;
+  else if (strcmp(value, "cost") == 0)
+    *policy_p = delta_base_policy_cost;
+  else
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("Invalid '%s' value '%s' in the config"),
+                             CONFIG_OPTION_DELTA_BASE_POLICY, value);
+
+  return SVN_NO_ERROR;
+}
+
+/* Default for the number of idle rev / pack files to keep open.
+   Windows can't delete files that are still open, which would make
+   'svnadmin pack' fail, so don't keep any there. */
+#ifdef WIN32
+#define DEFAULT_CACHED_FILE_HANDLES 0
+#else
+#define DEFAULT_CACHED_FILE_HANDLES 16
+#endif
+
+/* zstd compression level used for the plain 'zstd' compression option.
+   This matches the zstd library's own default. */
+#define DEFAULT_ZSTD_COMPRESSION_LEVEL 3
+
 static svn_error_t *
 parse_compression_option(compression_type_t *compression_type_p,
                          int *compression_level_p,
@@ -692,7 +800,8 @@ parse_compression_option(compression_type_t *compression_type_p,
   int level;
   svn_boolean_t is_valid = TRUE;
 
-  /* compression = none | lz4 | zlib | zlib-1 ... zlib-9 */
+  /* compression = none | lz4 | zlib | zlib-1 ... zlib-9
+   *               | zstd | zstd-1 ... zstd-19 */
   if (strcmp(value, "none") == 0)
     {
       type = compression_type_none;
@@ -722,6 +831,25 @@ parse_compression_option(compression_type_t *compression_type_p,
       else
         is_valid = FALSE;
     }
+  else if (strncmp(value, "zstd", 4) == 0)
+    {
+      const char *p = value + 4;
+
+      type = compression_type_zstd;
+      if (*p == 0)
+        {
+          level = DEFAULT_ZSTD_COMPRESSION_LEVEL;
+        }
+      else if (*p == '-')
+        {
+          p++;
+          SVN_ERR(svn_cstring_atoi(&level, p));
+          if (level < 1 || level > 19)
+            is_valid = FALSE;
+        }
+      else
+        is_valid = FALSE;
+    }
   else
     {
       is_valid = FALSE;
@@ -760,6 +888,69 @@ read_config(fs_fs_data_t *ffd,
   else
     ffd->rep_sharing_allowed = FALSE;
 
+  /* Initialize ffd->rep_cache_shards. */
+  if (ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    {
+      apr_int64_t shards;
+      SVN_ERR(svn_config_get_int64(config, &shards,
+                                   CONFIG_SECTION_REP_SHARING,
+                                   CONFIG_OPTION_REP_CACHE_SHARDS, 1));
+      if (shards < 1 || shards > SVN_FS_FS__MAX_REP_CACHE_SHARDS)
+        return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                 _("%s is invalid for fsfs.conf setting '%s' "
+                                   "because it is not between 1 and %d."),
+                                 apr_psprintf(scratch_pool,
+                                              "%" APR_INT64_T_FMT, shards),
+                                 CONFIG_OPTION_REP_CACHE_SHARDS,
+                                 SVN_FS_FS__MAX_REP_CACHE_SHARDS);
+
+      ffd->rep_cache_shards = (int)shards;
+
+      SVN_ERR(svn_config_get_bool(config, &ffd->rep_cache_filter,
+                                  CONFIG_SECTION_REP_SHARING,
+                                  CONFIG_OPTION_REP_CACHE_FILTER, FALSE));
+    }
+  else
+    {
+      ffd->rep_cache_shards = 1;
+      ffd->rep_cache_filter = FALSE;
+    }
+
+  /* Initialize ffd->changed_paths_index.  Like the rep-cache, it needs
+     SQLite support in the FS format. */
+  if (ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    SVN_ERR(svn_config_get_bool(config, &ffd->changed_paths_index,
+                                CONFIG_SECTION_CHANGED_PATHS_INDEX,
+                                CONFIG_OPTION_ENABLE_CHANGED_PATHS_INDEX,
+                                FALSE));
+  else
+    ffd->changed_paths_index = FALSE;
+
+  /* Initialize ffd->revision_dates_index.  It is a plain file and works
+     with any format. */
+  SVN_ERR(svn_config_get_bool(config, &ffd->revision_dates_index,
+                              CONFIG_SECTION_REVISION_DATES_INDEX,
+                              CONFIG_OPTION_ENABLE_REVISION_DATES_INDEX,
+                              FALSE));
+
+  /* Initialize ffd->mergeinfo_index, with the same format requirement. */
+  if (ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    SVN_ERR(svn_config_get_bool(config, &ffd->mergeinfo_index,
+                                CONFIG_SECTION_MERGEINFO_INDEX,
+                                CONFIG_OPTION_ENABLE_MERGEINFO_INDEX,
+                                FALSE));
+  else
+    ffd->mergeinfo_index = FALSE;
+
+  /* Initialize ffd->lock_database, with the same format requirement. */
+  if (ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    SVN_ERR(svn_config_get_bool(config, &ffd->lock_database,
+                                CONFIG_SECTION_LOCK_DATABASE,
+                                CONFIG_OPTION_ENABLE_LOCK_DATABASE,
+                                FALSE));
+  else
+    ffd->lock_database = FALSE;
+
   /* Initialize deltification settings in ffd. */
   if (ffd->format >= SVN_FS_FS__MIN_DELTIFICATION_FORMAT)
     {
@@ -779,6 +970,7 @@ read_config(fs_fs_data_t *ffd,
                                    CONFIG_SECTION_DELTIFICATION,
                                    CONFIG_OPTION_MAX_LINEAR_DELTIFICATION,
                                    SVN_FS_FS_MAX_LINEAR_DELTIFICATION));
+      SVN_ERR(parse_delta_base_policy(&ffd->delta_base_policy, config));
     }
   else
     {
@@ -786,6 +978,7 @@ read_config(fs_fs_data_t *ffd,
       ffd->deltify_properties = FALSE;
       ffd->max_deltification_walk = SVN_FS_FS_MAX_DELTIFICATION_WALK;
       ffd->max_linear_deltification = SVN_FS_FS_MAX_LINEAR_DELTIFICATION;
+      ffd->delta_base_policy = delta_base_policy_skip_delta;
     }
 
   /* Initialize revprop packing settings in ffd. */
@@ -854,10 +1047,15 @@ read_config(fs_fs_data_t *ffd,
                                   CONFIG_SECTION_DEBUG,
                                   CONFIG_OPTION_PACK_AFTER_COMMIT,
                                   FALSE));
+      SVN_ERR(svn_config_get_bool(config, &ffd->mmap_packed_files,
+                                  CONFIG_SECTION_IO,
+                                  CONFIG_OPTION_MMAP_PACKED_FILES,
+                                  FALSE));
     }
   else
     {
       ffd->pack_after_commit = FALSE;
+      ffd->mmap_packed_files = FALSE;
     }
 
   /* Initialize compression settings in ffd. */
@@ -890,6 +1088,18 @@ read_config(fs_fs_data_t *ffd,
                                       _("Compression type 'lz4' requires "
                                         "filesystem format 8 or higher"));
             }
+          if (ffd->delta_compression_type == compression_type_zstd)
+            {
+              if (ffd->format < SVN_FS_FS__MIN_SVNDIFF3_FORMAT)
+                return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                        _("Compression type 'zstd' requires "
+                                          "filesystem format 8 or higher"));
+              if (!svn__zstd_supported())
+                return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                        _("Compression type 'zstd' is not "
+                                          "supported by this build of "
+                                          "Subversion"));
+            }
         }
       else if (compression_level_val)
         {
@@ -920,6 +1130,15 @@ read_config(fs_fs_data_t *ffd,
       ffd->delta_compression_level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
     }
 
+  {
+    apr_int64_t compression_threads;
+    SVN_ERR(svn_config_get_int64(config, &compression_threads,
+                                 CONFIG_SECTION_DELTIFICATION,
+                                 CONFIG_OPTION_COMPRESSION_THREADS, 1));
+    ffd->delta_compression_threads = (int)MIN(MAX(compression_threads, 1),
+                                              64);
+  }
+
 #ifdef SVN_DEBUG
   SVN_ERR(svn_config_get_bool(config, &ffd->verify_before_commit,
                               CONFIG_SECTION_DEBUG,
@@ -932,6 +1151,78 @@ read_config(fs_fs_data_t *ffd,
                               FALSE));
 #endif
 
+  SVN_ERR(svn_config_get_bool(config, &ffd->prefetch_delta_chains,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_PREFETCH_DELTA_CHAINS,
+                              FALSE));
+
+  SVN_ERR(svn_config_get_bool(config, &ffd->prefetch_block_reads,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_PREFETCH_BLOCK_READS,
+                              FALSE));
+
+  SVN_ERR(svn_config_get_int64(config, &ffd->read_ahead_blocks,
+                               CONFIG_SECTION_IO,
+                               CONFIG_OPTION_READ_AHEAD_BLOCKS,
+                               16));
+  if (ffd->read_ahead_blocks < 0)
+    ffd->read_ahead_blocks = 0;
+
+  {
+    apr_int64_t cached_file_handles;
+    SVN_ERR(svn_config_get_int64(config, &cached_file_handles,
+                                 CONFIG_SECTION_IO,
+                                 CONFIG_OPTION_CACHED_FILE_HANDLES,
+                                 DEFAULT_CACHED_FILE_HANDLES));
+    ffd->cached_file_handles = (int)MIN(MAX(cached_file_handles, 0),
+                                        1024);
+  }
+
+  SVN_ERR(svn_config_get_int64(config, &ffd->pack_jobs,
+                               CONFIG_SECTION_IO,
+                               CONFIG_OPTION_PACK_JOBS,
+                               1));
+  if (ffd->pack_jobs < 1)
+    ffd->pack_jobs = 1;
+
+  SVN_ERR(svn_config_get_bool(config, &ffd->group_commit,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_GROUP_COMMIT,
+                              FALSE));
+
+  {
+    apr_int64_t in_memory_txn_size;
+    SVN_ERR(svn_config_get_int64(config, &in_memory_txn_size,
+                                 CONFIG_SECTION_IO,
+                                 CONFIG_OPTION_IN_MEMORY_TXN_SIZE,
+                                 64));
+    ffd->in_memory_txn_size = (apr_size_t)MIN(MAX(in_memory_txn_size, 0),
+                                              0x100000) * 1024;
+  }
+
+  /* Access logging is only enabled if a log file has been given. */
+  {
+    const char *access_log;
+    apr_int64_t access_log_size;
+
+    svn_config_get(config, &access_log, CONFIG_SECTION_DEBUG,
+                   CONFIG_OPTION_ACCESS_LOG, NULL);
+    SVN_ERR(svn_config_get_int64(config, &access_log_size,
+                                 CONFIG_SECTION_DEBUG,
+                                 CONFIG_OPTION_ACCESS_LOG_SIZE, 0x100000));
+    access_log_size = MIN(MAX(access_log_size, 1), APR_UINT32_MAX);
+
+    ffd->access_log = NULL;
+    if (access_log && *access_log)
+      SVN_ERR(svn_fs__access_log_open(&ffd->access_log,
+                                      svn_dirent_join(fs_path, access_log,
+                                                      scratch_pool),
+                                      (apr_uint32_t)access_log_size,
+                                      (apr_uint32_t)ffd->block_size,
+                                      (apr_uint32_t)ffd->max_files_per_dir,
+                                      result_pool));
+  }
+
   /* memcached configuration */
   SVN_ERR(svn_cache__make_memcache_from_config(&ffd->memcache, config,
                                                result_pool, scratch_pool));
@@ -940,6 +1231,15 @@ read_config(fs_fs_data_t *ffd,
                               CONFIG_SECTION_CACHES, CONFIG_OPTION_FAIL_STOP,
                               FALSE));
 
+  SVN_ERR(svn_config_get_int64(config, &ffd->cache_priority,
+                               CONFIG_SECTION_CACHES,
+                               CONFIG_OPTION_CACHE_PRIORITY,
+                               100));
+  if (ffd->cache_priority < 1)
+    ffd->cache_priority = 1;
+  else if (ffd->cache_priority > 1000)
+    ffd->cache_priority = 1000;
+
   return SVN_NO_ERROR;
 }
 
@@ -972,6 +1272,14 @@ write_config(svn_fs_t *fs,
 "### configured (and ignoring it with file:// access).  To make"             NL
 "### Subversion never ignore cache errors, uncomment this line."             NL
 "# " CONFIG_OPTION_FAIL_STOP " = true"                                       NL
+"### All repositories served by a process share the same in-memory cache."   NL
+"### The following parameter weighs the cache priority of this"              NL
+"### repository's data against that of other repositories, in percent."     NL
+"### Data of repositories with lower values gets evicted first and cannot"   NL
+"### displace the default-priority data of others.  Use e.g. 25 for large,"  NL
+"### rarely used repositories and e.g. 400 for the most important ones."     NL
+"### Values range from 1 to 1000.  The default is 100."                      NL
+"# " CONFIG_OPTION_CACHE_PRIORITY " = 100"                                   NL
 ""                                                                           NL
 "[" CONFIG_SECTION_REP_SHARING "]"                                           NL
 "### To conserve space, the filesystem can optionally avoid storing"         NL
@@ -988,6 +1296,77 @@ write_config(svn_fs_t *fs,
 "### 'svnadmin verify' will check the rep-cache regardless of this setting." NL
 "### rep-sharing is enabled by default."                                     NL
 "# " CONFIG_OPTION_ENABLE_REP_SHARING " = true"                              NL
+"###"                                                                        NL
+"### The rep-cache database can be split into several files.  Concurrent"    NL
+"### commits then only contend for a database lock if they add content"      NL
+"### that hashes to the same file, and no single index grows as large."      NL
+"### The following parameter sets the number of rep-cache files, from 1"     NL
+"### to 256.  The default of 1 uses the single rep-cache.db file; other"     NL
+"### values use rep-cache-00.db, rep-cache-01.db etc.  Changing this value"  NL
+"### does not move existing entries.  Representations recorded before the"   NL
+"### change will no longer be found and shared, but nothing is lost."        NL
+"### Files of the previous layout should be removed when the value is"       NL
+"### changed since 'svnadmin verify', 'recover' and 'hotcopy' only look at"  NL
+"### the files of the current layout."                                       NL
+"# " CONFIG_OPTION_REP_CACHE_SHARDS " = 1"                                   NL
+"###"                                                                        NL
+"### Most rep-cache lookups during bulk imports and 'svnadmin load' miss"    NL
+"### because the content is new.  If the following parameter is enabled,"    NL
+"### each server process keeps an in-memory filter over the rep-cache keys"  NL
+"### that tells which contents are certainly not in the rep-cache, saving"   NL
+"### the database queries for them.  The filter is built upon first use by"  NL
+"### reading the whole rep-cache and takes about 2 bytes per entry.  It"     NL
+"### will only be used as long as all commits go through the same process;"  NL
+"### it is switched off once another process has committed.  Hence, this"    NL
+"### benefits 'svnadmin load' and single process, multi-threaded servers."   NL
+"### The filter is disabled by default."                                     NL
+"# " CONFIG_OPTION_REP_CACHE_FILTER " = false"                               NL
+""                                                                           NL
+"[" CONFIG_SECTION_CHANGED_PATHS_INDEX "]"                                   NL
+"### 'svn log' on a path has to walk the history of every node it reports."  NL
+"### In large repositories with deep histories, that walk dominates the"     NL
+"### request.  If the following parameter is enabled, each commit records"   NL
+"### the paths it changed in an index (changed-paths.db) that log requests"  NL
+"### use to find the relevant revisions directly.  The index only covers"    NL
+"### revisions committed while it was enabled plus a few older revisions"    NL
+"### filled in by each commit.  Log falls back to the regular history walk"  NL
+"### for anything outside that range as well as at copies and deletions."    NL
+"### The index is disabled by default."                                      NL
+"# " CONFIG_OPTION_ENABLE_CHANGED_PATHS_INDEX " = false"                     NL
+""                                                                           NL
+"[" CONFIG_SECTION_REVISION_DATES_INDEX "]"                                  NL
+"### Dated revisions such as '-r {2024-01-01}' get resolved by a binary"     NL
+"### search over the svn:date properties of the revisions, reading one"      NL
+"### revision property file per step.  If the following parameter is"        NL
+"### enabled, commits and svn:date changes maintain a small file"            NL
+"### (revision-dates) with the date of every revision that is searched"      NL
+"### instead.  Each commit also fills in a bounded number of revisions"      NL
+"### committed before the index got enabled.  The index is disabled by"      NL
+"### default."                                                               NL
+"# " CONFIG_OPTION_ENABLE_REVISION_DATES_INDEX " = false"                    NL
+""                                                                           NL
+"[" CONFIG_SECTION_MERGEINFO_INDEX "]"                                       NL
+"### Merges and 'svn mergeinfo' ask for the mergeinfo of whole subtrees."    NL
+"### Finding the nodes that carry mergeinfo requires walking every branch"   NL
+"### of the tree that has any.  If the following parameter is enabled,"      NL
+"### each commit records which paths carry mergeinfo in an index"            NL
+"### (mergeinfo.db) that answers these requests directly.  The index"        NL
+"### starts with the tree of the revision before the first commit that"      NL
+"### maintains it; older revisions use the regular tree walk."               NL
+"### The index is disabled by default."                                      NL
+"# " CONFIG_OPTION_ENABLE_MERGEINFO_INDEX " = false"                         NL
+""                                                                           NL
+"[" CONFIG_SECTION_LOCK_DATABASE "]"                                         NL
+"### Locks are stored in one file per locked path, and every parent"         NL
+"### directory keeps a file listing the locks below it.  Listing the locks"  NL
+"### of a large subtree means reading all of these files.  If the following" NL
+"### parameter is enabled, the next lock or unlock operation moves all"      NL
+"### locks into a database (locks/locks.db) that answers such queries"       NL
+"### directly and updates any number of locks in one transaction."           NL
+"### Disabling it again moves the locks back to individual files upon the"   NL
+"### next lock or unlock.  All processes accessing the repository should"    NL
+"### use the same setting.  The database is disabled by default."            NL
+"# " CONFIG_OPTION_ENABLE_LOCK_DATABASE " = false"                           NL
 ""                                                                           NL
 "[" CONFIG_SECTION_DELTIFICATION "]"                                         NL
 "### To conserve space, the filesystem stores data as differences against"   NL
@@ -1050,6 +1429,21 @@ write_config(svn_fs_t *fs,
 "### For 1.8, the default value is 16; earlier versions use 1."              NL
 "# " CONFIG_OPTION_MAX_LINEAR_DELTIFICATION " = 16"                          NL
 "###"                                                                        NL
+"### This setting selects how the delta base of a new representation is"     NL
+"### chosen.  'skip-delta' derives it from the number of predecessors"       NL
+"### alone, as controlled by the two options above.  'cost' looks at the"    NL
+"### delta chains actually stored for the candidates instead:  It deltifies" NL
+"### against the latest version while that can be reconstructed from at"     NL
+"### most " CONFIG_OPTION_MAX_LINEAR_DELTIFICATION " representations, then"  NL
+"### falls back to the nearest skip-delta base that is cheap to read and"    NL
+"### similar in size."                                                       NL
+"### This avoids long chains caused by shared representations and deltas"    NL
+"### that are larger than the fulltext would be.  Only new revisions are"    NL
+"### affected; to rebalance existing ones, dump and load the repository"     NL
+"### with this option set."                                                  NL
+"### The default value is 'skip-delta'."                                     NL
+"# " CONFIG_OPTION_DELTA_BASE_POLICY " = skip-delta"                         NL
+"###"                                                                        NL
 "### After deltification, we compress the data to minimize on-disk size."    NL
 "### This setting controls the compression algorithm, which will be used in" NL
 "### future revisions.  It can be used to either disable compression or to"  NL
@@ -1059,8 +1453,15 @@ write_config(svn_fs_t *fs,
 "### incompressible files.  Note that the compression ratio of lz4 is"       NL
 "### usually lower than the one provided by zlib, but using it can"          NL
 "### significantly speed up commits as well as reading the data."            NL
+"### zstd usually compresses better than zlib while being considerably"      NL
+"### faster to decompress.  It requires format 8 and a build of Subversion"  NL
+"### with zstd support.  The first commit with it marks the repository"     NL
+"### such that releases and builds without zstd support refuse to open"      NL
+"### it; that commit itself still uses zlib.  'zstd' without a level is"     NL
+"### equivalent to 'zstd-3'."                                                NL
 "### The syntax of this option is:"                                          NL
 "###   " CONFIG_OPTION_COMPRESSION " = none | lz4 | zlib | zlib-1 ... zlib-9" NL
+"###                 | zstd | zstd-1 ... zstd-19"                            NL
 "### Versions prior to Subversion 1.10 will ignore this option."             NL
 "### The default value is 'zlib', which is currently equivalent to 'zlib-5'." NL
 "# " CONFIG_OPTION_COMPRESSION " = zlib"                                     NL
@@ -1071,6 +1472,14 @@ write_config(svn_fs_t *fs,
 "### still be used (and it will result in zlib compression with the"         NL
 "### corresponding compression level)."                                      NL
 "###   " CONFIG_OPTION_COMPRESSION_LEVEL " = 0 ... 9 (default is 5)"         NL
+"###"                                                                        NL
+"### Delta windows of large files may be compressed by several threads at"   NL
+"### the same time.  This speeds up commits of large binaries on multi-core" NL
+"### servers while producing the same on-disk data.  The setting is ignored" NL
+"### where threads are not supported and values are capped at 64."          NL
+"### Versions prior to Subversion 1.10 will ignore this option."             NL
+"### The default is 1, i.e. windows are compressed by the committing thread." NL
+"# " CONFIG_OPTION_COMPRESSION_THREADS " = 1"                               NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -1139,6 +1548,95 @@ write_config(svn_fs_t *fs,
 "### Must be a power of 2."                                                  NL
 "### p2l-page-size is given in kBytes and with a default of 1024 kBytes."    NL
 "# " CONFIG_OPTION_P2L_PAGE_SIZE " = 1024"                                   NL
+"###"                                                                        NL
+"### Pack files never change once written.  If this option is enabled,"     NL
+"### they will be memory-mapped when opened for reading and revision"        NL
+"### contents will be read directly from the mapped pages, avoiding"         NL
+"### buffer copies and seek / read system calls.  Non-packed revisions"      NL
+"### and transactions are not affected by this setting.  On 32 bit"          NL
+"### systems, large pack files may exceed the address space and will then"   NL
+"### be read without memory-mapping."                                        NL
+"### Versions prior to Subversion 1.10 will ignore this option."             NL
+"### mmap-packed-files is disabled by default."                              NL
+"# " CONFIG_OPTION_MMAP_PACKED_FILES " = false"                              NL
+"###"                                                                        NL
+"### Reconstructing a file from a long delta chain reads data from many"     NL
+"### different rev and pack files.  If this option is enabled, the OS will"  NL
+"### be told to fetch all of that data in the background as soon as the"     NL
+"### delta chain is known.  This allows these reads to be served in"        NL
+"### parallel and may significantly speed up reading from cold caches or"    NL
+"### high-latency storage.  It has no effect on platforms that don't"        NL
+"### support read-ahead hints."                                              NL
+"### Versions prior to Subversion 1.10 will ignore this option."             NL
+"### prefetch-delta-chains is disabled by default."                          NL
+"# " CONFIG_OPTION_PREFETCH_DELTA_CHAINS " = false"                          NL
+"###"                                                                        NL
+"### Reading an item from a repository of format 7 or newer first looks up"  NL
+"### its offset in the log-to-phys index, then the other items in the same"  NL
+"### block in the phys-to-log index, and finally reads that block.  If this" NL
+"### option is enabled, the OS will be told to fetch the block as soon as"   NL
+"### its offset is known and index pages that span several blocks in one"    NL
+"### go.  Each lookup then waits for fewer disk accesses in sequence, which" NL
+"### helps with cold caches, high-latency storage and many concurrent"       NL
+"### readers.  It has no effect on platforms that don't support read-ahead"  NL
+"### hints."                                                                 NL
+"### Versions prior to Subversion 1.10 will ignore this option."             NL
+"### prefetch-block-reads is disabled by default."                           NL
+"# " CONFIG_OPTION_PREFETCH_BLOCK_READS " = false"                           NL
+"###"                                                                        NL
+"### Operations like 'svnadmin dump' and 'svnadmin verify' read rev and"     NL
+"### pack files front to back.  Once such a sequential scan has been"        NL
+"### detected, the OS will be told to fetch the next read-ahead-blocks"      NL
+"### blocks of block-size in the background.  Set this to 0 to disable"      NL
+"### read-ahead.  It has no effect on platforms that don't support"          NL
+"### read-ahead hints or for repositories of format 6 and older."            NL
+"### Versions prior to Subversion 1.10 will ignore this option."             NL
+"### The default is 16 blocks."                                              NL
+"# " CONFIG_OPTION_READ_AHEAD_BLOCKS " = 16"                                 NL
+"###"                                                                        NL
+"### Opening a pack file and reading its index footer takes several system"  NL
+"### calls.  Up to cached-file-handles rev and pack files that are no"       NL
+"### longer in use will be kept open and be shared by all sessions of this"  NL
+"### process that access this repository.  Set this to 0 to close files"     NL
+"### as soon as they are no longer in use.  Files of revisions that get"     NL
+"### packed will be closed when packing in the same process."                NL
+"### Versions prior to Subversion 1.10 will ignore this option."             NL
+"### The default is 16 files, or 0 on Windows, where open files can't be"    NL
+"### deleted by 'svnadmin pack'."                                            NL
+"# " CONFIG_OPTION_CACHED_FILE_HANDLES " = 16"                               NL
+"###"                                                                        NL
+"### 'svnadmin pack' may process several shards at the same time, each in"   NL
+"### its own thread.  Shards still get switched over to their packed form"   NL
+"### in order, and the memory limit given to the pack operation is split"    NL
+"### evenly between the concurrent shards.  Concurrent packing requires"     NL
+"### thread-safe caches and is ignored where threads are not supported."     NL
+"### Versions prior to Subversion 1.10 will ignore this option."             NL
+"### The default is 1, i.e. shards are packed one after another."            NL
+"# " CONFIG_OPTION_PACK_JOBS " = 1"                                          NL
+"###"                                                                        NL
+"### Servers that handle several commits to the same repository at the"      NL
+"### same time from different threads of the same process may write them"   NL
+"### as a group instead of one after another:  one thread takes the write"   NL
+"### lock on behalf of all commits waiting for it, writes their revisions"   NL
+"### back to back and flushes them to disk together.  Commits that are"      NL
+"### out of date due to an earlier member of the group are merged just as"   NL
+"### they would be when committed separately.  This has no effect where"     NL
+"### threads are not supported."                                             NL
+"### Versions prior to Subversion 1.10 will ignore this option."             NL
+"### group-commit is disabled by default."                                   NL
+"# " CONFIG_OPTION_GROUP_COMMIT " = false"                                   NL
+"###"                                                                        NL
+"### Commits of only a few files spend most of their time creating and"      NL
+"### reading back small files in the transaction directory.  Transactions"   NL
+"### that are created and committed by the same commit editor, in"           NL
+"### repositories without start-commit and pre-commit hooks, keep their"     NL
+"### node revisions, properties, changes and next-ids in memory instead."    NL
+"### Once these exceed in-memory-txn-size kBytes, they are written to the"   NL
+"### transaction directory and the commit continues from there.  Set this"   NL
+"### to 0 to always use the transaction directory."                          NL
+"### Versions prior to Subversion 1.10 will ignore this option."             NL
+"### The default is 64 kBytes."                                              NL
+"# " CONFIG_OPTION_IN_MEMORY_TXN_SIZE " = 64"                                NL
 ""                                                                           NL
 "[" CONFIG_SECTION_DEBUG "]"                                                 NL
 "###"                                                                        NL
@@ -1146,6 +1644,16 @@ write_config(svn_fs_t *fs,
 "### the commit. The default is false in release-mode builds, and true"      NL
 "### in debug-mode builds."                                                  NL
 "# " CONFIG_OPTION_VERIFY_BEFORE_COMMIT " = false"                           NL
+"###"                                                                        NL
+"### Record every access to an item in a revision or pack file in a binary"  NL
+"### log file, together with its position and whether it has been served"    NL
+"### from cache.  The log is a ring buffer that keeps the latest"            NL
+"### " CONFIG_OPTION_ACCESS_LOG_SIZE " records.  Relative paths are taken"   NL
+"### relative to the db directory.  All processes opening the repository"    NL
+"### write to the same log.  Use 'svnfsfs access-map' to evaluate it."       NL
+"### Access logging is disabled by default."                                 NL
+"# " CONFIG_OPTION_ACCESS_LOG " = access.log"                                NL
+"# " CONFIG_OPTION_ACCESS_LOG_SIZE " = 1048576"                              NL
 ;
 #undef NL
   return svn_io_file_create(svn_dirent_join(fs->path, PATH_CONFIG, pool),
@@ -1217,16 +1725,22 @@ svn_fs_fs__read_format_file(svn_fs_t *fs, apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   int format, max_files_per_dir;
-  svn_boolean_t use_log_addressing;
+  svn_boolean_t use_log_addressing, compressed_changes, binary_properties;
+  svn_boolean_t zstd_deltas;
 
   /* Read info from format file. */
   SVN_ERR(read_format(&format, &max_files_per_dir, &use_log_addressing,
-                      path_format(fs, scratch_pool), scratch_pool));
+                      &compressed_changes, &binary_properties,
+                      &zstd_deltas, path_format(fs, scratch_pool),
+                      scratch_pool));
 
   /* Now that we've got *all* info, store / update values in FFD. */
   ffd->format = format;
   ffd->max_files_per_dir = max_files_per_dir;
   ffd->use_log_addressing = use_log_addressing;
+  ffd->compressed_changes = compressed_changes;
+  ffd->binary_properties = binary_properties;
+  ffd->zstd_deltas = zstd_deltas;
 
   return SVN_NO_ERROR;
 }
@@ -1291,13 +1805,15 @@ upgrade_body(void *baton, apr_pool_t *pool)
   svn_fs_t *fs = upgrade_baton->fs;
   fs_fs_data_t *ffd = fs->fsap_data;
   int format, max_files_per_dir;
-  svn_boolean_t use_log_addressing;
+  svn_boolean_t use_log_addressing, compressed_changes, binary_properties;
+  svn_boolean_t zstd_deltas;
   const char *format_path = path_format(fs, pool);
   svn_node_kind_t kind;
   svn_boolean_t needs_revprop_shard_cleanup = FALSE;
 
   /* Read the FS format number and max-files-per-dir setting. */
   SVN_ERR(read_format(&format, &max_files_per_dir, &use_log_addressing,
+                      &compressed_changes, &binary_properties, &zstd_deltas,
                       format_path, pool));
 
   /* If the config file does not exist, create one. */
@@ -1374,6 +1890,9 @@ upgrade_body(void *baton, apr_pool_t *pool)
   ffd->format = SVN_FS_FS__FORMAT_NUMBER;
   ffd->max_files_per_dir = max_files_per_dir;
   ffd->use_log_addressing = use_log_addressing;
+  ffd->compressed_changes = compressed_changes;
+  ffd->binary_properties = binary_properties;
+  ffd->zstd_deltas = zstd_deltas;
 
   /* Always add / bump the instance ID such that no form of caching
      accidentally uses outdated information.  Keep the UUID. */
@@ -1804,6 +2323,8 @@ svn_fs_fs__create_file_tree(svn_fs_t *fs,
                             int format,
                             int shard_size,
                             svn_boolean_t use_log_addressing,
+                            svn_boolean_t compressed_changes,
+                            svn_boolean_t binary_properties,
                             apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
@@ -1823,6 +2344,18 @@ svn_fs_fs__create_file_tree(svn_fs_t *fs,
   else
     ffd->use_log_addressing = FALSE;
 
+  /* Select the changes list encoding depending on the format. */
+  if (format >= SVN_FS_FS__MIN_COMPRESSED_CHANGES_FORMAT)
+    ffd->compressed_changes = compressed_changes;
+  else
+    ffd->compressed_changes = FALSE;
+
+  /* Select the property list encoding depending on the format. */
+  if (format >= SVN_FS_FS__MIN_BINARY_PROPERTIES_FORMAT)
+    ffd->binary_properties = binary_properties;
+  else
+    ffd->binary_properties = FALSE;
+
   /* Create the revision data directories. */
   if (ffd->max_files_per_dir)
     SVN_ERR(svn_io_make_dir_recursively(svn_fs_fs__path_rev_shard(fs, 0,
@@ -1905,6 +2438,8 @@ svn_fs_fs__create(svn_fs_t *fs,
   int format = SVN_FS_FS__FORMAT_NUMBER;
   int shard_size = SVN_FS_FS_DEFAULT_MAX_FILES_PER_DIR;
   svn_boolean_t log_addressing;
+  svn_boolean_t compressed_changes;
+  svn_boolean_t binary_properties;
 
   /* Process the given filesystem config. */
   if (fs->config)
@@ -1957,10 +2492,17 @@ svn_fs_fs__create(svn_fs_t *fs,
   log_addressing = svn_hash__get_bool(fs->config,
                                       SVN_FS_CONFIG_FSFS_LOG_ADDRESSING,
                                       TRUE);
+  compressed_changes
+    = svn_hash__get_bool(fs->config, SVN_FS_CONFIG_FSFS_COMPRESSED_CHANGES,
+                         FALSE);
+  binary_properties
+    = svn_hash__get_bool(fs->config, SVN_FS_CONFIG_FSFS_BINARY_PROPERTIES,
+                         FALSE);
 
   /* Actual FS creation. */
   SVN_ERR(svn_fs_fs__create_file_tree(fs, path, format, shard_size,
-                                      log_addressing, pool));
+                                      log_addressing, compressed_changes,
+                                      binary_properties, pool));
 
   /* This filesystem is ready.  Stamp it with a format number. */
   SVN_ERR(svn_fs_fs__write_format(fs, FALSE, pool));
@@ -2247,8 +2789,13 @@ change_rev_prop_body(void *baton, apr_pool_t *pool)
     return SVN_NO_ERROR;
 
   svn_hash_sets(table, cb->name, cb->value);
+  SVN_ERR(svn_fs_fs__set_revision_proplist(cb->fs, cb->rev, table, pool));
+
+  /* Keep dated revision lookups in line with the new date. */
+  if (strcmp(cb->name, SVN_PROP_REVISION_DATE) == 0)
+    SVN_ERR(svn_fs_fs__set_revision_date(cb->fs, cb->rev, cb->value, pool));
 
-  return svn_fs_fs__set_revision_proplist(cb->fs, cb->rev, table, pool);
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
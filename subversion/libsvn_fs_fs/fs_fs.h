@@ -134,8 +134,11 @@ svn_boolean_t svn_fs_fs__fs_supports_mergeinfo(svn_fs_t *fs);
 
 /* Under the repository db PATH, create a FSFS repository with FORMAT,
  * the given SHARD_SIZE. If USE_LOG_ADDRESSING is non-zero, repository
- * will use logical addressing. If not supported by the respective format,
- * the latter two parameters will be ignored. FS will be updated.
+ * will use logical addressing. If COMPRESSED_CHANGES is non-zero, new
+ * revisions will store compressed changed paths lists. If BINARY_PROPERTIES
+ * is non-zero, new property lists will use the binary encoding. If not
+ * supported by the respective format, the latter four parameters will be
+ * ignored. FS will be updated.
  *
  * The only file not being written is the 'format' file.  This allows
  * callers such as hotcopy to modify the contents before turning the
@@ -149,6 +152,8 @@ svn_fs_fs__create_file_tree(svn_fs_t *fs,
                             int format,
                             int shard_size,
                             svn_boolean_t use_log_addressing,
+                            svn_boolean_t compressed_changes,
+                            svn_boolean_t binary_properties,
                             apr_pool_t *pool);
 
 /* Create a fs_fs fileysystem referenced by FS at path PATH.  Get any
@@ -288,6 +293,16 @@ svn_fs_fs__get_node_origin(const svn_fs_id_t **origin_id,
 svn_error_t *
 svn_fs_fs__initialize_caches(svn_fs_t *fs, apr_pool_t *pool);
 
+/* Set *CLONE to a copy of FS that uses its own cache frontends and may
+   be used in another thread in parallel to FS.  All copies share the
+   global membuffer cache, which therefore must have been configured to
+   be thread-safe.  The clone has no access to the rep-cache and holds
+   no locks.  Allocate it in POOL. */
+svn_error_t *
+svn_fs_fs__clone_fs(svn_fs_t **clone,
+                    svn_fs_t *fs,
+                    apr_pool_t *pool);
+
 /* Initialize all transaction-local caches in FS according to the global
    cache settings and make TXN_ID part of their key space. Use POOL for
    allocations.
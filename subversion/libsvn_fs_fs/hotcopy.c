@@ -19,12 +19,18 @@
  *    under the License.
  * ====================================================================
  */
+#include <string.h>
+
+#include <apr_thread_proc.h>
+
 #include "svn_pools.h"
 #include "svn_path.h"
 #include "svn_dirent_uri.h"
+#include "svn_sorts.h"
 
 #include "fs_fs.h"
 #include "hotcopy.h"
+#include "lock.h"
 #include "util.h"
 #include "recovery.h"
 #include "revprops.h"
@@ -279,7 +285,6 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
 
 /* Copy a packed shard containing revision REV, and which contains
  * MAX_FILES_PER_DIR revisions, from SRC_FS to DST_FS.
- * Update *DST_MIN_UNPACKED_REV in case the shard is new in DST_FS.
  * Do not re-copy data which already exists in DST_FS.
  * Set *SKIPPED_P to FALSE only if at least one part of the shard
  * was copied, do not change the value in *SKIPPED_P otherwise.
@@ -287,7 +292,6 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
-                          svn_revnum_t *dst_min_unpacked_rev,
                           svn_fs_t *src_fs,
                           svn_fs_t *dst_fs,
                           svn_revnum_t rev,
@@ -357,15 +361,6 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
                                               scratch_pool));
     }
 
-  /* If necessary, update the min-unpacked rev file in the hotcopy. */
-  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
-    {
-      *dst_min_unpacked_rev = rev + max_files_per_dir;
-      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
-                                                *dst_min_unpacked_rev,
-                                                scratch_pool));
-    }
-
   return SVN_NO_ERROR;
 }
 
@@ -400,20 +395,28 @@ hotcopy_remove_files(svn_fs_t *dst_fs,
   svn_revnum_t rev;
   apr_pool_t *iterpool;
 
-  /* Pre-compute paths for initial shard. */
-  shard = apr_psprintf(scratch_pool, "%ld", start_rev / max_files_per_dir);
-  dst_subdir_shard = svn_dirent_join(dst_subdir, shard, scratch_pool);
-
   iterpool = svn_pool_create(scratch_pool);
   for (rev = start_rev; rev < end_rev; rev++)
     {
       svn_pool_clear(iterpool);
 
       /* If necessary, update paths for shard. */
-      if (rev != start_rev && rev % max_files_per_dir == 0)
+      if (rev == start_rev || rev % max_files_per_dir == 0)
         {
+          svn_node_kind_t kind;
+
           shard = apr_psprintf(iterpool, "%ld", rev / max_files_per_dir);
           dst_subdir_shard = svn_dirent_join(dst_subdir, shard, scratch_pool);
+
+          /* An incremental hotcopy into a destination that has been
+           * packed before finds most shard folders already gone.  Don't
+           * try to remove each of their files individually. */
+          SVN_ERR(svn_io_check_path(dst_subdir_shard, &kind, iterpool));
+          if (kind == svn_node_none)
+            {
+              rev += max_files_per_dir - 1 - rev % max_files_per_dir;
+              continue;
+            }
         }
 
       /* remove files for REV */
@@ -532,13 +535,377 @@ remove_folder(const char *path,
   return svn_error_trace(err);
 }
 
+/* The packed shard starting at revision REV, which contains
+ * MAX_FILES_PER_DIR revisions, has just been copied to DST_FS.  SKIPPED
+ * tells whether all of it already existed in DST_FS.  Checkpoint the
+ * shard in DST_FS by updating *DST_MIN_UNPACKED_REV and, unless DST_FS
+ * already contained the shard's revisions when it had DST_YOUNGEST as its
+ * youngest revision, 'current'.  Then remove the non-packed files that
+ * the shard replaces.  INCREMENTAL, NOTIFY_FUNC, NOTIFY_BATON,
+ * CANCEL_FUNC and CANCEL_BATON are as for hotcopy_revisions().
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_switch_to_packed_shard(svn_revnum_t *dst_min_unpacked_rev,
+                               svn_fs_t *dst_fs,
+                               svn_revnum_t dst_youngest,
+                               svn_revnum_t rev,
+                               int max_files_per_dir,
+                               svn_boolean_t skipped,
+                               svn_boolean_t incremental,
+                               svn_fs_hotcopy_notify_t notify_func,
+                               void* notify_baton,
+                               svn_cancel_func_t cancel_func,
+                               void* cancel_baton,
+                               apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
+  svn_revnum_t pack_end_rev = rev + max_files_per_dir - 1;
+
+  /* If necessary, update the min-unpacked rev file in the hotcopy. */
+  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
+    {
+      *dst_min_unpacked_rev = rev + max_files_per_dir;
+      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
+                                                *dst_min_unpacked_rev,
+                                                scratch_pool));
+    }
+
+  /* Whenever this pack did not previously exist in the destination,
+   * update 'current' to the most recent packed rev (so readers can see
+   * new revisions which arrived in this pack). */
+  if (pack_end_rev > dst_youngest)
+    {
+      SVN_ERR(svn_fs_fs__write_current(dst_fs, pack_end_rev, 0, 0,
+                                       scratch_pool));
+    }
+
+  /* When notifying about packed shards, make things simpler by either
+   * reporting a full revision range, i.e [pack start, pack end] or
+   * reporting nothing. There is one case when this approach might not
+   * be exact (incremental hotcopy with a pack replacing last unpacked
+   * revisions), but generally this is good enough. */
+  if (notify_func && !skipped)
+    notify_func(notify_baton, rev, pack_end_rev, scratch_pool);
+
+  /* Remove revision files which are now packed. */
+  if (incremental)
+    {
+      SVN_ERR(hotcopy_remove_rev_files(dst_fs, rev,
+                                       rev + max_files_per_dir,
+                                       max_files_per_dir, scratch_pool));
+      if (dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+        SVN_ERR(hotcopy_remove_revprop_files(dst_fs, rev,
+                                             rev + max_files_per_dir,
+                                             max_files_per_dir,
+                                             scratch_pool));
+    }
+
+  /* Now that all revisions have moved into the pack, the original
+   * rev dir can be removed. */
+  SVN_ERR(remove_folder(svn_fs_fs__path_rev_shard(dst_fs, rev,
+                                                  scratch_pool),
+                        cancel_func, cancel_baton, scratch_pool));
+  if (rev > 0 && dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+    SVN_ERR(remove_folder(svn_fs_fs__path_revprops_shard(dst_fs, rev,
+                                                         scratch_pool),
+                          cancel_func, cancel_baton, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Concurrent hotcopy.
+ *
+ * Copying the files of one shard does not touch the files of any other
+ * shard.  Hence, we can copy several shards at once, each in its own
+ * thread.  Only the file copying happens in the worker threads.  The
+ * calling thread checkpoints the shards in the destination, i.e. updates
+ * 'min-unpacked-rev' and 'current', strictly in shard order.  So, readers
+ * of the destination never see a revision before all earlier shards have
+ * been copied completely.
+ */
+
+/* Parameters shared by all shards of a concurrent hotcopy.
+ */
+typedef struct hotcopy_shards_baton_t
+{
+  svn_fs_t *src_fs;
+  svn_fs_t *dst_fs;
+  const char *src_revs_dir;
+  const char *dst_revs_dir;
+  const char *src_revprops_dir;
+  const char *dst_revprops_dir;
+  int max_files_per_dir;
+} hotcopy_shards_baton_t;
+
+/* A single shard being copied by a worker thread.
+ */
+typedef struct hotcopy_job_t
+{
+  /* First revision of the shard and the last revision to copy. */
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+
+  /* Whether the shard is packed in the source. */
+  svn_boolean_t packed;
+
+  /* Whether the files already existed in the destination.  One element
+   * per revision for non-packed shards and a single one for packed shards.
+   * Valid after the thread has been joined. */
+  svn_boolean_t *skipped;
+
+  const hotcopy_shards_baton_t *baton;
+
+  /* Root pool owned by this job.  Only the worker thread may use it
+   * until the thread has been joined. */
+  apr_pool_t *pool;
+
+  /* The worker thread.  NULL if it could not be started. */
+  apr_thread_t *thread;
+
+  /* Result of the copying.  Valid after the thread has been joined. */
+  svn_error_t *err;
+} hotcopy_job_t;
+
+/* Copy the files of the shard described by JOB.
+ */
+static svn_error_t *
+hotcopy_job_copy_files(hotcopy_job_t *job)
+{
+  const hotcopy_shards_baton_t *baton = job->baton;
+  apr_pool_t *iterpool;
+  svn_revnum_t rev;
+
+  if (job->packed)
+    return svn_error_trace(hotcopy_copy_packed_shard(
+                             &job->skipped[0], baton->src_fs, baton->dst_fs,
+                             job->start_rev, baton->max_files_per_dir,
+                             job->pool));
+
+  iterpool = svn_pool_create(job->pool);
+  for (rev = job->start_rev; rev <= job->end_rev; rev++)
+    {
+      svn_boolean_t *skipped = &job->skipped[rev - job->start_rev];
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(hotcopy_copy_shard_file(skipped,
+                                      baton->src_revs_dir,
+                                      baton->dst_revs_dir, rev,
+                                      baton->max_files_per_dir,
+                                      iterpool));
+      SVN_ERR(hotcopy_copy_shard_file(skipped,
+                                      baton->src_revprops_dir,
+                                      baton->dst_revprops_dir, rev,
+                                      baton->max_files_per_dir,
+                                      iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread function copying the shard of the hotcopy_job_t in DATA.
+ */
+static void * APR_THREAD_FUNC
+hotcopy_thread_func(apr_thread_t *tid,
+                    void *data)
+{
+  hotcopy_job_t *job = data;
+
+  job->err = hotcopy_job_copy_files(job);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Initialize JOB for copying the shard starting at revision START_REV,
+ * up to and including END_REV, as described by BATON and start its worker
+ * thread.  PACKED tells whether the shard is packed in the source.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+start_hotcopy_job(hotcopy_job_t *job,
+                  const hotcopy_shards_baton_t *baton,
+                  svn_revnum_t start_rev,
+                  svn_revnum_t end_rev,
+                  svn_boolean_t packed,
+                  apr_pool_t *scratch_pool)
+{
+  apr_status_t status;
+  int count = packed ? 1 : (int)(end_rev - start_rev + 1);
+  int i;
+
+  memset(job, 0, sizeof(*job));
+  job->start_rev = start_rev;
+  job->end_rev = end_rev;
+  job->packed = packed;
+  job->baton = baton;
+  job->pool = svn_pool_create(NULL);
+
+  job->skipped = apr_palloc(job->pool, count * sizeof(*job->skipped));
+  for (i = 0; i < count; i++)
+    job->skipped[i] = TRUE;
+
+  status = apr_thread_create(&job->thread, NULL, hotcopy_thread_func, job,
+                             scratch_pool);
+  if (status)
+    {
+      job->thread = NULL;
+      return svn_error_wrap_apr(status, _("Can't create thread"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the worker of JOB to finish and return its result.
+ */
+static svn_error_t *
+finish_hotcopy_job(hotcopy_job_t *job)
+{
+  svn_error_t *err;
+
+  if (job->thread)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, job->thread);
+      job->thread = NULL;
+    }
+
+  err = job->err;
+  job->err = SVN_NO_ERROR;
+
+  return err;
+}
+
+/* Release all resources held by JOB.
+ */
+static void
+release_hotcopy_job(hotcopy_job_t *job)
+{
+  if (job->pool)
+    {
+      svn_pool_destroy(job->pool);
+      job->pool = NULL;
+    }
+}
+
+/* Copy all shards of revisions up to SRC_YOUNGEST as described by BATON,
+ * using up to JOBS worker threads.  The shards below SRC_MIN_UNPACKED_REV
+ * are packed in the source.  Checkpoint the results in the destination
+ * in shard order.  *DST_MIN_UNPACKED_REV, DST_YOUNGEST, INCREMENTAL,
+ * NOTIFY_FUNC, NOTIFY_BATON, CANCEL_FUNC and CANCEL_BATON are as for
+ * hotcopy_revisions().  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+hotcopy_shards_concurrently(const hotcopy_shards_baton_t *baton,
+                            svn_revnum_t *dst_min_unpacked_rev,
+                            svn_revnum_t src_min_unpacked_rev,
+                            svn_revnum_t src_youngest,
+                            svn_revnum_t dst_youngest,
+                            svn_boolean_t incremental,
+                            int jobs,
+                            svn_fs_hotcopy_notify_t notify_func,
+                            void* notify_baton,
+                            svn_cancel_func_t cancel_func,
+                            void* cancel_baton,
+                            apr_pool_t *scratch_pool)
+{
+  int max_files_per_dir = baton->max_files_per_dir;
+  hotcopy_job_t *slots = apr_pcalloc(scratch_pool, jobs * sizeof(*slots));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t next_rev = 0;
+  svn_revnum_t rev;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* Fill all worker slots. */
+  while (!err && next_rev <= src_youngest
+         && next_rev / max_files_per_dir < jobs)
+    {
+      err = start_hotcopy_job(&slots[next_rev / max_files_per_dir], baton,
+                              next_rev,
+                              MIN(src_youngest,
+                                  next_rev + max_files_per_dir - 1),
+                              next_rev < src_min_unpacked_rev,
+                              scratch_pool);
+      next_rev += max_files_per_dir;
+    }
+
+  /* Process the results in shard order and keep the slots busy.
+   * After an error, we still need to wait for all started jobs. */
+  for (rev = 0; rev < next_rev; rev += max_files_per_dir)
+    {
+      hotcopy_job_t *job = &slots[(rev / max_files_per_dir) % jobs];
+      svn_pool_clear(iterpool);
+
+      if (err)
+        {
+          svn_error_clear(finish_hotcopy_job(job));
+          release_hotcopy_job(job);
+          continue;
+        }
+
+      err = finish_hotcopy_job(job);
+      if (!err && job->packed)
+        {
+          err = hotcopy_switch_to_packed_shard(dst_min_unpacked_rev,
+                                               baton->dst_fs, dst_youngest,
+                                               rev, max_files_per_dir,
+                                               job->skipped[0], incremental,
+                                               notify_func, notify_baton,
+                                               cancel_func, cancel_baton,
+                                               iterpool);
+        }
+      else if (!err)
+        {
+          svn_revnum_t copied_rev;
+
+          /* Whenever revisions of this shard did not previously exist in
+           * the destination, checkpoint the progress via 'current'. */
+          if (job->end_rev > dst_youngest)
+            err = svn_fs_fs__write_current(baton->dst_fs, job->end_rev,
+                                           0, 0, iterpool);
+
+          for (copied_rev = job->start_rev;
+               !err && notify_func && copied_rev <= job->end_rev;
+               copied_rev++)
+            if (!job->skipped[copied_rev - job->start_rev])
+              notify_func(notify_baton, copied_rev, copied_rev, iterpool);
+        }
+
+      release_hotcopy_job(job);
+
+      if (!err && cancel_func)
+        err = cancel_func(cancel_baton);
+
+      /* Re-use the slot for the next shard. */
+      if (!err && next_rev <= src_youngest)
+        {
+          err = start_hotcopy_job(job, baton, next_rev,
+                                  MIN(src_youngest,
+                                      next_rev + max_files_per_dir - 1),
+                                  next_rev < src_min_unpacked_rev,
+                                  scratch_pool);
+          next_rev += max_files_per_dir;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Copy the revision and revprop files (possibly sharded / packed) from
  * SRC_FS to DST_FS.  Do not re-copy data which already exists in DST_FS.
  * When copying packed or unpacked shards, checkpoint the result in DST_FS
  * for every shard by updating the 'current' file if necessary.  Assume
  * the >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT filesystem format without
- * global next-ID counters.  Indicate progress via the optional NOTIFY_FUNC
- * callback using NOTIFY_BATON.  Use POOL for temporary allocations.
+ * global next-ID counters.  Copy up to JOBS shards concurrently.
+ * Indicate progress via the optional NOTIFY_FUNC callback using
+ * NOTIFY_BATON.  Use POOL for temporary allocations.
  */
 static svn_error_t *
 hotcopy_revisions(svn_fs_t *src_fs,
@@ -546,6 +913,7 @@ hotcopy_revisions(svn_fs_t *src_fs,
                   svn_revnum_t src_youngest,
                   svn_revnum_t dst_youngest,
                   svn_boolean_t incremental,
+                  int jobs,
                   const char *src_revs_dir,
                   const char *dst_revs_dir,
                   const char *src_revprops_dir,
@@ -557,7 +925,6 @@ hotcopy_revisions(svn_fs_t *src_fs,
                   apr_pool_t *pool)
 {
   fs_fs_data_t *src_ffd = src_fs->fsap_data;
-  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
   int max_files_per_dir = src_ffd->max_files_per_dir;
   svn_revnum_t src_min_unpacked_rev;
   svn_revnum_t dst_min_unpacked_rev;
@@ -600,12 +967,37 @@ hotcopy_revisions(svn_fs_t *src_fs,
    * Copy the necessary rev files.
    */
 
+#if APR_HAS_THREADS
+  /* Copy several shards at once, if requested. */
+  if (jobs > 1 && max_files_per_dir && src_youngest >= max_files_per_dir)
+    {
+      hotcopy_shards_baton_t baton;
+
+      baton.src_fs = src_fs;
+      baton.dst_fs = dst_fs;
+      baton.src_revs_dir = src_revs_dir;
+      baton.dst_revs_dir = dst_revs_dir;
+      baton.src_revprops_dir = src_revprops_dir;
+      baton.dst_revprops_dir = dst_revprops_dir;
+      baton.max_files_per_dir = max_files_per_dir;
+
+      SVN_ERR(hotcopy_shards_concurrently(&baton, &dst_min_unpacked_rev,
+                                          src_min_unpacked_rev,
+                                          src_youngest, dst_youngest,
+                                          incremental, jobs,
+                                          notify_func, notify_baton,
+                                          cancel_func, cancel_baton, pool));
+      SVN_ERR_ASSERT(src_min_unpacked_rev == dst_min_unpacked_rev);
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
   iterpool = svn_pool_create(pool);
   /* First, copy packed shards. */
   for (rev = 0; rev < src_min_unpacked_rev; rev += max_files_per_dir)
     {
       svn_boolean_t skipped = TRUE;
-      svn_revnum_t pack_end_rev;
 
       svn_pool_clear(iterpool);
 
@@ -613,51 +1005,16 @@ hotcopy_revisions(svn_fs_t *src_fs,
         SVN_ERR(cancel_func(cancel_baton));
 
       /* Copy the packed shard. */
-      SVN_ERR(hotcopy_copy_packed_shard(&skipped, &dst_min_unpacked_rev,
-                                        src_fs, dst_fs,
+      SVN_ERR(hotcopy_copy_packed_shard(&skipped, src_fs, dst_fs,
                                         rev, max_files_per_dir,
                                         iterpool));
-
-      pack_end_rev = rev + max_files_per_dir - 1;
-
-      /* Whenever this pack did not previously exist in the destination,
-       * update 'current' to the most recent packed rev (so readers can see
-       * new revisions which arrived in this pack). */
-      if (pack_end_rev > dst_youngest)
-        {
-          SVN_ERR(svn_fs_fs__write_current(dst_fs, pack_end_rev, 0, 0,
-                                           iterpool));
-        }
-
-      /* When notifying about packed shards, make things simpler by either
-       * reporting a full revision range, i.e [pack start, pack end] or
-       * reporting nothing. There is one case when this approach might not
-       * be exact (incremental hotcopy with a pack replacing last unpacked
-       * revisions), but generally this is good enough. */
-      if (notify_func && !skipped)
-        notify_func(notify_baton, rev, pack_end_rev, iterpool);
-
-      /* Remove revision files which are now packed. */
-      if (incremental)
-        {
-          SVN_ERR(hotcopy_remove_rev_files(dst_fs, rev,
-                                           rev + max_files_per_dir,
-                                           max_files_per_dir, iterpool));
-          if (dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-            SVN_ERR(hotcopy_remove_revprop_files(dst_fs, rev,
-                                                 rev + max_files_per_dir,
-                                                 max_files_per_dir,
-                                                 iterpool));
-        }
-
-      /* Now that all revisions have moved into the pack, the original
-       * rev dir can be removed. */
-      SVN_ERR(remove_folder(svn_fs_fs__path_rev_shard(dst_fs, rev, iterpool),
-                            cancel_func, cancel_baton, iterpool));
-      if (rev > 0 && dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-        SVN_ERR(remove_folder(svn_fs_fs__path_revprops_shard(dst_fs, rev,
-                                                             iterpool),
-                              cancel_func, cancel_baton, iterpool));
+      SVN_ERR(hotcopy_switch_to_packed_shard(&dst_min_unpacked_rev, dst_fs,
+                                             dst_youngest, rev,
+                                             max_files_per_dir, skipped,
+                                             incremental,
+                                             notify_func, notify_baton,
+                                             cancel_func, cancel_baton,
+                                             iterpool));
     }
 
   if (cancel_func)
@@ -780,6 +1137,7 @@ struct hotcopy_body_baton {
   svn_fs_t *src_fs;
   svn_fs_t *dst_fs;
   svn_boolean_t incremental;
+  int jobs;
   svn_fs_hotcopy_notify_t notify_func;
   void *notify_baton;
   svn_cancel_func_t cancel_func;
@@ -928,7 +1286,8 @@ hotcopy_body(void *baton, apr_pool_t *pool)
   if (src_ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
     {
       SVN_ERR(hotcopy_revisions(src_fs, dst_fs, src_youngest, dst_youngest,
-                                incremental, src_revs_dir, dst_revs_dir,
+                                incremental, hbb->jobs,
+                                src_revs_dir, dst_revs_dir,
                                 src_revprops_dir, dst_revprops_dir,
                                 notify_func, notify_baton,
                                 cancel_func, cancel_baton, pool));
@@ -955,9 +1314,23 @@ hotcopy_body(void *baton, apr_pool_t *pool)
   src_subdir = svn_dirent_join(src_fs->path, PATH_LOCKS_DIR, pool);
   SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
   if (kind == svn_node_dir)
-    SVN_ERR(svn_io_copy_dir_recursively(src_subdir, dst_fs->path,
-                                        PATH_LOCKS_DIR, TRUE,
-                                        cancel_func, cancel_baton, pool));
+    {
+      const char *src_lock_db = svn_dirent_join(src_subdir, LOCK_DB_NAME,
+                                                pool);
+
+      SVN_ERR(svn_io_copy_dir_recursively(src_subdir, dst_fs->path,
+                                          PATH_LOCKS_DIR, TRUE,
+                                          cancel_func, cancel_baton, pool));
+
+      /* The lock database may have changed while we copied it.  Replace
+       * it with a consistent copy. */
+      SVN_ERR(svn_io_check_path(src_lock_db, &kind, pool));
+      if (kind == svn_node_file)
+        SVN_ERR(svn_sqlite__hotcopy(src_lock_db,
+                                    svn_dirent_join(dst_subdir, LOCK_DB_NAME,
+                                                    pool),
+                                    pool));
+    }
 
   /* Now copy the node-origins cache tree. */
   src_subdir = svn_dirent_join(src_fs->path, PATH_NODE_ORIGINS_DIR, pool);
@@ -974,18 +1347,34 @@ hotcopy_body(void *baton, apr_pool_t *pool)
 
   if (dst_ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT)
     {
+      svn_boolean_t copied = FALSE;
+      int i;
+
       /* Copy the rep cache and then remove entries for revisions
-       * that did not make it into the destination. */
-      src_subdir = svn_dirent_join(src_fs->path, REP_CACHE_DB_NAME, pool);
-      dst_subdir = svn_dirent_join(dst_fs->path, REP_CACHE_DB_NAME, pool);
-      SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
-      if (kind == svn_node_file)
+       * that did not make it into the destination.  The destination
+       * uses the same number of shards as the source as we just copied
+       * its config. */
+      for (i = 0; i < src_ffd->rep_cache_shards; ++i)
         {
-          SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
+          src_subdir = svn_fs_fs__path_rep_cache_shard(src_fs, i, pool);
+          dst_subdir = svn_dirent_join(dst_fs->path,
+                                       svn_dirent_basename(src_subdir, NULL),
+                                       pool);
+          SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+          if (kind == svn_node_file)
+            {
+              SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
 
-          /* The source might have r/o flags set on it - which would be
-             carried over to the copy. */
-          SVN_ERR(svn_io_set_file_read_write(dst_subdir, FALSE, pool));
+              /* The source might have r/o flags set on it - which would be
+                 carried over to the copy. */
+              SVN_ERR(svn_io_set_file_read_write(dst_subdir, FALSE, pool));
+              copied = TRUE;
+            }
+        }
+
+      if (copied)
+        {
+          dst_ffd->rep_cache_shards = src_ffd->rep_cache_shards;
           SVN_ERR(svn_fs_fs__del_rep_reference(dst_fs, src_youngest, pool));
         }
     }
@@ -995,6 +1384,10 @@ hotcopy_body(void *baton, apr_pool_t *pool)
     SVN_ERR(svn_io_dir_file_copy(src_fs->path, dst_fs->path,
                                  PATH_TXN_CURRENT, pool));
 
+  /* The copied revisions may contain zstd compressed deltas. */
+  if (src_ffd->zstd_deltas)
+    dst_ffd->zstd_deltas = TRUE;
+
   /* Hotcopied FS is complete. Stamp it with a format file. */
   SVN_ERR(svn_fs_fs__write_format(dst_fs, TRUE, pool));
 
@@ -1007,6 +1400,7 @@ svn_fs_fs__hotcopy(svn_fs_t *src_fs,
                    const char *src_path,
                    const char *dst_path,
                    svn_boolean_t incremental,
+                   int jobs,
                    svn_fs_hotcopy_notify_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -1058,6 +1452,8 @@ svn_fs_fs__hotcopy(svn_fs_t *src_fs,
       SVN_ERR(svn_fs_fs__create_file_tree(dst_fs, dst_path, src_ffd->format,
                                           src_ffd->max_files_per_dir,
                                           src_ffd->use_log_addressing,
+                                          src_ffd->compressed_changes,
+                                          src_ffd->binary_properties,
                                           pool));
 
       /* Copy the UUID.  Hotcopy destination receives a new instance ID, but
@@ -1082,6 +1478,7 @@ svn_fs_fs__hotcopy(svn_fs_t *src_fs,
   hbb.src_fs = src_fs;
   hbb.dst_fs = dst_fs;
   hbb.incremental = incremental;
+  hbb.jobs = jobs;
   hbb.notify_func = notify_func;
   hbb.notify_baton = notify_baton;
   hbb.cancel_func = cancel_func;
@@ -28,6 +28,7 @@
 
 #include "svn_private_config.h"
 
+#include "private/svn_io_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_temp_serializer.h"
@@ -417,6 +418,27 @@ packed_stream_get(apr_uint64_t *value,
   return SVN_NO_ERROR;
 }
 
+/* Tell the OS that we are about to read SIZE bytes of STREAM, starting at
+ * packed stream offset OFFSET, if FS is configured to prefetch block reads
+ * and that range spans more than one block.  Otherwise, buffered reads
+ * fetch the data block by block, which would be just as efficient.
+ */
+static void
+packed_stream_prefetch(svn_fs_fs__packed_number_stream_t *stream,
+                       svn_fs_t *fs,
+                       apr_off_t offset,
+                       apr_off_t size)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_off_t file_offset = offset + stream->stream_start;
+
+  if (   ffd->prefetch_block_reads
+      && size > 0
+      && file_offset / stream->block_size
+         != (file_offset + size - 1) / stream->block_size)
+    svn_io__file_prefetch(stream->file, file_offset, size);
+}
+
 /* Navigate STREAM to packed stream offset OFFSET.  There will be no checks
  * whether the given OFFSET is valid.
  */
@@ -1335,6 +1357,8 @@ get_l2p_page(l2p_page_t **page,
 
   /* open index file and select page */
   SVN_ERR(auto_open_l2p_index(rev_file, fs, start_revision));
+  packed_stream_prefetch(rev_file->l2p_stream, fs, table_entry->offset,
+                         table_entry->size);
   packed_stream_seek(rev_file->l2p_stream, table_entry->offset);
 
   /* initialize the page content */
@@ -1795,6 +1819,7 @@ svn_fs_fs__item_offset(apr_off_t *absolute_position,
   else if (svn_fs_fs__use_log_addressing(fs))
     {
       /* ordinary index lookup */
+      SVN_FS_FS__COUNT(svn_fs_fs__metric_l2p_lookups);
       SVN_ERR(l2p_index_lookup(absolute_position, fs, rev_file, revision,
                                item_index, scratch_pool));
     }
@@ -1816,6 +1841,147 @@ svn_fs_fs__item_offset(apr_off_t *absolute_position,
   return svn_error_trace(err);
 }
 
+/* Return TRUE if REV_FILE is not NULL and is the rev / pack file that
+ * contains REVISION in FS.
+ */
+static svn_boolean_t
+covers_revision(svn_fs_fs__revision_file_t *rev_file,
+                svn_fs_t *fs,
+                svn_revnum_t revision)
+{
+  return rev_file
+      && rev_file->is_packed == svn_fs_fs__is_packed_rev(fs, revision)
+      && rev_file->start_revision
+           == svn_fs_fs__packed_base_rev(fs, revision);
+}
+
+svn_error_t *
+svn_fs_fs__item_offsets(apr_array_header_t **offsets,
+                        svn_fs_t *fs,
+                        svn_fs_fs__revision_file_t *rev_file,
+                        const apr_array_header_t *items,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_fs__revision_file_t *file = rev_file;
+  l2p_header_t *header = NULL;
+  l2p_page_t *page = NULL;
+  svn_fs_fs__page_cache_key_t key = { 0 };
+  apr_pool_t *file_pool;
+  apr_pool_t *page_pool;
+  int i;
+
+  *offsets = apr_array_make(result_pool, items->nelts, sizeof(apr_off_t));
+
+  /* Physical addressing does not need any index lookups. */
+  if (!svn_fs_fs__use_log_addressing(fs))
+    {
+      for (i = 0; i < items->nelts; ++i)
+        {
+          const svn_fs_fs__id_part_t *item
+            = &APR_ARRAY_IDX(items, i, svn_fs_fs__id_part_t);
+          apr_off_t offset = (apr_off_t)item->number;
+
+          if (svn_fs_fs__is_packed_rev(fs, item->revision))
+            {
+              apr_off_t rev_offset;
+              SVN_ERR(svn_fs_fs__get_packed_offset(&rev_offset, fs,
+                                                   item->revision,
+                                                   scratch_pool));
+              offset += rev_offset;
+            }
+
+          APR_ARRAY_PUSH(*offsets, apr_off_t) = offset;
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+  file_pool = svn_pool_create(scratch_pool);
+  page_pool = svn_pool_create(scratch_pool);
+
+  for (i = 0; i < items->nelts; ++i)
+    {
+      const svn_fs_fs__id_part_t *item
+        = &APR_ARRAY_IDX(items, i, svn_fs_fs__id_part_t);
+      l2p_page_info_baton_t info_baton;
+      l2p_entry_baton_t page_baton;
+
+      /* switch to the rev / pack file and its index covering ITEM */
+      if (!covers_revision(file, fs, item->revision))
+        {
+          if (file && file != rev_file)
+            SVN_ERR(svn_fs_fs__close_revision_file(file));
+
+          header = NULL;
+          page = NULL;
+          svn_pool_clear(page_pool);
+          svn_pool_clear(file_pool);
+
+          if (covers_revision(rev_file, fs, item->revision))
+            file = rev_file;
+          else
+            SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file, fs,
+                                                     item->revision,
+                                                     file_pool,
+                                                     file_pool));
+        }
+
+      if (header == NULL)
+        SVN_ERR(get_l2p_header(&header, file, fs, item->revision,
+                               file_pool, page_pool));
+
+      /* locate the index page for ITEM */
+      info_baton.revision = item->revision;
+      info_baton.item_index = item->number;
+      SVN_ERR(l2p_page_info_copy(&info_baton, header, header->page_table,
+                                 header->page_table_index, scratch_pool));
+
+      /* Fetch and decode that page unless we already have it. */
+      assert(item->revision <= APR_UINT32_MAX);
+      if (   page == NULL
+          || key.revision != (apr_uint32_t)item->revision
+          || key.page != info_baton.page_no)
+        {
+          svn_boolean_t is_cached = FALSE;
+
+          svn_pool_clear(page_pool);
+          key.revision = (apr_uint32_t)item->revision;
+          key.is_packed = file->is_packed;
+          key.page = info_baton.page_no;
+
+          SVN_ERR(svn_cache__get((void **)&page, &is_cached,
+                                 ffd->l2p_page_cache, &key, page_pool));
+          if (!is_cached)
+            {
+              SVN_ERR(get_l2p_page(&page, file, fs,
+                                   info_baton.first_revision,
+                                   &info_baton.entry, page_pool));
+              SVN_ERR(svn_cache__set(ffd->l2p_page_cache, &key, page,
+                                     page_pool));
+            }
+        }
+
+      /* extract the offset from the page */
+      page_baton.revision = item->revision;
+      page_baton.item_index = item->number;
+      page_baton.page_offset = info_baton.page_offset;
+      SVN_ERR(l2p_page_get_entry(&page_baton, page, page->offsets,
+                                 scratch_pool));
+
+      APR_ARRAY_PUSH(*offsets, apr_off_t) = (apr_off_t)page_baton.offset;
+    }
+
+  if (file && file != rev_file)
+    SVN_ERR(svn_fs_fs__close_revision_file(file));
+
+  svn_pool_destroy(page_pool);
+  svn_pool_destroy(file_pool);
+
+  return SVN_NO_ERROR;
+}
+
 /*
  * phys-to-log index
  */
@@ -2463,6 +2629,8 @@ get_p2l_page(apr_array_header_t **entries,
 
   /* open index and navigate to page start */
   SVN_ERR(auto_open_p2l_index(rev_file, fs, start_revision));
+  packed_stream_prefetch(rev_file->p2l_stream, fs, start_offset,
+                         next_offset - start_offset);
   packed_stream_seek(rev_file->p2l_stream, start_offset);
 
   /* read rev file offset of the first page entry (all page entries will
@@ -2892,6 +3060,8 @@ svn_fs_fs__p2l_index_lookup(apr_array_header_t **entries,
   apr_array_header_t *result = apr_array_make(result_pool, 16,
                                               sizeof(svn_fs_fs__p2l_entry_t));
 
+  SVN_FS_FS__COUNT(svn_fs_fs__metric_p2l_lookups);
+
   /* Fetch entries page-by-page.  Since the p2l index is supposed to cover
    * every single byte in the rev / pack file - even unused sections -
    * every iteration must result in some progress. */
@@ -3001,6 +3171,7 @@ svn_fs_fs__p2l_entry_lookup(svn_fs_fs__p2l_entry_t **entry_p,
   p2l_page_info_baton_t page_info;
 
   *entry_p = NULL;
+  SVN_FS_FS__COUNT(svn_fs_fs__metric_p2l_lookups);
 
   /* look for this info in our cache */
   SVN_ERR(get_p2l_keys(&page_info, &key, rev_file, fs, revision, offset,
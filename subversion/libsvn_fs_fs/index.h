@@ -200,6 +200,26 @@ svn_fs_fs__item_offset(apr_off_t *absolute_position,
                        apr_uint64_t item_index,
                        apr_pool_t *scratch_pool);
 
+/* Batch version of svn_fs_fs__item_offset for committed revisions.
+ * ITEMS is an array of svn_fs_fs__id_part_t, each giving a revision and
+ * an item index within it.  Return the respective rev or pack file
+ * positions in *OFFSETS as an array of apr_off_t of the same length and
+ * order as ITEMS, allocated in RESULT_POOL.
+ *
+ * ITEMS does not need to be sorted but when given in (revision, item)
+ * order, each index header and index page will be fetched only once.
+ * REV_FILE will be used for all items it covers and may be NULL.  Other
+ * rev / pack files are opened as needed.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__item_offsets(apr_array_header_t **offsets,
+                        svn_fs_t *fs,
+                        svn_fs_fs__revision_file_t *rev_file,
+                        const apr_array_header_t *items,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
 /* Use the log-to-phys indexes in FS to determine the maximum item indexes
  * assigned to revision START_REV to START_REV + COUNT - 1.  That is a
  * close upper limit to the actual number of items in the respective revs.
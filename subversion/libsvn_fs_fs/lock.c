@@ -42,8 +42,11 @@
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_sqlite.h"
 #include "svn_private_config.h"
 
+#include "lock-db.h"
+
 /* Names of hash keys used to store a lock for writing to disk. */
 #define PATH_KEY "path"
 #define TOKEN_KEY "token"
@@ -58,6 +61,11 @@
    calculate a subdirectory in which to drop that file. */
 #define DIGEST_SUBDIR_LEN 3
 
+/* Schema version of the lock database. */
+#define LOCK_SCHEMA_FORMAT 1
+
+LOCK_DB_SQL_DECLARE_STATEMENTS(statements);
+
 
 
 /*** Generic helper functions. ***/
@@ -331,6 +339,205 @@ read_digest_file(apr_hash_t **children_p,
 }
 
 
+
+/*** Lock database functions. ***/
+
+/* Return the path of the lock database of the filesystem at FS_PATH. */
+static const char *
+path_lock_db(const char *fs_path,
+             apr_pool_t *result_pool)
+{
+  return svn_dirent_join_many(result_pool, fs_path, PATH_LOCKS_DIR,
+                              LOCK_DB_NAME, SVN_VA_NULL);
+}
+
+/* Body of get_lock_db().
+   Implements svn_atomic__init_once().init_func.
+ */
+static svn_error_t *
+open_lock_db(void *baton,
+             apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  int version;
+
+  /* The database only ever appears fully initialized, see import_locks(),
+     so never create it here. */
+  SVN_ERR(svn_sqlite__open(&sdb, path_lock_db(fs->path, pool),
+                           svn_sqlite__mode_readwrite, statements,
+                           0, NULL, 0,
+                           fs->pool, pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb, pool),
+                        sdb);
+  if (version != LOCK_SCHEMA_FORMAT)
+    return svn_error_compose_create(
+             svn_error_createf(SVN_ERR_FS_UNSUPPORTED_FORMAT, NULL,
+                               _("Unsupported lock database format %d"),
+                               version),
+             svn_sqlite__close(sdb));
+
+  /* This is used as a flag that the database is available so don't
+     set it earlier. */
+  ffd->lock_db = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SDB to the lock database of FS, opening it if necessary.  Set it
+   to NULL if the locks of FS are stored in digest files. */
+static svn_error_t *
+get_lock_db(svn_sqlite__db_t **sdb,
+            svn_fs_t *fs,
+            apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (! ffd->lock_db)
+    {
+      /* Whether the database exists determines where the locks are. */
+      const char *db_path = path_lock_db(fs->path, pool);
+      svn_node_kind_t kind;
+      svn_error_t *err;
+
+      SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+      if (kind != svn_node_file)
+        {
+          *sdb = NULL;
+          return SVN_NO_ERROR;
+        }
+
+      err = svn_atomic__init_once(&ffd->lock_db_opened, open_lock_db, fs,
+                                  pool);
+      SVN_ERR(svn_error_quick_wrapf(err,
+                                    _("Couldn't open lock database '%s'"),
+                                    svn_dirent_local_style(db_path, pool)));
+    }
+
+  *sdb = ffd->lock_db;
+  return SVN_NO_ERROR;
+}
+
+/* Close the lock database of FS, if it has been opened. */
+static svn_error_t *
+close_lock_db(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (ffd->lock_db)
+    {
+      svn_sqlite__db_t *sdb = ffd->lock_db;
+
+      ffd->lock_db = NULL;
+      ffd->lock_db_opened = 0;
+      SVN_ERR(svn_sqlite__close(sdb));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the lock described by the current row of STMT, which has been
+   produced by STMT_GET_LOCK or STMT_GET_LOCKS.  Allocate it in
+   RESULT_POOL. */
+static svn_lock_t *
+lock_from_row(svn_sqlite__stmt_t *stmt,
+              apr_pool_t *result_pool)
+{
+  svn_lock_t *lock = svn_lock_create(result_pool);
+
+  lock->path = svn_fspath__join("/", svn_sqlite__column_text(stmt, 0, NULL),
+                                result_pool);
+  lock->token = svn_sqlite__column_text(stmt, 1, result_pool);
+  lock->owner = svn_sqlite__column_text(stmt, 2, result_pool);
+  lock->comment = svn_sqlite__column_text(stmt, 3, result_pool);
+  lock->is_dav_comment = svn_sqlite__column_boolean(stmt, 4);
+  lock->creation_date = svn_sqlite__column_int64(stmt, 5);
+  lock->expiration_date = svn_sqlite__column_int64(stmt, 6);
+
+  return lock;
+}
+
+/* Set *LOCK_P to the lock on PATH stored in SDB or to NULL if there is
+   none.  Allocate the result in POOL. */
+static svn_error_t *
+db_get_lock(svn_lock_t **lock_p,
+            svn_sqlite__db_t *sdb,
+            const char *path,
+            apr_pool_t *pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", svn_fspath__skip_ancestor("/", path)));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *lock_p = have_row ? lock_from_row(stmt, pool) : NULL;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Set *LOCKS to an array of all 'svn_lock_t *' stored in SDB for PATH
+   and its descendants, sorted by path.  Allocate the result in POOL. */
+static svn_error_t *
+db_get_locks(apr_array_header_t **locks,
+             svn_sqlite__db_t *sdb,
+             const char *path,
+             apr_pool_t *pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  /* Fetch all rows before our callers get a chance to modify the table. */
+  *locks = apr_array_make(pool, 0, sizeof(svn_lock_t *));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_LOCKS));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", svn_fspath__skip_ancestor("/", path)));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      APR_ARRAY_PUSH(*locks, svn_lock_t *) = lock_from_row(stmt, pool);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Store LOCK in SDB, replacing any previous lock on the same path. */
+static svn_error_t *
+db_set_lock(svn_sqlite__db_t *sdb,
+            const svn_lock_t *lock)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "ssssdL",
+                            svn_fspath__skip_ancestor("/", lock->path),
+                            lock->token, lock->owner, lock->comment,
+                            lock->is_dav_comment ? 1 : 0,
+                            (apr_int64_t)lock->creation_date));
+
+  /* Leave the expiration date NULL for locks that don't expire. */
+  if (lock->expiration_date)
+    SVN_ERR(svn_sqlite__bind_int64(stmt, 7, lock->expiration_date));
+
+  return svn_error_trace(svn_sqlite__insert(NULL, stmt));
+}
+
+/* Remove the lock on PATH from SDB. */
+static svn_error_t *
+db_delete_lock(svn_sqlite__db_t *sdb,
+               const char *path)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_DELETE_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", svn_fspath__skip_ancestor("/", path)));
+
+  return svn_error_trace(svn_sqlite__update(NULL, stmt));
+}
+
+
 
 /*** Lock helper functions (path here are still FS paths, not on-disk
      schema-supporting paths) ***/
@@ -472,15 +679,24 @@ get_lock(svn_lock_t **lock_p,
          apr_pool_t *pool)
 {
   svn_lock_t *lock = NULL;
-  const char *digest_path;
-  svn_node_kind_t kind;
-
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
+  svn_sqlite__db_t *sdb;
 
   *lock_p = NULL;
-  if (kind != svn_node_none)
-    SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+  SVN_ERR(get_lock_db(&sdb, fs, pool));
+  if (sdb)
+    {
+      SVN_ERR(db_get_lock(&lock, sdb, path, pool));
+    }
+  else
+    {
+      const char *digest_path;
+      svn_node_kind_t kind;
+
+      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
+      SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
+      if (kind != svn_node_none)
+        SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+    }
 
   if (! lock)
     return must_exist ? SVN_FS__ERR_NO_SUCH_LOCK(fs, path) : SVN_NO_ERROR;
@@ -533,13 +749,52 @@ get_lock_helper(svn_fs_t *fs,
 }
 
 
+/* Like walk_locks() but for locks stored in the lock database SDB. */
+static svn_error_t *
+walk_db_locks(svn_fs_t *fs,
+              svn_sqlite__db_t *sdb,
+              const char *path,
+              svn_fs_get_locks_callback_t get_locks_func,
+              void *get_locks_baton,
+              svn_boolean_t have_write_lock,
+              apr_pool_t *pool)
+{
+  apr_array_header_t *locks;
+  apr_pool_t *subpool;
+  int i;
+
+  /* A single range query finds all locks in the subtree. */
+  SVN_ERR(db_get_locks(&locks, sdb, path, pool));
+
+  subpool = svn_pool_create(pool);
+  for (i = 0; i < locks->nelts; ++i)
+    {
+      svn_lock_t *lock = APR_ARRAY_IDX(locks, i, svn_lock_t *);
+      svn_pool_clear(subpool);
+
+      if (lock_expired(lock))
+        {
+          /* Only remove the lock if we have the write lock.
+             Read operations shouldn't change the filesystem. */
+          if (have_write_lock)
+            SVN_ERR(unlock_single(fs, lock, subpool));
+        }
+      else
+        {
+          SVN_ERR(get_locks_func(get_locks_baton, lock, subpool));
+        }
+    }
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
 /* A function that calls GET_LOCKS_FUNC/GET_LOCKS_BATON for
    all locks in and under PATH in FS.
    HAVE_WRITE_LOCK should be true if the caller (directly or indirectly)
    has the FS write lock. */
 static svn_error_t *
 walk_locks(svn_fs_t *fs,
-           const char *digest_path,
+           const char *path,
            svn_fs_get_locks_callback_t get_locks_func,
            void *get_locks_baton,
            svn_boolean_t have_write_lock,
@@ -549,8 +804,17 @@ walk_locks(svn_fs_t *fs,
   apr_hash_t *children;
   apr_pool_t *subpool;
   svn_lock_t *lock;
+  svn_sqlite__db_t *sdb;
+  const char *digest_path;
+
+  SVN_ERR(get_lock_db(&sdb, fs, pool));
+  if (sdb)
+    return svn_error_trace(walk_db_locks(fs, sdb, path, get_locks_func,
+                                         get_locks_baton, have_write_lock,
+                                         pool));
 
   /* First, send up any locks in the current digest file. */
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
   SVN_ERR(read_digest_file(&children, &lock, fs->path, digest_path, pool));
 
   if (lock && lock_expired(lock))
@@ -652,9 +916,7 @@ svn_fs_fs__allow_locked_operation(const char *path,
   if (recurse)
     {
       /* Discover all locks at or below the path. */
-      const char *digest_path;
-      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-      SVN_ERR(walk_locks(fs, digest_path, get_locks_callback,
+      SVN_ERR(walk_locks(fs, path, get_locks_callback,
                          fs, have_write_lock, pool));
     }
   else
@@ -697,6 +959,177 @@ schedule_index_update(apr_hash_t *updates,
     }
 }
 
+/* Remove all digest files of FS, leaving any lock database in place. */
+static svn_error_t *
+remove_digest_files(svn_fs_t *fs,
+                    apr_pool_t *pool)
+{
+  const char *locks_dir = svn_dirent_join(fs->path, PATH_LOCKS_DIR, pool);
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* The digest files live in sub-directories of LOCKS_DIR. */
+  SVN_ERR(svn_io_get_dirents3(&dirents, locks_dir, TRUE, pool, pool));
+  for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+
+      svn_pool_clear(iterpool);
+      if (dirent->kind == svn_node_dir)
+        SVN_ERR(svn_io_remove_dir2(svn_dirent_join(locks_dir, name, iterpool),
+                                   FALSE, NULL, NULL, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Add the unexpired locks of FS whose digest file names are the keys of
+   CHILDREN to SDB.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+insert_digest_locks(svn_sqlite__db_t *sdb,
+                    svn_fs_t *fs,
+                    apr_hash_t *children,
+                    apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  for (hi = apr_hash_first(scratch_pool, children); hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *digest = apr_hash_this_key(hi);
+      svn_lock_t *lock;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(read_digest_file(NULL, &lock, fs->path,
+                               digest_path_from_digest(fs->path, digest,
+                                                       iterpool),
+                               iterpool));
+      if (lock && !lock_expired(lock))
+        SVN_ERR(db_set_lock(sdb, lock));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Move all locks of FS from the digest files into a new lock database.
+   This assumes that the write lock is held. */
+static svn_error_t *
+import_locks(svn_fs_t *fs,
+             apr_pool_t *pool)
+{
+  const char *db_path = path_lock_db(fs->path, pool);
+  const char *tmp_path = apr_pstrcat(pool, db_path, ".tmp", SVN_VA_NULL);
+  const char *digest_path;
+  apr_hash_t *children;
+  svn_sqlite__db_t *sdb;
+
+  /* The digest file of the root lists every lock in the repository. */
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, "/", pool));
+  SVN_ERR(read_digest_file(&children, NULL, fs->path, digest_path, pool));
+
+  /* Fill the database under a temporary name such that readers never
+     see it incomplete. */
+  SVN_ERR(svn_fs_fs__ensure_dir_exists(svn_dirent_join(fs->path,
+                                                       PATH_LOCKS_DIR, pool),
+                                       fs->path, pool));
+  SVN_ERR(svn_io_remove_file2(tmp_path, TRUE, pool));
+  SVN_ERR(svn_sqlite__open(&sdb, tmp_path, svn_sqlite__mode_rwcreate,
+                           statements, 0, NULL, 0, pool, pool));
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb, STMT_CREATE_SCHEMA),
+                        sdb);
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__begin_transaction(sdb), sdb);
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__finish_transaction(
+                          sdb, insert_digest_locks(sdb, fs, children,
+                                                   pool)),
+                        sdb);
+  SVN_ERR(svn_sqlite__close(sdb));
+
+  SVN_ERR(svn_io_copy_perms(svn_fs_fs__path_current(fs, pool), tmp_path,
+                            pool));
+  SVN_ERR(svn_io_file_rename2(tmp_path, db_path, FALSE, pool));
+
+  /* The digest files are obsolete now. */
+  return svn_error_trace(remove_digest_files(fs, pool));
+}
+
+/* Move all locks of FS from the lock database SDB back into digest files
+   and remove the database.  This assumes that the write lock is held. */
+static svn_error_t *
+export_locks(svn_fs_t *fs,
+             svn_sqlite__db_t *sdb,
+             apr_pool_t *pool)
+{
+  apr_array_header_t *locks;
+  apr_hash_t *index_updates = apr_hash_make(pool);
+  apr_hash_index_t *hi;
+  const char *rev_0_path = svn_fs_fs__path_rev_absolute(fs, 0, pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(db_get_locks(&locks, sdb, "/", pool));
+
+  /* Digest files left behind by an interrupted import_locks() may list
+     locks that have been removed since. */
+  SVN_ERR(remove_digest_files(fs, pool));
+
+  /* Write the indices before the locks, like lock_body() does. */
+  for (i = 0; i < locks->nelts; ++i)
+    {
+      svn_lock_t *lock = APR_ARRAY_IDX(locks, i, svn_lock_t *);
+      if (!lock_expired(lock))
+        schedule_index_update(index_updates, lock->path, pool);
+    }
+
+  for (hi = apr_hash_first(pool, index_updates); hi; hi = apr_hash_next(hi))
+    {
+      const char *path = apr_hash_this_key(hi);
+      apr_array_header_t *children = apr_hash_this_val(hi);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(add_to_digest(fs->path, children, path, rev_0_path,
+                            iterpool));
+    }
+
+  for (i = 0; i < locks->nelts; ++i)
+    {
+      svn_lock_t *lock = APR_ARRAY_IDX(locks, i, svn_lock_t *);
+
+      svn_pool_clear(iterpool);
+      if (!lock_expired(lock))
+        SVN_ERR(set_lock(fs->path, lock, rev_0_path, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(close_lock_db(fs));
+  return svn_error_trace(svn_io_remove_file2(path_lock_db(fs->path, pool),
+                                             FALSE, pool));
+}
+
+/* Move the locks of FS into the lock database or out of it, if that is
+   not where the configuration wants them.  This assumes that the write
+   lock is held. */
+static svn_error_t *
+update_lock_store(svn_fs_t *fs,
+                  apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+
+  SVN_ERR(get_lock_db(&sdb, fs, pool));
+  if (ffd->lock_database && !sdb)
+    SVN_ERR(import_locks(fs, pool));
+  else if (!ffd->lock_database && sdb)
+    SVN_ERR(export_locks(fs, sdb, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* The effective arguments for lock_body() below. */
 struct lock_baton {
   svn_fs_t *fs;
@@ -823,6 +1256,25 @@ struct lock_info_t {
   svn_error_t *fs_err;
 };
 
+/* Store the locks of all INFOS, an array of 'struct lock_info_t', in SDB.
+   Skip entries that have no lock. */
+static svn_error_t *
+insert_lock_infos(svn_sqlite__db_t *sdb,
+                  apr_array_header_t *infos)
+{
+  int i;
+
+  for (i = 0; i < infos->nelts; ++i)
+    {
+      struct lock_info_t *info = &APR_ARRAY_IDX(infos, i,
+                                                struct lock_info_t);
+      if (info->lock)
+        SVN_ERR(db_set_lock(sdb, info->lock));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* The body of svn_fs_fs__lock(), which see.
 
    BATON is a 'struct lock_baton *' holding the effective arguments.
@@ -845,6 +1297,10 @@ lock_body(void *baton, apr_pool_t *pool)
   apr_hash_t *index_updates = apr_hash_make(pool);
   apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_sqlite__db_t *sdb;
+
+  SVN_ERR(update_lock_store(lb->fs, pool));
+  SVN_ERR(get_lock_db(&sdb, lb->fs, pool));
 
   /* Until we implement directory locks someday, we only allow locks
      on files. */
@@ -869,8 +1325,8 @@ lock_body(void *baton, apr_pool_t *pool)
                          youngest, iterpool));
 
       /* If no error occurred while pre-checking, schedule the index updates for
-         this path. */
-      if (!info.fs_err)
+         this path.  The lock database needs no indices. */
+      if (!info.fs_err && !sdb)
         schedule_index_update(index_updates, info.path, iterpool);
 
       APR_ARRAY_PUSH(lb->infos, struct lock_info_t) = info;
@@ -925,8 +1381,27 @@ lock_body(void *baton, apr_pool_t *pool)
           info->lock->creation_date = apr_time_now();
           info->lock->expiration_date = lb->expiration_date;
 
-          info->fs_err = set_lock(lb->fs->path, info->lock, rev_0_path,
-                                  iterpool);
+          if (!sdb)
+            info->fs_err = set_lock(lb->fs->path, info->lock, rev_0_path,
+                                    iterpool);
+        }
+    }
+
+  /* Store all new locks in a single database transaction.  If that fails,
+     none of them has been created. */
+  if (sdb)
+    {
+      svn_error_t *err = svn_sqlite__begin_transaction(sdb);
+      if (!err)
+        err = svn_sqlite__finish_transaction(sdb,
+                                             insert_lock_infos(sdb,
+                                                               lb->infos));
+      if (err)
+        {
+          for (i = 0; i < lb->infos->nelts; ++i)
+            APR_ARRAY_IDX(lb->infos, i, struct lock_info_t).lock = NULL;
+
+          return svn_error_trace(err);
         }
     }
 
@@ -975,6 +1450,25 @@ struct unlock_info_t {
   svn_boolean_t done;
 };
 
+/* Remove the locks of all INFOS, an array of 'struct unlock_info_t', from
+   SDB.  Skip entries that failed their checks. */
+static svn_error_t *
+delete_unlock_infos(svn_sqlite__db_t *sdb,
+                    apr_array_header_t *infos)
+{
+  int i;
+
+  for (i = 0; i < infos->nelts; ++i)
+    {
+      struct unlock_info_t *info = &APR_ARRAY_IDX(infos, i,
+                                                  struct unlock_info_t);
+      if (!info->fs_err)
+        SVN_ERR(db_delete_lock(sdb, info->path));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* The body of svn_fs_fs__unlock(), which see.
 
    BATON is a 'struct unlock_baton *' holding the effective arguments.
@@ -997,6 +1491,12 @@ unlock_body(void *baton, apr_pool_t *pool)
   apr_hash_t *indices_updates = apr_hash_make(pool);
   apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_sqlite__db_t *sdb;
+
+  /* Internal calls to remove expired locks don't change the lock store. */
+  if (!ub->skip_check)
+    SVN_ERR(update_lock_store(ub->fs, pool));
+  SVN_ERR(get_lock_db(&sdb, ub->fs, pool));
 
   SVN_ERR(ub->fs->vtable->youngest_rev(&youngest, ub->fs, pool));
   SVN_ERR(ub->fs->vtable->revision_root(&root, ub->fs, youngest, pool));
@@ -1019,13 +1519,28 @@ unlock_body(void *baton, apr_pool_t *pool)
                              iterpool));
 
       /* If no error occurred while pre-checking, schedule the index updates for
-         this path. */
-      if (!info.fs_err)
+         this path.  The lock database needs no indices. */
+      if (!info.fs_err && !sdb)
         schedule_index_update(indices_updates, info.path, iterpool);
 
       APR_ARRAY_PUSH(ub->infos, struct unlock_info_t) = info;
     }
 
+  /* Remove all locks from the database in a single transaction. */
+  if (sdb)
+    {
+      SVN_SQLITE__WITH_TXN(delete_unlock_infos(sdb, ub->infos), sdb);
+      for (i = 0; i < ub->infos->nelts; ++i)
+        {
+          struct unlock_info_t *info = &APR_ARRAY_IDX(ub->infos, i,
+                                                      struct unlock_info_t);
+          info->done = !info->fs_err;
+        }
+
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+
   rev_0_path = svn_fs_fs__path_rev_absolute(ub->fs, 0, pool);
 
   /* Unlike the lock_body(), we need to delete locks *before* we start to
@@ -1348,7 +1863,6 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
                      void *get_locks_baton,
                      apr_pool_t *pool)
 {
-  const char *digest_path;
   get_locks_filter_baton_t glfb;
 
   SVN_ERR(svn_fs__check_fs(fs, TRUE));
@@ -1359,9 +1873,8 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
   glfb.get_locks_func = get_locks_func;
   glfb.get_locks_baton = get_locks_baton;
 
-  /* Get the top digest path in our tree of interest, and then walk it. */
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(walk_locks(fs, digest_path, get_locks_filter_func, &glfb,
+  /* Walk our tree of interest. */
+  SVN_ERR(walk_locks(fs, path, get_locks_filter_func, &glfb,
                      FALSE, pool));
   return SVN_NO_ERROR;
 }
@@ -28,6 +28,9 @@ extern "C" {
 #endif /* __cplusplus */
 
 
+/* Name of the lock database within the locks directory.  If it exists,
+   it holds all locks of the repository instead of the digest files. */
+#define LOCK_DB_NAME "locks.db"
 
 /* These functions implement some of the calls in the FS loader
    library's fs vtables. */
@@ -24,6 +24,7 @@
 #include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_sorts.h"
+#include "svn_ctype.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
@@ -70,6 +71,18 @@
  * various flags. */
 #define MAX_CHANGE_LINE_LEN FSFS_MAX_PATH_LEN + 256
 
+/* Header line keyword of a LZ4 compressed block of changes. */
+#define CHANGES_BLOCK_LZ4  "lz4"
+
+/* Upper limit for the uncompressed size of a block of changes.  It is
+ * much larger than any block that we write but keeps corrupted data from
+ * making us allocate arbitrary amounts of memory. */
+#define MAX_CHANGES_BLOCK_SIZE 0x4000000
+
+/* First byte of a property list in the binary encoding.  Property lists
+ * in hash dump format start with a letter instead. */
+#define BINARY_PROPLIST_MARKER '\0'
+
 /* Convert the C string in *TEXT to a revision number and return it in *REV.
  * Overflows, negative values other than -1 and terminating characters other
  * than 0x20 or 0x0 will cause an error.  Set *TEXT to the first char after
@@ -291,30 +304,26 @@ svn_fs_fs__unparse_footer(apr_off_t l2p_offset,
                                                        scratch_pool));
 }
 
-/* Read the next entry in the changes record from file FILE and store
-   the resulting change in *CHANGE_P.  If there is no next record,
-   store NULL there.  Perform all allocations from POOL. */
+/* Parse the changes entry consisting of LINE and the (possibly empty)
+   COPYFROM_LINE.  Store the resulting change in *CHANGE_P.
+
+   If PREV_PATH is not NULL, the entry is part of a compressed block and
+   its path is given relative to PREV_PATH, i.e. the path of the previous
+   entry in the same block.  Update PREV_PATH to the path of the new entry
+   in that case.
+
+   Allocate the result in RESULT_POOL. */
 static svn_error_t *
 read_change(change_t **change_p,
-            svn_stream_t *stream,
-            apr_pool_t *result_pool,
-            apr_pool_t *scratch_pool)
+            svn_stringbuf_t *line,
+            svn_stringbuf_t *copyfrom_line,
+            svn_stringbuf_t *prev_path,
+            apr_pool_t *result_pool)
 {
-  svn_stringbuf_t *line;
-  svn_boolean_t eof = TRUE;
   change_t *change;
   char *str, *last_str, *kind_str;
   svn_fs_path_change2_t *info;
 
-  /* Default return value. */
-  *change_p = NULL;
-
-  SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, scratch_pool));
-
-  /* Check for a blank line. */
-  if (eof || (line->len == 0))
-    return SVN_NO_ERROR;
-
   change = apr_pcalloc(result_pool, sizeof(*change));
   info = &change->info;
   last_str = line->data;
@@ -421,10 +430,12 @@ read_change(change_t **change_p,
     }
 
   /* Get the mergeinfo-mod flag if given.  Otherwise, the next thing
-     is the path starting with a slash.  Also, we must initialize the
-     flag explicitly because 0 is not valid for a svn_tristate_t. */
+     is the path starting with a slash or, within compressed blocks, the
+     length of the prefix shared with the previous path.  Also, we must
+     initialize the flag explicitly because 0 is not valid for a
+     svn_tristate_t. */
   info->mergeinfo_mod = svn_tristate_unknown;
-  if (*last_str != '/')
+  if (prev_path ? !svn_ctype_isdigit(*last_str) : *last_str != '/')
     {
       str = svn_cstring_tokenize(" ", &last_str);
       if (str == NULL)
@@ -447,6 +458,23 @@ read_change(change_t **change_p,
     }
 
   /* Get the changed path. */
+  if (prev_path)
+    {
+      apr_uint64_t prefix_len;
+
+      str = svn_cstring_tokenize(" ", &last_str);
+      if (str == NULL)
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("Invalid changes line in rev-file"));
+
+      SVN_ERR(svn_cstring_strtoui64(&prefix_len, str, 0, prev_path->len,
+                                    10));
+      svn_stringbuf_remove(prev_path, (apr_size_t)prefix_len,
+                           prev_path->len);
+      svn_stringbuf_appendcstr(prev_path, last_str);
+      last_str = prev_path->data;
+    }
+
   if (!svn_fspath__is_canonical(last_str))
     return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
                             _("Invalid path in changes line"));
@@ -454,17 +482,16 @@ read_change(change_t **change_p,
   change->path.len = strlen(last_str);
   change->path.data = apr_pstrdup(result_pool, last_str);
 
-  /* Read the next line, the copyfrom line. */
-  SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, scratch_pool));
+  /* Parse the copyfrom line. */
   info->copyfrom_known = TRUE;
-  if (eof || line->len == 0)
+  if (copyfrom_line->len == 0)
     {
       info->copyfrom_rev = SVN_INVALID_REVNUM;
       info->copyfrom_path = NULL;
     }
   else
     {
-      last_str = line->data;
+      last_str = copyfrom_line->data;
       SVN_ERR(parse_revnum(&info->copyfrom_rev, (const char **)&last_str));
 
       if (!svn_fspath__is_canonical(last_str))
@@ -479,6 +506,153 @@ read_change(change_t **change_p,
   return SVN_NO_ERROR;
 }
 
+/* State of a reader for changed paths lists that may contain compressed
+   blocks of changes. */
+typedef struct changes_reader_t
+{
+  /* The changes list as stored in the rev / proto-rev / txn file. */
+  svn_stream_t *stream;
+
+  /* Buffers for the compressed and uncompressed data of the current
+     block.  NULL until the first block has been read. */
+  svn_stringbuf_t *compressed;
+  svn_stringbuf_t *block;
+
+  /* Offset of the next unread line within BLOCK. */
+  apr_size_t block_pos;
+
+  /* Path of the last entry read from the current block. */
+  svn_stringbuf_t *prev_path;
+
+  /* Pool for the buffers above. */
+  apr_pool_t *pool;
+} changes_reader_t;
+
+/* Return a reader for the changes list in STREAM allocated in POOL. */
+static changes_reader_t *
+changes_reader_create(svn_stream_t *stream,
+                      apr_pool_t *pool)
+{
+  changes_reader_t *reader = apr_pcalloc(pool, sizeof(*reader));
+  reader->stream = stream;
+  reader->pool = pool;
+
+  return reader;
+}
+
+/* Return TRUE if READER has not yet returned all entries of the current
+   compressed block. */
+static svn_boolean_t
+changes_reader_in_block(changes_reader_t *reader)
+{
+  return reader->block && reader->block_pos < reader->block->len;
+}
+
+/* Set *LINE to the next line of READER's current block, without the
+   terminating newline.  Allocate it in RESULT_POOL. */
+static void
+read_block_line(svn_stringbuf_t **line,
+                changes_reader_t *reader,
+                apr_pool_t *result_pool)
+{
+  const char *start = reader->block->data + reader->block_pos;
+  apr_size_t remaining = reader->block->len - reader->block_pos;
+  const char *eol = memchr(start, '\n', remaining);
+  apr_size_t len = eol ? eol - start : remaining;
+
+  *line = svn_stringbuf_ncreate(start, len, result_pool);
+  reader->block_pos += eol ? len + 1 : len;
+}
+
+/* Read the compressed block of changes described by the header line LINE
+   from READER's stream and make READER return its entries next.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_changes_block(changes_reader_t *reader,
+                   const char *line,
+                   apr_pool_t *scratch_pool)
+{
+  apr_uint64_t size;
+  apr_size_t len;
+
+  SVN_ERR(svn_cstring_strtoui64(&size, line, 0, MAX_CHANGES_BLOCK_SIZE, 10));
+  if (!reader->block)
+    {
+      reader->compressed = svn_stringbuf_create_empty(reader->pool);
+      reader->block = svn_stringbuf_create_empty(reader->pool);
+      reader->prev_path = svn_stringbuf_create_empty(reader->pool);
+    }
+
+  len = (apr_size_t)size;
+  svn_stringbuf_setempty(reader->compressed);
+  svn_stringbuf_ensure(reader->compressed, len);
+  SVN_ERR(svn_stream_read_full(reader->stream, reader->compressed->data,
+                               &len));
+  if (len != size)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Truncated block of changes in rev-file"));
+
+  reader->compressed->len = len;
+  SVN_ERR(svn__decompress_lz4(reader->compressed->data,
+                              reader->compressed->len, reader->block,
+                              MAX_CHANGES_BLOCK_SIZE));
+
+  svn_stringbuf_setempty(reader->prev_path);
+  reader->block_pos = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next entry in the changes list from READER and store the
+   resulting change in *CHANGE_P.  If there is no next entry, store NULL
+   there.  Allocate the result in RESULT_POOL and temporaries in
+   SCRATCH_POOL. */
+static svn_error_t *
+read_next_change(change_t **change_p,
+                 changes_reader_t *reader,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *line, *copyfrom_line;
+  svn_boolean_t eof = TRUE;
+
+  /* Default return value. */
+  *change_p = NULL;
+
+  while (!changes_reader_in_block(reader))
+    {
+      SVN_ERR(svn_stream_readline(reader->stream, &line, "\n", &eof,
+                                  scratch_pool));
+
+      /* Check for a blank line. */
+      if (eof || (line->len == 0))
+        return SVN_NO_ERROR;
+
+      if (strncmp(line->data, CHANGES_BLOCK_LZ4 " ",
+                  sizeof(CHANGES_BLOCK_LZ4)) != 0)
+        {
+          /* Plain entry.  Read the next line, the copyfrom line. */
+          SVN_ERR(svn_stream_readline(reader->stream, &copyfrom_line, "\n",
+                                      &eof, scratch_pool));
+          if (eof)
+            svn_stringbuf_setempty(copyfrom_line);
+
+          return svn_error_trace(read_change(change_p, line, copyfrom_line,
+                                             NULL, result_pool));
+        }
+
+      SVN_ERR(read_changes_block(reader,
+                                 line->data + sizeof(CHANGES_BLOCK_LZ4),
+                                 scratch_pool));
+    }
+
+  read_block_line(&line, reader, scratch_pool);
+  read_block_line(&copyfrom_line, reader, scratch_pool);
+
+  return svn_error_trace(read_change(change_p, line, copyfrom_line,
+                                     reader->prev_path, result_pool));
+}
+
 svn_error_t *
 svn_fs_fs__read_changes(apr_array_header_t **changes,
                         svn_stream_t *stream,
@@ -487,6 +661,7 @@ svn_fs_fs__read_changes(apr_array_header_t **changes,
                         apr_pool_t *scratch_pool)
 {
   apr_pool_t *iterpool;
+  changes_reader_t *reader = changes_reader_create(stream, scratch_pool);
 
   /* Pre-allocate enough room for most change lists.
      (will be auto-expanded as necessary).
@@ -498,12 +673,14 @@ svn_fs_fs__read_changes(apr_array_header_t **changes,
    */
   *changes = apr_array_make(result_pool, 63, sizeof(change_t *));
 
+  /* Never stop in the middle of a compressed block.  Callers continue
+     reading from the current stream position. */
   iterpool = svn_pool_create(scratch_pool);
-  for (; max_count > 0; --max_count)
+  for (; max_count > 0 || changes_reader_in_block(reader); --max_count)
     {
       change_t *change;
       svn_pool_clear(iterpool);
-      SVN_ERR(read_change(&change, stream, result_pool, iterpool));
+      SVN_ERR(read_next_change(&change, reader, result_pool, iterpool));
       if (!change)
         break;
  
@@ -523,13 +700,14 @@ svn_fs_fs__read_changes_incrementally(svn_stream_t *stream,
 {
   change_t *change;
   apr_pool_t *iterpool;
+  changes_reader_t *reader = changes_reader_create(stream, scratch_pool);
 
   iterpool = svn_pool_create(scratch_pool);
   do
     {
       svn_pool_clear(iterpool);
 
-      SVN_ERR(read_change(&change, stream, iterpool, iterpool));
+      SVN_ERR(read_next_change(&change, reader, iterpool, iterpool));
       if (change)
         SVN_ERR(change_receiver(change_receiver_baton, change, iterpool));
     }
@@ -543,6 +721,8 @@ svn_fs_fs__read_changes_incrementally(svn_stream_t *stream,
 
    Only include the node kind field if INCLUDE_NODE_KIND is true.  Only
    include the mergeinfo-mod field if INCLUDE_MERGEINFO_MODS is true.
+   If PREV_PATH is not NULL, write PATH relative to it as expected inside
+   compressed blocks and update PREV_PATH to PATH afterwards.
    All temporary allocations are in SCRATCH_POOL. */
 static svn_error_t *
 write_change_entry(svn_stream_t *stream,
@@ -550,6 +730,7 @@ write_change_entry(svn_stream_t *stream,
                    svn_fs_path_change2_t *change,
                    svn_boolean_t include_node_kind,
                    svn_boolean_t include_mergeinfo_mods,
+                   svn_stringbuf_t *prev_path,
                    apr_pool_t *scratch_pool)
 {
   const char *idstr;
@@ -603,6 +784,22 @@ write_change_entry(svn_stream_t *stream,
                                       ? FLAG_TRUE
                                       : FLAG_FALSE);
 
+  if (prev_path)
+    {
+      apr_size_t prefix_len = 0;
+      const char *suffix;
+
+      while (   prefix_len < prev_path->len
+             && path[prefix_len] == prev_path->data[prefix_len])
+        ++prefix_len;
+
+      suffix = path + prefix_len;
+      svn_stringbuf_remove(prev_path, prefix_len, prev_path->len);
+      svn_stringbuf_appendcstr(prev_path, suffix);
+      path = apr_psprintf(scratch_pool, "%" APR_SIZE_T_FMT " %s",
+                          prefix_len, suffix);
+    }
+
   buf = svn_stringbuf_createf(scratch_pool, "%s %s%s %s %s%s %s\n",
                               idstr, change_string, kind_string,
                               change->text_mod ? FLAG_TRUE : FLAG_FALSE,
@@ -666,7 +863,7 @@ svn_fs_fs__write_changes(svn_stream_t *stream,
 
       /* Write out the new entry into the final rev-file. */
       SVN_ERR(write_change_entry(stream, path, change, include_node_kinds,
-                                 include_mergeinfo_mods, iterpool));
+                                 include_mergeinfo_mods, NULL, iterpool));
     }
 
   if (terminate_list)
@@ -677,6 +874,69 @@ svn_fs_fs__write_changes(svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__write_compressed_changes(svn_stream_t *stream,
+                                    svn_fs_t *fs,
+                                    apr_hash_t *changes,
+                                    apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_boolean_t include_mergeinfo_mods =
+      ffd->format >= SVN_FS_FS__MIN_MERGEINFO_IN_CHANGED_FORMAT;
+  apr_array_header_t *sorted_changed_paths;
+  svn_stringbuf_t *block = svn_stringbuf_create_empty(scratch_pool);
+  svn_stringbuf_t *compressed = svn_stringbuf_create_empty(scratch_pool);
+  svn_stringbuf_t *prev_path = svn_stringbuf_create_empty(scratch_pool);
+  svn_stream_t *block_stream = svn_stream_from_stringbuf(block,
+                                                         scratch_pool);
+  int i;
+
+  /* Lexical order maximizes the prefixes shared between neighbours. */
+  sorted_changed_paths = svn_sort__hash(changes,
+                                        svn_sort_compare_items_lexically,
+                                        scratch_pool);
+
+  for (i = 0; i < sorted_changed_paths->nelts; ++i)
+    {
+      svn_fs_path_change2_t *change;
+      const char *path;
+
+      svn_pool_clear(iterpool);
+
+      change = APR_ARRAY_IDX(sorted_changed_paths, i, svn_sort__item_t).value;
+      path = APR_ARRAY_IDX(sorted_changed_paths, i, svn_sort__item_t).key;
+
+      SVN_ERR(write_change_entry(block_stream, path, change, TRUE,
+                                 include_mergeinfo_mods, prev_path,
+                                 iterpool));
+
+      /* Blocks match the granularity of svn_fs_fs__get_changes such that
+         each of its calls reads and decompresses exactly one block. */
+      if (   (i + 1) % SVN_FS_FS__CHANGES_BLOCK_SIZE == 0
+          || i + 1 == sorted_changed_paths->nelts)
+        {
+          const char *header;
+          apr_size_t len;
+
+          SVN_ERR(svn__compress_lz4(block->data, block->len, compressed));
+          header = apr_psprintf(iterpool, CHANGES_BLOCK_LZ4 " %"
+                                APR_SIZE_T_FMT "\n", compressed->len);
+
+          SVN_ERR(svn_stream_puts(stream, header));
+          len = compressed->len;
+          SVN_ERR(svn_stream_write(stream, compressed->data, &len));
+
+          svn_stringbuf_setempty(block);
+          svn_stringbuf_setempty(prev_path);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_stream_puts(stream, "\n"));
+}
+
 /* Given a revision file FILE that has been pre-positioned at the
    beginning of a Node-Rev header block, read in that header block and
    store it in the apr_hash_t HEADERS.  All allocations will be from
@@ -1242,3 +1502,146 @@ svn_fs_fs__write_rep_header(svn_fs_fs__rep_header_t *header,
 
   return svn_error_trace(svn_stream_puts(stream, text));
 }
+
+svn_error_t *
+svn_fs_fs__write_binary_proplist(svn_stream_t *stream,
+                                 apr_hash_t *proplist,
+                                 apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *sorted;
+  svn_stringbuf_t *buf;
+  unsigned char number[2 * SVN__MAX_ENCODED_UINT_LEN];
+  unsigned char *end;
+  apr_size_t len;
+  int i;
+
+  sorted = svn_sort__hash(proplist, svn_sort_compare_items_lexically,
+                          scratch_pool);
+
+  /* All of the list goes into a single buffer and write call. */
+  buf = svn_stringbuf_create_ensure(256, scratch_pool);
+  svn_stringbuf_appendbyte(buf, BINARY_PROPLIST_MARKER);
+  end = svn__encode_uint(number, sorted->nelts);
+  svn_stringbuf_appendbytes(buf, (const char *)number, end - number);
+
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                    svn_sort__item_t);
+      const svn_string_t *value = item->value;
+
+      end = svn__encode_uint(number, item->klen);
+      end = svn__encode_uint(end, value->len);
+      svn_stringbuf_appendbytes(buf, (const char *)number, end - number);
+
+      /* Terminate key and value such that they can be used in place. */
+      svn_stringbuf_appendbytes(buf, item->key, item->klen);
+      svn_stringbuf_appendbyte(buf, '\0');
+      svn_stringbuf_appendbytes(buf, value->data, value->len);
+      svn_stringbuf_appendbyte(buf, '\0');
+    }
+
+  len = buf->len;
+  return svn_error_trace(svn_stream_write(stream, buf->data, &len));
+}
+
+svn_error_t *
+svn_fs_fs__write_proplist(svn_stream_t *stream,
+                          svn_fs_t *fs,
+                          apr_hash_t *proplist,
+                          apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (ffd->binary_properties)
+    return svn_error_trace(svn_fs_fs__write_binary_proplist(stream,
+                                                            proplist,
+                                                            scratch_pool));
+
+  return svn_error_trace(svn_hash_write2(proplist, stream,
+                                         SVN_HASH_TERMINATOR, scratch_pool));
+}
+
+/* Parse the binary property list in DATA of LEN bytes into *PROPLIST,
+ * allocated in RESULT_POOL.  Keys and values will point into DATA. */
+static svn_error_t *
+parse_binary_proplist(apr_hash_t **proplist,
+                      const char *data,
+                      apr_size_t len,
+                      apr_pool_t *result_pool)
+{
+  const unsigned char *p = (const unsigned char *)data + 1;
+  const unsigned char *end = (const unsigned char *)data + len;
+  apr_uint64_t count, key_len, value_len;
+  apr_hash_t *hash;
+
+  p = svn__decode_uint(&count, p, end);
+  if (p == NULL || count > len)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Invalid binary property list"));
+
+  hash = svn_hash__make(result_pool);
+  for (; count > 0; --count)
+    {
+      svn_string_t *value;
+      const char *key;
+
+      p = svn__decode_uint(&key_len, p, end);
+      if (p)
+        p = svn__decode_uint(&value_len, p, end);
+
+      /* Both strings plus their terminators must fit into the rest. */
+      if (   p == NULL
+          || key_len >= (apr_uint64_t)(end - p)
+          || value_len >= (apr_uint64_t)(end - p) - key_len - 1
+          || p[key_len] != '\0'
+          || p[key_len + 1 + value_len] != '\0')
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("Invalid binary property list"));
+
+      key = (const char *)p;
+      p += key_len + 1;
+
+      value = apr_palloc(result_pool, sizeof(*value));
+      value->data = (const char *)p;
+      value->len = (apr_size_t)value_len;
+      p += value_len + 1;
+
+      apr_hash_set(hash, key, (apr_ssize_t)key_len, value);
+    }
+
+  if (p != end)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Invalid binary property list"));
+
+  *proplist = hash;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__parse_proplist(apr_hash_t **proplist,
+                          const svn_string_t *content,
+                          svn_boolean_t in_place,
+                          apr_pool_t *result_pool)
+{
+  svn_stream_t *stream;
+
+  if (content->len && content->data[0] == BINARY_PROPLIST_MARKER)
+    {
+      const char *data = in_place
+                       ? content->data
+                       : apr_pmemdup(result_pool, content->data,
+                                     content->len);
+
+      return svn_error_trace(parse_binary_proplist(proplist, data,
+                                                   content->len,
+                                                   result_pool));
+    }
+
+  *proplist = svn_hash__make(result_pool);
+  stream = svn_stream_from_string(content, result_pool);
+
+  return svn_error_trace(svn_hash_read2(*proplist, stream,
+                                        SVN_HASH_TERMINATOR, result_pool));
+}
@@ -37,6 +37,7 @@
  * - node revision
  * - representation (as in "text:" and "props:" lines)
  * - representation header ("PLAIN" and "DELTA" lines)
+ * - property lists
  */
 
 /* Given the last "few" bytes (should be at least 40) of revision REV in
@@ -98,8 +99,10 @@ svn_fs_fs__unparse_footer(apr_off_t l2p_offset,
                           apr_pool_t *scratch_pool);
 
 /* Read up to MAX_COUNT of the changes from STREAM and store them in
-   *CHANGES, allocated in RESULT_POOL.  Do temporary allocations in
-   SCRATCH_POOL. */
+   *CHANGES, allocated in RESULT_POOL.  Compressed blocks of changes are
+   always read completely, i.e. *CHANGES may contain more than MAX_COUNT
+   entries if the block boundaries don't line up with MAX_COUNT.
+   Do temporary allocations in SCRATCH_POOL. */
 svn_error_t *
 svn_fs_fs__read_changes(apr_array_header_t **changes,
                         svn_stream_t *stream,
@@ -139,6 +142,19 @@ svn_fs_fs__write_changes(svn_stream_t *stream,
                          svn_boolean_t terminate_list,
                          apr_pool_t *scratch_pool);
 
+/* Write the changed path info from CHANGES in filesystem FS to the
+   output stream STREAM as a complete, terminated changes list.  Sort the
+   entries by path and store them in LZ4 compressed blocks of up to
+   SVN_FS_FS__CHANGES_BLOCK_SIZE entries each, with every path given
+   relative to its predecessor within the same block.
+   Perform temporary allocations in SCRATCH_POOL.
+ */
+svn_error_t *
+svn_fs_fs__write_compressed_changes(svn_stream_t *stream,
+                                    svn_fs_t *fs,
+                                    apr_hash_t *changes,
+                                    apr_pool_t *scratch_pool);
+
 /* Read a node-revision from STREAM. Set *NODEREV to the new structure,
    allocated in RESULT_POOL. */
 svn_error_t *
@@ -233,3 +249,32 @@ svn_error_t *
 svn_fs_fs__write_rep_header(svn_fs_fs__rep_header_t *header,
                             svn_stream_t *stream,
                             apr_pool_t *scratch_pool);
+
+/* Write PROPLIST to STREAM in the binary property list encoding.  Entries
+ * are sorted by name such that equal lists produce equal output.
+ * Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__write_binary_proplist(svn_stream_t *stream,
+                                 apr_hash_t *proplist,
+                                 apr_pool_t *scratch_pool);
+
+/* Write PROPLIST to STREAM in the encoding selected for new property lists
+ * in FS, i.e. either as hash dump or in the binary encoding.
+ * Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__write_proplist(svn_stream_t *stream,
+                          svn_fs_t *fs,
+                          apr_hash_t *proplist,
+                          apr_pool_t *scratch_pool);
+
+/* Parse CONTENT, a property list either in hash dump format or in the
+ * binary encoding, and return it in *PROPLIST allocated in RESULT_POOL.
+ *
+ * Binary property lists are parsed in place if IN_PLACE is set: the keys
+ * and values in *PROPLIST will point into CONTENT, which must then remain
+ * valid as long as RESULT_POOL.  Otherwise, the data gets copied. */
+svn_error_t *
+svn_fs_fs__parse_proplist(apr_hash_t **proplist,
+                          const svn_string_t *content,
+                          svn_boolean_t in_place,
+                          apr_pool_t *result_pool);
@@ -0,0 +1,85 @@
+/* mergeinfo-db.sql -- schema for the mergeinfo index
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+-- STMT_CREATE_SCHEMA
+/* The node at PATH, relative to the repository root, has svn:mergeinfo
+   in all revisions from START_REVISION up to but not including
+   END_REVISION.  END_REVISION is NULL while it still has. */
+CREATE TABLE mergeinfo_paths (
+  path TEXT NOT NULL,
+  start_revision INTEGER NOT NULL,
+  end_revision INTEGER,
+  PRIMARY KEY (path, start_revision)
+  );
+
+/* The contiguous range of revisions for which the table above is
+   complete.  Holds at most one row. */
+CREATE TABLE indexed_range (
+  first_revision INTEGER NOT NULL,
+  last_revision INTEGER NOT NULL
+  );
+
+PRAGMA USER_VERSION = 1;
+
+
+-- STMT_RESET
+DELETE FROM mergeinfo_paths;
+DELETE FROM indexed_range;
+
+-- STMT_GET_INDEXED_RANGE
+SELECT first_revision, last_revision
+FROM indexed_range
+
+-- STMT_INSERT_INDEXED_RANGE
+INSERT INTO indexed_range (first_revision, last_revision)
+VALUES (?1, ?2)
+
+-- STMT_SET_INDEXED_RANGE
+UPDATE indexed_range
+SET first_revision = ?1, last_revision = ?2
+
+-- STMT_OPEN_MERGEINFO_PATH
+INSERT OR REPLACE INTO mergeinfo_paths (path, start_revision)
+SELECT ?1, ?2
+WHERE NOT EXISTS (SELECT 1 FROM mergeinfo_paths
+                  WHERE path = ?1 AND end_revision IS NULL)
+
+-- STMT_CLOSE_MERGEINFO_PATH
+UPDATE mergeinfo_paths
+SET end_revision = ?2
+WHERE path = ?1 AND end_revision IS NULL
+
+-- STMT_CLOSE_MERGEINFO_SUBTREE
+UPDATE mergeinfo_paths
+SET end_revision = ?2
+WHERE (path = ?1 OR IS_STRICT_DESCENDANT_OF(path, ?1))
+  AND end_revision IS NULL
+
+-- STMT_GET_MERGEINFO_DESCENDANTS
+SELECT path
+FROM mergeinfo_paths
+WHERE IS_STRICT_DESCENDANT_OF(path, ?1)
+  AND start_revision <= ?2
+  AND (end_revision IS NULL OR end_revision > ?2)
+ORDER BY path
@@ -0,0 +1,420 @@
+/* mergeinfo-index.c --- index of the nodes that have mergeinfo
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+
+#include "svn_private_config.h"
+
+#include "fs_fs.h"
+#include "fs.h"
+#include "tree.h"
+#include "mergeinfo-index.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_fs_util.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_sqlite.h"
+
+#include "mergeinfo-db.h"
+
+/* A few magic values */
+#define MERGEINFO_SCHEMA_FORMAT       1
+
+/* Maximum number of revisions other than the one just committed that a
+   single commit adds to the index.  If the index lags further behind,
+   it gets restarted from a crawl of the latest tree instead. */
+#define MAX_CATCH_UP_REVISIONS        100
+
+MERGEINFO_DB_SQL_DECLARE_STATEMENTS(statements);
+
+
+
+/** Helper functions. **/
+static APR_INLINE const char *
+path_mergeinfo_db(const char *fs_path,
+                  apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs_path, MERGEINFO_DB_NAME, result_pool);
+}
+
+/* Body of svn_fs_fs__open_mergeinfo_index().
+   Implements svn_atomic__init_once().init_func.
+ */
+static svn_error_t *
+open_mergeinfo_db(void *baton,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  const char *db_path;
+  int version;
+
+  db_path = path_mergeinfo_db(fs->path, pool);
+#ifndef WIN32
+  {
+    /* We want to extend the permissions that apply to the repository
+       as a whole when creating a new index and not simply default
+       to umask. */
+    svn_node_kind_t kind;
+
+    SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+    if (kind == svn_node_none)
+      {
+        const char *current = svn_fs_fs__path_current(fs, pool);
+        svn_error_t *err = svn_io_file_create_empty(db_path, pool);
+
+        if (err && !APR_STATUS_IS_EEXIST(err->apr_err))
+          /* A real error. */
+          return svn_error_trace(err);
+        else if (err)
+          /* Some other thread/process created the file. */
+          svn_error_clear(err);
+        else
+          /* We created the file. */
+          SVN_ERR(svn_io_copy_perms(current, db_path, pool));
+      }
+  }
+#endif
+  SVN_ERR(svn_sqlite__open(&sdb, db_path,
+                           svn_sqlite__mode_rwcreate, statements,
+                           0, NULL, 0,
+                           fs->pool, pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb, pool),
+                        sdb);
+  if (version < MERGEINFO_SCHEMA_FORMAT)
+    {
+      /* Must be 0 -- an uninitialized (no schema) database. Create
+         the schema. Results in schema version of 1.  */
+      SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb,
+                                                        STMT_CREATE_SCHEMA),
+                            sdb);
+    }
+
+  /* This is used as a flag that the database is available so don't
+     set it earlier. */
+  ffd->mergeinfo_db = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__open_mergeinfo_index(svn_fs_t *fs,
+                                apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err = svn_atomic__init_once(&ffd->mergeinfo_db_opened,
+                                           open_mergeinfo_db, fs, pool);
+  return svn_error_quick_wrapf(err,
+                               _("Couldn't open mergeinfo index '%s'"),
+                               svn_dirent_local_style(
+                                 path_mergeinfo_db(fs->path, pool),
+                                 pool));
+}
+
+svn_error_t *
+svn_fs_fs__close_mergeinfo_index(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (ffd->mergeinfo_db)
+    {
+      svn_sqlite__db_t *sdb = ffd->mergeinfo_db;
+
+      ffd->mergeinfo_db = NULL;
+      ffd->mergeinfo_db_opened = 0;
+      SVN_ERR(svn_sqlite__close(sdb));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__remove_mergeinfo_index(svn_fs_t *fs,
+                                  apr_pool_t *pool)
+{
+  SVN_ERR(svn_fs_fs__close_mergeinfo_index(fs));
+  SVN_ERR(svn_io_remove_file2(path_mergeinfo_db(fs->path, pool), TRUE,
+                              pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the range of revisions covered by the index in SDB into *FIRST
+   and *LAST.  Set *HAVE_RANGE to FALSE if the index is still empty. */
+static svn_error_t *
+get_indexed_range(svn_boolean_t *have_range,
+                  svn_revnum_t *first,
+                  svn_revnum_t *last,
+                  svn_sqlite__db_t *sdb)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_INDEXED_RANGE));
+  SVN_ERR(svn_sqlite__step(have_range, stmt));
+  if (*have_range)
+    {
+      *first = svn_sqlite__column_revnum(stmt, 0);
+      *last = svn_sqlite__column_revnum(stmt, 1);
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Execute the statement STMT_IDX in SDB for the repository root relative
+   path of the absolute PATH and REVISION. */
+static svn_error_t *
+update_path(svn_sqlite__db_t *sdb,
+            int stmt_idx,
+            const char *path,
+            svn_revnum_t revision)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, stmt_idx));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", svn_fspath__skip_ancestor("/", path),
+                            revision));
+
+  return svn_error_trace(svn_sqlite__update(NULL, stmt));
+}
+
+/* Record in SDB that the nodes under PATH in ROOT that have
+   mergeinfo start having it in revision START, unless they already have.
+   If INCLUDE_DESCENDANTS is FALSE, only consider PATH itself and record
+   that it stops having mergeinfo in REV if it has none.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+index_mergeinfo_paths(svn_sqlite__db_t *sdb,
+                      svn_fs_root_t *root,
+                      const char *path,
+                      svn_boolean_t include_descendants,
+                      svn_revnum_t start,
+                      apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *paths;
+  int i;
+
+  SVN_ERR(svn_fs_fs__get_mergeinfo_paths(&paths, root, path,
+                                         include_descendants,
+                                         scratch_pool, scratch_pool));
+  if (! include_descendants && paths->nelts == 0)
+    return svn_error_trace(update_path(sdb, STMT_CLOSE_MERGEINFO_PATH, path,
+                                       start));
+
+  for (i = 0; i < paths->nelts; i++)
+    SVN_ERR(update_path(sdb, STMT_OPEN_MERGEINFO_PATH,
+                        APR_ARRAY_IDX(paths, i, const char *), start));
+
+  return SVN_NO_ERROR;
+}
+
+/* Apply the mergeinfo changes of revision REV in FS to the index in SDB.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+index_revision(svn_fs_t *fs,
+               svn_sqlite__db_t *sdb,
+               svn_revnum_t rev,
+               apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  apr_hash_t *changes;
+  apr_array_header_t *sorted_changes;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(svn_fs_fs__revision_root(&root, fs, rev, scratch_pool));
+  SVN_ERR(svn_fs_fs__paths_changed(&changes, fs, rev, scratch_pool));
+
+  /* Process parents before their children, so that a change below a
+     copy in the same revision sees the copy already indexed. */
+  sorted_changes = svn_sort__hash(changes, svn_sort_compare_items_as_paths,
+                                  scratch_pool);
+  for (i = 0; i < sorted_changes->nelts; i++)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted_changes, i,
+                                              svn_sort__item_t);
+      const char *path = item->key;
+      svn_fs_path_change2_t *change = item->value;
+
+      svn_pool_clear(iterpool);
+
+      /* Whatever was at PATH before is gone. */
+      if (   change->change_kind == svn_fs_path_change_delete
+          || change->change_kind == svn_fs_path_change_replace)
+        SVN_ERR(update_path(sdb, STMT_CLOSE_MERGEINFO_SUBTREE, path, rev));
+
+      /* A new node, possibly copied along with mergeinfo on descendants. */
+      if (   change->change_kind == svn_fs_path_change_add
+          || change->change_kind == svn_fs_path_change_replace)
+        SVN_ERR(index_mergeinfo_paths(sdb, root, path, TRUE, rev,
+                                      iterpool));
+
+      /* An existing node whose mergeinfo may have changed. */
+      else if (   change->change_kind == svn_fs_path_change_modify
+               && change->prop_mod
+               && change->mergeinfo_mod != svn_tristate_false)
+        SVN_ERR(index_mergeinfo_paths(sdb, root, path, FALSE, rev,
+                                      iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Body of svn_fs_fs__update_mergeinfo_index() to be run within an
+   SQLite transaction on SDB. */
+static svn_error_t *
+update_index(svn_fs_t *fs,
+             svn_sqlite__db_t *sdb,
+             svn_revnum_t new_rev,
+             apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_range;
+  svn_revnum_t first, last;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(get_indexed_range(&have_range, &first, &last, sdb));
+
+  /* Replaying many revisions committed while the index was disabled
+     would take longer than starting over. */
+  if (have_range && new_rev - 1 - last > MAX_CATCH_UP_REVISIONS)
+    {
+      SVN_ERR(svn_sqlite__exec_statements(sdb, STMT_RESET));
+      have_range = FALSE;
+    }
+
+  if (! have_range)
+    {
+      svn_fs_root_t *root;
+
+      /* Start with the mergeinfo that exists right before NEW_REV. */
+      first = new_rev - 1;
+      last = new_rev - 1;
+
+      SVN_ERR(svn_fs_fs__revision_root(&root, fs, first, scratch_pool));
+      SVN_ERR(index_mergeinfo_paths(sdb, root, "/", TRUE, first,
+                                    scratch_pool));
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                        STMT_INSERT_INDEXED_RANGE));
+      SVN_ERR(svn_sqlite__bindf(stmt, "rr", first, last));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  while (last < new_rev)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(index_revision(fs, sdb, last + 1, iterpool));
+      ++last;
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_INDEXED_RANGE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "rr", first, last));
+
+  return svn_error_trace(svn_sqlite__update(NULL, stmt));
+}
+
+svn_error_t *
+svn_fs_fs__update_mergeinfo_index(svn_fs_t *fs,
+                                  svn_revnum_t new_rev,
+                                  apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+
+  if (! ffd->mergeinfo_db)
+    SVN_ERR(svn_fs_fs__open_mergeinfo_index(fs, pool));
+
+  /* Take the write lock right away.  Concurrent commits would otherwise
+     fail to upgrade their read locks after reading the indexed range. */
+  sdb = ffd->mergeinfo_db;
+  SVN_ERR(svn_sqlite__begin_immediate_transaction(sdb));
+  SVN_ERR(svn_sqlite__finish_transaction(sdb,
+                                         update_index(fs, sdb, new_rev,
+                                                      pool)));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_indexed_mergeinfo_paths(apr_array_header_t **paths,
+                                       svn_fs_t *fs,
+                                       svn_revnum_t rev,
+                                       const char *path,
+                                       apr_pool_t *result_pool,
+                                       apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_range, have_row;
+  svn_revnum_t first, last;
+
+  *paths = NULL;
+  if (! ffd->mergeinfo_index)
+    return SVN_NO_ERROR;
+
+  /* Don't create the index just for reading it. */
+  if (! ffd->mergeinfo_db)
+    {
+      svn_node_kind_t kind;
+
+      SVN_ERR(svn_io_check_path(path_mergeinfo_db(fs->path, scratch_pool),
+                                &kind, scratch_pool));
+      if (kind != svn_node_file)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(svn_fs_fs__open_mergeinfo_index(fs, scratch_pool));
+    }
+
+  sdb = ffd->mergeinfo_db;
+  SVN_ERR(get_indexed_range(&have_range, &first, &last, sdb));
+  if (! have_range || rev < first || rev > last)
+    return SVN_NO_ERROR;
+
+  path = svn_fs__canonicalize_abspath(path, scratch_pool);
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                    STMT_GET_MERGEINFO_DESCENDANTS));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", svn_fspath__skip_ancestor("/", path),
+                            rev));
+
+  *paths = apr_array_make(result_pool, 0, sizeof(const char *));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      APR_ARRAY_PUSH(*paths, const char *)
+        = svn_fspath__join("/", svn_sqlite__column_text(stmt, 0, NULL),
+                           result_pool);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
@@ -0,0 +1,81 @@
+/* mergeinfo-index.h : interface to the mergeinfo index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#ifndef SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H
+#define SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H
+
+#include "svn_error.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+#define MERGEINFO_DB_NAME        "mergeinfo.db"
+
+/* Open and create, if needed, the mergeinfo index database of FS.
+   Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__open_mergeinfo_index(svn_fs_t *fs,
+                                apr_pool_t *pool);
+
+/* Close the mergeinfo index database of FS. */
+svn_error_t *
+svn_fs_fs__close_mergeinfo_index(svn_fs_t *fs);
+
+/* Close and remove the mergeinfo index database of FS, if it exists.
+   The index will be rebuilt from the next commit onwards.  Use POOL for
+   temporary allocations. */
+svn_error_t *
+svn_fs_fs__remove_mergeinfo_index(svn_fs_t *fs,
+                                  apr_pool_t *pool);
+
+/* Add revision NEW_REV, which has just been committed to FS, to the
+   mergeinfo index of FS.  Also add the revisions since the last one
+   indexed, or restart the index at NEW_REV if there are too many of
+   them.  Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__update_mergeinfo_index(svn_fs_t *fs,
+                                  svn_revnum_t new_rev,
+                                  apr_pool_t *pool);
+
+/* Set *PATHS to the paths of all strict descendants of PATH in revision
+   REV of FS that have mergeinfo, according to the mergeinfo index.  Set
+   it to NULL if the index is disabled or does not cover REV.  Allocate
+   the result in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__get_indexed_mergeinfo_paths(apr_array_header_t **paths,
+                                       svn_fs_t *fs,
+                                       svn_revnum_t rev,
+                                       const char *path,
+                                       apr_pool_t *result_pool,
+                                       apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H */
@@ -22,9 +22,12 @@
 #include <assert.h>
 #include <string.h>
 
+#include <apr_thread_proc.h>
+
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 #include "svn_sorts.h"
+#include "svn_cache_config.h"
 #include "private/svn_temp_serializer.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
@@ -1726,6 +1729,7 @@ pack_phys_addressed(const char *pack_file_dir,
   svn_stream_t *manifest_stream;
   svn_revnum_t end_rev, rev;
   apr_pool_t *iterpool;
+  svn_fs__batch_fsync_t *batch;
 
   /* Some useful paths. */
   pack_file_path = svn_dirent_join(pack_file_dir, PATH_PACKED, pool);
@@ -1781,20 +1785,18 @@ pack_phys_addressed(const char *pack_file_dir,
 
   /* Close stream over APR file. */
   SVN_ERR(svn_stream_close(manifest_stream));
-
-  /* Ensure that pack file is written to disk. */
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(manifest_file, pool));
   SVN_ERR(svn_io_file_close(manifest_file, pool));
+  SVN_ERR(svn_io_file_close(pack_file, pool));
+
+  /* Ensure that pack and manifest file are written to disk. */
+  SVN_ERR(svn_fs__batch_fsync_create(&batch, flush_to_disk, pool));
+  SVN_ERR(svn_fs__batch_fsync_add_file(batch, manifest_file_path, pool));
+  SVN_ERR(svn_fs__batch_fsync_add_file(batch, pack_file_path, pool));
+  SVN_ERR(svn_fs__batch_fsync_run(batch, pool));
 
   /* disallow write access to the manifest file */
   SVN_ERR(svn_io_set_file_read_only(manifest_file_path, FALSE, iterpool));
 
-  /* Ensure that pack file is written to disk. */
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(pack_file, pool));
-  SVN_ERR(svn_io_file_close(pack_file, pool));
-
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
@@ -1925,6 +1927,11 @@ synced_pack_shard(void *baton,
   ffd->min_unpacked_rev
     = (svn_revnum_t)((pb->shard + 1) * ffd->max_files_per_dir);
 
+  /* Idle handles would keep the old rev files around.  Close them.
+   * Other processes will only notice upon their next cache miss. */
+  SVN_ERR(svn_fs_fs__file_handle_cache_purge(pb->fs,
+                                             ffd->min_unpacked_rev));
+
   /* Finally, remove the existing shard directories.
    * For revprops, clean up older obsolete shards as well as they might
    * have been left over from an interrupted FS upgrade. */
@@ -1957,6 +1964,33 @@ synced_pack_shard(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* The packed revision data for the shard described by BATON has been
+ * written.  Pack its revprops, switch the repository over to the packed
+ * shard and notify the caller.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+switch_to_packed_shard(struct pack_baton *baton,
+                       apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+
+  /* For newer repo formats, we only acquired the pack lock so far.
+     Before modifying the repo state by switching over to the packed
+     data, we need to acquire the global (write) lock. */
+  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
+    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
+                                       pool));
+  else
+    SVN_ERR(synced_pack_shard(baton, pool));
+
+  /* Notify caller we're done packing this shard. */
+  if (baton->notify_func)
+    SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
+                               svn_fs_pack_notify_end, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Pack the shard described by BATON.
  *
  * If for some reason we detect a partial packing already performed,
@@ -1992,23 +2026,223 @@ pack_shard(struct pack_baton *baton,
                          baton->max_mem, ffd->flush_to_disk,
                          baton->cancel_func, baton->cancel_baton, pool));
 
-  /* For newer repo formats, we only acquired the pack lock so far.
-     Before modifying the repo state by switching over to the packed
-     data, we need to acquire the global (write) lock. */
-  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
-    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
-                                       pool));
-  else
-    SVN_ERR(synced_pack_shard(baton, pool));
+  return svn_error_trace(switch_to_packed_shard(baton, pool));
+}
 
-  /* Notify caller we're starting to pack this shard. */
-  if (baton->notify_func)
-    SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
-                               svn_fs_pack_notify_end, pool));
+#if APR_HAS_THREADS
+
+/* Concurrent packing.
+ *
+ * Packing the revision data of a shard only reads the non-packed shard
+ * and writes the new pack directory.  It does not change the repository
+ * state.  Hence, we can do that for several shards at once, each in its
+ * own thread.  The calling thread then switches the repository over to
+ * the packed shards strictly in shard order, i.e. min-unpacked-rev only
+ * ever advances by one shard at a time just as with sequential packing.
+ *
+ * The FS-specific caches are not thread-safe.  So, every worker uses its
+ * own copy of the svn_fs_t with private cache frontends.  All of them
+ * share the same global membuffer cache, which therefore must have been
+ * configured to be thread-safe.
+ */
+
+/* A single shard being packed by a worker thread.
+ */
+typedef struct pack_job_t
+{
+  /* The shard to pack. */
+  apr_int64_t shard;
+
+  /* Paths of the pack directory to create and the shard to read. */
+  const char *rev_pack_file_dir;
+  const char *rev_shard_path;
+
+  /* Private copy of the filesystem to pack. */
+  svn_fs_t *fs;
+
+  /* Memory limit for this shard. */
+  apr_size_t max_mem;
+
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Root pool owned by this job.  Only the worker thread may use it
+   * until the thread has been joined. */
+  apr_pool_t *pool;
+
+  /* The worker thread.  NULL if it could not be started. */
+  apr_thread_t *thread;
+
+  /* Result of the packing.  Valid after the thread has been joined. */
+  svn_error_t *err;
+} pack_job_t;
+
+/* Thread function packing the revision data of the pack_job_t in DATA.
+ */
+static void * APR_THREAD_FUNC
+pack_thread_func(apr_thread_t *tid,
+                 void *data)
+{
+  pack_job_t *job = data;
+  fs_fs_data_t *ffd = job->fs->fsap_data;
+
+  job->err = pack_rev_shard(job->fs, job->rev_pack_file_dir,
+                            job->rev_shard_path, job->shard,
+                            ffd->max_files_per_dir, job->max_mem,
+                            ffd->flush_to_disk, job->cancel_func,
+                            job->cancel_baton, job->pool);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Initialize JOB for packing SHARD of the filesystem described by BATON,
+ * limiting its memory usage to MAX_MEM, and start its worker thread.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+start_pack_job(pack_job_t *job,
+               struct pack_baton *baton,
+               apr_int64_t shard,
+               apr_size_t max_mem,
+               apr_pool_t *scratch_pool)
+{
+  apr_status_t status;
+
+  memset(job, 0, sizeof(*job));
+  job->shard = shard;
+  job->max_mem = max_mem;
+  job->cancel_func = baton->cancel_func;
+  job->cancel_baton = baton->cancel_baton;
+  job->pool = svn_pool_create(NULL);
+
+  job->rev_pack_file_dir = svn_dirent_join(baton->revs_dir,
+                  apr_psprintf(job->pool,
+                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
+                               shard),
+                  job->pool);
+  job->rev_shard_path = svn_dirent_join(baton->revs_dir,
+                                        apr_psprintf(job->pool,
+                                                     "%" APR_INT64_T_FMT,
+                                                     shard),
+                                        job->pool);
+
+  SVN_ERR(svn_fs_fs__clone_fs(&job->fs, baton->fs, job->pool));
+
+  status = apr_thread_create(&job->thread, NULL, pack_thread_func, job,
+                             scratch_pool);
+  if (status)
+    {
+      job->thread = NULL;
+      return svn_error_wrap_apr(status, _("Can't create thread"));
+    }
 
   return SVN_NO_ERROR;
 }
 
+/* Wait for the worker of JOB to finish and return its result.  Release
+ * all resources held by JOB.
+ */
+static svn_error_t *
+finish_pack_job(pack_job_t *job)
+{
+  svn_error_t *err = job->err;
+
+  if (job->thread)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, job->thread);
+      err = job->err;
+    }
+
+  job->err = SVN_NO_ERROR;
+  job->thread = NULL;
+  if (job->pool)
+    {
+      svn_pool_destroy(job->pool);
+      job->pool = NULL;
+    }
+
+  return err;
+}
+
+/* Pack the shards FIRST_SHARD up to but not including END_SHARD of the
+ * filesystem described by BATON, using up to JOBS worker threads.  The
+ * memory limit in BATON gets split evenly between the workers.  Shards
+ * get switched over to their packed form and reported in shard order.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+pack_shards_concurrently(struct pack_baton *baton,
+                         apr_int64_t first_shard,
+                         apr_int64_t end_shard,
+                         int jobs,
+                         apr_pool_t *scratch_pool)
+{
+  pack_job_t *slots = apr_pcalloc(scratch_pool, jobs * sizeof(*slots));
+  apr_size_t max_mem = MAX(baton->max_mem / jobs, 1);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_int64_t next_shard = first_shard;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* Fill all worker slots. */
+  while (!err && next_shard < end_shard && next_shard < first_shard + jobs)
+    {
+      err = start_pack_job(&slots[next_shard - first_shard], baton,
+                           next_shard, max_mem, scratch_pool);
+      ++next_shard;
+    }
+
+  /* Process the results in shard order and keep the slots busy.
+   * After an error, we still need to wait for all started jobs. */
+  for (baton->shard = first_shard;
+       baton->shard < next_shard;
+       baton->shard++)
+    {
+      pack_job_t *job = &slots[(baton->shard - first_shard) % jobs];
+      svn_pool_clear(iterpool);
+
+      /* Notify caller we're starting to pack this shard. */
+      if (!err && baton->notify_func)
+        err = baton->notify_func(baton->notify_baton, baton->shard,
+                                 svn_fs_pack_notify_start, iterpool);
+
+      if (err)
+        {
+          svn_error_clear(finish_pack_job(job));
+          continue;
+        }
+
+      err = finish_pack_job(job);
+      if (!err)
+        {
+          baton->rev_shard_path = svn_dirent_join(baton->revs_dir,
+                                    apr_psprintf(iterpool,
+                                                 "%" APR_INT64_T_FMT,
+                                                 baton->shard),
+                                    iterpool);
+          err = switch_to_packed_shard(baton, iterpool);
+        }
+
+      if (!err && baton->cancel_func)
+        err = baton->cancel_func(baton->cancel_baton);
+
+      /* Re-use the slot for the next shard. */
+      if (!err && next_shard < end_shard)
+        {
+          err = start_pack_job(job, baton, next_shard, max_mem,
+                               scratch_pool);
+          ++next_shard;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Read the youngest rev and the first non-packed rev info for FS from disk.
    Set *FULLY_PACKED when there is no completed unpacked shard.
    Use SCRATCH_POOL for temporary allocations.
@@ -2057,7 +2291,7 @@ pack_body(void *baton,
 {
   struct pack_baton *pb = baton;
   fs_fs_data_t *ffd = pb->fs->fsap_data;
-  apr_int64_t completed_shards;
+  apr_int64_t first_shard, completed_shards;
   apr_pool_t *iterpool;
   svn_boolean_t fully_packed;
 
@@ -2074,14 +2308,29 @@ pack_body(void *baton,
       return SVN_NO_ERROR;
     }
 
+  first_shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
   completed_shards = (ffd->youngest_rev_cache + 1) / ffd->max_files_per_dir;
   pb->revs_dir = svn_dirent_join(pb->fs->path, PATH_REVS_DIR, pool);
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
     pb->revsprops_dir = svn_dirent_join(pb->fs->path, PATH_REVPROPS_DIR,
                                         pool);
 
+#if APR_HAS_THREADS
+  /* Pack several shards at once, if that has been enabled and the caches
+     can be used safely from multiple threads. */
+  if (   ffd->pack_jobs > 1
+      && completed_shards - first_shard > 1
+      && !svn_cache_config_get()->single_threaded)
+    {
+      int jobs = (int)MIN(ffd->pack_jobs, completed_shards - first_shard);
+      return svn_error_trace(pack_shards_concurrently(pb, first_shard,
+                                                      completed_shards,
+                                                      jobs, pool));
+    }
+#endif
+
   iterpool = svn_pool_create(pool);
-  for (pb->shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+  for (pb->shard = first_shard;
        pb->shard < completed_shards;
        pb->shard++)
     {
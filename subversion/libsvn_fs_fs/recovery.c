@@ -28,6 +28,9 @@
 
 #include "index.h"
 #include "low_level.h"
+#include "changed-paths-index.h"
+#include "revision-dates.h"
+#include "mergeinfo-index.h"
 #include "rep-cache.h"
 #include "revprops.h"
 #include "util.h"
@@ -482,6 +485,12 @@ recover_body(void *baton, apr_pool_t *pool)
         SVN_ERR(svn_fs_fs__del_rep_reference(fs, max_rev, pool));
     }
 
+  /* The indexes may list revisions that are gone now and would then be
+     committed anew.  Start over with fresh indexes. */
+  SVN_ERR(svn_fs_fs__remove_changed_paths_index(fs, pool));
+  SVN_ERR(svn_fs_fs__remove_mergeinfo_index(fs, pool));
+  SVN_ERR(svn_fs_fs__remove_revision_dates(fs, pool));
+
   /* Now store the discovered youngest revision, and the next IDs if
      relevant, in a new 'current' file. */
   return svn_fs_fs__write_current(fs, max_rev, next_node_id, next_copy_id,
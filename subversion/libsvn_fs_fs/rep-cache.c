@@ -39,6 +39,16 @@
 /* A few magic values */
 #define REP_CACHE_SCHEMA_FORMAT   1
 
+/* The rep-cache filter is a Bloom filter with FILTER_BITS_PER_KEY bits
+   for each of the keys it has been sized for.  We use FILTER_HASH_COUNT
+   hash functions, each being a 32 bit slice of the SHA1 digest.  This
+   gives a false positive rate of about 2% when the filter is full. */
+#define FILTER_BITS_PER_KEY       8
+#define FILTER_HASH_COUNT         5
+
+/* Minimum number of keys to size the filter for. */
+#define FILTER_MIN_CAPACITY       1024
+
 REP_CACHE_DB_SQL_DECLARE_STATEMENTS(statements);
 
 
@@ -51,34 +61,339 @@ path_rep_cache_db(const char *fs_path,
   return svn_dirent_join(fs_path, REP_CACHE_DB_NAME, result_pool);
 }
 
+const char *
+svn_fs_fs__path_rep_cache_shard(svn_fs_t *fs,
+                                int shard,
+                                apr_pool_t *result_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  if (ffd->rep_cache_shards <= 1)
+    return path_rep_cache_db(fs->path, result_pool);
+
+  return svn_dirent_join(fs->path,
+                         apr_psprintf(result_pool,
+                                      REP_CACHE_SHARD_DB_NAME_FORMAT, shard),
+                         result_pool);
+}
+
+/* Return the rep-cache database in FS that holds the entry for the SHA1
+   DIGEST.  The rep-cache must have been opened. */
+static svn_sqlite__db_t *
+shard_db(svn_fs_t *fs,
+         const unsigned char *digest)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  return ffd->rep_cache_db[svn_fs_fs__rep_cache_shard(fs, digest)];
+}
+
 
-/** Library-private API's. **/
+/** The rep-cache filter. **/
 
-/* Body of svn_fs_fs__open_rep_cache().
-   Implements svn_atomic__init_once().init_func.
- */
+/* A Bloom filter over the SHA1 keys in the rep-cache, shared between all
+   svn_fs_t instances of the same repository within this process.
+
+   The filter is built from the database upon first use and updated
+   whenever this process adds an entry.  It is only authoritative as long
+   as we see all additions, i.e. as long as no other process commits.
+   Entries may get removed from the database (e.g. by recovery) without
+   the filter noticing; that only causes unnecessary database lookups. */
+struct fs_fs_rep_filter_t
+{
+  /* Synchronises all access to the members below. */
+  svn_mutex__t *lock;
+
+  /* Holds BITS.  Will be cleared when the filter gets rebuilt. */
+  apr_pool_t *pool;
+
+  /* BIT_COUNT bits.  NULL if the filter still needs to be built. */
+  unsigned char *bits;
+  apr_size_t bit_count;
+
+  /* Number of keys added to the filter and the number of keys that it
+     has been sized for.  COUNT exceeding CAPACITY triggers a rebuild. */
+  apr_size_t count;
+  apr_size_t capacity;
+
+  /* All rep-cache entries up to this revision have been added. */
+  svn_revnum_t revision;
+
+  /* Set once the filter can no longer be trusted. */
+  svn_boolean_t disabled;
+};
+
+svn_error_t *
+svn_fs_fs__rep_filter_create(fs_fs_rep_filter_t **filter_p,
+                             apr_pool_t *result_pool)
+{
+  fs_fs_rep_filter_t *filter = apr_pcalloc(result_pool, sizeof(*filter));
+
+  SVN_ERR(svn_mutex__init(&filter->lock, TRUE, result_pool));
+  filter->pool = svn_pool_create(result_pool);
+  filter->revision = SVN_INVALID_REVNUM;
+
+  *filter_p = filter;
+  return SVN_NO_ERROR;
+}
+
+/* Return the bit position in FILTER for the I-th hash function applied to
+   the SHA1 DIGEST. */
+static apr_size_t
+filter_bit(const fs_fs_rep_filter_t *filter,
+           const unsigned char *digest,
+           int i)
+{
+  const unsigned char *slice = digest + 4 * i;
+  apr_uint32_t value = (apr_uint32_t)slice[0]
+                     | ((apr_uint32_t)slice[1] << 8)
+                     | ((apr_uint32_t)slice[2] << 16)
+                     | ((apr_uint32_t)slice[3] << 24);
+
+  return value % filter->bit_count;
+}
+
+/* Add the SHA1 DIGEST to the built FILTER. */
+static void
+filter_add(fs_fs_rep_filter_t *filter,
+           const unsigned char *digest)
+{
+  int i;
+  for (i = 0; i < FILTER_HASH_COUNT; ++i)
+    {
+      apr_size_t bit = filter_bit(filter, digest, i);
+      filter->bits[bit / 8] |= (unsigned char)(1 << (bit % 8));
+    }
+
+  ++filter->count;
+}
+
+/* Return TRUE if the SHA1 DIGEST may have been added to the built FILTER
+   and FALSE, if it certainly has not. */
+static svn_boolean_t
+filter_contains(const fs_fs_rep_filter_t *filter,
+                const unsigned char *digest)
+{
+  int i;
+  for (i = 0; i < FILTER_HASH_COUNT; ++i)
+    {
+      apr_size_t bit = filter_bit(filter, digest, i);
+      if ((filter->bits[bit / 8] & (1 << (bit % 8))) == 0)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Add all keys in the rep-cache database SDB to the built FILTER.
+   Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
-open_rep_cache(void *baton,
-               apr_pool_t *pool)
+filter_add_shard(fs_fs_rep_filter_t *filter,
+                 svn_sqlite__db_t *sdb,
+                 apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int iterations = 0;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_ALL_HASHES));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      svn_checksum_t *checksum;
+      svn_error_t *err;
+
+      /* Clear ITERPOOL occasionally. */
+      if (iterations++ % 16 == 0)
+        svn_pool_clear(iterpool);
+
+      err = svn_checksum_parse_hex(&checksum, svn_checksum_sha1,
+                                   svn_sqlite__column_text(stmt, 0, iterpool),
+                                   iterpool);
+      if (err)
+        return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+
+      /* All-zero digests are returned as NULL.  Never mind. */
+      if (checksum)
+        filter_add(filter, checksum->digest);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  SVN_ERR(svn_sqlite__reset(stmt));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* (Re-)build FILTER from the rep-cache database(s) in FS.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+filter_build(fs_fs_rep_filter_t *filter,
+             svn_fs_t *fs,
+             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t youngest;
+  apr_int64_t count = 0;
+  int i;
+
+  /* Entries for all revisions up to YOUNGEST will be in the database,
+     except those that other processes are yet to write.  Missing them
+     only loses a few sharing opportunities. */
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, scratch_pool));
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, scratch_pool));
+
+  for (i = 0; i < ffd->rep_cache_shards; ++i)
+    {
+      svn_sqlite__stmt_t *stmt;
+      svn_boolean_t have_row;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db[i],
+                                        STMT_GET_REP_COUNT));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      count += svn_sqlite__column_int64(stmt, 0);
+      SVN_ERR(svn_sqlite__reset(stmt));
+    }
+
+  /* Leave plenty of room for future additions. */
+  svn_pool_clear(filter->pool);
+  filter->capacity = (apr_size_t)(2 * count) + FILTER_MIN_CAPACITY;
+  filter->bit_count = filter->capacity * FILTER_BITS_PER_KEY;
+  filter->bits = apr_pcalloc(filter->pool, filter->bit_count / 8);
+  filter->count = 0;
+
+  for (i = 0; i < ffd->rep_cache_shards; ++i)
+    SVN_ERR(filter_add_shard(filter, ffd->rep_cache_db[i], scratch_pool));
+
+  filter->revision = youngest;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *MAYBE to FALSE if the SHA1 DIGEST is certainly not in the rep-cache
+   of FS.  Otherwise, set it to TRUE.  The caller must hold the lock of
+   FS's rep-cache filter.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+filter_lookup(svn_boolean_t *maybe,
+              svn_fs_t *fs,
+              const unsigned char *digest,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_rep_filter_t *filter = ffd->shared->rep_filter;
+
+  *maybe = TRUE;
+  if (filter->disabled)
+    return SVN_NO_ERROR;
+
+  /* If we know about revisions that the filter has not seen being
+     committed, some other process added them and we can't tell which
+     keys got added to the rep-cache. */
+  if (filter->bits && ffd->youngest_rev_cache > filter->revision)
+    {
+      filter->disabled = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  if (! filter->bits)
+    {
+      svn_error_t *err = filter_build(filter, fs, scratch_pool);
+      if (err)
+        {
+          /* Don't fail the same expensive way over and over again. */
+          filter->bits = NULL;
+          filter->disabled = TRUE;
+          return svn_error_trace(err);
+        }
+    }
+
+  *maybe = filter_contains(filter, digest);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the SHA1 DIGEST to the rep-cache filter of FS, if that has already
+   been built.  The caller must hold the lock of that filter. */
+static svn_error_t *
+filter_insert(svn_fs_t *fs,
+              const unsigned char *digest)
 {
-  svn_fs_t *fs = baton;
   fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_rep_filter_t *filter = ffd->shared->rep_filter;
+
+  if (filter->disabled || ! filter->bits)
+    return SVN_NO_ERROR;
+
+  filter_add(filter, digest);
+
+  /* Becoming too crowded?  Rebuild it with more room, upon next use. */
+  if (filter->count > filter->capacity)
+    filter->bits = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Update the rep-cache filter of FS for the commit of revisions
+   OLD_REV + 1 to NEW_REV.  The caller must hold the lock of that filter. */
+static svn_error_t *
+filter_note_commit(svn_fs_t *fs,
+                   svn_revnum_t old_rev,
+                   svn_revnum_t new_rev)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_rep_filter_t *filter = ffd->shared->rep_filter;
+
+  if (filter->disabled || ! filter->bits)
+    return SVN_NO_ERROR;
+
+  /* Any gap means that some other process committed. */
+  if (filter->revision == old_rev)
+    filter->revision = new_rev;
+  else
+    filter->disabled = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__rep_filter_note_commit(svn_fs_t *fs,
+                                  svn_revnum_t old_rev,
+                                  svn_revnum_t new_rev)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_MUTEX__WITH_LOCK(ffd->shared->rep_filter->lock,
+                       filter_note_commit(fs, old_rev, new_rev));
+
+  return SVN_NO_ERROR;
+}
+
+/** Library-private API's. **/
+
+/* Open (or create) the rep-cache database file for SHARD in FS and return
+   it in *SDB.  The database will be automatically closed when fs->pool is
+   destroyed.  Use POOL for temporary allocations. */
+static svn_error_t *
+open_rep_cache_shard(svn_sqlite__db_t **sdb_p,
+                     svn_fs_t *fs,
+                     int shard,
+                     apr_pool_t *pool)
+{
   svn_sqlite__db_t *sdb;
   const char *db_path;
   int version;
 
-  /* Open (or create) the sqlite database.  It will be automatically
-     closed when fs->pool is destroyed. */
-  db_path = path_rep_cache_db(fs->path, pool);
+  db_path = svn_fs_fs__path_rep_cache_shard(fs, shard, pool);
 #ifndef WIN32
   {
     /* We want to extend the permissions that apply to the repository
        as a whole when creating a new rep cache and not simply default
        to umask. */
-    svn_boolean_t exists;
+    svn_node_kind_t kind;
 
-    SVN_ERR(svn_fs_fs__exists_rep_cache(&exists, fs, pool));
-    if (!exists)
+    SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+    if (kind == svn_node_none)
       {
         const char *current = svn_fs_fs__path_current(fs, pool);
         svn_error_t *err = svn_io_file_create_empty(db_path, pool);
@@ -111,9 +426,40 @@ open_rep_cache(void *baton,
                             sdb);
     }
 
+  *sdb_p = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+/* Body of svn_fs_fs__open_rep_cache().
+   Implements svn_atomic__init_once().init_func.
+ */
+static svn_error_t *
+open_rep_cache(void *baton,
+               apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t **dbs;
+  int i;
+
+  dbs = apr_pcalloc(fs->pool, ffd->rep_cache_shards * sizeof(*dbs));
+  for (i = 0; i < ffd->rep_cache_shards; ++i)
+    {
+      svn_error_t *err = open_rep_cache_shard(&dbs[i], fs, i, pool);
+      if (err)
+        {
+          /* Don't leave the shards opened so far lingering. */
+          while (i-- > 0)
+            err = svn_error_compose_create(err, svn_sqlite__close(dbs[i]));
+
+          return svn_error_trace(err);
+        }
+    }
+
   /* This is used as a flag that the database is available so don't
      set it earlier. */
-  ffd->rep_cache_db = sdb;
+  ffd->rep_cache_db = dbs;
 
   return SVN_NO_ERROR;
 }
@@ -128,7 +474,8 @@ svn_fs_fs__open_rep_cache(svn_fs_t *fs,
   return svn_error_quick_wrapf(err,
                                _("Couldn't open rep-cache database '%s'"),
                                svn_dirent_local_style(
-                                 path_rep_cache_db(fs->path, pool), pool));
+                                 svn_fs_fs__path_rep_cache_shard(fs, 0, pool),
+                                 pool));
 }
 
 svn_error_t *
@@ -138,60 +485,72 @@ svn_fs_fs__close_rep_cache(svn_fs_t *fs)
 
   if (ffd->rep_cache_db)
     {
-      SVN_ERR(svn_sqlite__close(ffd->rep_cache_db));
+      svn_error_t *err = SVN_NO_ERROR;
+      int i;
+
+      for (i = 0; i < ffd->rep_cache_shards; ++i)
+        err = svn_error_compose_create(
+                err, svn_sqlite__close(ffd->rep_cache_db[i]));
+
       ffd->rep_cache_db = NULL;
       ffd->rep_cache_db_opened = 0;
+      SVN_ERR(err);
     }
 
   return SVN_NO_ERROR;
 }
 
+int
+svn_fs_fs__rep_cache_shard(svn_fs_t *fs,
+                           const unsigned char *digest)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  return ffd->rep_cache_shards <= 1 ? 0 : digest[0] % ffd->rep_cache_shards;
+}
+
 svn_error_t *
 svn_fs_fs__exists_rep_cache(svn_boolean_t *exists,
                             svn_fs_t *fs, apr_pool_t *pool)
 {
   svn_node_kind_t kind;
 
-  SVN_ERR(svn_io_check_path(path_rep_cache_db(fs->path, pool),
+  /* All shards get created together, so checking the first is enough. */
+  SVN_ERR(svn_io_check_path(svn_fs_fs__path_rep_cache_shard(fs, 0, pool),
                             &kind, pool));
 
   *exists = (kind != svn_node_none);
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_fs_fs__walk_rep_reference(svn_fs_t *fs,
-                              svn_revnum_t start,
-                              svn_revnum_t end,
-                              svn_error_t *(*walker)(representation_t *,
-                                                     void *,
-                                                     svn_fs_t *,
-                                                     apr_pool_t *),
-                              void *walker_baton,
-                              svn_cancel_func_t cancel_func,
-                              void *cancel_baton,
-                              apr_pool_t *pool)
+/* Implement svn_fs_fs__walk_rep_reference() for the rep-cache database
+   SDB of FS.  ITERATIONS counts the entries processed so far, across all
+   shards. */
+static svn_error_t *
+walk_rep_cache_shard(svn_fs_t *fs,
+                     svn_sqlite__db_t *sdb,
+                     svn_revnum_t start,
+                     svn_revnum_t end,
+                     svn_error_t *(*walker)(representation_t *,
+                                            void *,
+                                            svn_fs_t *,
+                                            apr_pool_t *),
+                     void *walker_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     int *iterations,
+                     apr_pool_t *pool)
 {
-  fs_fs_data_t *ffd = fs->fsap_data;
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
-  int iterations = 0;
 
   apr_pool_t *iterpool = svn_pool_create(pool);
 
-  /* Don't check ffd->rep_sharing_allowed. */
-  SVN_ERR_ASSERT(ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT);
-
-  if (! ffd->rep_cache_db)
-    SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
-
   /* Check global invariants. */
   if (start == 0)
     {
       svn_revnum_t max;
 
-      SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
-                                        STMT_GET_MAX_REV));
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_MAX_REV));
       SVN_ERR(svn_sqlite__step(&have_row, stmt));
       max = svn_sqlite__column_revnum(stmt, 0);
       SVN_ERR(svn_sqlite__reset(stmt));
@@ -199,8 +558,7 @@ svn_fs_fs__walk_rep_reference(svn_fs_t *fs,
         SVN_ERR(svn_fs_fs__ensure_revision_exists(max, fs, iterpool));
     }
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
-                                    STMT_GET_REPS_FOR_RANGE));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_REPS_FOR_RANGE));
   SVN_ERR(svn_sqlite__bindf(stmt, "rr",
                             start, end));
 
@@ -214,7 +572,7 @@ svn_fs_fs__walk_rep_reference(svn_fs_t *fs,
       svn_checksum_t *checksum;
 
       /* Clear ITERPOOL occasionally. */
-      if (iterations++ % 16 == 0)
+      if ((*iterations)++ % 16 == 0)
         svn_pool_clear(iterpool);
 
       /* Check for cancellation. */
@@ -255,6 +613,38 @@ svn_fs_fs__walk_rep_reference(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__walk_rep_reference(svn_fs_t *fs,
+                              svn_revnum_t start,
+                              svn_revnum_t end,
+                              svn_error_t *(*walker)(representation_t *,
+                                                     void *,
+                                                     svn_fs_t *,
+                                                     apr_pool_t *),
+                              void *walker_baton,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int iterations = 0;
+  int i;
+
+  /* Don't check ffd->rep_sharing_allowed. */
+  SVN_ERR_ASSERT(ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT);
+
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
+
+  for (i = 0; i < ffd->rep_cache_shards; ++i)
+    SVN_ERR(walk_rep_cache_shard(fs, ffd->rep_cache_db[i], start, end,
+                                 walker, walker_baton,
+                                 cancel_func, cancel_baton,
+                                 &iterations, pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 /* This function's caller ignores most errors it returns.
    If you extend this function, check the callsite to see if you have
@@ -280,13 +670,33 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
                             _("Only SHA1 checksums can be used as keys in the "
                               "rep_cache table.\n"));
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_GET_REP));
+  SVN_FS_FS__COUNT(svn_fs_fs__metric_rep_cache_queries);
+
+  /* Most lookups miss.  Don't bother the database if we know already. */
+  if (ffd->rep_cache_filter)
+    {
+      svn_boolean_t maybe;
+
+      SVN_MUTEX__WITH_LOCK(ffd->shared->rep_filter->lock,
+                           filter_lookup(&maybe, fs, checksum->digest,
+                                         pool));
+      if (! maybe)
+        {
+          *rep_p = NULL;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, shard_db(fs, checksum->digest),
+                                    STMT_GET_REP));
   SVN_ERR(svn_sqlite__bindf(stmt, "s",
                             svn_checksum_to_cstring(checksum, pool)));
 
   SVN_ERR(svn_sqlite__step(&have_row, stmt));
   if (have_row)
     {
+      SVN_FS_FS__COUNT(svn_fs_fs__metric_rep_cache_hits);
+
       rep = apr_pcalloc(pool, sizeof(*rep));
       svn_fs_fs__id_txn_reset(&(rep->txn_id));
       memcpy(rep->sha1_digest, checksum->digest, sizeof(rep->sha1_digest));
@@ -342,7 +752,8 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                             _("Only SHA1 checksums can be used as keys in the "
                               "rep_cache table.\n"));
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_SET_REP));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, shard_db(fs, rep->sha1_digest),
+                                    STMT_SET_REP));
   SVN_ERR(svn_sqlite__bindf(stmt, "siiii",
                             svn_checksum_to_cstring(&checksum, pool),
                             (apr_int64_t) rep->revision,
@@ -351,7 +762,12 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                             (apr_int64_t) rep->expanded_size));
 
   err = svn_sqlite__insert(NULL, stmt);
-  if (err)
+  if (! err)
+    {
+      SVN_MUTEX__WITH_LOCK(ffd->shared->rep_filter->lock,
+                           filter_insert(fs, rep->sha1_digest));
+    }
+  else
     {
       representation_t *old_rep;
 
@@ -384,49 +800,76 @@ svn_fs_fs__del_rep_reference(svn_fs_t *fs,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_sqlite__stmt_t *stmt;
+  int i;
 
   SVN_ERR_ASSERT(ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT);
   if (! ffd->rep_cache_db)
     SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
-                                    STMT_DEL_REPS_YOUNGER_THAN_REV));
-  SVN_ERR(svn_sqlite__bindf(stmt, "r", youngest));
-  SVN_ERR(svn_sqlite__step_done(stmt));
+  for (i = 0; i < ffd->rep_cache_shards; ++i)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db[i],
+                                        STMT_DEL_REPS_YOUNGER_THAN_REV));
+      SVN_ERR(svn_sqlite__bindf(stmt, "r", youngest));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
 
   return SVN_NO_ERROR;
 }
 
-/* Start a transaction to take an SQLite reserved lock that prevents
-   other writes.
+/* Start transactions to take an SQLite reserved lock on the first
+   COUNT rep-cache shards of FS that prevents other writes.  If that
+   fails, all locks taken so far will have been released.
 
    See unlock_rep_cache(). */
 static svn_error_t *
 lock_rep_cache(svn_fs_t *fs,
+               int count,
                apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+  int i;
 
   if (! ffd->rep_cache_db)
     SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
-  SVN_ERR(svn_sqlite__exec_statements(ffd->rep_cache_db, STMT_LOCK_REP));
+  for (i = 0; i < count; ++i)
+    {
+      svn_error_t *err = svn_sqlite__exec_statements(ffd->rep_cache_db[i],
+                                                     STMT_LOCK_REP);
+      if (err)
+        {
+          while (i-- > 0)
+            err = svn_error_compose_create(err,
+                       svn_sqlite__exec_statements(ffd->rep_cache_db[i],
+                                                   STMT_UNLOCK_REP));
+
+          return svn_error_trace(err);
+        }
+    }
 
   return SVN_NO_ERROR;
 }
 
-/* End the transaction started by lock_rep_cache(). */
+/* End the transactions started by lock_rep_cache() on the first COUNT
+   rep-cache shards of FS. */
 static svn_error_t *
 unlock_rep_cache(svn_fs_t *fs,
+                 int count,
                  apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
 
   SVN_ERR_ASSERT(ffd->rep_cache_db); /* was opened by lock_rep_cache() */
 
-  SVN_ERR(svn_sqlite__exec_statements(ffd->rep_cache_db, STMT_UNLOCK_REP));
+  for (i = count - 1; i >= 0; --i)
+    err = svn_error_compose_create(err,
+               svn_sqlite__exec_statements(ffd->rep_cache_db[i],
+                                           STMT_UNLOCK_REP));
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(err);
 }
 
 svn_error_t *
@@ -436,9 +879,68 @@ svn_fs_fs__with_rep_cache_lock(svn_fs_t *fs,
                                void *baton,
                                apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   svn_error_t *err;
 
-  SVN_ERR(lock_rep_cache(fs, pool));
+  /* Always lock the shards in the same order to prevent deadlocks. */
+  SVN_ERR(lock_rep_cache(fs, ffd->rep_cache_shards, pool));
   err = body(baton, pool);
-  return svn_error_compose_create(err, unlock_rep_cache(fs, pool));
+  return svn_error_compose_create(err,
+                                  unlock_rep_cache(fs, ffd->rep_cache_shards,
+                                                   pool));
+}
+
+svn_error_t *
+svn_fs_fs__set_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t **by_shard;
+  apr_pool_t *iterpool;
+  int i, k;
+
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, scratch_pool));
+
+  /* Sort the REPS into per-shard buckets. */
+  by_shard = apr_pcalloc(scratch_pool,
+                         ffd->rep_cache_shards * sizeof(*by_shard));
+  for (i = 0; i < reps->nelts; ++i)
+    {
+      representation_t *rep = APR_ARRAY_IDX(reps, i, representation_t *);
+      int shard = svn_fs_fs__rep_cache_shard(fs, rep->sha1_digest);
+
+      if (! by_shard[shard])
+        by_shard[shard] = apr_array_make(scratch_pool, 4, sizeof(rep));
+      APR_ARRAY_PUSH(by_shard[shard], representation_t *) = rep;
+    }
+
+  /* Write each shard's entries in their own sqlite transaction;
+   * see <http://www.sqlite.org/faq.html#q19>.  This way, we only ever hold
+   * one database lock at a time and concurrent commits may update the
+   * other shards in the meantime. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < ffd->rep_cache_shards; ++i)
+    {
+      svn_sqlite__db_t *sdb = ffd->rep_cache_db[i];
+      svn_error_t *err = SVN_NO_ERROR;
+
+      if (! by_shard[i])
+        continue;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_sqlite__begin_transaction(sdb));
+      for (k = 0; !err && k < by_shard[i]->nelts; ++k)
+        err = svn_fs_fs__set_rep_reference(fs,
+                                           APR_ARRAY_IDX(by_shard[i], k,
+                                                         representation_t *),
+                                           iterpool);
+
+      SVN_ERR(svn_sqlite__finish_transaction(sdb, err));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
 }
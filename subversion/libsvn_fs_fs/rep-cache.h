@@ -34,6 +34,11 @@ extern "C" {
 
 #define REP_CACHE_DB_NAME        "rep-cache.db"
 
+/* Name of the rep-cache database file for a given shard number if the
+   rep-cache has been split into several files; see
+   CONFIG_OPTION_REP_CACHE_SHARDS. */
+#define REP_CACHE_SHARD_DB_NAME_FORMAT "rep-cache-%02x.db"
+
 /* Open and create, if needed, the rep cache database associated with FS.
    Use POOL for temporary allocations. */
 svn_error_t *
@@ -44,6 +49,34 @@ svn_fs_fs__open_rep_cache(svn_fs_t *fs,
 svn_error_t *
 svn_fs_fs__close_rep_cache(svn_fs_t *fs);
 
+/* Create an empty rep-cache filter in *FILTER_P, allocated in RESULT_POOL.
+   It will be built upon first use. */
+svn_error_t *
+svn_fs_fs__rep_filter_create(fs_fs_rep_filter_t **filter_p,
+                             apr_pool_t *result_pool);
+
+/* Tell the rep-cache filter of FS that this process is about to commit
+   the revisions OLD_REV + 1 up to NEW_REV on top of OLD_REV.  The caller
+   must hold the write lock and the rep-cache entries for these revisions
+   must be added through svn_fs_fs__set_rep_reference et al. */
+svn_error_t *
+svn_fs_fs__rep_filter_note_commit(svn_fs_t *fs,
+                                  svn_revnum_t old_rev,
+                                  svn_revnum_t new_rev);
+
+/* Return the rep-cache shard number in FS that holds the entry for the
+   SHA1 DIGEST. */
+int
+svn_fs_fs__rep_cache_shard(svn_fs_t *fs,
+                           const unsigned char *digest);
+
+/* Return the path of the rep-cache database file for SHARD in FS,
+   allocated in RESULT_POOL. */
+const char *
+svn_fs_fs__path_rep_cache_shard(svn_fs_t *fs,
+                                int shard,
+                                apr_pool_t *result_pool);
+
 /* Set *EXISTS to TRUE iff the rep-cache DB file exists. */
 svn_error_t *
 svn_fs_fs__exists_rep_cache(svn_boolean_t *exists,
@@ -83,6 +116,15 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                              representation_t *rep,
                              apr_pool_t *pool);
 
+/* Set all representations in REPS (an array of representation_t *) in FS
+   like svn_fs_fs__set_rep_reference does.  Batch the updates to each
+   rep-cache shard in a single sqlite transaction.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__set_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *scratch_pool);
+
 /* Delete from the cache all reps corresponding to revisions younger
    than YOUNGEST. */
 svn_error_t *
@@ -92,6 +134,7 @@ svn_fs_fs__del_rep_reference(svn_fs_t *fs,
 
 /* Start a transaction to take an SQLite reserved lock that prevents
    other writes, call BODY, end the transaction, and return what BODY returned.
+   If the rep-cache consists of several shards, all of them will be locked.
  */
 svn_error_t *
 svn_fs_fs__with_rep_cache_lock(svn_fs_t *fs,
@@ -28,7 +28,10 @@
 
 #include "../libsvn_fs/fs-loader.h"
 
+#include "svn_pools.h"
+#include "svn_sorts.h"
 #include "private/svn_io_private.h"
+#include "private/svn_mutex.h"
 #include "svn_private_config.h"
 
 /* Initialize the *FILE structure for REVISION in filesystem FS.  Set its
@@ -46,6 +49,9 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
 
   file->file = NULL;
   file->stream = NULL;
+  file->mmap = NULL;
+  file->mmap_offset = 0;
+  file->mmap_stream = NULL;
   file->p2l_stream = NULL;
   file->l2p_stream = NULL;
   file->block_size = ffd->block_size;
@@ -54,6 +60,11 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
   file->p2l_offset = -1;
   file->p2l_checksum = NULL;
   file->footer_offset = -1;
+  file->read_ahead_blocks = ffd->read_ahead_blocks;
+  file->last_block = -1;
+  file->sequential_reads = 0;
+  file->read_ahead_end = 0;
+  file->handle = NULL;
   file->pool = pool;
 }
 
@@ -120,15 +131,101 @@ auto_make_writable(const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_read_fn_t for svn_fs_fs__revision_file_t.MMAP_STREAM.
+ * BATON is the svn_fs_fs__revision_file_t. */
+static svn_error_t *
+mmap_read(void *baton,
+          char *buffer,
+          apr_size_t *len)
+{
+  svn_fs_fs__revision_file_t *file = baton;
+  apr_size_t remaining = file->mmap->size - (apr_size_t)file->mmap_offset;
+
+  *len = MIN(*len, remaining);
+  memcpy(buffer, (const char *)file->mmap->mm + file->mmap_offset, *len);
+  file->mmap_offset += *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_stream_skip_fn_t for
+ * svn_fs_fs__revision_file_t.MMAP_STREAM.
+ * BATON is the svn_fs_fs__revision_file_t. */
+static svn_error_t *
+mmap_skip(void *baton,
+          apr_size_t len)
+{
+  svn_fs_fs__revision_file_t *file = baton;
+  apr_size_t remaining = file->mmap->size - (apr_size_t)file->mmap_offset;
+
+  file->mmap_offset += MIN(len, remaining);
+
+  return SVN_NO_ERROR;
+}
+
+/* Make FILE->MMAP_STREAM read from FILE->MMAP, starting at the
+ * beginning of the file.  Allocate the stream in FILE->POOL.
+ */
+static void
+init_mmap_stream(svn_fs_fs__revision_file_t *file)
+{
+  file->mmap_offset = 0;
+  file->mmap_stream = svn_stream_create(file, file->pool);
+  svn_stream_set_read2(file->mmap_stream, mmap_read, mmap_read);
+  svn_stream_set_skip(file->mmap_stream, mmap_skip);
+}
+
+/* Try to memory-map the whole of FILE->FILE.  If that is not possible,
+ * e.g. because the file does not fit into the address space, silently
+ * leave FILE->MMAP as NULL such that callers fall back to reading from
+ * FILE->FILE.  Allocate the mapping in FILE_POOL and use SCRATCH_POOL
+ * for temporaries.
+ */
+static svn_error_t *
+auto_mmap_file(svn_fs_fs__revision_file_t *file,
+               apr_pool_t *file_pool,
+               apr_pool_t *scratch_pool)
+{
+#if APR_HAS_MMAP
+  apr_off_t size;
+  apr_status_t status;
+
+  SVN_ERR(svn_io_file_size_get(&size, file->file, scratch_pool));
+
+  /* Empty files can't be mapped and over-sized ones don't fit into our
+   * address space. */
+  if (size == 0 || (apr_off_t)(apr_size_t)size != size)
+    return SVN_NO_ERROR;
+
+  status = apr_mmap_create(&file->mmap, file->file, 0, (apr_size_t)size,
+                           APR_MMAP_READ, file_pool);
+  if (status)
+    {
+      /* Mapping is only an optimization.  Use the standard file access. */
+      file->mmap = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  init_mmap_stream(file);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* Core implementation of svn_fs_fs__open_pack_or_rev_file working on an
  * existing, initialized FILE structure.  If WRITABLE is TRUE, give write
  * access to the file - temporarily resetting the r/o state if necessary.
+ * If PATH_P is not NULL, return the path of the file actually opened in
+ * *PATH_P.  Allocate the OS file handle and its memory mapping in
+ * FILE_POOL and everything else in RESULT_POOL.
  */
 static svn_error_t *
 open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
                       svn_fs_t *fs,
                       svn_revnum_t rev,
                       svn_boolean_t writable,
+                      const char **path_p,
+                      apr_pool_t *file_pool,
                       apr_pool_t *result_pool,
                       apr_pool_t *scratch_pool)
 {
@@ -151,7 +248,7 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
       /* open the revision file in buffered r/o or r/w mode */
       if (!err)
         err = svn_io_file_open(&apr_file, path, flags, APR_OS_DEFAULT,
-                               result_pool);
+                               file_pool);
 
       if (!err)
         {
@@ -160,6 +257,13 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
                                                   result_pool);
           file->is_packed = svn_fs_fs__is_packed_rev(fs, rev);
 
+          /* Pack files are immutable, i.e. safe to map while we read. */
+          if (!writable && file->is_packed && ffd->mmap_packed_files)
+            SVN_ERR(auto_mmap_file(file, file_pool, scratch_pool));
+
+          if (path_p)
+            *path_p = path;
+
           return SVN_NO_ERROR;
         }
 
@@ -199,6 +303,280 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
   return svn_error_trace(err);
 }
 
+/* An open rev / pack file together with everything we learned about it
+ * that does not depend on the respective reader.  While idle, it is
+ * linked into a fs_fs_file_handle_cache_t.  Otherwise, it is owned by
+ * exactly one svn_fs_fs__revision_file_t.
+ */
+struct svn_fs_fs__file_handle_t
+{
+  /* Path of the repository and of the rev / pack file.  The latter is
+   * the key under which we look up idle handles. */
+  const char *fs_path;
+  const char *path;
+
+  /* Copied from the svn_fs_fs__revision_file_t that opened the file. */
+  svn_revnum_t start_revision;
+  svn_boolean_t is_packed;
+  apr_file_t *file;
+  apr_mmap_t *mmap;
+
+  /* Footer contents.  The offsets are -1 until some reader called
+   * svn_fs_fs__auto_read_footer. */
+  apr_off_t l2p_offset;
+  svn_checksum_t *l2p_checksum;
+  apr_off_t p2l_offset;
+  svn_checksum_t *p2l_checksum;
+  apr_off_t footer_offset;
+
+  /* The cache to return this handle to and the maximum number of idle
+   * handles that the current owner's FS configuration allows for.  If
+   * that is 0, the handle gets closed instead. */
+  fs_fs_file_handle_cache_t *cache;
+  int capacity;
+
+  /* Neighbours in CACHE's LRU list.  NULL while checked out. */
+  svn_fs_fs__file_handle_t *next;
+  svn_fs_fs__file_handle_t *previous;
+
+  /* Root pool containing this object as well as FILE and MMAP.  Handles
+   * get passed between threads, so this can't be a reader's sub-pool. */
+  apr_pool_t *pool;
+};
+
+struct fs_fs_file_handle_cache_t
+{
+  /* Doubly-linked list of idle handles, most recently used first.
+   * There are only a few entries, so a linear search is good enough. */
+  svn_fs_fs__file_handle_t *first;
+  svn_fs_fs__file_handle_t *last;
+
+  /* Number of entries in that list. */
+  int count;
+
+  /* Serializes all access to the members above. */
+  svn_mutex__t *lock;
+};
+
+/* Remove HANDLE from the list of idle handles in CACHE. */
+static void
+unlink_handle(fs_fs_file_handle_cache_t *cache,
+              svn_fs_fs__file_handle_t *handle)
+{
+  if (handle->previous)
+    handle->previous->next = handle->next;
+  else
+    cache->first = handle->next;
+
+  if (handle->next)
+    handle->next->previous = handle->previous;
+  else
+    cache->last = handle->previous;
+
+  handle->next = NULL;
+  handle->previous = NULL;
+  --cache->count;
+}
+
+/* Set *HANDLE_P to the most recently used idle handle for the file at
+ * PATH in CACHE and remove it from CACHE.  Set it to NULL if there is
+ * none.  The caller must hold CACHE's lock.
+ */
+static svn_error_t *
+checkout_handle(svn_fs_fs__file_handle_t **handle_p,
+                fs_fs_file_handle_cache_t *cache,
+                const char *path)
+{
+  svn_fs_fs__file_handle_t *handle;
+
+  for (handle = cache->first; handle; handle = handle->next)
+    if (strcmp(handle->path, path) == 0)
+      {
+        unlink_handle(cache, handle);
+        break;
+      }
+
+  *handle_p = handle;
+  return SVN_NO_ERROR;
+}
+
+/* Add HANDLE to the front of its cache's idle list.  If that exceeds
+ * the capacity, remove the least recently used entry and return it in
+ * *VICTIM_P.  Otherwise, set *VICTIM_P to NULL.  The caller must hold
+ * the cache's lock.
+ */
+static svn_error_t *
+checkin_handle(svn_fs_fs__file_handle_t **victim_p,
+               svn_fs_fs__file_handle_t *handle)
+{
+  fs_fs_file_handle_cache_t *cache = handle->cache;
+
+  handle->previous = NULL;
+  handle->next = cache->first;
+  if (cache->first)
+    cache->first->previous = handle;
+  else
+    cache->last = handle;
+
+  cache->first = handle;
+  ++cache->count;
+
+  *victim_p = NULL;
+  if (cache->count > handle->capacity)
+    {
+      *victim_p = cache->last;
+      unlink_handle(cache, cache->last);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* APR pool cleanup callback handing the HANDLE of the
+ * svn_fs_fs__revision_file_t BATON back to its cache, along with the
+ * footer data that we may have read in the meantime.  Close the handle
+ * if it can't be cached. */
+static apr_status_t
+release_handle(void *baton)
+{
+  svn_fs_fs__revision_file_t *file = baton;
+  svn_fs_fs__file_handle_t *handle = file->handle;
+  svn_fs_fs__file_handle_t *victim = handle;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status = APR_SUCCESS;
+
+  file->handle = NULL;
+  if (handle->l2p_offset == -1 && file->l2p_offset != -1)
+    {
+      handle->l2p_offset = file->l2p_offset;
+      handle->l2p_checksum = svn_checksum_dup(file->l2p_checksum,
+                                              handle->pool);
+      handle->p2l_offset = file->p2l_offset;
+      handle->p2l_checksum = svn_checksum_dup(file->p2l_checksum,
+                                              handle->pool);
+      handle->footer_offset = file->footer_offset;
+    }
+
+  if (handle->capacity > 0)
+    {
+      err = svn_mutex__lock(handle->cache->lock);
+      if (!err)
+        err = svn_mutex__unlock(handle->cache->lock,
+                                checkin_handle(&victim, handle));
+    }
+
+  /* Close files outside the lock. */
+  if (victim)
+    svn_pool_destroy(victim->pool);
+
+  if (err)
+    {
+      status = err->apr_err;
+      svn_error_clear(err);
+    }
+
+  return status;
+}
+
+/* Take over the idle HANDLE into the freshly initialized FILE and use
+ * SCRATCH_POOL for temporaries.  HANDLE will be returned to its cache
+ * when FILE gets closed or FILE->POOL gets cleaned up.
+ */
+static svn_error_t *
+use_handle(svn_fs_fs__revision_file_t *file,
+           svn_fs_fs__file_handle_t *handle,
+           apr_pool_t *scratch_pool)
+{
+  apr_off_t offset = 0;
+
+  file->handle = handle;
+  apr_pool_cleanup_register(file->pool, file, release_handle,
+                            apr_pool_cleanup_null);
+
+  file->start_revision = handle->start_revision;
+  file->is_packed = handle->is_packed;
+  file->file = handle->file;
+  file->stream = svn_stream_from_aprfile2(handle->file, TRUE, file->pool);
+  file->mmap = handle->mmap;
+  if (file->mmap)
+    init_mmap_stream(file);
+
+  /* The previous user may have read the footer already. */
+  file->l2p_offset = handle->l2p_offset;
+  file->l2p_checksum = svn_checksum_dup(handle->l2p_checksum, file->pool);
+  file->p2l_offset = handle->p2l_offset;
+  file->p2l_checksum = svn_checksum_dup(handle->p2l_checksum, file->pool);
+  file->footer_offset = handle->footer_offset;
+
+  /* Don't depend on where the previous user left the file pointer. */
+  SVN_ERR(svn_io_file_seek(file->file, APR_SET, &offset, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Close all idle handles in CACHE that belong to the repository at
+ * FS_PATH and either are for the file at PATH or, if PATH is NULL, are
+ * for non-packed revisions before MIN_UNPACKED_REV.  Prepend them to
+ * the *VICTIMS_P list.  The caller must hold CACHE's lock.
+ */
+static svn_error_t *
+purge_handles(svn_fs_fs__file_handle_t **victims_p,
+              fs_fs_file_handle_cache_t *cache,
+              const char *fs_path,
+              const char *path,
+              svn_revnum_t min_unpacked_rev)
+{
+  svn_fs_fs__file_handle_t *handle = cache->first;
+
+  while (handle)
+    {
+      svn_fs_fs__file_handle_t *next = handle->next;
+
+      if (   strcmp(handle->fs_path, fs_path) == 0
+          && (path ? strcmp(handle->path, path) == 0
+                   : (   !handle->is_packed
+                      && handle->start_revision < min_unpacked_rev)))
+        {
+          unlink_handle(cache, handle);
+          handle->next = *victims_p;
+          *victims_p = handle;
+        }
+
+      handle = next;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Close all idle handles in FS' file handle cache that match PATH and
+ * MIN_UNPACKED_REV as described for purge_handles().
+ */
+static svn_error_t *
+purge_fs_handles(svn_fs_t *fs,
+                 const char *path,
+                 svn_revnum_t min_unpacked_rev)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_file_handle_cache_t *cache;
+  svn_fs_fs__file_handle_t *victims = NULL;
+
+  if (ffd->shared == NULL)
+    return SVN_NO_ERROR;
+
+  cache = ffd->shared->file_handle_cache;
+  SVN_MUTEX__WITH_LOCK(cache->lock,
+                       purge_handles(&victims, cache, fs->path, path,
+                                     min_unpacked_rev));
+
+  while (victims)
+    {
+      svn_fs_fs__file_handle_t *next = victims->next;
+      svn_pool_destroy(victims->pool);
+      victims = next;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__open_pack_or_rev_file(svn_fs_fs__revision_file_t **file,
                                  svn_fs_t *fs,
@@ -206,11 +584,63 @@ svn_fs_fs__open_pack_or_rev_file(svn_fs_fs__revision_file_t **file,
                                  apr_pool_t *result_pool,
                                  apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_file_handle_cache_t *cache;
+  svn_fs_fs__file_handle_t *handle;
+  apr_pool_t *handle_pool;
+  const char *path;
+  svn_error_t *err;
+
   *file = apr_palloc(result_pool, sizeof(**file));
   init_revision_file(*file, fs, rev, result_pool);
 
-  return svn_error_trace(open_pack_or_rev_file(*file, fs, rev, FALSE,
-                                               result_pool, scratch_pool));
+  /* The shared data is not available while creating the repository. */
+  if (ffd->cached_file_handles == 0 || ffd->shared == NULL)
+    return svn_error_trace(open_pack_or_rev_file(*file, fs, rev, FALSE,
+                                                 NULL, result_pool,
+                                                 result_pool,
+                                                 scratch_pool));
+
+  /* Reuse an idle handle, if there is one. */
+  cache = ffd->shared->file_handle_cache;
+  path = svn_fs_fs__path_rev_absolute(fs, rev, scratch_pool);
+  SVN_MUTEX__WITH_LOCK(cache->lock, checkout_handle(&handle, cache, path));
+
+  if (handle)
+    {
+      handle->capacity = ffd->cached_file_handles;
+      return svn_error_trace(use_handle(*file, handle, scratch_pool));
+    }
+
+  /* Otherwise, open the file such that it may outlive RESULT_POOL. */
+  handle_pool = svn_pool_create(NULL);
+  err = open_pack_or_rev_file(*file, fs, rev, FALSE, &path, handle_pool,
+                              result_pool, scratch_pool);
+  if (err)
+    {
+      svn_pool_destroy(handle_pool);
+      return svn_error_trace(err);
+    }
+
+  handle = apr_pcalloc(handle_pool, sizeof(*handle));
+  handle->fs_path = apr_pstrdup(handle_pool, fs->path);
+  handle->path = apr_pstrdup(handle_pool, path);
+  handle->start_revision = (*file)->start_revision;
+  handle->is_packed = (*file)->is_packed;
+  handle->file = (*file)->file;
+  handle->mmap = (*file)->mmap;
+  handle->l2p_offset = -1;
+  handle->p2l_offset = -1;
+  handle->footer_offset = -1;
+  handle->cache = cache;
+  handle->capacity = ffd->cached_file_handles;
+  handle->pool = handle_pool;
+
+  (*file)->handle = handle;
+  apr_pool_cleanup_register(result_pool, *file, release_handle,
+                            apr_pool_cleanup_null);
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -220,11 +650,19 @@ svn_fs_fs__open_pack_or_rev_file_writable(svn_fs_fs__revision_file_t** file,
                                           apr_pool_t* result_pool,
                                           apr_pool_t *scratch_pool)
 {
+  const char *path;
+
   *file = apr_palloc(result_pool, sizeof(**file));
   init_revision_file(*file, fs, rev, result_pool);
 
-  return svn_error_trace(open_pack_or_rev_file(*file, fs, rev, TRUE,
-                                               result_pool, scratch_pool));
+  SVN_ERR(open_pack_or_rev_file(*file, fs, rev, TRUE, &path, result_pool,
+                                result_pool, scratch_pool));
+
+  /* Idle read-only handles would not notice our modifications to the
+   * file's footer or its memory mapped contents. */
+  SVN_ERR(purge_fs_handles(fs, path, SVN_INVALID_REVNUM));
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -267,6 +705,94 @@ svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file)
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__rev_file_mmap_data(const char **data,
+                              svn_fs_fs__revision_file_t *file,
+                              apr_off_t offset,
+                              apr_size_t size)
+{
+  SVN_ERR_ASSERT(file->mmap);
+
+  if (offset < 0 || (apr_size_t)offset > file->mmap->size
+      || size > file->mmap->size - (apr_size_t)offset)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Reading %s bytes at offset %s beyond the "
+                               "end of pack file for revision %ld"),
+                             apr_psprintf(file->pool, "%" APR_SIZE_T_FMT,
+                                          size),
+                             apr_off_t_toa(file->pool, offset),
+                             file->start_revision);
+
+  *data = (const char *)file->mmap->mm + offset;
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of consecutive forward block reads after which we consider the
+ * access pattern to be sequential. */
+#define SEQUENTIAL_READ_THRESHOLD 2
+
+/* Maximum distance in blocks between two reads that we still consider
+ * sequential.  Blocks may be skipped if their contents are in cache. */
+#define SEQUENTIAL_READ_MAX_GAP 4
+
+void
+svn_fs_fs__rev_file_read_ahead(svn_fs_fs__revision_file_t *file,
+                               apr_off_t block_start)
+{
+  apr_off_t block_size = file->block_size;
+  apr_off_t window;
+
+  if (file->read_ahead_blocks == 0 || file->file == NULL || block_size <= 0)
+    return;
+
+  /* Re-reading the same block does not tell us anything. */
+  if (block_start == file->last_block)
+    return;
+
+  if (   file->last_block >= 0
+      && block_start > file->last_block
+      && block_start - file->last_block <= SEQUENTIAL_READ_MAX_GAP
+                                           * block_size)
+    {
+      ++file->sequential_reads;
+    }
+  else
+    {
+      file->sequential_reads = 0;
+      file->read_ahead_end = 0;
+    }
+
+  file->last_block = block_start;
+  if (file->sequential_reads < SEQUENTIAL_READ_THRESHOLD)
+    return;
+
+  /* Keep READ_AHEAD_BLOCKS ahead of the reader but don't issue a new
+   * hint for every single block. */
+  window = (apr_off_t)file->read_ahead_blocks * block_size;
+  if (file->read_ahead_end - block_start > window / 2)
+    return;
+
+  if (file->read_ahead_end < block_start + block_size)
+    file->read_ahead_end = block_start + block_size;
+
+  svn_io__file_prefetch(file->file, file->read_ahead_end,
+                        block_start + block_size + window
+                        - file->read_ahead_end);
+  file->read_ahead_end = block_start + block_size + window;
+}
+
+svn_error_t *
+svn_fs_fs__rev_file_mmap_seek(svn_fs_fs__revision_file_t *file,
+                              apr_off_t offset)
+{
+  const char *data;
+  SVN_ERR(svn_fs_fs__rev_file_mmap_data(&data, file, offset, 0));
+  file->mmap_offset = offset;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
                                svn_fs_t *fs,
@@ -293,15 +819,73 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
 svn_error_t *
 svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file)
 {
-  if (file->stream)
-    SVN_ERR(svn_stream_close(file->stream));
-  if (file->file)
-    SVN_ERR(svn_io_file_close(file->file, file->pool));
+  if (file->handle)
+    {
+      /* Keep the file open for the next reader. */
+      apr_status_t status = apr_pool_cleanup_run(file->pool, file,
+                                                 release_handle);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't release revision file handle"));
+    }
+  else
+    {
+      if (file->stream)
+        SVN_ERR(svn_stream_close(file->stream));
+#if APR_HAS_MMAP
+      if (file->mmap)
+        apr_mmap_delete(file->mmap);
+#endif
+      if (file->file)
+        SVN_ERR(svn_io_file_close(file->file, file->pool));
+    }
 
   file->file = NULL;
   file->stream = NULL;
+  file->mmap = NULL;
+  file->mmap_stream = NULL;
   file->l2p_stream = NULL;
   file->p2l_stream = NULL;
 
   return SVN_NO_ERROR;
 }
+
+/* APR pool cleanup callback closing all idle handles in the
+ * fs_fs_file_handle_cache_t BATON.  No other thread may access the
+ * cache anymore at this point. */
+static apr_status_t
+close_idle_handles(void *baton)
+{
+  fs_fs_file_handle_cache_t *cache = baton;
+
+  while (cache->first)
+    {
+      svn_fs_fs__file_handle_t *handle = cache->first;
+      unlink_handle(cache, handle);
+      svn_pool_destroy(handle->pool);
+    }
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_fs_fs__file_handle_cache_create(fs_fs_file_handle_cache_t **cache_p,
+                                    apr_pool_t *result_pool)
+{
+  fs_fs_file_handle_cache_t *cache = apr_pcalloc(result_pool,
+                                                 sizeof(*cache));
+
+  SVN_ERR(svn_mutex__init(&cache->lock, TRUE, result_pool));
+  apr_pool_cleanup_register(result_pool, cache, close_idle_handles,
+                            apr_pool_cleanup_null);
+
+  *cache_p = cache;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__file_handle_cache_purge(svn_fs_t *fs,
+                                   svn_revnum_t min_unpacked_rev)
+{
+  return svn_error_trace(purge_fs_handles(fs, NULL, min_unpacked_rev));
+}
@@ -23,6 +23,8 @@
 #ifndef SVN_LIBSVN_FS__REV_FILE_H
 #define SVN_LIBSVN_FS__REV_FILE_H
 
+#include <apr_mmap.h>
+
 #include "svn_fs.h"
 #include "id.h"
 
@@ -38,6 +40,16 @@
 typedef struct svn_fs_fs__packed_number_stream_t
   svn_fs_fs__packed_number_stream_t;
 
+/* Opaque type of an open rev / pack file that can be reused by later
+ * svn_fs_fs__open_pack_or_rev_file calls.  See rev_file.c.
+ */
+typedef struct svn_fs_fs__file_handle_t svn_fs_fs__file_handle_t;
+
+/* Idle rev and pack file handles kept open for reuse.  An instance of
+ * this lives in the FS' shared data.
+ */
+typedef struct fs_fs_file_handle_cache_t fs_fs_file_handle_cache_t;
+
 /* Data file, including indexes data, and associated properties for
  * START_REVISION.  As the FILE is kept open, background pack operations
  * will not cause access to this file to fail.
@@ -57,6 +69,19 @@ typedef struct svn_fs_fs__revision_file_t
   /* stream based on FILE and not NULL exactly when FILE is not NULL */
   svn_stream_t *stream;
 
+  /* Read-only memory mapped image of the whole FILE or NULL.  Will only
+   * be set for pack files opened for reading and only if the
+   * "mmap-packed-files" option has been enabled in fsfs.conf. */
+  apr_mmap_t *mmap;
+
+  /* Read position within MMAP.  This is independent from FILE's current
+   * file pointer.  Undefined if MMAP is NULL. */
+  apr_off_t mmap_offset;
+
+  /* Stream reading from MMAP at MMAP_OFFSET.  Not NULL exactly when MMAP
+   * is not NULL. */
+  svn_stream_t *mmap_stream;
+
   /* the opened P2L index stream or NULL.  Always NULL for txns. */
   svn_fs_fs__packed_number_stream_t *p2l_stream;
 
@@ -90,6 +115,26 @@ typedef struct svn_fs_fs__revision_file_t
    * been called, yet. */
   apr_off_t footer_offset;
 
+  /* Copied from FS->FFD->READ_AHEAD_BLOCKS upon creation.  0 disables
+   * sequential access detection and read-ahead. */
+  apr_int64_t read_ahead_blocks;
+
+  /* Start offset of the block most recently passed to
+   * svn_fs_fs__rev_file_read_ahead.  -1 if there was none, yet. */
+  apr_off_t last_block;
+
+  /* Number of consecutive forward moves to near-by blocks. */
+  int sequential_reads;
+
+  /* End of the data range in FILE that we already asked the OS to
+   * prefetch. */
+  apr_off_t read_ahead_end;
+
+  /* The cached handle that FILE and MMAP have been taken from or NULL.
+   * It will be handed back to the handle cache when this object gets
+   * closed or its pool gets cleaned up. */
+  svn_fs_fs__file_handle_t *handle;
+
   /* pool containing this object */
   apr_pool_t *pool;
 } svn_fs_fs__revision_file_t;
@@ -98,7 +143,10 @@ typedef struct svn_fs_fs__revision_file_t
  * been packed, *FILE will be set to the packed file; otherwise, set *FILE
  * to the revision file for REV.  Return SVN_ERR_FS_NO_SUCH_REVISION if the
  * file doesn't exist.  Allocate *FILE in RESULT_POOL and use SCRATCH_POOL
- * for temporaries. */
+ * for temporaries.
+ *
+ * If enabled in FS's config, the underlying OS file may be taken from and
+ * will be returned to a per-process cache of idle file handles. */
 svn_error_t *
 svn_fs_fs__open_pack_or_rev_file(svn_fs_fs__revision_file_t **file,
                                  svn_fs_t *fs,
@@ -128,6 +176,33 @@ svn_fs_fs__open_pack_or_rev_file_writable(svn_fs_fs__revision_file_t **file,
 svn_error_t *
 svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file);
 
+/* Set *DATA to the address of the SIZE bytes starting at OFFSET within
+ * the memory mapped image of FILE.  FILE->MMAP must not be NULL.  Return
+ * SVN_ERR_FS_CORRUPT if the requested range is not fully within FILE.
+ */
+svn_error_t *
+svn_fs_fs__rev_file_mmap_data(const char **data,
+                              svn_fs_fs__revision_file_t *file,
+                              apr_off_t offset,
+                              apr_size_t size);
+
+/* Tell FILE that the block starting at offset BLOCK_START is about to be
+ * read.  If this looks like a sequential scan through FILE, ask the OS to
+ * fetch the next few blocks in the background.  This is a mere hint and
+ * a no-op if FILE has not been opened, yet.
+ */
+void
+svn_fs_fs__rev_file_read_ahead(svn_fs_fs__revision_file_t *file,
+                               apr_off_t block_start);
+
+/* Set the read position of FILE->MMAP_STREAM to OFFSET.  FILE->MMAP must
+ * not be NULL.  Return SVN_ERR_FS_CORRUPT if OFFSET is beyond the end of
+ * FILE.
+ */
+svn_error_t *
+svn_fs_fs__rev_file_mmap_seek(svn_fs_fs__revision_file_t *file,
+                              apr_off_t offset);
+
 /* Open the proto-rev file of transaction TXN_ID in FS and return it in *FILE.
  * Allocate *FILE in RESULT_POOL use and SCRATCH_POOL for temporaries.. */
 svn_error_t *
@@ -142,4 +217,20 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
 svn_error_t *
 svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file);
 
+/* Create an empty cache of idle rev / pack file handles in *CACHE_P,
+ * allocated in RESULT_POOL.  Any idle handles will be closed when
+ * RESULT_POOL gets cleaned up.
+ */
+svn_error_t *
+svn_fs_fs__file_handle_cache_create(fs_fs_file_handle_cache_t **cache_p,
+                                    apr_pool_t *result_pool);
+
+/* Close all idle handles of non-packed revision files below
+ * MIN_UNPACKED_REV in FS's file handle cache.  Call this after packing,
+ * so the old rev files can actually be removed from disk.
+ */
+svn_error_t *
+svn_fs_fs__file_handle_cache_purge(svn_fs_t *fs,
+                                   svn_revnum_t min_unpacked_rev);
+
 #endif
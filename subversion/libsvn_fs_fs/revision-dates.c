@@ -0,0 +1,332 @@
+/* revision-dates.c --- index of the svn:date of every revision
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_props.h"
+#include "svn_sorts.h"
+#include "svn_time.h"
+
+#include "svn_private_config.h"
+
+#include "fs_fs.h"
+#include "fs.h"
+#include "revprops.h"
+#include "util.h"
+#include "revision-dates.h"
+
+/* The index file holds one entry per revision, starting at revision 0.
+   Each entry is the svn:date of that revision as a big-endian apr_time_t
+   of this many bytes.  Only complete entries count. */
+#define ENTRY_SIZE                    8
+
+/* Maximum number of revisions other than the one just committed that a
+   single commit adds to the index.  Reading a revision's properties is
+   cheap, so we can afford more of them than the changed-paths index. */
+#define MAX_CATCH_UP_REVISIONS        1000
+
+
+
+/** Helper functions. **/
+static APR_INLINE const char *
+path_revision_dates(const char *fs_path,
+                    apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs_path, REVISION_DATES_NAME, result_pool);
+}
+
+/* Set *COUNT to the number of complete entries in the index FILE.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_entry_count(svn_revnum_t *count,
+                apr_file_t *file,
+                apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE, file, scratch_pool));
+  *count = (svn_revnum_t)(finfo.size / ENTRY_SIZE);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the entry for revision REV from the index FILE into *TM.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_entry(apr_time_t *tm,
+           apr_file_t *file,
+           svn_revnum_t rev,
+           apr_pool_t *scratch_pool)
+{
+  unsigned char buffer[ENTRY_SIZE];
+  apr_off_t offset = (apr_off_t)rev * ENTRY_SIZE;
+  apr_uint64_t value = 0;
+  int i;
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(file, buffer, sizeof(buffer), NULL, NULL,
+                                 scratch_pool));
+
+  for (i = 0; i < ENTRY_SIZE; ++i)
+    value = (value << 8) | buffer[i];
+
+  *tm = (apr_time_t)value;
+
+  return SVN_NO_ERROR;
+}
+
+/* Write TM as the entry for revision REV to the index FILE.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+write_entry(apr_file_t *file,
+            svn_revnum_t rev,
+            apr_time_t tm,
+            apr_pool_t *scratch_pool)
+{
+  unsigned char buffer[ENTRY_SIZE];
+  apr_off_t offset = (apr_off_t)rev * ENTRY_SIZE;
+  apr_uint64_t value = (apr_uint64_t)tm;
+  int i;
+
+  for (i = ENTRY_SIZE - 1; i >= 0; --i)
+    {
+      buffer[i] = (unsigned char)(value & 0xff);
+      value >>= 8;
+    }
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, scratch_pool));
+  return svn_error_trace(svn_io_file_write_full(file, buffer, sizeof(buffer),
+                                                NULL, scratch_pool));
+}
+
+/* Return the entry to record for a revision whose svn:date is DATE.
+   DATE may be NULL.  Revisions without a valid date get PREVIOUS, the
+   entry of the revision before them, so that the binary search over the
+   entries still works.  Use SCRATCH_POOL for temporary allocations. */
+static apr_time_t
+get_entry_value(const svn_string_t *date,
+                apr_time_t previous,
+                apr_pool_t *scratch_pool)
+{
+  apr_time_t tm;
+  svn_error_t *err;
+
+  if (date == NULL)
+    return previous;
+
+  err = svn_time_from_cstring(&tm, date->data, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return previous;
+    }
+
+  return tm;
+}
+
+svn_error_t *
+svn_fs_fs__remove_revision_dates(svn_fs_t *fs,
+                                 apr_pool_t *pool)
+{
+  return svn_error_trace(svn_io_remove_file2(path_revision_dates(fs->path,
+                                                                 pool),
+                                             TRUE, pool));
+}
+
+/* Baton used for update_body below. */
+typedef struct update_baton_t
+{
+  svn_fs_t *fs;
+  svn_revnum_t new_rev;
+} update_baton_t;
+
+/* The work-horse for svn_fs_fs__update_revision_dates, called with the
+   FS write lock.  This implements the svn_fs_fs__with_write_lock()
+   'body' callback type.  BATON is an 'update_baton_t *'. */
+static svn_error_t *
+update_body(void *baton,
+            apr_pool_t *pool)
+{
+  update_baton_t *ub = baton;
+  const char *path = path_revision_dates(ub->fs->path, pool);
+  apr_file_t *file;
+  svn_node_kind_t kind;
+  svn_revnum_t count, rev, last;
+  apr_time_t previous = 0;
+  apr_pool_t *iterpool;
+
+  /* We want to extend the permissions that apply to the repository as a
+     whole when creating a new index and not simply default to umask. */
+  SVN_ERR(svn_io_check_path(path, &kind, pool));
+  if (kind == svn_node_none)
+    {
+      SVN_ERR(svn_io_file_create_empty(path, pool));
+      SVN_ERR(svn_io_copy_perms(svn_fs_fs__path_current(ub->fs, pool),
+                                path, pool));
+    }
+
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ | APR_WRITE | APR_BINARY,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(get_entry_count(&count, file, pool));
+  if (count > 0)
+    SVN_ERR(read_entry(&previous, file, count - 1, pool));
+
+  /* Entries must be contiguous from revision 0 on.  If there are too
+     many revisions missing, NEW_REV will be added by a later commit. */
+  last = MIN(ub->new_rev, count + MAX_CATCH_UP_REVISIONS);
+
+  iterpool = svn_pool_create(pool);
+  for (rev = count; rev <= last; ++rev)
+    {
+      apr_hash_t *proplist;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__get_revision_proplist(&proplist, ub->fs, rev,
+                                               FALSE, iterpool, iterpool));
+      previous = get_entry_value(svn_hash_gets(proplist,
+                                               SVN_PROP_REVISION_DATE),
+                                 previous, iterpool);
+      SVN_ERR(write_entry(file, rev, previous, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_io_file_close(file, pool));
+}
+
+svn_error_t *
+svn_fs_fs__update_revision_dates(svn_fs_t *fs,
+                                 svn_revnum_t new_rev,
+                                 apr_pool_t *pool)
+{
+  update_baton_t ub;
+
+  ub.fs = fs;
+  ub.new_rev = new_rev;
+
+  return svn_error_trace(svn_fs_fs__with_write_lock(fs, update_body, &ub,
+                                                    pool));
+}
+
+svn_error_t *
+svn_fs_fs__set_revision_date(svn_fs_t *fs,
+                             svn_revnum_t rev,
+                             const svn_string_t *date,
+                             apr_pool_t *pool)
+{
+  apr_file_t *file;
+  svn_revnum_t count;
+  apr_time_t previous = 0;
+  svn_error_t *err;
+
+  /* Update the index even if it is disabled right now.  It would be
+     out of date once it gets enabled again otherwise. */
+  err = svn_io_file_open(&file, path_revision_dates(fs->path, pool),
+                         APR_READ | APR_WRITE | APR_BINARY, APR_OS_DEFAULT,
+                         pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Revisions not covered yet will be read when the index catches up. */
+  SVN_ERR(get_entry_count(&count, file, pool));
+  if (rev < count)
+    {
+      if (rev > 0)
+        SVN_ERR(read_entry(&previous, file, rev - 1, pool));
+
+      SVN_ERR(write_entry(file, rev, get_entry_value(date, previous, pool),
+                          pool));
+    }
+
+  return svn_error_trace(svn_io_file_close(file, pool));
+}
+
+svn_error_t *
+svn_fs_fs__dated_revision(svn_revnum_t *revision,
+                          svn_fs_t *fs,
+                          apr_time_t tm,
+                          apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_file_t *file;
+  svn_revnum_t count, youngest, bottom, top;
+  apr_time_t this_time;
+  svn_error_t *err;
+
+  *revision = SVN_INVALID_REVNUM;
+  if (! ffd->revision_dates_index)
+    return SVN_NO_ERROR;
+
+  err = svn_io_file_open(&file, path_revision_dates(fs->path, scratch_pool),
+                         APR_READ | APR_BINARY, APR_OS_DEFAULT,
+                         scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, scratch_pool));
+  SVN_ERR(get_entry_count(&count, file, scratch_pool));
+  count = MIN(count, youngest + 1);
+
+  if (count > 0)
+    {
+      SVN_ERR(read_entry(&this_time, file, 0, scratch_pool));
+      if (this_time > tm)
+        {
+          *revision = 0;
+        }
+      else
+        {
+          /* Find the youngest entry not younger than TM.  The entry at
+             BOTTOM is never younger than TM. */
+          bottom = 0;
+          top = count - 1;
+          while (bottom < top)
+            {
+              svn_revnum_t middle = bottom + (top - bottom + 1) / 2;
+
+              SVN_ERR(read_entry(&this_time, file, middle, scratch_pool));
+              if (this_time > tm)
+                top = middle - 1;
+              else
+                bottom = middle;
+            }
+
+          /* Revisions that the index does not cover yet may still be
+             older than TM. */
+          if (bottom < count - 1 || bottom == youngest)
+            *revision = bottom;
+        }
+    }
+
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
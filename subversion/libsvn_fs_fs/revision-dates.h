@@ -0,0 +1,77 @@
+/* revision-dates.h : interface to the revision dates index
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#ifndef SVN_LIBSVN_FS_FS_REVISION_DATES_H
+#define SVN_LIBSVN_FS_FS_REVISION_DATES_H
+
+#include "svn_error.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+#define REVISION_DATES_NAME      "revision-dates"
+
+/* Remove the revision dates index of FS, if it exists.  The index will
+   be rebuilt from the next commit onwards.  Use POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__remove_revision_dates(svn_fs_t *fs,
+                                 apr_pool_t *pool);
+
+/* Add revision NEW_REV, which has just been committed to FS, to the
+   revision dates index of FS.  Also add a bounded number of older
+   revisions that the index does not cover yet.  This takes the FS write
+   lock.  Use POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__update_revision_dates(svn_fs_t *fs,
+                                 svn_revnum_t new_rev,
+                                 apr_pool_t *pool);
+
+/* Record DATE, the new svn:date value of revision REV in FS, in the
+   revision dates index of FS if that covers REV.  DATE may be NULL.
+   The caller must hold the FS write lock.  Use POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__set_revision_date(svn_fs_t *fs,
+                             svn_revnum_t rev,
+                             const svn_string_t *date,
+                             apr_pool_t *pool);
+
+/* Implements fs_vtable_t.dated_revision(); see there and
+   svn_fs__dated_revision(). */
+svn_error_t *
+svn_fs_fs__dated_revision(svn_revnum_t *revision,
+                          svn_fs_t *fs,
+                          apr_time_t tm,
+                          apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_REVISION_DATES_H */
@@ -28,6 +28,7 @@
 #include "svn_sorts.h"
 
 #include "fs_fs.h"
+#include "low_level.h"
 #include "revprops.h"
 #include "temp_serializer.h"
 #include "util.h"
@@ -196,25 +197,282 @@ parse_revprop(apr_hash_t **properties,
               apr_pool_t *result_pool,
               apr_pool_t *scratch_pool)
 {
-  svn_stream_t *stream = svn_stream_from_string(content, scratch_pool);
-  *properties = apr_hash_make(result_pool);
-
-  SVN_ERR_W(svn_hash_read2(*properties, stream, SVN_HASH_TERMINATOR,
-                           result_pool),
+  SVN_ERR_W(svn_fs_fs__parse_proplist(properties, content, FALSE,
+                                      result_pool),
             apr_psprintf(scratch_pool, "Failed to parse revprops for r%ld.",
                          revision));
 
   return SVN_NO_ERROR;
 }
 
+/* Give writing processes 10 seconds to replace an existing revprop
+   file with a new one. After that time, we assume that the writing
+   process got aborted and that we have re-read revprops. */
+#define REVPROP_CHANGE_TIMEOUT (10 * 1000000)
+
+/* In case of an inconsistent read, close the generation file, yield,
+   re-open and re-read.  This is the number of times we try this before
+   giving up. */
+#define GENERATION_READ_RETRY_COUNT 100
+
+/* Revprop caching management.
+ *
+ * We cache revprops using (revision, generation) pairs as keys.  The
+ * generation is stored in the PATH_REVPROP_GENERATION file and gets
+ * bumped upon every revprop change.  Because it lives on disk, all
+ * processes accessing the repository agree upon it and the revprop cache
+ * may be shared between them, e.g. through memcached.  A missing file
+ * is the same as generation 0; it gets created upon the first change.
+ *
+ * An FS instance reads the generation file only when it has no valid
+ * generation, i.e. initially and after every REFRESH.  Between those sync
+ * barriers, the cache may return outdated revprops just as it did before.
+ *
+ * To detect writers that crashed between switching to the new revprop
+ * data and bumping the generation, we bump it twice per revprop change:
+ * once immediately before (creating an odd number) and once after the
+ * atomic switch (even generation).  A reader seeing an odd generation
+ * will use it, i.e. not get any cache hits.  If the generation file has
+ * not been touched for REVPROP_CHANGE_TIMEOUT, the reader assumes the
+ * writer to be gone, acquires the write lock and bumps the generation.
+ */
+
+/* Read revprop generation as stored on disk for repository FS. The result
+ * is returned in *CURRENT.  A missing file is reported as generation 0.
+ */
+static svn_error_t *
+read_revprop_generation_file(apr_int64_t *current,
+                             svn_fs_t *fs,
+                             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+  svn_error_t *err = SVN_NO_ERROR;
+  const char *path = svn_fs_fs__path_revprop_generation(fs, scratch_pool);
+
+  /* Retry in case of incomplete file buffer updates. */
+  for (i = 0; i < GENERATION_READ_RETRY_COUNT; ++i)
+    {
+      svn_stringbuf_t *buf;
+
+      svn_error_clear(err);
+      svn_pool_clear(iterpool);
+
+      /* Read the generation file. */
+      err = svn_stringbuf_from_file2(&buf, path, iterpool);
+
+      /* No revprop has been changed since the file got introduced. */
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        {
+          svn_error_clear(err);
+          err = SVN_NO_ERROR;
+          *current = 0;
+          break;
+        }
+
+      /* If we could read the file, it should be complete due to our atomic
+       * file replacement scheme. */
+      if (!err)
+        {
+          svn_stringbuf_strip_whitespace(buf);
+          SVN_ERR(svn_cstring_atoi64(current, buf->data));
+          break;
+        }
+
+      /* Got unlucky the file was not available.  Retry. */
+#if APR_HAS_THREADS
+      apr_thread_yield();
+#else
+      apr_sleep(0);
+#endif
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* If we had to give up, propagate the error. */
+  return svn_error_trace(err);
+}
+
+/* Write the CURRENT revprop generation to disk for repository FS.
+ */
+static svn_error_t *
+write_revprop_generation_file(svn_fs_t *fs,
+                              apr_int64_t current,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_stringbuf_t *buffer;
+  const char *path = svn_fs_fs__path_revprop_generation(fs, scratch_pool);
+
+  /* Invalidate our cached revprop generation in case the file operations
+   * below fail. */
+  ffd->revprop_generation = -1;
+
+  /* Write the new number.  Use the "current" file as permissions reference
+   * because the generation file may not exist, yet. */
+  buffer = svn_stringbuf_createf(scratch_pool, "%" APR_INT64_T_FMT "\n",
+                                 current);
+  SVN_ERR(svn_io_write_atomic2(path, buffer->data, buffer->len,
+                               svn_fs_fs__path_current(fs, scratch_pool),
+                               ffd->flush_to_disk, scratch_pool));
+
+  /* Remember it to spare us the re-read. */
+  ffd->revprop_generation = current;
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton structure for revprop_generation_fixup. */
+typedef struct revprop_generation_fixup_t
+{
+  /* revprop generation to read */
+  apr_int64_t *generation;
+
+  /* file system context */
+  svn_fs_t *fs;
+} revprop_generation_fixup_t;
+
+/* If the revprop generation has an odd value, it means the original writer
+   of the revprop got killed. We don't know whether that process as able
+   to change the revprop data but we assume that it was. Therefore, we
+   increase the generation in that case to basically invalidate everyone's
+   cache content.
+   Execute this only while holding the write lock to the repo in baton->FS.
+   This implements the svn_fs_fs__with_write_lock() 'body' callback type.
+ */
+static svn_error_t *
+revprop_generation_fixup(void *void_baton,
+                         apr_pool_t *scratch_pool)
+{
+  revprop_generation_fixup_t *baton = void_baton;
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+  assert(ffd->has_write_lock);
+
+  /* Maybe, either the original revprop writer or some other reader has
+     already corrected / bumped the revprop generation.  Thus, we need
+     to read it again.  However, we will now be the only ones changing
+     the file contents due to us holding the write lock. */
+  SVN_ERR(read_revprop_generation_file(baton->generation, baton->fs,
+                                       scratch_pool));
+
+  /* Cause everyone to re-read revprops upon their next access, if the
+     last revprop write did not complete properly. */
+  if (*baton->generation % 2)
+    {
+      ++*baton->generation;
+      SVN_ERR(write_revprop_generation_file(baton->fs,
+                                            *baton->generation,
+                                            scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the current revprop generation of FS and store it in FS->FSAP_DATA.
+   Also, detect aborted / crashed writers and recover from that. */
+static svn_error_t *
+read_revprop_generation(svn_fs_t *fs,
+                        apr_pool_t *scratch_pool)
+{
+  apr_int64_t current = 0;
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* read the current revprop generation number */
+  SVN_ERR(read_revprop_generation_file(&current, fs, scratch_pool));
+
+  /* is an unfinished revprop write under the way? */
+  if (current % 2)
+    {
+      svn_boolean_t timeout = FALSE;
+
+      /* Has the writer process been aborted?
+       * Either by timeout or by us being the writer now.
+       */
+      if (!ffd->has_write_lock)
+        {
+          apr_time_t mtime;
+          SVN_ERR(svn_io_file_affected_time(&mtime,
+                        svn_fs_fs__path_revprop_generation(fs, scratch_pool),
+                        scratch_pool));
+          timeout = apr_time_now() > mtime + REVPROP_CHANGE_TIMEOUT;
+        }
+
+      if (ffd->has_write_lock || timeout)
+        {
+          revprop_generation_fixup_t baton;
+          baton.generation = &current;
+          baton.fs = fs;
+
+          /* Ensure that the original writer process no longer exists by
+           * acquiring the write lock to this repository.  Then, fix up
+           * the revprop generation.
+           */
+          if (ffd->has_write_lock)
+            SVN_ERR(revprop_generation_fixup(&baton, scratch_pool));
+          else
+            SVN_ERR(svn_fs_fs__with_write_lock(fs, revprop_generation_fixup,
+                                               &baton, scratch_pool));
+        }
+    }
+
+  /* return the value we just got */
+  ffd->revprop_generation = current;
+  return SVN_NO_ERROR;
+}
+
+/* Set the revprop generation in FS to the next odd number to indicate
+   that there is a revprop write process under way.  Update the value
+   in FS->FSAP_DATA accordingly.  If the change times out, readers shall
+   recover from that state & re-read revprops.
+   The caller must hold the write lock or have exclusive access to FS. */
+static svn_error_t *
+begin_revprop_change(svn_fs_t *fs,
+                     apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Set the revprop generation to an odd value to indicate
+   * that a write is in progress.
+   */
+  SVN_ERR(read_revprop_generation(fs, scratch_pool));
+  ++ffd->revprop_generation;
+  SVN_ERR_ASSERT(ffd->revprop_generation % 2);
+  SVN_ERR(write_revprop_generation_file(fs, ffd->revprop_generation,
+                                        scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set the revprop generation in FS to the next even generation after
+   the odd value in FS->FSAP_DATA to indicate that
+   a) readers shall re-read revprops, and
+   b) the write process has been completed (no recovery required).
+   The caller must hold the write lock or have exclusive access to FS. */
+static svn_error_t *
+end_revprop_change(svn_fs_t *fs,
+                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  SVN_ERR_ASSERT(ffd->revprop_generation % 2);
+
+  /* Set the revprop generation to an even value to indicate
+   * that a write has been completed.  Since we held the write
+   * lock, nobody else could have updated the file contents.
+   */
+  SVN_ERR(write_revprop_generation_file(fs, ffd->revprop_generation + 1,
+                                        scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 void
 svn_fs_fs__reset_revprop_cache(svn_fs_t *fs)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  ffd->revprop_prefix = 0;
+  ffd->revprop_generation = -1;
 }
 
-/* If FS has not a revprop cache prefix set, generate one.
+/* If FS has no valid revprop generation, read it from disk.
  * Always call this before accessing the revprop cache.
  */
 static svn_error_t *
@@ -222,8 +480,8 @@ prepare_revprop_cache(svn_fs_t *fs,
                       apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  if (!ffd->revprop_prefix)
-    SVN_ERR(svn_atomic__unique_counter(&ffd->revprop_prefix));
+  if (ffd->revprop_generation < 0)
+    SVN_ERR(read_revprop_generation(fs, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -243,9 +501,9 @@ cache_revprops(svn_boolean_t *is_cached,
   pair_cache_key_t key;
 
   /* Make sure prepare_revprop_cache() has been called. */
-  SVN_ERR_ASSERT(ffd->revprop_prefix);
+  SVN_ERR_ASSERT(ffd->revprop_generation >= 0);
   key.revision = revision;
-  key.second = ffd->revprop_prefix;
+  key.second = ffd->revprop_generation;
 
   if (is_cached)
     {
@@ -708,10 +966,10 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
       svn_boolean_t is_cached;
       pair_cache_key_t key;
 
-      /* Auto-alloc prefix and construct the key. */
+      /* Get the current generation and construct the key. */
       SVN_ERR(prepare_revprop_cache(fs, scratch_pool));
       key.revision = rev;
-      key.second = ffd->revprop_prefix;
+      key.second = ffd->revprop_generation;
 
       /* The only way that this might error out is due to parser error. */
       SVN_ERR_W(svn_cache__get((void **) proplist_p, &is_cached,
@@ -787,7 +1045,7 @@ write_non_packed_revprop(const char **final_path,
                                    svn_dirent_dirname(*final_path, pool),
                                    svn_io_file_del_none, pool, pool));
   stream = svn_stream_from_aprfile2(file, TRUE, pool);
-  SVN_ERR(svn_hash_write2(proplist, stream, SVN_HASH_TERMINATOR, pool));
+  SVN_ERR(svn_fs_fs__write_proplist(stream, fs, proplist, pool));
   SVN_ERR(svn_stream_close(stream));
 
   /* Flush temporary file to disk and close it. */
@@ -1041,7 +1299,7 @@ write_packed_revprop(const char **final_path,
   /* serialize the new revprops */
   serialized = svn_stringbuf_create_empty(pool);
   stream = svn_stream_from_stringbuf(serialized, pool);
-  SVN_ERR(svn_hash_write2(proplist, stream, SVN_HASH_TERMINATOR, pool));
+  SVN_ERR(svn_fs_fs__write_proplist(stream, fs, proplist, pool));
   SVN_ERR(svn_stream_close(stream));
 
   /* calculate the size of the new data */
@@ -1189,8 +1447,9 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
     SVN_ERR(write_non_packed_revprop(&final_path, &tmp_path,
                                      fs, rev, proplist, pool));
 
-  /* Previous cache contents is invalid now. */
-  svn_fs_fs__reset_revprop_cache(fs);
+  /* Tell readers in all processes that a change is under way.
+   * Previous cache contents will be invalid from now on. */
+  SVN_ERR(begin_revprop_change(fs, pool));
 
   /* We use the rev file of this revision as the perms reference,
    * because when setting revprops for the first time, the revprop
@@ -1203,6 +1462,11 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
   SVN_ERR(switch_to_new_revprop(fs, final_path, tmp_path, perms_reference,
                                 files_to_delete, pool));
 
+  /* Indicate that the update completed and make our own FS instance
+   * re-read the generation upon the next access. */
+  SVN_ERR(end_revprop_change(fs, pool));
+  svn_fs_fs__reset_revprop_cache(fs);
+
   return SVN_NO_ERROR;
 }
 
@@ -1290,13 +1554,14 @@ svn_fs_fs__copy_revprops(const char *pack_file_dir,
                          apr_array_header_t *sizes,
                          apr_size_t total_size,
                          int compression_level,
-                         svn_boolean_t flush_to_disk,
+                         svn_fs__batch_fsync_t *batch,
                          svn_cancel_func_t cancel_func,
                          void *cancel_baton,
                          apr_pool_t *scratch_pool)
 {
   svn_stream_t *pack_stream;
   apr_file_t *pack_file;
+  const char *pack_file_path;
   svn_revnum_t rev;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
 
@@ -1312,9 +1577,9 @@ svn_fs_fs__copy_revprops(const char *pack_file_dir,
                                     sizes->nelts, iterpool));
 
   /* Some useful paths. */
-  SVN_ERR(svn_io_file_open(&pack_file, svn_dirent_join(pack_file_dir,
-                                                       pack_filename,
-                                                       scratch_pool),
+  pack_file_path = svn_dirent_join(pack_file_dir, pack_filename,
+                                   scratch_pool);
+  SVN_ERR(svn_io_file_open(&pack_file, pack_file_path,
                            APR_WRITE | APR_CREATE, APR_OS_DEFAULT,
                            scratch_pool));
 
@@ -1351,9 +1616,8 @@ svn_fs_fs__copy_revprops(const char *pack_file_dir,
   /* write the pack file content to disk */
   SVN_ERR(svn_io_file_write_full(pack_file, compressed->data, compressed->len,
                                  NULL, scratch_pool));
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(pack_file, scratch_pool));
   SVN_ERR(svn_io_file_close(pack_file, scratch_pool));
+  SVN_ERR(svn_fs__batch_fsync_add_file(batch, pack_file_path, scratch_pool));
 
   svn_pool_destroy(iterpool);
 
@@ -1379,6 +1643,7 @@ svn_fs_fs__pack_revprops_shard(const char *pack_file_dir,
   apr_size_t total_size;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_array_header_t *sizes;
+  svn_fs__batch_fsync_t *batch;
 
   /* Sanitize config file values. */
   apr_size_t max_size = (apr_size_t)MIN(MAX(max_pack_size, 1),
@@ -1392,8 +1657,10 @@ svn_fs_fs__pack_revprops_shard(const char *pack_file_dir,
   SVN_ERR(svn_io_remove_dir2(pack_file_dir, TRUE, cancel_func, cancel_baton,
                              scratch_pool));
 
-  /* Create the new directory and manifest file stream. */
+  /* Create the new directory and manifest file stream.  All pack files
+   * will be flushed to disk together at the end. */
   SVN_ERR(svn_io_dir_make(pack_file_dir, APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_fs__batch_fsync_create(&batch, flush_to_disk, scratch_pool));
 
   SVN_ERR(svn_io_file_open(&manifest_file, manifest_file_path,
                            APR_WRITE | APR_BUFFERED | APR_CREATE | APR_EXCL,
@@ -1439,7 +1706,7 @@ svn_fs_fs__pack_revprops_shard(const char *pack_file_dir,
           SVN_ERR(svn_fs_fs__copy_revprops(pack_file_dir, pack_filename,
                                            shard_path, start_rev, rev-1,
                                            sizes, total_size,
-                                           compression_level, flush_to_disk,
+                                           compression_level, batch,
                                            cancel_func, cancel_baton,
                                            iterpool));
 
@@ -1467,14 +1734,14 @@ svn_fs_fs__pack_revprops_shard(const char *pack_file_dir,
     SVN_ERR(svn_fs_fs__copy_revprops(pack_file_dir, pack_filename,
                                      shard_path, start_rev, rev-1,
                                      sizes, (apr_size_t)total_size,
-                                     compression_level, flush_to_disk,
+                                     compression_level, batch,
                                      cancel_func, cancel_baton, iterpool));
 
-  /* flush the manifest file to disk and update permissions */
+  /* flush the manifest and all pack files to disk and update permissions */
   SVN_ERR(svn_stream_close(manifest_stream));
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(manifest_file, iterpool));
   SVN_ERR(svn_io_file_close(manifest_file, iterpool));
+  SVN_ERR(svn_fs__batch_fsync_add_file(batch, manifest_file_path, iterpool));
+  SVN_ERR(svn_fs__batch_fsync_run(batch, iterpool));
   SVN_ERR(svn_io_copy_perms(shard_path, pack_file_dir, iterpool));
 
   svn_pool_destroy(iterpool);
@@ -22,6 +22,8 @@
 
 #include "svn_fs.h"
 
+#include "private/svn_fs_util.h"
+
 /* In the filesystem FS, pack all revprop shards up to min_unpacked_rev.
  *
  * NOTE: Keep the old non-packed shards around until after the format bump.
@@ -58,7 +60,8 @@ svn_fs_fs__upgrade_cleanup_pack_revprops(svn_fs_t *fs,
                                          void *cancel_baton,
                                          apr_pool_t *scratch_pool);
 
-/* Invalidate the revprop cache in FS. */
+/* Make FS re-read the revprop generation before its next revprop cache
+   access, i.e. invalidate its view of the revprop cache. */
 void
 svn_fs_fs__reset_revprop_cache(svn_fs_t *fs);
 
@@ -111,8 +114,8 @@ svn_fs_fs__packed_revprop_available(svn_boolean_t *missing,
  * a hint on which initial buffer size we should use to hold the pack file
  * content.
  *
- * If FLUSH_TO_DISK is non-zero, do not return until the data has actually
- * been written on the disk.  CANCEL_FUNC and CANCEL_BATON are used as usual.
+ * The new pack file will be scheduled for fsync in BATCH but not be
+ * flushed to disk, yet.  CANCEL_FUNC and CANCEL_BATON are used as usual.
  * Temporary allocations are done in SCRATCH_POOL.
  */
 svn_error_t *
@@ -124,7 +127,7 @@ svn_fs_fs__copy_revprops(const char *pack_file_dir,
                          apr_array_header_t *sizes,
                          apr_size_t total_size,
                          int compression_level,
-                         svn_boolean_t flush_to_disk,
+                         svn_fs__batch_fsync_t *batch,
                          svn_cancel_func_t cancel_func,
                          void *cancel_baton,
                          apr_pool_t *scratch_pool);
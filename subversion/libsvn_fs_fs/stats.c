@@ -20,12 +20,17 @@
  * ====================================================================
  */
 
+#include <apr_thread_proc.h>
+
+#include "svn_cache_config.h"
 #include "svn_dirent_uri.h"
 #include "svn_fs.h"
+#include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_sorts.h"
 
 #include "private/svn_cache.h"
+#include "private/svn_packed_data.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_fs_fs_private.h"
@@ -182,9 +187,23 @@ typedef struct query_t
   /* First non-packed revision. */
   svn_revnum_t min_unpacked_rev;
 
+  /* First revision to read, i.e. the one at index 0 in REVISIONS.
+   * Queries covering a single shard only start at that shard. */
+  svn_revnum_t first_revision;
+
   /* all revisions */
   apr_array_header_t *revisions;
 
+  /* rep_ref_t * of representations whose delta chain length depends on
+   * representations before FIRST_REVISION.  Their CHAIN_LENGTH remains 0
+   * until the chain gets resolved against the full repository. */
+  apr_array_header_t *deferred_refs;
+
+  /* References to representations before FIRST_REVISION, i.e. rep sharing
+   * across shards.  Maps "REVISION:ITEM_INDEX" to rep_stats_t *, whose
+   * REF_COUNT counts the references from within this query only. */
+  apr_hash_t *external_reps;
+
   /* empty representation.
    * Used as a dummy base for DELTA reps without base. */
   rep_stats_t *null_base;
@@ -255,20 +274,15 @@ add_to_histogram(svn_fs_fs__histogram_t *histogram,
   histogram->lines[(apr_size_t)shift].sum += size;
 }
 
-/* Update data aggregators in STATS with this representation of type KIND,
- * on-disk REP_SIZE and expanded node size EXPANDED_SIZE for PATH in REVSION.
- * PLAIN_ADDED indicates whether the node has a deltification predecessor.
+/* Add the change of REP_SIZE bytes for PATH in REVISION to the largest
+ * changes in STATS, if it is large enough.
  */
 static void
-add_change(svn_fs_fs__stats_t *stats,
-           apr_uint64_t rep_size,
-           apr_uint64_t expanded_size,
-           svn_revnum_t revision,
-           const char *path,
-           rep_kind_t kind,
-           svn_boolean_t plain_added)
+add_large_change(svn_fs_fs__stats_t *stats,
+                 apr_uint64_t rep_size,
+                 svn_revnum_t revision,
+                 const char *path)
 {
-  /* identify largest reps */
   if (rep_size >= stats->largest_changes->min_size)
     {
       apr_size_t i;
@@ -291,6 +305,45 @@ add_change(svn_fs_fs__stats_t *stats,
       largest_changes->min_size
         = largest_changes->changes[largest_changes->count-1]->size;
     }
+}
+
+/* Return the entry for EXTENSION in STATS.  Auto-insert it, if necessary.
+ */
+static svn_fs_fs__extension_info_t *
+get_extension_info(svn_fs_fs__stats_t *stats,
+                   const char *extension)
+{
+  svn_fs_fs__extension_info_t *info
+    = apr_hash_get(stats->by_extension, extension, APR_HASH_KEY_STRING);
+
+  if (info == NULL)
+    {
+      apr_pool_t *pool = apr_hash_pool_get(stats->by_extension);
+      info = apr_pcalloc(pool, sizeof(*info));
+      info->extension = apr_pstrdup(pool, extension);
+
+      apr_hash_set(stats->by_extension, info->extension,
+                   APR_HASH_KEY_STRING, info);
+    }
+
+  return info;
+}
+
+/* Update data aggregators in STATS with this representation of type KIND,
+ * on-disk REP_SIZE and expanded node size EXPANDED_SIZE for PATH in REVSION.
+ * PLAIN_ADDED indicates whether the node has a deltification predecessor.
+ */
+static void
+add_change(svn_fs_fs__stats_t *stats,
+           apr_uint64_t rep_size,
+           apr_uint64_t expanded_size,
+           svn_revnum_t revision,
+           const char *path,
+           rep_kind_t kind,
+           svn_boolean_t plain_added)
+{
+  /* identify largest reps */
+  add_large_change(stats, rep_size, revision, path);
 
   /* global histograms */
   add_to_histogram(&stats->rep_size_histogram, rep_size);
@@ -338,16 +391,7 @@ add_change(svn_fs_fs__stats_t *stats,
         extension = "(none)";
 
       /* get / auto-insert entry for this extension */
-      info = apr_hash_get(stats->by_extension, extension, APR_HASH_KEY_STRING);
-      if (info == NULL)
-        {
-          apr_pool_t *pool = apr_hash_pool_get(stats->by_extension);
-          info = apr_pcalloc(pool, sizeof(*info));
-          info->extension = apr_pstrdup(pool, extension);
-
-          apr_hash_set(stats->by_extension, info->extension,
-                       APR_HASH_KEY_STRING, info);
-        }
+      info = get_extension_info(stats, extension);
 
       /* update per-extension histogram */
       add_to_histogram(&info->node_histogram, expanded_size);
@@ -393,7 +437,14 @@ find_representation(int *idx,
   info = revision_info ? *revision_info : NULL;
   if (info == NULL || info->revision != revision)
     {
-      info = APR_ARRAY_IDX(query->revisions, revision, revision_info_t*);
+      if (   revision < query->first_revision
+          || revision - query->first_revision >= query->revisions->nelts)
+        info = NULL;
+      else
+        info = APR_ARRAY_IDX(query->revisions,
+                             revision - query->first_revision,
+                             revision_info_t*);
+
       if (revision_info)
         *revision_info = info;
     }
@@ -419,6 +470,64 @@ find_representation(int *idx,
   return NULL;
 }
 
+/* Return TRUE if REP has been stored in a revision not covered by QUERY.
+ */
+static svn_boolean_t
+is_external_rep(query_t *query,
+                rep_stats_t *rep)
+{
+  return rep->revision < query->first_revision;
+}
+
+/* Return the representation with ITEM_INDEX in REVISION from the external
+ * representations in QUERY.  Auto-create it from REP if necessary and
+ * allocate it in the pool of the external reps container.
+ */
+static rep_stats_t *
+get_external_rep(query_t *query,
+                 representation_t *rep)
+{
+  apr_pool_t *pool = apr_hash_pool_get(query->external_reps);
+  const char *key = apr_psprintf(pool, "%ld:%" APR_UINT64_T_FMT,
+                                 rep->revision, rep->item_index);
+  rep_stats_t *result = svn_hash_gets(query->external_reps, key);
+
+  if (!result)
+    {
+      result = apr_pcalloc(pool, sizeof(*result));
+      result->revision = rep->revision;
+      result->expanded_size = rep->expanded_size;
+      result->item_index = rep->item_index;
+      result->size = rep->size;
+
+      svn_hash_sets(query->external_reps, key, result);
+    }
+
+  return result;
+}
+
+/* Queue the delta chain link from REVISION, ITEM_INDEX to BASE_REVISION,
+ * BASE_ITEM_INDEX in QUERY, to be resolved once all earlier revisions have
+ * been read.
+ */
+static void
+defer_chain_length(query_t *query,
+                   svn_revnum_t revision,
+                   apr_uint64_t item_index,
+                   svn_revnum_t base_revision,
+                   apr_uint64_t base_item_index)
+{
+  apr_pool_t *pool = query->deferred_refs->pool;
+  rep_ref_t *ref = apr_pcalloc(pool, sizeof(*ref));
+
+  ref->revision = revision;
+  ref->item_index = item_index;
+  ref->base_revision = base_revision;
+  ref->base_item_index = base_item_index;
+
+  APR_ARRAY_PUSH(query->deferred_refs, rep_ref_t *) = ref;
+}
+
 /* Find / auto-construct the representation stats for REP in QUERY and
  * return it in *REPRESENTATION.
  *
@@ -441,7 +550,12 @@ parse_representation(rep_stats_t **representation,
   /* look it up */
   result = find_representation(&idx, query, &revision_info, rep->revision,
                                rep->item_index);
-  if (!result)
+  if (!result && rep->revision < query->first_revision)
+    {
+      /* shared with a revision outside our range */
+      result = get_external_rep(query, rep);
+    }
+  else if (!result)
     {
       /* not parsed, yet (probably a rep in the same revision).
        * Create a new rep object and determine its base rep as well.
@@ -470,7 +584,8 @@ parse_representation(rep_stats_t **representation,
 
           result->header_size = header->header_size;
 
-          /* Determine length of the delta chain. */
+          /* Determine length of the delta chain.  If the base has not
+           * been read by this query, let the caller resolve it. */
           if (header->type == svn_fs_fs__rep_delta)
             {
               int base_idx;
@@ -479,8 +594,14 @@ parse_representation(rep_stats_t **representation,
                                       header->base_revision,
                                       header->base_item_index);
 
-              result->chain_length = 1 + MIN(base_rep->chain_length,
-                                             (apr_byte_t)0xfe);
+              if (base_rep && base_rep->chain_length)
+                result->chain_length = 1 + MIN(base_rep->chain_length,
+                                               (apr_byte_t)0xfe);
+              else
+                defer_chain_length(query, result->revision,
+                                   result->item_index,
+                                   header->base_revision,
+                                   header->base_item_index);
             }
           else
             {
@@ -645,11 +766,12 @@ read_noderev(query_t *query,
                                                     : file_property_rep;
     }
 
-  /* record largest changes */
-  if (text && text->ref_count == 1)
+  /* record largest changes.  Reps from other shards have been recorded
+   * when reading the shards they belong to. */
+  if (text && text->ref_count == 1 && !is_external_rep(query, text))
     add_change(query->stats, text->size, text->expanded_size, text->revision,
                noderev->created_path, text->kind, !noderev->predecessor_id);
-  if (props && props->ref_count == 1)
+  if (props && props->ref_count == 1 && !is_external_rep(query, props))
     add_change(query->stats, props->size, props->expanded_size,
                props->revision, noderev->created_path, props->kind,
                !noderev->predecessor_id);
@@ -657,6 +779,7 @@ read_noderev(query_t *query,
   /* if this is a directory and has not been processed, yet, read and
    * process it recursively */
   if (   noderev->kind == svn_node_dir && text && text->ref_count == 1
+      && !is_external_rep(query, text)
       && !svn_fs_fs__use_log_addressing(query->fs))
     SVN_ERR(parse_dir(query, noderev, revision_info, result_pool,
                       scratch_pool));
@@ -817,10 +940,6 @@ read_phys_pack_file(query_t *query,
   /* Done with this pack file. */
   SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
 
-  /* one more pack file processed */
-  if (query->progress_func)
-    query->progress_func(base, query->progress_baton, scratch_pool);
-
   return SVN_NO_ERROR;
 }
 
@@ -866,15 +985,6 @@ read_phys_revision_file(query_t *query,
   /* put it into our container */
   APR_ARRAY_PUSH(query->revisions, revision_info_t*) = info;
 
-  /* show progress every 1000 revs or so */
-  if (query->progress_func)
-    {
-      if (query->shard_size && (revision % query->shard_size == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-      if (!query->shard_size && (revision % 1000 == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-    }
-
   return SVN_NO_ERROR;
 }
 
@@ -940,7 +1050,8 @@ compare_representation_refs(const void *lhs, const void *rhs)
 
 /* Given all the presentations found in a single rev / pack file as
  * rep_ref_t * in REP_REFS, update the delta chain lengths in QUERY.
- * REP_REFS and its contents can then be discarded.
+ * Links to bases that QUERY cannot resolve get deferred.  REP_REFS and
+ * its contents can then be discarded.
  */
 static svn_error_t *
 resolve_representation_refs(query_t *query,
@@ -978,10 +1089,19 @@ resolve_representation_refs(query_t *query,
 
           base = find_representation(&idx, query, NULL, ref->base_revision,
                                      ref->base_item_index);
-          SVN_ERR_ASSERT(base);
-          SVN_ERR_ASSERT(base->chain_length);
-
-          rep->chain_length = 1 + MIN(base->chain_length, (apr_byte_t)0xfe);
+          if (base && base->chain_length)
+            {
+              rep->chain_length = 1 + MIN(base->chain_length,
+                                          (apr_byte_t)0xfe);
+            }
+          else
+            {
+              /* Only bases outside of QUERY may be unknown. */
+              SVN_ERR_ASSERT(   base
+                             || ref->base_revision < query->first_revision);
+              defer_chain_length(query, ref->revision, ref->item_index,
+                                 ref->base_revision, ref->base_item_index);
+            }
         }
     }
 
@@ -1034,7 +1154,8 @@ read_log_rev_or_packfile(query_t *query,
 
   /* record the whole pack size in the first rev so the total sum will
      still be correct */
-  APR_ARRAY_IDX(query->revisions, base, revision_info_t*)->end = max_offset;
+  APR_ARRAY_IDX(query->revisions, base - query->first_revision,
+                revision_info_t*)->end = max_offset;
 
   /* for all offsets in the file, get the P2L index entries and process
      the interesting items (change lists, noderevs) */
@@ -1070,7 +1191,8 @@ read_log_rev_or_packfile(query_t *query,
             continue;
 
           /* read and process interesting items */
-          info = APR_ARRAY_IDX(query->revisions, entry->item.revision,
+          info = APR_ARRAY_IDX(query->revisions,
+                               entry->item.revision - query->first_revision,
                                revision_info_t*);
 
           if (entry->type == SVN_FS_FS__ITEM_TYPE_NODEREV)
@@ -1146,14 +1268,9 @@ read_log_pack_file(query_t *query,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool)
 {
-  SVN_ERR(read_log_rev_or_packfile(query, base, query->shard_size,
-                                   result_pool, scratch_pool));
-
-  /* one more pack file processed */
-  if (query->progress_func)
-    query->progress_func(base, query->progress_baton, scratch_pool);
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(read_log_rev_or_packfile(query, base,
+                                                 query->shard_size,
+                                                 result_pool, scratch_pool));
 }
 
 /* Read the content of the file for REVISION in logical addressing mode
@@ -1168,22 +1285,12 @@ read_log_revision_file(query_t *query,
                        apr_pool_t *result_pool,
                        apr_pool_t *scratch_pool)
 {
-  SVN_ERR(read_log_rev_or_packfile(query, revision, 1,
-                                   result_pool, scratch_pool));
-
-  /* show progress every 1000 revs or so */
-  if (query->progress_func)
-    {
-      if (query->shard_size && (revision % query->shard_size == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-      if (!query->shard_size && (revision % 1000 == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-    }
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(read_log_rev_or_packfile(query, revision, 1,
+                                                 result_pool, scratch_pool));
 }
 
-/* Read the repository and collect the stats info in QUERY.
+/* Read the revisions FIRST_REVISION to HEAD in QUERY and collect the
+ * stats info in QUERY.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
@@ -1197,8 +1304,8 @@ read_revisions(query_t *query,
   svn_revnum_t revision;
 
   /* read all packed revs */
-  for ( revision = 0
-      ; revision < query->min_unpacked_rev
+  for ( revision = query->first_revision
+      ; revision < query->min_unpacked_rev && revision <= query->head
       ; revision += query->shard_size)
     {
       svn_pool_clear(iterpool);
@@ -1360,8 +1467,12 @@ create_query(query_t **query,
    * of both the nelts field of the array and our revision numbers). This
    * means this code will fail on platforms where int is less than 32-bits
    * and the repository has more revisions than int can hold. */
+  (*query)->first_revision = 0;
   (*query)->revisions = apr_array_make(result_pool, (int) (*query)->head + 1,
                                        sizeof(revision_info_t *));
+  (*query)->deferred_refs = apr_array_make(result_pool, 0,
+                                           sizeof(rep_ref_t *));
+  (*query)->external_reps = apr_hash_make(result_pool);
   (*query)->null_base = apr_pcalloc(result_pool,
                                     sizeof(*(*query)->null_base));
 
@@ -1376,9 +1487,913 @@ create_query(query_t **query,
   return SVN_NO_ERROR;
 }
 
+/* Return the last revision of the shard in QUERY that starts at REVISION.
+ * Non-sharded repositories get processed in blocks of 1000 revisions.
+ */
+static svn_revnum_t
+get_shard_end(query_t *query,
+              svn_revnum_t revision)
+{
+  svn_revnum_t size = query->shard_size ? query->shard_size : 1000;
+
+  return MIN(query->head, revision - revision % size + size - 1);
+}
+
+/* Return a query, allocated in RESULT_POOL, that reads the shard starting
+ * at FIRST_REVISION of the repository described by QUERY from FS and
+ * collects its results in a stats object of its own.  Progress will not
+ * be reported.
+ */
+static query_t *
+create_shard_query(query_t *query,
+                   svn_fs_t *fs,
+                   svn_revnum_t first_revision,
+                   apr_pool_t *result_pool)
+{
+  query_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  svn_revnum_t last_revision = get_shard_end(query, first_revision);
+
+  result->fs = fs;
+  result->head = last_revision;
+  result->shard_size = query->shard_size;
+  result->min_unpacked_rev = query->min_unpacked_rev;
+  result->first_revision = first_revision;
+  result->revisions = apr_array_make(result_pool,
+                                     (int)(last_revision - first_revision + 1),
+                                     sizeof(revision_info_t *));
+  result->deferred_refs = apr_array_make(result_pool, 16,
+                                         sizeof(rep_ref_t *));
+  result->external_reps = apr_hash_make(result_pool);
+  result->null_base = query->null_base;
+  result->stats = create_stats(result_pool);
+  result->cancel_func = query->cancel_func;
+  result->cancel_baton = query->cancel_baton;
+
+  return result;
+}
+
+/* Add the contents of the histogram SOURCE to TARGET.
+ */
+static void
+add_histogram(svn_fs_fs__histogram_t *target,
+              const svn_fs_fs__histogram_t *source)
+{
+  int i;
+
+  target->total.count += source->total.count;
+  target->total.sum += source->total.sum;
+  for (i = 0; i < 64; ++i)
+    {
+      target->lines[i].count += source->lines[i].count;
+      target->lines[i].sum += source->lines[i].sum;
+    }
+}
+
+/* Number of histograms in svn_fs_fs__stats_t, not counting the ones per
+ * file extension. */
+#define HISTOGRAM_COUNT 13
+
+/* Set the HISTOGRAM_COUNT elements of HISTOGRAMS to the histograms in
+ * STATS.  The order is always the same.
+ */
+static void
+get_histograms(svn_fs_fs__histogram_t *histograms[HISTOGRAM_COUNT],
+               svn_fs_fs__stats_t *stats)
+{
+  histograms[0] = &stats->rep_size_histogram;
+  histograms[1] = &stats->node_size_histogram;
+  histograms[2] = &stats->added_rep_size_histogram;
+  histograms[3] = &stats->added_node_size_histogram;
+  histograms[4] = &stats->unused_rep_histogram;
+  histograms[5] = &stats->file_histogram;
+  histograms[6] = &stats->file_rep_histogram;
+  histograms[7] = &stats->file_prop_histogram;
+  histograms[8] = &stats->file_prop_rep_histogram;
+  histograms[9] = &stats->dir_histogram;
+  histograms[10] = &stats->dir_rep_histogram;
+  histograms[11] = &stats->dir_prop_histogram;
+  histograms[12] = &stats->dir_prop_rep_histogram;
+}
+
+/* Add the per-change data collected in SOURCE, i.e. histograms and the
+ * largest changes, to TARGET.  Use SCRATCH_POOL for temporary allocations.
+ */
+static void
+merge_stats(svn_fs_fs__stats_t *target,
+            svn_fs_fs__stats_t *source,
+            apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__histogram_t *target_histograms[HISTOGRAM_COUNT];
+  svn_fs_fs__histogram_t *source_histograms[HISTOGRAM_COUNT];
+  apr_hash_index_t *hi;
+  apr_size_t i;
+
+  get_histograms(target_histograms, target);
+  get_histograms(source_histograms, source);
+  for (i = 0; i < HISTOGRAM_COUNT; ++i)
+    add_histogram(target_histograms[i], source_histograms[i]);
+
+  /* SOURCE's list is sorted by size, so we can stop at its first entry
+   * that is too small for TARGET. */
+  for (i = 0; i < source->largest_changes->count; ++i)
+    {
+      svn_fs_fs__large_change_info_t *change
+        = source->largest_changes->changes[i];
+
+      if (   change->revision == SVN_INVALID_REVNUM
+          || change->size < target->largest_changes->min_size)
+        break;
+
+      add_large_change(target, change->size, change->revision,
+                       change->path->data);
+    }
+
+  for (hi = apr_hash_first(scratch_pool, source->by_extension);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_fs_fs__extension_info_t *source_info = apr_hash_this_val(hi);
+      svn_fs_fs__extension_info_t *info
+        = get_extension_info(target, source_info->extension);
+
+      add_histogram(&info->rep_histogram, &source_info->rep_histogram);
+      add_histogram(&info->node_histogram, &source_info->node_histogram);
+    }
+}
+
+/* Append the results of the single-shard query SHARD to QUERY, which must
+ * already contain all revisions before that shard.  Resolve the references
+ * to earlier shards in the process.  Allocate the copied data in
+ * RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+merge_shard(query_t *query,
+            query_t *shard,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+  int i, k;
+
+  /* Copy the revisions and their representations. */
+  for (i = 0; i < shard->revisions->nelts; ++i)
+    {
+      revision_info_t *source = APR_ARRAY_IDX(shard->revisions, i,
+                                              revision_info_t *);
+      revision_info_t *info = apr_pmemdup(result_pool, source,
+                                          sizeof(*info));
+      int count = source->representations->nelts;
+      rep_stats_t *reps = apr_palloc(result_pool, count * sizeof(*reps));
+
+      SVN_ERR_ASSERT(info->revision
+                     == query->first_revision + query->revisions->nelts);
+
+      info->representations = apr_array_make(result_pool, count,
+                                             sizeof(rep_stats_t *));
+      for (k = 0; k < count; ++k)
+        {
+          reps[k] = *APR_ARRAY_IDX(source->representations, k,
+                                   rep_stats_t *);
+          APR_ARRAY_PUSH(info->representations, rep_stats_t *) = &reps[k];
+        }
+
+      APR_ARRAY_PUSH(query->revisions, revision_info_t *) = info;
+    }
+
+  /* Count the references to representations in earlier shards. */
+  for (hi = apr_hash_first(scratch_pool, shard->external_reps);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      rep_stats_t *external = apr_hash_this_val(hi);
+      revision_info_t *info = NULL;
+      int idx;
+      rep_stats_t *rep = find_representation(&idx, query, &info,
+                                             external->revision,
+                                             external->item_index);
+
+      if (rep)
+        {
+          if (rep->ref_count == 0)
+            rep->kind = external->kind;
+
+          rep->ref_count += external->ref_count;
+        }
+      else if (info)
+        {
+          /* Not referenced by its own revision.  We don't know its
+           * delta base anymore. */
+          rep = apr_pmemdup(result_pool, external, sizeof(*rep));
+          rep->chain_length = 1;
+          svn_sort__array_insert(info->representations, &rep, idx);
+        }
+    }
+
+  /* Now, all delta bases are known.  The links are in revision order. */
+  for (i = 0; i < shard->deferred_refs->nelts; ++i)
+    {
+      rep_ref_t *ref = APR_ARRAY_IDX(shard->deferred_refs, i, rep_ref_t *);
+      int idx;
+      rep_stats_t *rep = find_representation(&idx, query, NULL,
+                                             ref->revision, ref->item_index);
+      rep_stats_t *base = find_representation(&idx, query, NULL,
+                                              ref->base_revision,
+                                              ref->base_item_index);
+
+      SVN_ERR_ASSERT(rep && !rep->chain_length);
+      rep->chain_length = 1 + MIN(base ? base->chain_length : 0,
+                                  (apr_byte_t)0xfe);
+    }
+
+  merge_stats(query->stats, shard->stats, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Per-shard summaries.
+ *
+ * Reading a shard produces a revision_info_t per revision plus a few
+ * items that depend on earlier shards.  For packed shards, all of this
+ * can be stored in a summary file and reused as long as the pack file
+ * has neither been replaced nor modified.  That saves us from reading
+ * the same old shards over and over.
+ */
+
+/* Format number of the summary files. */
+#define SUMMARY_FORMAT 1
+
+/* Return a new top-level integer stream in ROOT with SUBSTREAMS
+ * sub-streams.  SIGNED_INTS is passed through to the sub-streams.
+ */
+static svn_packed__int_stream_t *
+create_int_stream(svn_packed__data_root_t *root,
+                  int substreams,
+                  svn_boolean_t signed_ints)
+{
+  svn_packed__int_stream_t *stream
+    = svn_packed__create_int_stream(root, FALSE, signed_ints);
+  int i;
+
+  for (i = 0; i < substreams; ++i)
+    svn_packed__create_int_substream(stream, FALSE, signed_ints);
+
+  return stream;
+}
+
+/* Write HISTOGRAM to STREAM.
+ */
+static void
+write_histogram(svn_packed__int_stream_t *stream,
+                const svn_fs_fs__histogram_t *histogram)
+{
+  int i;
+
+  svn_packed__add_uint(stream, histogram->total.count);
+  svn_packed__add_uint(stream, histogram->total.sum);
+  for (i = 0; i < 64; ++i)
+    {
+      svn_packed__add_uint(stream, histogram->lines[i].count);
+      svn_packed__add_uint(stream, histogram->lines[i].sum);
+    }
+}
+
+/* Read HISTOGRAM from STREAM.
+ */
+static void
+read_histogram(svn_fs_fs__histogram_t *histogram,
+               svn_packed__int_stream_t *stream)
+{
+  int i;
+
+  histogram->total.count = svn_packed__get_uint(stream);
+  histogram->total.sum = svn_packed__get_uint(stream);
+  for (i = 0; i < 64; ++i)
+    {
+      histogram->lines[i].count = svn_packed__get_uint(stream);
+      histogram->lines[i].sum = svn_packed__get_uint(stream);
+    }
+}
+
+/* Write the results of the single-shard QUERY to the summary file at PATH.
+ * The shard's pack file had PACK_SIZE bytes and had been modified last at
+ * PACK_MTIME.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_shard_summary(query_t *query,
+                    const char *path,
+                    svn_filesize_t pack_size,
+                    apr_time_t pack_mtime,
+                    apr_pool_t *scratch_pool)
+{
+  svn_packed__data_root_t *root = svn_packed__data_create_root(scratch_pool);
+  svn_packed__int_stream_t *header_stream = create_int_stream(root, 0, TRUE);
+  svn_packed__int_stream_t *revs_stream = create_int_stream(root, 9, FALSE);
+  svn_packed__int_stream_t *reps_stream = create_int_stream(root, 7, FALSE);
+  svn_packed__int_stream_t *refs_stream = create_int_stream(root, 4, FALSE);
+  svn_packed__int_stream_t *external_stream
+    = create_int_stream(root, 6, FALSE);
+  svn_packed__int_stream_t *histogram_stream
+    = create_int_stream(root, 2, FALSE);
+  svn_packed__int_stream_t *changes_stream
+    = create_int_stream(root, 2, TRUE);
+  svn_packed__byte_stream_t *uuid_stream
+    = svn_packed__create_bytes_stream(root);
+  svn_packed__byte_stream_t *paths_stream
+    = svn_packed__create_bytes_stream(root);
+  svn_packed__byte_stream_t *extensions_stream
+    = svn_packed__create_bytes_stream(root);
+
+  svn_fs_fs__histogram_t *histograms[HISTOGRAM_COUNT];
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(scratch_pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(contents, scratch_pool);
+  apr_hash_index_t *hi;
+  apr_size_t i;
+  int r, k;
+
+  /* The key that must match when reading the summary. */
+  svn_packed__add_int(header_stream, SUMMARY_FORMAT);
+  svn_packed__add_int(header_stream, query->first_revision);
+  svn_packed__add_int(header_stream, query->revisions->nelts);
+  svn_packed__add_int(header_stream, pack_size);
+  svn_packed__add_int(header_stream, pack_mtime);
+  svn_packed__add_bytes(uuid_stream, query->fs->uuid,
+                        strlen(query->fs->uuid));
+
+  /* Revisions and their representations. */
+  for (r = 0; r < query->revisions->nelts; ++r)
+    {
+      revision_info_t *info = APR_ARRAY_IDX(query->revisions, r,
+                                            revision_info_t *);
+
+      svn_packed__add_uint(revs_stream, info->offset);
+      svn_packed__add_uint(revs_stream, info->end);
+      svn_packed__add_uint(revs_stream, info->changes_len);
+      svn_packed__add_uint(revs_stream, info->change_count);
+      svn_packed__add_uint(revs_stream, info->dir_noderev_count);
+      svn_packed__add_uint(revs_stream, info->file_noderev_count);
+      svn_packed__add_uint(revs_stream, info->dir_noderev_size);
+      svn_packed__add_uint(revs_stream, info->file_noderev_size);
+      svn_packed__add_uint(revs_stream, info->representations->nelts);
+
+      for (k = 0; k < info->representations->nelts; ++k)
+        {
+          rep_stats_t *rep = APR_ARRAY_IDX(info->representations, k,
+                                           rep_stats_t *);
+
+          svn_packed__add_uint(reps_stream, rep->item_index);
+          svn_packed__add_uint(reps_stream, rep->size);
+          svn_packed__add_uint(reps_stream, rep->expanded_size);
+          svn_packed__add_uint(reps_stream, rep->ref_count);
+          svn_packed__add_uint(reps_stream, rep->header_size);
+          svn_packed__add_uint(reps_stream, rep->kind);
+          svn_packed__add_uint(reps_stream, rep->chain_length);
+        }
+    }
+
+  /* Links to earlier shards. */
+  for (k = 0; k < query->deferred_refs->nelts; ++k)
+    {
+      rep_ref_t *ref = APR_ARRAY_IDX(query->deferred_refs, k, rep_ref_t *);
+
+      svn_packed__add_uint(refs_stream, ref->revision);
+      svn_packed__add_uint(refs_stream, ref->item_index);
+      svn_packed__add_uint(refs_stream, ref->base_revision);
+      svn_packed__add_uint(refs_stream, ref->base_item_index);
+    }
+
+  for (hi = apr_hash_first(scratch_pool, query->external_reps);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      rep_stats_t *rep = apr_hash_this_val(hi);
+
+      svn_packed__add_uint(external_stream, rep->revision);
+      svn_packed__add_uint(external_stream, rep->item_index);
+      svn_packed__add_uint(external_stream, rep->size);
+      svn_packed__add_uint(external_stream, rep->expanded_size);
+      svn_packed__add_uint(external_stream, rep->ref_count);
+      svn_packed__add_uint(external_stream, rep->kind);
+    }
+
+  /* Per-change data. */
+  get_histograms(histograms, query->stats);
+  for (i = 0; i < HISTOGRAM_COUNT; ++i)
+    write_histogram(histogram_stream, histograms[i]);
+
+  for (hi = apr_hash_first(scratch_pool, query->stats->by_extension);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_fs_fs__extension_info_t *info = apr_hash_this_val(hi);
+
+      svn_packed__add_bytes(extensions_stream, info->extension,
+                            strlen(info->extension));
+      write_histogram(histogram_stream, &info->rep_histogram);
+      write_histogram(histogram_stream, &info->node_histogram);
+    }
+
+  for (i = 0; i < query->stats->largest_changes->count; ++i)
+    {
+      svn_fs_fs__large_change_info_t *change
+        = query->stats->largest_changes->changes[i];
+
+      if (change->revision == SVN_INVALID_REVNUM)
+        break;
+
+      svn_packed__add_int(changes_stream, change->size);
+      svn_packed__add_int(changes_stream, change->revision);
+      svn_packed__add_bytes(paths_stream, change->path->data,
+                            change->path->len);
+    }
+
+  /* Replace the old summary, if any. */
+  SVN_ERR(svn_packed__data_write(stream, root, scratch_pool));
+  SVN_ERR(svn_io_write_atomic2(path, contents->data, contents->len, NULL,
+                               FALSE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return an error about the corrupt summary file at PATH.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+corrupt_summary(const char *path,
+                apr_pool_t *scratch_pool)
+{
+  return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                           _("Stats summary '%s' is corrupt"),
+                           svn_dirent_local_style(path, scratch_pool));
+}
+
+/* Read the results of the single-shard QUERY from the summary file at
+ * PATH and set *FOUND.  If the summary does not belong to the shard's
+ * pack file of PACK_SIZE bytes last modified at PACK_MTIME, set *FOUND to
+ * FALSE and leave QUERY untouched.  The same happens upon error.
+ * Allocate the results in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+read_shard_summary(svn_boolean_t *found,
+                   query_t *query,
+                   const char *path,
+                   svn_filesize_t pack_size,
+                   apr_time_t pack_mtime,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  svn_packed__data_root_t *root;
+  svn_packed__int_stream_t *header_stream, *revs_stream, *reps_stream;
+  svn_packed__int_stream_t *refs_stream, *external_stream;
+  svn_packed__int_stream_t *histogram_stream, *changes_stream;
+  svn_packed__byte_stream_t *uuid_stream, *paths_stream, *extensions_stream;
+
+  svn_fs_fs__histogram_t *histograms[HISTOGRAM_COUNT];
+  svn_fs_fs__stats_t *stats;
+  apr_array_header_t *revisions, *deferred_refs;
+  apr_hash_t *external_reps;
+  svn_stream_t *stream;
+  const char *uuid;
+  apr_size_t len, i, count;
+
+  *found = FALSE;
+
+  SVN_ERR(svn_stream_open_readonly(&stream, path, scratch_pool,
+                                   scratch_pool));
+  SVN_ERR(svn_packed__data_read(&root, stream, scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  header_stream = svn_packed__first_int_stream(root);
+  revs_stream = svn_packed__next_int_stream(header_stream);
+  reps_stream = svn_packed__next_int_stream(revs_stream);
+  refs_stream = svn_packed__next_int_stream(reps_stream);
+  external_stream = svn_packed__next_int_stream(refs_stream);
+  histogram_stream = svn_packed__next_int_stream(external_stream);
+  changes_stream = svn_packed__next_int_stream(histogram_stream);
+  uuid_stream = svn_packed__first_byte_stream(root);
+  paths_stream = svn_packed__next_byte_stream(uuid_stream);
+  extensions_stream = svn_packed__next_byte_stream(paths_stream);
+  if (!changes_stream || !extensions_stream)
+    return svn_error_trace(corrupt_summary(path, scratch_pool));
+
+  /* Is this our summary and still up-to-date? */
+  uuid = svn_packed__get_bytes(uuid_stream, &len);
+  if (   svn_packed__get_int(header_stream) != SUMMARY_FORMAT
+      || svn_packed__get_int(header_stream) != query->first_revision
+      || svn_packed__get_int(header_stream) != query->shard_size
+      || svn_packed__get_int(header_stream) != pack_size
+      || svn_packed__get_int(header_stream) != pack_mtime
+      || len != strlen(query->fs->uuid)
+      || memcmp(uuid, query->fs->uuid, len))
+    return SVN_NO_ERROR;
+
+  /* Revisions and their representations. */
+  count = svn_packed__int_count(svn_packed__first_int_substream(revs_stream));
+  if (count != (apr_size_t)query->shard_size)
+    return svn_error_trace(corrupt_summary(path, scratch_pool));
+
+  revisions = apr_array_make(result_pool, (int)count,
+                             sizeof(revision_info_t *));
+  for (i = 0; i < count; ++i)
+    {
+      revision_info_t *info = apr_pcalloc(result_pool, sizeof(*info));
+      apr_size_t rep_count, k;
+
+      info->revision = query->first_revision + (svn_revnum_t)i;
+      info->offset = (apr_off_t)svn_packed__get_uint(revs_stream);
+      info->end = (apr_off_t)svn_packed__get_uint(revs_stream);
+      info->changes_len = svn_packed__get_uint(revs_stream);
+      info->change_count = svn_packed__get_uint(revs_stream);
+      info->dir_noderev_count = svn_packed__get_uint(revs_stream);
+      info->file_noderev_count = svn_packed__get_uint(revs_stream);
+      info->dir_noderev_size = svn_packed__get_uint(revs_stream);
+      info->file_noderev_size = svn_packed__get_uint(revs_stream);
+
+      rep_count = (apr_size_t)svn_packed__get_uint(revs_stream);
+      if (rep_count > svn_packed__int_count(
+                        svn_packed__first_int_substream(reps_stream)))
+        return svn_error_trace(corrupt_summary(path, scratch_pool));
+
+      info->representations = apr_array_make(result_pool, (int)rep_count,
+                                             sizeof(rep_stats_t *));
+      for (k = 0; k < rep_count; ++k)
+        {
+          rep_stats_t *rep = apr_pcalloc(result_pool, sizeof(*rep));
+
+          rep->revision = info->revision;
+          rep->item_index = svn_packed__get_uint(reps_stream);
+          rep->size = svn_packed__get_uint(reps_stream);
+          rep->expanded_size = svn_packed__get_uint(reps_stream);
+          rep->ref_count = (apr_uint32_t)svn_packed__get_uint(reps_stream);
+          rep->header_size = (apr_uint16_t)svn_packed__get_uint(reps_stream);
+          rep->kind = (char)svn_packed__get_uint(reps_stream);
+          rep->chain_length = (apr_byte_t)svn_packed__get_uint(reps_stream);
+
+          APR_ARRAY_PUSH(info->representations, rep_stats_t *) = rep;
+        }
+
+      APR_ARRAY_PUSH(revisions, revision_info_t *) = info;
+    }
+
+  /* Links to earlier shards. */
+  count = svn_packed__int_count(svn_packed__first_int_substream(refs_stream));
+  deferred_refs = apr_array_make(result_pool, (int)count,
+                                 sizeof(rep_ref_t *));
+  for (i = 0; i < count; ++i)
+    {
+      rep_ref_t *ref = apr_pcalloc(result_pool, sizeof(*ref));
+
+      ref->revision = (svn_revnum_t)svn_packed__get_uint(refs_stream);
+      ref->item_index = svn_packed__get_uint(refs_stream);
+      ref->base_revision = (svn_revnum_t)svn_packed__get_uint(refs_stream);
+      ref->base_item_index = svn_packed__get_uint(refs_stream);
+
+      APR_ARRAY_PUSH(deferred_refs, rep_ref_t *) = ref;
+    }
+
+  count = svn_packed__int_count(
+            svn_packed__first_int_substream(external_stream));
+  external_reps = apr_hash_make(result_pool);
+  for (i = 0; i < count; ++i)
+    {
+      rep_stats_t *rep = apr_pcalloc(result_pool, sizeof(*rep));
+
+      rep->revision = (svn_revnum_t)svn_packed__get_uint(external_stream);
+      rep->item_index = svn_packed__get_uint(external_stream);
+      rep->size = svn_packed__get_uint(external_stream);
+      rep->expanded_size = svn_packed__get_uint(external_stream);
+      rep->ref_count = (apr_uint32_t)svn_packed__get_uint(external_stream);
+      rep->kind = (char)svn_packed__get_uint(external_stream);
+
+      svn_hash_sets(external_reps,
+                    apr_psprintf(result_pool, "%ld:%" APR_UINT64_T_FMT,
+                                 rep->revision, rep->item_index),
+                    rep);
+    }
+
+  /* Per-change data. */
+  count = svn_packed__byte_block_count(extensions_stream);
+  if (svn_packed__int_count(svn_packed__first_int_substream(histogram_stream))
+      != 65 * (HISTOGRAM_COUNT + 2 * count))
+    return svn_error_trace(corrupt_summary(path, scratch_pool));
+
+  stats = create_stats(result_pool);
+  get_histograms(histograms, stats);
+  for (i = 0; i < HISTOGRAM_COUNT; ++i)
+    read_histogram(histograms[i], histogram_stream);
+
+  for (i = 0; i < count; ++i)
+    {
+      const char *extension = svn_packed__get_bytes(extensions_stream, &len);
+      svn_fs_fs__extension_info_t *info
+        = get_extension_info(stats, apr_pstrmemdup(scratch_pool, extension,
+                                                   len));
+
+      read_histogram(&info->rep_histogram, histogram_stream);
+      read_histogram(&info->node_histogram, histogram_stream);
+    }
+
+  count = svn_packed__byte_block_count(paths_stream);
+  for (i = 0; i < count; ++i)
+    {
+      const char *path_data = svn_packed__get_bytes(paths_stream, &len);
+      apr_uint64_t size = (apr_uint64_t)svn_packed__get_int(changes_stream);
+      svn_revnum_t revision
+        = (svn_revnum_t)svn_packed__get_int(changes_stream);
+
+      add_large_change(stats, size, revision,
+                       apr_pstrmemdup(scratch_pool, path_data, len));
+    }
+
+  /* All good.  Use the results. */
+  query->revisions = revisions;
+  query->deferred_refs = deferred_refs;
+  query->external_reps = external_reps;
+  query->stats = stats;
+  *found = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read all revisions covered by the single-shard QUERY.  If CACHE_DIR is
+ * not NULL and the shard has been packed, use the summary in CACHE_DIR if
+ * it is up-to-date and write a new one otherwise.  Allocate the results
+ * in RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_shard(query_t *query,
+           const char *cache_dir,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  const char *summary_path = NULL;
+  apr_finfo_t finfo;
+
+  if (cache_dir && query->first_revision < query->min_unpacked_rev)
+    {
+      const char *pack_path
+        = svn_fs_fs__path_rev_packed(query->fs, query->first_revision,
+                                     PATH_PACKED, scratch_pool);
+      svn_boolean_t found;
+      svn_error_t *err;
+
+      SVN_ERR(svn_io_stat(&finfo, pack_path,
+                          APR_FINFO_SIZE | APR_FINFO_MTIME, scratch_pool));
+      summary_path = svn_dirent_join(cache_dir,
+                                     apr_psprintf(scratch_pool, "%ld.stats",
+                                                  query->first_revision
+                                                  / query->shard_size),
+                                     scratch_pool);
+
+      /* A missing or unusable summary only means more work for us. */
+      err = read_shard_summary(&found, query, summary_path, finfo.size,
+                               finfo.mtime, result_pool, scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          found = FALSE;
+        }
+
+      if (found)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(read_revisions(query, result_pool, scratch_pool));
+
+  if (summary_path)
+    SVN_ERR(write_shard_summary(query, summary_path, finfo.size,
+                                finfo.mtime, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read all shards of the repository described by QUERY one after another
+ * and collect the results in QUERY.  CACHE_DIR is the optional location
+ * of the shard summaries.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_shards(query_t *query,
+            const char *cache_dir,
+            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t revision;
+
+  for (revision = 0;
+       revision <= query->head;
+       revision = get_shard_end(query, revision) + 1)
+    {
+      query_t *shard;
+
+      svn_pool_clear(iterpool);
+
+      shard = create_shard_query(query, query->fs, revision, iterpool);
+      SVN_ERR(read_shard(shard, cache_dir, iterpool, iterpool));
+      SVN_ERR(merge_shard(query, shard, scratch_pool, iterpool));
+
+      /* one more shard processed */
+      if (query->progress_func)
+        query->progress_func(revision, query->progress_baton, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+
+/* Concurrent reading.
+ *
+ * Shards get read independently from each other, i.e. any dependency on
+ * earlier shards gets resolved when merging the results.  Hence, we can
+ * read several shards at once, each in its own thread.  The calling thread
+ * merges the results strictly in shard order.
+ *
+ * The FS-specific caches are not thread-safe.  So, every worker uses its
+ * own copy of the svn_fs_t.
+ */
+
+/* A single shard being read by a worker thread.
+ */
+typedef struct stats_job_t
+{
+  /* First revision of the shard. */
+  svn_revnum_t first_revision;
+
+  /* Query reading the shard, using a private copy of the filesystem. */
+  query_t *query;
+
+  /* Optional directory containing the shard summaries. */
+  const char *cache_dir;
+
+  /* Root pool owned by this job.  Only the worker thread may use it
+   * until the thread has been joined. */
+  apr_pool_t *pool;
+
+  /* The worker thread.  NULL if it could not be started. */
+  apr_thread_t *thread;
+
+  /* Result of the reading.  Valid after the thread has been joined. */
+  svn_error_t *err;
+} stats_job_t;
+
+/* Thread function reading the shard of the stats_job_t in DATA.
+ */
+static void * APR_THREAD_FUNC
+stats_thread_func(apr_thread_t *tid,
+                  void *data)
+{
+  stats_job_t *job = data;
+
+  job->err = read_shard(job->query, job->cache_dir, job->pool, job->pool);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Initialize JOB for reading the shard starting at FIRST_REVISION of the
+ * repository described by QUERY and start its worker thread.  CACHE_DIR
+ * is the optional location of the shard summaries.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+start_stats_job(stats_job_t *job,
+                query_t *query,
+                svn_revnum_t first_revision,
+                const char *cache_dir,
+                apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs;
+  apr_status_t status;
+
+  memset(job, 0, sizeof(*job));
+  job->first_revision = first_revision;
+  job->cache_dir = cache_dir;
+  job->pool = svn_pool_create(NULL);
+
+  SVN_ERR(svn_fs_fs__clone_fs(&fs, query->fs, job->pool));
+  job->query = create_shard_query(query, fs, first_revision, job->pool);
+
+  status = apr_thread_create(&job->thread, NULL, stats_thread_func, job,
+                             scratch_pool);
+  if (status)
+    {
+      job->thread = NULL;
+      return svn_error_wrap_apr(status, _("Can't create thread"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the worker of JOB to finish.  Unless QUERY is NULL, merge the
+ * results into QUERY, allocated in RESULT_POOL.  Release all resources
+ * held by JOB.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+finish_stats_job(stats_job_t *job,
+                 query_t *query,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  if (job->thread)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, job->thread);
+    }
+
+  err = job->err;
+  if (!err && query && job->thread)
+    err = merge_shard(query, job->query, result_pool, scratch_pool);
+
+  job->err = SVN_NO_ERROR;
+  job->thread = NULL;
+  if (job->pool)
+    {
+      svn_pool_destroy(job->pool);
+      job->pool = NULL;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Read all shards of the repository described by QUERY using up to JOBS
+ * worker threads and collect the results in QUERY.  CACHE_DIR is the
+ * optional location of the shard summaries.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+read_shards_concurrently(query_t *query,
+                         int jobs,
+                         const char *cache_dir,
+                         apr_pool_t *scratch_pool)
+{
+  stats_job_t *slots = apr_pcalloc(scratch_pool, jobs * sizeof(*slots));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t next_revision = 0;
+  int started = 0;
+  int finished;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* Fill all worker slots. */
+  while (!err && next_revision <= query->head && started < jobs)
+    {
+      err = start_stats_job(&slots[started], query, next_revision,
+                            cache_dir, scratch_pool);
+      next_revision = get_shard_end(query, next_revision) + 1;
+      ++started;
+    }
+
+  /* Merge the results in shard order and keep the slots busy.
+   * After an error, we still need to wait for all started jobs. */
+  for (finished = 0; finished < started; ++finished)
+    {
+      stats_job_t *job = &slots[finished % jobs];
+      svn_revnum_t revision = job->first_revision;
+
+      svn_pool_clear(iterpool);
+
+      if (err)
+        {
+          svn_error_clear(finish_stats_job(job, NULL, scratch_pool,
+                                           iterpool));
+          continue;
+        }
+
+      err = finish_stats_job(job, query, scratch_pool, iterpool);
+
+      /* one more shard processed */
+      if (!err && query->progress_func)
+        query->progress_func(revision, query->progress_baton, iterpool);
+
+      if (!err && query->cancel_func)
+        err = query->cancel_func(query->cancel_baton);
+
+      /* Re-use the slot for the next shard. */
+      if (!err && next_revision <= query->head)
+        {
+          err = start_stats_job(job, query, next_revision, cache_dir,
+                                scratch_pool);
+          next_revision = get_shard_end(query, next_revision) + 1;
+          ++started;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
+                     int jobs,
+                     const char *cache_dir,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
                      svn_cancel_func_t cancel_func,
@@ -1392,7 +2407,19 @@ svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
   SVN_ERR(create_query(&query, fs, *stats, progress_func, progress_baton,
                        cancel_func, cancel_baton, scratch_pool,
                        scratch_pool));
-  SVN_ERR(read_revisions(query, scratch_pool, scratch_pool));
+
+  if (cache_dir)
+    SVN_ERR(svn_io_make_dir_recursively(cache_dir, scratch_pool));
+
+#if APR_HAS_THREADS
+  /* Read several shards at once, if that has been requested and the
+     caches can be used safely from multiple threads. */
+  if (jobs > 1 && !svn_cache_config_get()->single_threaded)
+    SVN_ERR(read_shards_concurrently(query, jobs, cache_dir, scratch_pool));
+  else
+#endif
+    SVN_ERR(read_shards(query, cache_dir, scratch_pool));
+
   aggregate_stats(query->revisions, *stats);
 
   return SVN_NO_ERROR;
@@ -669,9 +669,17 @@ svn_fs_fs__serialize_revprops(void **data,
                               apr_pool_t *pool)
 {
   svn_string_t *buffer = in;
+  apr_hash_t *properties;
+  svn_stringbuf_t *serialized;
+
+  /* Always cache the binary encoding, which can be used in place. */
+  SVN_ERR(svn_fs_fs__parse_proplist(&properties, buffer, TRUE, pool));
+  serialized = svn_stringbuf_create_ensure(buffer->len, pool);
+  SVN_ERR(svn_fs_fs__write_binary_proplist(
+              svn_stream_from_stringbuf(serialized, pool), properties, pool));
 
-  *data = (void *)buffer->data;
-  *data_len = buffer->len;
+  *data = serialized->data;
+  *data_len = serialized->len;
 
   return SVN_NO_ERROR;
 }
@@ -683,16 +691,13 @@ svn_fs_fs__deserialize_revprops(void **out,
                                 apr_pool_t *pool)
 {
   apr_hash_t *properties;
-  svn_stream_t *stream;
 
   svn_string_t buffer;
   buffer.data = data;
   buffer.len = data_len;
 
-  stream = svn_stream_from_string(&buffer, pool);
-  properties = svn_hash__make(pool);
-
-  SVN_ERR(svn_hash_read2(properties, stream, SVN_HASH_TERMINATOR, pool));
+  /* DATA is ours, so we can use the property names and values in place. */
+  SVN_ERR(svn_fs_fs__parse_proplist(&properties, &buffer, TRUE, pool));
 
   /* done */
   *out = properties;
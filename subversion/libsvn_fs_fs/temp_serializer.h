@@ -156,8 +156,9 @@ svn_fs_fs__deserialize_properties(void **out,
                                   apr_pool_t *pool);
 
 /**
- * Implements #svn_cache__serialize_func_t for a properties hash
- * (@a in is an #apr_hash_t of svn_string_t elements, keyed by const char*).
+ * Implements #svn_cache__serialize_func_t for a revision properties list
+ * (@a in is the #svn_string_t with the list as stored on disk, in either
+ * encoding).  The binary property list encoding is used in the cache.
  */
 svn_error_t *
 svn_fs_fs__serialize_revprops(void **data,
@@ -168,6 +169,7 @@ svn_fs_fs__serialize_revprops(void **data,
 /**
  * Implements #svn_cache__deserialize_func_t for a properties hash
  * (@a *out is an #apr_hash_t of svn_string_t elements, keyed by const char*).
+ * Names and values point into @a data.
  */
 svn_error_t *
 svn_fs_fs__deserialize_revprops(void **out,
@@ -41,8 +41,13 @@
 #include "temp_serializer.h"
 #include "cached_data.h"
 #include "lock.h"
+#include "changed-paths-index.h"
+#include "revision-dates.h"
+#include "mergeinfo-index.h"
 #include "rep-cache.h"
+#include "txn-store.h"
 
+#include "private/svn_delta_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
@@ -507,6 +512,9 @@ svn_fs_fs__put_node_revision(svn_fs_t *fs,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   apr_file_t *noderev_file;
+  svn_stringbuf_t *buffer;
+  svn_boolean_t in_memory;
+  const char *path;
 
   noderev->is_fresh_txn_root = fresh_txn_root;
 
@@ -515,17 +523,24 @@ svn_fs_fs__put_node_revision(svn_fs_t *fs,
                              _("Attempted to write to non-transaction '%s'"),
                              svn_fs_fs__id_unparse(id, pool)->data);
 
-  SVN_ERR(svn_io_file_open(&noderev_file,
-                           svn_fs_fs__path_txn_node_rev(fs, id, pool),
-                           APR_WRITE | APR_CREATE | APR_TRUNCATE
-                           | APR_BUFFERED, APR_OS_DEFAULT, pool));
-
-  SVN_ERR(svn_fs_fs__write_noderev(svn_stream_from_aprfile2(noderev_file, TRUE,
-                                                            pool),
+  buffer = svn_stringbuf_create_ensure(256, pool);
+  SVN_ERR(svn_fs_fs__write_noderev(svn_stream_from_stringbuf(buffer, pool),
                                    noderev, ffd->format,
                                    svn_fs_fs__fs_supports_mergeinfo(fs),
                                    pool));
 
+  path = svn_fs_fs__path_txn_node_rev(fs, id, pool);
+  SVN_ERR(svn_fs_fs__txn_store_write(&in_memory, fs,
+                                     svn_fs_fs__id_txn_id(id), path,
+                                     buffer, FALSE, pool));
+  if (in_memory)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_file_open(&noderev_file, path,
+                           APR_WRITE | APR_CREATE | APR_TRUNCATE
+                           | APR_BUFFERED, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(noderev_file, buffer->data, buffer->len,
+                                 NULL, pool));
   SVN_ERR(svn_io_file_close(noderev_file, pool));
 
   return SVN_NO_ERROR;
@@ -900,7 +915,7 @@ svn_fs_fs__txn_changes_fetch(apr_hash_t **changed_paths_p,
                              const svn_fs_fs__id_part_t *txn_id,
                              apr_pool_t *pool)
 {
-  apr_file_t *file;
+  svn_stream_t *stream;
   apr_hash_t *changed_paths = apr_hash_make(pool);
   apr_pool_t *scratch_pool = svn_pool_create(pool);
   process_changes_baton_t baton;
@@ -908,16 +923,14 @@ svn_fs_fs__txn_changes_fetch(apr_hash_t **changed_paths_p,
   baton.changed_paths = changed_paths;
   baton.deletions = apr_hash_make(scratch_pool);
 
-  SVN_ERR(svn_io_file_open(&file,
-                           path_txn_changes(fs, txn_id, scratch_pool),
-                           APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
-                           scratch_pool));
-
-  SVN_ERR(svn_fs_fs__read_changes_incrementally(
-                                  svn_stream_from_aprfile2(file, TRUE,
-                                                           scratch_pool),
-                                  process_changes, &baton,
-                                  scratch_pool));
+  SVN_ERR(svn_fs_fs__txn_store_open_readonly(&stream, fs, txn_id,
+                                             path_txn_changes(fs, txn_id,
+                                                              scratch_pool),
+                                             scratch_pool, scratch_pool));
+
+  SVN_ERR(svn_fs_fs__read_changes_incrementally(stream,
+                                                process_changes, &baton,
+                                                scratch_pool));
   svn_pool_destroy(scratch_pool);
 
   *changed_paths_p = changed_paths;
@@ -1127,12 +1140,14 @@ svn_error_t *
 svn_fs_fs__create_txn(svn_fs_txn_t **txn_p,
                       svn_fs_t *fs,
                       svn_revnum_t rev,
+                      svn_boolean_t in_memory,
                       apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_fs_txn_t *txn;
   fs_txn_data_t *ftd;
   svn_fs_id_t *root_id;
+  svn_stringbuf_t *next_ids;
 
   txn = apr_pcalloc(pool, sizeof(*txn));
   ftd = apr_pcalloc(pool, sizeof(*ftd));
@@ -1150,6 +1165,10 @@ svn_fs_fs__create_txn(svn_fs_txn_t **txn_p,
   txn->fsap_data = ftd;
   *txn_p = txn;
 
+  /* Decide where to put the small files before writing any of them. */
+  if (in_memory)
+    SVN_ERR(svn_fs_fs__txn_store_add(fs, &ftd->txn_id));
+
   /* Create a new root node for this transaction. */
   SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, rev, pool, pool));
   SVN_ERR(create_new_txn_noderev_from_rev(fs, &ftd->txn_id, root_id, pool));
@@ -1165,12 +1184,27 @@ svn_fs_fs__create_txn(svn_fs_txn_t **txn_p,
                pool));
 
   /* Create an empty changes file. */
-  SVN_ERR(svn_io_file_create_empty(path_txn_changes(fs, &ftd->txn_id, pool),
-                                   pool));
+  SVN_ERR(svn_fs_fs__txn_store_write(&in_memory, fs, &ftd->txn_id,
+                                     path_txn_changes(fs, &ftd->txn_id,
+                                                      pool),
+                                     svn_stringbuf_create_empty(pool),
+                                     FALSE, pool));
+  if (!in_memory)
+    SVN_ERR(svn_io_file_create_empty(path_txn_changes(fs, &ftd->txn_id,
+                                                      pool),
+                                     pool));
 
   /* Create the next-ids file. */
-  return svn_io_file_create(path_txn_next_ids(fs, &ftd->txn_id, pool),
-                            "0 0\n", pool);
+  next_ids = svn_stringbuf_create("0 0\n", pool);
+  SVN_ERR(svn_fs_fs__txn_store_write(&in_memory, fs, &ftd->txn_id,
+                                     path_txn_next_ids(fs, &ftd->txn_id,
+                                                       pool),
+                                     next_ids, FALSE, pool));
+  if (!in_memory)
+    SVN_ERR(svn_io_file_create(path_txn_next_ids(fs, &ftd->txn_id, pool),
+                               next_ids->data, pool));
+
+  return SVN_NO_ERROR;
 }
 
 /* Store the property list for transaction TXN_ID in PROPLIST.
@@ -1192,8 +1226,10 @@ get_txn_proplist(apr_hash_t *proplist,
                               "passed to get_txn_proplist()"));
 
   /* Open the transaction properties file. */
-  SVN_ERR(svn_stream_open_readonly(&stream, path_txn_props(fs, txn_id, pool),
-                                   pool, pool));
+  SVN_ERR(svn_fs_fs__txn_store_open_readonly(&stream, fs, txn_id,
+                                             path_txn_props(fs, txn_id,
+                                                            pool),
+                                             pool, pool));
 
   /* Read in the property list. */
   err = svn_hash_read2(proplist, stream, SVN_HASH_TERMINATOR, pool);
@@ -1219,6 +1255,15 @@ set_txn_proplist(svn_fs_t *fs,
   svn_stream_t *tmp_stream;
   const char *tmp_path;
   const char *final_path = path_txn_props(fs, txn_id, pool);
+  svn_stringbuf_t *buffer = svn_stringbuf_create_ensure(256, pool);
+  svn_boolean_t in_memory;
+
+  SVN_ERR(svn_hash_write2(props, svn_stream_from_stringbuf(buffer, pool),
+                          SVN_HASH_TERMINATOR, pool));
+  SVN_ERR(svn_fs_fs__txn_store_write(&in_memory, fs, txn_id, final_path,
+                                     buffer, FALSE, pool));
+  if (in_memory)
+    return SVN_NO_ERROR;
 
   /* Write the new contents into a temporary file. */
   SVN_ERR(svn_stream_open_unique(&tmp_stream, &tmp_path,
@@ -1227,7 +1272,7 @@ set_txn_proplist(svn_fs_t *fs,
                                  pool, pool));
 
   /* Replace the old file with the new one. */
-  SVN_ERR(svn_hash_write2(props, tmp_stream, SVN_HASH_TERMINATOR, pool));
+  SVN_ERR(svn_stream_write(tmp_stream, buffer->data, &buffer->len));
   SVN_ERR(svn_stream_close(tmp_stream));
 
   SVN_ERR(svn_io_file_rename2(tmp_path, final_path, FALSE, pool));
@@ -1330,6 +1375,7 @@ write_next_ids(svn_fs_t *fs,
   apr_file_t *file;
   char buffer[2 * SVN_INT64_BUFFER_SIZE + 2];
   char *p = buffer;
+  svn_boolean_t in_memory;
 
   p += svn__ui64tobase36(p, node_id);
   *(p++) = ' ';
@@ -1337,6 +1383,15 @@ write_next_ids(svn_fs_t *fs,
   *(p++) = '\n';
   *(p++) = '\0';
 
+  SVN_ERR(svn_fs_fs__txn_store_write(&in_memory, fs, txn_id,
+                                     path_txn_next_ids(fs, txn_id, pool),
+                                     svn_stringbuf_ncreate(buffer,
+                                                           p - buffer,
+                                                           pool),
+                                     FALSE, pool));
+  if (in_memory)
+    return SVN_NO_ERROR;
+
   SVN_ERR(svn_io_file_open(&file,
                            path_txn_next_ids(fs, txn_id, pool),
                            APR_WRITE | APR_TRUNCATE,
@@ -1358,10 +1413,13 @@ read_next_ids(apr_uint64_t *node_id,
               apr_pool_t *pool)
 {
   svn_stringbuf_t *buf;
+  svn_stream_t *stream;
   const char *str;
-  SVN_ERR(svn_fs_fs__read_content(&buf,
-                                  path_txn_next_ids(fs, txn_id, pool),
-                                  pool));
+  SVN_ERR(svn_fs_fs__txn_store_open_readonly(&stream, fs, txn_id,
+                                             path_txn_next_ids(fs, txn_id,
+                                                               pool),
+                                             pool, pool));
+  SVN_ERR(svn_stringbuf_from_stream(&buf, stream, 0, pool));
 
   /* Parse this into two separate strings. */
 
@@ -1460,6 +1518,8 @@ svn_fs_fs__purge_txn(svn_fs_t *fs,
 
   /* Remove the shared transaction object associated with this transaction. */
   SVN_ERR(purge_shared_txn(fs, &txn_id, pool));
+  /* Release any of its files that were kept in memory. */
+  SVN_ERR(svn_fs_fs__txn_store_purge(fs, &txn_id));
   /* Remove the directory associated with this transaction. */
   SVN_ERR(svn_io_remove_dir2(svn_fs_fs__path_txn_dir(fs, &txn_id, pool),
                              FALSE, NULL, NULL, pool));
@@ -1586,11 +1646,17 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
           /* Obtain final file size to update txn_dir_cache. */
           SVN_ERR(svn_io_file_size_get(&filesize, file, subpool));
 
-          /* Store in the cache. */
+          /* Store in the cache.  Very large directories go into the
+           * separate large dir cache. */
           dir_data.entries = entries;
           dir_data.txn_filesize = filesize;
-          SVN_ERR(svn_cache__set(ffd->txn_dir_cache, key, &dir_data,
-                                 subpool));
+          if (svn_cache__is_cachable(ffd->txn_dir_cache,
+                                     150 * entries->nelts))
+            SVN_ERR(svn_cache__set(ffd->txn_dir_cache, key, &dir_data,
+                                   subpool));
+          else if (ffd->large_dir_cache)
+            SVN_ERR(svn_cache__set(ffd->large_dir_cache, key, &dir_data,
+                                   subpool));
         }
 
       svn_pool_clear(subpool);
@@ -1610,25 +1676,32 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
         {
           const char *key
             = svn_fs_fs__id_unparse(parent_noderev->id, subpool)->data;
-          svn_boolean_t found;
-          svn_filesize_t cached_filesize;
-
-          /* Get the file size that corresponds to the cached contents
-           * (if any). */
-          SVN_ERR(svn_cache__get_partial((void **)&cached_filesize, &found,
-                                         ffd->txn_dir_cache, key,
-                                         svn_fs_fs__extract_dir_filesize,
-                                         NULL, subpool));
-
-          /* File size info still matches?
-           * If not, we need to drop the cache entry. */
-          if (found)
+          svn_cache__t *caches[2];
+          int i;
+
+          caches[0] = ffd->txn_dir_cache;
+          caches[1] = ffd->large_dir_cache;
+          for (i = 0; i < 2 && caches[i]; ++i)
             {
-              SVN_ERR(svn_io_file_size_get(&filesize, file, subpool));
+              svn_boolean_t found;
+              svn_filesize_t cached_filesize;
+
+              /* Get the file size that corresponds to the cached contents
+               * (if any). */
+              SVN_ERR(svn_cache__get_partial((void **)&cached_filesize,
+                                             &found, caches[i], key,
+                                             svn_fs_fs__extract_dir_filesize,
+                                             NULL, subpool));
+
+              /* File size info still matches?
+               * If not, we need to drop the cache entry. */
+              if (found)
+                {
+                  SVN_ERR(svn_io_file_size_get(&filesize, file, subpool));
 
-              if (cached_filesize != filesize)
-                SVN_ERR(svn_cache__set(ffd->txn_dir_cache, key, NULL,
-                                       subpool));
+                  if (cached_filesize != filesize)
+                    SVN_ERR(svn_cache__set(caches[i], key, NULL, subpool));
+                }
             }
         }
     }
@@ -1683,6 +1756,10 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
       SVN_ERR(svn_cache__set_partial(ffd->txn_dir_cache, key,
                                      svn_fs_fs__replace_dir_entry, &baton,
                                      subpool));
+      if (ffd->large_dir_cache)
+        SVN_ERR(svn_cache__set_partial(ffd->large_dir_cache, key,
+                                       svn_fs_fs__replace_dir_entry, &baton,
+                                       subpool));
     }
 
   svn_pool_destroy(subpool);
@@ -1706,11 +1783,9 @@ svn_fs_fs__add_change(svn_fs_t *fs,
   apr_file_t *file;
   svn_fs_path_change2_t *change;
   apr_hash_t *changes = apr_hash_make(pool);
-
-  /* Not using APR_BUFFERED to append change in one atomic write operation. */
-  SVN_ERR(svn_io_file_open(&file, path_txn_changes(fs, txn_id, pool),
-                           APR_APPEND | APR_WRITE | APR_CREATE,
-                           APR_OS_DEFAULT, pool));
+  svn_stringbuf_t *buffer = svn_stringbuf_create_ensure(256, pool);
+  const char *changes_path = path_txn_changes(fs, txn_id, pool);
+  svn_boolean_t in_memory;
 
   change = svn_fs__path_change_create_internal(id, change_kind, pool);
   change->text_mod = text_mod;
@@ -1725,9 +1800,21 @@ svn_fs_fs__add_change(svn_fs_t *fs,
     change->copyfrom_path = apr_pstrdup(pool, copyfrom_path);
 
   svn_hash_sets(changes, path, change);
-  SVN_ERR(svn_fs_fs__write_changes(svn_stream_from_aprfile2(file, TRUE, pool),
+  SVN_ERR(svn_fs_fs__write_changes(svn_stream_from_stringbuf(buffer, pool),
                                    fs, changes, FALSE, pool));
 
+  SVN_ERR(svn_fs_fs__txn_store_write(&in_memory, fs, txn_id, changes_path,
+                                     buffer, TRUE, pool));
+  if (in_memory)
+    return SVN_NO_ERROR;
+
+  /* Not using APR_BUFFERED to append change in one atomic write operation. */
+  SVN_ERR(svn_io_file_open(&file, changes_path,
+                           APR_APPEND | APR_WRITE | APR_CREATE,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, buffer->data, buffer->len, NULL,
+                                 pool));
+
   return svn_io_file_close(file, pool);
 }
 
@@ -1902,6 +1989,11 @@ fnv1a_checksum_finalize(apr_uint32_t *digest,
   return SVN_NO_ERROR;
 }
 
+/* Checksum kinds calculated for representation contents.  Callers that
+   don't need the SHA1 only pass the first element. */
+static const svn_checksum_kind_t md5_sha1_kinds[2]
+  = { svn_checksum_md5, svn_checksum_sha1 };
+
 /* This baton is used by the representation writing streams.  It keeps
    track of the checksum information as well as the total size of the
    representation so far. */
@@ -1935,8 +2027,8 @@ struct rep_write_baton
      writing to it. */
   void *lockcookie;
 
-  svn_checksum_ctx_t *md5_checksum_ctx;
-  svn_checksum_ctx_t *sha1_checksum_ctx;
+  /* calculate MD5 and SHA1 of the fulltext in a single pass */
+  svn_checksum__multi_ctx_t *checksum_ctx;
 
   /* calculate a modified FNV-1a checksum of the on-disk representation */
   svn_checksum_ctx_t *fnv1a_checksum_ctx;
@@ -1958,8 +2050,7 @@ rep_write_contents(void *baton,
 {
   struct rep_write_baton *b = baton;
 
-  SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, data, *len));
-  SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
+  SVN_ERR(svn_checksum__multi_update(b->checksum_ctx, data, *len));
   b->rep_size += *len;
 
   /* If we are writing a delta, use that stream. */
@@ -2005,6 +2096,155 @@ shards_spanned(int *spanned,
   return SVN_NO_ERROR;
 }
 
+/* Reset *REP to NULL if it is not worth using as a delta base in FS,
+   i.e. if it is too small or if reconstructing it would be too expensive.
+   Perform temporary allocations in POOL. */
+static svn_error_t *
+filter_delta_base(representation_t **rep,
+                  svn_fs_t *fs,
+                  apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* if we encountered a shared rep, its parent chain may be different
+   * from the node-rev parent chain. */
+  if (*rep)
+    {
+      int chain_length = 0;
+      int shard_count = 0;
+
+      /* Very short rep bases are simply not worth it as we are unlikely
+       * to re-coup the deltification space overhead of 20+ bytes. */
+      svn_filesize_t rep_size = (*rep)->expanded_size;
+      if (rep_size < 64)
+        {
+          *rep = NULL;
+          return SVN_NO_ERROR;
+        }
+
+      /* Check whether the length of the deltification chain is acceptable.
+       * Otherwise, shared reps may form a non-skipping delta chain in
+       * extreme cases. */
+      SVN_ERR(svn_fs_fs__rep_chain_length(&chain_length, &shard_count,
+                                          *rep, fs, pool));
+
+      /* Some reasonable limit, depending on how acceptable longer linear
+       * chains are in this repo.  Also, allow for some minimal chain. */
+      if (chain_length >= 2 * (int)ffd->max_linear_deltification + 2)
+        *rep = NULL;
+      else
+        /* To make it worth opening additional shards / pack files, we
+         * require that the reps have a certain minimal size.  To deltify
+         * against a rep in different shard, the lower limit is 512 bytes
+         * and doubles with every extra shard to visit along the delta
+         * chain. */
+        if (   shard_count > 1
+            && ((svn_filesize_t)128 << shard_count) >= rep_size)
+          *rep = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement the delta_base_policy_cost variant of choose_delta_base().
+ *
+ * Rather than deriving the base from the predecessor count alone, look at
+ * the delta chains actually stored for the candidates.  Try the immediate
+ * predecessor first, then the skip-delta positions obtained by clearing
+ * the lowest set bits of NODEREV's predecessor count one after another.
+ * Use the first candidate that can be reconstructed from at most
+ * max-linear-deltification representations without reading from too many
+ * shards.
+ * Skip candidates whose size differs from the predecessor's by so much
+ * that the delta would likely be no smaller than a fulltext.  If there is
+ * no such candidate within max-deltification-walk, store a fulltext.
+ *
+ * Parameters are the same as for choose_delta_base().
+ */
+static svn_error_t *
+choose_delta_base_by_cost(representation_t **rep,
+                          svn_fs_t *fs,
+                          node_revision_t *noderev,
+                          svn_boolean_t props,
+                          apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  node_revision_t *base;
+  representation_t *linear_rep;
+  int index = noderev->predecessor_count - 1;
+  int next = noderev->predecessor_count;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_fs_fs__get_node_revision(&base, fs, noderev->predecessor_id,
+                                       pool, iterpool));
+  linear_rep = props ? base->prop_rep : base->data_rep;
+
+  *rep = NULL;
+  while (ffd->max_deltification_walk > 0)
+    {
+      representation_t *candidate = props ? base->prop_rep : base->data_rep;
+
+      svn_pool_clear(iterpool);
+
+      /* The predecessor's size is our best guess for the size of the new
+       * contents.  If a base is further away from that than the contents
+       * are long, the delta will not beat a fulltext. */
+      if (candidate && linear_rep && candidate != linear_rep)
+        {
+          svn_filesize_t size_diff = candidate->expanded_size
+                                   - linear_rep->expanded_size;
+          if (size_diff < 0)
+            size_diff = -size_diff;
+
+          if (size_diff >= linear_rep->expanded_size)
+            candidate = NULL;
+        }
+
+      if (candidate && candidate->expanded_size >= 64)
+        {
+          int chain_length = 0;
+          int shard_count = 0;
+
+          SVN_ERR(svn_fs_fs__rep_chain_length(&chain_length, &shard_count,
+                                              candidate, fs, iterpool));
+
+          /* Same minimum size per shard to open as in filter_delta_base. */
+          if (   chain_length <= (int)ffd->max_linear_deltification
+              && (   shard_count <= 1
+                  || ((svn_filesize_t)128 << shard_count)
+                       < candidate->expanded_size))
+            {
+              *rep = candidate;
+              break;
+            }
+        }
+
+      /* Continue with the next skip-delta position further back. */
+      if (index == 0)
+        break;
+
+      do
+        next = next & (next - 1);
+      while (next >= index);
+
+      if (noderev->predecessor_count - next
+            > (int)ffd->max_deltification_walk)
+        break;
+
+      while (index > next)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_fs_fs__get_node_revision(&base, fs,
+                                               base->predecessor_id, pool,
+                                               iterpool));
+          --index;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* Given a node-revision NODEREV in filesystem FS, return the
    representation in *REP to use as the base for a text representation
    delta if PROPS is FALSE.  If PROPS has been set, a suitable props
@@ -2036,6 +2276,10 @@ choose_delta_base(representation_t **rep,
       return SVN_NO_ERROR;
     }
 
+  if (ffd->delta_base_policy == delta_base_policy_cost)
+    return svn_error_trace(choose_delta_base_by_cost(rep, fs, noderev,
+                                                     props, pool));
+
   /* Flip the rightmost '1' bit of the predecessor count to determine
      which file rev (counting from 0) we want to use.  (To see why
      count & (count - 1) unsets the rightmost set bit, think about how
@@ -2086,44 +2330,7 @@ choose_delta_base(representation_t **rep,
   /* return a suitable base representation */
   *rep = props ? base->prop_rep : base->data_rep;
 
-  /* if we encountered a shared rep, its parent chain may be different
-   * from the node-rev parent chain. */
-  if (*rep)
-    {
-      int chain_length = 0;
-      int shard_count = 0;
-
-      /* Very short rep bases are simply not worth it as we are unlikely
-       * to re-coup the deltification space overhead of 20+ bytes. */
-      svn_filesize_t rep_size = (*rep)->expanded_size;
-      if (rep_size < 64)
-        {
-          *rep = NULL;
-          return SVN_NO_ERROR;
-        }
-
-      /* Check whether the length of the deltification chain is acceptable.
-       * Otherwise, shared reps may form a non-skipping delta chain in
-       * extreme cases. */
-      SVN_ERR(svn_fs_fs__rep_chain_length(&chain_length, &shard_count,
-                                          *rep, fs, pool));
-
-      /* Some reasonable limit, depending on how acceptable longer linear
-       * chains are in this repo.  Also, allow for some minimal chain. */
-      if (chain_length >= 2 * (int)ffd->max_linear_deltification + 2)
-        *rep = NULL;
-      else
-        /* To make it worth opening additional shards / pack files, we
-         * require that the reps have a certain minimal size.  To deltify
-         * against a rep in different shard, the lower limit is 512 bytes
-         * and doubles with every extra shard to visit along the delta
-         * chain. */
-        if (   shard_count > 1
-            && ((svn_filesize_t)128 << shard_count) >= rep_size)
-          *rep = NULL;
-    }
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(filter_delta_base(rep, fs, pool));
 }
 
 /* Something went wrong and the pool for the rep write is being
@@ -2168,8 +2375,23 @@ txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   int svndiff_version;
+  int compression_level = ffd->delta_compression_level;
 
-  if (ffd->delta_compression_type == compression_type_lz4)
+  /* Readers only know to expect zstd compressed deltas once the format
+     file says so, see commit_body().  Until then, fall back to zlib. */
+  if (ffd->delta_compression_type == compression_type_zstd
+      && ffd->zstd_deltas)
+    {
+      SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF3_FORMAT);
+      svndiff_version = 3;
+    }
+  else if (ffd->delta_compression_type == compression_type_zstd)
+    {
+      svndiff_version = 1;
+      compression_level = MIN(compression_level,
+                              SVN_DELTA_COMPRESSION_LEVEL_MAX);
+    }
+  else if (ffd->delta_compression_type == compression_type_lz4)
     {
       SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT);
       svndiff_version = 2;
@@ -2184,8 +2406,9 @@ txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
       svndiff_version = 0;
     }
 
-  svn_txdelta_to_svndiff3(handler, handler_baton, output, svndiff_version,
-                          ffd->delta_compression_level, pool);
+  svn_txdelta__to_svndiff_parallel(handler, handler_baton, output,
+                                   svndiff_version, compression_level,
+                                   ffd->delta_compression_threads, pool);
 }
 
 /* Get a rep_write_baton and store it in *WB_P for the representation
@@ -2208,8 +2431,7 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
 
   b = apr_pcalloc(pool, sizeof(*b));
 
-  b->sha1_checksum_ctx = svn_checksum_ctx_create(svn_checksum_sha1, pool);
-  b->md5_checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
+  b->checksum_ctx = svn_checksum__multi_ctx_create(md5_sha1_kinds, 2, pool);
 
   b->fs = fs;
   b->result_pool = pool;
@@ -2483,24 +2705,25 @@ get_shared_rep(representation_t **old_rep,
   return SVN_NO_ERROR;
 }
 
-/* Copy the hash sum calculation results from MD5_CTX, SHA1_CTX into REP.
- * SHA1 results are only be set if SHA1_CTX is not NULL.
- * Use POOL for allocations.
+/* Copy the hash sum calculation results from CTX into REP.
+ * SHA1 results are only be set if HAS_SHA1 is set, in which case CTX
+ * must have calculated them.  Use POOL for allocations.
  */
 static svn_error_t *
 digests_final(representation_t *rep,
-              const svn_checksum_ctx_t *md5_ctx,
-              const svn_checksum_ctx_t *sha1_ctx,
+              const svn_checksum__multi_ctx_t *ctx,
+              svn_boolean_t has_sha1,
               apr_pool_t *pool)
 {
   svn_checksum_t *checksum;
 
-  SVN_ERR(svn_checksum_final(&checksum, md5_ctx, pool));
+  SVN_ERR(svn_checksum__multi_final(&checksum, ctx, svn_checksum_md5, pool));
   memcpy(rep->md5_digest, checksum->digest, svn_checksum_size(checksum));
-  rep->has_sha1 = sha1_ctx != NULL;
+  rep->has_sha1 = has_sha1;
   if (rep->has_sha1)
     {
-      SVN_ERR(svn_checksum_final(&checksum, sha1_ctx, pool));
+      SVN_ERR(svn_checksum__multi_final(&checksum, ctx, svn_checksum_sha1,
+                                        pool));
       memcpy(rep->sha1_digest, checksum->digest, svn_checksum_size(checksum));
     }
 
@@ -2536,8 +2759,7 @@ rep_write_contents_close(void *baton)
   rep->revision = SVN_INVALID_REVNUM;
 
   /* Finalize the checksum. */
-  SVN_ERR(digests_final(rep, b->md5_checksum_ctx, b->sha1_checksum_ctx,
-                        b->result_pool));
+  SVN_ERR(digests_final(rep, b->checksum_ctx, TRUE, b->result_pool));
 
   /* Check and see if we already have a representation somewhere that's
      identical to the one we just wrote out. */
@@ -2682,15 +2904,24 @@ svn_fs_fs__set_proplist(svn_fs_t *fs,
   const char *filename
     = svn_fs_fs__path_txn_node_props(fs, noderev->id, pool);
   apr_file_t *file;
-  svn_stream_t *out;
+  svn_stringbuf_t *buffer = svn_stringbuf_create_ensure(256, pool);
+  svn_boolean_t in_memory;
 
   /* Dump the property list to the mutable property file. */
-  SVN_ERR(svn_io_file_open(&file, filename,
-                           APR_WRITE | APR_CREATE | APR_TRUNCATE
-                           | APR_BUFFERED, APR_OS_DEFAULT, pool));
-  out = svn_stream_from_aprfile2(file, TRUE, pool);
-  SVN_ERR(svn_hash_write2(proplist, out, SVN_HASH_TERMINATOR, pool));
-  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_hash_write2(proplist, svn_stream_from_stringbuf(buffer, pool),
+                          SVN_HASH_TERMINATOR, pool));
+  SVN_ERR(svn_fs_fs__txn_store_write(&in_memory, fs,
+                                     svn_fs_fs__id_txn_id(noderev->id),
+                                     filename, buffer, FALSE, pool));
+  if (!in_memory)
+    {
+      SVN_ERR(svn_io_file_open(&file, filename,
+                               APR_WRITE | APR_CREATE | APR_TRUNCATE
+                               | APR_BUFFERED, APR_OS_DEFAULT, pool));
+      SVN_ERR(svn_io_file_write_full(file, buffer->data, buffer->len, NULL,
+                                     pool));
+      SVN_ERR(svn_io_file_close(file, pool));
+    }
 
   /* Mark the node-rev's prop rep as mutable, if not already done. */
   if (!noderev->prop_rep || !is_txn_rep(noderev->prop_rep))
@@ -2711,10 +2942,11 @@ struct write_container_baton
 
   apr_size_t size;
 
-  svn_checksum_ctx_t *md5_ctx;
+  /* MD5 and, optionally, SHA1 calculation. */
+  svn_checksum__multi_ctx_t *checksum_ctx;
 
-  /* SHA1 calculation is optional. If not needed, this will be NULL. */
-  svn_checksum_ctx_t *sha1_ctx;
+  /* Whether CHECKSUM_CTX calculates the SHA1 as well. */
+  svn_boolean_t has_sha1;
 };
 
 /* The handler for the write_container_rep stream.  BATON is a
@@ -2727,9 +2959,7 @@ write_container_handler(void *baton,
 {
   struct write_container_baton *whb = baton;
 
-  SVN_ERR(svn_checksum_update(whb->md5_ctx, data, *len));
-  if (whb->sha1_ctx)
-    SVN_ERR(svn_checksum_update(whb->sha1_ctx, data, *len));
+  SVN_ERR(svn_checksum__multi_update(whb->checksum_ctx, data, *len));
 
   SVN_ERR(svn_stream_write(whb->stream, data, len));
   whb->size += *len;
@@ -2754,6 +2984,19 @@ write_hash_to_stream(svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+/* Implement collection_writer_t writing the property list given as BATON
+   in the binary encoding. */
+static svn_error_t *
+write_binary_proplist_to_stream(svn_stream_t *stream,
+                                void *baton,
+                                apr_pool_t *pool)
+{
+  apr_hash_t *proplist = baton;
+  SVN_ERR(svn_fs_fs__write_binary_proplist(stream, proplist, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Implement collection_writer_t writing the svn_fs_dirent_t* array given
    as BATON. */
 static svn_error_t *
@@ -2807,9 +3050,10 @@ write_container_rep(representation_t *rep,
   else
     fnv1a_checksum_ctx = NULL;
   whb->size = 0;
-  whb->md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
-  if (item_type != SVN_FS_FS__ITEM_TYPE_DIR_REP)
-    whb->sha1_ctx = svn_checksum_ctx_create(svn_checksum_sha1, scratch_pool);
+  whb->has_sha1 = item_type != SVN_FS_FS__ITEM_TYPE_DIR_REP;
+  whb->checksum_ctx = svn_checksum__multi_ctx_create(md5_sha1_kinds,
+                                                     whb->has_sha1 ? 2 : 1,
+                                                     scratch_pool);
 
   stream = svn_stream_create(whb, scratch_pool);
   svn_stream_set_write(stream, write_container_handler);
@@ -2819,7 +3063,8 @@ write_container_rep(representation_t *rep,
   SVN_ERR(writer(stream, collection, scratch_pool));
 
   /* Store the results. */
-  SVN_ERR(digests_final(rep, whb->md5_ctx, whb->sha1_ctx, scratch_pool));
+  SVN_ERR(digests_final(rep, whb->checksum_ctx, whb->has_sha1,
+                        scratch_pool));
 
   /* Update size info. */
   rep->expanded_size = whb->size;
@@ -2951,9 +3196,10 @@ write_container_delta_rep(representation_t *rep,
   whb->stream = svn_txdelta_target_push(diff_wh, diff_whb, source,
                                         scratch_pool);
   whb->size = 0;
-  whb->md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
-  if (item_type != SVN_FS_FS__ITEM_TYPE_DIR_REP)
-    whb->sha1_ctx = svn_checksum_ctx_create(svn_checksum_sha1, scratch_pool);
+  whb->has_sha1 = item_type != SVN_FS_FS__ITEM_TYPE_DIR_REP;
+  whb->checksum_ctx = svn_checksum__multi_ctx_create(md5_sha1_kinds,
+                                                     whb->has_sha1 ? 2 : 1,
+                                                     scratch_pool);
 
   /* serialize the hash */
   stream = svn_stream_create(whb, scratch_pool);
@@ -2963,7 +3209,8 @@ write_container_delta_rep(representation_t *rep,
   SVN_ERR(svn_stream_close(whb->stream));
 
   /* Store the results. */
-  SVN_ERR(digests_final(rep, whb->md5_ctx, whb->sha1_ctx, scratch_pool));
+  SVN_ERR(digests_final(rep, whb->checksum_ctx, whb->has_sha1,
+                        scratch_pool));
 
   /* Update size info. */
   SVN_ERR(svn_io_file_get_offset(&rep_end, file, scratch_pool));
@@ -3258,18 +3505,21 @@ write_final_rev(const svn_fs_id_t **new_id_p,
       apr_uint32_t item_type = noderev->kind == svn_node_dir
                              ? SVN_FS_FS__ITEM_TYPE_DIR_PROPS
                              : SVN_FS_FS__ITEM_TYPE_FILE_PROPS;
+      collection_writer_t writer = ffd->binary_properties
+                                 ? write_binary_proplist_to_stream
+                                 : write_hash_to_stream;
       SVN_ERR(svn_fs_fs__get_proplist(&proplist, fs, noderev, pool));
 
       noderev->prop_rep->revision = rev;
 
       if (ffd->deltify_properties)
         SVN_ERR(write_container_delta_rep(noderev->prop_rep, file, proplist,
-                                          write_hash_to_stream, fs, noderev,
-                                          reps_hash, TRUE, item_type, pool));
+                                          writer, fs, noderev, reps_hash,
+                                          TRUE, item_type, pool));
       else
         SVN_ERR(write_container_rep(noderev->prop_rep, file, proplist,
-                                    write_hash_to_stream, fs, reps_hash,
-                                    TRUE, item_type, pool));
+                                    writer, fs, reps_hash, TRUE, item_type,
+                                    pool));
 
       reset_txn_in_rep(noderev->prop_rep);
     }
@@ -3389,6 +3639,7 @@ write_final_changed_path_info(apr_off_t *offset_p,
                               apr_hash_t *changed_paths,
                               apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   apr_off_t offset;
   svn_stream_t *stream;
   svn_checksum_ctx_t *fnv1a_checksum_ctx;
@@ -3402,7 +3653,11 @@ write_final_changed_path_info(apr_off_t *offset_p,
   else
     fnv1a_checksum_ctx = NULL;
 
-  SVN_ERR(svn_fs_fs__write_changes(stream, fs, changed_paths, TRUE, pool));
+  if (ffd->compressed_changes)
+    SVN_ERR(svn_fs_fs__write_compressed_changes(stream, fs, changed_paths,
+                                                pool));
+  else
+    SVN_ERR(svn_fs_fs__write_changes(stream, fs, changed_paths, TRUE, pool));
 
   *offset_p = offset;
 
@@ -3575,13 +3830,14 @@ verify_locks(svn_fs_t *fs,
 }
 
 /* Writes final revision properties to file PATH applying permissions
-   from file PERMS_REFERENCE. This involves setting svn:date and
-   removing any temporary properties associated with the commit flags. */
+   from file PERMS_REFERENCE and schedules the necessary fsync calls in
+   BATCH. This involves setting svn:date and removing any temporary
+   properties associated with the commit flags. */
 static svn_error_t *
 write_final_revprop(const char *path,
                     const char *perms_reference,
                     svn_fs_txn_t *txn,
-                    svn_boolean_t flush_to_disk,
+                    svn_fs__batch_fsync_t *batch,
                     apr_pool_t *pool)
 {
   apr_hash_t *txnprops;
@@ -3618,14 +3874,14 @@ write_final_revprop(const char *path,
                            | APR_BUFFERED, APR_OS_DEFAULT, pool));
 
   stream = svn_stream_from_aprfile2(revprop_file, TRUE, pool);
-  SVN_ERR(svn_hash_write2(txnprops, stream, SVN_HASH_TERMINATOR, pool));
+  SVN_ERR(svn_fs_fs__write_proplist(stream, fs, txnprops, pool));
   SVN_ERR(svn_stream_close(stream));
 
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(revprop_file, pool));
   SVN_ERR(svn_io_file_close(revprop_file, pool));
 
   SVN_ERR(svn_io_copy_perms(perms_reference, path, pool));
+  SVN_ERR(svn_fs__batch_fsync_add_file(batch, path, pool));
+  SVN_ERR(svn_fs__batch_fsync_new_path(batch, path, pool));
 
   return SVN_NO_ERROR;
 }
@@ -3716,56 +3972,35 @@ struct commit_baton {
   apr_pool_t *reps_pool;
 };
 
-/* The work-horse for svn_fs_fs__commit, called with the FS write lock.
-   This implements the svn_fs_fs__with_write_lock() 'body' callback
-   type.  BATON is a 'struct commit_baton *'. */
+/* Write the contents of CB->TXN to CB->FS as revision OLD_REV + 1 but
+   don't update the 'current' file, i.e. don't make the new revision
+   visible, yet.  START_NODE_ID and START_COPY_ID are the next ids as
+   read from 'current' for old format repositories.  Add the cache keys
+   of all new directory representations to DIRECTORY_IDS.
+
+   Don't flush the new files to disk but schedule the necessary fsync
+   calls in BATCH.  The caller has to run it before updating 'current'.
+
+   The FS write lock is assumed to be held by the caller. */
 static svn_error_t *
-commit_body(void *baton, apr_pool_t *pool)
+write_new_revision(struct commit_baton *cb,
+                   svn_revnum_t old_rev,
+                   apr_uint64_t start_node_id,
+                   apr_uint64_t start_copy_id,
+                   apr_array_header_t *directory_ids,
+                   svn_fs__batch_fsync_t *batch,
+                   apr_pool_t *pool)
 {
-  struct commit_baton *cb = baton;
   fs_fs_data_t *ffd = cb->fs->fsap_data;
   const char *old_rev_filename, *rev_filename, *proto_filename;
   const char *revprop_filename;
   const svn_fs_id_t *root_id, *new_root_id;
-  apr_uint64_t start_node_id;
-  apr_uint64_t start_copy_id;
-  svn_revnum_t old_rev, new_rev;
+  svn_revnum_t new_rev;
   apr_file_t *proto_file;
   void *proto_file_lockcookie;
   apr_off_t initial_offset, changed_path_offset;
   const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
   apr_hash_t *changed_paths;
-  apr_array_header_t *directory_ids = apr_array_make(pool, 4,
-                                                     sizeof(pair_cache_key_t));
-
-  /* Re-Read the current repository format.  All our repo upgrade and
-     config evaluation strategies are such that existing information in
-     FS and FFD remains valid.
-
-     Although we don't recommend upgrading hot repositories, people may
-     still do it and we must make sure to either handle them gracefully
-     or to error out.
-
-     Committing pre-format 3 txns will fail after upgrade to format 3+
-     because the proto-rev cannot be found; no further action needed.
-     Upgrades from pre-f7 to f7+ means a potential change in addressing
-     mode for the final rev.  We must be sure to detect that cause because
-     the failure would only manifest once the new revision got committed.
-   */
-  SVN_ERR(svn_fs_fs__read_format_file(cb->fs, pool));
-
-  /* Read the current youngest revision and, possibly, the next available
-     node id and copy id (for old format filesystems).  Update the cached
-     value for the youngest revision, because we have just checked it. */
-  SVN_ERR(svn_fs_fs__read_current(&old_rev, &start_node_id, &start_copy_id,
-                                  cb->fs, pool));
-  ffd->youngest_rev_cache = old_rev;
-
-  /* Check to make sure this transaction is based off the most recent
-     revision. */
-  if (cb->txn->base_rev != old_rev)
-    return svn_error_create(SVN_ERR_FS_TXN_OUT_OF_DATE, NULL,
-                            _("Transaction out of date"));
 
   /* We need the changes list for verification as well as for writing it
      to the final rev file. */
@@ -3819,8 +4054,6 @@ commit_body(void *baton, apr_pool_t *pool)
                                      NULL, pool));
     }
 
-  if (ffd->flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(proto_file, pool));
   SVN_ERR(svn_io_file_close(proto_file, pool));
 
   /* We don't unlock the prototype revision file immediately to avoid a
@@ -3845,6 +4078,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_fs__batch_fsync_new_path(batch, new_dir, pool));
         }
 
       /* Create the revprops shard. */
@@ -3861,6 +4095,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVPROPS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_fs__batch_fsync_new_path(batch, new_dir, pool));
         }
     }
 
@@ -3873,8 +4108,9 @@ commit_body(void *baton, apr_pool_t *pool)
   rev_filename = svn_fs_fs__path_rev(cb->fs, new_rev, pool);
   proto_filename = svn_fs_fs__path_txn_proto_rev(cb->fs, txn_id, pool);
   SVN_ERR(svn_fs_fs__move_into_place(proto_filename, rev_filename,
-                                     old_rev_filename, ffd->flush_to_disk,
-                                     pool));
+                                     old_rev_filename, FALSE, pool));
+  SVN_ERR(svn_fs__batch_fsync_add_file(batch, rev_filename, pool));
+  SVN_ERR(svn_fs__batch_fsync_new_path(batch, rev_filename, pool));
 
   /* Now that we've moved the prototype revision file out of the way,
      we can unlock it (since further attempts to write to the file
@@ -3886,7 +4122,7 @@ commit_body(void *baton, apr_pool_t *pool)
   SVN_ERR_ASSERT(! svn_fs_fs__is_packed_revprop(cb->fs, new_rev));
   revprop_filename = svn_fs_fs__path_revprops(cb->fs, new_rev, pool);
   SVN_ERR(write_final_revprop(revprop_filename, old_rev_filename,
-                              cb->txn, ffd->flush_to_disk, pool));
+                              cb->txn, batch, pool));
 
   /* Run paranoia checks. */
   if (ffd->verify_before_commit)
@@ -3894,6 +4130,76 @@ commit_body(void *baton, apr_pool_t *pool)
       SVN_ERR(verify_before_commit(cb->fs, new_rev, pool));
     }
 
+  return SVN_NO_ERROR;
+}
+
+/* The work-horse for svn_fs_fs__commit, called with the FS write lock.
+   This implements the svn_fs_fs__with_write_lock() 'body' callback
+   type.  BATON is a 'struct commit_baton *'. */
+static svn_error_t *
+commit_body(void *baton, apr_pool_t *pool)
+{
+  struct commit_baton *cb = baton;
+  fs_fs_data_t *ffd = cb->fs->fsap_data;
+  apr_uint64_t start_node_id;
+  apr_uint64_t start_copy_id;
+  svn_revnum_t old_rev, new_rev;
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
+  apr_array_header_t *directory_ids = apr_array_make(pool, 4,
+                                                     sizeof(pair_cache_key_t));
+  svn_fs__batch_fsync_t *batch;
+
+  /* Re-Read the current repository format.  All our repo upgrade and
+     config evaluation strategies are such that existing information in
+     FS and FFD remains valid.
+
+     Although we don't recommend upgrading hot repositories, people may
+     still do it and we must make sure to either handle them gracefully
+     or to error out.
+
+     Committing pre-format 3 txns will fail after upgrade to format 3+
+     because the proto-rev cannot be found; no further action needed.
+     Upgrades from pre-f7 to f7+ means a potential change in addressing
+     mode for the final rev.  We must be sure to detect that cause because
+     the failure would only manifest once the new revision got committed.
+   */
+  SVN_ERR(svn_fs_fs__read_format_file(cb->fs, pool));
+
+  /* Once zstd compression is configured, announce zstd compressed deltas
+     in the format file before any revision may contain them.  Releases
+     and builds that cannot read them will then refuse to open the
+     repository instead of failing in the middle of a read. */
+  if (ffd->delta_compression_type == compression_type_zstd
+      && !ffd->zstd_deltas)
+    {
+      ffd->zstd_deltas = TRUE;
+      SVN_ERR(svn_fs_fs__write_format(cb->fs, TRUE, pool));
+    }
+
+  /* Read the current youngest revision and, possibly, the next available
+     node id and copy id (for old format filesystems).  Update the cached
+     value for the youngest revision, because we have just checked it. */
+  SVN_ERR(svn_fs_fs__read_current(&old_rev, &start_node_id, &start_copy_id,
+                                  cb->fs, pool));
+  ffd->youngest_rev_cache = old_rev;
+
+  /* Check to make sure this transaction is based off the most recent
+     revision. */
+  if (cb->txn->base_rev != old_rev)
+    return svn_error_create(SVN_ERR_FS_TXN_OUT_OF_DATE, NULL,
+                            _("Transaction out of date"));
+
+  SVN_ERR(svn_fs__batch_fsync_create(&batch, ffd->flush_to_disk, pool));
+  SVN_ERR(write_new_revision(cb, old_rev, start_node_id, start_copy_id,
+                             directory_ids, batch, pool));
+  new_rev = old_rev + 1;
+
+  /* Write all new files to disk at once, before making them visible. */
+  SVN_ERR(svn_fs__batch_fsync_run(batch, pool));
+
+  /* Keep the rep-cache filter in sync before anyone may see NEW_REV. */
+  SVN_ERR(svn_fs_fs__rep_filter_note_commit(cb->fs, old_rev, new_rev));
+
   /* Update the 'current' file. */
   SVN_ERR(write_final_current(cb->fs, txn_id, new_rev, start_node_id,
                               start_copy_id, pool));
@@ -3917,29 +4223,320 @@ commit_body(void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
-/* Add the representations in REPS_TO_CACHE (an array of representation_t *)
- * to the rep-cache database of FS. */
+#if APR_HAS_THREADS
+
+/* A commit waiting to be written as part of a commit group. */
+struct fs_fs_commit_request_t
+{
+  /* What to commit.  CB->FS is the filesystem object of the thread that
+     made the request. */
+  struct commit_baton *cb;
+
+  /* Callback and baton to bring CB->TXN up to date with the youngest
+     revision. */
+  svn_fs_fs__txn_merge_func_t merge_func;
+  void *merge_baton;
+
+  /* The pool of the requesting thread.  It must only be used while that
+     thread waits for DONE. */
+  apr_pool_t *pool;
+
+  /* Cache keys of the directories written for this commit. */
+  apr_array_header_t *directory_ids;
+
+  /* The revision written for this request or SVN_INVALID_REVNUM. */
+  svn_revnum_t new_rev;
+
+  /* The result of the commit.  Only valid once DONE has been set. */
+  svn_error_t *err;
+  svn_boolean_t done;
+
+  /* Next request in the queue. */
+  fs_fs_commit_request_t *next;
+};
+
+/* Move all requests from the commit queue in FFSD to *REQUESTS.
+   The COMMIT_QUEUE_LOCK must be held by the caller. */
 static svn_error_t *
-write_reps_to_cache(svn_fs_t *fs,
-                    const apr_array_header_t *reps_to_cache,
-                    apr_pool_t *scratch_pool)
+take_queued_requests(fs_fs_commit_request_t **requests,
+                     fs_fs_shared_data_t *ffsd)
 {
-  int i;
+  *requests = ffsd->commit_queue;
+  ffsd->commit_queue = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set the DONE flag on all REQUESTS.  The COMMIT_QUEUE_LOCK must be
+   held by the caller. */
+static svn_error_t *
+mark_requests_done(fs_fs_commit_request_t *requests)
+{
+  for (; requests; requests = requests->next)
+    requests->done = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Write request REQUEST as revision OLD_REV + 1, merging its txn first
+   if it is based on an older revision.  Schedule the necessary fsyncs
+   in BATCH.  The caller holds the write lock on behalf
+   of REQUEST->CB->FS.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+write_request(fs_fs_commit_request_t *request,
+              svn_revnum_t old_rev,
+              svn_fs__batch_fsync_t *batch,
+              apr_pool_t *scratch_pool)
+{
+  struct commit_baton *cb = request->cb;
+  fs_fs_data_t *ffd = cb->fs->fsap_data;
+
+  /* See commit_body for why we re-read the format.  Formats that use
+     global ids are not eligible for group commit and upgrades can't
+     take us back to them. */
+  SVN_ERR(svn_fs_fs__read_format_file(cb->fs, scratch_pool));
+  SVN_ERR_ASSERT(ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT);
 
-  for (i = 0; i < reps_to_cache->nelts; i++)
+  if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+    SVN_ERR(svn_fs_fs__update_min_unpacked_rev(cb->fs, scratch_pool));
+
+  /* OLD_REV may not be in 'current' yet, but it exists on disk and
+     will be published together with this request's revision. */
+  ffd->youngest_rev_cache = old_rev;
+
+  if (cb->txn->base_rev != old_rev)
+    SVN_ERR(request->merge_func(cb->txn, old_rev, request->merge_baton,
+                                scratch_pool));
+
+  return svn_error_trace(write_new_revision(cb, old_rev, 0, 0,
+                                            request->directory_ids,
+                                            batch, scratch_pool));
+}
+
+/* Process all queued commit requests of FS as one group.  This
+   implements the svn_fs_fs__with_write_lock() 'body' callback type.
+   BATON is the svn_fs_t * holding the write lock.
+
+   Errors of individual requests are reported in their ERR member.
+   All requests taken from the queue are marked as DONE upon return. */
+static svn_error_t *
+commit_group_body(void *baton,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+  fs_fs_commit_request_t *requests = NULL;
+  fs_fs_commit_request_t *request;
+  svn_fs__batch_fsync_t *batch;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t old_rev = ffd->youngest_rev_cache;
+  svn_revnum_t youngest = old_rev;
+  svn_error_t *err;
+
+  /* Take all requests that have arrived so far.  Later ones will have to
+     wait for the next group. */
+  SVN_MUTEX__WITH_LOCK(ffsd->commit_queue_lock,
+                       take_queued_requests(&requests, ffsd));
+
+  /* Write them back to back.  A failed request does not consume a
+     revision number and does not affect those after it. */
+  err = svn_fs__batch_fsync_create(&batch, ffd->flush_to_disk, pool);
+  for (request = requests; request && !err; request = request->next)
     {
-      representation_t *rep = APR_ARRAY_IDX(reps_to_cache, i, representation_t *);
+      fs_fs_data_t *request_ffd = request->cb->fs->fsap_data;
 
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, rep, scratch_pool));
+      svn_pool_clear(iterpool);
+
+      /* We hold the lock on behalf of all requests but only FS must
+         keep the flag afterwards. */
+      request_ffd->has_write_lock = TRUE;
+      request->err = write_request(request, youngest, batch, iterpool);
+      request_ffd->has_write_lock = (request->cb->fs == fs);
+
+      if (!request->err)
+        {
+          request->new_rev = ++youngest;
+        }
+      else
+        {
+          /* The next request will replace any files that this one has
+             left in BATCH.  Don't keep handles to the old ones. */
+          err = svn_fs__batch_fsync_run(batch, iterpool);
+        }
     }
 
+  /* Make all of them durable at once and then visible at once. */
+  if (!err && youngest > old_rev)
+    {
+      err = svn_fs__batch_fsync_run(batch, iterpool);
+      if (!err)
+        err = svn_fs_fs__rep_filter_note_commit(fs, old_rev, youngest);
+      if (!err)
+        err = svn_fs_fs__write_current(fs, youngest, 0, 0, iterpool);
+    }
+
+  /* Report back.  See commit_body about errors after 'current' has been
+     updated. */
+  for (request = requests; request; request = request->next)
+    {
+      struct commit_baton *cb = request->cb;
+      fs_fs_data_t *request_ffd = cb->fs->fsap_data;
+
+      /* None of the new revisions has been published.  Make sure that
+         nobody believes otherwise. */
+      if (err)
+        {
+          request_ffd->youngest_rev_cache = old_rev;
+          if (!request->err)
+            request->err = svn_error_dup(err);
+
+          continue;
+        }
+
+      if (request->err)
+        continue;
+
+      svn_pool_clear(iterpool);
+      *cb->new_rev_p = request->new_rev;
+      request_ffd->youngest_rev_cache = youngest;
+
+      request->err = promote_cached_directories(cb->fs,
+                                                request->directory_ids,
+                                                iterpool);
+      request->err
+        = svn_error_compose_create(request->err,
+                                   svn_fs_fs__purge_txn(cb->fs,
+                                                        cb->txn->id,
+                                                        iterpool));
+    }
+
+  ffd->youngest_rev_cache = err ? old_rev : youngest;
+  svn_error_clear(err);
+  svn_pool_destroy(iterpool);
+
+  SVN_MUTEX__WITH_LOCK(ffsd->commit_queue_lock,
+                       mark_requests_done(requests));
+
   return SVN_NO_ERROR;
 }
 
+/* Remove REQUEST from the commit queue in FFSD, if it is still in there.
+   The COMMIT_QUEUE_LOCK must be held by the caller. */
+static svn_error_t *
+dequeue_request(fs_fs_shared_data_t *ffsd,
+                fs_fs_commit_request_t *request)
+{
+  fs_fs_commit_request_t **link;
+
+  for (link = &ffsd->commit_queue; *link; link = &(*link)->next)
+    if (*link == request)
+      {
+        *link = request->next;
+        break;
+      }
+
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_fs_with_write_lock (CB->FS, commit_body, CB, POOL) but
+   queue the commit such that it may be written together with other
+   commits of the same process.  MERGE_FUNC and MERGE_BATON will be used
+   to bring CB->TXN up to date with revisions written as part of the
+   same group. */
+static svn_error_t *
+commit_grouped(struct commit_baton *cb,
+               svn_fs_fs__txn_merge_func_t merge_func,
+               void *merge_baton,
+               apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = cb->fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+  apr_thread_mutex_t *mutex = svn_mutex__get(ffsd->commit_queue_lock);
+  fs_fs_commit_request_t request = { 0 };
+  fs_fs_commit_request_t **link;
+  apr_status_t status;
+
+  request.cb = cb;
+  request.merge_func = merge_func;
+  request.merge_baton = merge_baton;
+  request.pool = pool;
+  request.directory_ids = apr_array_make(pool, 4, sizeof(pair_cache_key_t));
+  request.new_rev = SVN_INVALID_REVNUM;
+
+  /* Commits get written in the order they arrive. */
+  SVN_ERR(svn_mutex__lock(ffsd->commit_queue_lock));
+  for (link = &ffsd->commit_queue; *link; link = &(*link)->next)
+    ;
+  *link = &request;
+
+  while (!request.done)
+    {
+      if (ffsd->commit_leader_active)
+        {
+          /* Someone else writes to the repository right now.  Once they
+             are done, they will either have written our request as well
+             or we will take over. */
+          status = apr_thread_cond_wait(ffsd->commit_queue_changed, mutex);
+          if (status)
+            {
+              SVN_ERR(dequeue_request(ffsd, &request));
+              return svn_mutex__unlock(ffsd->commit_queue_lock,
+                         svn_error_wrap_apr(status,
+                                            _("Can't wait for FSFS commit")));
+            }
+        }
+      else
+        {
+          svn_error_t *err, *lock_err;
+
+          /* Write everything that has been queued up to now. */
+          ffsd->commit_leader_active = TRUE;
+          SVN_ERR(svn_mutex__unlock(ffsd->commit_queue_lock,
+                                    SVN_NO_ERROR));
+
+          err = svn_fs_fs__with_write_lock(cb->fs, commit_group_body,
+                                           cb->fs, pool);
+
+          lock_err = svn_mutex__lock(ffsd->commit_queue_lock);
+          if (lock_err)
+            return svn_error_compose_create(lock_err, err);
+          ffsd->commit_leader_active = FALSE;
+
+          /* If we failed to produce a group, every request that we did
+             not get to stays queued for the next leader. */
+          if (err && !request.done)
+            {
+              SVN_ERR(dequeue_request(ffsd, &request));
+              request.err = err;
+              request.done = TRUE;
+            }
+          else if (err)
+            {
+              request.err = svn_error_compose_create(request.err, err);
+            }
+
+          status = apr_thread_cond_broadcast(ffsd->commit_queue_changed);
+          if (status)
+            request.err = svn_error_compose_create(
+                              request.err,
+                              svn_error_wrap_apr(status,
+                                           _("Can't signal FSFS commit")));
+        }
+    }
+
+  return svn_error_trace(svn_mutex__unlock(ffsd->commit_queue_lock,
+                                           request.err));
+}
+
+#endif /* APR_HAS_THREADS */
+
 svn_error_t *
 svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_t *fs,
                   svn_fs_txn_t *txn,
+                  svn_fs_fs__txn_merge_func_t merge_func,
+                  void *merge_baton,
                   apr_pool_t *pool)
 {
   struct commit_baton cb;
@@ -3962,7 +4559,19 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
       cb.reps_pool = NULL;
     }
 
-  SVN_ERR(svn_fs_fs__with_write_lock(fs, commit_body, &cb, pool));
+#if APR_HAS_THREADS
+  if (ffd->group_commit && merge_func
+      && ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+    {
+      SVN_ERR(commit_grouped(&cb, merge_func, merge_baton, pool));
+    }
+  else
+#endif
+    {
+      SVN_ERR(svn_fs_fs__with_write_lock(fs, commit_body, &cb, pool));
+    }
+
+  SVN_FS_FS__COUNT(svn_fs_fs__metric_commits);
 
   /* At this point, *NEW_REV_P has been set, so errors below won't affect
      the success of the commit.  (See svn_fs_commit_txn().)  */
@@ -3975,15 +4584,14 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
 
       /* Write new entries to the rep-sharing database.
        *
-       * We use an sqlite transaction to speed things up;
-       * see <http://www.sqlite.org/faq.html#q19>.
+       * With a sharded rep-cache, this only holds the lock on one shard
+       * at a time, so concurrent commits don't serialize on a single
+       * database lock.
        */
-      /* ### A commit that touches thousands of files will starve other
-             (reader/writer) commits for the duration of the below call.
-             Maybe write in batches? */
-      SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
-      err = write_reps_to_cache(fs, cb.reps_to_cache, pool);
-      err = svn_sqlite__finish_transaction(ffd->rep_cache_db, err);
+      /* ### A commit that touches thousands of files will still starve
+             other (reader/writer) commits to the same shard for the duration
+             of the below call.  Maybe write in batches? */
+      err = svn_fs_fs__set_rep_references(fs, cb.reps_to_cache, pool);
 
       if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
         {
@@ -3998,6 +4606,39 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
         return svn_error_trace(err);
     }
 
+  /* Record the changed paths for 'svn log'.  The index catches up on
+     any revisions missed here during later commits. */
+  if (ffd->changed_paths_index)
+    {
+      svn_error_t *err;
+
+      err = svn_fs_fs__update_changed_paths_index(fs, *new_rev_p, pool);
+      if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
+        return svn_error_trace(
+            svn_error_compose_create(
+                err, svn_fs_fs__close_changed_paths_index(fs)));
+      else if (err)
+        return svn_error_trace(err);
+    }
+
+  /* Record which nodes carry mergeinfo in the new revision. */
+  if (ffd->mergeinfo_index)
+    {
+      svn_error_t *err;
+
+      err = svn_fs_fs__update_mergeinfo_index(fs, *new_rev_p, pool);
+      if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
+        return svn_error_trace(
+            svn_error_compose_create(
+                err, svn_fs_fs__close_mergeinfo_index(fs)));
+      else if (err)
+        return svn_error_trace(err);
+    }
+
+  /* Record the date of the new revision for dated revision lookups. */
+  if (ffd->revision_dates_index)
+    SVN_ERR(svn_fs_fs__update_revision_dates(fs, *new_rev_p, pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -4106,13 +4747,20 @@ svn_fs_fs__delete_node_revision(svn_fs_t *fs,
                                 apr_pool_t *pool)
 {
   node_revision_t *noderev;
+  const char *path;
+  svn_boolean_t in_memory;
 
   SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool, pool));
 
   /* Delete any mutable property representation. */
   if (noderev->prop_rep && is_txn_rep(noderev->prop_rep))
-    SVN_ERR(svn_io_remove_file2(svn_fs_fs__path_txn_node_props(fs, id, pool),
-                                FALSE, pool));
+    {
+      path = svn_fs_fs__path_txn_node_props(fs, id, pool);
+      SVN_ERR(svn_fs_fs__txn_store_remove(&in_memory, fs,
+                                          svn_fs_fs__id_txn_id(id), path));
+      if (!in_memory)
+        SVN_ERR(svn_io_remove_file2(path, FALSE, pool));
+    }
 
   /* Delete any mutable data representation. */
   if (noderev->data_rep && is_txn_rep(noderev->data_rep)
@@ -4128,11 +4776,18 @@ svn_fs_fs__delete_node_revision(svn_fs_t *fs,
         {
           const char *key = svn_fs_fs__id_unparse(id, pool)->data;
           SVN_ERR(svn_cache__set(ffd->txn_dir_cache, key, NULL, pool));
+          if (ffd->large_dir_cache)
+            SVN_ERR(svn_cache__set(ffd->large_dir_cache, key, NULL, pool));
         }
     }
 
-  return svn_io_remove_file2(svn_fs_fs__path_txn_node_rev(fs, id, pool),
-                             FALSE, pool);
+  path = svn_fs_fs__path_txn_node_rev(fs, id, pool);
+  SVN_ERR(svn_fs_fs__txn_store_remove(&in_memory, fs,
+                                      svn_fs_fs__id_txn_id(id), path));
+  if (in_memory)
+    return SVN_NO_ERROR;
+
+  return svn_io_remove_file2(path, FALSE, pool);
 }
 
 
@@ -4186,7 +4841,8 @@ svn_fs_fs__begin_txn(svn_fs_txn_t **txn_p,
 
   SVN_ERR(svn_fs__check_fs(fs, TRUE));
 
-  SVN_ERR(svn_fs_fs__create_txn(txn_p, fs, rev, pool));
+  SVN_ERR(svn_fs_fs__create_txn(txn_p, fs, rev,
+                                (flags & SVN_FS_TXN__IN_MEMORY) != 0, pool));
 
   /* Put a datestamp on the newly created txn, so we always know
      exactly how old it is.  (This will help sysadmins identify
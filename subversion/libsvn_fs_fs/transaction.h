@@ -59,12 +59,14 @@ svn_fs_fs__paths_changed(apr_hash_t **changed_paths_p,
                          apr_pool_t *pool);
 
 /* Create a new transaction in filesystem FS, based on revision REV,
-   and store it in *TXN_P.  Allocate all necessary variables from
-   POOL. */
+   and store it in *TXN_P.  If IN_MEMORY is set, keep the transaction's
+   small files in memory as far as FS' configuration allows.  Allocate
+   all necessary variables from POOL. */
 svn_error_t *
 svn_fs_fs__create_txn(svn_fs_txn_t **txn_p,
                       svn_fs_t *fs,
                       svn_revnum_t rev,
+                      svn_boolean_t in_memory,
                       apr_pool_t *pool);
 
 /* Set the transaction property NAME to the value VALUE in transaction
@@ -210,14 +212,33 @@ svn_fs_fs__add_index_data(svn_fs_t *fs,
                           svn_revnum_t revision,
                           apr_pool_t *pool);
 
+/* Callback to merge the changes between TXN's base revision and
+   revision REV into TXN and to make REV the new base revision of TXN.
+   BATON is the callback's baton.  Use SCRATCH_POOL for temporary
+   allocations. */
+typedef svn_error_t *
+(*svn_fs_fs__txn_merge_func_t)(svn_fs_txn_t *txn,
+                               svn_revnum_t rev,
+                               void *baton,
+                               apr_pool_t *scratch_pool);
+
 /* Commit the transaction TXN in filesystem FS and return its new
    revision number in *REV.  If the transaction is out of date, return
-   the error SVN_ERR_FS_TXN_OUT_OF_DATE. Use POOL for temporary
-   allocations. */
+   the error SVN_ERR_FS_TXN_OUT_OF_DATE.
+
+   If MERGE_FUNC is not NULL and group commit has been enabled for FS,
+   TXN may be written together with concurrent commits of other threads.
+   MERGE_FUNC will then be called with MERGE_BATON to update TXN to
+   revisions written earlier in the same group.  Its errors will be
+   returned.
+
+   Use POOL for temporary allocations. */
 svn_error_t *
 svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_t *fs,
                   svn_fs_txn_t *txn,
+                  svn_fs_fs__txn_merge_func_t merge_func,
+                  void *merge_baton,
                   apr_pool_t *pool);
 
 /* Set *NAMES_P to an array of names which are all the active
@@ -55,6 +55,7 @@
 #include "cached_data.h"
 #include "dag.h"
 #include "lock.h"
+#include "mergeinfo-index.h"
 #include "tree.h"
 #include "fs_fs.h"
 #include "id.h"
@@ -325,10 +326,11 @@ cache_lookup( fs_fs_dag_cache_t *cache
   return result->node;
 }
 
-/* Store a copy of NODE in CACHE, taking  REVISION and PATH as key.
- * This function will clean the cache at regular intervals.
+/* Store a copy of NODE in CACHE, taking  REVISION and PATH as key and
+ * return that copy.  This function will clean the cache at regular
+ * intervals.
  */
-static void
+static dag_node_t *
 cache_insert(fs_fs_dag_cache_t *cache,
              svn_revnum_t revision,
              const char *path,
@@ -362,6 +364,8 @@ cache_insert(fs_fs_dag_cache_t *cache,
 
   entry->node = svn_fs_fs__dag_dup(node, cache->pool);
   cache->insertions++;
+
+  return entry->node;
 }
 
 /* Optimistic lookup using the last seen non-empty location in CACHE.
@@ -1175,6 +1179,131 @@ open_path(parent_path_t **parent_path_p,
   return SVN_NO_ERROR;
 }
 
+/* Set *NODE_P to the DAG node for PATH in revision root ROOT, allocated
+   in RESULT_POOL.  PATH must be in canonical form.  Return the error
+   SVN_ERR_FS_NOT_FOUND if this node doesn't exist.
+
+   This is a simplified version of open_path() for the common case that
+   the caller only wants the final node of a committed tree.  All nodes
+   along PATH are taken from and put into the 1st level cache and are
+   being used by reference, i.e. without copying them.  Only the final
+   node will be duplicated and stored in the 2nd level cache.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+walk_dag_path(dag_node_t **node_p,
+              svn_fs_root_t *root,
+              const char *path,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = root->fs->fsap_data;
+  fs_fs_dag_cache_t *cache = ffd->dag_node_cache;
+  dag_node_t *here = NULL;
+  const char *rest = NULL;
+  apr_pool_t *iterpool;
+
+  /* Writable copy of PATH.  We terminate it at the end of the part
+     traversed so far and restore the '/' in the next iteration. */
+  apr_size_t path_len = strlen(path);
+  char *path_so_far = apr_pstrmemdup(scratch_pool, path, path_len);
+  apr_size_t len_so_far = 0;
+
+  SVN_ERR_ASSERT(!root->is_txn_root);
+  assert(svn_fs__is_canonical_abspath(path));
+
+  /* First attempt: PATH@REV may be the last node we looked up under a
+     different revision.  See open_path() for details. */
+  SVN_ERR(try_match_last_node(&here, root, path, path_len, scratch_pool));
+  if (here)
+    {
+      *node_p = svn_fs_fs__dag_dup(here, result_pool);
+      return SVN_NO_ERROR;
+    }
+
+  /* Second attempt: start at the parent directory, which we will often
+     have visited recently for a sibling. */
+  if (path_len > 1)
+    {
+      apr_size_t dirname_len = path_len;
+      while (path[dirname_len - 1] != '/')
+        --dirname_len;
+
+      /* Strip the separator unless the parent is the root. */
+      if (dirname_len > 1)
+        {
+          path_so_far[dirname_len - 1] = '\0';
+          here = cache_lookup(cache, root->rev, path_so_far);
+          if (here)
+            {
+              len_so_far = dirname_len - 1;
+              rest = path + dirname_len;
+            }
+        }
+    }
+
+  /* Start at the root, which we already have opened. */
+  if (!here)
+    {
+      here = root->fsap_data;
+      rest = path + 1;
+    }
+
+  path_so_far[len_so_far] = '\0';
+
+  /* Walk the remaining segments.  At the top of this loop, HERE is the
+     node for PATH_SO_FAR and REST is the part of PATH still to find. */
+  iterpool = svn_pool_create(scratch_pool);
+  while (*rest)
+    {
+      const char *next;
+      char *entry;
+      dag_node_t *child;
+
+      svn_pool_clear(iterpool);
+
+      /* HERE must be a directory if we want to look into it. */
+      if (svn_fs_fs__dag_node_kind(here) != svn_node_dir)
+        {
+          const char *msg
+            = apr_psprintf(iterpool,
+                           _("Failure opening '%s' in revision %ld"),
+                           path, root->rev);
+          SVN_ERR_W(SVN_FS__ERR_NOT_DIRECTORY(root->fs, path_so_far), msg);
+        }
+
+      /* Parse out the next entry and extend PATH_SO_FAR by it. */
+      entry = svn_fs__next_entry_name(&next, rest, iterpool);
+      path_so_far[len_so_far] = '/';
+      len_so_far += strlen(entry) + 1;
+      path_so_far[len_so_far] = '\0';
+
+      /* Nodes in the L1 cache are only valid until the next insertion,
+         so we must not keep HERE across the cache_insert() below. */
+      child = cache_lookup(cache, root->rev, path_so_far);
+      if (!child)
+        {
+          SVN_ERR(svn_fs_fs__dag_open(&child, here, entry, iterpool,
+                                      iterpool));
+          if (child == NULL)
+            return SVN_FS__NOT_FOUND(root, path);
+
+          child = cache_insert(cache, root->rev, path_so_far, child);
+        }
+
+      here = child;
+      rest = next ? next : "";
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Make the final node available to other FS instances. */
+  if (len_so_far)
+    SVN_ERR(dag_node_cache_set(root, path, here, scratch_pool));
+
+  *node_p = svn_fs_fs__dag_dup(here, result_pool);
+  return SVN_NO_ERROR;
+}
+
 
 /* Make the node referred to by PARENT_PATH mutable, if it isn't
    already, allocating from POOL.  ROOT must be the root from which
@@ -1305,7 +1434,15 @@ get_dag(dag_node_t **dag_node_p,
           SVN_ERR(dag_node_cache_get(&node, root, path, pool));
         }
 
-      if (! node)
+      if (! node && !root->is_txn_root)
+        {
+          /* Committed trees never change, so we can walk the path using
+           * the cached nodes directly. */
+          apr_pool_t *scratch_pool = svn_pool_create(pool);
+          SVN_ERR(walk_dag_path(&node, root, path, pool, scratch_pool));
+          svn_pool_destroy(scratch_pool);
+        }
+      else if (! node)
         {
           /* Call open_path with no flags, as we want this to return an
            * error if the node for which we are searching doesn't exist. */
@@ -1579,6 +1716,44 @@ fs_node_has_props(svn_boolean_t *has_props,
                                                   scratch_pool));
 }
 
+static svn_error_t *
+fs_node_proplists(apr_hash_t **proplists_p,
+                  svn_fs_root_t *root,
+                  const apr_array_header_t *paths,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *noderevs
+    = apr_array_make(scratch_pool, paths->nelts, sizeof(node_revision_t *));
+  apr_array_header_t *proplists;
+  int i;
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      dag_node_t *node;
+      node_revision_t *noderev;
+
+      SVN_ERR(get_dag(&node, root, path, scratch_pool));
+      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, root->fs,
+                                           svn_fs_fs__dag_get_id(node),
+                                           scratch_pool, scratch_pool));
+      APR_ARRAY_PUSH(noderevs, node_revision_t *) = noderev;
+    }
+
+  SVN_ERR(svn_fs_fs__get_proplists(&proplists, root->fs, noderevs,
+                                   result_pool, scratch_pool));
+
+  *proplists_p = apr_hash_make(result_pool);
+  for (i = 0; i < paths->nelts; ++i)
+    svn_hash_sets(*proplists_p,
+                  apr_pstrdup(result_pool,
+                              APR_ARRAY_IDX(paths, i, const char *)),
+                  APR_ARRAY_IDX(proplists, i, apr_hash_t *));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 increment_mergeinfo_up_tree(parent_path_t *pp,
                             apr_int64_t increment,
@@ -2197,6 +2372,28 @@ merge_changes(dag_node_t *ancestor_node,
 }
 
 
+/* Implements svn_fs_fs__txn_merge_func_t.  Merge the changes between
+   TXN's base revision and REV into TXN, just like one iteration of the
+   loop in svn_fs_fs__commit_txn does.  BATON is the svn_stringbuf_t *
+   that receives the path of a conflict. */
+static svn_error_t *
+merge_txn_to_rev(svn_fs_txn_t *txn,
+                 svn_revnum_t rev,
+                 void *baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *conflict = baton;
+  svn_fs_root_t *root;
+  dag_node_t *root_node;
+
+  SVN_ERR(svn_fs_fs__revision_root(&root, txn->fs, rev, scratch_pool));
+  SVN_ERR(get_root(&root_node, root, scratch_pool));
+  SVN_ERR(merge_changes(NULL, root_node, txn, conflict, scratch_pool));
+  txn->base_rev = rev;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__commit_txn(const char **conflict_p,
                       svn_revnum_t *new_rev,
@@ -2298,8 +2495,16 @@ svn_fs_fs__commit_txn(const char **conflict_p,
       txn->base_rev = youngish_rev;
 
       /* Try to commit. */
-      err = svn_fs_fs__commit(new_rev, fs, txn, iterpool);
-      if (err && (err->apr_err == SVN_ERR_FS_TXN_OUT_OF_DATE))
+      err = svn_fs_fs__commit(new_rev, fs, txn, merge_txn_to_rev, conflict,
+                              iterpool);
+      if (err && (err->apr_err == SVN_ERR_FS_CONFLICT))
+        {
+          /* Group commit had to merge newer revisions and failed. */
+          if (conflict_p)
+            *conflict_p = conflict->data;
+          goto cleanup;
+        }
+      else if (err && (err->apr_err == SVN_ERR_FS_TXN_OUT_OF_DATE))
         {
           /* Did someone else finish committing a new revision while we
              were in mid-merge or mid-commit?  If so, we'll need to
@@ -2464,6 +2669,45 @@ fs_dir_optimal_order(apr_array_header_t **ordered_p,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+fs_prefetch_dir_entries(svn_fs_root_t *root,
+                        const apr_array_header_t *paths,
+                        apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *noderevs
+    = apr_array_make(scratch_pool, paths->nelts, sizeof(node_revision_t *));
+  int i;
+
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      dag_node_t *node;
+      node_revision_t *noderev;
+      svn_error_t *err;
+
+      /* This is only a hint, so ignore paths that aren't directories. */
+      err = get_dag(&node, root, path, scratch_pool);
+      if (err && (   err->apr_err == SVN_ERR_FS_NOT_FOUND
+                  || err->apr_err == SVN_ERR_FS_NOT_DIRECTORY))
+        {
+          svn_error_clear(err);
+          continue;
+        }
+      SVN_ERR(err);
+
+      if (svn_fs_fs__dag_node_kind(node) != svn_node_dir)
+        continue;
+
+      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, root->fs,
+                                           svn_fs_fs__dag_get_id(node),
+                                           scratch_pool, scratch_pool));
+      APR_ARRAY_PUSH(noderevs, node_revision_t *) = noderev;
+    }
+
+  return svn_error_trace(svn_fs_fs__prefetch_dir_contents(root->fs, noderevs,
+                                                          scratch_pool));
+}
+
 /* Raise an error if PATH contains a newline because FSFS cannot handle
  * such paths. See issue #4340. */
 static svn_error_t *
@@ -2938,6 +3182,27 @@ fs_try_process_file_contents(svn_boolean_t *success,
 /* --- End machinery for svn_fs_try_process_file_contents() ---  */
 
 
+/* --- Machinery for svn_fs__try_get_file_range() ---  */
+
+static svn_error_t *
+fs_try_get_file_range(apr_file_t **file,
+                      apr_off_t *offset,
+                      svn_filesize_t *length,
+                      svn_fs_root_t *root,
+                      const char *path,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  dag_node_t *node;
+  SVN_ERR(get_dag(&node, root, path, scratch_pool));
+
+  return svn_fs_fs__dag_try_get_file_range(file, offset, length, node,
+                                           result_pool, scratch_pool);
+}
+
+/* --- End machinery for svn_fs__try_get_file_range() ---  */
+
+
 /* --- Machinery for svn_fs_apply_textdelta() ---  */
 
 
@@ -3279,6 +3544,30 @@ fs_get_file_delta_stream(svn_txdelta_stream_t **stream_p,
                                               target_node, pool);
 }
 
+static svn_error_t *
+fs_try_get_file_delta_range(apr_file_t **file,
+                            apr_off_t *offset,
+                            svn_filesize_t *length,
+                            svn_fs_root_t *source_root,
+                            const char *source_path,
+                            svn_fs_root_t *target_root,
+                            const char *target_path,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  dag_node_t *source_node, *target_node;
+
+  if (source_root && source_path)
+    SVN_ERR(get_dag(&source_node, source_root, source_path, scratch_pool));
+  else
+    source_node = NULL;
+  SVN_ERR(get_dag(&target_node, target_root, target_path, scratch_pool));
+
+  return svn_fs_fs__dag_try_get_file_delta_range(file, offset, length,
+                                                 source_node, target_node,
+                                                 result_pool, scratch_pool);
+}
+
 
 
 /* Finding Changes */
@@ -3507,6 +3796,11 @@ typedef struct fs_history_data_t
   /* If not NULL, this is the noderev ID of PATH@REVISION. */
   const svn_fs_id_t *current_id;
 
+  /* If CHUNK_KEY.REVISION is valid, the predecessor of CURRENT_ID is
+     entry CHUNK_POS of that chunk in the history cache. */
+  pair_cache_key_t chunk_key;
+  int chunk_pos;
+
 } fs_history_data_t;
 
 static svn_fs_history_t *
@@ -3828,6 +4122,161 @@ fs_node_origin_rev(svn_revnum_t *revision,
 }
 
 
+/* Maximum number of entries in a history chunk. */
+#define HISTORY_CHUNK_SIZE 64
+
+/* Linear sections of node history get walked over and over again by
+   log, blame and merge.  Instead of reading every node-revision along
+   the way, we cache chunks of the predecessor chain.  A chunk is an
+   array of history_entry_t, entry I being the predecessor ID of the
+   I-th node-revision following the chunk's start. */
+typedef struct history_entry_t
+{
+  /* Parts of the predecessor ID.  If REV_ITEM.REVISION is not a valid
+     revision, there is no predecessor. */
+  svn_fs_fs__id_part_t node_id;
+  svn_fs_fs__id_part_t copy_id;
+  svn_fs_fs__id_part_t rev_item;
+} history_entry_t;
+
+/* Implement svn_cache__partial_getter_func_t.  Set *OUT to a copy of
+   the history chunk entry at index *(int *)BATON, allocated in
+   RESULT_POOL, or to NULL if the chunk is shorter than that. */
+static svn_error_t *
+get_history_entry(void **out,
+                  const void *data,
+                  apr_size_t data_len,
+                  void *baton,
+                  apr_pool_t *result_pool)
+{
+  apr_size_t pos = *(int *)baton;
+
+  if (pos < data_len / sizeof(history_entry_t))
+    *out = apr_pmemdup(result_pool,
+                       (const char *)data + pos * sizeof(history_entry_t),
+                       sizeof(history_entry_t));
+  else
+    *out = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the predecessor chain in FS starting at node-revision START_ID,
+   store it as a new history chunk under KEY and return its first entry
+   in *ENTRY.  Don't follow the chain beyond revision STOP_REV.  Allocate
+   *ENTRY in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+build_history_chunk(history_entry_t **entry,
+                    svn_fs_t *fs,
+                    const svn_fs_id_t *start_id,
+                    svn_revnum_t stop_rev,
+                    const pair_cache_key_t *key,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_stringbuf_t *chunk = svn_stringbuf_create_empty(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  const svn_fs_id_t *id = start_id;
+  int i;
+
+  for (i = 0; i < HISTORY_CHUNK_SIZE; ++i)
+    {
+      node_revision_t *noderev;
+      history_entry_t next;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, iterpool,
+                                           iterpool));
+
+      memset(&next, 0, sizeof(next));
+      if (noderev->predecessor_id)
+        {
+          next.node_id = *svn_fs_fs__id_node_id(noderev->predecessor_id);
+          next.copy_id = *svn_fs_fs__id_copy_id(noderev->predecessor_id);
+          next.rev_item = *svn_fs_fs__id_rev_item(noderev->predecessor_id);
+        }
+      else
+        {
+          next.rev_item.revision = SVN_INVALID_REVNUM;
+        }
+
+      svn_stringbuf_appendbytes(chunk, (const char *)&next, sizeof(next));
+      if (   ! noderev->predecessor_id
+          || next.rev_item.revision <= stop_rev)
+        break;
+
+      id = svn_fs_fs__id_copy(noderev->predecessor_id, scratch_pool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  if (ffd->history_cache)
+    SVN_ERR(svn_cache__set(ffd->history_cache, key, chunk, scratch_pool));
+
+  *entry = apr_pmemdup(result_pool, chunk->data, sizeof(**entry));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *PRED_ID to the predecessor of FHD->CURRENT_ID, or to NULL if it
+   has none.  Set *CHUNK_KEY and *CHUNK_POS to the location of the
+   predecessor of *PRED_ID in the history cache.  Allocate *PRED_ID in
+   RESULT_POOL and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+get_history_predecessor(const svn_fs_id_t **pred_id,
+                        pair_cache_key_t *chunk_key,
+                        int *chunk_pos,
+                        fs_history_data_t *fhd,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fhd->fs->fsap_data;
+  history_entry_t *entry = NULL;
+  svn_boolean_t found;
+
+  /* Continue along the chunk that we have been following so far. */
+  if (ffd->history_cache && SVN_IS_VALID_REVNUM(fhd->chunk_key.revision))
+    {
+      *chunk_key = fhd->chunk_key;
+      *chunk_pos = fhd->chunk_pos;
+      SVN_ERR(svn_cache__get_partial((void **)&entry, &found,
+                                     ffd->history_cache, chunk_key,
+                                     get_history_entry, chunk_pos,
+                                     scratch_pool));
+    }
+
+  /* Otherwise, use the chunk starting at CURRENT_ID. */
+  if (! entry)
+    {
+      const svn_fs_fs__id_part_t *rev_item
+        = svn_fs_fs__id_rev_item(fhd->current_id);
+
+      chunk_key->revision = rev_item->revision;
+      chunk_key->second = rev_item->number;
+      *chunk_pos = 0;
+
+      if (ffd->history_cache)
+        SVN_ERR(svn_cache__get_partial((void **)&entry, &found,
+                                       ffd->history_cache, chunk_key,
+                                       get_history_entry, chunk_pos,
+                                       scratch_pool));
+      if (! entry)
+        SVN_ERR(build_history_chunk(&entry, fhd->fs, fhd->current_id,
+                                    fhd->next_copy, chunk_key,
+                                    scratch_pool, scratch_pool));
+    }
+
+  ++*chunk_pos;
+  if (SVN_IS_VALID_REVNUM(entry->rev_item.revision))
+    *pred_id = svn_fs_fs__id_rev_create(&entry->node_id, &entry->copy_id,
+                                        &entry->rev_item, result_pool);
+  else
+    *pred_id = NULL;
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 history_prev(svn_fs_history_t **prev_history,
              svn_fs_history_t *history,
@@ -3860,33 +4309,41 @@ history_prev(svn_fs_history_t **prev_history,
     {
       /* We know the last reported node (CURRENT_ID) and the NEXT_COPY
          revision is somewhat further in the past. */
-      node_revision_t *noderev;
+      fs_history_data_t *prev_fhd;
+      pair_cache_key_t chunk_key;
+      int chunk_pos;
       assert(reported);
 
       /* Get the previous node change.  If there is none, then we already
          reported the initial addition and this history traversal is done. */
-      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, fhd->current_id,
-                                           scratch_pool, scratch_pool));
-      if (! noderev->predecessor_id)
+      SVN_ERR(get_history_predecessor(&pred_id, &chunk_key, &chunk_pos,
+                                      fhd, scratch_pool, scratch_pool));
+      if (! pred_id)
         return SVN_NO_ERROR;
 
       /* If the previous node change is younger than the next copy, it is
          part of the linear history section. */
-      commit_rev = svn_fs_fs__id_rev(noderev->predecessor_id);
+      commit_rev = svn_fs_fs__id_rev(pred_id);
       if (commit_rev > fhd->next_copy)
         {
           /* Within the linear history, simply report all node changes and
-             continue with the respective predecessor. */
-          *prev_history = assemble_history(fs, noderev->created_path,
+             continue with the respective predecessor.  Without copies,
+             the node cannot have changed its path. */
+          *prev_history = assemble_history(fs, fhd->path,
                                            commit_rev, TRUE, NULL,
                                            SVN_INVALID_REVNUM,
                                            fhd->next_copy,
-                                           noderev->predecessor_id,
+                                           pred_id,
                                            result_pool);
+          prev_fhd = (*prev_history)->fsap_data;
+          prev_fhd->chunk_key = chunk_key;
+          prev_fhd->chunk_pos = chunk_pos;
 
           return SVN_NO_ERROR;
         }
 
+      pred_id = NULL;
+
      /* We hit a copy. Fall back to the standard code path. */
     }
 
@@ -4129,6 +4586,7 @@ assemble_history(svn_fs_t *fs,
   fhd->rev_hint = rev_hint;
   fhd->next_copy = next_copy;
   fhd->current_id = current_id ? svn_fs_fs__id_copy(current_id, pool) : NULL;
+  fhd->chunk_key.revision = SVN_INVALID_REVNUM;
   fhd->fs = fs;
 
   history->vtable = &history_vtable;
@@ -4140,6 +4598,97 @@ assemble_history(svn_fs_t *fs,
 /* mergeinfo queries */
 
 
+/* Set *MERGEINFO to the parsed svn:mergeinfo of the node DAG, which claims
+   to have mergeinfo.  Set it to NULL if the mergeinfo is syntactically
+   invalid.  The parsed mergeinfo of immutable nodes is cached per
+   node-revision, so repeated queries and tree crawls don't have to fetch
+   and parse the same property again.  Allocate *MERGEINFO in RESULT_POOL.
+   Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_dag_mergeinfo(svn_mergeinfo_t *mergeinfo,
+                  dag_node_t *dag,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = svn_fs_fs__dag_get_fs(dag)->fsap_data;
+  svn_boolean_t cacheable = (ffd->explicit_mergeinfo_cache
+                             && ! svn_fs_fs__dag_check_mutable(dag));
+  pair_cache_key_t key;
+  apr_hash_t *proplist;
+  svn_string_t *mergeinfo_string;
+  svn_error_t *err;
+
+  if (cacheable)
+    {
+      const svn_fs_fs__id_part_t *rev_item
+        = svn_fs_fs__id_rev_item(svn_fs_fs__dag_get_id(dag));
+      svn_boolean_t found;
+
+      key.revision = rev_item->revision;
+      key.second = rev_item->number;
+      SVN_ERR(svn_cache__get((void **)mergeinfo, &found,
+                             ffd->explicit_mergeinfo_cache, &key,
+                             result_pool));
+      if (found)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, dag, scratch_pool));
+  mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
+  if (!mergeinfo_string)
+    {
+      svn_string_t *idstr = svn_fs_fs__id_unparse(svn_fs_fs__dag_get_id(dag),
+                                                  scratch_pool);
+      return svn_error_createf
+        (SVN_ERR_FS_CORRUPT, NULL,
+         _("Node-revision #'%s' claims to have mergeinfo but doesn't"),
+         idstr->data);
+    }
+
+  /* Issue #3896: If a node has syntactically invalid mergeinfo, then
+     treat it as if no mergeinfo is present rather than raising a parse
+     error. */
+  err = svn_mergeinfo_parse(mergeinfo, mergeinfo_string->data, result_pool);
+  if (err)
+    {
+      *mergeinfo = NULL;
+      if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+        {
+          svn_error_clear(err);
+          err = NULL;
+        }
+      return svn_error_trace(err);
+    }
+
+  if (cacheable)
+    SVN_ERR(svn_cache__set(ffd->explicit_mergeinfo_cache, &key, *mergeinfo,
+                           scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the mergeinfo of the node DAG, which is at PATH and claims to have
+   mergeinfo, and call RECEIVER with it and BATON unless it is invalid.
+   SCRATCH_POOL is used for temporary allocations, including the mergeinfo
+   hash passed to RECEIVER.
+ */
+static svn_error_t *
+receive_dag_mergeinfo(const char *path,
+                      dag_node_t *dag,
+                      svn_fs_mergeinfo_receiver_t receiver,
+                      void *baton,
+                      apr_pool_t *scratch_pool)
+{
+  svn_mergeinfo_t mergeinfo;
+
+  SVN_ERR(get_dag_mergeinfo(&mergeinfo, dag, scratch_pool, scratch_pool));
+  if (mergeinfo)
+    SVN_ERR(receiver(path, mergeinfo, baton, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* DIR_DAG is a directory DAG node which has mergeinfo in its
    descendants.  This function iterates over its children.  For each
    child with immediate mergeinfo, call RECEIVER with it and BATON.
@@ -4177,43 +4726,10 @@ crawl_directory_dag_for_mergeinfo(svn_fs_root_t *root,
       SVN_ERR(svn_fs_fs__dag_has_mergeinfo(&has_mergeinfo, kid_dag));
       SVN_ERR(svn_fs_fs__dag_has_descendants_with_mergeinfo(&go_down, kid_dag));
 
+      /* Save this particular node's mergeinfo. */
       if (has_mergeinfo)
-        {
-          /* Save this particular node's mergeinfo. */
-          apr_hash_t *proplist;
-          svn_mergeinfo_t kid_mergeinfo;
-          svn_string_t *mergeinfo_string;
-          svn_error_t *err;
-
-          SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, kid_dag, iterpool));
-          mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
-          if (!mergeinfo_string)
-            {
-              svn_string_t *idstr = svn_fs_fs__id_unparse(dirent->id, iterpool);
-              return svn_error_createf
-                (SVN_ERR_FS_CORRUPT, NULL,
-                 _("Node-revision #'%s' claims to have mergeinfo but doesn't"),
-                 idstr->data);
-            }
-
-          /* Issue #3896: If a node has syntactically invalid mergeinfo, then
-             treat it as if no mergeinfo is present rather than raising a parse
-             error. */
-          err = svn_mergeinfo_parse(&kid_mergeinfo,
-                                    mergeinfo_string->data,
-                                    iterpool);
-          if (err)
-            {
-              if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
-                svn_error_clear(err);
-              else
-                return svn_error_trace(err);
-              }
-          else
-            {
-              SVN_ERR(receiver(kid_path, kid_mergeinfo, baton, iterpool));
-            }
-        }
+        SVN_ERR(receive_dag_mergeinfo(kid_path, kid_dag, receiver, baton,
+                                      iterpool));
 
       if (go_down)
         SVN_ERR(crawl_directory_dag_for_mergeinfo(root,
@@ -4262,8 +4778,6 @@ get_mergeinfo_for_path_internal(svn_mergeinfo_t *mergeinfo,
                                 apr_pool_t *scratch_pool)
 {
   parent_path_t *parent_path, *nearest_ancestor;
-  apr_hash_t *proplist;
-  svn_string_t *mergeinfo_string;
 
   path = svn_fs__canonicalize_abspath(path, scratch_pool);
 
@@ -4301,34 +4815,11 @@ get_mergeinfo_for_path_internal(svn_mergeinfo_t *mergeinfo,
         }
     }
 
-  SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, nearest_ancestor->node,
-                                      scratch_pool));
-  mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
-  if (!mergeinfo_string)
-    return svn_error_createf
-      (SVN_ERR_FS_CORRUPT, NULL,
-       _("Node-revision '%s@%ld' claims to have mergeinfo but doesn't"),
-       parent_path_path(nearest_ancestor, scratch_pool), rev_root->rev);
-
   /* Parse the mergeinfo; store the result in *MERGEINFO. */
-  {
-    /* Issue #3896: If a node has syntactically invalid mergeinfo, then
-       treat it as if no mergeinfo is present rather than raising a parse
-       error. */
-    svn_error_t *err = svn_mergeinfo_parse(mergeinfo,
-                                           mergeinfo_string->data,
-                                           result_pool);
-    if (err)
-      {
-        if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
-          {
-            svn_error_clear(err);
-            err = NULL;
-            *mergeinfo = NULL;
-          }
-        return svn_error_trace(err);
-      }
-  }
+  SVN_ERR(get_dag_mergeinfo(mergeinfo, nearest_ancestor->node,
+                            result_pool, scratch_pool));
+  if (! *mergeinfo)
+    return SVN_NO_ERROR;
 
   /* If our nearest ancestor is the very path we inquired about, we
      can return the mergeinfo results directly.  Otherwise, we're
@@ -4415,6 +4906,38 @@ add_descendant_mergeinfo(svn_fs_root_t *root,
 {
   dag_node_t *this_dag;
   svn_boolean_t go_down;
+  apr_array_header_t *kid_paths = NULL;
+
+  /* Let the mergeinfo index tell us where to look instead of crawling
+     the tree, if it covers this revision. */
+  if (! root->is_txn_root)
+    SVN_ERR(svn_fs_fs__get_indexed_mergeinfo_paths(&kid_paths, root->fs,
+                                                   root->rev, path,
+                                                   scratch_pool,
+                                                   scratch_pool));
+  if (kid_paths)
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      int i;
+
+      for (i = 0; i < kid_paths->nelts; ++i)
+        {
+          const char *kid_path = APR_ARRAY_IDX(kid_paths, i, const char *);
+          dag_node_t *kid_dag;
+          svn_boolean_t has_mergeinfo;
+
+          svn_pool_clear(iterpool);
+
+          SVN_ERR(get_dag(&kid_dag, root, kid_path, iterpool));
+          SVN_ERR(svn_fs_fs__dag_has_mergeinfo(&has_mergeinfo, kid_dag));
+          if (has_mergeinfo)
+            SVN_ERR(receive_dag_mergeinfo(kid_path, kid_dag, receiver, baton,
+                                          iterpool));
+        }
+
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
 
   SVN_ERR(get_dag(&this_dag, root, path, scratch_pool));
   SVN_ERR(svn_fs_fs__dag_has_descendants_with_mergeinfo(&go_down,
@@ -4430,6 +4953,82 @@ add_descendant_mergeinfo(svn_fs_root_t *root,
 }
 
 
+/* Append the paths of all descendants of THIS_PATH in ROOT, which is the
+   directory DIR_DAG, that have mergeinfo to PATHS.  Allocate them in
+   RESULT_POOL.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+crawl_directory_dag_for_mergeinfo_paths(apr_array_header_t *paths,
+                                        svn_fs_root_t *root,
+                                        const char *this_path,
+                                        dag_node_t *dir_dag,
+                                        apr_pool_t *result_pool,
+                                        apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *entries;
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(svn_fs_fs__dag_dir_entries(&entries, dir_dag, scratch_pool));
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_dirent_t *dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+      const char *kid_path;
+      dag_node_t *kid_dag;
+      svn_boolean_t has_mergeinfo, go_down;
+
+      svn_pool_clear(iterpool);
+
+      kid_path = svn_fspath__join(this_path, dirent->name, iterpool);
+      SVN_ERR(get_dag(&kid_dag, root, kid_path, iterpool));
+
+      SVN_ERR(svn_fs_fs__dag_has_mergeinfo(&has_mergeinfo, kid_dag));
+      SVN_ERR(svn_fs_fs__dag_has_descendants_with_mergeinfo(&go_down, kid_dag));
+
+      if (has_mergeinfo)
+        APR_ARRAY_PUSH(paths, const char *) = apr_pstrdup(result_pool,
+                                                          kid_path);
+      if (go_down)
+        SVN_ERR(crawl_directory_dag_for_mergeinfo_paths(paths, root,
+                                                        kid_path, kid_dag,
+                                                        result_pool,
+                                                        iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_mergeinfo_paths(apr_array_header_t **paths,
+                               svn_fs_root_t *root,
+                               const char *path,
+                               svn_boolean_t include_descendants,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  dag_node_t *dag;
+  svn_boolean_t has_mergeinfo, go_down;
+
+  path = svn_fs__canonicalize_abspath(path, scratch_pool);
+  *paths = apr_array_make(result_pool, 0, sizeof(const char *));
+
+  SVN_ERR(get_dag(&dag, root, path, scratch_pool));
+  SVN_ERR(svn_fs_fs__dag_has_mergeinfo(&has_mergeinfo, dag));
+  if (has_mergeinfo)
+    APR_ARRAY_PUSH(*paths, const char *) = apr_pstrdup(result_pool, path);
+
+  if (include_descendants)
+    {
+      SVN_ERR(svn_fs_fs__dag_has_descendants_with_mergeinfo(&go_down, dag));
+      if (go_down)
+        SVN_ERR(crawl_directory_dag_for_mergeinfo_paths(*paths, root, path,
+                                                        dag, result_pool,
+                                                        scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Find all the mergeinfo for a set of PATHS under ROOT and report it
    through RECEIVER with BATON.  INHERITED, INCLUDE_DESCENDANTS and
    ADJUST_INHERITED_MERGEINFO are the same as in the FS API.
@@ -4538,20 +5137,24 @@ static root_vtable_t root_vtable = {
   fs_node_prop,
   fs_node_proplist,
   fs_node_has_props,
+  fs_node_proplists,
   fs_change_node_prop,
   fs_props_changed,
   fs_dir_entries,
   fs_dir_optimal_order,
+  fs_prefetch_dir_entries,
   fs_make_dir,
   fs_file_length,
   fs_file_checksum,
   fs_file_contents,
   fs_try_process_file_contents,
+  fs_try_get_file_range,
   fs_make_file,
   fs_apply_textdelta,
   fs_apply_text,
   fs_contents_changed,
   fs_get_file_delta_stream,
+  fs_try_get_file_delta_range,
   fs_merge,
   fs_get_mergeinfo,
 };
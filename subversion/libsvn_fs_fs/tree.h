@@ -84,6 +84,18 @@ svn_fs_fs__node_created_rev(svn_revnum_t *revision,
                             const char *path,
                             apr_pool_t *pool);
 
+/* Set *PATHS to the paths of the nodes under the revision ROOT that have
+   mergeinfo, starting at PATH.  If INCLUDE_DESCENDANTS is FALSE, only
+   consider PATH itself.  The paths are allocated in RESULT_POOL and are
+   in no particular order.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__get_mergeinfo_paths(apr_array_header_t **paths,
+                               svn_fs_root_t *root,
+                               const char *path,
+                               svn_boolean_t include_descendants,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
 /* Verify metadata for ROOT.
    ### Currently only implemented for revision roots. */
 svn_error_t *
@@ -0,0 +1,421 @@
+/* txn-store.c --- in-memory transaction metadata
+ *
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_string_private.h"
+
+#include "svn_private_config.h"
+
+#include "fs.h"
+#include "id.h"
+#include "txn-store.h"
+
+/* The in-memory files of a single transaction. */
+typedef struct txn_files_t
+{
+  /* Maps the on-disk path (const char *) of each file to its contents
+     (svn_stringbuf_t *). */
+  apr_hash_t *files;
+
+  /* Sum of the lengths of all FILES. */
+  apr_size_t size;
+
+  /* If SIZE would exceed this, the files get written to disk. */
+  apr_size_t limit;
+
+  /* Root pool containing this object.  Transactions may be accessed
+     from different threads, so this can't be a sub-pool of any svn_fs_t
+     or request pool. */
+  apr_pool_t *pool;
+} txn_files_t;
+
+struct fs_fs_txn_store_t
+{
+  /* Maps the unparsed txn ID (const char *) to its txn_files_t. */
+  apr_hash_t *txns;
+
+  /* Serializes all access to TXNS and its contents. */
+  svn_mutex__t *lock;
+};
+
+/* APR pool cleanup callback releasing all transactions in the
+   fs_fs_txn_store_t BATON.  No other thread may access the store
+   anymore at this point. */
+static apr_status_t
+release_txns(void *baton)
+{
+  fs_fs_txn_store_t *store = baton;
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(NULL, store->txns); hi; hi = apr_hash_next(hi))
+    {
+      txn_files_t *txn = apr_hash_this_val(hi);
+      svn_pool_destroy(txn->pool);
+    }
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_fs_fs__txn_store_create(fs_fs_txn_store_t **store_p,
+                            apr_pool_t *result_pool)
+{
+  fs_fs_txn_store_t *store = apr_pcalloc(result_pool, sizeof(*store));
+
+  SVN_ERR(svn_mutex__init(&store->lock, TRUE, result_pool));
+  store->txns = apr_hash_make(result_pool);
+  apr_pool_cleanup_register(result_pool, store, release_txns,
+                            apr_pool_cleanup_null);
+
+  *store_p = store;
+  return SVN_NO_ERROR;
+}
+
+/* Return the store shared by all svn_fs_t of FS' repository or NULL if
+   that is not available, e.g. while creating the repository. */
+static fs_fs_txn_store_t *
+get_store(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  return ffd->shared ? ffd->shared->txn_store : NULL;
+}
+
+/* Write the unparsed TXN_ID into BUFFER and return it.  BUFFER must
+   provide 2 * SVN_INT64_BUFFER_SIZE + 1 chars.  This is the same as
+   svn_fs_fs__id_txn_unparse but doesn't need a pool. */
+static const char *
+txn_key(char *buffer,
+        const svn_fs_fs__id_part_t *txn_id)
+{
+  char *p = buffer;
+
+  p += svn__i64toa(p, txn_id->revision);
+  *(p++) = '-';
+  p += svn__ui64tobase36(p, txn_id->number);
+
+  return buffer;
+}
+
+/* Baton type for the *_locked() functions below. */
+typedef struct store_baton_t
+{
+  /* The store and the transaction within it. */
+  fs_fs_txn_store_t *store;
+  const char *key;
+
+  /* Path of the file to access. */
+  const char *path;
+
+  /* In/out data. */
+  svn_stringbuf_t *contents;
+  const svn_stringbuf_t *data;
+  svn_boolean_t append;
+  svn_boolean_t in_memory;
+
+  /* Used to allocate CONTENTS. */
+  apr_pool_t *pool;
+} store_baton_t;
+
+/* Write all files of TXN in STORE to disk and stop keeping it in memory.
+   Use SCRATCH_POOL for temporary allocations.  The caller must hold
+   STORE's lock. */
+static svn_error_t *
+spill_txn(fs_fs_txn_store_t *store,
+          const char *key,
+          txn_files_t *txn,
+          apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(scratch_pool, txn->files);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *path = apr_hash_this_key(hi);
+      svn_stringbuf_t *contents = apr_hash_this_val(hi);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_io_file_create_bytes(path, contents->data, contents->len,
+                                       iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Only forget about TXN once all of its files made it to disk. */
+  svn_hash_sets(store->txns, key, NULL);
+  svn_pool_destroy(txn->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* If the transaction of BATON is kept in memory, set BATON->IN_MEMORY
+   and copy the file contents into BATON->CONTENTS.  The caller must hold
+   the store's lock. */
+static svn_error_t *
+read_locked(store_baton_t *baton)
+{
+  txn_files_t *txn = svn_hash_gets(baton->store->txns, baton->key);
+  svn_stringbuf_t *contents;
+
+  baton->in_memory = txn != NULL;
+  if (!txn)
+    return SVN_NO_ERROR;
+
+  contents = svn_hash_gets(txn->files, baton->path);
+  if (!contents)
+    return svn_error_wrap_apr(APR_ENOENT, _("Can't open file '%s'"),
+                              svn_dirent_local_style(baton->path,
+                                                     baton->pool));
+
+  baton->contents = svn_stringbuf_dup(contents, baton->pool);
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_fs_fs__txn_store_write for BATON.  The caller must hold
+   the store's lock. */
+static svn_error_t *
+write_locked(store_baton_t *baton)
+{
+  txn_files_t *txn = svn_hash_gets(baton->store->txns, baton->key);
+  svn_stringbuf_t *contents;
+  apr_size_t old_len;
+
+  baton->in_memory = txn != NULL;
+  if (!txn)
+    return SVN_NO_ERROR;
+
+  contents = svn_hash_gets(txn->files, baton->path);
+  old_len = contents ? contents->len : 0;
+
+  if (txn->size - old_len + baton->data->len
+      + (baton->append ? old_len : 0) > txn->limit)
+    {
+      baton->in_memory = FALSE;
+      return svn_error_trace(spill_txn(baton->store, baton->key, txn,
+                                       baton->pool));
+    }
+
+  if (!contents)
+    {
+      contents = svn_stringbuf_create_ensure(baton->data->len, txn->pool);
+      svn_hash_sets(txn->files, apr_pstrdup(txn->pool, baton->path),
+                    contents);
+    }
+  else if (!baton->append)
+    {
+      svn_stringbuf_setempty(contents);
+    }
+
+  svn_stringbuf_appendbytes(contents, baton->data->data, baton->data->len);
+  txn->size = txn->size - old_len + contents->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_fs_fs__txn_store_remove for BATON.  The caller must hold
+   the store's lock. */
+static svn_error_t *
+remove_locked(store_baton_t *baton)
+{
+  txn_files_t *txn = svn_hash_gets(baton->store->txns, baton->key);
+  svn_stringbuf_t *contents;
+
+  baton->in_memory = txn != NULL;
+  if (!txn)
+    return SVN_NO_ERROR;
+
+  /* The path key remains allocated in TXN->POOL but that one is
+     short-lived anyway. */
+  contents = svn_hash_gets(txn->files, baton->path);
+  if (contents)
+    {
+      txn->size -= contents->len;
+      svn_hash_sets(txn->files, baton->path, NULL);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_fs_fs__txn_store_add for BATON, with TXN being the new,
+   empty transaction data.  The caller must hold the store's lock. */
+static svn_error_t *
+add_locked(store_baton_t *baton,
+           txn_files_t *txn)
+{
+  svn_hash_sets(baton->store->txns, apr_pstrdup(txn->pool, baton->key),
+                txn);
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_fs_fs__txn_store_purge for BATON and return the
+   transaction's pool in *POOL_P.  The caller must hold the store's lock.
+ */
+static svn_error_t *
+purge_locked(apr_pool_t **pool_p,
+             store_baton_t *baton)
+{
+  txn_files_t *txn = svn_hash_gets(baton->store->txns, baton->key);
+
+  *pool_p = txn ? txn->pool : NULL;
+  if (txn)
+    svn_hash_sets(baton->store->txns, baton->key, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__txn_store_add(svn_fs_t *fs,
+                         const svn_fs_fs__id_part_t *txn_id)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  char buffer[2 * SVN_INT64_BUFFER_SIZE + 1];
+  store_baton_t baton = { 0 };
+  apr_pool_t *pool;
+  txn_files_t *txn;
+
+  baton.store = get_store(fs);
+  if (!baton.store || ffd->in_memory_txn_size == 0)
+    return SVN_NO_ERROR;
+
+  pool = svn_pool_create(NULL);
+  txn = apr_pcalloc(pool, sizeof(*txn));
+  txn->files = apr_hash_make(pool);
+  txn->limit = ffd->in_memory_txn_size;
+  txn->pool = pool;
+
+  baton.key = txn_key(buffer, txn_id);
+  SVN_MUTEX__WITH_LOCK(baton.store->lock, add_locked(&baton, txn));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__txn_store_open_readonly(svn_stream_t **stream,
+                                   svn_fs_t *fs,
+                                   const svn_fs_fs__id_part_t *txn_id,
+                                   const char *path,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool)
+{
+  char buffer[2 * SVN_INT64_BUFFER_SIZE + 1];
+  store_baton_t baton = { 0 };
+
+  baton.store = get_store(fs);
+  if (baton.store)
+    {
+      baton.key = txn_key(buffer, txn_id);
+      baton.path = path;
+      baton.pool = result_pool;
+      SVN_MUTEX__WITH_LOCK(baton.store->lock, read_locked(&baton));
+    }
+
+  if (baton.in_memory)
+    *stream = svn_stream_from_stringbuf(baton.contents, result_pool);
+  else
+    SVN_ERR(svn_stream_open_readonly(stream, path, result_pool,
+                                     scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__txn_store_write(svn_boolean_t *in_memory,
+                           svn_fs_t *fs,
+                           const svn_fs_fs__id_part_t *txn_id,
+                           const char *path,
+                           const svn_stringbuf_t *data,
+                           svn_boolean_t append,
+                           apr_pool_t *scratch_pool)
+{
+  char buffer[2 * SVN_INT64_BUFFER_SIZE + 1];
+  store_baton_t baton = { 0 };
+
+  *in_memory = FALSE;
+  baton.store = get_store(fs);
+  if (!baton.store)
+    return SVN_NO_ERROR;
+
+  baton.key = txn_key(buffer, txn_id);
+  baton.path = path;
+  baton.data = data;
+  baton.append = append;
+  baton.pool = scratch_pool;
+  SVN_MUTEX__WITH_LOCK(baton.store->lock, write_locked(&baton));
+
+  *in_memory = baton.in_memory;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__txn_store_remove(svn_boolean_t *in_memory,
+                            svn_fs_t *fs,
+                            const svn_fs_fs__id_part_t *txn_id,
+                            const char *path)
+{
+  char buffer[2 * SVN_INT64_BUFFER_SIZE + 1];
+  store_baton_t baton = { 0 };
+
+  *in_memory = FALSE;
+  baton.store = get_store(fs);
+  if (!baton.store)
+    return SVN_NO_ERROR;
+
+  baton.key = txn_key(buffer, txn_id);
+  baton.path = path;
+  SVN_MUTEX__WITH_LOCK(baton.store->lock, remove_locked(&baton));
+
+  *in_memory = baton.in_memory;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__txn_store_purge(svn_fs_t *fs,
+                           const svn_fs_fs__id_part_t *txn_id)
+{
+  char buffer[2 * SVN_INT64_BUFFER_SIZE + 1];
+  store_baton_t baton = { 0 };
+  apr_pool_t *pool;
+
+  baton.store = get_store(fs);
+  if (!baton.store)
+    return SVN_NO_ERROR;
+
+  baton.key = txn_key(buffer, txn_id);
+  SVN_MUTEX__WITH_LOCK(baton.store->lock, purge_locked(&pool, &baton));
+
+  /* Release the memory outside the lock. */
+  if (pool)
+    svn_pool_destroy(pool);
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,108 @@
+/* txn-store.h : interface to in-memory transaction metadata
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#ifndef SVN_LIBSVN_FS_FS_TXN_STORE_H
+#define SVN_LIBSVN_FS_FS_TXN_STORE_H
+
+#include "svn_error.h"
+
+#include "fs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/* Transactions normally keep their node revisions, property lists,
+   changes and next-ids as small files in the txn directory.  For
+   transactions that don't need to be visible to other processes before
+   they get committed, this store keeps these files in memory instead.
+   It is shared by all svn_fs_t of the same repository within this
+   process.  Once a transaction's files exceed the configured size, they
+   get written to the txn directory and that transaction continues in
+   the usual way.
+
+   All functions below take the PATH that the respective file would have
+   on disk.  Those with an IN_MEMORY parameter do nothing and set it to
+   FALSE if transaction TXN_ID is not kept in memory, in which case the
+   caller accesses the txn directory instead. */
+
+/* Create an empty store in *STORE_P, allocated in RESULT_POOL.  Any
+   remaining contents will be released when RESULT_POOL gets cleaned up. */
+svn_error_t *
+svn_fs_fs__txn_store_create(fs_fs_txn_store_t **store_p,
+                            apr_pool_t *result_pool);
+
+/* Start keeping the files of the new transaction TXN_ID in FS in memory,
+   up to FS' in-memory-txn-size.  This must be called before any of the
+   transaction's files have been written. */
+svn_error_t *
+svn_fs_fs__txn_store_add(svn_fs_t *fs,
+                         const svn_fs_fs__id_part_t *txn_id);
+
+/* Open the file at PATH of transaction TXN_ID in FS for reading and
+   return it in *STREAM, allocated in RESULT_POOL.  Depending on the
+   transaction, the data comes from memory or from disk.  Either way,
+   return an APR_ENOENT error if there is no such file.  Use SCRATCH_POOL
+   for temporary allocations. */
+svn_error_t *
+svn_fs_fs__txn_store_open_readonly(svn_stream_t **stream,
+                                   svn_fs_t *fs,
+                                   const svn_fs_fs__id_part_t *txn_id,
+                                   const char *path,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool);
+
+/* If TXN_ID in FS is kept in memory, set *IN_MEMORY to TRUE and replace
+   the file at PATH with DATA or, if APPEND is set, append DATA to it.
+   If that makes the transaction's files too large, write all of them
+   to disk and set *IN_MEMORY to FALSE, i.e. leave the actual write to
+   the caller.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__txn_store_write(svn_boolean_t *in_memory,
+                           svn_fs_t *fs,
+                           const svn_fs_fs__id_part_t *txn_id,
+                           const char *path,
+                           const svn_stringbuf_t *data,
+                           svn_boolean_t append,
+                           apr_pool_t *scratch_pool);
+
+/* If TXN_ID in FS is kept in memory, set *IN_MEMORY to TRUE and remove
+   the file at PATH, if it exists. */
+svn_error_t *
+svn_fs_fs__txn_store_remove(svn_boolean_t *in_memory,
+                            svn_fs_t *fs,
+                            const svn_fs_fs__id_part_t *txn_id,
+                            const char *path);
+
+/* Release all in-memory files of transaction TXN_ID in FS, if any. */
+svn_error_t *
+svn_fs_fs__txn_store_purge(svn_fs_t *fs,
+                           const svn_fs_fs__id_part_t *txn_id);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_FS_FS_TXN_STORE_H */
@@ -263,6 +263,7 @@ compare_l2p_to_p2l_index(svn_fs_t *fs,
 {
   svn_revnum_t i;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_pool_t *revpool = svn_pool_create(pool);
   apr_array_header_t *max_ids;
 
   /* common file access structure */
@@ -280,16 +281,30 @@ compare_l2p_to_p2l_index(svn_fs_t *fs,
       apr_uint64_t k;
       apr_uint64_t max_id = APR_ARRAY_IDX(max_ids, i, apr_uint64_t);
       svn_revnum_t revision = start + i;
+      apr_array_header_t *items;
+      apr_array_header_t *offsets;
 
+      /* get all L2P entries of REVISION in one go */
+      svn_pool_clear(revpool);
+      items = apr_array_make(revpool, (int)max_id,
+                             sizeof(svn_fs_fs__id_part_t));
       for (k = 0; k < max_id; ++k)
         {
-          apr_off_t offset;
+          svn_fs_fs__id_part_t *item = apr_array_push(items);
+          item->revision = revision;
+          item->number = k;
+        }
+
+      SVN_ERR(svn_fs_fs__item_offsets(&offsets, fs, rev_file, items,
+                                      revpool, iterpool));
+
+      for (k = 0; k < max_id; ++k)
+        {
+          apr_off_t offset = APR_ARRAY_IDX(offsets, k, apr_off_t);
           svn_fs_fs__p2l_entry_t *p2l_entry;
           svn_pool_clear(iterpool);
 
-          /* get L2P entry.  Ignore unused entries. */
-          SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rev_file, revision,
-                                         NULL, k, iterpool));
+          /* Ignore unused entries. */
           if (offset == -1)
             continue;
 
@@ -324,6 +339,7 @@ compare_l2p_to_p2l_index(svn_fs_t *fs,
     }
 
   svn_pool_destroy(iterpool);
+  svn_pool_destroy(revpool);
 
   SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
 
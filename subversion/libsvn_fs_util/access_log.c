@@ -0,0 +1,328 @@
+/* access_log.c --- ring buffer of item accesses
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_file_io.h>
+
+#include "private/svn_fs_util.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+#include "svn_private_config.h"
+
+/* File layout, all numbers little endian:
+ *
+ * Header
+ *   0  8 bytes  ACCESS_LOG_MAGIC
+ *   8  4 bytes  capacity in records
+ *  12  4 bytes  block size of the repository
+ *  16  4 bytes  shard size of the repository
+ *  20  4 bytes  reserved, 0
+ *  24  8 bytes  total number of records ever written
+ *
+ * followed by CAPACITY slots of one record each:
+ *   0  8 bytes  offset, all bits set if unknown
+ *   8  4 bytes  revision
+ *  12  4 bytes  size
+ *  16  1 byte   item type
+ *  17  1 byte   flags, see below
+ *
+ * Record number N is stored in slot N % CAPACITY.
+ */
+#define ACCESS_LOG_MAGIC "SVNFSAL1"
+#define HEADER_SIZE 32
+#define TOTAL_OFFSET 24
+#define RECORD_SIZE 18
+
+/* Record flags. */
+#define FLAG_CACHE_HIT 1
+#define FLAG_PACKED    2
+
+/* Number of records to buffer before writing them to disk. */
+#define BUFFER_RECORDS 256
+
+struct svn_fs__access_log_t
+{
+  /* The log file, opened for read and write. */
+  apr_file_t *file;
+
+  /* Path of FILE in local style, used in error messages. */
+  const char *path;
+
+  /* Number of records in BUFFER. */
+  int count;
+
+  /* Encoded records not written to FILE, yet. */
+  unsigned char buffer[BUFFER_RECORDS * RECORD_SIZE];
+};
+
+static void
+encode_uint32(unsigned char *p, apr_uint32_t value)
+{
+  int i;
+  for (i = 0; i < 4; ++i, value >>= 8)
+    p[i] = (unsigned char)(value & 0xff);
+}
+
+static void
+encode_uint64(unsigned char *p, apr_uint64_t value)
+{
+  int i;
+  for (i = 0; i < 8; ++i, value >>= 8)
+    p[i] = (unsigned char)(value & 0xff);
+}
+
+static apr_uint32_t
+decode_uint32(const unsigned char *p)
+{
+  apr_uint32_t value = 0;
+  int i;
+  for (i = 3; i >= 0; --i)
+    value = (value << 8) + p[i];
+
+  return value;
+}
+
+static apr_uint64_t
+decode_uint64(const unsigned char *p)
+{
+  apr_uint64_t value = 0;
+  int i;
+  for (i = 7; i >= 0; --i)
+    value = (value << 8) + p[i];
+
+  return value;
+}
+
+/* Append all buffered records in LOG to its file and empty the buffer.
+ * Allocates no memory, so it can be called during pool cleanup. */
+static apr_status_t
+write_records(svn_fs__access_log_t *log)
+{
+  unsigned char header[HEADER_SIZE];
+  apr_uint32_t capacity;
+  apr_uint64_t total;
+  apr_off_t offset = 0;
+  apr_status_t status, unlock_status;
+  int written = 0;
+
+  if (log->count == 0)
+    return APR_SUCCESS;
+
+  status = apr_file_lock(log->file, APR_FLOCK_EXCLUSIVE);
+  if (status)
+    return status;
+
+  status = apr_file_seek(log->file, APR_SET, &offset);
+  if (!status)
+    status = apr_file_read_full(log->file, header, HEADER_SIZE, NULL);
+  if (!status && memcmp(header, ACCESS_LOG_MAGIC, 8))
+    status = APR_EINVAL;
+
+  capacity = decode_uint32(header + 8);
+  total = decode_uint64(header + TOTAL_OFFSET);
+  if (!status && capacity == 0)
+    status = APR_EINVAL;
+
+  /* Write the records in up to two chunks, wrapping around at the end
+   * of the ring buffer. */
+  while (!status && written < log->count)
+    {
+      apr_uint64_t slot = (total + written) % capacity;
+      apr_uint64_t chunk = MIN((apr_uint64_t)(log->count - written),
+                               capacity - slot);
+
+      offset = (apr_off_t)(HEADER_SIZE + slot * RECORD_SIZE);
+      status = apr_file_seek(log->file, APR_SET, &offset);
+      if (!status)
+        status = apr_file_write_full(log->file,
+                                     log->buffer + written * RECORD_SIZE,
+                                     (apr_size_t)chunk * RECORD_SIZE, NULL);
+
+      written += (int)chunk;
+    }
+
+  if (!status)
+    {
+      encode_uint64(header + TOTAL_OFFSET, total + log->count);
+      offset = TOTAL_OFFSET;
+      status = apr_file_seek(log->file, APR_SET, &offset);
+      if (!status)
+        status = apr_file_write_full(log->file, header + TOTAL_OFFSET, 8,
+                                     NULL);
+    }
+
+  unlock_status = apr_file_unlock(log->file);
+
+  /* Never try to write the same records twice. */
+  log->count = 0;
+
+  return status ? status : unlock_status;
+}
+
+/* Pool cleanup function writing all records buffered in the
+ * svn_fs__access_log_t * DATA. */
+static apr_status_t
+flush_on_cleanup(void *data)
+{
+  /* There is nobody to report errors to. */
+  write_records(data);
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_fs__access_log_open(svn_fs__access_log_t **log,
+                        const char *path,
+                        apr_uint32_t capacity,
+                        apr_uint32_t block_size,
+                        apr_uint32_t shard_size,
+                        apr_pool_t *result_pool)
+{
+  svn_fs__access_log_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  apr_pool_t *scratch_pool = svn_pool_create(result_pool);
+  svn_filesize_t filesize;
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(capacity > 0);
+
+  result->path = svn_dirent_local_style(path, result_pool);
+  SVN_ERR(svn_io_file_open(&result->file, path,
+                           APR_READ | APR_WRITE | APR_CREATE | APR_BINARY,
+                           APR_OS_DEFAULT, result_pool));
+
+  /* Initialize the header, unless another writer beat us to it. */
+  SVN_ERR(svn_io_lock_open_file(result->file, TRUE, FALSE, scratch_pool));
+  err = svn_io_file_size_get(&filesize, result->file, scratch_pool);
+  if (!err && filesize == 0)
+    {
+      unsigned char header[HEADER_SIZE] = { 0 };
+
+      memcpy(header, ACCESS_LOG_MAGIC, 8);
+      encode_uint32(header + 8, capacity);
+      encode_uint32(header + 12, block_size);
+      encode_uint32(header + 16, shard_size);
+
+      err = svn_io_file_write_full(result->file, header, HEADER_SIZE, NULL,
+                                   scratch_pool);
+    }
+
+  err = svn_error_compose_create(err,
+                                 svn_io_unlock_open_file(result->file,
+                                                         scratch_pool));
+  svn_pool_destroy(scratch_pool);
+  SVN_ERR(err);
+
+  /* Registered after the file's own cleanup, so it will run first. */
+  apr_pool_cleanup_register(result_pool, result, flush_on_cleanup,
+                            apr_pool_cleanup_null);
+
+  *log = result;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs__access_log_add(svn_fs__access_log_t *log,
+                       const svn_fs__access_t *access)
+{
+  unsigned char *record = log->buffer + log->count * RECORD_SIZE;
+
+  encode_uint64(record, access->offset < 0 ? APR_UINT64_MAX
+                                           : (apr_uint64_t)access->offset);
+  encode_uint32(record + 8, (apr_uint32_t)access->revision);
+  encode_uint32(record + 12, access->size);
+  record[16] = (unsigned char)access->item_type;
+  record[17] = (unsigned char)((access->cache_hit ? FLAG_CACHE_HIT : 0)
+                               | (access->packed ? FLAG_PACKED : 0));
+
+  if (++log->count == BUFFER_RECORDS)
+    SVN_ERR(svn_fs__access_log_flush(log));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs__access_log_flush(svn_fs__access_log_t *log)
+{
+  apr_status_t status = write_records(log);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't write access log '%s'"),
+                              log->path);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs__access_log_read(apr_array_header_t **accesses,
+                        apr_uint32_t *block_size,
+                        apr_uint32_t *shard_size,
+                        const char *path,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *content;
+  const unsigned char *data;
+  apr_uint32_t capacity;
+  apr_uint64_t total, first, count, i;
+  apr_array_header_t *result;
+
+  SVN_ERR(svn_stringbuf_from_file2(&content, path, scratch_pool));
+  data = (const unsigned char *)content->data;
+  if (content->len < HEADER_SIZE || memcmp(data, ACCESS_LOG_MAGIC, 8))
+    return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                             _("'%s' is not an access log"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  capacity = decode_uint32(data + 8);
+  total = decode_uint64(data + TOTAL_OFFSET);
+  count = MIN(total, capacity);
+  first = total > capacity ? total % capacity : 0;
+
+  if (content->len < HEADER_SIZE + count * RECORD_SIZE)
+    return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                             _("Access log '%s' is truncated"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  result = apr_array_make(result_pool, (int)count, sizeof(svn_fs__access_t));
+  for (i = 0; i < count; ++i)
+    {
+      const unsigned char *record
+        = data + HEADER_SIZE + ((first + i) % capacity) * RECORD_SIZE;
+      svn_fs__access_t *access = apr_array_push(result);
+      apr_uint64_t offset = decode_uint64(record);
+
+      access->offset = offset == APR_UINT64_MAX ? -1 : (apr_off_t)offset;
+      access->revision = (svn_revnum_t)decode_uint32(record + 8);
+      access->size = decode_uint32(record + 12);
+      access->item_type = record[16];
+      access->cache_hit = (record[17] & FLAG_CACHE_HIT) != 0;
+      access->packed = (record[17] & FLAG_PACKED) != 0;
+    }
+
+  *block_size = decode_uint32(data + 12);
+  *shard_size = decode_uint32(data + 16);
+  *accesses = result;
+
+  return SVN_NO_ERROR;
+}
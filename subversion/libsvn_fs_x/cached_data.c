@@ -175,6 +175,51 @@ dbg__log_access(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* If access logging has been enabled for FS, record an access to the item
+ * of ITEM_TYPE (SVN_FS_X__ITEM_TYPE_*) in REVISION.  OFFSET and SIZE give
+ * its location in the rev / pack file if known, -1 and 0 otherwise.
+ * CACHE_HIT tells whether the item has been served from cache.
+ */
+static svn_error_t *
+log_access(svn_fs_t *fs,
+           svn_revnum_t revision,
+           apr_off_t offset,
+           apr_off_t size,
+           apr_uint32_t item_type,
+           svn_boolean_t cache_hit)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  svn_fs__access_t access;
+
+  if (!ffd->access_log)
+    return SVN_NO_ERROR;
+
+  access.revision = revision;
+  access.packed = svn_fs_x__is_packed_rev(fs, revision);
+  access.offset = offset;
+  access.size = (apr_uint32_t)MIN(MAX(size, 0), APR_UINT32_MAX);
+  access.item_type = item_type;
+  access.cache_hit = cache_hit;
+
+  return svn_error_trace(svn_fs__access_log_add(ffd->access_log, &access));
+}
+
+/* Call log_access for a cache hit on the ITEM_TYPE contents of REP in FS.
+ * No-op for NULL and uncommitted REPs.
+ */
+static svn_error_t *
+log_rep_hit(svn_fs_t *fs,
+            const svn_fs_x__representation_t *rep,
+            apr_uint32_t item_type)
+{
+  if (!rep || svn_fs_x__is_txn(rep->id.change_set))
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(log_access(fs,
+                                    svn_fs_x__get_revnum(rep->id.change_set),
+                                    -1, 0, item_type, TRUE));
+}
+
 /* Open the revision file for the item given by ID in filesystem FS and
    store the newly opened file in FILE.  Seek to the item's location before
    returning.
@@ -332,7 +377,9 @@ get_node_revision_body(svn_fs_x__noderev_t **noderev_p,
                                          svn_fs_x__noderevs_get_func,
                                          &sub_item, result_pool));
           if (is_cached)
-            return SVN_NO_ERROR;
+            return svn_error_trace(log_access(fs, revision, -1, 0,
+                                              SVN_FS_X__ITEM_TYPE_NODEREV,
+                                              TRUE));
         }
 
       key.revision = revision;
@@ -346,7 +393,9 @@ get_node_revision_body(svn_fs_x__noderev_t **noderev_p,
                              &key,
                              result_pool));
       if (is_cached)
-        return SVN_NO_ERROR;
+        return svn_error_trace(log_access(fs, revision, -1, 0,
+                                          SVN_FS_X__ITEM_TYPE_NODEREV,
+                                          TRUE));
 
       /* block-read will parse the whole block and will also return
          the one noderev that we need right now. */
@@ -614,6 +663,8 @@ create_rep_state_body(rep_state_t **rep_state,
   if (SVN_IS_VALID_REVNUM(revision))
     SVN_ERR(svn_cache__get((void **) &rh, &is_cached,
                            ffd->rep_header_cache, &key, result_pool));
+  if (is_cached)
+    SVN_ERR(log_rep_hit(fs, rep, SVN_FS_X__ITEM_TYPE_ANY_REP));
 
   /* initialize the (shared) FILE member in RS */
   if (reuse_shared_file)
@@ -2750,7 +2801,8 @@ svn_fs_x__rep_contents_dir(apr_array_header_t **entries_p,
         {
           /* Still valid. Done. */
           *entries_p = dir->entries;
-          return SVN_NO_ERROR;
+          return svn_error_trace(log_rep_hit(fs, noderev->data_rep,
+                                             SVN_FS_X__ITEM_TYPE_DIR_REP));
         }
     }
 
@@ -2817,7 +2869,12 @@ svn_fs_x__rep_contents_dir_entry(svn_fs_x__dirent_t **dirent,
     *hint = baton.hint;
 
   /* fetch data from disk if we did not find it in the cache */
-  if (! found || baton.out_of_date)
+  if (found && !baton.out_of_date)
+    {
+      SVN_ERR(log_rep_hit(fs, noderev->data_rep,
+                          SVN_FS_X__ITEM_TYPE_DIR_REP));
+    }
+  else
     {
       svn_fs_x__dirent_t *entry;
       svn_fs_x__dirent_t *entry_copy = NULL;
@@ -2890,7 +2947,10 @@ svn_fs_x__get_proplist(apr_hash_t **proplist,
       SVN_ERR(svn_cache__get((void **) proplist, &is_cached,
                              ffd->properties_cache, &key, result_pool));
       if (is_cached)
-        return SVN_NO_ERROR;
+        return svn_error_trace(log_rep_hit(fs, rep,
+                                 noderev->kind == svn_node_dir
+                                   ? SVN_FS_X__ITEM_TYPE_DIR_PROPS
+                                   : SVN_FS_X__ITEM_TYPE_FILE_PROPS));
 
       SVN_ERR(svn_fs_x__get_contents(&stream, fs, rep, FALSE, scratch_pool));
       SVN_ERR(svn_string_from_stream2(&content, stream, rep->expanded_size,
@@ -2993,7 +3053,10 @@ svn_fs_x__get_changes(apr_array_header_t **changes,
         }
     }
 
-  if (!found)
+  if (found)
+    SVN_ERR(log_access(context->fs, context->revision, -1, 0,
+                       SVN_FS_X__ITEM_TYPE_CHANGES, TRUE));
+  else
     {
       /* 'block-read' will also provide us with the desired data */
       SVN_ERR(block_read((void **)changes, context->fs, &id,
@@ -3167,6 +3230,49 @@ block_read_changes(apr_array_header_t **changes,
   return SVN_NO_ERROR;
 }
 
+/* Set *DICTIONARY to the compression dictionary used by the containers
+ * in the pack file containing REVISION in FS.  Pack files without such a
+ * dictionary yield an empty one.  Allocate the result in RESULT_POOL and
+ * use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_dictionary(const svn_string_t **dictionary,
+               svn_fs_t *fs,
+               svn_revnum_t revision,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  svn_revnum_t key = svn_fs_x__packed_base_rev(fs, revision);
+  svn_stringbuf_t *content;
+  svn_boolean_t is_cached;
+  svn_error_t *err;
+
+  SVN_ERR(svn_cache__get((void **)&content, &is_cached,
+                         ffd->dictionary_cache, &key, result_pool));
+  if (!is_cached)
+    {
+      const char *path = svn_fs_x__path_rev_packed(fs, revision,
+                                                   PATH_DICTIONARY,
+                                                   scratch_pool);
+      err = svn_stringbuf_from_file2(&content, path, result_pool);
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        {
+          svn_error_clear(err);
+          content = svn_stringbuf_create_empty(result_pool);
+        }
+      else
+        SVN_ERR(err);
+
+      SVN_ERR(svn_cache__set(ffd->dictionary_cache, &key, content,
+                             scratch_pool));
+    }
+
+  *dictionary = svn_stringbuf__morph_into_string(content);
+
+  return SVN_NO_ERROR;
+}
+
 /* If not already cached or if MUST_READ is set, read the changed paths
  * list container addressed by ENTRY in FS.  Return the changes list
  * identified by SUB_ITEM in *CHANGES, using CONTEXT to select a sub-range
@@ -3189,6 +3295,7 @@ block_read_changes_container(apr_array_header_t **changes,
   svn_fs_x__changes_t *container;
   svn_fs_x__pair_cache_key_t key;
   svn_stream_t *stream;
+  const svn_string_t *dictionary;
   svn_revnum_t revision = svn_fs_x__get_revnum(entry->items[0].change_set);
 
   key.revision = svn_fs_x__packed_base_rev(fs, revision);
@@ -3205,11 +3312,13 @@ block_read_changes_container(apr_array_header_t **changes,
     }
 
   SVN_ERR(read_item(&stream, fs, rev_file, entry, scratch_pool));
+  SVN_ERR(get_dictionary(&dictionary, fs, revision, scratch_pool,
+                         scratch_pool));
 
   /* read changes from revision file */
 
-  SVN_ERR(svn_fs_x__read_changes_container(&container, stream, scratch_pool,
-                                           scratch_pool));
+  SVN_ERR(svn_fs_x__read_changes_container(&container, stream, dictionary,
+                                           scratch_pool, scratch_pool));
 
   /* extract requested data */
 
@@ -3285,6 +3394,7 @@ block_read_noderevs_container(svn_fs_x__noderev_t **noderev_p,
   svn_fs_x__data_t *ffd = fs->fsap_data;
   svn_fs_x__noderevs_t *container;
   svn_stream_t *stream;
+  const svn_string_t *dictionary;
   svn_fs_x__pair_cache_key_t key;
   svn_revnum_t revision = svn_fs_x__get_revnum(entry->items[0].change_set);
 
@@ -3302,10 +3412,12 @@ block_read_noderevs_container(svn_fs_x__noderev_t **noderev_p,
     }
 
   SVN_ERR(read_item(&stream, fs, rev_file, entry, scratch_pool));
+  SVN_ERR(get_dictionary(&dictionary, fs, revision, scratch_pool,
+                         scratch_pool));
 
   /* read noderevs from revision file */
-  SVN_ERR(svn_fs_x__read_noderevs_container(&container, stream, scratch_pool,
-                                            scratch_pool));
+  SVN_ERR(svn_fs_x__read_noderevs_container(&container, stream, dictionary,
+                                            scratch_pool, scratch_pool));
 
   /* extract requested data */
   if (must_read)
@@ -3337,6 +3449,7 @@ block_read_reps_container(svn_fs_x__rep_extractor_t **extractor,
   svn_fs_x__data_t *ffd = fs->fsap_data;
   svn_fs_x__reps_t *container;
   svn_stream_t *stream;
+  const svn_string_t *dictionary;
   svn_fs_x__pair_cache_key_t key;
   svn_revnum_t revision = svn_fs_x__get_revnum(entry->items[0].change_set);
 
@@ -3354,10 +3467,12 @@ block_read_reps_container(svn_fs_x__rep_extractor_t **extractor,
     }
 
   SVN_ERR(read_item(&stream, fs, rev_file, entry, scratch_pool));
+  SVN_ERR(get_dictionary(&dictionary, fs, revision, scratch_pool,
+                         scratch_pool));
 
   /* read noderevs from revision file */
-  SVN_ERR(svn_fs_x__read_reps_container(&container, stream, result_pool,
-                                        scratch_pool));
+  SVN_ERR(svn_fs_x__read_reps_container(&container, stream, dictionary,
+                                        result_pool, scratch_pool));
 
   /* extract requested data */
 
@@ -3455,6 +3570,8 @@ block_read(void **result,
 
               SVN_ERR(svn_fs_x__rev_file_seek(revision_file, NULL,
                                               entry->offset));
+              SVN_ERR(log_access(fs, key.revision, entry->offset,
+                                 entry->size, entry->type, FALSE));
               switch (entry->type)
                 {
                   case SVN_FS_X__ITEM_TYPE_FILE_REP:
@@ -527,6 +527,22 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        no_handler, !cache_nodeprops,
                        fs->pool, scratch_pool));
 
+  /* if enabled, cache parsed mergeinfo along with the node properties */
+  SVN_ERR(create_cache(&(ffd->mergeinfo_cache),
+                       NULL,
+                       membuffer,
+                       0, 0, /* Do not use inprocess cache */
+                       svn_fs_x__serialize_mergeinfo,
+                       svn_fs_x__deserialize_mergeinfo,
+                       sizeof(svn_fs_x__id_t),
+                       apr_pstrcat(scratch_pool, prefix, "MERGEINFO",
+                                   SVN_VA_NULL),
+                       SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                       has_namespace,
+                       fs,
+                       no_handler, !cache_nodeprops,
+                       fs->pool, scratch_pool));
+
   /* if enabled, cache revprops */
   SVN_ERR(create_cache(&(ffd->revprop_cache),
                        NULL,
@@ -617,6 +633,20 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
                        fs,
                        no_handler, FALSE,
                        fs->pool, scratch_pool));
+  SVN_ERR(create_cache(&(ffd->dictionary_cache),
+                       NULL,
+                       membuffer,
+                       0, 0, /* Do not use inprocess cache */
+                       /* Values are svn_stringbuf_t */
+                       NULL, NULL,
+                       sizeof(svn_revnum_t),
+                       apr_pstrcat(scratch_pool, prefix, "DICT",
+                                   SVN_VA_NULL),
+                       SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       has_namespace,
+                       fs,
+                       no_handler, FALSE,
+                       fs->pool, scratch_pool));
 
   /* Cache index info. */
   SVN_ERR(create_cache(&(ffd->l2p_header_cache),
@@ -290,6 +290,7 @@ svn_fs_x__changes_get_list(apr_array_header_t **list,
 svn_error_t *
 svn_fs_x__write_changes_container(svn_stream_t *stream,
                                   const svn_fs_x__changes_t *changes,
+                                  const svn_string_t *dictionary,
                                   apr_pool_t *scratch_pool)
 {
   int i;
@@ -333,7 +334,8 @@ svn_fs_x__write_changes_container(svn_stream_t *stream,
     }
 
   /* write to disk */
-  SVN_ERR(svn_fs_x__write_string_table(stream, paths, scratch_pool));
+  SVN_ERR(svn_fs_x__write_string_table(stream, paths, dictionary,
+                                       scratch_pool));
   SVN_ERR(svn_packed__data_write(stream, root, scratch_pool));
 
   return SVN_NO_ERROR;
@@ -342,6 +344,7 @@ svn_fs_x__write_changes_container(svn_stream_t *stream,
 svn_error_t *
 svn_fs_x__read_changes_container(svn_fs_x__changes_t **changes_p,
                                  svn_stream_t *stream,
+                                 const svn_string_t *dictionary,
                                  apr_pool_t *result_pool,
                                  apr_pool_t *scratch_pool)
 {
@@ -355,7 +358,7 @@ svn_fs_x__read_changes_container(svn_fs_x__changes_t **changes_p,
   svn_packed__int_stream_t *changes_stream;
 
   /* read from disk */
-  SVN_ERR(svn_fs_x__read_string_table(&changes->paths, stream,
+  SVN_ERR(svn_fs_x__read_string_table(&changes->paths, stream, dictionary,
                                       result_pool, scratch_pool));
 
   SVN_ERR(svn_packed__data_read(&root, stream, result_pool, scratch_pool));
@@ -84,21 +84,25 @@ svn_fs_x__changes_get_list(apr_array_header_t **list,
 
 /* I/O interface. */
 
-/* Write a serialized representation of CHANGES to STREAM.
+/* Write a serialized representation of CHANGES to STREAM.  Compress the
+ * paths using the optional preset DICTIONARY.
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__write_changes_container(svn_stream_t *stream,
                                   const svn_fs_x__changes_t *changes,
+                                  const svn_string_t *dictionary,
                                   apr_pool_t *scratch_pool);
 
-/* Read a changes container from its serialized representation in STREAM.
+/* Read a changes container from its serialized representation in STREAM,
+ * using the same DICTIONARY as when it was written.
  * Allocate the result in RESULT_POOL and return it in *CHANGES_P.  Use
  * SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__read_changes_container(svn_fs_x__changes_t **changes_p,
                                  svn_stream_t *stream,
+                                 const svn_string_t *dictionary,
                                  apr_pool_t *result_pool,
                                  apr_pool_t *scratch_pool);
 
@@ -34,6 +34,7 @@
 #include "private/svn_atomic.h"
 #include "private/svn_cache.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_fs_util.h"
 #include "private/svn_sqlite.h"
 #include "private/svn_mutex.h"
 
@@ -68,6 +69,8 @@ extern "C" {
                                                  /* Current revprop generation*/
 #define PATH_MANIFEST         "manifest"         /* Manifest file name */
 #define PATH_PACKED           "pack"             /* Packed revision data file */
+#define PATH_DICTIONARY       "dict"             /* Compression dictionary
+                                                    of a packed shard */
 #define PATH_EXT_PACKED_SHARD ".pack"            /* Extension for packed
                                                     shards */
 #define PATH_EXT_L2P_INDEX    ".l2p"             /* extension of the log-
@@ -113,6 +116,8 @@ extern "C" {
 #define CONFIG_OPTION_P2L_PAGE_SIZE      "p2l-page-size"
 #define CONFIG_SECTION_DEBUG             "debug"
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
+#define CONFIG_OPTION_ACCESS_LOG         "access-log"
+#define CONFIG_OPTION_ACCESS_LOG_SIZE    "access-log-size"
 
 /* The format number of this filesystem.
    This is independent of the repository format number, and
@@ -121,11 +126,11 @@ extern "C" {
    Note: If you bump this, please update the switch statement in
          svn_fs_x__create() as well.
  */
-#define SVN_FS_X__FORMAT_NUMBER   2
+#define SVN_FS_X__FORMAT_NUMBER   3
 
 /* Latest experimental format number.  Experimental formats are only
    compatible with themselves. */
-#define SVN_FS_X__EXPERIMENTAL_FORMAT_NUMBER   2
+#define SVN_FS_X__EXPERIMENTAL_FORMAT_NUMBER   3
 
 /* On most operating systems apr implements file locks per process, not
    per file.  On Windows apr implements the locking as per file handle
@@ -308,6 +313,10 @@ typedef struct svn_fs_x__data_t
   /* Node properties cache.  Maps from rep key to apr_hash_t. */
   svn_cache__t *properties_cache;
 
+  /* Parsed svn:mergeinfo of immutable nodes.  Maps from node-revision ID
+     to svn_mergeinfo_t. */
+  svn_cache__t *mergeinfo_cache;
+
   /* Cache for txdelta_window_t objects;
    * the key is svn_fs_x__window_cache_key_t */
   svn_cache__t *txdelta_window_cache;
@@ -336,6 +345,10 @@ typedef struct svn_fs_x__data_t
      the key is a (pack file revision, file offset) pair */
   svn_cache__t *reps_container_cache;
 
+  /* Cache for the compression dictionaries of packed shards as
+     svn_stringbuf_t; the key is the first revision in the pack file */
+  svn_cache__t *dictionary_cache;
+
   /* Cache for svn_fs_x__rep_header_t objects; the key is a
      (revision, item index) pair */
   svn_cache__t *rep_header_cache;
@@ -397,6 +410,9 @@ typedef struct svn_fs_x__data_t
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
+  /* Record item accesses in this log.  NULL if disabled. */
+  svn_fs__access_log_t *access_log;
+
   /* Per-instance filesystem ID, which provides an additional level of
      uniqueness for filesystems that share the same UUID, but should
      still be distinguishable (e.g. backups produced by svn_fs_hotcopy()
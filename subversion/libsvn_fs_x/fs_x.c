@@ -338,6 +338,29 @@ read_config(svn_fs_x__data_t *ffd,
                               CONFIG_OPTION_PACK_AFTER_COMMIT,
                               FALSE));
 
+  /* Access logging is only enabled if a log file has been given. */
+  {
+    const char *access_log;
+    apr_int64_t access_log_size;
+
+    svn_config_get(config, &access_log, CONFIG_SECTION_DEBUG,
+                   CONFIG_OPTION_ACCESS_LOG, NULL);
+    SVN_ERR(svn_config_get_int64(config, &access_log_size,
+                                 CONFIG_SECTION_DEBUG,
+                                 CONFIG_OPTION_ACCESS_LOG_SIZE, 0x100000));
+    access_log_size = MIN(MAX(access_log_size, 1), APR_UINT32_MAX);
+
+    ffd->access_log = NULL;
+    if (access_log && *access_log)
+      SVN_ERR(svn_fs__access_log_open(&ffd->access_log,
+                                      svn_dirent_join(fs_path, access_log,
+                                                      scratch_pool),
+                                      (apr_uint32_t)access_log_size,
+                                      (apr_uint32_t)ffd->block_size,
+                                      (apr_uint32_t)ffd->max_files_per_dir,
+                                      result_pool));
+  }
+
   /* memcached configuration */
   SVN_ERR(svn_cache__make_memcache_from_config(&ffd->memcache, config,
                                                result_pool, scratch_pool));
@@ -528,6 +551,17 @@ write_config(svn_fs_t *fs,
 "### Must be a power of 2."                                                  NL
 "### p2l-page-size is given in kBytes and with a default of 1024 kBytes."    NL
 "# " CONFIG_OPTION_P2L_PAGE_SIZE " = 1024"                                   NL
+""                                                                           NL
+"[" CONFIG_SECTION_DEBUG "]"                                                 NL
+"###"                                                                        NL
+"### Record every access to an item in a revision or pack file in a binary"  NL
+"### log file, together with its position and whether it has been served"    NL
+"### from cache.  The log is a ring buffer that keeps the latest"            NL
+"### " CONFIG_OPTION_ACCESS_LOG_SIZE " records.  Relative paths are taken"   NL
+"### relative to the db directory.  All processes opening the repository"    NL
+"### write to the same log.  Access logging is disabled by default."         NL
+"# " CONFIG_OPTION_ACCESS_LOG " = access.log"                                NL
+"# " CONFIG_OPTION_ACCESS_LOG_SIZE " = 1048576"                              NL
 ;
 #undef NL
   return svn_io_file_create(svn_dirent_join(fs->path, PATH_CONFIG,
@@ -1270,10 +1304,11 @@ svn_fs_x__info_format(int *fs_format,
     case 1:
       break;
     case 2:
+    case 3:
       (*supports_version)->minor = 10;
       break;
 #ifdef SVN_DEBUG
-# if SVN_FS_X__FORMAT_NUMBER != 2
+# if SVN_FS_X__FORMAT_NUMBER != 3
 #  error "Need to add a 'case' statement here"
 # endif
 #endif
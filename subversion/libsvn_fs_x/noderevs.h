@@ -80,21 +80,25 @@ svn_fs_x__noderevs_get(svn_fs_x__noderev_t **noderev_p,
 
 /* I/O interface. */
 
-/* Write a serialized representation of CONTAINER to STREAM.
+/* Write a serialized representation of CONTAINER to STREAM.  Compress the
+ * paths using the optional preset DICTIONARY.
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__write_noderevs_container(svn_stream_t *stream,
                                    const svn_fs_x__noderevs_t *container,
+                                   const svn_string_t *dictionary,
                                    apr_pool_t *scratch_pool);
 
-/* Read a noderev container from its serialized representation in STREAM.
+/* Read a noderev container from its serialized representation in STREAM,
+ * using the same DICTIONARY as when it was written.
  * Allocate the result in RESULT_POOL and return it in *CONTAINER.  Use
  * SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__read_noderevs_container(svn_fs_x__noderevs_t **container,
                                    svn_stream_t *stream,
+                                   const svn_string_t *dictionary,
                                    apr_pool_t *result_pool,
                                    apr_pool_t *scratch_pool);
 
@@ -228,6 +228,16 @@ typedef struct pack_context_t
   /* pool used for temporary data structures that will be cleaned up when
    * the next range of revisions is being processed */
   apr_pool_t *info_pool;
+
+  /* compression dictionary shared by all containers in the pack file.
+   * NULL until it has been created from the first revision range. */
+  svn_string_t *dictionary;
+
+  /* pool that DICTIONARY gets allocated in */
+  apr_pool_t *dictionary_pool;
+
+  /* fsync batch that the pack file and related files get scheduled in */
+  svn_fs__batch_fsync_t *batch;
 } pack_context_t;
 
 /* Create and initialize a new pack context for packing shard SHARD_REV in
@@ -244,7 +254,7 @@ initialize_pack_context(pack_context_t *context,
                         const char *shard_dir,
                         svn_revnum_t shard_rev,
                         int max_items,
-                        svn_fs_x__batch_fsync_t *batch,
+                        svn_fs__batch_fsync_t *batch,
                         svn_cancel_func_t cancel_func,
                         void *cancel_baton,
                         apr_pool_t *pool)
@@ -274,8 +284,8 @@ initialize_pack_context(pack_context_t *context,
   context->pack_file_path
     = svn_dirent_join(pack_file_dir, PATH_PACKED, pool);
 
-  SVN_ERR(svn_fs_x__batch_fsync_open_file(&context->pack_file, batch,
-                                          context->pack_file_path, pool));
+  SVN_ERR(svn_fs__batch_fsync_open_file(&context->pack_file, batch,
+                                        context->pack_file_path, pool));
 
   /* Proto index files */
   SVN_ERR(svn_fs_x__l2p_proto_index_open(
@@ -320,6 +330,10 @@ initialize_pack_context(pack_context_t *context,
   context->info_pool = svn_pool_create(pool);
   context->paths = svn_prefix_tree__create(context->info_pool);
 
+  /* the dictionary will be created once we know the first paths */
+  context->dictionary_pool = pool;
+  context->batch = batch;
+
   return SVN_NO_ERROR;
 }
 
@@ -672,6 +686,22 @@ tweak_path_for_ordering(const char *original,
    return path;
 }
 
+/* Revert the changes that tweak_path_for_ordering() made to PATH.
+ */
+static void
+untweak_path(svn_string_t *path)
+{
+  char *data = (char *)path->data;
+  apr_size_t i;
+
+  /* Only the first char of "trunk" resp. "branch" has been replaced. */
+  for (i = 0; i < path->len; ++i)
+    if (data[i] == '\1')
+      data[i] = 't';
+    else if (data[i] == '\2')
+      data[i] = 'b';
+}
+
 /* Copy node revision item identified by ENTRY from the current position
  * in REV_FILE into CONTEXT->REPS_FILE.  Add all tracking into needed by
  * our placement algorithm to CONTEXT.
@@ -819,6 +849,144 @@ sort_reps(pack_context_t *context)
                   (int (*)(const void *, const void *))compare_references);
 }
 
+/* Upper limit for the size of a pack file's compression dictionary.
+ * zlib will only use the last 32kB of any preset dictionary. */
+#define MAX_DICTIONARY_SIZE 0x8000
+
+/* A path or parent path that may be added to the compression dictionary.
+ */
+typedef struct dictionary_candidate_t
+{
+  /* the path, not NUL-terminated */
+  const char *data;
+
+  /* length of DATA in bytes */
+  apr_size_t len;
+
+  /* number of path_order_t entries that contain this path */
+  apr_size_t count;
+} dictionary_candidate_t;
+
+/* implements compare_fn_t.  Sort descending by the number of bytes that
+ * the candidate may save, i.e. by COUNT * LEN.
+ */
+static int
+compare_dictionary_candidates(const dictionary_candidate_t * const * lhs_p,
+                              const dictionary_candidate_t * const * rhs_p)
+{
+  apr_uint64_t lhs_saving = (apr_uint64_t)(*lhs_p)->count * (*lhs_p)->len;
+  apr_uint64_t rhs_saving = (apr_uint64_t)(*rhs_p)->count * (*rhs_p)->len;
+
+  if (lhs_saving == rhs_saving)
+    return 0;
+
+  return lhs_saving < rhs_saving ? 1 : -1;
+}
+
+/* Create the compression dictionary for the pack file in CONTEXT from the
+ * paths collected in CONTEXT->PATH_ORDER and write it to the pack file
+ * directory.  The dictionary consists of the most frequent paths and path
+ * prefixes, which are what the string tables of all our containers hold.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_dictionary(pack_context_t *context,
+                 apr_pool_t *scratch_pool)
+{
+  apr_hash_t *candidates = apr_hash_make(scratch_pool);
+  apr_array_header_t *sorted;
+  apr_array_header_t *selected;
+  apr_hash_index_t *hi;
+  svn_stringbuf_t *dictionary;
+  apr_size_t size = 0;
+  int i;
+
+  /* Count the number of occurrences of every path and parent path. */
+  for (i = 0; i < context->path_order->nelts; ++i)
+    {
+      path_order_t *entry
+        = APR_ARRAY_IDX(context->path_order, i, path_order_t *);
+      svn_string_t *path = svn_prefix_string__expand(entry->path,
+                                                     scratch_pool);
+      apr_size_t len;
+
+      untweak_path(path);
+      for (len = 1; len <= path->len; ++len)
+        if (len == path->len || path->data[len] == '/')
+          {
+            dictionary_candidate_t *candidate
+              = apr_hash_get(candidates, path->data, len);
+            if (!candidate)
+              {
+                candidate = apr_pcalloc(scratch_pool, sizeof(*candidate));
+                candidate->data = path->data;
+                candidate->len = len;
+                apr_hash_set(candidates, candidate->data, len, candidate);
+              }
+
+            ++candidate->count;
+          }
+    }
+
+  /* Strings that occur only once will not benefit from the dictionary. */
+  sorted = apr_array_make(scratch_pool, apr_hash_count(candidates),
+                          sizeof(dictionary_candidate_t *));
+  for (hi = apr_hash_first(scratch_pool, candidates);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      dictionary_candidate_t *candidate = apr_hash_this_val(hi);
+      if (candidate->count > 1)
+        APR_ARRAY_PUSH(sorted, dictionary_candidate_t *) = candidate;
+    }
+
+  svn_sort__array(sorted,
+                  (int (*)(const void *, const void *))
+                    compare_dictionary_candidates);
+
+  /* Select the most valuable candidates that fit into the dictionary. */
+  selected = apr_array_make(scratch_pool, sorted->nelts,
+                            sizeof(dictionary_candidate_t *));
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      dictionary_candidate_t *candidate
+        = APR_ARRAY_IDX(sorted, i, dictionary_candidate_t *);
+      if (size + candidate->len <= MAX_DICTIONARY_SIZE)
+        {
+          APR_ARRAY_PUSH(selected, dictionary_candidate_t *) = candidate;
+          size += candidate->len;
+        }
+    }
+
+  /* Matches close to the end of the dictionary are cheapest to encode,
+   * so put the most valuable strings last. */
+  dictionary = svn_stringbuf_create_ensure(size, context->dictionary_pool);
+  for (i = selected->nelts - 1; i >= 0; --i)
+    {
+      dictionary_candidate_t *candidate
+        = APR_ARRAY_IDX(selected, i, dictionary_candidate_t *);
+      svn_stringbuf_appendbytes(dictionary, candidate->data, candidate->len);
+    }
+
+  context->dictionary = svn_stringbuf__morph_into_string(dictionary);
+
+  /* Pack files without a dictionary file use an empty one. */
+  if (context->dictionary->len)
+    {
+      apr_file_t *file;
+      const char *path = svn_dirent_join(context->pack_file_dir,
+                                         PATH_DICTIONARY, scratch_pool);
+
+      SVN_ERR(svn_fs__batch_fsync_open_file(&file, context->batch, path,
+                                            scratch_pool));
+      SVN_ERR(svn_io_file_write_full(file, context->dictionary->data,
+                                     context->dictionary->len, NULL,
+                                     scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Return the remaining unused bytes in the current block in CONTEXT's
  * pack file.
  */
@@ -1032,6 +1200,7 @@ write_nodes_container(pack_context_t *context,
                                                           TRUE, scratch_pool),
                                  scratch_pool);
   SVN_ERR(svn_fs_x__write_noderevs_container(pack_stream, *container,
+                                             context->dictionary,
                                              scratch_pool));
   SVN_ERR(svn_stream_close(pack_stream));
   SVN_ERR(svn_io_file_seek(context->pack_file, APR_CUR, &offset,
@@ -1120,6 +1289,7 @@ store_nodes(pack_context_t *context,
             = svn_stream_from_stringbuf(serialized, iterpool);
 
           SVN_ERR(svn_fs_x__write_noderevs_container(temp_stream, *container,
+                                                     context->dictionary,
                                                      iterpool));
           SVN_ERR(svn_stream_close(temp_stream));
 
@@ -1186,6 +1356,7 @@ write_reps_container(pack_context_t *context,
                                  scratch_pool);
 
   SVN_ERR(svn_fs_x__write_reps_container(pack_stream, container,
+                                         context->dictionary,
                                          scratch_pool));
   SVN_ERR(svn_stream_close(pack_stream));
   SVN_ERR(svn_io_file_seek(context->pack_file, APR_CUR, &offset,
@@ -1503,6 +1674,7 @@ write_changes_container(pack_context_t *context,
 
   SVN_ERR(svn_fs_x__write_changes_container(pack_stream,
                                              container,
+                                             context->dictionary,
                                              scratch_pool));
   SVN_ERR(svn_stream_close(pack_stream));
   SVN_ERR(svn_io_file_seek(context->pack_file, APR_CUR, &offset,
@@ -1574,7 +1746,9 @@ write_changes_containers(pack_context_t *context,
             = svn_stream_from_stringbuf(serialized, iterpool);
 
           SVN_ERR(svn_fs_x__write_changes_container(memory_stream,
-                                                     container, iterpool));
+                                                     container,
+                                                     context->dictionary,
+                                                     iterpool));
           SVN_ERR(svn_stream_close(temp_stream));
 
           block_left = get_block_left(context) - serialized->len;
@@ -1806,6 +1980,13 @@ pack_range(pack_context_t *context,
   /* follow dependencies recursively for noderevs and data representations */
   sort_reps(context);
 
+  /* all containers in the pack file share the same dictionary */
+  if (!context->dictionary)
+    {
+      SVN_ERR(write_dictionary(context, revpool));
+      svn_pool_clear(revpool);
+    }
+
   /* phase 4: copy bucket data to pack file.  Write P2L index. */
   SVN_ERR(write_changes_containers(context, context->changes,
                                    context->changes_file, revpool));
@@ -1919,7 +2100,7 @@ pack_log_addressed(svn_fs_t *fs,
                    const char *shard_dir,
                    svn_revnum_t shard_rev,
                    apr_size_t max_mem,
-                   svn_fs_x__batch_fsync_t *batch,
+                   svn_fs__batch_fsync_t *batch,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
                    apr_pool_t *scratch_pool)
@@ -2019,7 +2200,7 @@ pack_rev_shard(svn_fs_t *fs,
                apr_int64_t shard,
                int max_files_per_dir,
                apr_size_t max_mem,
-               svn_fs_x__batch_fsync_t *batch,
+               svn_fs__batch_fsync_t *batch,
                svn_cancel_func_t cancel_func,
                void *cancel_baton,
                apr_pool_t *scratch_pool)
@@ -2036,7 +2217,7 @@ pack_rev_shard(svn_fs_t *fs,
 
   /* Create the new directory and pack file. */
   SVN_ERR(svn_io_dir_make(pack_file_dir, APR_OS_DEFAULT, scratch_pool));
-  SVN_ERR(svn_fs_x__batch_fsync_new_path(batch, pack_file_dir, scratch_pool));
+  SVN_ERR(svn_fs__batch_fsync_new_path(batch, pack_file_dir, scratch_pool));
 
   /* Index information files */
   SVN_ERR(pack_log_addressed(fs, pack_file_dir, shard_path, shard_rev,
@@ -2045,6 +2226,10 @@ pack_rev_shard(svn_fs_t *fs,
 
   SVN_ERR(svn_io_copy_perms(shard_path, pack_file_dir, scratch_pool));
   SVN_ERR(svn_io_set_file_read_only(pack_file_path, FALSE, scratch_pool));
+  SVN_ERR(svn_io_set_file_read_only(svn_dirent_join(pack_file_dir,
+                                                    PATH_DICTIONARY,
+                                                    scratch_pool),
+                                    TRUE, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -2076,7 +2261,7 @@ pack_shard(const char *dir,
 {
   svn_fs_x__data_t *ffd = fs->fsap_data;
   const char *shard_path, *pack_file_dir;
-  svn_fs_x__batch_fsync_t *batch;
+  svn_fs__batch_fsync_t *batch;
 
   /* Notify caller we're starting to pack this shard. */
   if (notify_func)
@@ -2084,8 +2269,8 @@ pack_shard(const char *dir,
                         scratch_pool));
 
   /* Perform all fsyncs through this instance. */
-  SVN_ERR(svn_fs_x__batch_fsync_create(&batch, ffd->flush_to_disk,
-                                       scratch_pool));
+  SVN_ERR(svn_fs__batch_fsync_create(&batch, ffd->flush_to_disk,
+                                     scratch_pool));
 
   /* Some useful paths. */
   pack_file_dir = svn_dirent_join(dir,
@@ -2119,7 +2304,7 @@ pack_shard(const char *dir,
   ffd->min_unpacked_rev = (svn_revnum_t)((shard + 1) * max_files_per_dir);
 
   /* Ensure that packed file is written to disk.*/
-  SVN_ERR(svn_fs_x__batch_fsync_run(batch, scratch_pool));
+  SVN_ERR(svn_fs__batch_fsync_run(batch, scratch_pool));
 
   /* Finally, remove the existing shard directories. */
   SVN_ERR(svn_io_remove_dir2(shard_path, TRUE,
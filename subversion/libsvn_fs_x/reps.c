@@ -694,6 +694,7 @@ svn_fs_x__extractor_drive(svn_stringbuf_t **contents,
 svn_error_t *
 svn_fs_x__write_reps_container(svn_stream_t *stream,
                                const svn_fs_x__reps_builder_t *builder,
+                               const svn_string_t *dictionary,
                                apr_pool_t *scratch_pool)
 {
   int i;
@@ -760,7 +761,7 @@ svn_fs_x__write_reps_container(svn_stream_t *stream,
   svn_packed__add_uint(misc_stream, 0);
 
   /* write to stream */
-  SVN_ERR(svn_packed__data_write(stream, root, scratch_pool));
+  SVN_ERR(svn_packed__data_write2(stream, root, dictionary, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -768,6 +769,7 @@ svn_fs_x__write_reps_container(svn_stream_t *stream,
 svn_error_t *
 svn_fs_x__read_reps_container(svn_fs_x__reps_t **container,
                               svn_stream_t *stream,
+                              const svn_string_t *dictionary,
                               apr_pool_t *result_pool,
                               apr_pool_t *scratch_pool)
 {
@@ -787,7 +789,8 @@ svn_fs_x__read_reps_container(svn_fs_x__reps_t **container,
   svn_packed__byte_stream_t *text_stream;
 
   /* read from disk */
-  SVN_ERR(svn_packed__data_read(&root, stream, result_pool, scratch_pool));
+  SVN_ERR(svn_packed__data_read2(&root, stream, dictionary, result_pool,
+                                 scratch_pool));
 
   bases_stream = svn_packed__first_int_stream(root);
   reps_stream = svn_packed__next_int_stream(bases_stream);
@@ -141,20 +141,24 @@ svn_fs_x__extractor_drive(svn_stringbuf_t** contents,
 /* I/O interface. */
 
 /* Write a serialized representation of the final container described by
- * BUILDER to STREAM.  Use SCRATCH_POOL for temporary allocations.
+ * BUILDER to STREAM.  Compress the text using the optional preset
+ * DICTIONARY.  Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__write_reps_container(svn_stream_t *stream,
                                const svn_fs_x__reps_builder_t *builder,
+                               const svn_string_t *dictionary,
                                apr_pool_t *scratch_pool);
 
 /* Read a representations container from its serialized representation in
- * STREAM.  Allocate the result in RESULT_POOL and return it in *CONTAINER.
+ * STREAM, using the same DICTIONARY as when it was written.  Allocate the
+ * result in RESULT_POOL and return it in *CONTAINER.
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__read_reps_container(svn_fs_x__reps_t **container,
                               svn_stream_t *stream,
+                              const svn_string_t *dictionary,
                               apr_pool_t *result_pool,
                               apr_pool_t *scratch_pool);
 
@@ -63,6 +63,7 @@ typedef struct builder_table_t
   builder_string_t *first;
   builder_string_t *last;
   apr_array_header_t *short_strings;
+  apr_hash_t *short_string_dict;
   apr_array_header_t *long_strings;
   apr_hash_t *long_string_dict;
   apr_size_t long_string_size;
@@ -111,6 +112,7 @@ add_table(string_table_builder_t *builder)
                                                      unused bytes at the end */
   table->short_strings = apr_array_make(builder->pool, 64,
                                         sizeof(builder_string_t *));
+  table->short_string_dict = svn_hash__make(builder->pool);
   table->long_strings = apr_array_make(builder->pool, 0,
                                        sizeof(svn_string_t));
   table->long_string_dict = svn_hash__make(builder->pool);
@@ -281,13 +283,10 @@ svn_fs_x__string_table_builder_add(string_table_builder_t *builder,
   if (len == 0)
     len = strlen(string);
 
-  string = apr_pstrmemdup(builder->pool, string, len);
   if (len > MAX_SHORT_STRING_LEN)
     {
       void *idx_void;
       svn_string_t item;
-      item.data = string;
-      item.len = len;
 
       idx_void = apr_hash_get(table->long_string_dict, string, len);
       result = (apr_uintptr_t)idx_void;
@@ -296,6 +295,10 @@ svn_fs_x__string_table_builder_add(string_table_builder_t *builder,
              + LONG_STRING_MASK
              + (((apr_size_t)builder->tables->nelts - 1) << TABLE_SHIFT);
 
+      string = apr_pstrmemdup(builder->pool, string, len);
+      item.data = string;
+      item.len = len;
+
       if (table->long_strings->nelts == MAX_STRINGS_PER_TABLE)
         table = add_table(builder);
 
@@ -310,7 +313,16 @@ svn_fs_x__string_table_builder_add(string_table_builder_t *builder,
     }
   else
     {
-      builder_string_t *item = apr_pcalloc(builder->pool, sizeof(*item));
+      /* Most strings get added many times.  Finding them in the hash is
+       * much cheaper than a tree lookup and saves us the copy. */
+      builder_string_t *item = apr_hash_get(table->short_string_dict,
+                                            string, len);
+      if (item)
+        return item->position
+             + (((apr_size_t)builder->tables->nelts - 1) << TABLE_SHIFT);
+
+      string = apr_pstrmemdup(builder->pool, string, len);
+      item = apr_pcalloc(builder->pool, sizeof(*item));
       item->string.data = string;
       item->string.len = len;
       item->previous_match_len = 0;
@@ -322,6 +334,7 @@ svn_fs_x__string_table_builder_add(string_table_builder_t *builder,
 
       item->position = table->short_strings->nelts;
       APR_ARRAY_PUSH(table->short_strings, builder_string_t *) = item;
+      apr_hash_set(table->short_string_dict, string, len, item);
 
       if (table->top == NULL)
         {
@@ -587,6 +600,7 @@ svn_fs_x__string_table_get(const string_table_t *table,
 svn_error_t *
 svn_fs_x__write_string_table(svn_stream_t *stream,
                              const string_table_t *table,
+                             const svn_string_t *dictionary,
                              apr_pool_t *scratch_pool)
 {
   apr_size_t i, k;
@@ -648,7 +662,7 @@ svn_fs_x__write_string_table(svn_stream_t *stream,
 
   /* write to target stream */
 
-  SVN_ERR(svn_packed__data_write(stream, root, scratch_pool));
+  SVN_ERR(svn_packed__data_write2(stream, root, dictionary, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -656,6 +670,7 @@ svn_fs_x__write_string_table(svn_stream_t *stream,
 svn_error_t *
 svn_fs_x__read_string_table(string_table_t **table_p,
                             svn_stream_t *stream,
+                            const svn_string_t *dictionary,
                             apr_pool_t *result_pool,
                             apr_pool_t *scratch_pool)
 {
@@ -669,7 +684,8 @@ svn_fs_x__read_string_table(string_table_t **table_p,
   svn_packed__byte_stream_t *small_strings_data;
   svn_packed__int_stream_t *headers;
 
-  SVN_ERR(svn_packed__data_read(&root, stream, result_pool, scratch_pool));
+  SVN_ERR(svn_packed__data_read2(&root, stream, dictionary, result_pool,
+                                 scratch_pool));
   table_sizes = svn_packed__first_int_stream(root);
   headers = svn_packed__next_int_stream(table_sizes);
   large_strings = svn_packed__first_byte_stream(root);
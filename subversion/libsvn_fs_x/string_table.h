@@ -86,20 +86,24 @@ svn_fs_x__string_table_get(const string_table_t *table,
                            apr_pool_t *result_pool);
 
 /* Write a serialized representation of the string table TABLE to STREAM.
+ * Compress the string data using the optional preset DICTIONARY.
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__write_string_table(svn_stream_t *stream,
                              const string_table_t *table,
+                             const svn_string_t *dictionary,
                              apr_pool_t *scratch_pool);
 
 /* Read the serialized string table representation from STREAM and return
- * the resulting runtime representation in *TABLE_P.  Allocate it in
- * RESULT_POOL and use SCRATCH_POOL for temporary allocations.
+ * the resulting runtime representation in *TABLE_P.  DICTIONARY must be
+ * the same that was given to svn_fs_x__write_string_table().  Allocate
+ * the result in RESULT_POOL and use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_x__read_string_table(string_table_t **table_p,
                             svn_stream_t *stream,
+                            const svn_string_t *dictionary,
                             apr_pool_t *result_pool,
                             apr_pool_t *scratch_pool);
 
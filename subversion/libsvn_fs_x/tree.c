@@ -2902,6 +2902,70 @@ assemble_history(svn_fs_t *fs,
 /* mergeinfo queries */
 
 
+/* Set *MERGEINFO to the parsed svn:mergeinfo of the node DAG, which claims
+   to have mergeinfo.  Set it to NULL if the mergeinfo is syntactically
+   invalid.  The parsed mergeinfo of immutable nodes is cached per
+   node-revision, so repeated queries and tree crawls don't have to fetch
+   and parse the same property again.  Allocate *MERGEINFO in RESULT_POOL.
+   Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_dag_mergeinfo(svn_mergeinfo_t *mergeinfo,
+                  dag_node_t *dag,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = svn_fs_x__dag_get_fs(dag)->fsap_data;
+  const svn_fs_x__id_t *id = svn_fs_x__dag_get_id(dag);
+  svn_boolean_t cacheable = ! svn_fs_x__dag_check_mutable(dag);
+  apr_hash_t *proplist;
+  svn_string_t *mergeinfo_string;
+  svn_error_t *err;
+
+  if (cacheable)
+    {
+      svn_boolean_t found;
+
+      SVN_ERR(svn_cache__get((void **)mergeinfo, &found,
+                             ffd->mergeinfo_cache, id, result_pool));
+      if (found)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_x__dag_get_proplist(&proplist, dag, scratch_pool,
+                                     scratch_pool));
+  mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
+  if (!mergeinfo_string)
+    {
+      svn_string_t *idstr = svn_fs_x__id_unparse(id, scratch_pool);
+      return svn_error_createf
+        (SVN_ERR_FS_CORRUPT, NULL,
+         _("Node-revision #'%s' claims to have mergeinfo but doesn't"),
+         idstr->data);
+    }
+
+  /* Issue #3896: If a node has syntactically invalid mergeinfo, then
+     treat it as if no mergeinfo is present rather than raising a parse
+     error. */
+  err = svn_mergeinfo_parse(mergeinfo, mergeinfo_string->data, result_pool);
+  if (err)
+    {
+      *mergeinfo = NULL;
+      if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+        {
+          svn_error_clear(err);
+          err = NULL;
+        }
+      return svn_error_trace(err);
+    }
+
+  if (cacheable)
+    SVN_ERR(svn_cache__set(ffd->mergeinfo_cache, id, *mergeinfo,
+                           scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* DIR_DAG is a directory DAG node which has mergeinfo in its
    descendants.  This function iterates over its children.  For each
    child with immediate mergeinfo, call RECEIVER with it and BATON.
@@ -2941,41 +3005,12 @@ crawl_directory_dag_for_mergeinfo(svn_fs_root_t *root,
       if (svn_fs_x__dag_has_mergeinfo(kid_dag))
         {
           /* Save this particular node's mergeinfo. */
-          apr_hash_t *proplist;
           svn_mergeinfo_t kid_mergeinfo;
-          svn_string_t *mergeinfo_string;
-          svn_error_t *err;
-
-          SVN_ERR(svn_fs_x__dag_get_proplist(&proplist, kid_dag, iterpool,
-                                             iterpool));
-          mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
-          if (!mergeinfo_string)
-            {
-              svn_string_t *idstr
-                = svn_fs_x__id_unparse(&dirent->id, iterpool);
-              return svn_error_createf
-                (SVN_ERR_FS_CORRUPT, NULL,
-                 _("Node-revision #'%s' claims to have mergeinfo but doesn't"),
-                 idstr->data);
-            }
 
-          /* Issue #3896: If a node has syntactically invalid mergeinfo, then
-             treat it as if no mergeinfo is present rather than raising a parse
-             error. */
-          err = svn_mergeinfo_parse(&kid_mergeinfo,
-                                    mergeinfo_string->data,
-                                    iterpool);
-          if (err)
-            {
-              if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
-                svn_error_clear(err);
-              else
-                return svn_error_trace(err);
-              }
-          else
-            {
-              SVN_ERR(receiver(kid_path, kid_mergeinfo, baton, iterpool));
-            }
+          SVN_ERR(get_dag_mergeinfo(&kid_mergeinfo, kid_dag, iterpool,
+                                    iterpool));
+          if (kid_mergeinfo)
+            SVN_ERR(receiver(kid_path, kid_mergeinfo, baton, iterpool));
         }
 
       if (svn_fs_x__dag_has_descendants_with_mergeinfo(kid_dag))
@@ -3006,8 +3041,6 @@ get_mergeinfo_for_path(svn_mergeinfo_t *mergeinfo,
                        apr_pool_t *scratch_pool)
 {
   svn_fs_x__dag_path_t *dag_path, *nearest_ancestor;
-  apr_hash_t *proplist;
-  svn_string_t *mergeinfo_string;
 
   *mergeinfo = NULL;
   SVN_ERR(svn_fs_x__get_dag_path(&dag_path, rev_root, path, 0, FALSE,
@@ -3041,34 +3074,11 @@ get_mergeinfo_for_path(svn_mergeinfo_t *mergeinfo,
         }
     }
 
-  SVN_ERR(svn_fs_x__dag_get_proplist(&proplist, nearest_ancestor->node,
-                                     scratch_pool, scratch_pool));
-  mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
-  if (!mergeinfo_string)
-    return svn_error_createf
-      (SVN_ERR_FS_CORRUPT, NULL,
-       _("Node-revision '%s@%ld' claims to have mergeinfo but doesn't"),
-       parent_path_path(nearest_ancestor, scratch_pool), rev_root->rev);
-
   /* Parse the mergeinfo; store the result in *MERGEINFO. */
-  {
-    /* Issue #3896: If a node has syntactically invalid mergeinfo, then
-       treat it as if no mergeinfo is present rather than raising a parse
-       error. */
-    svn_error_t *err = svn_mergeinfo_parse(mergeinfo,
-                                           mergeinfo_string->data,
-                                           result_pool);
-    if (err)
-      {
-        if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
-          {
-            svn_error_clear(err);
-            err = NULL;
-            *mergeinfo = NULL;
-          }
-        return svn_error_trace(err);
-      }
-  }
+  SVN_ERR(get_dag_mergeinfo(mergeinfo, nearest_ancestor->node,
+                            result_pool, scratch_pool));
+  if (! *mergeinfo)
+    return SVN_NO_ERROR;
 
   /* If our nearest ancestor is the very path we inquired about, we
      can return the mergeinfo results directly.  Otherwise, we're
@@ -3213,20 +3223,24 @@ static root_vtable_t root_vtable = {
   x_node_prop,
   x_node_proplist,
   x_node_has_props,
+  NULL,
   x_change_node_prop,
   x_props_changed,
   x_dir_entries,
   x_dir_optimal_order,
+  NULL,
   x_make_dir,
   x_file_length,
   x_file_checksum,
   x_file_contents,
   x_try_process_file_contents,
+  NULL,
   x_make_file,
   x_apply_textdelta,
   x_apply_text,
   x_contents_changed,
   x_get_file_delta_stream,
+  NULL,
   x_merge,
   x_get_mergeinfo,
 };
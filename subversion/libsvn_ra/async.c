@@ -0,0 +1,360 @@
+/*
+ * async.c :  queue of RA requests with completion callbacks
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_ra.h"
+
+#include "private/svn_ra_private.h"
+
+/* The kinds of requests that may be queued. */
+typedef enum request_kind_t
+{
+  request_stat,
+  request_get_file,
+  request_get_dir,
+  request_get_log
+} request_kind_t;
+
+/* A single queued request. */
+typedef struct request_t
+{
+  request_kind_t kind;
+
+  /* Target of all but log requests. */
+  const char *path;
+  svn_revnum_t revision;
+
+  /* Only used by stat requests: set once the request has been handled. */
+  svn_boolean_t done;
+
+  /* Only used by get_file requests. */
+  svn_stream_t *stream;
+
+  /* Only used by get_dir requests. */
+  apr_uint32_t dirent_fields;
+
+  /* Only used by get_log requests. */
+  const apr_array_header_t *paths;
+  svn_revnum_t start;
+  svn_revnum_t end;
+  int limit;
+  svn_boolean_t discover_changed_paths;
+  svn_boolean_t strict_node_history;
+  svn_boolean_t include_merged_revisions;
+  const apr_array_header_t *revprops;
+  svn_log_entry_receiver_t receiver;
+  void *receiver_baton;
+
+  /* Completion callback, one per request kind. */
+  svn_ra__async_stat_cb_t stat_cb;
+  svn_ra__async_file_cb_t file_cb;
+  svn_ra__async_dir_cb_t dir_cb;
+  svn_ra__async_log_cb_t log_cb;
+  void *baton;
+} request_t;
+
+struct svn_ra__async_t
+{
+  /* Session to execute the requests on. */
+  svn_ra_session_t *session;
+
+  /* The request_t * queued, in order. */
+  apr_array_header_t *requests;
+
+  /* Holds REQUESTS.  Gets cleared after each run. */
+  apr_pool_t *queue_pool;
+};
+
+svn_error_t *
+svn_ra__async_create(svn_ra__async_t **async,
+                     svn_ra_session_t *session,
+                     apr_pool_t *result_pool)
+{
+  svn_ra__async_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  result->session = session;
+  result->queue_pool = svn_pool_create(result_pool);
+  result->requests = apr_array_make(result->queue_pool, 16,
+                                    sizeof(request_t *));
+
+  *async = result;
+  return SVN_NO_ERROR;
+}
+
+/* Append a new request of KIND for PATH in REVISION to ASYNC and return
+   it.  PATH may be NULL. */
+static request_t *
+add_request(svn_ra__async_t *async,
+            request_kind_t kind,
+            const char *path,
+            svn_revnum_t revision,
+            void *baton)
+{
+  request_t *request = apr_pcalloc(async->queue_pool, sizeof(*request));
+
+  request->kind = kind;
+  request->path = path ? apr_pstrdup(async->queue_pool, path) : NULL;
+  request->revision = revision;
+  request->baton = baton;
+
+  APR_ARRAY_PUSH(async->requests, request_t *) = request;
+  return request;
+}
+
+svn_error_t *
+svn_ra__async_stat(svn_ra__async_t *async,
+                   const char *path,
+                   svn_revnum_t revision,
+                   svn_ra__async_stat_cb_t callback,
+                   void *baton)
+{
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+
+  add_request(async, request_stat, path, revision, baton)->stat_cb
+    = callback;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra__async_get_file(svn_ra__async_t *async,
+                       const char *path,
+                       svn_revnum_t revision,
+                       svn_stream_t *stream,
+                       svn_ra__async_file_cb_t callback,
+                       void *baton)
+{
+  request_t *request;
+
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+
+  request = add_request(async, request_get_file, path, revision, baton);
+  request->stream = stream;
+  request->file_cb = callback;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra__async_get_dir(svn_ra__async_t *async,
+                      const char *path,
+                      svn_revnum_t revision,
+                      apr_uint32_t dirent_fields,
+                      svn_ra__async_dir_cb_t callback,
+                      void *baton)
+{
+  request_t *request;
+
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+
+  request = add_request(async, request_get_dir, path, revision, baton);
+  request->dirent_fields = dirent_fields;
+  request->dir_cb = callback;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra__async_get_log(svn_ra__async_t *async,
+                      const apr_array_header_t *paths,
+                      svn_revnum_t start,
+                      svn_revnum_t end,
+                      int limit,
+                      svn_boolean_t discover_changed_paths,
+                      svn_boolean_t strict_node_history,
+                      svn_boolean_t include_merged_revisions,
+                      const apr_array_header_t *revprops,
+                      svn_log_entry_receiver_t receiver,
+                      void *receiver_baton,
+                      svn_ra__async_log_cb_t callback,
+                      void *baton)
+{
+  request_t *request = add_request(async, request_get_log, NULL,
+                                   SVN_INVALID_REVNUM, baton);
+
+  request->paths = paths;
+  request->start = start;
+  request->end = end;
+  request->limit = limit;
+  request->discover_changed_paths = discover_changed_paths;
+  request->strict_node_history = strict_node_history;
+  request->include_merged_revisions = include_merged_revisions;
+  request->revprops = revprops;
+  request->receiver = receiver;
+  request->receiver_baton = receiver_baton;
+  request->log_cb = callback;
+  return SVN_NO_ERROR;
+}
+
+/* Execute all stat requests in ASYNC that have not been handled yet.
+   Send all requests for the same revision as one batch.  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+run_stat_requests(svn_ra__async_t *async,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i, k;
+
+  for (i = 0; i < async->requests->nelts; i++)
+    {
+      request_t *first = APR_ARRAY_IDX(async->requests, i, request_t *);
+      apr_array_header_t *paths;
+      apr_hash_t *unique_paths;
+      apr_hash_t *dirents;
+
+      if (first->kind != request_stat || first->done)
+        continue;
+
+      svn_pool_clear(iterpool);
+
+      /* Collect all paths to stat in FIRST's revision. */
+      paths = apr_array_make(iterpool, 16, sizeof(const char *));
+      unique_paths = apr_hash_make(iterpool);
+      for (k = i; k < async->requests->nelts; k++)
+        {
+          request_t *request = APR_ARRAY_IDX(async->requests, k,
+                                             request_t *);
+          if (request->kind == request_stat
+              && request->revision == first->revision
+              && !svn_hash_gets(unique_paths, request->path))
+            {
+              svn_hash_sets(unique_paths, request->path, request->path);
+              APR_ARRAY_PUSH(paths, const char *) = request->path;
+            }
+        }
+
+      SVN_ERR(svn_ra__stat_many(async->session, &dirents, paths,
+                                first->revision, iterpool, iterpool));
+
+      /* Report the results in queue order. */
+      for (k = i; k < async->requests->nelts; k++)
+        {
+          request_t *request = APR_ARRAY_IDX(async->requests, k,
+                                             request_t *);
+          if (request->kind == request_stat
+              && request->revision == first->revision)
+            {
+              request->done = TRUE;
+              SVN_ERR(request->stat_cb(request->baton, request->path,
+                                       svn_hash_gets(dirents, request->path),
+                                       iterpool));
+            }
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Execute REQUEST, which must not be a stat request, on SESSION and
+   invoke its completion callback.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+run_request(svn_ra_session_t *session,
+            request_t *request,
+            apr_pool_t *scratch_pool)
+{
+  svn_revnum_t fetched_rev = SVN_INVALID_REVNUM;
+  apr_hash_t *props = NULL;
+  apr_hash_t *dirents = NULL;
+
+  switch (request->kind)
+    {
+      case request_get_file:
+        SVN_ERR(svn_ra_get_file(session, request->path, request->revision,
+                                request->stream, &fetched_rev, &props,
+                                scratch_pool));
+        if (request->file_cb)
+          SVN_ERR(request->file_cb(request->baton, request->path,
+                                   fetched_rev, props, scratch_pool));
+        break;
+
+      case request_get_dir:
+        SVN_ERR(svn_ra_get_dir2(session, &dirents, &fetched_rev, &props,
+                                request->path, request->revision,
+                                request->dirent_fields, scratch_pool));
+        if (request->dir_cb)
+          SVN_ERR(request->dir_cb(request->baton, request->path, dirents,
+                                  fetched_rev, props, scratch_pool));
+        break;
+
+      case request_get_log:
+        SVN_ERR(svn_ra_get_log2(session, request->paths, request->start,
+                                request->end, request->limit,
+                                request->discover_changed_paths,
+                                request->strict_node_history,
+                                request->include_merged_revisions,
+                                request->revprops, request->receiver,
+                                request->receiver_baton, scratch_pool));
+        if (request->log_cb)
+          SVN_ERR(request->log_cb(request->baton, scratch_pool));
+        break;
+
+      default:
+        SVN_ERR_MALFUNCTION();
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Execute all requests queued in ASYNC.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+run_requests(svn_ra__async_t *async,
+             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(run_stat_requests(async, scratch_pool));
+
+  for (i = 0; i < async->requests->nelts; i++)
+    {
+      request_t *request = APR_ARRAY_IDX(async->requests, i, request_t *);
+      if (request->kind == request_stat)
+        continue;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(run_request(async->session, request, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra__async_run(svn_ra__async_t *async,
+                  apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = run_requests(async, scratch_pool);
+
+  /* Start over with an empty queue, even after a failure. */
+  svn_pool_clear(async->queue_pool);
+  async->requests = apr_array_make(async->queue_pool, 16,
+                                   sizeof(request_t *));
+
+  return svn_error_trace(err);
+}
@@ -825,6 +825,42 @@ svn_error_t *svn_ra_get_log2(svn_ra_session_t *session,
                                   receiver, receiver_baton, pool);
 }
 
+svn_error_t *
+svn_ra__get_log_search(svn_ra_session_t *session,
+                       const apr_array_header_t *paths,
+                       svn_revnum_t start,
+                       svn_revnum_t end,
+                       int limit,
+                       svn_boolean_t discover_changed_paths,
+                       svn_boolean_t strict_node_history,
+                       const apr_array_header_t *revprops,
+                       const apr_array_header_t *search_patterns,
+                       svn_log_entry_receiver_t receiver,
+                       void *receiver_baton,
+                       apr_pool_t *pool)
+{
+  int i;
+
+  if (!search_patterns || !session->vtable->get_log_search)
+    return svn_error_trace(svn_ra_get_log2(session, paths, start, end, limit,
+                                           discover_changed_paths,
+                                           strict_node_history, FALSE,
+                                           revprops, receiver, receiver_baton,
+                                           pool));
+
+  for (i = 0; paths && i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+    }
+
+  return svn_error_trace(session->vtable->get_log_search(
+                           session, paths, start, end, limit,
+                           discover_changed_paths, strict_node_history,
+                           revprops, search_patterns,
+                           receiver, receiver_baton, pool));
+}
+
 svn_error_t *svn_ra_check_path(svn_ra_session_t *session,
                                const char *path,
                                svn_revnum_t revision,
@@ -941,6 +977,51 @@ svn_error_t *svn_ra_stat(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra__stat_many(svn_ra_session_t *session,
+                  apr_hash_t **dirents,
+                  const apr_array_header_t *paths,
+                  svn_revnum_t revision,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    SVN_ERR_ASSERT(svn_relpath_is_canonical(APR_ARRAY_IDX(paths, i,
+                                                          const char *)));
+
+  if (session->vtable->stat_many)
+    {
+      svn_error_t *err = session->vtable->stat_many(session, dirents, paths,
+                                                    revision, result_pool,
+                                                    scratch_pool);
+      if (!err || err->apr_err != SVN_ERR_RA_NOT_IMPLEMENTED)
+        return svn_error_trace(err);
+
+      svn_error_clear(err);
+    }
+
+  /* Fall back to one request per path. */
+  *dirents = apr_hash_make(result_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_stat(session, path, revision, &dirent, iterpool));
+      if (dirent)
+        svn_hash_sets(*dirents, apr_pstrdup(result_pool, path),
+                      svn_dirent_dup(dirent, result_pool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *svn_ra_get_uuid2(svn_ra_session_t *session,
                               const char **uuid,
                               apr_pool_t *pool)
@@ -1065,6 +1146,31 @@ svn_error_t *svn_ra_get_file_revs2(svn_ra_session_t *session,
   return svn_error_trace(err);
 }
 
+svn_error_t *
+svn_ra__get_file_blame(svn_ra_session_t *session,
+                       const char *path,
+                       svn_revnum_t start,
+                       svn_revnum_t end,
+                       const svn_diff_file_options_t *diff_options,
+                       svn_ra__blame_receiver_t receiver,
+                       void *receiver_baton,
+                       apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(start) && SVN_IS_VALID_REVNUM(end)
+                 && start <= end);
+
+  if (!session->vtable->get_file_blame)
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL, NULL);
+
+  return svn_error_trace(session->vtable->get_file_blame(session, path,
+                                                         start, end,
+                                                         diff_options,
+                                                         receiver,
+                                                         receiver_baton,
+                                                         scratch_pool));
+}
+
 svn_error_t *svn_ra_lock(svn_ra_session_t *session,
                          apr_hash_t *path_revs,
                          const char *comment,
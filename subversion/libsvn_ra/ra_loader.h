@@ -378,6 +378,38 @@ typedef struct svn_ra__vtable_t {
     void *replay_baton,
     apr_pool_t *scratch_pool);
 
+  /* See svn_ra__stat_many().  May be NULL. */
+  svn_error_t *(*stat_many)(svn_ra_session_t *session,
+                            apr_hash_t **dirents,
+                            const apr_array_header_t *paths,
+                            svn_revnum_t revision,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+  /* See svn_ra__get_file_blame().  May be NULL. */
+  svn_error_t *(*get_file_blame)(svn_ra_session_t *session,
+                                 const char *path,
+                                 svn_revnum_t start,
+                                 svn_revnum_t end,
+                                 const svn_diff_file_options_t *diff_options,
+                                 svn_ra__blame_receiver_t receiver,
+                                 void *receiver_baton,
+                                 apr_pool_t *scratch_pool);
+
+  /* See svn_ra__get_log_search().  May be NULL. */
+  svn_error_t *(*get_log_search)(svn_ra_session_t *session,
+                                 const apr_array_header_t *paths,
+                                 svn_revnum_t start,
+                                 svn_revnum_t end,
+                                 int limit,
+                                 svn_boolean_t discover_changed_paths,
+                                 svn_boolean_t strict_node_history,
+                                 const apr_array_header_t *revprops,
+                                 const apr_array_header_t *search_patterns,
+                                 svn_log_entry_receiver_t receiver,
+                                 void *receiver_baton,
+                                 apr_pool_t *pool);
+
 } svn_ra__vtable_t;
 
 /* The RA session object. */
@@ -369,6 +369,10 @@ make_reporter(svn_ra_session_t *session,
                                         additional details. */
                                   result_pool));
 
+  /* The editor runs in our process, so there is no point in compressing
+     added files against themselves just to expand them again. */
+  svn_repos__report_set_send_fulltexts(rbaton, TRUE);
+
   /* Wrap the report baton given us by the repos layer with our own
      reporter baton. */
   *report_baton = make_reporter_baton(sess, rbaton, result_pool);
@@ -731,6 +735,28 @@ svn_ra_local__get_file_revs(svn_ra_session_t *session,
                                   handler, handler_baton, pool);
 }
 
+static svn_error_t *
+svn_ra_local__get_file_blame(svn_ra_session_t *session,
+                             const char *path,
+                             svn_revnum_t start,
+                             svn_revnum_t end,
+                             const svn_diff_file_options_t *diff_options,
+                             svn_ra__blame_receiver_t receiver,
+                             void *receiver_baton,
+                             apr_pool_t *scratch_pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  const char *abs_path = svn_fspath__join(sess->fs_path->data, path,
+                                          scratch_pool);
+
+  return svn_error_trace(svn_repos__get_file_blame(
+                           sess->repos, abs_path, start, end, diff_options,
+                           NULL, NULL, FALSE, receiver, receiver_baton,
+                           sess->callbacks ? sess->callbacks->cancel_func
+                                           : NULL,
+                           sess->callback_baton, scratch_pool));
+}
+
 static svn_error_t *
 svn_ra_local__get_dated_revision(svn_ra_session_t *session,
                                  svn_revnum_t *revision,
@@ -1121,19 +1147,21 @@ log_receiver_wrapper(void *baton,
 }
 
 
+/* Implement svn_ra_local__get_log() and svn_ra_local__get_log_search(). */
 static svn_error_t *
-svn_ra_local__get_log(svn_ra_session_t *session,
-                      const apr_array_header_t *paths,
-                      svn_revnum_t start,
-                      svn_revnum_t end,
-                      int limit,
-                      svn_boolean_t discover_changed_paths,
-                      svn_boolean_t strict_node_history,
-                      svn_boolean_t include_merged_revisions,
-                      const apr_array_header_t *revprops,
-                      svn_log_entry_receiver_t receiver,
-                      void *receiver_baton,
-                      apr_pool_t *pool)
+get_log(svn_ra_session_t *session,
+        const apr_array_header_t *paths,
+        svn_revnum_t start,
+        svn_revnum_t end,
+        int limit,
+        svn_boolean_t discover_changed_paths,
+        svn_boolean_t strict_node_history,
+        svn_boolean_t include_merged_revisions,
+        const apr_array_header_t *revprops,
+        const apr_array_header_t *search_patterns,
+        svn_log_entry_receiver_t receiver,
+        void *receiver_baton,
+        apr_pool_t *pool)
 {
   svn_ra_local__session_baton_t *sess = session->priv;
   struct log_baton lb;
@@ -1167,12 +1195,53 @@ svn_ra_local__get_log(svn_ra_session_t *session,
                                     strict_node_history,
                                     include_merged_revisions,
                                     revprops,
+                                    search_patterns,
                                     NULL, NULL,
                                     receiver,
                                     receiver_baton,
                                     pool);
 }
 
+static svn_error_t *
+svn_ra_local__get_log(svn_ra_session_t *session,
+                      const apr_array_header_t *paths,
+                      svn_revnum_t start,
+                      svn_revnum_t end,
+                      int limit,
+                      svn_boolean_t discover_changed_paths,
+                      svn_boolean_t strict_node_history,
+                      svn_boolean_t include_merged_revisions,
+                      const apr_array_header_t *revprops,
+                      svn_log_entry_receiver_t receiver,
+                      void *receiver_baton,
+                      apr_pool_t *pool)
+{
+  return svn_error_trace(get_log(session, paths, start, end, limit,
+                                 discover_changed_paths, strict_node_history,
+                                 include_merged_revisions, revprops, NULL,
+                                 receiver, receiver_baton, pool));
+}
+
+static svn_error_t *
+svn_ra_local__get_log_search(svn_ra_session_t *session,
+                             const apr_array_header_t *paths,
+                             svn_revnum_t start,
+                             svn_revnum_t end,
+                             int limit,
+                             svn_boolean_t discover_changed_paths,
+                             svn_boolean_t strict_node_history,
+                             const apr_array_header_t *revprops,
+                             const apr_array_header_t *search_patterns,
+                             svn_log_entry_receiver_t receiver,
+                             void *receiver_baton,
+                             apr_pool_t *pool)
+{
+  return svn_error_trace(get_log(session, paths, start, end, limit,
+                                 discover_changed_paths, strict_node_history,
+                                 FALSE, revprops, search_patterns,
+                                 receiver, receiver_baton, pool));
+}
+
 
 static svn_error_t *
 svn_ra_local__do_check_path(svn_ra_session_t *session,
@@ -1916,7 +1985,10 @@ static const svn_ra__vtable_t ra_local_vtable =
   svn_ra_local__list ,
   svn_ra_local__register_editor_shim_callbacks,
   svn_ra_local__get_commit_ev2,
-  NULL /* replay_range_ev2 */
+  NULL /* replay_range_ev2 */,
+  NULL /* stat_many */,
+  svn_ra_local__get_file_blame,
+  svn_ra_local__get_log_search
 };
 
 
@@ -27,6 +27,9 @@
 #include "svn_dirent_uri.h"
 #include "svn_types.h"
 #include "svn_pools.h"
+#include "svn_io.h"
+#include "svn_checksum.h"
+#include "svn_string.h"
 
 #include "blncache.h"
 
@@ -50,8 +53,17 @@ struct svn_ra_serf__blncache_t
    * structures. (Allocated from the same pool as 'revnum_to_bc'.)
    */
   apr_hash_t *baseline_info;
+
+  /* If not NULL, the file we append new entries to.  Allocated in POOL,
+   * the pool the cache has been created in. */
+  const char *file_path;
+  apr_pool_t *pool;
 };
 
+/* Upper limit for the number of entries in a cache file.  Once a file
+ * grows beyond that, it gets started afresh. */
+#define MAX_FILE_ENTRIES 10000
+
 
 
 /* Return a pointer to an 'baseline_info_t' structure allocated from
@@ -94,6 +106,8 @@ svn_ra_serf__blncache_create(svn_ra_serf__blncache_t **blncache_p,
   svn_ra_serf__blncache_t *blncache = apr_pcalloc(pool, sizeof(*blncache));
   apr_pool_t *cache_pool;
 
+  blncache->pool = pool;
+
   /* Create subpool for cached data. It will be cleared if we reach maximum
    * cache size.*/
   cache_pool = svn_pool_create(pool);
@@ -107,12 +121,13 @@ svn_ra_serf__blncache_create(svn_ra_serf__blncache_t **blncache_p,
 
 #define MAX_CACHE_SIZE 1000
 
-svn_error_t *
-svn_ra_serf__blncache_set(svn_ra_serf__blncache_t *blncache,
-                          const char *baseline_url,
-                          svn_revnum_t revision,
-                          const char *bc_url,
-                          apr_pool_t *scratch_pool)
+/* Store the baseline information in the in-memory caches of BLNCACHE.
+ * Parameters are the same as for svn_ra_serf__blncache_set. */
+static void
+cache_set(svn_ra_serf__blncache_t *blncache,
+          const char *baseline_url,
+          svn_revnum_t revision,
+          const char *bc_url)
 {
   if (bc_url && SVN_IS_VALID_REVNUM(revision))
     {
@@ -137,11 +152,160 @@ svn_ra_serf__blncache_set(svn_ra_serf__blncache_t *blncache,
                         baseline_info_make(bc_url, revision, cache_pool));
         }
     }
+}
+
+#undef MAX_CACHE_SIZE
+
+/* Append an entry for BASELINE_URL, REVISION and BC_URL to the file
+ * backing BLNCACHE.  BASELINE_URL may be NULL. */
+static svn_error_t *
+file_append(svn_ra_serf__blncache_t *blncache,
+            const char *baseline_url,
+            svn_revnum_t revision,
+            const char *bc_url,
+            apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  const char *line;
+
+  line = apr_psprintf(scratch_pool, "%ld %s%s%s\n", revision, bc_url,
+                      baseline_url ? " " : "",
+                      baseline_url ? baseline_url : "");
+
+  /* A single append of a full line, so concurrent writers won't produce
+   * garbled entries in practice.  We ignore those while reading anyway. */
+  SVN_ERR(svn_io_file_open(&file, blncache->file_path,
+                           APR_WRITE | APR_APPEND | APR_CREATE,
+                           APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, line, strlen(line), NULL,
+                                 scratch_pool));
+
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
+svn_error_t *
+svn_ra_serf__blncache_set(svn_ra_serf__blncache_t *blncache,
+                          const char *baseline_url,
+                          svn_revnum_t revision,
+                          const char *bc_url,
+                          apr_pool_t *scratch_pool)
+{
+  if (!bc_url || !SVN_IS_VALID_REVNUM(revision))
+    return SVN_NO_ERROR;
+
+  cache_set(blncache, baseline_url, revision, bc_url);
+
+  /* The persistent cache is merely an optimization. */
+  if (blncache->file_path)
+    {
+      svn_error_t *err = file_append(blncache, baseline_url, revision,
+                                     bc_url, scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          blncache->file_path = NULL;
+        }
+    }
 
   return SVN_NO_ERROR;
 }
 
-#undef MAX_CACHE_SIZE
+/* Read the baseline information from STREAM into BLNCACHE.  The first
+ * line must match HEADER.  Set *ENTRIES to the number of lines read. */
+static svn_error_t *
+file_load(svn_ra_serf__blncache_t *blncache,
+          int *entries,
+          svn_stream_t *stream,
+          const char *header,
+          apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_stringbuf_t *line;
+  svn_boolean_t eof;
+
+  *entries = 0;
+
+  SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, scratch_pool));
+  if (eof || strcmp(line->data, header) != 0)
+    return SVN_NO_ERROR;
+
+  while (!eof)
+    {
+      apr_array_header_t *parts;
+      svn_revnum_t revision;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, iterpool));
+      ++*entries;
+
+      /* Skip anything that does not look like a valid entry. */
+      parts = svn_cstring_split(line->data, " ", FALSE, iterpool);
+      if (parts->nelts != 2 && parts->nelts != 3)
+        continue;
+      if (svn_revnum_parse(&revision, APR_ARRAY_IDX(parts, 0, const char *),
+                           NULL))
+        continue;
+
+      cache_set(blncache,
+                parts->nelts == 3 ? APR_ARRAY_IDX(parts, 2, const char *)
+                                  : NULL,
+                revision, APR_ARRAY_IDX(parts, 1, const char *));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__blncache_attach_file(svn_ra_serf__blncache_t *blncache,
+                                  const char *cache_dir,
+                                  const char *uuid,
+                                  const char *repos_root_url,
+                                  apr_pool_t *scratch_pool)
+{
+  const char *header = apr_pstrcat(scratch_pool, uuid, " ", repos_root_url,
+                                   SVN_VA_NULL);
+  svn_checksum_t *checksum;
+  const char *file_path;
+  svn_stream_t *stream;
+  int entries = 0;
+  svn_error_t *err;
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_md5, header, strlen(header),
+                       scratch_pool));
+  file_path = svn_dirent_join(cache_dir,
+                              svn_checksum_to_cstring(checksum, scratch_pool),
+                              scratch_pool);
+
+  err = svn_stream_open_readonly(&stream, file_path, scratch_pool,
+                                 scratch_pool);
+  if (!err)
+    {
+      err = file_load(blncache, &entries, stream, header, scratch_pool);
+      err = svn_error_compose_create(err, svn_stream_close(stream));
+    }
+
+  /* Start a new file if there is none, it is unusable or too large. */
+  if (err || entries == 0 || entries > MAX_FILE_ENTRIES)
+    {
+      svn_error_clear(err);
+
+      header = apr_pstrcat(scratch_pool, header, "\n", SVN_VA_NULL);
+      err = svn_io_make_dir_recursively(cache_dir, scratch_pool);
+      if (!err)
+        err = svn_io_write_atomic2(file_path, header, strlen(header),
+                                   NULL, FALSE, scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          return SVN_NO_ERROR;
+        }
+    }
+
+  blncache->file_path = apr_pstrdup(blncache->pool, file_path);
+
+  return SVN_NO_ERROR;
+}
 
 svn_error_t *
 svn_ra_serf__blncache_get_bc_url(const char **bc_url_p,
@@ -83,6 +83,22 @@ svn_ra_serf__blncache_get_baseline_info(const char **bc_url_p,
                                         const char *baseline_url,
                                         apr_pool_t *pool);
 
+/* Back BLNCACHE with a file in directory CACHE_DIR, so that later sessions
+ * can skip the baseline discovery.  The file is specific to the repository
+ * with UUID at REPOS_ROOT_URL.  Load all information already stored there
+ * and append anything added with svn_ra_serf__blncache_set from now on.
+ * Since baselines never change, the file needs no invalidation.
+ *
+ * Problems with the file are not fatal; the cache simply stays in memory
+ * only.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_ra_serf__blncache_attach_file(svn_ra_serf__blncache_t *blncache,
+                                  const char *cache_dir,
+                                  const char *uuid,
+                                  const char *repos_root_url,
+                                  apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -40,11 +40,16 @@
 #include "private/svn_dep_compat.h"
 #include "private/svn_fspath.h"
 #include "private/svn_skel.h"
+#include "private/svn_sorts_private.h"
 
 #include "ra_serf.h"
 #include "../libsvn_ra/ra_loader.h"
 
 
+/* Maximum number of PUT requests that may be pipelined on the commit
+   connection before close_file() waits for the oldest one. */
+#define MAX_PENDING_PUTS 16
+
 /* Baton passed back with the commit editor. */
 typedef struct commit_context_t {
   /* Pool for our commit. */
@@ -72,6 +77,10 @@ typedef struct commit_context_t {
   const char *vcc_url;           /* vcc url */
 
   int open_batons;               /* Number of open batons */
+
+  /* PUT requests whose responses we did not check yet, oldest first
+     (pending_put_t *). */
+  apr_array_header_t *pending_puts;
 } commit_context_t;
 
 #define USING_HTTPV2_COMMIT_SUPPORT(commit_ctx) ((commit_ctx)->txn_url != NULL)
@@ -176,6 +185,10 @@ typedef struct file_context_t {
   /* Buffer holding the svndiff (can spill to disk). */
   svn_ra_serf__request_body_t *svndiff;
 
+  /* Pool for the svndiff and the PUT request sending it.  Unlike POOL,
+     this one lives on after close_file() until the PUT has completed. */
+  apr_pool_t *put_pool;
+
   /* Did we send the svndiff in apply_textdelta_stream()? */
   svn_boolean_t svndiff_sent;
 
@@ -196,6 +209,20 @@ typedef struct file_context_t {
 
 } file_context_t;
 
+/* A PUT request sent by close_file() that may still be in flight. */
+typedef struct pending_put_t {
+  /* Pool containing all data used by the request. */
+  apr_pool_t *pool;
+
+  svn_ra_serf__handler_t *handler;
+
+  /* The request body, or NULL when PUTting an empty file. */
+  svn_ra_serf__request_body_t *svndiff;
+
+  /* Status code that signals success. */
+  int expected_result;
+} pending_put_t;
+
 
 /* Setup routines and handlers for various requests we'll invoke. */
 
@@ -1886,6 +1913,8 @@ negotiate_put_encoding(int *svndiff_version_p,
       if (session->supports_svndiff2 &&
           svn_ra_serf__is_low_latency_connection(session))
         svndiff_version = 2;
+      else if (session->supports_svndiff3)
+        svndiff_version = 3;
       else if (session->supports_svndiff1)
         svndiff_version = 1;
       else if (session->supports_svndiff2)
@@ -1902,8 +1931,13 @@ negotiate_put_encoding(int *svndiff_version_p,
        *
        * Note: For future compatibility, we also handle a theoretically
        * possible case where the server has advertised only svndiff2 support.
+       *
+       * svndiff3 is better than svndiff1 in both respects, so use it
+       * whenever both sides support it.
        */
-      if (session->supports_svndiff1)
+      if (session->supports_svndiff3)
+        svndiff_version = 3;
+      else if (session->supports_svndiff1)
         svndiff_version = 1;
       else if (session->supports_svndiff2)
         svndiff_version = 2;
@@ -1956,9 +1990,10 @@ apply_textdelta(void *file_baton,
    * in response to a PUT" capability, and only if the editor driver uses the
    * new callback.
    */
+  ctx->put_pool = svn_pool_create(ctx->commit_ctx->pool);
   ctx->svndiff =
     svn_ra_serf__request_body_create(SVN_RA_SERF__REQUEST_BODY_IN_MEM_SIZE,
-                                     ctx->pool);
+                                     ctx->put_pool);
   ctx->stream = svn_ra_serf__request_body_get_stream(ctx->svndiff);
 
   negotiate_put_encoding(&svndiff_version, &compression_level,
@@ -2133,70 +2168,170 @@ change_file_prop(void *file_baton,
   return SVN_NO_ERROR;
 }
 
+/* Check the response to the completed request PUT, then release all of
+   its resources.  Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
-close_file(void *file_baton,
-           const char *text_checksum,
+finish_put(pending_put_t *put,
            apr_pool_t *scratch_pool)
 {
-  file_context_t *ctx = file_baton;
-  svn_boolean_t put_empty_file = FALSE;
+  svn_ra_serf__handler_t *handler = put->handler;
+  svn_error_t *err = SVN_NO_ERROR;
 
-  ctx->result_checksum = text_checksum;
+  if (handler->sline.code != put->expected_result)
+    {
+      if (handler->server_error)
+        err = svn_ra_serf__server_error_create(handler, scratch_pool);
+      else
+        err = svn_ra_serf__unexpected_status(handler);
+    }
 
-  /* If we got no stream of changes, but this is an added-without-history
-   * file, make a note that we'll be PUTting a zero-byte file to the server.
-   */
-  if ((!ctx->svndiff) && ctx->added && (!ctx->copy_path))
-    put_empty_file = TRUE;
+  /* Don't keep open file handles longer than necessary. */
+  if (put->svndiff)
+    err = svn_error_compose_create(
+            err,
+            svn_ra_serf__request_body_cleanup(put->svndiff, scratch_pool));
 
-  /* If we have a stream of changes, push them to the server... */
-  if ((ctx->svndiff || put_empty_file) && !ctx->svndiff_sent)
-    {
-      svn_ra_serf__handler_t *handler;
-      int expected_result;
+  svn_pool_destroy(put->pool);
 
-      handler = svn_ra_serf__create_handler(ctx->commit_ctx->session,
-                                            scratch_pool);
+  return svn_error_trace(err);
+}
 
-      handler->method = "PUT";
-      handler->path = ctx->url;
+/* Run the serf context until no more than MAX_PENDING PUT requests of
+   COMMIT_CTX are left in flight, checking completed ones in the order
+   they were sent.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+wait_for_puts(commit_context_t *commit_ctx,
+              int max_pending,
+              apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *puts = commit_ctx->pending_puts;
+  apr_interval_time_t waittime_left = commit_ctx->session->timeout;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
 
-      handler->response_handler = svn_ra_serf__expect_empty_body;
-      handler->response_baton = handler;
+  while (puts->nelts > 0)
+    {
+      pending_put_t *put = APR_ARRAY_IDX(puts, 0, pending_put_t *);
 
-      if (put_empty_file)
+      svn_pool_clear(iterpool);
+
+      if (put->handler->done)
         {
-          handler->body_delegate = create_empty_put_body;
-          handler->body_delegate_baton = ctx;
-          handler->body_type = "text/plain";
+          /* Dequeue first, so that a failed PUT gets reported only once. */
+          svn_sort__array_delete(puts, 0, 1);
+          SVN_ERR(finish_put(put, iterpool));
         }
+      else if (puts->nelts > max_pending)
+        SVN_ERR(svn_ra_serf__context_run(commit_ctx->session,
+                                         &waittime_left, iterpool));
       else
-        {
-          SVN_ERR(svn_stream_close(ctx->stream));
+        break;
+    }
 
-          svn_ra_serf__request_body_get_delegate(&handler->body_delegate,
-                                                 &handler->body_delegate_baton,
-                                                 ctx->svndiff);
-          handler->body_type = SVN_SVNDIFF_MIME_TYPE;
-        }
+  svn_pool_destroy(iterpool);
 
-      handler->header_delegate = setup_put_headers;
-      handler->header_delegate_baton = ctx;
+  return SVN_NO_ERROR;
+}
 
-      SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
+/* Send the contents of file CTX -- empty if PUT_EMPTY_FILE is set -- to
+   the server without waiting for the response.
 
-      if (ctx->added && ! ctx->copy_path)
-        expected_result = 201; /* Created */
-      else
-        expected_result = 204; /* Updated */
+   All commit requests go through the same connection and the server
+   handles them in order.  That also keeps any later request for the same
+   path behind its PUT.  The server would not accept two concurrent
+   writes to the same transaction anyway.  Over HTTP/2, requests don't
+   wait for each other, so we must wait for the response right away.
 
-      if (handler->sline.code != expected_result)
-        return svn_error_trace(svn_ra_serf__unexpected_status(handler));
+   Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+queue_put(file_context_t *ctx,
+          svn_boolean_t put_empty_file,
+          apr_pool_t *scratch_pool)
+{
+  commit_context_t *commit_ctx = ctx->commit_ctx;
+  file_context_t *put_ctx;
+  pending_put_t *put;
+  svn_ra_serf__handler_t *handler;
+
+  if (!ctx->put_pool)
+    ctx->put_pool = svn_pool_create(commit_ctx->pool);
+
+  /* The editor driver may destroy CTX->POOL as soon as close_file()
+     returns, so the request must not use anything in it. */
+  put_ctx = apr_pmemdup(ctx->put_pool, ctx, sizeof(*ctx));
+  put_ctx->relpath = apr_pstrdup(ctx->put_pool, ctx->relpath);
+  put_ctx->url = apr_pstrdup(ctx->put_pool, ctx->url);
+  put_ctx->base_checksum = apr_pstrdup(ctx->put_pool, ctx->base_checksum);
+  put_ctx->result_checksum = apr_pstrdup(ctx->put_pool,
+                                         ctx->result_checksum);
+
+  put = apr_pcalloc(ctx->put_pool, sizeof(*put));
+  put->pool = ctx->put_pool;
+  put->svndiff = ctx->svndiff;
+  if (ctx->added && ! ctx->copy_path)
+    put->expected_result = 201; /* Created */
+  else
+    put->expected_result = 204; /* Updated */
+
+  handler = svn_ra_serf__create_handler(commit_ctx->session, put->pool);
+
+  handler->method = "PUT";
+  handler->path = put_ctx->url;
+
+  handler->response_handler = svn_ra_serf__expect_empty_body;
+  handler->response_baton = handler;
+
+  if (put_empty_file)
+    {
+      handler->body_delegate = create_empty_put_body;
+      handler->body_delegate_baton = put_ctx;
+      handler->body_type = "text/plain";
+    }
+  else
+    {
+      SVN_ERR(svn_stream_close(ctx->stream));
+
+      svn_ra_serf__request_body_get_delegate(&handler->body_delegate,
+                                             &handler->body_delegate_baton,
+                                             ctx->svndiff);
+      handler->body_type = SVN_SVNDIFF_MIME_TYPE;
     }
 
-  /* Don't keep open file handles longer than necessary. */
-  if (ctx->svndiff)
-    SVN_ERR(svn_ra_serf__request_body_cleanup(ctx->svndiff, scratch_pool));
+  handler->header_delegate = setup_put_headers;
+  handler->header_delegate_baton = put_ctx;
+
+  put->handler = handler;
+  ctx->svndiff = NULL;
+  ctx->put_pool = NULL;
+
+  svn_ra_serf__request_create(handler);
+  APR_ARRAY_PUSH(commit_ctx->pending_puts, pending_put_t *) = put;
+
+  return svn_error_trace(wait_for_puts(commit_ctx,
+                                       commit_ctx->session->http20
+                                         ? 0 : MAX_PENDING_PUTS,
+                                       scratch_pool));
+}
+
+static svn_error_t *
+close_file(void *file_baton,
+           const char *text_checksum,
+           apr_pool_t *scratch_pool)
+{
+  file_context_t *ctx = file_baton;
+  svn_boolean_t put_empty_file = FALSE;
+
+  ctx->result_checksum = text_checksum;
+
+  /* If we got no stream of changes, but this is an added-without-history
+   * file, make a note that we'll be PUTting a zero-byte file to the server.
+   */
+  if ((!ctx->svndiff) && ctx->added && (!ctx->copy_path))
+    put_empty_file = TRUE;
+
+  /* If we have a stream of changes, push them to the server... */
+  if ((ctx->svndiff || put_empty_file) && !ctx->svndiff_sent)
+    SVN_ERR(queue_put(ctx, put_empty_file, scratch_pool));
 
   /* If we had any prop changes, push them via PROPPATCH. */
   if (apr_hash_count(ctx->prop_changes))
@@ -2251,6 +2386,9 @@ close_edit(void *edit_baton,
               SVN_ERR_FS_INCORRECT_EDITOR_COMPLETION, NULL,
               _("Closing editor with directories or files open"));
 
+  /* Never MERGE a transaction with missing contents. */
+  SVN_ERR(wait_for_puts(ctx, 0, pool));
+
   /* MERGE our activity */
   SVN_ERR(svn_ra_serf__run_merge(&commit_info,
                                  ctx->session,
@@ -2305,6 +2443,23 @@ abort_edit(void *edit_baton,
   if (! (ctx->activity_url || ctx->txn_url))
     return SVN_NO_ERROR;
 
+  /* Let the remaining PUTs complete, so that resetting the connection
+     won't requeue them behind our DELETE.  Their errors don't matter
+     anymore. */
+  while (ctx->pending_puts->nelts)
+    {
+      pending_put_t *put = APR_ARRAY_IDX(ctx->pending_puts, 0,
+                                         pending_put_t *);
+
+      svn_error_clear(wait_for_puts(ctx, 0, pool));
+
+      /* Give up if the connection itself is broken. */
+      if (ctx->pending_puts->nelts
+          && APR_ARRAY_IDX(ctx->pending_puts, 0, pending_put_t *) == put
+          && !put->handler->done)
+        break;
+    }
+
   /* An error occurred on conns[0]. serf 0.4.0 remembers that the connection
      had a problem. We need to reset it, in order to use it again.  */
   serf_connection_reset(ctx->session->conns[0]->conn);
@@ -2391,6 +2546,8 @@ svn_ra_serf__get_commit_editor(svn_ra_session_t *ra_session,
   ctx->keep_locks = keep_locks;
 
   ctx->deleted_entries = apr_hash_make(ctx->pool);
+  ctx->pending_puts = apr_array_make(ctx->pool, MAX_PENDING_PUTS,
+                                     sizeof(pending_put_t *));
 
   editor = svn_delta_default_editor(pool);
   editor->open_root = open_root;
@@ -0,0 +1,298 @@
+/*
+ * list.c :  entry point for the list RA function in ra_serf
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <apr_uri.h>
+#include <serf.h>
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_ra.h"
+#include "svn_dav.h"
+#include "svn_xml.h"
+#include "svn_time.h"
+#include "svn_base64.h"
+#include "svn_private_config.h"
+
+#include "private/svn_dav_protocol.h"
+
+#include "../libsvn_ra/ra_loader.h"
+
+#include "ra_serf.h"
+
+
+
+typedef struct list_context_t {
+  /* parameters set by our caller */
+  const char *path;
+  svn_revnum_t revision;
+  const apr_array_header_t *patterns;
+  svn_depth_t depth;
+  apr_uint32_t dirent_fields;
+
+  /* dirent callback function/baton */
+  svn_ra_dirent_receiver_t receiver;
+  void *receiver_baton;
+
+} list_context_t;
+
+enum list_state_e {
+  INITIAL = XML_STATE_INITIAL,
+  REPORT,
+  ITEM,
+  PATH,
+  AUTHOR
+};
+
+#define D_ "DAV:"
+#define S_ SVN_XML_NAMESPACE
+static const svn_ra_serf__xml_transition_t list_ttable[] = {
+  { INITIAL, S_, SVN_DAV__LIST_REPORT, REPORT,
+    FALSE, { NULL }, FALSE },
+
+  { REPORT, S_, SVN_DAV__ITEM, ITEM,
+    FALSE, { "node-kind", "?size", "?has-props", "?created-rev", "?date",
+             NULL }, TRUE },
+
+  { ITEM, S_, SVN_DAV__PATH, PATH,
+    TRUE, { NULL }, TRUE },
+
+  { ITEM, D_, "creator-displayname", AUTHOR,
+    TRUE, { "?encoding", NULL }, TRUE },
+
+  { 0 }
+};
+
+/* The dirent fields we can request from the server, and their names. */
+static const struct {
+  apr_uint32_t field;
+  const char *name;
+} dirent_field_names[] = {
+  { SVN_DIRENT_KIND,        "kind" },
+  { SVN_DIRENT_SIZE,        "size" },
+  { SVN_DIRENT_HAS_PROPS,   "has-props" },
+  { SVN_DIRENT_CREATED_REV, "created-rev" },
+  { SVN_DIRENT_TIME,        "time" },
+  { SVN_DIRENT_LAST_AUTHOR, "last-author" },
+  { 0 }
+};
+
+
+/* Conforms to svn_ra_serf__xml_closed_t  */
+static svn_error_t *
+list_closed(svn_ra_serf__xml_estate_t *xes,
+            void *baton,
+            int leaving_state,
+            const svn_string_t *cdata,
+            apr_hash_t *attrs,
+            apr_pool_t *scratch_pool)
+{
+  list_context_t *list_ctx = baton;
+
+  if (leaving_state == ITEM)
+    {
+      const char *path = svn_hash_gets(attrs, "path");
+      const char *kind_word = svn_hash_gets(attrs, "node-kind");
+      const char *size = svn_hash_gets(attrs, "size");
+      const char *has_props = svn_hash_gets(attrs, "has-props");
+      const char *created_rev = svn_hash_gets(attrs, "created-rev");
+      const char *date = svn_hash_gets(attrs, "date");
+      svn_dirent_t dirent = { 0 };
+
+      if (!path)
+        return svn_error_create(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                                _("Missing path in list-report item"));
+
+      dirent.kind = svn_node_kind_from_word(kind_word);
+      dirent.size = SVN_INVALID_FILESIZE;
+      dirent.created_rev = SVN_INVALID_REVNUM;
+
+      if (size)
+        {
+          apr_int64_t size_val;
+
+          SVN_ERR(svn_cstring_atoi64(&size_val, size));
+          dirent.size = (svn_filesize_t)size_val;
+        }
+
+      if (has_props)
+        dirent.has_props = (strcmp(has_props, "true") == 0);
+
+      if (created_rev)
+        SVN_ERR(svn_revnum_parse(&dirent.created_rev, created_rev, NULL));
+
+      if (date)
+        SVN_ERR(svn_time_from_cstring(&dirent.time, date, scratch_pool));
+
+      dirent.last_author = svn_hash_gets(attrs, "author");
+
+      SVN_ERR(list_ctx->receiver(path, &dirent, list_ctx->receiver_baton,
+                                 scratch_pool));
+    }
+  else if (leaving_state == PATH)
+    {
+      SVN_ERR_ASSERT(cdata != NULL);
+
+      svn_ra_serf__xml_note(xes, ITEM, "path", cdata->data);
+    }
+  else if (leaving_state == AUTHOR)
+    {
+      const char *encoding = svn_hash_gets(attrs, "encoding");
+
+      SVN_ERR_ASSERT(cdata != NULL);
+
+      if (encoding)
+        {
+          /* Check for a known encoding type.  This is easy -- there's
+             only one.  */
+          if (strcmp(encoding, "base64") != 0)
+            return svn_error_createf(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                                     _("Unsupported encoding '%s'"),
+                                     encoding);
+
+          cdata = svn_base64_decode_string(cdata, scratch_pool);
+        }
+
+      svn_ra_serf__xml_note(xes, ITEM, "author", cdata->data);
+    }
+  else
+    SVN_ERR_MALFUNCTION();
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Implements svn_ra_serf__request_body_delegate_t */
+static svn_error_t *
+create_list_body(serf_bucket_t **body_bkt,
+                 void *baton,
+                 serf_bucket_alloc_t *alloc,
+                 apr_pool_t *pool /* request pool */,
+                 apr_pool_t *scratch_pool)
+{
+  serf_bucket_t *buckets;
+  list_context_t *list_ctx = baton;
+  int i;
+
+  buckets = serf_bucket_aggregate_create(alloc);
+
+  svn_ra_serf__add_open_tag_buckets(buckets, alloc,
+                                    "S:" SVN_DAV__LIST_REPORT,
+                                    "xmlns:S", SVN_XML_NAMESPACE,
+                                    SVN_VA_NULL);
+
+  svn_ra_serf__add_tag_buckets(buckets,
+                               "S:" SVN_DAV__PATH, list_ctx->path,
+                               alloc);
+
+  svn_ra_serf__add_tag_buckets(buckets,
+                               "S:" SVN_DAV__REVISION,
+                               apr_ltoa(pool, list_ctx->revision),
+                               alloc);
+
+  svn_ra_serf__add_tag_buckets(buckets,
+                               "S:" SVN_DAV__DEPTH,
+                               svn_depth_to_word(list_ctx->depth),
+                               alloc);
+
+  if (list_ctx->patterns)
+    for (i = 0; i < list_ctx->patterns->nelts; ++i)
+      svn_ra_serf__add_tag_buckets(buckets,
+                                   "S:" SVN_DAV__PATTERN,
+                                   APR_ARRAY_IDX(list_ctx->patterns, i,
+                                                 const char *),
+                                   alloc);
+
+  for (i = 0; dirent_field_names[i].name; ++i)
+    if (list_ctx->dirent_fields & dirent_field_names[i].field)
+      svn_ra_serf__add_tag_buckets(buckets,
+                                   "S:" SVN_DAV__DIRENT_FIELD,
+                                   dirent_field_names[i].name,
+                                   alloc);
+
+  svn_ra_serf__add_close_tag_buckets(buckets, alloc,
+                                     "S:" SVN_DAV__LIST_REPORT);
+
+  *body_bkt = buckets;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__list(svn_ra_session_t *ra_session,
+                  const char *path,
+                  svn_revnum_t revision,
+                  const apr_array_header_t *patterns,
+                  svn_depth_t depth,
+                  apr_uint32_t dirent_fields,
+                  svn_ra_dirent_receiver_t receiver,
+                  void *receiver_baton,
+                  apr_pool_t *scratch_pool)
+{
+  list_context_t *list_ctx;
+  svn_ra_serf__session_t *session = ra_session->priv;
+  svn_ra_serf__handler_t *handler;
+  svn_ra_serf__xml_context_t *xmlctx;
+  const char *req_url;
+  svn_error_t *err;
+
+  /* An empty pattern list matches nothing. */
+  if (patterns && patterns->nelts == 0)
+    return SVN_NO_ERROR;
+
+  list_ctx = apr_pcalloc(scratch_pool, sizeof(*list_ctx));
+  list_ctx->path = path;
+  list_ctx->revision = revision;
+  list_ctx->patterns = patterns;
+  list_ctx->depth = depth;
+  list_ctx->dirent_fields = dirent_fields;
+  list_ctx->receiver = receiver;
+  list_ctx->receiver_baton = receiver_baton;
+
+  SVN_ERR(svn_ra_serf__get_stable_url(&req_url, &list_ctx->revision,
+                                      session, NULL /* url */, revision,
+                                      scratch_pool, scratch_pool));
+
+  xmlctx = svn_ra_serf__xml_context_create(list_ttable,
+                                           NULL, list_closed, NULL,
+                                           list_ctx,
+                                           scratch_pool);
+  handler = svn_ra_serf__create_expat_handler(session, xmlctx, NULL,
+                                              scratch_pool);
+
+  handler->method = "REPORT";
+  handler->path = req_url;
+  handler->body_delegate = create_list_body;
+  handler->body_delegate_baton = list_ctx;
+  handler->body_type = "text/xml";
+
+  err = svn_ra_serf__context_run_one(handler, scratch_pool);
+
+  if (!err && handler->sline.code != 200)
+    err = svn_ra_serf__unexpected_status(handler);
+
+  if (err && (err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE))
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, err, NULL);
+
+  return svn_error_trace(err);
+}
@@ -693,6 +693,26 @@ retrieve_baseline_info(svn_revnum_t *actual_revision,
 }
 
 
+/* Back SESSION's baseline cache by a file, if that has been configured
+   and not been done yet.  Call this only after svn_ra_serf__discover_vcc,
+   which gives us the repository's identity.  */
+static svn_error_t *
+attach_persistent_blncache(svn_ra_serf__session_t *session,
+                           apr_pool_t *scratch_pool)
+{
+  if (session->blncache_dir && session->uuid && session->repos_root_str)
+    {
+      SVN_ERR(svn_ra_serf__blncache_attach_file(session->blncache,
+                                                session->blncache_dir,
+                                                session->uuid,
+                                                session->repos_root_str,
+                                                scratch_pool));
+      session->blncache_dir = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* For HTTPv1 servers, do a PROPFIND dance on the VCC to fetch the youngest
    revnum. If BASECOLL_URL is non-NULL, then the corresponding baseline
    collection URL is also returned.
@@ -712,6 +732,8 @@ v1_get_youngest_revnum(svn_revnum_t *youngest,
   const char *baseline_url;
   const char *bc_url;
 
+  SVN_ERR(attach_persistent_blncache(session, scratch_pool));
+
   /* Fetching DAV:checked-in from the VCC (with no Label: to specify a
      revision) will return the latest Baseline resource's URL.  */
   SVN_ERR(svn_ra_serf__fetch_dav_prop(&baseline_url, session, vcc_url,
@@ -813,6 +835,7 @@ get_baseline_info(const char **bc_url,
       const char *vcc_url;
 
       SVN_ERR(svn_ra_serf__discover_vcc(&vcc_url, session, scratch_pool));
+      SVN_ERR(attach_persistent_blncache(session, scratch_pool));
 
       if (SVN_IS_VALID_REVNUM(revision))
         {
@@ -82,6 +82,10 @@ typedef struct svn_ra_serf__connection_t {
 
   svn_ra_serf__session_t *session;
 
+  /* Number of update GETs on this connection whose responses turned out
+     to be large.  Used to keep small requests away from it. */
+  int large_fetches;
+
 } svn_ra_serf__connection_t;
 
 /** Maximum value we'll allow for the http-max-connections config option.
@@ -144,6 +148,9 @@ struct svn_ra_serf__session_t {
      requests may come in any order */
   svn_boolean_t http20;
 
+  /* Should we offer http/2 when negotiating TLS connections? */
+  svn_boolean_t http2_enabled;
+
   /* Should we use Transfer-Encoding: chunked for HTTP/1.1 servers. */
   svn_boolean_t using_chunked_requests;
 
@@ -243,6 +250,10 @@ struct svn_ra_serf__session_t {
 
   svn_ra_serf__blncache_t *blncache;
 
+  /* If not NULL, BLNCACHE still needs to be backed by a file in this
+     directory, once we know the repository UUID and root URL. */
+  const char *blncache_dir;
+
   /* Trisate flag that indicates user preference for using bulk updates
      (svn_tristate_true) with all the properties and content in the
      update-report response. If svn_tristate_false, request a skelta
@@ -269,6 +280,10 @@ struct svn_ra_serf__session_t {
   /* Indicates whether the server can understand svndiff version 2. */
   svn_boolean_t supports_svndiff2;
 
+  /* Indicates whether both, the server and this client, can handle
+     svndiff version 3. */
+  svn_boolean_t supports_svndiff3;
+
   /* Indicates whether the server sends the result checksum in the response
    * to a successful PUT request. */
   svn_boolean_t supports_put_result_checksum;
@@ -683,6 +698,8 @@ svn_ra_serf__create_handler(svn_ra_serf__session_t *session,
 
    The same BATON value will be passed to all three callbacks.
 
+   TTABLE is not copied and must remain valid as long as the context.
+
    The context will be created within RESULT_POOL.  */
 svn_ra_serf__xml_context_t *
 svn_ra_serf__xml_context_create(
@@ -743,6 +760,21 @@ svn_ra_serf__xml_note(svn_ra_serf__xml_estate_t *xes,
                       const char *value);
 
 
+/* Return the value of the attribute NAME on the element that caused the
+   transition into XES, or NULL if the element has no such attribute.
+   Attribute namespaces are ignored.
+
+   This may only be called from within the OPENED_CB for XES.  The value
+   is borrowed from the XML parser and becomes invalid once that callback
+   returns.  Unlike COLLECT_ATTRS in the transition table, this neither
+   copies the attributes nor puts them into a hash, which makes it the
+   cheaper choice for attributes that are only needed when the element
+   gets opened.  */
+const char *
+svn_ra_serf__xml_get_attr(svn_ra_serf__xml_estate_t *xes,
+                          const char *name);
+
+
 /* Returns XES->STATE_POOL for allocating structures that should live
    as long as the state identified by XES.
 
@@ -1232,6 +1264,15 @@ svn_ra_serf__stat(svn_ra_session_t *ra_session,
                   svn_dirent_t **dirent,
                   apr_pool_t *pool);
 
+/* Implements svn_ra__vtable_t.stat_many(). */
+svn_error_t *
+svn_ra_serf__stat_many(svn_ra_session_t *ra_session,
+                       apr_hash_t **dirents,
+                       const apr_array_header_t *paths,
+                       svn_revnum_t revision,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool);
+
 /* Implements svn_ra__vtable_t.get_locations(). */
 svn_error_t *
 svn_ra_serf__get_locations(svn_ra_session_t *session,
@@ -1487,6 +1528,18 @@ svn_error_t * svn_ra_serf__get_inherited_props(svn_ra_session_t *session,
                                                apr_pool_t *result_pool,
                                                apr_pool_t *scratch_pool);
 
+/* Implements the list RA layer function. */
+svn_error_t *
+svn_ra_serf__list(svn_ra_session_t *ra_session,
+                  const char *path,
+                  svn_revnum_t revision,
+                  const apr_array_header_t *patterns,
+                  svn_depth_t depth,
+                  apr_uint32_t dirent_fields,
+                  svn_ra_dirent_receiver_t receiver,
+                  void *receiver_baton,
+                  apr_pool_t *scratch_pool);
+
 /* Implements svn_ra__vtable_t.get_repos_root(). */
 svn_error_t *
 svn_ra_serf__get_repos_root(svn_ra_session_t *ra_session,
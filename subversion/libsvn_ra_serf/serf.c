@@ -164,6 +164,12 @@ load_config(svn_ra_serf__session_t *session,
   const char *exceptions;
   apr_port_t proxy_port;
   svn_tristate_t chunked_requests;
+  svn_boolean_t persistent_blncache;
+#ifdef SVN__SERF_TEST_HTTP2
+  svn_boolean_t http2_default = TRUE;
+#else
+  svn_boolean_t http2_default = FALSE;
+#endif
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
   apr_int64_t log_components;
   apr_int64_t log_level;
@@ -251,6 +257,18 @@ load_config(svn_ra_serf__session_t *session,
                                   SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS,
                                   "auto", svn_tristate_unknown));
 
+  /* Should we try to multiplex over http/2. */
+  SVN_ERR(svn_config_get_bool(config, &session->http2_enabled,
+                              SVN_CONFIG_SECTION_GLOBAL,
+                              SVN_CONFIG_OPTION_HTTP_HTTP2,
+                              http2_default));
+
+  /* Should baselines be remembered across sessions. */
+  SVN_ERR(svn_config_get_bool(config, &persistent_blncache,
+                              SVN_CONFIG_SECTION_GLOBAL,
+                              SVN_CONFIG_OPTION_HTTP_BASELINE_CACHE,
+                              FALSE));
+
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
   SVN_ERR(svn_config_get_int64(config, &log_components,
                                SVN_CONFIG_SECTION_GLOBAL,
@@ -318,6 +336,18 @@ load_config(svn_ra_serf__session_t *session,
                                       SVN_CONFIG_OPTION_HTTP_CHUNKED_REQUESTS,
                                       "auto", chunked_requests));
 
+      /* Should we try to multiplex over http/2. */
+      SVN_ERR(svn_config_get_bool(config, &session->http2_enabled,
+                                  server_group,
+                                  SVN_CONFIG_OPTION_HTTP_HTTP2,
+                                  session->http2_enabled));
+
+      /* Should baselines be remembered across sessions. */
+      SVN_ERR(svn_config_get_bool(config, &persistent_blncache,
+                                  server_group,
+                                  SVN_CONFIG_OPTION_HTTP_BASELINE_CACHE,
+                                  persistent_blncache));
+
 #if SERF_VERSION_AT_LEAST(1, 4, 0) && !defined(SVN_SERF_NO_LOGGING)
       SVN_ERR(svn_config_get_int64(config, &log_components,
                                    server_group,
@@ -349,6 +379,20 @@ load_config(svn_ra_serf__session_t *session,
     }
 #endif
 
+  /* The persistent baseline cache lives in the user's config area. */
+  session->blncache_dir = NULL;
+  if (persistent_blncache)
+    {
+      const char *config_dir = NULL;
+
+      if (session->auth_baton)
+        config_dir = svn_auth_get_parameter(session->auth_baton,
+                                            SVN_AUTH_PARAM_CONFIG_DIR);
+      SVN_ERR(svn_config_get_user_config_path(&session->blncache_dir,
+                                              config_dir, "baseline-cache",
+                                              result_pool));
+    }
+
   /* Don't allow the http-max-connections value to be larger than our
      compiled-in limit, or to be too small to operate.  Broken
      functionality and angry administrators are equally undesirable. */
@@ -758,6 +802,7 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   /* supports_rev_rsrc_replay */
   /* supports_svndiff1 */
   /* supports_svndiff2 */
+  /* supports_svndiff3 */
   /* supports_put_result_checksum */
   /* conn_latency */
 
@@ -1063,10 +1108,13 @@ static const svn_ra__vtable_t serf_vtable = {
   svn_ra_serf__get_deleted_rev,
   svn_ra_serf__get_inherited_props,
   NULL /* set_svn_ra_open */,
-  NULL /* svn_ra_list */,
+  svn_ra_serf__list,
   svn_ra_serf__register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
-  NULL /* replay_range_ev2 */
+  NULL /* replay_range_ev2 */,
+  svn_ra_serf__stat_many,
+  NULL /* get_file_blame */,
+  NULL /* get_log_search */
 };
 
 svn_error_t *
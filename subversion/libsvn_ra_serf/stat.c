@@ -616,3 +616,119 @@ svn_ra_serf__get_dir(svn_ra_session_t *ra_session,
 
   return SVN_NO_ERROR;
 }
+
+/* One PROPFIND request issued by svn_ra_serf__stat_many(). */
+typedef struct stat_request_t
+{
+  const char *relpath;
+  struct fill_dirent_baton_t fdb;
+  svn_ra_serf__handler_t *handler;
+} stat_request_t;
+
+/* Implements svn_ra__vtable_t.stat_many(). */
+svn_error_t *
+svn_ra_serf__stat_many(svn_ra_session_t *ra_session,
+                       apr_hash_t **dirents,
+                       const apr_array_header_t *paths,
+                       svn_revnum_t revision,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__session_t *session = ra_session->priv;
+  apr_interval_time_t waittime_left = session->timeout;
+  apr_array_header_t *requests;
+  const svn_ra_serf__dav_props_t *props;
+  apr_pool_t *iterpool;
+  int first = 0;
+  int i;
+
+  *dirents = apr_hash_make(result_pool);
+
+  /* Whether the server supports the deadprop-count property determines
+     which properties to ask for.  Let the first request find out. */
+  if (session->supports_deadprop_count == svn_tristate_unknown
+      && paths->nelts)
+    {
+      const char *relpath = APR_ARRAY_IDX(paths, 0, const char *);
+      svn_dirent_t *dirent;
+
+      SVN_ERR(svn_ra_serf__stat(ra_session, relpath, revision, &dirent,
+                                result_pool));
+      if (dirent)
+        svn_hash_sets(*dirents, apr_pstrdup(result_pool, relpath), dirent);
+
+      first = 1;
+    }
+
+  /* Queue all remaining requests at once, so that serf can pipeline
+     them and keep them in flight concurrently. */
+  props = get_dirent_props(SVN_DIRENT_ALL, session, scratch_pool);
+  requests = apr_array_make(scratch_pool, paths->nelts,
+                            sizeof(stat_request_t *));
+  for (i = first; i < paths->nelts; i++)
+    {
+      stat_request_t *rq = apr_pcalloc(scratch_pool, sizeof(*rq));
+      const char *url;
+
+      rq->relpath = APR_ARRAY_IDX(paths, i, const char *);
+      url = svn_path_url_add_component2(session->session_url.path,
+                                        rq->relpath, scratch_pool);
+      if (SVN_IS_VALID_REVNUM(revision))
+        SVN_ERR(svn_ra_serf__get_stable_url(&url, NULL, session, url,
+                                            revision,
+                                            scratch_pool, scratch_pool));
+
+      rq->fdb.entry = svn_dirent_create(result_pool);
+      rq->fdb.result_pool = result_pool;
+
+      SVN_ERR(svn_ra_serf__create_propfind_handler(&rq->handler, session,
+                                                   url, SVN_INVALID_REVNUM,
+                                                   "0", props,
+                                                   fill_dirent_propfunc,
+                                                   &rq->fdb, scratch_pool));
+
+      /* Missing paths are not an error here. */
+      rq->handler->no_fail_on_http_failure_status = TRUE;
+
+      svn_ra_serf__request_create(rq->handler);
+      APR_ARRAY_PUSH(requests, stat_request_t *) = rq;
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  while (TRUE)
+    {
+      svn_pool_clear(iterpool);
+
+      for (i = 0; i < requests->nelts; i++)
+        if (!APR_ARRAY_IDX(requests, i, stat_request_t *)->handler->done)
+          break;
+
+      if (i >= requests->nelts)
+        break; /* All requests done */
+
+      SVN_ERR(svn_ra_serf__context_run(session, &waittime_left, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  for (i = 0; i < requests->nelts; i++)
+    {
+      stat_request_t *rq = APR_ARRAY_IDX(requests, i, stat_request_t *);
+
+      if (rq->handler->sline.code == 404)
+        continue;
+
+      if (rq->handler->sline.code != 207)
+        {
+          if (rq->handler->server_error)
+            SVN_ERR(svn_ra_serf__server_error_create(rq->handler,
+                                                     scratch_pool));
+
+          return svn_error_trace(svn_ra_serf__unexpected_status(rq->handler));
+        }
+
+      svn_hash_sets(*dirents, apr_pstrdup(result_pool, rq->relpath),
+                    rq->fdb.entry);
+    }
+
+  return SVN_NO_ERROR;
+}
@@ -205,11 +205,12 @@ static const svn_ra_serf__xml_transition_t update_ttable[] = {
   { ADD_DIR, S_, "prop", PROP,
     FALSE, { NULL }, FALSE },
 
+  /* The base-checksum attribute is read in update_opened().  */
   { OPEN_FILE, S_, "txdelta", TXDELTA,
-    FALSE, { "?base-checksum" }, TRUE },
+    FALSE, { NULL }, TRUE },
 
   { ADD_FILE, S_, "txdelta", TXDELTA,
-    FALSE, { "?base-checksum" }, TRUE },
+    FALSE, { NULL }, TRUE },
 
   { OPEN_FILE, S_, "fetch-file", FETCH_FILE,
     FALSE, { "?base-checksum", "?sha1-checksum", NULL }, TRUE},
@@ -251,15 +252,38 @@ static const svn_ra_serf__xml_transition_t update_ttable[] = {
    can make the measurements quite imprecise.
 
    We measure outstanding requests as the sum of NUM_ACTIVE_FETCHES and
-   NUM_ACTIVE_PROPFINDS in the report_context_t structure.  */
+   NUM_ACTIVE_PROPFINDS in the report_context_t structure.
+
+   REQUEST_COUNT_TO_RESUME is only the initial value of REQUEST_WINDOW in
+   report_context_t.  Every REQUEST_WINDOW_INTERVAL, we compare the rate at
+   which requests complete with the previous rate and keep moving the window
+   by REQUEST_WINDOW_STEP in the same direction as long as the rate improves,
+   reversing otherwise.  On high-latency links this lets the window (and thus
+   the number of connections opened per REQS_PER_CONN) grow while a congested
+   server makes it shrink.  The rate counts received bytes plus a nominal
+   REQUEST_OVERHEAD_BYTES per request, so checkouts of many tiny files are
+   measured sensibly as well.  */
 #define REQUEST_COUNT_TO_PAUSE 50
 #define REQUEST_COUNT_TO_RESUME 40
 
+#define REQUEST_WINDOW_MIN 8
+#define REQUEST_WINDOW_MAX 64 /* REQS_PER_CONN for each possible connection */
+#define REQUEST_WINDOW_STEP 4
+#define REQUEST_WINDOW_INTERVAL apr_time_from_msec(250)
+#define REQUEST_OVERHEAD_BYTES 1024
+
+/* GET responses larger than this get their connection avoided for new
+   requests, so that small files don't queue up behind them. */
+#define LARGE_FETCH_SIZE 0x40000
+
 #define SPILLBUF_BLOCKSIZE 4096
 #define SPILLBUF_MAXBUFFSIZE 131072
 
 #define PARSE_CHUNK_SIZE 8000 /* Copied from xml.c ### Needs tuning */
 
+/* Amount of base64 encoded txdelta data to collect before decoding it. */
+#define TXDELTA_BUFFER_SIZE 16384
+
 /* Forward-declare our report context. */
 typedef struct report_context_t report_context_t;
 typedef struct body_create_baton_t body_create_baton_t;
@@ -354,6 +378,8 @@ typedef struct file_baton_t
 
   svn_stream_t *txdelta_stream;         /* Stream that feeds windows when
                                            written to within txdelta*/
+  svn_stringbuf_t *txdelta_buf;         /* Base64 data not yet written to
+                                           TXDELTA_STREAM */
 } file_baton_t;
 
 /*
@@ -382,6 +408,9 @@ typedef struct fetch_ctx_t {
   /* This is the amount of data that we have read so far. */
   apr_off_t read_size;
 
+  /* Is this fetch counted in its connection's LARGE_FETCHES? */
+  svn_boolean_t large;
+
   /* If we're writing this file to a stream, this will be non-NULL. */
   svn_stream_t *result_stream;
 
@@ -445,6 +474,19 @@ struct report_context_t {
   /* number of pending PROPFIND requests */
   unsigned int num_active_propfinds;
 
+  /* Resume parsing the REPORT response when fewer requests than this
+     are active.  Adapted over time, see REQUEST_COUNT_TO_RESUME. */
+  unsigned int request_window;
+
+  /* Direction in which we move REQUEST_WINDOW, +1 or -1. */
+  int window_direction;
+
+  /* Start of the current measurement interval, the work completed since
+     then and the rate measured over the previous interval. */
+  apr_time_t interval_start;
+  apr_off_t interval_work;
+  double last_rate;
+
   /* Are we done parsing the REPORT response? */
   svn_boolean_t done;
 
@@ -544,6 +586,52 @@ create_file_baton(file_baton_t **new_file,
   return SVN_NO_ERROR;
 }
 
+/* Account for a finished request that received BYTES of response data
+   and adapt CTX->REQUEST_WINDOW if a measurement interval has passed. */
+static void
+request_done(report_context_t *ctx,
+             apr_off_t bytes)
+{
+  apr_time_t now = apr_time_now();
+  apr_interval_time_t elapsed = now - ctx->interval_start;
+  double rate;
+  int window;
+
+  ctx->interval_work += bytes + REQUEST_OVERHEAD_BYTES;
+  if (elapsed < REQUEST_WINDOW_INTERVAL)
+    return;
+
+  rate = (double)ctx->interval_work / (double)elapsed;
+  if (rate < ctx->last_rate)
+    ctx->window_direction = -ctx->window_direction;
+
+  window = (int)ctx->request_window
+         + ctx->window_direction * REQUEST_WINDOW_STEP;
+  if (window < REQUEST_WINDOW_MIN)
+    {
+      window = REQUEST_WINDOW_MIN;
+      ctx->window_direction = 1;
+    }
+  else if (window > REQUEST_WINDOW_MAX)
+    {
+      window = REQUEST_WINDOW_MAX;
+      ctx->window_direction = -1;
+    }
+
+  ctx->request_window = window;
+  ctx->last_rate = rate;
+  ctx->interval_start = now;
+  ctx->interval_work = 0;
+}
+
+/* Is the number of active requests in CTX below the current window? */
+static svn_boolean_t
+below_request_window(const report_context_t *ctx)
+{
+  return (ctx->num_active_fetches + ctx->num_active_propfinds)
+            < ctx->request_window;
+}
+
 /** Minimum nr. of outstanding requests needed before a new connection is
  *  opened. */
 #define REQS_PER_CONN 8
@@ -555,6 +643,11 @@ create_file_baton(file_baton_t **new_file,
 static svn_error_t *
 open_connection_if_needed(svn_ra_serf__session_t *sess, int num_active_reqs)
 {
+  /* With http/2 all requests get multiplexed over the first connection,
+   * so another handshake would only cost time. */
+  if (sess->http20)
+    return SVN_NO_ERROR;
+
   /* For each REQS_PER_CONN outstanding requests open a new connection, with
    * a minimum of 1 extra connection. */
   if (sess->num_conns == 1 ||
@@ -592,6 +685,11 @@ get_best_connection(report_context_t *ctx)
   svn_ra_serf__connection_t *conn;
   int first_conn = 1;
 
+  /* Http/2 streams don't block each other, so the REPORT response can
+     share its connection with everything else. */
+  if (ctx->sess->http20)
+    return ctx->sess->conns[0];
+
   /* Skip the first connection if the REPORT response hasn't been completely
      received yet or if we're being told to limit our connections to
      2 (because this could be an attempt to ensure that we do all our
@@ -625,14 +723,18 @@ get_best_connection(report_context_t *ctx)
 
          The method used here selects the connection with the least amount of
          pending requests, thereby giving more work to lightly loaded server
-         processes.
+         processes.  Connections busy with a large response count as if
+         they had another window worth of requests pending, so that nothing
+         small has to wait until they are done.
        */
       int i, best_conn = first_conn;
       unsigned int min = INT_MAX;
       for (i = first_conn; i < ctx->sess->num_conns; i++)
         {
           serf_connection_t *sc = ctx->sess->conns[i]->conn;
-          unsigned int pending = serf_connection_pending_requests(sc);
+          unsigned int pending = serf_connection_pending_requests(sc)
+                               + ctx->sess->conns[i]->large_fetches
+                                   * ctx->request_window;
           if (pending < min)
             {
               min = pending;
@@ -836,6 +938,13 @@ cancel_fetch(serf_request_t *request,
           fetch_ctx->read_size = 0;
         }
 
+      /* The request may be requeued on another connection. */
+      if (fetch_ctx->large)
+        {
+          fetch_ctx->handler->conn->large_fetches--;
+          fetch_ctx->large = FALSE;
+        }
+
       return SVN_NO_ERROR;
     }
 
@@ -1021,6 +1130,12 @@ handle_fetch(serf_request_t *request,
 
       fetch_ctx->read_size += len;
 
+      if (!fetch_ctx->large && fetch_ctx->read_size > LARGE_FETCH_SIZE)
+        {
+          fetch_ctx->handler->conn->large_fetches++;
+          fetch_ctx->large = TRUE;
+        }
+
       if (fetch_ctx->aborted_read)
         {
           apr_off_t skip;
@@ -1158,6 +1273,7 @@ file_props_done(serf_request_t *request,
     return svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
   file->parent_dir->ctx->num_active_propfinds--;
+  request_done(file->parent_dir->ctx, 0);
 
   file->fetch_props = FALSE;
 
@@ -1190,6 +1306,13 @@ file_fetch_done(serf_request_t *request,
     return svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
   file->parent_dir->ctx->num_active_fetches--;
+  request_done(file->parent_dir->ctx, fetch_ctx->read_size);
+
+  if (fetch_ctx->large)
+    {
+      handler->conn->large_fetches--;
+      fetch_ctx->large = FALSE;
+    }
 
   file->fetch_file = FALSE;
 
@@ -1424,6 +1547,7 @@ dir_props_done(serf_request_t *request,
     return svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
   dir->ctx->num_active_propfinds--;
+  request_done(dir->ctx, 0);
 
   /* Closing the directory will automatically deliver the propfind props.
    *
@@ -1479,6 +1603,21 @@ fetch_for_dir(dir_baton_t *dir,
 
 /** XML callbacks for our update-report response parsing */
 
+/* Write the base64 data collected in FILE->TXDELTA_BUF to
+   FILE->TXDELTA_STREAM and empty the buffer. */
+static svn_error_t *
+flush_txdelta_buf(file_baton_t *file)
+{
+  apr_size_t len = file->txdelta_buf->len;
+
+  if (len)
+    SVN_ERR(svn_stream_write(file->txdelta_stream, file->txdelta_buf->data,
+                             &len));
+  svn_stringbuf_setempty(file->txdelta_buf);
+
+  return SVN_NO_ERROR;
+}
+
 /* Conforms to svn_ra_serf__xml_opened_t  */
 static svn_error_t *
 update_opened(svn_ra_serf__xml_estate_t *xes,
@@ -1646,8 +1785,7 @@ update_opened(svn_ra_serf__xml_estate_t *xes,
 
           file->fetch_file = FALSE;
 
-          attrs = svn_ra_serf__xml_gather_since(xes, entered_state);
-          base_checksum = svn_hash_gets(attrs, "base-checksum");
+          base_checksum = svn_ra_serf__xml_get_attr(xes, "base-checksum");
 
           if (base_checksum)
             SVN_ERR(svn_checksum_parse_hex(&file->base_md5_checksum,
@@ -1666,6 +1804,9 @@ update_opened(svn_ra_serf__xml_estate_t *xes,
                                                   file->pool);
 
               file->txdelta_stream = svn_base64_decode(decoder, file->pool);
+              file->txdelta_buf
+                = svn_stringbuf_create_ensure(TXDELTA_BUFFER_SIZE,
+                                              file->pool);
             }
         }
         break;
@@ -1958,6 +2099,7 @@ update_closed(svn_ra_serf__xml_estate_t *xes,
 
           if (file->txdelta_stream)
             {
+              SVN_ERR(flush_txdelta_buf(file));
               SVN_ERR(svn_stream_close(file->txdelta_stream));
               file->txdelta_stream = NULL;
             }
@@ -2036,7 +2178,14 @@ update_cdata(svn_ra_serf__xml_estate_t *xes,
   if (current_state == TXDELTA && ctx->cur_file
       && ctx->cur_file->txdelta_stream)
     {
-      SVN_ERR(svn_stream_write(ctx->cur_file->txdelta_stream, data, &len));
+      file_baton_t *file = ctx->cur_file;
+
+      /* Expat hands us the data in line-sized pieces.  Decoding it in
+         larger blocks lets the base64 decoder use its fast path and
+         saves many small writes to the svndiff parser. */
+      svn_stringbuf_appendbytes(file->txdelta_buf, data, len);
+      if (file->txdelta_buf->len >= TXDELTA_BUFFER_SIZE)
+        SVN_ERR(flush_txdelta_buf(file));
     }
 
   return SVN_NO_ERROR;
@@ -2250,8 +2399,7 @@ update_delay_handler(serf_request_t *request,
                                                     scratch_pool));
         }
 
-      while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-                 < REQUEST_COUNT_TO_RESUME)
+      while (below_request_window(udb->report))
         {
           const char *data;
           apr_size_t len;
@@ -2294,8 +2442,10 @@ update_delay_handler(serf_request_t *request,
             }
         }
 
-      /* Let's start using the spill infrastructure */
-      udb->spillbuf = svn_spillbuf__create(SPILLBUF_BLOCKSIZE,
+      /* Let's start using the spill infrastructure.  Spill in the
+         background, so that slow disks don't hold up the network. */
+      udb->spillbuf = svn_spillbuf__create_write_behind(
+                                           SPILLBUF_BLOCKSIZE,
                                            SPILLBUF_MAXBUFFSIZE,
                                            udb->report->pool);
     }
@@ -2334,8 +2484,7 @@ process_pending(update_delay_baton_t *udb,
   apr_pool_t *iterpool = NULL;
   serf_bucket_alloc_t *alloc = NULL;
 
-  while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-            < REQUEST_COUNT_TO_RESUME)
+  while (below_request_window(udb->report))
     {
       const char *data;
       apr_size_t len;
@@ -2605,6 +2754,10 @@ make_update_reporter(svn_ra_session_t *ra_session,
   report->editor_baton = update_baton;
   report->done = FALSE;
 
+  report->request_window = REQUEST_COUNT_TO_RESUME;
+  report->window_direction = 1;
+  report->interval_start = apr_time_now();
+
   *reporter = &ra_serf_reporter;
   *report_baton = report;
 
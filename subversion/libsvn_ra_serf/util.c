@@ -45,6 +45,7 @@
 #include "private/svn_fspath.h"
 #include "private/svn_auth_private.h"
 #include "private/svn_cert.h"
+#include "private/svn_subr_private.h"
 
 #include "ra_serf.h"
 
@@ -480,7 +481,7 @@ load_authorities(svn_ra_serf__connection_t *conn, const char *authorities,
   return SVN_NO_ERROR;
 }
 
-#if SERF_VERSION_AT_LEAST(1, 4, 0) && defined(SVN__SERF_TEST_HTTP2)
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
 /* Implements serf_ssl_protocol_result_cb_t */
 static apr_status_t
 conn_negotiate_protocol(void *data,
@@ -557,8 +558,11 @@ conn_setup(apr_socket_t *sock,
               SVN_ERR(load_authorities(conn, conn->session->ssl_authorities,
                                        conn->session->pool));
             }
-#if SERF_VERSION_AT_LEAST(1, 4, 0) && defined(SVN__SERF_TEST_HTTP2)
-          if (APR_SUCCESS ==
+#if SERF_VERSION_AT_LEAST(1, 4, 0)
+          /* Offer http/2 via ALPN.  Until the server picks a protocol
+             serf must not frame any requests. */
+          if (conn->session->http2_enabled
+              && APR_SUCCESS ==
                 serf_ssl_negotiate_protocol(conn->ssl_context, "h2,http/1.1",
                                             conn_negotiate_protocol, conn))
             {
@@ -2042,9 +2046,15 @@ svn_ra_serf__setup_svndiff_accept_encoding(serf_bucket_t *headers,
          to svndiff1 with a low latency connection (assuming the underlying
          network has high bandwidth), as it is faster and in this case, we
          don't care about worse compression ratio. */
-      serf_bucket_headers_setn(
-        headers, "Accept-Encoding",
-        "gzip,svndiff2;q=0.9,svndiff1;q=0.8,svndiff;q=0.7");
+      if (svn__zstd_supported())
+        serf_bucket_headers_setn(
+          headers, "Accept-Encoding",
+          "gzip,svndiff2;q=0.9,svndiff3;q=0.85,"
+          "svndiff1;q=0.8,svndiff;q=0.7");
+      else
+        serf_bucket_headers_setn(
+          headers, "Accept-Encoding",
+          "gzip,svndiff2;q=0.9,svndiff1;q=0.8,svndiff;q=0.7");
     }
   else
     {
@@ -2052,10 +2062,17 @@ svn_ra_serf__setup_svndiff_accept_encoding(serf_bucket_t *headers,
          svndiff2 is not a reasonable substitute for svndiff1 with default
          compression level, because, while it is faster, it also gives worse
          compression ratio.  While we can use svndiff2 in some cases (see
-         above), we can't do this generally. */
-      serf_bucket_headers_setn(
-        headers, "Accept-Encoding",
-        "gzip,svndiff1;q=0.9,svndiff2;q=0.8,svndiff;q=0.7");
+         above), we can't do this generally.  If we can read svndiff3,
+         prefer it over both, as zstd beats zlib in speed and ratio. */
+      if (svn__zstd_supported())
+        serf_bucket_headers_setn(
+          headers, "Accept-Encoding",
+          "gzip,svndiff3;q=0.95,svndiff1;q=0.9,"
+          "svndiff2;q=0.8,svndiff;q=0.7");
+      else
+        serf_bucket_headers_setn(
+          headers, "Accept-Encoding",
+          "gzip,svndiff1;q=0.9,svndiff2;q=0.8,svndiff;q=0.7");
     }
 }
 
@@ -125,6 +125,10 @@ struct svn_ra_serf__xml_estate_t {
   /* Any collected cdata. May be NULL if no cdata is being collected.  */
   svn_stringbuf_t *cdata;
 
+  /* The attributes of the element that opened this state, borrowed from
+     the parser.  Only set while the OPENED_CB is being called.  */
+  const char *const *raw_attrs;
+
   /* Previous/outer state.  */
   svn_ra_serf__xml_estate_t *prev;
 
@@ -621,6 +625,16 @@ svn_ra_serf__xml_note(svn_ra_serf__xml_estate_t *xes,
 }
 
 
+const char *
+svn_ra_serf__xml_get_attr(svn_ra_serf__xml_estate_t *xes,
+                          const char *name)
+{
+  SVN_ERR_ASSERT_NO_RETURN(xes->raw_attrs != NULL);
+
+  return svn_xml_get_attr_value(name, xes->raw_attrs);
+}
+
+
 apr_pool_t *
 svn_ra_serf__xml_state_pool(svn_ra_serf__xml_estate_t *xes)
 {
@@ -753,10 +767,20 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
       /* STATE_POOL remains NULL.  */
     }
 
-  /* Some basic copies to set up the new estate.  */
+  /* Some basic copies to set up the new estate.  Unless we matched a
+     wildcard, the tag equals the one in the (static) transition table and
+     we don't need to copy it.  */
   new_xes->state = scan->to_state;
-  new_xes->tag.name = apr_pstrdup(new_pool, elemname.name);
-  new_xes->tag.xmlns = apr_pstrdup(new_pool, elemname.xmlns);
+  if (*scan->name == '*')
+    {
+      new_xes->tag.name = apr_pstrdup(new_pool, elemname.name);
+      new_xes->tag.xmlns = apr_pstrdup(new_pool, elemname.xmlns);
+    }
+  else
+    {
+      new_xes->tag.name = scan->name;
+      new_xes->tag.xmlns = scan->ns;
+    }
   new_xes->custom_close = scan->custom_close;
 
   /* Start with the parent's namespace set.  */
@@ -769,9 +793,11 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
   if (xmlctx->opened_cb)
     {
       START_CALLBACK(xmlctx);
+      new_xes->raw_attrs = attrs;
       SVN_ERR(xmlctx->opened_cb(new_xes, xmlctx->baton,
                                 new_xes->state, &new_xes->tag,
                                 xmlctx->scratch_pool));
+      new_xes->raw_attrs = NULL;
       END_CALLBACK(xmlctx);
       svn_pool_clear(xmlctx->scratch_pool);
     }
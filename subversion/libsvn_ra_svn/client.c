@@ -629,6 +629,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   apr_uint64_t minver, maxver;
   svn_ra_svn__list_t *mechlist, *server_caplist, *repos_caplist;
   const char *client_string = NULL;
+  svn_boolean_t compress_stream;
   apr_pool_t *pool = result_pool;
   svn_ra_svn__parent_t *parent;
 
@@ -746,8 +747,14 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   /* In protocol version 2, we send back our protocol version, our
    * capability list, and the URL, and subsequently there is an auth
    * request. */
+  /* We want the whole stream compressed if the server offers that and
+   * we did not disable compression. */
+  compress_stream
+    = (   svn_ra_svn_compression_level(conn) > 0
+       && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_LZ4_STREAM));
+
   /* Client-side capabilities list: */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww)cc(?c)",
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww?ww)cc(?c)",
                                   (apr_uint64_t) 2,
                                   SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                   SVN_RA_SVN_CAP_SVNDIFF1,
@@ -756,9 +763,18 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                   SVN_RA_SVN_CAP_DEPTH,
                                   SVN_RA_SVN_CAP_MERGEINFO,
                                   SVN_RA_SVN_CAP_LOG_REVPROPS,
+                                  compress_stream
+                                    ? SVN_RA_SVN_CAP_LZ4_STREAM
+                                    : NULL,
+                                  svn__zstd_supported()
+                                    ? SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED
+                                    : NULL,
                                   url,
                                   SVN_RA_SVN__DEFAULT_USERAGENT,
                                   client_string));
+  if (compress_stream)
+    SVN_ERR(svn_ra_svn__enable_stream_compression(conn, pool));
+
   SVN_ERR(handle_auth_request(sess, pool));
 
   /* This is where the security layer would go into effect if we
@@ -1847,6 +1863,7 @@ perform_ra_svn_log(svn_error_t **outer_error,
                    svn_boolean_t strict_node_history,
                    svn_boolean_t include_merged_revisions,
                    const apr_array_header_t *revprops,
+                   const apr_array_header_t *search_patterns,
                    svn_log_entry_receiver_t receiver,
                    void *receiver_baton,
                    apr_pool_t *pool)
@@ -1895,17 +1912,37 @@ perform_ra_svn_log(svn_error_t **outer_error,
           else
             want_custom_revprops = TRUE;
         }
-      SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
+      SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)!"));
     }
   else
     {
-      SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!w())", "all-revprops"));
+      SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!w()!", "all-revprops"));
 
       want_author = TRUE;
       want_date = TRUE;
       want_message = TRUE;
       want_custom_revprops = TRUE;
     }
+  if (search_patterns)
+    {
+      int k;
+
+      SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!(!"));
+      for (i = 0; i < search_patterns->nelts; i++)
+        {
+          const apr_array_header_t *group
+            = APR_ARRAY_IDX(search_patterns, i, const apr_array_header_t *);
+
+          SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!(!"));
+          for (k = 0; k < group->nelts; k++)
+            SVN_ERR(svn_ra_svn__write_cstring(conn, pool,
+                                              APR_ARRAY_IDX(group, k,
+                                                            const char *)));
+          SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)!"));
+        }
+      SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)!"));
+    }
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)"));
 
   SVN_ERR(handle_auth_request(sess_baton, pool));
 
@@ -2094,7 +2131,48 @@ ra_svn_log(svn_ra_session_t *session,
                                            discover_changed_paths,
                                            strict_node_history,
                                            include_merged_revisions,
-                                           revprops,
+                                           revprops, NULL,
+                                           receiver, receiver_baton,
+                                           pool));
+  return svn_error_trace(
+            svn_error_compose_create(outer_error,
+                                     err));
+}
+
+static svn_error_t *
+ra_svn_log_search(svn_ra_session_t *session,
+                  const apr_array_header_t *paths,
+                  svn_revnum_t start, svn_revnum_t end,
+                  int limit,
+                  svn_boolean_t discover_changed_paths,
+                  svn_boolean_t strict_node_history,
+                  const apr_array_header_t *revprops,
+                  const apr_array_header_t *search_patterns,
+                  svn_log_entry_receiver_t receiver,
+                  void *receiver_baton, apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_error_t *outer_error = NULL;
+  svn_error_t *err;
+
+  /* Older servers would not know what to do with the patterns.  Our
+     caller filters the entries anyway. */
+  if (!svn_ra_svn_has_capability(sess_baton->conn, SVN_RA_SVN_CAP_LOG_SEARCH))
+    search_patterns = NULL;
+
+  if (paths)
+    paths = reparent_path_array(session, paths, pool);
+  else
+    SVN_ERR(ensure_exact_server_parent(session, pool));
+
+  err = svn_error_trace(perform_ra_svn_log(&outer_error,
+                                           session, paths,
+                                           start, end,
+                                           limit,
+                                           discover_changed_paths,
+                                           strict_node_history,
+                                           FALSE,
+                                           revprops, search_patterns,
                                            receiver, receiver_baton,
                                            pool));
   return svn_error_trace(
@@ -2133,21 +2211,13 @@ static svn_error_t *handle_unsupported_cmd(svn_error_t *err,
 }
 
 
-static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
-                                const char *path, svn_revnum_t rev,
-                                svn_dirent_t **dirent, apr_pool_t *pool)
+/* Parse the response LIST to a "stat" command and return the result
+   in *DIRENT, allocated in POOL. */
+static svn_error_t *
+parse_stat_response(svn_dirent_t **dirent,
+                    svn_ra_svn__list_t *list,
+                    apr_pool_t *pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
-  svn_ra_svn__list_t *list = NULL;
-  svn_dirent_t *the_dirent;
-
-  path = reparent_path(session, path, pool);
-  SVN_ERR(svn_ra_svn__write_cmd_stat(conn, pool, path, rev));
-  SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess_baton, pool),
-                                 N_("'stat' not implemented")));
-  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "(?l)", &list));
-
   if (! list)
     {
       *dirent = NULL;
@@ -2158,6 +2228,7 @@ static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
       svn_boolean_t has_props;
       svn_revnum_t crev;
       apr_uint64_t size;
+      svn_dirent_t *the_dirent;
 
       SVN_ERR(svn_ra_svn__parse_tuple(list, "wnbr(?c)(?c)",
                                       &kind, &size, &has_props,
@@ -2169,7 +2240,7 @@ static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
       the_dirent->has_props = has_props;
       the_dirent->created_rev = crev;
       SVN_ERR(svn_time_from_cstring(&the_dirent->time, cdate, pool));
-      the_dirent->last_author = cauthor;
+      the_dirent->last_author = apr_pstrdup(pool, cauthor);
 
       *dirent = the_dirent;
     }
@@ -2177,6 +2248,111 @@ static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
+                                const char *path, svn_revnum_t rev,
+                                svn_dirent_t **dirent, apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_ra_svn__list_t *list = NULL;
+
+  path = reparent_path(session, path, pool);
+  SVN_ERR(svn_ra_svn__write_cmd_stat(conn, pool, path, rev));
+  SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess_baton, pool),
+                                 N_("'stat' not implemented")));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "(?l)", &list));
+
+  return svn_error_trace(parse_stat_response(dirent, list, pool));
+}
+
+/* Return TRUE, if ERR indicates that CONN can no longer be used to
+   communicate with the server.  Any other error is a mere failure of
+   the respective command. */
+static svn_boolean_t
+is_connection_error(svn_error_t *err)
+{
+  return svn_error_find_cause(err, SVN_ERR_RA_SVN_CONNECTION_CLOSED)
+      || svn_error_find_cause(err, SVN_ERR_RA_SVN_IO_ERROR)
+      || svn_error_find_cause(err, SVN_ERR_RA_SVN_MALFORMED_DATA);
+}
+
+static svn_error_t *ra_svn_stat_many(svn_ra_session_t *session,
+                                     apr_hash_t **dirents,
+                                     const apr_array_header_t *paths,
+                                     svn_revnum_t rev,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_array_header_t *failed;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (!svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_PIPELINED_COMMANDS))
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL,
+                            _("Server does not support pipelined commands"));
+
+  /* Send all requests at once.  They go out with the first read. */
+  SVN_ERR(svn_ra_svn__write_cmd_pipeline(conn, scratch_pool, TRUE));
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      SVN_ERR(svn_ra_svn__write_cmd_stat(conn, scratch_pool,
+                                         reparent_path(session, path,
+                                                       scratch_pool),
+                                         rev));
+    }
+  SVN_ERR(svn_ra_svn__write_cmd_pipeline(conn, scratch_pool, FALSE));
+
+  /* Now, read the responses in the same order.  Remember the paths that
+     failed to retry them individually. */
+  *dirents = apr_hash_make(result_pool);
+  failed = apr_array_make(scratch_pool, 0, sizeof(const char *));
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_ra_svn__list_t *list = NULL;
+      svn_dirent_t *dirent;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+      err = handle_auth_request(sess_baton, iterpool);
+      if (!err)
+        err = svn_ra_svn__read_cmd_response(conn, iterpool, "(?l)", &list);
+
+      if (err && is_connection_error(err))
+        return svn_error_trace(err);
+
+      if (err)
+        {
+          svn_error_clear(err);
+          APR_ARRAY_PUSH(failed, const char *) = path;
+          continue;
+        }
+
+      SVN_ERR(parse_stat_response(&dirent, list, result_pool));
+      if (dirent)
+        svn_hash_sets(*dirents, apr_pstrdup(result_pool, path), dirent);
+    }
+
+  /* Commands that e.g. require authentication could not be completed
+     within the batch. */
+  for (i = 0; i < failed->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(failed, i, const char *);
+      svn_dirent_t *dirent;
+
+      SVN_ERR(ra_svn_stat(session, path, rev, &dirent, result_pool));
+      if (dirent)
+        svn_hash_sets(*dirents, apr_pstrdup(result_pool, path), dirent);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 static svn_error_t *ra_svn_get_locations(svn_ra_session_t *session,
                                          apr_hash_t **locations,
@@ -2460,6 +2636,85 @@ static svn_error_t *ra_svn_get_file_revs(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_get_file_blame(svn_ra_session_t *session,
+                                          const char *path,
+                                          svn_revnum_t start,
+                                          svn_revnum_t end,
+                                          const svn_diff_file_options_t *opts,
+                                          svn_ra__blame_receiver_t receiver,
+                                          void *receiver_baton,
+                                          apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  apr_array_header_t *diff_args;
+  apr_hash_t *all_rev_props;
+  apr_pool_t *iterpool;
+
+  if (!svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_FILE_BLAME))
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL,
+                            _("Server does not support computing blame"));
+
+  /* Pass the diff options in their command line form. */
+  diff_args = apr_array_make(scratch_pool, 3, sizeof(const char *));
+  if (opts->ignore_space == svn_diff_file_ignore_space_change)
+    APR_ARRAY_PUSH(diff_args, const char *) = "-b";
+  else if (opts->ignore_space == svn_diff_file_ignore_space_all)
+    APR_ARRAY_PUSH(diff_args, const char *) = "-w";
+  if (opts->ignore_eol_style)
+    APR_ARRAY_PUSH(diff_args, const char *) = "--ignore-eol-style";
+  if (opts->algorithm == svn_diff_algorithm_histogram)
+    APR_ARRAY_PUSH(diff_args, const char *) = "--histogram";
+
+  path = reparent_path(session, path, scratch_pool);
+  SVN_ERR(svn_ra_svn__write_cmd_get_file_blame(conn, scratch_pool, path,
+                                               start, end, diff_args));
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+
+  /* The server sends the revision properties only with the first chunk
+     of each revision. */
+  all_rev_props = apr_hash_make(scratch_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  while (1)
+    {
+      svn_ra_svn__item_t *item;
+      svn_ra_svn__list_t *proplist;
+      apr_uint64_t start_line;
+      svn_revnum_t rev;
+      apr_hash_t *rev_props = NULL;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      if (is_done_response(item))
+        break;
+      if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Blame entry not a list"));
+
+      SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "n(?r)l",
+                                      &start_line, &rev, &proplist));
+      if (SVN_IS_VALID_REVNUM(rev))
+        {
+          rev_props = apr_hash_get(all_rev_props, &rev, sizeof(rev));
+          if (!rev_props)
+            {
+              SVN_ERR(svn_ra_svn__parse_proplist(proplist, scratch_pool,
+                                                 &rev_props));
+              apr_hash_set(all_rev_props,
+                           apr_pmemdup(scratch_pool, &rev, sizeof(rev)),
+                           sizeof(rev), rev_props);
+            }
+        }
+
+      SVN_ERR(receiver(receiver_baton, (apr_int64_t) start_line, rev,
+                       rev_props, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_ra_svn__read_cmd_response(conn, scratch_pool,
+                                                       ""));
+}
+
 /* For each path in PATH_REVS, send a 'lock' command to the server.
    Used with 1.2.x series servers which support locking, but of only
    one path at a time.  ra_svn_lock(), which supports 'lock-many'
@@ -3284,7 +3539,10 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   ra_svn_list,
   ra_svn_register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
-  NULL /* replay_range_ev2 */
+  NULL /* replay_range_ev2 */,
+  ra_svn_stat_many,
+  ra_svn_get_file_blame,
+  ra_svn_log_search
 };
 
 svn_error_t *
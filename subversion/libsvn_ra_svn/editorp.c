@@ -351,12 +351,19 @@ static svn_error_t *ra_svn_apply_textdelta(void *file_baton,
   svn_stream_set_write(diff_stream, ra_svn_svndiff_handler);
   svn_stream_set_close(diff_stream, ra_svn_svndiff_close_handler);
 
-  /* If the connection does not support SVNDIFF1 or if we don't want to use
+  /* Prefer zstd-based svndiff3 if both sides support it.  If the
+   * connection does not support SVNDIFF1 either or if we don't want to use
    * compression, use the non-compressing "version 0" implementation */
  /* ### TODO: Check SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED and decide between
   * ###       svndiff1[at compression_level] and svndiff2 */
   if (   svn_ra_svn_compression_level(b->conn) > 0
-      && svn_ra_svn_has_capability(b->conn, SVN_RA_SVN_CAP_SVNDIFF1))
+      && svn__zstd_supported()
+      && svn_ra_svn_has_capability(b->conn,
+                                   SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED))
+    svn_txdelta_to_svndiff3(wh, wh_baton, diff_stream, 3,
+                            b->conn->compression_level, pool);
+  else if (   svn_ra_svn_compression_level(b->conn) > 0
+           && svn_ra_svn_has_capability(b->conn, SVN_RA_SVN_CAP_SVNDIFF1))
     svn_txdelta_to_svndiff3(wh, wh_baton, diff_stream, 1,
                             b->conn->compression_level, pool);
   else
@@ -582,7 +589,7 @@ ra_svn_handle_delete_entry(svn_ra_svn_conn_t *conn,
   SVN_ERR(svn_ra_svn__parse_tuple(params, "c(?r)s",
                                   &path, &rev, &token));
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
-  path = svn_relpath_canonicalize(path, pool);
+  path = svn_relpath__canonicalize_lazy(path, pool);
   SVN_CMD_ERR(ds->editor->delete_entry(path, rev, entry->baton, pool));
   return SVN_NO_ERROR;
 }
@@ -604,14 +611,14 @@ ra_svn_handle_add_dir(svn_ra_svn_conn_t *conn,
                                   &child_token, &copy_path, &copy_rev));
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
   subpool = svn_pool_create(entry->pool);
-  path = svn_relpath_canonicalize(path, pool);
+  path = svn_relpath__canonicalize_lazy(path, pool);
 
   /* Some operations pass COPY_PATH as a full URL (commits, etc.).
      Others (replay, e.g.) deliver an fspath.  That's ... annoying. */
   if (copy_path)
     {
       if (svn_path_is_url(copy_path))
-        copy_path = svn_uri_canonicalize(copy_path, pool);
+        copy_path = svn_uri__canonicalize_lazy(copy_path, pool);
       else
         copy_path = svn_fspath__canonicalize(copy_path, pool);
     }
@@ -639,7 +646,7 @@ ra_svn_handle_open_dir(svn_ra_svn_conn_t *conn,
                                   &child_token, &rev));
   SVN_ERR(lookup_token(ds, token, FALSE, &entry));
   subpool = svn_pool_create(entry->pool);
-  path = svn_relpath_canonicalize(path, pool);
+  path = svn_relpath__canonicalize_lazy(path, pool);
   SVN_CMD_ERR(ds->editor->open_directory(path, entry->baton, rev, subpool,
                                          &child_baton));
   store_token(ds, child_baton, child_token, FALSE, subpool);
@@ -729,7 +736,7 @@ ra_svn_handle_add_file(svn_ra_svn_conn_t *conn,
   if (copy_path)
     {
       if (svn_path_is_url(copy_path))
-        copy_path = svn_uri_canonicalize(copy_path, pool);
+        copy_path = svn_uri__canonicalize_lazy(copy_path, pool);
       else
         copy_path = svn_fspath__canonicalize(copy_path, pool);
     }
@@ -42,6 +42,7 @@
 #include "svn_ctype.h"
 #include "svn_sorts.h"
 #include "svn_time.h"
+#include "svn_io.h"
 
 #include "ra_svn.h"
 
@@ -215,6 +216,11 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
   conn->capabilities = apr_hash_make(result_pool);
   conn->compression_level = compression_level;
   conn->zero_copy_limit = zero_copy_limit;
+  conn->stream_compressed = FALSE;
+  conn->frame_buf = NULL;
+  conn->compressed_buf = NULL;
+  conn->decompressed = NULL;
+  conn->decompressed_pos = 0;
   conn->pool = result_pool;
 
   if (sock != NULL)
@@ -315,6 +321,14 @@ svn_ra_svn__set_block_handler(svn_ra_svn_conn_t *conn,
 svn_error_t *svn_ra_svn__data_available(svn_ra_svn_conn_t *conn,
                                        svn_boolean_t *data_available)
 {
+  /* Data of a compressed frame that we already received. */
+  if (   conn->stream_compressed
+      && conn->decompressed_pos < conn->decompressed->len)
+    {
+      *data_available = TRUE;
+      return SVN_NO_ERROR;
+    }
+
   return svn_ra_svn__stream_data_available(conn->stream, data_available);
 }
 
@@ -346,20 +360,14 @@ check_io_limits(svn_ra_svn_conn_t *conn)
 }
 
 /* Write data to socket or output file as appropriate. */
-static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                                    const char *data, apr_size_t len)
+static svn_error_t *raw_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                               const char *data, apr_size_t len)
 {
   const char *end = data + len;
   apr_size_t count;
   apr_pool_t *subpool = NULL;
   svn_ra_svn__session_baton_t *session = conn->session;
 
-  /* Limit the size of the response, if a limit has been configured.
-   * This is to limit the server load in case users e.g. accidentally ran
-   * an export on the root folder. */
-  conn->current_out += len;
-  SVN_ERR(check_io_limits(conn));
-
   while (data < end)
     {
       count = end - data;
@@ -389,12 +397,74 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
         }
     }
 
+  if (subpool)
+    svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+/* Maximum amount of uncompressed data per compressed frame. */
+#define MAX_FRAME_CONTENTS 0x100000
+
+/* Size of the frame header, which is the length of the compressed data in
+   network byte order. */
+#define FRAME_HEADER_SIZE 4
+
+/* Send LEN bytes at DATA as a sequence of LZ4 compressed frames. */
+static svn_error_t *compressed_output(svn_ra_svn_conn_t *conn,
+                                      apr_pool_t *pool,
+                                      const char *data, apr_size_t len)
+{
+  while (len > 0)
+    {
+      apr_size_t chunk = MIN(len, MAX_FRAME_CONTENTS);
+      apr_size_t frame_len;
+      unsigned char *header;
+
+      SVN_ERR(svn__compress_lz4(data, chunk, conn->compressed_buf));
+      frame_len = conn->compressed_buf->len;
+
+      /* Header and contents go out with a single write. */
+      svn_stringbuf_setempty(conn->frame_buf);
+      svn_stringbuf_ensure(conn->frame_buf, FRAME_HEADER_SIZE + frame_len);
+      header = (unsigned char *)conn->frame_buf->data;
+      header[0] = (unsigned char)(frame_len >> 24);
+      header[1] = (unsigned char)(frame_len >> 16);
+      header[2] = (unsigned char)(frame_len >> 8);
+      header[3] = (unsigned char)frame_len;
+      conn->frame_buf->len = FRAME_HEADER_SIZE;
+      svn_stringbuf_appendbytes(conn->frame_buf, conn->compressed_buf->data,
+                                frame_len);
+
+      SVN_ERR(raw_output(conn, pool, conn->frame_buf->data,
+                         conn->frame_buf->len));
+
+      data += chunk;
+      len -= chunk;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write data to socket or output file as appropriate, compressing it
+   if so negotiated. */
+static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                                    const char *data, apr_size_t len)
+{
+  /* Limit the size of the response, if a limit has been configured.
+   * This is to limit the server load in case users e.g. accidentally ran
+   * an export on the root folder. */
+  conn->current_out += len;
+  SVN_ERR(check_io_limits(conn));
+
+  if (conn->stream_compressed)
+    SVN_ERR(compressed_output(conn, pool, data, len));
+  else
+    SVN_ERR(raw_output(conn, pool, data, len));
+
   conn->written_since_error_check += len;
   conn->may_check_for_error
     = conn->written_since_error_check >= conn->error_check_interval;
 
-  if (subpool)
-    svn_pool_destroy(subpool);
   return SVN_NO_ERROR;
 }
 
@@ -472,6 +542,79 @@ static char *readbuf_drain(svn_ra_svn_conn_t *conn, char *data, char *end)
   return data + copylen;
 }
 
+/* Read exactly LEN bytes from CONN's stream into DATA. */
+static svn_error_t *raw_read_full(svn_ra_svn_conn_t *conn, char *data,
+                                  apr_size_t len)
+{
+  while (len > 0)
+    {
+      apr_size_t count = len;
+      SVN_ERR(svn_ra_svn__stream_read(conn->stream, data, &count));
+      data += count;
+      len -= count;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read up to *LEN bytes from CONN's stream into DATA, decompressing if
+   so negotiated.  Set *LEN to the actual number of bytes read. */
+static svn_error_t *conn_read(svn_ra_svn_conn_t *conn, char *data,
+                              apr_size_t *len)
+{
+  if (!conn->stream_compressed)
+    return svn_error_trace(svn_ra_svn__stream_read(conn->stream, data, len));
+
+  /* Fetch the next frame, skipping empty ones. */
+  while (conn->decompressed_pos == conn->decompressed->len)
+    {
+      unsigned char header[FRAME_HEADER_SIZE];
+      apr_size_t frame_len;
+
+      SVN_ERR(raw_read_full(conn, (char *)header, sizeof(header)));
+      frame_len = ((apr_size_t)header[0] << 24)
+                | ((apr_size_t)header[1] << 16)
+                | ((apr_size_t)header[2] << 8)
+                | (apr_size_t)header[3];
+
+      /* No valid frame can get that large even if compression failed. */
+      if (frame_len > MAX_FRAME_CONTENTS + SVN__MAX_ENCODED_UINT_LEN)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Compressed frame too large"));
+
+      /* FRAME_BUF may still be in use by a partial write. */
+      svn_stringbuf_ensure(conn->compressed_buf, frame_len);
+      SVN_ERR(raw_read_full(conn, conn->compressed_buf->data, frame_len));
+      SVN_ERR(svn__decompress_lz4(conn->compressed_buf->data, frame_len,
+                                  conn->decompressed, MAX_FRAME_CONTENTS));
+      conn->decompressed_pos = 0;
+    }
+
+  *len = MIN(*len, conn->decompressed->len - conn->decompressed_pos);
+  memcpy(data, conn->decompressed->data + conn->decompressed_pos, *len);
+  conn->decompressed_pos += *len;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_svn__enable_stream_compression(svn_ra_svn_conn_t *conn,
+                                      apr_pool_t *pool)
+{
+  /* Whatever has been written so far is not part of the compressed
+   * stream. */
+  if (conn->write_pos)
+    SVN_ERR(writebuf_flush(conn, pool));
+
+  conn->frame_buf = svn_stringbuf_create_empty(conn->pool);
+  conn->compressed_buf = svn_stringbuf_create_empty(conn->pool);
+  conn->decompressed = svn_stringbuf_create_empty(conn->pool);
+  conn->decompressed_pos = 0;
+  conn->stream_compressed = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
 /* Read data from socket or input file as appropriate. */
 static svn_error_t *readbuf_input(svn_ra_svn_conn_t *conn, char *data,
                                   apr_size_t *len, apr_pool_t *pool)
@@ -487,7 +630,7 @@ static svn_error_t *readbuf_input(svn_ra_svn_conn_t *conn, char *data,
   SVN_ERR(check_io_limits(conn));
 
   /* Actually fill the buffer. */
-  SVN_ERR(svn_ra_svn__stream_read(conn->stream, data, len));
+  SVN_ERR(conn_read(conn, data, len));
   if (*len == 0)
     return svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL, NULL);
   conn->current_in += *len;
@@ -518,7 +661,7 @@ static svn_error_t *readbuf_skip(svn_ra_svn_conn_t *conn, apr_uint64_t len)
       break;
 
     buflen = sizeof(conn->read_buf);
-    SVN_ERR(svn_ra_svn__stream_read(conn->stream, conn->read_buf, &buflen));
+    SVN_ERR(conn_read(conn, conn->read_buf, &buflen));
     if (buflen == 0)
       return svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL, NULL);
 
@@ -744,6 +887,101 @@ svn_ra_svn__write_string(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Send LEN bytes from FILE, starting at OFFSET, directly to SOCK without
+ * copying them through user space.  Use POOL for temporary allocations. */
+#if APR_HAS_SENDFILE
+static svn_error_t *
+sendfile_output(svn_ra_svn_conn_t *conn,
+                apr_pool_t *pool,
+                apr_socket_t *sock,
+                apr_file_t *file,
+                apr_off_t offset,
+                apr_size_t len)
+{
+  apr_pool_t *subpool = NULL;
+
+  conn->current_out += len;
+  SVN_ERR(check_io_limits(conn));
+
+  while (len > 0)
+    {
+      apr_size_t count = len;
+      apr_off_t off = offset;
+      apr_status_t status = apr_socket_sendfile(sock, file, NULL, &off,
+                                                &count, 0);
+
+      if (status && !APR_STATUS_IS_EAGAIN(status))
+        return svn_error_wrap_apr(status, _("Can't write to connection"));
+
+      if (count == 0)
+        {
+          if (!subpool)
+            subpool = svn_pool_create(pool);
+          else
+            svn_pool_clear(subpool);
+          SVN_ERR(conn->block_handler(conn, subpool, conn->block_baton));
+        }
+
+      offset += count;
+      len -= count;
+      conn->written_since_error_check += count;
+    }
+
+  conn->may_check_for_error
+    = conn->written_since_error_check >= conn->error_check_interval;
+
+  if (subpool)
+    svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+#endif
+
+svn_error_t *
+svn_ra_svn__write_file_range(svn_ra_svn_conn_t *conn,
+                             apr_pool_t *pool,
+                             apr_file_t *file,
+                             apr_off_t offset,
+                             apr_size_t len)
+{
+#if APR_HAS_SENDFILE
+  /* Compressed data can't be sent straight from the file. */
+  apr_socket_t *sock = conn->stream_compressed
+                     ? NULL
+                     : svn_ra_svn__stream_socket(conn->stream);
+#endif
+
+  SVN_ERR(write_number(conn, pool, len, ':'));
+
+#if APR_HAS_SENDFILE
+  if (sock)
+    {
+      /* Everything we buffered so far must precede the file contents. */
+      if (conn->write_pos > 0)
+        SVN_ERR(writebuf_flush(conn, pool));
+
+      SVN_ERR(sendfile_output(conn, pool, sock, file, offset, len));
+    }
+  else
+#endif
+    {
+      char *buffer = apr_palloc(pool, SVN__STREAM_CHUNK_SIZE);
+
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+      while (len > 0)
+        {
+          apr_size_t count = MIN(len, SVN__STREAM_CHUNK_SIZE);
+
+          SVN_ERR(svn_io_file_read_full2(file, buffer, count, NULL, NULL,
+                                         pool));
+          SVN_ERR(writebuf_write(conn, pool, buffer, count));
+          len -= count;
+        }
+    }
+
+  SVN_ERR(writebuf_writechar(conn, pool, ' '));
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_svn__write_cstring(svn_ra_svn_conn_t *conn,
                           apr_pool_t *pool,
@@ -1325,8 +1563,10 @@ static svn_error_t *read_item(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
     }
   else if (svn_ctype_isalpha(c))
     {
-      /* It's a word.  Read it into a buffer of limited size. */
-      char *buffer = apr_palloc(pool, MAX_WORD_LENGTH + 1);
+      /* It's a word.  Read it into a buffer of limited size.  Most words
+       * are much shorter than that, so only their actual length will be
+       * copied into POOL. */
+      char buffer[MAX_WORD_LENGTH + 1];
       char *end = buffer + MAX_WORD_LENGTH;
       char *p = buffer + 1;
 
@@ -1370,7 +1610,7 @@ static svn_error_t *read_item(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 
       /* Store the word in ITEM. */
       item->kind = SVN_RA_SVN_WORD;
-      item->u.word.data = buffer;
+      item->u.word.data = apr_pstrmemdup(pool, buffer, p - buffer);
       item->u.word.len = p - buffer;
     }
   else if (c == '(')
@@ -1919,6 +2159,10 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
   command = svn_hash_gets(cmd_hash, cmdname);
   if (command)
     {
+      svn_trace__span_t *span = svn_trace__span_begin("ra_svn command",
+                                                      pool);
+      svn_trace__span_attr(span, "command", cmdname);
+
       /* Call the standard command handler.
        * If that is not set, then this is a lecagy API call and we invoke
        * the legacy command handler. */
@@ -1940,6 +2184,7 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
        * So, check again for the limit violations and exit the command
        * processing quickly if we may have truncated data. */
       err = svn_error_compose_create(check_io_limits(conn), err);
+      svn_trace__span_end(span);
 
       *terminate = command->terminate;
     }
@@ -2565,6 +2810,18 @@ svn_ra_svn__write_cmd_stat(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__write_cmd_pipeline(svn_ra_svn_conn_t *conn,
+                               apr_pool_t *pool,
+                               svn_boolean_t pipelined)
+{
+  SVN_ERR(writebuf_write_literal(conn, pool, "( pipeline ( "));
+  SVN_ERR(write_tuple_boolean(conn, pool, pipelined));
+  SVN_ERR(writebuf_write_literal(conn, pool, ") ) "));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_svn__write_cmd_get_file_revs(svn_ra_svn_conn_t *conn,
                                     apr_pool_t *pool,
@@ -2587,6 +2844,34 @@ svn_ra_svn__write_cmd_get_file_revs(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__write_cmd_get_file_blame(svn_ra_svn_conn_t *conn,
+                                     apr_pool_t *pool,
+                                     const char *path,
+                                     svn_revnum_t start,
+                                     svn_revnum_t end,
+                                     const apr_array_header_t *diff_args)
+{
+  int i;
+
+  SVN_ERR(writebuf_write_literal(conn, pool, "( get-file-blame ( "));
+  SVN_ERR(write_tuple_cstring(conn, pool, path));
+  SVN_ERR(write_tuple_start_list(conn, pool));
+  SVN_ERR(write_tuple_revision_opt(conn, pool, start));
+  SVN_ERR(write_tuple_end_list(conn, pool));
+  SVN_ERR(write_tuple_start_list(conn, pool));
+  SVN_ERR(write_tuple_revision_opt(conn, pool, end));
+  SVN_ERR(write_tuple_end_list(conn, pool));
+  SVN_ERR(write_tuple_start_list(conn, pool));
+  for (i = 0; i < diff_args->nelts; i++)
+    SVN_ERR(write_tuple_cstring(conn, pool,
+                                APR_ARRAY_IDX(diff_args, i, const char *)));
+  SVN_ERR(write_tuple_end_list(conn, pool));
+  SVN_ERR(writebuf_write_literal(conn, pool, ") ) "));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_svn__write_cmd_lock(svn_ra_svn_conn_t *conn,
                            apr_pool_t *pool,
@@ -115,6 +115,17 @@ struct svn_ra_svn_conn_st {
   int compression_level;
   apr_size_t zero_copy_limit;
 
+  /* If set, all data gets sent and received as LZ4 compressed frames
+     (see svn_ra_svn__enable_stream_compression).  FRAME_BUF holds the
+     frame being sent, COMPRESSED_BUF the compressed data being produced
+     or received and DECOMPRESSED the contents of the last received frame,
+     of which the first DECOMPRESSED_POS bytes have been consumed. */
+  svn_boolean_t stream_compressed;
+  svn_stringbuf_t *frame_buf;
+  svn_stringbuf_t *compressed_buf;
+  svn_stringbuf_t *decompressed;
+  apr_size_t decompressed_pos;
+
   /* who's on the other side of the connection? */
   char *remote_ip;
 
@@ -235,6 +246,10 @@ svn_error_t *svn_ra_svn__read_command_only(svn_ra_svn_conn_t *conn,
                                            apr_pool_t *pool,
                                            const char **command);
 
+/* Return the socket that STREAM writes to without any further processing
+ * such as encryption, or NULL if there is no such socket. */
+apr_socket_t *svn_ra_svn__stream_socket(svn_ra_svn__stream_t *stream);
+
 /* Set the timeout for operations on STREAM to INTERVAL. */
 void svn_ra_svn__stream_timeout(svn_ra_svn__stream_t *stream,
                                 apr_interval_time_t interval);
@@ -140,8 +140,10 @@ synchronized_authz_initialize(void *baton, apr_pool_t *pool)
   svn_boolean_t multi_threaded = FALSE;
 #endif
 
-  SVN_ERR(svn_object_pool__create(&authz_pool, multi_threaded, pool));
-  SVN_ERR(svn_object_pool__create(&filtered_pool, multi_threaded, pool));
+  SVN_ERR(svn_object_pool__create(&authz_pool, multi_threaded, FALSE,
+                                  pool));
+  SVN_ERR(svn_object_pool__create(&filtered_pool, multi_threaded, FALSE,
+                                  pool));
 
   return SVN_NO_ERROR;
 }
@@ -251,14 +253,36 @@ typedef struct node_pattern_t
 
   /* If not NULL, the segments of all sorted_pattern_t in this array contain
    * wildcards and don't fit into any of the above categories.
-   * The NEXT members of the elements will not be used. */
+   * The NEXT members of the elements will not be used.
+   *
+   * Once the tree has been finalized, this only contains the patterns that
+   * start with a wildcard.  All others have been moved to COMPLEX_HEADS. */
   apr_array_header_t *complex;
 
+  /* If not NULL, this contains all complex_head_t for the "complex"
+   * patterns that start with some literal text.  Sorted by that text. */
+  apr_array_header_t *complex_heads;
+
   /* This node itself is a "**" segment and must therefore itself be added
    * to the matching node list for the next level. */
   svn_boolean_t repeat;
 } node_pattern_t;
 
+/* Group of "complex" patterns that all start with the same literal HEAD.
+ * Since HEAD must be a prefix of any matching segment, these are being
+ * linked and looked up just like prefix patterns are. */
+typedef struct complex_head_t
+{
+  /* The literal text up to the first wildcard or escape sequence. */
+  svn_string_t head;
+
+  /* The node_t * for all patterns starting with HEAD. */
+  apr_array_header_t *nodes;
+
+  /* Entry whose HEAD is a prefix to this one's or NULL. */
+  struct complex_head_t *next;
+} complex_head_t;
+
 /* The pattern tree.  All relevant path rules are being folded into this
  * prefix tree, with a single, whole segment stored at each node.  The whole
  * tree applies to a single user only.
@@ -339,6 +363,19 @@ compare_node_path_segment(const void *void_lhs,
   return strcmp(element->node->segment.data, segment);
 }
 
+/* compare_func comparing complex pattern heads. It takes a complex_head_t*
+ * as VOID_LHS and a const char * as VOID_RHS.
+ */
+static int
+compare_complex_head(const void *void_lhs,
+                     const void *void_rhs)
+{
+  const complex_head_t *element = void_lhs;
+  const char *head = void_rhs;
+
+  return strcmp(element->head.data, head);
+}
+
 /* Make sure a node_t* for SEGMENT exists in *ARRAY and return it.
  * Auto-create either if they don't exist.  Entries in *ARRAY are
  * sorted by their segment strings.
@@ -747,14 +784,17 @@ trim_tree(node_t *node,
 static void
 finalize_tree(node_t *node,
               limited_rights_t *sum,
+              apr_pool_t *result_pool,
               apr_pool_t *scratch_pool);
 
 /* Call finalize_tree() on all elements in the HASH of node_t *, passing
- * SUM along. HASH may be NULL. Use SCRATCH_POOL for temporary allocations.
+ * SUM along. HASH may be NULL. Allocate lookup structures in RESULT_POOL
+ * and use SCRATCH_POOL for temporary allocations.
  */
 static void
 finalize_subnode_hash(apr_hash_t *hash,
                       limited_rights_t *sum,
+                      apr_pool_t *result_pool,
                       apr_pool_t *scratch_pool)
 {
   if (hash)
@@ -763,17 +803,18 @@ finalize_subnode_hash(apr_hash_t *hash,
       for (hi = apr_hash_first(scratch_pool, hash);
            hi;
            hi = apr_hash_next(hi))
-        finalize_tree(apr_hash_this_val(hi), sum, scratch_pool);
+        finalize_tree(apr_hash_this_val(hi), sum, result_pool, scratch_pool);
     }
 }
 
 /* Call finalize_up_tree() on all elements in the ARRAY of node_t *,
- * passing SUM along.  ARRAY may be NULL.  Use SCRATCH_POOL for temporary
- * allocations.
+ * passing SUM along.  ARRAY may be NULL.  Allocate lookup structures in
+ * RESULT_POOL and use SCRATCH_POOL for temporary allocations.
  */
 static void
 finalize_subnode_array(apr_array_header_t *array,
                        limited_rights_t *sum,
+                       apr_pool_t *result_pool,
                        apr_pool_t *scratch_pool)
 {
   if (array)
@@ -781,7 +822,7 @@ finalize_subnode_array(apr_array_header_t *array,
       int i;
       for (i = 0; i < array->nelts; ++i)
         finalize_tree(APR_ARRAY_IDX(array, i, sorted_pattern_t).node, sum,
-                      scratch_pool);
+                      result_pool, scratch_pool);
     }
 }
 
@@ -820,13 +861,120 @@ link_prefix_patterns(apr_array_header_t *array)
     }
 }
 
+/* Return the length of the literal text at the start of the fnmatch
+ * PATTERN, i.e. up to the first wildcard or escape sequence. */
+static apr_size_t
+literal_head_len(const char *pattern)
+{
+  apr_size_t len;
+  for (len = 0; pattern[len]; ++len)
+    if (   pattern[len] == '*' || pattern[len] == '?'
+        || pattern[len] == '[' || pattern[len] == '\\')
+      break;
+
+  return len;
+}
+
+/* Link the complex_head_t within the sorted ARRAY that are prefixes of
+ * one another.  This is the equivalent of link_prefix_patterns(). */
+static void
+link_complex_heads(apr_array_header_t *array)
+{
+  int i;
+  for (i = 1; i < array->nelts; ++i)
+    {
+      complex_head_t *prev = &APR_ARRAY_IDX(array, i - 1, complex_head_t);
+      complex_head_t *entry = &APR_ARRAY_IDX(array, i, complex_head_t);
+
+      if (prev->head.data[0] != entry->head.data[0])
+        continue;
+
+      for ( ; prev; prev = prev->next)
+        if (   prev->head.len < entry->head.len
+            && !memcmp(prev->head.data, entry->head.data, prev->head.len))
+          {
+            entry->next = prev;
+            break;
+          }
+    }
+}
+
+/* Move all complex patterns in PATTERNS that start with some literal text
+ * into the COMPLEX_HEADS index, allocated in RESULT_POOL.  With thousands
+ * of such rules, lookup() then only has to fnmatch those few whose heads
+ * are actually a prefix of the respective path segment. */
+static void
+index_complex_patterns(node_pattern_t *patterns,
+                       apr_pool_t *result_pool)
+{
+  apr_array_header_t *headless = NULL;
+  apr_array_header_t *heads = NULL;
+  int i;
+
+  if (!patterns->complex)
+    return;
+
+  for (i = 0; i < patterns->complex->nelts; ++i)
+    {
+      sorted_pattern_t *pattern
+        = &APR_ARRAY_IDX(patterns->complex, i, sorted_pattern_t);
+      node_t *node = pattern->node;
+      apr_size_t len = literal_head_len(node->segment.data);
+      const char *head;
+      complex_head_t *entry;
+      int idx;
+
+      if (len == 0)
+        {
+          if (!headless)
+            headless = apr_array_make(result_pool, 4,
+                                      sizeof(sorted_pattern_t));
+          APR_ARRAY_PUSH(headless, sorted_pattern_t) = *pattern;
+          continue;
+        }
+
+      if (!heads)
+        heads = apr_array_make(result_pool, 4, sizeof(complex_head_t));
+
+      head = apr_pstrmemdup(result_pool, node->segment.data, len);
+      idx = svn_sort__bsearch_lower_bound(heads, head, compare_complex_head);
+      if (   idx < heads->nelts
+          && !strcmp(APR_ARRAY_IDX(heads, idx, complex_head_t).head.data,
+                     head))
+        {
+          entry = &APR_ARRAY_IDX(heads, idx, complex_head_t);
+        }
+      else
+        {
+          complex_head_t new_entry;
+          new_entry.head.data = head;
+          new_entry.head.len = len;
+          new_entry.nodes = apr_array_make(result_pool, 1, sizeof(node_t *));
+          new_entry.next = NULL;
+          svn_sort__array_insert(heads, &new_entry, idx);
+
+          entry = &APR_ARRAY_IDX(heads, idx, complex_head_t);
+        }
+
+      APR_ARRAY_PUSH(entry->nodes, node_t *) = node;
+    }
+
+  if (heads)
+    link_complex_heads(heads);
+
+  patterns->complex = headless;
+  patterns->complex_heads = heads;
+}
+
 /* Recursively finalization the tree node properties for NODE.  Update SUM
  * (of NODE's parent) by combining it with the recursive access rights info
- * on NODE.  Use SCRATCH_POOL for temporary allocations.
+ * on NODE.  Allocate lookup structures in RESULT_POOL and use SCRATCH_POOL
+ * for temporary allocations.
  */
 static void
 finalize_tree(node_t *node,
               limited_rights_t *sum,
+              apr_pool_t *result_pool,
               apr_pool_t *scratch_pool)
 {
   limited_rights_t *local_sum = &node->rights;
@@ -848,23 +996,27 @@ finalize_tree(node_t *node,
     }
 
   /* Process all sub-nodes. */
-  finalize_subnode_hash(node->sub_nodes, local_sum, scratch_pool);
+  finalize_subnode_hash(node->sub_nodes, local_sum, result_pool,
+                        scratch_pool);
 
   if (node->pattern_sub_nodes)
     {
-      finalize_tree(node->pattern_sub_nodes->any, local_sum, scratch_pool);
-      finalize_tree(node->pattern_sub_nodes->any_var, local_sum, scratch_pool);
+      finalize_tree(node->pattern_sub_nodes->any, local_sum, result_pool,
+                    scratch_pool);
+      finalize_tree(node->pattern_sub_nodes->any_var, local_sum, result_pool,
+                    scratch_pool);
 
       finalize_subnode_array(node->pattern_sub_nodes->prefixes, local_sum,
-                             scratch_pool);
+                             result_pool, scratch_pool);
       finalize_subnode_array(node->pattern_sub_nodes->suffixes, local_sum,
-                             scratch_pool);
+                             result_pool, scratch_pool);
       finalize_subnode_array(node->pattern_sub_nodes->complex, local_sum,
-                             scratch_pool);
+                             result_pool, scratch_pool);
 
-      /* Link up the prefixes / suffixes. */
+      /* Link up the prefixes / suffixes and index the complex patterns. */
       link_prefix_patterns(node->pattern_sub_nodes->prefixes);
       link_prefix_patterns(node->pattern_sub_nodes->suffixes);
+      index_complex_patterns(node->pattern_sub_nodes, result_pool);
     }
 
   /* Add our min / max info to the parent's info.
@@ -954,10 +1106,11 @@ create_user_authz(authz_full_t *authz,
    * node itself.
    *
    * To prevent additional finalization passes, we piggy-back the addition
-   * of the ordering links of the prefix and suffix sub-node rules.
+   * of the ordering links of the prefix and suffix sub-node rules as well
+   * as the index of complex patterns.
    */
   svn_pool_clear(subpool);
-  finalize_tree(root, &root->rights, subpool);
+  finalize_tree(root, &root->rights, result_pool, subpool);
 
   /* Done. */
   svn_pool_destroy(subpool);
@@ -967,6 +1120,22 @@ create_user_authz(authz_full_t *authz,
 
 /*** Lookup. ***/
 
+/* Snapshot of a lookup_state_t after following one more segment of its
+ * PARENT_PATH.  Restoring it allows a lookup to continue from any ancestor
+ * of the previous lookup's path instead of only from its immediate parent.
+ */
+typedef struct lookup_frame_t
+{
+  /* Length of the PARENT_PATH prefix that this frame applies to. */
+  apr_size_t path_len;
+
+  /* Rights that apply at that path. */
+  limited_rights_t rights;
+
+  /* Nodes applying to that path, i.e. the CURRENT list at that level. */
+  apr_array_header_t *nodes;
+} lookup_frame_t;
+
 /* Reusable lookup state object. It is easy to pass to functions and
  * recycling it between lookups saves significant setup costs. */
 typedef struct lookup_state_t
@@ -992,6 +1161,15 @@ typedef struct lookup_state_t
   /* Rights that apply at PARENT_PATH, if PARENT_PATH is not empty. */
   limited_rights_t parent_rights;
 
+  /* The first DEPTH elements are the lookup_frame_t * for each segment
+   * of PARENT_PATH, i.e. the last one of them is in sync with CURRENT.
+   * Elements beyond DEPTH are kept for recycling. */
+  apr_array_header_t *frames;
+  int depth;
+
+  /* Pool to allocate new frames from. */
+  apr_pool_t *pool;
+
 } lookup_state_t;
 
 /* Constructor for lookup_state_t. */
@@ -1015,31 +1193,82 @@ create_lookup_state(apr_pool_t *result_pool)
    * above applies. */
   state->parent_path = svn_stringbuf_create_ensure(200, result_pool);
 
+  state->frames = apr_array_make(result_pool, 8, sizeof(lookup_frame_t *));
+  state->pool = result_pool;
+
   return state;
 }
 
+/* Record the now current PARENT_PATH level of STATE as a new frame. */
+static void
+push_lookup_frame(lookup_state_t *state)
+{
+  lookup_frame_t *frame;
+  if (state->depth < state->frames->nelts)
+    {
+      frame = APR_ARRAY_IDX(state->frames, state->depth, lookup_frame_t *);
+      apr_array_clear(frame->nodes);
+    }
+  else
+    {
+      frame = apr_palloc(state->pool, sizeof(*frame));
+      frame->nodes = apr_array_make(state->pool, 4, sizeof(node_t *));
+      APR_ARRAY_PUSH(state->frames, lookup_frame_t *) = frame;
+    }
+
+  ++state->depth;
+  frame->path_len = state->parent_path->len;
+  frame->rights = state->parent_rights;
+  apr_array_cat(frame->nodes, state->current);
+}
+
 /* Clear the current contents of STATE and re-initialize it for ROOT.
- * Check whether we can reuse a previous parent path lookup to shorten
- * the current PATH walk.  Return the full or remaining portion of
- * PATH, respectively.  PATH must not be NULL. */
+ * Check whether we can reuse a previous lookup of some parent path to
+ * shorten the current PATH walk.  Return the full or remaining portion
+ * of PATH, respectively.  PATH must not be NULL. */
 static const char *
 init_lockup_state(lookup_state_t *state,
                   node_t *root,
                   const char *path)
 {
   apr_size_t len = strlen(path);
-  if (   (len > state->parent_path->len)
-      && state->parent_path->len
-      && (path[state->parent_path->len] == '/')
-      && !memcmp(path, state->parent_path->data, state->parent_path->len))
+  apr_size_t common = 0;
+  int i;
+
+  /* All frames apply to prefixes of PARENT_PATH.  Those within the part
+   * that PATH has in common with it are valid for PATH as well. */
+  while (   common < state->parent_path->len
+         && path[common] == state->parent_path->data[common])
+    ++common;
+
+  /* Use the deepest frame that applies to a true parent path of PATH. */
+  for (i = state->depth; i > 0; --i)
     {
-      /* The PARENT_PATH of the previous lookup is actually a parent path
-       * of PATH.  The CURRENT node list already matches the parent path
-       * and we only have to set the correct rights info. */
-      state->rights = state->parent_rights;
+      lookup_frame_t *frame = APR_ARRAY_IDX(state->frames, i - 1,
+                                            lookup_frame_t *);
+      if (   frame->path_len <= common
+          && len > frame->path_len
+          && path[frame->path_len] == '/')
+        {
+          /* If this is not the PARENT_PATH of the previous lookup, rewind
+           * STATE to that frame's level. */
+          if (i < state->depth)
+            {
+              apr_array_clear(state->current);
+              apr_array_cat(state->current, frame->nodes);
+              state->parent_rights = frame->rights;
+              svn_stringbuf_remove(state->parent_path, frame->path_len,
+                                   state->parent_path->len);
+              state->depth = i;
+            }
 
-      /* Tell the caller where to proceed. */
-      return path + state->parent_path->len;
+          /* The CURRENT node list already matches the parent path and we
+           * only have to set the correct rights info. */
+          state->rights = state->parent_rights;
+
+          /* Tell the caller where to proceed. */
+          return path + frame->path_len;
+        }
     }
 
   /* Start lookup at ROOT for the full PATH. */
@@ -1063,6 +1292,7 @@ init_lockup_state(lookup_state_t *state,
 
   svn_stringbuf_setempty(state->parent_path);
   svn_stringbuf_setempty(state->scratch_pad);
+  state->depth = 0;
 
   return path;
 }
@@ -1171,6 +1401,51 @@ add_complex_matches(lookup_state_t *state,
     }
 }
 
+/* If the HEAD of ENTRY is a prefix of SEGMENT, add all nodes in ENTRY that
+ * match SEGMENT to STATE. */
+static void
+add_if_head_matches(lookup_state_t *state,
+                    const complex_head_t *entry,
+                    const svn_stringbuf_t *segment)
+{
+  if (   entry->head.len <= segment->len
+      && !memcmp(entry->head.data, segment->data, entry->head.len))
+    {
+      int i;
+      for (i = 0; i < entry->nodes->nelts; ++i)
+        {
+          node_t *node = APR_ARRAY_IDX(entry->nodes, i, node_t *);
+          if (0 == apr_fnmatch(node->segment.data, segment->data, 0))
+            add_next_node(state, node);
+        }
+    }
+}
+
+/* Scan the HEADS array of complex_head_t for all entries whose HEAD is a
+ * prefix of SEGMENT and add their matching pattern nodes to STATE for the
+ * next tree level. */
+static void
+add_complex_head_matches(lookup_state_t *state,
+                         const svn_stringbuf_t *segment,
+                         apr_array_header_t *heads)
+{
+  /* Same logic as in add_prefix_matches(). */
+  int i = svn_sort__bsearch_lower_bound(heads, segment->data,
+                                        compare_complex_head);
+  if (i < heads->nelts)
+    add_if_head_matches(state, &APR_ARRAY_IDX(heads, i, complex_head_t),
+                        segment);
+
+  if (i > 0)
+    {
+      complex_head_t *entry;
+      for (entry = &APR_ARRAY_IDX(heads, i - 1, complex_head_t);
+           entry;
+           entry = entry->next)
+        add_if_head_matches(state, entry, segment);
+    }
+}
+
 /* Extract the next segment from PATH and copy it into SEGMENT, whose current
  * contents get overwritten.  Empty paths ("") are supported and leading '/'
  * segment separators will be interpreted as an empty segment ("").  Non-
@@ -1323,6 +1598,10 @@ lookup(lookup_state_t *state,
                 add_complex_matches(state, segment,
                                     node->pattern_sub_nodes->complex);
 
+              if (node->pattern_sub_nodes->complex_heads)
+                add_complex_head_matches(
+                    state, segment, node->pattern_sub_nodes->complex_heads);
+
               /* Find all suffux pattern matches.
                * This must be the last check as it destroys SEGMENT. */
               if (node->pattern_sub_nodes->suffixes)
@@ -1359,6 +1638,7 @@ lookup(lookup_state_t *state,
 
           /* In STATE, PARENT_PATH, PARENT_RIGHTS and CURRENT are now in sync. */
           state->parent_rights = state->rights;
+          push_lookup_frame(state);
         }
     }
 
@@ -1665,12 +1945,13 @@ svn_repos_authz_parse(svn_authz_t **authz_p, svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
-                             const char *path, const char *user,
-                             svn_repos_authz_access_t required_access,
-                             svn_boolean_t *access_granted,
-                             apr_pool_t *pool)
+/* The actual implementation of svn_repos_authz_check_access(). */
+static svn_error_t *
+check_access(svn_authz_t *authz, const char *repos_name,
+             const char *path, const char *user,
+             svn_repos_authz_access_t required_access,
+             svn_boolean_t *access_granted,
+             apr_pool_t *pool)
 {
   const authz_access_t required =
     ((required_access & svn_authz_read ? authz_access_read_flag : 0)
@@ -1727,3 +2008,78 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
+                             const char *path, const char *user,
+                             svn_repos_authz_access_t required_access,
+                             svn_boolean_t *access_granted,
+                             apr_pool_t *pool)
+{
+  svn_trace__span_t *span = svn_trace__span_begin("repos authz_check",
+                                                  pool);
+  svn_error_t *err = check_access(authz, repos_name, path, user,
+                                  required_access, access_granted, pool);
+
+  svn_trace__span_attr(span, "path", path);
+  svn_trace__span_attr(span, "user", user);
+  svn_trace__span_attr_int(span, "granted", !err && *access_granted);
+  svn_trace__span_end(span);
+
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_repos__authz_check_access_many(svn_boolean_t *access_granted,
+                                   svn_authz_t *authz,
+                                   const char *repos_name,
+                                   const apr_array_header_t *paths,
+                                   const char *user,
+                                   svn_repos_authz_access_t required_access,
+                                   apr_pool_t *scratch_pool)
+{
+  const authz_access_t required =
+    ((required_access & svn_authz_read ? authz_access_read_flag : 0)
+     | (required_access & svn_authz_write ? authz_access_write_flag : 0));
+  const svn_boolean_t recursive = !!(required_access & svn_authz_recursive);
+  int i;
+
+  /* Pick or create the suitable pre-filtered path rule tree. */
+  authz_user_rules_t *rules = get_user_rules(
+      authz,
+      (repos_name ? repos_name : AUTHZ_ANY_REPOSITORY),
+      user);
+
+  /* Uniform access to the repository answers all queries at once. */
+  if (   (rules->global_rights.min_access & required) == required
+      || (rules->global_rights.max_access & required) != required)
+    {
+      svn_boolean_t granted
+        = (rules->global_rights.min_access & required) == required;
+
+      for (i = 0; i < paths->nelts; ++i)
+        access_granted[i] = granted;
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Did we already filter the data model? */
+  if (!rules->root)
+    SVN_ERR(filter_tree(authz, scratch_pool));
+
+  /* With PATHS being sorted, each lookup continues from the deepest
+   * ancestor that it shares with its predecessor. */
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      path = init_lockup_state(rules->lookup_state, rules->root, path);
+
+      /* Sanity check. */
+      SVN_ERR_ASSERT(path[0] == '/');
+
+      access_granted[i] = lookup(rules->lookup_state, path, required,
+                                 recursive, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,495 @@
+/* blame.c --- computing blame on the server side
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_private_config.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_delta.h"
+#include "svn_diff.h"
+#include "svn_io.h"
+#include "svn_props.h"
+#include "svn_sorts.h"
+#include "svn_repos.h"
+#include "repos.h"
+#include "private/svn_cache.h"
+#include "private/svn_diff_private.h"
+#include "private/svn_repos_private.h"
+
+
+/* The revision a blame chunk is attributed to. */
+struct rev
+{
+  svn_revnum_t revision; /* SVN_INVALID_REVNUM before the blame range */
+  apr_hash_t *rev_props; /* the revision properties */
+};
+
+/* One blame chunk as stored in the blame cache.  Cache entries are
+   arrays of these, ordered by START_LINE. */
+typedef struct cached_chunk_t
+{
+  apr_int64_t start_line;
+  apr_int64_t revision;
+} cached_chunk_t;
+
+/* Baton for the file revision handler.  Lives the entire operation. */
+struct blame_baton
+{
+  svn_revnum_t start;
+  const svn_diff_file_options_t *diff_options;
+  svn_diff__blame_chain_t *chain;
+
+  /* svn_revnum_t -> struct rev *, shared by all chunks of a revision */
+  apr_hash_t *revs;
+
+  /* The cached blame of the first file revision to come, if any.  It
+     replaces the diff against the previous revision. */
+  const svn_stringbuf_t *resume_blame;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* name of file containing the previous revision of the file */
+  const char *last_filename;
+
+  apr_pool_t *mainpool;  /* lives during the whole sequence of calls */
+  apr_pool_t *lastpool;  /* pool used during previous call */
+  apr_pool_t *currpool;  /* pool used during this call */
+};
+
+/* Baton for the txdelta window handler.  Allocated per revision. */
+struct delta_baton
+{
+  svn_txdelta_window_handler_t wrapped_handler;
+  void *wrapped_baton;
+  struct blame_baton *blame_baton;
+  svn_stream_t *source_stream;  /* the delta source */
+  const char *filename;         /* the delta target */
+  const struct rev *rev;
+};
+
+/* Return the rev struct for REVISION from BB, creating it as needed. */
+static struct rev *
+get_rev(struct blame_baton *bb,
+        svn_revnum_t revision)
+{
+  struct rev *rev = apr_hash_get(bb->revs, &revision, sizeof(revision));
+
+  if (!rev)
+    {
+      rev = apr_pcalloc(bb->mainpool, sizeof(*rev));
+      rev->revision = revision;
+      apr_hash_set(bb->revs, &rev->revision, sizeof(rev->revision), rev);
+    }
+
+  return rev;
+}
+
+/* Replace the blame chain in BB with the chunks from the cache entry
+   CACHED. */
+static void
+load_cached_blame(struct blame_baton *bb,
+                  const svn_stringbuf_t *cached)
+{
+  const cached_chunk_t *chunks = (const cached_chunk_t *)cached->data;
+  apr_size_t count = cached->len / sizeof(*chunks);
+  svn_diff__blame_t *last = NULL;
+  apr_size_t i;
+
+  bb->chain = svn_diff__blame_chain_create(bb->mainpool);
+  for (i = 0; i < count; ++i)
+    {
+      svn_diff__blame_t *blame
+        = svn_diff__blame_create(bb->chain,
+                                 get_rev(bb, (svn_revnum_t)chunks[i].revision),
+                                 (apr_off_t)chunks[i].start_line);
+      if (last)
+        last->next = blame;
+      else
+        bb->chain->blame = blame;
+      last = blame;
+    }
+}
+
+/* Return the blame chain CHAIN in the cache entry format. */
+static svn_stringbuf_t *
+serialize_blame(const svn_diff__blame_chain_t *chain,
+                apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(result_pool);
+  const svn_diff__blame_t *walk;
+
+  for (walk = chain->blame; walk; walk = walk->next)
+    {
+      const struct rev *rev = walk->rev;
+      cached_chunk_t chunk;
+
+      chunk.start_line = walk->start;
+      chunk.revision = rev->revision;
+      svn_stringbuf_appendbytes(result, (const char *)&chunk, sizeof(chunk));
+    }
+
+  return result;
+}
+
+/* Return the blame cache key for the node revision ID, blamed from START
+   with DIFF_OPTIONS. */
+static const char *
+blame_cache_key(const svn_fs_id_t *id,
+                svn_revnum_t start,
+                const svn_diff_file_options_t *diff_options,
+                apr_pool_t *result_pool)
+{
+  return apr_psprintf(result_pool, "%s:%ld:%d:%d:%d",
+                      svn_fs_unparse_id(id, result_pool)->data, start,
+                      (int)diff_options->ignore_space,
+                      (int)diff_options->ignore_eol_style,
+                      (int)diff_options->algorithm);
+}
+
+/* Set *CACHE to the blame cache of REPOS, or to NULL if there is no
+   membuffer cache to store it in. */
+static svn_error_t *
+open_blame_cache(svn_cache__t **cache,
+                 svn_repos_t *repos,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *uuid;
+  const char *prefix;
+
+  *cache = NULL;
+  if (!membuffer)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_get_uuid(repos->fs, &uuid, scratch_pool));
+  prefix = apr_pstrcat(scratch_pool, "repos-blame:", uuid, "/",
+                       svn_repos_path(repos, scratch_pool), ":",
+                       SVN_VA_NULL);
+
+  return svn_error_trace(svn_cache__create_membuffer_cache(
+                           cache, membuffer, NULL, NULL,
+                           APR_HASH_KEY_STRING, prefix,
+                           SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                           TRUE, FALSE, result_pool, scratch_pool));
+}
+
+/* Walk the history of PATH in END back to START and find the newest node
+   revision whose blame from START with DIFF_OPTIONS is in CACHE.  Set
+   *CACHED to that blame and *CACHED_REV to the revision that created the
+   node revision, or *CACHED to NULL if none is cached.  Set *UP_TO_DATE
+   if the node revision is that of PATH in END.  Allocate *CACHED in
+   RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+find_cached_blame(svn_stringbuf_t **cached,
+                  svn_revnum_t *cached_rev,
+                  svn_boolean_t *up_to_date,
+                  svn_cache__t *cache,
+                  svn_repos_t *repos,
+                  const char *path,
+                  svn_revnum_t start,
+                  svn_revnum_t end,
+                  const svn_diff_file_options_t *diff_options,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *root;
+  svn_fs_history_t *history;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *last_pool = svn_pool_create(scratch_pool);
+  svn_boolean_t newest = TRUE;
+
+  *cached = NULL;
+  *up_to_date = FALSE;
+
+  SVN_ERR(svn_fs_revision_root(&root, repos->fs, end, scratch_pool));
+  SVN_ERR(svn_fs_node_history2(&history, root, path, scratch_pool,
+                               scratch_pool));
+  while (1)
+    {
+      const char *hist_path;
+      svn_revnum_t hist_rev;
+      svn_fs_root_t *hist_root;
+      const svn_fs_id_t *id;
+      svn_boolean_t found;
+      apr_pool_t *tmp_pool;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, iterpool,
+                                   iterpool));
+      if (!history)
+        break;
+      SVN_ERR(svn_fs_history_location(&hist_path, &hist_rev, history,
+                                      iterpool));
+
+      SVN_ERR(svn_fs_revision_root(&hist_root, repos->fs, hist_rev,
+                                   iterpool));
+      SVN_ERR(svn_fs_node_id(&id, hist_root, hist_path, iterpool));
+      SVN_ERR(svn_cache__get((void **)cached, &found, cache,
+                             blame_cache_key(id, start, diff_options,
+                                             iterpool),
+                             result_pool));
+      if (found)
+        {
+          *cached_rev = hist_rev;
+          *up_to_date = newest;
+          break;
+        }
+
+      if (hist_rev <= start)
+        break;
+
+      newest = FALSE;
+
+      /* Swap pools. */
+      tmp_pool = iterpool;
+      iterpool = last_pool;
+      last_pool = tmp_pool;
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(last_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Apply the delta window WINDOW and, after the last one, update the
+ * blame with the changes of this revision.
+ *
+ * Implements svn_txdelta_window_handler_t.
+ */
+static svn_error_t *
+window_handler(svn_txdelta_window_t *window, void *baton)
+{
+  struct delta_baton *dbaton = baton;
+  struct blame_baton *bb = dbaton->blame_baton;
+  apr_pool_t *tmp_pool;
+
+  SVN_ERR(dbaton->wrapped_handler(window, dbaton->wrapped_baton));
+
+  /* We patiently wait for the NULL window marking the end. */
+  if (window)
+    return SVN_NO_ERROR;
+
+  /* Close the source file early, so it can be deleted with its pool. */
+  if (dbaton->source_stream)
+    SVN_ERR(svn_stream_close(dbaton->source_stream));
+
+  if (bb->resume_blame)
+    {
+      /* This revision has been blamed before. */
+      load_cached_blame(bb, bb->resume_blame);
+      bb->resume_blame = NULL;
+    }
+  else
+    SVN_ERR(svn_diff__blame_add_file(bb->chain, bb->last_filename,
+                                     dbaton->filename, dbaton->rev,
+                                     bb->diff_options,
+                                     bb->cancel_func, bb->cancel_baton,
+                                     bb->currpool));
+
+  /* Keep this revision's file around to diff it with the next one. */
+  bb->last_filename = dbaton->filename;
+
+  tmp_pool = bb->lastpool;
+  bb->lastpool = bb->currpool;
+  bb->currpool = tmp_pool;
+
+  return SVN_NO_ERROR;
+}
+
+/* Reconstruct the contents of the next file revision next to the previous
+ * one, so that the window handler can diff them.
+ *
+ * Implements svn_file_rev_handler_t.
+ */
+static svn_error_t *
+file_rev_handler(void *baton,
+                 const char *path,
+                 svn_revnum_t revnum,
+                 apr_hash_t *rev_props,
+                 svn_boolean_t merged_revision,
+                 svn_txdelta_window_handler_t *content_delta_handler,
+                 void **content_delta_baton,
+                 apr_array_header_t *prop_diffs,
+                 apr_pool_t *pool)
+{
+  struct blame_baton *bb = baton;
+  struct delta_baton *dbaton;
+  svn_stream_t *last_stream;
+  svn_stream_t *cur_stream;
+
+  if (bb->cancel_func)
+    SVN_ERR(bb->cancel_func(bb->cancel_baton));
+
+  /* Without content changes, the blame stays the same.  Note that we
+     must not switch the pools either, as they hold the last file. */
+  if (!content_delta_handler)
+    return SVN_NO_ERROR;
+
+  svn_pool_clear(bb->currpool);
+
+  dbaton = apr_pcalloc(bb->currpool, sizeof(*dbaton));
+  dbaton->blame_baton = bb;
+
+  if (bb->last_filename)
+    SVN_ERR(svn_stream_open_readonly(&dbaton->source_stream,
+                                     bb->last_filename,
+                                     bb->currpool, pool));
+  last_stream = svn_stream_disown(dbaton->source_stream, pool);
+
+  SVN_ERR(svn_stream_open_unique(&cur_stream, &dbaton->filename, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 bb->currpool, bb->currpool));
+
+  /* Lines from the revision before the range get no blame. */
+  if (revnum >= bb->start)
+    {
+      struct rev *rev = get_rev(bb, revnum);
+
+      if (!rev->rev_props)
+        rev->rev_props = svn_prop_hash_dup(rev_props, bb->mainpool);
+      dbaton->rev = rev;
+    }
+  else
+    {
+      dbaton->rev = get_rev(bb, SVN_INVALID_REVNUM);
+    }
+
+  svn_txdelta_apply(last_stream, cur_stream, NULL, NULL, bb->currpool,
+                    &dbaton->wrapped_handler, &dbaton->wrapped_baton);
+  *content_delta_handler = window_handler;
+  *content_delta_baton = dbaton;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__get_file_blame(svn_repos_t *repos,
+                          const char *path,
+                          svn_revnum_t start,
+                          svn_revnum_t end,
+                          const svn_diff_file_options_t *diff_options,
+                          svn_repos_authz_func_t authz_read_func,
+                          void *authz_read_baton,
+                          svn_boolean_t use_cache,
+                          svn_repos__blame_receiver_t receiver,
+                          void *receiver_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool)
+{
+  struct blame_baton bb;
+  svn_diff__blame_t *walk;
+  svn_cache__t *cache = NULL;
+  svn_revnum_t first_rev = MAX(0, start - 1);
+  svn_boolean_t up_to_date = FALSE;
+  apr_pool_t *iterpool;
+
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(start) && SVN_IS_VALID_REVNUM(end)
+                 && start <= end);
+
+  bb.start = start;
+  bb.diff_options = diff_options;
+  bb.chain = svn_diff__blame_chain_create(scratch_pool);
+  bb.revs = apr_hash_make(scratch_pool);
+  bb.resume_blame = NULL;
+  bb.cancel_func = cancel_func;
+  bb.cancel_baton = cancel_baton;
+  bb.last_filename = NULL;
+  bb.mainpool = scratch_pool;
+  bb.lastpool = svn_pool_create(scratch_pool);
+  bb.currpool = svn_pool_create(scratch_pool);
+
+  /* The cached blame may have been computed with different path-based
+     authz rules, so it can only be used without any. */
+  if (use_cache && !authz_read_func)
+    SVN_ERR(open_blame_cache(&cache, repos, scratch_pool, scratch_pool));
+
+  if (cache)
+    {
+      svn_stringbuf_t *cached;
+      svn_revnum_t cached_rev;
+
+      SVN_ERR(find_cached_blame(&cached, &cached_rev, &up_to_date, cache,
+                                repos, path, start, end, diff_options,
+                                scratch_pool, scratch_pool));
+      if (cached && up_to_date)
+        {
+          load_cached_blame(&bb, cached);
+        }
+      else if (cached)
+        {
+          /* Only process the revisions since the cached one. */
+          bb.resume_blame = cached;
+          first_rev = cached_rev;
+        }
+    }
+
+  /* Unless we resume from a cached blame, also get the revision before
+     START, if available, so that we know what was actually changed in
+     START. */
+  if (!up_to_date)
+    {
+      SVN_ERR(svn_repos_get_file_revs2(repos, path, first_rev, end,
+                                       FALSE, authz_read_func,
+                                       authz_read_baton, file_rev_handler,
+                                       &bb, scratch_pool));
+
+      if (cache)
+        {
+          svn_fs_root_t *root;
+          const svn_fs_id_t *id;
+
+          SVN_ERR(svn_fs_revision_root(&root, repos->fs, end, scratch_pool));
+          SVN_ERR(svn_fs_node_id(&id, root, path, scratch_pool));
+          SVN_ERR(svn_cache__set(cache,
+                                 blame_cache_key(id, start, diff_options,
+                                                 scratch_pool),
+                                 serialize_blame(bb.chain, scratch_pool),
+                                 scratch_pool));
+        }
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (walk = bb.chain->blame; walk; walk = walk->next)
+    {
+      struct rev *rev = (struct rev *)walk->rev;
+
+      svn_pool_clear(iterpool);
+
+      /* Revisions taken from the cache still lack their properties. */
+      if (SVN_IS_VALID_REVNUM(rev->revision) && !rev->rev_props)
+        SVN_ERR(svn_fs_revision_proplist2(&rev->rev_props, repos->fs,
+                                          rev->revision, FALSE,
+                                          scratch_pool, iterpool));
+
+      SVN_ERR(receiver(receiver_baton, walk->start, rev->revision,
+                       rev->rev_props, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  svn_pool_destroy(bb.lastpool);
+  svn_pool_destroy(bb.currpool);
+
+  return SVN_NO_ERROR;
+}
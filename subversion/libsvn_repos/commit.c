@@ -434,10 +434,12 @@ open_root(void *edit_baton,
      make our own. */
   if (eb->txn_owner)
     {
-      SVN_ERR(svn_repos_fs_begin_txn_for_commit2(&(eb->txn),
+      /* We will commit or abort it ourselves in close_edit / abort_edit. */
+      SVN_ERR(svn_repos__fs_begin_txn_for_commit(&(eb->txn),
                                                  eb->repos,
                                                  youngest,
                                                  eb->revprop_table,
+                                                 TRUE,
                                                  eb->pool));
     }
   else /* Even if we aren't the owner of the transaction, we might
@@ -148,6 +148,7 @@ svn_repos__get_logs_compat(svn_repos_t *repos,
                            svn_boolean_t strict_node_history,
                            svn_boolean_t include_merged_revisions,
                            const apr_array_header_t *revprops,
+                           const apr_array_header_t *search_patterns,
                            svn_repos_authz_func_t authz_read_func,
                            void *authz_read_baton,
                            svn_log_entry_receiver_t receiver,
@@ -162,17 +163,29 @@ svn_repos__get_logs_compat(svn_repos_t *repos,
   baton.inner = receiver;
   baton.inner_baton = receiver_baton;
 
-  SVN_ERR(svn_repos_get_logs5(repos, paths, start, end, limit,
-                              strict_node_history,
-                              include_merged_revisions,
-                              revprops,
-                              authz_read_func, authz_read_baton,
-                              discover_changed_paths
-                                ? log4_path_change_receiver
-                                : NULL,
-                              &baton,
-                              log4_entry_receiver, &baton,
-                              pool));
+  if (search_patterns && !include_merged_revisions)
+    SVN_ERR(svn_repos__get_logs_search(repos, paths, start, end, limit,
+                                       strict_node_history,
+                                       revprops, search_patterns,
+                                       authz_read_func, authz_read_baton,
+                                       discover_changed_paths
+                                         ? log4_path_change_receiver
+                                         : NULL,
+                                       &baton,
+                                       log4_entry_receiver, &baton,
+                                       pool));
+  else
+    SVN_ERR(svn_repos_get_logs5(repos, paths, start, end, limit,
+                                strict_node_history,
+                                include_merged_revisions,
+                                revprops,
+                                authz_read_func, authz_read_baton,
+                                discover_changed_paths
+                                  ? log4_path_change_receiver
+                                  : NULL,
+                                &baton,
+                                log4_entry_receiver, &baton,
+                                pool));
 
   svn_pool_destroy(changes_pool);
   return SVN_NO_ERROR;
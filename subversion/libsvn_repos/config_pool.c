@@ -24,10 +24,14 @@
 
 
 
+#include <apr_md5.h>
+
 #include "svn_checksum.h"
+#include "svn_hash.h"
 #include "svn_path.h"
 #include "svn_pools.h"
 
+#include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_repos_private.h"
 
@@ -35,6 +39,42 @@
 
 #include "config_file.h"
 
+
+/* Files modified less than this long before we read them may still change
+ * without their timestamp changing.  Don't remember stamps for those.
+ */
+#define STAMP_GRANULARITY apr_time_from_sec(1)
+
+/* What we know about a local config file from the last time we read it.
+ */
+typedef struct file_stamp_t
+{
+  /* Last modification time of the file. */
+  apr_time_t mtime;
+
+  /* Size of the file in bytes. */
+  svn_filesize_t size;
+
+  /* MD5 checksum of the file contents. */
+  unsigned char digest[APR_MD5_DIGESTSIZE];
+} file_stamp_t;
+
+struct svn_repos__config_pool_t
+{
+  /* Parsed configurations, keyed by their contents' MD5 checksum. */
+  svn_object_pool__t *object_pool;
+
+  /* Maps local file paths to file_stamp_t.  This allows us to find the
+   * cached configuration without reading and checksumming the file. */
+  apr_hash_t *stamps;
+
+  /* Serializes access to STAMPS. */
+  svn_mutex__t *mutex;
+
+  /* The pool that STAMPS and its contents are allocated in. */
+  apr_pool_t *pool;
+};
+
 
 /* Return a memory buffer structure allocated in POOL and containing the
  * data from CHECKSUM.
@@ -70,8 +110,8 @@ find_config(svn_config_t **cfg,
 {
   /* First, attempt the cache lookup. */
   svn_membuf_t *key = checksum_as_key(checksum, scratch_pool);
-  SVN_ERR(svn_object_pool__lookup((void **)cfg, config_pool, key,
-                                  result_pool));
+  SVN_ERR(svn_object_pool__lookup((void **)cfg, config_pool->object_pool,
+                                  key, result_pool));
 
   /* Not found? => parse and cache */
   if (!*cfg)
@@ -79,15 +119,114 @@ find_config(svn_config_t **cfg,
       svn_config_t *config;
 
       /* create a pool for the new config object and parse the data into it */
-      apr_pool_t *cfg_pool = svn_object_pool__new_item_pool(config_pool);
+      apr_pool_t *cfg_pool
+        = svn_object_pool__new_item_pool(config_pool->object_pool);
       SVN_ERR(svn_config_parse(&config, stream, FALSE, FALSE, cfg_pool));
 
       /* switch config data to r/o mode to guarantee thread-safe access */
       svn_config__set_read_only(config, cfg_pool);
 
       /* add config in pool, handle loads races and return the right config */
-      SVN_ERR(svn_object_pool__insert((void **)cfg, config_pool, key,
-                                      config, cfg_pool, result_pool));
+      SVN_ERR(svn_object_pool__insert((void **)cfg, config_pool->object_pool,
+                                      key, config, cfg_pool, result_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DIGEST to the checksum digest that CONFIG_POOL remembers for the
+ * local file described by PATH and DIRENT.  Set it to NULL if we don't
+ * know the file or it has been modified since.
+ */
+static svn_error_t *
+get_stamp(const unsigned char **digest,
+          svn_repos__config_pool_t *config_pool,
+          const char *path,
+          const svn_io_dirent2_t *dirent)
+{
+  file_stamp_t *stamp = svn_hash_gets(config_pool->stamps, path);
+
+  *digest = NULL;
+  if (   stamp
+      && stamp->mtime == dirent->mtime
+      && stamp->size == dirent->filesize)
+    *digest = stamp->digest;
+
+  return SVN_NO_ERROR;
+}
+
+/* Make CONFIG_POOL remember that the local file described by PATH and
+ * DIRENT has contents with the given MD5 CHECKSUM.
+ */
+static svn_error_t *
+set_stamp(svn_repos__config_pool_t *config_pool,
+          const char *path,
+          const svn_io_dirent2_t *dirent,
+          const svn_checksum_t *checksum)
+{
+  file_stamp_t *stamp = svn_hash_gets(config_pool->stamps, path);
+  if (!stamp)
+    {
+      stamp = apr_palloc(config_pool->pool, sizeof(*stamp));
+      svn_hash_sets(config_pool->stamps,
+                    apr_pstrdup(config_pool->pool, path), stamp);
+    }
+
+  stamp->mtime = dirent->mtime;
+  stamp->size = dirent->filesize;
+  memcpy(stamp->digest, checksum->digest, sizeof(stamp->digest));
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread-safe wrapper around set_stamp.
+ */
+static svn_error_t *
+remember_stamp(svn_repos__config_pool_t *config_pool,
+               const char *path,
+               const svn_io_dirent2_t *dirent,
+               const svn_checksum_t *checksum)
+{
+  SVN_MUTEX__WITH_LOCK(config_pool->mutex,
+                       set_stamp(config_pool, path, dirent, checksum));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CFG to the cached configuration for the local file PATH, if
+ * CONFIG_POOL knows about the file and it has not been modified since it
+ * got read.  Set *CFG to NULL otherwise.  DIRENT describes the current
+ * state of PATH.
+ *
+ * RESULT_POOL determines the lifetime of the returned reference and
+ * SCRATCH_POOL is being used for temporary allocations.
+ */
+static svn_error_t *
+find_stamped_config(svn_config_t **cfg,
+                    svn_repos__config_pool_t *config_pool,
+                    const char *path,
+                    const svn_io_dirent2_t *dirent,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  const unsigned char *digest;
+
+  *cfg = NULL;
+  SVN_MUTEX__WITH_LOCK(config_pool->mutex,
+                       get_stamp(&digest, config_pool, path, dirent));
+
+  /* The stamp may be gone from the object pool by now.  Then, we simply
+   * need to read the file again. */
+  if (digest)
+    {
+      svn_checksum_t checksum;
+      svn_membuf_t *key;
+
+      checksum.digest = digest;
+      checksum.kind = svn_checksum_md5;
+      key = checksum_as_key(&checksum, scratch_pool);
+      SVN_ERR(svn_object_pool__lookup((void **)cfg, config_pool->object_pool,
+                                      key, result_pool));
     }
 
   return SVN_NO_ERROR;
@@ -100,8 +239,16 @@ svn_repos__config_pool_create(svn_repos__config_pool_t **config_pool,
                               svn_boolean_t thread_safe,
                               apr_pool_t *pool)
 {
-  return svn_error_trace(svn_object_pool__create(config_pool,
-                                                 thread_safe, pool));
+  svn_repos__config_pool_t *result = apr_pcalloc(pool, sizeof(*result));
+
+  SVN_ERR(svn_object_pool__create(&result->object_pool, thread_safe, FALSE,
+                                  pool));
+  SVN_ERR(svn_mutex__init(&result->mutex, thread_safe, pool));
+  result->stamps = apr_hash_make(pool);
+  result->pool = pool;
+
+  *config_pool = result;
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -118,15 +265,48 @@ svn_repos__config_pool_get(svn_config_t **cfg,
                                                             scratch_pool);
   svn_stream_t *stream;
   svn_checksum_t *checksum;
+  const svn_io_dirent2_t *dirent = NULL;
 
   *cfg = NULL;
-  err = svn_repos__get_config(&stream, &checksum, access, path, must_exist,
-                              scratch_pool);
-  if (!err)
-    err = svn_error_quick_wrapf(find_config(cfg, config_pool, stream,
-                                            checksum, pool, scratch_pool),
-                                "Error while parsing config file: '%s':",
-                                path);
+
+  /* For local files that we read before, checking the timestamp and size
+   * is enough to tell whether we can use the cached configuration.  This
+   * saves us from reading and checksumming the whole file each time. */
+  if (!svn_path_is_url(path))
+    {
+      err = svn_io_stat_dirent2(&dirent, path, FALSE, TRUE, scratch_pool,
+                                scratch_pool);
+      if (err || dirent->kind != svn_node_file)
+        {
+          svn_error_clear(err);
+          err = SVN_NO_ERROR;
+          dirent = NULL;
+        }
+      else
+        {
+          err = find_stamped_config(cfg, config_pool, path, dirent, pool,
+                                    scratch_pool);
+        }
+    }
+
+  if (!err && !*cfg)
+    {
+      err = svn_repos__get_config(&stream, &checksum, access, path,
+                                  must_exist, scratch_pool);
+      if (!err)
+        err = svn_error_quick_wrapf(find_config(cfg, config_pool, stream,
+                                                checksum, pool,
+                                                scratch_pool),
+                                    "Error while parsing config file: '%s':",
+                                    path);
+
+      /* Remember the file stamp unless the file may still change within
+       * the timestamp granularity. */
+      if (   !err && *cfg && dirent
+          && checksum->kind == svn_checksum_md5
+          && dirent->mtime + STAMP_GRANULARITY < apr_time_now())
+        err = remember_stamp(config_pool, path, dirent, checksum);
+    }
 
   /* Let the standard implementation handle all the difficult cases.
    * Note that for in-repo configs, there are no further special cases to
@@ -22,6 +22,9 @@
 
 
 #include <stdarg.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
 
 #include "svn_private_config.h"
 #include "svn_pools.h"
@@ -41,6 +44,7 @@
 #include "private/svn_repos_private.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_cache.h"
@@ -314,29 +318,76 @@ tracker_path_delete(path_tracker_t *tracker,
 }
 
 
+/* If the repository already stores the delta between OLDROOT/OLDPATH and
+   NEWROOT/NEWPATH as svndiff data that any svndiff reader can handle,
+   set *FILE, *OFFSET and *LEN to where that data can be found.
+   Otherwise, set *FILE to NULL. */
+static svn_error_t *
+try_get_stored_delta(apr_file_t **file, apr_off_t *offset,
+                     svn_filesize_t *len,
+                     svn_fs_root_t *oldroot, const char *oldpath,
+                     svn_fs_root_t *newroot, const char *newpath,
+                     apr_pool_t *pool)
+{
+  char header[4];
+  apr_off_t header_offset;
+
+  SVN_ERR(svn_fs__try_get_file_delta_range(file, offset, len,
+                                           oldroot, oldpath,
+                                           newroot, newpath, pool, pool));
+  if (*file == NULL)
+    return SVN_NO_ERROR;
+
+  /* Releases before 1.10 can't load svndiff2, so don't put anything
+     newer than svndiff1 into the dump file. */
+  if (*len >= sizeof(header))
+    {
+      header_offset = *offset;
+      SVN_ERR(svn_io_file_seek(*file, APR_SET, &header_offset, pool));
+      SVN_ERR(svn_io_file_read_full2(*file, header, sizeof(header),
+                                     NULL, NULL, pool));
+    }
+
+  if (   *len < sizeof(header)
+      || memcmp(header, "SVN", 3) != 0
+      || header[3] > 1)
+    {
+      SVN_ERR(svn_io_file_close(*file, pool));
+      *file = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Compute the delta between OLDROOT/OLDPATH and NEWROOT/NEWPATH and
-   store it into a new temporary file *TEMPFILE.  OLDROOT may be NULL,
-   in which case the delta will be computed against an empty file, as
-   per the svn_fs_get_file_delta_stream docstring.  Record the length
-   of the temporary file in *LEN, and rewind the file before
-   returning. */
+   return the location of its svndiff representation in *FILE, *OFFSET
+   and *LEN.  OLDROOT may be NULL, in which case the delta will be
+   computed against an empty file, as per the svn_fs_get_file_delta_stream
+   docstring.
+
+   If the repository already stores that delta, simply point to it.
+   Otherwise, write the delta into a new temporary file. */
 static svn_error_t *
-store_delta(apr_file_t **tempfile, svn_filesize_t *len,
+store_delta(apr_file_t **file, apr_off_t *offset, svn_filesize_t *len,
             svn_fs_root_t *oldroot, const char *oldpath,
             svn_fs_root_t *newroot, const char *newpath, apr_pool_t *pool)
 {
   svn_stream_t *temp_stream;
-  apr_off_t offset;
   svn_txdelta_stream_t *delta_stream;
   svn_txdelta_window_handler_t wh;
   void *whb;
 
+  SVN_ERR(try_get_stored_delta(file, offset, len, oldroot, oldpath,
+                               newroot, newpath, pool));
+  if (*file)
+    return SVN_NO_ERROR;
+
   /* Create a temporary file and open a stream to it. Note that we need
-     the file handle in order to rewind it. */
-  SVN_ERR(svn_io_open_unique_file3(tempfile, NULL, NULL,
+     the file handle in order to find the data's length. */
+  SVN_ERR(svn_io_open_unique_file3(file, NULL, NULL,
                                    svn_io_file_del_on_pool_cleanup,
                                    pool, pool));
-  temp_stream = svn_stream_from_aprfile2(*tempfile, TRUE, pool);
+  temp_stream = svn_stream_from_aprfile2(*file, TRUE, pool);
 
   /* Compute the delta and send it to the temporary file. */
   SVN_ERR(svn_fs_get_file_delta_stream(&delta_stream, oldroot, oldpath,
@@ -345,11 +396,33 @@ store_delta(apr_file_t **tempfile, svn_filesize_t *len,
                           SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, pool);
   SVN_ERR(svn_txdelta_send_txstream(delta_stream, wh, whb, pool));
 
-  /* Get the length of the temporary file and rewind it. */
-  SVN_ERR(svn_io_file_get_offset(&offset, *tempfile, pool));
-  *len = offset;
-  offset = 0;
-  return svn_io_file_seek(*tempfile, APR_SET, &offset, pool);
+  /* Get the length of the temporary file. */
+  SVN_ERR(svn_io_file_get_offset(offset, *file, pool));
+  *len = *offset;
+  *offset = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy LEN bytes starting at OFFSET in FILE to STREAM, then close FILE.
+   Use POOL for temporaries. */
+static svn_error_t *
+dump_file_range(svn_stream_t *stream, apr_file_t *file, apr_off_t offset,
+                svn_filesize_t len, apr_pool_t *pool)
+{
+  char *buffer = apr_palloc(pool, SVN__STREAM_CHUNK_SIZE);
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+  while (len > 0)
+    {
+      apr_size_t count = (apr_size_t)MIN(len, SVN__STREAM_CHUNK_SIZE);
+
+      SVN_ERR(svn_io_file_read_full2(file, buffer, count, NULL, NULL, pool));
+      SVN_ERR(svn_stream_write(stream, buffer, &count));
+      len -= count;
+    }
+
+  return svn_error_trace(svn_io_file_close(file, pool));
 }
 
 
@@ -1101,6 +1174,7 @@ dump_node(struct edit_baton *eb,
   svn_revnum_t compare_rev = eb->current_rev - 1;
   svn_fs_root_t *compare_root = NULL;
   apr_file_t *delta_file = NULL;
+  apr_off_t delta_offset = 0;
   svn_repos__dumpfile_headers_t *headers
     = svn_repos__dumpfile_headers_create(pool);
   svn_filesize_t textlen;
@@ -1426,11 +1500,11 @@ dump_node(struct edit_baton *eb,
 
       if (eb->use_deltas)
         {
-          /* Compute the text delta now and write it into a temporary
-             file, so that we can find its length.  Output a header
-             saying our text contents are a delta. */
-          SVN_ERR(store_delta(&delta_file, &textlen, compare_root,
-                              compare_path, eb->fs_root, path, pool));
+          /* Compute the text delta now, so that we can find its length.
+             Output a header saying our text contents are a delta. */
+          SVN_ERR(store_delta(&delta_file, &delta_offset, &textlen,
+                              compare_root, compare_path, eb->fs_root, path,
+                              pool));
           svn_repos__dumpfile_header_push(
             headers, SVN_REPOS_DUMPFILE_TEXT_DELTA, "true");
 
@@ -1491,15 +1565,16 @@ dump_node(struct edit_baton *eb,
 
       if (delta_file)
         {
-          /* Make sure to close the underlying file when the stream is
-             closed. */
-          contents = svn_stream_from_aprfile2(delta_file, FALSE, pool);
+          SVN_ERR(dump_file_range(eb->stream, delta_file, delta_offset,
+                                  textlen, pool));
         }
       else
-        SVN_ERR(svn_fs_file_contents(&contents, eb->fs_root, path, pool));
-
-      SVN_ERR(svn_stream_copy3(contents, svn_stream_disown(eb->stream, pool),
-                               NULL, NULL, pool));
+        {
+          SVN_ERR(svn_fs_file_contents(&contents, eb->fs_root, path, pool));
+          SVN_ERR(svn_stream_copy3(contents,
+                                   svn_stream_disown(eb->stream, pool),
+                                   NULL, NULL, pool));
+        }
     }
 
   len = 2;
@@ -1966,61 +2041,86 @@ write_revision_record(svn_stream_t *stream,
 }
 
 
+/* Baton for dump_filter_authz_func.
+ */
+typedef struct dump_filter_baton_t
+{
+  svn_repos_dump_filter_func_t filter_func;
+  void *filter_baton;
+} dump_filter_baton_t;
 
-/* The main dumper. */
-svn_error_t *
-svn_repos_dump_fs4(svn_repos_t *repos,
-                   svn_stream_t *stream,
-                   svn_revnum_t start_rev,
-                   svn_revnum_t end_rev,
-                   svn_boolean_t incremental,
-                   svn_boolean_t use_deltas,
-                   svn_boolean_t include_revprops,
-                   svn_boolean_t include_changes,
-                   svn_repos_notify_func_t notify_func,
-                   void *notify_baton,
-                   svn_cancel_func_t cancel_func,
-                   void *cancel_baton,
-                   apr_pool_t *pool)
+/* Implements svn_repos_authz_func_t.  Let the filter in BATON, a
+ * dump_filter_baton_t, decide whether PATH in ROOT will be dumped.
+ * The replay and delta drivers then never look at excluded subtrees.
+ */
+static svn_error_t *
+dump_filter_authz_func(svn_boolean_t *allowed,
+                       svn_fs_root_t *root,
+                       const char *path,
+                       void *baton,
+                       apr_pool_t *pool)
+{
+  dump_filter_baton_t *b = baton;
+
+  /* The drivers don't agree on whether paths have a leading '/'. */
+  path = svn_fspath__canonicalize(path, pool);
+
+  /* The root directory itself never gets dumped. */
+  if (svn_fspath__is_root(path, strlen(path)))
+    {
+      *allowed = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(b->filter_func(allowed, root, path,
+                                        b->filter_baton, pool));
+}
+
+/* Write a complete dump stream for revisions START_REV to END_REV in FS
+ * to STREAM, i.e. including the stream header.  OLDEST_DUMPED_REV is the
+ * first revision of the whole dump operation and determines which copy
+ * sources and mergeinfo count as outside the dumped range.  Set the flags
+ * FOUND_OLD_REFERENCE and FOUND_OLD_MERGEINFO if those have been found.
+ * Send rev_end notifications but no dump_end notification.  All other
+ * parameters are the same as for svn_repos_dump_fs4.
+ */
+static svn_error_t *
+dump_range(svn_fs_t *fs,
+           svn_stream_t *stream,
+           svn_revnum_t start_rev,
+           svn_revnum_t end_rev,
+           svn_revnum_t oldest_dumped_rev,
+           svn_boolean_t incremental,
+           svn_boolean_t use_deltas,
+           svn_boolean_t include_revprops,
+           svn_boolean_t include_changes,
+           svn_repos_dump_filter_func_t filter_func,
+           void *filter_baton,
+           svn_boolean_t *found_old_reference,
+           svn_boolean_t *found_old_mergeinfo,
+           svn_repos_notify_func_t notify_func,
+           void *notify_baton,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *pool)
 {
   const svn_delta_editor_t *dump_editor;
   void *dump_edit_baton = NULL;
   svn_revnum_t rev;
-  svn_fs_t *fs = svn_repos_fs(repos);
   apr_pool_t *iterpool = svn_pool_create(pool);
-  svn_revnum_t youngest;
   const char *uuid;
   int version;
-  svn_boolean_t found_old_reference = FALSE;
-  svn_boolean_t found_old_mergeinfo = FALSE;
   svn_repos_notify_t *notify;
+  svn_repos_authz_func_t authz_func = NULL;
+  dump_filter_baton_t filter = { 0 };
 
-  /* Make sure we catch up on the latest revprop changes.  This is the only
-   * time we will refresh the revprop data in this query. */
-  SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
-
-  /* Determine the current youngest revision of the filesystem. */
-  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
-
-  /* Use default vals if necessary. */
-  if (! SVN_IS_VALID_REVNUM(start_rev))
-    start_rev = 0;
-  if (! SVN_IS_VALID_REVNUM(end_rev))
-    end_rev = youngest;
-  if (! stream)
-    stream = svn_stream_empty(pool);
-
-  /* Validate the revisions. */
-  if (start_rev > end_rev)
-    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
-                             _("Start revision %ld"
-                               " is greater than end revision %ld"),
-                             start_rev, end_rev);
-  if (end_rev > youngest)
-    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
-                             _("End revision %ld is invalid "
-                               "(youngest revision is %ld)"),
-                             end_rev, youngest);
+  /* Path filtering piggy-backs on the drivers' authz support. */
+  if (filter_func)
+    {
+      authz_func = dump_filter_authz_func;
+      filter.filter_func = filter_func;
+      filter.filter_baton = filter_baton;
+    }
 
   /* Write out the UUID. */
   SVN_ERR(svn_fs_get_uuid(fs, &uuid, pool));
@@ -2071,10 +2171,11 @@ svn_repos_dump_fs4(svn_repos_t *repos,
          non-incremental dump. */
       use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
       SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
-                              "", stream, &found_old_reference,
-                              &found_old_mergeinfo, NULL,
+                              "", stream, found_old_reference,
+                              found_old_mergeinfo, NULL,
                               notify_func, notify_baton,
-                              start_rev, use_deltas_for_rev, FALSE, FALSE,
+                              oldest_dumped_rev, use_deltas_for_rev,
+                              FALSE, FALSE,
                               iterpool));
 
       /* Drive the editor in one way or another. */
@@ -2091,8 +2192,8 @@ svn_repos_dump_fs4(svn_repos_t *repos,
           SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
                                        to_root, "",
                                        dump_editor, dump_edit_baton,
-                                       NULL,
-                                       NULL,
+                                       authz_func,
+                                       &filter,
                                        FALSE, /* don't send text-deltas */
                                        svn_depth_infinity,
                                        FALSE, /* don't send entry props */
@@ -2104,7 +2205,7 @@ svn_repos_dump_fs4(svn_repos_t *repos,
           /* The normal case: compare consecutive revs. */
           SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
                                     dump_editor, dump_edit_baton,
-                                    NULL, NULL, iterpool));
+                                    authz_func, &filter, iterpool));
 
           /* While our editor close_edit implementation is a no-op, we still
              do this for completeness. */
@@ -2119,143 +2220,823 @@ svn_repos_dump_fs4(svn_repos_t *repos,
         }
     }
 
-  if (notify_func)
-    {
-      /* Did we issue any warnings about references to revisions older than
-         the oldest dumped revision?  If so, then issue a final generic
-         warning, since the inline warnings already issued might easily be
-         missed. */
+  svn_pool_destroy(iterpool);
 
-      notify = svn_repos_notify_create(svn_repos_notify_dump_end, iterpool);
-      notify_func(notify_baton, notify, iterpool);
+  return SVN_NO_ERROR;
+}
 
-      if (found_old_reference)
-        {
-          notify_warning(iterpool, notify_func, notify_baton,
-                         svn_repos_notify_warning_found_old_reference,
-                         _("The range of revisions dumped "
-                           "contained references to "
-                           "copy sources outside that "
-                           "range."));
-        }
+/* Send the dump_end notification to NOTIFY_FUNC / NOTIFY_BATON, followed
+ * by the summary warnings selected by FOUND_OLD_REFERENCE and
+ * FOUND_OLD_MERGEINFO.  Use SCRATCH_POOL for temporary allocations.
+ */
+static void
+notify_dump_end(svn_boolean_t found_old_reference,
+                svn_boolean_t found_old_mergeinfo,
+                svn_repos_notify_func_t notify_func,
+                void *notify_baton,
+                apr_pool_t *scratch_pool)
+{
+  svn_repos_notify_t *notify;
 
-      /* Ditto if we issued any warnings about old revisions referenced
-         in dumped mergeinfo. */
-      if (found_old_mergeinfo)
-        {
-          notify_warning(iterpool, notify_func, notify_baton,
-                         svn_repos_notify_warning_found_old_mergeinfo,
-                         _("The range of revisions dumped "
-                           "contained mergeinfo "
-                           "which reference revisions outside "
-                           "that range."));
-        }
+  if (!notify_func)
+    return;
+
+  /* Did we issue any warnings about references to revisions older than
+     the oldest dumped revision?  If so, then issue a final generic
+     warning, since the inline warnings already issued might easily be
+     missed. */
+
+  notify = svn_repos_notify_create(svn_repos_notify_dump_end, scratch_pool);
+  notify_func(notify_baton, notify, scratch_pool);
+
+  if (found_old_reference)
+    {
+      notify_warning(scratch_pool, notify_func, notify_baton,
+                     svn_repos_notify_warning_found_old_reference,
+                     _("The range of revisions dumped "
+                       "contained references to "
+                       "copy sources outside that "
+                       "range."));
     }
 
-  svn_pool_destroy(iterpool);
+  /* Ditto if we issued any warnings about old revisions referenced
+     in dumped mergeinfo. */
+  if (found_old_mergeinfo)
+    {
+      notify_warning(scratch_pool, notify_func, notify_baton,
+                     svn_repos_notify_warning_found_old_mergeinfo,
+                     _("The range of revisions dumped "
+                       "contained mergeinfo "
+                       "which reference revisions outside "
+                       "that range."));
+    }
+}
+
+/* Replace invalid *START_REV and *END_REV with the defaults for FS and
+ * make sure they describe a valid, existing range of revisions.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_dump_range(svn_revnum_t *start_rev,
+               svn_revnum_t *end_rev,
+               svn_fs_t *fs,
+               apr_pool_t *scratch_pool)
+{
+  svn_revnum_t youngest;
+
+  /* Make sure we catch up on the latest revprop changes.  This is the only
+   * time we will refresh the revprop data in this query. */
+  SVN_ERR(svn_fs_refresh_revision_props(fs, scratch_pool));
+
+  /* Determine the current youngest revision of the filesystem. */
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, scratch_pool));
+
+  /* Use default vals if necessary. */
+  if (! SVN_IS_VALID_REVNUM(*start_rev))
+    *start_rev = 0;
+  if (! SVN_IS_VALID_REVNUM(*end_rev))
+    *end_rev = youngest;
+
+  /* Validate the revisions. */
+  if (*start_rev > *end_rev)
+    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                             _("Start revision %ld"
+                               " is greater than end revision %ld"),
+                             *start_rev, *end_rev);
+  if (*end_rev > youngest)
+    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                             _("End revision %ld is invalid "
+                               "(youngest revision is %ld)"),
+                             *end_rev, youngest);
 
   return SVN_NO_ERROR;
 }
 
+/* The main dumper. */
+svn_error_t *
+svn_repos_dump_fs4(svn_repos_t *repos,
+                   svn_stream_t *stream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t incremental,
+                   svn_boolean_t use_deltas,
+                   svn_boolean_t include_revprops,
+                   svn_boolean_t include_changes,
+                   svn_repos_dump_filter_func_t filter_func,
+                   void *filter_baton,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_boolean_t found_old_reference = FALSE;
+  svn_boolean_t found_old_mergeinfo = FALSE;
+
+  SVN_ERR(get_dump_range(&start_rev, &end_rev, fs, pool));
+  if (! stream)
+    stream = svn_stream_empty(pool);
+
+  SVN_ERR(dump_range(fs, stream, start_rev, end_rev, start_rev, incremental,
+                     use_deltas, include_revprops, include_changes,
+                     filter_func, filter_baton,
+                     &found_old_reference, &found_old_mergeinfo,
+                     notify_func, notify_baton, cancel_func, cancel_baton,
+                     pool));
+
+  notify_dump_end(found_old_reference, found_old_mergeinfo,
+                  notify_func, notify_baton, pool);
+
+  return SVN_NO_ERROR;
+}
 
 /*----------------------------------------------------------------------*/
 
-/* verify, based on dump */
+/** Dumping into segments. **/
+
+/* A segmented dump consists of a directory with a number of segment files
+ * and a manifest.  Every segment is a complete dump stream covering a
+ * contiguous range of revisions.  Apart from the first one, segments are
+ * always incremental, so loading them one after another is equivalent to
+ * loading a single dump of the whole range.  The manifest lists the
+ * segments in revision order, one per line:
+ *
+ *   SVN-dump-segments: 1
+ *   <start_rev> <end_rev> <file name>
+ *   ...
+ *
+ * Segments are shard-aligned and may be written concurrently.  The
+ * manifest is written last, so its existence signals a complete dump.
+ */
 
+/* Number of revisions per job if the repository is not sharded. */
+#define DEFAULT_JOB_SIZE 1000
 
-/* Creating a new revision that changes /A/B/E/bravo means creating new
-   directory listings for /, /A, /A/B, and /A/B/E in the new revision, with
-   each entry not changed in the new revision a link back to the entry in a
-   previous revision.  svn_repos_replay()ing a revision does not verify that
-   those links are correct.
+/* Name of the manifest file within a segmented dump directory. */
+#define DUMP_MANIFEST "manifest"
 
-   For paths actually changed in the revision we verify, we get directory
-   contents or file length twice: once in the dump editor, and once here.
-   We could create a new verify baton, store in it the changed paths, and
-   skip those here, but that means building an entire wrapper editor and
-   managing two levels of batons.  The impact from checking these entries
-   twice should be minimal, while the code to avoid it is not.
-*/
+/* First line of the manifest.  Contains the manifest format number. */
+#define DUMP_MANIFEST_HEADER "SVN-dump-segments: 1"
 
+/* Return the number of revisions per shard in FS or some sensible job
+ * size for backends without shards.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
 static svn_error_t *
-verify_directory_entry(void *baton, const void *key, apr_ssize_t klen,
-                       void *val, apr_pool_t *pool)
+get_job_size(svn_revnum_t *job_size,
+             svn_fs_t *fs,
+             apr_pool_t *scratch_pool)
 {
-  struct dir_baton *db = baton;
-  svn_fs_dirent_t *dirent = (svn_fs_dirent_t *)val;
-  char *path;
-  svn_boolean_t right_kind;
+  const svn_fs_info_placeholder_t *info;
+  int shard_size = 0;
 
-  path = svn_relpath_join(db->path, (const char *)key, pool);
-
-  /* since we can't access the directory entries directly by their ID,
-     we need to navigate from the FS_ROOT to them (relatively expensive
-     because we may start at a never rev than the last change to node).
-     We check that the node kind stored in the noderev matches the dir
-     entry.  This also ensures that all entries point to valid noderevs.
-   */
-  switch (dirent->kind) {
-  case svn_node_dir:
-    SVN_ERR(svn_fs_is_dir(&right_kind, db->edit_baton->fs_root, path, pool));
-    if (!right_kind)
-      return svn_error_createf(SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
-                               _("Node '%s' is not a directory."),
-                               path);
+  SVN_ERR(svn_fs_info(&info, fs, scratch_pool, scratch_pool));
+  if (strcmp(info->fs_type, SVN_FS_TYPE_FSFS) == 0)
+    shard_size = ((const svn_fs_fsfs_info_t *)info)->shard_size;
+  else if (strcmp(info->fs_type, SVN_FS_TYPE_FSX) == 0)
+    shard_size = ((const svn_fs_fsx_info_t *)info)->shard_size;
 
-    break;
-  case svn_node_file:
-    SVN_ERR(svn_fs_is_file(&right_kind, db->edit_baton->fs_root, path, pool));
-    if (!right_kind)
-      return svn_error_createf(SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
-                               _("Node '%s' is not a file."),
-                               path);
-    break;
-  default:
-    return svn_error_createf(SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
-                             _("Unexpected node kind %d for '%s'"),
-                             dirent->kind, path);
-  }
+  *job_size = shard_size > 0 ? shard_size : DEFAULT_JOB_SIZE;
 
   return SVN_NO_ERROR;
 }
 
-/* Baton used by the check_name_collision hash iterator. */
-struct check_name_collision_baton
+/* A range of revisions to be dumped into a single segment file.
+ */
+typedef struct dump_segment_t
 {
-  struct dir_baton *dir_baton;
-  apr_hash_t *normalized;
-  svn_membuf_t buffer;
-};
+  /* Revisions to dump (inclusive). */
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
 
-/* Scan the directory and report all entry names that differ only in
-   Unicode character representation. */
-static svn_error_t *
-check_name_collision(void *baton, const void *key, apr_ssize_t klen,
-                     void *val, apr_pool_t *iterpool)
-{
-  struct check_name_collision_baton *const cb = baton;
+  /* Name of the segment file within the dump directory. */
   const char *name;
-  const char *found;
 
-  SVN_ERR(svn_utf__normalize(&name, key, klen, &cb->buffer));
+  /* Warnings to summarize at the end of the dump. */
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
 
-  found = svn_hash_gets(cb->normalized, name);
-  if (!found)
-    svn_hash_sets(cb->normalized, apr_pstrdup(cb->buffer.pool, name),
-                  normalized_unique);
-  else if (found == normalized_collision)
-    /* Skip already reported collision */;
-  else
-    {
-      struct dir_baton *const db = cb->dir_baton;
-      struct edit_baton *const eb = db->edit_baton;
-      const char* normpath;
+  /* Notifications recorded by a worker thread (svn_repos_notify_t *).
+   * NULL if the segment has been dumped by the calling thread. */
+  apr_array_header_t *notifications;
 
-      svn_hash_sets(cb->normalized, apr_pstrdup(cb->buffer.pool, name),
-                    normalized_collision);
+  /* Error that aborts the whole dump. */
+  svn_error_t *err;
 
-      SVN_ERR(svn_utf__normalize(
-                  &normpath, svn_relpath_join(db->path, name, iterpool),
+  /* Set, once the worker is done with this segment. */
+  svn_boolean_t done;
+
+  /* Pool containing NOTIFICATIONS.  NULL until the segment gets
+   * processed by a worker. */
+  apr_pool_t *pool;
+} dump_segment_t;
+
+/* Parameters of a segmented dump which are the same for all segments.
+ */
+typedef struct dump_segments_params_t
+{
+  /* Directory to write the segments to. */
+  const char *dir_path;
+
+  /* First revision of the whole dump. */
+  svn_revnum_t start_rev;
+
+  /* Parameters given to svn_repos_dump_fs_segments. */
+  svn_boolean_t incremental;
+  svn_boolean_t use_deltas;
+  svn_boolean_t include_revprops;
+  svn_boolean_t include_changes;
+  svn_repos_dump_filter_func_t filter_func;
+  void *filter_baton;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} dump_segments_params_t;
+
+/* Dump the revisions in SEGMENT from FS into the respective file as
+ * specified by PARAMS.  Send notifications to NOTIFY_FUNC / NOTIFY_BATON.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+dump_segment(dump_segment_t *segment,
+             svn_fs_t *fs,
+             const dump_segments_params_t *params,
+             svn_repos_notify_func_t notify_func,
+             void *notify_baton,
+             apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_stream_t *stream;
+  const char *path = svn_dirent_join(params->dir_path, segment->name,
+                                     scratch_pool);
+
+  SVN_ERR(svn_io_file_open(&file, path,
+                           APR_WRITE | APR_CREATE | APR_TRUNCATE
+                           | APR_BUFFERED, APR_OS_DEFAULT, scratch_pool));
+  stream = svn_stream_from_aprfile2(file, FALSE, scratch_pool);
+
+  /* Only the first segment may be a non-incremental dump. */
+  SVN_ERR(dump_range(fs, stream, segment->start_rev, segment->end_rev,
+                     params->start_rev,
+                        params->incremental
+                     || segment->start_rev != params->start_rev,
+                     params->use_deltas, params->include_revprops,
+                     params->include_changes,
+                     params->filter_func, params->filter_baton,
+                     &segment->found_old_reference,
+                     &segment->found_old_mergeinfo,
+                     notify_func, notify_baton,
+                     params->cancel_func, params->cancel_baton,
+                     scratch_pool));
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Write the manifest for the COUNT SEGMENTS to DIR_PATH.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_dump_manifest(const char *dir_path,
+                    const dump_segment_t *segments,
+                    int count,
+                    apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents
+    = svn_stringbuf_create(DUMP_MANIFEST_HEADER "\n", scratch_pool);
+  int i;
+
+  for (i = 0; i < count; ++i)
+    svn_stringbuf_appendcstr(contents,
+                             apr_psprintf(scratch_pool, "%ld %ld %s\n",
+                                          segments[i].start_rev,
+                                          segments[i].end_rev,
+                                          segments[i].name));
+
+  return svn_error_trace(svn_io_write_atomic2(
+                           svn_dirent_join(dir_path, DUMP_MANIFEST,
+                                           scratch_pool),
+                           contents->data, contents->len,
+                           NULL, TRUE, scratch_pool));
+}
+
+#if APR_HAS_THREADS
+
+/* Parallel dumping of segments.
+ *
+ * Worker threads, each with its own svn_fs_t, dump segments into their
+ * respective files and record the notifications produced.  The calling
+ * thread replays the notifications segment by segment in revision order.
+ * If one segment fails, no further segments will be started.
+ */
+
+/* Data shared between the calling thread and all worker threads.  All
+ * members after SEGMENTS must only be accessed while holding MUTEX.
+ */
+typedef struct dump_shared_t
+{
+  /* Parameters of the dump. */
+  const dump_segments_params_t *params;
+  const char *fs_path;
+  svn_boolean_t notify;
+
+  /* All segments in revision order and their number. */
+  dump_segment_t *segments;
+  int segment_count;
+
+  /* Next segment to be picked up by a worker. */
+  int next_job;
+
+  /* Next segment to be replayed by the calling thread. */
+  int next_replay;
+
+  /* Maximum number of segments that may be processed ahead of
+   * NEXT_REPLAY.  This limits the amount of recorded data in memory. */
+  int max_ahead;
+
+  /* If set, workers shall not pick up further segments. */
+  svn_boolean_t aborted;
+
+  /* Serialization and signalling of state changes. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+} dump_shared_t;
+
+/* Per worker thread data.
+ */
+typedef struct dump_worker_t
+{
+  /* Shared state. */
+  dump_shared_t *shared;
+
+  /* Private copy of the FS config. */
+  apr_hash_t *fs_config;
+
+  /* Pool for all worker-local allocations. */
+  apr_pool_t *pool;
+} dump_worker_t;
+
+/* Record a copy of NOTIFY in the dump_segment_t BATON.
+ * Implements svn_repos_notify_func_t.
+ */
+static void
+record_dump_notification(void *baton,
+                         const svn_repos_notify_t *notify,
+                         apr_pool_t *scratch_pool)
+{
+  dump_segment_t *segment = baton;
+  svn_repos_notify_t *copy = apr_pmemdup(segment->pool, notify,
+                                         sizeof(*notify));
+
+  copy->warning_str = apr_pstrdup(segment->pool, notify->warning_str);
+  copy->path = apr_pstrdup(segment->pool, notify->path);
+  APR_ARRAY_PUSH(segment->notifications, svn_repos_notify_t *) = copy;
+}
+
+/* Worker thread main function.  DATA is a dump_worker_t.  Process
+ * segments until all have been handed out or the dump got aborted.
+ */
+static void *
+APR_THREAD_FUNC dump_thread_func(apr_thread_t *tid, void *data)
+{
+  dump_worker_t *worker = data;
+  dump_shared_t *shared = worker->shared;
+  apr_pool_t *scratch_pool = svn_pool_create(worker->pool);
+  svn_fs_t *fs;
+  svn_error_t *err;
+
+  err = svn_fs_open2(&fs, shared->fs_path, worker->fs_config,
+                     worker->pool, scratch_pool);
+
+  while (TRUE)
+    {
+      dump_segment_t *segment = NULL;
+
+      apr_thread_mutex_lock(shared->mutex);
+      while (   !shared->aborted
+             && shared->next_job < shared->segment_count
+             && shared->next_job >= shared->next_replay + shared->max_ahead)
+        apr_thread_cond_wait(shared->changed, shared->mutex);
+
+      if (!shared->aborted && shared->next_job < shared->segment_count)
+        segment = &shared->segments[shared->next_job++];
+      apr_thread_mutex_unlock(shared->mutex);
+
+      if (segment == NULL)
+        break;
+
+      /* Pools for recorded data will be destroyed by the calling thread,
+       * so they must not depend on our WORKER->POOL. */
+      svn_pool_clear(scratch_pool);
+      segment->pool = svn_pool_create(NULL);
+      segment->notifications
+        = apr_array_make(segment->pool, 16, sizeof(svn_repos_notify_t *));
+
+      if (!err)
+        err = dump_segment(segment, fs, shared->params,
+                           shared->notify ? record_dump_notification : NULL,
+                           segment, scratch_pool);
+
+      apr_thread_mutex_lock(shared->mutex);
+      segment->err = err;
+      segment->done = TRUE;
+      if (err)
+        shared->aborted = TRUE;
+      apr_thread_cond_broadcast(shared->changed);
+      apr_thread_mutex_unlock(shared->mutex);
+
+      /* The error is now owned by SEGMENT. */
+      if (err)
+        break;
+    }
+
+  svn_pool_destroy(scratch_pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Release all data still held by SEGMENT.
+ */
+static void
+cleanup_dump_segment(dump_segment_t *segment)
+{
+  svn_error_clear(segment->err);
+  segment->err = SVN_NO_ERROR;
+
+  if (segment->pool)
+    svn_pool_destroy(segment->pool);
+  segment->pool = NULL;
+}
+
+/* Dump the COUNT SEGMENTS of FS as specified by PARAMS using JOBS worker
+ * threads.  Send the notifications to NOTIFY_FUNC / NOTIFY_BATON in
+ * revision order.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+dump_segments_parallel(svn_fs_t *fs,
+                       dump_segment_t *segments,
+                       int count,
+                       const dump_segments_params_t *params,
+                       int jobs,
+                       svn_repos_notify_func_t notify_func,
+                       void *notify_baton,
+                       apr_pool_t *scratch_pool)
+{
+  dump_shared_t shared = { 0 };
+  dump_worker_t *workers;
+  apr_thread_t **threads;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_t *fs_config = svn_fs_config(fs, scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status;
+  int thread_count = 0;
+  int i, k;
+
+  shared.params = params;
+  shared.fs_path = svn_fs_path(fs, scratch_pool);
+  shared.notify = notify_func != NULL;
+  shared.segments = segments;
+  shared.segment_count = count;
+  shared.max_ahead = 2 * jobs;
+
+  status = apr_thread_mutex_create(&shared.mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   scratch_pool);
+  if (!status)
+    status = apr_thread_cond_create(&shared.changed, scratch_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create dump mutex"));
+
+  /* Start the workers. */
+  jobs = MIN(jobs, count);
+  workers = apr_pcalloc(scratch_pool, jobs * sizeof(*workers));
+  threads = apr_pcalloc(scratch_pool, jobs * sizeof(*threads));
+  for (i = 0; i < jobs; ++i)
+    {
+      workers[i].shared = &shared;
+      workers[i].pool = svn_pool_create(NULL);
+      workers[i].fs_config = fs_config
+                           ? apr_hash_copy(workers[i].pool, fs_config)
+                           : NULL;
+
+      status = apr_thread_create(&threads[i], NULL, dump_thread_func,
+                                 &workers[i], scratch_pool);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, _("Can't create thread"));
+          svn_pool_destroy(workers[i].pool);
+          break;
+        }
+
+      ++thread_count;
+    }
+
+  /* Report the progress in revision order. */
+  for (i = 0; i < count && !err && thread_count > 0; ++i)
+    {
+      dump_segment_t *segment = &segments[i];
+      svn_pool_clear(iterpool);
+
+      apr_thread_mutex_lock(shared.mutex);
+      while (!segment->done)
+        apr_thread_cond_wait(shared.changed, shared.mutex);
+      apr_thread_mutex_unlock(shared.mutex);
+
+      for (k = 0; notify_func && k < segment->notifications->nelts; ++k)
+        notify_func(notify_baton,
+                    APR_ARRAY_IDX(segment->notifications, k,
+                                  svn_repos_notify_t *),
+                    iterpool);
+
+      err = segment->err;
+      segment->err = SVN_NO_ERROR;
+      cleanup_dump_segment(segment);
+
+      apr_thread_mutex_lock(shared.mutex);
+      shared.next_replay = i + 1;
+      apr_thread_cond_broadcast(shared.changed);
+      apr_thread_mutex_unlock(shared.mutex);
+    }
+
+  /* Stop all workers and release what they left behind. */
+  apr_thread_mutex_lock(shared.mutex);
+  shared.aborted = TRUE;
+  apr_thread_cond_broadcast(shared.changed);
+  apr_thread_mutex_unlock(shared.mutex);
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, threads[i]);
+      svn_pool_destroy(workers[i].pool);
+    }
+
+  for (i = 0; i < count; ++i)
+    cleanup_dump_segment(&segments[i]);
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_repos_dump_fs_segments(svn_repos_t *repos,
+                           const char *dir_path,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           svn_boolean_t incremental,
+                           svn_boolean_t use_deltas,
+                           svn_boolean_t include_revprops,
+                           svn_boolean_t include_changes,
+                           svn_repos_dump_filter_func_t filter_func,
+                           void *filter_baton,
+                           int jobs,
+                           svn_repos_notify_func_t notify_func,
+                           void *notify_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  dump_segments_params_t params = { 0 };
+  dump_segment_t *segments;
+  svn_boolean_t found_old_reference = FALSE;
+  svn_boolean_t found_old_mergeinfo = FALSE;
+  svn_revnum_t job_size, rev;
+  apr_pool_t *iterpool;
+  int count;
+  int i;
+
+  SVN_ERR(get_dump_range(&start_rev, &end_rev, fs, pool));
+  SVN_ERR(svn_io_make_dir_recursively(dir_path, pool));
+
+  /* A stale manifest would refer to a mix of old and new segments. */
+  SVN_ERR(svn_io_remove_file2(svn_dirent_join(dir_path, DUMP_MANIFEST,
+                                              pool),
+                              TRUE, pool));
+
+  /* Split the range into shard-aligned segments. */
+  SVN_ERR(get_job_size(&job_size, fs, pool));
+  count = (int)(end_rev / job_size - start_rev / job_size + 1);
+  segments = apr_pcalloc(pool, count * sizeof(*segments));
+  for (i = 0, rev = start_rev; i < count; ++i)
+    {
+      segments[i].start_rev = rev;
+      rev = (rev / job_size + 1) * job_size;
+      segments[i].end_rev = MIN(rev - 1, end_rev);
+      segments[i].name = apr_psprintf(pool, "%ld-%ld.dump",
+                                      segments[i].start_rev,
+                                      segments[i].end_rev);
+    }
+
+  params.dir_path = dir_path;
+  params.start_rev = start_rev;
+  params.incremental = incremental;
+  params.use_deltas = use_deltas;
+  params.include_revprops = include_revprops;
+  params.include_changes = include_changes;
+  params.filter_func = filter_func;
+  params.filter_baton = filter_baton;
+  params.cancel_func = cancel_func;
+  params.cancel_baton = cancel_baton;
+
+#if APR_HAS_THREADS
+  if (jobs > 1 && count > 1)
+    {
+      SVN_ERR(dump_segments_parallel(fs, segments, count, &params, jobs,
+                                     notify_func, notify_baton, pool));
+    }
+  else
+#endif
+    {
+      iterpool = svn_pool_create(pool);
+      for (i = 0; i < count; ++i)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(dump_segment(&segments[i], fs, &params,
+                               notify_func, notify_baton, iterpool));
+        }
+      svn_pool_destroy(iterpool);
+    }
+
+  for (i = 0; i < count; ++i)
+    {
+      found_old_reference |= segments[i].found_old_reference;
+      found_old_mergeinfo |= segments[i].found_old_mergeinfo;
+    }
+
+  SVN_ERR(write_dump_manifest(dir_path, segments, count, pool));
+  notify_dump_end(found_old_reference, found_old_mergeinfo,
+                  notify_func, notify_baton, pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__read_dump_manifest(apr_array_header_t **segments,
+                              const char *dir_path,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  const char *path = svn_dirent_join(dir_path, DUMP_MANIFEST, scratch_pool);
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  svn_revnum_t next_rev = SVN_INVALID_REVNUM;
+  int i;
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, path, scratch_pool));
+  lines = svn_cstring_split(contents->data, "\n", TRUE, scratch_pool);
+
+  if (   lines->nelts == 0
+      || strcmp(APR_ARRAY_IDX(lines, 0, const char *),
+                DUMP_MANIFEST_HEADER) != 0)
+    return svn_error_createf(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                             _("'%s' is not a dump manifest"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  *segments = apr_array_make(result_pool, lines->nelts - 1,
+                             sizeof(const char *));
+  for (i = 1; i < lines->nelts; ++i)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      apr_array_header_t *fields = svn_cstring_split(line, " ", TRUE,
+                                                     scratch_pool);
+      svn_revnum_t start_rev, end_rev;
+      const char *name;
+
+      if (fields->nelts != 3)
+        return svn_error_createf(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                                 _("Malformed line %d in dump manifest "
+                                   "'%s'"), i + 1,
+                                 svn_dirent_local_style(path,
+                                                        scratch_pool));
+
+      SVN_ERR(svn_revnum_parse(&start_rev,
+                               APR_ARRAY_IDX(fields, 0, const char *),
+                               NULL));
+      SVN_ERR(svn_revnum_parse(&end_rev,
+                               APR_ARRAY_IDX(fields, 1, const char *),
+                               NULL));
+      name = APR_ARRAY_IDX(fields, 2, const char *);
+
+      /* Segments must be contiguous and must stay within DIR_PATH. */
+      if (   start_rev > end_rev
+          || (SVN_IS_VALID_REVNUM(next_rev) && start_rev != next_rev)
+          || !svn_dirent_is_canonical(name, scratch_pool)
+          || strcmp(svn_dirent_basename(name, NULL), name) != 0)
+        return svn_error_createf(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                                 _("Invalid segment '%s' in dump manifest "
+                                   "'%s'"), line,
+                                 svn_dirent_local_style(path,
+                                                        scratch_pool));
+
+      next_rev = end_rev + 1;
+      APR_ARRAY_PUSH(*segments, const char *)
+        = svn_dirent_join(dir_path, name, result_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/*----------------------------------------------------------------------*/
+
+/* verify, based on dump */
+
+
+/* Creating a new revision that changes /A/B/E/bravo means creating new
+   directory listings for /, /A, /A/B, and /A/B/E in the new revision, with
+   each entry not changed in the new revision a link back to the entry in a
+   previous revision.  svn_repos_replay()ing a revision does not verify that
+   those links are correct.
+
+   For paths actually changed in the revision we verify, we get directory
+   contents or file length twice: once in the dump editor, and once here.
+   We could create a new verify baton, store in it the changed paths, and
+   skip those here, but that means building an entire wrapper editor and
+   managing two levels of batons.  The impact from checking these entries
+   twice should be minimal, while the code to avoid it is not.
+*/
+
+static svn_error_t *
+verify_directory_entry(void *baton, const void *key, apr_ssize_t klen,
+                       void *val, apr_pool_t *pool)
+{
+  struct dir_baton *db = baton;
+  svn_fs_dirent_t *dirent = (svn_fs_dirent_t *)val;
+  char *path;
+  svn_boolean_t right_kind;
+
+  path = svn_relpath_join(db->path, (const char *)key, pool);
+
+  /* since we can't access the directory entries directly by their ID,
+     we need to navigate from the FS_ROOT to them (relatively expensive
+     because we may start at a never rev than the last change to node).
+     We check that the node kind stored in the noderev matches the dir
+     entry.  This also ensures that all entries point to valid noderevs.
+   */
+  switch (dirent->kind) {
+  case svn_node_dir:
+    SVN_ERR(svn_fs_is_dir(&right_kind, db->edit_baton->fs_root, path, pool));
+    if (!right_kind)
+      return svn_error_createf(SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
+                               _("Node '%s' is not a directory."),
+                               path);
+
+    break;
+  case svn_node_file:
+    SVN_ERR(svn_fs_is_file(&right_kind, db->edit_baton->fs_root, path, pool));
+    if (!right_kind)
+      return svn_error_createf(SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
+                               _("Node '%s' is not a file."),
+                               path);
+    break;
+  default:
+    return svn_error_createf(SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
+                             _("Unexpected node kind %d for '%s'"),
+                             dirent->kind, path);
+  }
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton used by the check_name_collision hash iterator. */
+struct check_name_collision_baton
+{
+  struct dir_baton *dir_baton;
+  apr_hash_t *normalized;
+  svn_membuf_t buffer;
+};
+
+/* Scan the directory and report all entry names that differ only in
+   Unicode character representation. */
+static svn_error_t *
+check_name_collision(void *baton, const void *key, apr_ssize_t klen,
+                     void *val, apr_pool_t *iterpool)
+{
+  struct check_name_collision_baton *const cb = baton;
+  const char *name;
+  const char *found;
+
+  SVN_ERR(svn_utf__normalize(&name, key, klen, &cb->buffer));
+
+  found = svn_hash_gets(cb->normalized, name);
+  if (!found)
+    svn_hash_sets(cb->normalized, apr_pstrdup(cb->buffer.pool, name),
+                  normalized_unique);
+  else if (found == normalized_collision)
+    /* Skip already reported collision */;
+  else
+    {
+      struct dir_baton *const db = cb->dir_baton;
+      struct edit_baton *const eb = db->edit_baton;
+      const char* normpath;
+
+      svn_hash_sets(cb->normalized, apr_pstrdup(cb->buffer.pool, name),
+                    normalized_collision);
+
+      SVN_ERR(svn_utf__normalize(
+                  &normpath, svn_relpath_join(db->path, name, iterpool),
                   SVN_UTF__UNKNOWN_LENGTH, &cb->buffer));
       notify_warning(iterpool, eb->notify_func, eb->notify_baton,
                      svn_repos_notify_warning_name_collision,
@@ -2391,12 +3172,497 @@ report_error(svn_revnum_t revision,
     }
 }
 
+#if APR_HAS_THREADS
+
+/* Parallel verification.
+ *
+ * The revision range gets split into shard-aligned jobs.  A number of
+ * worker threads, each with its own svn_fs_t, verify these jobs and
+ * record the notifications and failures that they produce.  The calling
+ * thread then replays them job by job in revision order.  Like the
+ * sequential code, we verify the backend-specific metadata for all jobs
+ * first and then the revision contents, so callers see the same sequence
+ * of callbacks as with sequential verification.
+ */
+
+/* A notification or verification failure recorded by a worker thread.
+ */
+typedef struct verify_event_t
+{
+  /* Notification to send.  NULL for failures. */
+  svn_repos_notify_t *notify;
+
+  /* Revision that this event refers to or SVN_INVALID_REVNUM. */
+  svn_revnum_t revision;
+
+  /* Failure to report.  Will be reset to NULL once it has been passed on.
+   * Only used if NOTIFY is NULL. */
+  svn_error_t *err;
+} verify_event_t;
+
+/* A range of revisions to be verified by a single worker thread.
+ */
+typedef struct verify_job_t
+{
+  /* Revisions to verify (inclusive). */
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+
+  /* Recorded events in the order they occurred (verify_event_t). */
+  apr_array_header_t *events;
+
+  /* Error that aborts the whole verification, e.g. cancellation. */
+  svn_error_t *fatal_err;
+
+  /* Set, once the worker is done with this job. */
+  svn_boolean_t done;
+
+  /* Pool containing EVENTS.  NULL until the job gets processed. */
+  apr_pool_t *pool;
+} verify_job_t;
+
+/* Data shared between the calling thread and all worker threads.  All
+ * members after JOBS must only be accessed while holding MUTEX.
+ */
+typedef struct verify_shared_t
+{
+  /* If set, run svn_fs_verify for each job.  Otherwise, verify the
+   * contents of each revision. */
+  svn_boolean_t verify_metadata;
+
+  /* Parameters given to svn_repos_verify_fs4. */
+  const char *fs_path;
+  svn_revnum_t start_rev;
+  svn_boolean_t check_normalization;
+  svn_boolean_t notify;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* All jobs in revision order and their number. */
+  verify_job_t *jobs;
+  int job_count;
+
+  /* Next job to be picked up by a worker. */
+  int next_job;
+
+  /* Next job to be replayed by the calling thread. */
+  int next_replay;
+
+  /* Maximum number of jobs that may be processed ahead of NEXT_REPLAY.
+   * This limits the amount of recorded data in memory. */
+  int max_ahead;
+
+  /* If set, workers shall not pick up further jobs. */
+  svn_boolean_t aborted;
+
+  /* Serialization and signalling of state changes. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+} verify_shared_t;
+
+/* Per worker thread data.
+ */
+typedef struct verify_worker_t
+{
+  /* Shared state. */
+  verify_shared_t *shared;
+
+  /* Private copy of the FS config. */
+  apr_hash_t *fs_config;
+
+  /* Pool for all worker-local allocations. */
+  apr_pool_t *pool;
+} verify_worker_t;
+
+/* Record a copy of NOTIFY in the verify_job_t BATON.
+ * Implements svn_repos_notify_func_t.
+ */
+static void
+record_notification(void *baton,
+                    const svn_repos_notify_t *notify,
+                    apr_pool_t *scratch_pool)
+{
+  verify_job_t *job = baton;
+  verify_event_t *event = apr_array_push(job->events);
+
+  event->notify = apr_pmemdup(job->pool, notify, sizeof(*notify));
+  event->notify->warning_str = apr_pstrdup(job->pool, notify->warning_str);
+  event->notify->path = apr_pstrdup(job->pool, notify->path);
+  event->revision = notify->revision;
+  event->err = SVN_NO_ERROR;
+}
+
+/* Record a structure verification notification for REVISION in the
+ * verify_job_t BATON.  Implements svn_fs_progress_notify_func_t.
+ */
+static void
+record_fs_notification(svn_revnum_t revision,
+                       void *baton,
+                       apr_pool_t *pool)
+{
+  verify_job_t *job = baton;
+  verify_event_t *event = apr_array_push(job->events);
+
+  event->notify
+    = svn_repos_notify_create(svn_repos_notify_verify_rev_structure,
+                              job->pool);
+  event->notify->revision = revision;
+  event->revision = revision;
+  event->err = SVN_NO_ERROR;
+}
+
+/* Record the verification failure ERR for REVISION in JOB.
+ */
+static void
+record_error(verify_job_t *job,
+             svn_revnum_t revision,
+             svn_error_t *err)
+{
+  verify_event_t *event = apr_array_push(job->events);
+
+  event->notify = NULL;
+  event->revision = revision;
+  event->err = err;
+}
+
+/* Verify the metadata or revisions covered by JOB in FS, as selected by
+ * WORKER->SHARED->VERIFY_METADATA, and record all notifications and
+ * failures in JOB.  FS may be NULL for metadata verification.  Return
+ * fatal errors such as cancellation.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+process_verify_job(verify_job_t *job,
+                   verify_worker_t *worker,
+                   svn_fs_t *fs,
+                   apr_pool_t *scratch_pool)
+{
+  verify_shared_t *shared = worker->shared;
+  svn_revnum_t rev;
+  svn_error_t *err;
+  apr_pool_t *iterpool;
+
+  /* Backend-specific checks for this range. */
+  if (shared->verify_metadata)
+    {
+      err = svn_fs_verify(shared->fs_path, worker->fs_config,
+                          job->start_rev, job->end_rev,
+                          shared->notify ? record_fs_notification : NULL,
+                          job, shared->cancel_func, shared->cancel_baton,
+                          scratch_pool);
+      if (err && err->apr_err == SVN_ERR_CANCELLED)
+        return svn_error_trace(err);
+      else if (err)
+        record_error(job, SVN_INVALID_REVNUM, err);
+
+      return SVN_NO_ERROR;
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = job->start_rev; rev <= job->end_rev; rev++)
+    {
+      svn_boolean_t aborted;
+
+      svn_pool_clear(iterpool);
+
+      /* Don't waste time if the caller already gave up. */
+      apr_thread_mutex_lock(shared->mutex);
+      aborted = shared->aborted;
+      apr_thread_mutex_unlock(shared->mutex);
+      if (aborted)
+        break;
+
+      err = verify_one_revision(fs, rev,
+                                shared->notify ? record_notification : NULL,
+                                job, shared->start_rev,
+                                shared->check_normalization,
+                                shared->cancel_func, shared->cancel_baton,
+                                iterpool);
+
+      if (err && err->apr_err == SVN_ERR_CANCELLED)
+        {
+          return svn_error_trace(err);
+        }
+      else if (err)
+        {
+          record_error(job, rev, err);
+        }
+      else if (shared->notify)
+        {
+          verify_event_t *event = apr_array_push(job->events);
+          event->notify
+            = svn_repos_notify_create(svn_repos_notify_verify_rev_end,
+                                      job->pool);
+          event->notify->revision = rev;
+          event->revision = rev;
+          event->err = SVN_NO_ERROR;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Worker thread main function.  DATA is a verify_worker_t.  Process jobs
+ * until all have been handed out or the verification got aborted.
+ */
+static void *
+APR_THREAD_FUNC verify_thread_func(apr_thread_t *tid, void *data)
+{
+  verify_worker_t *worker = data;
+  verify_shared_t *shared = worker->shared;
+  apr_pool_t *scratch_pool = svn_pool_create(worker->pool);
+  svn_fs_t *fs = NULL;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (!shared->verify_metadata)
+    err = svn_fs_open2(&fs, shared->fs_path, worker->fs_config,
+                       worker->pool, scratch_pool);
+
+  while (TRUE)
+    {
+      verify_job_t *job = NULL;
+
+      apr_thread_mutex_lock(shared->mutex);
+      while (   !shared->aborted
+             && shared->next_job < shared->job_count
+             && shared->next_job >= shared->next_replay + shared->max_ahead)
+        apr_thread_cond_wait(shared->changed, shared->mutex);
+
+      if (!shared->aborted && shared->next_job < shared->job_count)
+        job = &shared->jobs[shared->next_job++];
+      apr_thread_mutex_unlock(shared->mutex);
+
+      if (job == NULL)
+        break;
+
+      /* Pools for recorded data will be destroyed by the calling thread,
+       * so they must not depend on our WORKER->POOL. */
+      svn_pool_clear(scratch_pool);
+      job->pool = svn_pool_create(NULL);
+      job->events = apr_array_make(job->pool, 16, sizeof(verify_event_t));
+
+      if (!err)
+        err = process_verify_job(job, worker, fs, scratch_pool);
+
+      apr_thread_mutex_lock(shared->mutex);
+      job->fatal_err = err;
+      job->done = TRUE;
+      apr_thread_cond_broadcast(shared->changed);
+      apr_thread_mutex_unlock(shared->mutex);
+
+      /* The fatal error is now owned by JOB. */
+      if (err)
+        break;
+    }
+
+  svn_pool_destroy(scratch_pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Send all events recorded in JOB to NOTIFY_FUNC / NOTIFY_BATON and
+ * VERIFY_CALLBACK / VERIFY_BATON, respectively.  Return the fatal error
+ * of JOB, if any.  The checks of repository-global metadata run once per
+ * job but shall only be announced once.  Skip these notifications unless
+ * IS_LAST is set.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+replay_verify_job(verify_job_t *job,
+                  svn_boolean_t is_last,
+                  svn_repos_notify_func_t notify_func,
+                  void *notify_baton,
+                  svn_repos_verify_callback_t verify_callback,
+                  void *verify_baton,
+                  apr_pool_t *scratch_pool)
+{
+  int i;
+  svn_error_t *err;
+
+  for (i = 0; i < job->events->nelts; ++i)
+    {
+      verify_event_t *event = &APR_ARRAY_IDX(job->events, i,
+                                             verify_event_t);
+      if (event->notify)
+        {
+          svn_boolean_t is_global
+            =    event->notify->action
+                   == svn_repos_notify_verify_rev_structure
+              && !SVN_IS_VALID_REVNUM(event->revision);
+
+          if (notify_func && (is_last || !is_global))
+            notify_func(notify_baton, event->notify, scratch_pool);
+        }
+      else
+        {
+          err = event->err;
+          event->err = SVN_NO_ERROR;
+          SVN_ERR(report_error(event->revision, err, verify_callback,
+                               verify_baton, scratch_pool));
+        }
+    }
+
+  err = job->fatal_err;
+  job->fatal_err = SVN_NO_ERROR;
+
+  return svn_error_trace(err);
+}
+
+/* Release all data still held by JOB.
+ */
+static void
+cleanup_verify_job(verify_job_t *job)
+{
+  int i;
+
+  if (job->pool == NULL)
+    return;
+
+  for (i = 0; i < job->events->nelts; ++i)
+    svn_error_clear(APR_ARRAY_IDX(job->events, i, verify_event_t).err);
+
+  svn_error_clear(job->fatal_err);
+  svn_pool_destroy(job->pool);
+  job->pool = NULL;
+}
+
+/* Implement the metadata verification part (if VERIFY_METADATA is set)
+ * or the revision contents verification part of svn_repos_verify_fs4 for
+ * FS using JOBS worker threads.  All other parameters are the same as for
+ * svn_repos_verify_fs4.
+ */
+static svn_error_t *
+verify_fs_parallel(svn_fs_t *fs,
+                   svn_boolean_t verify_metadata,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t check_normalization,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_repos_verify_callback_t verify_callback,
+                   void *verify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool)
+{
+  verify_shared_t shared = { 0 };
+  verify_worker_t *workers;
+  apr_thread_t **threads;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_t *fs_config = svn_fs_config(fs, scratch_pool);
+  svn_revnum_t job_size, rev;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status;
+  int thread_count = 0;
+  int i;
+
+  /* Split the range into shard-aligned jobs. */
+  SVN_ERR(get_job_size(&job_size, fs, scratch_pool));
+  shared.job_count = (int)(end_rev / job_size - start_rev / job_size + 1);
+  shared.jobs = apr_pcalloc(scratch_pool,
+                            shared.job_count * sizeof(*shared.jobs));
+  for (i = 0, rev = start_rev; i < shared.job_count; ++i)
+    {
+      shared.jobs[i].start_rev = rev;
+      rev = (rev / job_size + 1) * job_size;
+      shared.jobs[i].end_rev = MIN(rev - 1, end_rev);
+    }
+
+  shared.verify_metadata = verify_metadata;
+  shared.fs_path = svn_fs_path(fs, scratch_pool);
+  shared.start_rev = start_rev;
+  shared.check_normalization = check_normalization;
+  shared.notify = notify_func != NULL;
+  shared.cancel_func = cancel_func;
+  shared.cancel_baton = cancel_baton;
+  shared.max_ahead = 2 * jobs;
+
+  status = apr_thread_mutex_create(&shared.mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   scratch_pool);
+  if (!status)
+    status = apr_thread_cond_create(&shared.changed, scratch_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create verification mutex"));
+
+  /* Start the workers. */
+  jobs = MIN(jobs, shared.job_count);
+  workers = apr_pcalloc(scratch_pool, jobs * sizeof(*workers));
+  threads = apr_pcalloc(scratch_pool, jobs * sizeof(*threads));
+  for (i = 0; i < jobs; ++i)
+    {
+      workers[i].shared = &shared;
+      workers[i].pool = svn_pool_create(NULL);
+      workers[i].fs_config = fs_config
+                           ? apr_hash_copy(workers[i].pool, fs_config)
+                           : NULL;
+
+      status = apr_thread_create(&threads[i], NULL, verify_thread_func,
+                                 &workers[i], scratch_pool);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, _("Can't create thread"));
+          svn_pool_destroy(workers[i].pool);
+          break;
+        }
+
+      ++thread_count;
+    }
+
+  /* Report the results in revision order. */
+  for (i = 0; i < shared.job_count && !err; ++i)
+    {
+      verify_job_t *job = &shared.jobs[i];
+      svn_pool_clear(iterpool);
+
+      apr_thread_mutex_lock(shared.mutex);
+      while (!job->done)
+        apr_thread_cond_wait(shared.changed, shared.mutex);
+      apr_thread_mutex_unlock(shared.mutex);
+
+      err = replay_verify_job(job, i + 1 == shared.job_count,
+                              notify_func, notify_baton,
+                              verify_callback, verify_baton, iterpool);
+      cleanup_verify_job(job);
+
+      apr_thread_mutex_lock(shared.mutex);
+      shared.next_replay = i + 1;
+      apr_thread_cond_broadcast(shared.changed);
+      apr_thread_mutex_unlock(shared.mutex);
+    }
+
+  /* Stop all workers and release what they left behind. */
+  apr_thread_mutex_lock(shared.mutex);
+  shared.aborted = TRUE;
+  apr_thread_cond_broadcast(shared.changed);
+  apr_thread_mutex_unlock(shared.mutex);
+
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, threads[i]);
+      svn_pool_destroy(workers[i].pool);
+    }
+
+  for (i = 0; i < shared.job_count; ++i)
+    cleanup_verify_job(&shared.jobs[i]);
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
 svn_error_t *
-svn_repos_verify_fs3(svn_repos_t *repos,
+svn_repos_verify_fs4(svn_repos_t *repos,
                      svn_revnum_t start_rev,
                      svn_revnum_t end_rev,
                      svn_boolean_t check_normalization,
                      svn_boolean_t metadata_only,
+                     int jobs,
                      svn_repos_notify_func_t notify_func,
                      void *notify_baton,
                      svn_repos_verify_callback_t verify_callback,
@@ -2439,6 +3705,35 @@ svn_repos_verify_fs3(svn_repos_t *repos,
                                "(youngest revision is %ld)"),
                              end_rev, youngest);
 
+#if APR_HAS_THREADS
+  /* Spread the work across multiple threads. */
+  if (jobs > 1 && start_rev < end_rev)
+    {
+      SVN_ERR(verify_fs_parallel(fs, TRUE, start_rev, end_rev,
+                                 check_normalization, jobs,
+                                 notify_func, notify_baton,
+                                 verify_callback, verify_baton,
+                                 cancel_func, cancel_baton, iterpool));
+      if (!metadata_only)
+        SVN_ERR(verify_fs_parallel(fs, FALSE, start_rev, end_rev,
+                                   check_normalization, jobs,
+                                   notify_func, notify_baton,
+                                   verify_callback, verify_baton,
+                                   cancel_func, cancel_baton, iterpool));
+
+      /* We're done. */
+      if (notify_func)
+        {
+          notify = svn_repos_notify_create(svn_repos_notify_verify_end,
+                                           iterpool);
+          notify_func(notify_baton, notify, iterpool);
+        }
+
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+#endif
+
   /* Create a notify object that we can reuse within the loop and a
      forwarding structure for notifications from inside svn_fs_verify(). */
   if (notify_func)
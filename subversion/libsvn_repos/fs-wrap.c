@@ -39,6 +39,7 @@
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_fs_private.h"
 
 
 /*** Commit wrappers ***/
@@ -128,10 +129,11 @@ svn_repos_fs_commit_txn(const char **conflict_p,
 
 
 svn_error_t *
-svn_repos_fs_begin_txn_for_commit2(svn_fs_txn_t **txn_p,
+svn_repos__fs_begin_txn_for_commit(svn_fs_txn_t **txn_p,
                                    svn_repos_t *repos,
                                    svn_revnum_t rev,
                                    apr_hash_t *revprop_table,
+                                   svn_boolean_t in_process,
                                    apr_pool_t *pool)
 {
   apr_array_header_t *revprops;
@@ -140,15 +142,23 @@ svn_repos_fs_begin_txn_for_commit2(svn_fs_txn_t **txn_p,
   apr_hash_t *hooks_env;
   svn_error_t *err;
   svn_fs_txn_t *txn;
+  apr_uint32_t flags = SVN_FS_TXN_CHECK_LOCKS;
 
   /* Parse the hooks-env file (if any). */
   SVN_ERR(svn_repos__parse_hooks_env(&hooks_env, repos->hooks_env_path,
                                      pool, pool));
 
+  /* Hook scripts run in a separate process and may inspect the txn. */
+  if (in_process
+      && !svn_repos__hook_exists(svn_repos_start_commit_hook(repos, pool),
+                                 pool)
+      && !svn_repos__hook_exists(svn_repos_pre_commit_hook(repos, pool),
+                                 pool))
+    flags |= SVN_FS_TXN__IN_MEMORY;
+
   /* Begin the transaction, ask for the fs to do on-the-fly lock checks.
      We fetch its name, too, so the start-commit hook can use it.  */
-  SVN_ERR(svn_fs_begin_txn2(&txn, repos->fs, rev,
-                            SVN_FS_TXN_CHECK_LOCKS, pool));
+  SVN_ERR(svn_fs_begin_txn2(&txn, repos->fs, rev, flags, pool));
   err = svn_fs_txn_name(&txn_name, txn, pool);
   if (err)
     return svn_error_compose_create(err, svn_fs_abort_txn(txn, pool));
@@ -174,6 +184,19 @@ svn_repos_fs_begin_txn_for_commit2(svn_fs_txn_t **txn_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_repos_fs_begin_txn_for_commit2(svn_fs_txn_t **txn_p,
+                                   svn_repos_t *repos,
+                                   svn_revnum_t rev,
+                                   apr_hash_t *revprop_table,
+                                   apr_pool_t *pool)
+{
+  return svn_error_trace(svn_repos__fs_begin_txn_for_commit(txn_p, repos,
+                                                            rev,
+                                                            revprop_table,
+                                                            FALSE, pool));
+}
+
 
 svn_error_t *
 svn_repos_fs_begin_txn_for_commit(svn_fs_txn_t **txn_p,
@@ -582,8 +605,17 @@ svn_repos_fs_lock_many(svn_repos_t *repos,
        "Cannot lock path, no authenticated username available.");
 
   /* Run pre-lock hook.  This could throw error, preventing
-     svn_fs_lock2() from happening for that path. */
-  for (hi = apr_hash_first(scratch_pool, targets); hi; hi = apr_hash_next(hi))
+     svn_fs_lock2() from happening for that path.  The hook interface
+     takes a single path, so it has to run once per target; look it up
+     once for the whole batch and pass all targets straight through if
+     it is not installed. */
+  if (!svn_repos__hook_exists(svn_repos_pre_lock_hook(repos, scratch_pool),
+                              scratch_pool))
+    pre_targets = targets;
+
+  for (hi = apr_hash_first(scratch_pool, targets);
+       hi && pre_targets != targets;
+       hi = apr_hash_next(hi))
     {
       const char *new_token;
       svn_fs_lock_target_t *target;
@@ -741,8 +773,15 @@ svn_repos_fs_unlock_many(svn_repos_t *repos,
        _("Cannot unlock, no authenticated username available"));
 
   /* Run pre-unlock hook.  This could throw error, preventing
-     svn_fs_unlock_many() from happening for that path. */
-  for (hi = apr_hash_first(scratch_pool, targets); hi; hi = apr_hash_next(hi))
+     svn_fs_unlock_many() from happening for that path.  As with the
+     pre-lock hook, skip the per-path runs if it is not installed. */
+  if (!svn_repos__hook_exists(svn_repos_pre_unlock_hook(repos, scratch_pool),
+                              scratch_pool))
+    pre_targets = targets;
+
+  for (hi = apr_hash_first(scratch_pool, targets);
+       hi && pre_targets != targets;
+       hi = apr_hash_next(hi))
     {
       const char *path = apr_hash_this_key(hi);
       const char *token = apr_hash_this_val(hi);
@@ -26,6 +26,7 @@
 
 #include <apr_pools.h>
 #include <apr_file_io.h>
+#include <apr_network_io.h>
 
 #include "svn_config.h"
 #include "svn_hash.h"
@@ -34,17 +35,81 @@
 #include "svn_path.h"
 #include "svn_pools.h"
 #include "svn_repos.h"
+#include "svn_sorts.h"
 #include "svn_utf.h"
 #include "repos.h"
 #include "svn_private_config.h"
+#include "private/svn_atomic.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_mutex.h"
 #include "private/svn_repos_private.h"
+#include "private/svn_skel.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
 
 
 
 /*** Hook drivers. ***/
 
+/* Return an SVN_ERR_REPOS_HOOK_FAILURE error for hook NAME having
+   terminated for reason EXITWHY with EXITCODE, including its UTF-8
+   encoded error output UTF8_STDERR in the message. */
+static svn_error_t *
+hook_failure_error(const char *name,
+                   apr_exit_why_e exitwhy,
+                   int exitcode,
+                   const char *utf8_stderr,
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *failure_message;
+
+  if (!APR_PROC_CHECK_EXIT(exitwhy))
+    {
+      failure_message = svn_stringbuf_createf(pool,
+        _("'%s' hook failed (did not exit cleanly: "
+          "apr_exit_why_e was %d, exitcode was %d).  "),
+        name, exitwhy, exitcode);
+    }
+  else
+    {
+      const char *action;
+      if (strcmp(name, "start-commit") == 0
+          || strcmp(name, "pre-commit") == 0)
+        action = _("Commit");
+      else if (strcmp(name, "pre-revprop-change") == 0)
+        action = _("Revprop change");
+      else if (strcmp(name, "pre-lock") == 0)
+        action = _("Lock");
+      else if (strcmp(name, "pre-unlock") == 0)
+        action = _("Unlock");
+      else
+        action = NULL;
+      if (action == NULL)
+        failure_message = svn_stringbuf_createf(
+            pool, _("%s hook failed (exit code %d)"),
+            name, exitcode);
+      else
+        failure_message = svn_stringbuf_createf(
+            pool, _("%s blocked by %s hook (exit code %d)"),
+            action, name, exitcode);
+    }
+
+  if (utf8_stderr[0])
+    {
+      svn_stringbuf_appendcstr(failure_message,
+                               _(" with output:\n"));
+      svn_stringbuf_appendcstr(failure_message, utf8_stderr);
+    }
+  else
+    {
+      svn_stringbuf_appendcstr(failure_message,
+                               _(" with no output."));
+    }
+
+  return svn_error_create(SVN_ERR_REPOS_HOOK_FAILURE, NULL,
+                          failure_message->data);
+}
+
 /* Helper function for run_hook_cmd().  Wait for a hook to finish
    executing and return either SVN_NO_ERROR if the hook script completed
    without error, or an error describing the reason for failure.
@@ -66,7 +131,7 @@ check_hook_result(const char *name, const char *cmd, apr_proc_t *cmd_proc,
                   apr_file_t *read_errhandle, apr_pool_t *pool)
 {
   svn_error_t *err, *err2;
-  svn_stringbuf_t *native_stderr, *failure_message;
+  svn_stringbuf_t *native_stderr;
   const char *utf8_stderr;
   int exitcode;
   apr_exit_why_e exitwhy;
@@ -115,51 +180,7 @@ check_hook_result(const char *name, const char *cmd, apr_proc_t *cmd_proc,
         error in the messages above before we clear it here. */
   svn_error_clear(err2);
 
-  if (!APR_PROC_CHECK_EXIT(exitwhy))
-    {
-      failure_message = svn_stringbuf_createf(pool,
-        _("'%s' hook failed (did not exit cleanly: "
-          "apr_exit_why_e was %d, exitcode was %d).  "),
-        name, exitwhy, exitcode);
-    }
-  else
-    {
-      const char *action;
-      if (strcmp(name, "start-commit") == 0
-          || strcmp(name, "pre-commit") == 0)
-        action = _("Commit");
-      else if (strcmp(name, "pre-revprop-change") == 0)
-        action = _("Revprop change");
-      else if (strcmp(name, "pre-lock") == 0)
-        action = _("Lock");
-      else if (strcmp(name, "pre-unlock") == 0)
-        action = _("Unlock");
-      else
-        action = NULL;
-      if (action == NULL)
-        failure_message = svn_stringbuf_createf(
-            pool, _("%s hook failed (exit code %d)"),
-            name, exitcode);
-      else
-        failure_message = svn_stringbuf_createf(
-            pool, _("%s blocked by %s hook (exit code %d)"),
-            action, name, exitcode);
-    }
-
-  if (utf8_stderr[0])
-    {
-      svn_stringbuf_appendcstr(failure_message,
-                               _(" with output:\n"));
-      svn_stringbuf_appendcstr(failure_message, utf8_stderr);
-    }
-  else
-    {
-      svn_stringbuf_appendcstr(failure_message,
-                               _(" with no output."));
-    }
-
-  return svn_error_create(SVN_ERR_REPOS_HOOK_FAILURE, err,
-                          failure_message->data);
+  return hook_failure_error(name, exitwhy, exitcode, utf8_stderr, pool);
 }
 
 /* Copy the environment given as key/value pairs of ENV_HASH into
@@ -193,14 +214,202 @@ env_from_env_hash(apr_hash_t *env_hash,
   return env;
 }
 
+/* Create a temporary file F that will automatically be deleted when the
+   pool is cleaned up.  Fill it with VALUE, and leave it open and rewound,
+   ready to be read from. */
+static svn_error_t *
+create_temp_file(apr_file_t **f, const svn_string_t *value, apr_pool_t *pool)
+{
+  apr_off_t offset = 0;
+
+  SVN_ERR(svn_io_open_unique_file3(f, NULL, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   pool, pool));
+  SVN_ERR(svn_io_file_write_full(*f, value->data, value->len, NULL, pool));
+  return svn_io_file_seek(*f, APR_SET, &offset, pool);
+}
+
+#ifdef APR_UNIX
+/* Send all LEN bytes of DATA over SOCK. */
+static apr_status_t
+send_all(apr_socket_t *sock, const char *data, apr_size_t len)
+{
+  while (len)
+    {
+      apr_size_t sent = len;
+      apr_status_t status = apr_socket_send(sock, data, &sent);
+      if (status)
+        return status;
+
+      data += sent;
+      len -= sent;
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Read from SOCK until the peer closes the connection and return the
+   data in *BUF, allocated in POOL. */
+static apr_status_t
+recv_all(svn_stringbuf_t **buf, apr_socket_t *sock, apr_pool_t *pool)
+{
+  char chunk[SVN__STREAM_CHUNK_SIZE];
+
+  *buf = svn_stringbuf_create_empty(pool);
+  while (TRUE)
+    {
+      apr_size_t len = sizeof(chunk);
+      apr_status_t status = apr_socket_recv(sock, chunk, &len);
+
+      svn_stringbuf_appendbytes(*buf, chunk, len);
+      if (APR_STATUS_IS_EOF(status))
+        return APR_SUCCESS;
+      if (status)
+        return status;
+    }
+}
+
+/* Run the hook program CMD with ARGS for hook NAME through the hook
+   server listening on the Unix socket SOCKET_PATH.
+
+   The request is a skel (NAME CMD (ARG ...) (ENV ...) (STDIN?)) where
+   the ARGs are ARGS without the program name, the ENVs are "VAR=VALUE"
+   entries of HOOK_ENV and STDIN is STDIN_DATA, if given.  After sending
+   it, the write side of the connection is shut down.  The server runs
+   the hook as if it had been started by run_hook_cmd() and replies with
+   a skel (EXITCODE STDOUT STDERR) before closing the connection.
+
+   If the server cannot be reached, set *HANDLED to FALSE and return
+   without running the hook, so that the caller can fall back to
+   starting the hook program itself.  Otherwise, set *HANDLED to TRUE and
+   return the hook's result as run_hook_cmd() does. */
+static svn_error_t *
+run_hook_server(svn_boolean_t *handled,
+                svn_string_t **result,
+                const char *socket_path,
+                const char *name,
+                const char *cmd,
+                const char **args,
+                apr_hash_t *hook_env,
+                const svn_string_t *stdin_data,
+                apr_pool_t *pool)
+{
+  apr_sockaddr_t *sa;
+  apr_socket_t *sock;
+  apr_status_t status;
+  svn_skel_t *request, *list, *response;
+  svn_stringbuf_t *buf;
+  apr_int64_t exitcode;
+  const char **arg;
+  const char *utf8_stderr;
+  svn_error_t *err;
+
+  *handled = FALSE;
+
+  status = apr_sockaddr_info_get(&sa, socket_path, APR_UNIX, 0, 0, pool);
+  if (!status)
+    status = apr_socket_create(&sock, APR_UNIX, SOCK_STREAM, 0, pool);
+  if (status)
+    return SVN_NO_ERROR;
+
+  status = apr_socket_connect(sock, sa);
+  if (status)
+    {
+      apr_socket_close(sock);
+      return SVN_NO_ERROR;
+    }
+
+  *handled = TRUE;
+
+  request = svn_skel__make_empty_list(pool);
+  svn_skel__append(request, svn_skel__str_atom(name, pool));
+  svn_skel__append(request, svn_skel__str_atom(cmd, pool));
+
+  list = svn_skel__make_empty_list(pool);
+  for (arg = args + 1; *arg; ++arg)
+    svn_skel__append(list, svn_skel__str_atom(*arg, pool));
+  svn_skel__append(request, list);
+
+  list = svn_skel__make_empty_list(pool);
+  arg = env_from_env_hash(hook_env, pool, pool);
+  for (; arg && *arg; ++arg)
+    svn_skel__append(list, svn_skel__str_atom(*arg, pool));
+  svn_skel__append(request, list);
+
+  list = svn_skel__make_empty_list(pool);
+  if (stdin_data)
+    svn_skel__append(list, svn_skel__mem_atom(stdin_data->data,
+                                              stdin_data->len, pool));
+  svn_skel__append(request, list);
+
+  buf = svn_skel__unparse(request, pool);
+  status = send_all(sock, buf->data, buf->len);
+  if (!status)
+    status = apr_socket_shutdown(sock, APR_SHUTDOWN_WRITE);
+  if (!status)
+    status = recv_all(&buf, sock, pool);
+  apr_socket_close(sock);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't run '%s' hook through hook server "
+                                "'%s'"),
+                              name, svn_dirent_local_style(socket_path,
+                                                           pool));
+
+  response = svn_skel__parse(buf->data, buf->len, pool);
+  if (response
+      && svn_skel__list_length(response) == 3
+      && response->children->is_atom
+      && response->children->next->is_atom
+      && response->children->next->next->is_atom)
+    err = svn_skel__parse_int(&exitcode, response->children, pool);
+  else
+    err = svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+
+  if (err)
+    return svn_error_createf(SVN_ERR_REPOS_HOOK_FAILURE, err,
+                             _("Malformed response from hook server '%s' "
+                               "for '%s' hook"),
+                             svn_dirent_local_style(socket_path, pool),
+                             name);
+
+  if (exitcode == 0)
+    {
+      if (result)
+        *result = svn_string_ncreate(response->children->next->data,
+                                     response->children->next->len, pool);
+      return SVN_NO_ERROR;
+    }
+
+  err = svn_utf_cstring_to_utf8(&utf8_stderr,
+                                apr_pstrmemdup(pool,
+                                    response->children->next->next->data,
+                                    response->children->next->next->len),
+                                pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      utf8_stderr = _("[Error output could not be translated from the "
+                      "native locale to UTF-8.]");
+    }
+
+  return hook_failure_error(name, APR_PROC_EXIT, (int)exitcode,
+                            utf8_stderr, pool);
+}
+#endif
+
 /* NAME, CMD and ARGS are the name, path to and arguments for the hook
    program that is to be run.  The hook's exit status will be checked,
    and if an error occurred the hook's stderr output will be added to
    the returned error.
 
-   If STDIN_HANDLE is non-null, pass it as the hook's stdin, else pass
+   If STDIN_DATA is non-null, pass it as the hook's stdin, else pass
    no stdin to the hook.
 
+   If HOOKS_ENV configures a hook server, hand the hook over to that
+   server instead of starting it as a new process, unless the server
+   cannot be reached.
+
    If RESULT is non-null, set *RESULT to the stdout of the hook or to
    a zero-length string if the hook generates no output on stdout. */
 static svn_error_t *
@@ -209,16 +418,48 @@ run_hook_cmd(svn_string_t **result,
              const char *cmd,
              const char **args,
              apr_hash_t *hooks_env,
-             apr_file_t *stdin_handle,
+             const svn_string_t *stdin_data,
              apr_pool_t *pool)
 {
   apr_file_t *null_handle;
+  apr_file_t *stdin_handle = NULL;
   apr_status_t apr_err;
   svn_error_t *err;
   apr_proc_t cmd_proc = {0};
   apr_pool_t *cmd_pool;
   apr_hash_t *hook_env = NULL;
 
+  /* Check if a custom environment is defined for this hook, or else
+   * whether a default environment is defined. */
+  if (hooks_env)
+    {
+      hook_env = svn_hash_gets(hooks_env, name);
+      if (hook_env == NULL)
+        hook_env = svn_hash_gets(hooks_env,
+                                 SVN_REPOS__HOOKS_ENV_DEFAULT_SECTION);
+    }
+
+#ifdef APR_UNIX
+  if (hooks_env)
+    {
+      apr_hash_t *server = svn_hash_gets(hooks_env,
+                                         SVN_REPOS__HOOKS_ENV_SERVER_SECTION);
+      const char *socket_path
+        = server ? svn_hash_gets(server, SVN_REPOS__HOOKS_ENV_SERVER_SOCKET)
+                 : NULL;
+
+      if (socket_path && *socket_path)
+        {
+          svn_boolean_t handled;
+
+          SVN_ERR(run_hook_server(&handled, result, socket_path, name, cmd,
+                                  args, hook_env, stdin_data, pool));
+          if (handled)
+            return SVN_NO_ERROR;
+        }
+    }
+#endif
+
   if (result)
     {
       null_handle = NULL;
@@ -237,27 +478,30 @@ run_hook_cmd(svn_string_t **result,
    * destroy in order to clean up the stderr pipe opened for the process. */
   cmd_pool = svn_pool_create(pool);
 
-  /* Check if a custom environment is defined for this hook, or else
-   * whether a default environment is defined. */
-  if (hooks_env)
-    {
-      hook_env = svn_hash_gets(hooks_env, name);
-      if (hook_env == NULL)
-        hook_env = svn_hash_gets(hooks_env,
-                                 SVN_REPOS__HOOKS_ENV_DEFAULT_SECTION);
-    }
+  /* Pass empty input as the null device, anything else through a
+   * temporary file. */
+  if (stdin_data && stdin_data->len)
+    err = create_temp_file(&stdin_handle, stdin_data, cmd_pool);
+  else if (stdin_data)
+    err = svn_io_file_open(&stdin_handle, SVN_NULL_DEVICE_NAME,
+                           APR_READ, APR_OS_DEFAULT, cmd_pool);
+  else
+    err = SVN_NO_ERROR;
 
-  err = svn_io_start_cmd3(&cmd_proc, ".", cmd, args,
-                          env_from_env_hash(hook_env, pool, pool),
-                          FALSE, FALSE, stdin_handle, result != NULL,
-                          null_handle, TRUE, NULL, cmd_pool);
   if (!err)
-    err = check_hook_result(name, cmd, &cmd_proc, cmd_proc.err, pool);
-  else
     {
-      /* The command could not be started for some reason. */
-      err = svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, err,
-                              _("Failed to start '%s' hook"), cmd);
+      err = svn_io_start_cmd3(&cmd_proc, ".", cmd, args,
+                              env_from_env_hash(hook_env, pool, pool),
+                              FALSE, FALSE, stdin_handle, result != NULL,
+                              null_handle, TRUE, NULL, cmd_pool);
+      if (!err)
+        err = check_hook_result(name, cmd, &cmd_proc, cmd_proc.err, pool);
+      else
+        {
+          /* The command could not be started for some reason. */
+          err = svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, err,
+                                  _("Failed to start '%s' hook"), cmd);
+        }
     }
 
   /* Hooks are fallible, and so hook failure is "expected" to occur at
@@ -271,7 +515,8 @@ run_hook_cmd(svn_string_t **result,
         *result = svn_stringbuf__morph_into_string(native_stdout);
     }
 
-  /* Close resources allocated by svn_io_start_cmd3(), such as the pipe. */
+  /* Close resources allocated by svn_io_start_cmd3(), such as the pipe,
+     and the temporary stdin file. */
   svn_pool_destroy(cmd_pool);
 
   /* Close the null handle. */
@@ -286,22 +531,6 @@ run_hook_cmd(svn_string_t **result,
 }
 
 
-/* Create a temporary file F that will automatically be deleted when the
-   pool is cleaned up.  Fill it with VALUE, and leave it open and rewound,
-   ready to be read from. */
-static svn_error_t *
-create_temp_file(apr_file_t **f, const svn_string_t *value, apr_pool_t *pool)
-{
-  apr_off_t offset = 0;
-
-  SVN_ERR(svn_io_open_unique_file3(f, NULL, NULL,
-                                   svn_io_file_del_on_pool_cleanup,
-                                   pool, pool));
-  SVN_ERR(svn_io_file_write_full(*f, value->data, value->len, NULL, pool));
-  return svn_io_file_seek(*f, APR_SET, &offset, pool);
-}
-
-
 /* Check if the HOOK program exists and is a file or a symbolic link, using
    POOL for temporary allocations.
 
@@ -356,6 +585,15 @@ check_hook_cmd(const char *hook, svn_boolean_t *broken_link, apr_pool_t *pool)
   return NULL;
 }
 
+svn_boolean_t
+svn_repos__hook_exists(const char *hook,
+                       apr_pool_t *pool)
+{
+  svn_boolean_t broken_link;
+
+  return check_hook_cmd(hook, &broken_link, pool) != NULL;
+}
+
 /* Baton for parse_hooks_env_option. */
 struct parse_hooks_env_option_baton {
   /* The name of the section being parsed. If not the default section,
@@ -501,16 +739,14 @@ svn_repos__hooks_start_commit(svn_repos_t *repos,
   return SVN_NO_ERROR;
 }
 
-/* Set *HANDLE to an open filehandle for a temporary file (i.e.,
-   automatically deleted when closed), into which the LOCK_TOKENS have
-   been written out in the format described in the pre-commit hook
-   template.
+/* Return the LOCK_TOKENS written out in the format described in the
+   pre-commit hook template.
 
    LOCK_TOKENS is as returned by svn_fs__access_get_lock_tokens().
 
-   Allocate *HANDLE in POOL, and use POOL for temporary allocations. */
-static svn_error_t *
-lock_token_content(apr_file_t **handle, apr_hash_t *lock_tokens,
+   Allocate the result in POOL, and use POOL for temporary allocations. */
+static svn_string_t *
+lock_token_content(apr_hash_t *lock_tokens,
                    apr_pool_t *pool)
 {
   svn_stringbuf_t *lock_str = svn_stringbuf_create("LOCK-TOKENS:\n", pool);
@@ -538,8 +774,7 @@ lock_token_content(apr_file_t **handle, apr_hash_t *lock_tokens,
     }
 
   svn_stringbuf_appendcstr(lock_str, "\n");
-  return create_temp_file(handle,
-                          svn_stringbuf__morph_into_string(lock_str), pool);
+  return svn_stringbuf__morph_into_string(lock_str);
 }
 
 
@@ -561,7 +796,7 @@ svn_repos__hooks_pre_commit(svn_repos_t *repos,
     {
       const char *args[4];
       svn_fs_access_t *access_ctx;
-      apr_file_t *stdin_handle = NULL;
+      svn_string_t *stdin_data = NULL;
 
       args[0] = hook;
       args[1] = svn_dirent_local_style(svn_repos_path(repos, pool), pool);
@@ -573,28 +808,164 @@ svn_repos__hooks_pre_commit(svn_repos_t *repos,
         {
           apr_hash_t *lock_tokens = svn_fs__access_get_lock_tokens(access_ctx);
           if (apr_hash_count(lock_tokens))  {
-            SVN_ERR(lock_token_content(&stdin_handle, lock_tokens, pool));
+            stdin_data = lock_token_content(lock_tokens, pool);
           }
         }
 
-      if (!stdin_handle)
-        SVN_ERR(svn_io_file_open(&stdin_handle, SVN_NULL_DEVICE_NAME,
-                                 APR_READ, APR_OS_DEFAULT, pool));
+      if (!stdin_data)
+        stdin_data = svn_string_create_empty(pool);
 
       SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_PRE_COMMIT, hook, args,
-                           hooks_env, stdin_handle, pool));
+                           hooks_env, stdin_data, pool));
     }
 
   return SVN_NO_ERROR;
 }
 
 
-svn_error_t  *
-svn_repos__hooks_post_commit(svn_repos_t *repos,
-                             apr_hash_t *hooks_env,
-                             svn_revnum_t rev,
-                             const char *txn_name,
-                             apr_pool_t *pool)
+/*** The post-commit queue. ***/
+
+/* Name of the lock file within the post-commit queue directory.  Whoever
+   holds it runs the queue. */
+#define POST_COMMIT_QUEUE_LOCK "lock"
+
+/* File locks don't exclude other threads of the same process.  So,
+   DRAINING maps the paths of all post-commit queues known to this
+   process (const char *, allocated in DRAINING_POOL) to a non-NULL value
+   while one of our threads runs that queue and to NULL (i.e. the empty
+   string) otherwise.  Access to it is serialized by DRAINING_MUTEX. */
+static volatile svn_atomic_t draining_init_state = 0;
+static apr_pool_t *draining_pool = NULL;
+static apr_hash_t *draining = NULL;
+static svn_mutex__t *draining_mutex = NULL;
+
+/* Implements svn_atomic__init_once's init_func. */
+static svn_error_t *
+init_draining(void *baton,
+              apr_pool_t *pool)
+{
+  draining_pool = svn_pool_create(NULL);
+  draining = apr_hash_make(draining_pool);
+  SVN_ERR(svn_mutex__init(&draining_mutex, TRUE, draining_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set the entry for QUEUE_PATH in DRAINING to BUSY, unless it already has
+   that value.  Set *CHANGED accordingly.  Call this only while holding
+   DRAINING_MUTEX. */
+static svn_error_t *
+set_draining(svn_boolean_t *changed,
+             const char *queue_path,
+             svn_boolean_t busy)
+{
+  const char *key = NULL;
+  const char *value = NULL;
+  apr_hash_index_t *hi;
+
+  /* Re-use the key, so we don't leak memory for every commit. */
+  for (hi = apr_hash_first(NULL, draining); hi; hi = apr_hash_next(hi))
+    if (strcmp(apr_hash_this_key(hi), queue_path) == 0)
+      {
+        key = apr_hash_this_key(hi);
+        value = apr_hash_this_val(hi);
+        break;
+      }
+
+  if (!key)
+    key = apr_pstrdup(draining_pool, queue_path);
+
+  *changed = (value && *value != '\0') != busy;
+  if (*changed)
+    apr_hash_set(draining, key, APR_HASH_KEY_STRING, busy ? "busy" : "");
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the path of the post-commit queue of REPOS in POOL. */
+static const char *
+post_commit_queue_path(svn_repos_t *repos,
+                       apr_pool_t *pool)
+{
+  return svn_dirent_join(repos->path, SVN_REPOS__POST_COMMIT_QUEUE_DIR,
+                         pool);
+}
+
+/* Set *REVS to the revisions (svn_revnum_t) in the post-commit queue at
+   QUEUE_PATH, in ascending order.  Allocate *REVS in POOL. */
+static svn_error_t *
+list_post_commit_queue(apr_array_header_t **revs,
+                       const char *queue_path,
+                       apr_pool_t *pool)
+{
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  svn_error_t *err;
+
+  *revs = apr_array_make(pool, 4, sizeof(svn_revnum_t));
+
+  err = svn_io_get_dirents3(&dirents, queue_path, TRUE, pool, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const char *end;
+      svn_revnum_t rev;
+
+      /* Skip the lock file and temporaries of svn_io_write_atomic2(). */
+      err = svn_revnum_parse(&rev, name, &end);
+      if (err || *end != '\0')
+        {
+          svn_error_clear(err);
+          continue;
+        }
+
+      APR_ARRAY_PUSH(*revs, svn_revnum_t) = rev;
+    }
+
+  svn_sort__array(*revs, svn_sort_compare_revisions);
+  svn_sort__array_reverse(*revs, pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Append the post-commit hook invocation for REV and TXN_NAME to the
+   post-commit queue of REPOS.  Use POOL for temporary allocations. */
+static svn_error_t *
+queue_post_commit(svn_repos_t *repos,
+                  svn_revnum_t rev,
+                  const char *txn_name,
+                  apr_pool_t *pool)
+{
+  const char *queue_path = post_commit_queue_path(repos, pool);
+
+  if (!txn_name)
+    txn_name = "";
+
+  SVN_ERR(svn_io_make_dir_recursively(queue_path, pool));
+
+  /* Make it durable before the client learns about the new revision. */
+  return svn_error_trace(svn_io_write_atomic2(
+                           svn_dirent_join(queue_path,
+                                           apr_psprintf(pool, "%ld", rev),
+                                           pool),
+                           txn_name, strlen(txn_name), NULL, TRUE, pool));
+}
+
+/* Run the post-commit hook of REPOS for REV and TXN_NAME, using the
+   HOOKS_ENV.  Use POOL for temporary allocations. */
+static svn_error_t *
+run_post_commit_hook(svn_repos_t *repos,
+                     apr_hash_t *hooks_env,
+                     svn_revnum_t rev,
+                     const char *txn_name,
+                     apr_pool_t *pool)
 {
   const char *hook = svn_repos_post_commit_hook(repos, pool);
   svn_boolean_t broken_link;
@@ -620,6 +991,142 @@ svn_repos__hooks_post_commit(svn_repos_t *repos,
   return SVN_NO_ERROR;
 }
 
+/* Run all entries of the post-commit queue of REPOS at QUEUE_PATH in
+   order, unless another process is already doing that.  Add the errors
+   of failed hooks to *HOOK_ERR.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+run_post_commit_queue(svn_error_t **hook_err,
+                      svn_repos_t *repos,
+                      const char *queue_path,
+                      apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_t *hooks_env;
+  apr_array_header_t *revs;
+  apr_file_t *lock_file;
+  svn_error_t *err;
+  int i;
+
+  SVN_ERR(svn_io_file_open(&lock_file,
+                           svn_dirent_join(queue_path,
+                                           POST_COMMIT_QUEUE_LOCK,
+                                           scratch_pool),
+                           APR_READ | APR_WRITE | APR_CREATE,
+                           APR_OS_DEFAULT, scratch_pool));
+  err = svn_io_lock_open_file(lock_file, TRUE, TRUE, scratch_pool);
+  if (err && APR_STATUS_IS_EAGAIN(err->apr_err))
+    {
+      /* Another process takes care of the queue. */
+      svn_error_clear(err);
+      return svn_error_trace(svn_io_file_close(lock_file, scratch_pool));
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_repos__parse_hooks_env(&hooks_env, repos->hooks_env_path,
+                                     scratch_pool, scratch_pool));
+
+  /* Keep going until no more entries arrive while we hold the lock. */
+  SVN_ERR(list_post_commit_queue(&revs, queue_path, scratch_pool));
+  while (revs->nelts)
+    {
+      for (i = 0; i < revs->nelts; ++i)
+        {
+          svn_revnum_t rev = APR_ARRAY_IDX(revs, i, svn_revnum_t);
+          const char *entry_path;
+          svn_stringbuf_t *txn_name;
+
+          svn_pool_clear(iterpool);
+
+          entry_path = svn_dirent_join(queue_path,
+                                       apr_psprintf(iterpool, "%ld", rev),
+                                       iterpool);
+          SVN_ERR(svn_stringbuf_from_file2(&txn_name, entry_path, iterpool));
+
+          /* The hook has been delivered once it has run, whether it
+             succeeded or not.  Only if we don't get that far, it will be
+             run again. */
+          *hook_err = svn_error_compose_create(
+                        *hook_err,
+                        run_post_commit_hook(repos, hooks_env, rev,
+                                             txn_name->len ? txn_name->data
+                                                           : NULL,
+                                             iterpool));
+          SVN_ERR(svn_io_remove_file2(entry_path, TRUE, iterpool));
+        }
+
+      SVN_ERR(list_post_commit_queue(&revs, queue_path, scratch_pool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Closing the file releases the lock. */
+  return svn_error_trace(svn_io_file_close(lock_file, scratch_pool));
+}
+
+svn_error_t *
+svn_repos__run_post_commit_queue(svn_repos_t *repos,
+                                 apr_pool_t *scratch_pool)
+{
+  const char *queue_path = post_commit_queue_path(repos, scratch_pool);
+  svn_error_t *hook_err = SVN_NO_ERROR;
+  apr_array_header_t *revs;
+
+  SVN_ERR(svn_atomic__init_once(&draining_init_state, init_draining, NULL,
+                                scratch_pool));
+
+  /* A queue runner in another thread or process may have missed entries
+     added just before it gave up the queue.  So, check again after we
+     gave it up ourselves. */
+  SVN_ERR(list_post_commit_queue(&revs, queue_path, scratch_pool));
+  while (revs->nelts)
+    {
+      svn_boolean_t claimed;
+      svn_boolean_t released;
+      svn_error_t *err;
+
+      SVN_MUTEX__WITH_LOCK(draining_mutex,
+                           set_draining(&claimed, queue_path, TRUE));
+      if (!claimed)
+        break;
+
+      err = run_post_commit_queue(&hook_err, repos, queue_path,
+                                  scratch_pool);
+
+      SVN_MUTEX__WITH_LOCK(draining_mutex,
+                           set_draining(&released, queue_path, FALSE));
+      if (err)
+        return svn_error_compose_create(err, hook_err);
+
+      SVN_ERR(list_post_commit_queue(&revs, queue_path, scratch_pool));
+    }
+
+  return svn_error_trace(hook_err);
+}
+
+svn_error_t  *
+svn_repos__hooks_post_commit(svn_repos_t *repos,
+                             apr_hash_t *hooks_env,
+                             svn_revnum_t rev,
+                             const char *txn_name,
+                             apr_pool_t *pool)
+{
+  /* Defer the hook to the queue, if it exists at all. */
+  if (repos->async_post_commit)
+    {
+      const char *hook = svn_repos_post_commit_hook(repos, pool);
+      svn_boolean_t broken_link;
+
+      if (check_hook_cmd(hook, &broken_link, pool))
+        return svn_error_trace(queue_post_commit(repos, rev, txn_name,
+                                                 pool));
+
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(run_post_commit_hook(repos, hooks_env, rev,
+                                              txn_name, pool));
+}
+
 
 svn_error_t  *
 svn_repos__hooks_pre_revprop_change(svn_repos_t *repos,
@@ -641,15 +1148,14 @@ svn_repos__hooks_pre_revprop_change(svn_repos_t *repos,
   else if (hook)
     {
       const char *args[7];
-      apr_file_t *stdin_handle = NULL;
+      const svn_string_t *stdin_data;
       char action_string[2];
 
       /* Pass the new value as stdin to hook */
       if (new_value)
-        SVN_ERR(create_temp_file(&stdin_handle, new_value, pool));
+        stdin_data = new_value;
       else
-        SVN_ERR(svn_io_file_open(&stdin_handle, SVN_NULL_DEVICE_NAME,
-                                 APR_READ, APR_OS_DEFAULT, pool));
+        stdin_data = svn_string_create_empty(pool);
 
       action_string[0] = action;
       action_string[1] = '\0';
@@ -663,9 +1169,7 @@ svn_repos__hooks_pre_revprop_change(svn_repos_t *repos,
       args[6] = NULL;
 
       SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_PRE_REVPROP_CHANGE, hook,
-                           args, hooks_env, stdin_handle, pool));
-
-      SVN_ERR(svn_io_file_close(stdin_handle, pool));
+                           args, hooks_env, stdin_data, pool));
     }
   else
     {
@@ -704,15 +1208,14 @@ svn_repos__hooks_post_revprop_change(svn_repos_t *repos,
   else if (hook)
     {
       const char *args[7];
-      apr_file_t *stdin_handle = NULL;
+      const svn_string_t *stdin_data;
       char action_string[2];
 
       /* Pass the old value as stdin to hook */
       if (old_value)
-        SVN_ERR(create_temp_file(&stdin_handle, old_value, pool));
+        stdin_data = old_value;
       else
-        SVN_ERR(svn_io_file_open(&stdin_handle, SVN_NULL_DEVICE_NAME,
-                                 APR_READ, APR_OS_DEFAULT, pool));
+        stdin_data = svn_string_create_empty(pool);
 
       action_string[0] = action;
       action_string[1] = '\0';
@@ -726,9 +1229,7 @@ svn_repos__hooks_post_revprop_change(svn_repos_t *repos,
       args[6] = NULL;
 
       SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_REVPROP_CHANGE, hook,
-                           args, hooks_env, stdin_handle, pool));
-
-      SVN_ERR(svn_io_file_close(stdin_handle, pool));
+                           args, hooks_env, stdin_data, pool));
     }
 
   return SVN_NO_ERROR;
@@ -798,13 +1299,10 @@ svn_repos__hooks_post_lock(svn_repos_t *repos,
   else if (hook)
     {
       const char *args[5];
-      apr_file_t *stdin_handle = NULL;
       svn_string_t *paths_str = svn_string_create(svn_cstring_join
                                                   (paths, "\n", pool),
                                                   pool);
 
-      SVN_ERR(create_temp_file(&stdin_handle, paths_str, pool));
-
       args[0] = hook;
       args[1] = svn_dirent_local_style(svn_repos_path(repos, pool), pool);
       args[2] = username;
@@ -812,9 +1310,7 @@ svn_repos__hooks_post_lock(svn_repos_t *repos,
       args[4] = NULL;
 
       SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_LOCK, hook, args,
-                           hooks_env, stdin_handle, pool));
-
-      SVN_ERR(svn_io_file_close(stdin_handle, pool));
+                           hooks_env, paths_str, pool));
     }
 
   return SVN_NO_ERROR;
@@ -874,13 +1370,10 @@ svn_repos__hooks_post_unlock(svn_repos_t *repos,
   else if (hook)
     {
       const char *args[5];
-      apr_file_t *stdin_handle = NULL;
       svn_string_t *paths_str = svn_string_create(svn_cstring_join
                                                   (paths, "\n", pool),
                                                   pool);
 
-      SVN_ERR(create_temp_file(&stdin_handle, paths_str, pool));
-
       args[0] = hook;
       args[1] = svn_dirent_local_style(svn_repos_path(repos, pool), pool);
       args[2] = username ? username : "";
@@ -888,9 +1381,7 @@ svn_repos__hooks_post_unlock(svn_repos_t *repos,
       args[4] = NULL;
 
       SVN_ERR(run_hook_cmd(NULL, SVN_REPOS__HOOK_POST_UNLOCK, hook, args,
-                           hooks_env, stdin_handle, pool));
-
-      SVN_ERR(svn_io_file_close(stdin_handle, pool));
+                           hooks_env, paths_str, pool));
     }
 
   return SVN_NO_ERROR;
@@ -1226,7 +1226,7 @@ svn_repos_get_fs_build_parser5(const svn_repos_parse_fns3_t **callbacks,
 
 
 svn_error_t *
-svn_repos_load_fs5(svn_repos_t *repos,
+svn_repos_load_fs6(svn_repos_t *repos,
                    svn_stream_t *dumpstream,
                    svn_revnum_t start_rev,
                    svn_revnum_t end_rev,
@@ -1236,6 +1236,7 @@ svn_repos_load_fs5(svn_repos_t *repos,
                    svn_boolean_t use_post_commit_hook,
                    svn_boolean_t validate_props,
                    svn_boolean_t ignore_dates,
+                   svn_boolean_t pipelined,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -1261,10 +1262,85 @@ svn_repos_load_fs5(svn_repos_t *repos,
                                          notify_baton,
                                          pool));
 
+  if (pipelined)
+    return svn_repos__parse_dumpstream_pipelined(dumpstream, parser,
+                                                 parse_baton, FALSE,
+                                                 cancel_func, cancel_baton,
+                                                 pool);
+
   return svn_repos_parse_dumpstream3(dumpstream, parser, parse_baton, FALSE,
                                      cancel_func, cancel_baton, pool);
 }
 
+svn_error_t *
+svn_repos_load_fs_segments(svn_repos_t *repos,
+                           const char *dir_path,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           enum svn_repos_load_uuid uuid_action,
+                           const char *parent_dir,
+                           svn_boolean_t use_pre_commit_hook,
+                           svn_boolean_t use_post_commit_hook,
+                           svn_boolean_t validate_props,
+                           svn_boolean_t ignore_dates,
+                           svn_boolean_t pipelined,
+                           svn_repos_notify_func_t notify_func,
+                           void *notify_baton,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *pool)
+{
+  const svn_repos_parse_fns3_t *parser;
+  void *parse_baton;
+  apr_array_header_t *segments;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(svn_repos__read_dump_manifest(&segments, dir_path, pool, pool));
+
+  /* Use the same parser for all segments, so revision mappings etc.
+   * carry over from one segment to the next. */
+  SVN_ERR(svn_repos_get_fs_build_parser5(&parser, &parse_baton,
+                                         repos,
+                                         start_rev, end_rev,
+                                         TRUE, /* look for copyfrom revs */
+                                         validate_props,
+                                         uuid_action,
+                                         parent_dir,
+                                         use_pre_commit_hook,
+                                         use_post_commit_hook,
+                                         ignore_dates,
+                                         notify_func,
+                                         notify_baton,
+                                         pool));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < segments->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(segments, i, const char *);
+      svn_stream_t *stream;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_stream_open_readonly(&stream, path, iterpool, iterpool));
+
+      if (pipelined)
+        SVN_ERR(svn_repos__parse_dumpstream_pipelined(stream, parser,
+                                                      parse_baton, FALSE,
+                                                      cancel_func,
+                                                      cancel_baton,
+                                                      iterpool));
+      else
+        SVN_ERR(svn_repos_parse_dumpstream3(stream, parser, parse_baton,
+                                            FALSE, cancel_func,
+                                            cancel_baton, iterpool));
+
+      SVN_ERR(svn_stream_close(stream));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /*----------------------------------------------------------------------*/
 
 /** The same functionality for revprops only **/
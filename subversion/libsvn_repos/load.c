@@ -22,6 +22,9 @@
 
 
 #include <apr.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
 
 #include "svn_hash.h"
 #include "svn_pools.h"
@@ -53,6 +56,40 @@ stream_malformed(void)
                           _("Dumpstream data appears to be malformed"));
 }
 
+/* Advance STREAM by LENGTH bytes that nobody is interested in.  Streams
+   that support seeking, e.g. dump files, may do so without reading the
+   data.  Use BUFFER for any data that actually needs to be read. */
+static svn_error_t *
+skip_content(svn_stream_t *stream,
+             svn_filesize_t length,
+             char *buffer)
+{
+  apr_size_t rlen;
+
+  /* Skipping is allowed to move past the end of the stream without
+     telling us.  So, skip all but the last byte and read that one to
+     detect truncated streams. */
+  while (length > 1)
+    {
+      apr_size_t to_skip = length - 1 > APR_SIZE_MAX
+                         ? APR_SIZE_MAX
+                         : (apr_size_t)(length - 1);
+
+      SVN_ERR(svn_stream_skip(stream, to_skip));
+      length -= to_skip;
+    }
+
+  if (length)
+    {
+      rlen = 1;
+      SVN_ERR(svn_stream_read_full(stream, buffer, &rlen));
+      if (rlen != 1)
+        return stream_ran_dry();
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Allocate a new hash *HEADERS in POOL, and read a series of
    RFC822-style headers from STREAM.  Duplicate each header's name and
    value into POOL and store in hash as a const char * ==> const char *.
@@ -317,8 +354,10 @@ parse_text_block(svn_stream_t *stream,
       SVN_ERR(parse_fns->set_fulltext(&text_stream, record_baton));
     }
 
-  /* Regardless of whether or not we have a sink for our data, we
-     need to read it. */
+  /* Without a sink for our data, we don't need to look at it. */
+  if (! text_stream)
+    return svn_error_trace(skip_content(stream, content_length, buffer));
+
   while (content_length)
     {
       if (content_length >= (svn_filesize_t)buflen)
@@ -332,23 +371,19 @@ parse_text_block(svn_stream_t *stream,
       if (rlen != num_to_read)
         return stream_ran_dry();
 
-      if (text_stream)
+      /* write however many bytes you read. */
+      wlen = rlen;
+      SVN_ERR(svn_stream_write(text_stream, buffer, &wlen));
+      if (wlen != rlen)
         {
-          /* write however many bytes you read. */
-          wlen = rlen;
-          SVN_ERR(svn_stream_write(text_stream, buffer, &wlen));
-          if (wlen != rlen)
-            {
-              /* Uh oh, didn't write as many bytes as we read. */
-              return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
-                                      _("Unexpected EOF writing contents"));
-            }
+          /* Uh oh, didn't write as many bytes as we read. */
+          return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
+                                  _("Unexpected EOF writing contents"));
         }
     }
 
   /* If we opened a stream, we must close it. */
-  if (text_stream)
-    SVN_ERR(svn_stream_close(text_stream));
+  SVN_ERR(svn_stream_close(text_stream));
 
   return SVN_NO_ERROR;
 }
@@ -517,16 +552,15 @@ complete_vtable(const svn_repos_parse_fns3_t *provided,
 
 /*----------------------------------------------------------------------*/
 
-/** The public routines **/
-
-svn_error_t *
-svn_repos_parse_dumpstream3(svn_stream_t *stream,
-                            const svn_repos_parse_fns3_t *parse_fns,
-                            void *parse_baton,
-                            svn_boolean_t deltas_are_text,
-                            svn_cancel_func_t cancel_func,
-                            void *cancel_baton,
-                            apr_pool_t *pool)
+/* The implementation of svn_repos_parse_dumpstream3(). */
+static svn_error_t *
+parse_dumpstream(svn_stream_t *stream,
+                 const svn_repos_parse_fns3_t *parse_fns,
+                 void *parse_baton,
+                 svn_boolean_t deltas_are_text,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *pool)
 {
   svn_boolean_t eof;
   svn_stringbuf_t *linebuf;
@@ -749,7 +783,6 @@ svn_repos_parse_dumpstream3(svn_stream_t *stream,
       */
       if (content_length && ! old_v1_with_cl)
         {
-          apr_size_t rlen, num_to_read;
           svn_filesize_t remaining =
             svn__atoui64(content_length) -
             (prop_cl ? svn__atoui64(prop_cl) : 0) -
@@ -762,19 +795,7 @@ svn_repos_parse_dumpstream3(svn_stream_t *stream,
                                       "total block content length"));
 
           /* Consume remaining bytes in this content block */
-          while (remaining > 0)
-            {
-              if (remaining >= (svn_filesize_t)buflen)
-                rlen = buflen;
-              else
-                rlen = (apr_size_t) remaining;
-
-              num_to_read = rlen;
-              SVN_ERR(svn_stream_read_full(stream, buffer, &rlen));
-              remaining -= rlen;
-              if (rlen != num_to_read)
-                return stream_ran_dry();
-            }
+          SVN_ERR(skip_content(stream, remaining, buffer));
         }
 
       /* If we just finished processing a node record, we need to
@@ -798,3 +819,817 @@ svn_repos_parse_dumpstream3(svn_stream_t *stream,
   svn_pool_destroy(nodepool);
   return SVN_NO_ERROR;
 }
+
+
+#if APR_HAS_THREADS
+
+/* Pipelined parsing.
+ *
+ * A separate parser thread reads the dump stream, splits it into records
+ * and decodes the svndiff data of text deltas.  Instead of calling the
+ * caller's vtable, it records all callbacks as events and hands them over
+ * to the calling thread in blocks.  The calling thread replays the events
+ * against the caller's vtable, which typically means committing them to
+ * some repository.  Reading, parsing and decoding thus run ahead of the
+ * commits while all callbacks are still invoked from the calling thread,
+ * in the same order and with the same pool lifetimes as during sequential
+ * parsing.
+ */
+
+/* Approximate amount of recorded data per block, in bytes. */
+#define PIPELINE_BLOCK_SIZE (1024 * 1024)
+
+/* Recorded data may run ahead of the replay by up to this amount. */
+#define PIPELINE_MAX_QUEUED (16 * PIPELINE_BLOCK_SIZE)
+
+/* The svn_repos_parse_fns3_t callback that an event records.
+ */
+typedef enum parse_event_kind_t
+{
+  parse_event_magic_header,
+  parse_event_uuid,
+  parse_event_new_revision,
+  parse_event_new_node,
+  parse_event_set_revision_property,
+  parse_event_set_node_property,
+  parse_event_delete_node_property,
+  parse_event_remove_node_props,
+  parse_event_set_fulltext,
+  parse_event_fulltext_data,
+  parse_event_close_fulltext,
+  parse_event_apply_textdelta,
+  parse_event_window,
+  parse_event_close_node,
+  parse_event_close_revision
+} parse_event_kind_t;
+
+/* A recorded callback invocation.
+ */
+typedef struct parse_event_t
+{
+  parse_event_kind_t kind;
+
+  /* Dump format version for magic header events. */
+  int version;
+
+  /* UUID or property name. */
+  const char *name;
+
+  /* Property value. */
+  const svn_string_t *value;
+
+  /* Record headers of new revisions and nodes. */
+  apr_hash_t *headers;
+
+  /* Fulltext data. */
+  const char *data;
+  apr_size_t len;
+
+  /* Decoded delta window.  NULL marks the end of the delta. */
+  svn_txdelta_window_t *window;
+
+  /* Next event in the same block. */
+  struct parse_event_t *next;
+} parse_event_t;
+
+/* A sequence of events that is handed over as a whole.
+ */
+typedef struct parse_block_t
+{
+  /* Events in the order they occurred. */
+  parse_event_t *first;
+  parse_event_t *last;
+
+  /* Approximate amount of data held by the events. */
+  apr_size_t size;
+
+  /* If set, this is the last block and the parser ended with ERR. */
+  svn_boolean_t final;
+  svn_error_t *err;
+
+  /* Contains this block and all its events.  Created by the parser
+   * thread and destroyed by the calling thread. */
+  apr_pool_t *pool;
+
+  /* Next block in the queue. */
+  struct parse_block_t *next;
+} parse_block_t;
+
+/* State shared between the parser thread and the calling thread.
+ * The members after CURRENT must only be accessed while holding MUTEX.
+ */
+typedef struct parse_pipeline_t
+{
+  /* Parameters of the parser thread. */
+  svn_stream_t *stream;
+  svn_boolean_t deltas_are_text;
+
+  /* Stream handed out for all fulltexts.  Owned by the parser thread
+   * and stateless, so it can be reused as often as needed. */
+  svn_stream_t *fulltext_stream;
+
+  /* Block being filled by the parser thread.  Not shared. */
+  parse_block_t *current;
+
+  /* Blocks ready for replay. */
+  parse_block_t *head;
+  parse_block_t *tail;
+
+  /* Sum of the sizes of the queued blocks. */
+  apr_size_t queued;
+
+  /* Set by the calling thread if it won't take any further blocks. */
+  svn_boolean_t aborted;
+
+  /* Serialization and signalling of state changes. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+} parse_pipeline_t;
+
+/* Start a new block for PIPELINE->CURRENT.
+ */
+static void
+start_block(parse_pipeline_t *pipeline)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  pipeline->current = apr_pcalloc(pool, sizeof(*pipeline->current));
+  pipeline->current->pool = pool;
+}
+
+/* Queue PIPELINE->CURRENT for replay and start a new block.  Unless FINAL
+ * is set, wait for the replay to catch up if too much data is queued.
+ * Return SVN_ERR_CANCELLED if the calling thread has given up.
+ */
+static svn_error_t *
+flush_block(parse_pipeline_t *pipeline,
+            svn_boolean_t final)
+{
+  parse_block_t *block = pipeline->current;
+  svn_boolean_t aborted;
+
+  apr_thread_mutex_lock(pipeline->mutex);
+  while (   !final
+         && !pipeline->aborted
+         && pipeline->queued >= PIPELINE_MAX_QUEUED)
+    apr_thread_cond_wait(pipeline->changed, pipeline->mutex);
+
+  aborted = pipeline->aborted;
+  if (!aborted)
+    {
+      if (pipeline->tail)
+        pipeline->tail->next = block;
+      else
+        pipeline->head = block;
+
+      pipeline->tail = block;
+      pipeline->queued += block->size;
+      apr_thread_cond_broadcast(pipeline->changed);
+    }
+  apr_thread_mutex_unlock(pipeline->mutex);
+
+  if (aborted)
+    {
+      svn_error_clear(block->err);
+      svn_pool_destroy(block->pool);
+      pipeline->current = NULL;
+
+      return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+    }
+
+  if (final)
+    pipeline->current = NULL;
+  else
+    start_block(pipeline);
+
+  return SVN_NO_ERROR;
+}
+
+/* Append a new event of KIND and SIZE to PIPELINE->CURRENT and return it
+ * in *EVENT.  Hand the block over if it is full.
+ */
+static svn_error_t *
+add_event(parse_event_t **event,
+          parse_pipeline_t *pipeline,
+          parse_event_kind_t kind,
+          apr_size_t size)
+{
+  parse_block_t *block = pipeline->current;
+
+  /* Don't let blocks grow without bounds. */
+  if (block->size >= PIPELINE_BLOCK_SIZE)
+    {
+      SVN_ERR(flush_block(pipeline, FALSE));
+      block = pipeline->current;
+    }
+
+  *event = apr_pcalloc(block->pool, sizeof(**event));
+  (*event)->kind = kind;
+
+  if (block->last)
+    block->last->next = *event;
+  else
+    block->first = *event;
+
+  block->last = *event;
+  block->size += size + sizeof(**event);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a deep copy of the header hash HEADERS allocated in POOL and add
+ * its approximate size to *SIZE.
+ */
+static apr_hash_t *
+copy_headers(apr_size_t *size,
+             apr_hash_t *headers,
+             apr_pool_t *pool)
+{
+  apr_hash_t *copy = apr_hash_make(pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(pool, headers); hi; hi = apr_hash_next(hi))
+    {
+      const char *key = apr_hash_this_key(hi);
+      const char *val = apr_hash_this_val(hi);
+
+      *size += strlen(key) + strlen(val);
+      svn_hash_sets(copy, apr_pstrdup(pool, key), apr_pstrdup(pool, val));
+    }
+
+  return copy;
+}
+
+/* The following implement the recording svn_repos_parse_fns3_t callbacks.
+ * All batons are the parse_pipeline_t.
+ */
+static svn_error_t *
+record_magic_header_record(int version,
+                           void *parse_baton,
+                           apr_pool_t *pool)
+{
+  parse_event_t *event;
+
+  SVN_ERR(add_event(&event, parse_baton, parse_event_magic_header, 0));
+  event->version = version;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_uuid_record(const char *uuid,
+                   void *parse_baton,
+                   apr_pool_t *pool)
+{
+  parse_pipeline_t *pipeline = parse_baton;
+  parse_event_t *event;
+
+  SVN_ERR(add_event(&event, pipeline, parse_event_uuid, strlen(uuid)));
+  event->name = apr_pstrdup(pipeline->current->pool, uuid);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_new_revision_record(void **revision_baton,
+                           apr_hash_t *headers,
+                           void *parse_baton,
+                           apr_pool_t *pool)
+{
+  parse_pipeline_t *pipeline = parse_baton;
+  parse_event_t *event;
+  apr_size_t size = 0;
+
+  SVN_ERR(add_event(&event, pipeline, parse_event_new_revision, 0));
+  event->headers = copy_headers(&size, headers, pipeline->current->pool);
+  pipeline->current->size += size;
+
+  *revision_baton = pipeline;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_new_node_record(void **node_baton,
+                       apr_hash_t *headers,
+                       void *revision_baton,
+                       apr_pool_t *pool)
+{
+  parse_pipeline_t *pipeline = revision_baton;
+  parse_event_t *event;
+  apr_size_t size = 0;
+
+  /* We can't record anything for nodes outside of revisions. */
+  if (pipeline == NULL)
+    return stream_malformed();
+
+  SVN_ERR(add_event(&event, pipeline, parse_event_new_node, 0));
+  event->headers = copy_headers(&size, headers, pipeline->current->pool);
+  pipeline->current->size += size;
+
+  *node_baton = pipeline;
+  return SVN_NO_ERROR;
+}
+
+/* Record a property event of KIND for NAME and VALUE in PIPELINE.
+ * VALUE may be NULL.
+ */
+static svn_error_t *
+record_property(parse_pipeline_t *pipeline,
+                parse_event_kind_t kind,
+                const char *name,
+                const svn_string_t *value)
+{
+  parse_event_t *event;
+
+  SVN_ERR(add_event(&event, pipeline, kind,
+                    strlen(name) + (value ? value->len : 0)));
+  event->name = apr_pstrdup(pipeline->current->pool, name);
+  event->value = value ? svn_string_dup(value, pipeline->current->pool)
+                       : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_set_revision_property(void *revision_baton,
+                             const char *name,
+                             const svn_string_t *value)
+{
+  return svn_error_trace(record_property(revision_baton,
+                                         parse_event_set_revision_property,
+                                         name, value));
+}
+
+static svn_error_t *
+record_set_node_property(void *node_baton,
+                         const char *name,
+                         const svn_string_t *value)
+{
+  return svn_error_trace(record_property(node_baton,
+                                         parse_event_set_node_property,
+                                         name, value));
+}
+
+static svn_error_t *
+record_delete_node_property(void *node_baton,
+                            const char *name)
+{
+  return svn_error_trace(record_property(node_baton,
+                                         parse_event_delete_node_property,
+                                         name, NULL));
+}
+
+static svn_error_t *
+record_remove_node_props(void *node_baton)
+{
+  parse_event_t *event;
+  return svn_error_trace(add_event(&event, node_baton,
+                                   parse_event_remove_node_props, 0));
+}
+
+/* Implements svn_write_fn_t for fulltext streams.  BATON is the
+ * parse_pipeline_t.
+ */
+static svn_error_t *
+record_fulltext_write(void *baton,
+                      const char *data,
+                      apr_size_t *len)
+{
+  parse_pipeline_t *pipeline = baton;
+  parse_event_t *event;
+
+  SVN_ERR(add_event(&event, pipeline, parse_event_fulltext_data, *len));
+  event->data = apr_pmemdup(pipeline->current->pool, data, *len);
+  event->len = *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t for fulltext streams.  BATON is the
+ * parse_pipeline_t.
+ */
+static svn_error_t *
+record_fulltext_close(void *baton)
+{
+  parse_event_t *event;
+  return svn_error_trace(add_event(&event, baton,
+                                   parse_event_close_fulltext, 0));
+}
+
+static svn_error_t *
+record_set_fulltext(svn_stream_t **stream,
+                    void *node_baton)
+{
+  parse_pipeline_t *pipeline = node_baton;
+  parse_event_t *event;
+
+  SVN_ERR(add_event(&event, pipeline, parse_event_set_fulltext, 0));
+  *stream = pipeline->fulltext_stream;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_window_handler_t.  BATON is the
+ * parse_pipeline_t.
+ */
+static svn_error_t *
+record_window(svn_txdelta_window_t *window,
+              void *baton)
+{
+  parse_pipeline_t *pipeline = baton;
+  parse_event_t *event;
+  apr_size_t size = 0;
+
+  if (window)
+    size = window->num_ops * sizeof(*window->ops)
+         + (window->new_data ? window->new_data->len : 0);
+
+  SVN_ERR(add_event(&event, pipeline, parse_event_window, size));
+  event->window = window
+                ? svn_txdelta_window_dup(window, pipeline->current->pool)
+                : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_apply_textdelta(svn_txdelta_window_handler_t *handler,
+                       void **handler_baton,
+                       void *node_baton)
+{
+  parse_pipeline_t *pipeline = node_baton;
+  parse_event_t *event;
+
+  SVN_ERR(add_event(&event, pipeline, parse_event_apply_textdelta, 0));
+
+  *handler = record_window;
+  *handler_baton = pipeline;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_close_node(void *node_baton)
+{
+  parse_event_t *event;
+  return svn_error_trace(add_event(&event, node_baton,
+                                   parse_event_close_node, 0));
+}
+
+static svn_error_t *
+record_close_revision(void *revision_baton)
+{
+  parse_event_t *event;
+  return svn_error_trace(add_event(&event, revision_baton,
+                                   parse_event_close_revision, 0));
+}
+
+/* The vtable used by the parser thread. */
+static const svn_repos_parse_fns3_t recording_vtable =
+{
+  record_magic_header_record,
+  record_uuid_record,
+  record_new_revision_record,
+  record_new_node_record,
+  record_set_revision_property,
+  record_set_node_property,
+  record_delete_node_property,
+  record_remove_node_props,
+  record_set_fulltext,
+  record_apply_textdelta,
+  record_close_node,
+  record_close_revision
+};
+
+/* Parser thread main function.  DATA is the parse_pipeline_t.
+ */
+static void *
+APR_THREAD_FUNC parse_thread_func(apr_thread_t *tid, void *data)
+{
+  parse_pipeline_t *pipeline = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+  svn_error_t *err;
+
+  pipeline->fulltext_stream = svn_stream_create(pipeline, pool);
+  svn_stream_set_write(pipeline->fulltext_stream, record_fulltext_write);
+  svn_stream_set_close(pipeline->fulltext_stream, record_fulltext_close);
+
+  start_block(pipeline);
+
+  /* Cancellation is handled by the calling thread. */
+  err = parse_dumpstream(pipeline->stream, &recording_vtable, pipeline,
+                         pipeline->deltas_are_text, NULL, NULL, pool);
+
+  /* If the calling thread gave up, the block will be discarded.
+   * Otherwise, it now owns ERR. */
+  if (pipeline->current)
+    {
+      pipeline->current->final = TRUE;
+      pipeline->current->err = err;
+      svn_error_clear(flush_block(pipeline, TRUE));
+    }
+  else
+    {
+      svn_error_clear(err);
+    }
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* The state of the replay in the calling thread.
+ */
+typedef struct replay_state_t
+{
+  /* The caller's vtable and parse baton. */
+  const svn_repos_parse_fns3_t *parse_fns;
+  void *parse_baton;
+
+  /* Batons returned by PARSE_FNS for the current revision and node. */
+  void *rev_baton;
+  void *node_baton;
+
+  /* Whether we are inside a node record. */
+  svn_boolean_t in_node;
+
+  /* Target of the current fulltext or delta.  Either may be NULL. */
+  svn_stream_t *text_stream;
+  svn_txdelta_window_handler_t window_handler;
+  void *window_baton;
+
+  /* Emulate the pools used by the sequential parser. */
+  apr_pool_t *pool;
+  apr_pool_t *linepool;
+  apr_pool_t *revpool;
+  apr_pool_t *nodepool;
+} replay_state_t;
+
+/* Invoke the callback in STATE->PARSE_FNS that EVENT has recorded.
+ */
+static svn_error_t *
+replay_event(replay_state_t *state,
+             const parse_event_t *event)
+{
+  const svn_repos_parse_fns3_t *parse_fns = state->parse_fns;
+  apr_pool_t *proppool = state->in_node ? state->nodepool : state->revpool;
+  void *baton = state->in_node ? state->node_baton : state->rev_baton;
+  apr_size_t len;
+
+  switch (event->kind)
+    {
+      case parse_event_magic_header:
+        return svn_error_trace(parse_fns->magic_header_record(
+                                 event->version, state->parse_baton,
+                                 state->pool));
+
+      case parse_event_uuid:
+        svn_pool_clear(state->linepool);
+        return svn_error_trace(parse_fns->uuid_record(
+                                 apr_pstrdup(state->linepool, event->name),
+                                 state->parse_baton, state->pool));
+
+      case parse_event_new_revision:
+        svn_pool_clear(state->linepool);
+        return svn_error_trace(parse_fns->new_revision_record(
+                                 &state->rev_baton,
+                                 copy_headers(&len, event->headers,
+                                              state->linepool),
+                                 state->parse_baton, state->revpool));
+
+      case parse_event_new_node:
+        svn_pool_clear(state->linepool);
+        state->in_node = TRUE;
+        return svn_error_trace(parse_fns->new_node_record(
+                                 &state->node_baton,
+                                 copy_headers(&len, event->headers,
+                                              state->linepool),
+                                 state->rev_baton, state->nodepool));
+
+      case parse_event_set_revision_property:
+        return svn_error_trace(parse_fns->set_revision_property(
+                                 state->rev_baton,
+                                 apr_pstrdup(proppool, event->name),
+                                 svn_string_dup(event->value, proppool)));
+
+      case parse_event_set_node_property:
+        return svn_error_trace(parse_fns->set_node_property(
+                                 state->node_baton,
+                                 apr_pstrdup(proppool, event->name),
+                                 svn_string_dup(event->value, proppool)));
+
+      case parse_event_delete_node_property:
+        return svn_error_trace(parse_fns->delete_node_property(
+                                 state->node_baton,
+                                 apr_pstrdup(proppool, event->name)));
+
+      case parse_event_remove_node_props:
+        return svn_error_trace(parse_fns->remove_node_props(
+                                 state->node_baton));
+
+      case parse_event_set_fulltext:
+        return svn_error_trace(parse_fns->set_fulltext(
+                                 &state->text_stream, baton));
+
+      case parse_event_fulltext_data:
+        if (state->text_stream)
+          {
+            len = event->len;
+            SVN_ERR(svn_stream_write(state->text_stream, event->data, &len));
+            if (len != event->len)
+              return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
+                                      _("Unexpected EOF writing contents"));
+          }
+        return SVN_NO_ERROR;
+
+      case parse_event_close_fulltext:
+        if (state->text_stream)
+          {
+            svn_stream_t *stream = state->text_stream;
+            state->text_stream = NULL;
+            SVN_ERR(svn_stream_close(stream));
+          }
+        return SVN_NO_ERROR;
+
+      case parse_event_apply_textdelta:
+        return svn_error_trace(parse_fns->apply_textdelta(
+                                 &state->window_handler,
+                                 &state->window_baton, baton));
+
+      case parse_event_window:
+        if (state->window_handler)
+          {
+            svn_txdelta_window_handler_t handler = state->window_handler;
+            if (event->window == NULL)
+              state->window_handler = NULL;
+
+            SVN_ERR(handler(event->window, state->window_baton));
+          }
+        return SVN_NO_ERROR;
+
+      case parse_event_close_node:
+        {
+          void *node_baton = state->node_baton;
+          state->node_baton = NULL;
+          state->in_node = FALSE;
+
+          SVN_ERR(parse_fns->close_node(node_baton));
+          svn_pool_clear(state->nodepool);
+        }
+        return SVN_NO_ERROR;
+
+      case parse_event_close_revision:
+        {
+          void *rev_baton = state->rev_baton;
+          state->rev_baton = NULL;
+
+          /* The sequential parser skips revisions without baton. */
+          if (rev_baton != NULL)
+            SVN_ERR(parse_fns->close_revision(rev_baton));
+          svn_pool_clear(state->revpool);
+        }
+        return SVN_NO_ERROR;
+
+      default:
+        SVN_ERR_MALFUNCTION();
+    }
+}
+
+/* Like parse_dumpstream() but with the parsing and decoding running
+ * in a separate thread.
+ */
+static svn_error_t *
+parse_dumpstream_pipelined(svn_stream_t *stream,
+                           const svn_repos_parse_fns3_t *parse_fns,
+                           void *parse_baton,
+                           svn_boolean_t deltas_are_text,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *pool)
+{
+  parse_pipeline_t pipeline = { 0 };
+  replay_state_t state = { 0 };
+  apr_thread_t *thread;
+  apr_status_t status;
+  svn_boolean_t done = FALSE;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  pipeline.stream = stream;
+  pipeline.deltas_are_text = deltas_are_text;
+  status = apr_thread_mutex_create(&pipeline.mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   pool);
+  if (!status)
+    status = apr_thread_cond_create(&pipeline.changed, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create dump parser mutex"));
+
+  state.parse_fns = complete_vtable(parse_fns, pool);
+  state.parse_baton = parse_baton;
+  state.pool = pool;
+  state.linepool = svn_pool_create(pool);
+  state.revpool = svn_pool_create(pool);
+  state.nodepool = svn_pool_create(pool);
+
+  status = apr_thread_create(&thread, NULL, parse_thread_func, &pipeline,
+                             pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create thread"));
+
+  /* Replay the recorded events block by block. */
+  while (!done && !err)
+    {
+      parse_block_t *block;
+      const parse_event_t *event;
+
+      apr_thread_mutex_lock(pipeline.mutex);
+      while (!pipeline.head)
+        apr_thread_cond_wait(pipeline.changed, pipeline.mutex);
+
+      block = pipeline.head;
+      pipeline.head = block->next;
+      if (!pipeline.head)
+        pipeline.tail = NULL;
+
+      pipeline.queued -= block->size;
+      apr_thread_cond_broadcast(pipeline.changed);
+      apr_thread_mutex_unlock(pipeline.mutex);
+
+      if (cancel_func)
+        err = cancel_func(cancel_baton);
+
+      for (event = block->first; event && !err; event = event->next)
+        err = replay_event(&state, event);
+
+      /* The parser error comes after all events that preceded it. */
+      done = block->final;
+      if (done)
+        err = svn_error_compose_create(err, block->err);
+
+      svn_pool_destroy(block->pool);
+    }
+
+  /* Stop the parser and release what it left behind. */
+  apr_thread_mutex_lock(pipeline.mutex);
+  pipeline.aborted = TRUE;
+  apr_thread_cond_broadcast(pipeline.changed);
+  apr_thread_mutex_unlock(pipeline.mutex);
+
+  apr_thread_join(&status, thread);
+
+  while (pipeline.head)
+    {
+      parse_block_t *block = pipeline.head;
+      pipeline.head = block->next;
+
+      svn_error_clear(block->err);
+      svn_pool_destroy(block->pool);
+    }
+
+  svn_pool_destroy(state.linepool);
+  svn_pool_destroy(state.revpool);
+  svn_pool_destroy(state.nodepool);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+
+/** The public routines **/
+
+svn_error_t *
+svn_repos_parse_dumpstream3(svn_stream_t *stream,
+                            const svn_repos_parse_fns3_t *parse_fns,
+                            void *parse_baton,
+                            svn_boolean_t deltas_are_text,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *pool)
+{
+  return svn_error_trace(parse_dumpstream(stream, parse_fns, parse_baton,
+                                          deltas_are_text,
+                                          cancel_func, cancel_baton, pool));
+}
+
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      svn_boolean_t deltas_are_text,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  return svn_error_trace(parse_dumpstream_pipelined(stream, parse_fns,
+                                                    parse_baton,
+                                                    deltas_are_text,
+                                                    cancel_func,
+                                                    cancel_baton, pool));
+#else
+  return svn_error_trace(parse_dumpstream(stream, parse_fns, parse_baton,
+                                          deltas_are_text,
+                                          cancel_func, cancel_baton, pool));
+#endif
+}
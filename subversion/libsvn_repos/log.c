@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #define APR_WANT_STRFUNC
 #include <apr_want.h>
+#include <apr_fnmatch.h>
 
 #include "svn_compat.h"
 #include "svn_private_config.h"
@@ -41,9 +42,11 @@
 #include "private/svn_fspath.h"
 #include "private/svn_fs_private.h"
 #include "private/svn_mergeinfo_private.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_utf_private.h"
 
 
 /* This is a mere convenience struct such that we don't need to pass that
@@ -56,6 +59,10 @@ typedef struct log_callbacks_t
   void *revision_receiver_baton;
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
+
+  /* If not NULL, only send revisions matching any of these groups of
+     prepared search patterns.  See svn_repos__get_logs_search(). */
+  const apr_array_header_t *search_patterns;
 } log_callbacks_t;
 
 
@@ -421,6 +428,10 @@ struct path_info
   svn_boolean_t done;
   svn_boolean_t first_time;
 
+  /* Whether we may still take the next step using the changed-paths index
+     of the repository, if there is one.  See svn_fs__changed_paths_prev(). */
+  svn_boolean_t use_index;
+
   /* If possible, we like to keep open the history object for each path,
      since it avoids needed to open and close it many times as we walk
      backwards in time.  To do so we need two pools, so that we can clear
@@ -462,6 +473,64 @@ get_history(struct path_info *info,
   apr_pool_t *subpool;
   const char *path;
 
+  if (info->use_index)
+    {
+      svn_revnum_t revision;
+      svn_boolean_t structural;
+
+      SVN_ERR(svn_fs__changed_paths_prev(&revision, &structural, fs,
+                                         info->path->data,
+                                         info->first_time
+                                           ? info->history_rev + 1
+                                           : info->history_rev,
+                                         scratch_pool));
+      if (SVN_IS_VALID_REVNUM(revision) && !structural)
+        {
+          /* Same node, same path, just an older revision. */
+          info->history_rev = revision;
+          info->first_time = FALSE;
+
+          if (info->history_rev < start)
+            {
+              if (info->newpool)
+                svn_pool_destroy(info->newpool);
+              if (info->oldpool)
+                svn_pool_destroy(info->oldpool);
+              info->done = TRUE;
+              return SVN_NO_ERROR;
+            }
+
+          if (authz_read_func)
+            {
+              svn_boolean_t readable;
+              SVN_ERR(svn_fs_revision_root(&history_root, fs,
+                                           info->history_rev,
+                                           scratch_pool));
+              SVN_ERR(authz_read_func(&readable, history_root,
+                                      info->path->data,
+                                      authz_read_baton,
+                                      scratch_pool));
+              if (! readable)
+                info->done = TRUE;
+            }
+
+          return SVN_NO_ERROR;
+        }
+
+      /* Copies, deletions and revisions outside the index need the node
+         history.  Any history object we hold has been left behind by the
+         steps taken above, so reopen it at the current revision. */
+      info->use_index = FALSE;
+      if (info->hist && ! info->first_time)
+        {
+          svn_pool_destroy(info->newpool);
+          svn_pool_destroy(info->oldpool);
+          info->hist = NULL;
+          info->newpool = NULL;
+          info->oldpool = NULL;
+        }
+    }
+
   if (info->hist)
     {
       subpool = info->newpool;
@@ -548,65 +617,19 @@ get_history(struct path_info *info,
   return SVN_NO_ERROR;
 }
 
-/* Set INFO->HIST to the next history for the path *if* there is history
- * available and INFO->HISTORY_REV is equal to or greater than CURRENT.
- *
- * *CHANGED is set to TRUE if the path has history in the CURRENT revision,
- * otherwise it is not touched.
- *
- * If we do need to get the next history revision for the path, call
- * get_history to do it -- see it for details.
- */
-static svn_error_t *
-check_history(svn_boolean_t *changed,
-              struct path_info *info,
-              svn_fs_t *fs,
-              svn_revnum_t current,
-              svn_boolean_t strict,
-              svn_repos_authz_func_t authz_read_func,
-              void *authz_read_baton,
-              svn_revnum_t start,
-              apr_pool_t *result_pool,
-              apr_pool_t *scratch_pool)
-{
-  /* If we're already done with histories for this path,
-     don't try to fetch any more. */
-  if (info->done)
-    return SVN_NO_ERROR;
-
-  /* If the last rev we got for this path is less than CURRENT,
-     then just return and don't fetch history for this path.
-     The caller will get to this rev eventually or else reach
-     the limit. */
-  if (info->history_rev < current)
-    return SVN_NO_ERROR;
-
-  /* If the last rev we got for this path is equal to CURRENT
-     then set *CHANGED to true and get the next history
-     rev where this path was changed. */
-  *changed = TRUE;
-  return get_history(info, fs, strict, authz_read_func,
-                     authz_read_baton, start, result_pool, scratch_pool);
-}
-
-/* Return the next interesting revision in our list of HISTORIES. */
-static svn_revnum_t
-next_history_rev(const apr_array_header_t *histories)
+/* Order the path_info pointers A and B such that the one with the
+   youngest HISTORY_REV comes first.  Used with svn_priority_queue__t. */
+static int
+compare_history_revs(const void *a,
+                     const void *b)
 {
-  svn_revnum_t next_rev = SVN_INVALID_REVNUM;
-  int i;
+  const struct path_info *lhs = *(const struct path_info * const *)a;
+  const struct path_info *rhs = *(const struct path_info * const *)b;
 
-  for (i = 0; i < histories->nelts; ++i)
-    {
-      struct path_info *info = APR_ARRAY_IDX(histories, i,
-                                             struct path_info *);
-      if (info->done)
-        continue;
-      if (info->history_rev > next_rev)
-        next_rev = info->history_rev;
-    }
+  if (lhs->history_rev == rhs->history_rev)
+    return 0;
 
-  return next_rev;
+  return lhs->history_rev > rhs->history_rev ? -1 : 1;
 }
 
 /* Set *DELETED_MERGEINFO_CATALOG and *ADDED_MERGEINFO_CATALOG to
@@ -1276,6 +1299,152 @@ interesting_merge(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* Baton type to be used with the search_path_change callback. */
+typedef struct search_baton_t
+{
+  /* The pattern groups to match, see log_callbacks_t. */
+  const apr_array_header_t *search_patterns;
+
+  /* For each group in SEARCH_PATTERNS, one flag per pattern telling
+     whether it matched anything seen so far. */
+  svn_boolean_t **matched;
+
+  /* Scratch buffer for search_match(). */
+  svn_membuf_t buf;
+
+  /* The callback to pass the changes on to if the revision matches. */
+  svn_repos_path_change_receiver_t inner;
+  void *inner_baton;
+} search_baton_t;
+
+/* Return TRUE if the prepared search PATTERN matches the LEN bytes long
+ * STR.  Use BUF for temporary allocations. */
+static svn_boolean_t
+search_match(const char *pattern,
+             const char *str,
+             apr_size_t len,
+             svn_membuf_t *buf)
+{
+  svn_error_t *err = svn_utf__xfrm(&str, str, len, TRUE, TRUE, buf);
+  if (err)
+    {
+      /* Can't match invalid data. */
+      svn_error_clear(err);
+      return FALSE;
+    }
+
+  return apr_fnmatch(pattern, str, 0) == APR_SUCCESS;
+}
+
+/* Initialize B for SEARCH_PATTERNS with no pattern matched yet.
+ * Allocate in POOL. */
+static void
+search_baton_init(search_baton_t *b,
+                  const apr_array_header_t *search_patterns,
+                  apr_pool_t *pool)
+{
+  int i;
+
+  b->search_patterns = search_patterns;
+  b->matched = apr_palloc(pool, search_patterns->nelts * sizeof(*b->matched));
+  for (i = 0; i < search_patterns->nelts; i++)
+    {
+      const apr_array_header_t *group
+        = APR_ARRAY_IDX(search_patterns, i, const apr_array_header_t *);
+      b->matched[i] = apr_pcalloc(pool, group->nelts * sizeof(**b->matched));
+    }
+
+  svn_membuf__create(&b->buf, 0, pool);
+}
+
+/* Flag all patterns in B that match the LEN bytes long STR. */
+static void
+search_note_matches(search_baton_t *b,
+                    const char *str,
+                    apr_size_t len)
+{
+  int i, k;
+
+  for (i = 0; i < b->search_patterns->nelts; i++)
+    {
+      const apr_array_header_t *group
+        = APR_ARRAY_IDX(b->search_patterns, i, const apr_array_header_t *);
+
+      for (k = 0; k < group->nelts; k++)
+        if (!b->matched[i][k]
+            && search_match(APR_ARRAY_IDX(group, k, const char *),
+                            str, len, &b->buf))
+          b->matched[i][k] = TRUE;
+    }
+}
+
+/* Implements svn_repos_path_change_receiver_t.
+ * *BATON is a search_baton_t.
+ *
+ * Match CHANGE against the search patterns but don't keep it.  The changes
+ * of a matching revision get reported in a second pass, so that we never
+ * hold all changes of a revision in memory.
+ */
+static svn_error_t *
+search_path_change(void *baton,
+                   svn_repos_path_change_t *change,
+                   apr_pool_t *scratch_pool)
+{
+  search_baton_t *b = baton;
+
+  search_note_matches(b, change->path.data, change->path.len);
+  if (change->copyfrom_path && SVN_IS_VALID_REVNUM(change->copyfrom_rev))
+    search_note_matches(b, change->copyfrom_path,
+                        strlen(change->copyfrom_path));
+
+  return SVN_NO_ERROR;
+}
+
+/* Flag all patterns in B that match the author, date or log message in
+ * REVPROPS (which may be NULL). */
+static void
+search_note_revprops(search_baton_t *b,
+                     apr_hash_t *revprops)
+{
+  static const char * const searched_revprops[] = {
+    SVN_PROP_REVISION_AUTHOR,
+    SVN_PROP_REVISION_DATE,
+    SVN_PROP_REVISION_LOG,
+    NULL
+  };
+  int i;
+
+  for (i = 0; revprops && searched_revprops[i]; i++)
+    {
+      const svn_string_t *value = svn_hash_gets(revprops,
+                                                searched_revprops[i]);
+      if (value)
+        search_note_matches(b, value->data, value->len);
+    }
+}
+
+/* Return TRUE if all patterns of any group in B have matched. */
+static svn_boolean_t
+search_patterns_matched(const search_baton_t *b)
+{
+  int i, k;
+
+  for (i = 0; i < b->search_patterns->nelts; i++)
+    {
+      const apr_array_header_t *group
+        = APR_ARRAY_IDX(b->search_patterns, i, const apr_array_header_t *);
+
+      for (k = 0; k < group->nelts; k++)
+        if (!b->matched[i][k])
+          break;
+
+      if (k == group->nelts)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
 /* Send a log message for REV to the CALLBACKS.
 
    FS is used with REV to fetch the interesting history information,
@@ -1301,7 +1470,10 @@ interesting_merge(void *baton,
    If HANDLING_MERGED_REVISIONS is FALSE then ignore NESTED_MERGES.  Otherwise
    if NESTED_MERGES is not NULL and REV is contained in it, then don't send
    the log for REV, otherwise send it normally and add REV to
-   NESTED_MERGES. */
+   NESTED_MERGES.
+
+   If CALLBACKS->SEARCH_PATTERNS is not NULL, don't send anything for REV
+   unless it matches those patterns. */
 static svn_error_t *
 send_log(svn_revnum_t rev,
          svn_fs_t *fs,
@@ -1318,6 +1490,7 @@ send_log(svn_revnum_t rev,
   log_callbacks_t my_callbacks = *callbacks;
 
   interesting_merge_baton_t baton;
+  search_baton_t search_baton = { NULL };
 
   /* Is REV a merged revision that is already part of
      LOG_TARGET_HISTORY_AS_MERGEINFO?  If so then there is no
@@ -1343,10 +1516,48 @@ send_log(svn_revnum_t rev,
       baton.found_rev_of_interest = TRUE;
     }
 
+  /* The changes may only be sent once we know that REV matches the
+     search.  Only match them for now. */
+  if (callbacks->search_patterns)
+    search_baton_init(&search_baton, callbacks->search_patterns, pool);
+
+  if (callbacks->search_patterns && callbacks->path_change_receiver)
+    {
+      search_baton.inner = callbacks->path_change_receiver;
+      search_baton.inner_baton = callbacks->path_change_receiver_baton;
+
+      my_callbacks.path_change_receiver = search_path_change;
+      my_callbacks.path_change_receiver_baton = &search_baton;
+      callbacks = &my_callbacks;
+    }
+
   SVN_ERR(fill_log_entry(&log_entry, rev, fs, revprops, callbacks, pool));
   log_entry.has_children = has_children;
   log_entry.subtractive_merge = subtractive_merge;
 
+  if (callbacks->search_patterns)
+    {
+      search_note_revprops(&search_baton, log_entry.revprops);
+      if (!search_patterns_matched(&search_baton))
+        return SVN_NO_ERROR;
+
+      /* REV matches.  Fetch its changes once more and report them. */
+      if (search_baton.inner && rev > 0)
+        {
+          log_callbacks_t report_callbacks = *callbacks;
+          svn_fs_root_t *root;
+          svn_repos_revision_access_level_t access_level;
+
+          report_callbacks.path_change_receiver = search_baton.inner;
+          report_callbacks.path_change_receiver_baton
+            = search_baton.inner_baton;
+
+          SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+          SVN_ERR(detect_changed(&access_level, root, fs, &report_callbacks,
+                                 pool));
+        }
+    }
+
   /* Send the entry to the receiver, unless it is a redundant merged
      revision. */
   if (baton.found_rev_of_interest)
@@ -1442,6 +1653,7 @@ get_path_histories(apr_array_header_t **histories,
       info->done = FALSE;
       info->history_rev = hist_end;
       info->first_time = TRUE;
+      info->use_index = TRUE;
 
       if (i < MAX_OPEN_HISTORIES)
         {
@@ -1713,12 +1925,77 @@ combine_mergeinfo_path_lists(apr_array_header_t **combined_list,
 }
 
 
+/* The paths and revision ranges that do_logs() has already searched
+   while handling nested merges.  These tend to visit the same long paths
+   over and over again, so we intern them in a prefix tree and key the
+   RANGES hash by the resulting svn_prefix_string__t pointers. */
+typedef struct processed_searches_t
+{
+  /* All paths searched so far. */
+  svn_prefix_tree__t *paths;
+
+  /* svn_prefix_string__t * -> processed_path_t * */
+  apr_hash_t *ranges;
+} processed_searches_t;
+
+/* Entry in processed_searches_t.RANGES. */
+typedef struct processed_path_t
+{
+  /* The interned path.  Its address doubles as hash key. */
+  svn_prefix_string__t *path;
+
+  /* The revisions searched for PATH, see store_search(). */
+  svn_rangelist_t *ranges;
+} processed_path_t;
+
+/* Return a new, empty processed_searches_t allocated in RESULT_POOL. */
+static processed_searches_t *
+processed_searches_create(apr_pool_t *result_pool)
+{
+  processed_searches_t *processed = apr_palloc(result_pool,
+                                               sizeof(*processed));
+  processed->paths = svn_prefix_tree__create(result_pool);
+  processed->ranges = apr_hash_make(result_pool);
+
+  return processed;
+}
+
+/* Return the entry for PATH in PROCESSED.  If there is none, return NULL
+   or, if CREATE is set, add a new entry with an empty rangelist. */
+static processed_path_t *
+get_processed_path(processed_searches_t *processed,
+                   const char *path,
+                   svn_boolean_t create)
+{
+  apr_pool_t *processed_pool = apr_hash_pool_get(processed->ranges);
+  svn_prefix_string__t *key;
+  processed_path_t *entry;
+
+  key = create ? svn_prefix_string__create(processed->paths, path)
+               : svn_prefix_string__find(processed->paths, path);
+  if (!key)
+    return NULL;
+
+  entry = apr_hash_get(processed->ranges, &key, sizeof(key));
+  if (!entry && create)
+    {
+      entry = apr_palloc(processed_pool, sizeof(*entry));
+      entry->path = key;
+      entry->ranges = apr_array_make(processed_pool, 1,
+                                     sizeof(svn_merge_range_t *));
+      apr_hash_set(processed->ranges, &entry->path, sizeof(entry->path),
+                   entry);
+    }
+
+  return entry;
+}
+
 /* Pity that C is so ... linear. */
 static svn_error_t *
 do_logs(svn_fs_t *fs,
         const apr_array_header_t *paths,
         svn_mergeinfo_t log_target_history_as_mergeinfo,
-        svn_mergeinfo_t processed,
+        processed_searches_t *processed,
         svn_bit_array__t *nested_merges,
         svn_revnum_t hist_start,
         svn_revnum_t hist_end,
@@ -1769,7 +2046,7 @@ handle_merged_revisions(svn_revnum_t rev,
                         svn_fs_t *fs,
                         svn_mergeinfo_t log_target_history_as_mergeinfo,
                         svn_bit_array__t *nested_merges,
-                        svn_mergeinfo_t processed,
+                        processed_searches_t *processed,
                         svn_mergeinfo_t added_mergeinfo,
                         svn_mergeinfo_t deleted_mergeinfo,
                         svn_boolean_t strict_node_history,
@@ -1837,7 +2114,7 @@ static svn_error_t *
 reduce_search(apr_array_header_t *paths,
               svn_revnum_t *hist_start,
               svn_revnum_t *hist_end,
-              svn_mergeinfo_t processed,
+              processed_searches_t *processed,
               apr_pool_t *scratch_pool)
 {
   /* We add 1 to end to compensate for store_search */
@@ -1848,12 +2125,15 @@ reduce_search(apr_array_header_t *paths,
   for (i = 0; i < paths->nelts; ++i)
     {
       const char *path = APR_ARRAY_IDX(paths, i, const char *);
-      svn_rangelist_t *ranges = svn_hash_gets(processed, path);
+      processed_path_t *entry = get_processed_path(processed, path, FALSE);
+      svn_rangelist_t *ranges;
       int j;
 
-      if (!ranges)
+      if (!entry)
         continue;
 
+      ranges = entry->ranges;
+
       /* ranges is ordered, could we use some sort of binary search
          rather than iterating? */
       for (j = 0; j < ranges->nelts; ++j)
@@ -1902,7 +2182,7 @@ reduce_search(apr_array_header_t *paths,
 
 /* Extend PROCESSED to cover PATHS from HIST_START to HIST_END */
 static svn_error_t *
-store_search(svn_mergeinfo_t processed,
+store_search(processed_searches_t *processed,
              const apr_array_header_t *paths,
              svn_revnum_t hist_start,
              svn_revnum_t hist_end,
@@ -1912,25 +2192,25 @@ store_search(svn_mergeinfo_t processed,
      singe revisions where HIST_START is equal to HIST_END. */
   svn_revnum_t start = hist_start <= hist_end ? hist_start : hist_end;
   svn_revnum_t end = hist_start <= hist_end ? hist_end + 1 : hist_start + 1;
-  svn_mergeinfo_t mergeinfo = svn_hash__make(scratch_pool);
-  apr_pool_t *processed_pool = apr_hash_pool_get(processed);
+  apr_pool_t *processed_pool = apr_hash_pool_get(processed->ranges);
+  svn_rangelist_t *ranges = apr_array_make(scratch_pool, 1,
+                                           sizeof(svn_merge_range_t *));
+  svn_merge_range_t range;
   int i;
 
+  range.start = start;
+  range.end = end;
+  range.inheritable = TRUE;
+  APR_ARRAY_PUSH(ranges, svn_merge_range_t *) = &range;
+
   for (i = 0; i < paths->nelts; ++i)
     {
       const char *path = APR_ARRAY_IDX(paths, i, const char *);
-      svn_rangelist_t *ranges = apr_array_make(processed_pool, 1,
-                                               sizeof(svn_merge_range_t*));
-      svn_merge_range_t *range = apr_palloc(processed_pool, sizeof(*range));
-
-      range->start = start;
-      range->end = end;
-      range->inheritable = TRUE;
-      APR_ARRAY_PUSH(ranges, svn_merge_range_t *) = range;
-      svn_hash_sets(mergeinfo, apr_pstrdup(processed_pool, path), ranges);
+      processed_path_t *entry = get_processed_path(processed, path, TRUE);
+
+      SVN_ERR(svn_rangelist_merge2(entry->ranges, ranges, processed_pool,
+                                   scratch_pool));
     }
-  SVN_ERR(svn_mergeinfo_merge2(processed, mergeinfo,
-                               apr_hash_pool_get(processed), scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -1959,9 +2239,8 @@ store_search(svn_mergeinfo_t processed,
    do_logs()/send_logs()/handle_merge_revisions() recursions, see also the
    argument of the same name in send_logs().
 
-   PROCESSED is a mergeinfo hash that represents the paths and
-   revisions that have already been searched.  Allocated like
-   NESTED_MERGES above.
+   PROCESSED represents the paths and revisions that have already been
+   searched.  Allocated like NESTED_MERGES above.
 
    All other parameters are the same as svn_repos_get_logs5().
  */
@@ -1969,7 +2248,7 @@ static svn_error_t *
 do_logs(svn_fs_t *fs,
         const apr_array_header_t *paths,
         svn_mergeinfo_t log_target_history_as_mergeinfo,
-        svn_mergeinfo_t processed,
+        processed_searches_t *processed,
         svn_bit_array__t *nested_merges,
         svn_revnum_t hist_start,
         svn_revnum_t hist_end,
@@ -1987,10 +2266,11 @@ do_logs(svn_fs_t *fs,
   apr_pool_t *iterpool, *iterpool2;
   apr_pool_t *subpool = NULL;
   apr_array_header_t *revs = NULL;
-  apr_hash_t *rev_mergeinfo = NULL;
+  svn_hash_map__t *rev_mergeinfo = NULL;
   svn_revnum_t current;
   apr_array_header_t *histories;
-  svn_boolean_t any_histories_left = TRUE;
+  apr_array_header_t *pending;
+  svn_priority_queue__t *queue;
   int send_count = 0;
   int i;
 
@@ -2017,135 +2297,149 @@ do_logs(svn_fs_t *fs,
                              callbacks->authz_read_func,
                              callbacks->authz_read_baton, pool));
 
-  /* Loop through all the revisions in the range and add any
-     where a path was changed to the array, or if they wanted
-     history in reverse order just send it to them right away. */
+  /* Keep the histories that still have revisions for us ordered by
+     their youngest revision.  Finding the next revision to process is
+     then logarithmic in the number of paths instead of linear. */
+  pending = apr_array_make(pool, histories->nelts,
+                           sizeof(struct path_info *));
+  for (i = 0; i < histories->nelts; i++)
+    {
+      struct path_info *info = APR_ARRAY_IDX(histories, i,
+                                             struct path_info *);
+      if (! info->done)
+        APR_ARRAY_PUSH(pending, struct path_info *) = info;
+    }
+
+  queue = svn_priority_queue__create(pending, compare_history_revs);
+
+  /* Loop through all the revisions in which a path was changed and add
+     them to the array, or if they wanted history in reverse order just
+     send them right away. */
   iterpool = svn_pool_create(pool);
   iterpool2 = svn_pool_create(pool);
-  for (current = hist_end;
-       any_histories_left;
-       current = next_history_rev(histories))
+  while (svn_priority_queue__size(queue))
     {
-      svn_boolean_t changed = FALSE;
-      any_histories_left = FALSE;
+      struct path_info **next = svn_priority_queue__peek(queue);
+      svn_mergeinfo_t added_mergeinfo = NULL;
+      svn_mergeinfo_t deleted_mergeinfo = NULL;
+      svn_boolean_t has_children = FALSE;
+
+      current = (*next)->history_rev;
       svn_pool_clear(iterpool);
 
-      for (i = 0; i < histories->nelts; i++)
+      /* Advance all paths changed in CURRENT to the next revision in
+         which they were changed.  Depleted histories leave the queue. */
+      do
         {
-          struct path_info *info = APR_ARRAY_IDX(histories, i,
-                                                 struct path_info *);
+          struct path_info *info = *next;
 
           svn_pool_clear(iterpool2);
+          SVN_ERR(get_history(info, fs, strict_node_history,
+                              callbacks->authz_read_func,
+                              callbacks->authz_read_baton,
+                              hist_start, pool, iterpool2));
+
+          if (info->done)
+            svn_priority_queue__pop(queue);
+          else
+            svn_priority_queue__update(queue);
 
-          /* Check history for this path in current rev. */
-          SVN_ERR(check_history(&changed, info, fs, current,
-                                strict_node_history,
-                                callbacks->authz_read_func,
-                                callbacks->authz_read_baton,
-                                hist_start, pool, iterpool2));
-          if (! info->done)
-            any_histories_left = TRUE;
+          next = svn_priority_queue__peek(queue);
         }
+      while (next && (*next)->history_rev == current);
 
       svn_pool_clear(iterpool2);
 
-      /* If any of the paths changed in this rev then add or send it. */
-      if (changed)
+      /* At least one of the paths changed in this rev, so add or send it.
+         If we're including merged revisions, we need to calculate
+         the mergeinfo deltas committed in this revision to our
+         various paths. */
+      if (include_merged_revisions)
         {
-          svn_mergeinfo_t added_mergeinfo = NULL;
-          svn_mergeinfo_t deleted_mergeinfo = NULL;
-          svn_boolean_t has_children = FALSE;
+          apr_array_header_t *cur_paths =
+            apr_array_make(iterpool, paths->nelts, sizeof(const char *));
 
-          /* If we're including merged revisions, we need to calculate
-             the mergeinfo deltas committed in this revision to our
-             various paths. */
-          if (include_merged_revisions)
+          /* Get the current paths of our history objects so we can
+             query mergeinfo. */
+          /* ### TODO: Should this be ignoring depleted history items? */
+          for (i = 0; i < histories->nelts; i++)
             {
-              apr_array_header_t *cur_paths =
-                apr_array_make(iterpool, paths->nelts, sizeof(const char *));
-
-              /* Get the current paths of our history objects so we can
-                 query mergeinfo. */
-              /* ### TODO: Should this be ignoring depleted history items? */
-              for (i = 0; i < histories->nelts; i++)
-                {
-                  struct path_info *info = APR_ARRAY_IDX(histories, i,
-                                                         struct path_info *);
-                  APR_ARRAY_PUSH(cur_paths, const char *) = info->path->data;
-                }
-              SVN_ERR(get_combined_mergeinfo_changes(&added_mergeinfo,
-                                                     &deleted_mergeinfo,
-                                                     fs, cur_paths,
-                                                     current,
-                                                     iterpool, iterpool));
-              has_children = (apr_hash_count(added_mergeinfo) > 0
-                              || apr_hash_count(deleted_mergeinfo) > 0);
+              struct path_info *info = APR_ARRAY_IDX(histories, i,
+                                                     struct path_info *);
+              APR_ARRAY_PUSH(cur_paths, const char *) = info->path->data;
             }
+          SVN_ERR(get_combined_mergeinfo_changes(&added_mergeinfo,
+                                                 &deleted_mergeinfo,
+                                                 fs, cur_paths,
+                                                 current,
+                                                 iterpool, iterpool));
+          has_children = (apr_hash_count(added_mergeinfo) > 0
+                          || apr_hash_count(deleted_mergeinfo) > 0);
+        }
 
-          /* If our caller wants logs in descending order, we can send
-             'em now (because that's the order we're crawling history
-             in anyway). */
-          if (descending_order)
-            {
-              SVN_ERR(send_log(current, fs,
-                               log_target_history_as_mergeinfo, nested_merges,
-                               subtractive_merge, handling_merged_revisions,
-                               revprops, has_children, callbacks, iterpool));
+      /* If our caller wants logs in descending order, we can send
+         'em now (because that's the order we're crawling history
+         in anyway). */
+      if (descending_order)
+        {
+          SVN_ERR(send_log(current, fs,
+                           log_target_history_as_mergeinfo, nested_merges,
+                           subtractive_merge, handling_merged_revisions,
+                           revprops, has_children, callbacks, iterpool));
 
-              if (has_children) /* Implies include_merged_revisions == TRUE */
+          if (has_children) /* Implies include_merged_revisions == TRUE */
+            {
+              if (!nested_merges)
                 {
-                  if (!nested_merges)
-                    {
-                      /* We're at the start of the recursion stack, create a
-                         single hash to be shared across all of the merged
-                         recursions so we can track and squelch duplicates. */
-                      subpool = svn_pool_create(pool);
-                      nested_merges = svn_bit_array__create(hist_end, subpool);
-                      processed = svn_hash__make(subpool);
-                    }
-
-                  SVN_ERR(handle_merged_revisions(
-                    current, fs,
-                    log_target_history_as_mergeinfo, nested_merges,
-                    processed,
-                    added_mergeinfo, deleted_mergeinfo,
-                    strict_node_history,
-                    revprops,
-                    callbacks,
-                    iterpool));
+                  /* We're at the start of the recursion stack, create a
+                     single hash to be shared across all of the merged
+                     recursions so we can track and squelch duplicates. */
+                  subpool = svn_pool_create(pool);
+                  nested_merges = svn_bit_array__create(hist_end, subpool);
+                  processed = processed_searches_create(subpool);
                 }
-              if (limit && ++send_count >= limit)
-                break;
+
+              SVN_ERR(handle_merged_revisions(
+                current, fs,
+                log_target_history_as_mergeinfo, nested_merges,
+                processed,
+                added_mergeinfo, deleted_mergeinfo,
+                strict_node_history,
+                revprops,
+                callbacks,
+                iterpool));
             }
-          /* Otherwise, the caller wanted logs in ascending order, so
-             we have to buffer up a list of revs and (if doing
-             mergeinfo) a hash of related mergeinfo deltas, and
-             process them later. */
-          else
-            {
-              if (! revs)
-                revs = apr_array_make(pool, 64, sizeof(svn_revnum_t));
-              APR_ARRAY_PUSH(revs, svn_revnum_t) = current;
+          if (limit && ++send_count >= limit)
+            break;
+        }
+      /* Otherwise, the caller wanted logs in ascending order, so
+         we have to buffer up a list of revs and (if doing
+         mergeinfo) a hash of related mergeinfo deltas, and
+         process them later. */
+      else
+        {
+          if (! revs)
+            revs = apr_array_make(pool, 64, sizeof(svn_revnum_t));
+          APR_ARRAY_PUSH(revs, svn_revnum_t) = current;
 
-              if (added_mergeinfo || deleted_mergeinfo)
-                {
-                  svn_revnum_t *cur_rev =
-                    apr_pmemdup(pool, &current, sizeof(*cur_rev));
-                  struct added_deleted_mergeinfo *add_and_del_mergeinfo =
-                    apr_palloc(pool, sizeof(*add_and_del_mergeinfo));
-
-                  /* If we have added or deleted mergeinfo, both are non-null */
-                  SVN_ERR_ASSERT(added_mergeinfo && deleted_mergeinfo);
-                  add_and_del_mergeinfo->added_mergeinfo =
-                    svn_mergeinfo_dup(added_mergeinfo, pool);
-                  add_and_del_mergeinfo->deleted_mergeinfo =
-                    svn_mergeinfo_dup(deleted_mergeinfo, pool);
-
-                  if (! rev_mergeinfo)
-                    rev_mergeinfo = svn_hash__make(pool);
-                  apr_hash_set(rev_mergeinfo, cur_rev, sizeof(*cur_rev),
-                               add_and_del_mergeinfo);
-                }
+          if (added_mergeinfo || deleted_mergeinfo)
+            {
+              svn_revnum_t *cur_rev =
+                apr_pmemdup(pool, &current, sizeof(*cur_rev));
+              struct added_deleted_mergeinfo *add_and_del_mergeinfo =
+                apr_palloc(pool, sizeof(*add_and_del_mergeinfo));
+
+              /* If we have added or deleted mergeinfo, both are non-null */
+              SVN_ERR_ASSERT(added_mergeinfo && deleted_mergeinfo);
+              add_and_del_mergeinfo->added_mergeinfo =
+                svn_mergeinfo_dup(added_mergeinfo, pool);
+              add_and_del_mergeinfo->deleted_mergeinfo =
+                svn_mergeinfo_dup(deleted_mergeinfo, pool);
+
+              if (! rev_mergeinfo)
+                rev_mergeinfo = svn_hash_map__create(0, pool);
+              svn_hash_map__set(rev_mergeinfo, cur_rev, sizeof(*cur_rev),
+                                add_and_del_mergeinfo);
             }
         }
     }
@@ -2179,7 +2473,7 @@ do_logs(svn_fs_t *fs,
           if (rev_mergeinfo)
             {
               struct added_deleted_mergeinfo *add_and_del_mergeinfo =
-                apr_hash_get(rev_mergeinfo, &current, sizeof(current));
+                svn_hash_map__get(rev_mergeinfo, &current, sizeof(current));
               added_mergeinfo = add_and_del_mergeinfo->added_mergeinfo;
               deleted_mergeinfo = add_and_del_mergeinfo->deleted_mergeinfo;
               has_children = (apr_hash_count(added_mergeinfo) > 0
@@ -2303,22 +2597,26 @@ get_paths_history_as_mergeinfo(svn_mergeinfo_t *paths_history_mergeinfo,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_repos_get_logs5(svn_repos_t *repos,
-                    const apr_array_header_t *paths,
-                    svn_revnum_t start,
-                    svn_revnum_t end,
-                    int limit,
-                    svn_boolean_t strict_node_history,
-                    svn_boolean_t include_merged_revisions,
-                    const apr_array_header_t *revprops,
-                    svn_repos_authz_func_t authz_read_func,
-                    void *authz_read_baton,
-                    svn_repos_path_change_receiver_t path_change_receiver,
-                    void *path_change_receiver_baton,
-                    svn_repos_log_entry_receiver_t revision_receiver,
-                    void *revision_receiver_baton,
-                    apr_pool_t *scratch_pool)
+/* Implement svn_repos_get_logs5() and svn_repos__get_logs_search().
+   SEARCH_PATTERNS must have been prepared for matching and requires
+   INCLUDE_MERGED_REVISIONS to be FALSE. */
+static svn_error_t *
+get_logs(svn_repos_t *repos,
+         const apr_array_header_t *paths,
+         svn_revnum_t start,
+         svn_revnum_t end,
+         int limit,
+         svn_boolean_t strict_node_history,
+         svn_boolean_t include_merged_revisions,
+         const apr_array_header_t *revprops,
+         const apr_array_header_t *search_patterns,
+         svn_repos_authz_func_t authz_read_func,
+         void *authz_read_baton,
+         svn_repos_path_change_receiver_t path_change_receiver,
+         void *path_change_receiver_baton,
+         svn_repos_log_entry_receiver_t revision_receiver,
+         void *revision_receiver_baton,
+         apr_pool_t *scratch_pool)
 {
   svn_revnum_t head = SVN_INVALID_REVNUM;
   svn_fs_t *fs = repos->fs;
@@ -2332,6 +2630,7 @@ svn_repos_get_logs5(svn_repos_t *repos,
   callbacks.revision_receiver_baton = revision_receiver_baton;
   callbacks.authz_read_func = authz_read_func;
   callbacks.authz_read_baton = authz_read_baton;
+  callbacks.search_patterns = search_patterns;
 
   if (revprops)
     {
@@ -2465,3 +2764,89 @@ svn_repos_get_logs5(svn_repos_t *repos,
                  include_merged_revisions, FALSE, FALSE, FALSE,
                  revprops, descending_order, &callbacks, scratch_pool);
 }
+
+svn_error_t *
+svn_repos_get_logs5(svn_repos_t *repos,
+                    const apr_array_header_t *paths,
+                    svn_revnum_t start,
+                    svn_revnum_t end,
+                    int limit,
+                    svn_boolean_t strict_node_history,
+                    svn_boolean_t include_merged_revisions,
+                    const apr_array_header_t *revprops,
+                    svn_repos_authz_func_t authz_read_func,
+                    void *authz_read_baton,
+                    svn_repos_path_change_receiver_t path_change_receiver,
+                    void *path_change_receiver_baton,
+                    svn_repos_log_entry_receiver_t revision_receiver,
+                    void *revision_receiver_baton,
+                    apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(get_logs(repos, paths, start, end, limit,
+                                  strict_node_history,
+                                  include_merged_revisions, revprops, NULL,
+                                  authz_read_func, authz_read_baton,
+                                  path_change_receiver,
+                                  path_change_receiver_baton,
+                                  revision_receiver, revision_receiver_baton,
+                                  scratch_pool));
+}
+
+svn_error_t *
+svn_repos__get_logs_search(svn_repos_t *repos,
+                           const apr_array_header_t *paths,
+                           svn_revnum_t start,
+                           svn_revnum_t end,
+                           int limit,
+                           svn_boolean_t strict_node_history,
+                           const apr_array_header_t *revprops,
+                           const apr_array_header_t *search_patterns,
+                           svn_repos_authz_func_t authz_read_func,
+                           void *authz_read_baton,
+                           svn_repos_path_change_receiver_t path_change_receiver,
+                           void *path_change_receiver_baton,
+                           svn_repos_log_entry_receiver_t revision_receiver,
+                           void *revision_receiver_baton,
+                           apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *prepared = NULL;
+  svn_membuf_t buf;
+  int i, k;
+
+  /* Match any substring in the same case- and accent-insensitive way
+     as the 'svn log --search' does. */
+  if (search_patterns && search_patterns->nelts)
+    {
+      svn_membuf__create(&buf, 0, scratch_pool);
+      prepared = apr_array_make(scratch_pool, search_patterns->nelts,
+                                sizeof(apr_array_header_t *));
+      for (i = 0; i < search_patterns->nelts; i++)
+        {
+          const apr_array_header_t *group
+            = APR_ARRAY_IDX(search_patterns, i, const apr_array_header_t *);
+          apr_array_header_t *prepared_group
+            = apr_array_make(scratch_pool, group->nelts, sizeof(const char *));
+
+          for (k = 0; k < group->nelts; k++)
+            {
+              const char *pattern = APR_ARRAY_IDX(group, k, const char *);
+
+              SVN_ERR(svn_utf__xfrm(&pattern, pattern, strlen(pattern),
+                                    TRUE, TRUE, &buf));
+              APR_ARRAY_PUSH(prepared_group, const char *)
+                = apr_psprintf(scratch_pool, "*%s*", pattern);
+            }
+
+          APR_ARRAY_PUSH(prepared, apr_array_header_t *) = prepared_group;
+        }
+    }
+
+  return svn_error_trace(get_logs(repos, paths, start, end, limit,
+                                  strict_node_history, FALSE, revprops,
+                                  prepared,
+                                  authz_read_func, authz_read_baton,
+                                  path_change_receiver,
+                                  path_change_receiver_baton,
+                                  revision_receiver, revision_receiver_baton,
+                                  scratch_pool));
+}
@@ -35,16 +35,35 @@
 #include "svn_private_config.h"
 
 #include "private/svn_dep_compat.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_repos_private.h"
 
 #define NUM_CACHED_SOURCE_ROOTS 4
 
-/* Theory of operation: we write report operations out to a spill-buffer
-   as we receive them.  When the report is finished, we read the
-   operations back out again, using them to guide the progression of
-   the delta between the source and target revs.
+/* Number of sub-directories whose entries delta_dirs() asks the FS to
+   prefetch in one go. */
+#define DIR_PREFETCH_WINDOW 32
+
+/* Approximate amount of memory that the report operations may occupy
+   before we spill them to disk. */
+#define REPORT_MEMORY_LIMIT (4 * 1024 * 1024)
+
+/* Size of the blocks in which spilled report operations are read back. */
+#define REPORT_SPILL_BLOCKSIZE (64 * 1024)
+
+/* Theory of operation: we keep report operations in an in-memory index
+   as we receive them.  When the report is finished, we sort that index
+   into depth-first order and use it to guide the progression of the
+   delta between the source and target revs.
+
+   Should the index grow beyond REPORT_MEMORY_LIMIT, we write it out,
+   sorted, to a spill-buffer and start over with an empty index.  As
+   long as the client reports in depth-first order (and all of ours do),
+   every spill simply extends the same sorted run.  Otherwise, we start
+   a new run and merge all runs while driving the editor.
 
    Spill-buffer content format: we use a simple ad-hoc format to store the
    report operations.  Each report operation is the concatention of
@@ -76,8 +95,8 @@
 
 /* Describes the state of a working copy subtree, as given by a
    report.  Because we keep a lookahead pathinfo, we need to allocate
-   each one of these things in a subpool of the report baton and free
-   it when done. */
+   each one read back from a spill-buffer in a subpool of the report
+   baton and free it when done. */
 typedef struct path_info_t
 {
   const char *path;            /* path, munged to be anchor-relative */
@@ -86,7 +105,9 @@ typedef struct path_info_t
   svn_depth_t depth;           /* Depth of this path, meaningless for files */
   svn_boolean_t start_empty;   /* Meaningless for delete_path */
   const char *lock_token;      /* NULL if no token */
-  apr_pool_t *pool;            /* Container pool */
+  apr_size_t order;            /* Position within the report */
+  apr_pool_t *pool;            /* Container pool; NULL for entries from
+                                  the in-memory index */
 } path_info_t;
 
 /* Describes the standard revision properties that are relevant for
@@ -128,8 +149,24 @@ typedef struct report_baton_t
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
 
-  /* The spill-buffer holding the report. */
-  svn_spillbuf_reader_t *reader;
+  /* Report operations not yet spilled, as path_info_t *, allocated in
+     INDEX_POOL, and the approximate amount of memory they occupy.  During
+     the editor drive, INDEX_NEXT is the next element to hand out. */
+  apr_array_header_t *index;
+  apr_size_t index_size;
+  apr_pool_t *index_pool;
+  int index_next;
+
+  /* Number of report operations received so far, the path of the latest
+     one and whether they all arrived in depth-first order. */
+  apr_size_t op_count;
+  svn_stringbuf_t *last_path;
+  svn_boolean_t sorted;
+
+  /* Sorted runs of spilled report operations, as svn_spillbuf_reader_t *,
+     and, during the editor drive, the next operation from each run. */
+  apr_array_header_t *runs;
+  path_info_t **run_heads;
 
   /* For the actual editor drive, we'll need a lookahead path info
      entry, a cache of FS roots, and a pool to store them. */
@@ -143,6 +180,20 @@ typedef struct report_baton_t
 
   /* This will not change. So, fetch it once and reuse it. */
   svn_string_t *repos_uuid;
+
+  /* Number of threads computing text deltas ahead of the editor drive.
+     Prefetching is disabled for values below 2. */
+  int prefetch_jobs;
+
+  /* Send added files as plain fulltext windows instead of deltas
+     against the empty stream. */
+  svn_boolean_t send_fulltexts;
+
+#if APR_HAS_THREADS
+  /* Text delta prefetching state during the editor drive.  May be NULL. */
+  struct delta_prefetch_t *prefetch;
+#endif
+
   apr_pool_t *pool;
 } report_baton_t;
 
@@ -163,6 +214,8 @@ static svn_error_t *delta_dirs(report_baton_t *b, svn_revnum_t s_rev,
                                svn_depth_t requested_depth,
                                apr_pool_t *pool);
 
+static svn_error_t *spill_index(report_baton_t *b, apr_pool_t *scratch_pool);
+
 /* --- READING PREVIOUSLY STORED REPORT INFORMATION --- */
 
 static svn_error_t *
@@ -309,10 +362,78 @@ read_path_info(path_info_t **pi,
     SVN_ERR(read_string(&(*pi)->lock_token, reader, pool));
   else
     (*pi)->lock_token = NULL;
+  (*pi)->order = 0;
   (*pi)->pool = pool;
   return SVN_NO_ERROR;
 }
 
+/* Sort report operations in depth-first order of their paths, keeping
+   operations on the same path in the order they were reported.
+   Implements the qsort() comparison function for path_info_t *. */
+static int
+compare_path_infos(const void *a, const void *b)
+{
+  const path_info_t *lhs = *(const path_info_t * const *)a;
+  const path_info_t *rhs = *(const path_info_t * const *)b;
+  int diff = svn_path_compare_paths(lhs->path, rhs->path);
+
+  if (diff)
+    return diff;
+
+  return lhs->order < rhs->order ? -1 : (lhs->order > rhs->order);
+}
+
+/* Set *PI to the next report operation in depth-first order, or to NULL
+   if we have reached the end of the report.  Entries from B->index have
+   no pool of their own.  Entries from the spilled runs are allocated in
+   a subpool of B->pool that the caller must free eventually. */
+static svn_error_t *
+next_path_info(path_info_t **pi,
+               report_baton_t *b)
+{
+  int i, best = -1;
+
+  if (b->runs->nelts == 0)
+    {
+      *pi = b->index_next < b->index->nelts
+          ? APR_ARRAY_IDX(b->index, b->index_next++, path_info_t *)
+          : NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* Merge the runs.  Ties go to the earlier run, i.e. the operation
+     that has been reported first. */
+  for (i = 0; i < b->runs->nelts; ++i)
+    if (b->run_heads[i]
+        && (best < 0
+            || svn_path_compare_paths(b->run_heads[i]->path,
+                                      b->run_heads[best]->path) < 0))
+      best = i;
+
+  if (best < 0)
+    {
+      *pi = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  *pi = b->run_heads[best];
+  SVN_ERR(read_path_info(&b->run_heads[best],
+                         APR_ARRAY_IDX(b->runs, best,
+                                       svn_spillbuf_reader_t *),
+                         svn_pool_create(b->pool)));
+
+  return SVN_NO_ERROR;
+}
+
+/* Release the memory held by the report operation PI, if it has been
+   allocated in its own pool. */
+static void
+free_path_info(path_info_t *pi)
+{
+  if (pi->pool)
+    svn_pool_destroy(pi->pool);
+}
+
 /* Return true if PI's path is a child of PREFIX (which has length PLEN). */
 static svn_boolean_t
 relevant(path_info_t *pi, const char *prefix, apr_size_t plen)
@@ -321,7 +442,7 @@ relevant(path_info_t *pi, const char *prefix, apr_size_t plen)
           (!*prefix || pi->path[plen] == '/'));
 }
 
-/* Fetch the next pathinfo from B->reader for a descendant of
+/* Fetch the next pathinfo from the report B for a descendant of
    PREFIX.  If the next pathinfo is for an immediate child of PREFIX,
    set *ENTRY to the path component of the report information and
    *INFO to the path information for that entry.  If the next pathinfo
@@ -334,16 +455,15 @@ relevant(path_info_t *pi, const char *prefix, apr_size_t plen)
    At all times, B->lookahead is presumed to be the next pathinfo not
    yet returned as an immediate child, or NULL if we have reached the
    end of the report.  Because we use a lookahead element, we can't
-   rely on the usual nested pool lifetimes, so allocate each pathinfo
-   in a subpool of the report baton's pool.  The caller should delete
-   (*INFO)->pool when it is done with the information. */
+   rely on the usual nested pool lifetimes, so each pathinfo read back
+   from disk lives in a subpool of the report baton's pool.  The caller
+   should call free_path_info() on *INFO when it is done with it. */
 static svn_error_t *
 fetch_path_info(report_baton_t *b, const char **entry, path_info_t **info,
                 const char *prefix, apr_pool_t *pool)
 {
   apr_size_t plen = strlen(prefix);
   const char *relpath, *sep;
-  apr_pool_t *subpool;
 
   if (!relevant(b->lookahead, prefix, plen))
     {
@@ -367,8 +487,7 @@ fetch_path_info(report_baton_t *b, const char **entry, path_info_t **info,
           /* This is an immediate child; return it and advance. */
           *entry = relpath;
           *info = b->lookahead;
-          subpool = svn_pool_create(b->pool);
-          SVN_ERR(read_path_info(&b->lookahead, b->reader, subpool));
+          SVN_ERR(next_path_info(&b->lookahead, b));
         }
     }
   return SVN_NO_ERROR;
@@ -380,13 +499,11 @@ static svn_error_t *
 skip_path_info(report_baton_t *b, const char *prefix)
 {
   apr_size_t plen = strlen(prefix);
-  apr_pool_t *subpool;
 
   while (relevant(b->lookahead, prefix, plen))
     {
-      svn_pool_destroy(b->lookahead->pool);
-      subpool = svn_pool_create(b->pool);
-      SVN_ERR(read_path_info(&b->lookahead, b->reader, subpool));
+      free_path_info(b->lookahead);
+      SVN_ERR(next_path_info(&b->lookahead, b));
     }
   return SVN_NO_ERROR;
 }
@@ -662,6 +779,687 @@ send_zero_copy_delta(const unsigned char *contents,
 }
 
 
+#if APR_HAS_THREADS
+
+/* Prefetching of text deltas.
+ *
+ * Before delta_dirs() walks the target entries of a directory, it queues
+ * a prefetch job for every file that is likely to receive a text delta.
+ * Worker threads, each with its own svn_fs_t, pick up these jobs, compute
+ * the deltas and collect their windows in memory.  delta_files() then
+ * replays those windows instead of computing the delta itself, while the
+ * workers already process the next files.
+ *
+ * The jobs queued for one directory form a batch.  Batches of sub-
+ * directories get queued in front of those of their parents because
+ * the editor drive visits them first.  The calling thread never waits
+ * for a job that has not been picked up, yet; it simply takes it out of
+ * the queue and computes the delta itself.  When delta_dirs() is done
+ * with a directory, it cancels whatever jobs remain in its batch.
+ */
+
+/* Workers don't pick up new jobs while more than this number of bytes
+ * of delta windows is waiting to be replayed. */
+#define PREFETCH_MEMORY_LIMIT (8 * 1024 * 1024)
+
+/* Workers don't collect more than this number of bytes for a single job
+ * before the calling thread replays them. */
+#define PREFETCH_JOB_LIMIT (1024 * 1024)
+
+/* One delta window collected by a worker, allocated in its own POOL.
+ */
+typedef struct prefetch_window_t
+{
+  svn_txdelta_window_t *window;
+
+  /* Approximate memory used by WINDOW. */
+  apr_size_t size;
+
+  apr_pool_t *pool;
+  struct prefetch_window_t *next;
+} prefetch_window_t;
+
+/* Life cycle of a prefetch job.
+ */
+typedef enum prefetch_state_t
+{
+  /* Waiting in the queue to be picked up by a worker. */
+  prefetch_pending,
+
+  /* A worker is computing the delta. */
+  prefetch_running,
+
+  /* The worker is done with this job. */
+  prefetch_finished,
+
+  /* Taken out of the queue by the calling thread. */
+  prefetch_taken
+} prefetch_state_t;
+
+/* The text delta from S_REV/S_PATH to T_PATH in the target revision,
+ * computed by a worker thread.  S_PATH may be NULL.  All members after
+ * T_PATH must only be accessed while holding the shared mutex.
+ */
+typedef struct prefetch_job_t
+{
+  svn_revnum_t s_rev;
+  const char *s_path;
+  const char *t_path;
+
+  prefetch_state_t state;
+
+  /* Set by the calling thread to make the worker stop early. */
+  svn_boolean_t cancelled;
+
+  /* Set while the calling thread replays the windows of this job. */
+  svn_boolean_t consuming;
+
+  /* Windows collected but not replayed, yet, in delta order, and the
+   * sum of their sizes.  The final NULL window is implied. */
+  prefetch_window_t *first;
+  prefetch_window_t *last;
+  apr_size_t buffered;
+
+  /* Error returned while computing the delta. */
+  svn_error_t *err;
+
+  /* Neighbours in the queue of pending jobs. */
+  struct prefetch_job_t *prev_pending;
+  struct prefetch_job_t *next_pending;
+} prefetch_job_t;
+
+/* The jobs queued for one directory.  Only used by the calling thread.
+ */
+typedef struct prefetch_batch_t
+{
+  /* All jobs of this batch in queue order. */
+  apr_array_header_t *jobs;
+
+  /* Maps T_PATH to prefetch_job_t *. */
+  apr_hash_t *by_path;
+
+  /* The batch of the parent directory, if any. */
+  struct prefetch_batch_t *outer;
+
+  apr_pool_t *pool;
+} prefetch_batch_t;
+
+/* Data shared between the calling thread and all worker threads.  All
+ * members after T_REV must only be accessed while holding MUTEX.
+ */
+typedef struct delta_prefetch_t
+{
+  /* Repository to open in each worker and the target revision. */
+  const char *fs_path;
+  svn_revnum_t t_rev;
+
+  /* Queue of jobs not picked up by any worker, yet. */
+  prefetch_job_t *first_pending;
+  prefetch_job_t *last_pending;
+
+  /* Total size of all windows waiting to be replayed. */
+  apr_size_t buffered;
+
+  /* If set, workers shall terminate. */
+  svn_boolean_t shutdown;
+
+  /* Serialization and signalling of state changes. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+
+  /* Innermost batch of queued jobs.  Used by the calling thread only. */
+  prefetch_batch_t *batch;
+
+  /* Worker threads and their number. */
+  apr_thread_t **threads;
+  struct prefetch_worker_t *workers;
+  int thread_count;
+
+  /* Owned by the calling thread. */
+  apr_pool_t *pool;
+} delta_prefetch_t;
+
+/* Per worker thread data.
+ */
+typedef struct prefetch_worker_t
+{
+  /* Shared state. */
+  delta_prefetch_t *shared;
+
+  /* Private copy of the FS config. */
+  apr_hash_t *fs_config;
+
+  /* Pool for all worker-local allocations. */
+  apr_pool_t *pool;
+} prefetch_worker_t;
+
+/* Add JOB to the end of the pending queue in SHARED.
+ * The caller must hold the shared mutex. */
+static void
+append_pending(delta_prefetch_t *shared, prefetch_job_t *job)
+{
+  job->prev_pending = shared->last_pending;
+  job->next_pending = NULL;
+  if (shared->last_pending)
+    shared->last_pending->next_pending = job;
+  else
+    shared->first_pending = job;
+  shared->last_pending = job;
+}
+
+/* Remove JOB from the pending queue in SHARED.
+ * The caller must hold the shared mutex. */
+static void
+remove_pending(delta_prefetch_t *shared, prefetch_job_t *job)
+{
+  if (job->prev_pending)
+    job->prev_pending->next_pending = job->next_pending;
+  else
+    shared->first_pending = job->next_pending;
+
+  if (job->next_pending)
+    job->next_pending->prev_pending = job->prev_pending;
+  else
+    shared->last_pending = job->prev_pending;
+
+  job->prev_pending = NULL;
+  job->next_pending = NULL;
+}
+
+/* Return the approximate amount of memory used by WINDOW. */
+static apr_size_t
+window_size(const svn_txdelta_window_t *window)
+{
+  return sizeof(*window)
+       + window->num_ops * sizeof(*window->ops)
+       + (window->new_data ? window->new_data->len : 0);
+}
+
+/* Compute the text delta for JOB in the worker thread using the target
+ * root T_ROOT of FS.  *S_ROOT is the most recently used source root,
+ * allocated in ROOT_POOL; update it as needed.  Hand the windows over to
+ * SHARED.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+prefetch_delta(prefetch_job_t *job,
+               delta_prefetch_t *shared,
+               svn_fs_t *fs,
+               svn_fs_root_t *t_root,
+               svn_fs_root_t **s_root,
+               apr_pool_t *root_pool,
+               apr_pool_t *scratch_pool)
+{
+  svn_txdelta_stream_t *dstream;
+  svn_txdelta_window_t *window;
+  apr_pool_t *iterpool;
+
+  if (job->s_path)
+    {
+      svn_boolean_t changed;
+
+      if (   *s_root == NULL
+          || svn_fs_revision_root_revision(*s_root) != job->s_rev)
+        {
+          *s_root = NULL;
+          svn_pool_clear(root_pool);
+          SVN_ERR(svn_fs_revision_root(s_root, fs, job->s_rev, root_pool));
+        }
+
+      /* Unchanged contents won't be sent. */
+      SVN_ERR(svn_fs_contents_different(&changed, t_root, job->t_path,
+                                        *s_root, job->s_path,
+                                        scratch_pool));
+      if (!changed)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_get_file_delta_stream(&dstream,
+                                       job->s_path ? *s_root : NULL,
+                                       job->s_path, t_root, job->t_path,
+                                       scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  do
+    {
+      prefetch_window_t *item = NULL;
+      svn_boolean_t stop;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_txdelta_next_window(&window, dstream, iterpool));
+
+      /* The windows will be released by the calling thread, so their
+       * pools must not depend on any of ours. */
+      if (window)
+        {
+          apr_pool_t *pool = svn_pool_create(NULL);
+
+          item = apr_pcalloc(pool, sizeof(*item));
+          item->window = svn_txdelta_window_dup(window, pool);
+          item->size = window_size(window);
+          item->pool = pool;
+        }
+
+      apr_thread_mutex_lock(shared->mutex);
+      if (item && !job->cancelled)
+        {
+          if (job->last)
+            job->last->next = item;
+          else
+            job->first = item;
+          job->last = item;
+
+          job->buffered += item->size;
+          shared->buffered += item->size;
+          item = NULL;
+
+          apr_thread_cond_broadcast(shared->changed);
+        }
+
+      while (   !job->cancelled
+             && !shared->shutdown
+             && job->buffered >= PREFETCH_JOB_LIMIT)
+        apr_thread_cond_wait(shared->changed, shared->mutex);
+
+      stop = job->cancelled || shared->shutdown;
+      apr_thread_mutex_unlock(shared->mutex);
+
+      if (item)
+        svn_pool_destroy(item->pool);
+      if (stop)
+        break;
+    }
+  while (window);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Worker thread main function.  DATA is a prefetch_worker_t.  Process
+ * queued jobs until the prefetching gets shut down.
+ */
+static void *
+APR_THREAD_FUNC prefetch_thread_func(apr_thread_t *tid, void *data)
+{
+  prefetch_worker_t *worker = data;
+  delta_prefetch_t *shared = worker->shared;
+  apr_pool_t *scratch_pool = svn_pool_create(worker->pool);
+  apr_pool_t *root_pool = svn_pool_create(worker->pool);
+  svn_fs_root_t *t_root = NULL;
+  svn_fs_root_t *s_root = NULL;
+  svn_fs_t *fs;
+  svn_error_t *err;
+
+  /* Without a working FS, leave all jobs to the calling thread. */
+  err = svn_fs_open2(&fs, shared->fs_path, worker->fs_config,
+                     worker->pool, scratch_pool);
+  if (!err)
+    err = svn_fs_revision_root(&t_root, fs, shared->t_rev, worker->pool);
+  svn_error_clear(err);
+
+  while (t_root)
+    {
+      prefetch_job_t *job;
+
+      apr_thread_mutex_lock(shared->mutex);
+      while (   !shared->shutdown
+             && (   shared->first_pending == NULL
+                 || shared->buffered >= PREFETCH_MEMORY_LIMIT))
+        apr_thread_cond_wait(shared->changed, shared->mutex);
+
+      job = shared->shutdown ? NULL : shared->first_pending;
+      if (job)
+        {
+          remove_pending(shared, job);
+          job->state = prefetch_running;
+        }
+      apr_thread_mutex_unlock(shared->mutex);
+
+      if (job == NULL)
+        break;
+
+      svn_pool_clear(scratch_pool);
+      err = prefetch_delta(job, shared, fs, t_root, &s_root, root_pool,
+                           scratch_pool);
+
+      apr_thread_mutex_lock(shared->mutex);
+      job->err = err;
+      job->state = prefetch_finished;
+      apr_thread_cond_broadcast(shared->changed);
+      apr_thread_mutex_unlock(shared->mutex);
+    }
+
+  svn_pool_destroy(scratch_pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Start B->PREFETCH_JOBS worker threads for the editor drive of report
+ * B and set B->PREFETCH.  Leave it NULL if prefetching is not enabled or
+ * no thread could be started.  Allocate the shared state in POOL.
+ */
+static svn_error_t *
+start_prefetch(report_baton_t *b,
+               apr_pool_t *pool)
+{
+  delta_prefetch_t *prefetch;
+  svn_fs_t *fs = svn_repos_fs(b->repos);
+  apr_hash_t *fs_config = svn_fs_config(fs, pool);
+  apr_status_t status;
+  int i;
+
+  b->prefetch = NULL;
+  if (b->prefetch_jobs < 2 || !b->text_deltas)
+    return SVN_NO_ERROR;
+
+  prefetch = apr_pcalloc(pool, sizeof(*prefetch));
+  prefetch->pool = svn_pool_create(pool);
+  prefetch->fs_path = svn_fs_path(fs, prefetch->pool);
+  prefetch->t_rev = b->t_rev;
+
+  status = apr_thread_mutex_create(&prefetch->mutex,
+                                   APR_THREAD_MUTEX_DEFAULT,
+                                   prefetch->pool);
+  if (!status)
+    status = apr_thread_cond_create(&prefetch->changed, prefetch->pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create prefetch mutex"));
+
+  prefetch->threads = apr_pcalloc(prefetch->pool,
+                                  b->prefetch_jobs
+                                    * sizeof(*prefetch->threads));
+  prefetch->workers = apr_pcalloc(prefetch->pool,
+                                  b->prefetch_jobs
+                                    * sizeof(*prefetch->workers));
+  for (i = 0; i < b->prefetch_jobs; ++i)
+    {
+      prefetch_worker_t *worker = &prefetch->workers[i];
+
+      worker->shared = prefetch;
+      worker->pool = svn_pool_create(NULL);
+      worker->fs_config = fs_config
+                        ? apr_hash_copy(worker->pool, fs_config)
+                        : NULL;
+
+      status = apr_thread_create(&prefetch->threads[i], NULL,
+                                 prefetch_thread_func, worker,
+                                 prefetch->pool);
+      if (status)
+        {
+          /* Simply continue with fewer threads. */
+          svn_pool_destroy(worker->pool);
+          break;
+        }
+
+      ++prefetch->thread_count;
+    }
+
+  if (prefetch->thread_count)
+    b->prefetch = prefetch;
+  else
+    svn_pool_destroy(prefetch->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue prefetch jobs for the COUNT file deltas from S_REVS[i]/S_PATHS[i]
+ * to T_PATHS[i] as a new innermost batch in PREFETCH.  S_PATHS[i] may be
+ * NULL.  The jobs will be picked up in the given order.
+ */
+static void
+queue_prefetch_batch(delta_prefetch_t *prefetch,
+                     svn_revnum_t s_rev,
+                     const apr_array_header_t *s_paths,
+                     const apr_array_header_t *t_paths)
+{
+  prefetch_batch_t *batch;
+  prefetch_job_t *anchor;
+  int i;
+
+  batch = apr_pcalloc(prefetch->pool, sizeof(*batch));
+  batch->pool = svn_pool_create(prefetch->pool);
+  batch->jobs = apr_array_make(batch->pool, t_paths->nelts,
+                               sizeof(prefetch_job_t *));
+  batch->by_path = apr_hash_make(batch->pool);
+  batch->outer = prefetch->batch;
+  prefetch->batch = batch;
+
+  for (i = 0; i < t_paths->nelts; ++i)
+    {
+      prefetch_job_t *job = apr_pcalloc(batch->pool, sizeof(*job));
+      const char *s_path = APR_ARRAY_IDX(s_paths, i, const char *);
+
+      job->s_rev = s_rev;
+      job->s_path = s_path ? apr_pstrdup(batch->pool, s_path) : NULL;
+      job->t_path = apr_pstrdup(batch->pool,
+                                APR_ARRAY_IDX(t_paths, i, const char *));
+      job->state = prefetch_pending;
+
+      APR_ARRAY_PUSH(batch->jobs, prefetch_job_t *) = job;
+      svn_hash_sets(batch->by_path, job->t_path, job);
+    }
+
+  if (batch->jobs->nelts == 0)
+    return;
+
+  /* The jobs of the outer batches are needed only after this one. */
+  apr_thread_mutex_lock(prefetch->mutex);
+
+  anchor = prefetch->first_pending;
+  prefetch->first_pending = NULL;
+  prefetch->last_pending = NULL;
+  for (i = 0; i < batch->jobs->nelts; ++i)
+    append_pending(prefetch, APR_ARRAY_IDX(batch->jobs, i,
+                                           prefetch_job_t *));
+
+  if (anchor)
+    {
+      anchor->prev_pending = prefetch->last_pending;
+      prefetch->last_pending->next_pending = anchor;
+      while (anchor->next_pending)
+        anchor = anchor->next_pending;
+      prefetch->last_pending = anchor;
+    }
+
+  apr_thread_cond_broadcast(prefetch->changed);
+  apr_thread_mutex_unlock(prefetch->mutex);
+}
+
+/* Cancel all remaining jobs of the innermost batch in PREFETCH, wait for
+ * the workers to let go of them and release the batch.
+ */
+static void
+cancel_prefetch_batch(delta_prefetch_t *prefetch)
+{
+  prefetch_batch_t *batch = prefetch->batch;
+  int i;
+
+  apr_thread_mutex_lock(prefetch->mutex);
+  for (i = 0; i < batch->jobs->nelts; ++i)
+    {
+      prefetch_job_t *job = APR_ARRAY_IDX(batch->jobs, i, prefetch_job_t *);
+
+      if (job->state == prefetch_pending)
+        {
+          remove_pending(prefetch, job);
+          job->state = prefetch_taken;
+        }
+
+      job->cancelled = TRUE;
+    }
+
+  apr_thread_cond_broadcast(prefetch->changed);
+
+  for (i = 0; i < batch->jobs->nelts; ++i)
+    {
+      prefetch_job_t *job = APR_ARRAY_IDX(batch->jobs, i, prefetch_job_t *);
+
+      while (job->state == prefetch_running)
+        apr_thread_cond_wait(prefetch->changed, prefetch->mutex);
+
+      while (job->first)
+        {
+          prefetch_window_t *item = job->first;
+          job->first = item->next;
+          prefetch->buffered -= item->size;
+          svn_pool_destroy(item->pool);
+        }
+
+      job->last = NULL;
+      job->buffered = 0;
+      svn_error_clear(job->err);
+      job->err = SVN_NO_ERROR;
+    }
+
+  /* Less buffered data may allow workers to continue. */
+  apr_thread_cond_broadcast(prefetch->changed);
+  apr_thread_mutex_unlock(prefetch->mutex);
+
+  prefetch->batch = batch->outer;
+  svn_pool_destroy(batch->pool);
+}
+
+/* Cancel all prefetching for report B, terminate the workers and release
+ * all associated resources.  Reset B->PREFETCH to NULL.
+ */
+static void
+stop_prefetch(report_baton_t *b)
+{
+  delta_prefetch_t *prefetch = b->prefetch;
+  int i;
+
+  if (prefetch == NULL)
+    return;
+
+  while (prefetch->batch)
+    cancel_prefetch_batch(prefetch);
+
+  apr_thread_mutex_lock(prefetch->mutex);
+  prefetch->shutdown = TRUE;
+  apr_thread_cond_broadcast(prefetch->changed);
+  apr_thread_mutex_unlock(prefetch->mutex);
+
+  for (i = 0; i < prefetch->thread_count; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, prefetch->threads[i]);
+      svn_pool_destroy(prefetch->workers[i].pool);
+    }
+
+  svn_pool_destroy(prefetch->pool);
+  b->prefetch = NULL;
+}
+
+/* If B has a prefetch job for the text delta from S_REV/S_PATH to T_PATH,
+ * send its windows to DHANDLER / DBATON and set *SENT.  Otherwise, set
+ * *SENT to FALSE and leave it to the caller to compute the delta.
+ */
+static svn_error_t *
+send_prefetched_delta(svn_boolean_t *sent,
+                      report_baton_t *b,
+                      svn_revnum_t s_rev,
+                      const char *s_path,
+                      const char *t_path,
+                      svn_txdelta_window_handler_t dhandler,
+                      void *dbaton)
+{
+  delta_prefetch_t *prefetch = b->prefetch;
+  prefetch_job_t *job = NULL;
+  svn_boolean_t replayed = FALSE;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  *sent = FALSE;
+
+  if (prefetch && prefetch->batch)
+    job = svn_hash_gets(prefetch->batch->by_path, t_path);
+
+  /* Did we prefetch the delta against the same source? */
+  if (   job == NULL
+      || (s_path == NULL) != (job->s_path == NULL)
+      || (s_path && (s_rev != job->s_rev || strcmp(s_path, job->s_path))))
+    return SVN_NO_ERROR;
+
+  apr_thread_mutex_lock(prefetch->mutex);
+  if (job->state == prefetch_pending || job->state == prefetch_taken)
+    {
+      /* Not worth waiting for. */
+      if (job->state == prefetch_pending)
+        remove_pending(prefetch, job);
+      job->state = prefetch_taken;
+      apr_thread_mutex_unlock(prefetch->mutex);
+
+      return SVN_NO_ERROR;
+    }
+
+  job->consuming = TRUE;
+  while (TRUE)
+    {
+      prefetch_window_t *item;
+
+      while (job->first == NULL && job->state == prefetch_running)
+        apr_thread_cond_wait(prefetch->changed, prefetch->mutex);
+
+      item = job->first;
+      if (item == NULL)
+        break;
+
+      job->first = item->next;
+      if (job->first == NULL)
+        job->last = NULL;
+      job->buffered -= item->size;
+      prefetch->buffered -= item->size;
+      apr_thread_cond_broadcast(prefetch->changed);
+      apr_thread_mutex_unlock(prefetch->mutex);
+
+      err = dhandler(item->window, dbaton);
+      svn_pool_destroy(item->pool);
+      replayed = TRUE;
+
+      apr_thread_mutex_lock(prefetch->mutex);
+      if (err)
+        break;
+    }
+
+  if (err)
+    {
+      /* Let the worker stop early. */
+      job->cancelled = TRUE;
+      apr_thread_cond_broadcast(prefetch->changed);
+    }
+  else if (job->err && replayed)
+    {
+      /* Too late to fall back to the caller. */
+      err = job->err;
+      job->err = SVN_NO_ERROR;
+    }
+  else if (job->err)
+    {
+      /* The caller will run into the same problem and report it. */
+      svn_error_clear(job->err);
+      job->err = SVN_NO_ERROR;
+      replayed = FALSE;
+    }
+  else
+    {
+      replayed = TRUE;
+    }
+
+  job->consuming = FALSE;
+  if (job->state == prefetch_finished)
+    job->state = prefetch_taken;
+  apr_thread_mutex_unlock(prefetch->mutex);
+
+  SVN_ERR(err);
+  if (!replayed)
+    return SVN_NO_ERROR;
+
+  *sent = TRUE;
+  return svn_error_trace(dhandler(NULL, dbaton));
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Make the appropriate edits on FILE_BATON to change its contents and
    properties from those in S_REV/S_PATH to those in B->t_root/T_PATH,
    possibly using LOCK_TOKEN to determine if the client's lock on the file
@@ -708,8 +1506,29 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
 
   if (dhandler != svn_delta_noop_window_handler)
     {
-      if (b->text_deltas)
+      if (b->text_deltas && b->send_fulltexts && s_path == NULL)
+        {
+          /* There is nothing to delta against.  Don't bother compressing
+             the contents against themselves; the consumer would only
+             expand them again. */
+          svn_stream_t *contents;
+
+          SVN_ERR(svn_fs_file_contents(&contents, b->t_root, t_path, pool));
+          SVN_ERR(svn_txdelta_send_stream(contents, dhandler, dbaton, NULL,
+                                          pool));
+        }
+      else if (b->text_deltas)
         {
+#if APR_HAS_THREADS
+          /* A worker thread may have computed the delta already. */
+          svn_boolean_t sent;
+
+          SVN_ERR(send_prefetched_delta(&sent, b, s_rev, s_path, t_path,
+                                        dhandler, dbaton));
+          if (sent)
+            return SVN_NO_ERROR;
+#endif
+
           /* if we send deltas against empty streams, we may use our
              zero-copy code. */
           if (b->zero_copy_limit > 0 && s_path == NULL)
@@ -1095,10 +1914,153 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
     }
 }
 
+#if APR_HAS_THREADS
+
+/* Queue prefetch jobs for report B for those of the T_ENTRIES in
+ * directory T_PATH that delta_dirs() will likely send text deltas for.
+ * S_REV, S_PATH, S_ENTRIES, WC_DEPTH and REQUESTED_DEPTH are the same as
+ * in delta_dirs().  Use SCRATCH_POOL for temporary allocations.
+ */
+static void
+prefetch_dir_deltas(report_baton_t *b,
+                    svn_revnum_t s_rev,
+                    const char *s_path,
+                    apr_hash_t *s_entries,
+                    const char *t_path,
+                    const apr_array_header_t *t_entries,
+                    svn_depth_t wc_depth,
+                    svn_depth_t requested_depth,
+                    apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *s_paths
+    = apr_array_make(scratch_pool, t_entries->nelts, sizeof(const char *));
+  apr_array_header_t *t_paths
+    = apr_array_make(scratch_pool, t_entries->nelts, sizeof(const char *));
+  int i;
+
+  for (i = 0; i < t_entries->nelts; ++i)
+    {
+      const svn_fs_dirent_t *t_entry
+        = APR_ARRAY_IDX(t_entries, i, svn_fs_dirent_t *);
+      const svn_fs_dirent_t *s_entry = NULL;
+      const char *s_fullpath = NULL;
+
+      if (t_entry->kind != svn_node_file)
+        continue;
+
+      /* Mimic the selection logic in delta_dirs() and update_entry(). */
+      if (!is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
+        {
+          if (   requested_depth == svn_depth_unknown
+              && wc_depth < svn_depth_files)
+            continue;
+
+          s_entry = s_entries ? svn_hash_gets(s_entries, t_entry->name)
+                              : NULL;
+        }
+
+      if (s_entry && s_entry->kind == svn_node_file)
+        {
+          int distance = svn_fs_compare_ids(s_entry->id, t_entry->id);
+
+          /* Unchanged. */
+          if (distance == 0)
+            continue;
+
+          if (distance != -1 || b->ignore_ancestry)
+            s_fullpath = svn_fspath__join(s_path, t_entry->name,
+                                          scratch_pool);
+        }
+
+      /* delta_files() won't compute a delta for this one. */
+      if (!s_fullpath && b->send_fulltexts)
+        continue;
+
+      APR_ARRAY_PUSH(s_paths, const char *) = s_fullpath;
+      APR_ARRAY_PUSH(t_paths, const char *)
+        = svn_fspath__join(t_path, t_entry->name, scratch_pool);
+    }
+
+  queue_prefetch_batch(b->prefetch, s_rev, s_paths, t_paths);
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* A helper macro for when we have to recurse into subdirectories. */
 #define DEPTH_BELOW_HERE(depth) ((depth) == svn_depth_immediates) ? \
                                  svn_depth_empty : (depth)
 
+/* Starting at index START in the T_ENTRIES of directory T_PATH, find the
+   next DIR_PREFETCH_WINDOW sub-directories that delta_dirs() will likely
+   recurse into and ask the FS to prefetch their entries, as well as
+   those of their counterparts in S_ENTRIES of directory S_REV/S_PATH.
+   Set *END to the index after the last entry examined.  WC_DEPTH and
+   REQUESTED_DEPTH are the same as in delta_dirs().  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+prefetch_subdirs(report_baton_t *b,
+                 svn_revnum_t s_rev,
+                 const char *s_path,
+                 apr_hash_t *s_entries,
+                 const char *t_path,
+                 const apr_array_header_t *t_entries,
+                 int start,
+                 int *end,
+                 svn_depth_t wc_depth,
+                 svn_depth_t requested_depth,
+                 apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *s_paths
+    = apr_array_make(scratch_pool, DIR_PREFETCH_WINDOW, sizeof(const char *));
+  apr_array_header_t *t_paths
+    = apr_array_make(scratch_pool, DIR_PREFETCH_WINDOW, sizeof(const char *));
+  int i;
+
+  for (i = start;
+       i < t_entries->nelts && t_paths->nelts < DIR_PREFETCH_WINDOW;
+       ++i)
+    {
+      const svn_fs_dirent_t *t_entry
+        = APR_ARRAY_IDX(t_entries, i, svn_fs_dirent_t *);
+      const svn_fs_dirent_t *s_entry = NULL;
+
+      if (t_entry->kind != svn_node_dir)
+        continue;
+
+      if (!is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
+        s_entry = s_entries ? svn_hash_gets(s_entries, t_entry->name)
+                            : NULL;
+
+      /* Unchanged sub-trees will be skipped by update_entry(). */
+      if (s_entry && s_entry->kind == svn_node_dir)
+        {
+          int distance = svn_fs_compare_ids(s_entry->id, t_entry->id);
+          if (distance == 0)
+            continue;
+
+          if (distance != -1 || b->ignore_ancestry)
+            APR_ARRAY_PUSH(s_paths, const char *)
+              = svn_fspath__join(s_path, t_entry->name, scratch_pool);
+        }
+
+      APR_ARRAY_PUSH(t_paths, const char *)
+        = svn_fspath__join(t_path, t_entry->name, scratch_pool);
+    }
+
+  *end = i;
+
+  SVN_ERR(svn_fs__prefetch_dir_entries(b->t_root, t_paths, scratch_pool));
+  if (s_paths->nelts)
+    {
+      svn_fs_root_t *s_root;
+
+      SVN_ERR(get_source_root(b, &s_root, s_rev));
+      SVN_ERR(svn_fs__prefetch_dir_entries(s_root, s_paths, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Emit edits within directory DIR_BATON (with corresponding path
    E_PATH) with the changes from the directory S_REV/S_PATH to the
    directory B->t_rev/T_PATH.  S_PATH may be NULL if the entry does
@@ -1164,6 +2126,8 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
   apr_hash_index_t *hi;
   apr_pool_t *subpool = svn_pool_create(pool);
   apr_array_header_t *t_ordered_entries = NULL;
+  svn_boolean_t prefetch_dirs;
+  int prefetch_end = 0;
   int i;
 
   /* Compare the property lists.  If we're starting empty, pass a NULL
@@ -1178,6 +2142,7 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
       || requested_depth == svn_depth_unknown)
     {
       apr_pool_t *iterpool;
+      svn_stringbuf_t *e_fullpath_buf;
 
       /* Get the list of entries in each of source and target. */
       if (s_path && !start_empty)
@@ -1192,6 +2157,11 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
       /* Iterate over the report information for this directory. */
       iterpool = svn_pool_create(subpool);
 
+      /* The editor paths of all entries share the E_PATH prefix.  Build
+         them in a single, re-used buffer. */
+      e_fullpath_buf = svn_stringbuf_create_ensure(strlen(e_path) + 64,
+                                                   subpool);
+
       while (1)
         {
           path_info_t *info;
@@ -1217,11 +2187,12 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
               if (s_entries)
                 svn_hash_sets(s_entries, name, NULL);
 
-              svn_pool_destroy(info->pool);
+              free_path_info(info);
               continue;
             }
 
-          e_fullpath = svn_relpath_join(e_path, name, iterpool);
+          svn_relpath__join_buf(e_fullpath_buf, e_path, name);
+          e_fullpath = e_fullpath_buf->data;
           t_fullpath = svn_fspath__join(t_path, name, iterpool);
           t_entry = svn_hash_gets(t_entries, name);
           s_fullpath = s_path ? svn_fspath__join(s_path, name, iterpool) : NULL;
@@ -1253,10 +2224,11 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
               && (! info || info->depth != svn_depth_exclude || t_entry))
             svn_hash_sets(s_entries, name, NULL);
 
-          /* pathinfo entries live in their own subpools due to lookahead,
-             so we need to clear each one out as we finish with it. */
+          /* pathinfo entries read back from disk live in their own
+             subpools due to lookahead, so we need to clear each one out
+             as we finish with it. */
           if (info)
-            svn_pool_destroy(info->pool);
+            free_path_info(info);
         }
 
       /* Remove any deleted entries.  Do this before processing the
@@ -1286,7 +2258,9 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                     continue;
 
                   /* There is no corresponding target entry, so delete. */
-                  e_fullpath = svn_relpath_join(e_path, s_entry->name, iterpool);
+                  svn_relpath__join_buf(e_fullpath_buf, e_path,
+                                        s_entry->name);
+                  e_fullpath = e_fullpath_buf->data;
                   SVN_ERR(svn_repos_deleted_rev(svn_fs_root_fs(b->t_root),
                                                 svn_fspath__join(t_path,
                                                                  s_entry->name,
@@ -1304,6 +2278,20 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
       /* Loop over the dirents in the target. */
       SVN_ERR(svn_fs_dir_optimal_order(&t_ordered_entries, b->t_root,
                                        t_entries, subpool, iterpool));
+
+      /* Sub-directories will only be listed for these depths. */
+      prefetch_dirs = requested_depth == svn_depth_infinity
+                   || (   requested_depth == svn_depth_unknown
+                       && wc_depth >= svn_depth_immediates);
+
+#if APR_HAS_THREADS
+      /* Let the workers compute the text deltas of upcoming files. */
+      if (b->prefetch)
+        prefetch_dir_deltas(b, s_rev, s_path, s_entries, t_path,
+                            t_ordered_entries, wc_depth, requested_depth,
+                            iterpool);
+#endif
+
       for (i = 0; i < t_ordered_entries->nelts; ++i)
         {
           const svn_fs_dirent_t *t_entry
@@ -1313,6 +2301,13 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
 
           svn_pool_clear(iterpool);
 
+          /* Let the FS read the entries of the next sub-directories in
+             bulk instead of one random access at a time. */
+          if (prefetch_dirs && i == prefetch_end)
+            SVN_ERR(prefetch_subdirs(b, s_rev, s_path, s_entries, t_path,
+                                     t_ordered_entries, i, &prefetch_end,
+                                     wc_depth, requested_depth, iterpool));
+
           if (is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
             {
               /* We're making the working copy deeper, pretend the source
@@ -1340,7 +2335,8 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
             }
 
           /* Compose the report, editor, and target paths for this entry. */
-          e_fullpath = svn_relpath_join(e_path, t_entry->name, iterpool);
+          svn_relpath__join_buf(e_fullpath_buf, e_path, t_entry->name);
+          e_fullpath = e_fullpath_buf->data;
           t_fullpath = svn_fspath__join(t_path, t_entry->name, iterpool);
 
           SVN_ERR(update_entry(b, s_rev, s_fullpath, s_entry, t_fullpath,
@@ -1350,6 +2346,11 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                                iterpool));
         }
 
+#if APR_HAS_THREADS
+      if (b->prefetch)
+        cancel_prefetch_batch(b->prefetch);
+#endif
+
       /* iterpool is destroyed by destroying its parent (subpool) below */
     }
 
@@ -1424,19 +2425,41 @@ static svn_error_t *
 finish_report(report_baton_t *b, apr_pool_t *pool)
 {
   path_info_t *info;
-  apr_pool_t *subpool;
   svn_revnum_t s_rev;
   int i;
 
   /* Save our pool to manage the lookahead and fs_root cache with. */
   b->pool = pool;
 
-  /* Add the end marker. */
-  SVN_ERR(svn_spillbuf__reader_write(b->reader, "-", 1, pool));
+  /* Bring the report into depth-first order.  If parts of it have
+     already been spilled to disk, spill the rest as well and prepare
+     to merge all runs. */
+  if (b->runs->nelts)
+    {
+      SVN_ERR(spill_index(b, pool));
+
+      b->run_heads = apr_palloc(pool,
+                                b->runs->nelts * sizeof(*b->run_heads));
+      for (i = 0; i < b->runs->nelts; ++i)
+        {
+          svn_spillbuf_reader_t *run
+            = APR_ARRAY_IDX(b->runs, i, svn_spillbuf_reader_t *);
+
+          /* Add the end marker. */
+          SVN_ERR(svn_spillbuf__reader_write(run, "-", 1, pool));
+          SVN_ERR(read_path_info(&b->run_heads[i], run,
+                                 svn_pool_create(pool)));
+        }
+    }
+  else if (!b->sorted)
+    {
+      qsort(b->index->elts, b->index->nelts, b->index->elt_size,
+            compare_path_infos);
+    }
 
   /* Read the first pathinfo from the report and verify that it is a top-level
      set_path entry. */
-  SVN_ERR(read_path_info(&info, b->reader, pool));
+  SVN_ERR(next_path_info(&info, b));
   if (!info || strcmp(info->path, b->s_operand) != 0
       || info->link_path || !SVN_IS_VALID_REVNUM(info->rev))
     return svn_error_create(SVN_ERR_REPOS_BAD_REVISION_REPORT, NULL,
@@ -1444,8 +2467,7 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
   s_rev = info->rev;
 
   /* Initialize the lookahead pathinfo. */
-  subpool = svn_pool_create(pool);
-  SVN_ERR(read_path_info(&b->lookahead, b->reader, subpool));
+  SVN_ERR(next_path_info(&b->lookahead, b));
 
   if (b->lookahead && strcmp(b->lookahead->path, b->s_operand) == 0)
     {
@@ -1463,7 +2485,7 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
           b->lookahead->depth = info->depth;
         }
       info = b->lookahead;
-      SVN_ERR(read_path_info(&b->lookahead, b->reader, subpool));
+      SVN_ERR(next_path_info(&b->lookahead, b));
     }
 
   /* Open the target root and initialize the source root cache. */
@@ -1472,7 +2494,15 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
     b->s_roots[i] = NULL;
 
   {
-    svn_error_t *err = svn_error_trace(drive(b, s_rev, info, pool));
+    svn_error_t *err;
+
+#if APR_HAS_THREADS
+    SVN_ERR(start_prefetch(b, pool));
+    err = svn_error_trace(drive(b, s_rev, info, pool));
+    stop_prefetch(b);
+#else
+    err = svn_error_trace(drive(b, s_rev, info, pool));
+#endif
 
     if (err == SVN_NO_ERROR)
       return svn_error_trace(b->editor->close_edit(b->edit_baton, pool));
@@ -1486,47 +2516,160 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
 
 /* --- COLLECTING THE REPORT INFORMATION --- */
 
-/* Record a report operation into the spill buffer.  Return an error
-   if DEPTH is svn_depth_unknown. */
+/* Append STR to BUF as a length-counted string, preceded by '+'. */
+static void
+append_counted_string(svn_stringbuf_t *buf, const char *str)
+{
+  char len[SVN_INT64_BUFFER_SIZE];
+  apr_size_t str_len = strlen(str);
+
+  svn_stringbuf_appendbyte(buf, '+');
+  svn_stringbuf_appendbytes(buf, len, svn__ui64toa(len, str_len));
+  svn_stringbuf_appendbyte(buf, ':');
+  svn_stringbuf_appendbytes(buf, str, str_len);
+}
+
+/* Append the report operation PI to BUF in spill-buffer format. */
+static void
+serialize_path_info(svn_stringbuf_t *buf, const path_info_t *pi)
+{
+  append_counted_string(buf, pi->path);
+
+  if (pi->link_path)
+    append_counted_string(buf, pi->link_path);
+  else
+    svn_stringbuf_appendbyte(buf, '-');
+
+  if (SVN_IS_VALID_REVNUM(pi->rev))
+    {
+      char rev[SVN_INT64_BUFFER_SIZE];
+
+      svn_stringbuf_appendbyte(buf, '+');
+      svn_stringbuf_appendbytes(buf, rev, svn__i64toa(rev, pi->rev));
+      svn_stringbuf_appendbyte(buf, ':');
+    }
+  else
+    svn_stringbuf_appendbyte(buf, '-');
+
+  if (pi->depth == svn_depth_exclude)
+    svn_stringbuf_appendcstr(buf, "+X");
+  else if (pi->depth == svn_depth_empty)
+    svn_stringbuf_appendcstr(buf, "+E");
+  else if (pi->depth == svn_depth_files)
+    svn_stringbuf_appendcstr(buf, "+F");
+  else if (pi->depth == svn_depth_immediates)
+    svn_stringbuf_appendcstr(buf, "+M");
+  else
+    svn_stringbuf_appendbyte(buf, '-');
+
+  svn_stringbuf_appendbyte(buf, pi->start_empty ? '+' : '-');
+
+  if (pi->lock_token)
+    append_counted_string(buf, pi->lock_token);
+  else
+    svn_stringbuf_appendbyte(buf, '-');
+}
+
+/* Write the report operations from B->index to disk, sorted, and empty
+   the index.  While the report is in depth-first order, extend the
+   latest run; otherwise, start a new one.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+spill_index(report_baton_t *b, apr_pool_t *scratch_pool)
+{
+  svn_spillbuf_reader_t *run;
+  svn_stringbuf_t *buf;
+  int i;
+
+  if (b->sorted && b->runs->nelts)
+    {
+      run = APR_ARRAY_IDX(b->runs, b->runs->nelts - 1,
+                          svn_spillbuf_reader_t *);
+    }
+  else
+    {
+      /* Keep nothing in memory; that's the point of spilling. */
+      run = svn_spillbuf__reader_create(REPORT_SPILL_BLOCKSIZE, 0,
+                                        b->runs->pool);
+      APR_ARRAY_PUSH(b->runs, svn_spillbuf_reader_t *) = run;
+    }
+
+  if (!b->sorted)
+    qsort(b->index->elts, b->index->nelts, b->index->elt_size,
+          compare_path_infos);
+
+  buf = svn_stringbuf_create_ensure(REPORT_SPILL_BLOCKSIZE, scratch_pool);
+  for (i = 0; i < b->index->nelts; ++i)
+    {
+      serialize_path_info(buf, APR_ARRAY_IDX(b->index, i, path_info_t *));
+      if (buf->len >= REPORT_SPILL_BLOCKSIZE || i + 1 == b->index->nelts)
+        {
+          SVN_ERR(svn_spillbuf__reader_write(run, buf->data, buf->len,
+                                             scratch_pool));
+          svn_stringbuf_setempty(buf);
+        }
+    }
+
+  apr_array_clear(b->index);
+  b->index_size = 0;
+  svn_pool_clear(b->index_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Record a report operation in the report index, spilling the index to
+   disk if it grows too large.  Return an error if DEPTH is
+   svn_depth_unknown. */
 static svn_error_t *
 write_path_info(report_baton_t *b, const char *path, const char *lpath,
                 svn_revnum_t rev, svn_depth_t depth,
                 svn_boolean_t start_empty,
                 const char *lock_token, apr_pool_t *pool)
 {
-  const char *lrep, *rrep, *drep, *ltrep, *rep;
+  path_info_t *pi;
+
+  if (depth != svn_depth_exclude
+      && depth != svn_depth_empty
+      && depth != svn_depth_files
+      && depth != svn_depth_immediates
+      && depth != svn_depth_infinity)
+    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                             _("Unsupported report depth '%s'"),
+                             svn_depth_to_word(depth));
+
+  pi = apr_palloc(b->index_pool, sizeof(*pi));
 
   /* Munge the path to be anchor-relative, so that we can use edit paths
      as report paths. */
-  path = svn_relpath_join(b->s_operand, path, pool);
+  pi->path = svn_relpath_join(b->s_operand, path, b->index_pool);
+  pi->link_path = lpath ? apr_pstrdup(b->index_pool, lpath) : NULL;
+  pi->rev = rev;
+  pi->depth = depth;
+  pi->start_empty = start_empty;
+  pi->lock_token = lock_token ? apr_pstrdup(b->index_pool, lock_token)
+                              : NULL;
+  pi->order = b->op_count++;
+  pi->pool = NULL;
+
+  /* Once out of order, we will have to sort the index before use. */
+  if (b->sorted)
+    {
+      if (pi->order
+          && svn_path_compare_paths(b->last_path->data, pi->path) > 0)
+        b->sorted = FALSE;
+      else
+        svn_stringbuf_set(b->last_path, pi->path);
+    }
 
-  lrep = lpath ? apr_psprintf(pool, "+%" APR_SIZE_T_FMT ":%s",
-                              strlen(lpath), lpath) : "-";
-  rrep = (SVN_IS_VALID_REVNUM(rev)) ?
-    apr_psprintf(pool, "+%ld:", rev) : "-";
+  APR_ARRAY_PUSH(b->index, path_info_t *) = pi;
+  b->index_size += sizeof(pi) + sizeof(*pi) + strlen(pi->path)
+                 + (lpath ? strlen(lpath) : 0)
+                 + (lock_token ? strlen(lock_token) : 0);
 
-  if (depth == svn_depth_exclude)
-    drep = "+X";
-  else if (depth == svn_depth_empty)
-    drep = "+E";
-  else if (depth == svn_depth_files)
-    drep = "+F";
-  else if (depth == svn_depth_immediates)
-    drep = "+M";
-  else if (depth == svn_depth_infinity)
-    drep = "-";
-  else
-    return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
-                             _("Unsupported report depth '%s'"),
-                             svn_depth_to_word(depth));
+  if (b->index_size > REPORT_MEMORY_LIMIT)
+    SVN_ERR(spill_index(b, pool));
 
-  ltrep = lock_token ? apr_psprintf(pool, "+%" APR_SIZE_T_FMT ":%s",
-                                    strlen(lock_token), lock_token) : "-";
-  rep = apr_psprintf(pool, "+%" APR_SIZE_T_FMT ":%s%s%s%s%c%s",
-                     strlen(path), path, lrep, rrep, drep,
-                     start_empty ? '+' : '-', ltrep);
-  return svn_error_trace(
-            svn_spillbuf__reader_write(b->reader, rep, strlen(rep), pool));
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -1568,9 +2711,19 @@ svn_error_t *
 svn_repos_finish_report(void *baton, apr_pool_t *pool)
 {
   report_baton_t *b = baton;
+  svn_trace__span_t *span;
+  svn_error_t *err;
 
   SVN_ERR(svn_fs_refresh_revision_props(svn_repos_fs(b->repos), pool));
-  return svn_error_trace(finish_report(b, pool));
+
+  span = svn_trace__span_begin("repos finish_report", pool);
+  svn_trace__span_attr(span, "path", b->fs_base);
+  svn_trace__span_attr_int(span, "revision", b->t_rev);
+
+  err = finish_report(b, pool);
+  svn_trace__span_end(span);
+
+  return svn_error_trace(err);
 }
 
 svn_error_t *
@@ -1579,6 +2732,24 @@ svn_repos_abort_report(void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+void
+svn_repos__report_set_prefetch_jobs(void *report_baton,
+                                    int jobs)
+{
+  report_baton_t *b = report_baton;
+
+  b->prefetch_jobs = jobs;
+}
+
+void
+svn_repos__report_set_send_fulltexts(void *report_baton,
+                                     svn_boolean_t send_fulltexts)
+{
+  report_baton_t *b = report_baton;
+
+  b->send_fulltexts = send_fulltexts;
+}
+
 /* --- BEGINNING THE REPORT --- */
 
 
@@ -1630,10 +2801,21 @@ svn_repos_begin_report3(void **report_baton,
   b->authz_read_baton = authz_read_baton;
   b->revision_infos = apr_hash_make(pool);
   b->pool = pool;
-  b->reader = svn_spillbuf__reader_create(1000 /* blocksize */,
-                                          1000000 /* maxsize */,
-                                          pool);
+  b->index = apr_array_make(pool, 16, sizeof(path_info_t *));
+  b->index_size = 0;
+  b->index_pool = svn_pool_create(pool);
+  b->index_next = 0;
+  b->op_count = 0;
+  b->last_path = svn_stringbuf_create_empty(pool);
+  b->sorted = TRUE;
+  b->runs = apr_array_make(pool, 1, sizeof(svn_spillbuf_reader_t *));
+  b->run_heads = NULL;
   b->repos_uuid = svn_string_create(uuid, pool);
+  b->prefetch_jobs = 0;
+  b->send_fulltexts = FALSE;
+#if APR_HAS_THREADS
+  b->prefetch = NULL;
+#endif
 
   /* Hand reporter back to client. */
   *report_baton = b;
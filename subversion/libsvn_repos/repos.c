@@ -878,6 +878,11 @@ create_conf(svn_repos_t *repos, apr_pool_t *pool)
 "### Unless you specify an absolute path, the file's location is relative"   NL
 "### to the directory containing this file."                                 NL
 "# hooks-env = " SVN_REPOS__CONF_HOOKS_ENV                                   NL
+"### The async-post-commit option lets svnserve answer commits before the"   NL
+"### post-commit hook has run.  The hook invocations are queued in the"      NL
+"### repository and run in order once the client has got its response."      NL
+"### Default is false."                                                      NL
+"# async-post-commit = false"                                                NL
 ""                                                                           NL
 "[sasl]"                                                                     NL
 "### This option specifies whether you want to use the Cyrus SASL"           NL
@@ -979,7 +984,18 @@ create_conf(svn_repos_t *repos, apr_pool_t *pool)
 ""                                                                           NL
 "### This sets the PATH environment variable for the pre-commit hook."       NL
 "[pre-commit]"                                                               NL
-"PATH = /usr/local/bin:/usr/bin:/usr/sbin"                                   NL;
+"PATH = /usr/local/bin:/usr/bin:/usr/sbin"                                   NL
+""                                                                           NL
+"### On Unix, hook programs may be handed to a long-running hook server"     NL
+"### instead of being started as a new process for every invocation."        NL
+"### The server listens on the Unix socket given below.  Hooks run"          NL
+"### through it only if the hook program exists in the hooks directory."     NL
+"### For each hook, the server receives the skel"                            NL
+"###   (NAME PROGRAM (ARG ...) (VAR=VALUE ...) (STDIN?))"                    NL
+"### and has to reply with the skel (EXITCODE STDOUT STDERR)."               NL
+"### If the socket cannot be connected to, hooks are started as usual."      NL
+"# [hook-server]"                                                            NL
+"# socket = /var/run/svn-hooks.sock"                                         NL;
 
     SVN_ERR_W(svn_io_file_create(svn_dirent_join(repos->conf_path,
                                                  SVN_REPOS__CONF_HOOKS_ENV \
@@ -998,19 +1014,29 @@ svn_repos_hooks_setenv(svn_repos_t *repos,
                        apr_pool_t *scratch_pool)
 {
   if (hooks_env_path == NULL)
-    repos->hooks_env_path = svn_dirent_join(repos->conf_path,
-                                            SVN_REPOS__CONF_HOOKS_ENV,
-                                            repos->pool);
+    hooks_env_path = svn_dirent_join(repos->conf_path,
+                                     SVN_REPOS__CONF_HOOKS_ENV,
+                                     scratch_pool);
   else if (!svn_dirent_is_absolute(hooks_env_path))
-    repos->hooks_env_path = svn_dirent_join(repos->conf_path,
-                                            hooks_env_path,
-                                            repos->pool);
-  else
+    hooks_env_path = svn_dirent_join(repos->conf_path, hooks_env_path,
+                                     scratch_pool);
+
+  /* Pooled REPOS objects get this set for every new user.  Don't let
+     their pool grow each time. */
+  if (   repos->hooks_env_path == NULL
+      || strcmp(repos->hooks_env_path, hooks_env_path) != 0)
     repos->hooks_env_path = apr_pstrdup(repos->pool, hooks_env_path);
 
   return SVN_NO_ERROR;
 }
 
+void
+svn_repos__set_async_post_commit(svn_repos_t *repos,
+                                 svn_boolean_t async)
+{
+  repos->async_post_commit = async;
+}
+
 /* Allocate and return a new svn_repos_t * object, initializing the
    directory pathname members based on PATH, and initializing the
    REPOSITORY_CAPABILITIES member.
@@ -1964,10 +1990,11 @@ fs_hotcopy_notify(void *baton,
 
 /* Make a copy of a repository with hot backup of fs. */
 svn_error_t *
-svn_repos_hotcopy3(const char *src_path,
+svn_repos_hotcopy4(const char *src_path,
                    const char *dst_path,
                    svn_boolean_t clean_logs,
                    svn_boolean_t incremental,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -2052,8 +2079,8 @@ svn_repos_hotcopy3(const char *src_path,
   fs_notify_baton.notify_func = notify_func;
   fs_notify_baton.notify_baton = notify_baton;
 
-  SVN_ERR(svn_fs_hotcopy3(src_repos->db_path, dst_repos->db_path,
-                          clean_logs, incremental,
+  SVN_ERR(svn_fs_hotcopy4(src_repos->db_path, dst_repos->db_path,
+                          clean_logs, incremental, jobs,
                           fs_notify_func, &fs_notify_baton,
                           cancel_func, cancel_baton, scratch_pool));
 
@@ -2092,3 +2119,41 @@ svn_repos__fs_type(const char **fs_type,
                      svn_dirent_join(repos_path, SVN_REPOS__DB_DIR, pool),
                      pool);
 }
+
+svn_revnum_t
+svn_repos__dav_uri_revision(const char *path,
+                            const char *special_uri)
+{
+  static const char *const kinds[] = { "rev", "rvr", "ver", "bc", "bln",
+                                       NULL };
+  apr_size_t special_len = strlen(special_uri);
+  int i;
+
+  if (   path[0] != '/'
+      || strncmp(path + 1, special_uri, special_len) != 0
+      || path[special_len + 1] != '/')
+    return SVN_INVALID_REVNUM;
+
+  path += special_len + 2;
+  for (i = 0; kinds[i]; ++i)
+    {
+      apr_size_t len = strlen(kinds[i]);
+
+      if (strncmp(path, kinds[i], len) == 0 && path[len] == '/')
+        {
+          svn_revnum_t rev;
+          const char *end;
+          svn_error_t *err = svn_revnum_parse(&rev, path + len + 1, &end);
+
+          if (err || (*end != '\0' && *end != '/'))
+            {
+              svn_error_clear(err);
+              return SVN_INVALID_REVNUM;
+            }
+
+          return rev;
+        }
+    }
+
+  return SVN_INVALID_REVNUM;
+}
@@ -65,6 +65,8 @@ extern "C" {
 #define SVN_REPOS__LOCK_DIR    "locks"      /* Lock files live here. */
 #define SVN_REPOS__HOOK_DIR    "hooks"      /* Hook programs. */
 #define SVN_REPOS__CONF_DIR    "conf"       /* Configuration files. */
+#define SVN_REPOS__POST_COMMIT_QUEUE_DIR "post-commit-queue"
+                                            /* Deferred post-commit hooks. */
 
 /* Things for which we keep lockfiles. */
 #define SVN_REPOS__DB_LOCKFILE "db.lock" /* Our Berkeley lockfile. */
@@ -92,6 +94,10 @@ extern "C" {
 #define SVN_REPOS__CONF_HOOKS_ENV "hooks-env"
 /* The name of the default section in the hooks-env config file. */
 #define SVN_REPOS__HOOKS_ENV_DEFAULT_SECTION "default"
+/* The name of the section in the hooks-env config file which configures
+ * a hook server, and of its option naming the server's Unix socket. */
+#define SVN_REPOS__HOOKS_ENV_SERVER_SECTION "hook-server"
+#define SVN_REPOS__HOOKS_ENV_SERVER_SOCKET "socket"
 
 /* The configuration file for svnserve, in the repository conf directory. */
 #define SVN_REPOS__CONF_SVNSERVE_CONF "svnserve.conf"
@@ -132,6 +138,9 @@ struct svn_repos_t
    * in an empty environment. */
   const char *hooks_env_path;
 
+  /* If set, post-commit hooks get deferred to the post-commit queue. */
+  svn_boolean_t async_post_commit;
+
   /* The FS backend in use within this repository. */
   const char *fs_type;
 
@@ -221,7 +230,10 @@ svn_repos__hooks_pre_commit(svn_repos_t *repos,
    via svn_repos__parse_hooks_env() (or NULL if no such information is
    available).
 
-   REV is the revision that was created as a result of the commit.  */
+   REV is the revision that was created as a result of the commit.
+
+   If asynchronous post-commit hooks have been enabled for REPOS, just
+   add the hook invocation to the post-commit queue and return.  */
 svn_error_t *
 svn_repos__hooks_post_commit(svn_repos_t *repos,
                              apr_hash_t *hooks_env,
@@ -284,6 +296,28 @@ svn_repos__hooks_post_revprop_change(svn_repos_t *repos,
                                      char action,
                                      apr_pool_t *pool);
 
+/* Return TRUE if the hook program HOOK, as returned by e.g.
+   svn_repos_pre_lock_hook(), exists; a broken symbolic link counts as
+   existing.  Use POOL for temporary allocations.
+
+   Callers running the same hook for many paths can use this to skip
+   the per-path invocations altogether when the hook is not installed. */
+svn_boolean_t
+svn_repos__hook_exists(const char *hook,
+                       apr_pool_t *pool);
+
+/* Like svn_repos_fs_begin_txn_for_commit2() but if IN_PROCESS is set,
+   promise that the transaction will be committed or aborted by this
+   process.  Unless REPOS has hooks that might look at the transaction,
+   the filesystem may then keep it in memory. */
+svn_error_t *
+svn_repos__fs_begin_txn_for_commit(svn_fs_txn_t **txn_p,
+                                   svn_repos_t *repos,
+                                   svn_revnum_t rev,
+                                   apr_hash_t *revprop_table,
+                                   svn_boolean_t in_process,
+                                   apr_pool_t *pool);
+
 /* Run the pre-lock hook for REPOS.  Use POOL for any temporary
    allocations.  If the hook fails, return SVN_ERR_REPOS_HOOK_FAILURE.
 
@@ -387,6 +421,19 @@ svn_repos__prev_location(svn_revnum_t *appeared_rev,
                          const char *path,
                          apr_pool_t *pool);
 
+/* Like svn_repos_parse_dumpstream3() but read, parse and decode STREAM in
+   a separate thread while invoking the PARSE_FNS callbacks in the calling
+   thread.  Without thread support, this is the same as
+   svn_repos_parse_dumpstream3().  */
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      svn_boolean_t deltas_are_text,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
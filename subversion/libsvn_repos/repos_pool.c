@@ -0,0 +1,117 @@
+/*
+ * repos_pool.c :  pool of open repository objects
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include <string.h>
+
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_fs.h"
+#include "svn_pools.h"
+#include "svn_repos.h"
+
+#include "private/svn_object_pool.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_string_private.h"
+
+
+
+/* FS warning handler for parked repository objects.  The previous user's
+ * handler baton is gone by now.  Implements svn_fs_warning_callback_t. */
+static void
+parked_warning_func(void *baton,
+                    svn_error_t *err)
+{
+  svn_handle_warning2(stderr, err, "svn: ");
+}
+
+/* Pool cleanup function resetting the per-user state of the repository
+ * object BATON before it gets parked. */
+static apr_status_t
+reset_repos(void *baton)
+{
+  svn_fs_t *fs = svn_repos_fs(baton);
+
+  svn_fs_set_warning_func(fs, parked_warning_func, NULL);
+  svn_error_clear(svn_fs_set_access(fs, NULL));
+
+  return APR_SUCCESS;
+}
+
+/* API implementation */
+
+svn_error_t *
+svn_repos__repos_pool_create(svn_repos__repos_pool_t **repos_pool,
+                             svn_boolean_t thread_safe,
+                             apr_pool_t *pool)
+{
+  return svn_error_trace(svn_object_pool__create(repos_pool,
+                                                 thread_safe, TRUE,
+                                                 pool));
+}
+
+svn_error_t *
+svn_repos__repos_pool_get(svn_repos_t **repos_p,
+                          svn_repos__repos_pool_t *repos_pool,
+                          const char *path,
+                          apr_hash_t *fs_config,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_membuf_t key;
+  svn_repos_t *repos;
+
+  /* Repositories are identified by their absolute path. */
+  SVN_ERR(svn_dirent_get_absolute(&path, path, scratch_pool));
+  svn_membuf__create(&key, strlen(path), scratch_pool);
+  key.size = strlen(path);
+  memcpy(key.data, path, key.size);
+
+  /* Re-use an idle instance, if there is one. */
+  SVN_ERR(svn_object_pool__lookup((void **)repos_p, repos_pool, &key,
+                                  result_pool));
+
+  /* Open a new instance.  It will be parked for reuse once RESULT_POOL
+   * releases it. */
+  if (*repos_p == NULL)
+    {
+      apr_pool_t *item_pool = svn_object_pool__new_item_pool(repos_pool);
+      svn_error_t *err = svn_repos_open3(&repos, path, fs_config,
+                                         item_pool, scratch_pool);
+      if (err)
+        {
+          svn_pool_destroy(item_pool);
+          return svn_error_trace(err);
+        }
+
+      SVN_ERR(svn_object_pool__insert((void **)repos_p, repos_pool, &key,
+                                      repos, item_pool, result_pool));
+    }
+
+  /* Cleanups run in reverse order, i.e. this one before the release. */
+  apr_pool_cleanup_register(result_pool, *repos_p, reset_repos,
+                            apr_pool_cleanup_null);
+
+  return SVN_NO_ERROR;
+}
@@ -89,6 +89,33 @@ svn_repos_dated_revision(svn_revnum_t *revision,
   /* Initialize top and bottom values of binary search. */
   SVN_ERR(svn_fs_youngest_rev(&rev_latest, fs, pool));
   SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
+
+  /* Ask the filesystem's revision dates index first.  It may be out of
+     date, so only use its answer if the revisions around it confirm it. */
+  SVN_ERR(svn_fs__dated_revision(&rev_mid, fs, tm, pool));
+  if (SVN_IS_VALID_REVNUM(rev_mid) && rev_mid <= rev_latest)
+    {
+      svn_boolean_t confirmed = TRUE;
+
+      if (rev_mid > 0)
+        {
+          SVN_ERR(get_time(&this_time, fs, rev_mid, pool));
+          confirmed = (this_time <= tm);
+        }
+
+      if (confirmed && rev_mid < rev_latest)
+        {
+          SVN_ERR(get_time(&this_time, fs, rev_mid + 1, pool));
+          confirmed = (this_time > tm);
+        }
+
+      if (confirmed)
+        {
+          *revision = rev_mid;
+          return SVN_NO_ERROR;
+        }
+    }
+
   rev_bot = 0;
   rev_top = rev_latest;
 
@@ -317,6 +344,7 @@ svn_repos_deleted_rev(svn_fs_t *fs,
   svn_revnum_t mid_rev;
   svn_node_kind_t kind;
   svn_fs_node_relation_t node_relation;
+  svn_boolean_t indexed;
 
   /* Validate the revision range. */
   if (! SVN_IS_VALID_REVNUM(start))
@@ -346,6 +374,14 @@ svn_repos_deleted_rev(svn_fs_t *fs,
       return SVN_NO_ERROR;
     }
 
+  /* The path got deleted the first time it or any of its parents got
+     deleted or replaced.  The changed-paths index, if there is one,
+     records these events. */
+  SVN_ERR(svn_fs__changed_paths_next_structural(deleted, &indexed, fs,
+                                                path, start, end, pool));
+  if (indexed)
+    return SVN_NO_ERROR;
+
   /* Ensure path was deleted at or before end revision. */
   SVN_ERR(svn_fs_revision_root(&root, fs, end, pool));
   SVN_ERR(svn_fs_check_path(&kind, root, path, pool));
@@ -1341,6 +1377,10 @@ find_merged_revisions(apr_array_header_t **merged_path_revisions_out,
   return SVN_NO_ERROR;
 }
 
+/* Fulltexts up to this size will be kept in memory while sending file
+   revisions, so the next delta may use them as its source. */
+#define FULLTEXT_CACHE_LIMIT 0x100000
+
 struct send_baton
 {
   apr_pool_t *iterpool;
@@ -1349,8 +1389,64 @@ struct send_baton
   const char *last_path;
   svn_fs_root_t *last_root;
   svn_boolean_t include_merged_revisions;
+
+  /* Contents of LAST_PATH in LAST_ROOT, allocated in LAST_POOL.  NULL if
+     we did not read them. */
+  svn_stringbuf_t *last_fulltext;
 };
 
+/* Implement svn_fs_process_contents_func_t.  Copy CONTENTS into the
+   svn_stringbuf_t * given by BATON unless LEN exceeds our limit. */
+static svn_error_t *
+copy_fulltext(const unsigned char *contents,
+              apr_size_t len,
+              void *baton,
+              apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t **fulltext = baton;
+
+  if (len <= FULLTEXT_CACHE_LIMIT)
+    svn_stringbuf_appendbytes(*fulltext, (const char *)contents, len);
+  else
+    *fulltext = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *FULLTEXT to the contents of PATH in ROOT, allocated in POOL.
+   Set it to NULL, if the file is too large to be kept in memory. */
+static svn_error_t *
+read_fulltext(svn_stringbuf_t **fulltext,
+              svn_fs_root_t *root,
+              const char *path,
+              apr_pool_t *pool)
+{
+  svn_boolean_t success;
+  svn_filesize_t length;
+  svn_stream_t *contents;
+
+  /* Copy the data directly from the FS cache, if possible. */
+  *fulltext = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_fs_try_process_file_contents(&success, root, path,
+                                           copy_fulltext, fulltext,
+                                           pool));
+  if (success)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_file_length(&length, root, path, pool));
+  if (length > FULLTEXT_CACHE_LIMIT)
+    {
+      *fulltext = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_file_contents(&contents, root, path, pool));
+  SVN_ERR(svn_stringbuf_from_stream(fulltext, contents, (apr_size_t)length,
+                                    pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Send PATH_REV to HANDLER and HANDLER_BATON, using information provided by
    SB. */
 static svn_error_t *
@@ -1367,6 +1463,7 @@ send_path_revision(struct path_revision *path_rev,
   svn_txdelta_stream_t *delta_stream;
   svn_txdelta_window_handler_t delta_handler = NULL;
   void *delta_baton = NULL;
+  svn_stringbuf_t *fulltext = NULL;
   apr_pool_t *tmp_pool;  /* For swapping */
   svn_boolean_t contents_changed;
   svn_boolean_t props_changed;
@@ -1451,21 +1548,62 @@ send_path_revision(struct path_revision *path_rev,
      no deltas will be computed. */
   if (delta_handler && delta_handler != svn_delta_noop_window_handler)
     {
-      /* Get the content delta. */
-      SVN_ERR(svn_fs_get_file_delta_stream(&delta_stream,
-                                           sb->last_root, sb->last_path,
-                                           root, path_rev->path,
-                                           sb->iterpool));
-      /* And send. */
-      SVN_ERR(svn_txdelta_send_txstream(delta_stream,
-                                        delta_handler, delta_baton,
-                                        sb->iterpool));
+      /* Along a single line of history, the FS can often hand out the
+         stored delta as is.  The first revision and jumps between merge
+         sources need the fulltexts, though.  Keep those in memory, so
+         the next revision will not need to reconstruct them again. */
+      if (! sb->last_root || strcmp(sb->last_path, path_rev->path))
+        SVN_ERR(read_fulltext(&fulltext, root, path_rev->path,
+                              sb->iterpool));
+
+      if (fulltext && ! sb->last_root)
+        {
+          SVN_ERR(svn_txdelta_send_contents((const unsigned char *)
+                                              fulltext->data,
+                                            fulltext->len,
+                                            delta_handler, delta_baton,
+                                            sb->iterpool));
+        }
+      else
+        {
+          /* Get the content delta. */
+          if (fulltext)
+            {
+              svn_stream_t *source;
+
+              if (sb->last_fulltext)
+                source = svn_stream_from_stringbuf(sb->last_fulltext,
+                                                   sb->iterpool);
+              else
+                SVN_ERR(svn_fs_file_contents(&source, sb->last_root,
+                                             sb->last_path, sb->iterpool));
+
+              svn_txdelta2(&delta_stream, source,
+                           svn_stream_from_stringbuf(fulltext,
+                                                     sb->iterpool),
+                           FALSE, sb->iterpool);
+            }
+          else
+            {
+              SVN_ERR(svn_fs_get_file_delta_stream(&delta_stream,
+                                                   sb->last_root,
+                                                   sb->last_path,
+                                                   root, path_rev->path,
+                                                   sb->iterpool));
+            }
+
+          /* And send. */
+          SVN_ERR(svn_txdelta_send_txstream(delta_stream,
+                                            delta_handler, delta_baton,
+                                            sb->iterpool));
+        }
     }
 
   /* Remember root, path and props for next iteration. */
   sb->last_root = root;
   sb->last_path = path_rev->path;
   sb->last_props = props;
+  sb->last_fulltext = fulltext;
 
   /* Swap the pools. */
   tmp_pool = sb->iterpool;
@@ -1511,6 +1649,7 @@ get_file_revs_backwards(svn_repos_t *repos,
   /* We want the first txdelta to be against the empty file. */
   sb.last_root = NULL;
   sb.last_path = NULL;
+  sb.last_fulltext = NULL;
 
   /* Create an empty hash table for the first property diff. */
   sb.last_props = apr_hash_make(sb.last_pool);
@@ -1662,6 +1801,7 @@ svn_repos_get_file_revs2(svn_repos_t *repos,
   /* We want the first txdelta to be against the empty file. */
   sb.last_root = NULL;
   sb.last_path = NULL;
+  sb.last_fulltext = NULL;
 
   /* Create an empty hash table for the first property diff. */
   sb.last_props = apr_hash_make(sb.last_pool);
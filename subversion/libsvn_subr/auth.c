@@ -883,6 +883,169 @@ svn_auth__make_session_auth(svn_auth_baton_t **session_auth_baton,
   return SVN_NO_ERROR;
 }
 
+/* A provider of credentials of one kind for a thread auth baton.
+   See svn_auth__make_thread_auth(). */
+typedef struct forward_provider_baton_t
+{
+  /* The auth baton to ask while not *DETACHED. */
+  svn_auth_baton_t *auth_baton;
+  const svn_boolean_t *detached;
+  const char *cred_kind;
+
+  /* The iteration over the credentials of AUTH_BATON. */
+  svn_auth_iterstate_t *state;
+} forward_provider_baton_t;
+
+/* Implements svn_auth_provider_t.first_credentials for a
+   forward_provider_baton_t. */
+static svn_error_t *
+forward_first_credentials(void **credentials,
+                          void **iter_baton,
+                          void *provider_baton,
+                          apr_hash_t *parameters,
+                          const char *realmstring,
+                          apr_pool_t *pool)
+{
+  forward_provider_baton_t *pb = provider_baton;
+  svn_auth_baton_t *auth_baton;
+  apr_hash_index_t *hi;
+
+  *credentials = NULL;
+  *iter_baton = pb;
+  pb->state = NULL;
+
+  if (*pb->detached)
+    return SVN_NO_ERROR;
+
+  /* Ask with the parameters of the requesting session. */
+  SVN_ERR(svn_auth__make_session_auth(&auth_baton, pb->auth_baton,
+                                      NULL, NULL, pool, pool));
+  for (hi = apr_hash_first(pool, parameters); hi; hi = apr_hash_next(hi))
+    svn_auth_set_parameter(auth_baton, apr_hash_this_key(hi),
+                           apr_hash_this_val(hi));
+
+  return svn_error_trace(svn_auth_first_credentials(credentials,
+                                                    &pb->state,
+                                                    pb->cred_kind,
+                                                    realmstring,
+                                                    auth_baton, pool));
+}
+
+/* Implements svn_auth_provider_t.next_credentials for a
+   forward_provider_baton_t. */
+static svn_error_t *
+forward_next_credentials(void **credentials,
+                         void *iter_baton,
+                         void *provider_baton,
+                         apr_hash_t *parameters,
+                         const char *realmstring,
+                         apr_pool_t *pool)
+{
+  forward_provider_baton_t *pb = provider_baton;
+
+  *credentials = NULL;
+  if (*pb->detached || !pb->state)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_auth_next_credentials(credentials, pb->state,
+                                                   pool));
+}
+
+/* Implements svn_auth_provider_t.save_credentials for a
+   forward_provider_baton_t. */
+static svn_error_t *
+forward_save_credentials(svn_boolean_t *saved,
+                         void *credentials,
+                         void *provider_baton,
+                         apr_hash_t *parameters,
+                         const char *realmstring,
+                         apr_pool_t *pool)
+{
+  forward_provider_baton_t *pb = provider_baton;
+
+  *saved = FALSE;
+  if (*pb->detached || !pb->state)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_auth_save_credentials(pb->state, pool));
+  *saved = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_auth__make_thread_auth(svn_auth_baton_t **thread_auth_baton,
+                           svn_auth_baton_t *auth_baton,
+                           const svn_boolean_t *detached,
+                           apr_pool_t *result_pool)
+{
+  static const char * const cred_kinds[] = {
+    SVN_AUTH_CRED_SIMPLE,
+    SVN_AUTH_CRED_USERNAME,
+    SVN_AUTH_CRED_SSL_CLIENT_CERT,
+    SVN_AUTH_CRED_SSL_CLIENT_CERT_PW,
+    SVN_AUTH_CRED_SSL_SERVER_TRUST
+  };
+  static const char * const param_names[] = {
+    SVN_AUTH_PARAM_DEFAULT_USERNAME,
+    SVN_AUTH_PARAM_DEFAULT_PASSWORD,
+    SVN_AUTH_PARAM_NON_INTERACTIVE,
+    SVN_AUTH_PARAM_DONT_STORE_PASSWORDS,
+    SVN_AUTH_PARAM_NO_AUTH_CACHE,
+    SVN_AUTH_PARAM_CONFIG_DIR
+  };
+  apr_array_header_t *providers;
+  svn_auth_provider_object_t *provider;
+  int i;
+
+  providers = apr_array_make(result_pool, 10,
+                             sizeof(svn_auth_provider_object_t *));
+
+  for (i = 0; i < (sizeof(cred_kinds) / sizeof(cred_kinds[0])); i++)
+    {
+      svn_auth_provider_t *vtable = apr_pcalloc(result_pool,
+                                                sizeof(*vtable));
+      forward_provider_baton_t *pb = apr_pcalloc(result_pool, sizeof(*pb));
+
+      vtable->cred_kind = cred_kinds[i];
+      vtable->first_credentials = forward_first_credentials;
+      vtable->next_credentials = forward_next_credentials;
+      vtable->save_credentials = forward_save_credentials;
+      pb->auth_baton = auth_baton;
+      pb->detached = detached;
+      pb->cred_kind = cred_kinds[i];
+
+      provider = apr_pcalloc(result_pool, sizeof(*provider));
+      provider->vtable = vtable;
+      provider->provider_baton = pb;
+      APR_ARRAY_PUSH(providers, svn_auth_provider_object_t *) = provider;
+    }
+
+  /* What the disk cache provides without prompting. */
+  svn_auth_get_simple_provider2(&provider, NULL, NULL, result_pool);
+  APR_ARRAY_PUSH(providers, svn_auth_provider_object_t *) = provider;
+  svn_auth_get_username_provider(&provider, result_pool);
+  APR_ARRAY_PUSH(providers, svn_auth_provider_object_t *) = provider;
+  svn_auth_get_ssl_server_trust_file_provider(&provider, result_pool);
+  APR_ARRAY_PUSH(providers, svn_auth_provider_object_t *) = provider;
+  svn_auth_get_ssl_client_cert_file_provider(&provider, result_pool);
+  APR_ARRAY_PUSH(providers, svn_auth_provider_object_t *) = provider;
+  svn_auth_get_ssl_client_cert_pw_file_provider2(&provider, NULL, NULL,
+                                                 result_pool);
+  APR_ARRAY_PUSH(providers, svn_auth_provider_object_t *) = provider;
+
+  svn_auth_open(thread_auth_baton, providers, result_pool);
+
+  for (i = 0; i < (sizeof(param_names) / sizeof(param_names[0])); i++)
+    {
+      const void *value = svn_auth_get_parameter(auth_baton,
+                                                 param_names[i]);
+
+      if (value)
+        svn_auth_set_parameter(*thread_auth_baton, param_names[i], value);
+    }
+}
+
 
 static svn_error_t *
 dummy_first_creds(void **credentials,
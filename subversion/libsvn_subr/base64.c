@@ -36,6 +36,13 @@
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 
+/* SSE2 is part of every x86-64 CPU, so there is no need to detect it. */
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SVN_BASE64__SSE2
+#endif
+
 /* When asked to format the base64-encoded output as multiple lines,
    we put this many chars in each line (plus one new line char) unless
    we run out of data.
@@ -85,6 +92,53 @@ encode_group(const unsigned char *in, char *out)
   out[3] = base64tab[part2 & 0x3f];
 }
 
+#ifdef SVN_BASE64__SSE2
+
+/* Base64-encode 12 bytes from IN into 16 chars at OUT, producing the same
+   output as four calls to encode_group(). */
+static APR_INLINE void
+encode_block_sse2(const unsigned char *in, char *out)
+{
+  /* Put each group of three input bytes into a 32 bit lane. */
+  __m128i v = _mm_setr_epi32((in[0] << 16) | (in[1] << 8) | in[2],
+                             (in[3] << 16) | (in[4] << 8) | in[5],
+                             (in[6] << 16) | (in[7] << 8) | in[8],
+                             (in[9] << 16) | (in[10] << 8) | in[11]);
+  __m128i mask6 = _mm_set1_epi32(0x3f);
+  __m128i idx;
+  __m128i chars;
+
+  /* Split each lane into four 6 bit values, one per byte, in output
+     order.  */
+  idx = _mm_or_si128(
+          _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 18), mask6),
+                       _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 12),
+                                                    mask6), 8)),
+          _mm_or_si128(_mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(v, 6),
+                                                    mask6), 16),
+                       _mm_slli_epi32(_mm_and_si128(v, mask6), 24)));
+
+  /* Map the values to base64tab[] chars by adding range-specific
+     offsets. */
+  chars = _mm_add_epi8(idx, _mm_set1_epi8('A'));
+  chars = _mm_add_epi8(chars,
+                       _mm_and_si128(_mm_cmpgt_epi8(idx, _mm_set1_epi8(25)),
+                                     _mm_set1_epi8('a' - 'A' - 26)));
+  chars = _mm_add_epi8(chars,
+                       _mm_and_si128(_mm_cmpgt_epi8(idx, _mm_set1_epi8(51)),
+                                     _mm_set1_epi8('0' - 'a' - 26)));
+  chars = _mm_add_epi8(chars,
+                       _mm_and_si128(_mm_cmpgt_epi8(idx, _mm_set1_epi8(61)),
+                                     _mm_set1_epi8('+' - '0' - 10)));
+  chars = _mm_add_epi8(chars,
+                       _mm_and_si128(_mm_cmpeq_epi8(idx, _mm_set1_epi8(63)),
+                                     _mm_set1_epi8('/' - '+' - 1)));
+
+  _mm_storeu_si128((__m128i *)out, chars);
+}
+
+#endif
+
 /* Base64-encode a line, i.e. BYTES_PER_LINE bytes from DATA into
    BASE64_LINELEN chars and append it to STR.  It does not assume that
    a new line char will be appended, though.
@@ -101,6 +155,12 @@ encode_line(svn_stringbuf_t *str, const char *data)
   char *out = str->data + str->len;
   char *end = out + BASE64_LINELEN;
 
+#ifdef SVN_BASE64__SSE2
+  /* Encode 12 bytes at a time as long as they fit into the line. */
+  for ( ; end - out >= 16; in += 12, out += 16)
+    encode_block_sse2(in, out);
+#endif
+
   /* We assume that BYTES_PER_LINE is a multiple of 3 and BASE64_LINELEN
      a multiple of 4. */
   for ( ; out != end; in += 3, out += 4)
@@ -301,9 +361,14 @@ struct decode_baton {
   unsigned char buf[4];         /* Bytes waiting to be decoded */
   int buflen;                   /* Number of bytes waiting */
   svn_boolean_t done;           /* True if we already saw an '=' */
+  svn_stringbuf_t *decoded;     /* Output buffer reused between writes,
+                                   allocated in SCRATCH_POOL.  May be NULL. */
   apr_pool_t *scratch_pool;
 };
 
+/* Decoding buffers larger than this will not be kept between writes. */
+#define MAX_KEPT_DECODE_BUFFER 0x10000
+
 
 /* Base64-decode a group.  IN needs to have four bytes and OUT needs
    to have room for three bytes.  The input bytes must already have
@@ -361,6 +426,72 @@ decode_group_directly(const unsigned char *in, char *out)
   return (part0 | part1 | part2 | part3) != (unsigned char)(-1);
 }
 
+#ifdef SVN_BASE64__SSE2
+
+/* Base64-decode 16 chars from IN into 12 bytes at OUT, producing the same
+   output as four calls to decode_group_directly().  If any of the chars
+   is not part of base64tab[], return FALSE without writing to OUT.
+   Otherwise, return TRUE.  Note that this may write up to two bytes beyond
+   the 12 bytes of output. */
+static APR_INLINE svn_boolean_t
+decode_block_sse2(const char *in, char *out)
+{
+  __m128i c = _mm_loadu_si128((const __m128i *)in);
+  __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('A' - 1)),
+                                _mm_cmplt_epi8(c, _mm_set1_epi8('Z' + 1)));
+  __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('a' - 1)),
+                                _mm_cmplt_epi8(c, _mm_set1_epi8('z' + 1)));
+  __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)),
+                                _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+  __m128i plus = _mm_cmpeq_epi8(c, _mm_set1_epi8('+'));
+  __m128i slash = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+  __m128i v;
+
+  /* Chars >= 0x80 are negative and will fail all range checks. */
+  v = _mm_or_si128(_mm_or_si128(upper, lower),
+                   _mm_or_si128(_mm_or_si128(digit, plus), slash));
+  if (_mm_movemask_epi8(v) != 0xffff)
+    return FALSE;
+
+  /* Translate the chars into their 6 bit values. */
+  v = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')),
+                     _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+        _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+                     _mm_or_si128(_mm_and_si128(plus,
+                                                _mm_set1_epi8(62 - '+')),
+                                  _mm_and_si128(slash,
+                                                _mm_set1_epi8(63 - '/')))));
+  v = _mm_add_epi8(c, v);
+
+  /* Pack 4x6 bits into 24 bits per 32 bit lane, first in pairs of bytes
+     and then in pairs of 16 bit words. */
+  v = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0xff)), 6),
+                   _mm_srli_epi16(v, 8));
+  v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+
+  /* Swap bytes 0 and 2 of each lane to get them in output order. */
+  v = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 16),
+                                   _mm_set1_epi32(0xff)),
+                     _mm_and_si128(v, _mm_set1_epi32(0xff00))),
+        _mm_slli_epi32(_mm_and_si128(v, _mm_set1_epi32(0xff)), 16));
+
+  /* Close the gap between the two lanes in each 64 bit half and write
+     both halves with 6 bytes of output each. */
+  v = _mm_or_si128(_mm_and_si128(v, _mm_set_epi32(0, 0xffffff,
+                                                  0, 0xffffff)),
+                   _mm_and_si128(_mm_srli_epi64(v, 8),
+                                 _mm_set_epi32(0xffff, (int)0xff000000,
+                                               0xffff, (int)0xff000000)));
+  _mm_storel_epi64((__m128i *)out, v);
+  _mm_storel_epi64((__m128i *)(out + 6), _mm_srli_si128(v, 8));
+
+  return TRUE;
+}
+
+#endif
+
 /* Base64-encode up to BASE64_LINELEN chars from *DATA and append it to
    STR.  After the function returns, *DATA will point to the first char
    that has not been translated, yet.  Returns TRUE if all BASE64_LINELEN
@@ -379,6 +510,15 @@ decode_line(svn_stringbuf_t *str, const char **data)
   char *out = str->data + str->len;
   char *end = out + BYTES_PER_LINE;
 
+#ifdef SVN_BASE64__SSE2
+  /* Decode 16 chars at a time.  Leave room for the two extra bytes that
+     decode_block_sse2() may write; they will be overwritten later.  Upon
+     a special char, let the loop below find it. */
+  for (; end - out >= 14; p += 16, out += 12)
+    if (!decode_block_sse2((const char *)p, out))
+      break;
+#endif
+
   /* We assume that BYTES_PER_LINE is a multiple of 3 and BASE64_LINELEN
      a multiple of 4.  Stop translation as soon as we encounter a special
      char.  Leave the entire group untouched in that case. */
@@ -473,15 +613,27 @@ decode_data(void *baton, const char *data, apr_size_t *len)
   apr_size_t declen;
   svn_error_t *err = SVN_NO_ERROR;
 
-  /* Decode this block of data.  */
-  decoded = svn_stringbuf_create_empty(db->scratch_pool);
+  /* Decode this block of data.  Callers often write many small blocks,
+     so don't allocate a new buffer for each of them.  */
+  if (db->decoded)
+    svn_stringbuf_setempty(db->decoded);
+  else
+    db->decoded = svn_stringbuf_create_empty(db->scratch_pool);
+
+  decoded = db->decoded;
   decode_bytes(decoded, data, *len, db->buf, &db->buflen, &db->done);
 
   /* Write the output, clean up, go home.  */
   declen = decoded->len;
   if (declen != 0)
     err = svn_stream_write(db->output, decoded->data, &declen);
-  svn_pool_clear(db->scratch_pool);
+
+  if (decoded->blocksize > MAX_KEPT_DECODE_BUFFER)
+    {
+      db->decoded = NULL;
+      svn_pool_clear(db->scratch_pool);
+    }
+
   return err;
 }
 
@@ -509,6 +661,7 @@ svn_base64_decode(svn_stream_t *output, apr_pool_t *pool)
   db->output = output;
   db->buflen = 0;
   db->done = FALSE;
+  db->decoded = NULL;
   db->scratch_pool = svn_pool_create(pool);
   stream = svn_stream_create(db, pool);
   svn_stream_set_write(stream, decode_data);
@@ -28,6 +28,7 @@
 #include "svn_private_config.h"
 
 #include "cache.h"
+#include "private/svn_atomic.h"
 #include "private/svn_mutex.h"
 
 /* The (internal) cache object. */
@@ -81,8 +82,8 @@ typedef struct inprocess_cache_t {
 
   /* A lock for intra-process synchronization to the cache, or NULL if
    * the cache's creator doesn't feel the cache needs to be
-   * thread-safe. */
-  svn_mutex__t *mutex;
+   * thread-safe.  Lookups only need it in shared mode. */
+  svn_rwlock__t *lock;
 } inprocess_cache_t;
 
 /* A cache page; all items on the page are allocated from the same
@@ -93,6 +94,11 @@ struct cache_page {
   struct cache_page *prev;
   struct cache_page *next;
 
+  /* Set by lookups, which must not modify the LRU list because they
+   * only hold the lock in shared mode.  Pages that have this flag set
+   * get a second chance instead of being evicted. */
+  volatile svn_atomic_t referenced;
+
   /* The pool in which cache_entry structs, hash keys, and dup'd
    * values are allocated.  The CACHE_PAGE structs are allocated
    * in CACHE_POOL and have the same lifetime as the cache itself.
@@ -153,7 +159,7 @@ static svn_error_t *
 move_page_to_front(inprocess_cache_t *cache,
                    struct cache_page *page)
 {
-  /* This function is called whilst CACHE is locked. */
+  /* This function is called whilst CACHE is locked exclusively. */
 
   SVN_ERR_ASSERT(page != cache->sentinel);
 
@@ -166,6 +172,16 @@ move_page_to_front(inprocess_cache_t *cache,
   return SVN_NO_ERROR;
 }
 
+/* Remember that PAGE has been accessed.  This is safe to call while
+ * holding CACHE's lock in shared mode only. */
+static void
+mark_page_used(struct cache_page *page)
+{
+  /* Avoid needless writes to shared cache lines. */
+  if (! svn_atomic_read(&page->referenced))
+    svn_atomic_set(&page->referenced, TRUE);
+}
+
 /* Return a copy of KEY inside POOL, using CACHE->KLEN to figure out
  * how. */
 static const void *
@@ -190,7 +206,7 @@ inprocess_cache_get_internal(char **buffer,
 
   if (entry)
     {
-      SVN_ERR(move_page_to_front(cache, entry->page));
+      mark_page_used(entry->page);
 
       /* duplicate the buffer entry */
       *buffer = apr_palloc(result_pool, entry->size);
@@ -222,12 +238,12 @@ inprocess_cache_get(void **value_p,
       char* buffer;
       apr_size_t size;
 
-      SVN_MUTEX__WITH_LOCK(cache->mutex,
-                           inprocess_cache_get_internal(&buffer,
-                                                        &size,
-                                                        cache,
-                                                        key,
-                                                        result_pool));
+      SVN_RWLOCK__WITH_READ_LOCK(cache->lock,
+                                 inprocess_cache_get_internal(&buffer,
+                                                              &size,
+                                                              cache,
+                                                              key,
+                                                              result_pool));
       /* deserialize the buffer content. Usually, this will directly
          modify the buffer content directly. */
       *found = (buffer != NULL);
@@ -265,11 +281,11 @@ inprocess_cache_has_key(svn_boolean_t *found,
   inprocess_cache_t *cache = cache_void;
 
   if (key)
-    SVN_MUTEX__WITH_LOCK(cache->mutex,
-                         inprocess_cache_has_key_internal(found,
-                                                          cache,
-                                                          key,
-                                                          scratch_pool));
+    SVN_RWLOCK__WITH_READ_LOCK(cache->lock,
+                               inprocess_cache_has_key_internal(found,
+                                                                cache,
+                                                                key,
+                                                                scratch_pool));
   else
     *found = FALSE;
 
@@ -383,6 +399,16 @@ inprocess_cache_set_internal(inprocess_cache_t *cache,
 
       SVN_ERR_ASSERT(oldest_page != cache->sentinel);
 
+      /* Give pages that have been read since they were last considered
+       * another round.  This terminates as we reset the flags and
+       * readers are locked out. */
+      while (svn_atomic_read(&oldest_page->referenced))
+        {
+          svn_atomic_set(&oldest_page->referenced, FALSE);
+          SVN_ERR(move_page_to_front(cache, oldest_page));
+          oldest_page = cache->sentinel->prev;
+        }
+
       /* Erase the page and put it in cache->partial_page. */
       erase_page(cache, oldest_page);
     }
@@ -444,11 +470,11 @@ inprocess_cache_set(void *cache_void,
   inprocess_cache_t *cache = cache_void;
 
   if (key)
-    SVN_MUTEX__WITH_LOCK(cache->mutex,
-                         inprocess_cache_set_internal(cache,
-                                                      key,
-                                                      value,
-                                                      scratch_pool));
+    SVN_RWLOCK__WITH_WRITE_LOCK(cache->lock,
+                                inprocess_cache_set_internal(cache,
+                                                             key,
+                                                             value,
+                                                             scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -486,9 +512,9 @@ inprocess_cache_iter(svn_boolean_t *completed,
   b.user_cb = user_cb;
   b.user_baton = user_baton;
 
-  SVN_MUTEX__WITH_LOCK(cache->mutex,
-                       svn_iter_apr_hash(completed, cache->hash,
-                                         iter_cb, &b, scratch_pool));
+  SVN_RWLOCK__WITH_READ_LOCK(cache->lock,
+                             svn_iter_apr_hash(completed, cache->hash,
+                                               iter_cb, &b, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -503,13 +529,16 @@ inprocess_cache_get_partial_internal(void **value_p,
                                      apr_pool_t *result_pool)
 {
   struct cache_entry *entry = apr_hash_get(cache->hash, key, cache->klen);
-  if (! entry)
+
+  /* Entries that have been set to NULL are reported as missing, just as
+   * in inprocess_cache_get(). */
+  if (! entry || ! entry->value)
     {
       *found = FALSE;
       return SVN_NO_ERROR;
     }
 
-  SVN_ERR(move_page_to_front(cache, entry->page));
+  mark_page_used(entry->page);
 
   *found = TRUE;
   return func(value_p, entry->value, entry->size, baton, result_pool);
@@ -527,14 +556,10 @@ inprocess_cache_get_partial(void **value_p,
   inprocess_cache_t *cache = cache_void;
 
   if (key)
-    SVN_MUTEX__WITH_LOCK(cache->mutex,
-                         inprocess_cache_get_partial_internal(value_p,
-                                                              found,
-                                                              cache,
-                                                              key,
-                                                              func,
-                                                              baton,
-                                                              result_pool));
+    SVN_RWLOCK__WITH_READ_LOCK(cache->lock,
+                               inprocess_cache_get_partial_internal(
+                                 value_p, found, cache, key, func, baton,
+                                 result_pool));
   else
     *found = FALSE;
 
@@ -549,7 +574,7 @@ inprocess_cache_set_partial_internal(inprocess_cache_t *cache,
                                      apr_pool_t *scratch_pool)
 {
   struct cache_entry *entry = apr_hash_get(cache->hash, key, cache->klen);
-  if (entry)
+  if (entry && entry->value)
     {
       SVN_ERR(move_page_to_front(cache, entry->page));
 
@@ -574,12 +599,9 @@ inprocess_cache_set_partial(void *cache_void,
   inprocess_cache_t *cache = cache_void;
 
   if (key)
-    SVN_MUTEX__WITH_LOCK(cache->mutex,
-                         inprocess_cache_set_partial_internal(cache,
-                                                              key,
-                                                              func,
-                                                              baton,
-                                                              scratch_pool));
+    SVN_RWLOCK__WITH_WRITE_LOCK(cache->lock,
+                                inprocess_cache_set_partial_internal(
+                                  cache, key, func, baton, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -624,10 +646,10 @@ inprocess_cache_get_info(void *cache_void,
 {
   inprocess_cache_t *cache = cache_void;
 
-  SVN_MUTEX__WITH_LOCK(cache->mutex,
-                       inprocess_cache_get_info_internal(cache,
-                                                         info,
-                                                         result_pool));
+  SVN_RWLOCK__WITH_READ_LOCK(cache->lock,
+                             inprocess_cache_get_info_internal(cache,
+                                                               info,
+                                                               result_pool));
 
   return SVN_NO_ERROR;
 }
@@ -640,7 +662,8 @@ static svn_cache__vtable_t inprocess_cache_vtable = {
   inprocess_cache_is_cachable,
   inprocess_cache_get_partial,
   inprocess_cache_set_partial,
-  inprocess_cache_get_info
+  inprocess_cache_get_info,
+  NULL                  /* get_multi */
 };
 
 svn_error_t *
@@ -679,7 +702,7 @@ svn_cache__create_inprocess(svn_cache__t **cache_p,
   /* The sentinel doesn't need a pool.  (We're happy to crash if we
    * accidentally try to treat it like a real page.) */
 
-  SVN_ERR(svn_mutex__init(&cache->mutex, thread_safe, pool));
+  SVN_ERR(svn_rwlock__init(&cache->lock, thread_safe, pool));
 
   cache->cache_pool = pool;
 
@@ -25,12 +25,22 @@
 #include <apr_md5.h>
 #include <apr_thread_rwlock.h>
 
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MADVISE)
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include "svn_pools.h"
 #include "svn_checksum.h"
 #include "svn_private_config.h"
 #include "svn_hash.h"
+#include "svn_io.h"
 #include "svn_string.h"
 #include "svn_sorts.h"  /* get the MIN macro */
+#include "svn_version.h"
 
 #include "private/svn_atomic.h"
 #include "private/svn_dep_compat.h"
@@ -692,6 +702,240 @@ typedef struct cache_level_t
 
 } cache_level_t;
 
+/* Magic numbers identifying the disk tier file header as well as the
+ * two types of records in it.  They will also detect files that have been
+ * written on a platform with a different byte order.
+ */
+#define DISK_TIER_FILE_MAGIC 0x53564e43
+#define DISK_RECORD_MAGIC 0x4954454d
+#define DISK_TOMBSTONE_MAGIC 0x44454144
+
+/* Number of bytes in the disk tier file per index slot kept in memory.
+ * Each slot is 40 bytes, i.e. the index takes about 2% of the file size.
+ */
+#define DISK_TIER_BYTES_PER_SLOT 2048
+
+/* Minimum number of index slots in any disk tier.
+ */
+#define DISK_TIER_MIN_SLOTS 64
+
+/* Size of the buffer holding records waiting to be written to the disk
+ * tier.  Evicted entries may only fill the first half of it.  The rest
+ * is kept for tombstones.
+ */
+#define DISK_TIER_QUEUE_SIZE 0x100000
+
+/* Identifies the layout of the items in the disk tier.  Items are images
+ * of serialized structs, i.e. they depend on the pointer size and on the
+ * struct definitions and serializers of the respective Subversion release.
+ * Files written by any other release or pointer size will be discarded.
+ */
+#define DISK_TIER_ABI (  ((apr_uint32_t)SVN_VER_MAJOR << 24) \
+                       | ((apr_uint32_t)SVN_VER_MINOR << 16) \
+                       | ((apr_uint32_t)SVN_VER_PATCH << 8)  \
+                       | (apr_uint32_t)sizeof(void *))
+
+/* Header at the beginning of every disk tier file.  All records follow
+ * at the next ITEM_ALIGNMENT boundary.
+ */
+typedef struct disk_file_header_t
+{
+  /* Must be DISK_TIER_FILE_MAGIC. */
+  apr_uint32_t magic;
+
+  /* sizeof(disk_record_t) of the process that wrote the file. */
+  apr_uint32_t record_header_size;
+
+  /* ITEM_ALIGNMENT of the process that wrote the file. */
+  apr_uint32_t alignment;
+
+  /* DISK_TIER_ABI of the process that wrote the file. */
+  apr_uint32_t abi;
+
+  /* Set whenever the file gets initialized.  Every record carries the
+   * stamp of the file that it has been written to.  Records with any
+   * other stamp are left-overs and will be ignored. */
+  apr_uint64_t stamp;
+} disk_file_header_t;
+
+/* Header of an item written to the disk tier.  For DISK_RECORD_MAGIC, it
+ * is followed by the shared key prefix padded to ITEM_ALIGNMENT, the full
+ * key and the serialized item data - just as they would be stored in the
+ * membuffer.  Tombstones (DISK_TOMBSTONE_MAGIC) have no content.
+ */
+typedef struct disk_record_t
+{
+  /* DISK_RECORD_MAGIC or DISK_TOMBSTONE_MAGIC. */
+  apr_uint32_t magic;
+
+  /* FNV-1a checksum over the record contents following this header. */
+  apr_uint32_t checksum;
+
+  /* Records with higher sequence numbers have been written later. */
+  apr_uint64_t sequence;
+
+  /* Same as disk_file_header_t.stamp. */
+  apr_uint64_t stamp;
+
+  /* Same as entry_key_t.fingerprint. */
+  apr_uint64_t fingerprint[2];
+
+  /* Same as entry_key_t.key_len. */
+  apr_uint32_t key_len;
+
+  /* Length of the shared key prefix without padding.  0 if the key
+   * is stored in full. */
+  apr_uint32_t prefix_len;
+
+  /* Length of the serialized item data. */
+  apr_uint32_t item_size;
+
+  /* Same as entry_t.priority. */
+  apr_uint32_t priority;
+} disk_record_t;
+
+/* In-memory index entry for the latest record written to the disk tier
+ * for a given fingerprint.  Records get addressed by the fingerprint just
+ * like the entry groups of the membuffer.
+ */
+typedef struct disk_slot_t
+{
+  /* Fingerprint of the record's key. */
+  apr_uint64_t fingerprint[2];
+
+  /* Offset of the record within the file.  0 for empty slots and
+   * tombstones. */
+  apr_uint64_t offset;
+
+  /* Sequence number of the record. */
+  apr_uint64_t sequence;
+
+  /* Value of disk_tier_t.lap at the time the record has been written. */
+  apr_uint64_t lap;
+} disk_slot_t;
+
+/* Header of a record waiting in a spill_queue_t to be written to the disk
+ * tier.  For DISK_RECORD_MAGIC, it is followed by KEY.KEY_LEN bytes of
+ * full key and ITEM_SIZE bytes of serialized item data, just as they are
+ * stored in the membuffer.  Both parts start at ITEM_ALIGNMENT boundaries.
+ */
+typedef struct spill_record_t
+{
+  /* DISK_RECORD_MAGIC or DISK_TOMBSTONE_MAGIC. */
+  apr_uint32_t magic;
+
+  /* Same as entry_t.priority. */
+  apr_uint32_t priority;
+
+  /* Key of the entry.  Tombstones only use the fingerprint. */
+  entry_key_t key;
+
+  /* Shared key prefix of KEY.  NULL if KEY is a full key. */
+  const char *prefix;
+
+  /* Length of the serialized item data. */
+  apr_size_t item_size;
+
+  /* Set if the entry has been modified after it got queued.  The record
+   * must not become visible in the disk tier anymore. */
+  svn_boolean_t cancelled;
+} spill_record_t;
+
+/* Records waiting to be written to the disk tier, stored back to back.
+ */
+typedef struct spill_queue_t
+{
+  /* Buffer of disk_tier_t.queue_size bytes. */
+  unsigned char *data;
+
+  /* Number of bytes in DATA that are in use. */
+  apr_size_t used;
+} spill_queue_t;
+
+/* Optional, persistent second-level cache shared by all segments of a
+ * membuffer cache.  Entries that get evicted from the in-memory buffer
+ * are appended to a single file that is used as a ring buffer.  Later
+ * cache misses are looked up in there and promoted back into memory.
+ *
+ * Since records are only ever appended, they are valid until the write
+ * position wraps around and passes them.  LAP and CURRENT tell us whether
+ * this has happened, see disk_slot_is_valid().  Any update to an entry in
+ * the membuffer writes a tombstone record if an older copy of that entry
+ * might be in the disk tier.  Thus, the newest record for any key always
+ * reflects the latest cache content, even when the index gets rebuilt
+ * from the file contents after a restart.
+ *
+ * No file I/O happens while a cache segment is locked.  Evicted entries
+ * and tombstones get copied into the PENDING queue instead.  Whoever
+ * modified the membuffer then writes the queued records to the file
+ * after releasing the segment lock, see flush_disk_tier().  The index
+ * is updated as soon as an entry gets invalidated, so reads never see
+ * the old record even if the tombstone has not been written yet.
+ */
+typedef struct disk_tier_t
+{
+  /* The ring buffer file.  Opened for reading and writing and locked
+   * exclusively for this process. */
+  apr_file_t *file;
+
+  /* Stamp of the file, see disk_file_header_t. */
+  apr_uint64_t stamp;
+
+  /* Maximum size of the file in bytes. */
+  apr_uint64_t size;
+
+  /* Offset at which the next record will be written.  Incremented by every
+   * write and reset to the beginning of the data section upon wrap-around.
+   */
+  apr_uint64_t current;
+
+  /* Number of times CURRENT wrapped around + 1. */
+  apr_uint64_t lap;
+
+  /* Sequence number to use for the next record. */
+  apr_uint64_t next_sequence;
+
+  /* Direct-mapped index of the newest records per key fingerprint.
+   * SLOT_COUNT elements. */
+  disk_slot_t *slots;
+  apr_uint32_t slot_count;
+
+  /* Re-used checksum calculation context. */
+  svn_fnv1a_32__context_t *checksum;
+
+  /* Records to be written by the next call to flush_disk_tier(). */
+  spill_queue_t *pending;
+
+  /* Records currently being written by flush_disk_tier().  Empty if
+   * FLUSH_ACTIVE is not set. */
+  spill_queue_t *flushing;
+
+  /* Capacity of PENDING and FLUSHING in bytes. */
+  apr_size_t queue_size;
+
+  /* Set while some thread is running flush_disk_tier(). */
+  svn_boolean_t flush_active;
+
+  /* Set upon the first I/O error or when a tombstone could not be queued.
+   * The tier will not be used anymore. */
+  svn_boolean_t failed;
+
+  /* Set once the file has been emptied after FAILED got set. */
+  svn_boolean_t discarded;
+
+  /* Serializes all access to the members above except for FILE and
+   * CHECKSUM.  Only held for short periods of time and never during I/O.
+   * May be acquired while holding a lock on a cache segment. */
+  svn_mutex__t *mutex;
+
+  /* Serializes all access to FILE and CHECKSUM.  Must be acquired before
+   * MUTEX and never while holding a lock on a cache segment. */
+  svn_mutex__t *file_mutex;
+
+  /* Pool used for all tier-related allocations. */
+  apr_pool_t *pool;
+} disk_tier_t;
+
 /* The cache header structure.
  */
 struct svn_membuffer_t
@@ -767,6 +1011,12 @@ struct svn_membuffer_t
    */
   cache_level_t l2;
 
+  /* Optional disk-based cache level shared by all segments.  Items that
+   * get evicted from L1 or L2 will be written to it and read back from
+   * it upon cache misses.  NULL, if not enabled.
+   */
+  disk_tier_t *disk_tier;
+
 
   /* Number of used dictionary entries, i.e. number of cached items.
    * Purely statistical information that may be used for profiling only.
@@ -817,12 +1067,76 @@ struct svn_membuffer_t
    * This one is only used in debug assertions to verify that you used
    * the correct multi-threading settings. */
   svn_atomic_t write_lock_count;
+
+  /* Modification counter used to validate lock-free reads.  Writers
+   * increment it right after acquiring the write lock and again right
+   * before releasing it, i.e. it is odd while the segment is being
+   * modified.  A reader that sees the same even value before and after
+   * accessing the segment knows that its data is consistent. */
+  svn_atomic_t generation;
 };
 
 /* Align integer VALUE to the next ITEM_ALIGNMENT boundary.
  */
 #define ALIGN_VALUE(value) (((value) + ITEM_ALIGNMENT-1) & -ITEM_ALIGNMENT)
 
+/* Use seqlock-style lock-free reads in membuffer_cache_get.  The debug
+ * code compares the content tags of each entry, which requires a stable
+ * directory.  Without threads, there is nothing to gain. */
+#if APR_HAS_THREADS && !defined(SVN_DEBUG_CACHE_MEMBUFFER)
+#define USE_OPTIMISTIC_READS
+#endif
+
+/* Issue a full memory barrier.  APR does not provide one explicitly but
+ * its atomic compare-and-swap implies a full barrier on all platforms.
+ * Use a local variable, so we don't create contention on shared data.
+ */
+static APR_INLINE void
+memory_barrier(void)
+{
+  volatile svn_atomic_t dummy = 0;
+  svn_atomic_cas(&dummy, 0, 0);
+}
+
+/* Return the current modification generation of CACHE.  Memory accesses
+ * will not be reordered across this call.
+ */
+static APR_INLINE svn_atomic_t
+get_generation(svn_membuffer_t *cache)
+{
+  svn_atomic_t generation;
+
+  memory_barrier();
+  generation = svn_atomic_read(&cache->generation);
+  memory_barrier();
+
+  return generation;
+}
+
+/* Mark the beginning of a modification of CACHE.  The caller must hold
+ * the write lock.
+ */
+static APR_INLINE void
+begin_modification(svn_membuffer_t *cache)
+{
+  svn_atomic_inc(&cache->generation);
+  memory_barrier();
+}
+
+/* Mark the end of a modification of CACHE, if there is one in progress.
+ * Only the writer can see an odd generation while holding the lock, so
+ * this is a no-op for readers.
+ */
+static APR_INLINE void
+end_modification(svn_membuffer_t *cache)
+{
+  if (svn_atomic_read(&cache->generation) & 1)
+    {
+      memory_barrier();
+      svn_atomic_inc(&cache->generation);
+    }
+}
+
 /* If locking is supported for CACHE, acquire a read lock for it.
  */
 static svn_error_t *
@@ -852,7 +1166,10 @@ static svn_error_t *
 write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 {
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
-  return svn_mutex__lock(cache->lock);
+  SVN_ERR(svn_mutex__lock(cache->lock));
+  begin_modification(cache);
+
+  return SVN_NO_ERROR;
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
   if (cache->lock)
     {
@@ -876,6 +1193,9 @@ write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
                                   _("Can't write-lock cache mutex"));
     }
 
+  if (*success)
+    begin_modification(cache);
+
   return SVN_NO_ERROR;
 #else
   return SVN_NO_ERROR;
@@ -889,13 +1209,17 @@ static svn_error_t *
 force_write_lock_cache(svn_membuffer_t *cache)
 {
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
-  return svn_mutex__lock(cache->lock);
+  SVN_ERR(svn_mutex__lock(cache->lock));
+  begin_modification(cache);
+
+  return SVN_NO_ERROR;
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
   apr_status_t status = apr_thread_rwlock_wrlock(cache->lock);
   if (status)
     return svn_error_wrap_apr(status,
                               _("Can't write-lock cache mutex"));
 
+  begin_modification(cache);
   return SVN_NO_ERROR;
 #else
   return SVN_NO_ERROR;
@@ -909,58 +1233,943 @@ static svn_error_t *
 unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 {
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
+  end_modification(cache);
   return svn_mutex__unlock(cache->lock, err);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
+  end_modification(cache);
   if (cache->lock)
   {
     apr_status_t status = apr_thread_rwlock_unlock(cache->lock);
     if (err)
       return err;
 
-    if (status)
-      return svn_error_wrap_apr(status, _("Can't unlock cache mutex"));
-  }
+    if (status)
+      return svn_error_wrap_apr(status, _("Can't unlock cache mutex"));
+  }
+
+  return err;
+#else
+  return err;
+#endif
+}
+
+/* If supported, guard the execution of EXPR with a read lock to CACHE.
+ * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
+ */
+#define WITH_READ_LOCK(cache, expr)         \
+do {                                        \
+  SVN_ERR(read_lock_cache(cache));          \
+  SVN_ERR(unlock_cache(cache, (expr)));     \
+} while (0)
+
+/* If supported, guard the execution of EXPR with a write lock to CACHE.
+ * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
+ *
+ * The write lock process is complicated if we don't allow to wait for
+ * the lock: If we didn't get the lock, we may still need to remove an
+ * existing entry for the given key because that content is now stale.
+ * Once we discovered such an entry, we unconditionally do a blocking
+ * wait for the write lock.  In case no old content could be found, a
+ * failing lock attempt is simply a no-op and we exit the macro.
+ */
+#define WITH_WRITE_LOCK(cache, expr)                            \
+do {                                                            \
+  svn_boolean_t got_lock = TRUE;                                \
+  SVN_ERR(write_lock_cache(cache, &got_lock));                  \
+  if (!got_lock)                                                \
+    {                                                           \
+      svn_boolean_t exists;                                     \
+      SVN_ERR(entry_exists(cache, group_index, key, &exists));  \
+      if (exists)                                               \
+        SVN_ERR(force_write_lock_cache(cache));                 \
+      else                                                      \
+        break;                                                  \
+    }                                                           \
+  SVN_ERR(unlock_cache(cache, (expr)));                         \
+} while (0)
+
+/* Offset of the first record in a disk tier file.
+ */
+#define DISK_TIER_DATA_START ALIGN_VALUE(sizeof(disk_file_header_t))
+
+/* Return the slot in TIER that covers keys with the given FINGERPRINT.
+ */
+static disk_slot_t *
+get_disk_slot(disk_tier_t *tier,
+              const apr_uint64_t fingerprint[2])
+{
+  return &tier->slots[(fingerprint[0] ^ fingerprint[1]) % tier->slot_count];
+}
+
+/* Return TRUE, if SLOT in TIER references a record that has not been
+ * overwritten, yet.
+ */
+static svn_boolean_t
+disk_slot_is_valid(const disk_tier_t *tier,
+                   const disk_slot_t *slot)
+{
+  if (slot->offset == 0)
+    return FALSE;
+
+  /* Records written during the current lap are before CURRENT.
+   * Records from the previous lap survive until CURRENT passes them. */
+  return slot->lap == tier->lap
+      || (slot->lap + 1 == tier->lap && slot->offset >= tier->current);
+}
+
+/* Return TRUE, if SLOT in TIER references a valid record for KEY.
+ */
+static svn_boolean_t
+disk_slot_matches(const disk_tier_t *tier,
+                  const disk_slot_t *slot,
+                  const entry_key_t *key)
+{
+  return slot->fingerprint[0] == key->fingerprint[0]
+      && slot->fingerprint[1] == key->fingerprint[1]
+      && disk_slot_is_valid(tier, slot);
+}
+
+/* Return the total size of RECORD in the disk tier file, including all
+ * padding.  Return 0 if RECORD is not a valid record header.
+ */
+static apr_uint64_t
+disk_record_size(const disk_record_t *record)
+{
+  if (record->magic == DISK_TOMBSTONE_MAGIC)
+    return ALIGN_VALUE(sizeof(*record));
+
+  if (record->magic != DISK_RECORD_MAGIC)
+    return 0;
+
+  return ALIGN_VALUE(  sizeof(*record)
+                     + ALIGN_VALUE((apr_uint64_t)record->prefix_len)
+                     + record->key_len
+                     + (apr_uint64_t)record->item_size);
+}
+
+/* Make RECORD, found at OFFSET in TIER's file, the latest one for its
+ * fingerprint, unless a newer one has already been found.
+ * To be used while rebuilding the index from the file contents.
+ */
+static void
+index_disk_record(disk_tier_t *tier,
+                  const disk_record_t *record,
+                  apr_uint64_t offset)
+{
+  disk_slot_t *slot = get_disk_slot(tier, record->fingerprint);
+  if (slot->sequence >= record->sequence)
+    return;
+
+  slot->fingerprint[0] = record->fingerprint[0];
+  slot->fingerprint[1] = record->fingerprint[1];
+  slot->sequence = record->sequence;
+  slot->offset = record->magic == DISK_TOMBSTONE_MAGIC ? 0 : offset;
+}
+
+/* Rebuild the index of TIER from the first FILE_SIZE bytes of its file.
+ * Set the insertion position right behind the newest record found.
+ * Records that don't carry TIER's stamp will be ignored.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+load_disk_tier(disk_tier_t *tier,
+               apr_uint64_t file_size,
+               apr_pool_t *scratch_pool)
+{
+  apr_uint64_t offset = DISK_TIER_DATA_START;
+  apr_uint64_t newest_sequence = 0;
+  apr_uint64_t newest_end = DISK_TIER_DATA_START;
+  apr_uint32_t i;
+
+  while (offset + sizeof(disk_record_t) <= file_size)
+    {
+      disk_record_t record;
+      apr_uint64_t record_size;
+      apr_off_t file_offset = (apr_off_t)offset;
+
+      SVN_ERR(svn_io_file_seek(tier->file, APR_SET, &file_offset,
+                               scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(tier->file, &record, sizeof(record),
+                                     NULL, NULL, scratch_pool));
+
+      /* A record may have been partially overwritten by a newer one.
+       * In that case, scan for the next valid record header. */
+      record_size = disk_record_size(&record);
+      if (   record_size == 0
+          || record.stamp != tier->stamp
+          || offset + record_size > file_size)
+        {
+          offset += ITEM_ALIGNMENT;
+          continue;
+        }
+
+      index_disk_record(tier, &record, offset);
+      if (record.sequence > newest_sequence)
+        {
+          newest_sequence = record.sequence;
+          newest_end = offset + record_size;
+        }
+
+      offset += record_size;
+    }
+
+  tier->current = newest_end;
+  tier->next_sequence = newest_sequence + 1;
+
+  /* Everything before CURRENT has been written during the latest lap. */
+  tier->lap = 2;
+  for (i = 0; i < tier->slot_count; ++i)
+    tier->slots[i].lap = tier->slots[i].offset < tier->current ? 2 : 1;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the number of bytes that RECORD takes up in a spill_queue_t.
+ */
+static apr_size_t
+spill_record_size(const spill_record_t *record)
+{
+  apr_size_t size = ALIGN_VALUE(sizeof(*record));
+  if (record->magic == DISK_RECORD_MAGIC)
+    size += ALIGN_VALUE(record->key.key_len + record->item_size);
+
+  return size;
+}
+
+/* Mark all records for KEY in QUEUE as cancelled.  If KEY is NULL, cancel
+ * all records.
+ *
+ * Note: This function requires the caller to hold the MUTEX of the disk
+ * tier that QUEUE belongs to.
+ */
+static void
+cancel_spill_records(spill_queue_t *queue,
+                     const entry_key_t *key)
+{
+  apr_size_t offset;
+  for (offset = 0; offset < queue->used; )
+    {
+      spill_record_t *record = (spill_record_t *)(queue->data + offset);
+      if (   key == NULL
+          || (   record->key.fingerprint[0] == key->fingerprint[0]
+              && record->key.fingerprint[1] == key->fingerprint[1]))
+        record->cancelled = TRUE;
+
+      offset += spill_record_size(record);
+    }
+}
+
+/* Return TRUE, if QUEUE contains a record with DISK_RECORD_MAGIC for KEY
+ * that has not been cancelled.
+ *
+ * Note: This function requires the caller to hold the MUTEX of the disk
+ * tier that QUEUE belongs to.
+ */
+static svn_boolean_t
+spill_record_queued(const spill_queue_t *queue,
+                    const entry_key_t *key)
+{
+  apr_size_t offset;
+  for (offset = 0; offset < queue->used; )
+    {
+      const spill_record_t *record
+        = (const spill_record_t *)(queue->data + offset);
+      if (   record->magic == DISK_RECORD_MAGIC
+          && !record->cancelled
+          && record->key.fingerprint[0] == key->fingerprint[0]
+          && record->key.fingerprint[1] == key->fingerprint[1])
+        return TRUE;
+
+      offset += spill_record_size(record);
+    }
+
+  return FALSE;
+}
+
+/* Append a record with MAGIC for KEY to the pending queue of TIER.  For
+ * DISK_RECORD_MAGIC, PREFIX is the shared key prefix (NULL if KEY uses a
+ * full key) and DATA contains KEY->KEY_LEN bytes of full key followed by
+ * ITEM_SIZE bytes of serialized item with PRIORITY.  Return FALSE if there
+ * was not enough room left in the queue.
+ *
+ * Note: This function requires the caller to hold the TIER->MUTEX.
+ */
+static svn_boolean_t
+queue_spill_record(disk_tier_t *tier,
+                   apr_uint32_t magic,
+                   const entry_key_t *key,
+                   const char *prefix,
+                   const void *data,
+                   apr_size_t item_size,
+                   apr_uint32_t priority)
+{
+  spill_queue_t *queue = tier->pending;
+  spill_record_t *record;
+  apr_size_t data_size = 0;
+  apr_size_t limit = tier->queue_size;
+
+  if (magic == DISK_RECORD_MAGIC)
+    {
+      data_size = key->key_len + item_size;
+      limit /= 2;
+    }
+
+  if (ALIGN_VALUE(sizeof(*record)) + ALIGN_VALUE(data_size)
+      > limit - MIN(queue->used, limit))
+    return FALSE;
+
+  record = (spill_record_t *)(queue->data + queue->used);
+  record->magic = magic;
+  record->priority = priority;
+  record->key = *key;
+  record->prefix = prefix;
+  record->item_size = magic == DISK_RECORD_MAGIC ? item_size : 0;
+  record->cancelled = FALSE;
+
+  if (data_size)
+    memcpy((unsigned char *)record + ALIGN_VALUE(sizeof(*record)), data,
+           data_size);
+
+  queue->used += spill_record_size(record);
+  return TRUE;
+}
+
+/* Forget about all contents of TIER, including the records waiting to be
+ * written, and give it a new stamp.
+ *
+ * Note: This function requires the caller to hold the TIER->MUTEX.
+ */
+static svn_error_t *
+reset_disk_index(disk_tier_t *tier)
+{
+  tier->stamp = MAX((apr_uint64_t)apr_time_now(), tier->stamp + 1);
+
+  memset(tier->slots, 0, tier->slot_count * sizeof(*tier->slots));
+  tier->current = DISK_TIER_DATA_START;
+  tier->lap = 1;
+
+  tier->pending->used = 0;
+  cancel_spill_records(tier->flushing, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Empty the file of TIER and reset the index.
+ * Use SCRATCH_POOL for temporary allocations.
+ *
+ * Note: This function requires the caller to hold the TIER->FILE_MUTEX.
+ */
+static svn_error_t *
+reset_disk_tier(disk_tier_t *tier,
+                apr_pool_t *scratch_pool)
+{
+  disk_file_header_t header = { 0 };
+  apr_off_t offset = 0;
+
+  SVN_MUTEX__WITH_LOCK(tier->mutex, reset_disk_index(tier));
+
+  header.magic = DISK_TIER_FILE_MAGIC;
+  header.record_header_size = sizeof(disk_record_t);
+  header.alignment = ITEM_ALIGNMENT;
+  header.abi = DISK_TIER_ABI;
+  header.stamp = tier->stamp;
+
+  SVN_ERR(svn_io_file_trunc(tier->file, 0, scratch_pool));
+  SVN_ERR(svn_io_file_seek(tier->file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(tier->file, &header, sizeof(header), NULL,
+                                 scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Mark TIER as unusable if ERR is set.  Return ERR.
+ */
+static svn_error_t *
+check_disk_tier(disk_tier_t *tier,
+                svn_error_t *err)
+{
+  if (err)
+    tier->failed = TRUE;
+
+  return err;
+}
+
+/* Initialize *HEADER for the queued RECORD and reserve space for it in
+ * the file of TIER.  Set *POSITION to the offset within the file and *LAP
+ * to the lap of the record.  Set *POSITION to 0, if the record shall not
+ * be written.
+ *
+ * Note: This function requires the caller to hold the TIER->MUTEX.
+ */
+static svn_error_t *
+reserve_disk_record(apr_uint64_t *position,
+                    apr_uint64_t *lap,
+                    disk_record_t *header,
+                    disk_tier_t *tier,
+                    const spill_record_t *record)
+{
+  apr_uint64_t record_size;
+
+  *position = 0;
+  if (tier->failed || record->cancelled)
+    return SVN_NO_ERROR;
+
+  /* Don't write the same entry twice. */
+  if (   record->magic == DISK_RECORD_MAGIC
+      && disk_slot_matches(tier, get_disk_slot(tier, record->key.fingerprint),
+                           &record->key))
+    return SVN_NO_ERROR;
+
+  memset(header, 0, sizeof(*header));
+  header->magic = record->magic;
+  header->stamp = tier->stamp;
+  header->fingerprint[0] = record->key.fingerprint[0];
+  header->fingerprint[1] = record->key.fingerprint[1];
+  if (record->magic == DISK_RECORD_MAGIC)
+    {
+      header->key_len = (apr_uint32_t)record->key.key_len;
+      header->prefix_len = record->prefix
+                         ? (apr_uint32_t)strlen(record->prefix)
+                         : 0;
+      header->item_size = (apr_uint32_t)record->item_size;
+      header->priority = record->priority;
+    }
+
+  /* Very large items would flush large parts of the disk tier.
+   * Don't store them. */
+  record_size = disk_record_size(header);
+  if (record_size > (tier->size - DISK_TIER_DATA_START) / 4)
+    return SVN_NO_ERROR;
+
+  /* Wrap around at the end of the file.  Moving CURRENT ahead right away
+   * invalidates the records that we are about to overwrite. */
+  if (tier->current + record_size > tier->size)
+    {
+      tier->current = DISK_TIER_DATA_START;
+      tier->lap++;
+    }
+
+  header->sequence = tier->next_sequence++;
+  *position = tier->current;
+  *lap = tier->lap;
+  tier->current += record_size;
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the record with HEADER at POSITION to the file of TIER.  HEADER's
+ * checksum will be set.  For DISK_RECORD_MAGIC, PREFIX is the shared key
+ * prefix (NULL if the key is stored in full) and DATA contains the full
+ * key followed by the serialized item.
+ * Use SCRATCH_POOL for temporary allocations.
+ *
+ * Note: This function requires the caller to hold the TIER->FILE_MUTEX.
+ */
+static svn_error_t *
+write_disk_record(disk_tier_t *tier,
+                  disk_record_t *header,
+                  apr_uint64_t position,
+                  const char *prefix,
+                  const void *data,
+                  apr_pool_t *scratch_pool)
+{
+  static const char padding[ITEM_ALIGNMENT] = { 0 };
+
+  apr_size_t prefix_len = header->prefix_len;
+  apr_size_t data_size = header->key_len + header->item_size;
+  apr_uint64_t record_size = disk_record_size(header);
+  apr_uint64_t content_end;
+  apr_off_t offset;
+
+  /* Checksum the contents just as they will be read back. */
+  svn_fnv1a_32__context_reset(tier->checksum);
+  if (prefix_len)
+    {
+      svn_fnv1a_32__update(tier->checksum, prefix, prefix_len);
+      svn_fnv1a_32__update(tier->checksum, padding,
+                           ALIGN_VALUE(prefix_len) - prefix_len);
+    }
+  if (data_size)
+    svn_fnv1a_32__update(tier->checksum, data, data_size);
+  header->checksum = svn_fnv1a_32__finalize(tier->checksum);
+
+  offset = (apr_off_t)position;
+  SVN_ERR(svn_io_file_seek(tier->file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(tier->file, header, sizeof(*header), NULL,
+                                 scratch_pool));
+  content_end = position + sizeof(*header);
+
+  if (prefix_len)
+    {
+      SVN_ERR(svn_io_file_write_full(tier->file, prefix, prefix_len, NULL,
+                                     scratch_pool));
+      SVN_ERR(svn_io_file_write_full(tier->file, padding,
+                                     ALIGN_VALUE(prefix_len) - prefix_len,
+                                     NULL, scratch_pool));
+      content_end += ALIGN_VALUE(prefix_len);
+    }
+
+  if (data_size)
+    SVN_ERR(svn_io_file_write_full(tier->file, data, data_size, NULL,
+                                   scratch_pool));
+  content_end += data_size;
+
+  SVN_ERR(svn_io_file_write_full(tier->file, padding,
+                                 (apr_size_t)(position + record_size
+                                              - content_end),
+                                 NULL, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Make the record with HEADER that has been written at POSITION during
+ * LAP the latest one for its key in TIER - unless RECORD has been
+ * cancelled in the meantime.  In that case, set *OBSOLETE.
+ *
+ * Note: This function requires the caller to hold the TIER->MUTEX.
+ */
+static svn_error_t *
+publish_disk_record(svn_boolean_t *obsolete,
+                    disk_tier_t *tier,
+                    const disk_record_t *header,
+                    apr_uint64_t position,
+                    apr_uint64_t lap,
+                    const spill_record_t *record)
+{
+  disk_slot_t *slot = get_disk_slot(tier, header->fingerprint);
+
+  *obsolete = record->cancelled;
+  if (*obsolete)
+    return SVN_NO_ERROR;
+
+  slot->fingerprint[0] = header->fingerprint[0];
+  slot->fingerprint[1] = header->fingerprint[1];
+  slot->offset = position;
+  slot->sequence = header->sequence;
+  slot->lap = lap;
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the queued RECORD with DATA to TIER.  Errors will be ignored and
+ * simply disable the disk tier.
+ *
+ * Note: This function requires the caller to hold the TIER->FILE_MUTEX.
+ */
+static svn_error_t *
+write_spill_record(disk_tier_t *tier,
+                   const spill_record_t *record,
+                   const void *data)
+{
+  disk_record_t header;
+  apr_uint64_t position;
+  apr_uint64_t lap;
+  svn_boolean_t obsolete;
+  spill_record_t tombstone;
+  svn_error_t *err;
+
+  SVN_MUTEX__WITH_LOCK(tier->mutex,
+                       reserve_disk_record(&position, &lap, &header, tier,
+                                           record));
+  if (position == 0)
+    return SVN_NO_ERROR;
+
+  err = check_disk_tier(tier, write_disk_record(tier, &header, position,
+                                                record->prefix, data,
+                                                tier->pool));
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  /* Tombstones only need to be on disk.  The index has been updated when
+   * they were queued. */
+  if (record->magic != DISK_RECORD_MAGIC)
+    return SVN_NO_ERROR;
+
+  SVN_MUTEX__WITH_LOCK(tier->mutex,
+                       publish_disk_record(&obsolete, tier, &header,
+                                           position, lap, record));
+
+  /* The entry got modified while we were writing it.  Make sure that this
+   * record will not come back after a restart. */
+  if (obsolete)
+    {
+      tombstone = *record;
+      tombstone.magic = DISK_TOMBSTONE_MAGIC;
+      tombstone.prefix = NULL;
+      tombstone.item_size = 0;
+      tombstone.cancelled = FALSE;
+
+      SVN_ERR(write_spill_record(tier, &tombstone, NULL));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write all records in QUEUE to TIER.
+ *
+ * Note: This function requires the caller to hold the TIER->FILE_MUTEX.
+ */
+static svn_error_t *
+write_spill_queue(disk_tier_t *tier,
+                  const spill_queue_t *queue)
+{
+  apr_size_t offset;
+  for (offset = 0; offset < queue->used; )
+    {
+      const spill_record_t *record
+        = (const spill_record_t *)(queue->data + offset);
+      SVN_ERR(write_spill_record(tier, record,
+                                 (const unsigned char *)record
+                                   + ALIGN_VALUE(sizeof(*record))));
+
+      offset += spill_record_size(record);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Empty the file of TIER after it failed.  It may contain records that
+ * should have been invalidated and must not show up after a restart.
+ *
+ * Note: This function requires the caller to hold the TIER->FILE_MUTEX.
+ */
+static svn_error_t *
+discard_disk_tier(disk_tier_t *tier)
+{
+  svn_error_clear(svn_io_file_trunc(tier->file, 0, tier->pool));
+  return SVN_NO_ERROR;
+}
+
+/* If TIER may contain a copy of the entry with KEY, make sure it will not
+ * be returned anymore - even after a restart.  Copies still waiting to be
+ * written will be dropped.
+ *
+ * Note: This function requires the caller to hold the TIER->MUTEX.
+ */
+static svn_error_t *
+invalidate_on_disk_internal(disk_tier_t *tier,
+                            const entry_key_t *key)
+{
+  disk_slot_t *slot = get_disk_slot(tier, key->fingerprint);
+
+  cancel_spill_records(tier->pending, key);
+  cancel_spill_records(tier->flushing, key);
+
+  if (tier->failed || !disk_slot_matches(tier, slot, key))
+    return SVN_NO_ERROR;
+
+  /* Hide the old record right away.  The tombstone keeps it hidden after
+   * a restart.  If we can't write one, the tier must not be used again. */
+  slot->offset = 0;
+  if (!queue_spill_record(tier, DISK_TOMBSTONE_MAGIC, key, NULL, NULL, 0, 0))
+    tier->failed = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *FOUND to TRUE, if TIER contains a valid record for KEY.  If
+ * SEQUENCE is not 0, the record must also have that sequence number.
+ * Otherwise, records waiting to be written count as well.
+ *
+ * Note: This function requires the caller to hold the TIER->MUTEX.
+ */
+static svn_error_t *
+disk_entry_exists_internal(svn_boolean_t *found,
+                           disk_tier_t *tier,
+                           const entry_key_t *key,
+                           apr_uint64_t sequence)
+{
+  disk_slot_t *slot = get_disk_slot(tier, key->fingerprint);
+  *found = !tier->failed
+        && disk_slot_matches(tier, slot, key)
+        && (sequence == 0 || slot->sequence == sequence);
+
+  if (!*found && !tier->failed && sequence == 0)
+    *found = spill_record_queued(tier->pending, key)
+          || spill_record_queued(tier->flushing, key);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *POSITION and *SEQUENCE to the offset and sequence number of the
+ * latest record for KEY in TIER.  Set *POSITION to 0, if there is none.
+ *
+ * Note: This function requires the caller to hold the TIER->MUTEX.
+ */
+static svn_error_t *
+find_disk_record(apr_uint64_t *position,
+                 apr_uint64_t *sequence,
+                 disk_tier_t *tier,
+                 const entry_key_t *key)
+{
+  disk_slot_t *slot = get_disk_slot(tier, key->fingerprint);
+
+  *position = 0;
+  if (!tier->failed && disk_slot_matches(tier, slot, key))
+    {
+      *position = slot->offset;
+      *sequence = slot->sequence;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Look for the entry identified by TO_FIND with the shared key PREFIX
+ * (NULL if TO_FIND is a full key) in TIER.  If it exists, return a copy
+ * of its serialized data in *BUFFER, its size in *ITEM_SIZE, its priority
+ * in *PRIORITY and the sequence number of the record in *SEQUENCE.
+ * Otherwise, set *BUFFER to NULL.  Allocate the result in RESULT_POOL.
+ *
+ * Note: This function requires the caller to hold the TIER->FILE_MUTEX.
+ */
+static svn_error_t *
+read_from_disk_internal(char **buffer,
+                        apr_size_t *item_size,
+                        apr_uint32_t *priority,
+                        apr_uint64_t *sequence,
+                        disk_tier_t *tier,
+                        const full_key_t *to_find,
+                        const char *prefix,
+                        apr_pool_t *result_pool)
+{
+  const entry_key_t *key = &to_find->entry_key;
+  apr_size_t prefix_len = prefix ? strlen(prefix) : 0;
+  disk_record_t record;
+  apr_uint64_t position;
+  apr_uint64_t expected_sequence;
+  apr_size_t content_size;
+  apr_off_t offset;
+  char *content;
+
+  *buffer = NULL;
+  SVN_MUTEX__WITH_LOCK(tier->mutex,
+                       find_disk_record(&position, &expected_sequence, tier,
+                                        key));
+  if (position == 0)
+    return SVN_NO_ERROR;
+
+  offset = (apr_off_t)position;
+  SVN_ERR(svn_io_file_seek(tier->file, APR_SET, &offset, result_pool));
+  SVN_ERR(svn_io_file_read_full2(tier->file, &record, sizeof(record),
+                                 NULL, NULL, result_pool));
+
+  /* Is this the record that we expect?  Then, the contents should be
+   * complete, too. */
+  if (   record.magic != DISK_RECORD_MAGIC
+      || record.sequence != expected_sequence
+      || record.stamp != tier->stamp
+      || record.fingerprint[0] != key->fingerprint[0]
+      || record.fingerprint[1] != key->fingerprint[1]
+      || record.key_len != key->key_len
+      || record.prefix_len != prefix_len)
+    return SVN_NO_ERROR;
+
+  content_size = (apr_size_t)(disk_record_size(&record) - sizeof(record));
+  content = apr_palloc(result_pool, content_size);
+  SVN_ERR(svn_io_file_read_full2(tier->file, content, content_size,
+                                 NULL, NULL, result_pool));
+
+  /* Verify contents and full keys. */
+  svn_fnv1a_32__context_reset(tier->checksum);
+  svn_fnv1a_32__update(tier->checksum, content,
+                         ALIGN_VALUE(prefix_len) + record.key_len
+                       + record.item_size);
+  if (record.checksum != svn_fnv1a_32__finalize(tier->checksum))
+    return SVN_NO_ERROR;
+
+  if (prefix_len && memcmp(content, prefix, prefix_len))
+    return SVN_NO_ERROR;
+
+  content += ALIGN_VALUE(prefix_len);
+  if (key->key_len && memcmp(content, to_find->full_key.data, key->key_len))
+    return SVN_NO_ERROR;
+
+  *buffer = content + key->key_len;
+  *item_size = record.item_size;
+  *priority = record.priority;
+  *sequence = record.sequence;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the shared key prefix for KEY in CACHE or NULL if KEY is a full
+ * key.
+ */
+static const char *
+get_shared_prefix(svn_membuffer_t *cache,
+                  const entry_key_t *key)
+{
+  return key->prefix_idx == NO_INDEX
+       ? NULL
+       : cache->prefix_pool->values[key->prefix_idx];
+}
+
+/* If CACHE has a disk tier, queue the contents of ENTRY to be written to
+ * it before it gets evicted from memory.  This is a best-effort operation.
+ * The caller must call flush_disk_tier() after releasing the lock on
+ * CACHE.
+ */
+static void
+spill_entry(svn_membuffer_t *cache,
+            entry_t *entry)
+{
+  disk_tier_t *tier = cache->disk_tier;
+  svn_error_t *err;
+
+  /* Low-prio data is cheap to reconstruct. */
+  if (   tier == NULL
+      || tier->failed
+      || entry->priority <= SVN_CACHE__MEMBUFFER_LOW_PRIORITY)
+    return;
+
+  err = svn_mutex__lock(tier->mutex);
+  if (!err)
+    {
+      if (   !tier->failed
+          && !disk_slot_matches(tier,
+                                get_disk_slot(tier, entry->key.fingerprint),
+                                &entry->key))
+        queue_spill_record(tier, DISK_RECORD_MAGIC, &entry->key,
+                           get_shared_prefix(cache, &entry->key),
+                           cache->data + entry->offset,
+                           entry->size - entry->key.key_len,
+                           entry->priority);
+
+      err = svn_mutex__unlock(tier->mutex, SVN_NO_ERROR);
+    }
+
+  svn_error_clear(err);
+}
+
+/* If CACHE has a disk tier, make sure that any copy of the entry with KEY
+ * in it becomes invisible.  The caller is about to modify that entry and
+ * must call flush_disk_tier() after releasing the lock on CACHE.
+ */
+static svn_error_t *
+invalidate_on_disk(svn_membuffer_t *cache,
+                   const entry_key_t *key)
+{
+  disk_tier_t *tier = cache->disk_tier;
+  if (tier)
+    SVN_MUTEX__WITH_LOCK(tier->mutex,
+                         invalidate_on_disk_internal(tier, key));
+
+  return SVN_NO_ERROR;
+}
+
+/* If CACHE has a disk tier, write all records queued for it.  If some
+ * other thread is already doing that, return immediately.  That thread
+ * will pick up our records as well.  Write errors will be ignored and
+ * simply disable the disk tier.
+ *
+ * This must not be called while holding a lock on any cache segment.
+ */
+static svn_error_t *
+flush_disk_tier(svn_membuffer_t *cache)
+{
+  disk_tier_t *tier = cache->disk_tier;
+  spill_queue_t *queue;
+  svn_boolean_t discard;
+  svn_error_t *err;
+  svn_error_t *lock_err;
+
+  if (tier == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(tier->mutex));
+  if (tier->flush_active)
+    return svn_error_trace(svn_mutex__unlock(tier->mutex, SVN_NO_ERROR));
+
+  tier->flush_active = TRUE;
+  while (tier->pending->used || (tier->failed && !tier->discarded))
+    {
+      queue = tier->pending;
+      tier->pending = tier->flushing;
+      tier->flushing = queue;
+
+      discard = tier->failed;
+      tier->discarded = tier->failed;
+      SVN_ERR(svn_mutex__unlock(tier->mutex, SVN_NO_ERROR));
+
+      err = svn_mutex__lock(tier->file_mutex);
+      if (!err)
+        err = svn_mutex__unlock(tier->file_mutex,
+                                discard ? discard_disk_tier(tier)
+                                        : write_spill_queue(tier, queue));
+
+      lock_err = svn_mutex__lock(tier->mutex);
+      if (lock_err)
+        return svn_error_compose_create(err, lock_err);
+
+      queue->used = 0;
+
+      /* Even upon failure, let the next caller flush the tier again. */
+      if (err)
+        {
+          tier->flush_active = FALSE;
+          return svn_error_trace(svn_mutex__unlock(tier->mutex, err));
+        }
+    }
+
+  tier->flush_active = FALSE;
+  return svn_error_trace(svn_mutex__unlock(tier->mutex, SVN_NO_ERROR));
+}
+
+/* Set *FOUND to TRUE if CACHE has a disk tier that contains a valid record
+ * for KEY and, if SEQUENCE is not 0, that record has that SEQUENCE number.
+ */
+static svn_error_t *
+disk_entry_exists(svn_boolean_t *found,
+                  svn_membuffer_t *cache,
+                  const entry_key_t *key,
+                  apr_uint64_t sequence)
+{
+  disk_tier_t *tier = cache->disk_tier;
+
+  *found = FALSE;
+  if (tier)
+    SVN_MUTEX__WITH_LOCK(tier->mutex,
+                         disk_entry_exists_internal(found, tier, key,
+                                                    sequence));
 
-  return err;
-#else
-  return err;
-#endif
+  return SVN_NO_ERROR;
 }
 
-/* If supported, guard the execution of EXPR with a read lock to CACHE.
- * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
+/* Wrapper around read_from_disk_internal, called for CACHE.  Read errors
+ * will be ignored and simply disable the disk tier.
  */
-#define WITH_READ_LOCK(cache, expr)         \
-do {                                        \
-  SVN_ERR(read_lock_cache(cache));          \
-  SVN_ERR(unlock_cache(cache, (expr)));     \
-} while (0)
+static svn_error_t *
+read_from_disk(char **buffer,
+               apr_size_t *item_size,
+               apr_uint32_t *priority,
+               apr_uint64_t *sequence,
+               svn_membuffer_t *cache,
+               const full_key_t *to_find,
+               apr_pool_t *result_pool)
+{
+  disk_tier_t *tier = cache->disk_tier;
+  svn_error_t *err;
 
-/* If supported, guard the execution of EXPR with a write lock to CACHE.
- * The macro has been modeled after SVN_MUTEX__WITH_LOCK.
- *
- * The write lock process is complicated if we don't allow to wait for
- * the lock: If we didn't get the lock, we may still need to remove an
- * existing entry for the given key because that content is now stale.
- * Once we discovered such an entry, we unconditionally do a blocking
- * wait for the write lock.  In case no old content could be found, a
- * failing lock attempt is simply a no-op and we exit the macro.
- */
-#define WITH_WRITE_LOCK(cache, expr)                            \
-do {                                                            \
-  svn_boolean_t got_lock = TRUE;                                \
-  SVN_ERR(write_lock_cache(cache, &got_lock));                  \
-  if (!got_lock)                                                \
-    {                                                           \
-      svn_boolean_t exists;                                     \
-      SVN_ERR(entry_exists(cache, group_index, key, &exists));  \
-      if (exists)                                               \
-        SVN_ERR(force_write_lock_cache(cache));                 \
-      else                                                      \
-        break;                                                  \
-    }                                                           \
-  SVN_ERR(unlock_cache(cache, (expr)));                         \
-} while (0)
+  *buffer = NULL;
+  if (tier == NULL || tier->failed)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(tier->file_mutex));
+  err = check_disk_tier(tier,
+                        read_from_disk_internal(buffer, item_size, priority,
+                                                sequence, tier, to_find,
+                                                get_shared_prefix(cache,
+                                                      &to_find->entry_key),
+                                                result_pool));
+  if (err)
+    *buffer = NULL;
+  svn_error_clear(err);
+
+  return svn_error_trace(svn_mutex__unlock(tier->file_mutex, SVN_NO_ERROR));
+}
 
 /* Returns 0 if the entry group identified by GROUP_INDEX in CACHE has not
  * been initialized, yet. In that case, this group can not data. Otherwise,
@@ -1538,6 +2747,7 @@ find_entry(svn_membuffer_t *cache,
             if (entry != &to_shrink->entries[i])
               let_entry_age(cache, &to_shrink->entries[i]);
 
+          spill_entry(cache, entry);
           drop_entry(cache, entry);
         }
 
@@ -1755,6 +2965,7 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
               if (entry->priority > SVN_CACHE__MEMBUFFER_LOW_PRIORITY)
                 drop_hits += entry->hit_count * (apr_uint64_t)entry->priority;
 
+              spill_entry(cache, entry);
               drop_entry(cache, entry);
             }
         }
@@ -1821,9 +3032,14 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
           if (entry_index == cache->l1.next)
             {
               if (keep)
-                promote_entry(cache, entry);
+                {
+                  promote_entry(cache, entry);
+                }
               else
-                drop_entry(cache, entry);
+                {
+                  spill_entry(cache, entry);
+                  drop_entry(cache, entry);
+                }
             }
         }
     }
@@ -1832,6 +3048,93 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
    * right answer. */
 }
 
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MADVISE) && defined(MAP_ANONYMOUS)
+
+/* Huge pages on x86 and most other platforms are 2MB.  Mappings get
+ * rounded up to a multiple of this size.
+ */
+#define HUGE_PAGE_SIZE 0x200000
+
+/* The memory policy that spreads pages round-robin over a set of NUMA
+ * nodes, as defined by the Linux kernel ABI.
+ */
+#define MPOL_INTERLEAVE_POLICY 3
+
+/* A mapping created by allocate_segment_memory().
+ */
+typedef struct segment_mapping_t
+{
+  void *start;
+  apr_size_t size;
+} segment_mapping_t;
+
+/* Pool cleanup function unmapping the segment_mapping_t * DATA.
+ */
+static apr_status_t
+unmap_segment_memory(void *data)
+{
+  segment_mapping_t *mapping = data;
+  munmap(mapping->start, mapping->size);
+
+  return APR_SUCCESS;
+}
+
+#endif
+
+/* Return SIZE bytes of memory for a cache segment, allocated in POOL or
+ * tied to its lifetime.  The memory will not be initialized.
+ *
+ * If HUGE_PAGES is set, ask the OS to back the memory with huge pages to
+ * reduce TLB misses.  If NUMA_INTERLEAVE is set, ask it to spread the
+ * pages evenly over all NUMA nodes, so no single node's memory bandwidth
+ * becomes a bottleneck.  Both are only hints.  Return NULL if we are OOM.
+ */
+static void *
+allocate_segment_memory(apr_size_t size,
+                        svn_boolean_t huge_pages,
+                        svn_boolean_t numa_interleave,
+                        apr_pool_t *pool)
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MADVISE) && defined(MAP_ANONYMOUS)
+  if (huge_pages || numa_interleave)
+    {
+      segment_mapping_t *mapping = apr_palloc(pool, sizeof(*mapping));
+
+      /* Anonymous mappings get populated page by page upon first access,
+       * so the policies below apply before any memory gets committed. */
+      mapping->size = (size + HUGE_PAGE_SIZE - 1)
+                    & ~(apr_size_t)(HUGE_PAGE_SIZE - 1);
+      mapping->start = mmap(NULL, mapping->size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (mapping->start != MAP_FAILED)
+        {
+#ifdef MADV_HUGEPAGE
+          if (huge_pages)
+            madvise(mapping->start, mapping->size, MADV_HUGEPAGE);
+#endif
+#ifdef SYS_mbind
+          if (numa_interleave)
+            {
+              /* All nodes.  The kernel ignores those that don't exist or
+               * that we are not allowed to use. */
+              unsigned long nodes = ~0UL;
+              syscall(SYS_mbind, mapping->start, mapping->size,
+                      MPOL_INTERLEAVE_POLICY, &nodes, 8 * sizeof(nodes), 0);
+            }
+#endif
+
+          apr_pool_cleanup_register(pool, mapping, unmap_segment_memory,
+                                    apr_pool_cleanup_null);
+          return mapping->start;
+        }
+
+      /* Fall back to the standard allocation. */
+    }
+#endif
+
+  return apr_palloc(pool, size);
+}
+
 svn_error_t *
 svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   apr_size_t total_size,
@@ -1840,6 +3143,23 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   svn_boolean_t thread_safe,
                                   svn_boolean_t allow_blocking_writes,
                                   apr_pool_t *pool)
+{
+  return svn_error_trace(svn_cache__membuffer_cache_create2(
+                           cache, total_size, directory_size, segment_count,
+                           thread_safe, allow_blocking_writes, FALSE, FALSE,
+                           pool));
+}
+
+svn_error_t *
+svn_cache__membuffer_cache_create2(svn_membuffer_t **cache,
+                                   apr_size_t total_size,
+                                   apr_size_t directory_size,
+                                   apr_size_t segment_count,
+                                   svn_boolean_t thread_safe,
+                                   svn_boolean_t allow_blocking_writes,
+                                   svn_boolean_t huge_pages,
+                                   svn_boolean_t numa_interleave,
+                                   apr_pool_t *pool)
 {
   svn_membuffer_t *c;
   prefix_pool_t *prefix_pool;
@@ -1970,6 +3290,8 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].segment_count = (apr_uint32_t)segment_count;
       c[seg].prefix_pool = prefix_pool;
 
+      c[seg].disk_tier = NULL;
+
       c[seg].group_count = main_group_count;
       c[seg].spare_group_count = spare_group_count;
       c[seg].first_spare_group = NO_INDEX;
@@ -1978,8 +3300,9 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       /* Allocate but don't clear / zero the directory because it would add
          significantly to the server start-up time if the caches are large.
          Group initialization will take care of that in stead. */
-      c[seg].directory = apr_palloc(pool,
-                                    group_count * sizeof(entry_group_t));
+      c[seg].directory = allocate_segment_memory(
+                           group_count * sizeof(entry_group_t),
+                           huge_pages, numa_interleave, pool);
 
       /* Allocate and initialize directory entries as "not initialized",
          hence "unused" */
@@ -2004,7 +3327,9 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].l2.current_data = c[seg].l2.start_offset;
 
       /* This cast is safe because DATA_SIZE <= MAX_SEGMENT_SIZE. */
-      c[seg].data = apr_palloc(pool, (apr_size_t)ALIGN_VALUE(data_size));
+      c[seg].data = allocate_segment_memory(
+                      (apr_size_t)ALIGN_VALUE(data_size),
+                      huge_pages, numa_interleave, pool);
       c[seg].data_used = 0;
       c[seg].max_entry_size = max_entry_size;
 
@@ -2046,6 +3371,7 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
 #endif
       /* No writers at the moment. */
       c[seg].write_lock_count = 0;
+      c[seg].generation = 0;
     }
 
   /* done here
@@ -2054,11 +3380,90 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_cache__membuffer_enable_disk_tier(svn_membuffer_t *cache,
+                                      const char *path,
+                                      apr_uint64_t size,
+                                      svn_boolean_t thread_safe,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool)
+{
+  disk_tier_t *tier = apr_pcalloc(result_pool, sizeof(*tier));
+  disk_file_header_t header = { 0 };
+  apr_size_t bytes_read;
+  svn_filesize_t file_size;
+  apr_uint64_t slot_count;
+  apr_uint32_t seg;
+
+  /* We need some minimal amount of space to work with. */
+  size = ALIGN_VALUE(size);
+  if (size < DISK_TIER_DATA_START + 64 * ITEM_ALIGNMENT)
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             _("Disk cache size of %s bytes is too small"),
+                             apr_psprintf(scratch_pool,
+                                          "%" APR_UINT64_T_FMT, size));
+
+  slot_count = MAX(size / DISK_TIER_BYTES_PER_SLOT, DISK_TIER_MIN_SLOTS);
+  tier->slot_count = (apr_uint32_t)MIN(slot_count, APR_UINT32_MAX);
+  tier->slots = apr_pcalloc(result_pool,
+                            tier->slot_count * sizeof(*tier->slots));
+  tier->size = size;
+  tier->lap = 1;
+  tier->next_sequence = 1;
+  tier->checksum = svn_fnv1a_32__context_create(result_pool);
+  tier->queue_size = (apr_size_t)MIN(size, DISK_TIER_QUEUE_SIZE);
+  tier->pending = apr_pcalloc(result_pool, sizeof(*tier->pending));
+  tier->pending->data = apr_palloc(result_pool, tier->queue_size);
+  tier->flushing = apr_pcalloc(result_pool, sizeof(*tier->flushing));
+  tier->flushing->data = apr_palloc(result_pool, tier->queue_size);
+  tier->pool = result_pool;
+  SVN_ERR(svn_mutex__init(&tier->mutex, thread_safe, result_pool));
+  SVN_ERR(svn_mutex__init(&tier->file_mutex, thread_safe, result_pool));
+
+  /* Only one process may use the file at any time. */
+  SVN_ERR(svn_io_file_open(&tier->file, path,
+                           APR_READ | APR_WRITE | APR_CREATE | APR_BUFFERED,
+                           APR_OS_DEFAULT, result_pool));
+  SVN_ERR(svn_io_lock_open_file(tier->file, TRUE, TRUE, result_pool));
+
+  /* Re-use the existing contents if they have been written by a compatible
+   * process.  Otherwise, start from scratch. */
+  SVN_ERR(svn_io_file_size_get(&file_size, tier->file, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(tier->file, &header, sizeof(header),
+                                 &bytes_read, NULL, scratch_pool));
+  if (   bytes_read == sizeof(header)
+      && header.magic == DISK_TIER_FILE_MAGIC
+      && header.record_header_size == sizeof(disk_record_t)
+      && header.alignment == ITEM_ALIGNMENT
+      && header.abi == DISK_TIER_ABI)
+    {
+      if ((apr_uint64_t)file_size > size)
+        {
+          SVN_ERR(svn_io_file_trunc(tier->file, (apr_off_t)size,
+                                    scratch_pool));
+          file_size = (apr_off_t)size;
+        }
+
+      tier->stamp = header.stamp;
+      SVN_ERR(load_disk_tier(tier, (apr_uint64_t)file_size, scratch_pool));
+    }
+  else
+    {
+      SVN_ERR(reset_disk_tier(tier, scratch_pool));
+    }
+
+  for (seg = 0; seg < cache->segment_count; ++seg)
+    cache[seg].disk_tier = tier;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_cache__membuffer_clear(svn_membuffer_t *cache)
 {
   apr_size_t seg;
   apr_size_t segment_count = cache->segment_count;
+  disk_tier_t *tier;
 
   /* Length of the group_initialized array in bytes.
      See also svn_cache__membuffer_cache_create(). */
@@ -2105,6 +3510,13 @@ svn_cache__membuffer_clear(svn_membuffer_t *cache)
       SVN_ERR(unlock_cache(&cache[seg], SVN_NO_ERROR));
     }
 
+  /* The disk tier must not resurrect any of the old contents. */
+  tier = cache->disk_tier;
+  if (tier && !tier->failed)
+    SVN_MUTEX__WITH_LOCK(tier->file_mutex,
+                         check_disk_tier(tier,
+                                         reset_disk_tier(tier, tier->pool)));
+
   /* done here */
   return SVN_NO_ERROR;
 }
@@ -2126,7 +3538,8 @@ entry_exists_internal(svn_membuffer_t *cache,
 }
 
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
- * by the hash value TO_FIND and set *FOUND accordingly.
+ * by the hash value TO_FIND and set *FOUND accordingly.  Entries in the
+ * disk tier count as well.
  */
 static svn_error_t *
 entry_exists(svn_membuffer_t *cache,
@@ -2140,6 +3553,9 @@ entry_exists(svn_membuffer_t *cache,
                                        to_find,
                                        found));
 
+  if (!*found)
+    SVN_ERR(disk_entry_exists(found, cache, &to_find->entry_key, 0));
+
   return SVN_NO_ERROR;
 }
 
@@ -2310,6 +3726,34 @@ membuffer_cache_set_internal(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
+/* Same as membuffer_cache_set_internal but also invalidate any older copy
+ * of that entry in the disk tier of CACHE.
+ *
+ * Note: This function requires the caller to serialization access.
+ * Don't call it directly, call membuffer_cache_set instead.
+ */
+static svn_error_t *
+membuffer_cache_update_internal(svn_membuffer_t *cache,
+                                const full_key_t *to_find,
+                                apr_uint32_t group_index,
+                                char *buffer,
+                                apr_size_t item_size,
+                                apr_uint32_t priority,
+                                DEBUG_CACHE_MEMBUFFER_TAG_ARG
+                                apr_pool_t *scratch_pool)
+{
+  SVN_ERR(invalidate_on_disk(cache, &to_find->entry_key));
+
+  return svn_error_trace(membuffer_cache_set_internal(cache,
+                                                      to_find,
+                                                      group_index,
+                                                      buffer,
+                                                      item_size,
+                                                      priority,
+                                                      DEBUG_CACHE_MEMBUFFER_TAG
+                                                      scratch_pool));
+}
+
 /* Try to insert the ITEM and use the KEY to uniquely identify it.
  * However, there is no guarantee that it will actually be put into
  * the cache. If there is already some data associated to the KEY,
@@ -2344,15 +3788,17 @@ membuffer_cache_set(svn_membuffer_t *cache,
   /* The actual cache data access needs to sync'ed
    */
   WITH_WRITE_LOCK(cache,
-                  membuffer_cache_set_internal(cache,
-                                               key,
-                                               group_index,
-                                               buffer,
-                                               size,
-                                               priority,
-                                               DEBUG_CACHE_MEMBUFFER_TAG
-                                               scratch_pool));
-  return SVN_NO_ERROR;
+                  membuffer_cache_update_internal(cache,
+                                                  key,
+                                                  group_index,
+                                                  buffer,
+                                                  size,
+                                                  priority,
+                                                  DEBUG_CACHE_MEMBUFFER_TAG
+                                                  scratch_pool));
+
+  /* Write evicted entries to disk without holding the lock. */
+  return svn_error_trace(flush_disk_tier(cache));
 }
 
 /* Count a hit in ENTRY within CACHE.
@@ -2433,6 +3879,211 @@ membuffer_cache_get_internal(svn_membuffer_t *cache,
   return SVN_NO_ERROR;
 }
 
+/* Insert the serialized item in BUFFER with ITEM_SIZE and PRIORITY, read
+ * from record SEQUENCE of the disk tier, into the group GROUP_INDEX of
+ * CACHE for key TO_FIND.  Do nothing if the entry has been re-added to CACHE
+ * or modified since it was read.
+ *
+ * Note: This function requires the caller to serialization access.
+ * Don't call it directly, call promote_from_disk instead.
+ */
+static svn_error_t *
+promote_from_disk_internal(svn_membuffer_t *cache,
+                           const full_key_t *to_find,
+                           apr_uint32_t group_index,
+                           char *buffer,
+                           apr_size_t item_size,
+                           apr_uint32_t priority,
+                           apr_uint64_t sequence,
+                           DEBUG_CACHE_MEMBUFFER_TAG_ARG
+                           apr_pool_t *scratch_pool)
+{
+  svn_boolean_t unchanged;
+
+  if (find_entry(cache, group_index, to_find, FALSE))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(disk_entry_exists(&unchanged, cache, &to_find->entry_key,
+                            sequence));
+  if (!unchanged)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(membuffer_cache_set_internal(cache,
+                                                      to_find,
+                                                      group_index,
+                                                      buffer,
+                                                      item_size,
+                                                      priority,
+                                                      DEBUG_CACHE_MEMBUFFER_TAG
+                                                      scratch_pool));
+}
+
+/* Look for the entry identified by KEY in the disk tier of CACHE.  If it
+ * exists, return a copy of its serialized data in *BUFFER and its size in
+ * *ITEM_SIZE and copy it back into group GROUP_INDEX of CACHE.  Otherwise,
+ * set *BUFFER to NULL.  Allocations will be done in RESULT_POOL.
+ */
+static svn_error_t *
+promote_from_disk(svn_membuffer_t *cache,
+                  apr_uint32_t group_index,
+                  const full_key_t *key,
+                  char **buffer,
+                  apr_size_t *item_size,
+                  DEBUG_CACHE_MEMBUFFER_TAG_ARG
+                  apr_pool_t *result_pool)
+{
+  apr_uint32_t priority;
+  apr_uint64_t sequence;
+
+  SVN_ERR(read_from_disk(buffer, item_size, &priority, &sequence, cache,
+                         key, result_pool));
+  if (*buffer == NULL)
+    return SVN_NO_ERROR;
+
+  /* The deserializers may modify BUFFER.  So, this must come first. */
+  WITH_WRITE_LOCK(cache,
+                  promote_from_disk_internal(cache,
+                                             key,
+                                             group_index,
+                                             *buffer,
+                                             *item_size,
+                                             priority,
+                                             sequence,
+                                             DEBUG_CACHE_MEMBUFFER_TAG
+                                             result_pool));
+
+  return svn_error_trace(flush_disk_tier(cache));
+}
+
+#ifdef USE_OPTIMISTIC_READS
+
+/* Read-only variant of find_entry with FIND_EMPTY==FALSE.  It may be
+ * called without holding any lock on CACHE, i.e. the directory may be
+ * modified concurrently.  Hence, all indexes will be bounds-checked and
+ * the result may be bogus.  Callers must validate it by checking the
+ * CACHE generation afterwards.
+ */
+static entry_t *
+find_entry_optimistic(svn_membuffer_t *cache,
+                      apr_uint32_t group_index,
+                      const full_key_t *to_find)
+{
+  apr_uint32_t group_limit = cache->group_count + cache->spare_group_count;
+  entry_group_t *group = &cache->directory[group_index];
+  int chain_length;
+
+  if (! is_group_initialized(cache, group_index))
+    return NULL;
+
+  for (chain_length = 0;
+       chain_length < MAX_GROUP_CHAIN_LENGTH;
+       ++chain_length)
+    {
+      apr_uint32_t used = group->header.used;
+      apr_uint32_t next = group->header.next;
+      apr_uint32_t i;
+
+      for (i = 0; i < MIN(used, GROUP_SIZE); ++i)
+        if (entry_keys_match(&group->entries[i].key, &to_find->entry_key))
+          return &group->entries[i];
+
+      if (next == NO_INDEX || next >= group_limit)
+        break;
+
+      group = &cache->directory[next];
+    }
+
+  return NULL;
+}
+
+#endif
+
+/* Try to do the same as membuffer_cache_get_internal but without
+ * acquiring the lock on CACHE.  Set *SUCCESS to TRUE, if the result in
+ * *BUFFER and *ITEM_SIZE is valid.  If there have been concurrent
+ * modifications to CACHE, set *SUCCESS to FALSE and the caller needs to
+ * retry the lookup under the read lock.  Allocations will be done in
+ * RESULT_POOL.
+ */
+static svn_error_t *
+membuffer_cache_get_optimistic(svn_boolean_t *success,
+                               svn_membuffer_t *cache,
+                               apr_uint32_t group_index,
+                               const full_key_t *to_find,
+                               char **buffer,
+                               apr_size_t *item_size,
+                               apr_pool_t *result_pool)
+{
+#ifdef USE_OPTIMISTIC_READS
+  apr_uint64_t data_size = cache->l1.size + cache->l2.size;
+  apr_size_t key_len = to_find->entry_key.key_len;
+  apr_uint32_t generation;
+  entry_t *entry;
+  entry_t snapshot;
+
+  *success = FALSE;
+
+  /* Is a writer currently modifying this segment? */
+  generation = get_generation(cache);
+  if (generation & 1)
+    return SVN_NO_ERROR;
+
+  /* Everything we read from the directory might be inconsistent.
+   * Work on a copy and make sure we don't access memory outside the
+   * data buffer.  Sizes beyond MAX_ENTRY_SIZE would be garbage anyway. */
+  *buffer = NULL;
+  entry = find_entry_optimistic(cache, group_index, to_find);
+  if (entry)
+    {
+      snapshot = *entry;
+      if (   snapshot.size < key_len
+          || snapshot.size > cache->max_entry_size
+          || snapshot.offset > data_size
+          || ALIGN_VALUE(snapshot.size) > data_size - snapshot.offset)
+        return SVN_NO_ERROR;
+
+      /* Fingerprint collision?  Then there is no matching entry. */
+      if (key_len
+          && memcmp(to_find->full_key.data, cache->data + snapshot.offset,
+                    key_len))
+        {
+          entry = NULL;
+        }
+      else
+        {
+          apr_size_t size = ALIGN_VALUE(snapshot.size) - key_len;
+          *buffer = apr_palloc(result_pool, size);
+          memcpy(*buffer, cache->data + snapshot.offset + key_len, size);
+        }
+    }
+
+  /* Only if nobody modified the segment in the meantime, our copy is
+   * valid.  Pool memory allocated for a bogus copy just gets wasted. */
+  if (get_generation(cache) != generation)
+    {
+      *buffer = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* The statistics are not synchronized anyway. */
+  *success = TRUE;
+  cache->total_reads++;
+  if (entry)
+    {
+      increment_hit_counters(cache, entry);
+      *item_size = snapshot.size - key_len;
+    }
+  else
+    {
+      *item_size = 0;
+    }
+#else
+  *success = FALSE;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* Look for the *ITEM identified by KEY. If no item has been stored
  * for KEY, *ITEM will be NULL. Otherwise, the DESERIALIZER is called
  * to re-construct the proper object from the serialized data.
@@ -2449,18 +4100,32 @@ membuffer_cache_get(svn_membuffer_t *cache,
   apr_uint32_t group_index;
   char *buffer;
   apr_size_t size;
+  svn_boolean_t done;
 
   /* find the entry group that will hold the key.
    */
   group_index = get_group_index(&cache, &key->entry_key);
-  WITH_READ_LOCK(cache,
-                 membuffer_cache_get_internal(cache,
-                                              group_index,
-                                              key,
-                                              &buffer,
-                                              &size,
-                                              DEBUG_CACHE_MEMBUFFER_TAG
-                                              result_pool));
+
+  /* Most of the time, there will be no concurrent writer.  So, try to
+   * get the data without locking the segment first.
+   */
+  SVN_ERR(membuffer_cache_get_optimistic(&done, cache, group_index, key,
+                                         &buffer, &size, result_pool));
+  if (!done)
+    WITH_READ_LOCK(cache,
+                   membuffer_cache_get_internal(cache,
+                                                group_index,
+                                                key,
+                                                &buffer,
+                                                &size,
+                                                DEBUG_CACHE_MEMBUFFER_TAG
+                                                result_pool));
+
+  /* Cache miss.  Maybe, we evicted it to disk.
+   */
+  if (buffer == NULL && cache->disk_tier)
+    SVN_ERR(promote_from_disk(cache, group_index, key, &buffer, &size,
+                              DEBUG_CACHE_MEMBUFFER_TAG result_pool));
 
   /* re-construct the original data object from its serialized form.
    */
@@ -2607,6 +4272,23 @@ membuffer_cache_get_partial(svn_membuffer_t *cache,
                       deserializer, baton, DEBUG_CACHE_MEMBUFFER_TAG
                       result_pool));
 
+  /* Cache miss.  Maybe, we evicted it to disk.
+   */
+  if (!*found && cache->disk_tier)
+    {
+      char *buffer;
+      apr_size_t size;
+
+      SVN_ERR(promote_from_disk(cache, group_index, key, &buffer, &size,
+                                DEBUG_CACHE_MEMBUFFER_TAG result_pool));
+      if (buffer)
+        {
+          *found = TRUE;
+          return svn_error_trace(deserializer(item, buffer, size, baton,
+                                              result_pool));
+        }
+    }
+
   return SVN_NO_ERROR;
 }
 
@@ -2634,6 +4316,10 @@ membuffer_cache_set_partial_internal(svn_membuffer_t *cache,
   entry_t *entry = find_entry(cache, group_index, to_find, FALSE);
   cache->total_reads++;
 
+  /* The disk tier's copy would not get modified.  Therefore, it must go.
+   */
+  SVN_ERR(invalidate_on_disk(cache, &to_find->entry_key));
+
   /* this function is a no-op if the item is not in cache
    */
   if (entry != NULL)
@@ -2748,9 +4434,8 @@ membuffer_cache_set_partial(svn_membuffer_t *cache,
                       DEBUG_CACHE_MEMBUFFER_TAG
                       scratch_pool));
 
-  /* done here -> unlock the cache
-   */
-  return SVN_NO_ERROR;
+  /* Write evicted entries to disk without holding the lock. */
+  return svn_error_trace(flush_disk_tier(cache));
 }
 
 /* Implement the svn_cache__t interface on top of a shared membuffer cache.
@@ -3147,6 +4832,68 @@ svn_membuffer_get_segment_info(svn_membuffer_t *segment,
   return SVN_NO_ERROR;
 }
 
+/* Return TRUE if ENTRY in SEGMENT has been written through the front-end
+ * CACHE, i.e. if its key starts with CACHE's key prefix.
+ */
+static svn_boolean_t
+entry_has_prefix(svn_membuffer_t *segment,
+                 const entry_t *entry,
+                 const svn_membuffer_cache_t *cache)
+{
+  /* Shared prefixes are identified by their index. */
+  if (cache->prefix.prefix_idx != NO_INDEX)
+    return entry->key.prefix_idx == cache->prefix.prefix_idx;
+
+  /* Otherwise, the full key has been stored in front of the item data. */
+  return entry->key.prefix_idx == NO_INDEX
+      && entry->key.key_len >= cache->prefix.key_len
+      && memcmp(segment->data + entry->offset,
+                cache->combined_key.full_key.data,
+                cache->prefix.key_len) == 0;
+}
+
+/* Add the capacity of SEGMENT to INFO like svn_membuffer_get_segment_info
+ * but count only the entries that belong to the front-end CACHE as used,
+ * i.e. report CACHE's partition of the shared SEGMENT.
+ *
+ * Note that this has to walk all entries in SEGMENT.
+ */
+static svn_error_t *
+svn_membuffer_get_partition_info(svn_membuffer_t *segment,
+                                 const svn_membuffer_cache_t *cache,
+                                 svn_cache__info_t *info)
+{
+  cache_level_t *levels[2];
+  apr_uint64_t used_size = info->used_size;
+  apr_uint64_t used_entries = info->used_entries;
+  int i;
+
+  SVN_ERR(svn_membuffer_get_segment_info(segment, info, FALSE));
+
+  levels[0] = &segment->l1;
+  levels[1] = &segment->l2;
+  for (i = 0; i < 2; ++i)
+    {
+      apr_uint32_t idx;
+      for (idx = levels[i]->first; idx != NO_INDEX; )
+        {
+          entry_t *entry = get_entry(segment, idx);
+          if (entry_has_prefix(segment, entry, cache))
+            {
+              used_size += entry->size;
+              used_entries++;
+            }
+
+          idx = entry->next;
+        }
+    }
+
+  info->used_size = used_size;
+  info->used_entries = used_entries;
+
+  return SVN_NO_ERROR;
+}
+
 /* Implement svn_cache__vtable_t.get_info
  * (thread-safe even without mutex)
  */
@@ -3163,13 +4910,14 @@ svn_membuffer_cache_get_info(void *cache_void,
 
   info->id = apr_pstrdup(result_pool, get_prefix_key(cache));
 
-  /* collect info from shared cache back-end */
+  /* collect info from shared cache back-end, reporting our share of it
+     as the used part */
 
   for (i = 0; i < cache->membuffer->segment_count; ++i)
     {
       svn_membuffer_t *segment = cache->membuffer + i;
       WITH_READ_LOCK(segment,
-                     svn_membuffer_get_segment_info(segment, info, FALSE));
+                     svn_membuffer_get_partition_info(segment, cache, info));
     }
 
   return SVN_NO_ERROR;
@@ -3186,7 +4934,8 @@ static svn_cache__vtable_t membuffer_cache_vtable = {
   svn_membuffer_cache_is_cachable,
   svn_membuffer_cache_get_partial,
   svn_membuffer_cache_set_partial,
-  svn_membuffer_cache_get_info
+  svn_membuffer_cache_get_info,
+  NULL                                    /* get_multi */
 };
 
 /* Implement svn_cache__vtable_t.get and serialize all cache access.
@@ -3299,7 +5048,8 @@ static svn_cache__vtable_t membuffer_cache_synced_vtable = {
   svn_membuffer_cache_is_cachable,        /* no sync required */
   svn_membuffer_cache_get_partial_synced,
   svn_membuffer_cache_set_partial_synced,
-  svn_membuffer_cache_get_info            /* no sync required */
+  svn_membuffer_cache_get_info,           /* no sync required */
+  NULL                                    /* get_multi */
 };
 
 /* standard serialization function for svn_stringbuf_t items.
@@ -3472,9 +5222,34 @@ svn_cache__membuffer_get_global_info(apr_pool_t *pool)
 
   /* collect info from shared cache back-end */
 
-  for (i = 0; i < membuffer->segment_count; ++i)
-    svn_error_clear(svn_membuffer_get_global_segment_info(membuffer + i,
-                                                          info));
+  if (membuffer)
+    for (i = 0; i < membuffer->segment_count; ++i)
+      svn_error_clear(svn_membuffer_get_global_segment_info(membuffer + i,
+                                                            info));
 
   return info;
 }
+
+apr_array_header_t *
+svn_cache__membuffer_get_global_segment_infos(apr_pool_t *pool)
+{
+  apr_uint32_t i;
+
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  apr_array_header_t *infos
+    = apr_array_make(pool, membuffer ? membuffer->segment_count : 0,
+                     sizeof(svn_cache__info_t));
+
+  if (membuffer)
+    for (i = 0; i < membuffer->segment_count; ++i)
+      {
+        svn_cache__info_t *info = apr_array_push(infos);
+        memset(info, 0, sizeof(*info));
+        info->id = apr_psprintf(pool, "membuffer segment %u", i);
+
+        svn_error_clear(svn_membuffer_get_global_segment_info(membuffer + i,
+                                                              info));
+      }
+
+  return infos;
+}
@@ -23,6 +23,7 @@
 
 #include <apr_md5.h>
 
+#include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_base64.h"
 #include "svn_path.h"
@@ -176,6 +177,34 @@ memcache_internal_get(char **data,
 }
 
 
+/* De-serialize the DATA_LEN bytes of DATA, as read from CACHE, into
+ * *VALUE_P.  DATA must have been allocated in RESULT_POOL and may be
+ * modified by this function.
+ */
+static svn_error_t *
+deserialize_value(void **value_p,
+                  memcache_t *cache,
+                  char *data,
+                  apr_size_t data_len,
+                  apr_pool_t *result_pool)
+{
+  if (cache->deserialize_func)
+    {
+      SVN_ERR((cache->deserialize_func)(value_p, data, data_len,
+                                        result_pool));
+    }
+  else
+    {
+      svn_stringbuf_t *value = svn_stringbuf_create_empty(result_pool);
+      value->data = data;
+      value->blocksize = data_len;
+      value->len = data_len - 1; /* account for trailing NUL */
+      *value_p = value;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 memcache_get(void **value_p,
              svn_boolean_t *found,
@@ -195,22 +224,83 @@ memcache_get(void **value_p,
 
   /* If we found it, de-serialize it. */
   if (*found)
+    SVN_ERR(deserialize_value(value_p, cache, data, data_len, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement vtable.get_multi using memcached's multi-get, which takes a
+ * single round-trip per server.
+ */
+static svn_error_t *
+memcache_get_multi(apr_array_header_t **values_p,
+                   void *cache_void,
+                   const apr_array_header_t *keys,
+                   apr_pool_t *result_pool)
+{
+  memcache_t *cache = cache_void;
+  apr_array_header_t *values = apr_array_make(result_pool, keys->nelts,
+                                              sizeof(void *));
+  apr_pool_t *subpool = svn_pool_create(result_pool);
+  const char **mc_keys = apr_palloc(subpool, keys->nelts * sizeof(*mc_keys));
+  apr_hash_t *mc_values = NULL;
+  apr_hash_t *deserialized = apr_hash_make(subpool);
+  apr_status_t apr_err;
+  int i;
+
+  for (i = 0; i < keys->nelts; ++i)
     {
-      if (cache->deserialize_func)
+      const void *key = APR_ARRAY_IDX(keys, i, const void *);
+
+      mc_keys[i] = NULL;
+      if (key)
         {
-          SVN_ERR((cache->deserialize_func)(value_p, data, data_len,
-                                            result_pool));
+          SVN_ERR(build_key(&mc_keys[i], cache, key, subpool));
+          apr_memcache_add_multget_key(subpool, mc_keys[i], &mc_values);
         }
-      else
+    }
+
+  if (mc_values)
+    {
+      /* The data gets allocated in RESULT_POOL, so we can de-serialize
+         it in-place. */
+      apr_err = apr_memcache_multgetp(cache->memcache, subpool, result_pool,
+                                      mc_values);
+      if (apr_err != APR_SUCCESS)
+        return svn_error_wrap_apr(apr_err,
+                                  _("Unknown memcached error while reading"));
+    }
+
+  for (i = 0; i < keys->nelts; ++i)
+    {
+      apr_memcache_value_t *mc_value = NULL;
+      void *value = NULL;
+
+      if (mc_keys[i])
         {
-          svn_stringbuf_t *value = svn_stringbuf_create_empty(result_pool);
-          value->data = data;
-          value->blocksize = data_len;
-          value->len = data_len - 1; /* account for trailing NUL */
-          *value_p = value;
+          mc_value = svn_hash_gets(mc_values, mc_keys[i]);
+
+          /* De-serializing may modify the data.  Do it only once for keys
+             that were requested more than once. */
+          value = svn_hash_gets(deserialized, mc_keys[i]);
         }
+
+      if (   !value
+          && mc_value
+          && mc_value->status == APR_SUCCESS
+          && mc_value->data)
+        {
+          SVN_ERR(deserialize_value(&value, cache, mc_value->data,
+                                    mc_value->len, result_pool));
+          svn_hash_sets(deserialized, mc_keys[i], value);
+        }
+
+      APR_ARRAY_PUSH(values, void *) = value;
     }
 
+  svn_pool_destroy(subpool);
+
+  *values_p = values;
   return SVN_NO_ERROR;
 }
 
@@ -398,7 +488,8 @@ static svn_cache__vtable_t memcache_vtable = {
   memcache_is_cachable,
   memcache_get_partial,
   memcache_set_partial,
-  memcache_get_info
+  memcache_get_info,
+  memcache_get_multi
 };
 
 svn_error_t *
@@ -0,0 +1,281 @@
+/*
+ * cache-tiered.c: a near cache in front of a far cache
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+
+#include "svn_private_config.h"
+#include "cache.h"
+
+/* The (internal) cache object.
+ *
+ * We access both tiers through the public svn_cache__* API, so each of
+ * them applies its own error handler.  That way, a failing memcached
+ * may be ignored while errors in the near cache still get reported.
+ */
+typedef struct tiered_cache_t
+{
+  /* Fast cache that gets consulted first and filled from FAR_CACHE. */
+  svn_cache__t *near_cache;
+
+  /* Typically slower and shared between processes. */
+  svn_cache__t *far_cache;
+} tiered_cache_t;
+
+
+/* Copy VALUE stored under KEY in CACHE's far cache into its near cache.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+promote(tiered_cache_t *cache,
+        const void *key,
+        void *value,
+        apr_pool_t *scratch_pool)
+{
+  apr_pool_t *subpool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_cache__set(cache->near_cache, key, value, subpool));
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+tiered_cache_get(void **value_p,
+                 svn_boolean_t *found,
+                 void *cache_void,
+                 const void *key,
+                 apr_pool_t *result_pool)
+{
+  tiered_cache_t *cache = cache_void;
+
+  SVN_ERR(svn_cache__get(value_p, found, cache->near_cache, key,
+                         result_pool));
+  if (*found)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_cache__get(value_p, found, cache->far_cache, key,
+                         result_pool));
+  if (*found)
+    SVN_ERR(promote(cache, key, *value_p, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+tiered_cache_has_key(svn_boolean_t *found,
+                     void *cache_void,
+                     const void *key,
+                     apr_pool_t *scratch_pool)
+{
+  tiered_cache_t *cache = cache_void;
+
+  SVN_ERR(svn_cache__has_key(found, cache->near_cache, key, scratch_pool));
+  if (! *found)
+    SVN_ERR(svn_cache__has_key(found, cache->far_cache, key,
+                               scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+tiered_cache_set(void *cache_void,
+                 const void *key,
+                 void *value,
+                 apr_pool_t *scratch_pool)
+{
+  tiered_cache_t *cache = cache_void;
+
+  SVN_ERR(svn_cache__set(cache->near_cache, key, value, scratch_pool));
+  SVN_ERR(svn_cache__set(cache->far_cache, key, value, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+tiered_cache_iter(svn_boolean_t *completed,
+                  void *cache_void,
+                  svn_iter_apr_hash_cb_t user_cb,
+                  void *user_baton,
+                  apr_pool_t *scratch_pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Can't iterate a tiered cache"));
+}
+
+static svn_boolean_t
+tiered_cache_is_cachable(void *cache_void,
+                         apr_size_t size)
+{
+  tiered_cache_t *cache = cache_void;
+
+  return svn_cache__is_cachable(cache->near_cache, size)
+      || svn_cache__is_cachable(cache->far_cache, size);
+}
+
+static svn_error_t *
+tiered_cache_get_partial(void **value_p,
+                         svn_boolean_t *found,
+                         void *cache_void,
+                         const void *key,
+                         svn_cache__partial_getter_func_t func,
+                         void *baton,
+                         apr_pool_t *result_pool)
+{
+  tiered_cache_t *cache = cache_void;
+  void *value;
+
+  SVN_ERR(svn_cache__get_partial(value_p, found, cache->near_cache, key,
+                                 func, baton, result_pool));
+  if (*found)
+    return SVN_NO_ERROR;
+
+  /* Fetch the whole item, so the next access will find it nearby. */
+  SVN_ERR(svn_cache__get(&value, found, cache->far_cache, key,
+                         result_pool));
+  if (! *found)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(promote(cache, key, value, result_pool));
+  SVN_ERR(svn_cache__get_partial(value_p, found, cache->near_cache, key,
+                                 func, baton, result_pool));
+
+  /* The near cache may not have accepted the item. */
+  if (! *found)
+    SVN_ERR(svn_cache__get_partial(value_p, found, cache->far_cache, key,
+                                   func, baton, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+tiered_cache_set_partial(void *cache_void,
+                         const void *key,
+                         svn_cache__partial_setter_func_t func,
+                         void *baton,
+                         apr_pool_t *scratch_pool)
+{
+  tiered_cache_t *cache = cache_void;
+
+  SVN_ERR(svn_cache__set_partial(cache->near_cache, key, func, baton,
+                                 scratch_pool));
+  SVN_ERR(svn_cache__set_partial(cache->far_cache, key, func, baton,
+                                 scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+tiered_cache_get_info(void *cache_void,
+                      svn_cache__info_t *info,
+                      svn_boolean_t reset,
+                      apr_pool_t *result_pool)
+{
+  tiered_cache_t *cache = cache_void;
+
+  /* Only the near cache has meaningful size information. */
+  return svn_error_trace(svn_cache__get_info(cache->near_cache, info, reset,
+                                             result_pool));
+}
+
+static svn_error_t *
+tiered_cache_get_multi(apr_array_header_t **values_p,
+                       void *cache_void,
+                       const apr_array_header_t *keys,
+                       apr_pool_t *result_pool)
+{
+  tiered_cache_t *cache = cache_void;
+  apr_array_header_t *values, *missing_keys, *far_values;
+  int *missing_idx;
+  int i;
+
+  SVN_ERR(svn_cache__get_multi(&values, cache->near_cache, keys,
+                               result_pool));
+
+  /* Ask the far cache for everything that the near cache didn't have,
+     all at once. */
+  missing_keys = apr_array_make(result_pool, keys->nelts,
+                                sizeof(const void *));
+  missing_idx = apr_palloc(result_pool, keys->nelts * sizeof(*missing_idx));
+  for (i = 0; i < keys->nelts; ++i)
+    {
+      const void *key = APR_ARRAY_IDX(keys, i, const void *);
+      if (key && ! APR_ARRAY_IDX(values, i, void *))
+        {
+          missing_idx[missing_keys->nelts] = i;
+          APR_ARRAY_PUSH(missing_keys, const void *) = key;
+        }
+    }
+
+  if (missing_keys->nelts)
+    {
+      SVN_ERR(svn_cache__get_multi(&far_values, cache->far_cache,
+                                   missing_keys, result_pool));
+      for (i = 0; i < missing_keys->nelts; ++i)
+        {
+          void *value = APR_ARRAY_IDX(far_values, i, void *);
+          if (value)
+            {
+              SVN_ERR(promote(cache,
+                              APR_ARRAY_IDX(missing_keys, i, const void *),
+                              value, result_pool));
+              APR_ARRAY_IDX(values, missing_idx[i], void *) = value;
+            }
+        }
+    }
+
+  *values_p = values;
+  return SVN_NO_ERROR;
+}
+
+static svn_cache__vtable_t tiered_cache_vtable = {
+  tiered_cache_get,
+  tiered_cache_has_key,
+  tiered_cache_set,
+  tiered_cache_iter,
+  tiered_cache_is_cachable,
+  tiered_cache_get_partial,
+  tiered_cache_set_partial,
+  tiered_cache_get_info,
+  tiered_cache_get_multi
+};
+
+svn_error_t *
+svn_cache__create_tiered(svn_cache__t **cache_p,
+                         svn_cache__t *near_cache,
+                         svn_cache__t *far_cache,
+                         apr_pool_t *result_pool)
+{
+  svn_cache__t *wrapper = apr_pcalloc(result_pool, sizeof(*wrapper));
+  tiered_cache_t *cache = apr_pcalloc(result_pool, sizeof(*cache));
+
+  cache->near_cache = near_cache;
+  cache->far_cache = far_cache;
+
+  wrapper->vtable = &tiered_cache_vtable;
+  wrapper->cache_internal = cache;
+  wrapper->error_handler = 0;
+  wrapper->error_baton = 0;
+  wrapper->pretend_empty = FALSE; /* Both tiers check that themselves. */
+
+  *cache_p = wrapper;
+  return SVN_NO_ERROR;
+}
@@ -95,6 +95,77 @@ svn_cache__get(void **value_p,
   return err;
 }
 
+/* Return an array of COUNT NULL pointers, allocated in RESULT_POOL. */
+static apr_array_header_t *
+make_null_values(int count,
+                 apr_pool_t *result_pool)
+{
+  apr_array_header_t *values = apr_array_make(result_pool, count,
+                                              sizeof(void *));
+  int i;
+
+  for (i = 0; i < count; ++i)
+    APR_ARRAY_PUSH(values, void *) = NULL;
+
+  return values;
+}
+
+svn_error_t *
+svn_cache__get_multi(apr_array_header_t **values,
+                     svn_cache__t *cache,
+                     const apr_array_header_t *keys,
+                     apr_pool_t *result_pool)
+{
+  apr_array_header_t *result = NULL;
+  svn_error_t *err;
+  int i;
+
+  /* In case any errors happen and are quelched, make sure we start
+     out with nothing found. */
+  *values = make_null_values(keys->nelts, result_pool);
+#ifdef SVN_DEBUG
+  if (cache->pretend_empty)
+    return SVN_NO_ERROR;
+#endif
+
+  if (cache->vtable->get_multi == NULL)
+    {
+      /* Simply look up one key after the other. */
+      for (i = 0; i < keys->nelts; ++i)
+        {
+          void *value;
+          svn_boolean_t found;
+
+          SVN_ERR(svn_cache__get(&value, &found, cache,
+                                 APR_ARRAY_IDX(keys, i, const void *),
+                                 result_pool));
+          if (found)
+            APR_ARRAY_IDX(*values, i, void *) = value;
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+  cache->reads += keys->nelts;
+  err = handle_error(cache,
+                     (cache->vtable->get_multi)(&result,
+                                                cache->cache_internal,
+                                                keys,
+                                                result_pool),
+                     result_pool);
+
+  if (result && !err)
+    {
+      for (i = 0; i < result->nelts; ++i)
+        if (APR_ARRAY_IDX(result, i, void *))
+          cache->hits++;
+
+      *values = result;
+    }
+
+  return err;
+}
+
 svn_error_t *
 svn_cache__has_key(svn_boolean_t *found,
                    svn_cache__t *cache,
@@ -64,6 +64,18 @@ static svn_cache_config_t cache_settings =
 #endif
 };
 
+/* Location and size of the optional disk tier for the singleton membuffer
+ * cache.  The disk tier is disabled by default.
+ */
+static const char *disk_cache_path = NULL;
+static apr_uint64_t disk_cache_size = 0;
+
+/* Memory placement hints for the singleton membuffer cache.  Both are
+ * disabled by default.
+ */
+static svn_boolean_t cache_huge_pages = FALSE;
+static svn_boolean_t cache_numa_interleave = FALSE;
+
 /* Get the current FSFS cache configuration. */
 const svn_cache_config_t *
 svn_cache_config_get(void)
@@ -120,13 +132,15 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
         return SVN_NO_ERROR;
       apr_allocator_owner_set(allocator, pool);
 
-      err = svn_cache__membuffer_cache_create(
+      err = svn_cache__membuffer_cache_create2(
           &cache,
           (apr_size_t)cache_size,
           (apr_size_t)(cache_size / 5),
           0,
           ! svn_cache_config_get()->single_threaded,
           FALSE,
+          cache_huge_pages,
+          cache_numa_interleave,
           pool);
 
       /* Some error occurred. Most likely it's an OOM error but we don't
@@ -143,6 +157,17 @@ initialize_cache(void *baton, apr_pool_t *unused_pool)
           return svn_error_trace(err);
         }
 
+      /* The disk tier is optional.  If we can't use the file, simply
+       * continue without it. */
+      if (disk_cache_path && disk_cache_size)
+        svn_error_clear(svn_cache__membuffer_enable_disk_tier(
+                            cache,
+                            disk_cache_path,
+                            disk_cache_size,
+                            ! svn_cache_config_get()->single_threaded,
+                            pool,
+                            pool));
+
       /* done */
       *cache_p = cache;
     }
@@ -179,3 +204,18 @@ svn_cache_config_set(const svn_cache_config_t *settings)
   cache_settings = *settings;
 }
 
+void
+svn_cache_config_set_disk_cache(const char *path,
+                                apr_uint64_t size)
+{
+  disk_cache_path = path;
+  disk_cache_size = size;
+}
+
+void
+svn_cache_config_set_memory_placement(svn_boolean_t huge_pages,
+                                      svn_boolean_t numa_interleave)
+{
+  cache_huge_pages = huge_pages;
+  cache_numa_interleave = numa_interleave;
+}
@@ -26,7 +26,6 @@
 #include <ctype.h>
 
 #include <apr_md5.h>
-#include <apr_sha1.h>
 
 #include "svn_checksum.h"
 #include "svn_error.h"
@@ -35,6 +34,7 @@
 
 #include "checksum.h"
 #include "fnv1a.h"
+#include "sha1.h"
 
 #include "private/svn_subr_private.h"
 
@@ -475,8 +475,6 @@ svn_checksum(svn_checksum_t **checksum,
              apr_size_t len,
              apr_pool_t *pool)
 {
-  apr_sha1_ctx_t sha1_ctx;
-
   SVN_ERR(validate_kind(kind));
   *checksum = svn_checksum_create(kind, pool);
 
@@ -487,9 +485,7 @@ svn_checksum(svn_checksum_t **checksum,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_init(&sha1_ctx);
-        apr_sha1_update(&sha1_ctx, data, (unsigned int)len);
-        apr_sha1_final((unsigned char *)(*checksum)->digest, &sha1_ctx);
+        svn_sha1__digest((unsigned char *)(*checksum)->digest, data, len);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -550,8 +546,7 @@ svn_checksum_ctx_create(svn_checksum_kind_t kind,
         break;
 
       case svn_checksum_sha1:
-        ctx->apr_ctx = apr_palloc(pool, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        ctx->apr_ctx = svn_sha1__context_create(pool);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -580,8 +575,7 @@ svn_checksum_ctx_reset(svn_checksum_ctx_t *ctx)
         break;
 
       case svn_checksum_sha1:
-        memset(ctx->apr_ctx, 0, sizeof(apr_sha1_ctx_t));
-        apr_sha1_init(ctx->apr_ctx);
+        svn_sha1__context_reset(ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -611,7 +605,7 @@ svn_checksum_update(svn_checksum_ctx_t *ctx,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_update(ctx->apr_ctx, data, (unsigned int)len);
+        svn_sha1__update(ctx->apr_ctx, data, len);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -644,7 +638,8 @@ svn_checksum_final(svn_checksum_t **checksum,
         break;
 
       case svn_checksum_sha1:
-        apr_sha1_final((unsigned char *)(*checksum)->digest, ctx->apr_ctx);
+        svn_sha1__finalize((unsigned char *)(*checksum)->digest,
+                           ctx->apr_ctx);
         break;
 
       case svn_checksum_fnv1a_32:
@@ -854,3 +849,149 @@ svn_checksum__wrap_write_stream_fnv1a_32x4(apr_uint32_t *digest,
 
   return result;
 }
+
+/* Multi-digest contexts.
+ */
+
+/* Number of bytes fed into each sub-context before moving on to the next.
+ * Small enough for the data to stay in L1 / L2 cache between the passes. */
+#define MULTI_BLOCK_SIZE 0x4000
+
+struct svn_checksum__multi_ctx_t
+{
+  /* Sub-contexts indexed by checksum kind.  NULL for kinds not wanted. */
+  svn_checksum_ctx_t *contexts[svn_checksum_fnv1a_32x4 + 1];
+};
+
+svn_checksum__multi_ctx_t *
+svn_checksum__multi_ctx_create(const svn_checksum_kind_t *kinds,
+                               int count,
+                               apr_pool_t *pool)
+{
+  svn_checksum__multi_ctx_t *ctx = apr_pcalloc(pool, sizeof(*ctx));
+  int i;
+
+  for (i = 0; i < count; ++i)
+    if (!ctx->contexts[kinds[i]])
+      ctx->contexts[kinds[i]] = svn_checksum_ctx_create(kinds[i], pool);
+
+  return ctx;
+}
+
+svn_error_t *
+svn_checksum__multi_update(svn_checksum__multi_ctx_t *ctx,
+                           const void *data,
+                           apr_size_t len)
+{
+  const char *block = data;
+
+  while (len)
+    {
+      apr_size_t block_len = MIN(len, MULTI_BLOCK_SIZE);
+      apr_size_t i;
+
+      for (i = 0; i < sizeof(ctx->contexts) / sizeof(ctx->contexts[0]); ++i)
+        if (ctx->contexts[i])
+          SVN_ERR(svn_checksum_update(ctx->contexts[i], block, block_len));
+
+      block += block_len;
+      len -= block_len;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_checksum__multi_final(svn_checksum_t **checksum,
+                          const svn_checksum__multi_ctx_t *ctx,
+                          svn_checksum_kind_t kind,
+                          apr_pool_t *pool)
+{
+  SVN_ERR(validate_kind(kind));
+  if (!ctx->contexts[kind])
+    return svn_error_create(SVN_ERR_BAD_CHECKSUM_KIND, NULL, NULL);
+
+  return svn_error_trace(svn_checksum_final(checksum, ctx->contexts[kind],
+                                            pool));
+}
+
+/* Baton used by multi_write_handler and multi_close_handler. */
+typedef struct multi_stream_baton_t
+{
+  /* Stream we are wrapping. Forward write() and close() operations to it. */
+  svn_stream_t *inner_stream;
+
+  /* Build the checksums in here. */
+  svn_checksum__multi_ctx_t *context;
+
+  /* Write the final checksums here.  May be NULL. */
+  svn_checksum_t **md5_checksum;
+  svn_checksum_t **sha1_checksum;
+
+  /* Allocate the resulting checksums here. */
+  apr_pool_t *pool;
+} multi_stream_baton_t;
+
+/* Implement svn_write_fn_t.
+ * Update checksums and pass data on to inner stream.
+ */
+static svn_error_t *
+multi_write_handler(void *baton,
+                    const char *data,
+                    apr_size_t *len)
+{
+  multi_stream_baton_t *b = baton;
+
+  SVN_ERR(svn_checksum__multi_update(b->context, data, *len));
+  SVN_ERR(svn_stream_write(b->inner_stream, data, len));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_close_fn_t.
+ * Finalize checksum calculation and write results. Close inner stream.
+ */
+static svn_error_t *
+multi_close_handler(void *baton)
+{
+  multi_stream_baton_t *b = baton;
+
+  if (b->md5_checksum)
+    SVN_ERR(svn_checksum__multi_final(b->md5_checksum, b->context,
+                                      svn_checksum_md5, b->pool));
+  if (b->sha1_checksum)
+    SVN_ERR(svn_checksum__multi_final(b->sha1_checksum, b->context,
+                                      svn_checksum_sha1, b->pool));
+
+  return svn_error_trace(svn_stream_close(b->inner_stream));
+}
+
+svn_stream_t *
+svn_checksum__wrap_write_stream_multi(svn_checksum_t **md5_checksum,
+                                      svn_checksum_t **sha1_checksum,
+                                      svn_stream_t *inner_stream,
+                                      apr_pool_t *pool)
+{
+  svn_stream_t *outer_stream;
+  svn_checksum_kind_t kinds[2];
+  int count = 0;
+
+  multi_stream_baton_t *baton = apr_pcalloc(pool, sizeof(*baton));
+
+  if (md5_checksum)
+    kinds[count++] = svn_checksum_md5;
+  if (sha1_checksum)
+    kinds[count++] = svn_checksum_sha1;
+
+  baton->inner_stream = inner_stream;
+  baton->context = svn_checksum__multi_ctx_create(kinds, count, pool);
+  baton->md5_checksum = md5_checksum;
+  baton->sha1_checksum = sha1_checksum;
+  baton->pool = pool;
+
+  outer_stream = svn_stream_create(baton, pool);
+  svn_stream_set_write(outer_stream, multi_write_handler);
+  svn_stream_set_close(outer_stream, multi_close_handler);
+
+  return outer_stream;
+}
@@ -29,6 +29,10 @@
 
 #include "svn_private_config.h"
 
+#ifdef SVN_HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
 const char *
 svn_zlib__compiled_version(void)
 {
@@ -43,6 +47,20 @@ svn_zlib__runtime_version(void)
   return zlibVersion();
 }
 
+const char *
+svn_zlib__libdeflate_version(void)
+{
+#if defined(SVN_HAVE_LIBDEFLATE) && defined(LIBDEFLATE_VERSION_STRING)
+  static const char libdeflate_version_str[] = LIBDEFLATE_VERSION_STRING;
+
+  return libdeflate_version_str;
+#elif defined(SVN_HAVE_LIBDEFLATE)
+  return "unknown";
+#else
+  return NULL;
+#endif
+}
+
 
 /* The zlib compressBound function was not exported until 1.2.0. */
 #if ZLIB_VERNUM >= 0x1200
@@ -55,6 +73,81 @@ svn_zlib__runtime_version(void)
    be compressed using zlib as a secondary compressor.  */
 #define MIN_COMPRESS_SIZE 512
 
+#ifdef SVN_HAVE_LIBDEFLATE
+
+/* zlib_encode() and zlib_decode() always process whole buffers, so they
+   don't need the streaming zlib API.  libdeflate does whole-buffer
+   compression a lot faster and produces standard zlib format data, which
+   can be read by stock zlib and vice versa.  The dictionary variants
+   further down still use zlib because libdeflate has no preset
+   dictionaries. */
+
+/* Compress the LEN bytes at DATA with COMPRESSION_LEVEL into the
+   BUFFER_SIZE bytes at BUFFER.  Set *RESULT_LEN to the compressed size
+   or to 0 if the result did not fit into BUFFER. */
+static svn_error_t *
+libdeflate_encode(apr_size_t *result_len,
+                  unsigned char *buffer,
+                  apr_size_t buffer_size,
+                  const char *data,
+                  apr_size_t len,
+                  int compression_level)
+{
+  struct libdeflate_compressor *compressor
+    = libdeflate_alloc_compressor(compression_level);
+
+  if (compressor == NULL)
+    return svn_error_trace(svn_error__wrap_zlib(
+                             Z_MEM_ERROR, "libdeflate_alloc_compressor",
+                             _("Compression of svndiff data failed")));
+
+  *result_len = libdeflate_zlib_compress(compressor, data, len,
+                                         buffer, buffer_size);
+  libdeflate_free_compressor(compressor);
+
+  return SVN_NO_ERROR;
+}
+
+/* Decompress the zlib format data of length INLEN at IN into the LEN
+   bytes at BUFFER.  The decompressed data must have exactly LEN bytes. */
+static svn_error_t *
+libdeflate_decode(unsigned char *buffer,
+                  apr_size_t len,
+                  const unsigned char *in,
+                  apr_size_t inLen)
+{
+  struct libdeflate_decompressor *decompressor
+    = libdeflate_alloc_decompressor();
+  enum libdeflate_result result;
+  size_t actual_len;
+
+  if (decompressor == NULL)
+    return svn_error_trace(svn_error__wrap_zlib(
+                             Z_MEM_ERROR, "libdeflate_alloc_decompressor",
+                             _("Decompression of svndiff data failed")));
+
+  result = libdeflate_zlib_decompress(decompressor, in, inLen,
+                                      buffer, len, &actual_len);
+  libdeflate_free_decompressor(decompressor);
+
+  if (result == LIBDEFLATE_BAD_DATA || result == LIBDEFLATE_SHORT_OUTPUT)
+    return svn_error_trace(svn_error__wrap_zlib(
+                             Z_DATA_ERROR, "libdeflate_zlib_decompress",
+                             _("Decompression of svndiff data failed")));
+
+  /* Just like zlib, libdeflate should not produce something that has a
+     different size than the original length we stored. */
+  if (result != LIBDEFLATE_SUCCESS || actual_len != len)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA,
+                            NULL,
+                            _("Size of uncompressed data "
+                              "does not match stored original length"));
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* SVN_HAVE_LIBDEFLATE */
+
 /* If IN is a string that is >= MIN_COMPRESS_SIZE and the COMPRESSION_LEVEL
    is not SVN_DELTA_COMPRESSION_LEVEL_NONE, zlib compress it and places the
    result in OUT, with an integer prepended specifying the original size.
@@ -88,6 +181,24 @@ zlib_encode(const char *data,
     }
   else
     {
+#ifdef SVN_HAVE_LIBDEFLATE
+      apr_size_t compressed_len;
+
+      /* We only keep the compressed data if it is shorter than LEN,
+         so don't bother to provide space for more. */
+      svn_stringbuf_ensure(out, len + intlen);
+      SVN_ERR(libdeflate_encode(&compressed_len,
+                                (unsigned char *)out->data + intlen,
+                                len - 1, data, len, compression_level));
+      endlen = (unsigned long)compressed_len;
+
+      /* Compression didn't help :(, just append the original text */
+      if (endlen == 0)
+        {
+          svn_stringbuf_appendbytes(out, data, len);
+          return SVN_NO_ERROR;
+        }
+#else
       int zerr;
 
       svn_stringbuf_ensure(out, svnCompressBound(len) + intlen);
@@ -107,6 +218,7 @@ zlib_encode(const char *data,
           svn_stringbuf_appendbytes(out, data, len);
           return SVN_NO_ERROR;
         }
+#endif
       out->len = endlen + intlen;
       out->data[out->len] = 0;
     }
@@ -155,6 +267,13 @@ zlib_decode(const unsigned char *in, apr_size_t inLen, svn_stringbuf_t *out,
     }
   else
     {
+#ifdef SVN_HAVE_LIBDEFLATE
+      svn_stringbuf_ensure(out, len);
+      SVN_ERR(libdeflate_decode((unsigned char *)out->data, len,
+                                in, inLen));
+      out->data[len] = 0;
+      out->len = len;
+#else
       unsigned long zlen = len;
       int zerr;
 
@@ -174,6 +293,7 @@ zlib_decode(const unsigned char *in, apr_size_t inLen, svn_stringbuf_t *out,
                                   "does not match stored original length"));
       out->data[zlen] = 0;
       out->len = zlen;
+#endif
     }
   return SVN_NO_ERROR;
 }
@@ -199,3 +319,182 @@ svn__decompress_zlib(const void *data, apr_size_t len,
 {
   return zlib_decode(data, len, out, limit);
 }
+
+/* Like zlib_encode() but use the preset DICTIONARY.  Since the dictionary
+   makes even short buffers compressible, there is no minimum size. */
+static svn_error_t *
+zlib_encode_dict(const char *data,
+                 apr_size_t len,
+                 svn_stringbuf_t *out,
+                 int compression_level,
+                 const svn_string_t *dictionary)
+{
+  z_stream stream = { 0 };
+  apr_size_t intlen;
+  unsigned char buf[SVN__MAX_ENCODED_UINT_LEN], *p;
+  int zerr;
+
+  svn_stringbuf_setempty(out);
+  p = svn__encode_uint(buf, (apr_uint64_t)len);
+  svn_stringbuf_appendbytes(out, (const char *)buf, p - buf);
+
+  intlen = out->len;
+  if (len == 0 || compression_level == SVN__COMPRESSION_NONE)
+    {
+      svn_stringbuf_appendbytes(out, data, len);
+      return SVN_NO_ERROR;
+    }
+
+  zerr = deflateInit(&stream, compression_level);
+  if (zerr != Z_OK)
+    return svn_error_trace(svn_error__wrap_zlib(
+                             zerr, "deflateInit",
+                             _("Compression of data failed")));
+
+  zerr = deflateSetDictionary(&stream,
+                              (const unsigned char *)dictionary->data,
+                              (uInt)dictionary->len);
+  if (zerr == Z_OK)
+    {
+      svn_stringbuf_ensure(out, svnCompressBound(len) + intlen);
+
+      stream.next_in = (unsigned char *)data;
+      stream.avail_in = (uInt)len;
+      stream.next_out = (unsigned char *)out->data + intlen;
+      stream.avail_out = (uInt)(out->blocksize - intlen - 1);
+
+      zerr = deflate(&stream, Z_FINISH);
+      if (zerr == Z_STREAM_END)
+        zerr = Z_OK;
+      else if (zerr == Z_OK)
+        zerr = Z_BUF_ERROR;
+    }
+
+  deflateEnd(&stream);
+
+  /* Running out of buffer space simply means that compression didn't
+     help, so we only report real errors. */
+  if (zerr != Z_OK && zerr != Z_BUF_ERROR)
+    return svn_error_trace(svn_error__wrap_zlib(
+                             zerr, "deflate",
+                             _("Compression of data failed")));
+
+  /* Compression didn't help :(, just append the original text */
+  if (zerr != Z_OK || stream.total_out >= len)
+    {
+      svn_stringbuf_appendbytes(out, data, len);
+      return SVN_NO_ERROR;
+    }
+
+  out->len = stream.total_out + intlen;
+  out->data[out->len] = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Like zlib_decode() but use the preset DICTIONARY. */
+static svn_error_t *
+zlib_decode_dict(const unsigned char *in,
+                 apr_size_t inLen,
+                 svn_stringbuf_t *out,
+                 apr_size_t limit,
+                 const svn_string_t *dictionary)
+{
+  z_stream stream = { 0 };
+  apr_size_t len;
+  apr_uint64_t size;
+  const unsigned char *oldplace = in;
+  int zerr;
+
+  /* First thing in the string is the original length.  */
+  in = svn__decode_uint(&size, in, in + inLen);
+  len = (apr_size_t)size;
+  if (in == NULL || len != size)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Decompression of zlib compressed data failed: no size"));
+  if (len > limit)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA, NULL,
+                            _("Decompression of zlib compressed data failed: "
+                              "size too large"));
+
+  inLen -= (in - oldplace);
+  svn_stringbuf_ensure(out, len);
+  if (inLen == len)
+    {
+      memcpy(out->data, in, len);
+      out->data[len] = 0;
+      out->len = len;
+
+      return SVN_NO_ERROR;
+    }
+
+  zerr = inflateInit(&stream);
+  if (zerr != Z_OK)
+    return svn_error_trace(svn_error__wrap_zlib(
+                             zerr, "inflateInit",
+                             _("Decompression of data failed")));
+
+  stream.next_in = (unsigned char *)in;
+  stream.avail_in = (uInt)inLen;
+  stream.next_out = (unsigned char *)out->data;
+  stream.avail_out = (uInt)len;
+
+  zerr = inflate(&stream, Z_FINISH);
+  if (zerr == Z_NEED_DICT)
+    {
+      zerr = inflateSetDictionary(&stream,
+                                  (const unsigned char *)dictionary->data,
+                                  (uInt)dictionary->len);
+      if (zerr == Z_OK)
+        zerr = inflate(&stream, Z_FINISH);
+    }
+
+  inflateEnd(&stream);
+  if (zerr != Z_STREAM_END)
+    return svn_error_trace(svn_error__wrap_zlib(
+                             zerr == Z_OK ? Z_DATA_ERROR : zerr, "inflate",
+                             _("Decompression of data failed")));
+
+  /* Zlib should not produce something that has a different size than the
+     original length we stored. */
+  if (stream.total_out != len)
+    return svn_error_create(SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA,
+                            NULL,
+                            _("Size of uncompressed data "
+                              "does not match stored original length"));
+  out->data[len] = 0;
+  out->len = len;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn__compress_zlib_dict(const void *data, apr_size_t len,
+                        svn_stringbuf_t *out,
+                        int compression_method,
+                        const svn_string_t *dictionary)
+{
+  if (dictionary == NULL || dictionary->len == 0)
+    return svn_error_trace(svn__compress_zlib(data, len, out,
+                                              compression_method));
+
+  if (   compression_method < SVN__COMPRESSION_NONE
+      || compression_method > SVN__COMPRESSION_ZLIB_MAX)
+    return svn_error_createf(SVN_ERR_BAD_COMPRESSION_METHOD, NULL,
+                             _("Unsupported compression method %d"),
+                             compression_method);
+
+  return zlib_encode_dict(data, len, out, compression_method, dictionary);
+}
+
+svn_error_t *
+svn__decompress_zlib_dict(const void *data, apr_size_t len,
+                          svn_stringbuf_t *out,
+                          apr_size_t limit,
+                          const svn_string_t *dictionary)
+{
+  if (dictionary == NULL || dictionary->len == 0)
+    return svn_error_trace(svn__decompress_zlib(data, len, out, limit));
+
+  return zlib_decode_dict(data, len, out, limit, dictionary);
+}
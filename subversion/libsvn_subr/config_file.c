@@ -1154,6 +1154,12 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###                              HTTP operation."                   NL
         "###   http-chunked-requests      Whether to use chunked transfer"   NL
         "###                              encoding for HTTP requests body."  NL
+        "###   http-http2                 Whether to offer HTTP/2 to https"  NL
+        "###                              servers, multiplexing requests"    NL
+        "###                              over a single connection."         NL
+        "###   http-baseline-cache        Whether to keep discovered DAV"    NL
+        "###                              baselines on disk for later"       NL
+        "###                              sessions (yes/no)."                NL
         "###   ssl-authority-files        List of files, each of a trusted CA"
                                                                              NL
         "###   ssl-trust-default-ca       Trust the system 'default' CAs"    NL
@@ -1512,6 +1518,17 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### to show meaningful differences for binary file formats.  [New"  NL
         "### in 1.9]"                                                        NL
         "# diff-ignore-content-type = no"                                    NL
+        "### Set externals-concurrency to the number of new directory"       NL
+        "### externals to check out at the same time, each over its own"     NL
+        "### connection, during checkouts and updates.  [New in 1.10]"       NL
+        "# externals-concurrency = 1"                                        NL
+        "### Set log-cache to 'yes' to keep the log messages, revision"      NL
+        "### properties and changed paths seen by 'svn log' in the"          NL
+        "### log-cache directory of this configuration area.  Later log"     NL
+        "### requests then only fetch the revisions not yet cached.  Only"   NL
+        "### revision property changes made by this client update the"       NL
+        "### cache.  [New in 1.10]"                                          NL
+        "# log-cache = no"                                                   NL
         ""                                                                   NL
         "### Section for configuring automatic properties."                  NL
         "[auto-props]"                                                       NL
@@ -1553,6 +1570,28 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### returning an error.  The default is 10000, i.e. 10 seconds."    NL
         "### Longer values may be useful when exclusive locking is enabled." NL
         "# busy-timeout = 10000"                                             NL
+        "### Set to true to let working copy databases use write-ahead"      NL
+        "### logging.  Then reading the database, e.g. by IDEs showing the"  NL
+        "### status of files, does not block writing it, and vice versa."    NL
+        "### Do not enable this on network file systems.  It has no effect"  NL
+        "### if exclusive-locking applies.  Clients using SQLite older than" NL
+        "### 3.7.0 can not open such working copies."                        NL
+        "# wal-journaling = false"                                           NL
+        "### Set to true to store new pristine copies of files compressed."  NL
+        "### This saves disk space in the .svn directory at the cost of some"NL
+        "### CPU time.  Clients older than 1.10 can not read such pristines."NL
+        "# compress-pristines = false"                                       NL
+        "### Set to the path of a directory to share pristine copies of"     NL
+        "### files between all working copies on the same file system."      NL
+        "### Working copies hard link their pristines to this store, so it"  NL
+        "### needs no disk space for content present in other working"       NL
+        "### copies.  'svn cleanup' removes copies no longer in use."        NL
+        "# shared-pristine-store ="                                          NL
+        "### Set to true to drop the pristine copies of unmodified files"   NL
+        "### after checkout, update and switch.  They are fetched from the"  NL
+        "### repository again when diff, revert or commit need them.  This"  NL
+        "### saves disk space at the cost of network access later on."       NL
+        "# lazy-pristines = false"                                           NL
         ;
 
       err = svn_io_file_open(&f, path,
@@ -0,0 +1,160 @@
+/*
+ * cpu.c :  detection of optional CPU features
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "private/svn_subr_private.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__GNUC__) || defined(__clang__))
+#define SVN_CPU__X86_GNUC
+#include <cpuid.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define SVN_CPU__X86_MSVC
+#include <intrin.h>
+#endif
+
+/* Set in the cached feature mask once detection has run. */
+#define FEATURES_DETECTED 0x80000000u
+
+/* CPUID bits we are interested in. */
+#define CPUID_1_EDX_SSE2     (1u << 26)
+#define CPUID_1_ECX_SSSE3    (1u << 9)
+#define CPUID_1_ECX_SSE41    (1u << 19)
+#define CPUID_1_ECX_OSXSAVE  (1u << 27)
+#define CPUID_1_ECX_AVX      (1u << 28)
+#define CPUID_7_EBX_AVX2     (1u << 5)
+#define CPUID_7_EBX_SHA      (1u << 29)
+
+/* XCR0 bits that tell us the OS saves the SSE and AVX registers. */
+#define XCR0_SSE_AVX         0x6u
+
+#if defined(SVN_CPU__X86_GNUC) || defined(SVN_CPU__X86_MSVC)
+
+/* Execute CPUID for LEAF and sub-leaf 0 and return the registers in
+ * REGS in the order EAX, EBX, ECX, EDX.  Return FALSE if LEAF is not
+ * supported. */
+static svn_boolean_t
+cpuid(unsigned int regs[4], unsigned int leaf)
+{
+#ifdef SVN_CPU__X86_GNUC
+  if (__get_cpuid_max(0, NULL) < leaf)
+    return FALSE;
+
+  __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#else
+  int info[4];
+
+  __cpuid(info, 0);
+  if ((unsigned int)info[0] < leaf)
+    return FALSE;
+
+  __cpuidex(info, (int)leaf, 0);
+  regs[0] = (unsigned int)info[0];
+  regs[1] = (unsigned int)info[1];
+  regs[2] = (unsigned int)info[2];
+  regs[3] = (unsigned int)info[3];
+#endif
+
+  return TRUE;
+}
+
+/* Return the lower 32 bits of the XCR0 register.  Only call this if
+ * CPUID reports OSXSAVE. */
+static unsigned int
+xgetbv0(void)
+{
+#ifdef SVN_CPU__X86_GNUC
+  unsigned int eax, edx;
+
+  /* The XGETBV opcode, for assemblers that don't know it. */
+  __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0"
+                       : "=a"(eax), "=d"(edx) : "c"(0));
+  return eax;
+#else
+  return (unsigned int)_xgetbv(0);
+#endif
+}
+
+/* Return the svn_cpu__feature_t flags supported by this x86 machine. */
+static unsigned int
+detect_features(void)
+{
+  unsigned int regs[4];
+  unsigned int features = 0;
+  svn_boolean_t os_avx = FALSE;
+
+  if (!cpuid(regs, 1))
+    return 0;
+
+  if (regs[3] & CPUID_1_EDX_SSE2)
+    features |= svn_cpu__sse2;
+  if (regs[2] & CPUID_1_ECX_SSSE3)
+    features |= svn_cpu__ssse3;
+  if (regs[2] & CPUID_1_ECX_SSE41)
+    features |= svn_cpu__sse41;
+  if ((regs[2] & CPUID_1_ECX_OSXSAVE) && (regs[2] & CPUID_1_ECX_AVX))
+    os_avx = (xgetbv0() & XCR0_SSE_AVX) == XCR0_SSE_AVX;
+
+  if (cpuid(regs, 7))
+    {
+      if (os_avx && (regs[1] & CPUID_7_EBX_AVX2))
+        features |= svn_cpu__avx2;
+      if (regs[1] & CPUID_7_EBX_SHA)
+        features |= svn_cpu__sha;
+    }
+
+  return features;
+}
+
+#else
+
+/* Return the svn_cpu__feature_t flags supported by this machine. */
+static unsigned int
+detect_features(void)
+{
+  /* NEON is part of every AArch64 CPU.  On 32 bit ARM, trust the
+     compiler's target settings. */
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+  return svn_cpu__neon;
+#else
+  return 0;
+#endif
+}
+
+#endif
+
+svn_boolean_t
+svn_cpu__has_features(unsigned int features)
+{
+  /* Concurrent initialization is harmless as all threads will come to
+   * the same result. */
+  static volatile unsigned int detected = 0;
+  unsigned int available = detected;
+
+  if (available == 0)
+    {
+      available = detect_features() | FEATURES_DETECTED;
+      detected = available;
+    }
+
+  return (available & features) == features;
+}
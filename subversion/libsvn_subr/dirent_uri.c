@@ -1199,6 +1199,26 @@ svn_relpath_join(const char *base,
   return path;
 }
 
+void
+svn_relpath__join_buf(svn_stringbuf_t *buf,
+                      const char *base,
+                      const char *component)
+{
+  apr_size_t blen = strlen(base);
+  apr_size_t clen = strlen(component);
+
+  assert(relpath_is_canonical(base));
+  assert(relpath_is_canonical(component));
+
+  svn_stringbuf_setempty(buf);
+  svn_stringbuf_ensure(buf, blen + 1 + clen);
+
+  svn_stringbuf_appendbytes(buf, base, blen);
+  if (blen && clen)
+    svn_stringbuf_appendbyte(buf, '/');
+  svn_stringbuf_appendbytes(buf, component, clen);
+}
+
 char *
 svn_dirent_dirname(const char *dirent, apr_pool_t *pool)
 {
@@ -1652,6 +1672,24 @@ svn_relpath_canonicalize(const char *relpath, apr_pool_t *pool)
   return canonicalize(type_relpath, relpath, pool);
 }
 
+const char *
+svn_relpath__canonicalize_lazy(const char *relpath, apr_pool_t *result_pool)
+{
+  if (relpath_is_canonical(relpath))
+    return relpath;
+
+  return canonicalize(type_relpath, relpath, result_pool);
+}
+
+const char *
+svn_uri__canonicalize_lazy(const char *uri, apr_pool_t *result_pool)
+{
+  if (svn_uri_is_canonical(uri, result_pool))
+    return uri;
+
+  return canonicalize(type_uri, uri, result_pool);
+}
+
 const char *
 svn_dirent_canonicalize(const char *dirent, apr_pool_t *pool)
 {
@@ -1718,9 +1756,8 @@ svn_dirent_is_canonical(const char *dirent, apr_pool_t *scratch_pool)
 static svn_boolean_t
 relpath_is_canonical(const char *relpath)
 {
-  const char *dot_pos, *ptr = relpath;
-  apr_size_t i, len;
-  unsigned pattern = 0;
+  const char *dot_pos, *slash, *ptr = relpath;
+  apr_size_t len;
 
   /* RELPATH is canonical if it has:
    *  - no '.' segments
@@ -1754,13 +1791,14 @@ relpath_is_canonical(const char *relpath)
     if (dot_pos > ptr && dot_pos[-1] == '/' && dot_pos[1] == '/')
       return FALSE;
 
-  /* Now validate the rest of the path. */
-  for (i = 0; i < len - 1; ++i)
-    {
-      pattern = ((pattern & 0xff) << 8) + (unsigned char)ptr[i];
-      if (pattern == 0x101 * (unsigned char)('/'))
-        return FALSE;
-    }
+  /* Now validate the rest of the path.  Let memchr() do the scanning,
+   * it is much faster than a byte-by-byte loop.  We already know that
+   * the last char is not a '/', so there is always a char after SLASH. */
+  for (slash = memchr(ptr, '/', len - 1);
+       slash;
+       slash = memchr(slash + 1, '/', ptr + len - 1 - (slash + 1)))
+    if (slash[1] == '/')
+      return FALSE;
 
   return TRUE;
 }
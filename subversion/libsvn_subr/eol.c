@@ -30,10 +30,68 @@
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
 
+/* SSE2 is part of every x86-64 CPU, so there is no need to detect it. */
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SVN_EOL__SSE2
+#endif
+
+#ifdef SVN_EOL__SSE2
+/* Return the offset of the first CR, LF or, if CHECK_C is set, C in the
+ * first LEN bytes in BUF.  Only whole 16 byte blocks will be checked.
+ * Return the length of those blocks if none of the characters was found.
+ */
+static apr_size_t
+find_eol_or_char_sse2(const char *buf,
+                      apr_size_t len,
+                      svn_boolean_t check_c,
+                      char c)
+{
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const __m128i other = _mm_set1_epi8(c);
+  apr_size_t i;
+
+  for (i = 0; i + sizeof(__m128i) <= len; i += sizeof(__m128i))
+    {
+      __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+      __m128i found = _mm_or_si128(_mm_cmpeq_epi8(v, cr),
+                                   _mm_cmpeq_epi8(v, lf));
+      int mask;
+
+      if (check_c)
+        found = _mm_or_si128(found, _mm_cmpeq_epi8(v, other));
+
+      mask = _mm_movemask_epi8(found);
+      if (mask)
+        {
+          /* Position of the lowest bit set in MASK. */
+          while ((mask & 1) == 0)
+            {
+              mask >>= 1;
+              ++i;
+            }
+
+          return i;
+        }
+    }
+
+  return i;
+}
+#endif
+
+
 char *
 svn_eol__find_eol_start(char *buf, apr_size_t len)
 {
-#if SVN_UNALIGNED_ACCESS_IS_OK
+#ifdef SVN_EOL__SSE2
+
+  apr_size_t offset = find_eol_or_char_sse2(buf, len, FALSE, 0);
+  buf += offset;
+  len -= offset;
+
+#elif SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Scan the input one machine word at a time. */
   for (; len > sizeof(apr_uintptr_t)
@@ -70,6 +128,51 @@ svn_eol__find_eol_start(char *buf, apr_size_t len)
   return NULL;
 }
 
+char *
+svn_eol__find_eol_or_char(char *buf, apr_size_t len, char c)
+{
+#ifdef SVN_EOL__SSE2
+
+  apr_size_t offset = find_eol_or_char_sse2(buf, len, TRUE, c);
+  buf += offset;
+  len -= offset;
+
+#elif SVN_UNALIGNED_ACCESS_IS_OK
+
+  /* C repeated in every byte of a machine word. */
+  const apr_uintptr_t c_mask = (SVN__BIT_7_SET >> 7) * (unsigned char)c;
+
+  /* Scan the input one machine word at a time.
+   * See svn_eol__find_eol_start for how this works. */
+  for (; len > sizeof(apr_uintptr_t)
+       ; buf += sizeof(apr_uintptr_t), len -= sizeof(apr_uintptr_t))
+    {
+      apr_uintptr_t chunk = *(const apr_uintptr_t *)buf;
+
+      apr_uintptr_t r_test = chunk ^ SVN__R_MASK;
+      apr_uintptr_t n_test = chunk ^ SVN__N_MASK;
+      apr_uintptr_t c_test = chunk ^ c_mask;
+
+      r_test |= (r_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+      n_test |= (n_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+      c_test |= (c_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+
+      if ((r_test & n_test & c_test & SVN__BIT_7_SET) != SVN__BIT_7_SET)
+        break;
+    }
+
+#endif
+
+  /* The remaining odd bytes will be examined the naive way: */
+  for (; len > 0; ++buf, --len)
+    {
+      if (*buf == '\n' || *buf == '\r' || *buf == c)
+        return buf;
+    }
+
+  return NULL;
+}
+
 const char *
 svn_eol__detect_eol(char *buf, apr_size_t len, char **eolp)
 {
@@ -0,0 +1,313 @@
+/*
+ * hash_map.c :  implement an open-addressing hash map
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <string.h>
+#include <assert.h>
+
+#include <apr_hash.h>
+
+#include "svn_pools.h"
+#include "private/svn_subr_private.h"
+
+/* Minimum number of slots in a map.  Must be a power of two.
+ */
+#define MIN_CAPACITY 16
+
+/* Tags of used slots always have this bit set.  Empty slots have tag 0.
+ */
+#define TAG_USED 0x80
+
+/* A single map entry.  We keep it small to fit many into a cache line.
+ */
+typedef struct slot_t
+{
+  /* The key, not copied into the map. */
+  const void *key;
+
+  /* The value, never NULL for used slots. */
+  void *value;
+
+  /* Number of bytes in KEY. */
+  apr_uint32_t klen;
+
+  /* Full hash value of KEY. */
+  apr_uint32_t hash;
+} slot_t;
+
+struct svn_hash_map__t
+{
+  /* One tag per slot.  0 for empty slots, TAG_USED plus the upper hash
+   * bits for used ones. */
+  unsigned char *tags;
+
+  /* The entries, MASK + 1 of them. */
+  slot_t *slots;
+
+  /* Number of slots minus 1.  The number of slots is a power of two. */
+  apr_size_t mask;
+
+  /* Number of used slots. */
+  apr_size_t count;
+
+  /* Grow the table when COUNT would exceed this. */
+  apr_size_t max_count;
+
+  /* TAGS and SLOTS are allocated in this sub-pool of POOL. */
+  apr_pool_t *table_pool;
+
+  /* The pool that the map has been allocated in. */
+  apr_pool_t *pool;
+};
+
+/* Return the tag for HASH.
+ */
+static APR_INLINE unsigned char
+get_tag(apr_uint32_t hash)
+{
+  return (unsigned char)(TAG_USED | (hash >> 25));
+}
+
+/* Allocate a new, empty table of CAPACITY slots for MAP in a new
+ * sub-pool and release the previous table pool.  CAPACITY must be a
+ * power of two.
+ */
+static void
+allocate_table(svn_hash_map__t *map,
+               apr_size_t capacity)
+{
+  map->table_pool = svn_pool_create(map->pool);
+  map->tags = apr_pcalloc(map->table_pool, capacity);
+  map->slots = apr_palloc(map->table_pool, capacity * sizeof(*map->slots));
+  map->mask = capacity - 1;
+
+  /* Allow for a 7/8 load factor.  The tags keep probe sequences cheap. */
+  map->max_count = capacity - capacity / 8;
+}
+
+/* Return the index of the slot in MAP that contains KEY of length KLEN
+ * with the given HASH.  If there is no such entry, return the index of
+ * the empty slot where it would need to be inserted.
+ */
+static apr_size_t
+find_slot(svn_hash_map__t *map,
+          const void *key,
+          apr_uint32_t klen,
+          apr_uint32_t hash)
+{
+  unsigned char tag = get_tag(hash);
+  apr_size_t idx = hash & map->mask;
+
+  /* The table is never full, so this will terminate. */
+  while (map->tags[idx])
+    {
+      if (map->tags[idx] == tag)
+        {
+          const slot_t *slot = &map->slots[idx];
+          if (   slot->hash == hash
+              && slot->klen == klen
+              && memcmp(slot->key, key, klen) == 0)
+            break;
+        }
+
+      idx = (idx + 1) & map->mask;
+    }
+
+  return idx;
+}
+
+/* Double the number of slots in MAP and re-insert all entries.
+ */
+static void
+grow_table(svn_hash_map__t *map)
+{
+  apr_pool_t *old_pool = map->table_pool;
+  unsigned char *old_tags = map->tags;
+  slot_t *old_slots = map->slots;
+  apr_size_t old_capacity = map->mask + 1;
+  apr_size_t i;
+
+  allocate_table(map, 2 * old_capacity);
+  for (i = 0; i < old_capacity; ++i)
+    if (old_tags[i])
+      {
+        apr_size_t idx = old_slots[i].hash & map->mask;
+        while (map->tags[idx])
+          idx = (idx + 1) & map->mask;
+
+        map->tags[idx] = old_tags[i];
+        map->slots[idx] = old_slots[i];
+      }
+
+  svn_pool_destroy(old_pool);
+}
+
+/* Remove the entry in slot IDX from MAP.  Move entries of the same
+ * probe sequence backwards, so we don't need tombstones.
+ */
+static void
+remove_slot(svn_hash_map__t *map,
+            apr_size_t idx)
+{
+  apr_size_t next = (idx + 1) & map->mask;
+
+  while (map->tags[next])
+    {
+      /* The entry in NEXT may fill the gap at IDX, if that is not before
+       * its home slot in the probe sequence. */
+      apr_size_t home = map->slots[next].hash & map->mask;
+      if (((next - home) & map->mask) >= ((next - idx) & map->mask))
+        {
+          map->tags[idx] = map->tags[next];
+          map->slots[idx] = map->slots[next];
+          idx = next;
+        }
+
+      next = (next + 1) & map->mask;
+    }
+
+  map->tags[idx] = 0;
+  --map->count;
+}
+
+/* Return the actual length of KEY given its length KLEN as provided by
+ * the API user.
+ */
+static apr_uint32_t
+get_key_length(const void *key,
+               apr_ssize_t klen)
+{
+  if (klen == APR_HASH_KEY_STRING)
+    klen = strlen(key);
+
+  /* We store key lengths in 32 bits. */
+  assert((apr_uint64_t)klen <= APR_UINT32_MAX);
+
+  return (apr_uint32_t)klen;
+}
+
+svn_hash_map__t *
+svn_hash_map__create(apr_size_t count,
+                     apr_pool_t *pool)
+{
+  svn_hash_map__t *map = apr_pcalloc(pool, sizeof(*map));
+  apr_size_t capacity = MIN_CAPACITY;
+
+  while (capacity - capacity / 8 < count)
+    capacity *= 2;
+
+  map->pool = pool;
+  allocate_table(map, capacity);
+
+  return map;
+}
+
+void *
+svn_hash_map__get(svn_hash_map__t *map,
+                  const void *key,
+                  apr_ssize_t klen)
+{
+  apr_uint32_t len = get_key_length(key, klen);
+  apr_size_t idx = find_slot(map, key, len, svn__fnv1a_32(key, len));
+
+  return map->tags[idx] ? map->slots[idx].value : NULL;
+}
+
+void
+svn_hash_map__set(svn_hash_map__t *map,
+                  const void *key,
+                  apr_ssize_t klen,
+                  const void *value)
+{
+  apr_uint32_t len = get_key_length(key, klen);
+  apr_uint32_t hash = svn__fnv1a_32(key, len);
+  apr_size_t idx = find_slot(map, key, len, hash);
+
+  if (map->tags[idx])
+    {
+      if (value)
+        map->slots[idx].value = (void *)value;
+      else
+        remove_slot(map, idx);
+
+      return;
+    }
+
+  /* Removing an entry that does not exist is a no-op. */
+  if (!value)
+    return;
+
+  if (map->count == map->max_count)
+    {
+      grow_table(map);
+      idx = find_slot(map, key, len, hash);
+    }
+
+  map->tags[idx] = get_tag(hash);
+  map->slots[idx].key = key;
+  map->slots[idx].value = (void *)value;
+  map->slots[idx].klen = len;
+  map->slots[idx].hash = hash;
+  ++map->count;
+}
+
+apr_size_t
+svn_hash_map__count(svn_hash_map__t *map)
+{
+  return map->count;
+}
+
+void
+svn_hash_map__clear(svn_hash_map__t *map)
+{
+  memset(map->tags, 0, map->mask + 1);
+  map->count = 0;
+}
+
+svn_boolean_t
+svn_hash_map__next(const void **key,
+                   apr_ssize_t *klen,
+                   void **value,
+                   svn_hash_map__t *map,
+                   apr_size_t *iter)
+{
+  apr_size_t idx;
+
+  for (idx = *iter; idx <= map->mask; ++idx)
+    if (map->tags[idx])
+      {
+        const slot_t *slot = &map->slots[idx];
+        if (key)
+          *key = slot->key;
+        if (klen)
+          *klen = slot->klen;
+        if (value)
+          *value = slot->value;
+
+        *iter = idx + 1;
+        return TRUE;
+      }
+
+  *iter = idx;
+  return FALSE;
+}
@@ -51,6 +51,12 @@
 #include <fcntl.h>
 #endif
 
+#if defined(HAVE_LINUX_FS_H) && defined(HAVE_SYS_IOCTL_H)
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
 #include "svn_hash.h"
 #include "svn_types.h"
 #include "svn_dirent_uri.h"
@@ -824,8 +830,90 @@ svn_io_temp_dir(const char **dir,
 
 /*** Creating, copying and appending files. ***/
 
-/* Transfer the contents of FROM_FILE to TO_FILE, using POOL for temporary
- * allocations.
+#ifdef HAVE_COPY_FILE_RANGE
+/* The offset type of copy_file_range().  Linux has its own type for it,
+ * while the BSDs use off_t. */
+#ifdef __linux__
+typedef loff_t copy_range_offset_t;
+#else
+typedef off_t copy_range_offset_t;
+#endif
+#endif
+
+/* Try to let the operating system copy all of FROM_FILE, which must be
+ * positioned at its start, into the empty TO_FILE without passing the
+ * data through user space.  On copy-on-write file systems the files get
+ * to share their data blocks instead.  Set *COPIED to TRUE on success.
+ *
+ * If the platform or file system does not support this, set *COPIED to
+ * FALSE without having touched either file, so that the caller can copy
+ * the data itself.
+ */
+static apr_status_t
+copy_contents_in_kernel(svn_boolean_t *copied,
+                        apr_file_t *from_file,
+                        apr_file_t *to_file)
+{
+#if (defined(HAVE_LINUX_FS_H) && defined(HAVE_SYS_IOCTL_H) \
+     && defined(FICLONE)) || defined(HAVE_COPY_FILE_RANGE)
+  apr_os_file_t from_fd;
+  apr_os_file_t to_fd;
+#endif
+
+  *copied = FALSE;
+
+#if (defined(HAVE_LINUX_FS_H) && defined(HAVE_SYS_IOCTL_H) \
+     && defined(FICLONE)) || defined(HAVE_COPY_FILE_RANGE)
+  if (apr_os_file_get(&from_fd, from_file)
+      || apr_os_file_get(&to_fd, to_file))
+    return APR_SUCCESS;
+#endif
+
+#if defined(HAVE_LINUX_FS_H) && defined(HAVE_SYS_IOCTL_H) && defined(FICLONE)
+  /* A reflink on btrfs, XFS and the like: no data gets copied at all. */
+  if (ioctl(to_fd, FICLONE, from_fd) == 0)
+    {
+      *copied = TRUE;
+      return APR_SUCCESS;
+    }
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+  {
+    /* Use explicit offsets, so that the file positions stay where they
+     * are if we have to fall back to a plain copy. */
+    copy_range_offset_t from_offset = 0;
+    copy_range_offset_t to_offset = 0;
+
+    while (1)
+      {
+        ssize_t bytes_copied = copy_file_range(from_fd, &from_offset,
+                                               to_fd, &to_offset,
+                                               64 * SVN__STREAM_CHUNK_SIZE,
+                                               0);
+        if (bytes_copied < 0)
+          {
+            /* Not supported here, e.g. across file systems? */
+            if (to_offset == 0)
+              return APR_SUCCESS;
+
+            return APR_FROM_OS_ERROR(errno);
+          }
+
+        if (bytes_copied == 0)
+          break;
+      }
+
+    *copied = TRUE;
+  }
+#endif
+
+  return APR_SUCCESS;
+}
+
+/* Transfer the contents of FROM_FILE, which must be positioned at its
+ * start, to the empty TO_FILE, using POOL for temporary allocations.
+ * Where supported, the operating system does the actual copying.
  *
  * NOTE: We don't use apr_copy_file() for this, since it takes filenames
  * as parameters.  Since we want to copy to a temporary file
@@ -838,6 +926,13 @@ copy_contents(apr_file_t *from_file,
               apr_file_t *to_file,
               apr_pool_t *pool)
 {
+  svn_boolean_t copied;
+  apr_status_t status;
+
+  status = copy_contents_in_kernel(&copied, from_file, to_file);
+  if (status || copied)
+    return status;
+
   /* Copy bytes till the cows come home. */
   while (1)
     {
@@ -869,6 +964,17 @@ copy_contents(apr_file_t *from_file,
   /* NOTREACHED */
 }
 
+svn_error_t *
+svn_io__file_copy_contents(apr_file_t *from_file,
+                           apr_file_t *to_file,
+                           apr_pool_t *pool)
+{
+  return svn_error_trace(do_io_file_wrapper_cleanup(
+                           to_file, copy_contents(from_file, to_file, pool),
+                           N_("Can't copy to file '%s'"),
+                           N_("Can't copy to stream"),
+                           pool));
+}
 
 svn_error_t *
 svn_io_copy_file(const char *src,
@@ -3818,6 +3924,20 @@ svn_io_file_seek(apr_file_t *file, apr_seek_where_t where,
              pool);
 }
 
+void
+svn_io__file_prefetch(apr_file_t *file,
+                      apr_off_t offset,
+                      apr_off_t length)
+{
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_WILLNEED)
+  apr_os_file_t fd;
+
+  /* This is only a hint.  Silently ignore all failures. */
+  if (apr_os_file_get(&fd, file) == APR_SUCCESS)
+    (void)posix_fadvise(fd, offset, length, POSIX_FADV_WILLNEED);
+#endif
+}
+
 svn_error_t *
 svn_io_file_aligned_seek(apr_file_t *file,
                          apr_off_t block_size,
@@ -4319,6 +4439,26 @@ svn_io_file_rename2(const char *from_path, const char *to_path,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_io__file_link(const char *from_path,
+                  const char *to_path,
+                  apr_pool_t *pool)
+{
+  apr_status_t status;
+  const char *from_path_apr, *to_path_apr;
+
+  SVN_ERR(cstring_from_utf8(&from_path_apr, from_path, pool));
+  SVN_ERR(cstring_from_utf8(&to_path_apr, to_path, pool));
+
+  status = apr_file_link(from_path_apr, to_path_apr);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't link '%s' to '%s'"),
+                              svn_dirent_local_style(to_path, pool),
+                              svn_dirent_local_style(from_path, pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_io_file_move(const char *from_path, const char *to_path,
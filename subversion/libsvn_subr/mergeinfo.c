@@ -2700,6 +2700,241 @@ svn_mergeinfo__mergeinfo_from_segments(svn_mergeinfo_t *mergeinfo_p,
   return SVN_NO_ERROR;
 }
 
+/* A canonical rangelist stored as parallel arrays.  Bulk operations on
+   many rangelists use this instead of svn_rangelist_t, so that they
+   neither chase a pointer per range nor allocate every single range. */
+typedef struct packed_rangelist_t
+{
+  svn_revnum_t *start;
+  svn_revnum_t *end;
+  svn_boolean_t *inheritable;
+  int nelts;
+} packed_rangelist_t;
+
+/* How packed_rangelist_combine() combines the revisions of its operands. */
+typedef enum combine_mode_t
+{
+  /* Revisions in either operand.  Inheritable if inheritable in either. */
+  combine_union,
+
+  /* Revisions in both operands.  Inheritable if inheritable in either. */
+  combine_intersection,
+
+  /* Revisions in both operands with the same inheritability. */
+  combine_strict_intersection
+} combine_mode_t;
+
+/* Return an empty packed rangelist with room for CAPACITY ranges,
+   allocated in RESULT_POOL. */
+static packed_rangelist_t *
+packed_rangelist_create(int capacity,
+                        apr_pool_t *result_pool)
+{
+  packed_rangelist_t *packed = apr_palloc(result_pool, sizeof(*packed));
+
+  packed->start = apr_palloc(result_pool, capacity * sizeof(*packed->start));
+  packed->end = apr_palloc(result_pool, capacity * sizeof(*packed->end));
+  packed->inheritable = apr_palloc(result_pool,
+                                   capacity * sizeof(*packed->inheritable));
+  packed->nelts = 0;
+
+  return packed;
+}
+
+/* Append the range START-END with INHERITABLE to PACKED, extending the
+   last range instead if it adjoins and has the same inheritability.
+   PACKED must have room for another range. */
+static void
+packed_rangelist_append(packed_rangelist_t *packed,
+                        svn_revnum_t start,
+                        svn_revnum_t end,
+                        svn_boolean_t inheritable)
+{
+  int last = packed->nelts - 1;
+
+  if (last >= 0
+      && packed->end[last] == start
+      && packed->inheritable[last] == inheritable)
+    {
+      packed->end[last] = end;
+    }
+  else
+    {
+      packed->start[packed->nelts] = start;
+      packed->end[packed->nelts] = end;
+      packed->inheritable[packed->nelts] = inheritable;
+      packed->nelts++;
+    }
+}
+
+/* Set *PACKED to the canonical form of RANGELIST, allocated in
+   RESULT_POOL.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+pack_rangelist(packed_rangelist_t **packed,
+               const svn_rangelist_t *rangelist,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  int i;
+
+  if (!svn_rangelist__is_canonical(rangelist))
+    {
+      svn_rangelist_t *canonical = svn_rangelist_dup(rangelist, scratch_pool);
+
+      SVN_ERR(svn_rangelist__canonicalize(canonical, scratch_pool));
+      rangelist = canonical;
+    }
+
+  *packed = packed_rangelist_create(rangelist->nelts, result_pool);
+  for (i = 0; i < rangelist->nelts; i++)
+    {
+      const svn_merge_range_t *range
+        = APR_ARRAY_IDX(rangelist, i, const svn_merge_range_t *);
+
+      packed_rangelist_append(*packed, range->start, range->end,
+                              range->inheritable ? TRUE : FALSE);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Replace the contents of RANGELIST with the ranges in PACKED.  Allocate
+   the new ranges in a single block in RESULT_POOL. */
+static void
+unpack_rangelist(svn_rangelist_t *rangelist,
+                 const packed_rangelist_t *packed,
+                 apr_pool_t *result_pool)
+{
+  svn_merge_range_t *ranges = apr_palloc(result_pool,
+                                         packed->nelts * sizeof(*ranges));
+  int i;
+
+  apr_array_clear(rangelist);
+  for (i = 0; i < packed->nelts; i++)
+    {
+      ranges[i].start = packed->start[i];
+      ranges[i].end = packed->end[i];
+      ranges[i].inheritable = packed->inheritable[i];
+      APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) = &ranges[i];
+    }
+}
+
+/* Return the combination of the packed rangelists A and B as per MODE,
+   allocated in RESULT_POOL.  This is a single sweep over both operands
+   in which every range boundary ends one segment of constant coverage. */
+static packed_rangelist_t *
+packed_rangelist_combine(const packed_rangelist_t *a,
+                         const packed_rangelist_t *b,
+                         combine_mode_t mode,
+                         apr_pool_t *result_pool)
+{
+  /* Every boundary in A or B starts at most one range of the result. */
+  packed_rangelist_t *result
+    = packed_rangelist_create(2 * (a->nelts + b->nelts), result_pool);
+  svn_revnum_t pos;
+  int i = 0;
+  int j = 0;
+
+  if (a->nelts == 0)
+    pos = b->nelts ? b->start[0] : SVN_INVALID_REVNUM;
+  else if (b->nelts == 0)
+    pos = a->start[0];
+  else
+    pos = MIN(a->start[0], b->start[0]);
+
+  while (SVN_IS_VALID_REVNUM(pos))
+    {
+      svn_boolean_t in_a, in_b;
+      svn_revnum_t next_a, next_b, next;
+
+      /* Skip the ranges that end at or before POS. */
+      while (i < a->nelts && a->end[i] <= pos)
+        i++;
+      while (j < b->nelts && b->end[j] <= pos)
+        j++;
+
+      in_a = (i < a->nelts && a->start[i] <= pos);
+      in_b = (j < b->nelts && b->start[j] <= pos);
+
+      /* The segment from POS ends where the coverage of either operand
+         changes next. */
+      next_a = i < a->nelts ? (in_a ? a->end[i] : a->start[i])
+                            : SVN_INVALID_REVNUM;
+      next_b = j < b->nelts ? (in_b ? b->end[j] : b->start[j])
+                            : SVN_INVALID_REVNUM;
+      if (!SVN_IS_VALID_REVNUM(next_a))
+        next = next_b;
+      else if (!SVN_IS_VALID_REVNUM(next_b))
+        next = next_a;
+      else
+        next = MIN(next_a, next_b);
+
+      if (in_a && in_b)
+        {
+          if (mode != combine_strict_intersection
+              || a->inheritable[i] == b->inheritable[j])
+            packed_rangelist_append(result, pos, next,
+                                    a->inheritable[i] || b->inheritable[j]);
+        }
+      else if (mode == combine_union && in_a)
+        packed_rangelist_append(result, pos, next, a->inheritable[i]);
+      else if (mode == combine_union && in_b)
+        packed_rangelist_append(result, pos, next, b->inheritable[j]);
+
+      pos = next;
+    }
+
+  return result;
+}
+
+/* Combine RANGELIST with each rangelist in the hash RANGELISTS in turn as
+   per MODE and put the result into RANGELIST.  Allocate the new ranges in
+   RESULT_POOL.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+rangelist_combine_many(svn_rangelist_t *rangelist,
+                       apr_hash_t *rangelists,
+                       combine_mode_t mode,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *packed_pools[2];
+  packed_rangelist_t *packed;
+  apr_hash_index_t *hi;
+  int current = 0;
+
+  /* Alternate between two pools for the intermediate results, so that
+     memory use stays proportional to the size of the result. */
+  packed_pools[0] = svn_pool_create(scratch_pool);
+  packed_pools[1] = svn_pool_create(scratch_pool);
+
+  SVN_ERR(pack_rangelist(&packed, rangelist, packed_pools[current],
+                         iterpool));
+  for (hi = apr_hash_first(scratch_pool, rangelists);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      packed_rangelist_t *other;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(pack_rangelist(&other, apr_hash_this_val(hi), iterpool,
+                             iterpool));
+
+      current = 1 - current;
+      svn_pool_clear(packed_pools[current]);
+      packed = packed_rangelist_combine(packed, other, mode,
+                                        packed_pools[current]);
+    }
+
+  unpack_rangelist(rangelist, packed, result_pool);
+
+  svn_pool_destroy(packed_pools[0]);
+  svn_pool_destroy(packed_pools[1]);
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_rangelist__merge_many(svn_rangelist_t *merged_rangelist,
                           svn_mergeinfo_t merge_history,
@@ -2707,25 +2942,29 @@ svn_rangelist__merge_many(svn_rangelist_t *merged_rangelist,
                           apr_pool_t *scratch_pool)
 {
   if (apr_hash_count(merge_history))
-    {
-      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-      apr_hash_index_t *hi;
-
-      for (hi = apr_hash_first(scratch_pool, merge_history);
-           hi;
-           hi = apr_hash_next(hi))
-        {
-          svn_rangelist_t *subtree_rangelist = apr_hash_this_val(hi);
+    SVN_ERR(rangelist_combine_many(merged_rangelist, merge_history,
+                                   combine_union, result_pool,
+                                   scratch_pool));
 
-          svn_pool_clear(iterpool);
-          SVN_ERR(svn_rangelist_merge2(merged_rangelist, subtree_rangelist,
-                                       result_pool, iterpool));
-        }
-      svn_pool_destroy(iterpool);
-    }
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_rangelist__intersect_many(svn_rangelist_t *intersected_rangelist,
+                              apr_hash_t *rangelists,
+                              svn_boolean_t consider_inheritance,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  if (apr_hash_count(rangelists))
+    SVN_ERR(rangelist_combine_many(intersected_rangelist, rangelists,
+                                   consider_inheritance
+                                     ? combine_strict_intersection
+                                     : combine_intersection,
+                                   result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
 
 const char *
 svn_inheritance_to_word(svn_mergeinfo_inheritance_t inherit)
@@ -0,0 +1,171 @@
+/*
+ * metrics.c :  process-wide counters and their export
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_atomic.h>
+
+#include "svn_string.h"
+
+#include "private/svn_cache.h"
+#include "private/svn_dep_compat.h"
+#include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
+
+/* Head of the list of all registered counter groups.  Groups only ever
+ * get prepended, so readers may walk the list without locking. */
+static svn_metrics__group_t * volatile registered_groups = NULL;
+
+void
+svn_metrics__register(svn_metrics__group_t *group)
+{
+  while (TRUE)
+    {
+      svn_metrics__group_t *head = registered_groups;
+      svn_metrics__group_t *current;
+
+      for (current = head; current; current = current->next)
+        if (current == group)
+          return;
+
+      group->next = head;
+      if (svn_atomic_casptr((void *)&registered_groups, group, head) == head)
+        return;
+    }
+}
+
+/* Append the HELP and TYPE lines for metric NAME to BUFFER. */
+static void
+add_header(svn_stringbuf_t *buffer,
+           const char *name,
+           const char *help,
+           const char *type)
+{
+  svn_stringbuf_appendcstr(buffer, "# HELP ");
+  svn_stringbuf_appendcstr(buffer, name);
+  svn_stringbuf_appendbyte(buffer, ' ');
+  svn_stringbuf_appendcstr(buffer, help);
+  svn_stringbuf_appendcstr(buffer, "\n# TYPE ");
+  svn_stringbuf_appendcstr(buffer, name);
+  svn_stringbuf_appendbyte(buffer, ' ');
+  svn_stringbuf_appendcstr(buffer, type);
+  svn_stringbuf_appendbyte(buffer, '\n');
+}
+
+/* Append a metric NAME of TYPE with a single VALUE to BUFFER. */
+static void
+add_value(svn_stringbuf_t *buffer,
+          const char *name,
+          const char *help,
+          const char *type,
+          apr_uint64_t value)
+{
+  add_header(buffer, name, help, type);
+  svn_stringbuf_appendcstr(buffer,
+                           apr_psprintf(buffer->pool,
+                                        "%s %" APR_UINT64_T_FMT "\n",
+                                        name, value));
+}
+
+/* Append a gauge NAME with one value per element in the SEGMENTS array
+ * of svn_cache__info_t to BUFFER.  The value is taken from the member
+ * at OFFSET. */
+static void
+add_segment_values(svn_stringbuf_t *buffer,
+                   const char *name,
+                   const char *help,
+                   const apr_array_header_t *segments,
+                   apr_size_t offset)
+{
+  int i;
+
+  add_header(buffer, name, help, "gauge");
+  for (i = 0; i < segments->nelts; ++i)
+    {
+      const svn_cache__info_t *info
+        = &APR_ARRAY_IDX(segments, i, svn_cache__info_t);
+      apr_uint64_t value
+        = *(const apr_uint64_t *)((const char *)info + offset);
+
+      svn_stringbuf_appendcstr(buffer,
+                               apr_psprintf(buffer->pool,
+                                            "%s{segment=\"%d\"} %"
+                                            APR_UINT64_T_FMT "\n",
+                                            name, i, value));
+    }
+}
+
+svn_string_t *
+svn_metrics__format_prometheus(apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *buffer = svn_stringbuf_create_empty(result_pool);
+  svn_cache__info_t *info
+    = svn_cache__membuffer_get_global_info(result_pool);
+  apr_array_header_t *segments
+    = svn_cache__membuffer_get_global_segment_infos(result_pool);
+  svn_metrics__group_t *group;
+
+  /* Global membuffer cache. */
+  add_value(buffer, "svn_cache_gets_total",
+            "Lookups in the membuffer cache.", "counter", info->gets);
+  add_value(buffer, "svn_cache_hits_total",
+            "Lookups in the membuffer cache that found data.", "counter",
+            info->hits);
+  add_value(buffer, "svn_cache_sets_total",
+            "Writes to the membuffer cache.", "counter", info->sets);
+  add_value(buffer, "svn_cache_used_bytes",
+            "Size of the data stored in the membuffer cache.", "gauge",
+            info->used_size);
+  add_value(buffer, "svn_cache_data_bytes",
+            "Memory reserved for data in the membuffer cache.", "gauge",
+            info->data_size);
+  add_value(buffer, "svn_cache_total_bytes",
+            "Total memory allocated to the membuffer cache.", "gauge",
+            info->total_size);
+  add_value(buffer, "svn_cache_used_entries",
+            "Number of entries in the membuffer cache.", "gauge",
+            info->used_entries);
+  add_value(buffer, "svn_cache_total_entries",
+            "Maximum number of entries in the membuffer cache.", "gauge",
+            info->total_entries);
+
+  /* Per-segment fill levels. */
+  add_segment_values(buffer, "svn_cache_segment_used_bytes",
+                     "Size of the data stored per cache segment.",
+                     segments, APR_OFFSETOF(svn_cache__info_t, used_size));
+  add_segment_values(buffer, "svn_cache_segment_data_bytes",
+                     "Memory reserved for data per cache segment.",
+                     segments, APR_OFFSETOF(svn_cache__info_t, data_size));
+  add_segment_values(buffer, "svn_cache_segment_used_entries",
+                     "Number of entries per cache segment.",
+                     segments, APR_OFFSETOF(svn_cache__info_t, used_entries));
+
+  /* All registered counters. */
+  for (group = registered_groups; group; group = group->next)
+    {
+      int i;
+      for (i = 0; i < group->count; ++i)
+        add_value(buffer, group->counters[i].name, group->counters[i].help,
+                  "counter", group->counters[i].value);
+    }
+
+  return svn_stringbuf__morph_into_string(buffer);
+}
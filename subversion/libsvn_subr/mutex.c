@@ -22,6 +22,7 @@
  */
 
 #include <apr_portable.h>
+#include <apr_thread_rwlock.h>
 
 #include "svn_private_config.h"
 #include "private/svn_atomic.h"
@@ -106,6 +107,90 @@ svn_mutex__unlock(svn_mutex__t *mutex,
   return err;
 }
 
+struct svn_rwlock__t
+{
+#if APR_HAS_THREADS
+
+  apr_thread_rwlock_t *lock;
+
+#else
+
+  /* Truly empty structs are not allowed. */
+  int dummy;
+
+#endif
+};
+
+svn_error_t *
+svn_rwlock__init(svn_rwlock__t **lock_p,
+                 svn_boolean_t lock_required,
+                 apr_pool_t *result_pool)
+{
+  *lock_p = NULL;
+
+  if (lock_required)
+    {
+      svn_rwlock__t *lock = apr_pcalloc(result_pool, sizeof(*lock));
+
+#if APR_HAS_THREADS
+      apr_status_t status = apr_thread_rwlock_create(&lock->lock,
+                                                     result_pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create lock"));
+#endif
+
+      *lock_p = lock;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_rwlock__read_lock(svn_rwlock__t *lock)
+{
+  if (lock)
+    {
+#if APR_HAS_THREADS
+      apr_status_t status = apr_thread_rwlock_rdlock(lock->lock);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't get read lock"));
+#endif
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_rwlock__write_lock(svn_rwlock__t *lock)
+{
+  if (lock)
+    {
+#if APR_HAS_THREADS
+      apr_status_t status = apr_thread_rwlock_wrlock(lock->lock);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't get write lock"));
+#endif
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_rwlock__unlock(svn_rwlock__t *lock,
+                   svn_error_t *err)
+{
+  if (lock)
+    {
+#if APR_HAS_THREADS
+      apr_status_t status = apr_thread_rwlock_unlock(lock->lock);
+      if (status && !err)
+        return svn_error_wrap_apr(status, _("Can't unlock lock"));
+#endif
+    }
+
+  return err;
+}
+
 #if APR_HAS_THREADS
 
 apr_thread_mutex_t *
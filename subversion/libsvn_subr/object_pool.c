@@ -57,15 +57,28 @@ typedef struct object_ref_t
 
   /* Number of references to this data struct */
   volatile svn_atomic_t ref_count;
+
+  /* In exclusive mode, the next unused instance with the same KEY.
+   * NULL otherwise. */
+  struct object_ref_t *next;
 } object_ref_t;
 
+/* In exclusive mode, do not keep more than this many unused objects
+ * around.  Objects released beyond that limit get destroyed immediately.
+ */
+#define MAX_UNUSED_EXCLUSIVE 64
+
 
-/* Core data structure.  All access to it must be serialized using MUTEX.
+/* Core data structure.  All access to it must be serialized using LOCK.
  */
 struct svn_object_pool__t
 {
-  /* serialization object for all non-atomic data in this struct */
-  svn_mutex__t *mutex;
+  /* serialization object for all non-atomic data in this struct.
+   * Lookups in shared mode only need read access. */
+  svn_rwlock__t *lock;
+
+  /* if set, hand out every object to at most one user at a time */
+  svn_boolean_t exclusive;
 
   /* object_ref_t.KEY -> object_ref_t* mapping.
    *
@@ -158,6 +171,56 @@ object_ref_cleanup(void *baton)
   return APR_SUCCESS;
 }
 
+/* Put the OBJECT_REF that just got released in exclusive mode back into
+ * the chain of unused instances for its key.  If there are too many
+ * unused objects already, destroy it instead.
+ *
+ * Requires external serialization on OBJECT_REF->OBJECT_POOL.
+ */
+static svn_error_t *
+park_object_ref(object_ref_t *object_ref)
+{
+  svn_object_pool__t *object_pool = object_ref->object_pool;
+
+  svn_atomic_dec(&object_ref->ref_count);
+  if (object_pool->unused_count >= MAX_UNUSED_EXCLUSIVE)
+    {
+      svn_atomic_dec(&object_pool->object_count);
+      svn_pool_destroy(object_ref->pool);
+    }
+  else
+    {
+      /* Re-insert under our own key because the previous chain head may
+       * get removed before us. */
+      object_ref->next = apr_hash_get(object_pool->objects,
+                                      object_ref->key.data,
+                                      object_ref->key.size);
+      apr_hash_set(object_pool->objects, object_ref->key.data,
+                   object_ref->key.size, object_ref);
+      svn_atomic_inc(&object_pool->unused_count);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Cleanup function called when an object_ref_t gets released in
+ * exclusive mode.
+ */
+static apr_status_t
+exclusive_object_ref_cleanup(void *baton)
+{
+  object_ref_t *object_ref = baton;
+  svn_error_t *err;
+
+  err = svn_rwlock__write_lock(object_ref->object_pool->lock);
+  if (!err)
+    err = svn_rwlock__unlock(object_ref->object_pool->lock,
+                             park_object_ref(object_ref));
+
+  svn_error_clear(err);
+  return APR_SUCCESS;
+}
+
 /* Handle reference counting for the OBJECT_REF that the caller is about
  * to return.  The reference will be released when POOL gets cleaned up.
  *
@@ -173,13 +236,17 @@ add_object_ref(object_ref_t *object_ref,
     svn_atomic_dec(&object_ref->object_pool->unused_count);
 
   /* make sure the reference gets released automatically */
-  apr_pool_cleanup_register(pool, object_ref, object_ref_cleanup,
+  apr_pool_cleanup_register(pool, object_ref,
+                            object_ref->object_pool->exclusive
+                              ? exclusive_object_ref_cleanup
+                              : object_ref_cleanup,
                             apr_pool_cleanup_null);
 }
 
 /* Actual implementation of svn_object_pool__lookup.
  *
- * Requires external serialization on OBJECT_POOL.
+ * Requires external serialization on OBJECT_POOL.  Unless in exclusive
+ * mode, read access is sufficient because only atomic data gets modified.
  */
 static svn_error_t *
 lookup(void **object,
@@ -192,6 +259,17 @@ lookup(void **object,
 
   if (object_ref)
     {
+      if (object_pool->exclusive)
+        {
+          /* Take the object out of the chain of unused instances.
+           * The hash key belongs to OBJECT_REF, so re-insert the rest. */
+          apr_hash_set(object_pool->objects, key->data, key->size, NULL);
+          if (object_ref->next)
+            apr_hash_set(object_pool->objects, object_ref->next->key.data,
+                         object_ref->next->key.size, object_ref->next);
+          object_ref->next = NULL;
+        }
+
       *object = object_ref->object;
       add_object_ref(object_ref, result_pool);
     }
@@ -216,7 +294,9 @@ insert(void **object,
        apr_pool_t *result_pool)
 {
   object_ref_t *object_ref
-    = apr_hash_get(object_pool->objects, key->data, key->size);
+    = object_pool->exclusive
+    ? NULL
+    : apr_hash_get(object_pool->objects, key->data, key->size);
   if (object_ref)
     {
       /* Destroy the new one and return a reference to the existing one
@@ -236,8 +316,10 @@ insert(void **object,
       object_ref->key.size = key->size;
       memcpy(object_ref->key.data, key->data, key->size);
 
-      apr_hash_set(object_pool->objects, object_ref->key.data,
-                   object_ref->key.size, object_ref);
+      /* In exclusive mode, only unused objects are being indexed. */
+      if (!object_pool->exclusive)
+        apr_hash_set(object_pool->objects, object_ref->key.data,
+                     object_ref->key.size, object_ref);
       svn_atomic_inc(&object_pool->object_count);
 
       /* the new entry is *not* in use yet.
@@ -250,9 +332,10 @@ insert(void **object,
   *object = object_ref->object;
   add_object_ref(object_ref, result_pool);
 
-  /* limit memory usage */
-  if (svn_atomic_read(&object_pool->unused_count) * 2
-      > apr_hash_count(object_pool->objects) + 2)
+  /* limit memory usage.  In exclusive mode, park_object_ref does that. */
+  if (   !object_pool->exclusive
+      && svn_atomic_read(&object_pool->unused_count) * 2
+           > apr_hash_count(object_pool->objects) + 2)
     remove_unused_objects(object_pool);
 
   return SVN_NO_ERROR;
@@ -264,6 +347,7 @@ insert(void **object,
 svn_error_t *
 svn_object_pool__create(svn_object_pool__t **object_pool,
                         svn_boolean_t thread_safe,
+                        svn_boolean_t exclusive,
                         apr_pool_t *pool)
 {
   svn_object_pool__t *result;
@@ -272,8 +356,9 @@ svn_object_pool__create(svn_object_pool__t **object_pool,
    * cleanup and to prevent threading issues with the allocator
    */
   result = apr_pcalloc(pool, sizeof(*result));
-  SVN_ERR(svn_mutex__init(&result->mutex, thread_safe, pool));
+  SVN_ERR(svn_rwlock__init(&result->lock, thread_safe, pool));
 
+  result->exclusive = exclusive;
   result->pool = pool;
   result->objects = svn_hash__make(result->pool);
 
@@ -304,8 +389,14 @@ svn_object_pool__lookup(void **object,
                         apr_pool_t *result_pool)
 {
   *object = NULL;
-  SVN_MUTEX__WITH_LOCK(object_pool->mutex,
-                       lookup(object, object_pool, key, result_pool));
+  if (object_pool->exclusive)
+    SVN_RWLOCK__WITH_WRITE_LOCK(object_pool->lock,
+                                lookup(object, object_pool, key,
+                                       result_pool));
+  else
+    SVN_RWLOCK__WITH_READ_LOCK(object_pool->lock,
+                               lookup(object, object_pool, key,
+                                      result_pool));
   return SVN_NO_ERROR;
 }
 
@@ -318,8 +409,8 @@ svn_object_pool__insert(void **object,
                         apr_pool_t *result_pool)
 {
   *object = NULL;
-  SVN_MUTEX__WITH_LOCK(object_pool->mutex,
-                       insert(object, object_pool, key, item, 
-                              item_pool, result_pool));
+  SVN_RWLOCK__WITH_WRITE_LOCK(object_pool->lock,
+                              insert(object, object_pool, key, item,
+                                     item_pool, result_pool));
   return SVN_NO_ERROR;
 }
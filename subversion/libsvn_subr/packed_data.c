@@ -289,18 +289,18 @@ write_packed_uint_body(unsigned char *buffer, apr_uint64_t value)
 static apr_uint64_t
 remap_uint(apr_uint64_t value)
 {
-  return value & APR_UINT64_C(0x8000000000000000)
-       ? APR_UINT64_MAX - (2 * value)
-       : 2 * value;
+  /* Same as (MSB set ? APR_UINT64_MAX - 2 * VALUE : 2 * VALUE)
+   * but without branches. */
+  return (value << 1) ^ (0 - (value >> 63));
 }
 
 /* Invert remap_uint. */
 static apr_uint64_t
 unmap_uint(apr_uint64_t value)
 {
-  return value & 1
-       ? (APR_UINT64_MAX - value / 2)
-       : value / 2;
+  /* Same as (LSB set ? APR_UINT64_MAX - VALUE / 2 : VALUE / 2)
+   * but without branches. */
+  return (value >> 1) ^ (0 - (value & 1));
 }
 
 /* Empty the unprocessed integer buffer in STREAM by either pushing the
@@ -554,16 +554,19 @@ append_byte_stream(svn_packed__byte_stream_t *stream,
 
 /* Take the binary data in UNCOMPRESSED, zip it into COMPRESSED and write
  * it to STREAM.  COMPRESSED simply acts as a re-usable memory buffer.
+ * Use the optional preset DICTIONARY for compression.
  * Clear all buffers (COMPRESSED, UNCOMPRESSED) at the end of the function.
  */
 static svn_error_t *
 write_stream_data(svn_stream_t *stream,
                   svn_stringbuf_t *uncompressed,
-                  svn_stringbuf_t *compressed)
+                  svn_stringbuf_t *compressed,
+                  const svn_string_t *dictionary)
 {
-  SVN_ERR(svn__compress_zlib(uncompressed->data, uncompressed->len,
-                             compressed,
-                             SVN_DELTA_COMPRESSION_LEVEL_DEFAULT));
+  SVN_ERR(svn__compress_zlib_dict(uncompressed->data, uncompressed->len,
+                                  compressed,
+                                  SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                                  dictionary));
 
   SVN_ERR(write_stream_uint(stream, compressed->len));
   SVN_ERR(svn_stream_write(stream, compressed->data, &compressed->len));
@@ -575,9 +578,10 @@ write_stream_data(svn_stream_t *stream,
 }
 
 svn_error_t *
-svn_packed__data_write(svn_stream_t *stream,
-                       svn_packed__data_root_t *root,
-                       apr_pool_t *scratch_pool)
+svn_packed__data_write2(svn_stream_t *stream,
+                        svn_packed__data_root_t *root,
+                        const svn_string_t *dictionary,
+                        apr_pool_t *scratch_pool)
 {
   svn_packed__int_stream_t *int_stream;
   svn_packed__byte_stream_t *byte_stream;
@@ -611,7 +615,7 @@ svn_packed__data_write(svn_stream_t *stream,
       svn_stringbuf_ensure(uncompressed, len);
 
       append_int_stream(int_stream, uncompressed);
-      SVN_ERR(write_stream_data(stream, uncompressed, compressed));
+      SVN_ERR(write_stream_data(stream, uncompressed, compressed, NULL));
     }
 
   for (byte_stream = root->first_byte_stream;
@@ -622,12 +626,22 @@ svn_packed__data_write(svn_stream_t *stream,
       svn_stringbuf_ensure(uncompressed, len);
 
       append_byte_stream(byte_stream, uncompressed);
-      SVN_ERR(write_stream_data(stream, uncompressed, compressed));
+      SVN_ERR(write_stream_data(stream, uncompressed, compressed,
+                                dictionary));
     }
 
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_packed__data_write(svn_stream_t *stream,
+                       svn_packed__data_root_t *root,
+                       apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_packed__data_write2(stream, root, NULL,
+                                                 scratch_pool));
+}
+
 
 /* Read access. */
 
@@ -721,6 +735,45 @@ read_packed_uint_body(unsigned char *p, apr_uint64_t *result)
   return ++p;
 }
 
+/* Decode COUNT 7b/8b encoded values starting at P into BUFFER, storing
+ * the first value in BUFFER[COUNT-1] and the last one in BUFFER[0].
+ * Return the first position after the parsed data.
+ *
+ * The caller must ensure that reading 10 * COUNT bytes from P is safe.
+ */
+static unsigned char *
+read_packed_uints(unsigned char *p,
+                  apr_uint64_t *buffer,
+                  apr_size_t count)
+{
+#if SVN_UNALIGNED_ACCESS_IS_OK
+
+  /* The MSB of each byte in a machine word. */
+  const apr_size_t high_bits = ((apr_size_t)-1 / 0xff) * 0x80;
+
+  /* Most numbers in our streams are small.  If a whole machine word of
+   * input does not contain any MSB, it holds one single-byte value per
+   * byte and we can decode them in one go. */
+  while (count >= sizeof(apr_size_t))
+    if (*(const apr_size_t *)p & high_bits)
+      {
+        p = read_packed_uint_body(p, &buffer[--count]);
+      }
+    else
+      {
+        apr_size_t i;
+        for (i = 0; i < sizeof(apr_size_t); ++i)
+          buffer[--count] = *(p++);
+      }
+
+#endif
+
+  while (count > 0)
+    p = read_packed_uint_body(p, &buffer[--count]);
+
+  return p;
+}
+
 /* Read one 7b/8b encoded value from STREAM and return it in *RESULT.
  *
  * Overflows will be detected in the sense that it will end parsing the
@@ -823,8 +876,7 @@ svn_packed__data_fill_buffer(svn_packed__int_stream_t *stream)
 
       /* unpack numbers */
       start = p;
-      for (i = end; i > 0; --i)
-        p = read_packed_uint_body(p, &stream->buffer[i-1]);
+      p = read_packed_uints(p, stream->buffer, end);
 
       /* adjust remaining packed data buffer */
       packed_read = p - start;
@@ -959,13 +1011,15 @@ read_byte_stream_structure(svn_stringbuf_t *tree_struct,
 
 /* Read a compressed block from STREAM and uncompress it into UNCOMPRESSED.
  * UNCOMPRESSED_LEN is the expected size of the stream.  COMPRESSED is a
- * re-used buffer for temporary data.
+ * re-used buffer for temporary data.  DICTIONARY is the optional preset
+ * dictionary that the block has been compressed with.
  */
 static svn_error_t *
 read_stream_data(svn_stream_t *stream,
                  apr_size_t uncompressed_len,
                  svn_stringbuf_t *uncompressed,
-                 svn_stringbuf_t *compressed)
+                 svn_stringbuf_t *compressed,
+                 const svn_string_t *dictionary)
 {
   apr_uint64_t len;
   apr_size_t compressed_len;
@@ -978,8 +1032,9 @@ read_stream_data(svn_stream_t *stream,
   SVN_ERR(svn_stream_read_full(stream, compressed->data, &compressed->len));
   compressed->data[compressed_len] = '\0';
 
-  SVN_ERR(svn__decompress_zlib(compressed->data, compressed->len,
-                               uncompressed, uncompressed_len));
+  SVN_ERR(svn__decompress_zlib_dict(compressed->data, compressed->len,
+                                    uncompressed, uncompressed_len,
+                                    dictionary));
 
   return SVN_NO_ERROR;
 }
@@ -1033,10 +1088,11 @@ unflatten_byte_stream(svn_packed__byte_stream_t *stream,
 }
 
 svn_error_t *
-svn_packed__data_read(svn_packed__data_root_t **root_p,
-                      svn_stream_t *stream,
-                      apr_pool_t *result_pool,
-                      apr_pool_t *scratch_pool)
+svn_packed__data_read2(svn_packed__data_root_t **root_p,
+                       svn_stream_t *stream,
+                       const svn_string_t *dictionary,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
 {
   apr_uint64_t i;
   apr_uint64_t count;
@@ -1086,7 +1142,7 @@ svn_packed__data_read(svn_packed__data_root_t **root_p,
       apr_size_t offset = 0;
       SVN_ERR(read_stream_data(stream,
                                packed_int_stream_length(int_stream),
-                               uncompressed, compressed));
+                               uncompressed, compressed, NULL));
       unflatten_int_stream(int_stream, uncompressed, &offset);
     }
 
@@ -1097,10 +1153,20 @@ svn_packed__data_read(svn_packed__data_root_t **root_p,
       apr_size_t offset = 0;
       SVN_ERR(read_stream_data(stream,
                                packed_byte_stream_length(byte_stream),
-                               uncompressed, compressed));
+                               uncompressed, compressed, dictionary));
       unflatten_byte_stream(byte_stream, uncompressed, &offset);
     }
 
   *root_p = root;
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_packed__data_read(svn_packed__data_root_t **root_p,
+                      svn_stream_t *stream,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_packed__data_read2(root_p, stream, NULL,
+                                                result_pool, scratch_pool));
+}
@@ -30,15 +30,19 @@
 #include <apr_version.h>
 #include <apr_general.h>
 #include <apr_pools.h>
+#include <apr_strings.h>
+#include <apr_thread_mutex.h>
 
 #include "svn_pools.h"
+#include "svn_string.h"
+#include "svn_sorts.h"
 
 #include "pools.h"
+#include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
 
-#if APR_POOL_DEBUG
 /* file_line for the non-debug case. */
 static const char SVN_FILE_LINE_UNDEFINED[] = "svn:<undefined>";
-#endif /* APR_POOL_DEBUG */
 
 
 
@@ -66,26 +70,239 @@ abort_on_pool_failure(int retcode)
 }
 
 
+
+/*-----------------------------------------------------------------*/
+
+/* Pool usage statistics, see svn_pool__stats_enable(). */
+
+/* Number of buckets in our hash of creation sites.  Power of two. */
+#define SITE_BUCKETS 1024
+
+/* Usage statistics for all pools created at the same source location.
+ */
+typedef struct pool_site_t
+{
+  /* Creation site as "file:line".  Identifies this site by address. */
+  const char *file_line;
+
+  /* Number of pools created at this site. */
+  apr_uint64_t created;
+
+  /* Number of those pools that got cleared or destroyed.  Only the first
+   * of these events is being counted per pool. */
+  apr_uint64_t released;
+
+  /* Sum and maximum of the pools' sizes when released.  Only available
+   * with APR pool debugging. */
+  apr_uint64_t total_bytes;
+  apr_uint64_t peak_bytes;
+
+  /* Next site in the same bucket. */
+  struct pool_site_t *next;
+} pool_site_t;
+
+/* Per-pool data, allocated in the pool itself. */
+typedef struct pool_tracker_t
+{
+  apr_pool_t *pool;
+  pool_site_t *site;
+} pool_tracker_t;
+
+/* Set once by svn_pool__stats_enable(). */
+static svn_boolean_t stats_enabled = FALSE;
+
+/* All creation sites seen so far, allocated with malloc() and never
+ * released. */
+static pool_site_t *site_buckets[SITE_BUCKETS];
+
+#if APR_HAS_THREADS
+/* Serializes access to SITE_BUCKETS and its contents. */
+static apr_thread_mutex_t *stats_mutex = NULL;
+#endif
+
+static void
+lock_stats(void)
+{
+#if APR_HAS_THREADS
+  apr_thread_mutex_lock(stats_mutex);
+#endif
+}
+
+static void
+unlock_stats(void)
+{
+#if APR_HAS_THREADS
+  apr_thread_mutex_unlock(stats_mutex);
+#endif
+}
+
+/* Return the statistics for FILE_LINE, auto-creating them as needed.
+ * The caller must hold the lock.
+ */
+static pool_site_t *
+get_site(const char *file_line)
+{
+  apr_size_t bucket = ((apr_uintptr_t)file_line >> 3) % SITE_BUCKETS;
+  pool_site_t *site;
+
+  for (site = site_buckets[bucket]; site; site = site->next)
+    if (site->file_line == file_line)
+      return site;
+
+  site = calloc(1, sizeof(*site));
+  if (!site)
+    abort_on_pool_failure(APR_ENOMEM);
+
+  site->file_line = file_line;
+  site->next = site_buckets[bucket];
+  site_buckets[bucket] = site;
+
+  return site;
+}
+
+/* Pool pre-cleanup function recording the release of the pool described
+ * by the pool_tracker_t in BATON.  As APR drops all cleanups when clearing
+ * a pool, this runs at most once per pool.
+ */
+static apr_status_t
+release_pool(void *baton)
+{
+  pool_tracker_t *tracker = baton;
 #if APR_POOL_DEBUG
+  apr_uint64_t bytes = apr_pool_num_bytes(tracker->pool, FALSE);
+#else
+  apr_uint64_t bytes = 0;
+#endif
+
+  lock_stats();
+  tracker->site->released++;
+  tracker->site->total_bytes += bytes;
+  tracker->site->peak_bytes = MAX(tracker->site->peak_bytes, bytes);
+  unlock_stats();
+
+  return APR_SUCCESS;
+}
+
+/* Account for the new POOL created at FILE_LINE, if statistics have been
+ * enabled.
+ */
+static void
+track_pool(apr_pool_t *pool,
+           const char *file_line)
+{
+  pool_tracker_t *tracker;
+
+  if (!stats_enabled)
+    return;
+
+  tracker = apr_palloc(pool, sizeof(*tracker));
+  tracker->pool = pool;
+
+  lock_stats();
+  tracker->site = get_site(file_line);
+  tracker->site->created++;
+  unlock_stats();
+
+  apr_pool_pre_cleanup_register(pool, tracker, release_pool);
+}
+
+void
+svn_pool__stats_enable(void)
+{
+  if (stats_enabled)
+    return;
+
+#if APR_HAS_THREADS
+  apr_thread_mutex_create(&stats_mutex, APR_THREAD_MUTEX_DEFAULT,
+                          svn_pool__create_unmanaged(FALSE));
+#endif
+
+  stats_enabled = TRUE;
+}
+
+/* Sort callback for qsort(), putting the largest consumers first.
+ */
+static int
+compare_sites(const void *lhs, const void *rhs)
+{
+  const pool_site_t *lhs_site = *(const pool_site_t * const *)lhs;
+  const pool_site_t *rhs_site = *(const pool_site_t * const *)rhs;
+
+  if (lhs_site->peak_bytes != rhs_site->peak_bytes)
+    return lhs_site->peak_bytes < rhs_site->peak_bytes ? 1 : -1;
+  if (lhs_site->total_bytes != rhs_site->total_bytes)
+    return lhs_site->total_bytes < rhs_site->total_bytes ? 1 : -1;
+  if (lhs_site->created != rhs_site->created)
+    return lhs_site->created < rhs_site->created ? 1 : -1;
+
+  return 0;
+}
+
+svn_string_t *
+svn_pool__stats_format(int limit,
+                       apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(result_pool);
+  apr_array_header_t *sites = apr_array_make(result_pool, 64,
+                                             sizeof(pool_site_t *));
+  int i;
+
+  if (!stats_enabled)
+    return svn_stringbuf__morph_into_string(result);
+
+  lock_stats();
+  for (i = 0; i < SITE_BUCKETS; ++i)
+    {
+      pool_site_t *site;
+      for (site = site_buckets[i]; site; site = site->next)
+        {
+          pool_site_t *copy = apr_pmemdup(result_pool, site, sizeof(*site));
+          APR_ARRAY_PUSH(sites, pool_site_t *) = copy;
+        }
+    }
+  unlock_stats();
+
+  qsort(sites->elts, sites->nelts, sites->elt_size, compare_sites);
+
+  svn_stringbuf_appendcstr(result,
+                           "   created   released    peak kB   total kB"
+                           "  site\n");
+  for (i = 0; i < sites->nelts && (limit <= 0 || i < limit); ++i)
+    {
+      const pool_site_t *site = APR_ARRAY_IDX(sites, i, pool_site_t *);
+      svn_stringbuf_appendcstr(result,
+        apr_psprintf(result_pool,
+                     "%10" APR_UINT64_T_FMT " %10" APR_UINT64_T_FMT
+                     " %10" APR_UINT64_T_FMT " %10" APR_UINT64_T_FMT
+                     "  %s\n",
+                     site->created, site->released,
+                     site->peak_bytes / 1024, site->total_bytes / 1024,
+                     site->file_line));
+    }
+
+  return svn_stringbuf__morph_into_string(result);
+}
+
+
 #undef svn_pool_create_ex
-#endif /* APR_POOL_DEBUG */
 
 #if !APR_POOL_DEBUG
 
 apr_pool_t *
 svn_pool_create_ex(apr_pool_t *parent_pool, apr_allocator_t *allocator)
 {
-  apr_pool_t *pool;
-  apr_pool_create_ex(&pool, parent_pool, abort_on_pool_failure, allocator);
-  return pool;
+  return svn_pool_create_ex_debug(parent_pool, allocator,
+                                  SVN_FILE_LINE_UNDEFINED);
 }
 
-/* Wrapper that ensures binary compatibility */
 apr_pool_t *
-svn_pool_create_ex_debug(apr_pool_t *pool, apr_allocator_t *allocator,
+svn_pool_create_ex_debug(apr_pool_t *parent_pool, apr_allocator_t *allocator,
                          const char *file_line)
 {
-  return svn_pool_create_ex(pool, allocator);
+  apr_pool_t *pool;
+  apr_pool_create_ex(&pool, parent_pool, abort_on_pool_failure, allocator);
+  track_pool(pool, file_line);
+  return pool;
 }
 
 #else /* APR_POOL_DEBUG */
@@ -97,6 +314,7 @@ svn_pool_create_ex_debug(apr_pool_t *parent_pool, apr_allocator_t *allocator,
   apr_pool_t *pool;
   apr_pool_create_ex_debug(&pool, parent_pool, abort_on_pool_failure,
                            allocator, file_line);
+  track_pool(pool, file_line);
   return pool;
 }
 
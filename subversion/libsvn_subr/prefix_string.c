@@ -92,6 +92,9 @@ struct svn_prefix_tree__t
 
   /* all sub-nodes & strings will be allocated from this pool */
   apr_pool_t *pool;
+
+  /* number of strings stored in this tree */
+  apr_size_t count;
 };
 
 /* Return TRUE, iff NODE is a leaf node.
@@ -170,9 +173,14 @@ svn_prefix_tree__create(apr_pool_t *pool)
   return tree;
 }
 
-svn_prefix_string__t *
-svn_prefix_string__create(svn_prefix_tree__t *tree,
-                          const char *s)
+/* Return the string with value S in TREE.  If no such string exists yet,
+ * add it if INSERT is set, otherwise return NULL.  TREE will not be
+ * modified unless S gets inserted.
+ */
+static svn_prefix_string__t *
+lookup(svn_prefix_tree__t *tree,
+       const char *s,
+       svn_boolean_t insert)
 {
   svn_prefix_string__t *new_string;
   apr_size_t len = strlen(s);
@@ -224,6 +232,10 @@ svn_prefix_string__create(svn_prefix_tree__t *tree,
             }
         }
 
+      /* S is not in TREE. */
+      if (!insert)
+        return NULL;
+
       /* partial match -> split
        *
        * At this point, S may either be a prefix to the string represented
@@ -254,6 +266,9 @@ svn_prefix_string__create(svn_prefix_tree__t *tree,
       node = new_node;
     }
 
+  if (!insert)
+    return NULL;
+
   /* add sub-node(s) and final string */
   while (len - node->length > 7)
     {
@@ -283,9 +298,32 @@ svn_prefix_string__create(svn_prefix_tree__t *tree,
 
   node->sub_nodes[idx] = (node_t *)new_string;
   node->sub_node_count++;
+  tree->count++;
+
   return new_string;
 }
 
+svn_prefix_string__t *
+svn_prefix_string__create(svn_prefix_tree__t *tree,
+                          const char *s)
+{
+  return lookup(tree, s, TRUE);
+}
+
+svn_prefix_string__t *
+svn_prefix_string__find(const svn_prefix_tree__t *tree,
+                        const char *s)
+{
+  /* Casting away const is safe because lookup() won't modify TREE. */
+  return lookup((svn_prefix_tree__t *)tree, s, FALSE);
+}
+
+apr_size_t
+svn_prefix_tree__count(const svn_prefix_tree__t *tree)
+{
+  return tree->count;
+}
+
 svn_string_t *
 svn_prefix_string__expand(const svn_prefix_string__t *s,
                           apr_pool_t *pool)
@@ -0,0 +1,361 @@
+/*
+ * sha1.c :  SHA-1 checksum routines, using the CPU's SHA instructions
+ *           where available
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr.h>
+
+#include "private/svn_subr_private.h"
+#include "sha1.h"
+
+/* The x86 SHA extensions can be used with any compiler that supports
+ * per-function target attributes, without special compiler flags for
+ * the whole file.  We only call them after checking CPUID.
+ */
+#if !defined(SVN_DISABLE_SHA_NI) \
+    && (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) \
+        || (defined(__GNUC__) \
+            && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SVN_SHA1__SHA_NI
+#include <immintrin.h>
+#endif
+
+/* Size of the SHA-1 input blocks. */
+#define BLOCK_SIZE 64
+
+/* Process COUNT consecutive BLOCK_SIZE blocks of DATA and update STATE
+ * accordingly. */
+typedef void (*sha1_blocks_func_t)(apr_uint32_t state[5],
+                                   const unsigned char *data,
+                                   apr_size_t count);
+
+struct svn_sha1__context_t
+{
+  /* Intermediate hash value. */
+  apr_uint32_t state[5];
+
+  /* Number of bytes fed into the context so far. */
+  apr_uint64_t length;
+
+  /* Incomplete last input block.  Its size is LENGTH % BLOCK_SIZE. */
+  unsigned char buffer[BLOCK_SIZE];
+
+  /* Block processing implementation to use. */
+  sha1_blocks_func_t blocks;
+};
+
+#define ROL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+/* Read a big-endian 32 bit value from P. */
+static APR_INLINE apr_uint32_t
+load_be32(const unsigned char *p)
+{
+  return ((apr_uint32_t)p[0] << 24) | ((apr_uint32_t)p[1] << 16)
+       | ((apr_uint32_t)p[2] << 8) | (apr_uint32_t)p[3];
+}
+
+/* Write VALUE as big-endian 32 bit value to P. */
+static APR_INLINE void
+store_be32(unsigned char *p, apr_uint32_t value)
+{
+  p[0] = (unsigned char)(value >> 24);
+  p[1] = (unsigned char)(value >> 16);
+  p[2] = (unsigned char)(value >> 8);
+  p[3] = (unsigned char)value;
+}
+
+/* Portable implementation of sha1_blocks_func_t. */
+static void
+sha1_blocks_generic(apr_uint32_t state[5],
+                    const unsigned char *data,
+                    apr_size_t count)
+{
+  for (; count; --count, data += BLOCK_SIZE)
+    {
+      apr_uint32_t w[80];
+      apr_uint32_t a = state[0];
+      apr_uint32_t b = state[1];
+      apr_uint32_t c = state[2];
+      apr_uint32_t d = state[3];
+      apr_uint32_t e = state[4];
+      int i;
+
+      for (i = 0; i < 16; ++i)
+        w[i] = load_be32(data + 4 * i);
+      for (; i < 80; ++i)
+        w[i] = ROL32(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+
+      for (i = 0; i < 80; ++i)
+        {
+          apr_uint32_t f, k, temp;
+          if (i < 20)
+            {
+              f = (b & c) | (~b & d);
+              k = 0x5a827999;
+            }
+          else if (i < 40)
+            {
+              f = b ^ c ^ d;
+              k = 0x6ed9eba1;
+            }
+          else if (i < 60)
+            {
+              f = (b & c) | (b & d) | (c & d);
+              k = 0x8f1bbcdc;
+            }
+          else
+            {
+              f = b ^ c ^ d;
+              k = 0xca62c1d6;
+            }
+
+          temp = ROL32(a, 5) + f + e + k + w[i];
+          e = d;
+          d = c;
+          c = ROL32(b, 30);
+          b = a;
+          a = temp;
+        }
+
+      state[0] += a;
+      state[1] += b;
+      state[2] += c;
+      state[3] += d;
+      state[4] += e;
+    }
+}
+
+#ifdef SVN_SHA1__SHA_NI
+
+/* Four rounds of SHA-1 for the schedule words in M0, updating the message
+ * schedule M1 to M3 for later rounds.  EA and EB alternate between calls.
+ * F selects the round function and constant. */
+#define SHA_NI_ROUNDS(ea, eb, m0, m1, m2, m3, f) \
+  do { \
+    ea = _mm_sha1nexte_epu32(ea, m0); \
+    eb = abcd; \
+    m1 = _mm_sha1msg2_epu32(m1, m0); \
+    abcd = _mm_sha1rnds4_epu32(abcd, ea, f); \
+    m3 = _mm_sha1msg1_epu32(m3, m0); \
+    m2 = _mm_xor_si128(m2, m0); \
+  } while (0)
+
+/* Implementation of sha1_blocks_func_t using the SHA instruction set
+ * extension. */
+__attribute__((target("sha,sse4.1")))
+static void
+sha1_blocks_sha_ni(apr_uint32_t state[5],
+                   const unsigned char *data,
+                   apr_size_t count)
+{
+  const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL,
+                                      0x08090a0b0c0d0e0fULL);
+  __m128i abcd, abcd_save, e0, e0_save, e1;
+  __m128i msg0, msg1, msg2, msg3;
+
+  abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0x1b);
+  e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+  for (; count; --count, data += BLOCK_SIZE)
+    {
+      abcd_save = abcd;
+      e0_save = e0;
+
+      /* Rounds 0 to 15 load the message words. */
+      msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data), mask);
+      e0 = _mm_add_epi32(e0, msg0);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+      msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)),
+                              mask);
+      e1 = _mm_sha1nexte_epu32(e1, msg1);
+      e0 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+      msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+
+      msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)),
+                              mask);
+      e0 = _mm_sha1nexte_epu32(e0, msg2);
+      e1 = abcd;
+      abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+      msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+      msg0 = _mm_xor_si128(msg0, msg2);
+
+      msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)),
+                              mask);
+      SHA_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 0);
+
+      /* Rounds 16 to 79. */
+      SHA_NI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 0);
+      SHA_NI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 1);
+      SHA_NI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 1);
+      SHA_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 1);
+      SHA_NI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 1);
+      SHA_NI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 1);
+      SHA_NI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 2);
+      SHA_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 2);
+      SHA_NI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 2);
+      SHA_NI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 2);
+      SHA_NI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 2);
+      SHA_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 3);
+      SHA_NI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 3);
+      SHA_NI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 3);
+      SHA_NI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 3);
+      SHA_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 3);
+
+      /* Add this block's result to the state. */
+      e0 = _mm_sha1nexte_epu32(e0, e0_save);
+      abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+
+  _mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = (apr_uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+#undef SHA_NI_ROUNDS
+
+#endif /* SVN_SHA1__SHA_NI */
+
+/* Return the fastest sha1_blocks_func_t supported by this machine. */
+static sha1_blocks_func_t
+get_blocks_func(void)
+{
+  /* Concurrent initialization is harmless as all threads will come to
+   * the same result. */
+  static sha1_blocks_func_t func = NULL;
+  if (func == NULL)
+    {
+#ifdef SVN_SHA1__SHA_NI
+      /* Besides the SHA instructions, we use SSSE3 and SSE4.1 ones. */
+      func = svn_cpu__has_features(svn_cpu__sha | svn_cpu__ssse3
+                                   | svn_cpu__sse41)
+           ? sha1_blocks_sha_ni
+           : sha1_blocks_generic;
+#else
+      func = sha1_blocks_generic;
+#endif
+    }
+
+  return func;
+}
+
+svn_sha1__context_t *
+svn_sha1__context_create(apr_pool_t *pool)
+{
+  svn_sha1__context_t *context = apr_palloc(pool, sizeof(*context));
+  svn_sha1__context_reset(context);
+
+  return context;
+}
+
+void
+svn_sha1__context_reset(svn_sha1__context_t *context)
+{
+  context->state[0] = 0x67452301;
+  context->state[1] = 0xefcdab89;
+  context->state[2] = 0x98badcfe;
+  context->state[3] = 0x10325476;
+  context->state[4] = 0xc3d2e1f0;
+  context->length = 0;
+  context->blocks = get_blocks_func();
+}
+
+void
+svn_sha1__update(svn_sha1__context_t *context,
+                 const void *data,
+                 apr_size_t len)
+{
+  const unsigned char *input = data;
+  apr_size_t buffered = (apr_size_t)(context->length % BLOCK_SIZE);
+
+  context->length += len;
+
+  /* Complete a partial block from previous calls first. */
+  if (buffered)
+    {
+      apr_size_t to_copy = BLOCK_SIZE - buffered;
+      if (to_copy > len)
+        {
+          memcpy(context->buffer + buffered, input, len);
+          return;
+        }
+
+      memcpy(context->buffer + buffered, input, to_copy);
+      context->blocks(context->state, context->buffer, 1);
+      input += to_copy;
+      len -= to_copy;
+    }
+
+  /* Process all full blocks directly from the input. */
+  if (len >= BLOCK_SIZE)
+    {
+      context->blocks(context->state, input, len / BLOCK_SIZE);
+      input += len - len % BLOCK_SIZE;
+      len %= BLOCK_SIZE;
+    }
+
+  /* Keep the rest for later. */
+  memcpy(context->buffer, input, len);
+}
+
+void
+svn_sha1__finalize(unsigned char digest[SVN_SHA1__DIGESTSIZE],
+                   svn_sha1__context_t *context)
+{
+  apr_uint64_t bit_length = context->length * 8;
+  apr_size_t buffered = (apr_size_t)(context->length % BLOCK_SIZE);
+  int i;
+
+  /* Append the '1' bit and pad with zeros up to the length field. */
+  context->buffer[buffered++] = 0x80;
+  if (buffered > BLOCK_SIZE - 8)
+    {
+      memset(context->buffer + buffered, 0, BLOCK_SIZE - buffered);
+      context->blocks(context->state, context->buffer, 1);
+      buffered = 0;
+    }
+
+  memset(context->buffer + buffered, 0, BLOCK_SIZE - 8 - buffered);
+  store_be32(context->buffer + BLOCK_SIZE - 8,
+             (apr_uint32_t)(bit_length >> 32));
+  store_be32(context->buffer + BLOCK_SIZE - 4, (apr_uint32_t)bit_length);
+  context->blocks(context->state, context->buffer, 1);
+
+  for (i = 0; i < 5; ++i)
+    store_be32(digest + 4 * i, context->state[i]);
+}
+
+void
+svn_sha1__digest(unsigned char digest[SVN_SHA1__DIGESTSIZE],
+                 const void *data,
+                 apr_size_t len)
+{
+  svn_sha1__context_t context;
+
+  svn_sha1__context_reset(&context);
+  svn_sha1__update(&context, data, len);
+  svn_sha1__finalize(digest, &context);
+}
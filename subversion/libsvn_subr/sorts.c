@@ -27,8 +27,10 @@
 #include <apr_hash.h>
 #include <apr_tables.h>
 #include <stdlib.h>       /* for qsort()   */
+#include <string.h>
 #include <assert.h>
 #include "svn_hash.h"
+#include "svn_pools.h"
 #include "svn_path.h"
 #include "svn_sorts.h"
 #include "svn_error.h"
@@ -134,12 +136,258 @@ svn_sort_compare_ranges(const void *a, const void *b)
   return item1->start < item2->start ? -1 : 1;
 }
 
+
+/*** Radix sort for string keys. ***/
+
+/* qsort() has to compare full keys O(N log N) times, and paths within
+   the same tree tend to share long prefixes.  For large arrays sorted
+   by one of our well-known string orderings, a most-significant-digit
+   radix sort looks at every key byte only about once. */
+
+/* Arrays with fewer elements than this will be sorted with qsort(). */
+#define RADIX_SORT_THRESHOLD 256
+
+/* Buckets smaller than this will be sorted by insertion sort. */
+#define RADIX_SORT_SMALL 16
+
+/* Number of buckets: one for "end of key" plus one per byte value. */
+#define RADIX_BUCKETS 257
+
+/* A key to sort plus the position of its array element. */
+typedef struct radix_entry_t
+{
+  const unsigned char *key;
+  apr_size_t len;
+  int index;
+} radix_entry_t;
+
+/* Mapping of key bytes to bucket numbers, i.e. to their rank within the
+   ordering.  Bucket 0 is reserved for keys that end before the current
+   position. */
+typedef struct radix_order_t
+{
+  unsigned short rank[256];
+} radix_order_t;
+
+/* Initialize ORDER for plain lexical byte order or, if PATH_ORDER is
+   set, for the order of svn_path_compare_paths(), which sorts '/' before
+   all other characters. */
+static void
+init_radix_order(radix_order_t *order,
+                 svn_boolean_t path_order)
+{
+  int c;
+
+  for (c = 0; c < 256; ++c)
+    if (!path_order)
+      order->rank[c] = (unsigned short)(c + 1);
+    else if (c == '/')
+      order->rank[c] = 1;
+    else
+      order->rank[c] = (unsigned short)(c < '/' ? c + 1 : c);
+}
+
+/* Return the bucket of ENTRY's key at byte position DEPTH in ORDER. */
+static APR_INLINE unsigned int
+radix_bucket(const radix_entry_t *entry,
+             apr_size_t depth,
+             const radix_order_t *order)
+{
+  return depth < entry->len ? order->rank[entry->key[depth]] : 0;
+}
+
+/* Compare the keys of LHS and RHS, which are known to be equal in their
+   first DEPTH bytes, according to ORDER. */
+static int
+compare_radix_entries(const radix_entry_t *lhs,
+                      const radix_entry_t *rhs,
+                      apr_size_t depth,
+                      const radix_order_t *order)
+{
+  for (; ; ++depth)
+    {
+      unsigned int lhs_bucket = radix_bucket(lhs, depth, order);
+      unsigned int rhs_bucket = radix_bucket(rhs, depth, order);
+
+      if (lhs_bucket != rhs_bucket)
+        return lhs_bucket < rhs_bucket ? -1 : 1;
+      if (lhs_bucket == 0)
+        return 0;
+    }
+}
+
+/* Sort the COUNT ENTRIES, whose keys are all equal in their first DEPTH
+   bytes, by their keys according to ORDER.  TEMP provides scratch space
+   for COUNT entries. */
+static void
+radix_sort(radix_entry_t *entries,
+           radix_entry_t *temp,
+           int count,
+           apr_size_t depth,
+           const radix_order_t *order)
+{
+  int buckets[RADIX_BUCKETS];
+  int i, b;
+
+  while (count >= RADIX_SORT_SMALL)
+    {
+      int start;
+
+      memset(buckets, 0, sizeof(buckets));
+      for (i = 0; i < count; ++i)
+        ++buckets[radix_bucket(&entries[i], depth, order)];
+
+      /* Long common prefixes don't need any shuffling. */
+      b = radix_bucket(&entries[0], depth, order);
+      if (buckets[b] == count)
+        {
+          /* All keys ended, i.e. they are all equal. */
+          if (b == 0)
+            return;
+
+          ++depth;
+          continue;
+        }
+
+      /* Turn the counts into start positions and distribute. */
+      for (start = 0, b = 0; b < RADIX_BUCKETS; ++b)
+        {
+          int size = buckets[b];
+          buckets[b] = start;
+          start += size;
+        }
+
+      for (i = 0; i < count; ++i)
+        temp[buckets[radix_bucket(&entries[i], depth, order)]++]
+          = entries[i];
+      memcpy(entries, temp, count * sizeof(*entries));
+
+      /* Keys in bucket 0 ended and are equal.  Sort all other buckets
+         by their next byte.  BUCKETS[B] is now the end of bucket B. */
+      for (b = 1; b < RADIX_BUCKETS; ++b)
+        {
+          start = buckets[b - 1];
+          if (buckets[b] - start > 1)
+            radix_sort(entries + start, temp, buckets[b] - start,
+                       depth + 1, order);
+        }
+
+      return;
+    }
+
+  /* Insertion sort for small buckets. */
+  for (i = 1; i < count; ++i)
+    {
+      radix_entry_t entry = entries[i];
+      int k;
+
+      for (k = i;
+           k > 0 && compare_radix_entries(&entries[k - 1], &entry, depth,
+                                          order) > 0;
+           --k)
+        entries[k] = entries[k - 1];
+
+      entries[k] = entry;
+    }
+}
+
+/* Sort the elements of ARRAY by their string keys, which are given in
+   ENTRIES, according to ORDER.  Use SCRATCH_POOL for temporaries. */
+static void
+radix_sort_array(apr_array_header_t *array,
+                 radix_entry_t *entries,
+                 const radix_order_t *order,
+                 apr_pool_t *scratch_pool)
+{
+  radix_entry_t *temp = apr_palloc(scratch_pool,
+                                   array->nelts * sizeof(*temp));
+  char *elts = apr_palloc(scratch_pool, array->nelts * array->elt_size);
+  int i;
+
+  radix_sort(entries, temp, array->nelts, 0, order);
+
+  /* Apply the resulting permutation to the array elements. */
+  for (i = 0; i < array->nelts; ++i)
+    memcpy(elts + i * array->elt_size,
+           array->elts + entries[i].index * array->elt_size,
+           array->elt_size);
+  memcpy(array->elts, elts, array->nelts * array->elt_size);
+}
+
+/* If COMPARISON_FUNC is one of the string orderings that radix_sort()
+   supports and ARRAY is large enough to benefit from it, sort ARRAY
+   that way and return TRUE.  Otherwise, return FALSE. */
+static svn_boolean_t
+try_radix_sort(apr_array_header_t *array,
+               int (*comparison_func)(const void *, const void *))
+{
+  typedef int (*compare_func_t)(const void *, const void *);
+  svn_boolean_t items;
+  radix_order_t order;
+  radix_entry_t *entries;
+  apr_pool_t *scratch_pool;
+  int i;
+
+  if (array->nelts < RADIX_SORT_THRESHOLD)
+    return FALSE;
+
+  if (   comparison_func == svn_sort_compare_paths
+      && array->elt_size == sizeof(const char *))
+    {
+      items = FALSE;
+      init_radix_order(&order, TRUE);
+    }
+  else if (   comparison_func
+                == (compare_func_t)svn_sort_compare_items_as_paths
+           && array->elt_size == sizeof(svn_sort__item_t))
+    {
+      items = TRUE;
+      init_radix_order(&order, TRUE);
+    }
+  else if (   comparison_func
+                == (compare_func_t)svn_sort_compare_items_lexically
+           && array->elt_size == sizeof(svn_sort__item_t))
+    {
+      items = TRUE;
+      init_radix_order(&order, FALSE);
+    }
+  else
+    return FALSE;
+
+  scratch_pool = svn_pool_create(array->pool);
+  entries = apr_palloc(scratch_pool, array->nelts * sizeof(*entries));
+  for (i = 0; i < array->nelts; ++i)
+    {
+      if (items)
+        {
+          const svn_sort__item_t *item
+            = &APR_ARRAY_IDX(array, i, svn_sort__item_t);
+          entries[i].key = item->key;
+          entries[i].len = (apr_size_t)item->klen;
+        }
+      else
+        {
+          const char *path = APR_ARRAY_IDX(array, i, const char *);
+          entries[i].key = (const unsigned char *)path;
+          entries[i].len = strlen(path);
+        }
+
+      entries[i].index = i;
+    }
+
+  radix_sort_array(array, entries, &order, scratch_pool);
+  svn_pool_destroy(scratch_pool);
+
+  return TRUE;
+}
+
 void
 svn_sort__array(apr_array_header_t *array,
                 int (*comparison_func)(const void *,
                                        const void *))
 {
-  qsort(array->elts, array->nelts, array->elt_size, comparison_func);
+  if (!try_radix_sort(array, comparison_func))
+    qsort(array->elts, array->nelts, array->elt_size, comparison_func);
 }
 
 apr_array_header_t *
@@ -178,7 +426,7 @@ svn_sort__hash(apr_hash_t *ht,
         }
     }
 
-  /* quicksort the array if it isn't already sorted.  */
+  /* sort the array if it isn't already sorted.  */
   if (!sorted)
     svn_sort__array(ary,
           (int (*)(const void *, const void *))comparison_func);
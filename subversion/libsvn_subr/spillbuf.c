@@ -22,12 +22,20 @@
  */
 
 #include <apr_file_io.h>
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+#endif
 
 #include "svn_io.h"
 #include "svn_pools.h"
 
 #include "private/svn_subr_private.h"
 
+/* Size of each of the two buffers of a spill_writer_t. */
+#define SPILL_BUFFER_SIZE (256 * 1024)
+
 
 struct memblock_t {
   apr_size_t size;
@@ -87,8 +95,54 @@ struct svn_spillbuf_t {
 
   /* The name of the temporary spill file. */
   const char *filename;
+
+  /* Set if writes to the spill file should happen in the background. */
+  svn_boolean_t write_behind;
+
+  /* The thread writing to SPILL in the background, once started. */
+  struct spill_writer_t *writer;
 };
 
+#if APR_HAS_THREADS
+
+/* The background writer of a spill buffer.  Content to be appended to
+   the spill file collects in FILLING.  Once that is full, it is swapped
+   with FLUSHING and handed to the thread, which appends it to the file.
+
+   The thread holds MUTEX while it writes, and the owner of the spill
+   buffer holds it whenever it uses the spill file.  Thus, neither
+   ever sees the file position moved by the other. */
+typedef struct spill_writer_t
+{
+  char *filling;
+  apr_size_t filling_len;
+
+  /* Content handed to the thread, or 0 when the thread is idle. */
+  char *flushing;
+  apr_size_t flushing_len;
+
+  /* The first error of the thread, to be returned by the next write. */
+  svn_error_t *err;
+
+  /* Set when the thread should exit. */
+  svn_boolean_t stop;
+
+  /* The spill buffer; the thread writes to its SPILL. */
+  svn_spillbuf_t *buf;
+
+  apr_thread_mutex_t *mutex;
+
+  /* Signalled when content has been handed to the thread, or written. */
+  apr_thread_cond_t *cond;
+
+  apr_thread_t *thread;
+
+  /* Root pool for the thread's temporary allocations. */
+  apr_pool_t *pool;
+} spill_writer_t;
+
+#endif
+
 
 struct svn_spillbuf_reader_t {
   /* Embed the spill-buffer within the reader.  */
@@ -170,6 +224,18 @@ svn_spillbuf__create_extended(apr_size_t blocksize,
   return buf;
 }
 
+svn_spillbuf_t *
+svn_spillbuf__create_write_behind(apr_size_t blocksize,
+                                  apr_size_t maxsize,
+                                  apr_pool_t *result_pool)
+{
+  svn_spillbuf_t *buf = svn_spillbuf__create(blocksize, maxsize,
+                                             result_pool);
+
+  buf->write_behind = TRUE;
+  return buf;
+}
+
 svn_filesize_t
 svn_spillbuf__get_size(const svn_spillbuf_t *buf)
 {
@@ -230,6 +296,236 @@ return_buffer(svn_spillbuf_t *buf,
 }
 
 
+#if APR_HAS_THREADS
+
+/* Append LEN bytes at DATA to the spill file of BUF. */
+static svn_error_t *
+append_to_spill(svn_spillbuf_t *buf,
+                const char *data,
+                apr_size_t len,
+                apr_pool_t *scratch_pool)
+{
+  apr_off_t output_unused = 0;  /* ### stupid API  */
+
+  SVN_ERR(svn_io_file_seek(buf->spill, APR_END, &output_unused,
+                           scratch_pool));
+
+  return svn_error_trace(svn_io_file_write_full(buf->spill, data, len,
+                                                NULL, scratch_pool));
+}
+
+/* Implements apr_thread_start_t for the spill_writer_t at DATA. */
+static void * APR_THREAD_FUNC
+spill_writer_thread(apr_thread_t *tid, void *data)
+{
+  spill_writer_t *writer = data;
+
+  apr_thread_mutex_lock(writer->mutex);
+  while (TRUE)
+    {
+      svn_error_t *err;
+
+      while (!writer->stop && writer->flushing_len == 0)
+        apr_thread_cond_wait(writer->cond, writer->mutex);
+
+      if (writer->stop)
+        break;
+
+      err = append_to_spill(writer->buf, writer->flushing,
+                            writer->flushing_len, writer->pool);
+      svn_pool_clear(writer->pool);
+
+      if (err && !writer->err)
+        writer->err = err;
+      else
+        svn_error_clear(err);
+
+      writer->flushing_len = 0;
+      apr_thread_cond_broadcast(writer->cond);
+    }
+  apr_thread_mutex_unlock(writer->mutex);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Stop the thread of the spill_writer_t at DATA.  This is registered as
+   a pre-cleanup, so that it runs before the spill file is closed.
+   Implements apr_pool_cleanup_t. */
+static apr_status_t
+stop_spill_writer(void *data)
+{
+  spill_writer_t *writer = data;
+  apr_status_t retval;
+
+  apr_thread_mutex_lock(writer->mutex);
+  writer->stop = TRUE;
+  apr_thread_cond_broadcast(writer->cond);
+  apr_thread_mutex_unlock(writer->mutex);
+
+  apr_thread_join(&retval, writer->thread);
+
+  svn_error_clear(writer->err);
+  svn_pool_destroy(writer->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Start the background writer of BUF.  Leave BUF->writer NULL, and thus
+   write synchronously, if no thread is available. */
+static void
+start_spill_writer(svn_spillbuf_t *buf)
+{
+  spill_writer_t *writer = apr_pcalloc(buf->pool, sizeof(*writer));
+
+  writer->buf = buf;
+  if (apr_thread_mutex_create(&writer->mutex, APR_THREAD_MUTEX_DEFAULT,
+                              buf->pool)
+      || apr_thread_cond_create(&writer->cond, buf->pool))
+    return;
+
+  writer->pool = svn_pool_create(NULL);
+  if (apr_thread_create(&writer->thread, NULL, spill_writer_thread,
+                        writer, buf->pool))
+    {
+      svn_pool_destroy(writer->pool);
+      return;
+    }
+
+  writer->filling = apr_palloc(buf->pool, SPILL_BUFFER_SIZE);
+  writer->flushing = apr_palloc(buf->pool, SPILL_BUFFER_SIZE);
+
+  apr_pool_pre_cleanup_register(buf->pool, writer, stop_spill_writer);
+  buf->writer = writer;
+}
+
+/* Wait until the thread of WRITER is idle and return its error, if any.
+   The caller must hold the lock of WRITER. */
+static svn_error_t *
+wait_for_spill_writer(spill_writer_t *writer)
+{
+  svn_error_t *err;
+
+  while (writer->flushing_len > 0)
+    apr_thread_cond_wait(writer->cond, writer->mutex);
+
+  err = writer->err;
+  writer->err = NULL;
+
+  return err;
+}
+
+/* Append LEN bytes at DATA to the spill file of BUF, in the background
+   if possible.  BUF->spill_size must already include them. */
+static svn_error_t *
+write_behind(svn_spillbuf_t *buf,
+             const char *data,
+             apr_size_t len)
+{
+  spill_writer_t *writer;
+
+  if (buf->writer == NULL)
+    start_spill_writer(buf);
+
+  writer = buf->writer;
+  if (writer == NULL)
+    {
+      apr_pool_t *scratch_pool = svn_pool_create(buf->pool);
+
+      SVN_ERR(append_to_spill(buf, data, len, scratch_pool));
+      svn_pool_destroy(scratch_pool);
+
+      return SVN_NO_ERROR;
+    }
+
+  while (len > 0)
+    {
+      apr_size_t amt = SPILL_BUFFER_SIZE - writer->filling_len;
+      svn_error_t *err;
+      char *full;
+
+      if (amt > len)
+        amt = len;
+
+      memcpy(writer->filling + writer->filling_len, data, amt);
+      writer->filling_len += amt;
+      data += amt;
+      len -= amt;
+
+      if (writer->filling_len < SPILL_BUFFER_SIZE)
+        break;
+
+      /* Hand the full buffer to the thread, once it has written the
+         other one. */
+      apr_thread_mutex_lock(writer->mutex);
+      err = wait_for_spill_writer(writer);
+      if (!err)
+        {
+          full = writer->filling;
+          writer->filling = writer->flushing;
+          writer->flushing = full;
+          writer->flushing_len = writer->filling_len;
+          writer->filling_len = 0;
+          apr_thread_cond_broadcast(writer->cond);
+        }
+      apr_thread_mutex_unlock(writer->mutex);
+
+      SVN_ERR(err);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the next block of BUF from its spill file into MEM, while the
+   background writer of BUF may be appending to the file.  Write the
+   content that is still in memory first, if the file holds nothing
+   else that has not been read yet. */
+static svn_error_t *
+read_behind(struct memblock_t *mem,
+            svn_spillbuf_t *buf,
+            apr_pool_t *scratch_pool)
+{
+  spill_writer_t *writer = buf->writer;
+  svn_filesize_t unread;
+  apr_off_t offset = buf->spill_start;
+  svn_error_t *err;
+
+  apr_thread_mutex_lock(writer->mutex);
+
+  unread = buf->spill_size - writer->flushing_len - writer->filling_len;
+  if (unread == 0)
+    {
+      err = wait_for_spill_writer(writer);
+      if (!err)
+        err = append_to_spill(buf, writer->filling, writer->filling_len,
+                              scratch_pool);
+      if (err)
+        {
+          apr_thread_mutex_unlock(writer->mutex);
+          return svn_error_trace(err);
+        }
+
+      writer->filling_len = 0;
+      unread = buf->spill_size;
+    }
+
+  if ((apr_uint64_t)unread < (apr_uint64_t)buf->blocksize)
+    mem->size = (apr_size_t)unread;
+  else
+    mem->size = buf->blocksize;
+
+  err = svn_io_file_seek(buf->spill, APR_SET, &offset, scratch_pool);
+  if (!err)
+    err = svn_io_file_read_full2(buf->spill, mem->data, mem->size,
+                                 NULL, NULL, scratch_pool);
+
+  apr_thread_mutex_unlock(writer->mutex);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
 svn_error_t *
 svn_spillbuf__write(svn_spillbuf_t *buf,
                     const char *data,
@@ -273,6 +569,14 @@ svn_spillbuf__write(svn_spillbuf_t *buf,
         }
     }
 
+#if APR_HAS_THREADS
+  if (buf->spill != NULL && buf->write_behind)
+    {
+      buf->spill_size += len;
+      return svn_error_trace(write_behind(buf, data, len));
+    }
+#endif
+
   /* Once a spill file has been constructed, then we need to put all
      arriving data into the file. We will no longer attempt to hold it
      in memory.  */
@@ -391,6 +695,11 @@ read_data(struct memblock_t **mem,
   (*mem)->next = NULL;
 
   /* Read some data from the spill file into the memblock.  */
+#if APR_HAS_THREADS
+  if (buf->writer)
+    err = read_behind(*mem, buf, scratch_pool);
+  else
+#endif
   err = svn_io_file_read(buf->spill, (*mem)->data, &(*mem)->size,
                          scratch_pool);
   if (err)
@@ -423,7 +732,8 @@ maybe_seek(svn_boolean_t *seeked,
            const svn_spillbuf_t *buf,
            apr_pool_t *scratch_pool)
 {
-  if (buf->head == NULL && buf->spill != NULL)
+  /* With a background writer, every read seeks for itself. */
+  if (buf->head == NULL && buf->spill != NULL && buf->writer == NULL)
     {
       apr_off_t output_unused;
 
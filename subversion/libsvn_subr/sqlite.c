@@ -386,6 +386,12 @@ svn_sqlite__update(int *affected_rows, svn_sqlite__stmt_t *stmt)
   return svn_error_trace(svn_sqlite__reset(stmt));
 }
 
+int
+svn_sqlite__total_changes(svn_sqlite__db_t *db)
+{
+  return sqlite3_total_changes(db->db3);
+}
+
 
 static svn_error_t *
 vbindf(svn_sqlite__stmt_t *stmt, const char *fmt, va_list ap)
@@ -780,6 +786,105 @@ svn_sqlite__read_schema_version(int *version,
   return svn_error_trace(svn_sqlite__finalize(stmt));
 }
 
+/* Set *WAL to TRUE if DB uses write-ahead logging, and to FALSE
+   otherwise.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+uses_wal(svn_boolean_t *wal,
+         svn_sqlite__db_t *db,
+         apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(prepare_statement(&stmt, db, "PRAGMA journal_mode;", scratch_pool));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+
+  *wal = (strcmp(svn_sqlite__column_text(stmt, 0, NULL), "wal") == 0);
+
+  return svn_error_trace(svn_sqlite__finalize(stmt));
+}
+
+svn_error_t *
+svn_sqlite__set_wal(svn_boolean_t *wal,
+                    svn_sqlite__db_t *db,
+                    svn_boolean_t enable,
+                    apr_pool_t *scratch_pool)
+{
+  SVN_ERR(uses_wal(wal, db, scratch_pool));
+  if (*wal == enable)
+    return SVN_NO_ERROR;
+
+  /* SQLite silently keeps the old journal mode if the file system lacks
+     what WAL needs, and switching fails for read-only databases or while
+     other connections use DB.  None of that is fatal, so just check what
+     we got. */
+  svn_error_clear(exec_sql(db, enable ? "PRAGMA journal_mode = WAL;"
+                                      : "PRAGMA journal_mode = TRUNCATE;"));
+  SVN_ERR(uses_wal(wal, db, scratch_pool));
+
+  if (*wal)
+    {
+      /* Keep the log from staying large after checkpoints, which SQLite
+         runs automatically once it holds 1000 pages.  Readers get to map
+         the database, as WAL already rules out network file systems. */
+      SVN_ERR(exec_sql(db, "PRAGMA journal_size_limit = 4194304;"));
+      svn_error_clear(exec_sql(db, "PRAGMA mmap_size = 268435456;"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_sqlite__enable_incremental_vacuum(svn_sqlite__db_t *db)
+{
+  return svn_error_trace(exec_sql(db, "PRAGMA auto_vacuum = INCREMENTAL;"));
+}
+
+/* Set *VALUE to the integer returned by the PRAGMA statement SQL on DB.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_pragma_int(int *value,
+                svn_sqlite__db_t *db,
+                const char *sql,
+                apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(prepare_statement(&stmt, db, sql, scratch_pool));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+
+  *value = svn_sqlite__column_int(stmt, 0);
+
+  return svn_error_trace(svn_sqlite__finalize(stmt));
+}
+
+svn_error_t *
+svn_sqlite__incremental_vacuum(svn_boolean_t *supported,
+                               svn_boolean_t *done,
+                               svn_sqlite__db_t *db,
+                               int max_pages,
+                               apr_pool_t *scratch_pool)
+{
+  int mode;
+  int free_pages;
+
+  /* 2 means INCREMENTAL. */
+  SVN_ERR(read_pragma_int(&mode, db, "PRAGMA auto_vacuum;", scratch_pool));
+  *supported = (mode == 2);
+  *done = FALSE;
+  if (!*supported)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(exec_sql(db, apr_psprintf(scratch_pool,
+                                    "PRAGMA incremental_vacuum(%d);",
+                                    max_pages)));
+
+  SVN_ERR(read_pragma_int(&free_pages, db, "PRAGMA freelist_count;",
+                          scratch_pool));
+  *done = (free_pages == 0);
+
+  return SVN_NO_ERROR;
+}
+
 
 static volatile svn_atomic_t sqlite_init_state = 0;
 
@@ -1164,11 +1269,23 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  affects application(read: Subversion) performance/behavior. */
               "PRAGMA foreign_keys=OFF;"      /* SQLITE_DEFAULT_FOREIGN_KEYS*/
               "PRAGMA locking_mode = NORMAL;" /* SQLITE_DEFAULT_LOCKING_MODE */
-              /* Testing shows TRUNCATE is faster than DELETE on Windows. */
-              "PRAGMA journal_mode = TRUNCATE;"
               ),
                 *db);
 
+  /* Testing shows TRUNCATE is faster than DELETE on Windows.
+
+     But leave databases that were switched to write-ahead logging alone.
+     Leaving WAL mode requires that no other connection uses the database,
+     and whoever switched it knows better. */
+  {
+    svn_boolean_t wal;
+
+    SVN_SQLITE__ERR_CLOSE(uses_wal(&wal, *db, scratch_pool), *db);
+    if (!wal)
+      SVN_SQLITE__ERR_CLOSE(exec_sql(*db, "PRAGMA journal_mode = TRUNCATE;"),
+                            *db);
+  }
+
 #if defined(SVN_DEBUG)
   /* When running in debug mode, enable the checking of foreign key
      constraints.  This has possible performance implications, so we don't
@@ -424,6 +424,24 @@ svn_stringbuf_create_from_string(const svn_string_t *str, apr_pool_t *pool)
   return svn_stringbuf_ncreate(str->data, str->len, pool);
 }
 
+void
+svn_stringbuf__init(svn_stringbuf_t *strbuf,
+                    char *buffer,
+                    apr_size_t size,
+                    apr_pool_t *pool)
+{
+  /* svn_stringbuf_ensure() will copy the contents into a pool-allocated
+   * buffer once they outgrow BUFFER.  It never attempts to free or
+   * resize the old buffer, so BUFFER may live anywhere. */
+  assert(size > 0);
+
+  buffer[0] = '\0';
+  strbuf->pool = pool;
+  strbuf->data = buffer;
+  strbuf->len = 0;
+  strbuf->blocksize = size;
+}
+
 svn_stringbuf_t *
 svn_stringbuf_create_wrap(char *str, apr_pool_t *pool)
 {
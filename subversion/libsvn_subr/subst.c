@@ -1125,24 +1125,23 @@ translate_chunk(svn_stream_t *dst,
 
               if (b->keywords)
                 {
-                  /* Check 4 bytes at once to allow for efficient pipelining
-                    and to reduce loop condition overhead. */
-                  while ((end - p) >= (len + 4))
+                  /* Interesting chars are a subset of CR, LF and '$'.
+                     Skip to the next of those with our optimized
+                     sub-routine and check whether it really matters. */
+                  while ((p + len) < end)
                     {
-                      if (interesting[(unsigned char)p[len]]
-                          || interesting[(unsigned char)p[len+1]]
-                          || interesting[(unsigned char)p[len+2]]
-                          || interesting[(unsigned char)p[len+3]])
+                      const char *start = p + len;
+                      const char *next
+                        = svn_eol__find_eol_or_char((char *)start,
+                                                    end - start, '$');
+
+                      /* NEXT will be NULL if there is none of them left */
+                      len += (next ? next : end) - start;
+                      if (!next || interesting[(unsigned char)*next])
                         break;
 
-                      len += 4;
+                      ++len;
                     }
-
-                  /* Found an interesting char or EOF in the next 4 bytes.
-                     Find its exact position. */
-                  while ((p + len) < end
-                         && !interesting[(unsigned char)p[len]])
-                    ++len;
                 }
               else
                 {
@@ -167,6 +167,15 @@ svn_sysinfo__linked_libs(apr_pool_t *pool)
   lib->compiled_version = apr_pstrdup(pool, svn_zlib__compiled_version());
   lib->runtime_version = apr_pstrdup(pool, svn_zlib__runtime_version());
 
+  if (svn_zlib__libdeflate_version())
+    {
+      lib = &APR_ARRAY_PUSH(array, svn_version_ext_linked_lib_t);
+      lib->name = "libdeflate";
+      lib->compiled_version = apr_pstrdup(pool,
+                                          svn_zlib__libdeflate_version());
+      lib->runtime_version = NULL;
+    }
+
   return array;
 }
 
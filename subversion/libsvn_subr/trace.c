@@ -0,0 +1,452 @@
+/*
+ * trace.c :  recording and exporting request tracing spans
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+
+#include <apr_strings.h>
+#include <apr_thread_proc.h>
+
+#include "svn_pools.h"
+#include "svn_sorts.h"  /* get the MAX macro */
+#include "svn_string.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>   /* For getpid() */
+#endif
+
+#if APR_HAVE_PROCESS_H
+#include <process.h>
+#endif
+
+/* Maximum number of attributes per span.  Any further ones get dropped. */
+#define MAX_ATTRIBUTES 4
+
+/* Maximum length of an attribute value.  Longer values get truncated. */
+#define MAX_VALUE_LEN 63
+
+/* A span as stored in the global ring buffer.  It is self-contained,
+ * i.e. does not reference any pool memory. */
+typedef struct record_t
+{
+  /* Static name given to svn_trace__span_begin(). */
+  const char *name;
+
+  /* Thread that executed the span. */
+  apr_uint64_t thread;
+
+  /* Unique ID of this span within this process.  0 while not ended. */
+  apr_uint64_t id;
+
+  /* Begin and end timestamps. */
+  apr_time_t start;
+  apr_time_t end;
+
+  /* Attributes. */
+  int attribute_count;
+  const char *keys[MAX_ATTRIBUTES];
+  char values[MAX_ATTRIBUTES][MAX_VALUE_LEN + 1];
+} record_t;
+
+struct svn_trace__span_t
+{
+  /* The data to record when the span ends. */
+  record_t record;
+
+  /* Pool that SPAN has been allocated in and has a cleanup for it. */
+  apr_pool_t *pool;
+};
+
+/* Initialization status of this module. */
+static volatile svn_atomic_t init_status = 0;
+
+/* Non-zero after successful initialization. */
+static volatile svn_atomic_t enabled = 0;
+
+/* Serializes access to the variables below. */
+static svn_mutex__t *mutex = NULL;
+
+/* Ring buffer with room for CAPACITY records. */
+static record_t *records = NULL;
+static apr_size_t capacity = 0;
+
+/* Number of records stored so far. */
+static apr_uint64_t record_count = 0;
+
+/* Initialize the global state. BATON is the apr_size_t capacity. */
+static svn_error_t *
+init_trace(void *baton,
+           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  capacity = MAX(*(apr_size_t *)baton, 1);
+  records = apr_pcalloc(pool, capacity * sizeof(*records));
+  SVN_ERR(svn_mutex__init(&mutex, TRUE, pool));
+
+  svn_atomic_set(&enabled, 1);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_trace__enable(apr_size_t max_spans)
+{
+  return svn_error_trace(svn_atomic__init_once(&init_status, init_trace,
+                                               &max_spans, NULL));
+}
+
+svn_boolean_t
+svn_trace__is_enabled(void)
+{
+  return enabled != 0;
+}
+
+/* Return a number that identifies the current thread. */
+static apr_uint64_t
+current_thread(void)
+{
+#if APR_HAS_THREADS
+  return (apr_uint64_t)(apr_uintptr_t)apr_os_thread_current();
+#else
+  return 0;
+#endif
+}
+
+/* End SPAN now and copy it into the ring buffer. */
+static void
+store_span(svn_trace__span_t *span)
+{
+  svn_error_t *err;
+
+  span->record.end = apr_time_now();
+
+  err = svn_mutex__lock(mutex);
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  span->record.id = ++record_count;
+  records[(span->record.id - 1) % capacity] = span->record;
+
+  svn_error_clear(svn_mutex__unlock(mutex, SVN_NO_ERROR));
+}
+
+/* Pool cleanup ending the svn_trace__span_t in DATA. */
+static apr_status_t
+span_cleanup(void *data)
+{
+  store_span(data);
+  return APR_SUCCESS;
+}
+
+svn_trace__span_t *
+svn_trace__span_begin(const char *name,
+                      apr_pool_t *pool)
+{
+  svn_trace__span_t *span;
+
+  if (!enabled)
+    return NULL;
+
+  span = apr_palloc(pool, sizeof(*span));
+  span->record.name = name;
+  span->record.thread = current_thread();
+  span->record.id = 0;
+  span->record.attribute_count = 0;
+  span->pool = pool;
+
+  apr_pool_cleanup_register(pool, span, span_cleanup,
+                            apr_pool_cleanup_null);
+
+  /* Take the time last to not include our own overhead. */
+  span->record.start = apr_time_now();
+
+  return span;
+}
+
+void
+svn_trace__span_attr(svn_trace__span_t *span,
+                     const char *key,
+                     const char *value)
+{
+  int i;
+
+  if (!span || span->record.attribute_count == MAX_ATTRIBUTES)
+    return;
+
+  i = span->record.attribute_count++;
+  span->record.keys[i] = key;
+  apr_cpystrn(span->record.values[i], value ? value : "",
+              sizeof(span->record.values[i]));
+}
+
+void
+svn_trace__span_attr_int(svn_trace__span_t *span,
+                         const char *key,
+                         apr_int64_t value)
+{
+  int i;
+
+  if (!span || span->record.attribute_count == MAX_ATTRIBUTES)
+    return;
+
+  i = span->record.attribute_count++;
+  span->record.keys[i] = key;
+  apr_snprintf(span->record.values[i], sizeof(span->record.values[i]),
+               "%" APR_INT64_T_FMT, value);
+}
+
+void
+svn_trace__span_end(svn_trace__span_t *span)
+{
+  if (!span)
+    return;
+
+  apr_pool_cleanup_kill(span->pool, span, span_cleanup);
+  store_span(span);
+}
+
+/* Return a copy of all records currently in the ring buffer, oldest
+ * first, as an array of record_t allocated in RESULT_POOL. */
+static apr_array_header_t *
+get_records(apr_pool_t *result_pool)
+{
+  apr_array_header_t *result;
+  apr_uint64_t first, i;
+  svn_error_t *err;
+
+  if (!enabled)
+    return apr_array_make(result_pool, 0, sizeof(record_t));
+
+  err = svn_mutex__lock(mutex);
+  if (err)
+    {
+      svn_error_clear(err);
+      return apr_array_make(result_pool, 0, sizeof(record_t));
+    }
+
+  first = record_count > capacity ? record_count - capacity : 0;
+  result = apr_array_make(result_pool, (int)(record_count - first),
+                          sizeof(record_t));
+  for (i = first; i < record_count; ++i)
+    APR_ARRAY_PUSH(result, record_t) = records[i % capacity];
+
+  svn_error_clear(svn_mutex__unlock(mutex, SVN_NO_ERROR));
+
+  return result;
+}
+
+/* Append VALUE as a quoted JSON string to BUFFER. */
+static void
+append_json_string(svn_stringbuf_t *buffer,
+                   const char *value)
+{
+  svn_stringbuf_appendbyte(buffer, '"');
+  for (; *value; ++value)
+    {
+      unsigned char c = (unsigned char)*value;
+      if (c == '"' || c == '\\')
+        {
+          svn_stringbuf_appendbyte(buffer, '\\');
+          svn_stringbuf_appendbyte(buffer, c);
+        }
+      else if (c < 0x20)
+        {
+          char escaped[8];
+          apr_snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          svn_stringbuf_appendcstr(buffer, escaped);
+        }
+      else
+        {
+          svn_stringbuf_appendbyte(buffer, c);
+        }
+    }
+  svn_stringbuf_appendbyte(buffer, '"');
+}
+
+/* Return the ID of this process. */
+static apr_uint64_t
+process_id(void)
+{
+#if defined(WIN32) || (defined(HAVE_UNISTD_H) && defined(HAVE_GETPID))
+  return (apr_uint64_t)getpid();
+#else
+  return 0;
+#endif
+}
+
+/* Append the RECORDS in Chrome's trace event format to BUFFER. */
+static void
+format_chrome(svn_stringbuf_t *buffer,
+              const apr_array_header_t *records)
+{
+  apr_uint64_t pid = process_id();
+  int i, k;
+
+  svn_stringbuf_appendcstr(buffer, "{\"traceEvents\":[");
+  for (i = 0; i < records->nelts; ++i)
+    {
+      const record_t *record = &APR_ARRAY_IDX(records, i, record_t);
+
+      svn_stringbuf_appendcstr(buffer, i ? ",\n{\"name\":" : "\n{\"name\":");
+      append_json_string(buffer, record->name);
+      svn_stringbuf_appendcstr(buffer,
+          apr_psprintf(buffer->pool,
+                       ",\"cat\":\"svn\",\"ph\":\"X\""
+                       ",\"pid\":%" APR_UINT64_T_FMT
+                       ",\"tid\":%" APR_UINT64_T_FMT
+                       ",\"ts\":%" APR_INT64_T_FMT
+                       ",\"dur\":%" APR_INT64_T_FMT
+                       ",\"args\":{",
+                       pid, record->thread, (apr_int64_t)record->start,
+                       (apr_int64_t)(record->end - record->start)));
+
+      for (k = 0; k < record->attribute_count; ++k)
+        {
+          if (k)
+            svn_stringbuf_appendbyte(buffer, ',');
+          append_json_string(buffer, record->keys[k]);
+          svn_stringbuf_appendbyte(buffer, ':');
+          append_json_string(buffer, record->values[k]);
+        }
+
+      svn_stringbuf_appendcstr(buffer, "}}");
+    }
+  svn_stringbuf_appendcstr(buffer, "\n]}\n");
+}
+
+/* qsort comparison function ordering record_t by thread, then by start
+ * time and finally by descending end time, i.e. parents before their
+ * children. */
+static int
+compare_records(const void *lhs,
+                const void *rhs)
+{
+  const record_t *a = lhs;
+  const record_t *b = rhs;
+
+  if (a->thread != b->thread)
+    return a->thread < b->thread ? -1 : 1;
+  if (a->start != b->start)
+    return a->start < b->start ? -1 : 1;
+  if (a->end != b->end)
+    return a->end > b->end ? -1 : 1;
+
+  return 0;
+}
+
+/* Append the RECORDS as OTLP/JSON to BUFFER.  Nesting is reconstructed
+ * from the timestamps: the enclosing span of the same thread becomes the
+ * parent and the outermost one defines the trace ID. */
+static void
+format_otlp(svn_stringbuf_t *buffer,
+            apr_array_header_t *records)
+{
+  apr_uint64_t pid = process_id();
+  const record_t **stack
+    = apr_pcalloc(buffer->pool, (records->nelts + 1) * sizeof(*stack));
+  int depth = 0;
+  int i, k;
+
+  qsort(records->elts, records->nelts, records->elt_size, compare_records);
+
+  svn_stringbuf_appendcstr(buffer,
+      "{\"resourceSpans\":[{\"resource\":{\"attributes\":["
+      "{\"key\":\"service.name\",\"value\":{\"stringValue\":\"subversion\"}}"
+      "]},\"scopeSpans\":[{\"scope\":{\"name\":\"svn\"},\"spans\":[");
+
+  for (i = 0; i < records->nelts; ++i)
+    {
+      const record_t *record = &APR_ARRAY_IDX(records, i, record_t);
+      const record_t *parent;
+
+      /* Pop everything that does not enclose RECORD. */
+      if (i && stack[0]->thread != record->thread)
+        depth = 0;
+      while (depth && stack[depth - 1]->end < record->end)
+        --depth;
+
+      parent = depth ? stack[depth - 1] : NULL;
+      stack[depth++] = record;
+
+      svn_stringbuf_appendcstr(buffer, i ? ",\n{" : "\n{");
+      svn_stringbuf_appendcstr(buffer,
+          apr_psprintf(buffer->pool,
+                       "\"traceId\":\"%016" APR_UINT64_T_HEX_FMT
+                       "%016" APR_UINT64_T_HEX_FMT "\""
+                       ",\"spanId\":\"%016" APR_UINT64_T_HEX_FMT "\"",
+                       pid, stack[0]->id, record->id));
+      if (parent)
+        svn_stringbuf_appendcstr(buffer,
+            apr_psprintf(buffer->pool,
+                         ",\"parentSpanId\":\"%016" APR_UINT64_T_HEX_FMT "\"",
+                         parent->id));
+
+      svn_stringbuf_appendcstr(buffer, ",\"name\":");
+      append_json_string(buffer, record->name);
+      svn_stringbuf_appendcstr(buffer,
+          apr_psprintf(buffer->pool,
+                       ",\"kind\":1"
+                       ",\"startTimeUnixNano\":\"%" APR_INT64_T_FMT "000\""
+                       ",\"endTimeUnixNano\":\"%" APR_INT64_T_FMT "000\""
+                       ",\"attributes\":[",
+                       (apr_int64_t)record->start,
+                       (apr_int64_t)record->end));
+
+      for (k = 0; k < record->attribute_count; ++k)
+        {
+          svn_stringbuf_appendcstr(buffer, k ? ",{\"key\":" : "{\"key\":");
+          append_json_string(buffer, record->keys[k]);
+          svn_stringbuf_appendcstr(buffer, ",\"value\":{\"stringValue\":");
+          append_json_string(buffer, record->values[k]);
+          svn_stringbuf_appendcstr(buffer, "}}");
+        }
+
+      svn_stringbuf_appendcstr(buffer, "]}");
+    }
+
+  svn_stringbuf_appendcstr(buffer, "\n]}]}]}\n");
+}
+
+svn_string_t *
+svn_trace__export(svn_trace__format_t format,
+                  apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *buffer = svn_stringbuf_create_empty(result_pool);
+  apr_array_header_t *records = get_records(result_pool);
+
+  if (format == svn_trace__format_otlp)
+    format_otlp(buffer, records);
+  else
+    format_chrome(buffer, records);
+
+  return svn_stringbuf__morph_into_string(buffer);
+}
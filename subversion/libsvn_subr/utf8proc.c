@@ -147,6 +147,23 @@ normalize_cstring(apr_size_t *result_length,
   int flags = 0;
   ssize_t result;
 
+  /* Most paths are plain ASCII, which NFC composition and stripping marks
+     leave unchanged.  Simply copy those instead of running them through
+     the UCS-4 decomposition. */
+  if (!casefold)
+    {
+      apr_size_t len = (length == SVN_UTF__UNKNOWN_LENGTH
+                        ? strlen(string) : length);
+      if (svn_utf__is_ascii(string, len))
+        {
+          svn_membuf__ensure(buffer, len + 1);
+          memcpy(buffer->data, string, len);
+          ((char *)buffer->data)[len] = '\0';
+          *result_length = len;
+          return SVN_NO_ERROR;
+        }
+    }
+
   if (casefold)
     flags |= UTF8PROC_CASEFOLD;
 
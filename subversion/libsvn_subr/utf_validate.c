@@ -60,6 +60,13 @@
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
 
+/* SSE2 is part of every x86-64 CPU, so there is no need to detect it. */
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SVN_UTF__SSE2
+#endif
+
 /* Lookup table to categorise each octet in the string. */
 static const char octet_category[256] = {
   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0x00-0x7f */
@@ -258,6 +265,15 @@ static const char machine [9][14] = {
 static const char *
 first_non_fsm_start_char(const char *data, apr_size_t max_len)
 {
+#ifdef SVN_UTF__SSE2
+
+  /* Scan the input 16 bytes at a time.  MOVEMASK collects the top bits. */
+  for (; max_len >= sizeof(__m128i)
+       ; data += sizeof(__m128i), max_len -= sizeof(__m128i))
+    if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)data)))
+      break;
+
+#endif
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Scan the input one machine word at a time. */
@@ -290,7 +306,11 @@ svn_utf__last_valid(const char *data, apr_size_t len)
       int category = octet_category[octet];
       state = machine[state][category];
       if (state == FSM_START)
-        start = data;
+        {
+          /* Skip the ASCII run that usually follows. */
+          data = first_non_fsm_start_char(data, end - data);
+          start = data;
+        }
     }
   return start;
 }
@@ -304,6 +324,12 @@ svn_utf__cstring_is_valid(const char *data)
   return svn_utf__is_valid(data, strlen(data));
 }
 
+svn_boolean_t
+svn_utf__is_ascii(const char *data, apr_size_t len)
+{
+  return first_non_fsm_start_char(data, len) == data + len;
+}
+
 svn_boolean_t
 svn_utf__is_valid(const char *data, apr_size_t len)
 {
@@ -320,6 +346,11 @@ svn_utf__is_valid(const char *data, apr_size_t len)
       unsigned char octet = *data++;
       int category = octet_category[octet];
       state = machine[state][category];
+
+      /* Skip runs of ASCII chars quickly.  Multi-byte chars are usually
+       * few and far between in mostly ASCII text. */
+      if (state == FSM_START && data < end && (unsigned char)*data < 0x80)
+        data = first_non_fsm_start_char(data, end - data);
     }
   return state == FSM_START;
 }
@@ -147,7 +147,7 @@ xml_escape_cdata(svn_stringbuf_t **outstr,
   const char *p = data, *q;
 
   if (*outstr == NULL)
-    *outstr = svn_stringbuf_create_empty(pool);
+    *outstr = svn_stringbuf_create_ensure(len, pool);
 
   while (1)
     {
@@ -309,7 +309,7 @@ svn_xml_fuzzy_escape(const char *string, apr_pool_t *pool)
   if (q == end)
     return string;
 
-  outstr = svn_stringbuf_create_empty(pool);
+  outstr = svn_stringbuf_create_ensure(end - p, pool);
   while (1)
     {
       q = p;
@@ -29,6 +29,9 @@
 #include <apr_pools.h>
 #include <apr_file_io.h>
 #include <apr_hash.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
 
 #include "svn_hash.h"
 #include "svn_types.h"
@@ -1051,33 +1054,46 @@ open_txdelta_stream(svn_txdelta_stream_t **txdelta_stream_p,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
-                                      const svn_checksum_t **new_text_base_md5_checksum,
-                                      const svn_checksum_t **new_text_base_sha1_checksum,
-                                      svn_wc__db_t *db,
-                                      const char *local_abspath,
-                                      svn_boolean_t fulltext,
-                                      const svn_delta_editor_t *editor,
-                                      void *file_baton,
-                                      apr_pool_t *result_pool,
-                                      apr_pool_t *scratch_pool)
+/* The source and target of the text delta of one file to commit. */
+typedef struct text_delta_t
 {
+  const char *local_abspath;
+  svn_stream_t *base_stream;  /* delta source */
+  svn_stream_t *local_stream;  /* delta target: LOCAL_ABSPATH transl. to NF */
   const svn_checksum_t *expected_md5_checksum;  /* recorded MD5 of BASE_S. */
   svn_checksum_t *verify_checksum;  /* calc'd MD5 of BASE_STREAM */
   svn_checksum_t *local_md5_checksum;  /* calc'd MD5 of LOCAL_STREAM */
   svn_checksum_t *local_sha1_checksum;  /* calc'd SHA1 of LOCAL_STREAM */
-  svn_wc__db_install_data_t *install_data = NULL;
-  svn_error_t *err;
-  svn_error_t *err2;
-  svn_stream_t *base_stream;  /* delta source */
-  svn_stream_t *local_stream;  /* delta target: LOCAL_ABSPATH transl. to NF */
+  svn_wc__db_install_data_t *install_data;  /* new pristine, or NULL */
+} text_delta_t;
+
+/* Set *TD to the text delta of LOCAL_ABSPATH in DB, against an empty
+ * text if FULLTEXT is TRUE.  Copy the text to TEMPSTREAM, if not NULL,
+ * and prepare to install it as new pristine if INSTALL_PRISTINE is TRUE.
+ *
+ * This does all the wc.db access needed for reading the streams of *TD,
+ * so that they may be read on any thread.
+ *
+ * Allocate *TD and its streams in RESULT_POOL. */
+static svn_error_t *
+open_text_delta(text_delta_t **td,
+                svn_stream_t *tempstream,
+                svn_boolean_t install_pristine,
+                svn_wc__db_t *db,
+                const char *local_abspath,
+                svn_boolean_t fulltext,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  text_delta_t *d = apr_pcalloc(result_pool, sizeof(*d));
+
+  d->local_abspath = local_abspath;
 
   /* Translated input */
-  SVN_ERR(svn_wc__internal_translated_stream(&local_stream, db,
+  SVN_ERR(svn_wc__internal_translated_stream(&d->local_stream, db,
                                              local_abspath, local_abspath,
                                              SVN_WC_TRANSLATE_TO_NF,
-                                             scratch_pool, scratch_pool));
+                                             result_pool, scratch_pool));
 
   /* If the caller wants a copy of the working file translated to
    * repository-normal form, make the copy by tee-ing the TEMPSTREAM.
@@ -1091,19 +1107,21 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
          translated contents into the new text base file as we read from it.
          Note that the new text base file will be closed when the new stream
          is closed. */
-      local_stream = copying_stream(local_stream, tempstream, scratch_pool);
+      d->local_stream = copying_stream(d->local_stream, tempstream,
+                                       result_pool);
     }
-  if (new_text_base_sha1_checksum)
+  if (install_pristine)
     {
       svn_stream_t *new_pristine_stream;
 
       SVN_ERR(svn_wc__db_pristine_prepare_install(&new_pristine_stream,
-                                                  &install_data,
-                                                  &local_sha1_checksum, NULL,
+                                                  &d->install_data,
+                                                  &d->local_sha1_checksum,
+                                                  NULL,
                                                   db, local_abspath,
-                                                  scratch_pool, scratch_pool));
-      local_stream = copying_stream(local_stream, new_pristine_stream,
-                                    scratch_pool);
+                                                  result_pool, scratch_pool));
+      d->local_stream = copying_stream(d->local_stream, new_pristine_stream,
+                                       result_pool);
     }
 
   /* If sending a full text is requested, or if there is no pristine text
@@ -1118,63 +1136,54 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
       /* We will be computing a delta against the pristine contents */
       /* We need the expected checksum to be an MD-5 checksum rather than a
        * SHA-1 because we want to pass it to apply_textdelta(). */
-      SVN_ERR(read_and_checksum_pristine_text(&base_stream,
-                                              &expected_md5_checksum,
-                                              &verify_checksum,
+      SVN_ERR(read_and_checksum_pristine_text(&d->base_stream,
+                                              &d->expected_md5_checksum,
+                                              &d->verify_checksum,
                                               db, local_abspath,
-                                              scratch_pool, scratch_pool));
+                                              result_pool, scratch_pool));
     }
   else
     {
       /* Send a fulltext. */
-      base_stream = svn_stream_empty(scratch_pool);
-      expected_md5_checksum = NULL;
-      verify_checksum = NULL;
+      d->base_stream = svn_stream_empty(result_pool);
     }
 
   /* Arrange the stream to calculate the resulting MD5. */
-  local_stream = svn_stream_checksummed2(local_stream, &local_md5_checksum,
-                                         NULL, svn_checksum_md5, TRUE,
-                                         scratch_pool);
-
-  /* Tell the editor to apply a textdelta stream to the file baton. */
-  {
-    open_txdelta_stream_baton_t baton = { 0 };
-
-    /* apply_textdelta_stream() is working against a base with this checksum */
-    const char *base_digest_hex = NULL;
+  d->local_stream = svn_stream_checksummed2(d->local_stream,
+                                            &d->local_md5_checksum,
+                                            NULL, svn_checksum_md5, TRUE,
+                                            result_pool);
 
-    if (expected_md5_checksum)
-      /* ### Why '..._display()'?  expected_md5_checksum should never be all-
-       * zero, but if it is, we would want to pass NULL not an all-zero
-       * digest to apply_textdelta_stream(), wouldn't we? */
-      base_digest_hex = svn_checksum_to_cstring_display(expected_md5_checksum,
-                                                        scratch_pool);
+  *td = d;
+  return SVN_NO_ERROR;
+}
 
-    baton.need_reset = FALSE;
-    baton.base_stream = svn_stream_disown(base_stream, scratch_pool);
-    baton.local_stream = svn_stream_disown(local_stream, scratch_pool);
-    err = editor->apply_textdelta_stream(editor, file_baton, base_digest_hex,
-                                         open_txdelta_stream, &baton,
-                                         scratch_pool);
-  }
+/* Close the streams of TD after its delta was sent, or failed to be sent
+ * with the error ERR, and verify the checksum of the delta source.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+close_text_delta(text_delta_t *td,
+                 svn_error_t *err,
+                 apr_pool_t *scratch_pool)
+{
+  svn_error_t *err2;
 
   /* Close the two streams to force writing the digest */
-  err2 = svn_stream_close(base_stream);
+  err2 = svn_stream_close(td->base_stream);
   if (err2)
     {
       /* Set verify_checksum to NULL if svn_stream_close() returns error
          because checksum will be uninitialized in this case. */
-      verify_checksum = NULL;
+      td->verify_checksum = NULL;
       err = svn_error_compose_create(err, err2);
     }
 
-  err = svn_error_compose_create(err, svn_stream_close(local_stream));
+  err = svn_error_compose_create(err, svn_stream_close(td->local_stream));
 
   /* If we have an error, it may be caused by a corrupt text base,
      so check the checksum. */
-  if (expected_md5_checksum && verify_checksum
-      && !svn_checksum_match(expected_md5_checksum, verify_checksum))
+  if (td->expected_md5_checksum && td->verify_checksum
+      && !svn_checksum_match(td->expected_md5_checksum, td->verify_checksum))
     {
       /* The entry checksum does not match the actual text
          base checksum.  Extreme badness. Of course,
@@ -1189,10 +1198,11 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
          too, such as `svn diff'.  */
 
       err = svn_error_compose_create(
-              svn_checksum_mismatch_err(expected_md5_checksum, verify_checksum,
+              svn_checksum_mismatch_err(td->expected_md5_checksum,
+                                        td->verify_checksum,
                             scratch_pool,
                             _("Checksum mismatch for text base of '%s'"),
-                            svn_dirent_local_style(local_abspath,
+                            svn_dirent_local_style(td->local_abspath,
                                                    scratch_pool)),
               err);
 
@@ -1203,30 +1213,96 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
      thinking about it after this point. */
   SVN_ERR_W(err, apr_psprintf(scratch_pool,
                               _("While preparing '%s' for commit"),
-                              svn_dirent_local_style(local_abspath,
+                              svn_dirent_local_style(td->local_abspath,
                                                      scratch_pool)));
 
+  return SVN_NO_ERROR;
+}
+
+/* Finish the transmission of TD, whose delta has been sent to FILE_BATON
+ * of EDITOR and whose streams have been closed: set the new checksums,
+ * if requested, install the new pristine text and close FILE_BATON. */
+static svn_error_t *
+complete_text_delta(const svn_checksum_t **new_text_base_md5_checksum,
+                    const svn_checksum_t **new_text_base_sha1_checksum,
+                    text_delta_t *td,
+                    const svn_delta_editor_t *editor,
+                    void *file_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
   if (new_text_base_md5_checksum)
-    *new_text_base_md5_checksum = svn_checksum_dup(local_md5_checksum,
+    *new_text_base_md5_checksum = svn_checksum_dup(td->local_md5_checksum,
                                                    result_pool);
-  if (new_text_base_sha1_checksum)
+  if (td->install_data)
     {
-      SVN_ERR(svn_wc__db_pristine_install(install_data,
-                                          local_sha1_checksum,
-                                          local_md5_checksum,
+      SVN_ERR(svn_wc__db_pristine_install(td->install_data,
+                                          td->local_sha1_checksum,
+                                          td->local_md5_checksum,
                                           scratch_pool));
-      *new_text_base_sha1_checksum = svn_checksum_dup(local_sha1_checksum,
+      *new_text_base_sha1_checksum = svn_checksum_dup(td->local_sha1_checksum,
                                                       result_pool);
     }
 
   /* Close the file baton, and get outta here. */
   return svn_error_trace(
              editor->close_file(file_baton,
-                                svn_checksum_to_cstring(local_md5_checksum,
+                                svn_checksum_to_cstring(td->local_md5_checksum,
                                                         scratch_pool),
                                 scratch_pool));
 }
 
+svn_error_t *
+svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
+                                      const svn_checksum_t **new_text_base_md5_checksum,
+                                      const svn_checksum_t **new_text_base_sha1_checksum,
+                                      svn_wc__db_t *db,
+                                      const char *local_abspath,
+                                      svn_boolean_t fulltext,
+                                      const svn_delta_editor_t *editor,
+                                      void *file_baton,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool)
+{
+  text_delta_t *td;
+  svn_error_t *err;
+
+  SVN_ERR(open_text_delta(&td, tempstream,
+                          new_text_base_sha1_checksum != NULL,
+                          db, local_abspath, fulltext,
+                          scratch_pool, scratch_pool));
+
+  /* Tell the editor to apply a textdelta stream to the file baton. */
+  {
+    open_txdelta_stream_baton_t baton = { 0 };
+
+    /* apply_textdelta_stream() is working against a base with this checksum */
+    const char *base_digest_hex = NULL;
+
+    if (td->expected_md5_checksum)
+      /* ### Why '..._display()'?  expected_md5_checksum should never be all-
+       * zero, but if it is, we would want to pass NULL not an all-zero
+       * digest to apply_textdelta_stream(), wouldn't we? */
+      base_digest_hex = svn_checksum_to_cstring_display(
+                                                td->expected_md5_checksum,
+                                                scratch_pool);
+
+    baton.need_reset = FALSE;
+    baton.base_stream = svn_stream_disown(td->base_stream, scratch_pool);
+    baton.local_stream = svn_stream_disown(td->local_stream, scratch_pool);
+    err = editor->apply_textdelta_stream(editor, file_baton, base_digest_hex,
+                                         open_txdelta_stream, &baton,
+                                         scratch_pool);
+  }
+
+  SVN_ERR(close_text_delta(td, err, scratch_pool));
+
+  return svn_error_trace(complete_text_delta(new_text_base_md5_checksum,
+                                             new_text_base_sha1_checksum,
+                                             td, editor, file_baton,
+                                             result_pool, scratch_pool));
+}
+
 svn_error_t *
 svn_wc_transmit_text_deltas3(const svn_checksum_t **new_text_base_md5_checksum,
                              const svn_checksum_t **new_text_base_sha1_checksum,
@@ -1247,6 +1323,512 @@ svn_wc_transmit_text_deltas3(const svn_checksum_t **new_text_base_md5_checksum,
                                                scratch_pool);
 }
 
+#if APR_HAS_THREADS
+
+/* Number of threads computing text deltas ahead of their transmission. */
+#define DELTA_THREADS 4
+
+/* Maximum number of files whose deltas are computed ahead. */
+#define DELTA_AHEAD (4 * DELTA_THREADS)
+
+/* Computed deltas up to this size stay in memory; larger ones are spilled
+   to a temporary file. */
+#define DELTA_MEMORY_LIMIT (1024 * 1024)
+
+/* A text delta of svn_wc__transmit_text_deltas_batch(), computed ahead of
+   its transmission. */
+typedef struct prepared_delta_t
+{
+  svn_wc__text_delta_target_t *target;
+  text_delta_t *td;
+
+  /* Root pool holding everything of this delta, so that it can be used
+     by whatever thread computes it. */
+  apr_pool_t *pool;
+
+  /* The delta in svndiff format, in memory or in SVNDIFF_ABSPATH. */
+  svn_stringbuf_t *svndiff;
+  svn_stream_t *svndiff_file;
+  const char *svndiff_abspath;
+
+  /* The number of delta windows in the svndiff. */
+  int windows;
+
+  /* Set when the delta has been computed.  Protected by the mutex of
+     the batch. */
+  svn_boolean_t done;
+  svn_error_t *err;
+} prepared_delta_t;
+
+/* Implements svn_write_fn_t, storing the svndiff of the
+   prepared_delta_t at BATON. */
+static svn_error_t *
+write_svndiff(void *baton,
+              const char *data,
+              apr_size_t *len)
+{
+  prepared_delta_t *pd = baton;
+
+  if (pd->svndiff_file)
+    return svn_error_trace(svn_stream_write(pd->svndiff_file, data, len));
+
+  svn_stringbuf_appendbytes(pd->svndiff, data, *len);
+  if (pd->svndiff->len > DELTA_MEMORY_LIMIT)
+    {
+      apr_size_t spilled = pd->svndiff->len;
+
+      SVN_ERR(svn_stream_open_unique(&pd->svndiff_file, &pd->svndiff_abspath,
+                                     NULL, svn_io_file_del_on_pool_cleanup,
+                                     pd->pool, pd->pool));
+      SVN_ERR(svn_stream_write(pd->svndiff_file, pd->svndiff->data,
+                               &spilled));
+      pd->svndiff = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t for write_svndiff(). */
+static svn_error_t *
+close_svndiff(void *baton)
+{
+  prepared_delta_t *pd = baton;
+
+  if (pd->svndiff_file)
+    return svn_error_trace(svn_stream_close(pd->svndiff_file));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for count_windows(). */
+typedef struct count_windows_baton_t
+{
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  int *windows;
+} count_windows_baton_t;
+
+/* Implements svn_txdelta_window_handler_t, counting the windows passed
+   on to the handler of the count_windows_baton_t at BATON. */
+static svn_error_t *
+count_windows(svn_txdelta_window_t *window,
+              void *baton)
+{
+  count_windows_baton_t *b = baton;
+
+  if (window)
+    ++*b->windows;
+
+  return svn_error_trace(b->handler(window, b->handler_baton));
+}
+
+/* Compute the delta of PD, and close its streams.  This may run on any
+   thread.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+compute_delta(prepared_delta_t *pd,
+              apr_pool_t *scratch_pool)
+{
+  svn_txdelta_stream_t *txdelta_stream;
+  svn_stream_t *output;
+  count_windows_baton_t cwb;
+  svn_error_t *err;
+
+  pd->svndiff = svn_stringbuf_create_empty(pd->pool);
+  output = svn_stream_create(pd, pd->pool);
+  svn_stream_set_write(output, write_svndiff);
+  svn_stream_set_close(output, close_svndiff);
+
+  /* Plain svndiff0: it only has to be parsed again before the RA layer
+     encodes it for the wire. */
+  svn_txdelta_to_svndiff3(&cwb.handler, &cwb.handler_baton, output,
+                          0, 0, pd->pool);
+  cwb.windows = &pd->windows;
+
+  svn_txdelta2(&txdelta_stream, pd->td->base_stream, pd->td->local_stream,
+               FALSE, scratch_pool);
+  err = svn_txdelta_send_txstream(txdelta_stream, count_windows, &cwb,
+                                  scratch_pool);
+
+  return svn_error_trace(close_text_delta(pd->td, err, scratch_pool));
+}
+
+/* Baton for the delta stream of a prepared_delta_t. */
+typedef struct prepared_txdelta_baton_t
+{
+  prepared_delta_t *pd;
+  svn_stream_t *svndiff;
+  int windows_left;
+} prepared_txdelta_baton_t;
+
+/* Implements svn_txdelta_next_window_fn_t */
+static svn_error_t *
+prepared_next_window(svn_txdelta_window_t **window,
+                     void *baton,
+                     apr_pool_t *pool)
+{
+  prepared_txdelta_baton_t *b = baton;
+
+  if (b->windows_left == 0)
+    {
+      *window = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  --b->windows_left;
+  return svn_error_trace(svn_txdelta_read_svndiff_window(window, b->svndiff,
+                                                         0, pool));
+}
+
+/* Implements svn_txdelta_md5_digest_fn_t */
+static const unsigned char *
+prepared_md5_digest(void *baton)
+{
+  prepared_txdelta_baton_t *b = baton;
+
+  return b->pd->td->local_md5_checksum->digest;
+}
+
+/* Implements svn_txdelta_stream_open_func_t for the prepared_delta_t at
+   BATON.  Every call starts reading the delta from its beginning. */
+static svn_error_t *
+open_prepared_txdelta_stream(svn_txdelta_stream_t **txdelta_stream_p,
+                             void *baton,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  prepared_delta_t *pd = baton;
+  prepared_txdelta_baton_t *b = apr_pcalloc(result_pool, sizeof(*b));
+  char header[4];
+  apr_size_t len = sizeof(header);
+
+  b->pd = pd;
+  b->windows_left = pd->windows;
+
+  if (pd->svndiff)
+    b->svndiff = svn_stream_from_stringbuf(pd->svndiff, result_pool);
+  else
+    SVN_ERR(svn_stream_open_readonly(&b->svndiff, pd->svndiff_abspath,
+                                     result_pool, scratch_pool));
+
+  /* Skip the "SVN\0" header. */
+  SVN_ERR(svn_stream_read_full(b->svndiff, header, &len));
+
+  *txdelta_stream_p = svn_txdelta_stream_create(b, prepared_next_window,
+                                                prepared_md5_digest,
+                                                result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Send the computed delta PD to EDITOR and complete its transmission.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+send_prepared_delta(prepared_delta_t *pd,
+                    const svn_delta_editor_t *editor,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  const char *base_digest_hex = NULL;
+
+  if (pd->td->expected_md5_checksum)
+    base_digest_hex = svn_checksum_to_cstring_display(
+                                            pd->td->expected_md5_checksum,
+                                            scratch_pool);
+
+  SVN_ERR_W(editor->apply_textdelta_stream(editor, pd->target->file_baton,
+                                           base_digest_hex,
+                                           open_prepared_txdelta_stream, pd,
+                                           scratch_pool),
+            apr_psprintf(scratch_pool, _("While preparing '%s' for commit"),
+                         svn_dirent_local_style(pd->td->local_abspath,
+                                                scratch_pool)));
+
+  return svn_error_trace(
+            complete_text_delta(&pd->target->new_text_base_md5_checksum,
+                                &pd->target->new_text_base_sha1_checksum,
+                                pd->td, editor, pd->target->file_baton,
+                                result_pool, scratch_pool));
+}
+
+/* The deltas of svn_wc__transmit_text_deltas_batch(), shared between the
+   calling thread and the threads computing them. */
+typedef struct delta_batch_t
+{
+  /* The prepared_delta_t * of all targets, filled in order. */
+  prepared_delta_t **deltas;
+
+  /* Number of prepared deltas, and the index of the next one to
+     compute. */
+  int prepared;
+  int next;
+
+  /* Set when the threads should exit. */
+  svn_boolean_t stop;
+
+  /* Protects the fields above and the DONE flags of the deltas. */
+  apr_thread_mutex_t *mutex;
+
+  /* Signalled when a delta has been prepared or computed. */
+  apr_thread_cond_t *cond;
+} delta_batch_t;
+
+/* Compute the delta PD of BATCH and signal its completion.  The caller
+   must have taken PD from BATCH, and not hold the lock of BATCH. */
+static void
+run_compute_delta(delta_batch_t *batch,
+                  prepared_delta_t *pd,
+                  apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = compute_delta(pd, scratch_pool);
+
+  apr_thread_mutex_lock(batch->mutex);
+  pd->err = err;
+  pd->done = TRUE;
+  apr_thread_cond_broadcast(batch->cond);
+  apr_thread_mutex_unlock(batch->mutex);
+}
+
+/* Implements apr_thread_start_t for the delta_batch_t at DATA. */
+static void * APR_THREAD_FUNC
+compute_delta_thread(apr_thread_t *tid, void *data)
+{
+  delta_batch_t *batch = data;
+  apr_pool_t *iterpool = svn_pool_create(NULL);
+
+  while (TRUE)
+    {
+      prepared_delta_t *pd = NULL;
+
+      apr_thread_mutex_lock(batch->mutex);
+      while (!batch->stop && batch->next == batch->prepared)
+        apr_thread_cond_wait(batch->cond, batch->mutex);
+      if (!batch->stop)
+        pd = batch->deltas[batch->next++];
+      apr_thread_mutex_unlock(batch->mutex);
+
+      if (!pd)
+        break;
+
+      svn_pool_clear(iterpool);
+      run_compute_delta(batch, pd, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Implement svn_wc__transmit_text_deltas_batch() for BATCH, using up to
+   DELTA_THREADS threads besides the calling one.  Expects BATCH to be
+   set up apart from its deltas. */
+static svn_error_t *
+transmit_delta_batch(const svn_wc__text_delta_target_t **failed_target,
+                     delta_batch_t *batch,
+                     const apr_array_header_t *targets,
+                     svn_wc_context_t *wc_ctx,
+                     const svn_delta_editor_t *editor,
+                     svn_error_t *(*sending_func)(
+                                  void *baton,
+                                  const svn_wc__text_delta_target_t *target,
+                                  apr_pool_t *scratch_pool),
+                     void *sending_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  apr_thread_t *threads[DELTA_THREADS];
+  int thread_count = 0;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *prepare_err = SVN_NO_ERROR;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  for (i = 0; i < DELTA_THREADS && i + 1 < targets->nelts; i++)
+    {
+      if (apr_thread_create(&threads[thread_count], NULL,
+                            compute_delta_thread, batch, scratch_pool))
+        break;
+
+      ++thread_count;
+    }
+
+  for (i = 0; i < targets->nelts; i++)
+    {
+      prepared_delta_t *pd;
+
+      svn_pool_clear(iterpool);
+
+      /* Keep the threads busy with the following files. */
+      while (!prepare_err && batch->prepared < targets->nelts
+             && batch->prepared < i + DELTA_AHEAD)
+        {
+          svn_wc__text_delta_target_t *target
+            = APR_ARRAY_IDX(targets, batch->prepared,
+                            svn_wc__text_delta_target_t *);
+
+          pd = apr_pcalloc(scratch_pool, sizeof(*pd));
+          pd->target = target;
+          pd->pool = svn_pool_create(NULL);
+
+          prepare_err = open_text_delta(&pd->td, NULL, TRUE, wc_ctx->db,
+                                        target->local_abspath,
+                                        target->fulltext,
+                                        pd->pool, iterpool);
+          if (prepare_err)
+            {
+              svn_pool_destroy(pd->pool);
+              break;
+            }
+
+          apr_thread_mutex_lock(batch->mutex);
+          batch->deltas[batch->prepared++] = pd;
+          apr_thread_cond_broadcast(batch->cond);
+          apr_thread_mutex_unlock(batch->mutex);
+        }
+
+      if (i == batch->prepared)
+        {
+          *failed_target = APR_ARRAY_IDX(targets, i,
+                                         svn_wc__text_delta_target_t *);
+          err = prepare_err;
+          prepare_err = SVN_NO_ERROR;
+          break;
+        }
+
+      /* Wait for this delta, computing it here if no thread got to it. */
+      pd = batch->deltas[i];
+      apr_thread_mutex_lock(batch->mutex);
+      while (!pd->done)
+        {
+          if (batch->next == i)
+            {
+              batch->next++;
+              apr_thread_mutex_unlock(batch->mutex);
+              run_compute_delta(batch, pd, iterpool);
+              apr_thread_mutex_lock(batch->mutex);
+            }
+          else
+            apr_thread_cond_wait(batch->cond, batch->mutex);
+        }
+      apr_thread_mutex_unlock(batch->mutex);
+
+      *failed_target = pd->target;
+      err = pd->err;
+      pd->err = SVN_NO_ERROR;
+
+      if (!err && sending_func)
+        err = sending_func(sending_baton, pd->target, iterpool);
+
+      if (!err)
+        err = send_prepared_delta(pd, editor, result_pool, iterpool);
+
+      svn_pool_destroy(pd->pool);
+      batch->deltas[i] = NULL;
+
+      if (err)
+        break;
+    }
+
+  /* Stop the threads and clean up what they left. */
+  apr_thread_mutex_lock(batch->mutex);
+  batch->stop = TRUE;
+  apr_thread_cond_broadcast(batch->cond);
+  apr_thread_mutex_unlock(batch->mutex);
+
+  for (i = 0; i < thread_count; i++)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, threads[i]);
+    }
+
+  for (i = 0; i < batch->prepared; i++)
+    if (batch->deltas[i])
+      {
+        svn_error_clear(batch->deltas[i]->err);
+        svn_pool_destroy(batch->deltas[i]->pool);
+      }
+
+  svn_error_clear(prepare_err);
+  svn_pool_destroy(iterpool);
+
+  if (!err)
+    *failed_target = NULL;
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_wc__transmit_text_deltas_batch(
+                  const svn_wc__text_delta_target_t **failed_target,
+                  const apr_array_header_t *targets,
+                  svn_wc_context_t *wc_ctx,
+                  const svn_delta_editor_t *editor,
+                  svn_error_t *(*sending_func)(
+                                  void *baton,
+                                  const svn_wc__text_delta_target_t *target,
+                                  apr_pool_t *scratch_pool),
+                  void *sending_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  *failed_target = NULL;
+
+#if APR_HAS_THREADS
+  if (targets->nelts > 1)
+    {
+      delta_batch_t batch = { 0 };
+
+      batch.deltas = apr_pcalloc(scratch_pool,
+                                 targets->nelts * sizeof(*batch.deltas));
+
+      if (!apr_thread_mutex_create(&batch.mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   scratch_pool)
+          && !apr_thread_cond_create(&batch.cond, scratch_pool))
+        return svn_error_trace(transmit_delta_batch(failed_target, &batch,
+                                                    targets, wc_ctx, editor,
+                                                    sending_func,
+                                                    sending_baton,
+                                                    result_pool,
+                                                    scratch_pool));
+
+      /* Otherwise, fall back to sending one file after the other. */
+    }
+#endif
+
+  iterpool = svn_pool_create(scratch_pool);
+
+  for (i = 0; i < targets->nelts; i++)
+    {
+      svn_wc__text_delta_target_t *target
+        = APR_ARRAY_IDX(targets, i, svn_wc__text_delta_target_t *);
+
+      svn_pool_clear(iterpool);
+
+      *failed_target = target;
+
+      if (sending_func)
+        SVN_ERR(sending_func(sending_baton, target, iterpool));
+
+      SVN_ERR(svn_wc__internal_transmit_text_deltas(
+                                        NULL,
+                                        &target->new_text_base_md5_checksum,
+                                        &target->new_text_base_sha1_checksum,
+                                        wc_ctx->db, target->local_abspath,
+                                        target->fulltext, editor,
+                                        target->file_baton,
+                                        result_pool, iterpool));
+    }
+
+  *failed_target = NULL;
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc__internal_transmit_prop_deltas(svn_wc__db_t *db,
                                      const char *local_abspath,
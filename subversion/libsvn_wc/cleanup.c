@@ -126,9 +126,6 @@ cleanup_internal(svn_wc__db_t *db,
        removed it!  The logs have been run, so anything left here has no hope
        of being useful. */
       SVN_ERR(svn_wc__adm_cleanup_tmp_area(db, dir_abspath, scratch_pool));
-
-      /* Remove unreferenced pristine texts */
-      SVN_ERR(svn_wc__db_pristine_cleanup(db, dir_abspath, scratch_pool));
     }
 
   if (fix_recorded_timestamps)
@@ -149,6 +146,11 @@ cleanup_internal(svn_wc__db_t *db,
   /* All done, toss the lock */
   SVN_ERR(svn_wc__db_wclock_release(db, dir_abspath, scratch_pool));
 
+  /* Remove unreferenced pristine texts.  This doesn't need the lock, so
+     other clients can use the working copy while it runs. */
+  if (is_wcroot && vacuum_pristines)
+    SVN_ERR(svn_wc__db_pristine_cleanup(db, dir_abspath, scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
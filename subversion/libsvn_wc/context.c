@@ -106,6 +106,27 @@ svn_wc__context_create_with_db(svn_wc_context_t **wc_ctx,
 }
 
 
+void
+svn_wc__context_set_pristine_fetch(svn_wc_context_t *wc_ctx,
+                                   svn_wc__pristine_fetch_func_t fetch_func,
+                                   void *fetch_baton)
+{
+  svn_wc__db_set_pristine_fetch(wc_ctx->db, fetch_func, fetch_baton);
+}
+
+void
+svn_wc__read_cache_begin(svn_wc_context_t *wc_ctx)
+{
+  svn_wc__db_read_cache_begin(wc_ctx->db);
+}
+
+void
+svn_wc__read_cache_end(svn_wc_context_t *wc_ctx)
+{
+  svn_wc__db_read_cache_end(wc_ctx->db);
+}
+
+
 svn_error_t *
 svn_wc_context_destroy(svn_wc_context_t *wc_ctx)
 {
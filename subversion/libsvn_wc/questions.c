@@ -207,11 +207,13 @@ compare_and_verify(svn_boolean_t *modified_p,
 }
 
 svn_error_t *
-svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
-                                 svn_wc__db_t *db,
-                                 const char *local_abspath,
-                                 svn_boolean_t exact_comparison,
-                                 apr_pool_t *scratch_pool)
+svn_wc__internal_file_modified_p2(svn_boolean_t *modified_p,
+                                  const svn_io_dirent2_t **repair_dirent,
+                                  svn_wc__db_t *db,
+                                  const char *local_abspath,
+                                  svn_boolean_t exact_comparison,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
 {
   svn_stream_t *pristine_stream;
   svn_filesize_t pristine_size;
@@ -224,6 +226,8 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
   svn_boolean_t props_mod;
   const svn_io_dirent2_t *dirent;
 
+  *repair_dirent = NULL;
+
   /* Read the relevant info */
   SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, NULL, NULL, NULL, NULL,
                                NULL, NULL, NULL, &checksum, NULL, NULL, NULL,
@@ -246,7 +250,7 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
     }
 
   SVN_ERR(svn_io_stat_dirent2(&dirent, local_abspath, FALSE, TRUE,
-                              scratch_pool, scratch_pool));
+                              result_pool, scratch_pool));
 
   if (dirent->kind != svn_node_file)
     {
@@ -324,11 +328,32 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
       SVN_ERR(err);
   }
 
+  /* The timestamp is missing or "broken" so it needs "repair". */
   if (!*modified_p)
+    *repair_dirent = dirent;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
+                                 svn_wc__db_t *db,
+                                 const char *local_abspath,
+                                 svn_boolean_t exact_comparison,
+                                 apr_pool_t *scratch_pool)
+{
+  const svn_io_dirent2_t *dirent;
+
+  SVN_ERR(svn_wc__internal_file_modified_p2(modified_p, &dirent,
+                                            db, local_abspath,
+                                            exact_comparison,
+                                            scratch_pool, scratch_pool));
+
+  if (dirent)
     {
       svn_boolean_t own_lock;
 
-      /* The timestamp is missing or "broken" so "repair" it if we can. */
+      /* "Repair" the timestamp if we can. */
       SVN_ERR(svn_wc__db_wclock_owns_lock(&own_lock, db, local_abspath, FALSE,
                                           scratch_pool));
       if (own_lock)
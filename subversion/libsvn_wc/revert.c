@@ -246,9 +246,107 @@ revert_restore_handle_copied_dirs(svn_boolean_t *removed_self,
   return SVN_NO_ERROR;
 }
 
+/* Maximum number of file installations to collect before adding them to
+   the work queue and running it. */
+#define REVERT_INSTALL_BATCH 1024
+
+/* State shared by all nodes of one revert walk. */
+typedef struct revert_walk_t
+{
+  /* Abspaths of all nodes in the revert list, and of all nodes that have
+     such nodes below them, up to the revert root.  Nodes not in these
+     sets need no revert list lookups.  NULL if not known. */
+  apr_hash_t *listed;
+  apr_hash_t *pending;
+
+  /* File install work items (svn_skel_t *) not yet added to the work
+     queue.  The items are allocated in ITEM_POOL. */
+  apr_array_header_t *work_items;
+  apr_pool_t *item_pool;
+
+  /* Whether the work queue must be run. */
+  svn_boolean_t run_wq;
+} revert_walk_t;
+
+/* Create a revert walk for LOCAL_ABSPATH in DB, allocated in RESULT_POOL.
+   If RECURSIVE is TRUE, read the revert list for the whole tree at once
+   using SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+revert_walk_create(revert_walk_t **walk_p,
+                   svn_wc__db_t *db,
+                   const char *local_abspath,
+                   svn_boolean_t recursive,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  revert_walk_t *walk = apr_pcalloc(result_pool, sizeof(*walk));
+
+  walk->work_items = apr_array_make(result_pool, 16, sizeof(svn_skel_t *));
+  walk->item_pool = svn_pool_create(result_pool);
+
+  if (recursive)
+    {
+      apr_hash_index_t *hi;
+
+      SVN_ERR(svn_wc__db_revert_list_read_paths(&walk->listed, db,
+                                                local_abspath,
+                                                result_pool, scratch_pool));
+      walk->pending = apr_hash_make(result_pool);
+      for (hi = apr_hash_first(scratch_pool, walk->listed);
+           hi;
+           hi = apr_hash_next(hi))
+        {
+          const char *path = apr_hash_this_key(hi);
+
+          /* Mark PATH and its ancestors up to the revert root. */
+          while (!svn_hash_gets(walk->pending, path))
+            {
+              svn_hash_sets(walk->pending, path, path);
+              if (!svn_dirent_is_child(local_abspath, path, NULL))
+                break;
+
+              path = svn_dirent_dirname(path, result_pool);
+            }
+        }
+    }
+
+  *walk_p = walk;
+  return SVN_NO_ERROR;
+}
+
+/* Add all work items collected in WALK to the work queue of the working
+   copy containing WRI_ABSPATH in DB, in one transaction.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+revert_walk_flush(revert_walk_t *walk,
+                  svn_wc__db_t *db,
+                  const char *wri_abspath,
+                  apr_pool_t *scratch_pool)
+{
+  svn_skel_t *work_items;
+  int i;
+
+  if (walk->work_items->nelts == 0)
+    return SVN_NO_ERROR;
+
+  /* Keep the queue order without appending to the list repeatedly. */
+  work_items = svn_skel__make_empty_list(scratch_pool);
+  for (i = walk->work_items->nelts - 1; i >= 0; i--)
+    svn_skel__prepend(APR_ARRAY_IDX(walk->work_items, i, svn_skel_t *),
+                      work_items);
+
+  SVN_ERR(svn_wc__db_wq_add(db, wri_abspath, work_items, scratch_pool));
+
+  apr_array_clear(walk->work_items);
+  svn_pool_clear(walk->item_pool);
+  walk->run_wq = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
 /* Forward definition */
 static svn_error_t *
-revert_wc_data(svn_boolean_t *run_wq,
+revert_wc_data(revert_walk_t *walk,
                svn_boolean_t *notify_required,
                svn_wc__db_t *db,
                const char *local_abspath,
@@ -271,14 +369,14 @@ revert_wc_data(svn_boolean_t *run_wq,
    REVERT_ROOT is true for explicit revert targets and FALSE for targets
    reached via recursion.
 
-   Sets *RUN_WQ to TRUE when the caller should (eventually) run the workqueue.
-   (The function sets it to FALSE when it has run the WQ itself)
+   Collects file installations in WALK.  The caller should (eventually)
+   flush WALK and run the workqueue if WALK->RUN_WQ is set.
 
    If INFO is NULL, LOCAL_ABSPATH doesn't exist in DB. Otherwise INFO
    specifies the state of LOCAL_ABSPATH in DB.
  */
 static svn_error_t *
-revert_restore(svn_boolean_t *run_wq,
+revert_restore(revert_walk_t *walk,
                svn_wc__db_t *db,
                const char *local_abspath,
                svn_depth_t depth,
@@ -300,6 +398,8 @@ revert_restore(svn_boolean_t *run_wq,
   apr_time_t recorded_time;
   svn_boolean_t copied_here;
   svn_node_kind_t reverted_kind;
+  svn_boolean_t has_pending;
+
   if (cancel_func)
     SVN_ERR(cancel_func(cancel_baton));
 
@@ -329,11 +429,22 @@ revert_restore(svn_boolean_t *run_wq,
         }
     }
 
-  SVN_ERR(svn_wc__db_revert_list_read(&notify_required,
-                                      &conflict_files,
-                                      &copied_here, &reverted_kind,
-                                      db, local_abspath,
-                                      scratch_pool, scratch_pool));
+  /* The revert list of a recursive walk is known up front, so we can
+     skip the database for the usually many nodes that are not in it. */
+  has_pending = !walk->pending || svn_hash_gets(walk->pending, local_abspath);
+  if (walk->listed && !svn_hash_gets(walk->listed, local_abspath))
+    {
+      notify_required = FALSE;
+      conflict_files = NULL;
+      copied_here = FALSE;
+      reverted_kind = svn_node_unknown;
+    }
+  else
+    SVN_ERR(svn_wc__db_revert_list_read(&notify_required,
+                                        &conflict_files,
+                                        &copied_here, &reverted_kind,
+                                        db, local_abspath,
+                                        scratch_pool, scratch_pool));
 
   if (info)
     {
@@ -353,7 +464,7 @@ revert_restore(svn_boolean_t *run_wq,
                                              scratch_pool),
                         scratch_pool);
 
-          if (notify_func)
+          if (notify_func && has_pending)
             SVN_ERR(svn_wc__db_revert_list_notify(notify_func, notify_baton,
                                                   db, local_abspath,
                                                   scratch_pool));
@@ -373,7 +484,7 @@ revert_restore(svn_boolean_t *run_wq,
 
   if (!metadata_only)
     {
-      SVN_ERR(revert_wc_data(run_wq,
+      SVN_ERR(revert_wc_data(walk,
                              &notify_required,
                              db, local_abspath, status, kind,
                              reverted_kind, recorded_size, recorded_time,
@@ -407,9 +518,11 @@ revert_restore(svn_boolean_t *run_wq,
       apr_hash_t *children, *conflicts;
       apr_hash_index_t *hi;
 
-      SVN_ERR(revert_restore_handle_copied_dirs(NULL, db, local_abspath, FALSE,
-                                                cancel_func, cancel_baton,
-                                                iterpool));
+      if (has_pending)
+        SVN_ERR(revert_restore_handle_copied_dirs(NULL, db, local_abspath,
+                                                  FALSE,
+                                                  cancel_func, cancel_baton,
+                                                  iterpool));
 
       SVN_ERR(svn_wc__db_read_children_info(&children, &conflicts,
                                             db, local_abspath, FALSE,
@@ -426,7 +539,7 @@ revert_restore(svn_boolean_t *run_wq,
 
           child_abspath = svn_dirent_join(local_abspath, child_name, iterpool);
 
-          SVN_ERR(revert_restore(run_wq,
+          SVN_ERR(revert_restore(walk,
                                  db, child_abspath, depth, metadata_only,
                                  use_commit_times, FALSE /* revert root */,
                                  apr_hash_this_val(hi),
@@ -435,18 +548,20 @@ revert_restore(svn_boolean_t *run_wq,
                                  iterpool));
         }
 
-      /* Run the queue per directory */
-      if (*run_wq)
+      /* Run the queue once enough installations have piled up, so that
+         it can perform them in large batches. */
+      if (walk->work_items->nelts >= REVERT_INSTALL_BATCH)
         {
+          SVN_ERR(revert_walk_flush(walk, db, local_abspath, iterpool));
           SVN_ERR(svn_wc__wq_run(db, local_abspath, cancel_func, cancel_baton,
                                  iterpool));
-          *run_wq = FALSE;
+          walk->run_wq = FALSE;
         }
 
       svn_pool_destroy(iterpool);
     }
 
-  if (notify_func && (revert_root || kind == svn_node_dir))
+  if (notify_func && has_pending && (revert_root || kind == svn_node_dir))
     SVN_ERR(svn_wc__db_revert_list_notify(notify_func, notify_baton,
                                           db, local_abspath, scratch_pool));
 
@@ -455,7 +570,7 @@ revert_restore(svn_boolean_t *run_wq,
 
 /* Perform the in-working copy revert of LOCAL_ABSPATH, to what is stored in DB */
 static svn_error_t *
-revert_wc_data(svn_boolean_t *run_wq,
+revert_wc_data(revert_walk_t *walk,
                svn_boolean_t *notify_required,
                svn_wc__db_t *db,
                const char *local_abspath,
@@ -691,12 +806,12 @@ revert_wc_data(svn_boolean_t *run_wq,
         {
           svn_skel_t *work_item;
 
+          /* Queued together with those of other files later on. */
           SVN_ERR(svn_wc__wq_build_file_install(&work_item, db, local_abspath,
                                                 NULL, use_commit_times, TRUE,
-                                                scratch_pool, scratch_pool));
-          SVN_ERR(svn_wc__db_wq_add(db, local_abspath, work_item,
-                                    scratch_pool));
-          *run_wq = TRUE;
+                                                walk->item_pool,
+                                                scratch_pool));
+          APR_ARRAY_PUSH(walk->work_items, svn_skel_t *) = work_item;
         }
       *notify_required = TRUE;
     }
@@ -720,7 +835,7 @@ revert(svn_wc__db_t *db,
 {
   svn_error_t *err;
   const struct svn_wc__db_info_t *info = NULL;
-  svn_boolean_t run_queue = FALSE;
+  revert_walk_t *walk = NULL;
 
   SVN_ERR_ASSERT(depth == svn_depth_empty || depth == svn_depth_infinity);
 
@@ -760,13 +875,25 @@ revert(svn_wc__db_t *db,
 
   if (!err)
     err = svn_error_trace(
-              revert_restore(&run_queue, db, local_abspath, depth, metadata_only,
+              revert_walk_create(&walk, db, local_abspath,
+                                 depth == svn_depth_infinity,
+                                 scratch_pool, scratch_pool));
+
+  if (!err)
+    err = svn_error_trace(
+              revert_restore(walk, db, local_abspath, depth, metadata_only,
                              use_commit_times, TRUE /* revert root */,
                              info, cancel_func, cancel_baton,
                              notify_func, notify_baton,
                              scratch_pool));
 
-  if (run_queue)
+  /* Restore whatever files we got to, even after an error. */
+  if (walk)
+    err = svn_error_compose_create(err,
+                                   revert_walk_flush(walk, db, local_abspath,
+                                                     scratch_pool));
+
+  if (walk && walk->run_wq)
     err = svn_error_compose_create(err,
                                    svn_wc__wq_run(db, local_abspath,
                                                   cancel_func, cancel_baton,
@@ -29,6 +29,9 @@
 #include <apr_pools.h>
 #include <apr_file_io.h>
 #include <apr_hash.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
 
 #include "svn_pools.h"
 #include "svn_types.h"
@@ -100,6 +103,14 @@ struct walk_status_baton
 
   /* Repository locks, if set. */
   apr_hash_t *repos_locks;
+
+  /* Directory listings remembered from earlier walks.  May be NULL. */
+  struct svn_wc__dirent_cache_t *dirent_cache;
+
+#if APR_HAS_THREADS
+  /* Reads directories ahead of the walk.  May be NULL. */
+  struct dirent_prefetch_t *prefetch;
+#endif
 };
 
 /*** Editor batons ***/
@@ -1188,6 +1199,413 @@ one_child_status(const struct walk_status_baton *wb,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* Number of threads reading directories ahead of the status walk. */
+#define DIRENT_PREFETCH_THREADS 4
+
+/* Maximum number of directory listings to read ahead of the walk. */
+#define DIRENT_PREFETCH_LIMIT 64
+
+/* A directory listing to be read by a prefetch thread. */
+typedef struct dirent_job_t
+{
+  /* The directory to read and the svn_io_get_dirents3() flag to use. */
+  const char *local_abspath;
+  svn_boolean_t only_check_type;
+
+  /* TRUE once a thread took this job off the PENDING queue. */
+  svn_boolean_t started;
+
+  /* TRUE once DIRENTS, ERR and READ_TIME are valid. */
+  svn_boolean_t finished;
+  apr_time_t read_time;
+  apr_hash_t *dirents;
+  svn_error_t *err;
+
+  /* Next job in the PENDING queue. */
+  struct dirent_job_t *next;
+
+  /* Root pool holding this job and its result. */
+  apr_pool_t *pool;
+} dirent_job_t;
+
+/* Directory reading threads and their work.  All members are protected
+   by MUTEX. */
+typedef struct dirent_prefetch_t
+{
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+
+  /* All jobs not yet taken by the walk, mapping abspath to dirent_job_t *,
+     and the ones not yet started, in FIFO order. */
+  apr_hash_t *jobs;
+  dirent_job_t *first_pending;
+  dirent_job_t *last_pending;
+
+  /* Tell the threads to terminate. */
+  svn_boolean_t shutdown;
+
+  apr_thread_t *threads[DIRENT_PREFETCH_THREADS];
+  int thread_count;
+} dirent_prefetch_t;
+
+/* Implements apr_thread_start_t, reading the directories queued in the
+   dirent_prefetch_t at DATA. */
+static void * APR_THREAD_FUNC
+dirent_prefetch_thread(apr_thread_t *tid, void *data)
+{
+  dirent_prefetch_t *prefetch = data;
+
+  while (1)
+    {
+      dirent_job_t *job;
+      apr_pool_t *scratch_pool;
+
+      apr_thread_mutex_lock(prefetch->mutex);
+      while (!prefetch->shutdown && !prefetch->first_pending)
+        apr_thread_cond_wait(prefetch->changed, prefetch->mutex);
+
+      if (prefetch->shutdown)
+        {
+          apr_thread_mutex_unlock(prefetch->mutex);
+          break;
+        }
+
+      job = prefetch->first_pending;
+      prefetch->first_pending = job->next;
+      if (!prefetch->first_pending)
+        prefetch->last_pending = NULL;
+      job->started = TRUE;
+      apr_thread_mutex_unlock(prefetch->mutex);
+
+      /* Nobody else touches JOB until we flag it as finished. */
+      scratch_pool = svn_pool_create(job->pool);
+      job->read_time = apr_time_now();
+      job->err = svn_io_get_dirents3(&job->dirents, job->local_abspath,
+                                     job->only_check_type,
+                                     job->pool, scratch_pool);
+      svn_pool_destroy(scratch_pool);
+
+      apr_thread_mutex_lock(prefetch->mutex);
+      job->finished = TRUE;
+      apr_thread_cond_broadcast(prefetch->changed);
+      apr_thread_mutex_unlock(prefetch->mutex);
+    }
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Release JOB and everything it holds. */
+static void
+destroy_dirent_job(dirent_job_t *job)
+{
+  svn_error_clear(job->err);
+  svn_pool_destroy(job->pool);
+}
+
+/* Implements apr_pool_cleanup_t for a dirent_job_t handed to the walk. */
+static apr_status_t
+dirent_job_cleanup(void *data)
+{
+  destroy_dirent_job(data);
+  return APR_SUCCESS;
+}
+
+/* Start reading directories on worker threads and set *PREFETCH to the
+   new prefetcher.  Allocate it in RESULT_POOL.  Set *PREFETCH to NULL if
+   no thread could be started. */
+static svn_error_t *
+start_dirent_prefetch(dirent_prefetch_t **prefetch,
+                      apr_pool_t *result_pool)
+{
+  dirent_prefetch_t *p = apr_pcalloc(result_pool, sizeof(*p));
+  apr_status_t status;
+  int i;
+
+  *prefetch = NULL;
+
+  status = apr_thread_mutex_create(&p->mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   result_pool);
+  if (!status)
+    status = apr_thread_cond_create(&p->changed, result_pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create status mutex"));
+
+  p->jobs = apr_hash_make(result_pool);
+  for (i = 0; i < DIRENT_PREFETCH_THREADS; ++i)
+    {
+      status = apr_thread_create(&p->threads[i], NULL,
+                                 dirent_prefetch_thread, p, result_pool);
+      if (status)
+        break;
+
+      ++p->thread_count;
+    }
+
+  /* Reading ahead is optional; fall back to reading in the walk. */
+  if (p->thread_count)
+    *prefetch = p;
+
+  return SVN_NO_ERROR;
+}
+
+/* Stop the threads of PREFETCH and release all unclaimed results. */
+static void
+stop_dirent_prefetch(dirent_prefetch_t *prefetch)
+{
+  apr_hash_index_t *hi;
+  int i;
+
+  apr_thread_mutex_lock(prefetch->mutex);
+  prefetch->shutdown = TRUE;
+  apr_thread_cond_broadcast(prefetch->changed);
+  apr_thread_mutex_unlock(prefetch->mutex);
+
+  for (i = 0; i < prefetch->thread_count; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, prefetch->threads[i]);
+    }
+
+  for (hi = apr_hash_first(NULL, prefetch->jobs); hi; hi = apr_hash_next(hi))
+    destroy_dirent_job(apr_hash_this_val(hi));
+
+  apr_hash_clear(prefetch->jobs);
+}
+
+/* Ask PREFETCH to read the directory LOCAL_ABSPATH in the background,
+   as svn_io_get_dirents3() with ONLY_CHECK_TYPE would. */
+static void
+queue_dirent_prefetch(dirent_prefetch_t *prefetch,
+                      const char *local_abspath,
+                      svn_boolean_t only_check_type)
+{
+  dirent_job_t *job;
+  apr_pool_t *pool;
+
+  if (apr_hash_count(prefetch->jobs) >= DIRENT_PREFETCH_LIMIT
+      || svn_hash_gets(prefetch->jobs, local_abspath))
+    return;
+
+  pool = svn_pool_create(NULL);
+  job = apr_pcalloc(pool, sizeof(*job));
+  job->local_abspath = apr_pstrdup(pool, local_abspath);
+  job->only_check_type = only_check_type;
+  job->pool = pool;
+
+  apr_thread_mutex_lock(prefetch->mutex);
+  if (prefetch->last_pending)
+    prefetch->last_pending->next = job;
+  else
+    prefetch->first_pending = job;
+  prefetch->last_pending = job;
+  svn_hash_sets(prefetch->jobs, job->local_abspath, job);
+  apr_thread_cond_signal(prefetch->changed);
+  apr_thread_mutex_unlock(prefetch->mutex);
+}
+
+/* Return the finished job for LOCAL_ABSPATH from PREFETCH, waiting for
+   it if necessary.  Return NULL if there is no such job or no thread has
+   started it yet; in the latter case, the job gets dropped. */
+static dirent_job_t *
+take_dirent_prefetch(dirent_prefetch_t *prefetch,
+                     const char *local_abspath)
+{
+  dirent_job_t *job;
+
+  apr_thread_mutex_lock(prefetch->mutex);
+  job = svn_hash_gets(prefetch->jobs, local_abspath);
+  if (job)
+    {
+      svn_hash_sets(prefetch->jobs, local_abspath, NULL);
+
+      if (!job->started)
+        {
+          /* Reading it ourselves is faster than waiting in line. */
+          dirent_job_t *prev = NULL;
+          dirent_job_t *iter = prefetch->first_pending;
+
+          while (iter != job)
+            {
+              prev = iter;
+              iter = iter->next;
+            }
+
+          if (prev)
+            prev->next = job->next;
+          else
+            prefetch->first_pending = job->next;
+
+          if (prefetch->last_pending == job)
+            prefetch->last_pending = prev;
+        }
+      else
+        {
+          while (!job->finished)
+            apr_thread_cond_wait(prefetch->changed, prefetch->mutex);
+        }
+    }
+  apr_thread_mutex_unlock(prefetch->mutex);
+
+  if (job && !job->started)
+    {
+      destroy_dirent_job(job);
+      job = NULL;
+    }
+
+  return job;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* A directory listing remembered across status walks. */
+typedef struct cached_listing_t
+{
+  const char *local_abspath;
+  apr_hash_t *dirents;
+
+  /* The listing reflects the directory as it was at this time or later. */
+  apr_time_t read_time;
+
+  /* Pool holding this listing. */
+  apr_pool_t *pool;
+} cached_listing_t;
+
+/* All directory listings remembered in a svn_wc_context_t. */
+typedef struct svn_wc__dirent_cache_t
+{
+  /* Tells us whether a listing is still valid. */
+  svn_wc__dir_changed_func_t changed_func;
+  void *changed_baton;
+
+  /* Maps directory abspaths to cached_listing_t *. */
+  apr_hash_t *listings;
+
+  apr_pool_t *pool;
+} svn_wc__dirent_cache_t;
+
+/* Remove LISTING from CACHE and release it. */
+static void
+forget_listing(svn_wc__dirent_cache_t *cache,
+               cached_listing_t *listing)
+{
+  svn_hash_sets(cache->listings, listing->local_abspath, NULL);
+  svn_pool_destroy(listing->pool);
+}
+
+/* Store a copy of DIRENTS, which has been read from LOCAL_ABSPATH at
+   READ_TIME, in CACHE. */
+static void
+remember_listing(svn_wc__dirent_cache_t *cache,
+                 const char *local_abspath,
+                 apr_hash_t *dirents,
+                 apr_time_t read_time)
+{
+  apr_pool_t *pool = svn_pool_create(cache->pool);
+  cached_listing_t *listing = apr_palloc(pool, sizeof(*listing));
+  apr_hash_index_t *hi;
+
+  listing->local_abspath = apr_pstrdup(pool, local_abspath);
+  listing->dirents = apr_hash_make(pool);
+  listing->read_time = read_time;
+  listing->pool = pool;
+
+  for (hi = apr_hash_first(NULL, dirents); hi; hi = apr_hash_next(hi))
+    svn_hash_sets(listing->dirents,
+                  apr_pstrdup(pool, apr_hash_this_key(hi)),
+                  svn_io_dirent2_dup(apr_hash_this_val(hi), pool));
+
+  svn_hash_sets(cache->listings, listing->local_abspath, listing);
+}
+
+/* Set *DIRENTS to the on-disk children of LOCAL_ABSPATH, as returned by
+   svn_io_get_dirents3() with ONLY_CHECK_TYPE set as per WB, and *READ_TIME
+   to a time no later than when the directory got read.  Use the listing
+   read ahead by WB's prefetcher, if there is one.  Allocate the result in
+   RESULT_POOL and temporaries in SCRATCH_POOL. */
+static svn_error_t *
+list_dir(apr_hash_t **dirents,
+         apr_time_t *read_time,
+         const struct walk_status_baton *wb,
+         const char *local_abspath,
+         apr_pool_t *result_pool,
+         apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  if (wb->prefetch)
+    {
+      dirent_job_t *job = take_dirent_prefetch(wb->prefetch, local_abspath);
+
+      if (job)
+        {
+          svn_error_t *err = job->err;
+
+          /* The listing lives in the job's pool; just tie that one to
+             RESULT_POOL, instead of copying. */
+          job->err = SVN_NO_ERROR;
+          *dirents = job->dirents;
+          *read_time = job->read_time;
+          apr_pool_cleanup_register(result_pool, job, dirent_job_cleanup,
+                                    apr_pool_cleanup_null);
+
+          return svn_error_trace(err);
+        }
+    }
+#endif
+
+  *read_time = apr_time_now();
+  return svn_error_trace(svn_io_get_dirents3(dirents, local_abspath,
+                                             wb->ignore_text_mods,
+                                             result_pool, scratch_pool));
+}
+
+/* Set *DIRENTS to the on-disk children of LOCAL_ABSPATH, like list_dir()
+   does, but reuse the listing from WB's dirent cache while it is still
+   valid.  The result must be treated as read-only.  Allocate the result
+   in RESULT_POOL and temporaries in SCRATCH_POOL. */
+static svn_error_t *
+read_dirents(apr_hash_t **dirents,
+             const struct walk_status_baton *wb,
+             const char *local_abspath,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  svn_wc__dirent_cache_t *cache = wb->dirent_cache;
+  apr_time_t read_time;
+
+  if (cache)
+    {
+      cached_listing_t *listing = svn_hash_gets(cache->listings,
+                                                local_abspath);
+
+      if (listing)
+        {
+          svn_boolean_t changed;
+
+          SVN_ERR(cache->changed_func(&changed, cache->changed_baton,
+                                      local_abspath, listing->read_time,
+                                      scratch_pool));
+          if (!changed)
+            {
+              *dirents = listing->dirents;
+              return SVN_NO_ERROR;
+            }
+
+          forget_listing(cache, listing);
+        }
+    }
+
+  SVN_ERR(list_dir(dirents, &read_time, wb, local_abspath,
+                   result_pool, scratch_pool));
+
+  if (cache)
+    remember_listing(cache, local_abspath, *dirents, read_time);
+
+  return SVN_NO_ERROR;
+}
+
 /* Send svn_wc_status3_t * structures for the directory LOCAL_ABSPATH and
    for all its child nodes (according to DEPTH) through STATUS_FUNC /
    STATUS_BATON.
@@ -1247,9 +1665,8 @@ get_dir_status(const struct walk_status_baton *wb,
 
   if (wb->check_working_copy)
     {
-      err = svn_io_get_dirents3(&dirents, local_abspath,
-                                wb->ignore_text_mods /* only_check_type*/,
-                                scratch_pool, iterpool);
+      err = read_dirents(&dirents, wb, local_abspath,
+                         scratch_pool, iterpool);
       if (err
           && (APR_STATUS_IS_ENOENT(err->apr_err)
               || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
@@ -1340,6 +1757,43 @@ get_dir_status(const struct walk_status_baton *wb,
   sorted_children = svn_sort__hash(all_children,
                                    svn_sort_compare_items_lexically,
                                    scratch_pool);
+
+#if APR_HAS_THREADS
+  /* Let the prefetcher list the sub-directories that we will descend
+     into while we are busy with the files in here.  The walk itself,
+     and with it all wc.db access, stays on this thread. */
+  if (wb->prefetch && depth == svn_depth_infinity)
+    for (i = 0; i < sorted_children->nelts; i++)
+      {
+        const svn_sort__item_t *item
+          = &APR_ARRAY_IDX(sorted_children, i, svn_sort__item_t);
+        const struct svn_wc__db_info_t *child_info
+          = apr_hash_get(nodes, item->key, item->klen);
+        const svn_io_dirent2_t *child_dirent
+          = apr_hash_get(dirents, item->key, item->klen);
+
+        const char *child_abspath;
+
+        if (!child_info || !child_info->has_descendants
+            || child_info->status == svn_wc__db_status_not_present
+            || child_info->status == svn_wc__db_status_excluded
+            || child_info->status == svn_wc__db_status_server_excluded
+            || (child_info->kind == svn_node_unknown
+                && child_info->status == svn_wc__db_status_normal)
+            || !child_dirent || child_dirent->kind != svn_node_dir)
+          continue;
+
+        /* Remembered listings are usually still valid. */
+        child_abspath = svn_dirent_join(local_abspath, item->key, iterpool);
+        if (wb->dirent_cache
+            && svn_hash_gets(wb->dirent_cache->listings, child_abspath))
+          continue;
+
+        queue_dirent_prefetch(wb->prefetch, child_abspath,
+                              wb->ignore_text_mods);
+      }
+#endif
+
   for (i = 0; i < sorted_children->nelts; i++)
     {
       const void *key;
@@ -2513,6 +2967,10 @@ svn_wc__get_status_editor(const svn_delta_editor_t **editor,
   eb->wb.check_working_copy = check_working_copy;
   eb->wb.repos_locks      = NULL;
   eb->wb.repos_root       = NULL;
+  eb->wb.dirent_cache     = NULL;
+#if APR_HAS_THREADS
+  eb->wb.prefetch         = NULL;
+#endif
 
   SVN_ERR(svn_wc__db_externals_defined_below(&eb->wb.externals,
                                              wc_ctx->db, eb->target_abspath,
@@ -2619,19 +3077,22 @@ stat_wc_dirent_case_sensitive(const svn_io_dirent2_t **dirent,
                                 result_pool, scratch_pool));
 }
 
-svn_error_t *
-svn_wc__internal_walk_status(svn_wc__db_t *db,
-                             const char *local_abspath,
-                             svn_depth_t depth,
-                             svn_boolean_t get_all,
-                             svn_boolean_t no_ignore,
-                             svn_boolean_t ignore_text_mods,
-                             const apr_array_header_t *ignore_patterns,
-                             svn_wc_status_func4_t status_func,
-                             void *status_baton,
-                             svn_cancel_func_t cancel_func,
-                             void *cancel_baton,
-                             apr_pool_t *scratch_pool)
+/* Implement svn_wc__internal_walk_status(), reusing the directory
+   listings in DIRENT_CACHE, if not NULL. */
+static svn_error_t *
+walk_status(svn_wc__db_t *db,
+            svn_wc__dirent_cache_t *dirent_cache,
+            const char *local_abspath,
+            svn_depth_t depth,
+            svn_boolean_t get_all,
+            svn_boolean_t no_ignore,
+            svn_boolean_t ignore_text_mods,
+            const apr_array_header_t *ignore_patterns,
+            svn_wc_status_func4_t status_func,
+            void *status_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *scratch_pool)
 {
   struct walk_status_baton wb;
   const svn_io_dirent2_t *dirent;
@@ -2644,6 +3105,10 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   wb.check_working_copy = TRUE;
   wb.repos_root = NULL;
   wb.repos_locks = NULL;
+  wb.dirent_cache = dirent_cache;
+#if APR_HAS_THREADS
+  wb.prefetch = NULL;
+#endif
 
   /* Use the caller-provided ignore patterns if provided; the build-time
      configured defaults otherwise. */
@@ -2690,19 +3155,32 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
       && info->status != svn_wc__db_status_excluded
       && info->status != svn_wc__db_status_server_excluded)
     {
-      SVN_ERR(get_dir_status(&wb,
-                             local_abspath,
-                             FALSE /* skip_root */,
-                             NULL, NULL, NULL,
-                             info,
-                             dirent,
-                             ignore_patterns,
-                             depth,
-                             get_all,
-                             no_ignore,
-                             status_func, status_baton,
-                             cancel_func, cancel_baton,
-                             scratch_pool));
+#if APR_HAS_THREADS
+      /* Deep walks spend most of their time waiting for the disk. */
+      if (depth == svn_depth_infinity || depth == svn_depth_unknown)
+        SVN_ERR(start_dirent_prefetch(&wb.prefetch, scratch_pool));
+#endif
+
+      err = get_dir_status(&wb,
+                           local_abspath,
+                           FALSE /* skip_root */,
+                           NULL, NULL, NULL,
+                           info,
+                           dirent,
+                           ignore_patterns,
+                           depth,
+                           get_all,
+                           no_ignore,
+                           status_func, status_baton,
+                           cancel_func, cancel_baton,
+                           scratch_pool);
+
+#if APR_HAS_THREADS
+      if (wb.prefetch)
+        stop_dirent_prefetch(wb.prefetch);
+#endif
+
+      SVN_ERR(err);
     }
   else
     {
@@ -2735,6 +3213,28 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__internal_walk_status(svn_wc__db_t *db,
+                             const char *local_abspath,
+                             svn_depth_t depth,
+                             svn_boolean_t get_all,
+                             svn_boolean_t no_ignore,
+                             svn_boolean_t ignore_text_mods,
+                             const apr_array_header_t *ignore_patterns,
+                             svn_wc_status_func4_t status_func,
+                             void *status_baton,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(walk_status(db, NULL, local_abspath, depth,
+                                     get_all, no_ignore, ignore_text_mods,
+                                     ignore_patterns,
+                                     status_func, status_baton,
+                                     cancel_func, cancel_baton,
+                                     scratch_pool));
+}
+
 svn_error_t *
 svn_wc_walk_status(svn_wc_context_t *wc_ctx,
                    const char *local_abspath,
@@ -2749,19 +3249,40 @@ svn_wc_walk_status(svn_wc_context_t *wc_ctx,
                    void *cancel_baton,
                    apr_pool_t *scratch_pool)
 {
-  return svn_error_trace(
-           svn_wc__internal_walk_status(wc_ctx->db,
-                                        local_abspath,
-                                        depth,
-                                        get_all,
-                                        no_ignore,
-                                        ignore_text_mods,
-                                        ignore_patterns,
-                                        status_func,
-                                        status_baton,
-                                        cancel_func,
-                                        cancel_baton,
-                                        scratch_pool));
+  return svn_error_trace(walk_status(wc_ctx->db, wc_ctx->dirent_cache,
+                                     local_abspath, depth,
+                                     get_all, no_ignore, ignore_text_mods,
+                                     ignore_patterns,
+                                     status_func, status_baton,
+                                     cancel_func, cancel_baton,
+                                     scratch_pool));
+}
+
+svn_error_t *
+svn_wc__status_set_dir_changed_func(svn_wc_context_t *wc_ctx,
+                                    svn_wc__dir_changed_func_t changed_func,
+                                    void *changed_baton)
+{
+  if (wc_ctx->dirent_cache)
+    {
+      svn_pool_destroy(wc_ctx->dirent_cache->pool);
+      wc_ctx->dirent_cache = NULL;
+    }
+
+  if (changed_func)
+    {
+      apr_pool_t *pool = svn_pool_create(wc_ctx->state_pool);
+      svn_wc__dirent_cache_t *cache = apr_palloc(pool, sizeof(*cache));
+
+      cache->changed_func = changed_func;
+      cache->changed_baton = changed_baton;
+      cache->listings = apr_hash_make(pool);
+      cache->pool = pool;
+
+      wc_ctx->dirent_cache = cache;
+    }
+
+  return SVN_NO_ERROR;
 }
 
 
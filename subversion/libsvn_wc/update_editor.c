@@ -4842,6 +4842,10 @@ close_edit(void *edit_baton,
                          eb->cancel_func, eb->cancel_baton,
                          eb->pool));
 
+  /* Drop the pristine texts again, if so configured. */
+  SVN_ERR(svn_wc__db_pristine_dehydrate(eb->db, eb->wcroot_abspath,
+                                        eb->pool));
+
   /* The edit is over, free its pool.
      ### No, this is wrong.  Who says this editor/baton won't be used
      again?  But the change is not merely to remove this call.  We
@@ -80,7 +80,8 @@ CREATE UNIQUE INDEX I_LOCAL_ABSPATH ON WCROOT (local_abspath);
    derived from the 'checksum' column.  Each pristine text is referenced by
    any number of rows in the NODES and ACTUAL_NODE tables.
 
-   In future, the pristine text file may be compressed.
+   The pristine text file may be compressed, in which case it is stored
+   as '<sha1>.svn-zbase' instead.
  */
 CREATE TABLE PRISTINE (
   /* The SHA-1 checksum of the pristine text. This is a unique key. The
@@ -88,12 +89,15 @@ CREATE TABLE PRISTINE (
      pristine texts referenced from this database. */
   checksum  TEXT NOT NULL PRIMARY KEY,
 
-  /* Enumerated values specifying type of compression. The only value
-     supported so far is NULL, meaning that no compression has been applied
-     and the pristine text is stored verbatim in the file. */
+  /* Enumerated values specifying type of compression. NULL means that no
+     compression has been applied and the pristine text is stored verbatim
+     in the file.  1 means that the file holds a zlib stream as written by
+     svn_stream_compressed(); a verbatim copy may then exist alongside.
+     2 means that no file is stored; the text is fetched from the
+     repository location of a referencing node when needed. */
   compression  INTEGER,
 
-  /* The size in bytes of the file in which the pristine text is stored.
+  /* The size in bytes of the (uncompressed) pristine text.
      Used to verify the pristine file is "proper". */
   size  INTEGER NOT NULL,
 
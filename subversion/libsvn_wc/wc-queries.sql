@@ -287,14 +287,19 @@ WHERE wc_id = ?1
   AND presence in (MAP_NORMAL, MAP_INCOMPLETE)
 ORDER BY local_relpath DESC
 
--- STMT_COPY_NODE_MOVE
+/* Copy the layer at op-depth ?3 rooted at ?2 to op-depth ?5 at ?4, keeping
+   the recorded size and timestamp of destination nodes whose text does not
+   change.  ?6 is the parent of ?4. */
+-- STMT_COPY_LAYER_MOVE
 INSERT OR REPLACE INTO nodes (
     wc_id, local_relpath, op_depth, parent_relpath, repos_id, repos_path,
     revision, presence, depth, kind, changed_revision, changed_date,
     changed_author, checksum, properties, translated_size, last_mod_time,
     symlink_target, moved_here, moved_to )
 SELECT
-    s.wc_id, ?4 /*local_relpath */, ?5 /*op_depth*/, ?6 /* parent_relpath */,
+    s.wc_id, RELPATH_SKIP_JOIN(?2, ?4, s.local_relpath) drp, ?5 /*op_depth*/,
+    CASE WHEN s.local_relpath = ?2 THEN ?6
+         ELSE RELPATH_SKIP_JOIN(?2, ?4, s.parent_relpath) END,
     s.repos_id,
     s.repos_path, s.revision, s.presence, s.depth, s.kind, s.changed_revision,
     s.changed_date, s.changed_author, s.checksum, s.properties,
@@ -302,8 +307,42 @@ SELECT
     CASE WHEN d.checksum=s.checksum THEN d.last_mod_time END,
     s.symlink_target, 1, d.moved_to
 FROM nodes s
-LEFT JOIN nodes d ON d.wc_id=?1 AND d.local_relpath=?4 AND d.op_depth=?5
-WHERE s.wc_id = ?1 AND s.local_relpath = ?2 AND s.op_depth = ?3
+LEFT JOIN nodes d ON d.wc_id=?1 AND d.local_relpath=drp AND d.op_depth=?5
+WHERE s.wc_id = ?1
+  AND (s.local_relpath = ?2 OR IS_STRICT_DESCENDANT_OF(s.local_relpath, ?2))
+  AND s.op_depth = ?3
+
+/* The paths below the move source ?2 (including ?2 itself) at op-depth ?3
+   whose node differs from the node at the same path below the move
+   destination ?4 at op-depth ?5, followed by the source paths of the
+   destination nodes that have no counterpart in the source.  Like the
+   update-move editor, only count nodes with presence 'normal'. */
+-- STMT_SELECT_MOVE_UPDATE_DIFFERENCES
+SELECT s.local_relpath
+FROM nodes s
+LEFT OUTER JOIN nodes d ON d.wc_id = ?1 AND d.op_depth = ?5
+     AND d.local_relpath = RELPATH_SKIP_JOIN(?2, ?4, s.local_relpath)
+     AND d.presence = MAP_NORMAL
+WHERE s.wc_id = ?1
+  AND (s.local_relpath = ?2 OR IS_STRICT_DESCENDANT_OF(s.local_relpath, ?2))
+  AND s.op_depth = ?3
+  AND s.presence = MAP_NORMAL
+  AND (d.local_relpath IS NULL
+       OR d.kind != s.kind
+       OR d.checksum IS NOT s.checksum
+       OR d.properties IS NOT s.properties)
+UNION ALL
+SELECT RELPATH_SKIP_JOIN(?4, ?2, d.local_relpath)
+FROM nodes d
+WHERE d.wc_id = ?1
+  AND (d.local_relpath = ?4 OR IS_STRICT_DESCENDANT_OF(d.local_relpath, ?4))
+  AND d.op_depth = ?5
+  AND d.presence = MAP_NORMAL
+  AND NOT EXISTS (SELECT 1 FROM nodes s
+                  WHERE s.wc_id = ?1 AND s.op_depth = ?3
+                    AND s.local_relpath
+                          = RELPATH_SKIP_JOIN(?4, ?2, d.local_relpath)
+                    AND s.presence = MAP_NORMAL)
 
 -- STMT_SELECT_NO_LONGER_MOVED_RV
 SELECT d.local_relpath, RELPATH_SKIP_JOIN(?2, ?4, d.local_relpath) srp,
@@ -872,24 +911,49 @@ SELECT id, work FROM work_queue ORDER BY id LIMIT 1
 -- STMT_DELETE_WORK_ITEM
 DELETE FROM work_queue WHERE id = ?1
 
+-- STMT_SELECT_WORK_ITEMS_FOLLOWING
+SELECT id, work FROM work_queue WHERE id > ?1 ORDER BY id LIMIT ?2
+
 -- STMT_INSERT_OR_IGNORE_PRISTINE
-INSERT OR IGNORE INTO pristine (checksum, md5_checksum, size, refcount)
-VALUES (?1, ?2, ?3, 0)
+INSERT OR IGNORE INTO pristine (checksum, md5_checksum, size, compression,
+                                refcount)
+VALUES (?1, ?2, ?3, ?4, 0)
 
 -- STMT_INSERT_PRISTINE
-INSERT INTO pristine (checksum, md5_checksum, size, refcount)
-VALUES (?1, ?2, ?3, 0)
+INSERT INTO pristine (checksum, md5_checksum, size, compression, refcount)
+VALUES (?1, ?2, ?3, ?4, 0)
 
 -- STMT_SELECT_PRISTINE
-SELECT md5_checksum
+SELECT md5_checksum, compression
 FROM pristine
 WHERE checksum = ?1
 
 -- STMT_SELECT_PRISTINE_SIZE
-SELECT size
+SELECT size, compression
 FROM pristine
 WHERE checksum = ?1 LIMIT 1
 
+-- STMT_UPDATE_PRISTINE_COMPRESSION
+UPDATE pristine SET compression = ?2
+WHERE checksum = ?1
+
+-- STMT_SELECT_PRISTINE_ORIGIN
+SELECT r.root, n.repos_path, n.revision
+FROM nodes n
+JOIN repository r ON n.repos_id = r.id
+WHERE n.wc_id = ?1 AND n.checksum = ?2
+  AND n.repos_path IS NOT NULL
+  AND n.presence IN (MAP_NORMAL, MAP_INCOMPLETE)
+LIMIT 1
+
+-- STMT_SELECT_DEHYDRATABLE_PRISTINES
+SELECT DISTINCT n.checksum
+FROM nodes n
+JOIN pristine p ON p.checksum = n.checksum
+WHERE n.wc_id = ?1 AND n.repos_id IS NOT NULL
+  AND n.presence = MAP_NORMAL
+  AND (p.compression IS NULL OR p.compression <> 2)
+
 -- STMT_SELECT_PRISTINE_BY_MD5
 SELECT checksum
 FROM pristine
@@ -899,6 +963,7 @@ WHERE md5_checksum = ?1
 SELECT checksum
 FROM pristine
 WHERE refcount = 0
+LIMIT ?1
 
 -- STMT_DELETE_PRISTINE_IF_UNREFERENCED
 DELETE FROM pristine
@@ -906,7 +971,7 @@ WHERE checksum = ?1 AND refcount = 0
 
 -- STMT_SELECT_COPY_PRISTINES
 /* For the root itself */
-SELECT n.checksum, md5_checksum, size
+SELECT n.checksum, md5_checksum, size, compression
 FROM nodes_current n
 LEFT JOIN pristine p ON n.checksum = p.checksum
 WHERE wc_id = ?1
@@ -914,7 +979,7 @@ WHERE wc_id = ?1
   AND n.checksum IS NOT NULL
 UNION ALL
 /* And all descendants */
-SELECT n.checksum, md5_checksum, size
+SELECT n.checksum, md5_checksum, size, compression
 FROM nodes n
 LEFT JOIN pristine p ON n.checksum = p.checksum
 WHERE wc_id = ?1
@@ -228,6 +228,9 @@ struct svn_wc_context_t
 
   /* The state pool for this context. */
   apr_pool_t *state_pool;
+
+  /* Directory listings remembered across status walks.  May be NULL. */
+  struct svn_wc__dirent_cache_t *dirent_cache;
 };
 
 /**
@@ -348,6 +351,22 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
                                  svn_boolean_t exact_comparison,
                                  apr_pool_t *scratch_pool);
 
+/* Like svn_wc__internal_file_modified_p(), but instead of repairing the
+ * recorded timestamp and filesize itself, set *REPAIR_DIRENT to the
+ * dirent of the unmodified file whose recorded information needs repair,
+ * allocated in RESULT_POOL, so that the caller can record it later.
+ * Otherwise set *REPAIR_DIRENT to NULL.  The caller must hold a
+ * write-lock to make use of *REPAIR_DIRENT.
+ */
+svn_error_t *
+svn_wc__internal_file_modified_p2(svn_boolean_t *modified_p,
+                                  const svn_io_dirent2_t **repair_dirent,
+                                  svn_wc__db_t *db,
+                                  const char *local_abspath,
+                                  svn_boolean_t exact_comparison,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
 
 /* Prepare to merge a file content change into the working copy.
 
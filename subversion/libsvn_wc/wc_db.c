@@ -1444,6 +1444,9 @@ create_db(svn_sqlite__db_t **sdb,
                                   NULL /* my_statements */,
                                   result_pool, scratch_pool));
 
+  /* Must happen before the first table is created. */
+  SVN_ERR(svn_sqlite__enable_incremental_vacuum(*sdb));
+
   SVN_SQLITE__WITH_LOCK(init_db(repos_id, wc_id,
                                 *sdb, repos_root_url, repos_uuid,
                                 root_node_repos_relpath, root_node_revision,
@@ -2614,6 +2617,244 @@ svn_wc__db_base_get_info_internal(svn_wc__db_status_t *status,
 }
 
 
+/* The results of read_info() for one node, as kept in the read cache */
+typedef struct read_cache_info_t
+{
+  svn_wc__db_status_t status;
+  svn_node_kind_t kind;
+  svn_revnum_t revision;
+  const char *repos_relpath;
+  const char *repos_root_url;
+  const char *repos_uuid;
+  svn_revnum_t changed_rev;
+  apr_time_t changed_date;
+  const char *changed_author;
+  svn_depth_t depth;
+  const svn_checksum_t *checksum;
+  const char *target;
+  const char *original_repos_relpath;
+  const char *original_root_url;
+  const char *original_uuid;
+  svn_revnum_t original_revision;
+  svn_wc__db_lock_t *lock;
+  svn_filesize_t recorded_size;
+  apr_time_t recorded_time;
+  const char *changelist;
+  svn_boolean_t conflicted;
+  svn_boolean_t op_root;
+  svn_boolean_t have_props;
+  svn_boolean_t props_mod;
+  svn_boolean_t have_base;
+  svn_boolean_t have_more_work;
+  svn_boolean_t have_work;
+} read_cache_info_t;
+
+/* The results of svn_wc__db_base_get_info_internal() for one node, as kept
+   in the read cache */
+typedef struct read_cache_base_t
+{
+  svn_wc__db_status_t status;
+  svn_node_kind_t kind;
+  svn_revnum_t revision;
+  const char *repos_relpath;
+  const char *repos_root_url;
+  const char *repos_uuid;
+  svn_revnum_t changed_rev;
+  apr_time_t changed_date;
+  const char *changed_author;
+  svn_depth_t depth;
+  const svn_checksum_t *checksum;
+  const char *target;
+  svn_wc__db_lock_t *lock;
+  svn_boolean_t had_props;
+  apr_hash_t *props;
+  svn_boolean_t update_root;
+} read_cache_base_t;
+
+/* What the read cache knows about one node.  Each member is NULL until the
+   corresponding query has been answered once. */
+typedef struct read_cache_node_t
+{
+  read_cache_info_t *info;
+  read_cache_base_t *base;
+  apr_hash_t *props;
+} read_cache_node_t;
+
+
+void
+svn_wc__db_read_cache_begin(svn_wc__db_t *db)
+{
+  if (db->read_cache_users++ == 0)
+    {
+      db->read_cache_pool = svn_pool_create(db->state_pool);
+      db->read_cache = NULL;
+      db->read_cache_wcroot = NULL;
+    }
+}
+
+void
+svn_wc__db_read_cache_end(svn_wc__db_t *db)
+{
+  SVN_ERR_ASSERT_NO_RETURN(db->read_cache_users > 0);
+
+  if (--db->read_cache_users == 0)
+    {
+      svn_pool_destroy(db->read_cache_pool);
+      db->read_cache_pool = NULL;
+      db->read_cache = NULL;
+      db->read_cache_wcroot = NULL;
+    }
+}
+
+void
+svn_wc__db_read_cache_clear(svn_wc__db_t *db)
+{
+  if (db->read_cache_pool)
+    {
+      svn_pool_clear(db->read_cache_pool);
+      db->read_cache = NULL;
+      db->read_cache_wcroot = NULL;
+    }
+}
+
+/* Return the read cache entry of DB for LOCAL_RELPATH in WCROOT, creating
+   an empty one if there is none yet, or NULL if DB has no read cache.
+
+   The cache only holds nodes of a single wcroot.  Whenever it is asked for
+   another wcroot, or rows have been changed in WCROOT since the cache was
+   started, everything in it is forgotten. */
+static read_cache_node_t *
+read_cache_get(svn_wc__db_t *db,
+               svn_wc__db_wcroot_t *wcroot,
+               const char *local_relpath)
+{
+  read_cache_node_t *node;
+  int changes;
+
+  if (!db->read_cache_pool)
+    return NULL;
+
+  changes = svn_sqlite__total_changes(wcroot->sdb);
+  if (db->read_cache_wcroot != wcroot || db->read_cache_changes != changes)
+    {
+      svn_pool_clear(db->read_cache_pool);
+      db->read_cache = apr_hash_make(db->read_cache_pool);
+      db->read_cache_wcroot = wcroot;
+      db->read_cache_changes = changes;
+    }
+
+  node = svn_hash_gets(db->read_cache, local_relpath);
+  if (!node)
+    {
+      node = apr_pcalloc(db->read_cache_pool, sizeof(*node));
+      svn_hash_sets(db->read_cache,
+                    apr_pstrdup(db->read_cache_pool, local_relpath), node);
+    }
+
+  return node;
+}
+
+/* Return a copy of LOCK allocated in RESULT_POOL, or NULL if LOCK is NULL */
+static svn_wc__db_lock_t *
+lock_dup(const svn_wc__db_lock_t *lock,
+         apr_pool_t *result_pool)
+{
+  svn_wc__db_lock_t *new_lock;
+
+  if (!lock)
+    return NULL;
+
+  new_lock = apr_pmemdup(result_pool, lock, sizeof(*lock));
+  new_lock->token = apr_pstrdup(result_pool, lock->token);
+  new_lock->owner = apr_pstrdup(result_pool, lock->owner);
+  new_lock->comment = apr_pstrdup(result_pool, lock->comment);
+
+  return new_lock;
+}
+
+/* Set NODE->BASE from svn_wc__db_base_get_info_internal() for
+   LOCAL_RELPATH in WCROOT, unless it is already there.  Allocate the
+   result in CACHE_POOL. */
+static svn_error_t *
+read_cache_fill_base(read_cache_node_t *node,
+                     svn_wc__db_wcroot_t *wcroot,
+                     const char *local_relpath,
+                     apr_pool_t *cache_pool,
+                     apr_pool_t *scratch_pool)
+{
+  read_cache_base_t *cb;
+  apr_int64_t repos_id;
+
+  if (node->base)
+    return SVN_NO_ERROR;
+
+  cb = apr_pcalloc(cache_pool, sizeof(*cb));
+
+  SVN_WC__DB_WITH_TXN4(
+          svn_wc__db_base_get_info_internal(&cb->status, &cb->kind,
+                                            &cb->revision,
+                                            &cb->repos_relpath, &repos_id,
+                                            &cb->changed_rev,
+                                            &cb->changed_date,
+                                            &cb->changed_author, &cb->depth,
+                                            &cb->checksum, &cb->target,
+                                            &cb->lock, &cb->had_props,
+                                            &cb->props, &cb->update_root,
+                                            wcroot, local_relpath,
+                                            cache_pool, scratch_pool),
+          svn_wc__db_fetch_repos_info(&cb->repos_root_url, &cb->repos_uuid,
+                                      wcroot, repos_id, cache_pool),
+          SVN_NO_ERROR,
+          SVN_NO_ERROR,
+          wcroot);
+  SVN_ERR_ASSERT(repos_id != INVALID_REPOS_ID);
+
+  node->base = cb;
+  return SVN_NO_ERROR;
+}
+
+/* Set NODE->INFO from read_info() for LOCAL_RELPATH in WCROOT, unless it
+   is already there.  Allocate the result in CACHE_POOL. */
+static svn_error_t *
+read_cache_fill_info(read_cache_node_t *node,
+                     svn_wc__db_wcroot_t *wcroot,
+                     const char *local_relpath,
+                     apr_pool_t *cache_pool,
+                     apr_pool_t *scratch_pool)
+{
+  read_cache_info_t *ci;
+  apr_int64_t repos_id, original_repos_id;
+
+  if (node->info)
+    return SVN_NO_ERROR;
+
+  ci = apr_pcalloc(cache_pool, sizeof(*ci));
+
+  SVN_WC__DB_WITH_TXN4(
+          read_info(&ci->status, &ci->kind, &ci->revision,
+                    &ci->repos_relpath, &repos_id, &ci->changed_rev,
+                    &ci->changed_date, &ci->changed_author, &ci->depth,
+                    &ci->checksum, &ci->target, &ci->original_repos_relpath,
+                    &original_repos_id, &ci->original_revision, &ci->lock,
+                    &ci->recorded_size, &ci->recorded_time, &ci->changelist,
+                    &ci->conflicted, &ci->op_root, &ci->have_props,
+                    &ci->props_mod, &ci->have_base, &ci->have_more_work,
+                    &ci->have_work,
+                    wcroot, local_relpath, cache_pool, scratch_pool),
+          svn_wc__db_fetch_repos_info(&ci->repos_root_url, &ci->repos_uuid,
+                                      wcroot, repos_id, cache_pool),
+          svn_wc__db_fetch_repos_info(&ci->original_root_url,
+                                      &ci->original_uuid,
+                                      wcroot, original_repos_id,
+                                      cache_pool),
+          SVN_NO_ERROR,
+          wcroot);
+
+  node->info = ci;
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_wc__db_base_get_info(svn_wc__db_status_t *status,
                          svn_node_kind_t *kind,
@@ -2639,6 +2880,7 @@ svn_wc__db_base_get_info(svn_wc__db_status_t *status,
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
   apr_int64_t repos_id;
+  read_cache_node_t *node;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
@@ -2646,6 +2888,52 @@ svn_wc__db_base_get_info(svn_wc__db_status_t *status,
                               local_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  node = read_cache_get(db, wcroot, local_relpath);
+  if (node)
+    {
+      const read_cache_base_t *cb;
+
+      SVN_ERR(read_cache_fill_base(node, wcroot, local_relpath,
+                                   db->read_cache_pool, scratch_pool));
+      cb = node->base;
+
+      if (status)
+        *status = cb->status;
+      if (kind)
+        *kind = cb->kind;
+      if (revision)
+        *revision = cb->revision;
+      if (repos_relpath)
+        *repos_relpath = apr_pstrdup(result_pool, cb->repos_relpath);
+      if (repos_root_url)
+        *repos_root_url = apr_pstrdup(result_pool, cb->repos_root_url);
+      if (repos_uuid)
+        *repos_uuid = apr_pstrdup(result_pool, cb->repos_uuid);
+      if (changed_rev)
+        *changed_rev = cb->changed_rev;
+      if (changed_date)
+        *changed_date = cb->changed_date;
+      if (changed_author)
+        *changed_author = apr_pstrdup(result_pool, cb->changed_author);
+      if (depth)
+        *depth = cb->depth;
+      if (checksum)
+        *checksum = svn_checksum_dup(cb->checksum, result_pool);
+      if (target)
+        *target = apr_pstrdup(result_pool, cb->target);
+      if (lock)
+        *lock = lock_dup(cb->lock, result_pool);
+      if (had_props)
+        *had_props = cb->had_props;
+      if (props)
+        *props = cb->props ? svn_prop_hash_dup(cb->props, result_pool)
+                           : NULL;
+      if (update_root)
+        *update_root = cb->update_root;
+
+      return SVN_NO_ERROR;
+    }
+
   SVN_WC__DB_WITH_TXN4(
           svn_wc__db_base_get_info_internal(status, kind, revision,
                                             repos_relpath, &repos_id,
@@ -4941,6 +5229,9 @@ svn_wc__db_op_copy_layer_internal(svn_wc__db_wcroot_t *wcroot,
   int dst_op_depth = relpath_depth(dst_op_relpath);
   svn_boolean_t locked;
   svn_error_t *err = NULL;
+  apr_array_header_t *extend_relpaths;
+  apr_array_header_t *extend_kinds;
+  int i;
 
   SVN_ERR(svn_wc__db_wclock_owns_lock_internal(&locked, wcroot, dst_op_relpath,
                                                FALSE, scratch_pool));
@@ -4951,10 +5242,13 @@ svn_wc__db_op_copy_layer_internal(svn_wc__db_wcroot_t *wcroot,
                              path_for_error_message(wcroot, dst_op_relpath,
                                                     scratch_pool));
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt2, wcroot->sdb,
-                                    STMT_COPY_NODE_MOVE));
+  /* Find the nodes that are not there yet at the destination before
+     we replace the entire subtree.  The node can't be deleted where it
+     is added, so extension of an existing shadowing is only interesting
+     2 levels deep. */
+  extend_relpaths = apr_array_make(scratch_pool, 0, sizeof(const char *));
+  extend_kinds = apr_array_make(scratch_pool, 0, sizeof(svn_node_kind_t));
 
-  /* Replace entire subtree at one op-depth. */
   SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
                                     STMT_SELECT_LAYER_FOR_REPLACE));
   SVN_ERR(svn_sqlite__bindf(stmt, "isdsd", wcroot->wc_id,
@@ -4963,28 +5257,8 @@ svn_wc__db_op_copy_layer_internal(svn_wc__db_wcroot_t *wcroot,
   SVN_ERR(svn_sqlite__step(&have_row, stmt));
   while (have_row)
     {
-      const char *src_relpath;
-      const char *dst_relpath;
-
-      svn_pool_clear(iterpool);
+      const char *dst_relpath = svn_sqlite__column_text(stmt, 2, NULL);
 
-      src_relpath = svn_sqlite__column_text(stmt, 0, iterpool);
-      dst_relpath = svn_sqlite__column_text(stmt, 2, iterpool);
-
-      err = svn_sqlite__bindf(stmt2, "isdsds", wcroot->wc_id,
-                              src_relpath, src_op_depth,
-                              dst_relpath, dst_op_depth,
-                              svn_relpath_dirname(dst_relpath, iterpool));
-      if (!err)
-        err = svn_sqlite__step_done(stmt2);
-
-      /* stmt2 is reset (never modified or by step_done) */
-
-      if (err)
-        break;
-
-      /* The node can't be deleted where it is added, so extension of
-         an existing shadowing is only interesting 2 levels deep. */
       if (relpath_depth(dst_relpath) > (dst_op_depth+1))
         {
           svn_boolean_t exists = !svn_sqlite__column_is_null(stmt, 3);
@@ -5001,20 +5275,37 @@ svn_wc__db_op_copy_layer_internal(svn_wc__db_wcroot_t *wcroot,
 
           if (!exists)
             {
-              svn_node_kind_t kind = svn_sqlite__column_token(stmt, 1, kind_map);
-
-              err = db_extend_parent_delete(wcroot, dst_relpath,
-                                            kind, dst_op_depth, iterpool);
-
-              if (err)
-                break;
+              APR_ARRAY_PUSH(extend_relpaths, const char *)
+                = apr_pstrdup(scratch_pool, dst_relpath);
+              APR_ARRAY_PUSH(extend_kinds, svn_node_kind_t)
+                = svn_sqlite__column_token(stmt, 1, kind_map);
             }
         }
 
       SVN_ERR(svn_sqlite__step(&have_row, stmt));
     }
+  SVN_ERR(svn_sqlite__reset(stmt));
 
-  SVN_ERR(svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+  /* Replace entire subtree at one op-depth. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_COPY_LAYER_MOVE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isdsds", wcroot->wc_id,
+                            src_op_relpath, src_op_depth,
+                            dst_op_relpath, dst_op_depth,
+                            svn_relpath_dirname(dst_op_relpath,
+                                                scratch_pool)));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  for (i = 0; i < extend_relpaths->nelts; i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(db_extend_parent_delete(wcroot,
+                                      APR_ARRAY_IDX(extend_relpaths, i,
+                                                    const char *),
+                                      APR_ARRAY_IDX(extend_kinds, i,
+                                                    svn_node_kind_t),
+                                      dst_op_depth, iterpool));
+    }
 
   /* And now remove the records that are no longer needed */
   SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
@@ -7414,6 +7705,42 @@ svn_wc__db_revert_list_read_copied_children(apr_array_header_t **children,
 }
 
 
+svn_error_t *
+svn_wc__db_revert_list_read_paths(apr_hash_t **paths,
+                                  svn_wc__db_t *db,
+                                  const char *local_abspath,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath,
+                              db, local_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  *paths = apr_hash_make(result_pool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_REVERT_LIST_RECURSIVE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", local_relpath));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const char *relpath = svn_sqlite__column_text(stmt, 0, NULL);
+      const char *abspath = svn_dirent_join(wcroot->abspath, relpath,
+                                            result_pool);
+
+      svn_hash_sets(*paths, abspath, abspath);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+
 svn_error_t *
 svn_wc__db_revert_list_notify(svn_wc_notify_func2_t notify_func,
                               void *notify_baton,
@@ -9210,6 +9537,7 @@ svn_wc__db_read_info(svn_wc__db_status_t *status,
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
   apr_int64_t repos_id, original_repos_id;
+  read_cache_node_t *node;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
@@ -9217,6 +9545,74 @@ svn_wc__db_read_info(svn_wc__db_status_t *status,
                               local_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  node = read_cache_get(db, wcroot, local_relpath);
+  if (node)
+    {
+      const read_cache_info_t *ci;
+
+      SVN_ERR(read_cache_fill_info(node, wcroot, local_relpath,
+                                   db->read_cache_pool, scratch_pool));
+      ci = node->info;
+
+      if (status)
+        *status = ci->status;
+      if (kind)
+        *kind = ci->kind;
+      if (revision)
+        *revision = ci->revision;
+      if (repos_relpath)
+        *repos_relpath = apr_pstrdup(result_pool, ci->repos_relpath);
+      if (repos_root_url)
+        *repos_root_url = apr_pstrdup(result_pool, ci->repos_root_url);
+      if (repos_uuid)
+        *repos_uuid = apr_pstrdup(result_pool, ci->repos_uuid);
+      if (changed_rev)
+        *changed_rev = ci->changed_rev;
+      if (changed_date)
+        *changed_date = ci->changed_date;
+      if (changed_author)
+        *changed_author = apr_pstrdup(result_pool, ci->changed_author);
+      if (depth)
+        *depth = ci->depth;
+      if (checksum)
+        *checksum = svn_checksum_dup(ci->checksum, result_pool);
+      if (target)
+        *target = apr_pstrdup(result_pool, ci->target);
+      if (original_repos_relpath)
+        *original_repos_relpath = apr_pstrdup(result_pool,
+                                              ci->original_repos_relpath);
+      if (original_root_url)
+        *original_root_url = apr_pstrdup(result_pool, ci->original_root_url);
+      if (original_uuid)
+        *original_uuid = apr_pstrdup(result_pool, ci->original_uuid);
+      if (original_revision)
+        *original_revision = ci->original_revision;
+      if (lock)
+        *lock = lock_dup(ci->lock, result_pool);
+      if (recorded_size)
+        *recorded_size = ci->recorded_size;
+      if (recorded_time)
+        *recorded_time = ci->recorded_time;
+      if (changelist)
+        *changelist = apr_pstrdup(result_pool, ci->changelist);
+      if (conflicted)
+        *conflicted = ci->conflicted;
+      if (op_root)
+        *op_root = ci->op_root;
+      if (have_props)
+        *have_props = ci->have_props;
+      if (props_mod)
+        *props_mod = ci->props_mod;
+      if (have_base)
+        *have_base = ci->have_base;
+      if (have_more_work)
+        *have_more_work = ci->have_more_work;
+      if (have_work)
+        *have_work = ci->have_work;
+
+      return SVN_NO_ERROR;
+    }
+
   SVN_WC__DB_WITH_TXN4(
           read_info(status, kind, revision, repos_relpath, &repos_id,
                     changed_rev, changed_date, changed_author,
@@ -10454,6 +10850,7 @@ svn_wc__db_read_props(apr_hash_t **props,
 {
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
+  read_cache_node_t *node;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
@@ -10461,6 +10858,26 @@ svn_wc__db_read_props(apr_hash_t **props,
                               local_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  node = read_cache_get(db, wcroot, local_relpath);
+  if (node)
+    {
+      if (!node->props)
+        {
+          apr_hash_t *cached_props;
+
+          SVN_WC__DB_WITH_TXN(
+                  svn_wc__db_read_props_internal(&cached_props, wcroot,
+                                                 local_relpath,
+                                                 db->read_cache_pool,
+                                                 scratch_pool),
+                  wcroot);
+          node->props = cached_props;
+        }
+
+      *props = svn_prop_hash_dup(node->props, result_pool);
+      return SVN_NO_ERROR;
+    }
+
   SVN_WC__DB_WITH_TXN(svn_wc__db_read_props_internal(props, wcroot,
                                                      local_relpath,
                                                      result_pool,
@@ -13599,6 +14016,101 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__db_wq_fetch_following(apr_array_header_t **ids,
+                              apr_array_header_t **work_items,
+                              svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              apr_uint64_t after_id,
+                              int max_items,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  *ids = apr_array_make(result_pool, max_items, sizeof(apr_uint64_t));
+  *work_items = apr_array_make(result_pool, max_items, sizeof(svn_skel_t *));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_WORK_ITEMS_FOLLOWING));
+  SVN_ERR(svn_sqlite__bindf(stmt, "id", (apr_int64_t)after_id, max_items));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  while (have_row)
+    {
+      apr_size_t len;
+      const void *val;
+
+      APR_ARRAY_PUSH(*ids, apr_uint64_t) = svn_sqlite__column_int64(stmt, 0);
+
+      val = svn_sqlite__column_blob(stmt, 1, &len, result_pool);
+      APR_ARRAY_PUSH(*work_items, svn_skel_t *)
+        = svn_skel__parse(val, len, result_pool);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Delete the work items IDS from wcroot and record the timestamps and
+   sizes in RECORD_MAP, if not NULL. */
+static svn_error_t *
+wq_record_and_complete(svn_wc__db_wcroot_t *wcroot,
+                       const apr_array_header_t *ids,
+                       apr_hash_t *record_map,
+                       apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  int i;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_DELETE_WORK_ITEM));
+  for (i = 0; i < ids->nelts; i++)
+    {
+      SVN_ERR(svn_sqlite__bind_int64(stmt, 1,
+                                     APR_ARRAY_IDX(ids, i, apr_uint64_t)));
+      SVN_ERR(svn_sqlite__step_done(stmt));
+    }
+
+  if (record_map)
+    SVN_ERR(wq_record(wcroot, record_map, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_wq_record_and_complete(svn_wc__db_t *db,
+                                  const char *wri_abspath,
+                                  const apr_array_header_t *ids,
+                                  apr_hash_t *record_map,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_WC__DB_WITH_TXN(
+    wq_record_and_complete(wcroot, ids, record_map, scratch_pool),
+    wcroot);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* ### temporary API. remove before release.  */
@@ -16070,11 +16582,25 @@ svn_wc__db_vacuum(svn_wc__db_t *db,
 {
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
+  svn_boolean_t incremental, done;
 
   SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath,
                                                 db, local_abspath,
                                                 scratch_pool, scratch_pool));
-  SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb, STMT_VACUUM));
+
+  /* Give back 4 MB (with the default page size) at a time. */
+  do
+    SVN_ERR(svn_sqlite__incremental_vacuum(&incremental, &done, wcroot->sdb,
+                                           1024, scratch_pool));
+  while (incremental && !done);
+
+  /* Older databases need to be rebuilt once.  That also makes them
+     support incremental vacuuming from now on. */
+  if (!incremental)
+    {
+      SVN_ERR(svn_sqlite__enable_incremental_vacuum(wcroot->sdb));
+      SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb, STMT_VACUUM));
+    }
 
   return SVN_NO_ERROR;
 }
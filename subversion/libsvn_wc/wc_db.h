@@ -269,6 +269,24 @@ svn_error_t *
 svn_wc__db_close(svn_wc__db_t *db);
 
 
+/* Start caching the results of svn_wc__db_read_info(),
+   svn_wc__db_base_get_info() and svn_wc__db_read_props() in DB, for an
+   operation that asks for the same nodes several times.  A cached result
+   is used until the working copy database it came from is modified through
+   DB, or until the matching svn_wc__db_read_cache_end().  Calls nest.
+
+   Changes made by other processes or through another svn_wc__db_t are not
+   noticed, so only do this while holding the write lock on the nodes that
+   are read. */
+void
+svn_wc__db_read_cache_begin(svn_wc__db_t *db);
+
+/* Undo one svn_wc__db_read_cache_begin() on DB, and release the cache
+   when there are no other users left. */
+void
+svn_wc__db_read_cache_end(svn_wc__db_t *db);
+
+
 /* Initialize the SDB for LOCAL_ABSPATH, which should be a working copy path.
 
    A REPOSITORY row will be constructed for the repository identified by
@@ -905,6 +923,10 @@ svn_wc__db_base_get_lock_tokens_recursive(apr_hash_t **lock_tokens,
    ### This is temporary - callers should not be looking at the file
    directly.
 
+   If the pristine text is stored compressed, an uncompressed copy is
+   created at *PRISTINE_ABSPATH first; it is kept until the pristine text
+   is removed from the store.
+
    Allocate the path in RESULT_POOL. */
 svn_error_t *
 svn_wc__db_pristine_get_path(const char **pristine_abspath,
@@ -925,6 +947,18 @@ svn_wc__db_pristine_get_future_path(const char **pristine_abspath,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
 
+/* Set *CONTENTS to a readable stream of the pristine text stored at
+   PRISTINE_ABSPATH, as returned by svn_wc__db_pristine_get_future_path(),
+   decompressing it if it is stored compressed.  This does not access the
+   database, so the caller must know the pristine text is in the store.
+
+   Allocate the stream in RESULT_POOL. */
+svn_error_t *
+svn_wc__db_pristine_read_future(svn_stream_t **contents,
+                                const char *pristine_abspath,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
 
 /* If requested set *CONTENTS to a readable stream that will yield the pristine
    text identified by SHA1_CHECKSUM (must be a SHA-1 checksum) within the WC
@@ -1040,7 +1074,12 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
                            apr_pool_t *scratch_pool);
 
 
-/* Remove all unreferenced pristines in the WC of WRI_ABSPATH in DB. */
+/* Remove all unreferenced pristines in the WC of WRI_ABSPATH in DB.
+ *
+ * This works in small batches, each in its own transaction, and does
+ * not need a write lock on the working copy.  It stops early, leaving the
+ * remaining pristines for later, as soon as the work queue is not empty,
+ * because queued work items may refer to unreferenced pristines. */
 svn_error_t *
 svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                             const char *wri_abspath,
@@ -1057,6 +1096,31 @@ svn_wc__db_pristine_check(svn_boolean_t *present,
                           const svn_checksum_t *sha1_checksum,
                           apr_pool_t *scratch_pool);
 
+/* Let DB fetch pristine texts that its working copies know but do not
+   store by calling FETCH_FUNC with FETCH_BATON. */
+void
+svn_wc__db_set_pristine_fetch(svn_wc__db_t *db,
+                              svn_wc__pristine_fetch_func_t fetch_func,
+                              void *fetch_baton);
+
+/* Make sure the pristine text with SHA-1 checksum SHA1_CHECKSUM is stored
+   in the pristine store for WRI_ABSPATH in DB, fetching it from the
+   repository if it was removed by svn_wc__db_pristine_dehydrate(). */
+svn_error_t *
+svn_wc__db_pristine_hydrate(svn_wc__db_t *db,
+                            const char *wri_abspath,
+                            const svn_checksum_t *sha1_checksum,
+                            apr_pool_t *scratch_pool);
+
+/* If DB is configured to use lazy pristines, remove the files of all
+   pristine texts of nodes with a repository location in the WC of
+   WRI_ABSPATH in DB, keeping their PRISTINE rows.  Do nothing if the
+   work queue is not empty. */
+svn_error_t *
+svn_wc__db_pristine_dehydrate(svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              apr_pool_t *scratch_pool);
+
 /* @defgroup svn_wc__db_external  External management
    @{ */
 
@@ -1725,6 +1789,19 @@ svn_wc__db_revert_list_read_copied_children(apr_array_header_t **children,
                                             apr_pool_t *result_pool,
                                             apr_pool_t *scratch_pool);
 
+/* Set *PATHS to a hash whose keys are the abspaths of all nodes in the
+ * revert list that are equal to LOCAL_ABSPATH or below it, using a
+ * single query.  Allocate *PATHS in RESULT_POOL.
+ *
+ * Unlike svn_wc__db_revert_list_read(), this leaves the revert list
+ * unchanged. */
+svn_error_t *
+svn_wc__db_revert_list_read_paths(apr_hash_t **paths,
+                                  svn_wc__db_t *db,
+                                  const char *local_abspath,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
 
 /* Make revert notifications for all paths in the revert list that are
  * equal to LOCAL_ABSPATH or below LOCAL_ABSPATH.
@@ -3028,6 +3105,37 @@ svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
                                     apr_pool_t *result_pool,
                                     apr_pool_t *scratch_pool);
 
+/* Fetch up to MAX_ITEMS work items queued after the one with id AFTER_ID,
+   for the working copy identified by WRI_ABSPATH, without marking any
+   work item as completed.  Set *IDS to an array of their apr_uint64_t
+   ids and *WORK_ITEMS to an array of the matching svn_skel_t * items, in
+   queue order.
+
+   This allows callers to run independent work items concurrently.
+
+   Allocate the results in RESULT_POOL and use SCRATCH_POOL for
+   temporary allocations.  */
+svn_error_t *
+svn_wc__db_wq_fetch_following(apr_array_header_t **ids,
+                              apr_array_header_t **work_items,
+                              svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              apr_uint64_t after_id,
+                              int max_items,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+/* Mark the work items with the apr_uint64_t ids in IDS as completed and,
+   in the same transaction, record timestamps and sizes from RECORD_MAP,
+   like svn_wc__db_wq_record_and_fetch_next() does.  RECORD_MAP may be
+   NULL.  */
+svn_error_t *
+svn_wc__db_wq_record_and_complete(svn_wc__db_t *db,
+                                  const char *wri_abspath,
+                                  const apr_array_header_t *ids,
+                                  apr_hash_t *record_map,
+                                  apr_pool_t *scratch_pool);
+
 
 /* @} */
 
@@ -3446,8 +3554,13 @@ svn_wc__db_base_moved_to(const char **move_dst_abspath,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
-/* Recover space from the database file for LOCAL_ABSPATH by running
- * the "vacuum" command. */
+/* Recover space from the database file for LOCAL_ABSPATH.
+ *
+ * Databases that support incremental vacuuming, which includes all that
+ * were created or vacuumed by this version, give back their unused pages
+ * in small steps, so that other processes can use the working copy in
+ * between.  Others are rebuilt by running the "vacuum" command once,
+ * which also makes them support incremental vacuuming. */
 svn_error_t *
 svn_wc__db_vacuum(svn_wc__db_t *db,
                   const char *local_abspath,
@@ -30,6 +30,7 @@
 #include "svn_dirent_uri.h"
 
 #include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
 
 #include "wc.h"
 #include "wc_db.h"
@@ -37,9 +38,19 @@
 #include "wc_db_private.h"
 
 #define PRISTINE_STORAGE_EXT ".svn-base"
+#define PRISTINE_COMPRESSED_EXT ".svn-zbase"
 #define PRISTINE_STORAGE_RELPATH "pristine"
 #define PRISTINE_TEMPDIR_RELPATH "tmp"
 
+/* Value of the PRISTINE.compression column for pristine texts stored as
+   written by svn_stream_compressed().  NULL means "not compressed". */
+#define PRISTINE_COMPRESSION_ZLIB 1
+
+/* Value of the PRISTINE.compression column for pristine texts that are
+   known to the store, but whose files were removed to save space.  They
+   are fetched from the repository again when needed. */
+#define PRISTINE_NOT_STORED 2
+
 
 
 /* Returns in PRISTINE_ABSPATH a new string allocated from RESULT_POOL,
@@ -92,6 +103,230 @@ get_pristine_fname(const char **pristine_abspath,
   return SVN_NO_ERROR;
 }
 
+/* Return the absolute path to the temporary directory for pristine text
+   files within WCROOT. */
+static char *
+pristine_get_tempdir(svn_wc__db_wcroot_t *wcroot,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  return svn_dirent_join_many(result_pool, wcroot->abspath,
+                              svn_wc_get_adm_dir(scratch_pool),
+                              PRISTINE_TEMPDIR_RELPATH, SVN_VA_NULL);
+}
+
+/* Return the location of the compressed form of the pristine file whose
+   uncompressed form is located at PRISTINE_ABSPATH, as returned by
+   get_pristine_fname().  Allocate the result in RESULT_POOL. */
+static const char *
+get_compressed_fname(const char *pristine_abspath,
+                     apr_pool_t *result_pool)
+{
+  apr_size_t len = strlen(pristine_abspath) - strlen(PRISTINE_STORAGE_EXT);
+
+  return apr_pstrcat(result_pool,
+                     apr_pstrmemdup(result_pool, pristine_abspath, len),
+                     PRISTINE_COMPRESSED_EXT, SVN_VA_NULL);
+}
+
+/* Return TRUE if column COLUMN of the current row of STMT, a PRISTINE.
+   compression value, says that the pristine text is stored compressed. */
+static svn_boolean_t
+column_is_compressed(svn_sqlite__stmt_t *stmt,
+                     int column)
+{
+  return !svn_sqlite__column_is_null(stmt, column)
+         && svn_sqlite__column_int(stmt, column) == PRISTINE_COMPRESSION_ZLIB;
+}
+
+/* Return TRUE if column COLUMN of the current row of STMT, a PRISTINE.
+   compression value, says that the pristine text is not stored locally. */
+static svn_boolean_t
+column_is_not_stored(svn_sqlite__stmt_t *stmt,
+                     int column)
+{
+  return !svn_sqlite__column_is_null(stmt, column)
+         && svn_sqlite__column_int(stmt, column) == PRISTINE_NOT_STORED;
+}
+
+/* Set *CONTENTS to a readable stream of the pristine text stored at
+ * PRISTINE_ABSPATH.  If that file does not exist and MAYBE_COMPRESSED is
+ * TRUE, read and decompress its compressed form instead.
+ *
+ * Allocate the stream in RESULT_POOL; use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+open_pristine_file(svn_stream_t **contents,
+                   const char *pristine_abspath,
+                   svn_boolean_t maybe_compressed,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  apr_file_t *file;
+  svn_error_t *err;
+
+  /* We don't enable APR_BUFFERED on this file to maximize throughput
+   * e.g. for fulltext comparison.  As we use SVN__STREAM_CHUNK_SIZE buffers
+   * where needed in streams, there is no point in having another layer of
+   * buffers. */
+  err = svn_io_file_open(&file, pristine_abspath, APR_READ, APR_OS_DEFAULT,
+                         result_pool);
+  if (err && maybe_compressed && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      SVN_ERR(svn_io_file_open(&file,
+                               get_compressed_fname(pristine_abspath,
+                                                    scratch_pool),
+                               APR_READ, APR_OS_DEFAULT, result_pool));
+      *contents = svn_stream_compressed(svn_stream_from_aprfile2(file, FALSE,
+                                                                 result_pool),
+                                        result_pool);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Make sure that the pristine text stored compressed next to
+ * PRISTINE_ABSPATH in WCROOT is also available uncompressed at
+ * PRISTINE_ABSPATH itself, for the callers that need a file to work on.
+ * That copy is removed together with the pristine text.
+ *
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+expand_compressed_pristine(svn_wc__db_wcroot_t *wcroot,
+                           const char *pristine_abspath,
+                           apr_pool_t *scratch_pool)
+{
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+  const char *tmp_abspath;
+
+  SVN_ERR(open_pristine_file(&src_stream, pristine_abspath, TRUE,
+                             scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_open_unique(&dst_stream, &tmp_abspath,
+                                 pristine_get_tempdir(wcroot, scratch_pool,
+                                                      scratch_pool),
+                                 svn_io_file_del_none,
+                                 scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_copy3(src_stream, dst_stream, NULL, NULL, scratch_pool));
+
+  /* If another process expanded it first, we just replace its copy with
+   * an identical one. */
+  SVN_ERR(svn_io_file_rename2(tmp_abspath, pristine_abspath, FALSE,
+                              scratch_pool));
+  SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch the pristine text identified by SHA1_CHECKSUM, which the store of
+ * WCROOT in DB knows but does not hold, from the repository and install
+ * it.  Find it at the repository location of a node referencing it.
+ *
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hydrate_pristine(svn_wc__db_t *db,
+                 svn_wc__db_wcroot_t *wcroot,
+                 const svn_checksum_t *sha1_checksum,
+                 apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  const char *repos_root_url;
+  const char *repos_relpath;
+  svn_revnum_t revision;
+  svn_stream_t *install_stream;
+  svn_wc__db_install_data_t *install_data;
+  svn_checksum_t *actual_sha1;
+  svn_checksum_t *actual_md5;
+  svn_error_t *err;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_PRISTINE_ORIGIN));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 1, wcroot->wc_id));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (! have_row || ! db->pristine_fetch_func)
+    return svn_error_createf(SVN_ERR_WC_PATH_NOT_FOUND,
+                             svn_sqlite__reset(stmt),
+                             _("Pristine text '%s' is not stored locally "
+                               "and can't be fetched"),
+                             svn_checksum_to_cstring_display(
+                               sha1_checksum, scratch_pool));
+
+  repos_root_url = svn_sqlite__column_text(stmt, 0, scratch_pool);
+  repos_relpath = svn_sqlite__column_text(stmt, 1, scratch_pool);
+  revision = svn_sqlite__column_revnum(stmt, 2);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&install_stream, &install_data,
+                                              &actual_sha1, &actual_md5,
+                                              db, wcroot->abspath,
+                                              scratch_pool, scratch_pool));
+
+  err = db->pristine_fetch_func(db->pristine_fetch_baton, install_stream,
+                                repos_root_url, repos_relpath, revision,
+                                scratch_pool);
+  if (! err)
+    err = svn_stream_close(install_stream);
+  if (! err && ! svn_checksum_match(sha1_checksum, actual_sha1))
+    err = svn_checksum_mismatch_err(sha1_checksum, actual_sha1, scratch_pool,
+                                    _("Checksum mismatch while fetching "
+                                      "the pristine text of '%s'"),
+                                    repos_relpath);
+  if (err)
+    return svn_error_compose_create(
+             err,
+             svn_wc__db_pristine_install_abort(install_data, scratch_pool));
+
+  return svn_error_trace(svn_wc__db_pristine_install(install_data,
+                                                     actual_sha1, actual_md5,
+                                                     scratch_pool));
+}
+
+/* Make sure that the pristine text identified by SHA1_CHECKSUM is stored
+ * in the pristine store of WCROOT in DB, fetching it if necessary.  This
+ * only accesses the database if no file is found.
+ *
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+ensure_pristine_stored(svn_wc__db_t *db,
+                       svn_wc__db_wcroot_t *wcroot,
+                       const svn_checksum_t *sha1_checksum,
+                       apr_pool_t *scratch_pool)
+{
+  const char *pristine_abspath;
+  svn_node_kind_t kind;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  svn_boolean_t not_stored;
+
+  SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                             sha1_checksum, scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_check_path(pristine_abspath, &kind, scratch_pool));
+  if (kind == svn_node_file)
+    return SVN_NO_ERROR;
+  SVN_ERR(svn_io_check_path(get_compressed_fname(pristine_abspath,
+                                                 scratch_pool),
+                            &kind, scratch_pool));
+  if (kind == svn_node_file)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb, STMT_SELECT_PRISTINE));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  not_stored = have_row && column_is_not_stored(stmt, 1);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  if (not_stored)
+    SVN_ERR(hydrate_pristine(db, wcroot, sha1_checksum, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_wc__db_pristine_get_path(const char **pristine_abspath,
@@ -104,6 +339,7 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
   svn_boolean_t present;
+  svn_node_kind_t kind;
 
   SVN_ERR_ASSERT(pristine_abspath != NULL);
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
@@ -121,6 +357,7 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
                                              scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  SVN_ERR(ensure_pristine_stored(db, wcroot, sha1_checksum, scratch_pool));
   SVN_ERR(svn_wc__db_pristine_check(&present, db, wri_abspath, sha1_checksum,
                                     scratch_pool));
   if (! present)
@@ -134,6 +371,13 @@ svn_wc__db_pristine_get_path(const char **pristine_abspath,
                              sha1_checksum,
                              result_pool, scratch_pool));
 
+  /* A pristine text that is only stored compressed must be expanded
+   * before our caller can use it as a file. */
+  SVN_ERR(svn_io_check_path(*pristine_abspath, &kind, scratch_pool));
+  if (kind != svn_node_file)
+    SVN_ERR(expand_compressed_pristine(wcroot, *pristine_abspath,
+                                       scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -150,11 +394,22 @@ svn_wc__db_pristine_get_future_path(const char **pristine_abspath,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__db_pristine_read_future(svn_stream_t **contents,
+                                const char *pristine_abspath,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(open_pristine_file(contents, pristine_abspath, TRUE,
+                                            result_pool, scratch_pool));
+}
+
 /* Set *CONTENTS to a readable stream from which the pristine text
  * identified by SHA1_CHECKSUM and PRISTINE_ABSPATH can be read from the
  * pristine store of WCROOT.  If SIZE is not null, set *SIZE to the size
  * in bytes of that text. If that text is not in the pristine store,
- * return an error.
+ * return an error.  If it is known but not stored locally, set
+ * *NOT_STORED to TRUE and leave *CONTENTS alone.
  *
  * Even if the pristine text is removed from the store while it is being
  * read, the stream will remain valid and readable until it is closed.
@@ -168,6 +423,7 @@ svn_wc__db_pristine_get_future_path(const char **pristine_abspath,
 static svn_error_t *
 pristine_read_txn(svn_stream_t **contents,
                   svn_filesize_t *size,
+                  svn_boolean_t *not_stored,
                   svn_wc__db_wcroot_t *wcroot,
                   const svn_checksum_t *sha1_checksum,
                   const char *pristine_abspath,
@@ -176,6 +432,7 @@ pristine_read_txn(svn_stream_t **contents,
 {
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
+  svn_boolean_t compressed;
 
   /* Check that this pristine text is present in the store.  (The presence
    * of the file is not sufficient.) */
@@ -186,6 +443,8 @@ pristine_read_txn(svn_stream_t **contents,
 
   if (size)
     *size = svn_sqlite__column_int64(stmt, 0);
+  compressed = have_row && column_is_compressed(stmt, 1);
+  *not_stored = have_row && column_is_not_stored(stmt, 1);
 
   SVN_ERR(svn_sqlite__reset(stmt));
   if (! have_row)
@@ -198,18 +457,10 @@ pristine_read_txn(svn_stream_t **contents,
 
   /* Open the file as a readable stream.  It will remain readable even when
    * deleted from disk; APR guarantees that on Windows as well as Unix.
-   *
-   * We also don't enable APR_BUFFERED on this file to maximize throughput
-   * e.g. for fulltext comparison.  As we use SVN__STREAM_CHUNK_SIZE buffers
-   * where needed in streams, there is no point in having another layer of
-   * buffers. */
-  if (contents)
-    {
-      apr_file_t *file;
-      SVN_ERR(svn_io_file_open(&file, pristine_abspath, APR_READ,
-                               APR_OS_DEFAULT, result_pool));
-      *contents = svn_stream_from_aprfile2(file, FALSE, result_pool);
-    }
+   * Prefer an expanded copy of a compressed pristine, if there is one. */
+  if (contents && ! *not_stored)
+    SVN_ERR(open_pristine_file(contents, pristine_abspath, compressed,
+                               result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -226,6 +477,7 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
   const char *pristine_abspath;
+  svn_boolean_t not_stored;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
 
@@ -247,30 +499,112 @@ svn_wc__db_pristine_read(svn_stream_t **contents,
                              sha1_checksum,
                              scratch_pool, scratch_pool));
   SVN_WC__DB_WITH_TXN(
-    pristine_read_txn(contents, size,
+    pristine_read_txn(contents, size, &not_stored,
                       wcroot, sha1_checksum, pristine_abspath,
                       result_pool, scratch_pool),
     wcroot);
 
+  /* Fetch a text that we don't store outside of the txn, and try again. */
+  if (contents && not_stored)
+    {
+      SVN_ERR(hydrate_pristine(db, wcroot, sha1_checksum, scratch_pool));
+      SVN_WC__DB_WITH_TXN(
+        pristine_read_txn(contents, NULL, &not_stored,
+                          wcroot, sha1_checksum, pristine_abspath,
+                          result_pool, scratch_pool),
+        wcroot);
+
+      /* Dehydrated again in the meantime? */
+      if (not_stored)
+        return svn_error_createf(SVN_ERR_WC_PATH_NOT_FOUND, NULL,
+                                 _("Pristine text '%s' not present"),
+                                 svn_checksum_to_cstring_display(
+                                   sha1_checksum, scratch_pool));
+    }
+
   return SVN_NO_ERROR;
 }
 
 
-/* Return the absolute path to the temporary directory for pristine text
-   files within WCROOT. */
-static char *
-pristine_get_tempdir(svn_wc__db_wcroot_t *wcroot,
-                     apr_pool_t *result_pool,
+/* Return the location of the copy of the pristine file PRISTINE_ABSPATH in
+ * the shared pristine store SHARED_DIR_ABSPATH.  Allocate the result in
+ * RESULT_POOL.  The shared store uses the same layout as ours. */
+static const char *
+get_shared_fname(const char *shared_dir_abspath,
+                 const char *pristine_abspath,
+                 apr_pool_t *result_pool)
+{
+  const char *subdir = svn_dirent_dirname(pristine_abspath, result_pool);
+
+  return svn_dirent_join_many(result_pool, shared_dir_abspath,
+                              svn_dirent_basename(subdir, NULL),
+                              svn_dirent_basename(pristine_abspath, NULL),
+                              SVN_VA_NULL);
+}
+
+/* Try to install the pristine file PRISTINE_ABSPATH as a hard link to its
+ * copy SHARED_ABSPATH in the shared pristine store.  On success, delete
+ * the no longer needed INSTALL_STREAM and set *LINKED to TRUE.  Otherwise
+ * set *LINKED to FALSE.
+ *
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+link_shared_pristine(svn_boolean_t *linked,
+                     svn_stream_t *install_stream,
+                     const char *pristine_abspath,
+                     const char *shared_abspath,
                      apr_pool_t *scratch_pool)
 {
-  return svn_dirent_join_many(result_pool, wcroot->abspath,
-                              svn_wc_get_adm_dir(scratch_pool),
-                              PRISTINE_TEMPDIR_RELPATH, SVN_VA_NULL);
+  svn_error_t *err;
+
+  SVN_ERR(svn_io_make_dir_recursively(svn_dirent_dirname(pristine_abspath,
+                                                         scratch_pool),
+                                      scratch_pool));
+
+  err = svn_io__file_link(shared_abspath, pristine_abspath, scratch_pool);
+  if (err)
+    {
+      /* Not in the store, not on the same file system, or whatever: just
+       * install our own copy. */
+      svn_error_clear(err);
+      *linked = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  *linked = TRUE;
+  return svn_error_trace(svn_stream__install_delete(install_stream,
+                                                    scratch_pool));
+}
+
+/* Add the newly installed pristine file PRISTINE_ABSPATH to the shared
+ * pristine store as SHARED_ABSPATH.  Failing to do so is not an error;
+ * the pristine text is then just not shared.
+ *
+ * Use SCRATCH_POOL for temporary allocations. */
+static void
+share_pristine(const char *pristine_abspath,
+               const char *shared_abspath,
+               apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+
+  err = svn_io_make_dir_recursively(svn_dirent_dirname(shared_abspath,
+                                                       scratch_pool),
+                                    scratch_pool);
+  if (!err)
+    err = svn_io__file_link(pristine_abspath, shared_abspath, scratch_pool);
+
+  svn_error_clear(err);
 }
 
 /* Install the pristine text described by BATON into the pristine store of
  * SDB.  If it is already stored then just delete the new file
- * BATON->tempfile_abspath.
+ * BATON->tempfile_abspath.  If it is known but not stored locally, store
+ * the new file and record how it is stored.  If COMPRESSED is TRUE, the
+ * new file holds the compressed form of a pristine text of SIZE bytes.
+ *
+ * If SHARED_DIR_ABSPATH is not NULL, it is the shared pristine store that
+ * the new pristine file should be (hard) linked with.
  *
  * This function expects to be executed inside a SQLite txn that has already
  * acquired a 'RESERVED' lock.
@@ -287,23 +621,39 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
                      const svn_checksum_t *sha1_checksum,
                      /* The pristine text's MD-5 checksum. */
                      const svn_checksum_t *md5_checksum,
+                     /* Whether INSTALL_STREAM holds compressed data. */
+                     svn_boolean_t compressed,
+                     /* The size of the uncompressed pristine text. */
+                     svn_filesize_t size,
+                     /* The shared pristine store, or NULL. */
+                     const char *shared_dir_abspath,
                      apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
+  svn_boolean_t linked = FALSE;
+  svn_boolean_t not_stored;
+#ifdef SVN_DEBUG
+  svn_boolean_t stored_compressed;
+#endif
 
   /* If this pristine text is already present in the store, just keep it:
    * delete the new one and return. */
   SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_PRISTINE));
   SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
   SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  not_stored = have_row && column_is_not_stored(stmt, 1);
+#ifdef SVN_DEBUG
+  stored_compressed = have_row && column_is_compressed(stmt, 1);
+#endif
   SVN_ERR(svn_sqlite__reset(stmt));
 
-  if (have_row)
+  if (have_row && ! not_stored)
     {
 #ifdef SVN_DEBUG
       /* Consistency checks.  Verify both files exist and match.
        * ### We could check much more. */
+      if (!compressed && !stored_compressed)
       {
         apr_finfo_t finfo1, finfo2;
 
@@ -332,19 +682,71 @@ pristine_install_txn(svn_sqlite__db_t *sdb,
   /* Move the file to its target location.  (If it is already there, it is
    * an orphan file and it doesn't matter if we overwrite it.) */
   {
-    apr_finfo_t finfo;
-    SVN_ERR(svn_stream__install_get_info(&finfo, install_stream,
-                                         APR_FINFO_SIZE, scratch_pool));
-    SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
-                                       TRUE, scratch_pool));
-
-    SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_PRISTINE));
-    SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
-    SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum, scratch_pool));
-    SVN_ERR(svn_sqlite__bind_int64(stmt, 3, finfo.size));
-    SVN_ERR(svn_sqlite__insert(NULL, stmt));
-
-    SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE, scratch_pool));
+    if (compressed)
+      {
+        pristine_abspath = get_compressed_fname(pristine_abspath,
+                                                scratch_pool);
+      }
+    else
+      {
+        apr_finfo_t finfo;
+        SVN_ERR(svn_stream__install_get_info(&finfo, install_stream,
+                                             APR_FINFO_SIZE, scratch_pool));
+        size = finfo.size;
+      }
+
+    /* Use the copy in the shared store if there is one; otherwise put
+     * ours there.  The link counts of these files act as their reference
+     * counts: our removing a pristine only ever removes our own link.
+     * The store only holds uncompressed texts, as it does not record
+     * how its files are stored. */
+    if (shared_dir_abspath && !compressed)
+      {
+        const char *shared_abspath = get_shared_fname(shared_dir_abspath,
+                                                      pristine_abspath,
+                                                      scratch_pool);
+
+        SVN_ERR(link_shared_pristine(&linked, install_stream,
+                                     pristine_abspath, shared_abspath,
+                                     scratch_pool));
+        if (! linked)
+          {
+            SVN_ERR(svn_stream__install_stream(install_stream,
+                                               pristine_abspath,
+                                               TRUE, scratch_pool));
+            share_pristine(pristine_abspath, shared_abspath, scratch_pool);
+          }
+      }
+    else
+      SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
+                                         TRUE, scratch_pool));
+
+    if (not_stored)
+      {
+        SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                          STMT_UPDATE_PRISTINE_COMPRESSION));
+        SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum,
+                                          scratch_pool));
+        if (compressed)
+          SVN_ERR(svn_sqlite__bind_int(stmt, 2, PRISTINE_COMPRESSION_ZLIB));
+        SVN_ERR(svn_sqlite__update(NULL, stmt));
+      }
+    else
+      {
+        SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_PRISTINE));
+        SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum,
+                                          scratch_pool));
+        SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum,
+                                          scratch_pool));
+        SVN_ERR(svn_sqlite__bind_int64(stmt, 3, size));
+        if (compressed)
+          SVN_ERR(svn_sqlite__bind_int(stmt, 4, PRISTINE_COMPRESSION_ZLIB));
+        SVN_ERR(svn_sqlite__insert(NULL, stmt));
+      }
+
+    if (! linked)
+      SVN_ERR(svn_io_set_file_read_only(pristine_abspath, FALSE,
+                                        scratch_pool));
   }
 
   return SVN_NO_ERROR;
@@ -354,8 +756,40 @@ struct svn_wc__db_install_data_t
 {
   svn_wc__db_wcroot_t *wcroot;
   svn_stream_t *inner_stream;
+
+  /* Whether INNER_STREAM receives the compressed pristine text, through
+     COMPRESSED_STREAM, and the number of bytes written before compression. */
+  svn_boolean_t compressed;
+  svn_stream_t *compressed_stream;
+  svn_filesize_t size;
+
+  /* The shared pristine store to link with, or NULL. */
+  const char *shared_dir_abspath;
 };
 
+/* Implements svn_write_fn_t, counting the bytes written to an install
+   stream.  BATON is a svn_wc__db_install_data_t. */
+static svn_error_t *
+write_handler_count(void *baton,
+                    const char *data,
+                    apr_size_t *len)
+{
+  svn_wc__db_install_data_t *install_data = baton;
+
+  install_data->size += *len;
+  return svn_error_trace(svn_stream_write(install_data->compressed_stream,
+                                          data, len));
+}
+
+/* Implements svn_close_fn_t for write_handler_count(). */
+static svn_error_t *
+close_handler_count(void *baton)
+{
+  svn_wc__db_install_data_t *install_data = baton;
+
+  return svn_error_trace(svn_stream_close(install_data->compressed_stream));
+}
+
 svn_error_t *
 svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
                                     svn_wc__db_install_data_t **install_data,
@@ -380,6 +814,7 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
 
   *install_data = apr_pcalloc(result_pool, sizeof(**install_data));
   (*install_data)->wcroot = wcroot;
+  (*install_data)->shared_dir_abspath = db->shared_pristine_abspath;
 
   SVN_ERR_W(svn_stream__create_for_install(stream,
                                            temp_dir_abspath,
@@ -388,12 +823,23 @@ svn_wc__db_pristine_prepare_install(svn_stream_t **stream,
 
   (*install_data)->inner_stream = *stream;
 
-  if (md5_checksum)
-    *stream = svn_stream_checksummed2(*stream, NULL, md5_checksum,
-                                      svn_checksum_md5, FALSE, result_pool);
-  if (sha1_checksum)
-    *stream = svn_stream_checksummed2(*stream, NULL, sha1_checksum,
-                                      svn_checksum_sha1, FALSE, result_pool);
+  /* Compress new pristine texts if so configured, keeping track of their
+   * uncompressed size.  INNER_STREAM stays the installable file stream. */
+  if (db->compress_pristines)
+    {
+      (*install_data)->compressed = TRUE;
+      (*install_data)->compressed_stream = svn_stream_compressed(*stream,
+                                                                 result_pool);
+      *stream = svn_stream_create(*install_data, result_pool);
+      svn_stream_set_write(*stream, write_handler_count);
+      svn_stream_set_close(*stream, close_handler_count);
+    }
+
+  /* Calculate both checksums in a single pass over the data. */
+  if (md5_checksum || sha1_checksum)
+    *stream = svn_checksum__wrap_write_stream_multi(md5_checksum,
+                                                    sha1_checksum, *stream,
+                                                    result_pool);
 
   return SVN_NO_ERROR;
 }
@@ -422,6 +868,8 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
     pristine_install_txn(wcroot->sdb,
                          install_data->inner_stream, pristine_abspath,
                          sha1_checksum, md5_checksum,
+                         install_data->compressed, install_data->size,
+                         install_data->shared_dir_abspath,
                          scratch_pool),
     wcroot->sdb);
 
@@ -514,13 +962,17 @@ svn_wc__db_pristine_get_sha1(const svn_checksum_t **sha1_checksum,
 }
 
 /* Handle the moving of a pristine from SRC_WCROOT to DST_WCROOT. The existing
-   pristine in SRC_WCROOT is described by CHECKSUM, MD5_CHECKSUM and SIZE */
+   pristine in SRC_WCROOT is described by CHECKSUM, MD5_CHECKSUM, SIZE,
+   COMPRESSED and NOT_STORED.  A compressed pristine is copied as is, and
+   one that is not stored locally just gets its row copied. */
 static svn_error_t *
 maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
                             svn_wc__db_wcroot_t *dst_wcroot,
                             const svn_checksum_t *checksum,
                             const svn_checksum_t *md5_checksum,
                             apr_int64_t size,
+                            svn_boolean_t compressed,
+                            svn_boolean_t not_stored,
                             svn_cancel_func_t cancel_func,
                             void *cancel_baton,
                             apr_pool_t *scratch_pool)
@@ -539,10 +991,14 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
   SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, checksum, scratch_pool));
   SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum, scratch_pool));
   SVN_ERR(svn_sqlite__bind_int64(stmt, 3, size));
+  if (compressed)
+    SVN_ERR(svn_sqlite__bind_int(stmt, 4, PRISTINE_COMPRESSION_ZLIB));
+  else if (not_stored)
+    SVN_ERR(svn_sqlite__bind_int(stmt, 4, PRISTINE_NOT_STORED));
 
   SVN_ERR(svn_sqlite__update(&affected_rows, stmt));
 
-  if (affected_rows == 0)
+  if (affected_rows == 0 || not_stored)
     return SVN_NO_ERROR;
 
   SVN_ERR(svn_stream_open_unique(&dst_stream, &tmp_abspath,
@@ -554,6 +1010,8 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
 
   SVN_ERR(get_pristine_fname(&src_abspath, src_wcroot->abspath, checksum,
                              scratch_pool, scratch_pool));
+  if (compressed)
+    src_abspath = get_compressed_fname(src_abspath, scratch_pool);
 
   SVN_ERR(svn_stream_open_readonly(&src_stream, src_abspath,
                                    scratch_pool, scratch_pool));
@@ -565,6 +1023,8 @@ maybe_transfer_one_pristine(svn_wc__db_wcroot_t *src_wcroot,
 
   SVN_ERR(get_pristine_fname(&pristine_abspath, dst_wcroot->abspath, checksum,
                              scratch_pool, scratch_pool));
+  if (compressed)
+    pristine_abspath = get_compressed_fname(pristine_abspath, scratch_pool);
 
   /* Move the file to its target location.  (If it is already there, it is
    * an orphan file and it doesn't matter if we overwrite it.) */
@@ -623,6 +1083,8 @@ pristine_transfer_txn(svn_wc__db_wcroot_t *src_wcroot,
       const svn_checksum_t *checksum;
       const svn_checksum_t *md5_checksum;
       apr_int64_t size;
+      svn_boolean_t compressed;
+      svn_boolean_t not_stored;
       svn_error_t *err;
 
       svn_pool_clear(iterpool);
@@ -630,9 +1092,12 @@ pristine_transfer_txn(svn_wc__db_wcroot_t *src_wcroot,
       SVN_ERR(svn_sqlite__column_checksum(&checksum, stmt, 0, iterpool));
       SVN_ERR(svn_sqlite__column_checksum(&md5_checksum, stmt, 1, iterpool));
       size = svn_sqlite__column_int64(stmt, 2);
+      compressed = column_is_compressed(stmt, 3);
+      not_stored = column_is_not_stored(stmt, 3);
 
       err = maybe_transfer_one_pristine(src_wcroot, dst_wcroot,
                                         checksum, md5_checksum, size,
+                                        compressed, not_stored,
                                         cancel_func, cancel_baton,
                                         iterpool);
 
@@ -702,8 +1167,19 @@ pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
                                     apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  svn_boolean_t compressed;
+  svn_boolean_t not_stored;
   int affected_rows;
 
+  /* Find out which file holds the pristine text. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SELECT_PRISTINE));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  compressed = have_row && column_is_compressed(stmt, 1);
+  not_stored = have_row && column_is_not_stored(stmt, 1);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
   /* Remove the DB row, if refcount is 0. */
   SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
                                     STMT_DELETE_PRISTINE_IF_UNREFERENCED));
@@ -711,7 +1187,7 @@ pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
   SVN_ERR(svn_sqlite__update(&affected_rows, stmt));
 
   /* If we removed the DB row, then remove the file. */
-  if (affected_rows > 0)
+  if (affected_rows > 0 && ! not_stored)
     {
       /* If the file is not present, something has gone wrong, but at this
        * point it no longer matters.  In a debug build, raise an error, but
@@ -722,6 +1198,14 @@ pristine_remove_if_unreferenced_txn(svn_sqlite__db_t *sdb,
       svn_boolean_t ignore_enoent = TRUE;
 #endif
 
+      if (compressed)
+        {
+          /* Also remove the expanded copy, if there is one. */
+          SVN_ERR(svn_io_remove_file2(pristine_abspath, TRUE, scratch_pool));
+          pristine_abspath = get_compressed_fname(pristine_abspath,
+                                                  scratch_pool);
+        }
+
       SVN_ERR(svn_io_remove_file2(pristine_abspath, ignore_enoent,
                                   scratch_pool));
     }
@@ -803,6 +1287,11 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
  * Look for pristine texts whose 'refcount' in the DB is zero, and remove
  * them from the 'pristine' table and from disk.
  *
+ * Do this in batches of PRISTINE_CLEANUP_BATCH pristines.  The query for
+ * each batch is completed before removing anything, so that other
+ * processes can commit their changes in between.  Stop as soon as the
+ * work queue is not empty, just like svn_wc__db_pristine_remove().
+ *
  * TODO: At least check that any zero refcount is really correct, before
  *       using it.  See dev@ email thread "Pristine text missing - cleanup
  *       doesn't work", <http://svn.haxx.se/dev/archive-2013-04/0426.shtml>.
@@ -829,38 +1318,138 @@ svn_wc__db_pristine_remove(svn_wc__db_t *db,
  *
  * TODO: Provide feedback about any errors found and any corrections made.
  */
+#define PRISTINE_CLEANUP_BATCH 256
+
 static svn_error_t *
 pristine_cleanup_wcroot(svn_wc__db_wcroot_t *wcroot,
                         apr_pool_t *scratch_pool)
 {
   svn_sqlite__stmt_t *stmt;
-  svn_error_t *err = NULL;
+  apr_array_header_t *batch;
+  apr_pool_t *batchpool = svn_pool_create(scratch_pool);
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
 
-  /* Find each unreferenced pristine in the DB and remove it. */
-  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                    STMT_SELECT_UNREFERENCED_PRISTINES));
-  while (! err)
+  do
     {
       svn_boolean_t have_row;
-      const svn_checksum_t *sha1_checksum;
+      int i;
 
-      svn_pool_clear(iterpool);
+      svn_pool_clear(batchpool);
 
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_LOOK_FOR_WORK));
       SVN_ERR(svn_sqlite__step(&have_row, stmt));
-      if (! have_row)
+      SVN_ERR(svn_sqlite__reset(stmt));
+      if (have_row)
         break;
 
-      SVN_ERR(svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
-                                          iterpool));
-      err = pristine_remove_if_unreferenced(wcroot, sha1_checksum,
-                                            iterpool);
+      /* Find the next batch of unreferenced pristines in the DB ... */
+      batch = apr_array_make(batchpool, PRISTINE_CLEANUP_BATCH,
+                             sizeof(const svn_checksum_t *));
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_SELECT_UNREFERENCED_PRISTINES));
+      SVN_ERR(svn_sqlite__bind_int(stmt, 1, PRISTINE_CLEANUP_BATCH));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      while (have_row)
+        {
+          svn_error_t *err;
+          const svn_checksum_t *sha1_checksum;
+
+          err = svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
+                                            batchpool);
+          if (err)
+            return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+
+          APR_ARRAY_PUSH(batch, const svn_checksum_t *) = sha1_checksum;
+          SVN_ERR(svn_sqlite__step(&have_row, stmt));
+        }
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      /* ... and remove them. */
+      for (i = 0; i < batch->nelts; ++i)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(pristine_remove_if_unreferenced(
+                    wcroot, APR_ARRAY_IDX(batch, i, const svn_checksum_t *),
+                    iterpool));
+        }
+    }
+  while (batch->nelts == PRISTINE_CLEANUP_BATCH);
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(batchpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the files in the shared pristine store SHARED_DIR_ABSPATH that
+ * are no longer linked from any working copy's pristine store.
+ *
+ * Another working copy may link to such a file while we remove it.  That
+ * is harmless: its own link stays valid, it is just no longer shared.
+ *
+ * ### This visits every file in the store, which is why only cleanup
+ * ### does it.
+ */
+static svn_error_t *
+pristine_cleanup_shared(const char *shared_dir_abspath,
+                        apr_pool_t *scratch_pool)
+{
+  apr_hash_t *subdirs;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err;
+
+  err = svn_io_get_dirents3(&subdirs, shared_dir_abspath, TRUE,
+                            scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  for (hi = apr_hash_first(scratch_pool, subdirs); hi; hi = apr_hash_next(hi))
+    {
+      const char *subdir_abspath;
+      const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+      apr_hash_t *files;
+      apr_hash_index_t *hj;
+
+      if (dirent->kind != svn_node_dir)
+        continue;
+
+      svn_pool_clear(iterpool);
+      subdir_abspath = svn_dirent_join(shared_dir_abspath,
+                                       apr_hash_this_key(hi), iterpool);
+      SVN_ERR(svn_io_get_dirents3(&files, subdir_abspath, TRUE,
+                                  iterpool, iterpool));
+
+      for (hj = apr_hash_first(iterpool, files); hj; hj = apr_hash_next(hj))
+        {
+          const char *file_abspath = svn_dirent_join(subdir_abspath,
+                                                     apr_hash_this_key(hj),
+                                                     iterpool);
+          apr_finfo_t finfo;
+
+          err = svn_io_stat(&finfo, file_abspath, APR_FINFO_NLINK, iterpool);
+          if (err && APR_STATUS_IS_INCOMPLETE(err->apr_err))
+            {
+              /* No link counts on this platform; keep everything. */
+              svn_error_clear(err);
+              svn_pool_destroy(iterpool);
+              return SVN_NO_ERROR;
+            }
+          SVN_ERR(err);
+
+          if (finfo.filetype == APR_REG && finfo.nlink == 1)
+            SVN_ERR(svn_io_remove_file2(file_abspath, TRUE, iterpool));
+        }
     }
 
   svn_pool_destroy(iterpool);
 
-  return svn_error_trace(
-      svn_error_compose_create(err, svn_sqlite__reset(stmt)));
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -879,6 +1468,10 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
 
   SVN_ERR(pristine_cleanup_wcroot(wcroot, scratch_pool));
 
+  if (db->shared_pristine_abspath)
+    SVN_ERR(pristine_cleanup_shared(db->shared_pristine_abspath,
+                                    scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -937,8 +1530,15 @@ svn_wc__db_pristine_check(svn_boolean_t *present,
       return svn_error_trace(err);
     else if (kind_on_disk != svn_node_file)
       {
-        *present = FALSE;
-        return SVN_NO_ERROR;
+        /* Maybe it is stored compressed. */
+        SVN_ERR(svn_io_check_path(get_compressed_fname(pristine_abspath,
+                                                       scratch_pool),
+                                  &kind_on_disk, scratch_pool));
+        if (kind_on_disk != svn_node_file)
+          {
+            *present = FALSE;
+            return SVN_NO_ERROR;
+          }
       }
   }
 
@@ -951,3 +1551,127 @@ svn_wc__db_pristine_check(svn_boolean_t *present,
   *present = have_row;
   return SVN_NO_ERROR;
 }
+
+
+void
+svn_wc__db_set_pristine_fetch(svn_wc__db_t *db,
+                              svn_wc__pristine_fetch_func_t fetch_func,
+                              void *fetch_baton)
+{
+  db->pristine_fetch_func = fetch_func;
+  db->pristine_fetch_baton = fetch_baton;
+}
+
+svn_error_t *
+svn_wc__db_pristine_hydrate(svn_wc__db_t *db,
+                            const char *wri_abspath,
+                            const svn_checksum_t *sha1_checksum,
+                            apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+  SVN_ERR_ASSERT(sha1_checksum != NULL);
+  SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  return svn_error_trace(ensure_pristine_stored(db, wcroot, sha1_checksum,
+                                                scratch_pool));
+}
+
+/* Remove the files of the pristine text SHA1_CHECKSUM from the store of
+ * WCROOT, and record that they are not stored.
+ *
+ * This function expects to be executed inside a SQLite txn that has already
+ * acquired a 'RESERVED' lock.
+ */
+static svn_error_t *
+pristine_dehydrate_txn(svn_wc__db_wcroot_t *wcroot,
+                       const svn_checksum_t *sha1_checksum,
+                       apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  const char *pristine_abspath;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_UPDATE_PRISTINE_COMPRESSION));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__bind_int(stmt, 2, PRISTINE_NOT_STORED));
+  SVN_ERR(svn_sqlite__update(NULL, stmt));
+
+  SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                             sha1_checksum, scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_remove_file2(pristine_abspath, TRUE, scratch_pool));
+  SVN_ERR(svn_io_remove_file2(get_compressed_fname(pristine_abspath,
+                                                   scratch_pool),
+                              TRUE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_pristine_dehydrate(svn_wc__db_t *db,
+                              const char *wri_abspath,
+                              apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_array_header_t *checksums;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  if (! db->lazy_pristines)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  /* Pending work items may still need the files, just like in
+   * svn_wc__db_pristine_remove(). */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb, STMT_LOOK_FOR_WORK));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  SVN_ERR(svn_sqlite__reset(stmt));
+  if (have_row)
+    return SVN_NO_ERROR;
+
+  /* Collect the candidates first, as removing them updates their rows. */
+  checksums = apr_array_make(scratch_pool, 0, sizeof(const svn_checksum_t *));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_DEHYDRATABLE_PRISTINES));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 1, wcroot->wc_id));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const svn_checksum_t *sha1_checksum;
+
+      SVN_ERR(svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
+                                          scratch_pool));
+      APR_ARRAY_PUSH(checksums, const svn_checksum_t *) = sha1_checksum;
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < checksums->nelts; i++)
+    {
+      const svn_checksum_t *sha1_checksum
+        = APR_ARRAY_IDX(checksums, i, const svn_checksum_t *);
+
+      svn_pool_clear(iterpool);
+      SVN_SQLITE__WITH_IMMEDIATE_TXN(
+        pristine_dehydrate_txn(wcroot, sha1_checksum, iterpool),
+        wcroot->sdb);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
@@ -52,6 +52,24 @@ struct svn_wc__db_t {
   /* Busy timeout in ms., 0 for the libsvn_subr default. */
   apr_int32_t timeout;
 
+  /* Should Sqlite databases use write-ahead logging? */
+  svn_boolean_t wal_journaling;
+
+  /* Should new pristine texts be stored compressed? */
+  svn_boolean_t compress_pristines;
+
+  /* The directory shared by the pristine stores of all working copies
+     using this context, or NULL. */
+  const char *shared_pristine_abspath;
+
+  /* Should pristine texts of unmodified nodes be removed after updates,
+     to be fetched again through PRISTINE_FETCH_FUNC when needed? */
+  svn_boolean_t lazy_pristines;
+
+  /* Callback fetching a pristine text from the repository, or NULL. */
+  svn_wc__pristine_fetch_func_t pristine_fetch_func;
+  void *pristine_fetch_baton;
+
   /* Map a given working copy directory to its relevant data.
      const char *local_abspath -> svn_wc__db_wcroot_t *wcroot  */
   apr_hash_t *dir_data;
@@ -64,6 +82,16 @@ struct svn_wc__db_t {
     svn_node_kind_t kind;
   } parse_cache;
 
+  /* The read cache of svn_wc__db_read_cache_begin(), or NULL when it is
+     disabled.  READ_CACHE maps local_relpath -> read_cache_node_t * for
+     READ_CACHE_WCROOT, and is only valid as long as the database of that
+     wcroot has seen READ_CACHE_CHANGES changes.  See read_cache_get(). */
+  apr_pool_t *read_cache_pool;
+  apr_hash_t *read_cache;
+  struct svn_wc__db_wcroot_t *read_cache_wcroot;
+  int read_cache_changes;
+  int read_cache_users;
+
   /* As we grow the state of this DB, allocate that state here. */
   apr_pool_t *state_pool;
 };
@@ -152,6 +180,12 @@ svn_wc__db_wcroot_parse_local_abspath(svn_wc__db_wcroot_t **wcroot,
 svn_error_t *
 svn_wc__db_verify_no_work(svn_sqlite__db_t *sdb);
 
+/* Forget everything in the read cache of DB, if any.  Call this before
+   closing a wcroot, so that the cache can't be mistaken for the cache of
+   another wcroot that reuses its memory. */
+void
+svn_wc__db_read_cache_clear(svn_wc__db_t *db);
+
 /* Assert that the given WCROOT is usable.
    NOTE: the expression is multiply-evaluated!!  */
 #define VERIFY_USABLE_WCROOT(wcroot)  SVN_ERR_ASSERT(               \
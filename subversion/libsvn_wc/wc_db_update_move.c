@@ -253,6 +253,10 @@ typedef struct update_move_baton_t {
   svn_wc_conflict_version_t *old_version;
   svn_wc_conflict_version_t *new_version;
 
+  /* The move source relpaths, mapped to themselves, below which the source
+     and the destination may differ, or NULL to visit every node. */
+  apr_hash_t *dirty;
+
   svn_cancel_func_t cancel_func;
   void *cancel_baton;
 } update_move_baton_t;
@@ -2118,13 +2122,17 @@ update_moved_away_node(node_move_baton_t *nmb,
           cnmb.dst_relpath = svn_relpath_join(dst_relpath, child_name,
                                               iterpool);
 
-          if (!cnmb.shadowed)
-            SVN_ERR(check_node_shadowed(&cnmb.shadowed, wcroot,
-                                        cnmb.dst_relpath, b->dst_op_depth,
-                                        iterpool));
+          /* Subtrees that are identical on both sides need no edits. */
+          if (!b->dirty || svn_hash_gets(b->dirty, cnmb.src_relpath))
+            {
+              if (!cnmb.shadowed)
+                SVN_ERR(check_node_shadowed(&cnmb.shadowed, wcroot,
+                                            cnmb.dst_relpath,
+                                            b->dst_op_depth, iterpool));
 
-          SVN_ERR(update_moved_away_node(&cnmb, wcroot, cnmb.src_relpath,
-                                         cnmb.dst_relpath, iterpool));
+              SVN_ERR(update_moved_away_node(&cnmb, wcroot, cnmb.src_relpath,
+                                             cnmb.dst_relpath, iterpool));
+            }
 
           if (!dst_only)
             ++i;
@@ -2139,6 +2147,54 @@ update_moved_away_node(node_move_baton_t *nmb,
   return SVN_NO_ERROR;
 }
 
+/* Set *DIRTY to a hash containing the relpaths of the nodes below the move
+   source SRC_RELPATH at SRC_OP_DEPTH, including SRC_RELPATH itself, that
+   must be visited by update_moved_away_node() because they, or one of
+   their descendants, differ from the corresponding node below the move
+   destination DST_RELPATH at DST_OP_DEPTH.
+
+   This lets the driver skip the (usually much larger) part of the tree
+   that the update did not touch, with a single query instead of a few
+   queries per node. */
+static svn_error_t *
+find_move_update_differences(apr_hash_t **dirty,
+                             svn_wc__db_wcroot_t *wcroot,
+                             const char *src_relpath,
+                             int src_op_depth,
+                             const char *dst_relpath,
+                             int dst_op_depth,
+                             apr_pool_t *result_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  *dirty = apr_hash_make(result_pool);
+  svn_hash_sets(*dirty, src_relpath, src_relpath);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_MOVE_UPDATE_DIFFERENCES));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isdsd", wcroot->wc_id,
+                            src_relpath, src_op_depth,
+                            dst_relpath, dst_op_depth));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const char *relpath = svn_sqlite__column_text(stmt, 0, NULL);
+
+      /* Mark the node and all its ancestors up to the move root */
+      while (!svn_hash_gets(*dirty, relpath))
+        {
+          relpath = apr_pstrdup(result_pool, relpath);
+          svn_hash_sets(*dirty, relpath, relpath);
+          relpath = svn_relpath_dirname(relpath, result_pool);
+        }
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
 static svn_error_t *
 suitable_for_move(svn_wc__db_wcroot_t *wcroot,
                   const char *local_relpath,
@@ -2291,6 +2347,11 @@ update_moved_away_conflict_victim(svn_revnum_t *old_rev,
   if (umb.src_op_depth == 0)
     SVN_ERR(suitable_for_move(wcroot, src_relpath, scratch_pool));
 
+  SVN_ERR(find_move_update_differences(&umb.dirty, wcroot,
+                                       src_relpath, umb.src_op_depth,
+                                       dst_relpath, umb.dst_op_depth,
+                                       scratch_pool));
+
   /* Create a new, and empty, list for notification information. */
   SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb,
                                       STMT_CREATE_UPDATE_MOVE_LIST));
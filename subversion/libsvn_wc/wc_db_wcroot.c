@@ -261,6 +261,55 @@ svn_wc__db_open(svn_wc__db_t **db,
         svn_error_clear(err);
       else
         (*db)->timeout = (apr_int32_t)timeout;
+
+      err = svn_config_get_bool(config, &(*db)->wal_journaling,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_WAL_JOURNALING,
+                                FALSE);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->wal_journaling = FALSE;
+        }
+
+      err = svn_config_get_bool(config, &(*db)->compress_pristines,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_COMPRESS_PRISTINES,
+                                FALSE);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->compress_pristines = FALSE;
+        }
+
+      err = svn_config_get_bool(config, &(*db)->lazy_pristines,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_LAZY_PRISTINES,
+                                FALSE);
+      if (err)
+        {
+          svn_error_clear(err);
+          (*db)->lazy_pristines = FALSE;
+        }
+
+      {
+        const char *shared_dir;
+
+        svn_config_get(config, &shared_dir, SVN_CONFIG_SECTION_WORKING_COPY,
+                       SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE, NULL);
+        if (shared_dir && *shared_dir)
+          {
+            err = svn_dirent_get_absolute(&(*db)->shared_pristine_abspath,
+                                          svn_dirent_internal_style(
+                                            shared_dir, scratch_pool),
+                                          result_pool);
+            if (err)
+              {
+                svn_error_clear(err);
+                (*db)->shared_pristine_abspath = NULL;
+              }
+          }
+      }
     }
 
   return SVN_NO_ERROR;
@@ -274,6 +323,8 @@ svn_wc__db_close(svn_wc__db_t *db)
   apr_hash_t *roots = apr_hash_make(scratch_pool);
   apr_hash_index_t *hi;
 
+  svn_wc__db_read_cache_clear(db);
+
   /* Collect all the unique WCROOT structures, and empty out DIR_DATA.  */
   for (hi = apr_hash_first(scratch_pool, db->dir_data);
        hi;
@@ -638,6 +689,16 @@ svn_wc__db_wcroot_parse_local_abspath(svn_wc__db_wcroot_t **wcroot,
                                         svn_sqlite__mode_readwrite,
                                         db->exclusive, db->timeout, NULL,
                                         db->state_pool, scratch_pool);
+          /* Exclusive locking is meant for network file systems, where
+             write-ahead logging doesn't work.  It also leaves no other
+             connections that WAL could help. */
+          if (err == NULL && !db->exclusive)
+            {
+              svn_boolean_t wal;
+
+              SVN_ERR(svn_sqlite__set_wal(&wal, sdb, db->wal_journaling,
+                                          scratch_pool));
+            }
           if (err == NULL)
             {
 #ifdef SVN_DEBUG
@@ -1005,6 +1066,8 @@ svn_wc__db_drop_root(svn_wc__db_t *db,
         svn_hash_sets(db->dir_data, apr_hash_this_key(hi), NULL);
     }
 
+  svn_wc__db_read_cache_clear(db);
+
   result = apr_pool_cleanup_run(db->state_pool, root_wcroot, close_wcroot);
   if (result != APR_SUCCESS)
     return svn_error_wrap_apr(result, NULL);
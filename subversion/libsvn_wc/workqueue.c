@@ -22,6 +22,9 @@
  */
 
 #include <apr_pools.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
 
 #include "svn_private_config.h"
 #include "svn_types.h"
@@ -84,6 +87,11 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
                         svn_boolean_t ignore_enoent,
                         apr_pool_t *scratch_pool);
 
+static void
+record_dirent(work_item_baton_t *wqb,
+              const char *local_abspath,
+              const svn_io_dirent2_t *dirent);
+
 /* ------------------------------------------------------------------------ */
 /* OP_REMOVE_BASE  */
 
@@ -275,11 +283,12 @@ install_committed_file(svn_boolean_t *overwrote_working,
 }
 
 static svn_error_t *
-process_commit_file_install(svn_wc__db_t *db,
-                       const char *local_abspath,
-                       svn_cancel_func_t cancel_func,
-                       void *cancel_baton,
-                       apr_pool_t *scratch_pool)
+process_commit_file_install(work_item_baton_t *wqb,
+                            svn_wc__db_t *db,
+                            const char *local_abspath,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *scratch_pool)
 {
   svn_boolean_t overwrote_working;
 
@@ -297,20 +306,18 @@ process_commit_file_install(svn_wc__db_t *db,
                                  cancel_func, cancel_baton,
                                  scratch_pool));
 
-  /* We will compute and modify the size and timestamp */
+  /* We will compute and modify the size and timestamp.  Like the other
+     file info we record, it is stored when the work item completes, in
+     the same transaction, instead of in a transaction of its own. */
   if (overwrote_working)
     {
-      apr_finfo_t finfo;
-
-      SVN_ERR(svn_io_stat(&finfo, local_abspath,
-                          APR_FINFO_MIN | APR_FINFO_LINK, scratch_pool));
-      SVN_ERR(svn_wc__db_global_record_fileinfo(db, local_abspath,
-                                                finfo.size, finfo.mtime,
-                                                scratch_pool));
+      SVN_ERR(get_and_record_fileinfo(wqb, local_abspath, FALSE,
+                                      scratch_pool));
     }
   else
     {
       svn_boolean_t modified;
+      const svn_io_dirent2_t *dirent;
 
       /* The working copy file hasn't been overwritten.  We just
          removed the recorded size and modification time from the nodes
@@ -324,12 +331,13 @@ process_commit_file_install(svn_wc__db_t *db,
          the recorded information. (If it isn't we keep the null data).
 
          Instead of reimplementing all this here, we just call a function
-         that already does implement this when it notices that we have the
-         right kind of lock (and we ignore the result)
+         that already does implement this (and we ignore the result)
        */
-      SVN_ERR(svn_wc__internal_file_modified_p(&modified,
-                                               db, local_abspath, FALSE,
-                                               scratch_pool));
+      SVN_ERR(svn_wc__internal_file_modified_p2(&modified, &dirent,
+                                                db, local_abspath, FALSE,
+                                                scratch_pool, scratch_pool));
+      if (dirent)
+        record_dirent(wqb, local_abspath, dirent);
     }
   return SVN_NO_ERROR;
 }
@@ -355,7 +363,7 @@ run_file_commit(work_item_baton_t *wqb,
   /* We don't both parsing the other two values in the skel. */
 
   return svn_error_trace(
-                process_commit_file_install(db, local_abspath,
+                process_commit_file_install(wqb, db, local_abspath,
                                             cancel_func, cancel_baton,
                                             scratch_pool));
 }
@@ -445,46 +453,73 @@ svn_wc__wq_build_postupgrade(svn_skel_t **work_item,
 
 /* OP_FILE_INSTALL */
 
-/* Process the OP_FILE_INSTALL work item WORK_ITEM.
- * See svn_wc__wq_build_file_install() which generates this work item.
- * Implements (struct work_item_dispatch).func. */
-static svn_error_t *
-run_file_install(work_item_baton_t *wqb,
-                 svn_wc__db_t *db,
-                 const svn_skel_t *work_item,
-                 const char *wri_abspath,
-                 svn_cancel_func_t cancel_func,
-                 void *cancel_baton,
-                 apr_pool_t *scratch_pool)
+/* Everything needed to perform an OP_FILE_INSTALL work item on disk,
+   gathered from wc.db beforehand.  */
+typedef struct file_install_t
 {
-  const svn_skel_t *arg1 = work_item->children->next;
-  const svn_skel_t *arg4 = arg1->next->next->next;
-  const char *local_relpath;
+  /* The file to install and where to take its normal form from.
+     SOURCE_IS_PRISTINE tells whether SOURCE_ABSPATH is in the pristine
+     store, where it may be stored compressed. */
   const char *local_abspath;
-  svn_boolean_t use_commit_times;
-  svn_boolean_t record_fileinfo;
+  const char *source_abspath;
+  svn_boolean_t source_is_pristine;
+
+  /* Translation to apply. */
   svn_boolean_t special;
-  svn_stream_t *src_stream;
   svn_subst_eol_style_t style;
   const char *eol;
   apr_hash_t *keywords;
+
+  /* Where to create the temporary file. */
   const char *temp_dir_abspath;
-  svn_stream_t *dst_stream;
+
+  /* Tweaks to apply after installing. CHANGED_DATE is 0 for "keep". */
+  svn_boolean_t set_executable;
+  svn_boolean_t set_read_only;
+  apr_time_t changed_date;
+
+  /* Whether to stat the installed file.  If so, DIRENT receives the
+     result and HAVE_DIRENT tells whether it describes a file. */
+  svn_boolean_t record_fileinfo;
+  svn_boolean_t have_dirent;
+  svn_io_dirent2_t dirent;
+
+  /* Error returned by perform_file_install(), if run on another thread. */
+  svn_error_t *err;
+} file_install_t;
+
+/* Parse the OP_FILE_INSTALL work item WORK_ITEM and read all wc.db
+ * information required to perform it into *INSTALL.
+ * Allocate *INSTALL in RESULT_POOL; use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+prepare_file_install(file_install_t **install,
+                     svn_wc__db_t *db,
+                     const svn_skel_t *work_item,
+                     const char *wri_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  const svn_skel_t *arg1 = work_item->children->next;
+  const svn_skel_t *arg4 = arg1->next->next->next;
+  file_install_t *fi = apr_pcalloc(result_pool, sizeof(*fi));
+  const char *local_relpath;
+  const char *local_abspath;
+  svn_boolean_t use_commit_times;
   apr_int64_t val;
   const char *wcroot_abspath;
-  const char *source_abspath;
   const svn_checksum_t *checksum;
   apr_hash_t *props;
   apr_time_t changed_date;
 
   local_relpath = apr_pstrmemdup(scratch_pool, arg1->data, arg1->len);
   SVN_ERR(svn_wc__db_from_relpath(&local_abspath, db, wri_abspath,
-                                  local_relpath, scratch_pool, scratch_pool));
+                                  local_relpath, result_pool, scratch_pool));
+  fi->local_abspath = local_abspath;
 
   SVN_ERR(svn_skel__parse_int(&val, arg1->next, scratch_pool));
   use_commit_times = (val != 0);
   SVN_ERR(svn_skel__parse_int(&val, arg1->next->next, scratch_pool));
-  record_fileinfo = (val != 0);
+  fi->record_fileinfo = (val != 0);
 
   SVN_ERR(svn_wc__db_read_node_install_info(&wcroot_abspath,
                                             &checksum, &props,
@@ -496,9 +531,9 @@ run_file_install(work_item_baton_t *wqb,
     {
       /* Use the provided path for the source.  */
       local_relpath = apr_pstrmemdup(scratch_pool, arg4->data, arg4->len);
-      SVN_ERR(svn_wc__db_from_relpath(&source_abspath, db, wri_abspath,
+      SVN_ERR(svn_wc__db_from_relpath(&fi->source_abspath, db, wri_abspath,
                                       local_relpath,
-                                      scratch_pool, scratch_pool));
+                                      result_pool, scratch_pool));
     }
   else if (! checksum)
     {
@@ -518,22 +553,87 @@ run_file_install(work_item_baton_t *wqb,
     }
   else
     {
-      SVN_ERR(svn_wc__db_pristine_get_future_path(&source_abspath,
+      /* PERFORM_FILE_INSTALL() reads the file directly, so fetch it now
+         if the working copy does not store it. */
+      SVN_ERR(svn_wc__db_pristine_hydrate(db, wcroot_abspath, checksum,
+                                          scratch_pool));
+      SVN_ERR(svn_wc__db_pristine_get_future_path(&fi->source_abspath,
                                                   wcroot_abspath,
                                                   checksum,
-                                                  scratch_pool, scratch_pool));
+                                                  result_pool, scratch_pool));
+      fi->source_is_pristine = TRUE;
     }
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
-                                   scratch_pool, scratch_pool));
-
   /* Fetch all the translation bits.  */
-  SVN_ERR(svn_wc__get_translate_info(&style, &eol,
-                                     &keywords,
-                                     &special, db, local_abspath,
+  SVN_ERR(svn_wc__get_translate_info(&fi->style, &fi->eol,
+                                     &fi->keywords,
+                                     &fi->special, db, local_abspath,
                                      props, FALSE,
+                                     result_pool, scratch_pool));
+  if (fi->special)
+    {
+      /* No need to set exec or read-only flags on special files.  */
+
+      /* ### Shouldn't this record a timestamp and size, etc.? */
+      fi->record_fileinfo = FALSE;
+      *install = fi;
+      return SVN_NO_ERROR;
+    }
+
+  /* Where is the Right Place to put a temp file in this working copy?  */
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&fi->temp_dir_abspath,
+                                         db, wcroot_abspath,
+                                         result_pool, scratch_pool));
+
+#ifndef WIN32
+  fi->set_executable = (props && svn_hash_gets(props, SVN_PROP_EXECUTABLE));
+#endif
+
+  /* Note that this explicitly checks the pristine properties, to make sure
+     that when the lock is locally set (=modification) it is not read only */
+  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
+    {
+      svn_wc__db_status_t status;
+      svn_wc__db_lock_t *lock;
+      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL,
+                                   db, local_abspath,
+                                   scratch_pool, scratch_pool));
+
+      fi->set_read_only = (!lock && status != svn_wc__db_status_added);
+    }
+
+  if (use_commit_times)
+    fi->changed_date = changed_date;
+
+  *install = fi;
+  return SVN_NO_ERROR;
+}
+
+/* Perform the file system part of the file installation INSTALL.  This
+ * does not access wc.db, so it may run on any thread.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+perform_file_install(file_install_t *install,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool)
+{
+  const char *local_abspath = install->local_abspath;
+  svn_stream_t *src_stream;
+  svn_stream_t *dst_stream;
+
+  if (install->source_is_pristine)
+    SVN_ERR(svn_wc__db_pristine_read_future(&src_stream,
+                                            install->source_abspath,
+                                            scratch_pool, scratch_pool));
+  else
+    SVN_ERR(svn_stream_open_readonly(&src_stream, install->source_abspath,
                                      scratch_pool, scratch_pool));
-  if (special)
+
+  if (install->special)
     {
       /* When this stream is closed, the resulting special file will
          atomically be created/moved into place at LOCAL_ABSPATH.  */
@@ -546,40 +646,48 @@ run_file_install(work_item_baton_t *wqb,
                                cancel_func, cancel_baton,
                                scratch_pool));
 
-      /* No need to set exec or read-only flags on special files.  */
-
-      /* ### Shouldn't this record a timestamp and size, etc.? */
       return SVN_NO_ERROR;
     }
 
-  if (svn_subst_translation_required(style, eol, keywords,
+  if (svn_subst_translation_required(install->style, install->eol,
+                                     install->keywords,
                                      FALSE /* special */,
                                      TRUE /* force_eol_check */))
     {
       /* Wrap it in a translating (expanding) stream.  */
-      src_stream = svn_subst_stream_translated(src_stream, eol,
+      src_stream = svn_subst_stream_translated(src_stream, install->eol,
                                                TRUE /* repair */,
-                                               keywords,
+                                               install->keywords,
                                                TRUE /* expand */,
                                                scratch_pool);
     }
 
-  /* Where is the Right Place to put a temp file in this working copy?  */
-  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath,
-                                         db, wcroot_abspath,
-                                         scratch_pool, scratch_pool));
-
   /* Translate to a temporary file. We don't want the user seeing a partial
      file, nor let them muck with it while we translate. We may also need to
      get its TRANSLATED_SIZE before the user can monkey it.  */
-  SVN_ERR(svn_stream__create_for_install(&dst_stream, temp_dir_abspath,
+  SVN_ERR(svn_stream__create_for_install(&dst_stream,
+                                         install->temp_dir_abspath,
                                          scratch_pool, scratch_pool));
 
-  /* Copy from the source to the dest, translating as we go. This will also
-     close both streams.  */
-  SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
-                           cancel_func, cancel_baton,
-                           scratch_pool));
+  /* A plain file to plain file copy (no translation, no compressed
+     pristine) can be left to the operating system, which may even just
+     clone the data on copy-on-write file systems.  */
+  if (svn_stream__aprfile(src_stream) && svn_stream__aprfile(dst_stream))
+    {
+      SVN_ERR(svn_io__file_copy_contents(svn_stream__aprfile(src_stream),
+                                         svn_stream__aprfile(dst_stream),
+                                         scratch_pool));
+      SVN_ERR(svn_stream_close(src_stream));
+      SVN_ERR(svn_stream_close(dst_stream));
+    }
+  else
+    {
+      /* Copy from the source to the dest, translating as we go. This will
+         also close both streams.  */
+      SVN_ERR(svn_stream_copy3(src_stream, dst_stream,
+                               cancel_func, cancel_baton,
+                               scratch_pool));
+    }
 
   /* All done. Move the file into place.  */
   /* With a single db we might want to install files in a missing directory.
@@ -589,48 +697,58 @@ run_file_install(work_item_baton_t *wqb,
                                      TRUE /* make_parents*/, scratch_pool));
 
   /* Tweak the on-disk file according to its properties.  */
-#ifndef WIN32
-  if (props && svn_hash_gets(props, SVN_PROP_EXECUTABLE))
+  if (install->set_executable)
     SVN_ERR(svn_io_set_file_executable(local_abspath, TRUE, FALSE,
                                        scratch_pool));
-#endif
-
-  /* Note that this explicitly checks the pristine properties, to make sure
-     that when the lock is locally set (=modification) it is not read only */
-  if (props && svn_hash_gets(props, SVN_PROP_NEEDS_LOCK))
-    {
-      svn_wc__db_status_t status;
-      svn_wc__db_lock_t *lock;
-      SVN_ERR(svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, &lock, NULL, NULL, NULL, NULL,
-                                   NULL, NULL, NULL, NULL, NULL, NULL,
-                                   db, local_abspath,
-                                   scratch_pool, scratch_pool));
 
-      if (!lock && status != svn_wc__db_status_added)
-        SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
-    }
+  if (install->set_read_only)
+    SVN_ERR(svn_io_set_file_read_only(local_abspath, FALSE, scratch_pool));
 
-  if (use_commit_times)
-    {
-      if (changed_date)
-        SVN_ERR(svn_io_set_file_affected_time(changed_date,
-                                              local_abspath,
-                                              scratch_pool));
-    }
+  if (install->changed_date)
+    SVN_ERR(svn_io_set_file_affected_time(install->changed_date,
+                                          local_abspath,
+                                          scratch_pool));
 
   /* ### this should happen before we rename the file into place.  */
-  if (record_fileinfo)
+  if (install->record_fileinfo)
     {
-      SVN_ERR(get_and_record_fileinfo(wqb, local_abspath,
-                                      FALSE /* ignore_enoent */,
-                                      scratch_pool));
+      const svn_io_dirent2_t *dirent;
+
+      SVN_ERR(svn_io_stat_dirent2(&dirent, local_abspath, FALSE, FALSE,
+                                  scratch_pool, scratch_pool));
+
+      install->have_dirent = (dirent->kind == svn_node_file);
+      install->dirent = *dirent;
     }
 
   return SVN_NO_ERROR;
 }
 
+/* Process the OP_FILE_INSTALL work item WORK_ITEM.
+ * See svn_wc__wq_build_file_install() which generates this work item.
+ * Implements (struct work_item_dispatch).func. */
+static svn_error_t *
+run_file_install(work_item_baton_t *wqb,
+                 svn_wc__db_t *db,
+                 const svn_skel_t *work_item,
+                 const char *wri_abspath,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  file_install_t *install;
+
+  SVN_ERR(prepare_file_install(&install, db, work_item, wri_abspath,
+                               scratch_pool, scratch_pool));
+  SVN_ERR(perform_file_install(install, cancel_func, cancel_baton,
+                               scratch_pool));
+
+  if (install->have_dirent)
+    record_dirent(wqb, install->local_abspath, &install->dirent);
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_error_t *
 svn_wc__wq_build_file_install(svn_skel_t **work_item,
@@ -1474,6 +1592,459 @@ dispatch_work_item(work_item_baton_t *wqb,
 }
 
 
+#if APR_HAS_THREADS
+
+/* Number of threads performing file installations concurrently. */
+#define FILE_INSTALL_THREADS 4
+
+/* Maximum number of consecutive OP_FILE_INSTALL work items to run as
+   one batch. */
+#define FILE_INSTALL_BATCH 64
+
+/* How long the calling thread waits for the installation threads before
+   it checks for cancellation again. */
+#define FILE_INSTALL_POLL_INTERVAL apr_time_from_msec(100)
+
+/* The installations of one batch, shared between its threads. */
+typedef struct install_batch_t
+{
+  /* The file_install_t * to perform. */
+  const apr_array_header_t *installs;
+
+  /* Index of the next installation to pick up. */
+  int next;
+
+  /* Set once the calling thread got cancelled.  The other threads then
+     abandon their installations. */
+  svn_boolean_t cancelled;
+
+  /* Number of other threads still running. */
+  int running;
+
+  /* Protects NEXT, CANCELLED and RUNNING. */
+  apr_thread_mutex_t *mutex;
+
+  /* Signalled when a thread finishes. */
+  apr_thread_cond_t *cond;
+
+  /* The cancellation callback of the caller, only to be invoked on the
+     calling thread. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} install_batch_t;
+
+/* Implements svn_cancel_func_t for the installation threads of the
+   install_batch_t BATON. */
+static svn_error_t *
+batch_cancel(void *baton)
+{
+  install_batch_t *batch = baton;
+  svn_boolean_t cancelled;
+
+  apr_thread_mutex_lock(batch->mutex);
+  cancelled = batch->cancelled;
+  apr_thread_mutex_unlock(batch->mutex);
+
+  return cancelled ? svn_error_create(SVN_ERR_CANCELLED, NULL, NULL)
+                   : SVN_NO_ERROR;
+}
+
+/* Implements svn_cancel_func_t for the calling thread of the
+   install_batch_t BATON.  Invoke the caller's cancellation callback, and
+   let the other threads know if it cancels. */
+static svn_error_t *
+caller_cancel(void *baton)
+{
+  install_batch_t *batch = baton;
+  svn_error_t *err;
+
+  if (!batch->cancel_func)
+    return SVN_NO_ERROR;
+
+  err = batch->cancel_func(batch->cancel_baton);
+  if (err)
+    {
+      apr_thread_mutex_lock(batch->mutex);
+      batch->cancelled = TRUE;
+      apr_thread_mutex_unlock(batch->mutex);
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Perform installations from BATCH until none are left, storing their
+   errors in them.  Check for cancellation with CANCEL_FUNC / CANCEL_BATON
+   before and during each of them.  Use POOL for temporary allocations. */
+static void
+perform_batch_installs(install_batch_t *batch,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  while (TRUE)
+    {
+      file_install_t *install = NULL;
+
+      apr_thread_mutex_lock(batch->mutex);
+      if (batch->next < batch->installs->nelts)
+        install = APR_ARRAY_IDX(batch->installs, batch->next++,
+                                file_install_t *);
+      apr_thread_mutex_unlock(batch->mutex);
+
+      if (!install)
+        break;
+
+      svn_pool_clear(iterpool);
+      install->err = cancel_func(cancel_baton);
+      if (!install->err)
+        install->err = perform_file_install(install, cancel_func,
+                                            cancel_baton, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+}
+
+/* Implements apr_thread_start_t for the install_batch_t at DATA. */
+static void * APR_THREAD_FUNC
+file_install_thread(apr_thread_t *tid, void *data)
+{
+  install_batch_t *batch = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  perform_batch_installs(batch, batch_cancel, batch, pool);
+  svn_pool_destroy(pool);
+
+  apr_thread_mutex_lock(batch->mutex);
+  batch->running--;
+  apr_thread_cond_signal(batch->cond);
+  apr_thread_mutex_unlock(batch->mutex);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Perform the file_install_t * in INSTALLS, using the calling thread plus
+   up to FILE_INSTALL_THREADS other threads, and store their errors in
+   them.  Installations abandoned because of cancellation through
+   CANCEL_FUNC / CANCEL_BATON get an error as well.  The cancellation
+   callback is only invoked on the calling thread.  Use SCRATCH_POOL for
+   temporary allocations. */
+static void
+perform_file_installs(const apr_array_header_t *installs,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *scratch_pool)
+{
+  install_batch_t batch = { 0 };
+  apr_thread_t *threads[FILE_INSTALL_THREADS];
+  int thread_count = 0;
+  apr_status_t status;
+  int i;
+
+  batch.installs = installs;
+  batch.cancel_func = cancel_func;
+  batch.cancel_baton = cancel_baton;
+
+  status = apr_thread_mutex_create(&batch.mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   scratch_pool);
+  if (!status)
+    status = apr_thread_cond_create(&batch.cond, scratch_pool);
+  if (status)
+    {
+      /* Fall back to doing it the old way. */
+      for (i = 0; i < installs->nelts; i++)
+        {
+          file_install_t *install = APR_ARRAY_IDX(installs, i,
+                                                  file_install_t *);
+          install->err = perform_file_install(install, cancel_func,
+                                              cancel_baton, scratch_pool);
+        }
+
+      return;
+    }
+
+  for (i = 0; i < FILE_INSTALL_THREADS && i + 1 < installs->nelts; i++)
+    {
+      apr_thread_mutex_lock(batch.mutex);
+      batch.running++;
+      apr_thread_mutex_unlock(batch.mutex);
+
+      status = apr_thread_create(&threads[thread_count], NULL,
+                                 file_install_thread, &batch, scratch_pool);
+      if (status)
+        {
+          apr_thread_mutex_lock(batch.mutex);
+          batch.running--;
+          apr_thread_mutex_unlock(batch.mutex);
+          break;
+        }
+
+      ++thread_count;
+    }
+
+  perform_batch_installs(&batch, caller_cancel, &batch, scratch_pool);
+
+  /* Keep checking for cancellation while the other threads finish. */
+  apr_thread_mutex_lock(batch.mutex);
+  while (batch.running)
+    {
+      apr_thread_cond_timedwait(batch.cond, batch.mutex,
+                                FILE_INSTALL_POLL_INTERVAL);
+      if (batch.running && !batch.cancelled && cancel_func)
+        {
+          svn_error_t *err;
+
+          apr_thread_mutex_unlock(batch.mutex);
+          err = cancel_func(cancel_baton);
+          apr_thread_mutex_lock(batch.mutex);
+
+          /* The abandoned installations report the cancellation. */
+          if (err)
+            {
+              svn_error_clear(err);
+              batch.cancelled = TRUE;
+            }
+        }
+    }
+  apr_thread_mutex_unlock(batch.mutex);
+
+  for (i = 0; i < thread_count; i++)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, threads[i]);
+    }
+}
+
+/* Run the OP_FILE_INSTALL work item WORK_ITEM with id ID together with
+ * the file installs immediately following it in the work queue of
+ * WRI_ABSPATH in DB.  Their wc.db accesses happen on this thread, while
+ * their file I/O runs on several threads.
+ *
+ * Mark all work items completed that ran successfully before the first
+ * failing one, and record their file info.  If no other file install
+ * follows WORK_ITEM, do nothing and set *BATCHED to FALSE.
+ *
+ * Check for cancellation with CANCEL_FUNC / CANCEL_BATON on this thread.
+ * On error, set *FAILED_ID and *FAILED_ITEM to the failing work item.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+run_file_install_batch(svn_boolean_t *batched,
+                       apr_uint64_t *failed_id,
+                       const svn_skel_t **failed_item,
+                       svn_wc__db_t *db,
+                       const char *wri_abspath,
+                       apr_uint64_t id,
+                       const svn_skel_t *work_item,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *following_ids, *following_items;
+  apr_array_header_t *ids, *items, *installs;
+  apr_hash_t *targets = apr_hash_make(scratch_pool);
+  apr_hash_t *record_map = NULL;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR(svn_wc__db_wq_fetch_following(&following_ids, &following_items,
+                                        db, wri_abspath, id,
+                                        FILE_INSTALL_BATCH - 1,
+                                        scratch_pool, scratch_pool));
+
+  ids = apr_array_make(scratch_pool, FILE_INSTALL_BATCH,
+                       sizeof(apr_uint64_t));
+  items = apr_array_make(scratch_pool, FILE_INSTALL_BATCH,
+                         sizeof(const svn_skel_t *));
+  APR_ARRAY_PUSH(ids, apr_uint64_t) = id;
+  APR_ARRAY_PUSH(items, const svn_skel_t *) = work_item;
+  svn_hash_sets(targets,
+                apr_pstrmemdup(scratch_pool,
+                               work_item->children->next->data,
+                               work_item->children->next->len),
+                "");
+
+  /* Take consecutive installs of distinct files only; everything else
+     must keep running in queue order. */
+  for (i = 0; i < following_items->nelts; i++)
+    {
+      const svn_skel_t *item = APR_ARRAY_IDX(following_items, i,
+                                             svn_skel_t *);
+      const char *target;
+
+      if (!svn_skel__matches_atom(item->children, OP_FILE_INSTALL))
+        break;
+
+      target = apr_pstrmemdup(scratch_pool, item->children->next->data,
+                              item->children->next->len);
+      if (svn_hash_gets(targets, target))
+        break;
+
+      svn_hash_sets(targets, target, "");
+      APR_ARRAY_PUSH(ids, apr_uint64_t)
+        = APR_ARRAY_IDX(following_ids, i, apr_uint64_t);
+      APR_ARRAY_PUSH(items, const svn_skel_t *) = item;
+    }
+
+  *batched = (items->nelts > 1);
+  if (!*batched)
+    return SVN_NO_ERROR;
+
+  /* Read everything we need from wc.db.  Stop at the first failure. */
+  installs = apr_array_make(scratch_pool, items->nelts,
+                            sizeof(file_install_t *));
+  for (i = 0; i < items->nelts; i++)
+    {
+      file_install_t *install;
+
+      err = prepare_file_install(&install, db,
+                                 APR_ARRAY_IDX(items, i, const svn_skel_t *),
+                                 wri_abspath, scratch_pool, scratch_pool);
+      if (err)
+        break;
+
+      APR_ARRAY_PUSH(installs, file_install_t *) = install;
+    }
+
+  perform_file_installs(installs, cancel_func, cancel_baton, scratch_pool);
+
+  /* Complete the work items in queue order, up to the first failure. */
+  for (i = 0; i < installs->nelts; i++)
+    {
+      file_install_t *install = APR_ARRAY_IDX(installs, i, file_install_t *);
+
+      if (install->err)
+        break;
+
+      if (install->have_dirent)
+        {
+          if (!record_map)
+            record_map = apr_hash_make(scratch_pool);
+
+          svn_hash_sets(record_map, install->local_abspath, &install->dirent);
+        }
+    }
+
+  if (i < installs->nelts)
+    {
+      int k;
+
+      svn_error_clear(err);
+      err = APR_ARRAY_IDX(installs, i, file_install_t *)->err;
+
+      for (k = i + 1; k < installs->nelts; k++)
+        svn_error_clear(APR_ARRAY_IDX(installs, k, file_install_t *)->err);
+    }
+
+  if (err)
+    {
+      *failed_id = APR_ARRAY_IDX(ids, i, apr_uint64_t);
+      *failed_item = APR_ARRAY_IDX(items, i, const svn_skel_t *);
+    }
+  ids->nelts = i;
+
+  return svn_error_compose_create(
+            err,
+            svn_wc__db_wq_record_and_complete(db, wri_abspath, ids,
+                                              record_map, scratch_pool));
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* The maximum number of OP_FILE_COMMIT work items that are completed
+   in a single wc.db transaction. */
+#define FILE_COMMIT_BATCH 256
+
+/* Run the OP_FILE_COMMIT work item WORK_ITEM with id ID together with
+ * the file commits immediately following it in the work queue of
+ * WRI_ABSPATH in DB.  Mark them completed and record their file info
+ * in one wc.db transaction, instead of in one or more transactions per
+ * work item, which dominate the post-processing of large commits.
+ *
+ * Mark all work items completed that ran successfully before the first
+ * failing one.  If no other file commit follows WORK_ITEM, do nothing
+ * and set *BATCHED to FALSE.
+ *
+ * On error, set *FAILED_ID and *FAILED_ITEM to the failing work item.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+run_file_commit_batch(svn_boolean_t *batched,
+                      apr_uint64_t *failed_id,
+                      const svn_skel_t **failed_item,
+                      svn_wc__db_t *db,
+                      const char *wri_abspath,
+                      apr_uint64_t id,
+                      const svn_skel_t *work_item,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *following_ids, *following_items;
+  apr_array_header_t *ids, *items;
+  work_item_baton_t wib = { 0 };
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR(svn_wc__db_wq_fetch_following(&following_ids, &following_items,
+                                        db, wri_abspath, id,
+                                        FILE_COMMIT_BATCH - 1,
+                                        scratch_pool, scratch_pool));
+
+  ids = apr_array_make(scratch_pool, FILE_COMMIT_BATCH,
+                       sizeof(apr_uint64_t));
+  items = apr_array_make(scratch_pool, FILE_COMMIT_BATCH,
+                         sizeof(const svn_skel_t *));
+  APR_ARRAY_PUSH(ids, apr_uint64_t) = id;
+  APR_ARRAY_PUSH(items, const svn_skel_t *) = work_item;
+
+  for (i = 0; i < following_items->nelts; i++)
+    {
+      const svn_skel_t *item = APR_ARRAY_IDX(following_items, i,
+                                             svn_skel_t *);
+
+      if (!svn_skel__matches_atom(item->children, OP_FILE_COMMIT))
+        break;
+
+      APR_ARRAY_PUSH(ids, apr_uint64_t)
+        = APR_ARRAY_IDX(following_ids, i, apr_uint64_t);
+      APR_ARRAY_PUSH(items, const svn_skel_t *) = item;
+    }
+
+  *batched = (items->nelts > 1);
+  if (!*batched)
+    return SVN_NO_ERROR;
+
+  /* The work items run in queue order, so a file's last recorded info
+     is the one that ends up in RECORD_MAP. */
+  wib.result_pool = scratch_pool;
+  iterpool = svn_pool_create(scratch_pool);
+
+  for (i = 0; i < items->nelts; i++)
+    {
+      svn_pool_clear(iterpool);
+
+      err = dispatch_work_item(&wib, db, wri_abspath,
+                               APR_ARRAY_IDX(items, i, const svn_skel_t *),
+                               cancel_func, cancel_baton, iterpool);
+      if (err)
+        {
+          *failed_id = APR_ARRAY_IDX(ids, i, apr_uint64_t);
+          *failed_item = APR_ARRAY_IDX(items, i, const svn_skel_t *);
+          break;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  ids->nelts = i;
+
+  return svn_error_compose_create(
+            err,
+            svn_wc__db_wq_record_and_complete(db, wri_abspath, ids,
+                                              wib.record_map, scratch_pool));
+}
+
 svn_error_t *
 svn_wc__wq_run(svn_wc__db_t *db,
                const char *wri_abspath,
@@ -1543,6 +2114,72 @@ svn_wc__wq_run(svn_wc__db_t *db,
       if (work_item == NULL)
         break;
 
+#if APR_HAS_THREADS
+      /* Installing many files at once is I/O bound; overlap them. */
+      if (svn_skel__matches_atom(work_item->children, OP_FILE_INSTALL))
+        {
+          svn_boolean_t batched;
+          const svn_skel_t *failed_item = work_item;
+          apr_uint64_t failed_id = id;
+
+          err = run_file_install_batch(&batched, &failed_id, &failed_item,
+                                       db, wri_abspath, id, work_item,
+                                       cancel_func, cancel_baton,
+                                       iterpool);
+          if (err)
+            {
+              const char *skel = svn_skel__unparse(failed_item,
+                                                   scratch_pool)->data;
+
+              return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
+                                       _("Failed to run the WC DB work queue "
+                                         "associated with '%s', work item "
+                                         "%d %s"),
+                                       svn_dirent_local_style(wri_abspath,
+                                                              scratch_pool),
+                                       (int)failed_id, skel);
+            }
+
+          /* All work items of the batch have been marked completed. */
+          if (batched)
+            {
+              last_id = 0;
+              continue;
+            }
+        }
+#endif
+
+      if (svn_skel__matches_atom(work_item->children, OP_FILE_COMMIT))
+        {
+          svn_boolean_t batched;
+          const svn_skel_t *failed_item = work_item;
+          apr_uint64_t failed_id = id;
+
+          err = run_file_commit_batch(&batched, &failed_id, &failed_item,
+                                      db, wri_abspath, id, work_item,
+                                      cancel_func, cancel_baton, iterpool);
+          if (err)
+            {
+              const char *skel = svn_skel__unparse(failed_item,
+                                                   scratch_pool)->data;
+
+              return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
+                                       _("Failed to run the WC DB work queue "
+                                         "associated with '%s', work item "
+                                         "%d %s"),
+                                       svn_dirent_local_style(wri_abspath,
+                                                              scratch_pool),
+                                       (int)failed_id, skel);
+            }
+
+          /* All work items of the batch have been marked completed. */
+          if (batched)
+            {
+              last_id = 0;
+              continue;
+            }
+        }
+
       err = dispatch_work_item(&wib, db, wri_abspath, work_item,
                                cancel_func, cancel_baton, iterpool);
       if (err)
@@ -1624,18 +2261,28 @@ get_and_record_fileinfo(work_item_baton_t *wqb,
   const svn_io_dirent2_t *dirent;
 
   SVN_ERR(svn_io_stat_dirent2(&dirent, local_abspath, FALSE, ignore_enoent,
-                              wqb->result_pool, scratch_pool));
+                              scratch_pool, scratch_pool));
 
   if (dirent->kind != svn_node_file)
     return SVN_NO_ERROR;
 
+  record_dirent(wqb, local_abspath, dirent);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remember the size and timestamp of the file LOCAL_ABSPATH, as found in
+   DIRENT, to be recorded in wc.db when the current work item completes. */
+static void
+record_dirent(work_item_baton_t *wqb,
+              const char *local_abspath,
+              const svn_io_dirent2_t *dirent)
+{
   wqb->used = TRUE;
 
   if (! wqb->record_map)
     wqb->record_map = apr_hash_make(wqb->result_pool);
 
   svn_hash_sets(wqb->record_map, apr_pstrdup(wqb->result_pool, local_abspath),
-                dirent);
-
-  return SVN_NO_ERROR;
+                svn_io_dirent2_dup(dirent, wqb->result_pool));
 }
@@ -84,6 +84,17 @@ typedef struct authz_svn_config_rec {
   const char *force_username_case;
 } authz_svn_config_rec;
 
+/* An authz file (and optional groups file) to be compiled at startup. */
+typedef struct authz_svn_preload_t {
+  const char *access_file;
+  const char *groups_file;
+} authz_svn_preload_t;
+
+typedef struct authz_svn_server_config_rec {
+  /* Array of authz_svn_preload_t. */
+  apr_array_header_t *preload;
+} authz_svn_server_config_rec;
+
 /* version where ap_some_auth_required breaks */
 #if AP_MODULE_MAGIC_AT_LEAST(20060110,0)
 /* first version with force_authn hook and ap_some_authn_required()
@@ -127,6 +138,16 @@ create_authz_svn_dir_config(apr_pool_t *p, char *d)
   return conf;
 }
 
+/* Implements the #create_server_config method of Apache's #module vtable. */
+static void *
+create_authz_svn_server_config(apr_pool_t *p, server_rec *s)
+{
+  authz_svn_server_config_rec *conf = apr_pcalloc(p, sizeof(*conf));
+  conf->preload = apr_array_make(p, 0, sizeof(authz_svn_preload_t));
+
+  return conf;
+}
+
 /* canonicalize ACCESS_FILE based on the type of argument.
  * If SERVER_RELATIVE is true, ACCESS_FILE is a relative
  * path then ACCESS_FILE is converted to an absolute
@@ -210,6 +231,39 @@ AuthzSVNGroupsFile_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+AuthzSVNPreloadAccessFile_cmd(cmd_parms *cmd, void *config,
+                              const char *arg1, const char *arg2)
+{
+  authz_svn_server_config_rec *conf
+    = ap_get_module_config(cmd->server->module_config, &authz_svn_module);
+  authz_svn_preload_t *preload = apr_array_push(conf->preload);
+
+  /* There is no repository to resolve repos-relative URLs against
+   * at startup. */
+  if (svn_path_is_repos_relative_url(arg1))
+    return apr_pstrcat(cmd->pool, "Repository relative URL not allowed: ",
+                       arg1, SVN_VA_NULL);
+  if (arg2 && svn_path_is_repos_relative_url(arg2))
+    return apr_pstrcat(cmd->pool, "Repository relative URL not allowed: ",
+                       arg2, SVN_VA_NULL);
+
+  preload->access_file = canonicalize_access_file(arg1, TRUE, cmd->pool);
+  if (!preload->access_file)
+    return apr_pstrcat(cmd->pool, "Invalid file path ", arg1, SVN_VA_NULL);
+
+  preload->groups_file = NULL;
+  if (arg2)
+    {
+      preload->groups_file = canonicalize_access_file(arg2, TRUE, cmd->pool);
+      if (!preload->groups_file)
+        return apr_pstrcat(cmd->pool, "Invalid file path ", arg2,
+                           SVN_VA_NULL);
+    }
+
+  return NULL;
+}
+
 /* Implements the #cmds member of Apache's #module vtable. */
 static const command_rec authz_svn_cmds[] =
 {
@@ -262,6 +316,15 @@ static const command_rec authz_svn_cmds[] =
                 OR_AUTHCFG,
                 "Set to 'Upper' or 'Lower' to convert the username before "
                 "checking for authorization."),
+  AP_INIT_TAKE12("AuthzSVNPreloadAccessFile",
+                 AuthzSVNPreloadAccessFile_cmd,
+                 NULL,
+                 RSRC_CONF,
+                 "Path to an authz file, optionally followed by the path "
+                 "to a groups file, to compile once at server startup.  "
+                 "The compiled rules are shared by all server processes "
+                 "that use the same files.  Path may be an absolute "
+                 "file:// URL to a text file in a Subversion repository."),
   { NULL }
 };
 
@@ -394,6 +457,9 @@ resolve_repos_relative_url(const char **path, const char **repos_url,
   return SVN_NO_ERROR;
 }
 
+/* Pool userdata key for the svn_authz_t used throughout a request. */
+#define REQUEST_ACCESS_CONF_KEY "mod_authz_svn-access-conf"
+
 /*
  * Get the, possibly cached, svn_authz_t for this request.
  */
@@ -408,6 +474,14 @@ get_access_conf(request_rec *r, authz_svn_config_rec *conf,
   svn_authz_t *access_conf = NULL;
   svn_error_t *svn_err = SVN_NO_ERROR;
   dav_error *dav_err;
+  void *cached;
+
+  /* mod_dav_svn may ask for many paths within the same request.  Stick
+     to the authz rules we found for the first one instead of reading
+     and validating the rules file again for each path. */
+  apr_pool_userdata_get(&cached, REQUEST_ACCESS_CONF_KEY, r->pool);
+  if (cached)
+    return cached;
 
   dav_err = dav_svn_get_repos_path2(r, conf->base_path, &repos_path, scratch_pool);
   if (dav_err)
@@ -476,6 +550,11 @@ get_access_conf(request_rec *r, authz_svn_config_rec *conf,
                     svn_err, scratch_pool);
       access_conf = NULL;
     }
+  else
+    {
+      apr_pool_userdata_setn(access_conf, REQUEST_ACCESS_CONF_KEY, NULL,
+                             r->pool);
+    }
 
   return access_conf;
 }
@@ -1068,12 +1147,78 @@ force_authn(request_rec *r)
  * Module flesh
  */
 
+/* Implements the #post_config hook.  Compile all AuthzSVNPreloadAccessFile
+ * rules into the process-wide authz cache before the server forks its
+ * worker processes.  Every child then inherits the parsed model instead
+ * of parsing the same files again on its first request.
+ *
+ * The references to the cached models are held in the configuration pool
+ * P, so they get released upon server restart. */
+static int
+preload_access_files(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp,
+                     server_rec *s)
+{
+  svn_error_t *svn_err;
+
+  svn_err = svn_repos_authz_initialize(p);
+  if (svn_err)
+    {
+      ap_log_perror(APLOG_MARK, APLOG_ERR, svn_err->apr_err, p,
+                    "mod_authz_svn: error calling "
+                    "svn_repos_authz_initialize: '%s'",
+                    svn_err->message ? svn_err->message : "(no more info)");
+      svn_error_clear(svn_err);
+      return HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+  for (; s; s = s->next)
+    {
+      authz_svn_server_config_rec *conf
+        = ap_get_module_config(s->module_config, &authz_svn_module);
+      int i;
+
+      for (i = 0; i < conf->preload->nelts; ++i)
+        {
+          const authz_svn_preload_t *preload
+            = &APR_ARRAY_IDX(conf->preload, i, authz_svn_preload_t);
+          svn_authz_t *access_conf;
+
+          svn_err = svn_repos_authz_read3(&access_conf,
+                                          preload->access_file,
+                                          preload->groups_file,
+                                          TRUE, NULL, p, ptemp);
+          if (svn_err)
+            {
+              char buffer[256];
+
+              ap_log_error(APLOG_MARK, APLOG_ERR, 0, s,
+                           "Failed to preload the authz file '%s': %s",
+                           preload->access_file,
+                           svn_err_best_message(svn_err, buffer,
+                                                sizeof(buffer)));
+              svn_error_clear(svn_err);
+              return HTTP_INTERNAL_SERVER_ERROR;
+            }
+
+          ap_log_error(APLOG_MARK, APLOG_DEBUG, 0, s,
+                       "Preloaded authz file %s", preload->access_file);
+        }
+    }
+
+  return OK;
+}
+
 /* Implements the #register_hooks method of Apache's #module vtable. */
 static void
 register_hooks(apr_pool_t *p)
 {
   static const char * const mod_ssl[] = { "mod_ssl.c", NULL };
+  static const char * const mod_dav_svn[] = { "mod_dav_svn.c", NULL };
 
+  /* Run after mod_dav_svn has initialized the FS layer, which we need
+   * for in-repository authz files. */
+  ap_hook_post_config(preload_access_files, mod_dav_svn, NULL,
+                      APR_HOOK_MIDDLE);
   ap_hook_access_checker(access_checker, NULL, NULL, APR_HOOK_LAST);
   /* Our check_user_id hook must be before any module which will return
    * HTTP_UNAUTHORIZED (mod_auth_basic, etc.), but after mod_ssl, to
@@ -1095,7 +1240,7 @@ module AP_MODULE_DECLARE_DATA authz_svn_module =
   STANDARD20_MODULE_STUFF,
   create_authz_svn_dir_config,     /* dir config creater */
   NULL,                            /* dir merger --- default is to override */
-  NULL,                            /* server config */
+  create_authz_svn_server_config,  /* server config */
   NULL,                            /* merge server config */
   authz_svn_cmds,                  /* command apr_table_t */
   register_hooks                   /* register hooks */
@@ -26,6 +26,7 @@
 
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
 #include "svn_path.h"
 
 #include "private/svn_fspath.h"
@@ -34,37 +35,44 @@
 #include "dav_svn.h"
 
 
-svn_boolean_t
-dav_svn__allow_read(request_rec *r,
-                    const dav_svn_repos *repos,
-                    const char *path,
-                    svn_revnum_t rev,
-                    apr_pool_t *pool)
+/* Pool userdata key for the read access decisions made for a request. */
+#define READ_ACCESS_MEMO_KEY "mod_dav_svn-read-access-memo"
+
+/* Return the table of read access decisions that dav_svn__allow_read()
+   made for request R so far, creating it on demand.  It maps "REV PATH"
+   strings to "y" or "n".  The user as well as the authz configuration
+   stay the same for the whole request, so decisions remain valid until
+   the request's pool goes away. */
+static apr_hash_t *
+get_read_access_memo(request_rec *r)
 {
-  const char *uri;
-  request_rec *subreq;
-  enum dav_svn__build_what uri_type;
-  svn_boolean_t allowed = FALSE;
-  authz_svn__subreq_bypass_func_t allow_read_bypass = NULL;
+  void *memo;
 
-  /* Easy out:  if the admin has explicitly set 'SVNPathAuthz Off',
-     then this whole callback does nothing. */
-  if (! dav_svn__get_pathauthz_flag(r))
+  apr_pool_userdata_get(&memo, READ_ACCESS_MEMO_KEY, r->pool);
+  if (memo == NULL)
     {
-      return TRUE;
+      memo = apr_hash_make(r->pool);
+      apr_pool_userdata_setn(memo, READ_ACCESS_MEMO_KEY, NULL, r->pool);
     }
 
-  /* Sometimes we get paths that do not start with '/' and
-     hence below uri concatenation would lead to wrong uris .*/
-  if (path && path[0] != '/')
-    path = apr_pstrcat(pool, "/", path, SVN_VA_NULL);
+  return memo;
+}
+
+/* Actual implementation of dav_svn__allow_read(), without memoization.
+   ALLOW_READ_BYPASS is the bypass provider, if any. */
+static svn_boolean_t
+allow_read(request_rec *r,
+           const dav_svn_repos *repos,
+           const char *path,
+           svn_revnum_t rev,
+           authz_svn__subreq_bypass_func_t allow_read_bypass,
+           apr_pool_t *pool)
+{
+  const char *uri;
+  request_rec *subreq;
+  enum dav_svn__build_what uri_type;
+  svn_boolean_t allowed = FALSE;
 
-  /* If bypass is specified and authz has exported the provider.
-     Otherwise, we fall through to the full version.  This should be
-     safer than allowing or disallowing all accesses if there is a
-     configuration error.
-     XXX: Is this the proper thing to do in this case? */
-  allow_read_bypass = dav_svn__get_pathauthz_bypass(r);
   if (allow_read_bypass != NULL)
     {
       if (allow_read_bypass(r, path, repos->repo_basename) == OK)
@@ -97,6 +105,57 @@ dav_svn__allow_read(request_rec *r,
   return allowed;
 }
 
+svn_boolean_t
+dav_svn__allow_read(request_rec *r,
+                    const dav_svn_repos *repos,
+                    const char *path,
+                    svn_revnum_t rev,
+                    apr_pool_t *pool)
+{
+  svn_boolean_t allowed;
+  authz_svn__subreq_bypass_func_t allow_read_bypass = NULL;
+  apr_hash_t *memo;
+  const char *key, *verdict;
+
+  /* Easy out:  if the admin has explicitly set 'SVNPathAuthz Off',
+     then this whole callback does nothing. */
+  if (! dav_svn__get_pathauthz_flag(r))
+    {
+      return TRUE;
+    }
+
+  /* Sometimes we get paths that do not start with '/' and
+     hence below uri concatenation would lead to wrong uris .*/
+  if (path && path[0] != '/')
+    path = apr_pstrcat(pool, "/", path, SVN_VA_NULL);
+
+  /* If bypass is specified and authz has exported the provider.
+     Otherwise, we fall through to the full version.  This should be
+     safer than allowing or disallowing all accesses if there is a
+     configuration error.
+     XXX: Is this the proper thing to do in this case? */
+  allow_read_bypass = dav_svn__get_pathauthz_bypass(r);
+  if (path == NULL)
+    return allow_read(r, repos, path, rev, allow_read_bypass, pool);
+
+  /* PROPFIND, log and update responses ask for the same paths over and
+     over again.  The bypass ignores the revision, so we can share the
+     decision for all revisions of a path then. */
+  if (allow_read_bypass != NULL)
+    rev = SVN_INVALID_REVNUM;
+
+  memo = get_read_access_memo(r);
+  key = apr_psprintf(pool, "%ld %s", rev, path);
+  verdict = svn_hash_gets(memo, key);
+  if (verdict)
+    return *verdict == 'y';
+
+  allowed = allow_read(r, repos, path, rev, allow_read_bypass, pool);
+  svn_hash_sets(memo, apr_pstrdup(r->pool, key), allowed ? "y" : "n");
+
+  return allowed;
+}
+
 
 svn_boolean_t
 dav_svn__allow_list_repos(request_rec *r,
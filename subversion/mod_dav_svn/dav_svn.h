@@ -340,6 +340,11 @@ svn_boolean_t dav_svn__get_revprop_cache_flag(request_rec *r);
 svn_boolean_t
 dav_svn__get_nodeprop_cache_flag(request_rec *r);
 
+/* for the repository referred to by this request, should svndiff responses
+ * for immutable resources be cached? */
+svn_boolean_t
+dav_svn__get_response_cache_flag(request_rec *r);
+
 /* has block read mode been enabled for the repository referred to by this
  * request? */
 svn_boolean_t dav_svn__get_block_read_flag(request_rec *r);
@@ -417,6 +422,12 @@ const char *dav_svn__get_master_uri(request_rec *r);
    Comes from the <SVNMasterVersion> directive. */
 svn_version_t *dav_svn__get_master_version(request_rec *r);
 
+/* Return TRUE iff a master URI is in place for this location and read
+   requests for revisions that this mirror does not have yet shall be
+   proxied to the master.
+   Comes from the <SVNMasterReadThrough> directive. */
+svn_boolean_t dav_svn__get_master_read_through_flag(request_rec *r);
+
 /* Return the disk path to the activities db.
    Comes from the <SVNActivitiesDB> directive. */
 const char *dav_svn__get_activities_db(request_rec *r);
@@ -429,9 +440,23 @@ const char *dav_svn__get_root_dir(request_rec *r);
 /* Return the data compression level to be used over the wire. */
 int dav_svn__get_compression_level(request_rec *r);
 
+/* Return the number of threads to use for encoding the text deltas sent
+   inline in update reports.  Values below 2 mean "no extra threads". */
+int dav_svn__get_delta_encoding_threads(request_rec *r);
+
 /* Return the hook script environment parsed from the configuration. */
 const char *dav_svn__get_hooks_env(request_rec *r);
 
+/* Are post-commit hooks deferred to the post-commit queue for the
+   repository referred to by this request? */
+svn_boolean_t dav_svn__get_async_post_commit_flag(request_rec *r);
+
+/* Note that request R (or its main request) committed a revision to
+   REPOS, so its post-commit queue needs to be run once the response has
+   been sent.  Do nothing if SVNAsyncPostCommit is off. */
+void dav_svn__post_commit_queued(request_rec *r,
+                                 svn_repos_t *repos);
+
 /** For HTTP protocol v2, these are the new URIs and URI stubs
     returned to the client in our OPTIONS response.  They all depend
     on the 'special uri', which is configurable in httpd.conf.  **/
@@ -534,6 +559,14 @@ int dav_svn__method_post(request_rec *r);
 /* Request handler to GET Subversion internal status (FSFS cache). */
 int dav_svn__status(request_rec *r);
 
+/* Request handler to GET cache statistics and FS operation counters in
+   the Prometheus text format. */
+int dav_svn__metrics(request_rec *r);
+
+/* Request handler to GET the tracing spans recorded by this process as
+   Chrome trace or OTLP JSON. */
+int dav_svn__trace(request_rec *r);
+
 /*** repos.c ***/
 
 /* generate an ETag for RESOURCE and return it, allocated in POOL. */
@@ -705,6 +738,7 @@ static const dav_report_elem dav_svn__reports_list[] = {
   { SVN_XML_NAMESPACE, "get-deleted-rev-report" },
   { SVN_XML_NAMESPACE, SVN_DAV__MERGEINFO_REPORT },
   { SVN_XML_NAMESPACE, SVN_DAV__INHERITED_PROPS_REPORT },
+  { SVN_XML_NAMESPACE, SVN_DAV__LIST_REPORT },
   { NULL, NULL },
 };
 
@@ -757,6 +791,11 @@ dav_svn__get_inherited_props_report(const dav_resource *resource,
                                     const apr_xml_doc *doc,
                                     dav_svn__output *output);
 
+dav_error *
+dav_svn__list_report(const dav_resource *resource,
+                     const apr_xml_doc *doc,
+                     dav_svn__output *output);
+
 /*** posts/ ***/
 
 /* The various POST handlers, defined in posts/, and used by repos.c.  */
@@ -991,6 +1030,13 @@ svn_error_t *dav_svn__brigade_printf(apr_bucket_brigade *bb,
                                      ...)
   __attribute__((format(printf, 3, 4)));
 
+/* Like dav_svn__brigade_printf() but taking the arguments from AP.  */
+svn_error_t *dav_svn__brigade_vprintf(apr_bucket_brigade *bb,
+                                      dav_svn__output *output,
+                                      const char *fmt,
+                                      va_list ap)
+  __attribute__((format(printf, 3, 0)));
+
 /* Write an unspecified number of strings to OUTPUT using BB.  */
 svn_error_t *dav_svn__brigade_putstrs(apr_bucket_brigade *bb,
                                       dav_svn__output *output,
@@ -751,6 +751,7 @@ append_locks(dav_lockdb *lockdb,
                                      &new_rev, txn, resource->pool);
       if (SVN_IS_VALID_REVNUM(new_rev))
         {
+          dav_svn__post_commit_queued(resource->info->r, repos->repos);
           /* ### Log an error in post commit FS processing? */
           svn_error_clear(serr);
         }
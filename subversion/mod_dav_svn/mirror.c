@@ -28,11 +28,31 @@
 #include <httpd.h>
 #include <http_core.h>
 
+#include "svn_repos.h"
+
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 
 #include "dav_svn.h"
 
 
+/* How long a mirror may assume that it still lacks a revision, before
+   looking at its youngest revision again. */
+#define YOUNGEST_RECHECK_INTERVAL apr_time_from_sec(1)
+
+/* What a connection has learned about the youngest revision of the
+   mirror repository. */
+typedef struct mirror_state_t
+{
+    /* Youngest revision found in the mirror, SVN_INVALID_REVNUM if we
+       didn't look yet. */
+    svn_revnum_t youngest;
+
+    /* When we determined YOUNGEST. */
+    apr_time_t checked;
+} mirror_state_t;
+
+
 /* Tweak the request record R, and add the necessary filters, so that
    the request is ready to be proxied away.  MASTER_URI is the URI
    specified in the SVNMasterURI Apache configuration value.
@@ -76,6 +96,69 @@ static int proxy_request_fixup(request_rec *r,
 }
 
 
+/* Return TRUE if the mirror repository at FS_PATH does not contain REV
+   yet.  Remember its youngest revision in R's connection, so that we
+   only need to look at the repository for revisions beyond it, and at
+   most once per YOUNGEST_RECHECK_INTERVAL. */
+static svn_boolean_t mirror_lacks_revision(request_rec *r,
+                                           const char *fs_path,
+                                           svn_revnum_t rev)
+{
+    const char *key = apr_pstrcat(r->pool, "mod_dav_svn-mirror:", fs_path,
+                                  SVN_VA_NULL);
+    mirror_state_t *state;
+    svn_repos_t *repos;
+    svn_revnum_t youngest;
+    svn_error_t *serr = SVN_NO_ERROR;
+    apr_time_t now;
+    void *userdata;
+
+    apr_pool_userdata_get(&userdata, key, r->connection->pool);
+    state = userdata;
+    if (state == NULL) {
+        state = apr_pcalloc(r->connection->pool, sizeof(*state));
+        state->youngest = SVN_INVALID_REVNUM;
+        apr_pool_userdata_set(state, key, NULL, r->connection->pool);
+    }
+
+    /* Revisions never disappear from the mirror. */
+    if (SVN_IS_VALID_REVNUM(state->youngest) && rev <= state->youngest)
+        return FALSE;
+
+    now = apr_time_now();
+    if (SVN_IS_VALID_REVNUM(state->youngest)
+        && now - state->checked < YOUNGEST_RECHECK_INTERVAL)
+        return TRUE;
+
+    /* Use the repository that an earlier request on this connection
+       opened, if any.  See get_resource(). */
+    apr_pool_userdata_get(&userdata,
+                          apr_pstrcat(r->pool, "mod_dav_svn:", fs_path,
+                                      SVN_VA_NULL),
+                          r->connection->pool);
+    repos = userdata;
+    if (repos == NULL)
+        serr = svn_repos_open3(&repos, fs_path, NULL, r->pool, r->pool);
+    if (! serr)
+        serr = svn_fs_youngest_rev(&youngest, svn_repos_fs(repos), r->pool);
+
+    if (serr) {
+        /* Let the regular request processing report the problem. */
+        dav_error *derr = dav_svn__convert_err(serr,
+                                               HTTP_INTERNAL_SERVER_ERROR,
+                                               "Can't check mirror for "
+                                               "read-through", r->pool);
+        dav_svn__log_err(r, derr, APLOG_ERR);
+        return FALSE;
+    }
+
+    state->youngest = youngest;
+    state->checked = now;
+
+    return rev > youngest;
+}
+
+
 int dav_svn__proxy_request_fixup(request_rec *r)
 {
     const char *root_dir, *master_uri, *special_uri;
@@ -112,6 +195,21 @@ int dav_svn__proxy_request_fixup(request_rec *r)
                     rv = proxy_request_fixup(r, master_uri, seg);
                     if (rv) return rv;
                 }
+                else if (dav_svn__get_master_read_through_flag(r)
+                         && dav_svn__get_fs_path(r)) {
+                    /* The mirror may lag behind the master.  Let the
+                       master serve revisions that we don't have yet. */
+                    svn_revnum_t rev;
+
+                    seg += strlen(root_dir);
+                    rev = svn_repos__dav_uri_revision(seg, special_uri);
+                    if (SVN_IS_VALID_REVNUM(rev)
+                        && mirror_lacks_revision(r, dav_svn__get_fs_path(r),
+                                                 rev)) {
+                        int rv = proxy_request_fixup(r, master_uri, seg);
+                        if (rv) return rv;
+                    }
+                }
             }
             return OK;
         }
@@ -43,6 +43,7 @@
 #include "mod_dav_svn.h"
 
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 
 #include "dav_svn.h"
@@ -67,6 +68,14 @@ typedef struct server_conf_t {
      compression level. */
   int compression_level;
 
+  /* The number of worker threads encoding svndiff windows for the
+   * inline text deltas of an update report.  Negative value used to
+   * specify the default of encoding them on the request thread. */
+  int delta_encoding_threads;
+
+  /* Number of tracing spans to keep per process.  0 disables tracing. */
+  int trace_spans;
+
 } server_conf_t;
 
 
@@ -101,13 +110,16 @@ typedef struct dir_conf_t {
   const char *root_dir;              /* our top-level directory */
   const char *master_uri;            /* URI to the master SVN repos */
   svn_version_t *master_version;     /* version of master server */
+  enum conf_flag master_read_through; /* proxy reads of missing revs */
   const char *activities_db;         /* path to activities database(s) */
   enum conf_flag txdelta_cache;      /* whether to enable txdelta caching */
   enum conf_flag fulltext_cache;     /* whether to enable fulltext caching */
   enum conf_flag revprop_cache;      /* whether to enable revprop caching */
   enum conf_flag nodeprop_cache;     /* whether to enable nodeprop caching */
   enum conf_flag block_read;         /* whether to enable block read mode */
+  enum conf_flag response_cache;     /* whether to cache svndiff responses */
   const char *hooks_env;             /* path to hook script env config file */
+  enum conf_flag async_post_commit;  /* whether to queue post-commit hooks */
 } dir_conf_t;
 
 
@@ -150,6 +162,18 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
   conf = ap_get_module_config(s->module_config, &dav_svn_module);
   svn_utf_initialize2(conf->use_utf8, p);
 
+  if (conf->trace_spans > 0)
+    {
+      serr = svn_trace__enable(conf->trace_spans);
+      if (serr)
+        {
+          ap_log_perror(APLOG_MARK, APLOG_ERR, serr->apr_err, p,
+                        "mod_dav_svn: error calling svn_trace__enable: '%s'",
+                        serr->message ? serr->message : "(no more info)");
+          return HTTP_INTERNAL_SERVER_ERROR;
+        }
+    }
+
   return OK;
 }
 
@@ -203,6 +227,7 @@ create_server_config(apr_pool_t *p, server_rec *s)
   server_conf_t *conf = apr_pcalloc(p, sizeof(server_conf_t));
 
   conf->compression_level = -1;
+  conf->delta_encoding_threads = -1;
 
   return conf;
 }
@@ -231,6 +256,14 @@ merge_server_config(apr_pool_t *p, void *base, void *overrides)
       newconf->compression_level = child->compression_level;
     }
 
+  if (child->delta_encoding_threads < 0)
+    newconf->delta_encoding_threads = parent->delta_encoding_threads;
+  else
+    newconf->delta_encoding_threads = child->delta_encoding_threads;
+
+  newconf->trace_spans = child->trace_spans ? child->trace_spans
+                                            : parent->trace_spans;
+
   return newconf;
 }
 
@@ -269,6 +302,8 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->fs_path = INHERIT_VALUE(parent, child, fs_path);
   newconf->master_uri = INHERIT_VALUE(parent, child, master_uri);
   newconf->master_version = INHERIT_VALUE(parent, child, master_version);
+  newconf->master_read_through = INHERIT_VALUE(parent, child,
+                                               master_read_through);
   newconf->activities_db = INHERIT_VALUE(parent, child, activities_db);
   newconf->repo_name = INHERIT_VALUE(parent, child, repo_name);
   newconf->xslt_uri = INHERIT_VALUE(parent, child, xslt_uri);
@@ -282,9 +317,12 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->fulltext_cache = INHERIT_VALUE(parent, child, fulltext_cache);
   newconf->revprop_cache = INHERIT_VALUE(parent, child, revprop_cache);
   newconf->nodeprop_cache = INHERIT_VALUE(parent, child, nodeprop_cache);
+  newconf->response_cache = INHERIT_VALUE(parent, child, response_cache);
   newconf->block_read = INHERIT_VALUE(parent, child, block_read);
   newconf->root_dir = INHERIT_VALUE(parent, child, root_dir);
   newconf->hooks_env = INHERIT_VALUE(parent, child, hooks_env);
+  newconf->async_post_commit = INHERIT_VALUE(parent, child,
+                                             async_post_commit);
 
   if (parent->fs_path)
     ap_log_error(APLOG_MARK, APLOG_WARNING, 0, NULL,
@@ -357,6 +395,20 @@ SVNMasterVersion_cmd(cmd_parms *cmd, void *config, const char *arg1)
 }
 
 
+static const char *
+SVNMasterReadThrough_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->master_read_through = CONF_FLAG_ON;
+  else
+    conf->master_read_through = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
+
 static const char *
 SVNActivitiesDB_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -591,6 +643,19 @@ SVNCacheNodeProps_cmd(cmd_parms *cmd, void *config, int arg)
   return NULL;
 }
 
+static const char *
+SVNCacheResponses_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->response_cache = CONF_FLAG_ON;
+  else
+    conf->response_cache = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
 static const char *
 SVNBlockRead_cmd(cmd_parms *cmd, void *config, int arg)
 {
@@ -604,6 +669,19 @@ SVNBlockRead_cmd(cmd_parms *cmd, void *config, int arg)
   return NULL;
 }
 
+static const char *
+SVNAsyncPostCommit_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->async_post_commit = CONF_FLAG_ON;
+  else
+    conf->async_post_commit = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
 static const char *
 SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -624,6 +702,25 @@ SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNCacheMemoryPlacement_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  /* The cache is process-global, so are these settings. */
+  static svn_boolean_t huge_pages = FALSE;
+  static svn_boolean_t numa_interleave = FALSE;
+
+  if (apr_strnatcasecmp("huge-pages", arg1) == 0)
+    huge_pages = TRUE;
+  else if (apr_strnatcasecmp("numa-interleave", arg1) == 0)
+    numa_interleave = TRUE;
+  else
+    return "Unrecognized value for SVNCacheMemoryPlacement directive";
+
+  svn_cache_config_set_memory_placement(huge_pages, numa_interleave);
+
+  return NULL;
+}
+
 static const char *
 SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -652,6 +749,54 @@ SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNDeltaEncodingThreads_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  server_conf_t *conf;
+  int value = 0;
+  svn_error_t *err = svn_cstring_atoi(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the SVN delta encoding threads.";
+    }
+
+  if (value < 0)
+    return apr_psprintf(cmd->pool,
+                        "%d is not a valid number of delta encoding threads.",
+                        value);
+
+  conf = ap_get_module_config(cmd->server->module_config,
+                              &dav_svn_module);
+  conf->delta_encoding_threads = value;
+
+  return NULL;
+}
+
+static const char *
+SVNTraceSpans_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  server_conf_t *conf;
+  int value = 0;
+  svn_error_t *err = svn_cstring_atoi(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the SVN trace spans.";
+    }
+
+  if (value < 0)
+    return apr_psprintf(cmd->pool,
+                        "%d is not a valid number of trace spans.",
+                        value);
+
+  conf = ap_get_module_config(cmd->server->module_config,
+                              &dav_svn_module);
+  conf->trace_spans = value;
+
+  return NULL;
+}
+
 static const char *
 SVNUseUTF8_cmd(cmd_parms *cmd, void *config, int arg)
 {
@@ -800,6 +945,19 @@ dav_svn__get_master_version(request_rec *r)
 }
 
 
+svn_boolean_t
+dav_svn__get_master_read_through_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* read-through mirroring is disabled by default. */
+  return conf->master_uri != NULL
+      && get_conf_flag(conf->master_read_through, FALSE);
+}
+
+
 const char *
 dav_svn__get_xslt_uri(request_rec *r)
 {
@@ -1031,6 +1189,17 @@ dav_svn__get_nodeprop_cache_flag(request_rec *r)
   return get_conf_flag(conf->nodeprop_cache, TRUE);
 }
 
+svn_boolean_t
+dav_svn__get_response_cache_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* response caching is disabled by default. */
+  return get_conf_flag(conf->response_cache, FALSE);
+}
+
 svn_boolean_t
 dav_svn__get_block_read_flag(request_rec *r)
 {
@@ -1060,6 +1229,21 @@ dav_svn__get_compression_level(request_rec *r)
     }
 }
 
+int
+dav_svn__get_delta_encoding_threads(request_rec *r)
+{
+  server_conf_t *conf;
+
+  conf = ap_get_module_config(r->server->module_config,
+                              &dav_svn_module);
+
+  /* encoding on the request thread is the default. */
+  if (conf->delta_encoding_threads < 0)
+    return 0;
+  else
+    return conf->delta_encoding_threads;
+}
+
 const char *
 dav_svn__get_hooks_env(request_rec *r)
 {
@@ -1069,6 +1253,63 @@ dav_svn__get_hooks_env(request_rec *r)
   return conf->hooks_env;
 }
 
+svn_boolean_t
+dav_svn__get_async_post_commit_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* post-commit hooks run before the response by default. */
+  return get_conf_flag(conf->async_post_commit, FALSE);
+}
+
+/* The pool-key under which the main request remembers the repository
+   whose post-commit queue needs to be run once the response is out. */
+#define POST_COMMIT_QUEUE_KEY "svn-post-commit-queue"
+
+void
+dav_svn__post_commit_queued(request_rec *r,
+                            svn_repos_t *repos)
+{
+  if (! dav_svn__get_async_post_commit_flag(r))
+    return;
+
+  while (r->main)
+    r = r->main;
+
+  apr_pool_userdata_setn(repos, POST_COMMIT_QUEUE_KEY, NULL, r->pool);
+}
+
+/* Implements the #log_transaction hook.  Run the post-commit hooks
+   queued by a commit in request R, now that the client has got the
+   response. */
+static int
+run_post_commit_queue(request_rec *r)
+{
+  void *repos = NULL;
+  svn_error_t *serr;
+  char buffer[128];
+
+  if (r->main)
+    return DECLINED;
+
+  apr_pool_userdata_get(&repos, POST_COMMIT_QUEUE_KEY, r->pool);
+  if (! repos)
+    return DECLINED;
+
+  serr = svn_repos__run_post_commit_queue(repos, r->pool);
+  if (serr)
+    {
+      ap_log_rerror(APLOG_MARK, APLOG_ERR, serr->apr_err, r,
+                    "running the post-commit queue failed: %s",
+                    svn_err_best_message(serr, buffer, sizeof(buffer)));
+      svn_error_clear(serr);
+    }
+
+  return OK;
+}
+
 static void
 merge_xml_filter_insert(request_rec *r)
 {
@@ -1342,6 +1583,12 @@ static const command_rec cmds[] =
                 "specifies the Subversion release version of a master "
                 "Subversion server "),
 
+  /* per directory/location */
+  AP_INIT_FLAG("SVNMasterReadThrough", SVNMasterReadThrough_cmd, NULL,
+               ACCESS_CONF,
+               "enables proxying reads of revisions that this mirror "
+               "does not have yet to the master server (default is Off)"),
+
   /* per directory/location */
   AP_INIT_TAKE1("SVNActivitiesDB", SVNActivitiesDB_cmd, NULL, ACCESS_CONF,
                 "specifies the location in the filesystem in which the "
@@ -1390,6 +1637,13 @@ static const command_rec cmds[] =
                "if sufficient in-memory cache is available"
                "(default is On)."),
 
+  /* per directory/location */
+  AP_INIT_FLAG("SVNCacheResponses", SVNCacheResponses_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "speeds up repeated GETs of immutable revision resources "
+               "by caching the svndiff data sent for them if sufficient "
+               "in-memory cache is available (default is Off)."),
+
   /* per directory/location */
   AP_INIT_FLAG("SVNBlockRead", SVNBlockRead_cmd, NULL,
                ACCESS_CONF|RSRC_CONF,
@@ -1397,6 +1651,13 @@ static const command_rec cmds[] =
                "caches (see SVNInMemoryCacheSize) have been configured."
                "(default is Off)."),
 
+  /* per directory/location */
+  AP_INIT_FLAG("SVNAsyncPostCommit", SVNAsyncPostCommit_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "answers commits before the post-commit hook has run. The "
+               "hook invocations are queued in the repository and run in "
+               "order after the response has been sent (default is Off)."),
+
   /* per server */
   AP_INIT_TAKE1("SVNInMemoryCacheSize", SVNInMemoryCacheSize_cmd, NULL,
                 RSRC_CONF,
@@ -1404,12 +1665,33 @@ static const command_rec cmds[] =
                 "in-memory object cache (default value is 16384; 0 switches "
                 "to dynamically sized caches)."),
   /* per server */
+  AP_INIT_ITERATE("SVNCacheMemoryPlacement", SVNCacheMemoryPlacement_cmd,
+                  NULL, RSRC_CONF,
+                  "places Subversion's in-memory object cache on huge pages "
+                  "('huge-pages') and / or spreads it across all NUMA nodes "
+                  "('numa-interleave'), where supported (default is "
+                  "neither)."),
+  /* per server */
   AP_INIT_TAKE1("SVNCompressionLevel", SVNCompressionLevel_cmd, NULL,
                 RSRC_CONF,
                 "specifies the compression level used before sending file "
                 "content over the network (0 for no compression, 9 for "
                 "maximum, 5 is default)."),
 
+  /* per server */
+  AP_INIT_TAKE1("SVNDeltaEncodingThreads", SVNDeltaEncodingThreads_cmd, NULL,
+                RSRC_CONF,
+                "specifies the number of threads compressing the text "
+                "deltas sent inline in update reports (0 and 1 encode them "
+                "on the request thread, which is the default)."),
+
+  /* per server */
+  AP_INIT_TAKE1("SVNTraceSpans", SVNTraceSpans_cmd, NULL,
+                RSRC_CONF,
+                "specifies the number of request tracing spans each process "
+                "keeps for the svn-trace handler (0 disables tracing, which "
+                "is the default)."),
+
   /* per server */
   AP_INIT_FLAG("SVNUseUTF8",
                SVNUseUTF8_cmd, NULL,
@@ -1460,6 +1742,12 @@ register_hooks(apr_pool_t *pconf)
   /* Handler to GET Subversion's FSFS cache stats, a bit like mod_status. */
   ap_hook_handler(dav_svn__status, NULL, NULL, APR_HOOK_MIDDLE);
 
+  /* Handler to GET the same stats plus FS counters for monitoring tools. */
+  ap_hook_handler(dav_svn__metrics, NULL, NULL, APR_HOOK_MIDDLE);
+
+  /* Handler to GET the recorded tracing spans. */
+  ap_hook_handler(dav_svn__trace, NULL, NULL, APR_HOOK_MIDDLE);
+
   /* live property handling */
   dav_hook_gather_propsets(dav_svn__gather_propsets, NULL, NULL,
                            APR_HOOK_MIDDLE);
@@ -1482,6 +1770,10 @@ register_hooks(apr_pool_t *pconf)
   /* map_to_storage hook is LAST to avoid interferring with mod_http's
    * handling of OPTIONS and TRACE. */
   ap_hook_map_to_storage(dav_svn__map_to_storage, NULL, NULL, APR_HOOK_LAST);
+
+  /* Deferred post-commit hooks run after the response has been sent. */
+  ap_hook_log_transaction(run_post_commit_queue, NULL, NULL,
+                          APR_HOOK_MIDDLE);
 }
 
 
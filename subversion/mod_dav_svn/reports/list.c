@@ -0,0 +1,304 @@
+/*
+ * list.c: mod_dav_svn REPORT handler for recursive directory listings
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+#include <apr_strings.h>
+#include <apr_xml.h>
+
+#include <http_request.h>
+#include <http_log.h>
+#include <mod_dav.h>
+
+#include "svn_pools.h"
+#include "svn_repos.h"
+#include "svn_xml.h"
+#include "svn_path.h"
+#include "svn_dav.h"
+#include "svn_time.h"
+#include "svn_base64.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_dav_protocol.h"
+#include "private/svn_log.h"
+
+#include "../dav_svn.h"
+
+/* Baton type to be used with list_receiver. */
+typedef struct list_receiver_baton_t
+{
+  /* Send the data through this brigade and output. */
+  apr_bucket_brigade *bb;
+  dav_svn__output *output;
+
+  /* Send the fields selected by these flags. */
+  apr_uint32_t dirent_fields;
+} list_receiver_baton_t;
+
+/* Implements svn_repos_dirent_receiver_t, sending DIRENT and PATH to the
+ * client as one <S:item> element.  BATON must be a list_receiver_baton_t. */
+static svn_error_t *
+list_receiver(const char *path,
+              svn_dirent_t *dirent,
+              void *baton,
+              apr_pool_t *pool)
+{
+  list_receiver_baton_t *b = baton;
+
+  SVN_ERR(dav_svn__brigade_printf(b->bb, b->output,
+                                  "<S:" SVN_DAV__ITEM " node-kind=\"%s\"",
+                                  svn_node_kind_to_word(dirent->kind)));
+
+  if (b->dirent_fields & SVN_DIRENT_SIZE)
+    SVN_ERR(dav_svn__brigade_printf(b->bb, b->output,
+                                    " size=\"%" SVN_FILESIZE_T_FMT "\"",
+                                    dirent->size));
+
+  if (b->dirent_fields & SVN_DIRENT_HAS_PROPS)
+    SVN_ERR(dav_svn__brigade_printf(b->bb, b->output,
+                                    " has-props=\"%s\"",
+                                    dirent->has_props ? "true" : "false"));
+
+  if (b->dirent_fields & SVN_DIRENT_CREATED_REV)
+    SVN_ERR(dav_svn__brigade_printf(b->bb, b->output,
+                                    " created-rev=\"%ld\"",
+                                    dirent->created_rev));
+
+  if ((b->dirent_fields & SVN_DIRENT_TIME) && dirent->time)
+    SVN_ERR(dav_svn__brigade_printf(b->bb, b->output,
+                                    " date=\"%s\"",
+                                    svn_time_to_cstring(dirent->time, pool)));
+
+  SVN_ERR(dav_svn__brigade_printf(b->bb, b->output,
+                                  ">" DEBUG_CR
+                                  "<S:" SVN_DAV__PATH ">%s</S:"
+                                  SVN_DAV__PATH ">" DEBUG_CR,
+                                  apr_xml_quote_string(pool, path, 0)));
+
+  if ((b->dirent_fields & SVN_DIRENT_LAST_AUTHOR) && dirent->last_author)
+    {
+      const char *author = dirent->last_author;
+      const char *encoding_str = "";
+
+      if (! svn_xml_is_xml_safe(author, strlen(author)))
+        {
+          author = svn_base64_encode_string2(svn_string_create(author, pool),
+                                             TRUE, pool)->data;
+          encoding_str = " encoding=\"base64\"";
+        }
+
+      SVN_ERR(dav_svn__brigade_printf(b->bb, b->output,
+                                      "<D:creator-displayname%s>%s"
+                                      "</D:creator-displayname>" DEBUG_CR,
+                                      encoding_str,
+                                      apr_xml_quote_string(pool, author, 0)));
+    }
+
+  return svn_error_trace(dav_svn__brigade_puts(b->bb, b->output,
+                                               "</S:" SVN_DAV__ITEM ">"
+                                               DEBUG_CR));
+}
+
+/* Map the dirent field name WORD to its SVN_DIRENT_* flag.  Return 0
+   for unknown names. */
+static apr_uint32_t
+dirent_field_from_word(const char *word)
+{
+  if (strcmp(word, "kind") == 0)
+    return SVN_DIRENT_KIND;
+  else if (strcmp(word, "size") == 0)
+    return SVN_DIRENT_SIZE;
+  else if (strcmp(word, "has-props") == 0)
+    return SVN_DIRENT_HAS_PROPS;
+  else if (strcmp(word, "created-rev") == 0)
+    return SVN_DIRENT_CREATED_REV;
+  else if (strcmp(word, "time") == 0)
+    return SVN_DIRENT_TIME;
+  else if (strcmp(word, "last-author") == 0)
+    return SVN_DIRENT_LAST_AUTHOR;
+
+  /* Be forward compatible. */
+  return 0;
+}
+
+/* Respond to a list-report request by streaming one <S:item> per node
+   found in the requested sub-tree.  The request looks like
+
+     <S:list-report xmlns:S="svn:">
+       <S:path>relative/path</S:path>
+       <S:revision>N</S:revision>
+       <S:depth>infinity</S:depth>
+       <S:pattern>*.c</S:pattern> ...
+       <S:dirent-field>size</S:dirent-field> ...
+     </S:list-report>
+ */
+dav_error *
+dav_svn__list_report(const dav_resource *resource,
+                     const apr_xml_doc *doc,
+                     dav_svn__output *output)
+{
+  svn_error_t *serr;
+  dav_error *derr = NULL;
+  apr_xml_elem *child;
+  dav_svn__authz_read_baton arb;
+  int ns;
+  apr_bucket_brigade *bb;
+  const char *path = resource->info->repos_path;
+  svn_fs_root_t *root;
+  svn_revnum_t rev = SVN_INVALID_REVNUM;
+  svn_depth_t depth = svn_depth_unknown;
+  apr_array_header_t *patterns = NULL;
+  list_receiver_baton_t rb;
+  svn_boolean_t path_info_only;
+
+  /* Sanity check. */
+  if (!resource->info->repos_path)
+    return dav_svn__new_error(resource->pool, HTTP_BAD_REQUEST, 0, 0,
+                              "The request does not specify a repository path");
+  ns = dav_svn__find_ns(doc->namespaces, SVN_XML_NAMESPACE);
+  if (ns == -1)
+    {
+      return dav_svn__new_error_svn(resource->pool, HTTP_BAD_REQUEST, 0, 0,
+                                    "The request does not contain the 'svn:' "
+                                    "namespace, so it is not going to have "
+                                    "certain required elements");
+    }
+
+  rb.dirent_fields = SVN_DIRENT_KIND;
+  for (child = doc->root->first_child;
+       child != NULL;
+       child = child->next)
+    {
+      /* if this element isn't one of ours, then skip it */
+      if (child->ns != ns)
+        continue;
+
+      if (strcmp(child->name, SVN_DAV__REVISION) == 0)
+        {
+          rev = SVN_STR_TO_REV(dav_xml_get_cdata(child, resource->pool, 1));
+        }
+      else if (strcmp(child->name, SVN_DAV__PATH) == 0)
+        {
+          path = dav_xml_get_cdata(child, resource->pool, 0);
+          if ((derr = dav_svn__test_canonical(path, resource->pool)))
+            return derr;
+          path = svn_fspath__join(resource->info->repos_path, path,
+                                  resource->pool);
+        }
+      else if (strcmp(child->name, SVN_DAV__DEPTH) == 0)
+        {
+          depth = svn_depth_from_word(dav_xml_get_cdata(child,
+                                                        resource->pool, 1));
+        }
+      else if (strcmp(child->name, SVN_DAV__PATTERN) == 0)
+        {
+          if (!patterns)
+            patterns = apr_array_make(resource->pool, 1,
+                                      sizeof(const char *));
+          APR_ARRAY_PUSH(patterns, const char *)
+            = dav_xml_get_cdata(child, resource->pool, 0);
+        }
+      else if (strcmp(child->name, SVN_DAV__DIRENT_FIELD) == 0)
+        {
+          rb.dirent_fields
+            |= dirent_field_from_word(dav_xml_get_cdata(child,
+                                                        resource->pool, 1));
+        }
+      /* else unknown element; skip it */
+    }
+
+  if (depth == svn_depth_unknown || depth == svn_depth_exclude)
+    return dav_svn__new_error(resource->pool, HTTP_BAD_REQUEST, 0, 0,
+                              "Invalid 'depth' specified in "
+                              "list-report request.");
+
+  /* Build authz read baton */
+  arb.r = resource->info->r;
+  arb.repos = resource->info->repos;
+
+  if (!SVN_IS_VALID_REVNUM(rev))
+    {
+      serr = svn_fs_youngest_rev(&rev, resource->info->repos->fs,
+                                 resource->pool);
+      if (serr != NULL)
+        return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                    "couldn't retrieve youngest revision",
+                                    resource->pool);
+    }
+
+  serr = svn_fs_revision_root(&root, resource->info->repos->fs,
+                              rev, resource->pool);
+  if (serr != NULL)
+    return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                "couldn't retrieve revision root",
+                                resource->pool);
+
+  bb = apr_brigade_create(resource->pool,
+                          dav_svn__output_get_bucket_alloc(output));
+  rb.bb = bb;
+  rb.output = output;
+
+  serr = dav_svn__brigade_puts(bb, output,
+                               DAV_XML_HEADER DEBUG_CR
+                               "<S:" SVN_DAV__LIST_REPORT " "
+                               "xmlns:S=\"" SVN_XML_NAMESPACE "\" "
+                               "xmlns:D=\"DAV:\">" DEBUG_CR);
+  if (serr)
+    {
+      derr = dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                  "Error beginning REPORT response.",
+                                  resource->pool);
+      goto cleanup;
+    }
+
+  /* Stream the directory entries while walking the tree. */
+  path_info_only = (rb.dirent_fields & ~SVN_DIRENT_KIND) == 0;
+  serr = svn_repos_list(root, path, patterns, depth, path_info_only,
+                        dav_svn__authz_read_func(&arb), &arb,
+                        list_receiver, &rb, NULL, NULL, resource->pool);
+  if (serr)
+    {
+      derr = dav_svn__convert_err(serr, HTTP_BAD_REQUEST, NULL,
+                                  resource->pool);
+      goto cleanup;
+    }
+
+  if ((serr = dav_svn__brigade_puts(bb, output,
+                                    "</S:" SVN_DAV__LIST_REPORT ">"
+                                    DEBUG_CR)))
+    {
+      derr = dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                  "Error ending REPORT response.",
+                                  resource->pool);
+      goto cleanup;
+    }
+
+ cleanup:
+
+  /* Log this 'high level' svn action. */
+  dav_svn__operational_log(resource->info,
+                           svn_log__list(path, rev, patterns, depth,
+                                         rb.dirent_fields, resource->pool));
+
+  return dav_svn__final_flush_or_error(resource->info->r, bb, output,
+                                       derr, resource->pool);
+}
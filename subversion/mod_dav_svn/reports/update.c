@@ -24,6 +24,9 @@
 #include <apr_pools.h>
 #include <apr_strings.h>
 #include <apr_xml.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
 
 #include <http_request.h>
 #include <http_log.h>
@@ -42,10 +45,14 @@
 
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
+#include "private/svn_delta_private.h"
 
 #include "../dav_svn.h"
 
 
+/* Worker threads encoding svndiff windows, see below. */
+typedef struct delta_encoder_t delta_encoder_t;
+
 /* State baton for the overall update process. */
 typedef struct update_ctx_t {
   const dav_resource *resource;
@@ -96,6 +103,9 @@ typedef struct update_ctx_t {
      resource" and are we advertising support for as much? */
   svn_boolean_t enable_v2_response;
 
+  /* If not NULL, text deltas are encoded by these worker threads. */
+  delta_encoder_t *encoder;
+
 } update_ctx_t;
 
 
@@ -137,6 +147,426 @@ typedef struct item_baton_t {
 #define DIR_OR_FILE(is_dir) ((is_dir) ? "directory" : "file")
 
 
+#if APR_HAS_THREADS
+
+/* Parallel svndiff encoding.
+ *
+ * In send-all mode, compressing the text delta windows usually dominates
+ * the CPU time spent on the request thread.  With an encoder, the windows
+ * are handed to a set of worker threads instead, and all output of the
+ * editor is kept in a queue until everything in front of it has been
+ * encoded.  The client therefore sees the exact same byte stream as
+ * without an encoder.
+ */
+
+/* A piece of output waiting in the queue. */
+typedef struct output_item_t
+{
+  /* The data to send.  For windows to encode, this is filled in by the
+     worker thread and only valid once DONE has been set. */
+  svn_stringbuf_t *data;
+
+  /* If not NULL, the window to encode, allocated in POOL. */
+  svn_txdelta_window_t *window;
+
+  /* If not NULL, send DATA through this (base64) stream instead of
+     writing it to the brigade directly.  Close it afterwards if
+     CLOSE_STREAM is set and then destroy STREAM_POOL, which holds the
+     stream. */
+  svn_stream_t *stream;
+  svn_boolean_t close_stream;
+  apr_pool_t *stream_pool;
+
+  /* Set when DATA is complete; ERR is the outcome of the encoding.
+     Both must only be accessed while holding the encoder's MUTEX. */
+  svn_boolean_t done;
+  svn_error_t *err;
+
+  /* Top-level pool holding this item and its data. */
+  apr_pool_t *pool;
+
+  /* Next item in the output queue and in the encoding queue. */
+  struct output_item_t *next;
+  struct output_item_t *next_job;
+} output_item_t;
+
+struct delta_encoder_t
+{
+  /* The svndiff settings of the report. */
+  int svndiff_version;
+  int compression_level;
+
+  /* The output queue.  Only the request thread accesses these. */
+  output_item_t *head;
+  output_item_t *tail;
+
+  /* Number of windows in the output queue and their upper limit. */
+  int queued_windows;
+  int max_windows;
+
+  /* Top-level pool holding the stream of the text delta currently
+     being queued, if any. */
+  apr_pool_t *stream_pool;
+
+  /* Windows not yet picked up by a worker, oldest first. */
+  output_item_t *jobs;
+  output_item_t *last_job;
+
+  /* If set, workers shall exit. */
+  svn_boolean_t shutdown;
+
+  /* Serialization and signalling of state changes. */
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+
+  /* The worker threads. */
+  apr_thread_t **threads;
+  int thread_count;
+
+  /* Top-level pool for the threads and their synchronization. */
+  apr_pool_t *pool;
+};
+
+/* Worker thread main function.  DATA is a delta_encoder_t.  Encode
+ * windows until the encoder gets shut down.
+ */
+static void *
+APR_THREAD_FUNC encoder_thread_func(apr_thread_t *tid, void *data)
+{
+  delta_encoder_t *encoder = data;
+
+  apr_thread_mutex_lock(encoder->mutex);
+  while (TRUE)
+    {
+      output_item_t *item;
+      svn_error_t *err;
+
+      while (!encoder->shutdown && !encoder->jobs)
+        apr_thread_cond_wait(encoder->changed, encoder->mutex);
+
+      if (encoder->shutdown)
+        break;
+
+      item = encoder->jobs;
+      encoder->jobs = item->next_job;
+      apr_thread_mutex_unlock(encoder->mutex);
+
+      /* Nobody else touches ITEM until we flag it as done. */
+      err = svn_txdelta__append_svndiff_window(item->data, item->window,
+                                               encoder->svndiff_version,
+                                               encoder->compression_level,
+                                               item->pool);
+
+      apr_thread_mutex_lock(encoder->mutex);
+      item->err = err;
+      item->done = TRUE;
+      apr_thread_cond_broadcast(encoder->changed);
+    }
+  apr_thread_mutex_unlock(encoder->mutex);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Stop all workers of the delta_encoder_t DATA and release everything
+ * still queued.  Implements an APR pool cleanup function.
+ */
+static apr_status_t
+shutdown_encoder(void *data)
+{
+  delta_encoder_t *encoder = data;
+  int i;
+
+  apr_thread_mutex_lock(encoder->mutex);
+  encoder->shutdown = TRUE;
+  apr_thread_cond_broadcast(encoder->changed);
+  apr_thread_mutex_unlock(encoder->mutex);
+
+  for (i = 0; i < encoder->thread_count; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, encoder->threads[i]);
+    }
+
+  while (encoder->head)
+    {
+      output_item_t *item = encoder->head;
+      encoder->head = item->next;
+
+      svn_error_clear(item->err);
+      if (item->stream_pool)
+        svn_pool_destroy(item->stream_pool);
+      svn_pool_destroy(item->pool);
+    }
+
+  if (encoder->stream_pool)
+    svn_pool_destroy(encoder->stream_pool);
+  svn_pool_destroy(encoder->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Start an encoder for UC with THREAD_COUNT workers and set UC->ENCODER.
+ * Leave UC->ENCODER as NULL if no worker could be started.
+ */
+static void
+start_encoder(update_ctx_t *uc,
+              int thread_count,
+              apr_pool_t *pool)
+{
+  delta_encoder_t *encoder = apr_pcalloc(pool, sizeof(*encoder));
+  apr_status_t status;
+  int i;
+
+  encoder->svndiff_version = uc->svndiff_version;
+  encoder->compression_level = uc->compression_level;
+  encoder->max_windows = 2 * thread_count;
+  encoder->pool = svn_pool_create(NULL);
+
+  status = apr_thread_mutex_create(&encoder->mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   encoder->pool);
+  if (!status)
+    status = apr_thread_cond_create(&encoder->changed, encoder->pool);
+  if (status)
+    {
+      svn_pool_destroy(encoder->pool);
+      return;
+    }
+
+  encoder->threads = apr_pcalloc(encoder->pool,
+                                 thread_count * sizeof(*encoder->threads));
+  for (i = 0; i < thread_count; ++i)
+    {
+      status = apr_thread_create(&encoder->threads[i], NULL,
+                                 encoder_thread_func, encoder,
+                                 encoder->pool);
+      if (status)
+        break;
+
+      ++encoder->thread_count;
+    }
+
+  apr_pool_cleanup_register(pool, encoder, shutdown_encoder,
+                            apr_pool_cleanup_null);
+
+  if (encoder->thread_count > 0)
+    uc->encoder = encoder;
+}
+
+/* Append a new item to the output queue of ENCODER and return it.
+ */
+static output_item_t *
+queue_item(delta_encoder_t *encoder)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  output_item_t *item = apr_pcalloc(pool, sizeof(*item));
+
+  item->pool = pool;
+  item->data = svn_stringbuf_create_empty(pool);
+
+  if (encoder->tail)
+    encoder->tail->next = item;
+  else
+    encoder->head = item;
+  encoder->tail = item;
+
+  return item;
+}
+
+/* Return the item at the end of the output queue of ENCODER that plain
+ * text may be appended to.
+ */
+static output_item_t *
+text_item(delta_encoder_t *encoder)
+{
+  output_item_t *item = encoder->tail;
+
+  if (item->window || item->stream)
+    {
+      item = queue_item(encoder);
+      item->done = TRUE;
+    }
+
+  return item;
+}
+
+/* Send all items at the head of UC's output queue that are complete
+ * to the client.  Wait for the encoding of further windows until no
+ * more than MAX_WINDOWS of them remain in the queue.
+ */
+static svn_error_t *
+flush_queue(update_ctx_t *uc,
+            int max_windows)
+{
+  delta_encoder_t *encoder = uc->encoder;
+
+  while (encoder->head)
+    {
+      output_item_t *item = encoder->head;
+      svn_error_t *err;
+      svn_boolean_t done;
+
+      apr_thread_mutex_lock(encoder->mutex);
+      while (!item->done && encoder->queued_windows > max_windows)
+        apr_thread_cond_wait(encoder->changed, encoder->mutex);
+      done = item->done;
+      err = item->err;
+      item->err = SVN_NO_ERROR;
+      apr_thread_mutex_unlock(encoder->mutex);
+
+      if (!done)
+        break;
+
+      encoder->head = item->next;
+      if (!encoder->head)
+        encoder->tail = NULL;
+      if (item->window)
+        --encoder->queued_windows;
+
+      if (!err && item->stream)
+        {
+          if (item->data->len)
+            err = svn_stream_write(item->stream, item->data->data,
+                                   &item->data->len);
+          if (!err && item->close_stream)
+            err = svn_stream_close(item->stream);
+        }
+      else if (!err && item->data->len)
+        {
+          err = dav_svn__brigade_write(uc->bb, uc->output,
+                                       item->data->data, item->data->len);
+        }
+
+      if (item->stream_pool)
+        svn_pool_destroy(item->stream_pool);
+      svn_pool_destroy(item->pool);
+      SVN_ERR(err);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a new base64 output stream for the text delta to be sent
+ * through UC's encoder.  It remains valid until the NULL window has been
+ * passed to queue_window() and the queue has been flushed.
+ */
+static svn_stream_t *
+open_queued_stream(update_ctx_t *uc)
+{
+  delta_encoder_t *encoder = uc->encoder;
+
+  /* The editor sends only one text delta at a time. */
+  SVN_ERR_ASSERT_NO_RETURN(encoder->stream_pool == NULL);
+  encoder->stream_pool = svn_pool_create(NULL);
+
+  return dav_svn__make_base64_output_stream(uc->bb, uc->output,
+                                            encoder->stream_pool);
+}
+
+/* Queue WINDOW to be encoded and sent through STREAM, which has been
+ * returned by open_queued_stream(), for UC.  Send the svndiff header
+ * first if HEADER is set.  If WINDOW is NULL, close STREAM instead.
+ */
+static svn_error_t *
+queue_window(update_ctx_t *uc,
+             svn_stream_t *stream,
+             svn_txdelta_window_t *window,
+             svn_boolean_t header)
+{
+  delta_encoder_t *encoder = uc->encoder;
+  output_item_t *item;
+
+  /* Limit the amount of memory held by the queue. */
+  SVN_ERR(flush_queue(uc, encoder->max_windows - 1));
+
+  if (header)
+    {
+      item = queue_item(encoder);
+      item->stream = stream;
+      item->done = TRUE;
+      svn_txdelta__append_svndiff_header(item->data,
+                                         encoder->svndiff_version);
+    }
+
+  item = queue_item(encoder);
+  item->stream = stream;
+
+  if (window == NULL)
+    {
+      item->close_stream = TRUE;
+      item->stream_pool = encoder->stream_pool;
+      item->done = TRUE;
+      encoder->stream_pool = NULL;
+    }
+  else
+    {
+      item->window = svn_txdelta_window_dup(window, item->pool);
+      ++encoder->queued_windows;
+
+      apr_thread_mutex_lock(encoder->mutex);
+      if (encoder->last_job && encoder->jobs)
+        encoder->last_job->next_job = item;
+      else
+        encoder->jobs = item;
+      encoder->last_job = item;
+      apr_thread_cond_signal(encoder->changed);
+      apr_thread_mutex_unlock(encoder->mutex);
+    }
+
+  /* Send whatever is ready. */
+  return svn_error_trace(flush_queue(uc, encoder->max_windows));
+}
+
+#endif /* APR_HAS_THREADS */
+
+
+/* Send the NUL-terminated STR to the client of UC, after any output
+   that is still being queued. */
+static svn_error_t *
+send_puts(update_ctx_t *uc, const char *str)
+{
+#if APR_HAS_THREADS
+  if (uc->encoder && uc->encoder->head)
+    {
+      svn_stringbuf_appendcstr(text_item(uc->encoder)->data, str);
+      return SVN_NO_ERROR;
+    }
+#endif
+
+  return svn_error_trace(dav_svn__brigade_puts(uc->bb, uc->output, str));
+}
+
+/* Send output to the client of UC using FMT as the output format string,
+   after any output that is still being queued. */
+static svn_error_t *
+send_printf(update_ctx_t *uc, const char *fmt, ...)
+  __attribute__((format(printf, 2, 3)));
+
+static svn_error_t *
+send_printf(update_ctx_t *uc, const char *fmt, ...)
+{
+  svn_error_t *err;
+  va_list ap;
+
+  va_start(ap, fmt);
+#if APR_HAS_THREADS
+  if (uc->encoder && uc->encoder->head)
+    {
+      output_item_t *item = text_item(uc->encoder);
+      svn_stringbuf_appendcstr(item->data,
+                               apr_pvsprintf(item->pool, fmt, ap));
+      err = SVN_NO_ERROR;
+    }
+  else
+#endif
+    err = dav_svn__brigade_vprintf(uc->bb, uc->output, fmt, ap);
+  va_end(ap);
+
+  return svn_error_trace(err);
+}
+
+
 /* add PATH to the pathmap HASH with a repository path of LINKPATH.
    if LINKPATH is NULL, PATH will map to itself. */
 static void
@@ -262,10 +692,10 @@ send_vsn_url(item_baton_t *baton, apr_pool_t *pool)
                                 revision, path, FALSE /* add_href */, pool);
     }
 
-  return dav_svn__brigade_printf(baton->uc->bb, baton->uc->output,
-                                 "<D:checked-in><D:href>%s</D:href>"
-                                 "</D:checked-in>" DEBUG_CR,
-                                 apr_xml_quote_string(pool, href, 1));
+  return send_printf(baton->uc,
+                     "<D:checked-in><D:href>%s</D:href>"
+                     "</D:checked-in>" DEBUG_CR,
+                     apr_xml_quote_string(pool, href, 1));
 }
 
 
@@ -279,8 +709,8 @@ absent_helper(svn_boolean_t is_dir,
 
   if (! uc->resource_walk)
     {
-      SVN_ERR(dav_svn__brigade_printf
-              (uc->bb, uc->output,
+      SVN_ERR(send_printf
+              (uc,
                "<S:absent-%s name=\"%s\"/>" DEBUG_CR,
                DIR_OR_FILE(is_dir),
                apr_xml_quote_string(pool,
@@ -323,10 +753,10 @@ add_helper(svn_boolean_t is_dir,
 
   if (uc->resource_walk)
     {
-      SVN_ERR(dav_svn__brigade_printf(child->uc->bb, child->uc->output,
-                                      "<S:resource path=\"%s\">" DEBUG_CR,
-                                      apr_xml_quote_string(pool, child->path3,
-                                                           1)));
+      SVN_ERR(send_printf(child->uc,
+                          "<S:resource path=\"%s\">" DEBUG_CR,
+                          apr_xml_quote_string(pool, child->path3,
+                                               1)));
     }
   else
     {
@@ -403,14 +833,14 @@ add_helper(svn_boolean_t is_dir,
          placeholders.  For example, "this%20dir" is a valid printf()
          format string that means "this[insert an integer of width 20
          here]ir". */
-      SVN_ERR(dav_svn__brigade_puts(child->uc->bb, child->uc->output, elt));
+      SVN_ERR(send_puts(child->uc, elt));
     }
 
   SVN_ERR(send_vsn_url(child, pool));
 
   if (uc->resource_walk)
-    SVN_ERR(dav_svn__brigade_puts(child->uc->bb, child->uc->output,
-                                  "</S:resource>" DEBUG_CR));
+    SVN_ERR(send_puts(child->uc,
+                      "</S:resource>" DEBUG_CR));
 
   *child_baton = child;
 
@@ -429,10 +859,10 @@ open_helper(svn_boolean_t is_dir,
   item_baton_t *child = make_child_baton(parent, path, pool);
   const char *qname = apr_xml_quote_string(pool, child->name, 1);
 
-  SVN_ERR(dav_svn__brigade_printf(child->uc->bb, child->uc->output,
-                                  "<S:open-%s name=\"%s\""
-                                  " rev=\"%ld\">" DEBUG_CR,
-                                  DIR_OR_FILE(is_dir), qname, base_revision));
+  SVN_ERR(send_printf(child->uc,
+                      "<S:open-%s name=\"%s\""
+                      " rev=\"%ld\">" DEBUG_CR,
+                      DIR_OR_FILE(is_dir), qname, base_revision));
   SVN_ERR(send_vsn_url(child, pool));
   *child_baton = child;
   return SVN_NO_ERROR;
@@ -456,21 +886,21 @@ close_helper(svn_boolean_t is_dir, item_baton_t *baton, apr_pool_t *pool)
         {
           qname = APR_ARRAY_IDX(baton->removed_props, i, const char *);
           qname = apr_xml_quote_string(pool, qname, 1);
-          SVN_ERR(dav_svn__brigade_printf(baton->uc->bb, baton->uc->output,
-                                          "<S:remove-prop name=\"%s\"/>"
-                                          DEBUG_CR, qname));
+          SVN_ERR(send_printf(baton->uc,
+                              "<S:remove-prop name=\"%s\"/>"
+                              DEBUG_CR, qname));
         }
     }
 
   /* Let's tie it off, nurse. */
   if (baton->added)
-    SVN_ERR(dav_svn__brigade_printf(baton->uc->bb, baton->uc->output,
-                                    "</S:add-%s>" DEBUG_CR,
-                                    DIR_OR_FILE(is_dir)));
+    SVN_ERR(send_printf(baton->uc,
+                        "</S:add-%s>" DEBUG_CR,
+                        DIR_OR_FILE(is_dir)));
   else
-    SVN_ERR(dav_svn__brigade_printf(baton->uc->bb, baton->uc->output,
-                                    "</S:open-%s>" DEBUG_CR,
-                                    DIR_OR_FILE(is_dir)));
+    SVN_ERR(send_printf(baton->uc,
+                        "</S:open-%s>" DEBUG_CR,
+                        DIR_OR_FILE(is_dir)));
   return SVN_NO_ERROR;
 }
 
@@ -482,8 +912,8 @@ maybe_start_update_report(update_ctx_t *uc)
 {
   if ((! uc->resource_walk) && (! uc->started_update))
     {
-      SVN_ERR(dav_svn__brigade_printf(
-                  uc->bb, uc->output,
+      SVN_ERR(send_printf(
+                  uc,
                   DAV_XML_HEADER DEBUG_CR "<S:update-report xmlns:S=\""
                   SVN_XML_NAMESPACE "\" xmlns:V=\"" SVN_DAV_PROP_NS_DAV "\" "
                   "xmlns:D=\"DAV:\" %s %s>" DEBUG_CR,
@@ -507,9 +937,9 @@ upd_set_target_revision(void *edit_baton,
   SVN_ERR(maybe_start_update_report(uc));
 
   if (! uc->resource_walk)
-    SVN_ERR(dav_svn__brigade_printf(uc->bb, uc->output,
-                                    "<S:target-revision rev=\"%ld\"/>"
-                                    DEBUG_CR, target_revision));
+    SVN_ERR(send_printf(uc,
+                        "<S:target-revision rev=\"%ld\"/>"
+                        DEBUG_CR, target_revision));
 
   return SVN_NO_ERROR;
 }
@@ -538,13 +968,13 @@ upd_open_root(void *edit_baton,
   SVN_ERR(maybe_start_update_report(uc));
 
   if (uc->resource_walk)
-    SVN_ERR(dav_svn__brigade_printf(uc->bb, uc->output,
-                                    "<S:resource path=\"%s\">" DEBUG_CR,
-                                    apr_xml_quote_string(pool, b->path3, 1)));
+    SVN_ERR(send_printf(uc,
+                        "<S:resource path=\"%s\">" DEBUG_CR,
+                        apr_xml_quote_string(pool, b->path3, 1)));
   else
-    SVN_ERR(dav_svn__brigade_printf(uc->bb, uc->output,
-                                    "<S:open-directory rev=\"%ld\">" DEBUG_CR,
-                                    base_revision));
+    SVN_ERR(send_printf(uc,
+                        "<S:open-directory rev=\"%ld\">" DEBUG_CR,
+                        base_revision));
 
   /* Only transmit the root directory's Version Resource URL if
      there's no target. */
@@ -552,8 +982,8 @@ upd_open_root(void *edit_baton,
     SVN_ERR(send_vsn_url(b, pool));
 
   if (uc->resource_walk)
-    SVN_ERR(dav_svn__brigade_puts(uc->bb, uc->output,
-                                  "</S:resource>" DEBUG_CR));
+    SVN_ERR(send_puts(uc,
+                      "</S:resource>" DEBUG_CR));
 
   return SVN_NO_ERROR;
 }
@@ -569,9 +999,9 @@ upd_delete_entry(const char *path,
   const char *qname = apr_xml_quote_string(pool,
                                            svn_relpath_basename(path, NULL),
                                            1);
-  return dav_svn__brigade_printf(parent->uc->bb, parent->uc->output,
-                                 "<S:delete-entry name=\"%s\" rev=\"%ld\"/>"
-                                   DEBUG_CR, qname, revision);
+  return send_printf(parent->uc,
+                     "<S:delete-entry name=\"%s\" rev=\"%ld\"/>"
+                       DEBUG_CR, qname, revision);
 }
 
 
@@ -621,29 +1051,29 @@ send_propchange(item_baton_t *b,
           svn_stringbuf_t *tmp = NULL;
           svn_xml_escape_cdata_string(&tmp, value, pool);
           qval = tmp->data;
-          SVN_ERR(dav_svn__brigade_printf(b->uc->bb, b->uc->output,
-                                          "<S:set-prop name=\"%s\">",
-                                          qname));
+          SVN_ERR(send_printf(b->uc,
+                              "<S:set-prop name=\"%s\">",
+                              qname));
         }
       else
         {
           qval = svn_base64_encode_string2(value, TRUE, pool)->data;
-          SVN_ERR(dav_svn__brigade_printf(b->uc->bb, b->uc->output,
-                                          "<S:set-prop name=\"%s\" "
-                                          "encoding=\"base64\">" DEBUG_CR,
-                                          qname));
+          SVN_ERR(send_printf(b->uc,
+                              "<S:set-prop name=\"%s\" "
+                              "encoding=\"base64\">" DEBUG_CR,
+                              qname));
         }
 
-      SVN_ERR(dav_svn__brigade_puts(b->uc->bb, b->uc->output, qval));
-      SVN_ERR(dav_svn__brigade_puts(b->uc->bb, b->uc->output,
-                                    "</S:set-prop>" DEBUG_CR));
+      SVN_ERR(send_puts(b->uc, qval));
+      SVN_ERR(send_puts(b->uc,
+                        "</S:set-prop>" DEBUG_CR));
     }
   else  /* value is null, so this is a prop removal */
     {
-      SVN_ERR(dav_svn__brigade_printf(b->uc->bb, b->uc->output,
-                                      "<S:remove-prop name=\"%s\"/>"
-                                      DEBUG_CR,
-                                      qname));
+      SVN_ERR(send_printf(b->uc,
+                          "<S:remove-prop name=\"%s\"/>"
+                          DEBUG_CR,
+                          qname));
     }
 
   return SVN_NO_ERROR;
@@ -763,6 +1193,9 @@ struct window_handler_baton
   /* The _real_ window handler and baton. */
   svn_txdelta_window_handler_t handler;
   void *handler_baton;
+
+  /* With an encoder, the base64 stream to queue the windows for. */
+  svn_stream_t *queued_stream;
 };
 
 
@@ -771,26 +1204,32 @@ static svn_error_t *
 window_handler(svn_txdelta_window_t *window, void *baton)
 {
   struct window_handler_baton *wb = baton;
+  svn_boolean_t first_window = ! wb->seen_first_window;
 
-  if (! wb->seen_first_window)
+  if (first_window)
     {
       wb->seen_first_window = TRUE;
 
       if (!wb->base_checksum)
-        SVN_ERR(dav_svn__brigade_puts(wb->uc->bb, wb->uc->output,
-                                      "<S:txdelta>"));
+        SVN_ERR(send_puts(wb->uc,
+                          "<S:txdelta>"));
       else
-        SVN_ERR(dav_svn__brigade_printf(wb->uc->bb, wb->uc->output,
-                                        "<S:txdelta base-checksum=\"%s\">",
-                                        wb->base_checksum));
+        SVN_ERR(send_printf(wb->uc,
+                            "<S:txdelta base-checksum=\"%s\">",
+                            wb->base_checksum));
     }
 
-  SVN_ERR(wb->handler(window, wb->handler_baton));
+#if APR_HAS_THREADS
+  if (wb->queued_stream)
+    SVN_ERR(queue_window(wb->uc, wb->queued_stream, window, first_window));
+  else
+#endif
+    SVN_ERR(wb->handler(window, wb->handler_baton));
 
   if (window == NULL)
     {
-      SVN_ERR(dav_svn__brigade_puts(wb->uc->bb, wb->uc->output,
-                                    "</S:txdelta>"));
+      SVN_ERR(send_puts(wb->uc,
+                        "</S:txdelta>"));
     }
 
   return SVN_NO_ERROR;
@@ -824,6 +1263,21 @@ upd_apply_textdelta(void *file_baton,
   wb->seen_first_window = FALSE;
   wb->uc = file->uc;
   wb->base_checksum = file->base_checksum;
+  wb->queued_stream = NULL;
+
+#if APR_HAS_THREADS
+  /* Let the workers encode the windows if we have any.  The stream must
+     survive FILE as its data may still be queued when FILE gets closed. */
+  if (file->uc->encoder)
+    {
+      wb->queued_stream = open_queued_stream(file->uc);
+      *handler = window_handler;
+      *handler_baton = wb;
+
+      return SVN_NO_ERROR;
+    }
+#endif
+
   base64_stream = dav_svn__make_base64_output_stream(wb->uc->bb,
                                                      wb->uc->output,
                                                      file->pool);
@@ -860,8 +1314,8 @@ upd_close_file(void *file_baton, const char *text_checksum, apr_pool_t *pool)
       if (sha1_checksum)
         sha1_digest = svn_checksum_to_cstring(sha1_checksum, pool);
 
-      SVN_ERR(dav_svn__brigade_printf
-              (file->uc->bb, file->uc->output,
+      SVN_ERR(send_printf
+              (file->uc,
                "<S:fetch-file%s%s%s%s%s%s/>" DEBUG_CR,
                file->base_checksum ? " base-checksum=\"" : "",
                file->base_checksum ? file->base_checksum : "",
@@ -873,11 +1327,11 @@ upd_close_file(void *file_baton, const char *text_checksum, apr_pool_t *pool)
 
   if (text_checksum)
     {
-      SVN_ERR(dav_svn__brigade_printf(file->uc->bb, file->uc->output,
-                                      "<S:prop>"
-                                      "<V:md5-checksum>%s</V:md5-checksum>"
-                                      "</S:prop>",
-                                      text_checksum));
+      SVN_ERR(send_printf(file->uc,
+                          "<S:prop>"
+                          "<V:md5-checksum>%s</V:md5-checksum>"
+                          "</S:prop>",
+                          text_checksum));
     }
 
   return close_helper(FALSE /* is_dir */, file, pool);
@@ -889,6 +1343,13 @@ upd_close_edit(void *edit_baton, apr_pool_t *pool)
 {
   update_ctx_t *uc = edit_baton;
 
+#if APR_HAS_THREADS
+  /* Everything the report driver will write from here on goes straight
+     to the brigade, so send what is still queued. */
+  if (uc->encoder)
+    SVN_ERR(flush_queue(uc, 0));
+#endif
+
   /* Our driver will unconditionally close the update report... So if
      the report hasn't even been started yet, start it now. */
   return maybe_start_update_report(uc);
@@ -1248,6 +1709,19 @@ dav_svn__update_report(const dav_resource *resource,
   if (! uc.send_all)
     text_deltas = FALSE;
 
+#if APR_HAS_THREADS
+  /* Compress the inline text deltas on worker threads if so configured.
+     A single worker would just add overhead. */
+  if (uc.send_all)
+    {
+      int thread_count
+        = dav_svn__get_delta_encoding_threads(resource->info->r);
+
+      if (thread_count > 1)
+        start_encoder(&uc, thread_count, resource->pool);
+    }
+#endif
+
   /* When we call svn_repos_finish_report, it will ultimately run
      dir_delta() between REPOS_PATH/TARGET and TARGET_PATH.  In the
      case of an update or status, these paths should be identical.  In
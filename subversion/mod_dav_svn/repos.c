@@ -55,8 +55,11 @@
 #include "svn_dirent_uri.h"
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
+#include "private/svn_cache.h"
+#include "private/svn_fs_private.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
 
 #include "dav_svn.h"
 
@@ -1741,7 +1744,9 @@ static int sort_encoding_pref(const void *accept_rec1, const void *accept_rec2)
 
 static int get_svndiff_version(const struct accept_rec *rec)
 {
-  if (strcmp(rec->name, "svndiff2") == 0)
+  if (strcmp(rec->name, "svndiff3") == 0)
+    return svn__zstd_supported() ? 3 : -1;
+  else if (strcmp(rec->name, "svndiff2") == 0)
     return 2;
   else if (strcmp(rec->name, "svndiff1") == 0)
     return 1;
@@ -2480,6 +2485,9 @@ get_resource(request_rec *r,
         return dav_svn__sanitize_error(serr,
                                        "Error settings hooks environment",
                                        HTTP_INTERNAL_SERVER_ERROR, r);
+
+      svn_repos__set_async_post_commit(repos->repos,
+                                       dav_svn__get_async_post_commit_flag(r));
     }
 
   /* cache the filesystem object */
@@ -3298,6 +3306,12 @@ set_headers(request_rec *r, const dav_resource *resource)
 typedef struct diff_ctx_t {
   dav_svn__output *output;
   apr_bucket_brigade *bb;
+
+  /* If not NULL, a copy of everything written so far, to be put into
+     CACHE once the response is complete.  Reset to NULL as soon as the
+     data grows too large for CACHE. */
+  svn_stringbuf_t *capture;
+  svn_cache__t *cache;
 } diff_ctx_t;
 
 
@@ -3306,6 +3320,14 @@ write_to_filter(void *baton, const char *buffer, apr_size_t *len)
 {
   diff_ctx_t *dc = baton;
 
+  if (dc->capture)
+    {
+      if (svn_cache__is_cachable(dc->cache, dc->capture->len + *len))
+        svn_stringbuf_appendbytes(dc->capture, buffer, *len);
+      else
+        dc->capture = NULL;
+    }
+
   /* take the current data and shove it into the filter */
   SVN_ERR(dav_svn__brigade_write(dc->bb, dc->output, buffer, *len));
 
@@ -3574,6 +3596,53 @@ emit_collection_tail(const dav_resource *resource,
 }
 
 
+/* Set *CACHE to the cache for svndiff responses for RESOURCE and *KEY
+   to the key under which the delta against BASE_REPOS_PATH@BASE_REV
+   is stored there.  Set *CACHE to NULL if the response should not be
+   cached, e.g. because RESOURCE is not immutable or caching has not
+   been enabled.
+
+   The key includes everything besides the FS contents that the
+   svndiff data depends on:  the repository UUID, both node locations,
+   the svndiff version and the compression level.  Repository paths
+   cannot contain newlines, so they are used as separators. */
+static svn_error_t *
+get_response_cache(svn_cache__t **cache,
+                   const char **key,
+                   const dav_resource *resource,
+                   svn_revnum_t base_rev,
+                   const char *base_repos_path,
+                   apr_pool_t *pool)
+{
+  request_rec *r = resource->info->r;
+  svn_membuffer_t *membuffer = svn_cache__get_global_membuffer_cache();
+  const char *uuid;
+
+  *cache = NULL;
+  if (!membuffer
+      || !dav_svn__get_response_cache_flag(r)
+      || !is_cacheable(r, resource)
+      || !SVN_IS_VALID_REVNUM(base_rev))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_get_uuid(resource->info->repos->fs, &uuid, pool));
+  *key = apr_psprintf(pool, "%s\n%ld\n%s\n%ld\n%s\n%d\n%d",
+                      uuid,
+                      svn_fs_revision_root_revision(resource->info->root.root),
+                      resource->info->repos_path,
+                      base_rev, base_repos_path,
+                      resource->info->svndiff_version,
+                      dav_svn__get_compression_level(r));
+
+  /* The data is a plain svn_stringbuf_t, so no serializer is needed. */
+  return svn_error_trace(svn_cache__create_membuffer_cache(
+                           cache, membuffer, NULL, NULL,
+                           APR_HASH_KEY_STRING, "dav_svn:response:",
+                           SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                           FALSE, FALSE, pool, pool));
+}
+
+
 static dav_error *
 deliver(const dav_resource *resource, ap_filter_t *unused)
 {
@@ -3773,6 +3842,7 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       svn_txdelta_window_handler_t handler;
       void * h_baton;
       diff_ctx_t dc = { 0 };
+      const char *cache_key = NULL;
 
       /* First order of business is to parse it. */
       serr = dav_svn__simple_parse_uri(&info, resource,
@@ -3806,6 +3876,52 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
                                       "to a file in revision %ld",
                                       info.repos_path, info.rev));
 
+          /* Both ends of the delta are immutable, so we may have sent
+             this very response before. */
+          serr = get_response_cache(&dc.cache, &cache_key, resource,
+                                    info.rev, info.repos_path,
+                                    resource->pool);
+          if (serr == NULL && dc.cache)
+            {
+              svn_stringbuf_t *cached;
+              svn_boolean_t found;
+
+              serr = svn_cache__get((void **)&cached, &found, dc.cache,
+                                    cache_key, resource->pool);
+              if (serr == NULL && found)
+                {
+                  dc.output = output;
+                  dc.bb = apr_brigade_create(
+                            resource->pool,
+                            dav_svn__output_get_bucket_alloc(output));
+
+                  serr = dav_svn__brigade_write(dc.bb, output, cached->data,
+                                                cached->len);
+                  if (serr == NULL)
+                    serr = close_filter(&dc);
+                  apr_brigade_destroy(dc.bb);
+
+                  if (serr != NULL)
+                    return dav_svn__convert_err(serr,
+                                                HTTP_INTERNAL_SERVER_ERROR,
+                                                "could not deliver the "
+                                                "cached txdelta stream",
+                                                resource->pool);
+
+                  return NULL;
+                }
+
+              dc.capture = svn_stringbuf_create_empty(resource->pool);
+            }
+
+          /* A broken cache must not fail the request. */
+          if (serr != NULL)
+            {
+              svn_error_clear(serr);
+              dc.cache = NULL;
+              dc.capture = NULL;
+            }
+
           /* Okay. Let's open up a delta stream for the client to read. */
           serr = svn_fs_get_file_delta_stream(&txd_stream,
                                               root, info.repos_path,
@@ -3846,6 +3962,11 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
                                         "could not deliver the txdelta stream",
                                         resource->pool);
 
+          /* The response has been sent in full; remember it. */
+          if (dc.capture)
+            svn_error_clear(svn_cache__set(dc.cache, cache_key, dc.capture,
+                                           resource->pool));
+
 
           return NULL;
         }
@@ -3860,6 +3981,46 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       svn_stream_t *stream;
       char *block;
 
+      /* If the FS stores the contents as-is, let httpd send them straight
+         from the rev / pack file, i.e. using sendfile() where possible.
+         Keyword substitution needs the data in user space, though. */
+      if (! resource->info->keyword_subst)
+        {
+          apr_file_t *file;
+          apr_off_t offset;
+          svn_filesize_t length;
+
+          serr = svn_fs__try_get_file_range(&file, &offset, &length,
+                                            resource->info->root.root,
+                                            resource->info->repos_path,
+                                            resource->pool, resource->pool);
+          if (serr != NULL)
+            return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                        "could not prepare to read the file",
+                                        resource->pool);
+
+          if (file)
+            {
+              apr_bucket_alloc_t *alloc
+                = dav_svn__output_get_bucket_alloc(output);
+
+              bb = apr_brigade_create(resource->pool, alloc);
+              apr_brigade_insert_file(bb, file, offset, length,
+                                      resource->pool);
+              bkt = apr_bucket_eos_create(alloc);
+              APR_BRIGADE_INSERT_TAIL(bb, bkt);
+
+              serr = dav_svn__output_pass_brigade(output, bb);
+              apr_brigade_destroy(bb);
+              if (serr != NULL)
+                return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                            "Could not write data to filter.",
+                                            resource->pool);
+
+              return NULL;
+            }
+        }
+
       serr = svn_fs_file_contents(&stream,
                                   resource->info->root.root,
                                   resource->info->repos_path,
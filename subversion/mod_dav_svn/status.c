@@ -28,6 +28,7 @@
 #include "dav_svn.h"
 #include "private/svn_cache.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_subr_private.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
@@ -117,3 +118,57 @@ int dav_svn__status(request_rec *r)
 
   return 0;
 }
+
+/* Like dav_svn__status but for monitoring systems:
+
+     <Location /svn-metrics>
+       SetHandler svn-metrics
+     </Location>
+
+  returns the cache statistics and FS operation counters of the serving
+  process in the Prometheus text format.  The same caveat about multiple
+  server processes applies.
+*/
+int dav_svn__metrics(request_rec *r)
+{
+  svn_string_t *text;
+
+  if (r->method_number != M_GET || strcmp(r->handler, "svn-metrics"))
+    return DECLINED;
+
+  text = svn_metrics__format_prometheus(r->pool);
+
+  ap_set_content_type(r, "text/plain; version=0.0.4");
+  ap_rwrite(text->data, (int)text->len, r);
+
+  return 0;
+}
+
+/* Export the most recent tracing spans of the serving process, see the
+   SVNTraceSpans directive:
+
+     <Location /svn-trace>
+       SetHandler svn-trace
+     </Location>
+
+  The result is in Chrome's trace event format unless the query string
+  is "format=otlp", which selects OTLP/JSON instead.
+*/
+int dav_svn__trace(request_rec *r)
+{
+  svn_string_t *text;
+  svn_trace__format_t format = svn_trace__format_chrome;
+
+  if (r->method_number != M_GET || strcmp(r->handler, "svn-trace"))
+    return DECLINED;
+
+  if (r->args && strcmp(r->args, "format=otlp") == 0)
+    format = svn_trace__format_otlp;
+
+  text = svn_trace__export(format, r->pool);
+
+  ap_set_content_type(r, "application/json");
+  ap_rwrite(text->data, (int)text->len, r);
+
+  return 0;
+}
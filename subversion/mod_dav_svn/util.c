@@ -555,13 +555,27 @@ dav_svn__brigade_printf(apr_bucket_brigade *bb,
                         const char *fmt,
                         ...)
 {
-  apr_status_t apr_err;
+  svn_error_t *err;
   va_list ap;
 
   va_start(ap, fmt);
+  err = dav_svn__brigade_vprintf(bb, output, fmt, ap);
+  va_end(ap);
+
+  return err;
+}
+
+
+svn_error_t *
+dav_svn__brigade_vprintf(apr_bucket_brigade *bb,
+                         dav_svn__output *output,
+                         const char *fmt,
+                         va_list ap)
+{
+  apr_status_t apr_err;
+
   apr_err = apr_brigade_vprintf(bb, ap_filter_flush,
                                 output->r->output_filters, fmt, ap);
-  va_end(ap);
   if (apr_err)
     return svn_error_create(apr_err, 0, NULL);
   /* Check for an aborted connection, since the brigade functions don't
@@ -154,7 +154,10 @@ get_vsn_options(apr_pool_t *p, apr_text_header *phdr)
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_REVERSE_FILE_REVS);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_SVNDIFF1);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_SVNDIFF2);
+  if (svn__zstd_supported())
+    apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_SVNDIFF3);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_PUT_RESULT_CHECKSUM);
+  apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_LIST);
   /* Mergeinfo is a special case: here we merely say that the server
    * knows how to handle mergeinfo -- whether the repository does too
    * is a separate matter.
@@ -974,6 +977,8 @@ dav_svn__checkin(dav_resource *resource,
 
       if (SVN_IS_VALID_REVNUM(new_rev))
         {
+          dav_svn__post_commit_queued(resource->info->r,
+                                      resource->info->repos->repos);
           if (serr)
             {
               const char *post_commit_err = svn_repos__post_commit_error_str
@@ -1154,6 +1159,10 @@ deliver_report(request_rec *r,
         {
           return dav_svn__get_inherited_props_report(resource, doc, output);
         }
+      else if (strcmp(doc->root->name, SVN_DAV__LIST_REPORT) == 0)
+        {
+          return dav_svn__list_report(resource, doc, output);
+        }
       /* NOTE: if you add a report, don't forget to add it to the
        *       dav_svn__reports_list[] array.
        */
@@ -1491,6 +1500,8 @@ merge(dav_resource *target,
      commit info) and the failure of the post-commit hook.  */
   if (SVN_IS_VALID_REVNUM(new_rev))
     {
+      dav_svn__post_commit_queued(source->info->r,
+                                  source->info->repos->repos);
       if (serr)
         {
           /* ### Any error from svn_fs_commit_txn() itself, and not
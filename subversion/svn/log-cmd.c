@@ -25,6 +25,7 @@
 
 #include "svn_client.h"
 #include "svn_compat.h"
+#include "svn_ctype.h"
 #include "svn_dirent_uri.h"
 #include "svn_string.h"
 #include "svn_path.h"
@@ -36,6 +37,7 @@
 #include "svn_props.h"
 #include "svn_pools.h"
 
+#include "private/svn_client_private.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
@@ -230,6 +232,191 @@ match_search_patterns(apr_array_header_t *search_patterns,
   return match;
 }
 
+/* Map all digits in STR to '0' and all '+' to '-', so that a
+ * human-readable date looks like any other date of the same month and
+ * weekday.  Return STR. */
+static char *
+date_shape(char *str)
+{
+  char *p;
+
+  for (p = str; *p; p++)
+    if (svn_ctype_isdigit(*p))
+      *p = '0';
+    else if (*p == '+')
+      *p = '-';
+
+  return str;
+}
+
+/* Set *SAMPLES to the shapes (see date_shape()) of all date strings that
+ * svn_cl__log_entry_receiver() may match search patterns against, plus
+ * those of the placeholders it uses for missing revprops.  The 15th of
+ * every month over a 28-year calendar cycle covers all combinations of
+ * month and weekday names.  Use BUF for temporary allocations. */
+static svn_error_t *
+get_date_samples(apr_array_header_t **samples,
+                 svn_membuf_t *buf,
+                 apr_pool_t *pool)
+{
+  const char *placeholders[4];
+  const char *str;
+  int year, month, i;
+
+  placeholders[0] = _("(no author)");
+  placeholders[1] = _("(no date)");
+  placeholders[2] = _("(invalid date)");
+  placeholders[3] = NULL;
+
+  *samples = apr_array_make(pool, 28 * 12 + 3, sizeof(const char *));
+  for (year = 2000; year < 2028; year++)
+    for (month = 1; month <= 12; month++)
+      {
+        SVN_ERR(svn_cl__time_cstring_to_human_cstring(
+                  &str,
+                  apr_psprintf(pool, "%04d-%02d-15T12:00:00.000000Z",
+                               year, month),
+                  pool));
+        SVN_ERR(svn_utf__xfrm(&str, str, strlen(str), TRUE, TRUE, buf));
+        APR_ARRAY_PUSH(*samples, const char *)
+          = date_shape(apr_pstrdup(pool, str));
+      }
+
+  for (i = 0; placeholders[i]; i++)
+    {
+      SVN_ERR(svn_utf__xfrm(&str, placeholders[i], strlen(placeholders[i]),
+                            TRUE, TRUE, buf));
+      APR_ARRAY_PUSH(*samples, const char *)
+        = date_shape(apr_pstrdup(pool, str));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if the search pattern PATTERN can never match a date or
+ * placeholder, i.e. if one of its literal parts does not occur in any
+ * of the SAMPLES returned by get_date_samples(). */
+static svn_boolean_t
+pattern_avoids_dates(const char *pattern,
+                     const apr_array_header_t *samples,
+                     apr_pool_t *pool)
+{
+  svn_stringbuf_t *literal = svn_stringbuf_create_empty(pool);
+  const char *p = pattern;
+
+  while (TRUE)
+    {
+      if (*p == '\\' && p[1])
+        {
+          svn_stringbuf_appendbyte(literal, p[1]);
+          p += 2;
+          continue;
+        }
+
+      if (*p && *p != '*' && *p != '?' && *p != '[')
+        {
+          svn_stringbuf_appendbyte(literal, *p);
+          p++;
+          continue;
+        }
+
+      /* End of a literal part. */
+      if (literal->len)
+        {
+          int i;
+
+          date_shape(literal->data);
+          for (i = 0; i < samples->nelts; i++)
+            if (strstr(APR_ARRAY_IDX(samples, i, const char *),
+                       literal->data))
+              break;
+
+          if (i == samples->nelts)
+            return TRUE;
+
+          svn_stringbuf_setempty(literal);
+        }
+
+      if (*p == '\0')
+        break;
+
+      /* Skip the wildcard.  A ']' right after the opening bracket and
+         its optional negation is part of the set. */
+      if (*p++ == '[')
+        {
+          if (*p == '!' || *p == '^')
+            p++;
+          if (*p == ']')
+            p++;
+          while (*p && *p != ']')
+            p++;
+          if (*p)
+            p++;
+        }
+    }
+
+  return FALSE;
+}
+
+/* Set *REPOS_PATTERNS to the groups of SEARCH_PATTERNS that the repository
+ * can evaluate on our behalf without skipping any revision that we would
+ * show, or to NULL if there are none.
+ *
+ * The repository matches the raw date while HUMAN_DATES says that we
+ * match a human-readable one and placeholders for missing revprops.  In
+ * that case, drop all patterns that might match those.  Dropping a
+ * pattern from a group only makes the group match more revisions;
+ * leaving a group empty makes all revisions match.
+ *
+ * Use BUF for temporary allocations. */
+static svn_error_t *
+get_repos_search_patterns(apr_array_header_t **repos_patterns,
+                          apr_array_header_t *search_patterns,
+                          svn_boolean_t human_dates,
+                          svn_membuf_t *buf,
+                          apr_pool_t *pool)
+{
+  apr_array_header_t *samples;
+  int i, j;
+
+  *repos_patterns = NULL;
+  if (!search_patterns || !human_dates)
+    {
+      *repos_patterns = search_patterns;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(get_date_samples(&samples, buf, pool));
+
+  *repos_patterns = apr_array_make(pool, search_patterns->nelts,
+                                   sizeof(apr_array_header_t *));
+  for (i = 0; i < search_patterns->nelts; i++)
+    {
+      apr_array_header_t *group
+        = APR_ARRAY_IDX(search_patterns, i, apr_array_header_t *);
+      apr_array_header_t *repos_group
+        = apr_array_make(pool, group->nelts, sizeof(const char *));
+
+      for (j = 0; j < group->nelts; j++)
+        {
+          const char *pattern = APR_ARRAY_IDX(group, j, const char *);
+
+          if (pattern_avoids_dates(pattern, samples, pool))
+            APR_ARRAY_PUSH(repos_group, const char *) = pattern;
+        }
+
+      if (repos_group->nelts == 0)
+        {
+          *repos_patterns = NULL;
+          break;
+        }
+
+      APR_ARRAY_PUSH(*repos_patterns, apr_array_header_t *) = repos_group;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Implement `svn_log_entry_receiver_t', printing the logs in
  * a human-readable and machine-parseable format.
  *
@@ -705,6 +892,7 @@ svn_cl__log(apr_getopt_t *os,
   svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
   apr_array_header_t *targets;
   svn_cl__log_receiver_baton lb;
+  apr_array_header_t *repos_patterns = NULL;
   const char *target;
   int i;
   apr_array_header_t *revprops;
@@ -817,6 +1005,12 @@ svn_cl__log(apr_getopt_t *os,
   svn_membuf__create(&lb.buffer, 0, pool);
   lb.pool = pool;
 
+  /* Let the repository skip revisions that we would not show anyway.
+     It does not search merged revisions. */
+  if (! opt_state->use_merge_history)
+    SVN_ERR(get_repos_search_patterns(&repos_patterns, lb.search_patterns,
+                                      ! opt_state->xml, &lb.buffer, pool));
+
   if (opt_state->xml)
     {
       /* If output is not incremental, output the XML header and wrap
@@ -859,18 +1053,19 @@ svn_cl__log(apr_getopt_t *os,
           if (!opt_state->quiet)
             APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_LOG;
         }
-      SVN_ERR(svn_client_log5(targets,
-                              &lb.target_peg_revision,
-                              opt_state->revision_ranges,
-                              opt_state->limit,
-                              opt_state->verbose,
-                              opt_state->stop_on_copy,
-                              opt_state->use_merge_history,
-                              revprops,
-                              svn_cl__log_entry_receiver_xml,
-                              &lb,
-                              ctx,
-                              pool));
+      SVN_ERR(svn_client__log_search(targets,
+                                     &lb.target_peg_revision,
+                                     opt_state->revision_ranges,
+                                     opt_state->limit,
+                                     opt_state->verbose,
+                                     opt_state->stop_on_copy,
+                                     opt_state->use_merge_history,
+                                     revprops,
+                                     repos_patterns,
+                                     svn_cl__log_entry_receiver_xml,
+                                     &lb,
+                                     ctx,
+                                     pool));
 
       if (! opt_state->incremental)
         SVN_ERR(svn_cl__xml_print_footer("log", pool));
@@ -882,18 +1077,19 @@ svn_cl__log(apr_getopt_t *os,
       APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_DATE;
       if (!opt_state->quiet)
         APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_LOG;
-      SVN_ERR(svn_client_log5(targets,
-                              &lb.target_peg_revision,
-                              opt_state->revision_ranges,
-                              opt_state->limit,
-                              opt_state->verbose,
-                              opt_state->stop_on_copy,
-                              opt_state->use_merge_history,
-                              revprops,
-                              svn_cl__log_entry_receiver,
-                              &lb,
-                              ctx,
-                              pool));
+      SVN_ERR(svn_client__log_search(targets,
+                                     &lb.target_peg_revision,
+                                     opt_state->revision_ranges,
+                                     opt_state->limit,
+                                     opt_state->verbose,
+                                     opt_state->stop_on_copy,
+                                     opt_state->use_merge_history,
+                                     revprops,
+                                     repos_patterns,
+                                     svn_cl__log_entry_receiver,
+                                     &lb,
+                                     ctx,
+                                     pool));
 
       if (! opt_state->incremental)
         SVN_ERR(svn_cmdline_printf(pool, SVN_CL__LOG_SEP_STRING));
@@ -3177,6 +3177,7 @@ main(int argc, const char *argv[])
 {
   apr_pool_t *pool;
   int exit_code = EXIT_SUCCESS;
+  svn_boolean_t pool_stats;
   svn_error_t *err;
 
   /* Initialize the app. */
@@ -3188,6 +3189,11 @@ main(int argc, const char *argv[])
    */
   pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
 
+  /* Pool statistics help to track down excessive memory usage. */
+  pool_stats = getenv("SVN_POOL_STATS") != NULL;
+  if (pool_stats)
+    svn_pool__stats_enable();
+
   err = sub_main(&exit_code, argc, argv, pool);
 
   /* Flush stdout and report if it fails. It would be flushed on exit anyway
@@ -3200,6 +3206,14 @@ main(int argc, const char *argv[])
       svn_cmdline_handle_exit_error(err, NULL, "svn: ");
     }
 
+  if (pool_stats)
+    {
+      /* Release all sub-pools first, so their usage gets accounted for. */
+      svn_pool_clear(pool);
+      svn_error_clear(svn_cmdline_fputs(svn_pool__stats_format(20, pool)->data,
+                                        stderr, pool));
+    }
+
   svn_pool_destroy(pool);
 
   svn_cmdline__cancellation_exit();
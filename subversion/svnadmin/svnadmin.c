@@ -151,7 +151,11 @@ enum svnadmin__cmdline_options_t
     svnadmin__compatible_version,
     svnadmin__check_normalization,
     svnadmin__metadata_only,
-    svnadmin__no_flush_to_disk
+    svnadmin__no_flush_to_disk,
+    svnadmin__jobs,
+    svnadmin__segments,
+    svnadmin__include,
+    svnadmin__exclude
   };
 
 /* Option codes and descriptions.
@@ -274,6 +278,23 @@ static const apr_getopt_option_t options_table[] =
      N_("disable flushing to disk during the operation\n"
         "                             (faster, but unsafe on power off)")},
 
+    {"jobs", svnadmin__jobs, 1,
+     N_("verify up to ARG shards of the repository in\n"
+        "                             parallel (default: 1)")},
+
+    {"segments", svnadmin__segments, 1,
+     N_("use a segmented dump in directory ARG\n"
+        "                             instead of a single dump stream")},
+
+    {"include", svnadmin__include, 1,
+     N_("dump only nodes at or below path ARG (and\n"
+        "                             their parent directories); may be\n"
+        "                             given multiple times")},
+
+    {"exclude", svnadmin__exclude, 1,
+     N_("do not dump nodes at or below path ARG;\n"
+        "                             may be given multiple times")},
+
     {NULL}
   };
 
@@ -330,9 +351,19 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
     "only the paths changed in that revision; otherwise it will describe\n"
     "every path present in the repository as of that revision.  (In either\n"
     "case, the second and subsequent revisions, if any, describe only paths\n"
-    "changed in those revisions.)\n"),
-  {'r', svnadmin__incremental, svnadmin__deltas, 'q', 'M', 'F'},
-  {{'F', N_("write to file ARG instead of stdout")}} },
+    "changed in those revisions.)\n"
+    "\n"
+    "With --include or --exclude, filtered subtrees are not read from the\n"
+    "repository at all.  Copies from filtered paths become plain adds.\n"),
+  {'r', svnadmin__incremental, svnadmin__deltas, 'q', 'M', 'F',
+   svnadmin__segments, svnadmin__jobs, svnadmin__include,
+   svnadmin__exclude},
+  {{'F', N_("write to file ARG instead of stdout")},
+   {svnadmin__segments, N_("write shard-sized segments and a manifest\n"
+                           "                             to directory ARG "
+                           "instead of stdout")},
+   {svnadmin__jobs, N_("dump up to ARG segments in parallel\n"
+                       "                             (default: 1)")}} },
 
   {"dump-revprops", subcommand_dump_revprops, {0}, N_
    ("usage: svnadmin dump-revprops REPOS_PATH [-r LOWER[:UPPER]]\n\n"
@@ -366,7 +397,9 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
     "Make a hot copy of a repository.\n"
     "If --incremental is passed, data which already exists at the destination\n"
     "is not copied again.  Incremental mode is implemented for FSFS repositories.\n"),
-   {svnadmin__clean_logs, svnadmin__incremental, 'q'} },
+   {svnadmin__clean_logs, svnadmin__incremental, 'q', svnadmin__jobs},
+   {{svnadmin__jobs, N_("copy up to ARG shards in parallel (FSFS only)\n"
+                        "                             (default: 1)")}} },
 
   {"info", subcommand_info, {0}, N_
    ("usage: svnadmin info REPOS_PATH\n\n"
@@ -397,8 +430,12 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
     svnadmin__ignore_dates,
     svnadmin__use_pre_commit_hook, svnadmin__use_post_commit_hook,
     svnadmin__parent_dir, svnadmin__bypass_prop_validation, 'M',
-    svnadmin__no_flush_to_disk, 'F'},
-   {{'F', N_("read from file ARG instead of stdin")}} },
+    svnadmin__no_flush_to_disk, 'F', svnadmin__segments, svnadmin__jobs},
+   {{'F', N_("read from file ARG instead of stdin")},
+    {svnadmin__segments, N_("read the segmented dump in directory ARG\n"
+                            "                             instead of stdin")},
+    {svnadmin__jobs, N_("parse and decode the dump stream in a separate\n"
+                        "                             thread if ARG > 1")}} },
 
   {"load-revprops", subcommand_load_revprops, {0}, N_
    ("usage: svnadmin load-revprops REPOS_PATH\n\n"
@@ -513,7 +550,8 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
    ("usage: svnadmin verify REPOS_PATH\n\n"
     "Verify the data stored in the repository.\n"),
    {'t', 'r', 'q', svnadmin__keep_going, 'M',
-    svnadmin__check_normalization, svnadmin__metadata_only} },
+    svnadmin__check_normalization, svnadmin__metadata_only,
+    svnadmin__jobs} },
 
   { NULL, NULL, {0}, NULL, {0} }
 };
@@ -550,8 +588,12 @@ struct svnadmin_opt_state
   enum svn_repos_load_uuid uuid_action;             /* --ignore-uuid,
                                                        --force-uuid */
   apr_uint64_t memory_cache_size;                   /* --memory-cache-size M */
+  int jobs;                                         /* --jobs */
   const char *parent_dir;                           /* --parent-dir */
   const char *file;                                 /* --file */
+  const char *segments_dir;                         /* --segments */
+  apr_array_header_t *include;                      /* --include */
+  apr_array_header_t *exclude;                      /* --exclude */
 
   const char *config_dir;    /* Overriding Configuration Directory */
 };
@@ -894,7 +936,7 @@ struct repos_verify_callback_baton
 };
 
 /* Implementation of svn_repos_verify_callback_t to handle errors coming
-   from svn_repos_verify_fs3(). */
+   from svn_repos_verify_fs4(). */
 static svn_error_t *
 repos_verify_callback(void *baton,
                       svn_revnum_t revision,
@@ -937,7 +979,7 @@ repos_verify_callback(void *baton,
 
 /* Implementation of svn_repos_notify_func_t to wrap the output to a
    response stream for svn_repos_dump_fs2(), svn_repos_verify_fs(),
-   svn_repos_hotcopy3() and others. */
+   svn_repos_hotcopy4() and others. */
 static void
 repos_notify_handler(void *baton,
                      const svn_repos_notify_t *notify,
@@ -1248,6 +1290,51 @@ get_dump_range(svn_revnum_t *lower,
   return SVN_NO_ERROR;
 }
 
+/* Baton for dump_filter_func. */
+struct dump_filter_baton_t
+{
+  /* Absolute repository paths given to --include or --exclude. */
+  apr_array_header_t *prefixes;
+
+  /* Whether PREFIXES came from --exclude. */
+  svn_boolean_t do_exclude;
+};
+
+/* Implements svn_repos_dump_filter_func_t.  Like svndumpfilter, match
+   whole path components.  When including, keep the parent directories
+   of the included paths as well, so that the dump can be loaded into
+   an empty repository. */
+static svn_error_t *
+dump_filter_func(svn_boolean_t *include,
+                 svn_fs_root_t *root,
+                 const char *path,
+                 void *baton,
+                 apr_pool_t *scratch_pool)
+{
+  struct dump_filter_baton_t *b = baton;
+  int i;
+
+  for (i = 0; i < b->prefixes->nelts; i++)
+    {
+      const char *prefix = APR_ARRAY_IDX(b->prefixes, i, const char *);
+
+      if (svn_fspath__skip_ancestor(prefix, path))
+        {
+          *include = !b->do_exclude;
+          return SVN_NO_ERROR;
+        }
+
+      if (!b->do_exclude && svn_fspath__skip_ancestor(path, prefix))
+        {
+          *include = TRUE;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  *include = b->do_exclude;
+  return SVN_NO_ERROR;
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -1257,13 +1344,46 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_stream_t *out_stream;
   svn_revnum_t lower, upper;
   svn_stream_t *feedback_stream = NULL;
+  svn_repos_dump_filter_func_t filter_func = NULL;
+  struct dump_filter_baton_t filter_baton = { 0 };
 
   /* Expect no more arguments. */
   SVN_ERR(parse_args(NULL, os, 0, 0, pool));
 
+  if (opt_state->file && opt_state->segments_dir)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("--file (-F) and --segments "
+                              "are mutually exclusive"));
+
+  if (opt_state->include && opt_state->exclude)
+    return svn_error_create(SVN_ERR_CL_MUTUALLY_EXCLUSIVE_ARGS, NULL,
+                            _("--include and --exclude "
+                              "are mutually exclusive"));
+
+  if (opt_state->include || opt_state->exclude)
+    {
+      filter_func = dump_filter_func;
+      filter_baton.do_exclude = opt_state->exclude != NULL;
+      filter_baton.prefixes = opt_state->exclude ? opt_state->exclude
+                                                 : opt_state->include;
+    }
+
   SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
   SVN_ERR(get_dump_range(&lower, &upper, repos, opt_state, pool));
 
+  /* Progress feedback goes to STDERR, unless they asked to suppress it. */
+  if (! opt_state->quiet)
+    feedback_stream = recode_stream_create(stderr, pool);
+
+  if (opt_state->segments_dir)
+    return svn_error_trace(svn_repos_dump_fs_segments(
+                             repos, opt_state->segments_dir, lower, upper,
+                             opt_state->incremental, opt_state->use_deltas,
+                             TRUE, TRUE, filter_func, &filter_baton,
+                             opt_state->jobs,
+                             !opt_state->quiet ? repos_notify_handler : NULL,
+                             feedback_stream, check_cancel, NULL, pool));
+
   /* Open the file or STDOUT, depending on whether -F was specified. */
   if (opt_state->file)
     {
@@ -1278,13 +1398,9 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   else
     SVN_ERR(svn_stream_for_stdout(&out_stream, pool));
 
-  /* Progress feedback goes to STDERR, unless they asked to suppress it. */
-  if (! opt_state->quiet)
-    feedback_stream = recode_stream_create(stderr, pool);
-
   SVN_ERR(svn_repos_dump_fs4(repos, out_stream, lower, upper,
                              opt_state->incremental, opt_state->use_deltas,
-                             TRUE, TRUE,
+                             TRUE, TRUE, filter_func, &filter_baton,
                              !opt_state->quiet ? repos_notify_handler : NULL,
                              feedback_stream, check_cancel, NULL, pool));
 
@@ -1326,7 +1442,7 @@ subcommand_dump_revprops(apr_getopt_t *os, void *baton, apr_pool_t *pool)
     feedback_stream = recode_stream_create(stderr, pool);
 
   SVN_ERR(svn_repos_dump_fs4(repos, out_stream, lower, upper,
-                             FALSE, FALSE, TRUE, FALSE,
+                             FALSE, FALSE, TRUE, FALSE, NULL, NULL,
                              !opt_state->quiet ? repos_notify_handler : NULL,
                              feedback_stream, check_cancel, NULL, pool));
 
@@ -1521,27 +1637,52 @@ subcommand_load(apr_getopt_t *os, void *baton, apr_pool_t *pool)
      support a limited set of revision kinds: number and unspecified. */
   SVN_ERR(get_load_range(&lower, &upper, opt_state));
 
-  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+  if (opt_state->file && opt_state->segments_dir)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("--file (-F) and --segments "
+                              "are mutually exclusive"));
 
-  /* Open the file or STDIN, depending on whether -F was specified. */
-  if (opt_state->file)
-    SVN_ERR(svn_stream_open_readonly(&in_stream, opt_state->file,
-                                     pool, pool));
-  else
-    SVN_ERR(svn_stream_for_stdin2(&in_stream, TRUE, pool));
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
 
   /* Progress feedback goes to STDOUT, unless they asked to suppress it. */
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stdout, pool);
 
-  err = svn_repos_load_fs5(repos, in_stream, lower, upper,
-                           opt_state->uuid_action, opt_state->parent_dir,
-                           opt_state->use_pre_commit_hook,
-                           opt_state->use_post_commit_hook,
-                           !opt_state->bypass_prop_validation,
-                           opt_state->ignore_dates,
-                           opt_state->quiet ? NULL : repos_notify_handler,
-                           feedback_stream, check_cancel, NULL, pool);
+  if (opt_state->segments_dir)
+    {
+      err = svn_repos_load_fs_segments(repos, opt_state->segments_dir,
+                                       lower, upper,
+                                       opt_state->uuid_action,
+                                       opt_state->parent_dir,
+                                       opt_state->use_pre_commit_hook,
+                                       opt_state->use_post_commit_hook,
+                                       !opt_state->bypass_prop_validation,
+                                       opt_state->ignore_dates,
+                                       opt_state->jobs > 1,
+                                       opt_state->quiet
+                                         ? NULL : repos_notify_handler,
+                                       feedback_stream, check_cancel, NULL,
+                                       pool);
+    }
+  else
+    {
+      /* Open the file or STDIN, depending on whether -F was specified. */
+      if (opt_state->file)
+        SVN_ERR(svn_stream_open_readonly(&in_stream, opt_state->file,
+                                         pool, pool));
+      else
+        SVN_ERR(svn_stream_for_stdin2(&in_stream, TRUE, pool));
+
+      err = svn_repos_load_fs6(repos, in_stream, lower, upper,
+                               opt_state->uuid_action, opt_state->parent_dir,
+                               opt_state->use_pre_commit_hook,
+                               opt_state->use_post_commit_hook,
+                               !opt_state->bypass_prop_validation,
+                               opt_state->ignore_dates,
+                               opt_state->jobs > 1,
+                               opt_state->quiet ? NULL : repos_notify_handler,
+                               feedback_stream, check_cancel, NULL, pool);
+    }
   if (err && err->apr_err == SVN_ERR_BAD_PROPERTY_VALUE)
     return svn_error_quick_wrap(err,
                                 _("Invalid property value found in "
@@ -2050,9 +2191,10 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
     apr_array_make(pool, 0, sizeof(struct verification_error *));
   verify_baton.result_pool = pool;
 
-  SVN_ERR(svn_repos_verify_fs3(repos, lower, upper,
+  SVN_ERR(svn_repos_verify_fs4(repos, lower, upper,
                                opt_state->check_normalization,
                                opt_state->metadata_only,
+                               opt_state->jobs,
                                !opt_state->quiet
                                  ? repos_notify_handler : NULL,
                                feedback_stream,
@@ -2149,8 +2291,9 @@ subcommand_hotcopy(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stdout, pool);
 
-  return svn_repos_hotcopy3(opt_state->repository_path, new_repos_path,
+  return svn_repos_hotcopy4(opt_state->repository_path, new_repos_path,
                             opt_state->clean_logs, opt_state->incremental,
+                            opt_state->jobs,
                             !opt_state->quiet ? repos_notify_handler : NULL,
                             feedback_stream, check_cancel, NULL, pool);
 }
@@ -2690,6 +2833,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -2834,9 +2978,36 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__metadata_only:
         opt_state.metadata_only = TRUE;
         break;
+      case svnadmin__jobs:
+        SVN_ERR(svn_cstring_atoi(&opt_state.jobs, opt_arg));
+        if (opt_state.jobs < 1)
+          return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                  _("The number of jobs must be at least 1"));
+        break;
       case svnadmin__fs_type:
         SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.fs_type, opt_arg, pool));
         break;
+      case svnadmin__segments:
+        SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.segments_dir, opt_arg,
+                                        pool));
+        opt_state.segments_dir
+          = svn_dirent_internal_style(opt_state.segments_dir, pool);
+        break;
+      case svnadmin__include:
+      case svnadmin__exclude:
+        {
+          apr_array_header_t **prefixes = opt_id == svnadmin__include
+                                        ? &opt_state.include
+                                        : &opt_state.exclude;
+          const char *prefix;
+
+          SVN_ERR(svn_utf_cstring_to_utf8(&prefix, opt_arg, pool));
+          if (! *prefixes)
+            *prefixes = apr_array_make(pool, 1, sizeof(const char *));
+          APR_ARRAY_PUSH(*prefixes, const char *)
+            = svn_fspath__canonicalize(prefix, pool);
+        }
+        break;
       case svnadmin__parent_dir:
         SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.parent_dir, opt_arg,
                                             pool));
@@ -3011,7 +3182,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     svn_cache_config_t settings = *svn_cache_config_get();
 
     settings.cache_size = opt_state.memory_cache_size;
-    settings.single_threaded = TRUE;
+    /* 'pack' may use multiple threads as configured in the repository's
+     * fsfs.conf. */
+    settings.single_threaded =    opt_state.jobs <= 1
+                               && subcommand->cmd_func != subcommand_pack;
 
     svn_cache_config_set(&settings);
   }
@@ -96,6 +96,10 @@ typedef struct svn_cl__opt_state_t
   svn_boolean_t trust_server_cert_not_yet_valid;
   svn_boolean_t trust_server_cert_other_failure;
   apr_array_header_t* search_patterns; /* pattern arguments for --search */
+  const char *report_file;       /* synthetic working copy state */
+  int clients;                   /* number of concurrent sessions */
+  int duration;                  /* seconds to generate load for */
+  const char *ops_file;          /* operation mix to generate load with */
 } svn_cl__opt_state_t;
 
 
@@ -110,10 +114,13 @@ typedef struct svn_cl__cmd_baton_t
 svn_opt_subcommand_t
   svn_cl__help,
   svn_cl__null_blame,
+  svn_cl__null_checkout,
   svn_cl__null_export,
   svn_cl__null_list,
+  svn_cl__null_load,
   svn_cl__null_log,
-  svn_cl__null_info;
+  svn_cl__null_info,
+  svn_cl__null_update;
 
 
 /* See definition in main.c for documentation. */
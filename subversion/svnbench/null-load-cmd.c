@@ -0,0 +1,662 @@
+/*
+ * null-load-cmd.c -- Subversion benchmark load generation command
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include <string.h>
+#include <apr_time.h>
+
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#endif
+
+#include "svn_client.h"
+#include "svn_cmdline.h"
+#include "svn_config.h"
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_hash.h"
+#include "svn_path.h"
+#include "svn_pools.h"
+#include "svn_ra.h"
+#include "svn_string.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_string_private.h"
+
+/*** Latency histograms. ***/
+
+/* Number of sub-buckets per power of two.  Latencies get recorded with
+ * a relative precision of 1 / SUB_BUCKETS. */
+#define SUB_BUCKET_BITS 3
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+
+/* Enough buckets for latencies of up to 2^42 microseconds. */
+#define BUCKET_COUNT (40 * SUB_BUCKETS)
+
+/* Log-linear histogram of operation latencies in microseconds. */
+typedef struct histogram_t
+{
+  apr_uint64_t buckets[BUCKET_COUNT];
+  apr_uint64_t count;
+  apr_uint64_t errors;
+  apr_time_t max;
+} histogram_t;
+
+/* Return the index of the bucket in which to count LATENCY. */
+static int
+bucket_index(apr_time_t latency)
+{
+  apr_uint64_t value = latency > 0 ? (apr_uint64_t)latency : 0;
+  int msb = 0;
+  int index;
+
+  if (value < SUB_BUCKETS)
+    return (int)value;
+
+  while (value >> (msb + 1))
+    ++msb;
+
+  index = (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS
+        + (int)((value >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+
+  return index < BUCKET_COUNT ? index : BUCKET_COUNT - 1;
+}
+
+/* Return the smallest latency that would be counted in bucket INDEX. */
+static apr_time_t
+bucket_value(int index)
+{
+  int shift;
+
+  if (index < SUB_BUCKETS)
+    return index;
+
+  shift = index / SUB_BUCKETS - 1;
+  return (apr_time_t)(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+}
+
+/* Count an operation with LATENCY in HISTOGRAM. */
+static void
+histogram_add(histogram_t *histogram,
+              apr_time_t latency)
+{
+  histogram->buckets[bucket_index(latency)]++;
+  histogram->count++;
+  if (latency > histogram->max)
+    histogram->max = latency;
+}
+
+/* Add all values counted in SOURCE to TARGET. */
+static void
+histogram_merge(histogram_t *target,
+                const histogram_t *source)
+{
+  int i;
+  for (i = 0; i < BUCKET_COUNT; ++i)
+    target->buckets[i] += source->buckets[i];
+
+  target->count += source->count;
+  target->errors += source->errors;
+  if (source->max > target->max)
+    target->max = source->max;
+}
+
+/* Return the latency below which PERMILLE per mill of the operations
+ * in HISTOGRAM completed. */
+static apr_time_t
+histogram_percentile(const histogram_t *histogram,
+                     int permille)
+{
+  apr_uint64_t threshold = (histogram->count * permille + 999) / 1000;
+  apr_uint64_t seen = 0;
+  int i;
+
+  for (i = 0; i < BUCKET_COUNT; ++i)
+    {
+      seen += histogram->buckets[i];
+      if (seen >= threshold && seen > 0)
+        return bucket_value(i);
+    }
+
+  return histogram->max;
+}
+
+/*** The operation mix. ***/
+
+/* The operations that may be part of the mix. */
+typedef enum op_kind_t
+{
+  op_stat,
+  op_list,
+  op_cat,
+  op_log,
+  op_checkout
+} op_kind_t;
+
+/* Names of the op_kind_t values, as used in the mix file. */
+static const char *op_names[] =
+  { "stat", "list", "cat", "log", "checkout" };
+
+/* Number of elements in OP_NAMES. */
+#define OP_NAME_COUNT ((int)(sizeof(op_names) / sizeof(op_names[0])))
+
+/* One line of the operation mix. */
+typedef struct op_t
+{
+  op_kind_t kind;
+
+  /* Relative to the target URL. */
+  const char *path;
+
+  /* Relative frequency of this operation. */
+  int weight;
+
+  /* The line as given in the mix, for the statistics. */
+  const char *label;
+} op_t;
+
+/* Read the operation mix from OPS_FILE into *OPS (op_t *) and return the
+ * sum of all weights in *TOTAL_WEIGHT.  If OPS_FILE is NULL, use a mix
+ * consisting of a stat of the target URL only.
+ *
+ * Each line in OPS_FILE reads "WEIGHT OPERATION [PATH]", where OPERATION
+ * is one of OP_NAMES.  Empty lines and lines starting with '#' are
+ * ignored.  Allocate the result in POOL. */
+static svn_error_t *
+read_ops(apr_array_header_t **ops,
+         int *total_weight,
+         const char *ops_file,
+         apr_pool_t *pool)
+{
+  svn_stringbuf_t *buffer;
+  apr_array_header_t *lines;
+  int i;
+
+  *ops = apr_array_make(pool, 8, sizeof(op_t));
+  *total_weight = 0;
+
+  if (ops_file == NULL)
+    {
+      op_t *op = apr_array_push(*ops);
+      op->kind = op_stat;
+      op->path = "";
+      op->weight = 1;
+      op->label = op_names[op_stat];
+      *total_weight = 1;
+
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_stringbuf_from_file2(&buffer, ops_file, pool));
+  lines = svn_cstring_split(buffer->data, "\n\r", TRUE, pool);
+
+  for (i = 0; i < lines->nelts; ++i)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      apr_array_header_t *fields;
+      op_t op = { 0 };
+      int k;
+
+      if (line[0] == '\0' || line[0] == '#')
+        continue;
+
+      fields = svn_cstring_split(line, " \t", TRUE, pool);
+      if (fields->nelts < 2 || fields->nelts > 3)
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("Invalid operation in line %d of '%s'"),
+                                 i + 1, ops_file);
+
+      SVN_ERR(svn_cstring_atoi(&op.weight,
+                               APR_ARRAY_IDX(fields, 0, const char *)));
+      if (op.weight <= 0)
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("Invalid weight in line %d of '%s'"),
+                                 i + 1, ops_file);
+
+      for (k = 0; k < OP_NAME_COUNT; ++k)
+        if (strcmp(op_names[k], APR_ARRAY_IDX(fields, 1, const char *)) == 0)
+          break;
+
+      if (k == OP_NAME_COUNT)
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("Unknown operation '%s' in line %d "
+                                   "of '%s'"),
+                                 APR_ARRAY_IDX(fields, 1, const char *),
+                                 i + 1, ops_file);
+
+      op.kind = k;
+      op.path = fields->nelts == 3
+              ? svn_relpath_canonicalize(APR_ARRAY_IDX(fields, 2,
+                                                       const char *),
+                                         pool)
+              : "";
+      op.label = *op.path
+               ? apr_pstrcat(pool, op_names[k], " ", op.path, SVN_VA_NULL)
+               : op_names[k];
+
+      APR_ARRAY_PUSH(*ops, op_t) = op;
+      *total_weight += op.weight;
+    }
+
+  if ((*ops)->nelts == 0)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("'%s' does not contain any operation"),
+                             ops_file);
+
+  return SVN_NO_ERROR;
+}
+
+/*** The simulated clients. ***/
+
+/* State of one simulated client. */
+typedef struct client_t
+{
+  /* Shared between all clients.  Read-only. */
+  svn_cl__opt_state_t *opt_state;
+  const char *url;
+  const apr_array_header_t *ops;
+  int total_weight;
+  apr_time_t deadline;
+
+  /* Private copy of the configuration. */
+  apr_hash_t *config;
+
+  /* State of the pseudo-random number generator.  Never 0. */
+  apr_uint32_t random;
+
+  /* One histogram per element in OPS. */
+  histogram_t *histograms;
+
+  /* Error that terminated this client. */
+  svn_error_t *err;
+} client_t;
+
+/* Return the next pseudo-random number of CLIENT. */
+static apr_uint32_t
+next_random(client_t *client)
+{
+  /* xorshift32 */
+  apr_uint32_t x = client->random;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  client->random = x;
+
+  return x;
+}
+
+/* Implements svn_log_entry_receiver_t, discarding all entries. */
+static svn_error_t *
+null_log_receiver(void *baton,
+                  svn_log_entry_t *log_entry,
+                  apr_pool_t *pool)
+{
+  return SVN_NO_ERROR;
+}
+
+/* Execute OP on SESSION, which is open at URL.  Use POOL for all
+ * allocations. */
+static svn_error_t *
+run_op(svn_ra_session_t *session,
+       const char *url,
+       const op_t *op,
+       apr_pool_t *pool)
+{
+  switch (op->kind)
+    {
+      case op_stat:
+        {
+          svn_dirent_t *dirent;
+          SVN_ERR(svn_ra_stat(session, op->path, SVN_INVALID_REVNUM,
+                              &dirent, pool));
+          break;
+        }
+
+      case op_list:
+        {
+          apr_hash_t *dirents;
+          SVN_ERR(svn_ra_get_dir2(session, &dirents, NULL, NULL, op->path,
+                                  SVN_INVALID_REVNUM, SVN_DIRENT_ALL, pool));
+          break;
+        }
+
+      case op_cat:
+        SVN_ERR(svn_ra_get_file(session, op->path, SVN_INVALID_REVNUM,
+                                svn_stream_empty(pool), NULL, NULL, pool));
+        break;
+
+      case op_log:
+        {
+          apr_array_header_t *paths = apr_array_make(pool, 1,
+                                                     sizeof(const char *));
+          APR_ARRAY_PUSH(paths, const char *) = op->path;
+          SVN_ERR(svn_ra_get_log2(session, paths, SVN_INVALID_REVNUM, 0,
+                                  100, FALSE, FALSE, FALSE, NULL,
+                                  null_log_receiver, NULL, pool));
+          break;
+        }
+
+      case op_checkout:
+        {
+          const svn_ra_reporter3_t *reporter;
+          void *report_baton;
+          svn_revnum_t revision;
+
+          SVN_ERR(svn_ra_reparent(session,
+                                  svn_path_url_add_component2(url, op->path,
+                                                              pool),
+                                  pool));
+          SVN_ERR(svn_ra_get_latest_revnum(session, &revision, pool));
+          SVN_ERR(svn_ra_do_update3(session, &reporter, &report_baton,
+                                    revision, "", svn_depth_infinity,
+                                    FALSE, FALSE,
+                                    svn_delta_default_editor(pool), NULL,
+                                    pool, pool));
+          SVN_ERR(reporter->set_path(report_baton, "", revision,
+                                     svn_depth_infinity, TRUE, NULL, pool));
+          SVN_ERR(reporter->finish_report(report_baton, pool));
+          SVN_ERR(svn_ra_reparent(session, url, pool));
+          break;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Connect to CLIENT->URL and execute random operations from CLIENT->OPS
+ * until CLIENT->DEADLINE.  Use POOL for all allocations. */
+static svn_error_t *
+run_client(client_t *client,
+           apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = client->opt_state;
+  svn_client_ctx_t *ctx;
+  svn_ra_session_t *session;
+  apr_pool_t *session_pool = svn_pool_create(pool);
+  apr_pool_t *iterpool;
+
+  /* Each client needs its own context as neither the auth baton nor the
+     configuration may be used by multiple threads. */
+  SVN_ERR(svn_client_create_context2(&ctx, client->config, pool));
+  ctx->cancel_func = svn_cl__check_cancel;
+  SVN_ERR(svn_cmdline_create_auth_baton2(
+            &ctx->auth_baton,
+            TRUE /* non_interactive */,
+            opt_state->auth_username,
+            opt_state->auth_password,
+            opt_state->config_dir,
+            opt_state->no_auth_cache,
+            opt_state->trust_server_cert_unknown_ca,
+            opt_state->trust_server_cert_cn_mismatch,
+            opt_state->trust_server_cert_expired,
+            opt_state->trust_server_cert_not_yet_valid,
+            opt_state->trust_server_cert_other_failure,
+            svn_hash_gets(client->config, SVN_CONFIG_CATEGORY_CONFIG),
+            ctx->cancel_func,
+            ctx->cancel_baton,
+            pool));
+
+  SVN_ERR(svn_client_open_ra_session2(&session, client->url, NULL, ctx,
+                                      session_pool, session_pool));
+
+  iterpool = svn_pool_create(pool);
+  while (apr_time_now() < client->deadline)
+    {
+      apr_uint32_t pick = next_random(client) % client->total_weight;
+      apr_time_t start;
+      svn_error_t *err;
+      int i;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_cl__check_cancel(NULL));
+
+      for (i = 0; i + 1 < client->ops->nelts; ++i)
+        {
+          apr_uint32_t weight = APR_ARRAY_IDX(client->ops, i, op_t).weight;
+          if (pick < weight)
+            break;
+
+          pick -= weight;
+        }
+
+      start = apr_time_now();
+      err = run_op(session, client->url,
+                   &APR_ARRAY_IDX(client->ops, i, op_t), iterpool);
+      if (err)
+        {
+          /* Keep going.  The error count is part of the statistics. */
+          client->histograms[i].errors++;
+          svn_error_clear(err);
+
+          /* The session may be in an undefined state now. */
+          svn_pool_clear(session_pool);
+          SVN_ERR(svn_client_open_ra_session2(&session, client->url, NULL,
+                                              ctx, session_pool,
+                                              session_pool));
+        }
+      else
+        histogram_add(&client->histograms[i], apr_time_now() - start);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+/* Thread function running the client_t given as DATA. */
+static void * APR_THREAD_FUNC
+client_thread(apr_thread_t *tid, void *data)
+{
+  client_t *client = data;
+  apr_pool_t *pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  client->err = run_client(client, pool);
+  svn_pool_destroy(pool);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+#endif
+
+/* Format LATENCY in milliseconds, allocated in POOL. */
+static const char *
+format_ms(apr_time_t latency,
+          apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "%.3f", latency / 1000.0);
+}
+
+/* Print the statistics in HISTOGRAMS for OPS, collected over ELAPSED
+ * microseconds.  Use POOL for temporary allocations. */
+static svn_error_t *
+print_statistics(const apr_array_header_t *ops,
+                 const histogram_t *histograms,
+                 apr_time_t elapsed,
+                 apr_pool_t *pool)
+{
+  histogram_t *total = apr_pcalloc(pool, sizeof(*total));
+  double seconds = elapsed > 0 ? elapsed / 1.0e6 : 1.0;
+  int i;
+
+  SVN_ERR(svn_cmdline_printf(pool,
+                             "%10s %10s %10s %10s %10s %10s %8s  %s\n",
+                             _("count"), _("ops/s"), _("p50 ms"),
+                             _("p99 ms"), _("p99.9 ms"), _("max ms"),
+                             _("errors"), _("operation")));
+
+  for (i = 0; i <= ops->nelts; ++i)
+    {
+      const histogram_t *histogram = i < ops->nelts ? &histograms[i] : total;
+      const char *label = i < ops->nelts
+                        ? APR_ARRAY_IDX(ops, i, op_t).label
+                        : _("total");
+
+      SVN_ERR(svn_cmdline_printf(pool,
+                                 "%10s %10.1f %10s %10s %10s %10s %8s  %s\n",
+                                 svn__ui64toa_sep(histogram->count, ',',
+                                                  pool),
+                                 histogram->count / seconds,
+                                 format_ms(histogram_percentile(histogram,
+                                                                500),
+                                           pool),
+                                 format_ms(histogram_percentile(histogram,
+                                                                990),
+                                           pool),
+                                 format_ms(histogram_percentile(histogram,
+                                                                999),
+                                           pool),
+                                 format_ms(histogram->max, pool),
+                                 svn__ui64toa_sep(histogram->errors, ',',
+                                                  pool),
+                                 label));
+
+      if (i < ops->nelts)
+        histogram_merge(total, histogram);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/*** Code. ***/
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_load(apr_getopt_t *os,
+                  void *baton,
+                  apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  apr_array_header_t *targets;
+  apr_array_header_t *ops;
+  client_t *clients;
+  histogram_t *histograms;
+  int total_weight;
+  int client_count = opt_state->clients > 0 ? opt_state->clients : 1;
+  int duration = opt_state->duration > 0 ? opt_state->duration : 10;
+  const char *url;
+  apr_time_t start_time;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i, k;
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+
+  /* We want exactly 1 target for this subcommand. */
+  if (targets->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, 0, NULL);
+  if (targets->nelts > 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL);
+
+  url = APR_ARRAY_IDX(targets, 0, const char *);
+  if (! svn_path_is_url(url))
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("'%s' is not a URL"), url);
+
+#if !APR_HAS_THREADS
+  if (client_count > 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("--clients requires thread support"));
+#endif
+
+  SVN_ERR(read_ops(&ops, &total_weight, opt_state->ops_file, pool));
+
+  start_time = apr_time_now();
+  clients = apr_pcalloc(pool, client_count * sizeof(*clients));
+  for (i = 0; i < client_count; ++i)
+    {
+      clients[i].opt_state = opt_state;
+      clients[i].url = url;
+      clients[i].ops = ops;
+      clients[i].total_weight = total_weight;
+      clients[i].deadline = start_time + apr_time_from_sec(duration);
+      clients[i].random = (apr_uint32_t)(start_time * (i + 1)) | 1;
+      clients[i].histograms = apr_pcalloc(pool, ops->nelts
+                                                * sizeof(histogram_t));
+      if (ctx->config)
+        SVN_ERR(svn_config_copy_config(&clients[i].config, ctx->config,
+                                       pool));
+      else
+        clients[i].config = apr_hash_make(pool);
+    }
+
+#if APR_HAS_THREADS
+  {
+    apr_thread_t **threads = apr_pcalloc(pool,
+                                         client_count * sizeof(*threads));
+    apr_threadattr_t *attr;
+    apr_status_t status;
+
+    status = apr_threadattr_create(&attr, pool);
+    if (status)
+      return svn_error_wrap_apr(status, _("Can't create threadattr"));
+
+    for (i = 0; i < client_count; ++i)
+      {
+        status = apr_thread_create(&threads[i], attr, client_thread,
+                                   &clients[i], pool);
+        if (status)
+          {
+            err = svn_error_wrap_apr(status, _("Can't create thread"));
+            break;
+          }
+      }
+
+    /* Wait for all clients that we could start. */
+    for (k = 0; k < i; ++k)
+      {
+        apr_status_t thread_status;
+        status = apr_thread_join(&thread_status, threads[k]);
+        if (status && !err)
+          err = svn_error_wrap_apr(status, _("Can't join thread"));
+      }
+  }
+#else
+  clients[0].err = run_client(&clients[0], pool);
+#endif
+
+  for (i = 0; i < client_count; ++i)
+    err = svn_error_compose_create(err, clients[i].err);
+  SVN_ERR(err);
+
+  /* Combine the results of all clients. */
+  histograms = apr_pcalloc(pool, ops->nelts * sizeof(*histograms));
+  for (i = 0; i < client_count; ++i)
+    for (k = 0; k < ops->nelts; ++k)
+      histogram_merge(&histograms[k], &clients[i].histograms[k]);
+
+  if (!opt_state->quiet)
+    SVN_ERR(print_statistics(ops, histograms, apr_time_now() - start_time,
+                             pool));
+
+  return SVN_NO_ERROR;
+}
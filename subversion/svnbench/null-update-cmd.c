@@ -0,0 +1,468 @@
+/*
+ * null-update-cmd.c -- Subversion benchmark update / checkout commands
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include <string.h>
+#include <apr_time.h>
+
+#include "svn_client.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_path.h"
+#include "svn_pools.h"
+#include "svn_cmdline.h"
+#include "svn_string.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_string_private.h"
+#include "private/svn_client_private.h"
+
+/*** A counting editor that does not store anything. ***/
+
+typedef struct edit_baton_t
+{
+  apr_int64_t editor_calls;
+  apr_int64_t dir_count;
+  apr_int64_t file_count;
+  apr_int64_t delete_count;
+  apr_int64_t window_count;
+  apr_int64_t byte_count;
+  apr_int64_t prop_count;
+  apr_int64_t prop_byte_count;
+
+  /* Time of the first editor call, 0 if there was none yet. */
+  apr_time_t first_call;
+} edit_baton_t;
+
+/* Count one editor call in EB. */
+static void
+count_call(edit_baton_t *eb)
+{
+  if (eb->editor_calls++ == 0)
+    eb->first_call = apr_time_now();
+}
+
+static svn_error_t *
+set_target_revision(void *edit_baton,
+                    svn_revnum_t target_revision,
+                    apr_pool_t *pool)
+{
+  count_call(edit_baton);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_root(void *edit_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **root_baton)
+{
+  count_call(edit_baton);
+  *root_baton = edit_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+delete_entry(const char *path,
+             svn_revnum_t revision,
+             void *parent_baton,
+             apr_pool_t *pool)
+{
+  edit_baton_t *eb = parent_baton;
+  count_call(eb);
+  eb->delete_count++;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+add_directory(const char *path,
+              void *parent_baton,
+              const char *copyfrom_path,
+              svn_revnum_t copyfrom_revision,
+              apr_pool_t *pool,
+              void **baton)
+{
+  edit_baton_t *eb = parent_baton;
+  count_call(eb);
+  eb->dir_count++;
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_directory(const char *path,
+               void *parent_baton,
+               svn_revnum_t base_revision,
+               apr_pool_t *pool,
+               void **baton)
+{
+  count_call(parent_baton);
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+change_prop(void *baton,
+            const char *name,
+            const svn_string_t *value,
+            apr_pool_t *pool)
+{
+  edit_baton_t *eb = baton;
+  count_call(eb);
+  eb->prop_count++;
+  if (value)
+    eb->prop_byte_count += value->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+close_node(void *baton,
+           apr_pool_t *pool)
+{
+  count_call(baton);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+absent_node(const char *path,
+            void *parent_baton,
+            apr_pool_t *pool)
+{
+  count_call(parent_baton);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+add_file(const char *path,
+         void *parent_baton,
+         const char *copyfrom_path,
+         svn_revnum_t copyfrom_revision,
+         apr_pool_t *pool,
+         void **baton)
+{
+  edit_baton_t *eb = parent_baton;
+  count_call(eb);
+  eb->file_count++;
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_file(const char *path,
+          void *parent_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **baton)
+{
+  count_call(parent_baton);
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+window_handler(svn_txdelta_window_t *window, void *baton)
+{
+  edit_baton_t *eb = baton;
+  if (window != NULL)
+    {
+      eb->window_count++;
+      eb->byte_count += window->tview_len;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+apply_textdelta(void *file_baton,
+                const char *base_checksum,
+                apr_pool_t *pool,
+                svn_txdelta_window_handler_t *handler,
+                void **handler_baton)
+{
+  count_call(file_baton);
+
+  *handler_baton = file_baton;
+  *handler = window_handler;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+close_file(void *file_baton,
+           const char *text_checksum,
+           apr_pool_t *pool)
+{
+  count_call(file_baton);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+close_edit(void *edit_baton,
+           apr_pool_t *pool)
+{
+  count_call(edit_baton);
+  return SVN_NO_ERROR;
+}
+
+/* Return a new editor that counts all calls in its edit_baton_t,
+ * allocated in POOL. */
+static svn_delta_editor_t *
+get_counting_editor(apr_pool_t *pool)
+{
+  svn_delta_editor_t *editor = svn_delta_default_editor(pool);
+
+  editor->set_target_revision = set_target_revision;
+  editor->open_root = open_root;
+  editor->delete_entry = delete_entry;
+  editor->add_directory = add_directory;
+  editor->open_directory = open_directory;
+  editor->change_dir_prop = change_prop;
+  editor->close_directory = close_node;
+  editor->absent_directory = absent_node;
+  editor->add_file = add_file;
+  editor->open_file = open_file;
+  editor->apply_textdelta = apply_textdelta;
+  editor->change_file_prop = change_prop;
+  editor->close_file = close_file;
+  editor->absent_file = absent_node;
+  editor->close_edit = close_edit;
+
+  return editor;
+}
+
+/*** The synthetic report. ***/
+
+/* Describe the state of the fictitious working copy in REPORT_FILE, or
+ * an unmodified working copy at REVISION if that is NULL, to REPORTER
+ * with REPORT_BATON.  If START_EMPTY is set, report an empty working
+ * copy instead.
+ *
+ * Each line in REPORT_FILE is either "REV [PATH]" to report PATH at
+ * revision REV or "- PATH" to report PATH as missing.  PATH is relative
+ * to the target URL; a line without PATH refers to the target itself
+ * and must come first.  Empty lines and lines starting with '#' are
+ * ignored.  Use POOL for temporary allocations. */
+static svn_error_t *
+send_report(const svn_ra_reporter3_t *reporter,
+            void *report_baton,
+            const char *report_file,
+            svn_revnum_t revision,
+            svn_boolean_t start_empty,
+            apr_pool_t *pool)
+{
+  svn_stringbuf_t *buffer;
+  apr_array_header_t *lines;
+  apr_pool_t *iterpool;
+  svn_boolean_t root_reported = FALSE;
+  int i;
+
+  if (report_file == NULL)
+    return svn_error_trace(reporter->set_path(report_baton, "", revision,
+                                              svn_depth_infinity,
+                                              start_empty, NULL, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&buffer, report_file, pool));
+  lines = svn_cstring_split(buffer->data, "\n\r", TRUE, pool);
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < lines->nelts; ++i)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      const char *path;
+      char *rev_str;
+      apr_int64_t rev;
+
+      if (line[0] == '\0' || line[0] == '#')
+        continue;
+
+      svn_pool_clear(iterpool);
+
+      path = strchr(line, ' ');
+      rev_str = apr_pstrndup(iterpool, line,
+                             path ? path - line : strlen(line));
+      path = path ? svn_relpath_canonicalize(path + 1, iterpool) : "";
+
+      if (!root_reported && *path)
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("The first entry in '%s' must be for "
+                                   "the target itself"), report_file);
+      root_reported = TRUE;
+
+      if (strcmp(rev_str, "-") == 0)
+        {
+          SVN_ERR(reporter->delete_path(report_baton, path, iterpool));
+          continue;
+        }
+
+      SVN_ERR_W(svn_cstring_atoi64(&rev, rev_str),
+                apr_psprintf(iterpool,
+                             _("Invalid revision in line %d of '%s'"),
+                             i + 1, report_file));
+      SVN_ERR(reporter->set_path(report_baton, path, (svn_revnum_t)rev,
+                                 svn_depth_infinity, start_empty && !*path,
+                                 NULL, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  if (!root_reported)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("'%s' does not report any path"),
+                             report_file);
+
+  return SVN_NO_ERROR;
+}
+
+/*** Code. ***/
+
+/* Run an update of the single URL target in OS with a synthetic report
+ * and a counting editor, then print the statistics.  If START_EMPTY is
+ * set, report an empty working copy, i.e. run a checkout.  BATON is the
+ * svn_cl__cmd_baton_t.  Use POOL for allocations. */
+static svn_error_t *
+bench_null_update(apr_getopt_t *os,
+                  void *baton,
+                  svn_boolean_t start_empty,
+                  apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  apr_array_header_t *targets;
+  svn_opt_revision_t peg_revision;
+  const char *truefrom;
+  svn_client__pathrev_t *loc;
+  svn_ra_session_t *ra_session;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+  edit_baton_t eb = { 0 };
+  apr_time_t start_time, report_time, end_time;
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+
+  /* We want exactly 1 target for this subcommand. */
+  if (targets->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, 0, NULL);
+  if (targets->nelts > 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL);
+
+  /* Get the peg revision if present. */
+  SVN_ERR(svn_opt_parse_path(&peg_revision, &truefrom,
+                             APR_ARRAY_IDX(targets, 0, const char *),
+                             pool));
+  if (! svn_path_is_url(truefrom))
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("'%s' is not a URL"), truefrom);
+
+  if (peg_revision.kind == svn_opt_revision_unspecified)
+    peg_revision.kind = svn_opt_revision_head;
+
+  if (opt_state->depth == svn_depth_unknown)
+    opt_state->depth = svn_depth_infinity;
+
+  SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &loc, truefrom,
+                                            NULL, &peg_revision,
+                                            &opt_state->start_revision,
+                                            ctx, pool));
+
+  SVN_ERR(svn_delta_get_cancellation_editor(ctx->cancel_func,
+                                            ctx->cancel_baton,
+                                            get_counting_editor(pool), &eb,
+                                            &editor, &edit_baton, pool));
+
+  start_time = apr_time_now();
+  SVN_ERR(svn_ra_do_update3(ra_session, &reporter, &report_baton,
+                            loc->rev, "", opt_state->depth,
+                            FALSE, /* don't want copyfrom-args */
+                            FALSE, /* don't want ignore_ancestry */
+                            editor, edit_baton, pool, pool));
+
+  SVN_ERR(send_report(reporter, report_baton, opt_state->report_file,
+                      loc->rev, start_empty, pool));
+  report_time = apr_time_now();
+
+  SVN_ERR(reporter->finish_report(report_baton, pool));
+  end_time = apr_time_now();
+
+  if (eb.first_call == 0)
+    eb.first_call = end_time;
+
+  if (!opt_state->quiet)
+    SVN_ERR(svn_cmdline_printf(pool,
+                               _("%15s editor calls\n"
+                                 "%15s directories added\n"
+                                 "%15s files added\n"
+                                 "%15s entries deleted\n"
+                                 "%15s delta windows\n"
+                                 "%15s bytes in files\n"
+                                 "%15s properties\n"
+                                 "%15s bytes in properties\n"
+                                 "%15.6f seconds to send the report\n"
+                                 "%15.6f seconds until the first edit\n"
+                                 "%15.6f seconds to receive the edit\n"),
+                               svn__ui64toa_sep(eb.editor_calls, ',', pool),
+                               svn__ui64toa_sep(eb.dir_count, ',', pool),
+                               svn__ui64toa_sep(eb.file_count, ',', pool),
+                               svn__ui64toa_sep(eb.delete_count, ',', pool),
+                               svn__ui64toa_sep(eb.window_count, ',', pool),
+                               svn__ui64toa_sep(eb.byte_count, ',', pool),
+                               svn__ui64toa_sep(eb.prop_count, ',', pool),
+                               svn__ui64toa_sep(eb.prop_byte_count, ',',
+                                                pool),
+                               (report_time - start_time) / 1.0e6,
+                               (eb.first_call - report_time) / 1.0e6,
+                               (end_time - eb.first_call) / 1.0e6));
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_update(apr_getopt_t *os,
+                    void *baton,
+                    apr_pool_t *pool)
+{
+  return svn_error_trace(bench_null_update(os, baton, FALSE, pool));
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_checkout(apr_getopt_t *os,
+                      void *baton,
+                      apr_pool_t *pool)
+{
+  return svn_error_trace(bench_null_update(os, baton, TRUE, pool));
+}
@@ -69,7 +69,11 @@ typedef enum svn_cl__longopt_t {
   opt_trust_server_cert,
   opt_trust_server_cert_failures,
   opt_changelist,
-  opt_search
+  opt_search,
+  opt_report_file,
+  opt_clients,
+  opt_duration,
+  opt_ops
 } svn_cl__longopt_t;
 
 
@@ -168,6 +172,16 @@ const apr_getopt_option_t svn_cl__options[] =
                        "history")},
   {"search", opt_search, 1,
                        N_("use ARG as search pattern (glob syntax)")},
+  {"report-file", opt_report_file, 1,
+                    N_("read the working copy state to report from\n"
+                       "                             "
+                       "file ARG")},
+  {"clients", opt_clients, 1,
+                    N_("run ARG concurrent client sessions")},
+  {"duration", opt_duration, 1,
+                    N_("generate load for ARG seconds")},
+  {"ops", opt_ops, 1,
+                    N_("read the operation mix from file ARG")},
 
   /* Long-opt Aliases
    *
@@ -230,6 +244,20 @@ const svn_opt_subcommand_desc2_t svn_cl__cmd_table[] =
      "  Write the annotated result to standard output.\n"),
     {'r', 'g'} },
 
+  { "null-checkout", svn_cl__null_checkout, {0}, N_
+    ("Run a checkout without creating a working copy.\n"
+     "usage: null-checkout [-r REV] URL[@PEGREV]\n"
+     "\n"
+     "  Receives the tree at URL, at revision REV if it is given, otherwise\n"
+     "  at HEAD, as a checkout would, but discards it.  Prints the number\n"
+     "  of editor calls, the amount of data received and how long sending\n"
+     "  the report, waiting for the server and receiving the edit took.\n"
+     "\n"
+     "  With --report-file, the target is still reported as empty but the\n"
+     "  other paths listed in that file as present.  See 'null-update' for\n"
+     "  the file format.\n"),
+    {'r', 'q', opt_depth, opt_report_file} },
+
   { "null-export", svn_cl__null_export, {0}, N_
     ("Create an unversioned copy of a tree.\n"
      "usage: null-export [-r REV] URL[@PEGREV]\n"
@@ -262,6 +290,22 @@ const svn_opt_subcommand_desc2_t svn_cl__cmd_table[] =
      "    Date and time of the last commit\n"),
     {'r', 'v', 'q', 'R', opt_depth, opt_search} },
 
+  { "null-load", svn_cl__null_load, {0}, N_
+    ("Put load on a repository server.\n"
+     "usage: null-load [--clients N] [--duration SECS] [--ops FILE] URL\n"
+     "\n"
+     "  Opens N sessions to URL (default: 1) and lets each of them execute\n"
+     "  a random sequence of operations for SECS seconds (default: 10).\n"
+     "  Prints the throughput and latency percentiles for each operation.\n"
+     "\n"
+     "  FILE describes the operation mix.  Each line in it reads\n"
+     "  'WEIGHT OPERATION [PATH]', with PATH relative to URL.  OPERATION is\n"
+     "  one of 'stat', 'list', 'cat', 'log' (the latest 100 revisions) or\n"
+     "  'checkout', each at HEAD.  Operations are picked with a probability\n"
+     "  proportional to their WEIGHT.  Lines starting with '#' are ignored.\n"
+     "  Without FILE, only 'stat' of URL will be executed.\n"),
+    {'q', opt_clients, opt_duration, opt_ops} },
+
   { "null-log", svn_cl__null_log, {0}, N_
     ("Fetch the log messages for a set of revision(s) and/or path(s).\n"
      "usage: 1. null-log [PATH][@REV]\n"
@@ -306,6 +350,22 @@ const svn_opt_subcommand_desc2_t svn_cl__cmd_table[] =
     {'r', 'R', opt_depth, opt_targets, opt_changelist}
   },
 
+  { "null-update", svn_cl__null_update, {0}, N_
+    ("Run an update without a working copy.\n"
+     "usage: null-update [-r REV] URL[@PEGREV]\n"
+     "\n"
+     "  Updates a fictitious working copy of URL to revision REV if it is\n"
+     "  given, otherwise to HEAD, and discards the changes received.\n"
+     "  Prints the same statistics as 'null-checkout'.\n"
+     "\n"
+     "  By default, the working copy is reported to be at the target\n"
+     "  revision already.  With --report-file, report the state given in\n"
+     "  that file instead.  Each line in it reads 'REV [PATH]' to report\n"
+     "  PATH at revision REV, or '- PATH' to report PATH as missing.  PATH\n"
+     "  is relative to URL.  The first line must omit PATH, reporting the\n"
+     "  revision of URL itself.  Lines starting with '#' are ignored.\n"),
+    {'r', 'q', opt_depth, opt_report_file} },
+
   { NULL, NULL, {0}, NULL, {0} }
 };
 
@@ -690,6 +750,28 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
                                  apr_pstrdup(pool, utf8_opt_arg),
                                  pool);
         break;
+      case opt_clients:
+        SVN_ERR(svn_cstring_atoi(&opt_state.clients, opt_arg));
+        if (opt_state.clients <= 0)
+          return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                  _("Argument to --clients must be "
+                                    "positive"));
+        break;
+      case opt_duration:
+        SVN_ERR(svn_cstring_atoi(&opt_state.duration, opt_arg));
+        if (opt_state.duration <= 0)
+          return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                  _("Argument to --duration must be "
+                                    "positive"));
+        break;
+      case opt_ops:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        opt_state.ops_file = svn_dirent_internal_style(utf8_opt_arg, pool);
+        break;
+      case opt_report_file:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        opt_state.report_file = svn_dirent_internal_style(utf8_opt_arg, pool);
+        break;
       default:
         /* Hmmm. Perhaps this would be a good place to squirrel away
            opts that commands like svn diff might need. Hmmm indeed. */
@@ -1025,6 +1025,31 @@ struct svndumpfilter_opt_state
 };
 
 
+/* Set *IN to a stream reading from STDIN, allocated in POOL.  If STDIN
+   has been redirected from a regular file, the stream will support
+   seeking, allowing the parser to skip over the contents of filtered
+   nodes instead of reading them. */
+static svn_error_t *
+open_input_stream(svn_stream_t **in,
+                  apr_pool_t *pool)
+{
+  apr_file_t *stdin_file;
+  apr_finfo_t finfo;
+  apr_status_t apr_err;
+
+  apr_err = apr_file_open_flags_stdin(&stdin_file, APR_BUFFERED, pool);
+  if (apr_err)
+    return svn_error_wrap_apr(apr_err, _("Can't open stdin"));
+
+  if (   apr_file_info_get(&finfo, APR_FINFO_TYPE, stdin_file) == APR_SUCCESS
+      && finfo.filetype == APR_REG)
+    *in = svn_stream_from_aprfile2(stdin_file, TRUE, pool);
+  else
+    SVN_ERR(svn_stream_for_stdin2(in, TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 parse_baton_initialize(struct parse_baton_t **pb,
                        struct svndumpfilter_opt_state *opt_state,
@@ -1034,7 +1059,7 @@ parse_baton_initialize(struct parse_baton_t **pb,
   struct parse_baton_t *baton = apr_palloc(pool, sizeof(*baton));
 
   /* Read the stream from STDIN.  Users can redirect a file. */
-  SVN_ERR(svn_stream_for_stdin2(&baton->in_stream, TRUE, pool));
+  SVN_ERR(open_input_stream(&baton->in_stream, pool));
 
   /* Have the parser dump results to STDOUT. Users can redirect a file. */
   SVN_ERR(svn_stream_for_stdout(&baton->out_stream, pool));
@@ -0,0 +1,389 @@
+/* access-map-cmd.c -- implements the access-map sub-command.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_dirent_uri.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
+#include "private/svn_fs_util.h"
+#include "private/svn_sorts_private.h"
+
+#include "svn_private_config.h"
+#include "svnfsfs.h"
+
+/* Number of blocks shown per line of a heat map. */
+#define BLOCKS_PER_LINE 64
+
+/* Item type names, indexed by SVN_FS_FS__ITEM_TYPE_* and
+ * SVN_FS_X__ITEM_TYPE_* values. */
+static const char *item_type_names[] =
+{
+  "none", "frep", "drep", "fprop", "dprop", "node", "chgs", "rep",
+  "chgs-cont", "node-cont", "reps-cont"
+};
+
+#define ITEM_TYPE_COUNT (sizeof(item_type_names) / sizeof(*item_type_names))
+
+/* Access counters for one item type. */
+typedef struct type_stats_t
+{
+  apr_uint64_t hits;
+  apr_uint64_t misses;
+  apr_uint64_t bytes_read;
+} type_stats_t;
+
+/* Reads from one rev or pack file. */
+typedef struct file_stats_t
+{
+  /* Whether this is a pack file. */
+  svn_boolean_t packed;
+
+  /* Shard number for pack files, revision for rev files. */
+  svn_revnum_t number;
+
+  /* Reads per block, as apr_uint64_t. */
+  apr_array_header_t *blocks;
+
+  /* Total number of reads and bytes read. */
+  apr_uint64_t reads;
+  apr_uint64_t bytes_read;
+
+  /* End of the previous read, -1 if not known. */
+  apr_off_t last_end;
+} file_stats_t;
+
+/* All statistics gathered from the access logs. */
+typedef struct map_t
+{
+  /* Block and shard size of the repository. */
+  apr_uint32_t block_size;
+  apr_uint32_t shard_size;
+
+  /* Counters per item type. */
+  type_stats_t types[ITEM_TYPE_COUNT];
+
+  /* file_stats_t *, keyed by file_key_t. */
+  apr_hash_t *files;
+
+  /* Reads with a known offset and how many of them started at most one
+   * block after the end of the previous read from the same file. */
+  apr_uint64_t located_reads;
+  apr_uint64_t sequential_reads;
+
+  apr_pool_t *pool;
+} map_t;
+
+/* Hash key identifying a rev or pack file. */
+typedef struct file_key_t
+{
+  svn_boolean_t packed;
+  svn_revnum_t number;
+} file_key_t;
+
+/* Return the entry for the file containing ACCESS in MAP. */
+static file_stats_t *
+get_file(map_t *map,
+         const svn_fs__access_t *access)
+{
+  file_key_t key = { 0 };
+  file_stats_t *file;
+
+  key.packed = access->packed;
+  key.number = access->packed && map->shard_size
+             ? access->revision / map->shard_size
+             : access->revision;
+
+  file = apr_hash_get(map->files, &key, sizeof(key));
+  if (!file)
+    {
+      file = apr_pcalloc(map->pool, sizeof(*file));
+      file->packed = key.packed;
+      file->number = key.number;
+      file->blocks = apr_array_make(map->pool, 16, sizeof(apr_uint64_t));
+      file->last_end = -1;
+
+      apr_hash_set(map->files, apr_pmemdup(map->pool, &key, sizeof(key)),
+                   sizeof(key), file);
+    }
+
+  return file;
+}
+
+/* Add ACCESS to the statistics in MAP. */
+static void
+add_access(map_t *map,
+           const svn_fs__access_t *access)
+{
+  type_stats_t *type
+    = &map->types[(apr_size_t)access->item_type < ITEM_TYPE_COUNT
+                  ? access->item_type
+                  : 0];
+  file_stats_t *file;
+  apr_off_t first, last, block;
+
+  if (access->cache_hit)
+    {
+      ++type->hits;
+      return;
+    }
+
+  ++type->misses;
+  type->bytes_read += access->size;
+
+  file = get_file(map, access);
+  ++file->reads;
+  file->bytes_read += access->size;
+
+  if (access->offset < 0)
+    return;
+
+  ++map->located_reads;
+  if (   file->last_end >= 0
+      && access->offset >= file->last_end
+      && access->offset - file->last_end <= map->block_size)
+    ++map->sequential_reads;
+  file->last_end = access->offset + access->size;
+
+  /* Count the read in all blocks it touches. */
+  first = access->offset / map->block_size;
+  last = (access->offset + MAX(access->size, 1) - 1) / map->block_size;
+  while (file->blocks->nelts <= last)
+    APR_ARRAY_PUSH(file->blocks, apr_uint64_t) = 0;
+
+  for (block = first; block <= last; ++block)
+    ++APR_ARRAY_IDX(file->blocks, block, apr_uint64_t);
+}
+
+/* Read the access log at PATH and add its contents to MAP. */
+static svn_error_t *
+read_log(map_t *map,
+         const char *path,
+         apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *accesses;
+  apr_uint32_t block_size, shard_size;
+  int i;
+
+  SVN_ERR(svn_fs__access_log_read(&accesses, &block_size, &shard_size,
+                                  path, scratch_pool, scratch_pool));
+
+  if (map->block_size == 0)
+    {
+      map->block_size = block_size ? block_size : 0x1000;
+      map->shard_size = shard_size;
+    }
+  else if (map->block_size != block_size || map->shard_size != shard_size)
+    {
+      return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                               _("Access log '%s' belongs to a differently "
+                                 "configured repository"),
+                               svn_dirent_local_style(path, scratch_pool));
+    }
+
+  for (i = 0; i < accesses->nelts; ++i)
+    add_access(map, &APR_ARRAY_IDX(accesses, i, svn_fs__access_t));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the number of significant bits in VALUE. */
+static int
+bit_count(apr_uint64_t value)
+{
+  int bits = 0;
+  for (; value; value >>= 1)
+    ++bits;
+
+  return bits;
+}
+
+/* Return the heat map character for a block read COUNT times, if the
+ * hottest block has been read in a number with MAX_BITS bits. */
+static char
+heat_char(apr_uint64_t count,
+          int max_bits)
+{
+  static const char levels[] = " .:-=+*#%@";
+  int bits = bit_count(count);
+
+  if (bits == 0)
+    return levels[0];
+
+  return levels[1 + (max_bits > 1 ? (bits - 1) * 8 / (max_bits - 1) : 8)];
+}
+
+/* Sort file_stats_t * by kind and number. */
+static int
+compare_files(const void *lhs,
+              const void *rhs)
+{
+  const file_stats_t *lhs_file = *(const file_stats_t * const *)lhs;
+  const file_stats_t *rhs_file = *(const file_stats_t * const *)rhs;
+
+  if (lhs_file->packed != rhs_file->packed)
+    return lhs_file->packed ? -1 : 1;
+
+  return lhs_file->number < rhs_file->number
+       ? -1
+       : (lhs_file->number > rhs_file->number ? 1 : 0);
+}
+
+/* Print the statistics per item type in MAP. */
+static void
+print_summary(const map_t *map)
+{
+  apr_size_t i;
+
+  printf(_("\nAccesses by item type:\n"));
+  printf(_("%10s %12s %12s %7s %14s\n"),
+         _("type"), _("hits"), _("reads"), _("hit %"), _("bytes read"));
+  for (i = 0; i < ITEM_TYPE_COUNT; ++i)
+    {
+      const type_stats_t *type = &map->types[i];
+      apr_uint64_t total = type->hits + type->misses;
+      if (total == 0)
+        continue;
+
+      printf("%10s %12" APR_UINT64_T_FMT " %12" APR_UINT64_T_FMT
+             " %6.1f%% %14" APR_UINT64_T_FMT "\n",
+             item_type_names[i], type->hits, type->misses,
+             100.0 * type->hits / total, type->bytes_read);
+    }
+
+  if (map->located_reads)
+    printf(_("\n%.1f%% of %" APR_UINT64_T_FMT " reads started within one "
+             "block after the previous read from the same file.\n"),
+           100.0 * map->sequential_reads / map->located_reads,
+           map->located_reads);
+}
+
+/* Print the heat map of FILE, whose hottest block has been read in a
+ * number with MAX_BITS bits, to the console.  Use BLOCK_SIZE and
+ * SHARD_SIZE to describe the file. */
+static void
+print_file(const file_stats_t *file,
+           apr_uint32_t block_size,
+           apr_uint32_t shard_size,
+           int max_bits)
+{
+  char line[BLOCKS_PER_LINE + 1];
+  int i;
+
+  if (file->packed && shard_size)
+    printf(_("\npack %ld (r%ld - r%ld): "),
+           file->number, file->number * (long)shard_size,
+           (file->number + 1) * (long)shard_size - 1);
+  else
+    printf(_("\nrev %ld: "), file->number);
+
+  printf(_("%" APR_UINT64_T_FMT " reads, %" APR_UINT64_T_FMT " bytes\n"),
+         file->reads, file->bytes_read);
+
+  for (i = 0; i < file->blocks->nelts; i += BLOCKS_PER_LINE)
+    {
+      int k;
+      int count = MIN(BLOCKS_PER_LINE, file->blocks->nelts - i);
+
+      for (k = 0; k < count; ++k)
+        line[k] = heat_char(APR_ARRAY_IDX(file->blocks, i + k, apr_uint64_t),
+                            max_bits);
+      line[count] = '\0';
+
+      printf("%12" APR_UINT64_T_HEX_FMT " |%s|\n",
+             (apr_uint64_t)i * block_size, line);
+    }
+}
+
+/* Print heat maps for all files in MAP.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static void
+print_heat_maps(const map_t *map,
+                apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *files = apr_array_make(scratch_pool,
+                                             apr_hash_count(map->files),
+                                             sizeof(file_stats_t *));
+  apr_hash_index_t *hi;
+  apr_uint64_t max_reads = 0;
+  int max_bits;
+  int i;
+
+  for (hi = apr_hash_first(scratch_pool, map->files); hi;
+       hi = apr_hash_next(hi))
+    {
+      file_stats_t *file = apr_hash_this_val(hi);
+      APR_ARRAY_PUSH(files, file_stats_t *) = file;
+
+      for (i = 0; i < file->blocks->nelts; ++i)
+        max_reads = MAX(max_reads,
+                        APR_ARRAY_IDX(file->blocks, i, apr_uint64_t));
+    }
+
+  svn_sort__array(files, compare_files);
+  max_bits = bit_count(max_reads);
+
+  printf(_("\nReads per %u byte block, from ' ' (none) over '.' (1) "
+           "to '@' (%" APR_UINT64_T_FMT "):\n"),
+         map->block_size, max_reads);
+
+  for (i = 0; i < files->nelts; ++i)
+    print_file(APR_ARRAY_IDX(files, i, file_stats_t *), map->block_size,
+               map->shard_size, max_bits);
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+svn_error_t *
+subcommand__access_map(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  svnfsfs__opt_state *opt_state = baton;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  map_t map = { 0 };
+  apr_array_header_t *logs;
+  int i;
+
+  map.files = apr_hash_make(pool);
+  map.pool = pool;
+
+  /* Default to the log location suggested in fsfs.conf. */
+  SVN_ERR(svn_opt_parse_all_args(&logs, os, pool));
+  if (logs->nelts == 0)
+    APR_ARRAY_PUSH(logs, const char *)
+      = svn_dirent_join_many(pool, opt_state->repository_path, "db",
+                             "access.log", SVN_VA_NULL);
+
+  for (i = 0; i < logs->nelts; ++i)
+    {
+      const char *path = APR_ARRAY_IDX(logs, i, const char *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_cancel(NULL));
+      SVN_ERR(read_log(&map, svn_dirent_internal_style(path, iterpool),
+                       iterpool));
+    }
+
+  print_summary(&map);
+  print_heat_maps(&map, iterpool);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
@@ -505,7 +505,8 @@ subcommand__stats(apr_getopt_t *os, void *baton, apr_pool_t *pool)
 
   printf("Reading revisions\n");
   SVN_ERR(open_fs(&fs, opt_state->repository_path, pool));
-  SVN_ERR(svn_fs_fs__get_stats(&stats, fs, print_progress, NULL,
+  SVN_ERR(svn_fs_fs__get_stats(&stats, fs, opt_state->jobs,
+                               opt_state->cache_dir, print_progress, NULL,
                                check_cancel, NULL, pool, pool));
 
   print_stats(stats, pool);
@@ -76,7 +76,9 @@ check_lib_versions(void)
 
 enum svnfsfs__cmdline_options_t
   {
-    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID
+    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID,
+    svnfsfs__jobs,
+    svnfsfs__cache_dir
   };
 
 /* Option codes and descriptions.
@@ -104,6 +106,13 @@ static const apr_getopt_option_t options_table[] =
      N_("size of the extra in-memory cache in MB used to\n"
         "                             minimize redundant operations. Default: 16.")},
 
+    {"jobs",          svnfsfs__jobs, 1,
+     N_("read up to ARG shards in parallel (default: 1)")},
+
+    {"cache-dir",     svnfsfs__cache_dir, 1,
+     N_("keep per-shard results in directory ARG and\n"
+        "                             reuse them for unchanged pack files")},
+
     {NULL}
   };
 
@@ -118,6 +127,15 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
     "Describe the usage of this program or its subcommands.\n"),
    {0} },
 
+  {"access-map", subcommand__access_map, {0}, N_
+   ("usage: svnfsfs access-map REPOS_PATH [LOG_FILE...]\n\n"
+    "Evaluate the access logs written by the repository if the access-log\n"
+    "option has been set in fsfs.conf.  LOG_FILE defaults to db/access.log\n"
+    "within the repository.  Print the number of cache hits and disk reads per\n"
+    "item type, followed by a heat map of the disk reads per block for each\n"
+    "revision and pack file.\n"),
+   {0} },
+
   {"dump-index", subcommand__dump_index, {0}, N_
    ("usage: svnfsfs dump-index REPOS_PATH -r REV\n\n"
     "Dump the index contents for the revision / pack file containing revision REV\n"
@@ -155,7 +173,7 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
   {"stats", subcommand__stats, {0}, N_
    ("usage: svnfsfs stats REPOS_PATH\n\n"
     "Write object size statistics to console.\n"),
-   {'M'} },
+   {'M', svnfsfs__jobs, svnfsfs__cache_dir} },
 
   { NULL, NULL, {0}, NULL, {0} }
 };
@@ -247,6 +265,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -311,6 +330,16 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnfsfs__version:
         opt_state.version = TRUE;
         break;
+      case svnfsfs__jobs:
+        SVN_ERR(svn_cstring_atoi(&opt_state.jobs, opt_arg));
+        if (opt_state.jobs < 1)
+          return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                  _("The number of jobs must be at least 1"));
+        break;
+      case svnfsfs__cache_dir:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        opt_state.cache_dir = svn_dirent_internal_style(utf8_opt_arg, pool);
+        break;
       default:
         {
           SVN_ERR(subcommand__help(NULL, NULL, pool));
@@ -437,7 +466,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     svn_cache_config_t settings = *svn_cache_config_get();
 
     settings.cache_size = opt_state.memory_cache_size;
-    settings.single_threaded = TRUE;
+    settings.single_threaded = opt_state.jobs <= 1;
 
     svn_cache_config_set(&settings);
   }
@@ -28,6 +28,9 @@
 #include <apr_pools.h>
 #include <apr_time.h>
 #include <apr_file_io.h>
+#include <apr_strings.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
 
 #define APR_WANT_STDIO
 #define APR_WANT_STRFUNC
@@ -70,6 +73,7 @@
 
 static svn_opt_subcommand_t
   subcommand_author,
+  subcommand_batch,
   subcommand_cat,
   subcommand_changed,
   subcommand_date,
@@ -103,7 +107,8 @@ enum
     svnlook__properties_only,
     svnlook__diff_cmd,
     svnlook__show_inherited_props,
-    svnlook__no_newline
+    svnlook__no_newline,
+    svnlook__jobs
   };
 
 /*
@@ -126,6 +131,11 @@ static const apr_getopt_option_t options_table[] =
   {"help",              'h', 0,
    N_("show help on a subcommand")},
 
+  {"jobs",              svnlook__jobs, 1,
+   N_("compute up to ARG file diffs in parallel\n"
+      "                             "
+      "(internal diff only, default: 1)")},
+
   {"limit",             'l', 1,
    N_("maximum number of history entries")},
 
@@ -219,6 +229,20 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
       "Print the author.\n"),
    {'r', 't'} },
 
+  {"batch", subcommand_batch, {0},
+   N_("usage: svnlook batch REPOS_PATH\n\n"
+      "Read svnlook commands from stdin, one per line, and run them all\n"
+      "against the same open repository.  Each line consists of a\n"
+      "subcommand followed by its options and arguments but without the\n"
+      "REPOS_PATH, e.g. 'changed -t 42-1' or 'cat -t 42-1 trunk/README'.\n"
+      "Arguments containing spaces may be quoted.\n"
+      "\n"
+      "After the output of each command, a line '%END 0' is written to\n"
+      "stdout if the command succeeded, or '%END 1' if it failed, in\n"
+      "which case the error has been written to stderr.  Empty lines are\n"
+      "ignored.  Cached repository data is reused between commands.\n"),
+   {'M'} },
+
   {"cat", subcommand_cat, {0},
    N_("usage: svnlook cat REPOS_PATH FILE_PATH\n\n"
       "Print the contents of a file.  Leading '/' on FILE_PATH is optional.\n"),
@@ -239,7 +263,7 @@ static const svn_opt_subcommand_desc2_t cmd_table[] =
       "Print GNU-style diffs of changed files and properties.\n"),
    {'r', 't', svnlook__no_diff_deleted, svnlook__no_diff_added,
     svnlook__diff_copy_from, svnlook__diff_cmd, 'x',
-    svnlook__ignore_properties, svnlook__properties_only} },
+    svnlook__ignore_properties, svnlook__properties_only, svnlook__jobs} },
 
   {"dirs-changed", subcommand_dirschanged, {0},
    N_("usage: svnlook dirs-changed REPOS_PATH\n\n"
@@ -348,6 +372,11 @@ struct svnlook_opt_state
   svn_boolean_t show_inherited_props; /*  --show-inherited-props */
   svn_boolean_t no_newline;       /* --no-newline */
   apr_uint64_t memory_cache_size; /* --memory-cache-size */
+  int jobs;                       /* --jobs */
+
+  /* If not NULL, the repository at REPOS_PATH opened once for all
+     commands of a 'batch' run. */
+  svn_repos_t *repos;
 };
 
 
@@ -370,6 +399,7 @@ typedef struct svnlook_ctxt_t
   svn_boolean_t ignore_properties;
   svn_boolean_t properties_only;
   const char *diff_cmd;
+  int jobs;
 
 } svnlook_ctxt_t;
 
@@ -553,80 +583,127 @@ print_dirs_changed_tree(svn_repos_node_t *node,
 }
 
 
-/* Recursively print all nodes in the tree that have been modified
-   (do not include directories affected only by "bubble-up"). */
+/* Print the status line for PATH (UTF-8, without leading slash) of KIND
+   with STATUS, followed by the copy source COPYFROM_PATH@COPYFROM_REV if
+   COPY_INFO is set and COPYFROM_PATH is not NULL. */
 static svn_error_t *
-print_changed_tree(svn_repos_node_t *node,
-                   const char *path /* UTF-8! */,
+print_changed_line(const char *status,
+                   const char *path,
+                   svn_node_kind_t kind,
                    svn_boolean_t copy_info,
+                   const char *copyfrom_path,
+                   svn_revnum_t copyfrom_rev,
                    apr_pool_t *pool)
 {
-  const char *full_path;
+  SVN_ERR(svn_cmdline_printf(pool, "%s %s%s\n",
+                             status,
+                             path,
+                             kind == svn_node_dir ? "/" : ""));
+  if (copy_info && copyfrom_path)
+    /* Remove the leading slash from the copyfrom path for consistency
+       with the rest of the output. */
+    SVN_ERR(svn_cmdline_printf(pool, "    (from %s%s:r%ld)\n",
+                               (copyfrom_path[0] == '/'
+                                ? copyfrom_path + 1
+                                : copyfrom_path),
+                               (kind == svn_node_dir ? "/" : ""),
+                               copyfrom_rev));
+
+  return SVN_NO_ERROR;
+}
+
+/* Print CHANGE found in ROOT, whose base revision root is BASE_ROOT, in
+   a format compatible with `svn update'.  Directories affected only by
+   "bubble-up" are not part of the changes list and never get printed. */
+static svn_error_t *
+print_changed_path(svn_fs_root_t *root,
+                   svn_fs_root_t *base_root,
+                   svn_fs_path_change3_t *change,
+                   svn_boolean_t copy_info,
+                   apr_pool_t *pool)
+{
+  const char *path = change->path.data;
+  svn_node_kind_t kind = change->node_kind;
+  const char *copyfrom_path = NULL;
+  svn_revnum_t copyfrom_rev = SVN_INVALID_REVNUM;
   char status[4] = "_  ";
-  svn_boolean_t print_me = TRUE;
-  apr_pool_t *iterpool;
 
   SVN_ERR(check_cancel(NULL));
 
-  if (! node)
-    return SVN_NO_ERROR;
+  /* Older repositories may not record the node kind. */
+  if (kind == svn_node_unknown)
+    SVN_ERR(svn_fs_check_path(&kind,
+                              change->change_kind == svn_fs_path_change_delete
+                                ? base_root
+                                : root,
+                              path, pool));
 
-  /* Print the node. */
-  if (node->action == 'A')
+  if (change->change_kind == svn_fs_path_change_add
+      || change->change_kind == svn_fs_path_change_replace)
     {
-      status[0] = 'A';
-      if (copy_info && node->copyfrom_path)
-        status[2] = '+';
-    }
-  else if (node->action == 'D')
-    status[0] = 'D';
-  else if (node->action == 'R')
-    {
-      if ((! node->text_mod) && (! node->prop_mod))
-        print_me = FALSE;
-      if (node->text_mod)
-        status[0] = 'U';
-      if (node->prop_mod)
-        status[1] = 'U';
+      if (change->copyfrom_known)
+        {
+          copyfrom_path = change->copyfrom_path;
+          copyfrom_rev = change->copyfrom_rev;
+        }
+      else
+        {
+          SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                     root, path, pool));
+        }
     }
-  else
-    print_me = FALSE;
 
-  /* Print this node unless told to skip it. */
-  if (print_me)
+  path = path[0] == '/' ? path + 1 : path;
+  switch (change->change_kind)
     {
-      SVN_ERR(svn_cmdline_printf(pool, "%s %s%s\n",
-                                 status,
-                                 path,
-                                 node->kind == svn_node_dir ? "/" : ""));
-      if (copy_info && node->copyfrom_path)
-        /* Remove the leading slash from the copyfrom path for consistency
-           with the rest of the output. */
-        SVN_ERR(svn_cmdline_printf(pool, "    (from %s%s:r%ld)\n",
-                                   (node->copyfrom_path[0] == '/'
-                                    ? node->copyfrom_path + 1
-                                    : node->copyfrom_path),
-                                   (node->kind == svn_node_dir ? "/" : ""),
-                                   node->copyfrom_rev));
-    }
+      case svn_fs_path_change_replace:
+        /* Same as a delete followed by an add. */
+        SVN_ERR(svn_fs_check_path(&kind, base_root, change->path.data,
+                                  pool));
+        SVN_ERR(print_changed_line("D  ", path, kind, copy_info, NULL,
+                                   SVN_INVALID_REVNUM, pool));
+        kind = change->node_kind;
+        if (kind == svn_node_unknown)
+          SVN_ERR(svn_fs_check_path(&kind, root, change->path.data, pool));
+        /* fall through */
+
+      case svn_fs_path_change_add:
+        status[0] = 'A';
+        if (copy_info && copyfrom_path)
+          status[2] = '+';
+        break;
 
-  /* Return here if the node has no children. */
-  node = node->child;
-  if (! node)
-    return SVN_NO_ERROR;
+      case svn_fs_path_change_delete:
+        status[0] = 'D';
+        break;
 
-  /* Recursively handle the node's children. */
-  iterpool = svn_pool_create(pool);
-  while (node)
-    {
-      svn_pool_clear(iterpool);
-      full_path = svn_dirent_join(path, node->name, iterpool);
-      SVN_ERR(print_changed_tree(node, full_path, copy_info, iterpool));
-      node = node->sibling;
+      case svn_fs_path_change_modify:
+      default:
+        if ((! change->text_mod) && (! change->prop_mod))
+          return SVN_NO_ERROR;
+        if (change->text_mod)
+          status[0] = 'U';
+        if (change->prop_mod)
+          status[1] = 'U';
+        copyfrom_path = NULL;
+        break;
     }
-  svn_pool_destroy(iterpool);
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(print_changed_line(status, path, kind, copy_info,
+                                            copyfrom_path, copyfrom_rev,
+                                            pool));
+}
+
+/* Compare two svn_fs_path_change3_t * by path, depth-first. */
+static int
+compare_changes_by_path(const void *a, const void *b)
+{
+  const svn_fs_path_change3_t *change_a
+    = *(const svn_fs_path_change3_t * const *)a;
+  const svn_fs_path_change3_t *change_b
+    = *(const svn_fs_path_change3_t * const *)b;
+
+  return svn_path_compare_paths(change_a->path.data, change_b->path.data);
 }
 
 
@@ -806,9 +883,97 @@ display_prop_diffs(svn_stream_t *outstream,
   return SVN_NO_ERROR;
 }
 
+/* Decide whether the text of the file NODE at PATH in ROOT shall be
+   diffed against BASE_PATH in BASE_ROOT, according to NODE's action and
+   the options in C.  IS_COPY tells whether NODE is the top of a copied
+   tree.  If so, set *DO_DIFF and prepare the temporary files as by
+   prepare_tmpfiles(), setting *ORIG_EMPTY if the original side is empty
+   because the file has been added.  Otherwise, set *DO_DIFF to FALSE. */
+static svn_error_t *
+prepare_file_diff(svn_boolean_t *do_diff,
+                  const char **orig_path,
+                  const char **new_path,
+                  svn_boolean_t *binary,
+                  svn_boolean_t *orig_empty,
+                  svn_fs_root_t *root,
+                  svn_fs_root_t *base_root,
+                  svn_repos_node_t *node,
+                  const char *path /* UTF-8! */,
+                  const char *base_path /* UTF-8! */,
+                  svn_boolean_t is_copy,
+                  const svnlook_ctxt_t *c,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  *do_diff = FALSE;
+  *orig_empty = FALSE;
+
+  if (node->action == 'R' && node->text_mod)
+    {
+      *do_diff = TRUE;
+      SVN_ERR(prepare_tmpfiles(orig_path, new_path, binary,
+                               base_root, base_path, root, path,
+                               result_pool, scratch_pool));
+    }
+  else if (c->diff_copy_from && node->action == 'A' && is_copy)
+    {
+      if (node->text_mod)
+        {
+          *do_diff = TRUE;
+          SVN_ERR(prepare_tmpfiles(orig_path, new_path, binary,
+                                   base_root, base_path, root, path,
+                                   result_pool, scratch_pool));
+        }
+    }
+  else if (! c->no_diff_added && node->action == 'A')
+    {
+      *do_diff = TRUE;
+      *orig_empty = TRUE;
+      SVN_ERR(prepare_tmpfiles(orig_path, new_path, binary,
+                               NULL, base_path, root, path,
+                               result_pool, scratch_pool));
+    }
+  else if (! c->no_diff_deleted && node->action == 'D')
+    {
+      *do_diff = TRUE;
+      SVN_ERR(prepare_tmpfiles(orig_path, new_path, binary,
+                               base_root, base_path, NULL, path,
+                               result_pool, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+/* A file whose text differences get computed before print_diff_tree()
+   gets to it, possibly in parallel with other files. */
+typedef struct text_diff_t
+{
+  /* Path of the file, as passed to print_diff_tree(). */
+  const char *path;
+
+  /* Results of prepare_file_diff().  The paths are NULL for binary
+     files. */
+  const char *orig_path;
+  const char *new_path;
+  svn_boolean_t binary;
+  svn_boolean_t orig_empty;
+
+  /* The differences between ORIG_PATH and NEW_PATH and the error that
+     occurred while computing them.  Both are NULL for binary files. */
+  svn_diff_t *diff;
+  svn_error_t *err;
+
+  /* Root pool that DIFF has been allocated in, or NULL. */
+  apr_pool_t *pool;
+} text_diff_t;
+
 
 /* Recursively print all nodes in the tree that have been modified
-   (do not include directories affected only by "bubble-up"). */
+   (do not include directories affected only by "bubble-up").
+
+   If TEXT_DIFFS is not NULL, it maps file paths to text_diff_t
+   computed in advance.  Files not in TEXT_DIFFS get processed here. */
 static svn_error_t *
 print_diff_tree(svn_stream_t *out_stream,
                 const char *encoding,
@@ -818,6 +983,7 @@ print_diff_tree(svn_stream_t *out_stream,
                 const char *path /* UTF-8! */,
                 const char *base_path /* UTF-8! */,
                 const svnlook_ctxt_t *c,
+                apr_hash_t *text_diffs,
                 apr_pool_t *pool)
 {
   const char *orig_path = NULL, *new_path = NULL;
@@ -826,6 +992,7 @@ print_diff_tree(svn_stream_t *out_stream,
   svn_boolean_t is_copy = FALSE;
   svn_boolean_t binary = FALSE;
   svn_boolean_t diff_header_printed = FALSE;
+  text_diff_t *text_diff = NULL;
   apr_pool_t *iterpool;
   svn_stringbuf_t *header;
 
@@ -882,37 +1049,21 @@ print_diff_tree(svn_stream_t *out_stream,
            labels.
 
          - Finally, we delete the temporary files.  */
-      if (node->action == 'R' && node->text_mod)
-        {
-          do_diff = TRUE;
-          SVN_ERR(prepare_tmpfiles(&orig_path, &new_path, &binary,
-                                   base_root, base_path, root, path,
-                                   pool, pool));
-        }
-      else if (c->diff_copy_from && node->action == 'A' && is_copy)
-        {
-          if (node->text_mod)
-            {
-              do_diff = TRUE;
-              SVN_ERR(prepare_tmpfiles(&orig_path, &new_path, &binary,
-                                       base_root, base_path, root, path,
-                                       pool, pool));
-            }
-        }
-      else if (! c->no_diff_added && node->action == 'A')
+      text_diff = text_diffs ? svn_hash_gets(text_diffs, path) : NULL;
+      if (text_diff)
         {
           do_diff = TRUE;
-          orig_empty = TRUE;
-          SVN_ERR(prepare_tmpfiles(&orig_path, &new_path, &binary,
-                                   NULL, base_path, root, path,
-                                   pool, pool));
+          orig_path = text_diff->orig_path;
+          new_path = text_diff->new_path;
+          binary = text_diff->binary;
+          orig_empty = text_diff->orig_empty;
         }
-      else if (! c->no_diff_deleted && node->action == 'D')
+      else
         {
-          do_diff = TRUE;
-          SVN_ERR(prepare_tmpfiles(&orig_path, &new_path, &binary,
-                                   base_root, base_path, NULL, path,
-                                   pool, pool));
+          SVN_ERR(prepare_file_diff(&do_diff, &orig_path, &new_path,
+                                    &binary, &orig_empty, root, base_root,
+                                    node, path, base_path, is_copy, c,
+                                    pool, pool));
         }
 
       /* The header for the copy case has already been created, and we don't
@@ -1037,8 +1188,20 @@ print_diff_tree(svn_stream_t *out_stream,
               if (c->diff_options)
                 SVN_ERR(svn_diff_file_options_parse(opts, c->diff_options, pool));
 
-              SVN_ERR(svn_diff_file_diff_2(&diff, orig_path,
-                                           new_path, opts, pool));
+              if (text_diff)
+                {
+                  /* Take ownership of the error. */
+                  svn_error_t *err = text_diff->err;
+                  text_diff->err = SVN_NO_ERROR;
+
+                  SVN_ERR(err);
+                  diff = text_diff->diff;
+                }
+              else
+                {
+                  SVN_ERR(svn_diff_file_diff_2(&diff, orig_path,
+                                               new_path, opts, pool));
+                }
 
               if (svn_diff_contains_diffs(diff))
                 {
@@ -1136,7 +1299,7 @@ print_diff_tree(svn_stream_t *out_stream,
       SVN_ERR(print_diff_tree(out_stream, encoding, root, base_root, node,
                               svn_dirent_join(path, node->name, iterpool),
                               svn_dirent_join(base_path, node->name, iterpool),
-                              c, iterpool));
+                              c, text_diffs, iterpool));
     }
   svn_pool_destroy(iterpool);
 
@@ -1468,23 +1631,272 @@ do_cat(svnlook_ctxt_t *c, const char *path, apr_pool_t *pool)
 static svn_error_t *
 do_changed(svnlook_ctxt_t *c, apr_pool_t *pool)
 {
-  svn_fs_root_t *root;
+  svn_fs_root_t *root, *base_root;
   svn_revnum_t base_rev_id;
-  svn_repos_node_t *tree;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  apr_array_header_t *changes = NULL;
+  const char *fs_type;
+  apr_pool_t *iterpool;
+  int i;
 
   SVN_ERR(get_root(&root, c, pool));
   SVN_ERR(get_base_rev(&base_rev_id, c, pool));
   if (base_rev_id == SVN_INVALID_REVNUM)
     return SVN_NO_ERROR;
 
-  SVN_ERR(generate_delta_tree(&tree, c->repos, root, base_rev_id, pool));
-  if (tree)
-    SVN_ERR(print_changed_tree(tree, "", c->copy_info, pool));
+  SVN_ERR(svn_fs_revision_root(&base_root, c->fs, base_rev_id, pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, pool, pool));
+
+  /* FSFS and FSX store the changes of a revision in path order, so we
+     can print them as they come in and never hold the whole list.  For
+     transactions and BDB, the order is arbitrary and we must sort them
+     first. */
+  SVN_ERR(svn_fs_type(&fs_type, svn_fs_path(c->fs, pool), pool));
+  if (! c->is_revision || strcmp(fs_type, SVN_FS_TYPE_BDB) == 0)
+    changes = apr_array_make(pool, 16, sizeof(svn_fs_path_change3_t *));
+
+  iterpool = svn_pool_create(pool);
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      svn_pool_clear(iterpool);
+
+      if (changes)
+        APR_ARRAY_PUSH(changes, svn_fs_path_change3_t *)
+          = svn_fs_path_change3_dup(change, pool);
+      else
+        SVN_ERR(print_changed_path(root, base_root, change, c->copy_info,
+                                   iterpool));
+
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  if (changes)
+    {
+      svn_sort__array(changes, compare_changes_by_path);
+      for (i = 0; i < changes->nelts; i++)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(print_changed_path(root, base_root,
+                                     APR_ARRAY_IDX(changes, i,
+                                                   svn_fs_path_change3_t *),
+                                     c->copy_info, iterpool));
+        }
+    }
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
 
 
+/* Walk the tree below NODE like print_diff_tree() and append a
+   text_diff_t for every file whose text is to be diffed to TEXT_DIFFS,
+   preparing its temporary files on the way.  Allocate the results in
+   RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+collect_text_diffs(apr_array_header_t *text_diffs,
+                   svn_fs_root_t *root,
+                   svn_fs_root_t *base_root,
+                   svn_repos_node_t *node,
+                   const char *path /* UTF-8! */,
+                   const char *base_path /* UTF-8! */,
+                   const svnlook_ctxt_t *c,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  svn_boolean_t is_copy = FALSE;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(check_cancel(NULL));
+
+  /* Same base adjustment as in print_diff_tree(). */
+  if ((SVN_IS_VALID_REVNUM(node->copyfrom_rev))
+      && (node->copyfrom_path != NULL))
+    {
+      is_copy = TRUE;
+      if (node->copyfrom_path[0] == '/')
+        base_path = node->copyfrom_path + 1;
+      else
+        base_path = node->copyfrom_path;
+
+      SVN_ERR(svn_fs_revision_root(&base_root,
+                                   svn_fs_root_fs(base_root),
+                                   node->copyfrom_rev, scratch_pool));
+    }
+
+  if (node->kind == svn_node_file)
+    {
+      text_diff_t *text_diff = apr_pcalloc(result_pool, sizeof(*text_diff));
+      svn_boolean_t do_diff;
+
+      SVN_ERR(prepare_file_diff(&do_diff, &text_diff->orig_path,
+                                &text_diff->new_path, &text_diff->binary,
+                                &text_diff->orig_empty, root, base_root,
+                                node, path, base_path, is_copy, c,
+                                result_pool, scratch_pool));
+      if (do_diff)
+        {
+          text_diff->path = apr_pstrdup(result_pool, path);
+          APR_ARRAY_PUSH(text_diffs, text_diff_t *) = text_diff;
+        }
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (node = node->child; node; node = node->sibling)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(collect_text_diffs(text_diffs, root, base_root, node,
+                                 svn_dirent_join(path, node->name, iterpool),
+                                 svn_dirent_join(base_path, node->name,
+                                                 iterpool),
+                                 c, result_pool, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function releasing the results held by the text_diff_t
+   elements of the array DATA. */
+static apr_status_t
+cleanup_text_diffs(void *data)
+{
+  apr_array_header_t *text_diffs = data;
+  int i;
+
+  for (i = 0; i < text_diffs->nelts; ++i)
+    {
+      text_diff_t *text_diff = APR_ARRAY_IDX(text_diffs, i, text_diff_t *);
+
+      svn_error_clear(text_diff->err);
+      text_diff->err = SVN_NO_ERROR;
+      if (text_diff->pool)
+        svn_pool_destroy(text_diff->pool);
+      text_diff->pool = NULL;
+    }
+
+  return APR_SUCCESS;
+}
+
+#if APR_HAS_THREADS
+
+/* Data shared by all threads computing text diffs.
+ */
+typedef struct text_diff_queue_t
+{
+  /* The text_diff_t to process and the options to use. */
+  apr_array_header_t *text_diffs;
+  const svn_diff_file_options_t *options;
+
+  /* Index of the next element in TEXT_DIFFS to pick up.  Only to be
+     accessed while holding MUTEX. */
+  int next;
+  apr_thread_mutex_t *mutex;
+} text_diff_queue_t;
+
+/* Worker thread main function.  DATA is a text_diff_queue_t.  Compute
+ * the diffs for all queued non-binary files until none are left.
+ */
+static void *
+APR_THREAD_FUNC text_diff_thread_func(apr_thread_t *tid, void *data)
+{
+  text_diff_queue_t *queue = data;
+
+  while (TRUE)
+    {
+      text_diff_t *text_diff = NULL;
+
+      apr_thread_mutex_lock(queue->mutex);
+      if (queue->next < queue->text_diffs->nelts)
+        text_diff = APR_ARRAY_IDX(queue->text_diffs, queue->next++,
+                                  text_diff_t *);
+      apr_thread_mutex_unlock(queue->mutex);
+
+      if (text_diff == NULL)
+        break;
+
+      if (text_diff->binary)
+        continue;
+
+      /* The results will be released by the calling thread, so they
+       * need a root pool of their own. */
+      text_diff->pool = svn_pool_create(NULL);
+      text_diff->err = check_cancel(NULL);
+      if (!text_diff->err)
+        text_diff->err = svn_diff_file_diff_2(&text_diff->diff,
+                                              text_diff->orig_path,
+                                              text_diff->new_path,
+                                              queue->options,
+                                              text_diff->pool);
+    }
+
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Compute the diffs for all elements in TEXT_DIFFS using OPTIONS and up
+ * to JOBS worker threads.  Per-file errors are stored in the elements.
+ */
+static svn_error_t *
+compute_text_diffs(apr_array_header_t *text_diffs,
+                   const svn_diff_file_options_t *options,
+                   int jobs)
+{
+  text_diff_queue_t queue = { 0 };
+  apr_thread_t **threads;
+  apr_pool_t *threads_pool;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status;
+  int thread_count = 0;
+  int i;
+
+  /* Our main pool uses a mutexless allocator, so thread management
+   * must not allocate from it. */
+  threads_pool = svn_pool_create(NULL);
+
+  queue.text_diffs = text_diffs;
+  queue.options = options;
+  status = apr_thread_mutex_create(&queue.mutex, APR_THREAD_MUTEX_DEFAULT,
+                                   threads_pool);
+  if (status)
+    {
+      svn_pool_destroy(threads_pool);
+      return svn_error_wrap_apr(status, _("Can't create diff mutex"));
+    }
+
+  jobs = MIN(jobs, text_diffs->nelts);
+  threads = apr_pcalloc(threads_pool, jobs * sizeof(*threads));
+  for (i = 0; i < jobs; ++i)
+    {
+      status = apr_thread_create(&threads[i], NULL, text_diff_thread_func,
+                                 &queue, threads_pool);
+      if (status)
+        {
+          err = svn_error_wrap_apr(status, _("Can't create thread"));
+          break;
+        }
+
+      ++thread_count;
+    }
+
+  /* Running workers will process all remaining items, even if we failed
+   * to start some of them. */
+  for (i = 0; i < thread_count; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, threads[i]);
+    }
+
+  svn_pool_destroy(threads_pool);
+
+  return err;
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Print some diff-y stuff in a TBD way. :-) */
 static svn_error_t *
 do_diff(svnlook_ctxt_t *c, apr_pool_t *pool)
@@ -1492,6 +1904,7 @@ do_diff(svnlook_ctxt_t *c, apr_pool_t *pool)
   svn_fs_root_t *root, *base_root;
   svn_revnum_t base_rev_id;
   svn_repos_node_t *tree;
+  apr_hash_t *text_diffs_by_path = NULL;
 
   SVN_ERR(get_root(&root, c, pool));
   SVN_ERR(get_base_rev(&base_rev_id, c, pool));
@@ -1532,8 +1945,43 @@ do_diff(svnlook_ctxt_t *c, apr_pool_t *pool)
       SVN_ERR(svn_cmdline_fflush(stdout));
       SVN_ERR(svn_stream_for_stdout(&out_stream, pool));
 
+#if APR_HAS_THREADS
+      /* Compute the text diffs of all files up-front and in parallel.
+         Fetching the contents from the repository still happens in this
+         thread as svn_fs_t is not thread-safe. */
+      if (c->jobs > 1 && !c->diff_cmd && !c->properties_only)
+        {
+          apr_array_header_t *text_diffs
+            = apr_array_make(pool, 16, sizeof(text_diff_t *));
+          svn_diff_file_options_t *opts = svn_diff_file_options_create(pool);
+          int i;
+
+          apr_pool_cleanup_register(pool, text_diffs, cleanup_text_diffs,
+                                    apr_pool_cleanup_null);
+          SVN_ERR(collect_text_diffs(text_diffs, root, base_root, tree,
+                                     "", "", c, pool, pool));
+
+          if (c->diff_options)
+            SVN_ERR(svn_diff_file_options_parse(opts, c->diff_options,
+                                                pool));
+          SVN_ERR(compute_text_diffs(text_diffs, opts, c->jobs));
+
+          /* Entries that no thread got to will be diffed on demand. */
+          text_diffs_by_path = apr_hash_make(pool);
+          for (i = 0; i < text_diffs->nelts; ++i)
+            {
+              text_diff_t *text_diff
+                = APR_ARRAY_IDX(text_diffs, i, text_diff_t *);
+
+              if (text_diff->binary || text_diff->pool)
+                svn_hash_sets(text_diffs_by_path, text_diff->path,
+                              text_diff);
+            }
+        }
+#endif
+
       SVN_ERR(print_diff_tree(out_stream, encoding, root, base_root, tree,
-                              "", "", c, pool));
+                              "", "", c, text_diffs_by_path, pool));
     }
   return SVN_NO_ERROR;
 }
@@ -2065,8 +2513,11 @@ get_ctxt_baton(svnlook_ctxt_t **baton_p,
 {
   svnlook_ctxt_t *baton = apr_pcalloc(pool, sizeof(*baton));
 
-  SVN_ERR(svn_repos_open3(&(baton->repos), opt_state->repos_path, NULL,
-                          pool, pool));
+  if (opt_state->repos)
+    baton->repos = opt_state->repos;
+  else
+    SVN_ERR(svn_repos_open3(&(baton->repos), opt_state->repos_path, NULL,
+                            pool, pool));
   baton->fs = svn_repos_fs(baton->repos);
   svn_fs_set_warning_func(baton->fs, warning_func, NULL);
   baton->show_ids = opt_state->show_ids;
@@ -2085,6 +2536,7 @@ get_ctxt_baton(svnlook_ctxt_t **baton_p,
   baton->ignore_properties = opt_state->ignore_properties;
   baton->properties_only = opt_state->properties_only;
   baton->diff_cmd = opt_state->diff_cmd;
+  baton->jobs = opt_state->jobs;
 
   if (baton->txn_name)
     SVN_ERR(svn_fs_open_txn(&(baton->txn), baton->fs,
@@ -2097,6 +2549,172 @@ get_ctxt_baton(svnlook_ctxt_t **baton_p,
 }
 
 
+/* Apply the option OPT_ID with argument OPT_ARG, as returned by
+   apr_getopt_long(), to OPT_STATE.  Use POOL for allocations. */
+static svn_error_t *
+parse_option(struct svnlook_opt_state *opt_state,
+             int opt_id,
+             const char *opt_arg,
+             apr_pool_t *pool)
+{
+  switch (opt_id)
+    {
+    case 'r':
+      {
+        char *digits_end = NULL;
+        opt_state->rev = strtol(opt_arg, &digits_end, 10);
+        if ((! SVN_IS_VALID_REVNUM(opt_state->rev))
+            || (! digits_end)
+            || *digits_end)
+          return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                  _("Invalid revision number supplied"));
+      }
+      break;
+
+    case 't':
+      opt_state->txn = opt_arg;
+      break;
+
+    case 'M':
+      {
+        apr_uint64_t sz_val;
+        SVN_ERR(svn_cstring_atoui64(&sz_val, opt_arg));
+
+        opt_state->memory_cache_size = 0x100000 * sz_val;
+      }
+      break;
+
+    case 'N':
+      opt_state->non_recursive = TRUE;
+      break;
+
+    case 'v':
+      opt_state->verbose = TRUE;
+      break;
+
+    case 'h':
+    case '?':
+      opt_state->help = TRUE;
+      break;
+
+    case 'q':
+      opt_state->quiet = TRUE;
+      break;
+
+    case svnlook__revprop_opt:
+      opt_state->revprop = TRUE;
+      break;
+
+    case svnlook__xml_opt:
+      opt_state->xml = TRUE;
+      break;
+
+    case svnlook__version:
+      opt_state->version = TRUE;
+      break;
+
+    case svnlook__show_ids:
+      opt_state->show_ids = TRUE;
+      break;
+
+    case 'l':
+      {
+        char *end;
+        opt_state->limit = strtol(opt_arg, &end, 10);
+        if (end == opt_arg || *end != '\0')
+          {
+            return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                    _("Non-numeric limit argument given"));
+          }
+        if (opt_state->limit <= 0)
+          {
+            return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                _("Argument to --limit must be positive"));
+          }
+      }
+      break;
+
+    case svnlook__no_diff_deleted:
+      opt_state->no_diff_deleted = TRUE;
+      break;
+
+    case svnlook__no_diff_added:
+      opt_state->no_diff_added = TRUE;
+      break;
+
+    case svnlook__diff_copy_from:
+      opt_state->diff_copy_from = TRUE;
+      break;
+
+    case svnlook__full_paths:
+      opt_state->full_paths = TRUE;
+      break;
+
+    case svnlook__copy_info:
+      opt_state->copy_info = TRUE;
+      break;
+
+    case 'x':
+      opt_state->extensions = opt_arg;
+      break;
+
+    case svnlook__ignore_properties:
+      opt_state->ignore_properties = TRUE;
+      break;
+
+    case svnlook__properties_only:
+      opt_state->properties_only = TRUE;
+      break;
+
+    case svnlook__diff_cmd:
+      opt_state->diff_cmd = opt_arg;
+      break;
+
+    case svnlook__show_inherited_props:
+      opt_state->show_inherited_props = TRUE;
+      break;
+
+    case svnlook__no_newline:
+      opt_state->no_newline = TRUE;
+      break;
+
+    case svnlook__jobs:
+      SVN_ERR(svn_cstring_atoi(&opt_state->jobs, opt_arg));
+      if (opt_state->jobs < 1)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                _("The number of jobs must be at least 1"));
+      break;
+
+    default:
+      return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                               _("Unknown option code %d"), opt_id);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return an error if OPT_STATE contains mutually exclusive options. */
+static svn_error_t *
+check_exclusive_options(const struct svnlook_opt_state *opt_state)
+{
+  /* The --transaction and --revision options may not co-exist. */
+  if ((opt_state->rev != SVN_INVALID_REVNUM) && opt_state->txn)
+    return svn_error_create
+                (SVN_ERR_CL_MUTUALLY_EXCLUSIVE_ARGS, NULL,
+                 _("The '--transaction' (-t) and '--revision' (-r) arguments "
+                   "cannot co-exist"));
+
+  /* The --show-inherited-props and --revprop options may not co-exist. */
+  if (opt_state->show_inherited_props && opt_state->revprop)
+    return svn_error_create
+                (SVN_ERR_CL_MUTUALLY_EXCLUSIVE_ARGS, NULL,
+                 _("Cannot use the '--show-inherited-props' option with the "
+                   "'--revprop' option"));
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /*** Subcommands. ***/
 
@@ -2114,6 +2732,179 @@ subcommand_author(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Line written to stdout after each command in batch mode, followed by
+   the command's exit status. */
+#define BATCH_END_MARKER "%END"
+
+/* Run the svnlook command line LINE (in native encoding, without the
+   program name and repository path) against the repository specified
+   in BATCH_STATE.  Use POOL for all allocations. */
+static svn_error_t *
+run_batch_command(const char *line,
+                  const struct svnlook_opt_state *batch_state,
+                  apr_pool_t *pool)
+{
+  struct svnlook_opt_state opt_state;
+  const svn_opt_subcommand_desc2_t *subcommand;
+  apr_array_header_t *received_opts;
+  apr_getopt_t *os;
+  apr_status_t status;
+  char **tokens;
+  const char **argv;
+  const char *first_arg;
+  int argc;
+  int i;
+
+  status = apr_tokenize_to_argv(line, &tokens, pool);
+  if (status)
+    return svn_error_wrap_apr(status,
+                              _("Can't split line into components: '%s'"),
+                              line);
+
+  /* apr_getopt expects the program name as the first element. */
+  for (argc = 0; tokens[argc]; argc++)
+    ;
+  argv = apr_palloc(pool, (argc + 2) * sizeof(*argv));
+  argv[0] = "svnlook";
+  for (i = 0; i < argc; i++)
+    argv[i + 1] = tokens[i];
+  argv[argc + 1] = NULL;
+
+  memset(&opt_state, 0, sizeof(opt_state));
+  opt_state.rev = SVN_INVALID_REVNUM;
+  opt_state.jobs = 1;
+  opt_state.memory_cache_size = batch_state->memory_cache_size;
+  opt_state.repos_path = batch_state->repos_path;
+  opt_state.repos = batch_state->repos;
+
+  SVN_ERR(svn_cmdline__getopt_init(&os, argc + 1, argv, pool));
+  os->interleave = 1;
+
+  received_opts = apr_array_make(pool, SVN_OPT_MAX_OPTIONS, sizeof(int));
+  while (1)
+    {
+      const char *opt_arg;
+      int opt_id;
+
+      status = apr_getopt_long(os, options_table, &opt_id, &opt_arg);
+      if (APR_STATUS_IS_EOF(status))
+        break;
+      else if (status)
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("Invalid options in '%s'"), line);
+
+      APR_ARRAY_PUSH(received_opts, int) = opt_id;
+      SVN_ERR(parse_option(&opt_state, opt_id, opt_arg, pool));
+    }
+
+  SVN_ERR(check_exclusive_options(&opt_state));
+
+  if (os->ind >= os->argc)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, NULL,
+                            _("Subcommand argument required"));
+
+  SVN_ERR(svn_utf_cstring_to_utf8(&first_arg, os->argv[os->ind++], pool));
+  subcommand = svn_opt_get_canonical_subcommand2(cmd_table, first_arg);
+  if (subcommand == NULL)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("Unknown subcommand: '%s'"), first_arg);
+  if (   subcommand->cmd_func == subcommand_help
+      || subcommand->cmd_func == subcommand_batch)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("Subcommand '%s' is not available in "
+                               "batch mode"), subcommand->name);
+
+  /* The repository is implied, so the remaining arguments are ARG1 and
+     ARG2 as in sub_main(). */
+  if (os->ind < os->argc)
+    {
+      SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.arg1,
+                                      os->argv[os->ind++], pool));
+      opt_state.arg1 = svn_dirent_internal_style(opt_state.arg1, pool);
+    }
+  if (os->ind < os->argc)
+    {
+      SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.arg2,
+                                      os->argv[os->ind++], pool));
+      opt_state.arg2 = svn_dirent_internal_style(opt_state.arg2, pool);
+    }
+
+  for (i = 0; i < received_opts->nelts; i++)
+    {
+      int opt_id = APR_ARRAY_IDX(received_opts, i, int);
+
+      if (! svn_opt_subcommand_takes_option3(subcommand, opt_id, NULL))
+        {
+          const char *optstr;
+          const apr_getopt_option_t *badopt =
+            svn_opt_get_option_from_code2(opt_id, options_table, subcommand,
+                                          pool);
+          svn_opt_format_option(&optstr, badopt, FALSE, pool);
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("Subcommand '%s' doesn't accept "
+                                     "option '%s'"),
+                                   subcommand->name, optstr);
+        }
+    }
+
+  return svn_error_trace((*subcommand->cmd_func)(os, &opt_state, pool));
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_batch(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnlook_opt_state *opt_state = baton;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stream_t *in;
+  svn_boolean_t eof = FALSE;
+
+  SVN_ERR(check_number_of_args(opt_state, 0));
+
+  /* Open the repository once.  Its caches will be shared by all
+     commands. */
+  SVN_ERR(svn_repos_open3(&opt_state->repos, opt_state->repos_path, NULL,
+                          pool, pool));
+  SVN_ERR(svn_stream_for_stdin2(&in, TRUE, pool));
+
+  while (! eof)
+    {
+      svn_stringbuf_t *line;
+      svn_error_t *err;
+      int exit_status = 0;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_cancel(NULL));
+
+      SVN_ERR(svn_stream_readline(in, &line, "\n", &eof, iterpool));
+      svn_stringbuf_strip_whitespace(line);
+      if (line->len == 0)
+        continue;
+
+      err = run_batch_command(line->data, opt_state, iterpool);
+
+      /* The end marker must follow all of the command's output. */
+      err = svn_error_compose_create(err, svn_cmdline_fflush(stdout));
+      if (err)
+        {
+          if (svn_error_find_cause(err, SVN_ERR_CANCELLED))
+            return svn_error_trace(err);
+
+          svn_handle_error2(err, stderr, FALSE, "svnlook: ");
+          svn_error_clear(err);
+          exit_status = 1;
+        }
+
+      SVN_ERR(svn_cmdline_printf(iterpool, BATCH_END_MARKER " %d\n",
+                                 exit_status));
+      SVN_ERR(svn_cmdline_fflush(stdout));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_cat(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -2462,6 +3253,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   /* Initialize opt_state. */
   memset(&opt_state, 0, sizeof(opt_state));
   opt_state.rev = SVN_INVALID_REVNUM;
+  opt_state.jobs = 1;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
 
   /* Parse options. */
@@ -2486,148 +3278,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       /* Stash the option code in an array before parsing it. */
       APR_ARRAY_PUSH(received_opts, int) = opt_id;
 
-      switch (opt_id)
-        {
-        case 'r':
-          {
-            char *digits_end = NULL;
-            opt_state.rev = strtol(opt_arg, &digits_end, 10);
-            if ((! SVN_IS_VALID_REVNUM(opt_state.rev))
-                || (! digits_end)
-                || *digits_end)
-              return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
-                                      _("Invalid revision number supplied"));
-          }
-          break;
-
-        case 't':
-          opt_state.txn = opt_arg;
-          break;
-
-        case 'M':
-          {
-            apr_uint64_t sz_val;
-            SVN_ERR(svn_cstring_atoui64(&sz_val, opt_arg));
-
-            opt_state.memory_cache_size = 0x100000 * sz_val;
-          }
-          break;
-
-        case 'N':
-          opt_state.non_recursive = TRUE;
-          break;
-
-        case 'v':
-          opt_state.verbose = TRUE;
-          break;
-
-        case 'h':
-        case '?':
-          opt_state.help = TRUE;
-          break;
-
-        case 'q':
-          opt_state.quiet = TRUE;
-          break;
-
-        case svnlook__revprop_opt:
-          opt_state.revprop = TRUE;
-          break;
-
-        case svnlook__xml_opt:
-          opt_state.xml = TRUE;
-          break;
-
-        case svnlook__version:
-          opt_state.version = TRUE;
-          break;
-
-        case svnlook__show_ids:
-          opt_state.show_ids = TRUE;
-          break;
-
-        case 'l':
-          {
-            char *end;
-            opt_state.limit = strtol(opt_arg, &end, 10);
-            if (end == opt_arg || *end != '\0')
-              {
-                return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
-                                        _("Non-numeric limit argument given"));
-              }
-            if (opt_state.limit <= 0)
-              {
-                return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
-                                    _("Argument to --limit must be positive"));
-              }
-          }
-          break;
-
-        case svnlook__no_diff_deleted:
-          opt_state.no_diff_deleted = TRUE;
-          break;
-
-        case svnlook__no_diff_added:
-          opt_state.no_diff_added = TRUE;
-          break;
-
-        case svnlook__diff_copy_from:
-          opt_state.diff_copy_from = TRUE;
-          break;
-
-        case svnlook__full_paths:
-          opt_state.full_paths = TRUE;
-          break;
-
-        case svnlook__copy_info:
-          opt_state.copy_info = TRUE;
-          break;
-
-        case 'x':
-          opt_state.extensions = opt_arg;
-          break;
-
-        case svnlook__ignore_properties:
-          opt_state.ignore_properties = TRUE;
-          break;
-
-        case svnlook__properties_only:
-          opt_state.properties_only = TRUE;
-          break;
-
-        case svnlook__diff_cmd:
-          opt_state.diff_cmd = opt_arg;
-          break;
-
-        case svnlook__show_inherited_props:
-          opt_state.show_inherited_props = TRUE;
-          break;
-
-        case svnlook__no_newline:
-          opt_state.no_newline = TRUE;
-          break;
-
-        default:
-          SVN_ERR(subcommand_help(NULL, NULL, pool));
-          *exit_code = EXIT_FAILURE;
-          return SVN_NO_ERROR;
-
-        }
+      SVN_ERR(parse_option(&opt_state, opt_id, opt_arg, pool));
     }
 
-  /* The --transaction and --revision options may not co-exist. */
-  if ((opt_state.rev != SVN_INVALID_REVNUM) && opt_state.txn)
-    return svn_error_create
-                (SVN_ERR_CL_MUTUALLY_EXCLUSIVE_ARGS, NULL,
-                 _("The '--transaction' (-t) and '--revision' (-r) arguments "
-                   "cannot co-exist"));
-
-  /* The --show-inherited-props and --revprop options may not co-exist. */
-  if (opt_state.show_inherited_props && opt_state.revprop)
-    return svn_error_create
-                (SVN_ERR_CL_MUTUALLY_EXCLUSIVE_ARGS, NULL,
-                 _("Cannot use the '--show-inherited-props' option with the "
-                   "'--revprop' option"));
+  SVN_ERR(check_exclusive_options(&opt_state));
 
   /* If the user asked for help, then the rest of the arguments are
      the names of subcommands to get help on (if any), or else they're
@@ -138,6 +138,63 @@ struct action {
   const svn_string_t *prop_value;
 };
 
+/* Look up the kinds of all repository paths of ACTIONS relative to ANCHOR
+   in MTCC at once, one request per revision, rather than one by one as
+   the actions are added. */
+static svn_error_t *
+prefetch_kinds(const apr_array_header_t *actions,
+               const char *anchor,
+               svn_revnum_t base_revision,
+               svn_client__mtcc_t *mtcc,
+               apr_pool_t *pool)
+{
+  apr_array_header_t *targets;
+  apr_hash_t *sources = apr_hash_make(pool);
+  apr_hash_index_t *hi;
+  int i;
+
+  targets = apr_array_make(pool, actions->nelts, sizeof(const char *));
+
+  for (i = 0; i < actions->nelts; ++i)
+    {
+      struct action *action = APR_ARRAY_IDX(actions, i, struct action *);
+      const char *path1 = subtract_anchor(anchor, action->path[0], pool);
+
+      if (action->action == ACTION_CP)
+        {
+          apr_array_header_t *paths = apr_hash_get(sources, &action->rev,
+                                                   sizeof(action->rev));
+
+          if (!paths)
+            {
+              paths = apr_array_make(pool, 4, sizeof(const char *));
+              apr_hash_set(sources, &action->rev, sizeof(action->rev),
+                           paths);
+            }
+          APR_ARRAY_PUSH(paths, const char *) = path1;
+        }
+      else
+        APR_ARRAY_PUSH(targets, const char *) = path1;
+
+      if (action->action == ACTION_MV || action->action == ACTION_CP)
+        APR_ARRAY_PUSH(targets, const char *)
+          = subtract_anchor(anchor, action->path[1], pool);
+    }
+
+  SVN_ERR(svn_client__mtcc_prefetch_kinds(targets, base_revision, mtcc,
+                                          pool));
+
+  for (hi = apr_hash_first(pool, sources); hi; hi = apr_hash_next(hi))
+    {
+      const svn_revnum_t *rev = apr_hash_this_key(hi);
+
+      SVN_ERR(svn_client__mtcc_prefetch_kinds(apr_hash_this_val(hi), *rev,
+                                              mtcc, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 execute(const apr_array_header_t *actions,
         const char *anchor,
@@ -157,6 +214,8 @@ execute(const apr_array_header_t *actions,
                                      : SVN_INVALID_REVNUM,
                                   ctx, pool, iterpool));
 
+  SVN_ERR(prefetch_kinds(actions, anchor, base_revision, mtcc, iterpool));
+
   for (i = 0; i < actions->nelts; ++i)
     {
       struct action *action = APR_ARRAY_IDX(actions, i, struct action *);
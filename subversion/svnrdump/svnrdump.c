@@ -23,6 +23,9 @@
  */
 
 #include <apr_uri.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
 
 #include "svn_pools.h"
 #include "svn_cmdline.h"
@@ -35,9 +38,11 @@
 #include "svn_private_config.h"
 #include "svn_string.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 
 #include "svnrdump.h"
 
+#include "private/svn_auth_private.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_ra_private.h"
@@ -66,6 +71,8 @@ enum svn_svnrdump__longopt_t
     opt_incremental,
     opt_trust_server_cert,
     opt_trust_server_cert_failures,
+    opt_jobs,
+    opt_checkpoint_dir,
     opt_version
   };
 
@@ -85,8 +92,14 @@ static const svn_opt_subcommand_desc2_t svnrdump__cmd_table[] =
     N_("usage: svnrdump dump URL [-r LOWER[:UPPER]]\n\n"
        "Dump revisions LOWER to UPPER of repository at remote URL to stdout\n"
        "in a 'dumpfile' portable format.  If only LOWER is given, dump that\n"
-       "one revision.\n"),
-    { 'r', 'q', opt_incremental, SVN_SVNRDUMP__BASE_OPTIONS } },
+       "one revision.\n"
+       "\n"
+       "With --jobs, fetch several ranges of revisions concurrently over\n"
+       "separate connections.  With --checkpoint-dir, keep the fetched\n"
+       "ranges in that directory, so an interrupted dump of the same URL\n"
+       "does not need to fetch them again.\n"),
+    { 'r', 'q', opt_incremental, opt_jobs, opt_checkpoint_dir,
+      SVN_SVNRDUMP__BASE_OPTIONS } },
   { "load", load_cmd, { 0 },
     N_("usage: svnrdump load URL\n\n"
        "Load a 'dumpfile' given on stdin to a repository at remote URL.\n"),
@@ -106,6 +119,12 @@ static const apr_getopt_option_t svnrdump__options[] =
                       N_("no progress (only errors) to stderr")},
     {"incremental",   opt_incremental, 0,
                       N_("dump incrementally")},
+    {"jobs",          opt_jobs, 1,
+                      N_("fetch revisions over ARG connections in parallel")},
+    {"checkpoint-dir", opt_checkpoint_dir, 1,
+                      N_("keep the revisions fetched so far in directory\n"
+                         "                             "
+                         "ARG and reuse them when dumping again")},
     {"skip-revprop",  opt_skip_revprop, 1,
                       N_("skip revision property ARG (e.g., \"svn:author\")")},
     {"config-dir",    opt_config_dir, 1,
@@ -167,6 +186,10 @@ struct replay_baton {
 
   /* Whether to be quiet. */
   svn_boolean_t quiet;
+
+  /* The cancellation callback for the dump editor. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
 };
 
 /* Option set */
@@ -180,6 +203,8 @@ typedef struct opt_baton_t {
   svn_opt_revision_t end_revision;
   svn_boolean_t quiet;
   svn_boolean_t incremental;
+  int jobs;
+  const char *checkpoint_dir;
   apr_hash_t *skip_revprops;
 } opt_baton_t;
 
@@ -206,7 +231,8 @@ replay_revstart(svn_revnum_t revision,
 
   SVN_ERR(svn_rdump__get_dump_editor(editor, edit_baton, revision,
                                      rb->stdout_stream, rb->extra_ra_session,
-                                     NULL, check_cancel, NULL, pool));
+                                     NULL, rb->cancel_func, rb->cancel_baton,
+                                     pool));
 
   return SVN_NO_ERROR;
 }
@@ -256,7 +282,8 @@ replay_revstart_v2(svn_revnum_t revision,
   SVN_ERR(svn_rdump__get_dump_editor_v2(editor, revision,
                                         rb->stdout_stream,
                                         rb->extra_ra_session,
-                                        NULL, check_cancel, NULL, pool, pool));
+                                        NULL, rb->cancel_func,
+                                        rb->cancel_baton, pool, pool));
 
   return SVN_NO_ERROR;
 }
@@ -450,11 +477,543 @@ dump_initial_full_revision(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+/* Number of revisions per checkpoint file.  Chunks are aligned to
+ * multiples of this, so dumps of different revision ranges can share
+ * checkpoints. */
+#define CHECKPOINT_CHUNK_SIZE 100
+
+/* Name of the file recording the dump source of a checkpoint directory. */
+#define CHECKPOINT_SOURCE_FILE "source"
+
+/* How long the main thread waits for a chunk before it checks for
+ * cancellation again. */
+#define CHUNK_POLL_INTERVAL apr_time_from_msec(100)
+
+/* A range of revisions that gets dumped into a separate file. */
+typedef struct dump_chunk_t
+{
+  svn_revnum_t start_revision;
+  svn_revnum_t end_revision;
+
+  /* Once DONE is set, the dump file (allocated in POOL) or the error. */
+  svn_boolean_t done;
+  const char *path;
+  svn_error_t *err;
+
+  /* Root pool with its own allocator, so it may be used by any thread. */
+  apr_pool_t *pool;
+} dump_chunk_t;
+
+/* State of a dump split into chunks.  NEXT_CHUNK, ABORTED and the DONE,
+ * PATH and ERR members of CHUNKS must only be accessed while holding
+ * MUTEX once the dump threads are running. */
+typedef struct chunked_dump_t
+{
+  dump_chunk_t *chunks;
+  int chunk_count;
+
+  /* Index of the next chunk to be picked up by a dump thread. */
+  int next_chunk;
+
+  /* Where to keep the chunk files.  If NULL, use temporary files. */
+  const char *checkpoint_dir;
+
+  /* If set, the dump threads shall not start new chunks. */
+  svn_boolean_t aborted;
+
+  /* Set once the dump threads run, and their sessions may no longer ask
+   * the auth baton of the client for credentials. */
+  svn_boolean_t detached;
+
+#if APR_HAS_THREADS
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+#endif
+} chunked_dump_t;
+
+/* A dump thread and its RA sessions, allocated in POOL, and the
+ * cancellation callback for its dump editor. */
+typedef struct dump_worker_t
+{
+  chunked_dump_t *dump;
+  svn_ra_session_t *session;
+  svn_ra_session_t *extra_ra_session;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+#if APR_HAS_THREADS
+  apr_thread_t *tid;
+#endif
+  apr_pool_t *pool;
+} dump_worker_t;
+
+/* Open a backdoor RA session for the dump editor in *EXTRA_RA_SESSION,
+ * rooted at the repository root of URL.  Use CTX and allocate in POOL.
+ */
+static svn_error_t *
+open_extra_ra_session(svn_ra_session_t **extra_ra_session,
+                      const char *url,
+                      svn_client_ctx_t *ctx,
+                      apr_pool_t *pool)
+{
+  const char *repos_root;
+
+  SVN_ERR(svn_client_open_ra_session2(extra_ra_session, url, NULL,
+                                      ctx, pool, pool));
+  SVN_ERR(svn_ra_get_repos_root2(*extra_ra_session, &repos_root, pool));
+  SVN_ERR(svn_ra_reparent(*extra_ra_session, repos_root, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Make sure that CHECKPOINT_DIR exists and holds checkpoints of URL in
+ * the repository with UUID only.
+ */
+static svn_error_t *
+check_checkpoint_dir(const char *checkpoint_dir,
+                     const char *url,
+                     const char *uuid,
+                     apr_pool_t *pool)
+{
+  const char *source_path = svn_dirent_join(checkpoint_dir,
+                                            CHECKPOINT_SOURCE_FILE, pool);
+  const char *source = apr_psprintf(pool, "%s %s\n", uuid, url);
+  svn_stringbuf_t *contents;
+  svn_error_t *err;
+
+  SVN_ERR(svn_io_make_dir_recursively(checkpoint_dir, pool));
+
+  err = svn_stringbuf_from_file2(&contents, source_path, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return svn_error_trace(svn_io_write_atomic2(source_path, source,
+                                                  strlen(source), NULL,
+                                                  TRUE, pool));
+    }
+  SVN_ERR(err);
+
+  if (strcmp(contents->data, source) != 0)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("Checkpoint directory '%s' belongs to a "
+                               "dump of a different URL or repository"),
+                             svn_dirent_local_style(checkpoint_dir, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Replay START_REVISION thru END_REVISION into a dump file and return
+ * its path in *PATH.  Replay through SESSION and use EXTRA_RA_SESSION
+ * and CANCEL_FUNC / CANCEL_BATON for the dump editor.
+ *
+ * If CHECKPOINT_DIR is not NULL, keep the file there and simply return
+ * the existing file if an earlier run already dumped this range.
+ * Otherwise, use a temporary file.
+ *
+ * Allocate *PATH in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+dump_chunk(const char **path,
+           svn_revnum_t start_revision,
+           svn_revnum_t end_revision,
+           const char *checkpoint_dir,
+           svn_ra_session_t *session,
+           svn_ra_session_t *extra_ra_session,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  struct replay_baton *replay_baton;
+  const char *final_path = NULL;
+  const char *tmp_path;
+  apr_file_t *file;
+  svn_stream_t *stream;
+  svn_error_t *err;
+
+  if (checkpoint_dir)
+    {
+      svn_node_kind_t kind;
+
+      final_path = svn_dirent_join(checkpoint_dir,
+                                   apr_psprintf(scratch_pool,
+                                                "r%ld-r%ld.dump",
+                                                start_revision,
+                                                end_revision),
+                                   result_pool);
+      SVN_ERR(svn_io_check_path(final_path, &kind, scratch_pool));
+      if (kind == svn_node_file)
+        {
+          *path = final_path;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Write to a temporary file first, so that an interrupted dump never
+     leaves an incomplete checkpoint behind. */
+  SVN_ERR(svn_io_open_unique_file3(&file, &tmp_path, checkpoint_dir,
+                                   svn_io_file_del_none,
+                                   result_pool, scratch_pool));
+  stream = svn_stream_from_aprfile2(file, FALSE, scratch_pool);
+
+  replay_baton = apr_pcalloc(scratch_pool, sizeof(*replay_baton));
+  replay_baton->stdout_stream = stream;
+  replay_baton->extra_ra_session = extra_ra_session;
+  replay_baton->quiet = TRUE;
+  replay_baton->cancel_func = cancel_func;
+  replay_baton->cancel_baton = cancel_baton;
+
+  err = svn_ra_replay_range(session, start_revision, end_revision,
+                            0, TRUE, replay_revstart, replay_revend,
+                            replay_baton, scratch_pool);
+  err = svn_error_compose_create(err, svn_stream_close(stream));
+  if (!err && final_path)
+    err = svn_io_file_rename2(tmp_path, final_path, TRUE, scratch_pool);
+
+  if (err)
+    return svn_error_compose_create(err,
+                                    svn_io_remove_file2(tmp_path, TRUE,
+                                                        scratch_pool));
+
+  *path = final_path ? final_path : tmp_path;
+  return SVN_NO_ERROR;
+}
+
+/* Dump the chunk of DUMP with index I using the sessions of WORKER and
+ * SCRATCH_POOL for temporaries.  Record the result in the chunk. */
+static void
+run_chunk(dump_worker_t *worker,
+          int i,
+          apr_pool_t *scratch_pool)
+{
+  chunked_dump_t *dump = worker->dump;
+  dump_chunk_t *chunk = &dump->chunks[i];
+  const char *path = NULL;
+  apr_pool_t *chunk_pool = svn_pool_create(NULL);
+  svn_error_t *err;
+
+  err = dump_chunk(&path, chunk->start_revision, chunk->end_revision,
+                   dump->checkpoint_dir, worker->session,
+                   worker->extra_ra_session, worker->cancel_func,
+                   worker->cancel_baton, chunk_pool, scratch_pool);
+
+#if APR_HAS_THREADS
+  if (dump->mutex)
+    apr_thread_mutex_lock(dump->mutex);
+#endif
+
+  chunk->pool = chunk_pool;
+  chunk->path = path;
+  chunk->err = err;
+  chunk->done = TRUE;
+  if (err)
+    dump->aborted = TRUE;
+
+#if APR_HAS_THREADS
+  if (dump->mutex)
+    {
+      apr_thread_cond_broadcast(dump->changed);
+      apr_thread_mutex_unlock(dump->mutex);
+    }
+#endif
+}
+
+#if APR_HAS_THREADS
+/* Implements svn_cancel_func_t for the dump threads.  BATON is the
+ * chunked_dump_t.  They get cancelled when the dump gets aborted. */
+static svn_error_t *
+worker_cancel(void *baton)
+{
+  chunked_dump_t *dump = baton;
+  svn_boolean_t aborted;
+
+  apr_thread_mutex_lock(dump->mutex);
+  aborted = dump->aborted;
+  apr_thread_mutex_unlock(dump->mutex);
+
+  return aborted ? svn_error_create(SVN_ERR_CANCELLED, NULL, NULL)
+                 : SVN_NO_ERROR;
+}
+
+/* Open the RA sessions of the dump thread WORKER to URL in WORKER->pool.
+ * Give them a client context of their own, so that the thread never
+ * invokes the callbacks of CTX and has an auth baton of its own.  Any
+ * prompting happens here, on the main thread.
+ */
+static svn_error_t *
+open_worker_sessions(dump_worker_t *worker,
+                     const char *url,
+                     svn_client_ctx_t *ctx)
+{
+  svn_client_ctx_t *worker_ctx;
+
+  SVN_ERR(svn_client_create_context2(&worker_ctx, ctx->config,
+                                     worker->pool));
+  if (ctx->auth_baton)
+    svn_auth__make_thread_auth(&worker_ctx->auth_baton, ctx->auth_baton,
+                               &worker->dump->detached, worker->pool);
+  worker_ctx->client_name = ctx->client_name;
+  worker_ctx->cancel_func = worker_cancel;
+  worker_ctx->cancel_baton = worker->dump;
+  worker->cancel_func = worker_cancel;
+  worker->cancel_baton = worker->dump;
+
+  SVN_ERR(svn_client_open_ra_session2(&worker->session, url, NULL,
+                                      worker_ctx, worker->pool,
+                                      worker->pool));
+  SVN_ERR(open_extra_ra_session(&worker->extra_ra_session, url,
+                                worker_ctx, worker->pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Dump thread main function.  DATA is the dump_worker_t.
+ * Dump chunks until there are no more or the dump got aborted.
+ */
+static void *
+APR_THREAD_FUNC dump_thread_func(apr_thread_t *tid, void *data)
+{
+  dump_worker_t *worker = data;
+  chunked_dump_t *dump = worker->dump;
+  apr_pool_t *iterpool = svn_pool_create(worker->pool);
+
+  while (TRUE)
+    {
+      int i = -1;
+
+      apr_thread_mutex_lock(dump->mutex);
+      if (!dump->aborted && dump->next_chunk < dump->chunk_count)
+        i = dump->next_chunk++;
+      apr_thread_mutex_unlock(dump->mutex);
+
+      if (i < 0)
+        break;
+
+      svn_pool_clear(iterpool);
+      run_chunk(worker, i, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+#endif
+
+/* Wait for chunk I of DUMP to be finished, or dump it right here using
+ * WORKER if there are no dump threads.  Set *DONE to FALSE if the chunk
+ * will never be done because the dump got aborted.  While waiting, check
+ * for cancellation, and abort the dump if cancelled. */
+static svn_error_t *
+wait_for_chunk(svn_boolean_t *done,
+               chunked_dump_t *dump,
+               int i,
+               dump_worker_t *worker,
+               apr_pool_t *scratch_pool)
+{
+  dump_chunk_t *chunk = &dump->chunks[i];
+
+#if APR_HAS_THREADS
+  if (dump->mutex)
+    {
+      svn_error_t *err = SVN_NO_ERROR;
+
+      apr_thread_mutex_lock(dump->mutex);
+      while (!chunk->done && !(dump->aborted && i >= dump->next_chunk))
+        {
+          apr_thread_cond_timedwait(dump->changed, dump->mutex,
+                                    CHUNK_POLL_INTERVAL);
+          if (check_cancel)
+            err = check_cancel(NULL);
+          if (err)
+            {
+              dump->aborted = TRUE;
+              break;
+            }
+        }
+      *done = chunk->done;
+      apr_thread_mutex_unlock(dump->mutex);
+
+      return svn_error_trace(err);
+    }
+#endif
+
+  run_chunk(worker, i, scratch_pool);
+  *done = chunk->done;
+
+  return SVN_NO_ERROR;
+}
+
+/* Dump START_REVISION thru END_REVISION incrementally to STDOUT_STREAM.
+ * Split the range into chunks and fetch JOBS of them concurrently over
+ * separate pairs of RA sessions to URL.  Without threads, use SESSION
+ * and EXTRA_RA_SESSION.  Otherwise, open a pair with the configuration
+ * and credentials of CTX for each thread.  Keep the chunks in
+ * CHECKPOINT_DIR, if not NULL.  Unless QUIET is set, generate progress
+ * messages on this thread as the chunks are written.
+ */
+static svn_error_t *
+dump_chunked(svn_stream_t *stdout_stream,
+             const char *url,
+             svn_client_ctx_t *ctx,
+             svn_ra_session_t *session,
+             svn_ra_session_t *extra_ra_session,
+             svn_revnum_t start_revision,
+             svn_revnum_t end_revision,
+             int jobs,
+             const char *checkpoint_dir,
+             svn_boolean_t quiet,
+             apr_pool_t *pool)
+{
+  chunked_dump_t *dump = apr_pcalloc(pool, sizeof(*dump));
+  apr_array_header_t *chunks;
+  dump_worker_t *workers;
+  int worker_count = 0;
+  svn_revnum_t chunk_size = CHECKPOINT_CHUNK_SIZE;
+  svn_revnum_t revision;
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  /* Without checkpoints to share, use smaller chunks so that all
+     connections stay busy until the end. */
+  if (!checkpoint_dir)
+    chunk_size = MAX(1, MIN(chunk_size,
+                            (end_revision - start_revision + 1)
+                              / (4 * jobs)));
+
+  chunks = apr_array_make(pool, 16, sizeof(dump_chunk_t));
+  for (revision = start_revision; revision <= end_revision; )
+    {
+      dump_chunk_t *chunk = apr_array_push(chunks);
+
+      memset(chunk, 0, sizeof(*chunk));
+      chunk->start_revision = revision;
+      chunk->end_revision = MIN(end_revision,
+                                revision - revision % chunk_size
+                                  + chunk_size - 1);
+      revision = chunk->end_revision + 1;
+    }
+
+  dump->chunks = (dump_chunk_t *)chunks->elts;
+  dump->chunk_count = chunks->nelts;
+  dump->checkpoint_dir = checkpoint_dir;
+
+  workers = apr_pcalloc(pool, jobs * sizeof(*workers));
+  workers[0].dump = dump;
+  workers[0].session = session;
+  workers[0].extra_ra_session = extra_ra_session;
+  workers[0].cancel_func = check_cancel;
+  workers[0].cancel_baton = NULL;
+  workers[0].pool = pool;
+
+#if APR_HAS_THREADS
+  if (jobs > 1 && dump->chunk_count > 1)
+    {
+      apr_status_t status;
+
+      status = apr_thread_mutex_create(&dump->mutex,
+                                       APR_THREAD_MUTEX_DEFAULT, pool);
+      if (!status)
+        status = apr_thread_cond_create(&dump->changed, pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create dump threads"));
+
+      /* Open all sessions while we are still single-threaded.  SESSION
+         and EXTRA_RA_SESSION use the callbacks of CTX and stay here. */
+      for (i = 0; i < jobs && i < dump->chunk_count; i++)
+        {
+          workers[i].dump = dump;
+          workers[i].pool = svn_pool_create(pool);
+          SVN_ERR(open_worker_sessions(&workers[i], url, ctx));
+        }
+
+      /* From here on, the sessions only use the credentials they have. */
+      dump->detached = TRUE;
+
+      for (i = 0; i < jobs && i < dump->chunk_count; i++)
+        {
+          status = apr_thread_create(&workers[i].tid, NULL,
+                                     dump_thread_func, &workers[i], pool);
+          if (status)
+            {
+              err = svn_error_wrap_apr(status,
+                                       _("Can't create dump threads"));
+              break;
+            }
+
+          ++worker_count;
+        }
+    }
+#endif
+
+  /* Write the chunks in order as they become available. */
+  iterpool = svn_pool_create(pool);
+  for (i = 0; !err && i < dump->chunk_count; i++)
+    {
+      dump_chunk_t *chunk = &dump->chunks[i];
+      svn_stream_t *chunk_stream;
+      svn_boolean_t done;
+
+      svn_pool_clear(iterpool);
+      err = wait_for_chunk(&done, dump, i, &workers[0], iterpool);
+      if (err || !done || chunk->err)
+        break;
+
+      err = svn_stream_open_readonly(&chunk_stream, chunk->path, iterpool,
+                                     iterpool);
+      if (!err)
+        err = svn_stream_copy3(chunk_stream,
+                               svn_stream_disown(stdout_stream, iterpool),
+                               check_cancel, NULL, iterpool);
+      if (!err && !checkpoint_dir)
+        err = svn_io_remove_file2(chunk->path, TRUE, iterpool);
+
+      for (revision = chunk->start_revision;
+           !err && !quiet && revision <= chunk->end_revision;
+           revision++)
+        err = svn_cmdline_fprintf(stderr, iterpool,
+                                  "* Dumped revision %lu.\n", revision);
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Stop the threads and clean up. */
+#if APR_HAS_THREADS
+  if (dump->mutex)
+    {
+      apr_thread_mutex_lock(dump->mutex);
+      dump->aborted = TRUE;
+      apr_thread_mutex_unlock(dump->mutex);
+    }
+
+  for (i = 0; i < worker_count; i++)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, workers[i].tid);
+    }
+#endif
+
+  for (i = 0; i < dump->chunk_count; i++)
+    {
+      dump_chunk_t *chunk = &dump->chunks[i];
+
+      err = svn_error_compose_create(err, chunk->err);
+      if (chunk->path && !checkpoint_dir)
+        svn_error_clear(svn_io_remove_file2(chunk->path, TRUE, pool));
+      if (chunk->pool)
+        svn_pool_destroy(chunk->pool);
+    }
+
+  return svn_error_trace(err);
+}
+
 /* Replay revisions START_REVISION thru END_REVISION (inclusive) of
  * the repository URL at which SESSION is rooted, using callbacks
  * which generate Subversion repository dumpstreams describing the
  * changes made in those revisions.  If QUIET is set, don't generate
  * progress messages.
+ *
+ * If JOBS is larger than 1 or CHECKPOINT_DIR is not NULL, fetch the
+ * incremental part of the dump as per dump_chunked(), opening additional
+ * sessions to URL with CTX.
  */
 static svn_error_t *
 replay_revisions(svn_ra_session_t *session,
@@ -463,6 +1022,10 @@ replay_revisions(svn_ra_session_t *session,
                  svn_revnum_t end_revision,
                  svn_boolean_t quiet,
                  svn_boolean_t incremental,
+                 int jobs,
+                 const char *checkpoint_dir,
+                 const char *url,
+                 svn_client_ctx_t *ctx,
                  apr_pool_t *pool)
 {
   struct replay_baton *replay_baton;
@@ -475,12 +1038,17 @@ replay_revisions(svn_ra_session_t *session,
   replay_baton->stdout_stream = stdout_stream;
   replay_baton->extra_ra_session = extra_ra_session;
   replay_baton->quiet = quiet;
+  replay_baton->cancel_func = check_cancel;
+  replay_baton->cancel_baton = NULL;
+
+  SVN_ERR(svn_ra_get_uuid2(session, &uuid, pool));
+  if (checkpoint_dir)
+    SVN_ERR(check_checkpoint_dir(checkpoint_dir, url, uuid, pool));
 
   /* Write the magic header and UUID */
   SVN_ERR(svn_stream_printf(stdout_stream, pool,
                             SVN_REPOS_DUMPFILE_MAGIC_HEADER ": %d\n\n",
                             SVN_REPOS_DUMPFILE_FORMAT_VERSION));
-  SVN_ERR(svn_ra_get_uuid2(session, &uuid, pool));
   SVN_ERR(svn_stream_printf(stdout_stream, pool,
                             SVN_REPOS_DUMPFILE_UUID ": %s\n\n", uuid));
 
@@ -512,7 +1080,13 @@ replay_revisions(svn_ra_session_t *session,
     }
 
   /* If there are still revisions left to be dumped, do so. */
-  if (start_revision <= end_revision)
+  if (start_revision <= end_revision && (jobs > 1 || checkpoint_dir))
+    {
+      SVN_ERR(dump_chunked(stdout_stream, url, ctx, session,
+                           extra_ra_session, start_revision, end_revision,
+                           jobs, checkpoint_dir, quiet, pool));
+    }
+  else if (start_revision <= end_revision)
     {
 #ifndef USE_EV2_IMPL
       SVN_ERR(svn_ra_replay_range(session, start_revision, end_revision,
@@ -605,18 +1179,16 @@ dump_cmd(apr_getopt_t *os,
 {
   opt_baton_t *opt_baton = baton;
   svn_ra_session_t *extra_ra_session;
-  const char *repos_root;
 
-  SVN_ERR(svn_client_open_ra_session2(&extra_ra_session,
-                                      opt_baton->url, NULL,
-                                      opt_baton->ctx, pool, pool));
-  SVN_ERR(svn_ra_get_repos_root2(extra_ra_session, &repos_root, pool));
-  SVN_ERR(svn_ra_reparent(extra_ra_session, repos_root, pool));
+  SVN_ERR(open_extra_ra_session(&extra_ra_session, opt_baton->url,
+                                opt_baton->ctx, pool));
 
   return replay_revisions(opt_baton->session, extra_ra_session,
                           opt_baton->start_revision.value.number,
                           opt_baton->end_revision.value.number,
-                          opt_baton->quiet, opt_baton->incremental, pool);
+                          opt_baton->quiet, opt_baton->incremental,
+                          opt_baton->jobs, opt_baton->checkpoint_dir,
+                          opt_baton->url, opt_baton->ctx, pool);
 }
 
 /* Handle the "load" subcommand.  Implements `svn_opt_subcommand_t'.  */
@@ -777,6 +1349,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_baton->start_revision.kind = svn_opt_revision_unspecified;
   opt_baton->end_revision.kind = svn_opt_revision_unspecified;
   opt_baton->url = NULL;
+  opt_baton->jobs = 1;
   opt_baton->skip_revprops = apr_hash_make(pool);
 
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -862,6 +1435,21 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
         case opt_incremental:
           opt_baton->incremental = TRUE;
           break;
+        case opt_jobs:
+          {
+            const char *utf8_opt_arg;
+            SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+            err = svn_cstring_atoi(&opt_baton->jobs, utf8_opt_arg);
+            if (err || opt_baton->jobs < 1)
+              return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                       _("Invalid number of jobs '%s'"),
+                                       utf8_opt_arg);
+          }
+          break;
+        case opt_checkpoint_dir:
+          SVN_ERR(svn_utf_cstring_to_utf8(&opt_arg, opt_arg, pool));
+          opt_baton->checkpoint_dir = svn_dirent_internal_style(opt_arg, pool);
+          break;
         case opt_skip_revprop:
           SVN_ERR(svn_utf_cstring_to_utf8(&opt_arg, opt_arg, pool));
           svn_hash_sets(opt_baton->skip_revprops, opt_arg, opt_arg);
@@ -1098,10 +1686,10 @@ main(int argc, const char *argv[])
   if (svn_cmdline_init("svnrdump", stderr) != EXIT_SUCCESS)
     return EXIT_FAILURE;
 
-  /* Create our top-level pool.  Use a separate mutexless allocator,
-   * given this application is single threaded.
+  /* Create our top-level pool.  Use a separate allocator with a mutex,
+   * since 'dump --jobs' uses several threads.
    */
-  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
 
   err = sub_main(&exit_code, argc, argv, pool);
 
@@ -25,10 +25,13 @@
 
 #define APR_WANT_STRFUNC
 #include <apr_want.h>
+#include <apr_thread_proc.h>
+#include <apr_thread_cond.h>
 
 #include "svn_error.h"
 #include "svn_io.h"
 #include "svn_pools.h"
+#include "svn_string.h"
 #include "svn_time.h"
 
 #include "private/svn_mutex.h"
@@ -40,6 +43,49 @@
 #include <unistd.h>   /* For getpid() */
 #endif
 
+#if APR_HAS_THREADS
+
+/* State of a logger that writes from a background thread.  All members
+ * are protected by the logger's mutex.
+ */
+typedef struct async_t
+{
+  /* Log data waiting to be written. */
+  svn_stringbuf_t *buffer;
+
+  /* Second buffer, owned by the flusher thread while it writes. */
+  svn_stringbuf_t *spare;
+
+  /* Try to keep BUFFER below this size. */
+  apr_size_t capacity;
+
+  /* If set, discard new entries while BUFFER is full.  Otherwise, make the
+   * writer wait for the flusher thread. */
+  svn_boolean_t drop_on_overflow;
+
+  /* Number of entries dropped since the last flush. */
+  apr_uint64_t dropped;
+
+  /* Signalled whenever BUFFER becomes non-empty or has been written. */
+  apr_thread_cond_t *changed;
+
+  /* The flusher thread and the process it has been started in.  Threads
+   * don't survive a fork, so we start a new one in every process. */
+  apr_thread_t *thread;
+  apr_int64_t owner_pid;
+
+  /* Set to stop the flusher thread. */
+  svn_boolean_t shutdown;
+
+  /* Pool for the flusher thread's temporary allocations. */
+  apr_pool_t *thread_pool;
+
+  /* Pool to create the flusher threads in. */
+  apr_pool_t *pool;
+} async_t;
+
+#endif
+
 struct logger_t
 {
   /* actual log file / stream object */
@@ -50,6 +96,14 @@ struct logger_t
 
   /* private pool used for temporary allocations */
   apr_pool_t *pool;
+
+  /* format of the log entries */
+  logger_format_t format;
+
+#if APR_HAS_THREADS
+  /* If not NULL, the stream gets written by a background thread. */
+  async_t *async;
+#endif
 };
 
 svn_error_t *
@@ -88,6 +142,307 @@ logger__create(logger_t **logger,
   return SVN_NO_ERROR;
 }
 
+void
+logger__set_format(logger_t *logger,
+                   logger_format_t format)
+{
+  logger->format = format;
+}
+
+/* Append VALUE as a quoted JSON string to BUFFER. */
+static void
+append_json_string(svn_stringbuf_t *buffer,
+                   const char *value)
+{
+  svn_stringbuf_appendbyte(buffer, '"');
+  for (; *value; ++value)
+    {
+      unsigned char c = (unsigned char)*value;
+      if (c == '"' || c == '\\')
+        {
+          svn_stringbuf_appendbyte(buffer, '\\');
+          svn_stringbuf_appendbyte(buffer, c);
+        }
+      else if (c < 0x20)
+        {
+          char escaped[8];
+          apr_snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+          svn_stringbuf_appendcstr(buffer, escaped);
+        }
+      else
+        {
+          svn_stringbuf_appendbyte(buffer, c);
+        }
+    }
+  svn_stringbuf_appendbyte(buffer, '"');
+}
+
+/* Append the opening of a JSON log entry with the fields common to all
+ * entries to BUFFER.  TIMESTR, REMOTE_HOST, USER and REPOS may be NULL.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static void
+append_json_header(svn_stringbuf_t *buffer,
+                   const char *timestr,
+                   const char *remote_host,
+                   const char *user,
+                   const char *repos,
+                   apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_appendcstr(buffer,
+                           apr_psprintf(scratch_pool,
+                                        "{\"pid\":%" APR_PID_T_FMT,
+                                        getpid()));
+  if (timestr)
+    {
+      svn_stringbuf_appendcstr(buffer, ",\"time\":");
+      append_json_string(buffer, timestr);
+    }
+  if (remote_host)
+    {
+      svn_stringbuf_appendcstr(buffer, ",\"host\":");
+      append_json_string(buffer, remote_host);
+    }
+  if (user)
+    {
+      svn_stringbuf_appendcstr(buffer, ",\"user\":");
+      append_json_string(buffer, user);
+    }
+  if (repos)
+    {
+      svn_stringbuf_appendcstr(buffer, ",\"repos\":");
+      append_json_string(buffer, repos);
+    }
+}
+
+#if APR_HAS_THREADS
+
+/* Return the log entry reporting that COUNT entries have been dropped
+ * in LOGGER's format.  Allocate it in RESULT_POOL.
+ */
+static svn_stringbuf_t *
+dropped_entry(logger_t *logger,
+              apr_uint64_t count,
+              apr_pool_t *result_pool)
+{
+  const char *timestr = svn_time_to_cstring(apr_time_now(), result_pool);
+  svn_stringbuf_t *entry;
+
+  if (logger->format == logger_format_json)
+    {
+      entry = svn_stringbuf_create_empty(result_pool);
+      append_json_header(entry, timestr, NULL, NULL, NULL, result_pool);
+      svn_stringbuf_appendcstr(entry,
+                               apr_psprintf(result_pool,
+                                            ",\"dropped\":%" APR_UINT64_T_FMT
+                                            "}" APR_EOL_STR,
+                                            count));
+    }
+  else
+    {
+      entry = svn_stringbuf_createf(result_pool,
+                                    "%" APR_PID_T_FMT " %s - - - "
+                                    "DROPPED %" APR_UINT64_T_FMT
+                                    " log entries" APR_EOL_STR,
+                                    getpid(), timestr, count);
+    }
+
+  return entry;
+}
+
+/* Thread function writing the buffered data of the logger_t BATON.
+ */
+static void * APR_THREAD_FUNC
+flusher_thread_func(apr_thread_t *thread,
+                    void *baton)
+{
+  logger_t *logger = baton;
+  async_t *async = logger->async;
+  apr_thread_mutex_t *mutex = svn_mutex__get(logger->mutex);
+
+  apr_thread_mutex_lock(mutex);
+  while (!async->shutdown || async->buffer->len)
+    {
+      svn_stringbuf_t *data;
+      apr_uint64_t dropped;
+      apr_size_t len;
+
+      if (async->buffer->len == 0)
+        {
+          apr_thread_cond_wait(async->changed, mutex);
+          continue;
+        }
+
+      /* Take the pending data and let new entries go into the other
+       * buffer while we write. */
+      data = async->buffer;
+      async->buffer = async->spare;
+      async->spare = NULL;
+      dropped = async->dropped;
+      async->dropped = 0;
+      apr_thread_mutex_unlock(mutex);
+
+      len = data->len;
+      svn_error_clear(svn_stream_write(logger->stream, data->data, &len));
+      if (dropped)
+        {
+          svn_stringbuf_t *entry = dropped_entry(logger, dropped,
+                                                 async->thread_pool);
+          len = entry->len;
+          svn_error_clear(svn_stream_write(logger->stream, entry->data,
+                                           &len));
+          svn_pool_clear(async->thread_pool);
+        }
+
+      svn_stringbuf_setempty(data);
+
+      apr_thread_mutex_lock(mutex);
+      async->spare = data;
+      apr_thread_cond_broadcast(async->changed);
+    }
+  apr_thread_mutex_unlock(mutex);
+
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+/* Make sure that LOGGER's flusher thread runs in this process.  Return
+ * FALSE if that is not possible.  The caller must hold the mutex.
+ */
+static svn_boolean_t
+ensure_flusher_thread(logger_t *logger)
+{
+  async_t *async = logger->async;
+  apr_int64_t pid = (apr_int64_t)getpid();
+
+  if (async->owner_pid != pid)
+    {
+      apr_status_t status;
+
+      /* Data inherited from the parent process will be written by it. */
+      if (async->owner_pid != -1)
+        {
+          svn_stringbuf_setempty(async->buffer);
+          async->dropped = 0;
+        }
+
+      async->owner_pid = pid;
+      status = apr_thread_create(&async->thread, NULL, flusher_thread_func,
+                                 logger, async->pool);
+      if (status)
+        async->thread = NULL;
+    }
+
+  return async->thread != NULL;
+}
+
+/* Pool cleanup function stopping the flusher thread of the logger_t
+ * BATON and writing all remaining data.
+ */
+static apr_status_t
+async_cleanup(void *baton)
+{
+  logger_t *logger = baton;
+  async_t *async = logger->async;
+  apr_thread_mutex_t *mutex = svn_mutex__get(logger->mutex);
+
+  if (async->thread && async->owner_pid == (apr_int64_t)getpid())
+    {
+      apr_status_t retval;
+
+      apr_thread_mutex_lock(mutex);
+      async->shutdown = TRUE;
+      apr_thread_cond_broadcast(async->changed);
+      apr_thread_mutex_unlock(mutex);
+
+      apr_thread_join(&retval, async->thread);
+    }
+
+  /* Whatever the flusher did not get to, e.g. in a forked process. */
+  if (async->buffer->len)
+    {
+      apr_size_t len = async->buffer->len;
+      svn_error_clear(svn_stream_write(logger->stream, async->buffer->data,
+                                       &len));
+    }
+
+  logger->async = NULL;
+  return APR_SUCCESS;
+}
+
+#endif
+
+svn_error_t *
+logger__set_async(logger_t *logger,
+                  apr_size_t buffer_size,
+                  svn_boolean_t drop_on_overflow,
+                  apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  async_t *async = apr_pcalloc(pool, sizeof(*async));
+  apr_status_t status;
+
+  async->buffer = svn_stringbuf_create_ensure(buffer_size, pool);
+  async->spare = svn_stringbuf_create_ensure(buffer_size, pool);
+  async->capacity = buffer_size;
+  async->drop_on_overflow = drop_on_overflow;
+  async->owner_pid = -1;
+  async->thread_pool = svn_pool_create(pool);
+  async->pool = pool;
+
+  status = apr_thread_cond_create(&async->changed, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create log flusher"));
+
+  /* The flusher gets started upon the first write.  That way, we get one
+   * in every process forked before that.  The flusher must be stopped
+   * before the pools it uses go away. */
+  logger->async = async;
+  apr_pool_pre_cleanup_register(pool, logger, async_cleanup);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Write ENTRY to the log file managed by LOGGER or queue it for the
+ * flusher thread.  The caller must hold LOGGER's mutex.
+ */
+static void
+write_entry(logger_t *logger,
+            const svn_stringbuf_t *entry)
+{
+  apr_size_t len = entry->len;
+
+#if APR_HAS_THREADS
+  async_t *async = logger->async;
+  if (async && ensure_flusher_thread(logger))
+    {
+      apr_thread_mutex_t *mutex = svn_mutex__get(logger->mutex);
+
+      /* An entry larger than the whole buffer still gets through. */
+      while (async->buffer->len
+             && async->buffer->len + len > async->capacity)
+        {
+          if (async->drop_on_overflow)
+            {
+              ++async->dropped;
+              return;
+            }
+
+          apr_thread_cond_wait(async->changed, mutex);
+        }
+
+      svn_stringbuf_appendbytes(async->buffer, entry->data, len);
+      if (async->buffer->len == len)
+        apr_thread_cond_broadcast(async->changed);
+
+      return;
+    }
+#endif
+
+  svn_error_clear(svn_stream_write(logger->stream, entry->data, &len));
+}
+
 void
 logger__log_error(logger_t *logger,
                   svn_error_t *err,
@@ -101,6 +456,7 @@ logger__log_error(logger_t *logger,
       char errbuf[256];
       /* 8192 from MAX_STRING_LEN in from httpd-2.2.4/include/httpd.h */
       char errstr[8192];
+      svn_stringbuf_t *entry;
 
       svn_error_clear(svn_mutex__lock(logger->mutex));
 
@@ -115,18 +471,46 @@ logger__log_error(logger_t *logger,
             ? repository->repos_name
              : "-";
 
+      /* Collect the whole chain, so it stays together in the log. */
+      entry = svn_stringbuf_create_empty(logger->pool);
       continuation = "";
       while (err)
         {
           const char *message = svn_err_best_message(err, errbuf, sizeof(errbuf));
+          apr_size_t len;
+
+          if (logger->format == logger_format_json)
+            {
+              append_json_header(entry, timestr, remote_host, user, repos,
+                                 logger->pool);
+              svn_stringbuf_appendcstr(entry, ",\"level\":\"ERR\"");
+              if (*continuation)
+                svn_stringbuf_appendcstr(entry, ",\"continuation\":true");
+              svn_stringbuf_appendcstr(entry, ",\"file\":");
+              append_json_string(entry, err->file ? err->file : "-");
+              svn_stringbuf_appendcstr(entry,
+                                       apr_psprintf(logger->pool,
+                                                    ",\"line\":%ld"
+                                                    ",\"apr_err\":%d"
+                                                    ",\"message\":",
+                                                    err->line,
+                                                    err->apr_err));
+              append_json_string(entry, message);
+              svn_stringbuf_appendcstr(entry, "}" APR_EOL_STR);
+
+              continuation = "-";
+              err = err->child;
+              continue;
+            }
+
           /* based on httpd-2.2.4/server/log.c:log_error_core */
-          apr_size_t len = apr_snprintf(errstr, sizeof(errstr),
-                                        "%" APR_PID_T_FMT
-                                        " %s %s %s %s ERR%s %s %ld %d ",
-                                        getpid(), timestr, remote_host, user,
-                                        repos, continuation,
-                                        err->file ? err->file : "-", err->line,
-                                        err->apr_err);
+          len = apr_snprintf(errstr, sizeof(errstr),
+                             "%" APR_PID_T_FMT
+                             " %s %s %s %s ERR%s %s %ld %d ",
+                             getpid(), timestr, remote_host, user,
+                             repos, continuation,
+                             err->file ? err->file : "-", err->line,
+                             err->apr_err);
 
           len += escape_errorlog_item(errstr + len, message,
                                       sizeof(errstr) - len);
@@ -138,24 +522,53 @@ logger__log_error(logger_t *logger,
           memcpy(errstr + len, APR_EOL_STR, sizeof(APR_EOL_STR));
           len += sizeof(APR_EOL_STR) -1;  /* add NL, ex terminating NUL */
 
-          svn_error_clear(svn_stream_write(logger->stream, errstr, &len));
+          svn_stringbuf_appendbytes(entry, errstr, len);
 
           continuation = "-";
           err = err->child;
         }
 
+      write_entry(logger, entry);
       svn_pool_clear(logger->pool);
 
       svn_error_clear(svn_mutex__unlock(logger->mutex, SVN_NO_ERROR));
     }
 }
 
-svn_error_t *
-logger__write(logger_t *logger,
-              const char *errstr,
-              apr_size_t len)
+void
+logger__log_request(logger_t *logger,
+                    const char *remote_host,
+                    const char *user,
+                    const char *repos,
+                    const char *message,
+                    apr_pool_t *scratch_pool)
 {
-  SVN_MUTEX__WITH_LOCK(logger->mutex,
-                       svn_stream_write(logger->stream, errstr, &len));
-  return SVN_NO_ERROR;
+  const char *timestr = svn_time_to_cstring(apr_time_now(), scratch_pool);
+  svn_stringbuf_t *entry;
+
+  remote_host = remote_host ? remote_host : "-";
+  user = user ? user : "-";
+  repos = repos ? repos : "-";
+
+  if (logger->format == logger_format_json)
+    {
+      entry = svn_stringbuf_create_empty(scratch_pool);
+      append_json_header(entry, timestr, remote_host, user, repos,
+                         scratch_pool);
+      svn_stringbuf_appendcstr(entry, ",\"message\":");
+      append_json_string(entry, message);
+      svn_stringbuf_appendcstr(entry, "}" APR_EOL_STR);
+    }
+  else
+    {
+      entry = svn_stringbuf_createf(scratch_pool,
+                                    "%" APR_PID_T_FMT
+                                    " %s %s %s %s %s" APR_EOL_STR,
+                                    getpid(), timestr, remote_host, user,
+                                    repos, message);
+    }
+
+  svn_error_clear(svn_mutex__lock(logger->mutex));
+  write_entry(logger, entry);
+  svn_error_clear(svn_mutex__unlock(logger->mutex, SVN_NO_ERROR));
 }
@@ -37,6 +37,16 @@ extern "C" {
  */
 typedef struct logger_t logger_t;
 
+/* Formats that log entries may be written in. */
+typedef enum logger_format_t
+{
+  /* One line of space-separated fields per entry.  This is the default. */
+  logger_format_text,
+
+  /* One JSON object per line. */
+  logger_format_json
+} logger_format_t;
+
 /* In POOL, create a writer object that will write log messages to stderr
  * and return it in *LOGGER.  The log file will not add any buffering
  * on top of stderr.
@@ -54,12 +64,40 @@ logger__create(logger_t **logger,
                const char *filename,
                apr_pool_t *pool);
 
-/* Write the first LEN bytes from ERRSTR to the log file managed by LOGGER.
+/* Make LOGGER write all further entries in FORMAT.
+ */
+void
+logger__set_format(logger_t *logger,
+                   logger_format_t format);
+
+/* Make LOGGER collect up to BUFFER_SIZE bytes of log entries in memory
+ * and write them to the log file from a background thread.  If that
+ * buffer is full, new entries get dropped if DROP_ON_OVERFLOW is set;
+ * the number of dropped entries will be logged.  Otherwise, the writer
+ * waits until there is space in the buffer again.
+ *
+ * POOL must be the pool that LOGGER has been created in.  Any buffered
+ * data will be written when POOL gets cleared or destroyed.  Without
+ * thread support, this is a no-op.
  */
 svn_error_t *
-logger__write(logger_t *logger,
-              const char *errstr,
-              apr_size_t len);
+logger__set_async(logger_t *logger,
+                  apr_size_t buffer_size,
+                  svn_boolean_t drop_on_overflow,
+                  apr_pool_t *pool);
+
+/* Write a log entry for a request with MESSAGE as its description to the
+ * log file managed by LOGGER.  REMOTE_HOST, USER and REPOS identify the
+ * client and repository and may be NULL.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+void
+logger__log_request(logger_t *logger,
+                    const char *remote_host,
+                    const char *user,
+                    const char *repos,
+                    const char *message,
+                    apr_pool_t *scratch_pool);
 
 /* Write a description of ERR with additional information from REPOSITORY
  * and CLIENT_INFO to the log file managed by LOGGER.  REPOSITORY as well
@@ -50,11 +50,16 @@
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
 #include "svn_user.h"
+#include "svn_sorts.h"
+#include "svn_diff.h"
 
 #include "private/svn_log.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_ra_svn_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_fs_private.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_subr_private.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
@@ -63,6 +68,10 @@
 #include "server.h"
 #include "logger.h"
 
+/* Maximum size of a single string when sending file contents straight from
+ * the repository files.  Clients have to buffer each string in full. */
+#define FILE_RANGE_CHUNK_SIZE 0x100000
+
 typedef struct commit_callback_baton_t {
   apr_pool_t *pool;
   svn_revnum_t *new_rev;
@@ -97,6 +106,12 @@ typedef struct file_revs_baton_t {
   apr_pool_t *pool;  /* Pool provided in the handler call. */
 } file_revs_baton_t;
 
+typedef struct file_blame_baton_t {
+  svn_ra_svn_conn_t *conn;
+  apr_hash_t *sent_revs;  /* Revisions whose revprops were sent already. */
+  apr_pool_t *pool;       /* For SENT_REVS. */
+} file_blame_baton_t;
+
 typedef struct fs_warning_baton_t {
   server_baton_t *server;
   svn_ra_svn_conn_t *conn;
@@ -148,29 +163,21 @@ static svn_error_t *log_command(server_baton_t *b,
                                 apr_pool_t *pool,
                                 const char *fmt, ...)
 {
-  const char *remote_host, *timestr, *log, *line;
+  const char *log;
   va_list ap;
-  apr_size_t nbytes;
 
   if (b->logger == NULL)
     return SVN_NO_ERROR;
 
-  remote_host = svn_ra_svn_conn_remote_host(conn);
-  timestr = svn_time_to_cstring(apr_time_now(), pool);
-
   va_start(ap, fmt);
   log = apr_pvsprintf(pool, fmt, ap);
   va_end(ap);
 
-  line = apr_psprintf(pool, "%" APR_PID_T_FMT
-                      " %s %s %s %s %s" APR_EOL_STR,
-                      getpid(), timestr,
-                      (remote_host ? remote_host : "-"),
-                      (b->client_info->user ? b->client_info->user : "-"),
-                      b->repository->repos_name, log);
-  nbytes = strlen(line);
+  logger__log_request(b->logger, svn_ra_svn_conn_remote_host(conn),
+                      b->client_info->user, b->repository->repos_name,
+                      log, pool);
 
-  return logger__write(b->logger, line, nbytes);
+  return SVN_NO_ERROR;
 }
 
 /* Log an authz failure */
@@ -180,7 +187,7 @@ log_authz_denied(const char *path,
                  server_baton_t *b,
                  apr_pool_t *pool)
 {
-  const char *timestr, *remote_host, *line;
+  const char *message;
 
   if (!b->logger)
     return SVN_NO_ERROR;
@@ -188,20 +195,16 @@ log_authz_denied(const char *path,
   if (!b->client_info || !b->client_info->user)
     return SVN_NO_ERROR;
 
-  timestr = svn_time_to_cstring(apr_time_now(), pool);
-  remote_host = b->client_info->remote_host;
+  message = apr_psprintf(pool, "Authorization Failed %s%s %s",
+                         (required & svn_authz_recursive ? "recursive " : ""),
+                         (required & svn_authz_write ? "write" : "read"),
+                         (path && path[0] ? path : "/"));
 
-  line = apr_psprintf(pool, "%" APR_PID_T_FMT
-                      " %s %s %s %s Authorization Failed %s%s %s" APR_EOL_STR,
-                      getpid(), timestr,
-                      (remote_host ? remote_host : "-"),
-                      b->client_info->user,
-                      b->repository->repos_name,
-                      (required & svn_authz_recursive ? "recursive " : ""),
-                      (required & svn_authz_write ? "write" : "read"),
-                      (path && path[0] ? path : "/"));
+  logger__log_request(b->logger, b->client_info->remote_host,
+                      b->client_info->user, b->repository->repos_name,
+                      message, pool);
 
-  return logger__write(b->logger, line, strlen(line));
+  return SVN_NO_ERROR;
 }
 
 /* If CFG specifies a path to the password DB, read that DB through
@@ -815,7 +818,8 @@ static svn_error_t *must_have_access(svn_ra_svn_conn_t *conn,
   if (b->client_info->user == NULL
       && b->repository->auth_access >= req
       && (b->client_info->tunnel_user || b->repository->pwdb
-          || b->repository->use_sasl))
+          || b->repository->use_sasl)
+      && !b->pipelined)
     SVN_ERR(auth_request(conn, pool, b, req, TRUE));
 
   /* Now that an authentication has been done get the new take of
@@ -854,7 +858,7 @@ static svn_error_t *set_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                                   &depth_word));
   if (depth_word)
     depth = svn_depth_from_word(depth_word);
-  path = svn_relpath_canonicalize(path, pool);
+  path = svn_relpath__canonicalize_lazy(path, pool);
   if (b->from_rev && strcmp(path, "") == 0)
     *b->from_rev = rev;
   if (!b->err)
@@ -873,7 +877,7 @@ static svn_error_t *delete_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   const char *path;
 
   SVN_ERR(svn_ra_svn__parse_tuple(params, "c", &path));
-  path = svn_relpath_canonicalize(path, pool);
+  path = svn_relpath__canonicalize_lazy(path, pool);
   if (!b->err)
     b->err = svn_repos_delete_path(b->report_baton, path, pool);
   return SVN_NO_ERROR;
@@ -895,8 +899,8 @@ static svn_error_t *link_path(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 
   /* ### WHAT?!  The link path is an absolute URL?!  Didn't see that
      coming...   -- cmpilato  */
-  path = svn_relpath_canonicalize(path, pool);
-  url = svn_uri_canonicalize(url, pool);
+  path = svn_relpath__canonicalize_lazy(path, pool);
+  url = svn_uri__canonicalize_lazy(url, pool);
   if (depth_word)
     depth = svn_depth_from_word(depth_word);
   if (!b->err)
@@ -988,6 +992,7 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
                                       authz_check_access_cb_func(b),
                                       &ab, svn_ra_svn_zero_copy_limit(conn),
                                       pool));
+  svn_repos__report_set_prefetch_jobs(report_baton, b->update_threads);
 
   rb.sb = b;
   rb.repos_url = svn_path_uri_decode(b->repository->repos_url, pool);
@@ -1436,6 +1441,21 @@ unlock_paths(const svn_ra_svn__list_t *lock_tokens,
   return SVN_NO_ERROR;
 }
 
+/* Run the post-commit hooks queued for the repository of B.  The client
+   has no way to learn about their errors anymore, so just log them. */
+static void
+run_post_commit_queue(server_baton_t *b,
+                      apr_pool_t *pool)
+{
+  svn_error_t *err = svn_repos__run_post_commit_queue(b->repository->repos,
+                                                      pool);
+  if (err)
+    {
+      log_error(err, b);
+      svn_error_clear(err);
+    }
+}
+
 static svn_error_t *
 commit(svn_ra_svn_conn_t *conn,
        apr_pool_t *pool,
@@ -1536,7 +1556,11 @@ commit(svn_ra_svn_conn_t *conn,
          answering the client, to avoid user-visible delay. */
 
       if (b->client_info->tunnel)
-        SVN_ERR(svn_fs_deltify_revision(b->repository->fs, new_rev, pool));
+        {
+          SVN_ERR(svn_fs_deltify_revision(b->repository->fs, new_rev, pool));
+          if (b->repository->async_post_commit)
+            run_post_commit_queue(b, pool);
+        }
 
       /* Unlock the paths. */
       if (! keep_locks && lock_tokens && lock_tokens->nelts)
@@ -1546,7 +1570,15 @@ commit(svn_ra_svn_conn_t *conn,
                                       new_rev, date, author, post_commit_err));
 
       if (! b->client_info->tunnel)
-        SVN_ERR(svn_fs_deltify_revision(b->repository->fs, new_rev, pool));
+        {
+          /* Let the client continue while the hooks run. */
+          if (b->repository->async_post_commit)
+            SVN_ERR(svn_ra_svn__flush(conn, pool));
+
+          SVN_ERR(svn_fs_deltify_revision(b->repository->fs, new_rev, pool));
+          if (b->repository->async_post_commit)
+            run_post_commit_queue(b, pool);
+        }
     }
   return SVN_NO_ERROR;
 }
@@ -1562,6 +1594,9 @@ get_file(svn_ra_svn_conn_t *conn,
   svn_revnum_t rev;
   svn_fs_root_t *root;
   svn_stream_t *contents;
+  apr_file_t *contents_file = NULL;
+  apr_off_t contents_offset;
+  svn_filesize_t contents_length;
   apr_hash_t *props = NULL;
   apr_array_header_t *inherited_props;
   svn_string_t write_str;
@@ -1614,7 +1649,15 @@ get_file(svn_ra_svn_conn_t *conn,
                           &ab, root, full_path,
                           pool));
   if (want_contents)
-    SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
+    {
+      /* Unmodified fulltexts can be sent straight from the repository. */
+      SVN_CMD_ERR(svn_fs__try_get_file_range(&contents_file,
+                                             &contents_offset,
+                                             &contents_length,
+                                             root, full_path, pool, pool));
+      if (!contents_file)
+        SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
+    }
 
   /* Send successful command response with revision and props. */
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((?c)r(!", "success",
@@ -1644,7 +1687,25 @@ get_file(svn_ra_svn_conn_t *conn,
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
 
   /* Now send the file's contents. */
-  if (want_contents)
+  if (want_contents && contents_file)
+    {
+      /* Don't make the client buffer arbitrarily large strings. */
+      while (contents_length > 0)
+        {
+          apr_size_t chunk_size
+            = (apr_size_t)MIN(contents_length, FILE_RANGE_CHUNK_SIZE);
+
+          SVN_ERR(svn_ra_svn__write_file_range(conn, pool, contents_file,
+                                               contents_offset, chunk_size));
+          contents_offset += chunk_size;
+          contents_length -= chunk_size;
+        }
+
+      SVN_ERR(svn_io_file_close(contents_file, pool));
+      SVN_ERR(svn_ra_svn__write_cstring(conn, pool, ""));
+      SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+    }
+  else if (want_contents)
     {
       err = SVN_NO_ERROR;
       while (1)
@@ -1747,7 +1808,7 @@ get_dir(svn_ra_svn_conn_t *conn,
   svn_revnum_t rev;
   apr_hash_t *entries, *props = NULL;
   apr_array_header_t *inherited_props;
-  apr_hash_index_t *hi;
+  apr_array_header_t *ordered;
   svn_fs_root_t *root;
   apr_pool_t *subpool;
   svn_boolean_t want_props, want_contents;
@@ -1799,8 +1860,16 @@ get_dir(svn_ra_svn_conn_t *conn,
   /* Fetch the directories' entries before starting the response, to allow
      proper error handling in cases like when FULL_PATH doesn't exist */
   if (want_contents)
+    {
       SVN_CMD_ERR(svn_fs_dir_entries(&entries, root, full_path, pool));
 
+      /* Visit the entries in the order in which the FS stores the nodes.
+         That makes looking up the dirent fields much faster for large
+         directories. */
+      SVN_CMD_ERR(svn_fs_dir_optimal_order(&ordered, root, entries, pool,
+                                           pool));
+    }
+
   /* Begin response ... */
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(r(!", "success", rev));
   SVN_ERR(svn_ra_svn__write_proplist(conn, pool, props));
@@ -1813,12 +1882,17 @@ get_dir(svn_ra_svn_conn_t *conn,
       const char *missing_date = svn_time_to_cstring(0, pool);
 
       /* Transform the hash table's FS entries into dirents.  This probably
-       * belongs in libsvn_repos. */
+       * belongs in libsvn_repos.
+       *
+       * Everything that is specific to a single entry is allocated in
+       * SUBPOOL, so that memory usage doesn't grow with the number of
+       * entries beyond the ENTRIES hash itself. */
       subpool = svn_pool_create(pool);
-      for (hi = apr_hash_first(pool, entries); hi; hi = apr_hash_next(hi))
+      for (i = 0; i < ordered->nelts; ++i)
         {
-          const char *name = apr_hash_this_key(hi);
-          svn_fs_dirent_t *fsent = apr_hash_this_val(hi);
+          svn_fs_dirent_t *fsent = APR_ARRAY_IDX(ordered, i,
+                                                 svn_fs_dirent_t *);
+          const char *name = fsent->name;
           const char *file_path;
 
           /* The fields in the entry tuple.  */
@@ -1876,7 +1950,7 @@ get_dir(svn_ra_svn_conn_t *conn,
             cdate = missing_date;
 
           /* Send the entry. */
-          SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "cwnbr(?c)(?c)", name,
+          SVN_ERR(svn_ra_svn__write_tuple(conn, subpool, "cwnbr(?c)(?c)", name,
                                           svn_node_kind_to_word(entry_kind),
                                           (apr_uint64_t) entry_size,
                                           has_props, created_rev,
@@ -2387,10 +2461,11 @@ log_cmd(svn_ra_svn_conn_t *conn,
   const char *full_path;
   svn_boolean_t send_changed_paths, strict_node, include_merged_revisions;
   apr_array_header_t *full_paths, *revprops;
-  svn_ra_svn__list_t *paths, *revprop_items;
+  apr_array_header_t *search_patterns = NULL;
+  svn_ra_svn__list_t *paths, *revprop_items, *search_items;
   char *revprop_word;
   svn_ra_svn__item_t *elt;
-  int i;
+  int i, k;
   apr_uint64_t limit, include_merged_revs_param;
   log_baton_t lb;
   authz_baton_t ab;
@@ -2398,11 +2473,12 @@ log_cmd(svn_ra_svn_conn_t *conn,
   ab.server = b;
   ab.conn = conn;
 
-  SVN_ERR(svn_ra_svn__parse_tuple(params, "l(?r)(?r)bb?n?Bwl", &paths,
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "l(?r)(?r)bb?n?Bwll", &paths,
                                   &start_rev, &end_rev, &send_changed_paths,
                                   &strict_node, &limit,
                                   &include_merged_revs_param,
-                                  &revprop_word, &revprop_items));
+                                  &revprop_word, &revprop_items,
+                                  &search_items));
 
   if (include_merged_revs_param == SVN_RA_SVN_UNSPECIFIED_NUMBER)
     include_merged_revisions = FALSE;
@@ -2434,6 +2510,35 @@ log_cmd(svn_ra_svn_conn_t *conn,
                              _("Unknown revprop word '%s' in log command"),
                              revprop_word);
 
+  if (search_items)
+    {
+      search_patterns = apr_array_make(pool, search_items->nelts,
+                                       sizeof(apr_array_header_t *));
+      for (i = 0; i < search_items->nelts; i++)
+        {
+          apr_array_header_t *group;
+
+          elt = &SVN_RA_SVN__LIST_ITEM(search_items, i);
+          if (elt->kind != SVN_RA_SVN_LIST)
+            return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                    _("Log search pattern group not a list"));
+
+          group = apr_array_make(pool, elt->u.list.nelts,
+                                 sizeof(const char *));
+          for (k = 0; k < elt->u.list.nelts; k++)
+            {
+              svn_ra_svn__item_t *pattern
+                = &SVN_RA_SVN__LIST_ITEM(&elt->u.list, k);
+              if (pattern->kind != SVN_RA_SVN_STRING)
+                return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                        _("Log search pattern not a string"));
+              APR_ARRAY_PUSH(group, const char *) = pattern->u.string.data;
+            }
+
+          APR_ARRAY_PUSH(search_patterns, apr_array_header_t *) = group;
+        }
+    }
+
   /* If we got an unspecified number then the user didn't send us anything,
      so we assume no limit.  If it's larger than INT_MAX then someone is
      messing with us, since we know the svn client libraries will never send
@@ -2466,13 +2571,24 @@ log_cmd(svn_ra_svn_conn_t *conn,
   lb.conn = conn;
   lb.stack_depth = 0;
   lb.started = FALSE;
-  err = svn_repos_get_logs5(b->repository->repos, full_paths, start_rev,
-                            end_rev, (int) limit,
-                            strict_node, include_merged_revisions,
-                            revprops, authz_check_access_cb_func(b), &ab,
-                            send_changed_paths ? path_change_receiver : NULL,
-                            send_changed_paths ? &lb : NULL,
-                            revision_receiver, &lb, pool);
+  if (search_patterns && !include_merged_revisions)
+    err = svn_repos__get_logs_search(b->repository->repos, full_paths,
+                                     start_rev, end_rev, (int) limit,
+                                     strict_node, revprops, search_patterns,
+                                     authz_check_access_cb_func(b), &ab,
+                                     send_changed_paths
+                                       ? path_change_receiver
+                                       : NULL,
+                                     send_changed_paths ? &lb : NULL,
+                                     revision_receiver, &lb, pool);
+  else
+    err = svn_repos_get_logs5(b->repository->repos, full_paths, start_rev,
+                              end_rev, (int) limit,
+                              strict_node, include_merged_revisions,
+                              revprops, authz_check_access_cb_func(b), &ab,
+                              send_changed_paths ? path_change_receiver : NULL,
+                              send_changed_paths ? &lb : NULL,
+                              revision_receiver, &lb, pool);
 
   write_err = svn_ra_svn__write_word(conn, pool, "done");
   if (write_err)
@@ -2568,6 +2684,28 @@ stat_cmd(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Start or end a batch of commands that the client sends without waiting
+ * for the responses in between.  Since the client can't answer an auth
+ * challenge in that situation, commands that would require one simply
+ * fail.  The client may then retry them individually.
+ *
+ * This command has no response.
+ */
+static svn_error_t *
+pipeline(svn_ra_svn_conn_t *conn,
+         apr_pool_t *pool,
+         svn_ra_svn__list_t *params,
+         void *baton)
+{
+  server_baton_t *b = baton;
+  svn_boolean_t pipelined;
+
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "b", &pipelined));
+  b->pipelined = pipelined;
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 get_locations(svn_ra_svn_conn_t *conn,
               apr_pool_t *pool,
@@ -2821,12 +2959,20 @@ static svn_error_t *file_rev_handler(void *baton, const char *path,
       svn_stream_set_write(stream, svndiff_handler);
       svn_stream_set_close(stream, svndiff_close_handler);
 
-      /* If the connection does not support SVNDIFF1 or if we don't want to use
-       * compression, use the non-compressing "version 0" implementation */
+      /* Prefer zstd-based svndiff3 if both sides support it.  If the
+       * connection does not support SVNDIFF1 either or if we don't want to
+       * use compression, use the non-compressing "version 0" implementation */
       /* ### TODO: Check SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED and decide between
        * ###       svndiff1[at compression_level] and svndiff2 */
       if (   svn_ra_svn_compression_level(frb->conn) > 0
-          && svn_ra_svn_has_capability(frb->conn, SVN_RA_SVN_CAP_SVNDIFF1))
+          && svn__zstd_supported()
+          && svn_ra_svn_has_capability(frb->conn,
+                                       SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED))
+        svn_txdelta_to_svndiff3(d_handler, d_baton, stream, 3,
+                                svn_ra_svn_compression_level(frb->conn), pool);
+      else if (   svn_ra_svn_compression_level(frb->conn) > 0
+               && svn_ra_svn_has_capability(frb->conn,
+                                            SVN_RA_SVN_CAP_SVNDIFF1))
         svn_txdelta_to_svndiff3(d_handler, d_baton, stream, 1,
                                 svn_ra_svn_compression_level(frb->conn), pool);
       else
@@ -2895,6 +3041,111 @@ get_file_revs(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Send one chunk of blame to the client.  The revision properties are
+ * only sent with the first chunk of each revision.
+ *
+ * Implements svn_repos__blame_receiver_t. */
+static svn_error_t *
+blame_receiver(void *baton,
+               apr_int64_t start_line,
+               svn_revnum_t revision,
+               apr_hash_t *rev_props,
+               apr_pool_t *scratch_pool)
+{
+  file_blame_baton_t *fbb = baton;
+
+  SVN_ERR(svn_ra_svn__write_tuple(fbb->conn, scratch_pool, "n(?r)(!",
+                                  (apr_uint64_t) start_line, revision));
+  if (SVN_IS_VALID_REVNUM(revision)
+      && !apr_hash_get(fbb->sent_revs, &revision, sizeof(revision)))
+    {
+      SVN_ERR(svn_ra_svn__write_proplist(fbb->conn, scratch_pool, rev_props));
+      apr_hash_set(fbb->sent_revs,
+                   apr_pmemdup(fbb->pool, &revision, sizeof(revision)),
+                   sizeof(revision), "");
+    }
+  SVN_ERR(svn_ra_svn__write_tuple(fbb->conn, scratch_pool, "!)"));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_file_blame(svn_ra_svn_conn_t *conn,
+               apr_pool_t *pool,
+               svn_ra_svn__list_t *params,
+               void *baton)
+{
+  server_baton_t *b = baton;
+  svn_error_t *err, *write_err;
+  file_blame_baton_t fbb;
+  svn_revnum_t start_rev, end_rev;
+  const char *path;
+  const char *full_path;
+  svn_ra_svn__list_t *diff_arg_items;
+  apr_array_header_t *diff_args;
+  svn_diff_file_options_t *diff_options;
+  authz_baton_t ab;
+  int i;
+
+  ab.server = b;
+  ab.conn = conn;
+
+  /* Parse arguments. */
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "c(?r)(?r)l",
+                                  &path, &start_rev, &end_rev,
+                                  &diff_arg_items));
+  path = svn_relpath_canonicalize(path, pool);
+  SVN_ERR(trivial_auth_request(conn, pool, b));
+  full_path = svn_fspath__join(b->repository->fs_path->data, path, pool);
+
+  diff_args = apr_array_make(pool, diff_arg_items->nelts,
+                             sizeof(const char *));
+  for (i = 0; i < diff_arg_items->nelts; i++)
+    {
+      svn_ra_svn__item_t *item = &SVN_RA_SVN__LIST_ITEM(diff_arg_items, i);
+
+      if (item->kind != SVN_RA_SVN_STRING)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Diff option is not a string"));
+      APR_ARRAY_PUSH(diff_args, const char *) = item->u.string.data;
+    }
+  diff_options = svn_diff_file_options_create(pool);
+  SVN_CMD_ERR(svn_diff_file_options_parse(diff_options, diff_args, pool));
+
+  if (!SVN_IS_VALID_REVNUM(end_rev))
+    SVN_ERR(svn_fs_youngest_rev(&end_rev, b->repository->fs, pool));
+  if (!SVN_IS_VALID_REVNUM(start_rev))
+    start_rev = 0;
+  if (start_rev > end_rev)
+    SVN_CMD_ERR(svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                  _("Invalid blame range r%ld:%ld"),
+                                  start_rev, end_rev));
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__get_file_blame(full_path, start_rev, end_rev,
+                                              pool)));
+
+  fbb.conn = conn;
+  fbb.sent_revs = apr_hash_make(pool);
+  fbb.pool = pool;
+
+  err = svn_repos__get_file_blame(b->repository->repos, full_path,
+                                  start_rev, end_rev, diff_options,
+                                  authz_check_access_cb_func(b), &ab,
+                                  b->cache_blame, blame_receiver, &fbb,
+                                  NULL, NULL, pool);
+  write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+  SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 lock(svn_ra_svn_conn_t *conn,
      apr_pool_t *pool,
@@ -2987,6 +3238,7 @@ lock_many(svn_ra_svn_conn_t *conn,
   svn_error_t *err, *write_err = SVN_NO_ERROR;
   apr_hash_t *targets = apr_hash_make(pool);
   apr_hash_t *authz_results = apr_hash_make(pool);
+  apr_array_header_t *full_paths;
   apr_hash_index_t *hi;
   struct lock_many_baton_t lmb;
 
@@ -3001,7 +3253,10 @@ lock_many(svn_ra_svn_conn_t *conn,
      an error. */
   SVN_ERR(must_have_access(conn, pool, b, svn_authz_write, NULL, TRUE));
 
-  /* Parse the lock requests from PATH_REVS into TARGETS. */
+  /* Parse the lock requests from PATH_REVS into TARGETS.  Remember the
+     canonical path of each request so that the results can be sent
+     back without parsing the request list a second time. */
+  full_paths = apr_array_make(pool, path_revs->nelts, sizeof(const char *));
   for (i = 0; i < path_revs->nelts; ++i)
     {
       const char *path, *full_path;
@@ -3027,6 +3282,7 @@ lock_many(svn_ra_svn_conn_t *conn,
          single path that is processed once.  The result is then
          returned multiple times. */
       svn_hash_sets(targets, full_path, target);
+      APR_ARRAY_PUSH(full_paths, const char *) = full_path;
     }
 
   SVN_ERR(log_command(b, conn, subpool, "%s",
@@ -3065,24 +3321,13 @@ lock_many(svn_ra_svn_conn_t *conn,
                                pool, subpool);
 
   /* Return results in the same order as the paths were supplied. */
-  for (i = 0; i < path_revs->nelts; ++i)
+  for (i = 0; i < full_paths->nelts; ++i)
     {
-      const char *path, *full_path;
-      svn_revnum_t current_rev;
-      svn_ra_svn__item_t *item = &SVN_RA_SVN__LIST_ITEM(path_revs, i);
+      const char *full_path = APR_ARRAY_IDX(full_paths, i, const char *);
       struct lock_result_t *result;
 
       svn_pool_clear(subpool);
 
-      write_err = svn_ra_svn__parse_tuple(&item->u.list, "c(?r)",
-                                          &path, &current_rev);
-      if (write_err)
-        break;
-
-      full_path = svn_fspath__join(b->repository->fs_path->data,
-                                   svn_relpath_canonicalize(path, subpool),
-                                   subpool);
-
       result = svn_hash_gets(lmb.results, full_path);
       if (!result)
         result = svn_hash_gets(authz_results, full_path);
@@ -3093,7 +3338,8 @@ lock_many(svn_ra_svn_conn_t *conn,
              reported in the correct order. */
           result = apr_palloc(pool, sizeof(struct lock_result_t));
           result->err = svn_error_createf(SVN_ERR_FS_LOCK_OPERATION_FAILED, 0,
-                                          _("No result for '%s'."), path);
+                                          _("No result for '%s'."),
+                                          full_path);
           svn_hash_sets(lmb.results, full_path, result);
         }
 
@@ -3173,6 +3419,7 @@ unlock_many(svn_ra_svn_conn_t *conn,
   svn_error_t *err = SVN_NO_ERROR, *write_err = SVN_NO_ERROR;
   apr_hash_t *targets = apr_hash_make(pool);
   apr_hash_t *authz_results = apr_hash_make(pool);
+  apr_array_header_t *paths, *full_paths;
   apr_hash_index_t *hi;
   struct lock_many_baton_t lmb;
 
@@ -3183,7 +3430,12 @@ unlock_many(svn_ra_svn_conn_t *conn,
 
   subpool = svn_pool_create(pool);
 
-  /* Parse the unlock requests from PATH_REVS into TARGETS. */
+  /* Parse the unlock requests from PATH_REVS into TARGETS.  Remember
+     the paths of each request so that the results can be sent back
+     without parsing the request list a second time. */
+  paths = apr_array_make(pool, unlock_tokens->nelts, sizeof(const char *));
+  full_paths = apr_array_make(pool, unlock_tokens->nelts,
+                              sizeof(const char *));
   for (i = 0; i < unlock_tokens->nelts; i++)
     {
       svn_ra_svn__item_t *item = &SVN_RA_SVN__LIST_ITEM(unlock_tokens, i);
@@ -3208,6 +3460,8 @@ unlock_many(svn_ra_svn_conn_t *conn,
          single path that is processed once.  The result is then
          returned multiple times. */
       svn_hash_sets(targets, full_path, token);
+      APR_ARRAY_PUSH(paths, const char *) = path;
+      APR_ARRAY_PUSH(full_paths, const char *) = full_path;
     }
 
   SVN_ERR(log_command(b, conn, subpool, "%s",
@@ -3245,23 +3499,14 @@ unlock_many(svn_ra_svn_conn_t *conn,
                                  pool, subpool);
 
   /* Return results in the same order as the paths were supplied. */
-  for (i = 0; i < unlock_tokens->nelts; ++i)
+  for (i = 0; i < full_paths->nelts; ++i)
     {
-      const char *path, *token, *full_path;
-      svn_ra_svn__item_t *item = &SVN_RA_SVN__LIST_ITEM(unlock_tokens, i);
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      const char *full_path = APR_ARRAY_IDX(full_paths, i, const char *);
       struct lock_result_t *result;
 
       svn_pool_clear(subpool);
 
-      write_err = svn_ra_svn__parse_tuple(&item->u.list, "c(?c)",
-                                          &path, &token);
-      if (write_err)
-        break;
-
-      full_path = svn_fspath__join(b->repository->fs_path->data,
-                                   svn_relpath_canonicalize(path, subpool),
-                                   pool);
-
       result = svn_hash_gets(lmb.results, full_path);
       if (!result)
         result = svn_hash_gets(authz_results, full_path);
@@ -3277,7 +3522,8 @@ unlock_many(svn_ra_svn_conn_t *conn,
         }
 
       if (result->err)
-        write_err = svn_ra_svn__write_cmd_failure(conn, pool, result->err);
+        write_err = svn_ra_svn__write_cmd_failure(conn, subpool,
+                                                  result->err);
       else
         write_err = svn_ra_svn__write_tuple(conn, subpool, "w(c)", "success",
                                             path);
@@ -3716,6 +3962,7 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "get-locations",   get_locations },
   { "get-location-segments",   get_location_segments },
   { "get-file-revs",   get_file_revs },
+  { "get-file-blame",  get_file_blame },
   { "lock",            lock },
   { "lock-many",       lock_many },
   { "unlock",          unlock },
@@ -3727,6 +3974,7 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "get-deleted-rev", get_deleted_rev },
   { "get-iprops",      get_inherited_props },
   { "list",            list },
+  { "pipeline",        pipeline },
   { NULL }
 };
 
@@ -3787,7 +4035,9 @@ repos_path_valid(const char *path)
  * and fs_path fields of REPOSITORY.  VHOST and READ_ONLY flags are the
  * same as in the server baton.
  *
- * CONFIG_POOL shall be used to load config objects.
+ * CONFIG_POOL shall be used to load config objects and the repository
+ * will be taken from REPOS_POOL.  The latter is released when RESULT_POOL
+ * gets cleaned up.
  *
  * Use SCRATCH_POOL for temporary allocations.
  *
@@ -3800,6 +4050,7 @@ find_repos(const char *url,
            svn_config_t *cfg,
            repository_t *repository,
            svn_repos__config_pool_t *config_pool,
+           svn_repos__repos_pool_t *repos_pool,
            apr_hash_t *fs_config,
            apr_pool_t *result_pool,
            apr_pool_t *scratch_pool)
@@ -3840,8 +4091,9 @@ find_repos(const char *url,
                              "No repository found in '%s'", url);
 
   /* Open the repository and fill in b with the resulting information. */
-  SVN_ERR(svn_repos_open3(&repository->repos, repository->repos_root,
-                          fs_config, result_pool, scratch_pool));
+  SVN_ERR(svn_repos__repos_pool_get(&repository->repos, repos_pool,
+                                    repository->repos_root, fs_config,
+                                    result_pool, scratch_pool));
   SVN_ERR(svn_repos_remember_client_capabilities(repository->repos,
                                                  repository->capabilities));
   repository->fs = svn_repos_fs(repository->repos);
@@ -3932,6 +4184,13 @@ find_repos(const char *url,
   SVN_ERR(svn_repos_hooks_setenv(repository->repos, hooks_env, scratch_pool));
   repository->hooks_env = apr_pstrdup(result_pool, hooks_env);
 
+  /* Defer post-commit hooks until after the commit response? */
+  SVN_ERR(svn_config_get_bool(cfg, &repository->async_post_commit,
+                              SVN_CONFIG_SECTION_GENERAL,
+                              SVN_CONFIG_OPTION_ASYNC_POST_COMMIT, FALSE));
+  svn_repos__set_async_post_commit(repository->repos,
+                                   repository->async_post_commit);
+
   return SVN_NO_ERROR;
 }
 
@@ -4129,6 +4388,8 @@ construct_server_baton(server_baton_t **baton,
   b->read_only = params->read_only;
   b->pool = conn_pool;
   b->vhost = params->vhost;
+  b->update_threads = params->update_threads;
+  b->cache_blame = params->cache_blame;
 
   b->logger = params->logger;
   b->client_info = get_client_info(conn, params, conn_pool);
@@ -4137,7 +4398,7 @@ construct_server_baton(server_baton_t **baton,
    * send an empty mechlist. */
   if (params->compression_level > 0)
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwwwwww?w)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
@@ -4151,11 +4412,18 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_PIPELINED_COMMANDS,
+                                           SVN_RA_SVN_CAP_FILE_BLAME,
+                                           SVN_RA_SVN_CAP_LOG_SEARCH,
+                                           SVN_RA_SVN_CAP_LZ4_STREAM,
+                                           svn__zstd_supported()
+                                             ? SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED
+                                             : NULL
                                            ));
   else
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
@@ -4167,7 +4435,10 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_PIPELINED_COMMANDS,
+                                           SVN_RA_SVN_CAP_FILE_BLAME,
+                                           SVN_RA_SVN_CAP_LOG_SEARCH
                                            ));
 
   /* Read client response, which we assume to be in version 2 format:
@@ -4188,6 +4459,12 @@ construct_server_baton(server_baton_t **baton,
   if (! svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_EDIT_PIPELINE))
     return SVN_NO_ERROR;
 
+  /* The client will only ask for stream compression if we offered it.
+   * Everything from hereon gets compressed. */
+  if (   params->compression_level > 0
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_LZ4_STREAM))
+    SVN_ERR(svn_ra_svn__enable_stream_compression(conn, scratch_pool));
+
   /* find_repos needs the capabilities as a list of words (eventually
      they get handed to the start-commit hook).  While we could add a
      new interface to re-retrieve them from conn and convert the
@@ -4225,6 +4502,7 @@ construct_server_baton(server_baton_t **baton,
   err = handle_config_error(find_repos(client_url, params->root, b->vhost,
                                        b->read_only, params->cfg,
                                        b->repository, params->config_pool,
+                                       params->repos_pool,
                                        params->fs_config,
                                        conn_pool, scratch_pool),
                             b);
@@ -58,6 +58,7 @@ typedef struct repository_t {
   const char *realm;       /* Authentication realm */
   const char *repos_url;   /* URL to base of repository */
   const char *hooks_env;   /* Path to the hooks environment file or NULL */
+  svn_boolean_t async_post_commit; /* Queue post-commit hooks? */
   const char *uuid;        /* Repository ID */
   apr_array_header_t *capabilities;
                            /* Client capabilities (SVN_RA_CAPABILITY_*) */
@@ -90,6 +91,9 @@ typedef struct server_baton_t {
                               May be NULL even if log_file is not. */
   svn_boolean_t read_only; /* Disallow write access (global flag) */
   svn_boolean_t vhost;     /* Use virtual-host-based path to repo. */
+  svn_boolean_t pipelined; /* Client doesn't wait for our responses. */
+  int update_threads;      /* Threads computing deltas for reports. */
+  svn_boolean_t cache_blame; /* Keep blame results in the cache. */
   apr_pool_t *pool;
 } server_baton_t;
 
@@ -127,6 +131,10 @@ typedef struct serve_params_t {
   /* all configurations should be opened through this factory */
   svn_repos__config_pool_t *config_pool;
 
+  /* all repositories should be opened through this factory, so idle
+     instances can be reused by later connections */
+  svn_repos__repos_pool_t *repos_pool;
+
   /* The FS configuration to be applied to all repositories.
      It mainly contains things like cache settings. */
   apr_hash_t *fs_config;
@@ -159,6 +167,12 @@ typedef struct serve_params_t {
 
   /* Use virtual-host-based path to repo. */
   svn_boolean_t vhost;
+
+  /* Number of threads computing text deltas for a single report. */
+  int update_threads;
+
+  /* Keep the results of get-file-blame in the membuffer cache. */
+  svn_boolean_t cache_blame;
 } serve_params_t;
 
 /* This structure contains all data that describes a client / server
@@ -31,6 +31,7 @@
 #include <apr_signal.h>
 #include <apr_thread_proc.h>
 #include <apr_portable.h>
+#include <apr_poll.h>
 
 #include <locale.h>
 
@@ -57,6 +58,7 @@
 #include "private/svn_atomic.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_ra_svn_private.h"
 
 #if APR_HAS_THREADS
 #    include <apr_thread_pool.h>
@@ -75,7 +77,7 @@
    unavailable due to platform limitations. */
 enum connection_handling_mode {
   connection_mode_fork,   /* Create a process per connection */
-  connection_mode_thread, /* Create a thread per connection */
+  connection_mode_thread, /* Share worker threads among connections */
   connection_mode_single  /* One connection at a time in this process */
 };
 
@@ -145,6 +147,15 @@ enum run_mode {
  */
 #define THREADPOOL_THREAD_IDLE_LIMIT 1000000
 
+/* Maximum number of connections that may be open at the same time in
+ * threaded mode.  Idle connections don't occupy a worker thread but are
+ * being watched by the main thread until the next command comes in.
+ *
+ * Each of them costs only the memory for its buffers and the repository
+ * objects it has open.
+ */
+#define REACTOR_MAX_CONNECTIONS 16384
+
 /* Number of client to server connections that may concurrently in the
  * TCP 3-way handshake state, i.e. are in the process of being created.
  *
@@ -222,6 +233,22 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_DISK_CACHE_FILE 277
+#define SVNSERVE_OPT_DISK_CACHE_SIZE 278
+#define SVNSERVE_OPT_UPDATE_THREADS  279
+#define SVNSERVE_OPT_CACHE_BLAME     280
+#define SVNSERVE_OPT_METRICS_FILE   281
+#define SVNSERVE_OPT_TRACE_FILE     282
+#define SVNSERVE_OPT_TRACE_FORMAT   283
+#define SVNSERVE_OPT_PROCESSES      284
+#define SVNSERVE_OPT_LOG_FORMAT     285
+#define SVNSERVE_OPT_LOG_BUFFER     286
+#define SVNSERVE_OPT_LOG_OVERFLOW   287
+#define SVNSERVE_OPT_CACHE_HUGE_PAGES 288
+#define SVNSERVE_OPT_CACHE_NUMA_INTERLEAVE 289
+
+/* Number of tracing spans to keep if --trace-file has been given. */
+#define SVNSERVE_TRACE_SPANS 10000
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -297,6 +324,32 @@ static const apr_getopt_option_t svnserve__options[] =
         "0 switches to dynamically sized caches.\n"
         "                             "
         "[used for FSFS and FSX repositories only]")},
+    {"disk-cache-file", SVNSERVE_OPT_DISK_CACHE_FILE, 1,
+     N_("file to hold data evicted from the in-memory cache.\n"
+        "                             "
+        "Its contents survive server restarts.\n"
+        "                             "
+        "Default is to use no disk cache.\n"
+        "                             "
+        "[used for FSFS and FSX repositories only]")},
+    {"disk-cache-size", SVNSERVE_OPT_DISK_CACHE_SIZE, 1,
+     N_("maximum size of the disk cache file in MB.\n"
+        "                             "
+        "Default is 1024.\n"
+        "                             "
+        "[used with --disk-cache-file only]")},
+    {"cache-huge-pages", SVNSERVE_OPT_CACHE_HUGE_PAGES, 1,
+     N_("back the in-memory cache with huge pages, where\n"
+        "                             "
+        "supported, to reduce TLB misses.\n"
+        "                             "
+        "Default is no.")},
+    {"cache-numa-interleave", SVNSERVE_OPT_CACHE_NUMA_INTERLEAVE, 1,
+     N_("spread the in-memory cache evenly across all NUMA\n"
+        "                             "
+        "nodes, where supported.\n"
+        "                             "
+        "Default is no.")},
     {"cache-txdeltas", SVNSERVE_OPT_CACHE_TXDELTAS, 1,
      N_("enable or disable caching of deltas between older\n"
         "                             "
@@ -325,6 +378,12 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is yes.\n"
         "                             "
         "[used for FSFS repositories only]")},
+    {"cache-blame", SVNSERVE_OPT_CACHE_BLAME, 1,
+     N_("enable or disable caching of blame results.\n"
+        "                             "
+        "Persistent if --disk-cache-file is given.\n"
+        "                             "
+        "Default is no.")},
     {"client-speed", SVNSERVE_OPT_CLIENT_SPEED, 1,
      N_("Optimize network handling based on the assumption\n"
         "                             "
@@ -362,6 +421,26 @@ static const apr_getopt_option_t svnserve__options[] =
         "                             "
         "Default is " APR_STRINGIFY(THREADPOOL_MAX_SIZE) "."
         ONLY_AVAILABLE_WITH_THEADS)},
+    {"update-threads",   SVNSERVE_OPT_UPDATE_THREADS, 1,
+     N_("Number of threads computing text deltas ahead\n"
+        "                             "
+        "of sending them in update, switch, status and\n"
+        "                             "
+        "diff responses.  Default is 1.")},
+#endif
+#if APR_HAS_FORK
+    {"processes",        SVNSERVE_OPT_PROCESSES, 1,
+     N_("Number of daemon processes accepting connections.\n"
+        "                             "
+        "Each process gets 1/ARG-th of the memory and disk\n"
+        "                             "
+        "cache size.  Disk cache, metrics and trace files\n"
+        "                             "
+        "get the process number appended, e.g. 'file.1'.\n"
+        "                             "
+        "Default is 1.\n"
+        "                             "
+        "[mode: daemon]")},
 #endif
     {"max-request-size", SVNSERVE_OPT_MAX_REQUEST, 1,
      N_("Maximum acceptable size of a client request in MB.\n"
@@ -396,6 +475,50 @@ static const apr_getopt_option_t svnserve__options[] =
         "process (useful for debugging)")},
     {"log-file",         SVNSERVE_OPT_LOG_FILE, 1,
      N_("svnserve log file")},
+    {"log-format",       SVNSERVE_OPT_LOG_FORMAT, 1,
+     N_("format of the log entries: 'text' (the default)\n"
+        "                             "
+        "or 'json' (one JSON object per line)")},
+#if APR_HAS_THREADS
+    {"log-buffer-size",  SVNSERVE_OPT_LOG_BUFFER, 1,
+     N_("buffer up to ARG kB of log entries in memory and\n"
+        "                             "
+        "write them from a background thread.  Not\n"
+        "                             "
+        "available when forking per connection.\n"
+        "                             "
+        "Default is 0 (write synchronously).")},
+    {"log-overflow",     SVNSERVE_OPT_LOG_OVERFLOW, 1,
+     N_("what to do if the log buffer is full: 'block'\n"
+        "                             "
+        "(wait for it, the default) or 'drop' (discard\n"
+        "                             "
+        "the entry and log the number of dropped ones)")},
+#endif
+    {"metrics-file",     SVNSERVE_OPT_METRICS_FILE, 1,
+     N_("write cache statistics and FS operation counters\n"
+        "                             "
+        "in Prometheus text format to file ARG whenever a\n"
+        "                             "
+        "connection closes, at most once per second.\n"
+        "                             "
+        "Only counts what is served by this process, i.e.\n"
+        "                             "
+        "not useful in fork mode.\n"
+        "                             "
+        "[mode: daemon, listen-once]")},
+    {"trace-file",       SVNSERVE_OPT_TRACE_FILE, 1,
+     N_("record request tracing spans and write the most\n"
+        "                             "
+        "recent ones to file ARG, updated like the\n"
+        "                             "
+        "--metrics-file.\n"
+        "                             "
+        "[mode: daemon, listen-once]")},
+    {"trace-format",     SVNSERVE_OPT_TRACE_FORMAT, 1,
+     N_("format of the --trace-file: 'chrome' (trace event\n"
+        "                             "
+        "JSON, the default) or 'otlp' (OTLP/JSON)")},
     {"pid-file",         SVNSERVE_OPT_PID_FILE, 1,
 #ifdef WIN32
      N_("write server process ID to file ARG\n"
@@ -492,6 +615,71 @@ static void sigchld_handler(int signo)
 }
 #endif
 
+/* Set *SOCK to a new socket listening on address SA, allocated in POOL.
+ * If REUSE_PORT is set and supported, allow other sockets to be bound to
+ * the same address and let the kernel balance connections between them.
+ */
+static svn_error_t *
+create_server_socket(apr_socket_t **sock,
+                     apr_sockaddr_t *sa,
+                     svn_boolean_t reuse_port,
+                     apr_pool_t *pool)
+{
+  apr_status_t status;
+
+#ifdef MAX_SECS_TO_LINGER
+  /* ### old APR interface */
+  status = apr_socket_create(sock, sa->family, SOCK_STREAM, pool);
+#else
+  status = apr_socket_create(sock, sa->family, SOCK_STREAM, APR_PROTO_TCP,
+                             pool);
+#endif
+  if (status)
+    {
+      return svn_error_wrap_apr(status, _("Can't create server socket"));
+    }
+
+  /* Prevents "socket in use" errors when server is killed and quickly
+   * restarted. */
+  status = apr_socket_opt_set(*sock, APR_SO_REUSEADDR, 1);
+  if (status)
+    {
+      return svn_error_wrap_apr(status, _("Can't set options on server socket"));
+    }
+
+#ifdef SO_REUSEPORT
+  if (reuse_port)
+    {
+      apr_os_sock_t os_sock;
+      int one = 1;
+
+      status = apr_os_sock_get(&os_sock, *sock);
+      if (!status && setsockopt(os_sock, SOL_SOCKET, SO_REUSEPORT,
+                                (void *)&one, sizeof(one)))
+        status = apr_get_netos_error();
+      if (status)
+        {
+          return svn_error_wrap_apr(status,
+                                    _("Can't set options on server socket"));
+        }
+    }
+#endif
+
+  status = apr_socket_bind(*sock, sa);
+  if (status)
+    {
+      return svn_error_wrap_apr(status, _("Can't bind server socket"));
+    }
+
+  status = apr_socket_listen(*sock, ACCEPT_BACKLOG);
+  if (status)
+    {
+      return svn_error_wrap_apr(status, _("Can't listen on server socket"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Redirect stdout to stderr.  ARG is the pool.
  *
  * In tunnel or inetd mode, we don't want hook scripts corrupting the
@@ -566,6 +754,63 @@ accept_connection(connection_t **connection,
        : SVN_NO_ERROR;
 }
 
+/* File to write the process' metrics to.  NULL if disabled. */
+static const char *metrics_filename = NULL;
+
+/* File to write the recorded tracing spans to in TRACE_FORMAT.
+ * NULL if disabled. */
+static const char *trace_filename = NULL;
+static svn_trace__format_t trace_format = svn_trace__format_chrome;
+
+/* Time at which we last wrote METRICS_FILENAME and TRACE_FILENAME. */
+static apr_time_t status_written = 0;
+
+/* Atomically replace FILENAME with TEXT.  Failures are not fatal but get
+ * logged to LOGGER.  Use SCRATCH_POOL for temporary allocations.
+ */
+static void
+write_status_file(logger_t *logger,
+                  const char *filename,
+                  const svn_string_t *text,
+                  apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = svn_io_write_atomic2(filename, text->data, text->len,
+                                          NULL, FALSE, scratch_pool);
+  if (err)
+    logger__log_error(logger, err, NULL, NULL);
+
+  svn_error_clear(err);
+}
+
+/* Update METRICS_FILENAME and TRACE_FILENAME, unless they have been
+ * written within the last second.  Failures get logged to LOGGER.
+ */
+static void
+write_status_files(logger_t *logger)
+{
+  apr_pool_t *pool;
+  apr_time_t now;
+
+  if (!metrics_filename && !trace_filename)
+    return;
+
+  /* Races are harmless here: we write some extra updates at worst. */
+  now = apr_time_now();
+  if (now - status_written < apr_time_from_sec(1))
+    return;
+  status_written = now;
+
+  pool = svn_pool_create(NULL);
+  if (metrics_filename)
+    write_status_file(logger, metrics_filename,
+                      svn_metrics__format_prometheus(pool), pool);
+  if (trace_filename)
+    write_status_file(logger, trace_filename,
+                      svn_trace__export(trace_format, pool), pool);
+
+  svn_pool_destroy(pool);
+}
+
 /* Add a reference to CONNECTION, i.e. keep it and it's pool valid unless
  * that reference gets released using release_shared_pool().
  */
@@ -583,7 +828,12 @@ close_connection(connection_t *connection)
 {
   /* this will automatically close USOCK */
   if (svn_atomic_dec(&connection->ref_count) == 0)
-    svn_pool_destroy(connection->pool);
+    {
+      logger_t *logger = connection->params->logger;
+
+      svn_pool_destroy(connection->pool);
+      write_status_files(logger);
+    }
 }
 
 /* Wrapper around serve() that takes a socket instead of a connection.
@@ -614,48 +864,168 @@ static svn_root_pools__t *connection_pools;
 /* The global thread pool serving all connections. */
 static apr_thread_pool_t *threads;
 
-/* Very simple load determination callback for serve_interruptable:
-   With less than half the threads in THREADS in use, we can afford to
-   wait in the socket read() function.  Otherwise, poll them round-robin. */
+/* The set of idle connections and the listening socket, watched by the
+   main thread in threaded mode. */
+static apr_pollset_t *idle_connections;
+
+/* Load determination callback for serve_interruptable:
+   Worker threads only ever execute commands that have already arrived.
+   Waiting for new ones is done by the main thread for all connections. */
 static svn_boolean_t
 is_busy(connection_t *connection)
 {
-  return apr_thread_pool_threads_count(threads) * 2
-       > apr_thread_pool_thread_max_get(threads);
+  return TRUE;
 }
 
-/* Serve the connection given by DATA.  Under high load, serve only
-   the current command (if any) and then put the connection back into
-   THREAD's task pool. */
+/* Hand CONNECTION over to the main thread which will schedule it again
+   for execution once there is new data coming in. */
+static void
+park_connection(connection_t *connection)
+{
+  apr_status_t status;
+  apr_pollfd_t pfd = { 0 };
+
+  pfd.p = connection->pool;
+  pfd.desc_type = APR_POLL_SOCKET;
+  pfd.desc.s = connection->usock;
+  pfd.reqevents = APR_POLLIN;
+  pfd.client_data = connection;
+
+  status = apr_pollset_add(idle_connections, &pfd);
+  if (status)
+    {
+      svn_error_t *err
+        = svn_error_wrap_apr(status, _("Can't watch client connection"));
+      logger__log_error(connection->params->logger, err, NULL,
+                        get_client_info(connection->conn, connection->params,
+                                        connection->pool));
+      svn_error_clear(err);
+      close_connection(connection);
+    }
+}
+
+/* Serve the connection given by DATA for as long as there are commands
+   waiting for it.  Then, either close the connection or park it until the
+   client sends the next command. */
 static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
 {
   svn_boolean_t done;
+  svn_boolean_t has_command = FALSE;
   connection_t *connection = data;
   svn_error_t *err;
 
   apr_pool_t *pool = svn_root_pools__acquire_pool(connection_pools);
 
-  /* process the actual request and log errors */
-  err = serve_interruptable(&done, connection, is_busy, pool);
-  if (err)
+  /* process the actual requests and log errors */
+  do
     {
-      logger__log_error(connection->params->logger, err, NULL,
-                        get_client_info(connection->conn, connection->params,
-                                        pool));
-      svn_error_clear(err);
-      done = TRUE;
+      err = serve_interruptable(&done, connection, is_busy, pool);
+      if (!err && !done)
+        err = svn_ra_svn__has_command(&has_command, &done, connection->conn,
+                                      pool);
+      if (err)
+        {
+          logger__log_error(connection->params->logger, err, NULL,
+                            get_client_info(connection->conn,
+                                            connection->params, pool));
+          svn_error_clear(err);
+          done = TRUE;
+        }
     }
+  while (!done && has_command);
+
   svn_root_pools__release_pool(pool, connection_pools);
 
-  /* Close or re-schedule connection. */
+  /* Close or park connection. */
   if (done)
     close_connection(connection);
   else
-    apr_thread_pool_push(threads, serve_thread, connection, 0, NULL);
+    park_connection(connection);
 
   return NULL;
 }
 
+/* Accept connections coming in on SOCK and serve them using the worker
+   threads in THREADS.  Connections without pending requests get parked
+   in IDLE_CONNECTIONS, so no thread is blocked waiting for them.  Only
+   when a client sends data, its connection will be given to a worker.
+
+   PARAMS and HANDLING_MODE are being passed to accept_connection().
+   Use POOL for allocations.  This function does not return unless there
+   is an error. */
+static svn_error_t *
+serve_threaded(apr_socket_t *sock,
+               serve_params_t *params,
+               enum connection_handling_mode handling_mode,
+               apr_pool_t *pool)
+{
+  apr_status_t status;
+  apr_pollfd_t pfd = { 0 };
+
+  status = apr_pollset_create(&idle_connections, REACTOR_MAX_CONNECTIONS + 1,
+                              pool, APR_POLLSET_THREADSAFE);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create pollset"));
+
+  /* The listening socket is the only entry without CLIENT_DATA. */
+  pfd.p = pool;
+  pfd.desc_type = APR_POLL_SOCKET;
+  pfd.desc.s = sock;
+  pfd.reqevents = APR_POLLIN;
+  status = apr_pollset_add(idle_connections, &pfd);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't watch server socket"));
+
+  while (1)
+    {
+      apr_int32_t count, i;
+      const apr_pollfd_t *descriptors;
+
+#ifdef WIN32
+      /* Wake up regularly to check for the service being stopped. */
+      apr_interval_time_t timeout = apr_time_from_sec(1);
+      if (winservice_is_stopping())
+        exit(0);
+#else
+      apr_interval_time_t timeout = -1;
+#endif
+
+      status = apr_pollset_poll(idle_connections, timeout, &count,
+                                &descriptors);
+      if (APR_STATUS_IS_EINTR(status) || APR_STATUS_IS_TIMEUP(status))
+        continue;
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't poll connections"));
+
+      for (i = 0; i < count; ++i)
+        {
+          connection_t *connection = descriptors[i].client_data;
+
+          if (connection)
+            {
+              /* The client became active again.  It is no longer idle. */
+              apr_pollset_remove(idle_connections, &descriptors[i]);
+            }
+          else
+            {
+              SVN_ERR(accept_connection(&connection, sock, params,
+                                        handling_mode, pool));
+
+              /* The worker threads and the pollset will now own it. */
+              attach_connection(connection);
+              close_connection(connection);
+            }
+
+          status = apr_thread_pool_push(threads, serve_thread, connection,
+                                        0, NULL);
+          if (status)
+            return svn_error_wrap_apr(status, _("Can't push task"));
+        }
+    }
+
+  /* NOTREACHED */
+}
+
 #endif
 
 /* Write the PID of the current process as a decimal number, followed by a
@@ -708,6 +1078,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   enum run_mode run_mode = run_mode_unspecified;
   svn_boolean_t foreground = FALSE;
   apr_socket_t *sock;
+  apr_socket_t **socks;
   apr_sockaddr_t *sa;
   svn_error_t *err;
   apr_getopt_t *os;
@@ -725,6 +1096,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_boolean_t cache_txdeltas = TRUE;
   svn_boolean_t cache_revprops = FALSE;
   svn_boolean_t use_block_read = FALSE;
+  const char *disk_cache_file = NULL;
+  apr_uint64_t disk_cache_size = APR_UINT64_C(1024) * 0x100000;
+  svn_boolean_t cache_huge_pages = FALSE;
+  svn_boolean_t cache_numa_interleave = FALSE;
   apr_uint16_t port = SVN_RA_SVN_PORT;
   const char *host = NULL;
   int family = APR_INET;
@@ -739,9 +1114,15 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   const char *config_filename = NULL;
   const char *pid_filename = NULL;
   const char *log_filename = NULL;
+  logger_format_t log_format = logger_format_text;
+  apr_size_t log_buffer_size = 0;
+  svn_boolean_t log_drop_on_overflow = FALSE;
   svn_node_kind_t kind;
   apr_size_t min_thread_count = THREADPOOL_MIN_SIZE;
   apr_size_t max_thread_count = THREADPOOL_MAX_SIZE;
+  int process_count = 1;
+  int process_index = 0;
+  int i;
 #ifdef SVN_HAVE_SASL
   SVN_ERR(cyrus_init(pool));
 #endif
@@ -766,6 +1147,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
   params.logger = NULL;
   params.config_pool = NULL;
+  params.repos_pool = NULL;
   params.fs_config = NULL;
   params.vhost = FALSE;
   params.username_case = CASE_ASIS;
@@ -774,6 +1156,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.error_check_interval = 4096;
   params.max_request_size = MAX_REQUEST_SIZE * 0x100000;
   params.max_response_size = 0;
+  params.update_threads = 1;
+  params.cache_blame = FALSE;
 
   while (1)
     {
@@ -909,6 +1293,32 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           }
           break;
 
+        case SVNSERVE_OPT_DISK_CACHE_FILE:
+          SVN_ERR(svn_utf_cstring_to_utf8(&disk_cache_file, arg, pool));
+          disk_cache_file = svn_dirent_internal_style(disk_cache_file, pool);
+          SVN_ERR(svn_dirent_get_absolute(&disk_cache_file, disk_cache_file,
+                                          pool));
+          break;
+
+        case SVNSERVE_OPT_DISK_CACHE_SIZE:
+          {
+            apr_uint64_t sz_val;
+            SVN_ERR(svn_cstring_atoui64(&sz_val, arg));
+
+            disk_cache_size = 0x100000 * sz_val;
+          }
+          break;
+
+        case SVNSERVE_OPT_CACHE_HUGE_PAGES:
+          cache_huge_pages
+            = svn_tristate__from_word(arg) == svn_tristate_true;
+          break;
+
+        case SVNSERVE_OPT_CACHE_NUMA_INTERLEAVE:
+          cache_numa_interleave
+            = svn_tristate__from_word(arg) == svn_tristate_true;
+          break;
+
         case SVNSERVE_OPT_CACHE_TXDELTAS:
           cache_txdeltas = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
@@ -925,6 +1335,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           cache_nodeprops = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
 
+        case SVNSERVE_OPT_CACHE_BLAME:
+          params.cache_blame
+            = svn_tristate__from_word(arg) == svn_tristate_true;
+          break;
+
         case SVNSERVE_OPT_BLOCK_READ:
           use_block_read = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
@@ -962,6 +1377,14 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           max_thread_count = (apr_size_t)apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_UPDATE_THREADS:
+          params.update_threads = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_PROCESSES:
+          process_count = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
 #ifdef WIN32
         case SVNSERVE_OPT_SERVICE:
           if (run_mode != run_mode_service)
@@ -995,6 +1418,62 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           SVN_ERR(svn_dirent_get_absolute(&log_filename, log_filename, pool));
           break;
 
+        case SVNSERVE_OPT_LOG_FORMAT:
+          if (strcmp(arg, "text") == 0)
+            log_format = logger_format_text;
+          else if (strcmp(arg, "json") == 0)
+            log_format = logger_format_json;
+          else
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("Invalid log format '%s'; "
+                                       "expected 'text' or 'json'"),
+                                     arg);
+          break;
+
+        case SVNSERVE_OPT_LOG_BUFFER:
+          log_buffer_size = (apr_size_t)apr_strtoi64(arg, NULL, 0) * 0x400;
+          break;
+
+        case SVNSERVE_OPT_LOG_OVERFLOW:
+          if (strcmp(arg, "block") == 0)
+            log_drop_on_overflow = FALSE;
+          else if (strcmp(arg, "drop") == 0)
+            log_drop_on_overflow = TRUE;
+          else
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("Invalid log overflow policy '%s'; "
+                                       "expected 'block' or 'drop'"),
+                                     arg);
+          break;
+
+        case SVNSERVE_OPT_METRICS_FILE:
+          SVN_ERR(svn_utf_cstring_to_utf8(&metrics_filename, arg, pool));
+          metrics_filename = svn_dirent_internal_style(metrics_filename,
+                                                       pool);
+          SVN_ERR(svn_dirent_get_absolute(&metrics_filename, metrics_filename,
+                                          pool));
+          break;
+
+        case SVNSERVE_OPT_TRACE_FILE:
+          SVN_ERR(svn_utf_cstring_to_utf8(&trace_filename, arg, pool));
+          trace_filename = svn_dirent_internal_style(trace_filename, pool);
+          SVN_ERR(svn_dirent_get_absolute(&trace_filename, trace_filename,
+                                          pool));
+          SVN_ERR(svn_trace__enable(SVNSERVE_TRACE_SPANS));
+          break;
+
+        case SVNSERVE_OPT_TRACE_FORMAT:
+          if (strcmp(arg, "chrome") == 0)
+            trace_format = svn_trace__format_chrome;
+          else if (strcmp(arg, "otlp") == 0)
+            trace_format = svn_trace__format_otlp;
+          else
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("Invalid trace format '%s'; "
+                                       "expected 'chrome' or 'otlp'"),
+                                     arg);
+          break;
+
         }
     }
 
@@ -1036,6 +1515,23 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       return SVN_NO_ERROR;
     }
 
+  if (process_count < 1)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("Invalid number of processes %d"),
+                             process_count);
+
+  if (process_count > 1 && run_mode != run_mode_daemon)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Option --processes is only valid in "
+                              "daemon mode"));
+
+  /* The log flusher thread would not survive forking per connection. */
+  if (log_buffer_size && run_mode == run_mode_daemon
+      && handling_mode == connection_mode_fork)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Option --log-buffer-size is not valid "
+                              "when forking per connection"));
+
   /* construct object pools */
   is_multi_threaded = handling_mode == connection_mode_thread;
   params.fs_config = apr_hash_make(pool);
@@ -1053,6 +1549,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   SVN_ERR(svn_repos__config_pool_create(&params.config_pool,
                                         is_multi_threaded,
                                         pool));
+  SVN_ERR(svn_repos__repos_pool_create(&params.repos_pool,
+                                       is_multi_threaded,
+                                       pool));
 
   /* If a configuration file is specified, load it and any referenced
    * password and authorization files. */
@@ -1073,6 +1572,14 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   else if (run_mode == run_mode_listen_once)
     SVN_ERR(logger__create_for_stderr(&params.logger, pool));
 
+  if (params.logger)
+    {
+      logger__set_format(params.logger, log_format);
+      if (log_buffer_size)
+        SVN_ERR(logger__set_async(params.logger, log_buffer_size,
+                                  log_drop_on_overflow, pool));
+    }
+
   if (params.tunnel_user && run_mode != run_mode_tunnel)
     {
       return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
@@ -1203,38 +1710,20 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       return svn_error_wrap_apr(status, _("Can't get address info"));
     }
 
-
-#ifdef MAX_SECS_TO_LINGER
-  /* ### old APR interface */
-  status = apr_socket_create(&sock, sa->family, SOCK_STREAM, pool);
+  /* With SO_REUSEPORT, every daemon process gets its own listening socket
+   * and the kernel distributes the connections among them.  Otherwise,
+   * all processes accept() on the same socket.  Bind all of them here,
+   * so that we report errors before going into the background. */
+  socks = apr_pcalloc(pool, process_count * sizeof(*socks));
+#ifdef SO_REUSEPORT
+  for (i = 0; i < process_count; ++i)
+    SVN_ERR(create_server_socket(&socks[i], sa, process_count > 1, pool));
 #else
-  status = apr_socket_create(&sock, sa->family, SOCK_STREAM, APR_PROTO_TCP,
-                             pool);
+  SVN_ERR(create_server_socket(&socks[0], sa, FALSE, pool));
+  for (i = 1; i < process_count; ++i)
+    socks[i] = socks[0];
 #endif
-  if (status)
-    {
-      return svn_error_wrap_apr(status, _("Can't create server socket"));
-    }
-
-  /* Prevents "socket in use" errors when server is killed and quickly
-   * restarted. */
-  status = apr_socket_opt_set(sock, APR_SO_REUSEADDR, 1);
-  if (status)
-    {
-      return svn_error_wrap_apr(status, _("Can't set options on server socket"));
-    }
-
-  status = apr_socket_bind(sock, sa);
-  if (status)
-    {
-      return svn_error_wrap_apr(status, _("Can't bind server socket"));
-    }
-
-  status = apr_socket_listen(sock, ACCEPT_BACKLOG);
-  if (status)
-    {
-      return svn_error_wrap_apr(status, _("Can't listen on server socket"));
-    }
+  sock = socks[0];
 
 #if APR_HAS_FORK
   if (run_mode != run_mode_listen_once && !foreground)
@@ -1279,6 +1768,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     if (params.memory_cache_size != -1)
       settings.cache_size = params.memory_cache_size;
 
+    /* Stay within the configured total when running several processes. */
+    settings.cache_size /= process_count;
+    disk_cache_size /= process_count;
+
     settings.single_threaded = TRUE;
     if (handling_mode == connection_mode_thread)
       {
@@ -1297,6 +1790,47 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     svn_cache_config_set(&settings);
   }
 
+#if APR_HAS_FORK
+  /* Start the additional daemon processes.  They must not be created any
+   * later since threads would not survive the fork and the caches have
+   * not been created yet; each process will allocate its own. */
+  for (process_index = 1; process_index < process_count; ++process_index)
+    {
+      status = apr_proc_fork(&proc, pool);
+      if (status == APR_INCHILD)
+        break;
+      else if (status != APR_INPARENT)
+        return svn_error_wrap_apr(status, "apr_proc_fork");
+    }
+
+  if (process_index == process_count)
+    process_index = 0;
+#endif
+
+  sock = socks[process_index];
+  if (process_count > 1)
+    {
+      /* Close the sockets that other processes listen on. */
+      for (i = 0; i < process_count; ++i)
+        if (socks[i] != sock)
+          apr_socket_close(socks[i]);
+
+      /* These files cannot be shared between processes. */
+      if (disk_cache_file)
+        disk_cache_file = apr_psprintf(pool, "%s.%d", disk_cache_file,
+                                       process_index);
+      if (metrics_filename)
+        metrics_filename = apr_psprintf(pool, "%s.%d", metrics_filename,
+                                        process_index);
+      if (trace_filename)
+        trace_filename = apr_psprintf(pool, "%s.%d", trace_filename,
+                                      process_index);
+    }
+
+  svn_cache_config_set_disk_cache(disk_cache_file, disk_cache_size);
+  svn_cache_config_set_memory_placement(cache_huge_pages,
+                                        cache_numa_interleave);
+
 #if APR_HAS_THREADS
   SVN_ERR(svn_root_pools__create(&connection_pools));
 
@@ -1330,6 +1864,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     }
 #endif
 
+#if APR_HAS_THREADS
+  if (handling_mode == connection_mode_thread
+      && run_mode != run_mode_listen_once)
+    return svn_error_trace(serve_threaded(sock, &params, handling_mode,
+                                          pool));
+#endif
+
   while (1)
     {
       connection_t *connection = NULL;
@@ -1367,19 +1908,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           break;
 
         case connection_mode_thread:
-          /* Create a detached thread for each connection.  That's not a
-             particularly sophisticated strategy for a threaded server, it's
-             little different from forking one process per connection. */
-#if APR_HAS_THREADS
-          attach_connection(connection);
-
-          status = apr_thread_pool_push(threads, serve_thread, connection,
-                                        0, NULL);
-          if (status)
-            {
-              return svn_error_wrap_apr(status, _("Can't push task"));
-            }
-#endif
+          /* Handled by serve_threaded() above. */
           break;
 
         case connection_mode_single:
@@ -0,0 +1,857 @@
+/*
+ * prefetch.c :  Fetch revisions from the source ahead of the commits
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_thread_proc.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_cond.h>
+
+#include "svn_pools.h"
+#include "svn_delta.h"
+#include "svn_props.h"
+#include "svn_ra.h"
+#include "svn_sorts.h"
+
+#include "private/svn_subr_private.h"
+
+#include "sync.h"
+
+#include "svn_private_config.h"
+
+
+/* Recorded editor drives get their text deltas spilled to disk once they
+ * exceed this size. */
+#define SPILL_BLOCKSIZE (16 * 1024)
+#define SPILL_MAXSIZE (1024 * 1024)
+
+#if APR_HAS_THREADS
+
+/*** Recording editor drives. ***/
+
+/* The editor callbacks we record.  close_edit and abort_edit are left to
+ * the replay's revfinish callback. */
+typedef enum edit_op_kind_t
+{
+  op_set_target_revision,
+  op_open_root,
+  op_delete_entry,
+  op_add_directory,
+  op_open_directory,
+  op_change_dir_prop,
+  op_close_directory,
+  op_absent_directory,
+  op_add_file,
+  op_open_file,
+  op_apply_textdelta,
+  op_change_file_prop,
+  op_close_file,
+  op_absent_file
+} edit_op_kind_t;
+
+/* A single recorded editor call.  Node batons are numbered in the order
+ * of creation; BATON is the node the call creates or works on and PARENT
+ * its parent directory. */
+typedef struct edit_op_t
+{
+  edit_op_kind_t kind;
+  int baton;
+  int parent;
+
+  /* Path, or name of the property. */
+  const char *path;
+
+  /* Copy source, or base / result checksum for text changes. */
+  const char *copyfrom_path;
+
+  /* Copy source or base revision. */
+  svn_revnum_t revision;
+
+  /* Property value. */
+  const svn_string_t *value;
+
+  /* Length of the svndiff data in the revision's spill buffer that
+   * belongs to an apply_textdelta. */
+  svn_filesize_t delta_len;
+} edit_op_t;
+
+/* A revision fetched from the source but not processed yet. */
+typedef struct recorded_rev_t
+{
+  svn_revnum_t revision;
+
+  /* Revision properties as given to the revstart and revfinish callback,
+   * respectively. */
+  apr_hash_t *start_props;
+  apr_hash_t *finish_props;
+
+  /* Sequence of edit_op_t and number of node batons it uses. */
+  apr_array_header_t *ops;
+  int baton_count;
+
+  /* svndiff data of all text deltas, in order. */
+  svn_spillbuf_reader_t *deltas;
+
+  /* Next revision in the queue. */
+  struct recorded_rev_t *next;
+
+  /* Root pool with its own allocator, so it may be used by any thread. */
+  apr_pool_t *pool;
+} recorded_rev_t;
+
+/* Node baton of the recording editor. */
+typedef struct node_baton_t
+{
+  recorded_rev_t *rev;
+  int id;
+} node_baton_t;
+
+/* Append a new operation of KIND on node BATON to REV and return it. */
+static edit_op_t *
+push_op(recorded_rev_t *rev,
+        edit_op_kind_t kind,
+        int baton)
+{
+  edit_op_t *op = apr_array_push(rev->ops);
+
+  memset(op, 0, sizeof(*op));
+  op->kind = kind;
+  op->baton = baton;
+  op->parent = -1;
+  op->revision = SVN_INVALID_REVNUM;
+
+  return op;
+}
+
+/* Record an operation of KIND that creates a new node below PARENT_BATON.
+ * Return it in *OP and the node's baton in *CHILD_BATON. */
+static void
+push_node_op(edit_op_t **op,
+             void **child_baton,
+             edit_op_kind_t kind,
+             void *parent_baton,
+             const char *path)
+{
+  node_baton_t *pb = parent_baton;
+  recorded_rev_t *rev = pb->rev;
+  node_baton_t *nb = apr_palloc(rev->pool, sizeof(*nb));
+
+  nb->rev = rev;
+  nb->id = rev->baton_count++;
+
+  *op = push_op(rev, kind, nb->id);
+  (*op)->parent = pb->id;
+  (*op)->path = apr_pstrdup(rev->pool, path);
+  *child_baton = nb;
+}
+
+static svn_error_t *
+record_set_target_revision(void *edit_baton,
+                           svn_revnum_t target_revision,
+                           apr_pool_t *pool)
+{
+  recorded_rev_t *rev = edit_baton;
+
+  push_op(rev, op_set_target_revision, -1)->revision = target_revision;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_open_root(void *edit_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *pool,
+                 void **root_baton)
+{
+  recorded_rev_t *rev = edit_baton;
+  node_baton_t *nb = apr_palloc(rev->pool, sizeof(*nb));
+
+  nb->rev = rev;
+  nb->id = rev->baton_count++;
+  push_op(rev, op_open_root, nb->id)->revision = base_revision;
+
+  *root_baton = nb;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_delete_entry(const char *path,
+                    svn_revnum_t revision,
+                    void *parent_baton,
+                    apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  edit_op_t *op = push_op(pb->rev, op_delete_entry, -1);
+
+  op->parent = pb->id;
+  op->path = apr_pstrdup(pb->rev->pool, path);
+  op->revision = revision;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_add_directory(const char *path,
+                     void *parent_baton,
+                     const char *copyfrom_path,
+                     svn_revnum_t copyfrom_revision,
+                     apr_pool_t *pool,
+                     void **child_baton)
+{
+  edit_op_t *op;
+
+  push_node_op(&op, child_baton, op_add_directory, parent_baton, path);
+  op->copyfrom_path = apr_pstrdup(((node_baton_t *)parent_baton)->rev->pool,
+                                  copyfrom_path);
+  op->revision = copyfrom_revision;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_open_directory(const char *path,
+                      void *parent_baton,
+                      svn_revnum_t base_revision,
+                      apr_pool_t *pool,
+                      void **child_baton)
+{
+  edit_op_t *op;
+
+  push_node_op(&op, child_baton, op_open_directory, parent_baton, path);
+  op->revision = base_revision;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_add_file(const char *path,
+                void *parent_baton,
+                const char *copyfrom_path,
+                svn_revnum_t copyfrom_revision,
+                apr_pool_t *pool,
+                void **file_baton)
+{
+  edit_op_t *op;
+
+  push_node_op(&op, file_baton, op_add_file, parent_baton, path);
+  op->copyfrom_path = apr_pstrdup(((node_baton_t *)parent_baton)->rev->pool,
+                                  copyfrom_path);
+  op->revision = copyfrom_revision;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_open_file(const char *path,
+                 void *parent_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *pool,
+                 void **file_baton)
+{
+  edit_op_t *op;
+
+  push_node_op(&op, file_baton, op_open_file, parent_baton, path);
+  op->revision = base_revision;
+
+  return SVN_NO_ERROR;
+}
+
+/* Record a property change of NAME to VALUE on node BATON as KIND. */
+static svn_error_t *
+record_change_prop(edit_op_kind_t kind,
+                   void *baton,
+                   const char *name,
+                   const svn_string_t *value)
+{
+  node_baton_t *nb = baton;
+  edit_op_t *op = push_op(nb->rev, kind, nb->id);
+
+  op->path = apr_pstrdup(nb->rev->pool, name);
+  op->value = value ? svn_string_dup(value, nb->rev->pool) : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_change_dir_prop(void *dir_baton,
+                       const char *name,
+                       const svn_string_t *value,
+                       apr_pool_t *pool)
+{
+  return record_change_prop(op_change_dir_prop, dir_baton, name, value);
+}
+
+static svn_error_t *
+record_change_file_prop(void *file_baton,
+                        const char *name,
+                        const svn_string_t *value,
+                        apr_pool_t *pool)
+{
+  return record_change_prop(op_change_file_prop, file_baton, name, value);
+}
+
+/* Record closing node BATON as KIND with optional CHECKSUM. */
+static svn_error_t *
+record_close_node(edit_op_kind_t kind,
+                  void *baton,
+                  const char *checksum)
+{
+  node_baton_t *nb = baton;
+  edit_op_t *op = push_op(nb->rev, kind, nb->id);
+
+  op->copyfrom_path = apr_pstrdup(nb->rev->pool, checksum);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_close_directory(void *dir_baton,
+                       apr_pool_t *pool)
+{
+  return record_close_node(op_close_directory, dir_baton, NULL);
+}
+
+static svn_error_t *
+record_close_file(void *file_baton,
+                  const char *text_checksum,
+                  apr_pool_t *pool)
+{
+  return record_close_node(op_close_file, file_baton, text_checksum);
+}
+
+/* Record an absent node PATH below PARENT_BATON as KIND. */
+static svn_error_t *
+record_absent(edit_op_kind_t kind,
+              const char *path,
+              void *parent_baton)
+{
+  node_baton_t *pb = parent_baton;
+  edit_op_t *op = push_op(pb->rev, kind, -1);
+
+  op->parent = pb->id;
+  op->path = apr_pstrdup(pb->rev->pool, path);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_absent_directory(const char *path,
+                        void *parent_baton,
+                        apr_pool_t *pool)
+{
+  return record_absent(op_absent_directory, path, parent_baton);
+}
+
+static svn_error_t *
+record_absent_file(const char *path,
+                   void *parent_baton,
+                   apr_pool_t *pool)
+{
+  return record_absent(op_absent_file, path, parent_baton);
+}
+
+/* Baton for delta_write. */
+typedef struct delta_baton_t
+{
+  recorded_rev_t *rev;
+
+  /* Index of the apply_textdelta operation in REV->OPS. */
+  int op;
+} delta_baton_t;
+
+/* Implements svn_write_fn_t.  Append the svndiff data to the spill
+ * buffer of the revision in BATON, a delta_baton_t. */
+static svn_error_t *
+delta_write(void *baton,
+            const char *data,
+            apr_size_t *len)
+{
+  delta_baton_t *db = baton;
+
+  APR_ARRAY_IDX(db->rev->ops, db->op, edit_op_t).delta_len += *len;
+  return svn_error_trace(svn_spillbuf__reader_write(db->rev->deltas, data,
+                                                    *len, db->rev->pool));
+}
+
+static svn_error_t *
+record_apply_textdelta(void *file_baton,
+                       const char *base_checksum,
+                       apr_pool_t *pool,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  node_baton_t *nb = file_baton;
+  recorded_rev_t *rev = nb->rev;
+  delta_baton_t *db = apr_palloc(rev->pool, sizeof(*db));
+  svn_stream_t *stream;
+  edit_op_t *op = push_op(rev, op_apply_textdelta, nb->id);
+
+  op->copyfrom_path = apr_pstrdup(rev->pool, base_checksum);
+
+  db->rev = rev;
+  db->op = rev->ops->nelts - 1;
+
+  /* The data stays local, so don't waste cycles on compression. */
+  stream = svn_stream_create(db, pool);
+  svn_stream_set_write(stream, delta_write);
+  svn_txdelta_to_svndiff3(handler, handler_baton, stream, 0,
+                          SVN_DELTA_COMPRESSION_LEVEL_NONE, pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+record_close_edit(void *edit_baton,
+                  apr_pool_t *pool)
+{
+  return SVN_NO_ERROR;
+}
+
+/* Return an editor that records its drive in the recorded_rev_t edit
+ * baton. */
+static const svn_delta_editor_t *
+get_record_editor(apr_pool_t *pool)
+{
+  svn_delta_editor_t *editor = svn_delta_default_editor(pool);
+
+  editor->set_target_revision = record_set_target_revision;
+  editor->open_root = record_open_root;
+  editor->delete_entry = record_delete_entry;
+  editor->add_directory = record_add_directory;
+  editor->open_directory = record_open_directory;
+  editor->change_dir_prop = record_change_dir_prop;
+  editor->close_directory = record_close_directory;
+  editor->absent_directory = record_absent_directory;
+  editor->add_file = record_add_file;
+  editor->open_file = record_open_file;
+  editor->apply_textdelta = record_apply_textdelta;
+  editor->change_file_prop = record_change_file_prop;
+  editor->close_file = record_close_file;
+  editor->absent_file = record_absent_file;
+  editor->close_edit = record_close_edit;
+  editor->abort_edit = record_close_edit;
+
+  return editor;
+}
+
+/* Feed the text delta of OP from REV into the window HANDLER/BATON. */
+static svn_error_t *
+play_textdelta(recorded_rev_t *rev,
+               const edit_op_t *op,
+               svn_txdelta_window_handler_t handler,
+               void *handler_baton,
+               apr_pool_t *scratch_pool)
+{
+  svn_stream_t *parser = svn_txdelta_parse_svndiff(handler, handler_baton,
+                                                   TRUE, scratch_pool);
+  svn_filesize_t remaining = op->delta_len;
+  char *buffer = apr_palloc(scratch_pool, SPILL_BLOCKSIZE);
+
+  while (remaining > 0)
+    {
+      apr_size_t len = (apr_size_t)MIN(remaining, SPILL_BLOCKSIZE);
+      apr_size_t amt;
+
+      SVN_ERR(svn_spillbuf__reader_read(&amt, rev->deltas, buffer, len,
+                                        scratch_pool));
+      if (amt == 0)
+        return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL, NULL);
+
+      SVN_ERR(svn_stream_write(parser, buffer, &amt));
+      remaining -= amt;
+    }
+
+  return svn_error_trace(svn_stream_close(parser));
+}
+
+/* Drive EDITOR / EDIT_BATON as recorded in REV.  Allocate node batons in
+ * POOL. */
+static svn_error_t *
+play_recording(recorded_rev_t *rev,
+               const svn_delta_editor_t *editor,
+               void *edit_baton,
+               apr_pool_t *pool)
+{
+  void **batons = apr_pcalloc(pool, (rev->baton_count + 1) * sizeof(*batons));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; i < rev->ops->nelts; i++)
+    {
+      const edit_op_t *op = &APR_ARRAY_IDX(rev->ops, i, edit_op_t);
+      void *parent = op->parent >= 0 ? batons[op->parent] : NULL;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+
+      svn_pool_clear(iterpool);
+      switch (op->kind)
+        {
+          case op_set_target_revision:
+            SVN_ERR(editor->set_target_revision(edit_baton, op->revision,
+                                                iterpool));
+            break;
+
+          case op_open_root:
+            SVN_ERR(editor->open_root(edit_baton, op->revision, pool,
+                                      &batons[op->baton]));
+            break;
+
+          case op_delete_entry:
+            SVN_ERR(editor->delete_entry(op->path, op->revision, parent,
+                                         iterpool));
+            break;
+
+          case op_add_directory:
+            SVN_ERR(editor->add_directory(op->path, parent,
+                                          op->copyfrom_path, op->revision,
+                                          pool, &batons[op->baton]));
+            break;
+
+          case op_open_directory:
+            SVN_ERR(editor->open_directory(op->path, parent, op->revision,
+                                           pool, &batons[op->baton]));
+            break;
+
+          case op_change_dir_prop:
+            SVN_ERR(editor->change_dir_prop(batons[op->baton], op->path,
+                                            op->value, iterpool));
+            break;
+
+          case op_close_directory:
+            SVN_ERR(editor->close_directory(batons[op->baton], iterpool));
+            break;
+
+          case op_absent_directory:
+            SVN_ERR(editor->absent_directory(op->path, parent, iterpool));
+            break;
+
+          case op_add_file:
+            SVN_ERR(editor->add_file(op->path, parent, op->copyfrom_path,
+                                     op->revision, pool,
+                                     &batons[op->baton]));
+            break;
+
+          case op_open_file:
+            SVN_ERR(editor->open_file(op->path, parent, op->revision, pool,
+                                      &batons[op->baton]));
+            break;
+
+          case op_apply_textdelta:
+            SVN_ERR(editor->apply_textdelta(batons[op->baton],
+                                            op->copyfrom_path, pool,
+                                            &handler, &handler_baton));
+            SVN_ERR(play_textdelta(rev, op, handler, handler_baton,
+                                   iterpool));
+            break;
+
+          case op_change_file_prop:
+            SVN_ERR(editor->change_file_prop(batons[op->baton], op->path,
+                                             op->value, iterpool));
+            break;
+
+          case op_close_file:
+            SVN_ERR(editor->close_file(batons[op->baton], op->copyfrom_path,
+                                       iterpool));
+            break;
+
+          case op_absent_file:
+            SVN_ERR(editor->absent_file(op->path, parent, iterpool));
+            break;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+
+/*** The prefetch queue. ***/
+
+/* Shared state of the fetching thread and the committing caller.
+ * HEAD, TAIL, QUEUED, FINISHED, ABORTED and ERR must only be accessed
+ * while holding MUTEX. */
+typedef struct prefetch_queue_t
+{
+  /* Parameters of the replay. */
+  svn_ra_session_t *from_session;
+  svn_revnum_t start_revision;
+  svn_revnum_t end_revision;
+  int lookahead;
+
+  /* Fetched revisions not yet taken by the caller, oldest first. */
+  recorded_rev_t *head;
+  recorded_rev_t *tail;
+  int queued;
+
+  /* The revision currently being fetched. */
+  recorded_rev_t *current;
+
+  /* Set by the fetching thread when the replay is done, together with
+   * its result ERR. */
+  svn_boolean_t finished;
+  svn_error_t *err;
+
+  /* Set by the caller if it won't take any further revisions. */
+  svn_boolean_t aborted;
+
+  apr_thread_mutex_t *mutex;
+  apr_thread_cond_t *changed;
+
+  /* Pool used by the fetching thread only. */
+  apr_pool_t *thread_pool;
+} prefetch_queue_t;
+
+/* Implements svn_ra_replay_revstart_callback_t for the fetching thread.
+ * Wait for space in the queue in REPLAY_BATON, then record the revision.
+ */
+static svn_error_t *
+fetch_rev_started(svn_revnum_t revision,
+                  void *replay_baton,
+                  const svn_delta_editor_t **editor,
+                  void **edit_baton,
+                  apr_hash_t *rev_props,
+                  apr_pool_t *pool)
+{
+  prefetch_queue_t *queue = replay_baton;
+  recorded_rev_t *rev;
+  apr_pool_t *rev_pool;
+  svn_boolean_t aborted;
+
+  apr_thread_mutex_lock(queue->mutex);
+  while (!queue->aborted && queue->queued >= queue->lookahead)
+    apr_thread_cond_wait(queue->changed, queue->mutex);
+  aborted = queue->aborted;
+  apr_thread_mutex_unlock(queue->mutex);
+
+  if (aborted)
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  rev_pool = svn_pool_create(NULL);
+  rev = apr_pcalloc(rev_pool, sizeof(*rev));
+  rev->pool = rev_pool;
+  rev->revision = revision;
+  rev->start_props = svn_prop_hash_dup(rev_props, rev->pool);
+  rev->ops = apr_array_make(rev->pool, 16, sizeof(edit_op_t));
+  rev->deltas = svn_spillbuf__reader_create(SPILL_BLOCKSIZE, SPILL_MAXSIZE,
+                                            rev->pool);
+  queue->current = rev;
+
+  *editor = get_record_editor(pool);
+  *edit_baton = rev;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_replay_revfinish_callback_t for the fetching thread.
+ * Hand the recorded revision over to the caller.
+ */
+static svn_error_t *
+fetch_rev_finished(svn_revnum_t revision,
+                   void *replay_baton,
+                   const svn_delta_editor_t *editor,
+                   void *edit_baton,
+                   apr_hash_t *rev_props,
+                   apr_pool_t *pool)
+{
+  prefetch_queue_t *queue = replay_baton;
+  recorded_rev_t *rev = edit_baton;
+
+  rev->finish_props = svn_prop_hash_dup(rev_props, rev->pool);
+  queue->current = NULL;
+
+  apr_thread_mutex_lock(queue->mutex);
+  if (queue->tail)
+    queue->tail->next = rev;
+  else
+    queue->head = rev;
+  queue->tail = rev;
+  ++queue->queued;
+  apr_thread_cond_broadcast(queue->changed);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetching thread main function.  DATA is the prefetch_queue_t.
+ * Replay the whole range into the queue.
+ */
+static void *
+APR_THREAD_FUNC fetch_thread_func(apr_thread_t *tid, void *data)
+{
+  prefetch_queue_t *queue = data;
+  svn_error_t *err;
+
+  err = svn_ra_replay_range(queue->from_session, queue->start_revision,
+                            queue->end_revision, 0, TRUE,
+                            fetch_rev_started, fetch_rev_finished, queue,
+                            queue->thread_pool);
+
+  /* Drop a partially recorded revision. */
+  if (queue->current)
+    {
+      svn_pool_destroy(queue->current->pool);
+      queue->current = NULL;
+    }
+
+  apr_thread_mutex_lock(queue->mutex);
+  queue->finished = TRUE;
+  queue->err = err;
+  apr_thread_cond_broadcast(queue->changed);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Wait for the next revision in QUEUE and return it in *REV.  Set *REV
+ * to NULL if the fetching thread finished without providing another one.
+ */
+static void
+take_next_rev(recorded_rev_t **rev,
+              prefetch_queue_t *queue)
+{
+  apr_thread_mutex_lock(queue->mutex);
+  while (!queue->head && !queue->finished)
+    apr_thread_cond_wait(queue->changed, queue->mutex);
+
+  *rev = queue->head;
+  if (*rev)
+    {
+      queue->head = (*rev)->next;
+      if (!queue->head)
+        queue->tail = NULL;
+      --queue->queued;
+      apr_thread_cond_broadcast(queue->changed);
+    }
+  apr_thread_mutex_unlock(queue->mutex);
+}
+
+/* Stop the fetching thread TID of QUEUE, release all revisions not taken
+ * yet and return the thread's error. */
+static svn_error_t *
+stop_fetching(prefetch_queue_t *queue,
+              apr_thread_t *tid)
+{
+  apr_status_t retval;
+  recorded_rev_t *rev;
+
+  apr_thread_mutex_lock(queue->mutex);
+  queue->aborted = TRUE;
+  apr_thread_cond_broadcast(queue->changed);
+  apr_thread_mutex_unlock(queue->mutex);
+
+  apr_thread_join(&retval, tid);
+
+  for (rev = queue->head; rev; rev = queue->head)
+    {
+      queue->head = rev->next;
+      svn_pool_destroy(rev->pool);
+    }
+
+  /* We caused the cancellation ourselves. */
+  if (queue->err && queue->err->apr_err == SVN_ERR_CANCELLED)
+    {
+      svn_error_clear(queue->err);
+      queue->err = SVN_NO_ERROR;
+    }
+
+  return queue->err;
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svnsync_replay_range(svn_ra_session_t *from_session,
+                     svn_revnum_t start_revision,
+                     svn_revnum_t end_revision,
+                     int lookahead,
+                     svn_ra_replay_revstart_callback_t revstart_func,
+                     svn_ra_replay_revfinish_callback_t revfinish_func,
+                     void *replay_baton,
+                     apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  prefetch_queue_t *queue;
+  apr_thread_t *tid;
+  apr_pool_t *iterpool;
+  svn_revnum_t revision;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_status_t status;
+
+  if (lookahead > 0)
+    {
+      queue = apr_pcalloc(pool, sizeof(*queue));
+      queue->from_session = from_session;
+      queue->start_revision = start_revision;
+      queue->end_revision = end_revision;
+      queue->lookahead = lookahead;
+      queue->thread_pool = svn_pool_create(pool);
+
+      status = apr_thread_mutex_create(&queue->mutex,
+                                       APR_THREAD_MUTEX_DEFAULT, pool);
+      if (!status)
+        status = apr_thread_cond_create(&queue->changed, pool);
+      if (!status)
+        status = apr_thread_create(&tid, NULL, fetch_thread_func, queue,
+                                   pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't start fetching thread"));
+
+      iterpool = svn_pool_create(pool);
+      for (revision = start_revision;
+           !err && revision <= end_revision;
+           revision++)
+        {
+          recorded_rev_t *rev;
+          const svn_delta_editor_t *editor;
+          void *edit_baton;
+
+          svn_pool_clear(iterpool);
+
+          take_next_rev(&rev, queue);
+          if (!rev)
+            break;
+
+          err = revstart_func(rev->revision, replay_baton, &editor,
+                              &edit_baton, rev->start_props, iterpool);
+          if (!err)
+            err = play_recording(rev, editor, edit_baton, iterpool);
+          if (!err)
+            err = revfinish_func(rev->revision, replay_baton, editor,
+                                 edit_baton, rev->finish_props, iterpool);
+
+          svn_pool_destroy(rev->pool);
+        }
+      svn_pool_destroy(iterpool);
+
+      err = svn_error_compose_create(err, stop_fetching(queue, tid));
+      svn_pool_destroy(queue->thread_pool);
+
+      return svn_error_trace(err);
+    }
+#endif
+
+  return svn_error_trace(svn_ra_replay_range(from_session, start_revision,
+                                             end_revision, 0, TRUE,
+                                             revstart_func, revfinish_func,
+                                             replay_baton, pool));
+}
@@ -71,7 +71,8 @@ enum svnsync__opt {
   svnsync_opt_trust_server_cert_failures_dst,
   svnsync_opt_allow_non_empty,
   svnsync_opt_skip_unchanged,
-  svnsync_opt_steal_lock
+  svnsync_opt_steal_lock,
+  svnsync_opt_lookahead
 };
 
 #define SVNSYNC_OPTS_DEFAULT svnsync_opt_non_interactive, \
@@ -127,9 +128,14 @@ static const svn_opt_subcommand_desc2_t svnsync_cmd_table[] =
          "ignoring what is recorded in the destination repository as the\n"
          "source URL.  Specifying SOURCE_URL is recommended in particular\n"
          "if untrusted users/administrators may have write access to the\n"
-         "DEST_URL repository.\n"),
+         "DEST_URL repository.\n"
+         "\n"
+         "Use --lookahead to fetch revisions from the source while earlier\n"
+         "ones are still being committed to the destination.  This helps\n"
+         "in particular when the source is far away in terms of latency.\n"),
       { SVNSYNC_OPTS_DEFAULT, svnsync_opt_source_prop_encoding, 'q',
-        svnsync_opt_disable_locking, svnsync_opt_steal_lock, 'M' } },
+        svnsync_opt_disable_locking, svnsync_opt_steal_lock,
+        svnsync_opt_lookahead, 'M' } },
     { "copy-revprops", copy_revprops_cmd, { 0 },
       N_("usage:\n"
          "\n"
@@ -274,6 +280,14 @@ static const apr_getopt_option_t svnsync_options[] =
                           "and is not being concurrently accessed by another\n"
                           "                             "
                           "svnsync instance.")},
+    {"lookahead",      svnsync_opt_lookahead, 1,
+                       N_("fetch up to ARG revisions from the source ahead\n"
+                          "                             "
+                          "of the one being committed to the destination.\n"
+                          "                             "
+                          "They are kept in temporary files as needed.\n"
+                          "                             "
+                          "[default: 0, i.e. fetch and commit alternately]")},
     {"memory-cache-size", 'M', 1,
                        N_("size of the extra in-memory cache in MB used to\n"
                           "                             "
@@ -311,6 +325,7 @@ typedef struct opt_baton_t {
   svn_boolean_t quiet;
   svn_boolean_t allow_non_empty;
   svn_boolean_t skip_unchanged;
+  int lookahead;
   svn_boolean_t version;
   svn_boolean_t help;
   svn_opt_revision_t start_rev;
@@ -420,6 +435,7 @@ typedef struct subcommand_baton_t {
 
   /* synchronize only */
   svn_revnum_t committed_rev;
+  int lookahead;
 
   /* copy-revprops only */
   svn_revnum_t start_rev;
@@ -761,6 +777,7 @@ make_subcommand_baton(opt_baton_t *opt_baton,
   b->sync_callbacks.auth_baton = opt_baton->sync_auth_baton;
   b->quiet = opt_baton->quiet;
   b->skip_unchanged = opt_baton->skip_unchanged;
+  b->lookahead = opt_baton->lookahead;
   b->allow_non_empty = opt_baton->allow_non_empty;
   b->to_url = to_url;
   b->source_prop_encoding = opt_baton->source_prop_encoding;
@@ -1551,9 +1568,9 @@ do_synchronize(svn_ra_session_t *to_session,
 
   SVN_ERR(check_cancel(NULL));
 
-  SVN_ERR(svn_ra_replay_range(from_session, start_revision, end_revision,
-                              0, TRUE, replay_rev_started,
-                              replay_rev_finished, rb, pool));
+  SVN_ERR(svnsync_replay_range(from_session, start_revision, end_revision,
+                               baton->lookahead, replay_rev_started,
+                               replay_rev_finished, rb, pool));
 
   SVN_ERR(log_properties_normalized(rb->normalized_rev_props_count
                                       + normalized_rev_props_count,
@@ -2125,6 +2142,18 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
             opt_baton.skip_unchanged = TRUE;
             break;
 
+          case svnsync_opt_lookahead:
+            {
+              const char *utf8_opt_arg;
+              SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+              err = svn_cstring_atoi(&opt_baton.lookahead, utf8_opt_arg);
+              if (err || opt_baton.lookahead < 0)
+                return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                         _("Invalid lookahead '%s'"),
+                                         utf8_opt_arg);
+            }
+            break;
+
           case 'q':
             opt_baton.quiet = TRUE;
             break;
@@ -2407,10 +2436,11 @@ main(int argc, const char *argv[])
   if (svn_cmdline_init("svnsync", stderr) != EXIT_SUCCESS)
     return EXIT_FAILURE;
 
-  /* Create our top-level pool.  Use a separate mutexless allocator,
-   * given this application is single threaded.
+  /* Create our top-level pool.  Use a separate allocator with a mutex,
+   * since 'sync --lookahead' fetches revisions from the source session
+   * in a separate thread.
    */
-  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
 
   err = sub_main(&exit_code, argc, argv, pool);
 
@@ -31,6 +31,7 @@ extern "C" {
 
 #include "svn_types.h"
 #include "svn_delta.h"
+#include "svn_ra.h"
 
 
 /* Normalize the encoding and line ending style of the values of properties
@@ -78,6 +79,28 @@ svnsync_get_sync_editor(const svn_delta_editor_t *wrapped_editor,
                         apr_pool_t *pool);
 
 
+/* Like svn_ra_replay_range() on FROM_SESSION for START_REVISION through
+ * END_REVISION with deltas and a low water mark of 0, except that up to
+ * LOOKAHEAD revisions get fetched ahead of the one REVSTART_FUNC and
+ * REVFINISH_FUNC are processing.  The editor drives of those revisions
+ * are recorded, with their text deltas kept in spill buffers.
+ *
+ * FROM_SESSION gets used by a separate thread, so the caller must not
+ * touch it until this returns and POOL's allocator must be thread-safe.
+ * Without thread support or if LOOKAHEAD is 0, this is a plain
+ * svn_ra_replay_range() call.
+ */
+svn_error_t *
+svnsync_replay_range(svn_ra_session_t *from_session,
+                     svn_revnum_t start_revision,
+                     svn_revnum_t end_revision,
+                     int lookahead,
+                     svn_ra_replay_revstart_callback_t revstart_func,
+                     svn_ra_replay_revfinish_callback_t revfinish_func,
+                     void *replay_baton,
+                     apr_pool_t *pool);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -3128,6 +3128,49 @@ def filtered_ls(sbox):
   exit_code, output, error = svntest.actions.run_and_verify_svn(
     None, [], 'ls', path, '--depth=infinity', '--search=*a')
 
+@Skip(svntest.main.is_ra_type_file)
+def ls_recursive_depth_authz(sbox):
+  "'svn ls -R --depth' with authz-filtered entries"
+
+  sbox.build(create_wc=False)
+
+  svntest.main.write_restrictive_svnserve_conf(sbox.repo_dir)
+  svntest.main.write_authz_file(sbox, { "/"         : "* = r",
+                                        "/A/B"      : "* =",
+                                        "/A/D/G/rho": "* =" })
+
+  url = sbox.repo_url + '/A'
+
+  # The unreadable A/B and A/D/G/rho are left out at any depth.
+  expected = svntest.verify.UnorderedOutput([
+    "C/\n",
+    "D/\n",
+    "D/G/\n",
+    "D/G/pi\n",
+    "D/G/tau\n",
+    "D/H/\n",
+    "D/H/chi\n",
+    "D/H/omega\n",
+    "D/H/psi\n",
+    "D/gamma\n",
+    "mu\n",
+    ])
+  svntest.actions.run_and_verify_svn(expected, [], 'ls', '-R', url)
+
+  expected = svntest.verify.UnorderedOutput(["C/\n", "D/\n", "mu\n"])
+  svntest.actions.run_and_verify_svn(expected, [], 'ls', '-R',
+                                     '--depth=immediates', url)
+
+  svntest.actions.run_and_verify_svn(["mu\n"], [], 'ls', '-R',
+                                     '--depth=files', url)
+
+  svntest.actions.run_and_verify_svn([], [], 'ls', '-R',
+                                     '--depth=empty', url)
+
+  expected = svntest.verify.UnorderedOutput(["pi\n", "tau\n"])
+  svntest.actions.run_and_verify_svn(expected, [], 'ls', '-R',
+                                     url + '/D/G')
+
 ########################################################################
 # Run the tests
 
@@ -3199,6 +3242,7 @@ test_list = [ None,
               mkdir_parents_target_exists_on_disk,
               plaintext_password_storage_disabled,
               filtered_ls,
+              ls_recursive_depth_authz,
              ]
 
 if __name__ == '__main__':
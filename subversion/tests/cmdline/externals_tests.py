@@ -4398,6 +4398,52 @@ def invalid_uris_in_repo(sbox):
                                             "-r", revision)
     svntest.main.safe_rmtree(sbox.wc_dir)
 
+def checkout_externals_concurrently(sbox):
+  "check out externals on several threads"
+
+  externals_test_setup(sbox)
+
+  wc_dir         = sbox.wc_dir
+  repo_url       = sbox.repo_url
+
+  exit_code, output, errput = svntest.actions.run_and_verify_svn(
+                                None, [],
+                                'checkout', repo_url, wc_dir,
+                                '--config-option',
+                                'config:miscellany:externals-concurrency=4')
+
+  # The notifications of the checkout threads have been passed on.
+  for path in ['A/C/exdir_G/pi', 'A/C/exdir_H/omega',
+               'A/D/exdir_A/mu', 'A/D/exdir_A/G/rho',
+               'A/D/exdir_A/H/psi', 'A/D/x/y/z/blah/E/alpha']:
+    if ('A    ' + sbox.ospath(path) + '\n') not in output:
+      raise svntest.Failure("Addition of '%s' not reported" % path)
+
+  # Pick a file at random, make sure it has the expected contents.
+  for path, contents in ((sbox.ospath('A/C/exdir_H/omega'),
+                          "This is the file 'omega'.\n"),
+                         (sbox.ospath('A/D/exdir_A/H/omega'),
+                          "This is the file 'omega'.\n"),
+                         (sbox.ospath('A/B/gamma'),
+                          "This is the file 'gamma'.\n")):
+    if open(path).read() != contents:
+      raise svntest.Failure("Unexpected contents for rev 1 of " + path)
+
+  # All of them have been registered in the defining working copy.
+  exit_code, output, errput = svntest.actions.run_and_verify_svn(
+                                None, [], 'status', wc_dir)
+  for path in ['A/C/exdir_G', 'A/C/exdir_H', 'A/D/exdir_A',
+               'A/D/exdir_A/G', 'A/D/exdir_A/H', 'A/D/x/y/z/blah']:
+    if ('X       ' + sbox.ospath(path) + '\n') not in output:
+      raise svntest.Failure("External '%s' not registered" % path)
+
+  # And they can be updated.
+  svntest.actions.run_and_verify_svn(None, [],
+                                     'update', wc_dir,
+                                     '--config-option',
+                                     'config:miscellany:'
+                                     'externals-concurrency=4')
+
 ########################################################################
 # Run the tests
 
@@ -4474,6 +4520,7 @@ test_list = [ None,
               file_external_recorded_info,
               external_externally_removed,
               invalid_uris_in_repo,
+              checkout_externals_concurrently,
              ]
 
 if __name__ == '__main__':
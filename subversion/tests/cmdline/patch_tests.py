@@ -28,6 +28,7 @@
 # General modules
 import base64
 import os
+import random
 import re
 import sys
 import tempfile
@@ -7791,6 +7792,162 @@ def patch_merge(sbox):
                                        expected_disk, None,
                                        expected_skip)
 
+def patch_binary_file_delta(sbox):
+  "patch a binary file with git deltas"
+
+  sbox.build()
+  wc_dir = sbox.wc_dir
+
+  # Incompressible contents, large enough for deltas to be used
+  rnd = random.Random(1)
+  original = bytes(bytearray(rnd.randrange(256) for i in range(65536)))
+  modified = original[:30000] + b'\0changed\0' + original[30000:]
+
+  blob_path = sbox.ospath('blob')
+  svntest.main.file_write(blob_path, original, mode='wb')
+  sbox.simple_add('blob')
+  sbox.simple_propset('svn:mime-type', 'application/octet-stream', 'blob')
+  sbox.simple_commit() # r2
+
+  svntest.main.file_write(blob_path, modified, mode='wb')
+
+  _, diff_output, _ = svntest.actions.run_and_verify_svn(None, [],
+                                                         'diff', '--git',
+                                                         wc_dir)
+
+  # Both versions should be described by short deltas, not literals
+  if ([l.split()[0] for l in diff_output if l.startswith(('literal ',
+                                                          'delta '))]
+      != ['delta', 'delta']) or len(diff_output) > 40:
+    raise svntest.Failure("Expected a short delta based binary patch")
+
+  sbox.simple_revert('blob')
+
+  tmp = sbox.get_tempname()
+  svntest.main.file_write(tmp, ''.join(diff_output))
+
+  expected_output = wc.State(wc_dir, {
+    'blob'              : Item(status='U '),
+  })
+  expected_disk = svntest.main.greek_state.copy()
+  expected_disk.add({
+    'blob' : Item(contents=modified,
+                  props={'svn:mime-type':'application/octet-stream'}),
+  })
+  expected_status = svntest.actions.get_virginal_state(wc_dir, 1)
+  expected_status.add({
+    'blob' : Item(status='M ', wc_rev=2),
+  })
+  expected_skip = wc.State('', { })
+
+  svntest.actions.run_and_verify_patch(wc_dir, tmp,
+                                       expected_output, expected_disk,
+                                       expected_status, expected_skip,
+                                       [], True, True)
+
+  # And apply it backwards
+  expected_disk.tweak('blob', contents=original)
+  expected_status.tweak('blob', status='  ')
+  svntest.actions.run_and_verify_patch(wc_dir, tmp,
+                                       expected_output, expected_disk,
+                                       expected_status, expected_skip,
+                                       [], True, True, '--reverse-diff')
+
+def patch_fuzz_closest_candidate(sbox):
+  "patch with fuzz picks the closest of several matches"
+
+  sbox.build()
+  wc_dir = sbox.wc_dir
+  patch_file_path = sbox.get_tempname('my.patch')
+
+  # The context of the hunk below matches, with fuzz 1, at lines 2, 7
+  # and 14.  The hunk claims line 10, so line 7 is the closest match,
+  # and neither the first nor the last one.
+  iota_contents = [
+    "header\n",
+    "alpha\n",
+    "beta\n",
+    "gamma\n",
+    "delta\n",
+    "one\n",
+    "alpha\n",
+    "beta\n",
+    "gamma\n",
+    "delta\n",
+    "two\n",
+    "three\n",
+    "four\n",
+    "alpha\n",
+    "beta\n",
+    "gamma\n",
+    "delta\n",
+    "footer\n",
+  ]
+
+  # The same, but only matching when whitespace is ignored.
+  gamma_contents = list(iota_contents)
+  gamma_contents[2] = "be ta\n"
+  gamma_contents[7] = "\tbeta  \n"
+  gamma_contents[8] = "  gamma\n"
+  gamma_contents[14] = "b e t a\n"
+
+  sbox.simple_append('iota', ''.join(iota_contents), truncate=True)
+  sbox.simple_append('A/D/gamma', ''.join(gamma_contents), truncate=True)
+  sbox.simple_commit()
+
+  unidiff_patch = [
+    "Index: %s\n",
+    "===================================================================\n",
+    "--- %s\t(revision 2)\n",
+    "+++ %s\t(working copy)\n",
+    "@@ -10,4 +10,5 @@\n",
+    " missing\n",
+    " beta\n",
+    "+inserted\n",
+    " gamma\n",
+    " delta\n",
+  ]
+  patch = ''.join(unidiff_patch)
+
+  svntest.main.file_write(patch_file_path,
+                          patch.replace('%s', 'iota'))
+
+  expected_output = [
+    'U         %s\n' % sbox.ospath('iota'),
+    '>         applied hunk @@ -10,4 +10,5 @@ with offset -3 and fuzz 1\n',
+  ]
+  expected_disk = svntest.main.greek_state.copy()
+  expected_disk.tweak('iota',
+                      contents=''.join(iota_contents[:8] + ["inserted\n"]
+                                       + iota_contents[8:]))
+  expected_disk.tweak('A/D/gamma', contents=''.join(gamma_contents))
+  expected_status = svntest.actions.get_virginal_state(wc_dir, 1)
+  expected_status.tweak('iota', status='M ', wc_rev=2)
+  expected_status.tweak('A/D/gamma', wc_rev=2)
+  expected_skip = wc.State('', { })
+
+  svntest.actions.run_and_verify_patch(wc_dir, patch_file_path,
+                                       expected_output, expected_disk,
+                                       expected_status, expected_skip,
+                                       [], True, True)
+
+  svntest.main.file_write(patch_file_path,
+                          patch.replace('%s', 'A/D/gamma'))
+
+  expected_output = [
+    'U         %s\n' % sbox.ospath('A/D/gamma'),
+    '>         applied hunk @@ -10,4 +10,5 @@ with offset -3 and fuzz 1\n',
+  ]
+  expected_disk.tweak('A/D/gamma',
+                      contents=''.join(gamma_contents[:8] + ["inserted\n"]
+                                       + gamma_contents[8:]))
+  expected_status.tweak('A/D/gamma', status='M ')
+
+  svntest.actions.run_and_verify_patch(wc_dir, patch_file_path,
+                                       expected_output, expected_disk,
+                                       expected_status, expected_skip,
+                                       [], True, True, '--ignore-whitespace')
+
 ########################################################################
 #Run the tests
 
@@ -7874,6 +8031,8 @@ test_list = [ None,
               missing_trailing_context,
               patch_missed_trail,
               patch_merge,
+              patch_binary_file_delta,
+              patch_fuzz_closest_candidate,
             ]
 
 if __name__ == '__main__':
@@ -1638,6 +1638,82 @@ def revert_moved_dir_partial(sbox):
   sbox.simple_move('A', 'A_')
   svntest.actions.run_and_verify_svn(None, [], 'revert', sbox.ospath('A'))
 
+def revert_tree_mixed_states(sbox):
+  "recursive revert of a tree with mixed states"
+
+  sbox.build(read_only = True)
+  wc_dir = sbox.wc_dir
+
+  # Text changes only, which leave no trace in the revert list.
+  sbox.simple_append('A/mu', 'extra text\n')
+  sbox.simple_append('A/B/E/beta', 'extra text\n')
+
+  # Property changes, a deletion and a missing file.
+  sbox.simple_propset('random-prop', 'propvalue', 'A/B/lambda', 'A/D/G')
+  sbox.simple_rm('A/D/G/pi')
+  os.remove(sbox.ospath('A/D/H/chi'))
+
+  # Additions and copies.
+  sbox.simple_append('A/D/H/zeta', 'This is the file zeta.\n')
+  sbox.simple_add('A/D/H/zeta')
+  sbox.simple_mkdir('A/C/X')
+  sbox.simple_append('A/C/X/file', 'This is a file.\n')
+  sbox.simple_add('A/C/X/file')
+  sbox.simple_copy('A/D/gamma', 'A/D/gamma2')
+  sbox.simple_copy('A/B/E', 'A/B/E2')
+
+  expected_status = svntest.actions.get_virginal_state(wc_dir, 1)
+  expected_status.tweak('A/mu', 'A/B/E/beta', status='M ')
+  expected_status.tweak('A/B/lambda', 'A/D/G', status=' M')
+  expected_status.tweak('A/D/G/pi', status='D ')
+  expected_status.tweak('A/D/H/chi', status='! ')
+  expected_status.add({
+    'A/D/H/zeta'   : Item(status='A ', wc_rev=0),
+    'A/C/X'        : Item(status='A ', wc_rev=0),
+    'A/C/X/file'   : Item(status='A ', wc_rev=0),
+    'A/D/gamma2'   : Item(status='A ', copied='+', wc_rev='-'),
+    'A/B/E2'       : Item(status='A ', copied='+', wc_rev='-'),
+    'A/B/E2/alpha' : Item(status='  ', copied='+', wc_rev='-'),
+    'A/B/E2/beta'  : Item(status='  ', copied='+', wc_rev='-'),
+    })
+  svntest.actions.run_and_verify_status(wc_dir, expected_status)
+
+  expected_output = svntest.verify.UnorderedOutput([
+    "Reverted '%s'\n" % sbox.ospath(path) for path in ['A/mu',
+                                                       'A/B/E/beta',
+                                                       'A/B/lambda',
+                                                       'A/D/G',
+                                                       'A/D/G/pi',
+                                                       'A/D/H/chi',
+                                                       'A/D/H/zeta',
+                                                       'A/C/X',
+                                                       'A/C/X/file',
+                                                       'A/D/gamma2',
+                                                       'A/B/E2',
+                                                       'A/B/E2/alpha',
+                                                       'A/B/E2/beta']])
+  svntest.actions.run_and_verify_svn(expected_output, [],
+                                     'revert', '-R', wc_dir)
+
+  # The added nodes stay behind unversioned, the copies are gone.
+  expected_status = svntest.actions.get_virginal_state(wc_dir, 1)
+  expected_status.add({
+    'A/D/H/zeta'   : Item(status='? '),
+    'A/C/X'        : Item(status='? '),
+    })
+  svntest.actions.run_and_verify_status(wc_dir, expected_status)
+
+  expected_disk = svntest.main.greek_state.copy()
+  expected_disk.add({
+    'A/D/H/zeta'   : Item("This is the file zeta.\n"),
+    'A/C/X'        : Item(),
+    'A/C/X/file'   : Item("This is a file.\n"),
+    })
+  svntest.actions.verify_disk(wc_dir, expected_disk)
+
+  # Nothing is left to revert.
+  svntest.actions.run_and_verify_svn([], [], 'revert', '-R', wc_dir)
+
 
 ########################################################################
 # Run the tests
@@ -1680,6 +1756,7 @@ test_list = [ None,
               revert_nonexistent,
               revert_obstructing_wc,
               revert_moved_dir_partial,
+              revert_tree_mixed_states,
              ]
 
 if __name__ == '__main__':
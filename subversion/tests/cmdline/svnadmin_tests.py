@@ -2817,6 +2817,31 @@ def verify_metadata_only(sbox):
       'STDOUT', [], output)
 
 
+@Skip(svntest.main.is_fs_type_bdb)
+def verify_parallel(sbox):
+  "verify with multiple jobs"
+
+  # Use small shards such that we get multiple verification jobs.
+  sbox.build(create_wc=False)
+  patch_format(sbox.repo_dir, shard_size=2)
+
+  for i in range(2, 8):
+    svntest.actions.run_and_verify_svnmucc(None, [],
+                                           '-U', sbox.repo_url,
+                                           '-m', 'r%d' % i,
+                                           'mkdir', 'dir%d' % i)
+
+  exit_code, expected_output, errput = svntest.main.run_svnadmin(
+                                                  "verify", sbox.repo_dir)
+  if errput:
+    raise SVNUnexpectedStderr(errput)
+
+  # The output must be the same, no matter how many jobs we use.
+  svntest.actions.run_and_verify_svnadmin(expected_output, [],
+                                          "verify", "--jobs", "3",
+                                          sbox.repo_dir)
+
+
 @Skip(svntest.main.is_fs_type_bdb)
 def verify_quickly(sbox):
   "verify quickly using metadata"
@@ -3436,6 +3461,50 @@ def load_from_file(sbox):
                                      'update', sbox.wc_dir)
   svntest.actions.verify_disk(sbox.wc_dir, expected_tree, check_props=True)
 
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+@SkipUnless(svntest.main.fs_has_pack)
+def hotcopy_parallel(sbox):
+  "'svnadmin hotcopy --jobs'"
+
+  # Use small shards such that several shards get copied at once.
+  sbox.build(create_wc=False)
+  patch_format(sbox.repo_dir, shard_size=2)
+
+  def commit_revs(revs):
+    for i in revs:
+      svntest.actions.run_and_verify_svnmucc(None, [],
+                                             '-U', sbox.repo_url,
+                                             '-m', 'r%d' % i,
+                                             'mkdir', 'dir%d' % i)
+
+  # Packed shards, a full and a partial non-packed one.
+  commit_revs(range(2, 8))
+  svntest.actions.run_and_verify_svnadmin(None, [], "pack", sbox.repo_dir)
+  commit_revs(range(8, 11))
+
+  backup_dir, backup_url = sbox.add_repo_path('backup')
+  parallel_dir, parallel_url = sbox.add_repo_path('parallel')
+
+  # The progress output must be the same, no matter how many jobs we use.
+  exit_code, expected_output, errput = svntest.main.run_svnadmin(
+                                         "hotcopy", sbox.repo_dir, backup_dir)
+  if errput:
+    raise SVNUnexpectedStderr(errput)
+
+  svntest.actions.run_and_verify_svnadmin(expected_output, [],
+                                          "hotcopy", "--jobs", "3",
+                                          sbox.repo_dir, parallel_dir)
+  check_hotcopy_fsfs(sbox.repo_dir, parallel_dir)
+
+  # Let a non-packed shard of the destination become packed.
+  commit_revs(range(11, 13))
+  svntest.actions.run_and_verify_svnadmin(None, [], "pack", sbox.repo_dir)
+  svntest.actions.run_and_verify_svnadmin(None, [],
+                                          "hotcopy", "--incremental",
+                                          "--jobs", "3",
+                                          sbox.repo_dir, parallel_dir)
+  check_hotcopy_fsfs(sbox.repo_dir, parallel_dir)
+
 ########################################################################
 # Run the tests
 
@@ -3484,6 +3553,7 @@ test_list = [ None,
               verify_packed,
               freeze_freeze,
               verify_metadata_only,
+              verify_parallel,
               verify_quickly,
               fsfs_hotcopy_progress,
               fsfs_hotcopy_progress_with_revprop_changes,
@@ -3500,7 +3570,8 @@ test_list = [ None,
               dump_no_op_prop_change,
               load_no_flush_to_disk,
               dump_to_file,
-              load_from_file
+              load_from_file,
+              hotcopy_parallel,
              ]
 
 if __name__ == '__main__':
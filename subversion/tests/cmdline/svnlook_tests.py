@@ -718,6 +718,53 @@ def property_delete(sbox):
   svntest.actions.run_and_verify_svnlook(["_U  A/mu\n"], [],
                                          'changed', repo_dir)
 
+def batch_mode(sbox):
+  "svnlook batch"
+
+  sbox.build()
+  repo_dir = sbox.repo_dir
+
+  sbox.simple_append('A/mu', 'appended mu text\n')
+  sbox.simple_commit()
+
+  exit_code, output, errput = svntest.main.run_command_stdin(
+    svntest.main.svnlook_binary, 1, -1, False,
+    ['youngest\n',
+     '\n',
+     'bogus\n',
+     'cat -r 1 A/mu\n',
+     'changed -t no-such-txn\n',
+     'changed\n'],
+    'batch', repo_dir)
+
+  expected_output = [ '2\n', '%END 0\n',
+                      '%END 1\n',
+                      "This is the file 'mu'.\n", '%END 0\n',
+                      '%END 1\n',
+                      'U   A/mu\n', '%END 0\n' ]
+  svntest.verify.compare_and_display_lines('wrong batch output', 'STDOUT',
+                                           expected_output, output)
+  if exit_code != 0 or len(errput) == 0:
+    raise svntest.Failure("Failed commands not reported on stderr")
+
+def diff_parallel(sbox):
+  "svnlook diff --jobs"
+
+  sbox.build()
+  repo_dir = sbox.repo_dir
+
+  sbox.simple_append('A/mu', 'appended mu text\n')
+  sbox.simple_append('iota', 'appended iota text\n')
+  sbox.simple_rm('A/D/G/rho')
+  sbox.simple_add_text('new file\n', 'A/new')
+  sbox.simple_propset('foo', 'bar', 'A/D/gamma')
+  sbox.simple_commit()
+
+  # The output must not depend on the number of threads.
+  expected_output = run_svnlook('diff', repo_dir)
+  svntest.actions.run_and_verify_svnlook(expected_output, [],
+                                         'diff', '--jobs', '4', repo_dir)
+
 
 ########################################################################
 # Run the tests
@@ -738,6 +785,8 @@ test_list = [ None,
               test_filesize,
               test_txn_flag,
               property_delete,
+              batch_mode,
+              diff_parallel,
              ]
 
 if __name__ == '__main__':
@@ -982,6 +982,44 @@ def load_non_deltas_with_props(sbox):
     actual = map(str.strip, out)
     svntest.verify.compare_and_display_lines(None, 'PROPS', expected, actual)
 
+#----------------------------------------------------------------------
+def parallel_dump(sbox):
+  "dump: using --jobs"
+  run_dump_test(sbox, "copy-and-modify.dump", extra_options=['--jobs', '3'])
+
+def parallel_range_dump(sbox):
+  "dump: subdirectory using --jobs and -rX:Y"
+  run_dump_test(sbox, "trunk-only.dump", subdir="/trunk",
+                expected_dumpfile_name="trunk-only-range.expected.dump",
+                extra_options=['--jobs', '2', '-r1:HEAD'])
+
+def checkpointed_dump(sbox):
+  "dump: resume using --checkpoint-dir"
+  sbox.build(read_only=True)
+  checkpoint_dir = sbox.get_tempname('checkpoints')
+
+  expected = svntest.actions.run_and_verify_svnrdump(
+                 None, svntest.verify.AnyOutput, [], 0,
+                 '-q', 'dump', sbox.repo_url)
+
+  # The first run stores the chunks, the second one reuses them.
+  for i in range(2):
+    actual = svntest.actions.run_and_verify_svnrdump(
+                 None, svntest.verify.AnyOutput, [], 0,
+                 '-q', '--checkpoint-dir', checkpoint_dir,
+                 'dump', sbox.repo_url)
+    svntest.verify.compare_dump_files(None, None, expected, actual)
+
+  if not os.path.exists(os.path.join(checkpoint_dir, 'r1-r1.dump')):
+    raise svntest.Failure("No checkpoint written for r1")
+
+  # A checkpoint directory of another repository must be rejected.
+  other_repo_dir, other_repo_url = sbox.add_repo_path('other')
+  svntest.main.create_repos(other_repo_dir)
+  svntest.actions.run_and_verify_svnrdump(
+      None, [], svntest.verify.AnyOutput, 1,
+      '-q', '--checkpoint-dir', checkpoint_dir, 'dump', other_repo_url)
+
 ########################################################################
 # Run the tests
 
@@ -1043,6 +1081,9 @@ test_list = [ None,
               load_non_deltas_replace_copy_with_props,
               dump_replace_with_copy,
               load_non_deltas_with_props,
+              parallel_dump,
+              parallel_range_dump,
+              checkpointed_dump,
              ]
 
 if __name__ == '__main__':
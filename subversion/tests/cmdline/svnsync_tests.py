@@ -587,6 +587,36 @@ def up_to_date_sync(sbox):
   svntest.actions.run_and_verify_svnsync([], [],
                                          "synchronize", dest_sbox.repo_url)
 
+def sync_with_lookahead(sbox):
+  "sync with --lookahead"
+
+  sbox.build()
+
+  # A few revisions with text changes, copies, deletions and props.
+  sbox.simple_append('A/mu', 'appended mu text\n')
+  sbox.simple_propset('p', 'v', 'A/B/lambda', 'A/D')
+  sbox.simple_commit()
+  sbox.simple_copy('A/D', 'A/D2')
+  sbox.simple_append('A/D2/gamma', 'changed gamma\n')
+  sbox.simple_commit()
+  sbox.simple_rm('A/B/E/alpha', 'A/C')
+  sbox.simple_add_text('new file\n', 'A/new')
+  sbox.simple_commit()
+  sbox.simple_append('A/new', 'more text\n')
+  sbox.simple_propdel('p', 'A/D')
+  sbox.simple_commit()
+
+  dest_sbox = sbox.clone_dependent()
+  dest_sbox.build(create_wc=False, empty=True)
+  svntest.actions.enable_revprop_changes(dest_sbox.repo_dir)
+  run_init(dest_sbox.repo_url, sbox.repo_url)
+  svntest.actions.run_and_verify_svnsync(AnyOutput, [],
+                                         "synchronize", dest_sbox.repo_url,
+                                         sbox.repo_url, "--lookahead", "2")
+
+  verify_mirror(dest_sbox,
+                svntest.actions.run_and_verify_dump(sbox.repo_dir))
+
 
 ########################################################################
 # Run the tests
@@ -625,6 +655,7 @@ test_list = [ None,
               fd_leak_sync_from_serf_to_local, # calls setrlimit
               mergeinfo_contains_r0,
               up_to_date_sync,
+              sync_with_lookahead,
              ]
 
 if __name__ == '__main__':
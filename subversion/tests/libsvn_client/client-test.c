@@ -38,6 +38,7 @@
 #include "private/svn_wc_private.h"
 #include "svn_props.h"
 #include "svn_hash.h"
+#include "svn_config.h"
 
 #include "../svn_test.h"
 #include "../svn_test_fs.h"
@@ -1408,6 +1409,169 @@ test_copy_pin_externals_select_subtree(const svn_test_opts_t *opts, apr_pool_t *
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_ra_session_cache(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  const char *repos_url;
+  svn_client_ctx_t *ctx;
+  svn_ra_session_t *session1, *session2, *session3;
+  const char *url;
+  apr_pool_t *subpool1 = svn_pool_create(pool);
+  apr_pool_t *subpool2 = svn_pool_create(pool);
+
+  SVN_ERR(create_greek_repos(&repos_url, "test-ra-session-cache", opts,
+                             pool));
+  SVN_ERR(svn_client_create_context(&ctx, pool));
+  SVN_ERR(svn_client_set_ra_session_cache(ctx, 2, apr_time_from_sec(60)));
+
+  /* Sessions in use are not being shared. */
+  SVN_ERR(svn_client_open_ra_session2(&session1, repos_url, NULL, ctx,
+                                      subpool1, pool));
+  SVN_ERR(svn_client_open_ra_session2(&session2, repos_url, NULL, ctx,
+                                      subpool2, pool));
+  SVN_TEST_ASSERT(session1 != session2);
+
+  /* Released sessions get reused and reparented. */
+  svn_pool_clear(subpool1);
+  url = svn_path_url_add_component2(repos_url, "A/B", pool);
+  SVN_ERR(svn_client_open_ra_session2(&session3, url, NULL, ctx,
+                                      subpool1, pool));
+  SVN_TEST_ASSERT(session3 == session1);
+  SVN_ERR(svn_ra_get_session_url(session3, &url, pool));
+  SVN_TEST_STRING_ASSERT(url,
+                         svn_path_url_add_component2(repos_url, "A/B",
+                                                     pool));
+
+  /* Disabling the cache closes idle sessions.  Sessions in use remain
+     valid until released. */
+  svn_pool_clear(subpool1);
+  SVN_ERR(svn_client_set_ra_session_cache(ctx, 0, 0));
+  SVN_ERR(svn_client_open_ra_session2(&session3, repos_url, NULL, ctx,
+                                      subpool1, pool));
+  SVN_ERR(svn_ra_get_session_url(session2, &url, pool));
+  SVN_TEST_STRING_ASSERT(url, repos_url);
+
+  svn_pool_destroy(subpool1);
+  svn_pool_destroy(subpool2);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_log_entry_receiver_t, appending the log message of
+   LOG_ENTRY to the array of const char * BATON. */
+static svn_error_t *
+log_message_receiver(void *baton,
+                     svn_log_entry_t *log_entry,
+                     apr_pool_t *pool)
+{
+  apr_array_header_t *messages = baton;
+  svn_string_t *message = NULL;
+
+  if (log_entry->revprops)
+    message = svn_hash_gets(log_entry->revprops, SVN_PROP_REVISION_LOG);
+  APR_ARRAY_PUSH(messages, const char *)
+    = apr_pstrdup(messages->pool, message ? message->data : "");
+
+  return SVN_NO_ERROR;
+}
+
+/* Run svn_client_log5() on URL from HEAD to 1 and return the log message
+   of its youngest revision in *MESSAGE. */
+static svn_error_t *
+get_youngest_log_message(const char **message,
+                         const char *url,
+                         svn_client_ctx_t *ctx,
+                         apr_pool_t *pool)
+{
+  apr_array_header_t *targets = apr_array_make(pool, 1, sizeof(url));
+  apr_array_header_t *ranges = apr_array_make(pool, 1, sizeof(void *));
+  apr_array_header_t *messages = apr_array_make(pool, 1, sizeof(url));
+  svn_opt_revision_range_t *range = apr_pcalloc(pool, sizeof(*range));
+  svn_opt_revision_t peg_rev;
+
+  peg_rev.kind = svn_opt_revision_head;
+  range->start.kind = svn_opt_revision_head;
+  range->end.kind = svn_opt_revision_number;
+  range->end.value.number = 1;
+  APR_ARRAY_PUSH(targets, const char *) = url;
+  APR_ARRAY_PUSH(ranges, svn_opt_revision_range_t *) = range;
+
+  SVN_ERR(svn_client_log5(targets, &peg_rev, ranges, 0, TRUE, FALSE, FALSE,
+                          NULL, log_message_receiver, messages, ctx, pool));
+  SVN_TEST_ASSERT(messages->nelts > 0);
+  *message = APR_ARRAY_IDX(messages, 0, const char *);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_log_cache(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  const char *repos_url;
+  const char *url;
+  const char *config_dir;
+  const char *uuid;
+  const char *message;
+  svn_repos_t *repos;
+  svn_config_t *cfg;
+  apr_hash_t *cfg_hash = apr_hash_make(pool);
+  svn_auth_baton_t *auth_baton;
+  svn_client_ctx_t *ctx;
+  svn_ra_session_t *session;
+  svn_node_kind_t kind;
+
+  SVN_ERR(create_greek_repos(&repos_url, "test-log-cache", opts, pool));
+  SVN_ERR(svn_repos_open3(&repos, svn_test_data_path("test-log-cache", pool),
+                          NULL, pool, pool));
+  SVN_ERR(svn_fs_change_rev_prop2(svn_repos_fs(repos), 1,
+                                  SVN_PROP_REVISION_LOG, NULL,
+                                  svn_string_create("first", pool), pool));
+  SVN_ERR(svn_fs_get_uuid(svn_repos_fs(repos), &uuid, pool));
+
+  config_dir = svn_test_data_path("test-log-cache-config", pool);
+  SVN_ERR(svn_io_remove_dir2(config_dir, TRUE, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(config_dir);
+
+  SVN_ERR(svn_config_create2(&cfg, FALSE, FALSE, pool));
+  svn_config_set_bool(cfg, SVN_CONFIG_SECTION_MISCELLANY,
+                      SVN_CONFIG_OPTION_LOG_CACHE, TRUE);
+  svn_hash_sets(cfg_hash, SVN_CONFIG_CATEGORY_CONFIG, cfg);
+  SVN_ERR(svn_client_create_context2(&ctx, cfg_hash, pool));
+  svn_auth_open(&auth_baton,
+                apr_array_make(pool, 0, sizeof(svn_auth_provider_object_t *)),
+                pool);
+  svn_auth_set_parameter(auth_baton, SVN_AUTH_PARAM_CONFIG_DIR, config_dir);
+  ctx->auth_baton = auth_baton;
+
+  /* The first request fills the cache. */
+  url = svn_path_url_add_component2(repos_url, "A/mu", pool);
+  SVN_ERR(get_youngest_log_message(&message, url, ctx, pool));
+  SVN_TEST_STRING_ASSERT(message, "first");
+  SVN_ERR(svn_io_check_path(svn_dirent_join_many(pool, config_dir,
+                                                 "log-cache", uuid, "0", "1",
+                                                 SVN_VA_NULL),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* Changes made behind our back go unnoticed... */
+  SVN_ERR(svn_fs_change_rev_prop2(svn_repos_fs(repos), 1,
+                                  SVN_PROP_REVISION_LOG, NULL,
+                                  svn_string_create("second", pool), pool));
+  SVN_ERR(get_youngest_log_message(&message, url, ctx, pool));
+  SVN_TEST_STRING_ASSERT(message, "first");
+
+  /* ...until the revision gets invalidated. */
+  SVN_ERR(svn_client_open_ra_session2(&session, repos_url, NULL, ctx,
+                                      pool, pool));
+  SVN_ERR(svn_client__log_cache_invalidate(session, 1, ctx, pool));
+  SVN_ERR(get_youngest_log_message(&message, url, ctx, pool));
+  SVN_TEST_STRING_ASSERT(message, "second");
+
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -1436,6 +1600,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_client_copy7 with externals_to_pin"),
     SVN_TEST_OPTS_PASS(test_copy_pin_externals_select_subtree,
                        "pin externals on selected subtrees only"),
+    SVN_TEST_OPTS_PASS(test_ra_session_cache,
+                       "test reusing RA sessions across operations"),
+    SVN_TEST_OPTS_PASS(test_log_cache,
+                       "test the persistent client-side log cache"),
     SVN_TEST_NULL
   };
 
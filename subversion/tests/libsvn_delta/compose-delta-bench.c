@@ -0,0 +1,437 @@
+/* compose-delta-bench.c --- measure delta chain reconstruction speed
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <apr_general.h>
+#include <apr_getopt.h>
+#include <apr_time.h>
+
+#include "svn_cmdline.h"
+#include "svn_delta.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+
+#include "private/svn_cmdline_private.h"
+#include "private/svn_delta_private.h"
+
+#include "svn_private_config.h"
+
+/* Define a MIN macro if this platform doesn't already have one. */
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#define USAGE_MSG \
+  "Usage: %s [OPTIONS]\n" \
+  "\n" \
+  "Create chains of 10, 100, ... up to --max-chain revisions of a file,\n" \
+  "each revision being a small random edit of its predecessor, and\n" \
+  "deltify every revision against the previous one.  Then reconstruct\n" \
+  "the latest revision by composing all delta windows of the chain, the\n" \
+  "way the BDB backend does, and by applying the composite window to the\n" \
+  "first revision.  Windows are composed with a fresh composer per step\n" \
+  "as well as with a single one that gets reused along the chain.\n" \
+  "Results are written to stdout as tab separated values: mode, chain\n" \
+  "length, iterations, total microseconds, microseconds per delta,\n" \
+  "reconstructed megabytes per second.\n" \
+  "\n" \
+  "Options:\n" \
+  "  --max-chain ARG   length of the longest delta chain [1000]\n" \
+  "  --file-size ARG   size of the file in bytes, at most one delta\n" \
+  "                    window [65536]\n" \
+  "  --edits ARG       number of changes per revision [4]\n" \
+  "  --iterations ARG  repetitions of each reconstruction [3]\n"
+
+/* Command line option IDs. */
+enum
+{
+  opt_max_chain = 256,
+  opt_file_size,
+  opt_edits,
+  opt_iterations
+};
+
+static const apr_getopt_option_t options[] =
+{
+  {"max-chain",  opt_max_chain,  1, NULL},
+  {"file-size",  opt_file_size,  1, NULL},
+  {"edits",      opt_edits,      1, NULL},
+  {"iterations", opt_iterations, 1, NULL},
+  {0,            0,              0, 0}
+};
+
+/* Largest file that still gets deltified into a single window. */
+#define MAX_FILE_SIZE (100 * 1024)
+
+/* Number of bytes replaced or inserted by a single edit. */
+#define EDIT_SIZE 32
+
+/* Benchmark parameters. */
+typedef struct bench_opts_t
+{
+  int max_chain;
+  int file_size;
+  int edits;
+  int iterations;
+} bench_opts_t;
+
+/* Return the next pseudo-random number from *STATE (xorshift32). */
+static apr_uint32_t
+next_random(apr_uint32_t *state)
+{
+  apr_uint32_t x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+
+  return x;
+}
+
+/* Return SIZE bytes of text that depend on *STATE, allocated in POOL. */
+static svn_stringbuf_t *
+make_contents(int size,
+              apr_uint32_t *state,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *text = svn_stringbuf_create_ensure(size, pool);
+  int i;
+
+  for (i = 0; i < size; ++i)
+    svn_stringbuf_appendbyte(text,
+                             (i % 64 == 63)
+                               ? '\n'
+                               : (char)('a' + next_random(state) % 26));
+
+  return text;
+}
+
+/* Return a copy of TEXT with EDITS random changes, each of which either
+ * replaces, inserts or removes a few bytes.  The size of the result will
+ * not exceed MAX_SIZE.  Use *STATE as random number generator state and
+ * allocate the result in POOL. */
+static svn_stringbuf_t *
+edit_contents(const svn_stringbuf_t *text,
+              int edits,
+              apr_size_t max_size,
+              apr_uint32_t *state,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_dup(text, pool);
+  svn_stringbuf_t *chunk = make_contents(EDIT_SIZE, state, pool);
+  int i;
+
+  for (i = 0; i < edits; ++i)
+    {
+      apr_size_t pos = result->len
+                     ? next_random(state) % result->len
+                     : 0;
+      apr_size_t len = MIN(EDIT_SIZE, result->len - pos);
+
+      switch (next_random(state) % 3)
+        {
+          case 0:
+            svn_stringbuf_replace(result, pos, len, chunk->data, len);
+            break;
+
+          case 1:
+            if (result->len + EDIT_SIZE <= max_size)
+              svn_stringbuf_insert(result, pos, chunk->data, EDIT_SIZE);
+            break;
+
+          default:
+            svn_stringbuf_remove(result, pos, len);
+            break;
+        }
+    }
+
+  return result;
+}
+
+/* Set *WINDOW to the single delta window that transforms SOURCE into
+ * TARGET.  Allocate it in RESULT_POOL. */
+static svn_error_t *
+make_window(svn_txdelta_window_t **window,
+            svn_stringbuf_t *source,
+            svn_stringbuf_t *target,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  svn_txdelta_stream_t *stream;
+  svn_txdelta_window_t *next;
+
+  svn_txdelta2(&stream,
+               svn_stream_from_stringbuf(source, scratch_pool),
+               svn_stream_from_stringbuf(target, scratch_pool),
+               FALSE, scratch_pool);
+
+  SVN_ERR(svn_txdelta_next_window(window, stream, scratch_pool));
+  SVN_ERR(svn_txdelta_next_window(&next, stream, scratch_pool));
+  if (*window == NULL || next != NULL)
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "Expected exactly one delta window");
+
+  *window = svn_txdelta_window_dup(*window, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Reconstruct the last revision of a chain from BASE and the CHAIN_LENGTH
+ * windows in WINDOWS by composing them from the newest to the oldest, the
+ * way the BDB backend does.  Reuse a single composer if REUSE is set.
+ * Compare the result to EXPECTED.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+reconstruct(const svn_stringbuf_t *base,
+            svn_txdelta_window_t **windows,
+            int chain_length,
+            svn_boolean_t reuse,
+            const svn_stringbuf_t *expected,
+            apr_pool_t *scratch_pool)
+{
+  svn_txdelta__composer_t *composer
+    = svn_txdelta__composer_create(scratch_pool);
+  apr_pool_t *window_pool = svn_pool_create(scratch_pool);
+  svn_txdelta_window_t *composite = windows[chain_length - 1];
+  apr_size_t len;
+  char *buf;
+  int i;
+
+  for (i = chain_length - 2; i >= 0; --i)
+    {
+      apr_pool_t *composite_pool = svn_pool_create(scratch_pool);
+
+      if (reuse)
+        composite = svn_txdelta__compose_windows(composer, windows[i],
+                                                 composite, composite_pool);
+      else
+        composite = svn_txdelta_compose_windows(windows[i], composite,
+                                                composite_pool);
+
+      svn_pool_destroy(window_pool);
+      window_pool = composite_pool;
+    }
+
+  len = composite->tview_len;
+  buf = apr_palloc(window_pool, len + 1);
+  svn_txdelta_apply_instructions(composite, base->data, buf, &len);
+
+  if (len != expected->len || memcmp(buf, expected->data, len))
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "Reconstructed text does not match");
+
+  svn_pool_destroy(window_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Build a chain of CHAIN_LENGTH deltas as described in OPTS, reconstruct
+ * its latest revision OPTS->ITERATIONS times in both modes and print the
+ * results. */
+static svn_error_t *
+run_benchmark(int chain_length,
+              const bench_opts_t *opts,
+              apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_txdelta_window_t **windows
+    = apr_palloc(pool, chain_length * sizeof(*windows));
+  apr_uint32_t state = 1;
+  svn_stringbuf_t *base = make_contents(opts->file_size, &state, pool);
+  svn_stringbuf_t *text = base;
+  int reuse;
+  int i;
+
+  for (i = 0; i < chain_length; ++i)
+    {
+      svn_stringbuf_t *next;
+
+      svn_pool_clear(iterpool);
+      next = edit_contents(text, opts->edits, MAX_FILE_SIZE, &state, pool);
+      SVN_ERR(make_window(&windows[i], text, next, pool, iterpool));
+      text = next;
+    }
+
+  for (reuse = FALSE; reuse <= TRUE; ++reuse)
+    {
+      apr_time_t elapsed = 0;
+
+      for (i = 0; i < opts->iterations; ++i)
+        {
+          apr_time_t start;
+
+          svn_pool_clear(iterpool);
+
+          start = apr_time_now();
+          SVN_ERR(reconstruct(base, windows, chain_length, reuse, text,
+                              iterpool));
+          elapsed += apr_time_now() - start;
+        }
+
+      SVN_ERR(svn_cmdline_printf(pool,
+                                 "%s\t%d\t%d\t%" APR_INT64_T_FMT
+                                 "\t%.3f\t%.3f\n",
+                                 reuse ? "reused" : "per-call",
+                                 chain_length, opts->iterations,
+                                 (apr_int64_t)elapsed,
+                                 (double)elapsed / opts->iterations
+                                   / chain_length,
+                                 elapsed
+                                   ? (double)text->len * opts->iterations
+                                     / elapsed
+                                   : 0.0));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the int option argument ARG into *VALUE, which must be between
+ * MIN and MAX. */
+static svn_error_t *
+parse_int(int *value,
+          const char *arg,
+          int min,
+          int max)
+{
+  SVN_ERR(svn_cstring_atoi(value, arg));
+  if (*value < min || *value > max)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             "Argument '%s' must be between %d and %d",
+                             arg, min, max);
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the command line ARGC / ARGV into *OPTS.  Set *USAGE if the
+ * usage message should be printed instead. */
+static svn_error_t *
+parse_args(bench_opts_t *opts,
+           svn_boolean_t *usage,
+           int argc,
+           const char *argv[],
+           apr_pool_t *pool)
+{
+  apr_getopt_t *os;
+
+  opts->max_chain = 1000;
+  opts->file_size = 65536;
+  opts->edits = 4;
+  opts->iterations = 3;
+  *usage = FALSE;
+
+  SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
+  while (TRUE)
+    {
+      int opt_id;
+      const char *arg;
+      apr_status_t status = apr_getopt_long(os, options, &opt_id, &arg);
+
+      if (APR_STATUS_IS_EOF(status))
+        break;
+      if (status != APR_SUCCESS)
+        {
+          *usage = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      switch (opt_id)
+        {
+          case opt_max_chain:
+            SVN_ERR(parse_int(&opts->max_chain, arg, 2, 1000000));
+            break;
+          case opt_file_size:
+            SVN_ERR(parse_int(&opts->file_size, arg, 1, MAX_FILE_SIZE));
+            break;
+          case opt_edits:
+            SVN_ERR(parse_int(&opts->edits, arg, 1, 1000));
+            break;
+          case opt_iterations:
+            SVN_ERR(parse_int(&opts->iterations, arg, 1, 1000000));
+            break;
+        }
+    }
+
+  if (os->ind < argc)
+    *usage = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Run the benchmarks as requested on the command line. */
+static svn_error_t *
+sub_main(int *exit_code,
+         int argc,
+         const char *argv[],
+         apr_pool_t *pool)
+{
+  bench_opts_t opts = { 0 };
+  svn_boolean_t usage;
+  int chain_length;
+
+  SVN_ERR(parse_args(&opts, &usage, argc, argv, pool));
+  if (usage)
+    {
+      fprintf(stderr, USAGE_MSG, argv[0]);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_cmdline_printf(pool, "#mode\tchain\titerations\ttotal-usec"
+                                   "\tusec-per-delta\tmb-per-sec\n"));
+
+  for (chain_length = 10; chain_length < opts.max_chain; chain_length *= 10)
+    SVN_ERR(run_benchmark(chain_length, &opts, pool));
+  SVN_ERR(run_benchmark(opts.max_chain, &opts, pool));
+
+  return SVN_NO_ERROR;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  int exit_code = EXIT_SUCCESS;
+  svn_error_t *err;
+
+  if (svn_cmdline_init("compose-delta-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  err = sub_main(&exit_code, argc, argv, pool);
+  if (err)
+    {
+      exit_code = EXIT_FAILURE;
+      svn_cmdline_handle_exit_error(err, NULL, "compose-delta-bench: ");
+    }
+
+  svn_pool_destroy(pool);
+
+  return exit_code;
+}
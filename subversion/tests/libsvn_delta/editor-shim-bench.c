@@ -0,0 +1,471 @@
+/* editor-shim-bench.c --- compare edits through the Ev2 shims to plain ones
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <apr_general.h>
+#include <apr_getopt.h>
+#include <apr_time.h>
+
+#include "svn_cmdline.h"
+#include "svn_delta.h"
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+
+#include "private/svn_cmdline_private.h"
+#include "private/svn_delta_private.h"
+#include "private/svn_editor.h"
+#include "private/svn_string_private.h"
+
+#include "svn_private_config.h"
+
+
+#define USAGE_MSG \
+  "Usage: %s [OPTIONS]\n" \
+  "\n" \
+  "Drive the same edits into a no-op delta editor, once directly and\n" \
+  "once through the Ev1 -> Ev2 -> Ev1 editor shims, and measure the\n" \
+  "overhead of the shims.  The 'add' edit adds all directories and\n" \
+  "files, the 'modify' edit changes the text of every other file and a\n" \
+  "property of the remaining ones.  Results are written to stdout as tab\n" \
+  "separated values: path, edit, iterations, operations per iteration,\n" \
+  "total microseconds, microseconds per operation, delta base fetches\n" \
+  "per iteration.\n" \
+  "\n" \
+  "Options:\n" \
+  "  --dirs ARG        number of directories [100]\n" \
+  "  --files ARG       files per directory [100]\n" \
+  "  --file-size ARG   size of each file in bytes [4096]\n" \
+  "  --iterations ARG  repetitions of each edit [3]\n"
+
+/* Command line option IDs. */
+enum
+{
+  opt_dirs = 256,
+  opt_files,
+  opt_file_size,
+  opt_iterations
+};
+
+static const apr_getopt_option_t options[] =
+{
+  {"dirs",       opt_dirs,       1, NULL},
+  {"files",      opt_files,      1, NULL},
+  {"file-size",  opt_file_size,  1, NULL},
+  {"iterations", opt_iterations, 1, NULL},
+  {0,            0,              0, 0}
+};
+
+/* The shims need a repository root, but it is only used for copies. */
+#define BENCH_REPOS_ROOT "file:///editor-shim-bench"
+
+/* Tree shape and benchmark parameters. */
+typedef struct bench_opts_t
+{
+  int dirs;
+  int files;
+  int file_size;
+  int iterations;
+} bench_opts_t;
+
+/* Baton for the shim callbacks. */
+typedef struct fetch_baton_t
+{
+  /* Base text of all files. */
+  const svn_string_t *base_text;
+
+  /* Number of times that fetch_base() has been called. */
+  int base_fetches;
+} fetch_baton_t;
+
+/* Implements svn_delta_fetch_props_func_t.  All nodes are property-less. */
+static svn_error_t *
+fetch_props(apr_hash_t **props,
+            void *baton,
+            const char *path,
+            svn_revnum_t base_revision,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  *props = apr_hash_make(result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_delta_fetch_kind_func_t.  File names start with 'f'. */
+static svn_error_t *
+fetch_kind(svn_node_kind_t *kind,
+           void *baton,
+           const char *path,
+           svn_revnum_t base_revision,
+           apr_pool_t *scratch_pool)
+{
+  *kind = svn_relpath_basename(path, NULL)[0] == 'f' ? svn_node_file
+                                                     : svn_node_dir;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_delta_fetch_base_func_t.  Write the base text to a
+ * temporary file, just like a working copy or RA layer would need to. */
+static svn_error_t *
+fetch_base(const char **filename,
+           void *baton,
+           const char *path,
+           svn_revnum_t base_revision,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  fetch_baton_t *fb = baton;
+
+  ++fb->base_fetches;
+
+  return svn_error_trace(svn_io_write_unique(filename, NULL,
+                                             fb->base_text->data,
+                                             fb->base_text->len,
+                                             svn_io_file_del_on_pool_cleanup,
+                                             result_pool));
+}
+
+/* Return SIZE bytes of text that depend on SEED, allocated in POOL. */
+static svn_string_t *
+make_contents(int size,
+              apr_uint32_t seed,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *text = svn_stringbuf_create_ensure(size, pool);
+  apr_uint32_t x = seed | 1;
+  int i;
+
+  for (i = 0; i < size; ++i)
+    {
+      /* xorshift32 */
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+
+      svn_stringbuf_appendbyte(text, (i % 64 == 63) ? '\n'
+                                                    : (char)('a' + x % 26));
+    }
+
+  return svn_stringbuf__morph_into_string(text);
+}
+
+/* Wrap EDITOR / EDIT_BATON in the Ev1 -> Ev2 -> Ev1 shims, just like
+ * svn_editor__insert_shims() does with ENABLE_EV2_SHIMS.  Use FB as baton
+ * for the shim callbacks and allocate everything in POOL. */
+static svn_error_t *
+insert_shims(const svn_delta_editor_t **editor,
+             void **edit_baton,
+             fetch_baton_t *fb,
+             apr_pool_t *pool)
+{
+  svn_boolean_t *found_abs_paths = apr_palloc(pool,
+                                              sizeof(*found_abs_paths));
+  struct svn_delta__extra_baton *exb;
+  svn_delta__unlock_func_t unlock_func;
+  void *unlock_baton;
+  svn_editor_t *editor2;
+
+  SVN_ERR(svn_delta__editor_from_delta(&editor2, &exb,
+                                       &unlock_func, &unlock_baton,
+                                       *editor, *edit_baton,
+                                       found_abs_paths, BENCH_REPOS_ROOT, "",
+                                       NULL, NULL, fetch_kind, fb,
+                                       fetch_props, fb, pool, pool));
+
+  return svn_error_trace(svn_delta__delta_from_editor(editor, edit_baton,
+                                                      editor2,
+                                                      unlock_func,
+                                                      unlock_baton,
+                                                      found_abs_paths,
+                                                      BENCH_REPOS_ROOT, "",
+                                                      fetch_props, fb,
+                                                      fetch_base, fb,
+                                                      exb, pool));
+}
+
+/* Drive EDITOR / EDIT_BATON with an edit of the tree described in OPTS.
+ * In ADD mode, add all directories and files with TEXT as contents.
+ * Otherwise, open them and set TEXT as the new contents of every other
+ * file and as a property value on the remaining ones.  Return the number
+ * of files edited in *OPERATIONS. */
+static svn_error_t *
+drive_edit(int *operations,
+           const svn_delta_editor_t *editor,
+           void *edit_baton,
+           svn_boolean_t add,
+           const svn_string_t *text,
+           const bench_opts_t *opts,
+           apr_pool_t *pool)
+{
+  apr_pool_t *dir_pool = svn_pool_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  void *root_baton;
+  int i, k;
+
+  SVN_ERR(editor->open_root(edit_baton, add ? 0 : 1, pool, &root_baton));
+  for (i = 0; i < opts->dirs; ++i)
+    {
+      const char *dir_path;
+      void *dir_baton;
+
+      svn_pool_clear(dir_pool);
+      dir_path = apr_psprintf(dir_pool, "d%d", i);
+      if (add)
+        SVN_ERR(editor->add_directory(dir_path, root_baton, NULL,
+                                      SVN_INVALID_REVNUM, dir_pool,
+                                      &dir_baton));
+      else
+        SVN_ERR(editor->open_directory(dir_path, root_baton, 1, dir_pool,
+                                       &dir_baton));
+
+      for (k = 0; k < opts->files; ++k)
+        {
+          const char *file_path;
+          void *file_baton;
+
+          svn_pool_clear(iterpool);
+          file_path = svn_relpath_join(dir_path,
+                                       apr_psprintf(iterpool, "f%d", k),
+                                       iterpool);
+          if (add)
+            SVN_ERR(editor->add_file(file_path, dir_baton, NULL,
+                                     SVN_INVALID_REVNUM, iterpool,
+                                     &file_baton));
+          else
+            SVN_ERR(editor->open_file(file_path, dir_baton, 1, iterpool,
+                                      &file_baton));
+
+          if (add || k % 2 == 0)
+            {
+              svn_txdelta_window_handler_t handler;
+              void *handler_baton;
+
+              SVN_ERR(editor->apply_textdelta(file_baton, NULL, iterpool,
+                                              &handler, &handler_baton));
+              SVN_ERR(svn_txdelta_send_string(text, handler, handler_baton,
+                                              iterpool));
+            }
+          else
+            {
+              SVN_ERR(editor->change_file_prop(file_baton, "bench:prop",
+                                               text, iterpool));
+            }
+
+          SVN_ERR(editor->close_file(file_baton, NULL, iterpool));
+        }
+
+      SVN_ERR(editor->close_directory(dir_baton, dir_pool));
+    }
+
+  SVN_ERR(editor->close_directory(root_baton, pool));
+  SVN_ERR(editor->close_edit(edit_baton, pool));
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(dir_pool);
+  *operations = opts->dirs * opts->files;
+
+  return SVN_NO_ERROR;
+}
+
+/* Run the ADD or modify edit OPTS->ITERATIONS times, through the shims
+ * if SHIMMED is set.  Print the results. */
+static svn_error_t *
+run_benchmark(svn_boolean_t shimmed,
+              svn_boolean_t add,
+              const bench_opts_t *opts,
+              apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  fetch_baton_t fb = { 0 };
+  const svn_string_t *text;
+  apr_time_t elapsed = 0;
+  int operations = 0;
+  int i;
+
+  fb.base_text = make_contents(opts->file_size, 1, pool);
+  text = make_contents(opts->file_size, 2, pool);
+
+  for (i = 0; i < opts->iterations; ++i)
+    {
+      const svn_delta_editor_t *editor;
+      void *edit_baton = NULL;
+      apr_time_t start;
+
+      svn_pool_clear(iterpool);
+
+      start = apr_time_now();
+      editor = svn_delta_default_editor(iterpool);
+      if (shimmed)
+        SVN_ERR(insert_shims(&editor, &edit_baton, &fb, iterpool));
+
+      SVN_ERR(drive_edit(&operations, editor, edit_baton, add, text, opts,
+                         iterpool));
+      elapsed += apr_time_now() - start;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_cmdline_printf(pool,
+                                            "%s\t%s\t%d\t%d\t%"
+                                            APR_INT64_T_FMT "\t%.3f\t%d\n",
+                                            shimmed ? "shimmed" : "native",
+                                            add ? "add" : "modify",
+                                            opts->iterations, operations,
+                                            (apr_int64_t)elapsed,
+                                            operations
+                                              ? (double)elapsed
+                                                / opts->iterations
+                                                / operations
+                                              : 0.0,
+                                            fb.base_fetches
+                                              / opts->iterations));
+}
+
+/* Parse the int option argument ARG into *VALUE, which must be at least
+ * MIN. */
+static svn_error_t *
+parse_int(int *value,
+          const char *arg,
+          int min)
+{
+  SVN_ERR(svn_cstring_atoi(value, arg));
+  if (*value < min)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             "Argument '%s' must be at least %d", arg, min);
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the command line ARGC / ARGV into *OPTS.  Set *USAGE if the
+ * usage message should be printed instead. */
+static svn_error_t *
+parse_args(bench_opts_t *opts,
+           svn_boolean_t *usage,
+           int argc,
+           const char *argv[],
+           apr_pool_t *pool)
+{
+  apr_getopt_t *os;
+
+  opts->dirs = 100;
+  opts->files = 100;
+  opts->file_size = 4096;
+  opts->iterations = 3;
+  *usage = FALSE;
+
+  SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
+  while (TRUE)
+    {
+      int opt_id;
+      const char *arg;
+      apr_status_t status = apr_getopt_long(os, options, &opt_id, &arg);
+
+      if (APR_STATUS_IS_EOF(status))
+        break;
+      if (status != APR_SUCCESS)
+        {
+          *usage = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      switch (opt_id)
+        {
+          case opt_dirs:
+            SVN_ERR(parse_int(&opts->dirs, arg, 0));
+            break;
+          case opt_files:
+            SVN_ERR(parse_int(&opts->files, arg, 0));
+            break;
+          case opt_file_size:
+            SVN_ERR(parse_int(&opts->file_size, arg, 0));
+            break;
+          case opt_iterations:
+            SVN_ERR(parse_int(&opts->iterations, arg, 1));
+            break;
+        }
+    }
+
+  if (os->ind < argc)
+    *usage = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Run the benchmarks as requested on the command line. */
+static svn_error_t *
+sub_main(int *exit_code,
+         int argc,
+         const char *argv[],
+         apr_pool_t *pool)
+{
+  bench_opts_t opts = { 0 };
+  svn_boolean_t usage;
+
+  SVN_ERR(parse_args(&opts, &usage, argc, argv, pool));
+  if (usage)
+    {
+      fprintf(stderr, USAGE_MSG, argv[0]);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_cmdline_printf(pool, "#path\tedit\titerations\toperations"
+                                   "\ttotal-usec\tusec-per-op"
+                                   "\tbase-fetches\n"));
+
+  SVN_ERR(run_benchmark(FALSE, TRUE, &opts, pool));
+  SVN_ERR(run_benchmark(TRUE, TRUE, &opts, pool));
+  SVN_ERR(run_benchmark(FALSE, FALSE, &opts, pool));
+  SVN_ERR(run_benchmark(TRUE, FALSE, &opts, pool));
+
+  return SVN_NO_ERROR;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  int exit_code = EXIT_SUCCESS;
+  svn_error_t *err;
+
+  if (svn_cmdline_init("editor-shim-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  err = sub_main(&exit_code, argc, argv, pool);
+  if (err)
+    {
+      exit_code = EXIT_FAILURE;
+      svn_cmdline_handle_exit_error(err, NULL, "editor-shim-bench: ");
+    }
+
+  svn_pool_destroy(pool);
+
+  return exit_code;
+}
@@ -37,6 +37,8 @@
 #include "svn_pools.h"
 #include "svn_error.h"
 
+#include "private/svn_delta_private.h"
+
 #include "../../libsvn_delta/delta.h"
 #include "delta-window-test.h"
 
@@ -605,6 +607,162 @@ random_txdelta_to_svndiff_stream_test(apr_pool_t *pool)
   return err;
 }
 
+/* (Note: *LAST_SEED is an output parameter.) */
+static svn_error_t *
+do_random_svndiff_window_test(apr_pool_t *pool,
+                              apr_uint32_t *last_seed)
+{
+  apr_uint32_t seed;
+  apr_uint32_t maxlen;
+  apr_size_t bytes_range;
+  int i;
+  int iterations;
+  int dump_files;
+  int print_windows;
+  const char *random_bytes;
+  apr_pool_t *iterpool;
+
+  /* Initialize parameters and print out the seed in case we dump core
+     or something. */
+  init_params(&seed, &maxlen, &iterations, &dump_files, &print_windows,
+              &random_bytes, &bytes_range, pool);
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < iterations; i++)
+    {
+      apr_uint32_t subseed_base;
+      apr_file_t *source;
+      apr_file_t *target;
+      svn_txdelta_stream_t *txstream;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      svn_txdelta_window_t *window;
+      svn_stringbuf_t *expected;
+      svn_stringbuf_t *actual;
+      int version = i % 3;
+      int level = i % 10;
+
+      svn_pool_clear(iterpool);
+      expected = svn_stringbuf_create_empty(iterpool);
+      actual = svn_stringbuf_create_empty(iterpool);
+
+      *last_seed = seed;
+      subseed_base = svn_test_rand(&seed);
+      source = generate_random_file(maxlen, subseed_base, &seed,
+                                    random_bytes, bytes_range,
+                                    dump_files, iterpool);
+      target = generate_random_file(maxlen, subseed_base, &seed,
+                                    random_bytes, bytes_range,
+                                    dump_files, iterpool);
+
+      svn_txdelta2(&txstream,
+                   svn_stream_from_aprfile2(source, TRUE, iterpool),
+                   svn_stream_from_aprfile2(target, TRUE, iterpool),
+                   FALSE, iterpool);
+      svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                              svn_stream_from_stringbuf(expected, iterpool),
+                              version, level, iterpool);
+
+      /* Encoding the windows one by one must give the same svndiff
+         data as the streamy encoder. */
+      svn_txdelta__append_svndiff_header(actual, version);
+      do
+        {
+          SVN_ERR(svn_txdelta_next_window(&window, txstream, iterpool));
+          SVN_ERR(handler(window, handler_baton));
+          if (window)
+            SVN_ERR(svn_txdelta__append_svndiff_window(actual, window,
+                                                       version, level,
+                                                       iterpool));
+        }
+      while (window);
+
+      SVN_TEST_ASSERT(svn_stringbuf_compare(expected, actual));
+
+      apr_file_close(source);
+      apr_file_close(target);
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_test_driver_t. */
+static svn_error_t *
+random_svndiff_window_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed;
+  svn_error_t *err = do_random_svndiff_window_test(pool, &seed);
+  if (err)
+    fprintf(stderr, "SEED: %lu\n", (unsigned long)seed);
+  return err;
+}
+
+/* Implements svn_test_driver_t.
+   Encode a delta spanning several windows with the threaded encoder and
+   compare the result with the single-threaded one. */
+static svn_error_t *
+parallel_svndiff_test(apr_pool_t *pool)
+{
+  apr_uint32_t seed = 0x12345;
+  svn_stringbuf_t *source = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *target;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int version;
+  apr_size_t i;
+
+  /* Somewhat compressible data, a few windows long.  The target is the
+     source with every 1000th byte modified. */
+  for (i = 0; i < 5 * SVN_DELTA_WINDOW_SIZE + 1234; ++i)
+    svn_stringbuf_appendbyte(source, (char)('a' + svn_test_rand(&seed) % 8));
+  target = svn_stringbuf_dup(source, pool);
+  for (i = 0; i < target->len; i += 1000)
+    target->data[i] = 'z';
+
+  for (version = 1; version <= 2; ++version)
+    {
+      svn_txdelta_stream_t *txstream;
+      svn_txdelta_window_handler_t handler, parallel_handler;
+      void *handler_baton, *parallel_baton;
+      svn_txdelta_window_t *window;
+      svn_stringbuf_t *expected;
+      svn_stringbuf_t *actual;
+
+      svn_pool_clear(iterpool);
+      expected = svn_stringbuf_create_empty(iterpool);
+      actual = svn_stringbuf_create_empty(iterpool);
+
+      svn_txdelta2(&txstream,
+                   svn_stream_from_stringbuf(source, iterpool),
+                   svn_stream_from_stringbuf(target, iterpool),
+                   FALSE, iterpool);
+      svn_txdelta_to_svndiff3(&handler, &handler_baton,
+                              svn_stream_from_stringbuf(expected, iterpool),
+                              version, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                              iterpool);
+      svn_txdelta__to_svndiff_parallel(&parallel_handler, &parallel_baton,
+                                       svn_stream_from_stringbuf(actual,
+                                                                 iterpool),
+                                       version,
+                                       SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                                       4, iterpool);
+
+      do
+        {
+          SVN_ERR(svn_txdelta_next_window(&window, txstream, iterpool));
+          SVN_ERR(handler(window, handler_baton));
+          SVN_ERR(parallel_handler(window, parallel_baton));
+        }
+      while (window);
+
+      SVN_TEST_ASSERT(svn_stringbuf_compare(expected, actual));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Change to 1 to enable the unit test for the delta combiner's range index: */
 #if 0
 #include "range-index-test.h"
@@ -629,6 +787,10 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_PASS2(random_range_index_test,
                    "random range index test"),
 #endif
+    SVN_TEST_PASS2(random_svndiff_window_test,
+                   "random single svndiff window encoding test"),
+    SVN_TEST_PASS2(parallel_svndiff_test,
+                   "multi-threaded svndiff encoding test"),
     SVN_TEST_NULL
   };
 
@@ -28,7 +28,9 @@
 #include "svn_types.h"
 #include "svn_error.h"
 #include "svn_delta.h"
+#include "svn_pools.h"
 
+#include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 
 static svn_error_t *
@@ -97,6 +99,166 @@ stream_window_test(apr_pool_t *pool)
 }
 
 
+/* Return a window of TLEN bytes consisting of PERIOD bytes of new data
+ * followed by a single, overlapping target copy repeating them.  Allocate
+ * the result in POOL. */
+static svn_txdelta_window_t *
+make_pattern_window(apr_size_t period,
+                    apr_size_t tlen,
+                    apr_pool_t *pool)
+{
+  svn_txdelta_window_t *window = apr_pcalloc(pool, sizeof(*window));
+  svn_txdelta_op_t *ops = apr_pcalloc(pool, 2 * sizeof(*ops));
+  svn_stringbuf_t *new_data = svn_stringbuf_create_empty(pool);
+  apr_size_t i;
+
+  for (i = 0; i < period; ++i)
+    svn_stringbuf_appendbyte(new_data, (char)('a' + i % 26 + i / 26));
+
+  ops[0].action_code = svn_txdelta_new;
+  ops[0].offset = 0;
+  ops[0].length = period;
+  ops[1].action_code = svn_txdelta_target;
+  ops[1].offset = 0;
+  ops[1].length = tlen - period;
+
+  window->tview_len = tlen;
+  window->num_ops = 2;
+  window->ops = ops;
+  window->new_data = svn_stringbuf__morph_into_string(new_data);
+
+  return window;
+}
+
+/* Return a window that reconstructs TLEN bytes from the SLEN bytes in SBUF
+ * and new data in short copies of 1 to 15 bytes, alternating between both
+ * sources.  Write the expected result to TBUF.  Allocate the window in
+ * POOL. */
+static svn_txdelta_window_t *
+make_small_copies_window(const char *sbuf,
+                         apr_size_t slen,
+                         char *tbuf,
+                         apr_size_t tlen,
+                         apr_pool_t *pool)
+{
+  svn_txdelta_window_t *window = apr_pcalloc(pool, sizeof(*window));
+  apr_array_header_t *ops = apr_array_make(pool, 16, sizeof(svn_txdelta_op_t));
+  svn_stringbuf_t *new_data = svn_stringbuf_create_empty(pool);
+  apr_size_t tpos = 0;
+  apr_size_t len = 1;
+
+  while (tpos < tlen)
+    {
+      svn_txdelta_op_t *op = apr_array_push(ops);
+      op->length = MIN(len, tlen - tpos);
+
+      if (ops->nelts % 2)
+        {
+          op->action_code = svn_txdelta_source;
+          op->offset = (tpos * 7) % (slen - op->length);
+          memcpy(tbuf + tpos, sbuf + op->offset, op->length);
+        }
+      else
+        {
+          apr_size_t i;
+
+          op->action_code = svn_txdelta_new;
+          op->offset = new_data->len;
+          for (i = 0; i < op->length; ++i)
+            svn_stringbuf_appendbyte(new_data, (char)('A' + (tpos + i) % 26));
+          memcpy(tbuf + tpos, new_data->data + op->offset, op->length);
+        }
+
+      tpos += op->length;
+      len = len % 15 + 1;
+    }
+
+  window->sview_len = slen;
+  window->tview_len = tlen;
+  window->num_ops = ops->nelts;
+  window->src_ops = (ops->nelts + 1) / 2;
+  window->ops = (svn_txdelta_op_t *)ops->elts;
+  window->new_data = svn_stringbuf__morph_into_string(new_data);
+
+  return window;
+}
+
+/* Apply WINDOW to SBUF and write the result to TBUF, COUNT times.
+ * If VERBOSE is set, print the throughput prefixed with NAME. */
+static void
+apply_window_repeatedly(svn_txdelta_window_t *window,
+                        const char *sbuf,
+                        char *tbuf,
+                        int count,
+                        svn_boolean_t verbose,
+                        const char *name)
+{
+  apr_time_t start = apr_time_now();
+  apr_time_t duration;
+  int i;
+
+  for (i = 0; i < count; ++i)
+    {
+      apr_size_t tlen = window->tview_len;
+      svn_txdelta_apply_instructions(window, sbuf, tbuf, &tlen);
+    }
+
+  /* Bytes per microsecond happen to be MB/s. */
+  duration = apr_time_now() - start;
+  if (verbose)
+    printf("%-20s %8.1f MB/s\n", name,
+           duration ? (double)window->tview_len * count / duration : 0.0);
+}
+
+static svn_error_t *
+apply_instructions_test(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  /* Cover RLE-style runs, tiny patterns and patterns longer than the
+     small copy threshold. */
+  static const apr_size_t periods[] = { 1, 2, 3, 7, 8, 9, 31, 64, 1000 };
+  enum { TLEN = 100000, REPEAT = 20 };
+
+  char *sbuf = apr_palloc(pool, TLEN);
+  char *tbuf = apr_palloc(pool, TLEN);
+  char *expected = apr_palloc(pool, TLEN);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_txdelta_window_t *window;
+  apr_size_t i, k;
+
+  for (k = 0; k < sizeof(periods) / sizeof(periods[0]); ++k)
+    {
+      const char *name;
+      svn_pool_clear(iterpool);
+
+      window = make_pattern_window(periods[k], TLEN, iterpool);
+      name = apr_psprintf(iterpool, "pattern %d:", (int)periods[k]);
+      apply_window_repeatedly(window, NULL, tbuf, REPEAT, opts->verbose,
+                              name);
+
+      for (i = 0; i < TLEN; ++i)
+        if (tbuf[i] != window->new_data->data[i % periods[k]])
+          return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                   "Pattern of length %d broken at "
+                                   "offset %d", (int)periods[k], (int)i);
+    }
+
+  for (i = 0; i < TLEN; ++i)
+    sbuf[i] = (char)(i * 13 + i / 256);
+
+  window = make_small_copies_window(sbuf, TLEN, expected, TLEN, pool);
+  apply_window_repeatedly(window, sbuf, tbuf, REPEAT, opts->verbose,
+                          "small copies:");
+  if (memcmp(tbuf, expected, TLEN))
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "Small copies produced wrong target data");
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /* The test table.  */
 
@@ -107,6 +269,8 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_PASS2(stream_window_test,
                    "txdelta stream and windows test"),
+    SVN_TEST_OPTS_PASS(apply_instructions_test,
+                       "apply patterns and small copies"),
     SVN_TEST_NULL
   };
 
@@ -2607,6 +2607,115 @@ test_identical_suffix(apr_pool_t *pool)
 #undef ORIGINAL_CONTENTS_PATTERN
 #undef INSERTED_LINE
 
+/* Many short lines with mixed eol styles, so that the identical prefix
+   and suffix are skipped in blocks holding several of them. */
+static svn_error_t *
+test_identical_prefix_suffix_eols(apr_pool_t *pool)
+{
+  svn_stringbuf_t *original = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *modified;
+  int i;
+
+  for (i = 0; i < 100; i++)
+    svn_stringbuf_appendcstr(original, "one\r\ntwo\nthree\r");
+  modified = svn_stringbuf_dup(original, pool);
+  svn_stringbuf_appendcstr(original, "changed\n");
+  svn_stringbuf_appendcstr(modified, "CHANGED\n");
+  for (i = 0; i < 100; i++)
+    {
+      svn_stringbuf_appendcstr(original, "one\r\ntwo\nthree\r");
+      svn_stringbuf_appendcstr(modified, "one\r\ntwo\nthree\r");
+    }
+
+  SVN_ERR(two_way_diff("prefix-suffix-eols-original",
+                       "prefix-suffix-eols-modified",
+                       original->data, modified->data,
+                       "--- prefix-suffix-eols-original" NL
+                       "+++ prefix-suffix-eols-modified" NL
+                       "@@ -298,7 +298,7 @@" NL
+                       " one\r\n"
+                       " two\n"
+                       " three\r"
+                       "-changed\n"
+                       "+CHANGED\n"
+                       " one\r\n"
+                       " two\n"
+                       " three\r",
+                       NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_histogram_diff(apr_pool_t *pool)
+{
+  svn_diff_file_options_t *diff_opts = svn_diff_file_options_create(pool);
+  apr_array_header_t *args = apr_array_make(pool, 1, sizeof(const char *));
+
+  APR_ARRAY_PUSH(args, const char *) = "--histogram";
+  SVN_ERR(svn_diff_file_options_parse(diff_opts, args, pool));
+  SVN_TEST_ASSERT(diff_opts->algorithm == svn_diff_algorithm_histogram);
+
+  SVN_ERR(two_way_diff("histogram-original", "histogram-modified",
+                       "1\n" "x\n" "2\n" "y\n" "3\n",
+                       "1\n" "X\n" "2\n" "Y\n" "3\n",
+                       "--- histogram-original" NL
+                       "+++ histogram-modified" NL
+                       "@@ -1,5 +1,5 @@" NL
+                       " 1\n"
+                       "-x\n"
+                       "+X\n"
+                       " 2\n"
+                       "-y\n"
+                       "+Y\n"
+                       " 3\n",
+                       diff_opts, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Files of 1MB and more are memory mapped by the file datasource. */
+static svn_error_t *
+test_large_files(apr_pool_t *pool)
+{
+  svn_stringbuf_t *original = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *modified = svn_stringbuf_create_empty(pool);
+  int i;
+
+  /* 150000 lines of 8 bytes, with changes near both ends such that
+     the lines in between are tokenized across many chunks. */
+  for (i = 1; i <= 150000; i++)
+    {
+      const char *line = apr_psprintf(pool, "%07d\n", i);
+
+      svn_stringbuf_appendcstr(original, line);
+      svn_stringbuf_appendcstr(modified,
+                               (i == 2 || i == 149999) ? "changed\n" : line);
+    }
+
+  SVN_ERR(two_way_diff("large-files-original", "large-files-modified",
+                       original->data, modified->data,
+                       "--- large-files-original" NL
+                       "+++ large-files-modified" NL
+                       "@@ -1,5 +1,5 @@" NL
+                       " 0000001\n"
+                       "-0000002\n"
+                       "+changed\n"
+                       " 0000003\n"
+                       " 0000004\n"
+                       " 0000005\n"
+                       "@@ -149996,5 +149996,5 @@" NL
+                       " 0149996\n"
+                       " 0149997\n"
+                       " 0149998\n"
+                       "-0149999\n"
+                       "+changed\n"
+                       " 0150000\n",
+                       NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* The magic number used in this test, 1<<17, is
    CHUNK_SIZE from ../../libsvn_diff/diff_file.c
  */
@@ -3103,6 +3212,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "identical suffix starts at the boundary of a chunk"),
     SVN_TEST_PASS2(test_token_compare,
                    "compare tokens at the chunk boundary"),
+    SVN_TEST_PASS2(test_identical_prefix_suffix_eols,
+                   "identical prefix and suffix with mixed eols"),
+    SVN_TEST_PASS2(test_histogram_diff,
+                   "2-way diff with the histogram algorithm"),
+    SVN_TEST_PASS2(test_large_files,
+                   "2-way diff of memory mapped files"),
     SVN_TEST_PASS2(two_way_issue_3362_v1,
                    "2-way issue #3362 test v1"),
     SVN_TEST_PASS2(two_way_issue_3362_v2,
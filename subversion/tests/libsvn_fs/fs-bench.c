@@ -0,0 +1,924 @@
+/* fs-bench.c --- microbenchmarks for the filesystem back-ends
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <apr_general.h>
+#include <apr_getopt.h>
+#include <apr_thread_proc.h>
+#include <apr_time.h>
+
+#include "svn_cmdline.h"
+#include "svn_dirent_uri.h"
+#include "svn_error.h"
+#include "svn_fs.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+
+#include "private/svn_cmdline_private.h"
+#include "private/svn_fspath.h"
+#include "private/svn_string_private.h"
+
+#include "svn_private_config.h"
+
+
+#define USAGE_MSG \
+  "Usage: %s [OPTIONS]\n" \
+  "\n" \
+  "Generate a repository for each of the given FS types and measure the\n" \
+  "performance of commits, file and directory reads, changed paths,\n" \
+  "node history and packing.  Results are written to stdout as tab\n" \
+  "separated values: FS type, cache mode, benchmark, iterations,\n" \
+  "operations per iteration, total microseconds, microseconds per\n" \
+  "operation.\n" \
+  "\n" \
+  "Options:\n" \
+  "  --fs-type ARG     comma-separated list of fsfs, fsx, bdb [fsfs]\n" \
+  "  --dirs ARG        sub-directories per directory [4]\n" \
+  "  --depth ARG       levels of sub-directories [3]\n" \
+  "  --files ARG       files per directory [8]\n" \
+  "  --file-size ARG   initial size of each file in bytes [4096]\n" \
+  "  --revisions ARG   number of revisions to create [100]\n" \
+  "  --changes ARG     files modified per revision [10]\n" \
+  "  --iterations ARG  repetitions of each read benchmark [3]\n" \
+  "  --threads ARG     concurrent readers in each read benchmark [1]\n" \
+  "  --cache ARG       cold, warm or both [both]\n" \
+  "  --fsfs-option ARG add SECTION:OPTION=VALUE to fsfs.conf; may be\n" \
+  "                    given several times\n" \
+  "  --repos-dir ARG   where to create the repositories [.]\n" \
+  "  --keep            don't delete the repositories afterwards\n"
+
+/* Command line option IDs. */
+enum
+{
+  opt_fs_type = 256,
+  opt_dirs,
+  opt_depth,
+  opt_files,
+  opt_file_size,
+  opt_revisions,
+  opt_changes,
+  opt_iterations,
+  opt_threads,
+  opt_cache,
+  opt_fsfs_option,
+  opt_repos_dir,
+  opt_keep
+};
+
+static const apr_getopt_option_t options[] =
+{
+  {"fs-type",    opt_fs_type,    1, NULL},
+  {"dirs",       opt_dirs,       1, NULL},
+  {"depth",      opt_depth,      1, NULL},
+  {"files",      opt_files,      1, NULL},
+  {"file-size",  opt_file_size,  1, NULL},
+  {"revisions",  opt_revisions,  1, NULL},
+  {"changes",    opt_changes,    1, NULL},
+  {"iterations", opt_iterations, 1, NULL},
+  {"threads",    opt_threads,    1, NULL},
+  {"cache",      opt_cache,      1, NULL},
+  {"fsfs-option", opt_fsfs_option, 1, NULL},
+  {"repos-dir",  opt_repos_dir,  1, NULL},
+  {"keep",       opt_keep,       0, NULL},
+  {0,            0,              0, 0}
+};
+
+/* Repository shape and benchmark parameters. */
+typedef struct bench_opts_t
+{
+  apr_array_header_t *fs_types;
+  int dirs;
+  int depth;
+  int files;
+  int file_size;
+  int revisions;
+  int changes;
+  int iterations;
+  int threads;
+  svn_boolean_t cold;
+  svn_boolean_t warm;
+  const char *repos_dir;
+  svn_boolean_t keep;
+
+  /* SECTION:OPTION=VALUE strings to add to fsfs.conf. */
+  apr_array_header_t *fsfs_options;
+} bench_opts_t;
+
+/* The generated repository. */
+typedef struct repos_t
+{
+  const char *fs_type;
+  const char *path;
+
+  /* All directories and files in HEAD, as absolute FS paths. */
+  apr_array_header_t *dirs;
+  apr_array_header_t *files;
+
+  svn_revnum_t youngest;
+} repos_t;
+
+/* Print one result line for BENCHMARK on REPOS in cache MODE.  OPERATIONS
+ * were executed in each of ITERATIONS runs, taking ELAPSED in total. */
+static svn_error_t *
+print_result(const repos_t *repos,
+             const char *mode,
+             const char *benchmark,
+             int iterations,
+             int operations,
+             apr_time_t elapsed,
+             apr_pool_t *pool)
+{
+  double per_op = iterations && operations
+                ? (double)elapsed / iterations / operations
+                : 0.0;
+
+  return svn_error_trace(svn_cmdline_printf(pool,
+                                            "%s\t%s\t%s\t%d\t%d\t%"
+                                            APR_INT64_T_FMT "\t%.3f\n",
+                                            repos->fs_type, mode, benchmark,
+                                            iterations, operations,
+                                            (apr_int64_t)elapsed, per_op));
+}
+
+/*** Repository generation. ***/
+
+/* Return SIZE bytes of text that depend on SEED, allocated in POOL. */
+static svn_string_t *
+make_contents(int size,
+              apr_uint32_t seed,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *text = svn_stringbuf_create_ensure(size, pool);
+  apr_uint32_t x = seed | 1;
+  int i;
+
+  for (i = 0; i < size; ++i)
+    {
+      /* xorshift32 */
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+
+      svn_stringbuf_appendbyte(text, (i % 64 == 63) ? '\n'
+                                                    : (char)('a' + x % 26));
+    }
+
+  return svn_stringbuf__morph_into_string(text);
+}
+
+/* Set the contents of file PATH in ROOT to CONTENTS. */
+static svn_error_t *
+set_contents(svn_fs_root_t *root,
+             const char *path,
+             const svn_string_t *contents,
+             apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+  apr_size_t len = contents->len;
+
+  SVN_ERR(svn_fs_apply_text(&stream, root, path, NULL, pool));
+  SVN_ERR(svn_stream_write(stream, contents->data, &len));
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Add LEVEL levels of directories and files below PATH in ROOT, as
+ * configured in OPTS.  Record the new nodes in REPOS. */
+static svn_error_t *
+add_tree(repos_t *repos,
+         svn_fs_root_t *root,
+         const char *path,
+         int level,
+         const bench_opts_t *opts,
+         apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_pool_t *result_pool = repos->files->pool;
+  int i;
+
+  for (i = 0; i < opts->files; ++i)
+    {
+      const char *file_path;
+
+      svn_pool_clear(iterpool);
+      file_path = svn_fspath__join(path, apr_psprintf(iterpool, "f%d.txt", i),
+                                   result_pool);
+
+      SVN_ERR(svn_fs_make_file(root, file_path, iterpool));
+      SVN_ERR(set_contents(root, file_path,
+                           make_contents(opts->file_size,
+                                         (apr_uint32_t)repos->files->nelts,
+                                         iterpool),
+                           iterpool));
+      APR_ARRAY_PUSH(repos->files, const char *) = file_path;
+    }
+
+  for (i = 0; level > 0 && i < opts->dirs; ++i)
+    {
+      const char *dir_path;
+
+      svn_pool_clear(iterpool);
+      dir_path = svn_fspath__join(path, apr_psprintf(iterpool, "d%d", i),
+                                  result_pool);
+
+      SVN_ERR(svn_fs_make_dir(root, dir_path, iterpool));
+      APR_ARRAY_PUSH(repos->dirs, const char *) = dir_path;
+
+      SVN_ERR(add_tree(repos, root, dir_path, level - 1, opts, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Commit TXN in FS and return the new revision in *NEW_REV. */
+static svn_error_t *
+commit_txn(svn_revnum_t *new_rev,
+           svn_fs_txn_t *txn,
+           apr_pool_t *pool)
+{
+  const char *conflict;
+
+  SVN_ERR(svn_fs_commit_txn(&conflict, new_rev, txn, pool));
+  if (!SVN_IS_VALID_REVNUM(*new_rev))
+    return svn_error_createf(SVN_ERR_FS_CONFLICT, NULL,
+                             "Commit conflict at '%s'", conflict);
+
+  return SVN_NO_ERROR;
+}
+
+/* Append OPTS->FSFS_OPTIONS to the fsfs.conf file of the FSFS at PATH. */
+static svn_error_t *
+add_fsfs_options(const char *path,
+                 const bench_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_stringbuf_t *text = svn_stringbuf_create_empty(pool);
+  apr_file_t *file;
+  int i;
+
+  for (i = 0; i < opts->fsfs_options->nelts; ++i)
+    {
+      const char *option = APR_ARRAY_IDX(opts->fsfs_options, i,
+                                         const char *);
+      const char *colon = strchr(option, ':');
+
+      /* Repeated sections are fine, the config parser merges them. */
+      svn_stringbuf_appendcstr(text,
+                               apr_psprintf(pool, "\n[%.*s]\n%s\n",
+                                            (int)(colon - option), option,
+                                            colon + 1));
+    }
+
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(path, "fsfs.conf", pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, text->data, text->len, NULL, pool));
+
+  return svn_error_trace(svn_io_file_close(file, pool));
+}
+
+/* Create a new repository of FS_TYPE in OPTS->REPOS_DIR, with the shape
+ * given by OPTS, and return it in *REPOS_P.  Report the commit timings.
+ * Allocate the result in RESULT_POOL. */
+static svn_error_t *
+create_repos(repos_t **repos_p,
+             const char *fs_type,
+             const bench_opts_t *opts,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  repos_t *repos = apr_pcalloc(result_pool, sizeof(*repos));
+  apr_hash_t *fs_config = apr_hash_make(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  apr_time_t start, elapsed = 0;
+  int next_file = 0;
+  int i;
+
+  repos->fs_type = fs_type;
+  repos->path = svn_dirent_join(opts->repos_dir,
+                                apr_pstrcat(scratch_pool, "fs-bench-",
+                                            fs_type, SVN_VA_NULL),
+                                result_pool);
+  repos->dirs = apr_array_make(result_pool, 16, sizeof(const char *));
+  repos->files = apr_array_make(result_pool, 16, sizeof(const char *));
+  APR_ARRAY_PUSH(repos->dirs, const char *) = "/";
+
+  SVN_ERR(svn_io_remove_dir2(repos->path, TRUE, NULL, NULL, scratch_pool));
+
+  /* Use small shards, so that there is something to pack. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FS_TYPE, fs_type);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE, "100");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_BDB_TXN_NOSYNC, "true");
+  SVN_ERR(svn_fs_create2(&fs, repos->path, fs_config, scratch_pool,
+                         scratch_pool));
+  if (strcmp(fs_type, "fsfs") == 0 && opts->fsfs_options->nelts)
+    SVN_ERR(add_fsfs_options(repos->path, opts, scratch_pool));
+
+  /* r1 contains the whole tree. */
+  start = apr_time_now();
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, 0, 0, iterpool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+  SVN_ERR(add_tree(repos, root, "/", opts->depth, opts, iterpool));
+  SVN_ERR(commit_txn(&repos->youngest, txn, iterpool));
+  SVN_ERR(print_result(repos, "-", "commit-tree", 1,
+                       repos->files->nelts + repos->dirs->nelts,
+                       apr_time_now() - start, iterpool));
+
+  /* Later revisions modify a few files each. */
+  for (i = 1; i < opts->revisions && repos->files->nelts; ++i)
+    {
+      int k;
+
+      svn_pool_clear(iterpool);
+
+      start = apr_time_now();
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, repos->youngest, 0, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      for (k = 0; k < opts->changes; ++k)
+        {
+          const char *path = APR_ARRAY_IDX(repos->files,
+                                           next_file++ % repos->files->nelts,
+                                           const char *);
+          SVN_ERR(set_contents(root, path,
+                               make_contents(opts->file_size + i,
+                                             (apr_uint32_t)(i * 65599 + k),
+                                             iterpool),
+                               iterpool));
+        }
+
+      SVN_ERR(commit_txn(&repos->youngest, txn, iterpool));
+      elapsed += apr_time_now() - start;
+    }
+
+  if (opts->revisions > 1)
+    SVN_ERR(print_result(repos, "-", "commit-change", opts->revisions - 1,
+                         opts->changes, elapsed, iterpool));
+
+  svn_pool_destroy(iterpool);
+  *repos_p = repos;
+
+  return SVN_NO_ERROR;
+}
+
+/*** The read benchmarks. ***/
+
+/* Read all files of REPOS in HEAD of FS.  Return the number of files
+ * read in *OPERATIONS. */
+static svn_error_t *
+bench_file_contents(int *operations,
+                    const repos_t *repos,
+                    svn_fs_t *fs,
+                    apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_fs_root_t *root;
+  int i;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, repos->youngest, pool));
+  for (i = 0; i < repos->files->nelts; ++i)
+    {
+      svn_stream_t *contents;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_file_contents(&contents, root,
+                                   APR_ARRAY_IDX(repos->files, i,
+                                                 const char *),
+                                   iterpool));
+      SVN_ERR(svn_stream_copy3(contents, svn_stream_empty(iterpool),
+                               NULL, NULL, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  *operations = repos->files->nelts;
+
+  return SVN_NO_ERROR;
+}
+
+/* List all directories of REPOS in HEAD of FS.  Return the number of
+ * directories listed in *OPERATIONS. */
+static svn_error_t *
+bench_dir_entries(int *operations,
+                  const repos_t *repos,
+                  svn_fs_t *fs,
+                  apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_fs_root_t *root;
+  int i;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, repos->youngest, pool));
+  for (i = 0; i < repos->dirs->nelts; ++i)
+    {
+      apr_hash_t *entries;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_dir_entries(&entries, root,
+                                 APR_ARRAY_IDX(repos->dirs, i, const char *),
+                                 iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  *operations = repos->dirs->nelts;
+
+  return SVN_NO_ERROR;
+}
+
+/* Iterate over the changed paths of all revisions in FS.  Return the
+ * number of revisions in *OPERATIONS. */
+static svn_error_t *
+bench_paths_changed(int *operations,
+                    const repos_t *repos,
+                    svn_fs_t *fs,
+                    apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t rev;
+
+  for (rev = 1; rev <= repos->youngest; ++rev)
+    {
+      svn_fs_root_t *root;
+      svn_fs_path_change_iterator_t *iterator;
+      svn_fs_path_change3_t *change;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_fs_paths_changed3(&iterator, root, iterpool, iterpool));
+      do
+        SVN_ERR(svn_fs_path_change_get(&change, iterator));
+      while (change);
+    }
+
+  svn_pool_destroy(iterpool);
+  *operations = (int)repos->youngest;
+
+  return SVN_NO_ERROR;
+}
+
+/* Walk the full history of the first few files of REPOS in HEAD of FS.
+ * Return the number of history entries in *OPERATIONS. */
+static svn_error_t *
+bench_node_history(int *operations,
+                   const repos_t *repos,
+                   svn_fs_t *fs,
+                   apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_fs_root_t *root;
+  int count = 0;
+  int i;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, repos->youngest, pool));
+  for (i = 0; i < repos->files->nelts && i < 16; ++i)
+    {
+      svn_fs_history_t *history;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_node_history2(&history, root,
+                                   APR_ARRAY_IDX(repos->files, i,
+                                                 const char *),
+                                   iterpool, iterpool));
+      SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, iterpool,
+                                   iterpool));
+      while (history)
+        {
+          ++count;
+          SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, iterpool,
+                                       iterpool));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  *operations = count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Signature of the read benchmarks above. */
+typedef svn_error_t *(*bench_func_t)(int *operations,
+                                     const repos_t *repos,
+                                     svn_fs_t *fs,
+                                     apr_pool_t *pool);
+
+/* Open the FS of REPOS.  Use the cache namespace NS, if not NULL. */
+static svn_error_t *
+open_fs(svn_fs_t **fs,
+        const repos_t *repos,
+        const char *ns,
+        apr_pool_t *pool)
+{
+  apr_hash_t *fs_config = apr_hash_make(pool);
+
+  if (ns)
+    svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS, ns);
+
+  return svn_error_trace(svn_fs_open2(fs, repos->path, fs_config, pool,
+                                      pool));
+}
+
+#if APR_HAS_THREADS
+
+/* One of several concurrent runs of a read benchmark. */
+typedef struct reader_t
+{
+  bench_func_t func;
+  const repos_t *repos;
+
+  /* FS object used by this reader only. */
+  svn_fs_t *fs;
+
+  /* Root pool for the benchmark function. */
+  apr_pool_t *pool;
+
+  /* Results. */
+  int operations;
+  svn_error_t *err;
+} reader_t;
+
+/* Thread function running the reader_t given in DATA. */
+static void * APR_THREAD_FUNC
+reader_thread(apr_thread_t *thread,
+              void *data)
+{
+  reader_t *reader = data;
+
+  reader->err = reader->func(&reader->operations, reader->repos, reader->fs,
+                             reader->pool);
+  return NULL;
+}
+
+#endif
+
+/* Run FUNC on REPOS concurrently for each of the THREADS FS objects in FS
+ * and return the total number of operations in *OPERATIONS. */
+static svn_error_t *
+run_readers(int *operations,
+            const repos_t *repos,
+            bench_func_t func,
+            svn_fs_t **fs,
+            int threads,
+            apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  reader_t *readers = apr_pcalloc(pool, threads * sizeof(*readers));
+  apr_thread_t **handles = apr_pcalloc(pool, threads * sizeof(*handles));
+  svn_error_t *err = SVN_NO_ERROR;
+  int started;
+  int i;
+
+  for (started = 0; started < threads; ++started)
+    {
+      apr_status_t status;
+      reader_t *reader = &readers[started];
+
+      reader->func = func;
+      reader->repos = repos;
+      reader->fs = fs[started];
+      reader->pool = svn_pool_create(NULL);
+
+      status = apr_thread_create(&handles[started], NULL, reader_thread,
+                                 reader, pool);
+      if (status)
+        {
+          svn_pool_destroy(reader->pool);
+          err = svn_error_wrap_apr(status, "Can't create reader thread");
+          break;
+        }
+    }
+
+  *operations = 0;
+  for (i = 0; i < started; ++i)
+    {
+      apr_status_t retval;
+
+      apr_thread_join(&retval, handles[i]);
+      svn_pool_destroy(readers[i].pool);
+
+      *operations += readers[i].operations;
+      err = svn_error_compose_create(err, readers[i].err);
+    }
+
+  return svn_error_trace(err);
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          "Concurrent readers require thread support");
+#endif
+}
+
+/* Run FUNC named NAME on REPOS for OPTS->ITERATIONS times, using
+ * OPTS->THREADS concurrent readers.  In COLD mode, open the FS with a new,
+ * empty cache namespace each time.  Otherwise, run FUNC once before the
+ * measurement to fill the caches. */
+static svn_error_t *
+run_benchmark(const repos_t *repos,
+              const char *name,
+              bench_func_t func,
+              svn_boolean_t cold,
+              const bench_opts_t *opts,
+              apr_pool_t *pool)
+{
+  static int namespace_counter = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_time_t elapsed = 0;
+  svn_fs_t **fs = apr_pcalloc(pool, opts->threads * sizeof(*fs));
+  apr_pool_t **fs_pools = apr_pcalloc(pool,
+                                      opts->threads * sizeof(*fs_pools));
+  int operations = 0;
+  int i, k;
+
+  /* Each FS object allocates in its own root pool, so concurrent readers
+     don't share an allocator. */
+  for (k = 0; k < opts->threads; ++k)
+    fs_pools[k] = svn_pool_create(NULL);
+
+  if (!cold)
+    {
+      /* The FS objects share the cache, so warming up one is enough. */
+      for (k = 0; k < opts->threads; ++k)
+        SVN_ERR(open_fs(&fs[k], repos, NULL, fs_pools[k]));
+      SVN_ERR(func(&operations, repos, fs[0], iterpool));
+    }
+
+  for (i = 0; i < opts->iterations; ++i)
+    {
+      apr_time_t start;
+
+      svn_pool_clear(iterpool);
+      if (cold)
+        {
+          /* Keys in a fresh namespace never hit the cache.  Opening the
+             FS is not part of the measurement. */
+          const char *ns = apr_psprintf(iterpool, "fs-bench-%d",
+                                        ++namespace_counter);
+
+          for (k = 0; k < opts->threads; ++k)
+            {
+              svn_pool_clear(fs_pools[k]);
+              SVN_ERR(open_fs(&fs[k], repos, apr_pstrdup(fs_pools[k], ns),
+                              fs_pools[k]));
+            }
+        }
+
+      start = apr_time_now();
+      if (opts->threads > 1)
+        SVN_ERR(run_readers(&operations, repos, func, fs, opts->threads,
+                            iterpool));
+      else
+        SVN_ERR(func(&operations, repos, fs[0], iterpool));
+      elapsed += apr_time_now() - start;
+    }
+
+  for (k = 0; k < opts->threads; ++k)
+    svn_pool_destroy(fs_pools[k]);
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(print_result(repos, cold ? "cold" : "warm", name,
+                                      opts->iterations, operations, elapsed,
+                                      pool));
+}
+
+/* Run all benchmarks for FS_TYPE as configured in OPTS. */
+static svn_error_t *
+run_all(const char *fs_type,
+        const bench_opts_t *opts,
+        apr_pool_t *pool)
+{
+  static const struct
+    {
+      const char *name;
+      bench_func_t func;
+    } benchmarks[] =
+    {
+      { "file-contents", bench_file_contents },
+      { "dir-entries",   bench_dir_entries },
+      { "paths-changed", bench_paths_changed },
+      { "node-history",  bench_node_history },
+      { NULL, NULL }
+    };
+  repos_t *repos;
+  apr_time_t start;
+  int i;
+
+  SVN_ERR(create_repos(&repos, fs_type, opts, pool, pool));
+
+  for (i = 0; benchmarks[i].name; ++i)
+    {
+      if (opts->cold)
+        SVN_ERR(run_benchmark(repos, benchmarks[i].name, benchmarks[i].func,
+                              TRUE, opts, pool));
+      if (opts->warm)
+        SVN_ERR(run_benchmark(repos, benchmarks[i].name, benchmarks[i].func,
+                              FALSE, opts, pool));
+    }
+
+  /* Packing is a no-op for BDB but we report it anyway. */
+  start = apr_time_now();
+  SVN_ERR(svn_fs_pack(repos->path, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(print_result(repos, "-", "pack", 1, 1, apr_time_now() - start,
+                       pool));
+
+  if (!opts->keep)
+    SVN_ERR(svn_fs_delete_fs(repos->path, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the int option argument ARG into *VALUE, which must be at least
+ * MIN. */
+static svn_error_t *
+parse_int(int *value,
+          const char *arg,
+          int min)
+{
+  SVN_ERR(svn_cstring_atoi(value, arg));
+  if (*value < min)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             "Argument '%s' must be at least %d", arg, min);
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the command line ARGC / ARGV into *OPTS.  Set *USAGE if the
+ * usage message should be printed instead. */
+static svn_error_t *
+parse_args(bench_opts_t *opts,
+           svn_boolean_t *usage,
+           int argc,
+           const char *argv[],
+           apr_pool_t *pool)
+{
+  apr_getopt_t *os;
+  const char *fs_types = "fsfs";
+
+  opts->dirs = 4;
+  opts->depth = 3;
+  opts->files = 8;
+  opts->file_size = 4096;
+  opts->revisions = 100;
+  opts->changes = 10;
+  opts->iterations = 3;
+  opts->threads = 1;
+  opts->cold = TRUE;
+  opts->warm = TRUE;
+  opts->repos_dir = ".";
+  opts->fsfs_options = apr_array_make(pool, 4, sizeof(const char *));
+  *usage = FALSE;
+
+  SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
+  while (TRUE)
+    {
+      int opt_id;
+      const char *arg;
+      apr_status_t status = apr_getopt_long(os, options, &opt_id, &arg);
+
+      if (APR_STATUS_IS_EOF(status))
+        break;
+      if (status != APR_SUCCESS)
+        {
+          *usage = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      switch (opt_id)
+        {
+          case opt_fs_type:
+            fs_types = arg;
+            break;
+          case opt_dirs:
+            SVN_ERR(parse_int(&opts->dirs, arg, 0));
+            break;
+          case opt_depth:
+            SVN_ERR(parse_int(&opts->depth, arg, 0));
+            break;
+          case opt_files:
+            SVN_ERR(parse_int(&opts->files, arg, 0));
+            break;
+          case opt_file_size:
+            SVN_ERR(parse_int(&opts->file_size, arg, 0));
+            break;
+          case opt_revisions:
+            SVN_ERR(parse_int(&opts->revisions, arg, 1));
+            break;
+          case opt_changes:
+            SVN_ERR(parse_int(&opts->changes, arg, 0));
+            break;
+          case opt_iterations:
+            SVN_ERR(parse_int(&opts->iterations, arg, 1));
+            break;
+          case opt_threads:
+            SVN_ERR(parse_int(&opts->threads, arg, 1));
+            break;
+          case opt_cache:
+            opts->cold = strcmp(arg, "warm") != 0;
+            opts->warm = strcmp(arg, "cold") != 0;
+            if (!opts->cold && !opts->warm)
+              return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                       "Invalid cache mode '%s'", arg);
+            break;
+          case opt_fsfs_option:
+            {
+              const char *colon = strchr(arg, ':');
+              if (!colon || colon == arg || !strchr(colon, '='))
+                return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                         "Invalid fsfs.conf option '%s'",
+                                         arg);
+              APR_ARRAY_PUSH(opts->fsfs_options, const char *)
+                = apr_pstrdup(pool, arg);
+            }
+            break;
+          case opt_repos_dir:
+            opts->repos_dir = svn_dirent_internal_style(arg, pool);
+            break;
+          case opt_keep:
+            opts->keep = TRUE;
+            break;
+        }
+    }
+
+  if (os->ind < argc)
+    *usage = TRUE;
+
+  opts->fs_types = svn_cstring_split(fs_types, ",", TRUE, pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Run the benchmarks as requested on the command line. */
+static svn_error_t *
+sub_main(int *exit_code,
+         int argc,
+         const char *argv[],
+         apr_pool_t *pool)
+{
+  bench_opts_t opts = { 0 };
+  svn_boolean_t usage;
+  int i;
+
+  SVN_ERR(parse_args(&opts, &usage, argc, argv, pool));
+  if (usage)
+    {
+      fprintf(stderr, USAGE_MSG, argv[0]);
+      *exit_code = EXIT_FAILURE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_initialize(pool));
+  SVN_ERR(svn_cmdline_printf(pool, "#fs-type\tcache\tbenchmark\titerations"
+                                   "\toperations\ttotal-usec\tusec-per-op\n"));
+
+  for (i = 0; i < opts.fs_types->nelts; ++i)
+    SVN_ERR(run_all(APR_ARRAY_IDX(opts.fs_types, i, const char *), &opts,
+                    pool));
+
+  return SVN_NO_ERROR;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  apr_pool_t *pool;
+  int exit_code = EXIT_SUCCESS;
+  svn_error_t *err;
+
+  if (svn_cmdline_init("fs-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  err = sub_main(&exit_code, argc, argv, pool);
+  if (err)
+    {
+      exit_code = EXIT_FAILURE;
+      svn_cmdline_handle_exit_error(err, NULL, "fs-bench: ");
+    }
+
+  svn_pool_destroy(pool);
+
+  return exit_code;
+}
@@ -6468,6 +6468,273 @@ test_zero_copy_processsing(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_try_get_file_range(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t rev;
+  const struct svn_test__tree_entry_t *node;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Start with a new repo and the greek tree in rev 1. */
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-try-get-file-range",
+                              opts, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, iterpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, iterpool));
+  SVN_ERR(test_commit_txn(&rev, txn, NULL, iterpool));
+  svn_pool_clear(iterpool);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+
+  /* Whenever the backend reports a file range, it must contain exactly
+   * the file contents. */
+  for (node = svn_test__greek_tree_nodes; node->path; node++)
+    if (node->contents)
+      {
+        apr_file_t *file;
+        apr_off_t offset;
+        svn_filesize_t length;
+        char *buffer;
+
+        svn_pool_clear(iterpool);
+
+        SVN_ERR(svn_fs__try_get_file_range(&file, &offset, &length, root,
+                                           node->path, iterpool, iterpool));
+        if (!file)
+          continue;
+
+        SVN_TEST_INT_ASSERT(length, strlen(node->contents));
+
+        buffer = apr_palloc(iterpool, (apr_size_t)length);
+        SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, iterpool));
+        SVN_ERR(svn_io_file_read_full2(file, buffer, (apr_size_t)length,
+                                       NULL, NULL, iterpool));
+        SVN_TEST_ASSERT(!memcmp(buffer, node->contents, (size_t)length));
+        SVN_ERR(svn_io_file_close(file, iterpool));
+      }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Assert that the delta range for SOURCE_ROOT/PATH -> TARGET_ROOT/PATH,
+   if FS reports any, turns SOURCE_CONTENTS into TARGET_CONTENTS. */
+static svn_error_t *
+check_file_delta_range(svn_fs_root_t *source_root,
+                       svn_fs_root_t *target_root,
+                       const char *path,
+                       const char *source_contents,
+                       const char *target_contents,
+                       apr_pool_t *pool)
+{
+  apr_file_t *file;
+  apr_off_t offset;
+  svn_filesize_t length;
+  char *buffer;
+  apr_size_t len;
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  svn_txdelta_window_handler_t handler;
+  void *baton;
+  svn_stream_t *parser;
+
+  SVN_ERR(svn_fs__try_get_file_delta_range(&file, &offset, &length,
+                                           source_root, path,
+                                           target_root, path, pool, pool));
+  if (!file)
+    return SVN_NO_ERROR;
+
+  buffer = apr_palloc(pool, (apr_size_t)length);
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+  SVN_ERR(svn_io_file_read_full2(file, buffer, (apr_size_t)length,
+                                 NULL, NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* The range must be a complete svndiff stream. */
+  svn_txdelta_apply(svn_stream_from_string(svn_string_create(source_contents,
+                                                             pool),
+                                           pool),
+                    svn_stream_from_stringbuf(result, pool),
+                    NULL, NULL, pool, &handler, &baton);
+  parser = svn_txdelta_parse_svndiff(handler, baton, TRUE, pool);
+  len = (apr_size_t)length;
+  SVN_ERR(svn_stream_write(parser, buffer, &len));
+  SVN_ERR(svn_stream_close(parser));
+
+  SVN_TEST_STRING_ASSERT(result->data, target_contents);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_try_get_file_delta_range(const svn_test_opts_t *opts,
+                              apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root1, *root2;
+  svn_revnum_t rev;
+  const char *contents1 = "This is the file 'iota'.\n";
+  const char *contents2 = "This is the file 'iota'.\nNow with a 2nd line.\n";
+
+  /* Start with a new repo and the greek tree in rev 1. */
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-try-get-file-delta-range",
+                              opts, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(test_commit_txn(&rev, txn, NULL, pool));
+  SVN_ERR(svn_fs_revision_root(&root1, fs, rev, pool));
+
+  /* Change iota in rev 2. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", contents2, pool));
+  SVN_ERR(test_commit_txn(&rev, txn, NULL, pool));
+  SVN_ERR(svn_fs_revision_root(&root2, fs, rev, pool));
+
+  /* Whatever range the backend reports must contain the right delta. */
+  SVN_ERR(check_file_delta_range(NULL, root1, "iota", "", contents1, pool));
+  SVN_ERR(check_file_delta_range(root1, root2, "iota", contents1, contents2,
+                                 pool));
+  SVN_ERR(check_file_delta_range(NULL, root2, "iota", "", contents2, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_prefetch_dir_entries(const svn_test_opts_t *opts,
+                          apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t rev;
+  apr_array_header_t *paths;
+  apr_hash_t *entries;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Start with a new repo and the greek tree in rev 1. */
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-prefetch-dir-entries",
+                              opts, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, iterpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, iterpool));
+  SVN_ERR(test_commit_txn(&rev, txn, NULL, iterpool));
+  svn_pool_clear(iterpool);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+
+  /* Files and missing paths must be ignored. */
+  paths = apr_array_make(pool, 6, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "/A/D/H";
+  APR_ARRAY_PUSH(paths, const char *) = "/iota";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/B";
+  APR_ARRAY_PUSH(paths, const char *) = "/no/such/dir";
+  APR_ARRAY_PUSH(paths, const char *) = "/iota/not-a-dir";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/D/G";
+  SVN_ERR(svn_fs__prefetch_dir_entries(root, paths, iterpool));
+
+  /* Prefetching must not change what we read afterwards. */
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "/A/D/H", iterpool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(entries), 3);
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "/A/B", iterpool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(entries), 3);
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "/A/D/G", iterpool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(entries), 3);
+
+  /* Doing it again is a no-op. */
+  SVN_ERR(svn_fs__prefetch_dir_entries(root, paths, iterpool));
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "/A/B", iterpool));
+  SVN_TEST_ASSERT(svn_hash_gets(entries, "lambda") != NULL);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_node_proplists(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t rev;
+  apr_array_header_t *paths;
+  apr_hash_t *proplists, *proplist;
+  svn_string_t *value;
+
+  /* Start with a new repo and the greek tree with some props in rev 1. */
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-node-proplists",
+                              opts, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "/iota", "p1",
+                                  svn_string_create("iota", pool), pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "/A/D", "p1",
+                                  svn_string_create("D", pool), pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "/A/D", "p2",
+                                  svn_string_create("D2", pool), pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "/A/mu", "p1",
+                                  svn_string_create("mu", pool), pool));
+  SVN_ERR(test_commit_txn(&rev, txn, NULL, pool));
+
+  paths = apr_array_make(pool, 4, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "/A/mu";
+  APR_ARRAY_PUSH(paths, const char *) = "/iota";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/B";
+  APR_ARRAY_PUSH(paths, const char *) = "/A/D";
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_node_proplists(&proplists, root, paths, pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(proplists), 4);
+
+  proplist = svn_hash_gets(proplists, "/A/mu");
+  SVN_TEST_INT_ASSERT(apr_hash_count(proplist), 1);
+  value = svn_hash_gets(proplist, "p1");
+  SVN_TEST_STRING_ASSERT(value->data, "mu");
+  proplist = svn_hash_gets(proplists, "/iota");
+  value = svn_hash_gets(proplist, "p1");
+  SVN_TEST_STRING_ASSERT(value->data, "iota");
+  proplist = svn_hash_gets(proplists, "/A/B");
+  SVN_TEST_INT_ASSERT(apr_hash_count(proplist), 0);
+  proplist = svn_hash_gets(proplists, "/A/D");
+  SVN_TEST_INT_ASSERT(apr_hash_count(proplist), 2);
+  value = svn_hash_gets(proplist, "p2");
+  SVN_TEST_STRING_ASSERT(value->data, "D2");
+
+  /* Mix committed and modified nodes in a transaction. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "/iota", "p1",
+                                  svn_string_create("changed", pool), pool));
+  SVN_ERR(svn_fs_node_proplists(&proplists, txn_root, paths, pool, pool));
+
+  proplist = svn_hash_gets(proplists, "/iota");
+  value = svn_hash_gets(proplist, "p1");
+  SVN_TEST_STRING_ASSERT(value->data, "changed");
+  proplist = svn_hash_gets(proplists, "/A/mu");
+  value = svn_hash_gets(proplist, "p1");
+  SVN_TEST_STRING_ASSERT(value->data, "mu");
+
+  /* Missing paths are an error. */
+  APR_ARRAY_PUSH(paths, const char *) = "/no/such/node";
+  SVN_TEST_ASSERT_ANY_ERROR(svn_fs_node_proplists(&proplists, root, paths,
+                                                  pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_dir_optimal_order(const svn_test_opts_t *opts,
                        apr_pool_t *pool)
@@ -7513,6 +7780,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test rep-sharing on content rather than SHA1"),
     SVN_TEST_OPTS_PASS(closest_copy_test_svn_4677,
                        "test issue SVN-4677 regression"),
+    SVN_TEST_OPTS_PASS(test_try_get_file_range,
+                       "test getting file contents as a file range"),
+    SVN_TEST_OPTS_PASS(test_try_get_file_delta_range,
+                       "test getting a stored delta as a file range"),
+    SVN_TEST_OPTS_PASS(test_prefetch_dir_entries,
+                       "test prefetching directory entries"),
+    SVN_TEST_OPTS_PASS(test_node_proplists,
+                       "test fetching many property lists at once"),
     SVN_TEST_NULL
   };
 
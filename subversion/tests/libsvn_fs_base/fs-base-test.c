@@ -1471,6 +1471,126 @@ orphaned_textmod_change(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Check that directory PATH in ROOT has exactly the entries named in the
+   comma-separated list EXPECTED. */
+static svn_error_t *
+check_dir_entries(svn_fs_root_t *root,
+                  const char *path,
+                  const char *expected,
+                  apr_pool_t *pool)
+{
+  apr_hash_t *entries;
+  apr_array_header_t *names = svn_cstring_split(expected, ",", TRUE, pool);
+  int i;
+
+  SVN_ERR(svn_fs_dir_entries(&entries, root, path, pool));
+  if (apr_hash_count(entries) != (unsigned int)names->nelts)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "'%s' has %u entries, expected '%s'",
+                             path, apr_hash_count(entries), expected);
+
+  for (i = 0; i < names->nelts; i++)
+    {
+      const char *name = APR_ARRAY_IDX(names, i, const char *);
+
+      if (! apr_hash_get(entries, name, APR_HASH_KEY_STRING))
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "'%s' has no entry '%s'", path, name);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Check that the contents of file PATH in ROOT are EXPECTED. */
+static svn_error_t *
+check_file_contents(svn_fs_root_t *root,
+                    const char *path,
+                    const char *expected,
+                    apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents;
+
+  SVN_ERR(svn_test__get_file_contents(root, path, &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, expected);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+txn_data_not_cached(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev;
+
+  SVN_ERR(svn_test__create_bdb_fs(&fs, "test-repo-txn-data-not-cached",
+                                  opts, pool));
+
+  /* r1: /A/f */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/f", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/f", "r1\n", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, pool));
+  SVN_TEST_INT_ASSERT(youngest_rev, 1);
+
+  /* Read the committed data, so it may get cached. */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, 1, pool));
+  SVN_ERR(check_dir_entries(rev_root, "A", "f", pool));
+  SVN_ERR(check_file_contents(rev_root, "A/f", "r1\n", pool));
+
+  /* Every change in a txn must show right away, no matter what we read
+     before. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(check_dir_entries(txn_root, "A", "f", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/g", pool));
+  SVN_ERR(check_dir_entries(txn_root, "A", "f,g", pool));
+  SVN_ERR(check_dir_entries(txn_root, "A", "f,g", pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/f", pool));
+  SVN_ERR(check_dir_entries(txn_root, "A", "g", pool));
+  SVN_ERR(check_dir_entries(txn_root, "A", "g", pool));
+
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/g", "txn 1\n", pool));
+  SVN_ERR(check_file_contents(txn_root, "A/g", "txn 1\n", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/g", "txn 2\n", pool));
+  SVN_ERR(check_file_contents(txn_root, "A/g", "txn 2\n", pool));
+
+  /* The committed revision is unaffected. */
+  SVN_ERR(check_dir_entries(rev_root, "A", "f", pool));
+  SVN_ERR(check_file_contents(rev_root, "A/f", "r1\n", pool));
+
+  /* r2: Commit the txn. */
+  SVN_ERR(svn_fs_commit_txn(NULL, &youngest_rev, txn, pool));
+  SVN_TEST_INT_ASSERT(youngest_rev, 2);
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, 2, pool));
+  SVN_ERR(check_dir_entries(rev_root, "A", "g", pool));
+  SVN_ERR(check_file_contents(rev_root, "A/g", "txn 2\n", pool));
+
+  /* Changes in an aborted txn leave no trace. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 2, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/h", pool));
+  SVN_ERR(check_dir_entries(txn_root, "A", "g,h", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/g", "aborted\n", pool));
+  SVN_ERR(check_file_contents(txn_root, "A/g", "aborted\n", pool));
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  SVN_ERR(check_dir_entries(rev_root, "A", "g", pool));
+  SVN_ERR(check_file_contents(rev_root, "A/g", "txn 2\n", pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 2, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(check_dir_entries(txn_root, "A", "g", pool));
+  SVN_ERR(check_file_contents(txn_root, "A/g", "txn 2\n", pool));
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 key_test(apr_pool_t *pool)
 {
@@ -1544,6 +1664,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "ensure no-op for redundant copies"),
     SVN_TEST_OPTS_PASS(orphaned_textmod_change,
                        "test for orphaned textmod changed paths"),
+    SVN_TEST_OPTS_PASS(txn_data_not_cached,
+                       "never serve stale txn data from the caches"),
     SVN_TEST_PASS2(key_test,
                    "testing sequential alphanumeric key generation"),
     SVN_TEST_NULL
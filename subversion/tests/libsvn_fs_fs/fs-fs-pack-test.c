@@ -23,20 +23,30 @@
 #include <stdlib.h>
 #include <string.h>
 #include <apr_pools.h>
+#include <apr_thread_proc.h>
 
 #include "../svn_test.h"
 #include "../../libsvn_fs/fs-loader.h"
+#include "../../libsvn_fs_fs/cached_data.h"
 #include "../../libsvn_fs_fs/fs.h"
 #include "../../libsvn_fs_fs/fs_fs.h"
+#include "../../libsvn_fs_fs/index.h"
+#include "../../libsvn_fs_fs/lock.h"
 #include "../../libsvn_fs_fs/low_level.h"
+#include "../../libsvn_fs_fs/mergeinfo-index.h"
 #include "../../libsvn_fs_fs/pack.h"
+#include "../../libsvn_fs_fs/rev_file.h"
 #include "../../libsvn_fs_fs/util.h"
 
 #include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_props.h"
 #include "svn_fs.h"
+#include "svn_time.h"
+#include "private/svn_fs_private.h"
+#include "private/svn_fs_util.h"
 #include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
 
 #include "../svn_test_fs.h"
 
@@ -416,6 +426,146 @@ read_packed_fs(const svn_test_opts_t *opts,
 #undef SHARD_SIZE
 #undef MAX_REV
 
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-read-packed-fs-mmap"
+#define SHARD_SIZE 5
+#define MAX_REV 11
+static svn_error_t *
+read_packed_fs_mmap(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  apr_hash_t *fs_config;
+  svn_revnum_t i;
+  svn_fs_fs__revision_file_t *rev_file;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE, pool));
+
+  /* Use a new FS instance with disjoint caches to make sure we actually
+   * read everything from the mapped pack files. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  ffd = fs->fsap_data;
+  ffd->mmap_packed_files = TRUE;
+
+  for (i = 1; i < (MAX_REV + 1); i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+      const char *expected;
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, pool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", pool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, pool));
+
+      expected = (i == 1) ? "This is the file 'iota'.\n"
+                          : get_rev_contents(i, pool);
+      SVN_TEST_STRING_ASSERT(rstring->data, expected);
+    }
+
+  /* The pack files have been mapped and the mapped image is what is on
+   * disk.  Non-packed revisions are read as usual. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, 1, pool, pool));
+  SVN_TEST_ASSERT(rev_file->is_packed);
+#if APR_HAS_MMAP
+  {
+    svn_stringbuf_t *pack_contents;
+    const char *data;
+
+    SVN_TEST_ASSERT(rev_file->mmap != NULL);
+    SVN_ERR(svn_stringbuf_from_file2(&pack_contents,
+                                     svn_fs_fs__path_rev_absolute(fs, 1,
+                                                                  pool),
+                                     pool));
+    SVN_TEST_INT_ASSERT(rev_file->mmap->size, pack_contents->len);
+    SVN_ERR(svn_fs_fs__rev_file_mmap_data(&data, rev_file, 0,
+                                          pack_contents->len));
+    SVN_TEST_ASSERT(memcmp(data, pack_contents->data,
+                           pack_contents->len) == 0);
+  }
+#endif
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, MAX_REV, pool,
+                                           pool));
+  SVN_TEST_ASSERT(! rev_file->is_packed);
+  SVN_TEST_ASSERT(rev_file->mmap == NULL);
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Mapping must not interfere with the remaining data access paths. */
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-read-delta-chain-prefetch"
+#define SHARD_SIZE 4
+#define MAX_REV 20
+static svn_error_t *
+read_delta_chain_prefetch(const svn_test_opts_t *opts,
+                          apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  apr_hash_t *fs_config;
+  svn_revnum_t i;
+  int pass;
+
+  /* Read-ahead hints have no observable effect other than timing, so
+   * this only checks that prefetching does not change what we read,
+   * with cold as well as with warm caches. */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Deltify 'iota' across several pack files and one non-packed shard. */
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  /* Use disjoint caches to make sure we actually read from disk. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  ffd = fs->fsap_data;
+  ffd->prefetch_delta_chains = TRUE;
+
+  for (pass = 0; pass < 2; pass++)
+    for (i = MAX_REV; i > 0; i--)
+      {
+        svn_fs_root_t *rev_root;
+        svn_stream_t *rstream;
+        svn_stringbuf_t *rstring;
+        const char *expected;
+
+        SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, pool));
+        SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", pool));
+        SVN_ERR(svn_test__stream_to_string(&rstring, rstream, pool));
+
+        expected = (i == 1) ? "This is the file 'iota'.\n"
+                            : get_rev_contents(i, pool);
+        SVN_TEST_STRING_ASSERT(rstring->data, expected);
+      }
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
 /* ------------------------------------------------------------------------ */
 #define REPO_NAME "test-repo-commit-packed-fs"
 #define SHARD_SIZE 5
@@ -1811,6 +1961,299 @@ pack_with_limited_memory(const svn_test_opts_t *opts,
 #undef MAX_REV
 #undef SHARD_SIZE
 
+/* ------------------------------------------------------------------------ */
+/* Batched l2p index lookups must return the same offsets as individual
+   ones, across pack file and non-packed rev file boundaries. */
+#define REPO_NAME "test-repo-item-offsets-batch"
+#define SHARD_SIZE 4
+#define MAX_REV 10
+static svn_error_t *
+item_offsets_batch(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  apr_hash_t *fs_config;
+  apr_array_header_t *max_ids;
+  apr_array_header_t *items;
+  apr_array_header_t *offsets;
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t rev;
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  /* Use a new FS instance with disjoint caches to make sure the batched
+   * lookup has to read the index pages itself. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  if (!svn_fs_fs__use_log_addressing(fs))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "requires log addressing");
+
+  /* All items in all revisions, in (revision, item) order. */
+  SVN_ERR(svn_fs_fs__l2p_get_max_ids(&max_ids, fs, 0, MAX_REV + 1, pool,
+                                     pool));
+  items = apr_array_make(pool, 0, sizeof(svn_fs_fs__id_part_t));
+  for (rev = 0; rev <= MAX_REV; ++rev)
+    {
+      apr_uint64_t k;
+      apr_uint64_t max_id = APR_ARRAY_IDX(max_ids, rev, apr_uint64_t);
+
+      for (k = 0; k < max_id; ++k)
+        {
+          svn_fs_fs__id_part_t *item = apr_array_push(items);
+          item->revision = rev;
+          item->number = k;
+        }
+    }
+
+  /* Start with a rev file that only covers the first shard. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, 0, pool, pool));
+  SVN_ERR(svn_fs_fs__item_offsets(&offsets, fs, rev_file, items, pool,
+                                  pool));
+  SVN_TEST_ASSERT(offsets->nelts == items->nelts);
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  for (i = 0; i < items->nelts; ++i)
+    {
+      const svn_fs_fs__id_part_t *item
+        = &APR_ARRAY_IDX(items, i, svn_fs_fs__id_part_t);
+      apr_off_t offset;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, item->revision,
+                                               iterpool, iterpool));
+      SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rev_file, item->revision,
+                                     NULL, item->number, iterpool));
+      SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+      SVN_TEST_ASSERT(offset == APR_ARRAY_IDX(offsets, i, apr_off_t));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+/* Sequential block access must trigger read-ahead, random access not. */
+#define REPO_NAME "test-repo-rev-file-read-ahead"
+#define SHARD_SIZE 4
+#define MAX_REV 7
+static svn_error_t *
+rev_file_read_ahead(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_off_t block_size;
+  apr_off_t end;
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, 0, pool, pool));
+
+  /* Use a fixed read-ahead distance, independent of fsfs.conf. */
+  rev_file->read_ahead_blocks = 8;
+  block_size = rev_file->block_size;
+
+  /* Scan forward a few blocks.  Read-ahead must start after the threshold
+   * and stay ahead of the current read position. */
+  for (i = 0; i < 16; ++i)
+    {
+      svn_fs_fs__rev_file_read_ahead(rev_file, i * block_size);
+      if (i >= 2)
+        SVN_TEST_ASSERT(rev_file->read_ahead_end > (i + 1) * block_size);
+      else
+        SVN_TEST_ASSERT(rev_file->read_ahead_end == 0);
+    }
+
+  /* Reading the same block again changes nothing. */
+  end = rev_file->read_ahead_end;
+  svn_fs_fs__rev_file_read_ahead(rev_file, 15 * block_size);
+  SVN_TEST_ASSERT(rev_file->read_ahead_end == end);
+
+  /* Jumping backwards and far forward is random access. */
+  svn_fs_fs__rev_file_read_ahead(rev_file, 0);
+  SVN_TEST_ASSERT(rev_file->read_ahead_end == 0);
+  svn_fs_fs__rev_file_read_ahead(rev_file, 100 * block_size);
+  SVN_TEST_ASSERT(rev_file->read_ahead_end == 0);
+
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+/* Packing several shards concurrently must produce a valid repository
+   and report the shards in order. */
+#define REPO_NAME "test-repo-pack-concurrently"
+#define SHARD_SIZE 4
+#define MAX_REV (5 * SHARD_SIZE + 1)
+static svn_error_t *
+pack_concurrently(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  struct pack_notify_baton pnb;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't support concurrent packing");
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  /* Use more jobs than there are shards and a tight memory budget. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+  ffd->pack_jobs = 8;
+
+  pnb.expected_shard = 0;
+  pnb.expected_action = svn_fs_pack_notify_start;
+  SVN_ERR(svn_fs_fs__pack(fs, 4000, pack_notify, &pnb, NULL, NULL, pool));
+  SVN_TEST_ASSERT(pnb.expected_shard == (MAX_REV + 1) / SHARD_SIZE);
+  SVN_TEST_ASSERT(pnb.expected_action == svn_fs_pack_notify_start);
+
+  /* All shards have been switched over. */
+  SVN_ERR(svn_fs_fs__read_min_unpacked_rev(&ffd->min_unpacked_rev, fs,
+                                           pool));
+  SVN_TEST_ASSERT(ffd->min_unpacked_rev
+                  == ((MAX_REV + 1) / SHARD_SIZE) * SHARD_SIZE);
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+/* Directories too large for the regular directory caches must behave just
+   like small ones, within a txn as well as after the commit. */
+#define REPO_NAME "test-repo-large-directory"
+#define ENTRY_COUNT 5000
+static svn_error_t *
+large_directory(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  const char *conflict;
+  svn_revnum_t rev;
+  apr_hash_t *entries;
+  svn_node_kind_t kind;
+  int i, expected_count = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Fill a directory and delete some of its entries in the same txn. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "big", pool));
+  for (i = 0; i < ENTRY_COUNT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_make_file(txn_root, apr_psprintf(iterpool, "big/f%d", i),
+                               iterpool));
+    }
+
+  for (i = 0; i < ENTRY_COUNT; i += 7)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_delete(txn_root, apr_psprintf(iterpool, "big/f%d", i),
+                            iterpool));
+    }
+
+  for (i = 0; i < ENTRY_COUNT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_check_path(&kind, txn_root,
+                                apr_psprintf(iterpool, "big/f%d", i),
+                                iterpool));
+      SVN_TEST_ASSERT(kind == (i % 7 ? svn_node_file : svn_node_none));
+      if (i % 7)
+        ++expected_count;
+    }
+
+  SVN_ERR(svn_fs_dir_entries(&entries, txn_root, "big", pool));
+  SVN_TEST_ASSERT(apr_hash_count(entries) == expected_count);
+
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  /* Look the entries up in the committed directory. */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  for (i = 0; i < ENTRY_COUNT; i += 3)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_check_path(&kind, rev_root,
+                                apr_psprintf(iterpool, "big/f%d", i),
+                                iterpool));
+      SVN_TEST_ASSERT(kind == (i % 7 ? svn_node_file : svn_node_none));
+    }
+
+  SVN_ERR(svn_fs_dir_entries(&entries, rev_root, "big", pool));
+  SVN_TEST_ASSERT(apr_hash_count(entries) == expected_count);
+
+  /* Modify the committed directory in a new txn. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_delete(txn_root, "big/f1", pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "big/f0", pool));
+
+  SVN_ERR(svn_fs_check_path(&kind, txn_root, "big/f0", pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+  SVN_ERR(svn_fs_check_path(&kind, txn_root, "big/f1", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_fs_check_path(&kind, txn_root, "big/f2", pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_dir_entries(&entries, rev_root, "big", pool));
+  SVN_TEST_ASSERT(apr_hash_count(entries) == expected_count);
+  SVN_ERR(svn_fs_check_path(&kind, rev_root, "big/f0", pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef ENTRY_COUNT
+
 /* ------------------------------------------------------------------------ */
 
 #define REPO_NAME "test-repo-large_delta_against_plain"
@@ -1889,7 +2332,1777 @@ large_delta_against_plain(const svn_test_opts_t *opts,
 
 
 
-/* The test table.  */
+/* ------------------------------------------------------------------------ */
+/* Concurrent commits from several threads of the same process with group
+   commit enabled must all succeed and produce consecutive revisions. */
+#define REPO_NAME "test-repo-group-commit"
+#define THREAD_COUNT 4
+#define COMMITS_PER_THREAD 8
+#if APR_HAS_THREADS
+
+/* Per-thread data of the group_commit test. */
+typedef struct group_commit_baton_t
+{
+  /* Thread number, used to make the changes of each thread unique. */
+  int thread_no;
+
+  /* Error returned by the thread, if any. */
+  svn_error_t *err;
+} group_commit_baton_t;
+
+/* Open the test repository with group commit enabled and commit
+   COMMITS_PER_THREAD new files to its "A" directory, each one based on
+   whatever HEAD is at the time.  Use POOL for allocations. */
+static svn_error_t *
+group_commit_worker(group_commit_baton_t *baton,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+  ffd->group_commit = TRUE;
+
+  for (i = 0; i < COMMITS_PER_THREAD; ++i)
+    {
+      svn_fs_txn_t *txn;
+      svn_fs_root_t *txn_root;
+      svn_revnum_t rev;
+      const char *conflict;
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "A/t%d-%d", baton->thread_no, i);
+
+      SVN_ERR(svn_fs_youngest_rev(&rev, fs, iterpool));
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_fs_make_file(txn_root, path, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, path, path, iterpool));
+      SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, iterpool));
+      SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread entry point for group_commit_worker.  DATA is the
+   group_commit_baton_t. */
+static void * APR_THREAD_FUNC
+group_commit_thread(apr_thread_t *thread,
+                    void *data)
+{
+  group_commit_baton_t *baton = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  baton->err = group_commit_worker(baton, pool);
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(thread, APR_SUCCESS);
+
+  return NULL;
+}
+
+#endif
+
+static svn_error_t *
+group_commit(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t rev;
+  const char *conflict;
+  apr_hash_t *entries;
+  apr_thread_t *threads[THREAD_COUNT];
+  group_commit_baton_t batons[THREAD_COUNT];
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't support group commit");
+
+  /* r1 provides the directory that all threads will add files to. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A", pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+
+  for (i = 0; i < THREAD_COUNT; ++i)
+    {
+      apr_status_t status;
+
+      batons[i].thread_no = i;
+      batons[i].err = SVN_NO_ERROR;
+
+      status = apr_thread_create(&threads[i], NULL, group_commit_thread,
+                                 &batons[i], pool);
+      if (status)
+        return svn_error_wrap_apr(status, "Can't create thread");
+    }
+
+  /* wait for the threads to finish */
+  for (i = 0; i < THREAD_COUNT; ++i)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, threads[i]);
+      if (status)
+        return svn_error_wrap_apr(status, "Can't join thread");
+
+      err = svn_error_compose_create(err, batons[i].err);
+    }
+
+  SVN_ERR(err);
+
+  /* Every commit created exactly one revision and none got lost. */
+  SVN_ERR(svn_fs_youngest_rev(&rev, fs, pool));
+  SVN_TEST_ASSERT(rev == 1 + THREAD_COUNT * COMMITS_PER_THREAD);
+
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_dir_entries(&entries, rev_root, "A", pool));
+  SVN_TEST_ASSERT(apr_hash_count(entries)
+                  == THREAD_COUNT * COMMITS_PER_THREAD);
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, rev, NULL, NULL, NULL, NULL,
+                        pool));
+#endif
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef THREAD_COUNT
+#undef COMMITS_PER_THREAD
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-sharded_rep_cache"
+#define SHARD_COUNT 16
+#define FILE_COUNT 32
+
+static svn_error_t *
+sharded_rep_cache(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_node_kind_t kind;
+  int i, count;
+  const char *conf_path;
+  const char *conf;
+  apr_file_t *file;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't support rep-cache shards");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Split the rep-cache and re-open the repository to pick that up. */
+  conf_path = svn_dirent_join(REPO_NAME, PATH_CONFIG, pool);
+  conf = apr_psprintf(pool, "\n[%s]\n%s = %d\n",
+                      CONFIG_SECTION_REP_SHARING,
+                      CONFIG_OPTION_REP_CACHE_SHARDS, SHARD_COUNT);
+  SVN_ERR(svn_io_file_open(&file, conf_path, APR_WRITE | APR_APPEND,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+  ffd->rep_sharing_allowed = TRUE;
+  SVN_TEST_ASSERT(ffd->rep_cache_shards == SHARD_COUNT);
+
+  /* Revision 1: add files with distinct contents. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  for (i = 0; i < FILE_COUNT; ++i)
+    {
+      const char *path;
+      const char *contents;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "f%d", i);
+      contents = apr_psprintf(iterpool, "Content %d.", i);
+      SVN_ERR(svn_fs_make_file(root, path, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, path,
+                                          multiply_string(contents,
+                                                          iterpool),
+                                          iterpool));
+    }
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Revision 2: add copies of that contents under new names.
+     All of them must be found in the rep-cache shards. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  for (i = 0; i < FILE_COUNT; ++i)
+    {
+      const char *path;
+      const char *contents;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "g%d", i);
+      contents = apr_psprintf(iterpool, "Content %d.", i);
+      SVN_ERR(svn_fs_make_file(root, path, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, path,
+                                          multiply_string(contents,
+                                                          iterpool),
+                                          iterpool));
+    }
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Only the root directory got a new representation. */
+  SVN_ERR(count_representations(&count, fs, rev, pool));
+  SVN_TEST_ASSERT(count == 1);
+
+  /* The rep-cache lives in the shard files only. */
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, "rep-cache.db",
+                                            pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  for (i = 0; i < SHARD_COUNT; ++i)
+    {
+      const char *name;
+
+      svn_pool_clear(iterpool);
+      name = apr_psprintf(iterpool, "rep-cache-%02x.db", i);
+      SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, name, iterpool),
+                                &kind, iterpool));
+      SVN_TEST_ASSERT(kind == svn_node_file);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Verification walks all shards. */
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, rev, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_COUNT
+#undef FILE_COUNT
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-rep_cache_filter"
+
+static svn_error_t *
+rep_cache_filter(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  int count;
+  const char *hello_str = multiply_string("Hello, ", pool);
+  const char *world_str = multiply_string("World!", pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't have a rep-cache filter");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  ffd->rep_sharing_allowed = TRUE;
+
+  /* Revision 1: populate the rep-cache without using the filter. */
+  ffd->rep_cache_filter = FALSE;
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "foo", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "foo", hello_str, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Revision 2: the filter gets built from the database contents and
+                 must not hide the existing entry. */
+  ffd->rep_cache_filter = TRUE;
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "bar", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "bar", hello_str, pool));
+  SVN_ERR(svn_fs_make_file(root, "baz", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "baz", world_str, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Only the root directory and "baz" got new representations. */
+  SVN_ERR(count_representations(&count, fs, rev, pool));
+  SVN_TEST_ASSERT(count == 2);
+
+  /* Revision 3: entries added after the filter had been built must be
+                 found as well. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "qux", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "qux", world_str, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(count_representations(&count, fs, rev, pool));
+  SVN_TEST_ASSERT(count == 1);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-changed_paths_index"
+
+/* Commit a new revision on top of *REV in FS that sets the contents of
+   file PATH to CONTENTS.  Update *REV to the new revision. */
+static svn_error_t *
+commit_file_change(svn_revnum_t *rev,
+                   svn_fs_t *fs,
+                   const char *path,
+                   const char *contents,
+                   apr_pool_t *pool)
+{
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, *rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, path, contents, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, rev, txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Assert that the changed-paths index in FS reports REVISION and
+   STRUCTURAL for PATH when asked for changes before BEFORE. */
+static svn_error_t *
+check_changed_paths_prev(svn_fs_t *fs,
+                         const char *path,
+                         svn_revnum_t before,
+                         svn_revnum_t revision,
+                         svn_boolean_t structural,
+                         apr_pool_t *pool)
+{
+  svn_revnum_t actual_revision;
+  svn_boolean_t actual_structural;
+
+  SVN_ERR(svn_fs__changed_paths_prev(&actual_revision, &actual_structural,
+                                     fs, path, before, pool));
+  SVN_TEST_INT_ASSERT(actual_revision, revision);
+  if (SVN_IS_VALID_REVNUM(revision))
+    SVN_TEST_ASSERT(actual_structural == structural);
+
+  return SVN_NO_ERROR;
+}
+
+/* Assert that the changed-paths index in FS covers the revisions after
+   AFTER up to UNTIL and reports REVISION as the first one to add, delete
+   or replace PATH or any of its parents. */
+static svn_error_t *
+check_changed_paths_next_structural(svn_fs_t *fs,
+                                    const char *path,
+                                    svn_revnum_t after,
+                                    svn_revnum_t until,
+                                    svn_revnum_t revision,
+                                    apr_pool_t *pool)
+{
+  svn_revnum_t actual_revision;
+  svn_boolean_t indexed;
+
+  SVN_ERR(svn_fs__changed_paths_next_structural(&actual_revision, &indexed,
+                                                fs, path, after, until,
+                                                pool));
+  SVN_TEST_ASSERT(indexed);
+  SVN_TEST_INT_ASSERT(actual_revision, revision);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+changed_paths_index(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root, *rev_root;
+  svn_revnum_t rev;
+  svn_boolean_t indexed;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't have a changed-paths index");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  ffd->changed_paths_index = TRUE;
+
+  /* r1: add /trunk with two files.  r2, r3: modify them. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "trunk", pool));
+  SVN_ERR(svn_fs_make_file(root, "trunk/a", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "trunk/a", "a1", pool));
+  SVN_ERR(svn_fs_make_file(root, "trunk/b", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "trunk/b", "b1", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(commit_file_change(&rev, fs, "trunk/a", "a2", pool));
+  SVN_ERR(commit_file_change(&rev, fs, "trunk/b", "b2", pool));
+
+  /* r4: branch /trunk.  r5, r6: modify the branch and /trunk. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "trunk", root, "branch", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(commit_file_change(&rev, fs, "branch/a", "a3", pool));
+  SVN_ERR(commit_file_change(&rev, fs, "trunk/a", "a4", pool));
+  SVN_TEST_INT_ASSERT(rev, 6);
+
+  /* Changes to the path itself. */
+  SVN_ERR(check_changed_paths_prev(fs, "/trunk/a", 7, 6, FALSE, pool));
+  SVN_ERR(check_changed_paths_prev(fs, "trunk/a", 6, 2, FALSE, pool));
+  SVN_ERR(check_changed_paths_prev(fs, "/trunk/a", 2, 1, TRUE, pool));
+  SVN_ERR(check_changed_paths_prev(fs, "/trunk/a", 1, SVN_INVALID_REVNUM,
+                                   FALSE, pool));
+
+  /* Changes below the path. */
+  SVN_ERR(check_changed_paths_prev(fs, "/trunk", 6, 3, FALSE, pool));
+  SVN_ERR(check_changed_paths_prev(fs, "/trunk", 3, 2, FALSE, pool));
+
+  /* Copies. */
+  SVN_ERR(check_changed_paths_prev(fs, "/branch/a", 7, 5, FALSE, pool));
+  SVN_ERR(check_changed_paths_prev(fs, "/branch/a", 5, SVN_INVALID_REVNUM,
+                                   FALSE, pool));
+  SVN_ERR(check_changed_paths_prev(fs, "/branch", 5, 4, TRUE, pool));
+  SVN_ERR(check_changed_paths_prev(fs, "/branch/b", 7, SVN_INVALID_REVNUM,
+                                   FALSE, pool));
+
+  /* Revisions outside the index and paths that it doesn't cover. */
+  SVN_ERR(check_changed_paths_prev(fs, "/trunk/a", 8, SVN_INVALID_REVNUM,
+                                   FALSE, pool));
+  SVN_ERR(check_changed_paths_prev(fs, "/", 7, SVN_INVALID_REVNUM,
+                                   FALSE, pool));
+
+  /* r7: delete /trunk. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_delete(root, "trunk", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Deletions of the path or its parents. */
+  SVN_ERR(check_changed_paths_next_structural(fs, "/trunk/a", 1, 7, 7,
+                                              pool));
+  SVN_ERR(check_changed_paths_next_structural(fs, "/trunk/a", 1, 6,
+                                              SVN_INVALID_REVNUM, pool));
+  SVN_ERR(check_changed_paths_next_structural(fs, "/branch/a", 4, 7,
+                                              SVN_INVALID_REVNUM, pool));
+  SVN_ERR(check_changed_paths_next_structural(fs, "/branch/a", 3, 7, 4,
+                                              pool));
+
+  /* Revisions outside the index. */
+  SVN_ERR(svn_fs__changed_paths_next_structural(&rev, &indexed, fs,
+                                                "/trunk/a", 1, 8, pool));
+  SVN_TEST_ASSERT(! indexed);
+
+  /* A disabled index must not be used. */
+  ffd->changed_paths_index = FALSE;
+  SVN_ERR(check_changed_paths_prev(fs, "/trunk/a", 7, SVN_INVALID_REVNUM,
+                                   FALSE, pool));
+  SVN_ERR(svn_fs__changed_paths_next_structural(&rev, &indexed, fs,
+                                                "/trunk/a", 1, 7, pool));
+  SVN_TEST_ASSERT(! indexed);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-mergeinfo_index"
+
+/* Assert that the mergeinfo index in FS lists exactly the
+   comma-separated EXPECTED paths below PATH in REVISION.  If EXPECTED
+   is NULL, assert that the index does not cover REVISION. */
+static svn_error_t *
+check_mergeinfo_paths(svn_fs_t *fs,
+                      svn_revnum_t revision,
+                      const char *path,
+                      const char *expected,
+                      apr_pool_t *pool)
+{
+  apr_array_header_t *paths;
+  apr_array_header_t *expected_paths;
+  int i;
+
+  SVN_ERR(svn_fs_fs__get_indexed_mergeinfo_paths(&paths, fs, revision, path,
+                                                 pool, pool));
+  if (expected == NULL)
+    {
+      SVN_TEST_ASSERT(paths == NULL);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_TEST_ASSERT(paths != NULL);
+  expected_paths = svn_cstring_split(expected, ",", TRUE, pool);
+  SVN_TEST_INT_ASSERT(paths->nelts, expected_paths->nelts);
+  for (i = 0; i < paths->nelts; i++)
+    SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(paths, i, const char *),
+                           APR_ARRAY_IDX(expected_paths, i, const char *));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_fs_mergeinfo_receiver_t, counting the paths in the
+   int * BATON. */
+static svn_error_t *
+count_mergeinfo_receiver(const char *path,
+                         svn_mergeinfo_t mergeinfo,
+                         void *baton,
+                         apr_pool_t *scratch_pool)
+{
+  int *count = baton;
+
+  ++*count;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+mergeinfo_index(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root, *rev_root;
+  svn_revnum_t rev;
+  apr_array_header_t *paths;
+  int count;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't have a mergeinfo index");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  ffd->mergeinfo_index = TRUE;
+
+  /* r1: add /trunk/sub with mergeinfo. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "trunk", pool));
+  SVN_ERR(svn_fs_make_dir(root, "trunk/sub", pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "trunk/sub", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/other:1", pool),
+                                  pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r2: branch /trunk, which copies the mergeinfo along. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "trunk", root, "branch", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r3: remove the mergeinfo from /trunk/sub. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "trunk/sub", SVN_PROP_MERGEINFO,
+                                  NULL, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r4: delete the branch. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_delete(root, "branch", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_INT_ASSERT(rev, 4);
+
+  SVN_ERR(check_mergeinfo_paths(fs, 0, "/", "", pool));
+  SVN_ERR(check_mergeinfo_paths(fs, 1, "/", "/trunk/sub", pool));
+  SVN_ERR(check_mergeinfo_paths(fs, 2, "/", "/branch/sub,/trunk/sub",
+                                pool));
+  SVN_ERR(check_mergeinfo_paths(fs, 2, "/trunk", "/trunk/sub", pool));
+  SVN_ERR(check_mergeinfo_paths(fs, 2, "trunk/sub", "", pool));
+  SVN_ERR(check_mergeinfo_paths(fs, 3, "/", "/branch/sub", pool));
+  SVN_ERR(check_mergeinfo_paths(fs, 4, "/", "", pool));
+
+  /* Revisions outside the index. */
+  SVN_ERR(check_mergeinfo_paths(fs, 5, "/", NULL, pool));
+
+  /* Descendant mergeinfo queries answered from the index. */
+  paths = apr_array_make(pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "/";
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, 2, pool));
+  count = 0;
+  SVN_ERR(svn_fs_get_mergeinfo3(rev_root, paths, svn_mergeinfo_inherited,
+                                TRUE, FALSE, count_mergeinfo_receiver,
+                                &count, pool));
+  SVN_TEST_INT_ASSERT(count, 2);
+
+  /* A disabled index must not be used. */
+  ffd->mergeinfo_index = FALSE;
+  SVN_ERR(check_mergeinfo_paths(fs, 2, "/", NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-delta_base_policy"
+#define MAX_LINEAR 4
+#define REVISION_COUNT 40
+
+static svn_error_t *
+delta_base_policy(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev = 0;
+  const char *conf_path;
+  const char *conf;
+  apr_file_t *file;
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't support delta-base-policy");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_DELTIFICATION_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Select the cost-based policy and re-open the repository. */
+  conf_path = svn_dirent_join(REPO_NAME, PATH_CONFIG, pool);
+  conf = apr_psprintf(pool, "\n[%s]\n%s = cost\n%s = %d\n",
+                      CONFIG_SECTION_DELTIFICATION,
+                      CONFIG_OPTION_DELTA_BASE_POLICY,
+                      CONFIG_OPTION_MAX_LINEAR_DELTIFICATION, MAX_LINEAR);
+  SVN_ERR(svn_io_file_open(&file, conf_path, APR_WRITE | APR_APPEND,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+  SVN_TEST_ASSERT(ffd->delta_base_policy == delta_base_policy_cost);
+
+  /* Grow a file by one line per revision.  Every representation must be
+     readable from at most MAX_LINEAR + 1 reps. */
+  for (i = 0; i < REVISION_COUNT; ++i)
+    {
+      const svn_fs_id_t *id;
+      node_revision_t *noderev;
+      svn_stringbuf_t *actual;
+      int chain_length;
+      int shard_count;
+
+      svn_pool_clear(iterpool);
+      svn_stringbuf_appendcstr(contents,
+                               apr_psprintf(iterpool,
+                                            "This is line %d of the file.\n",
+                                            i));
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (i == 0)
+        SVN_ERR(svn_fs_make_file(root, "f", iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "f", contents->data,
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_fs_node_id(&id, root, "f", iterpool));
+      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, iterpool,
+                                           iterpool));
+      SVN_ERR(svn_fs_fs__rep_chain_length(&chain_length, &shard_count,
+                                          noderev->data_rep, fs, iterpool));
+      SVN_TEST_ASSERT(chain_length <= MAX_LINEAR + 1);
+
+      SVN_ERR(svn_test__get_file_contents(root, "f", &actual, iterpool));
+      SVN_TEST_STRING_ASSERT(actual->data, contents->data);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, rev, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_LINEAR
+#undef REVISION_COUNT
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-revprop_generation"
+
+/* Set *GENERATION to the contents of the revprop generation file in FS. */
+static svn_error_t *
+read_generation(apr_int64_t *generation,
+                svn_fs_t *fs,
+                apr_pool_t *pool)
+{
+  svn_stringbuf_t *buf;
+  SVN_ERR(svn_stringbuf_from_file2(&buf,
+                                   svn_fs_fs__path_revprop_generation(fs,
+                                                                      pool),
+                                   pool));
+  svn_stringbuf_strip_whitespace(buf);
+  SVN_ERR(svn_cstring_atoi64(generation, buf->data));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+revprop_generation(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs1;
+  svn_fs_t *fs2;
+  apr_hash_t *fs_config;
+  svn_string_t *value;
+  apr_int64_t generation;
+  const char *path;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Writing r0 completes one revprop change. */
+  SVN_ERR(svn_test__create_fs(&fs1, REPO_NAME, opts, pool));
+  SVN_ERR(read_generation(&generation, fs1, pool));
+  SVN_TEST_ASSERT(generation == 2);
+
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_REVPROPS, "1");
+  SVN_ERR(svn_fs_open2(&fs2, svn_fs_path(fs1, pool), fs_config, pool, pool));
+  svn_fs_set_warning_func(fs2, ignore_fs_warnings, NULL);
+
+  /* Populate FS2's cache, then change the revprop through FS1. */
+  SVN_ERR(svn_fs_revision_prop2(&value, fs2, 0, "svn:date", FALSE,
+                                pool, pool));
+  SVN_ERR(svn_fs_revision_prop2(&value, fs2, 0, "svn:date", FALSE,
+                                pool, pool));
+  SVN_ERR(svn_fs_change_rev_prop2(fs1, 0, "svn:date", NULL,
+                                  svn_string_create("new", pool), pool));
+  SVN_ERR(read_generation(&generation, fs1, pool));
+  SVN_TEST_ASSERT(generation == 4);
+
+  /* After a sync barrier, FS2 must not get the cached old value. */
+  SVN_ERR(svn_fs_refresh_revision_props(fs2, pool));
+  SVN_ERR(svn_fs_revision_prop2(&value, fs2, 0, "svn:date", FALSE,
+                                pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, "new");
+
+  /* Simulate a writer that got killed in the middle of a change long ago.
+     The next reader must recover by bumping the generation. */
+  path = svn_fs_fs__path_revprop_generation(fs1, pool);
+  SVN_ERR(svn_io_write_atomic2(path, "5\n", 2, NULL, FALSE, pool));
+  SVN_ERR(svn_io_set_file_affected_time(apr_time_now()
+                                          - apr_time_from_sec(60),
+                                        path, pool));
+
+  SVN_ERR(svn_fs_refresh_revision_props(fs2, pool));
+  SVN_ERR(svn_fs_revision_prop2(&value, fs2, 0, "svn:date", FALSE,
+                                pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, "new");
+  SVN_ERR(read_generation(&generation, fs1, pool));
+  SVN_TEST_ASSERT(generation == 6);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* The test table.  */
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-lock_database"
+
+/* Implements svn_fs_get_locks_callback_t, counting the locks in the
+   int * BATON. */
+static svn_error_t *
+count_locks(void *baton,
+            svn_lock_t *lock,
+            apr_pool_t *pool)
+{
+  int *count = baton;
+  ++*count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *COUNT to the number of locks on and below PATH in FS. */
+static svn_error_t *
+get_lock_count(int *count,
+               svn_fs_t *fs,
+               const char *path,
+               apr_pool_t *pool)
+{
+  *count = 0;
+  SVN_ERR(svn_fs_get_locks2(fs, path, svn_depth_infinity, count_locks,
+                            count, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Append "enable-lock-database = ENABLE" to the fsfs.conf of the
+   repository at REPO_NAME and re-open it as *FS as user "bubba". */
+static svn_error_t *
+reopen_with_lock_database(svn_fs_t **fs,
+                          svn_boolean_t enable,
+                          apr_pool_t *pool)
+{
+  svn_fs_access_t *access;
+  const char *conf = apr_psprintf(pool, "\n[%s]\n%s = %s\n",
+                                  CONFIG_SECTION_LOCK_DATABASE,
+                                  CONFIG_OPTION_ENABLE_LOCK_DATABASE,
+                                  enable ? "true" : "false");
+  apr_file_t *file;
+
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(REPO_NAME, PATH_CONFIG,
+                                                  pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_fs_open2(fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_create_access(&access, "bubba", pool));
+  SVN_ERR(svn_fs_set_access(*fs, access));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+lock_database(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_fs_access_t *access;
+  svn_revnum_t rev;
+  svn_lock_t *lock;
+  apr_hash_t *targets = apr_hash_make(pool);
+  const char *db_path = svn_dirent_join_many(pool, REPO_NAME, PATH_LOCKS_DIR,
+                                             LOCK_DB_NAME, SVN_VA_NULL);
+  svn_node_kind_t kind;
+  int count;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't support lock databases");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* A lock in a digest file. */
+  SVN_ERR(svn_fs_create_access(&access, "bubba", pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/iota", NULL, NULL, FALSE, 0, rev, FALSE,
+                      pool));
+
+  /* Locking a batch moves all locks into the database. */
+  SVN_ERR(reopen_with_lock_database(&fs, TRUE, pool));
+  svn_hash_sets(targets, "/A/mu", svn_fs_lock_target_create(NULL, rev, pool));
+  svn_hash_sets(targets, "/A/B/lambda",
+                svn_fs_lock_target_create(NULL, rev, pool));
+  svn_hash_sets(targets, "/A/D/G/pi",
+                svn_fs_lock_target_create(NULL, rev, pool));
+  svn_hash_sets(targets, "/A/D/G/rho",
+                svn_fs_lock_target_create(NULL, rev, pool));
+  SVN_ERR(svn_fs_lock_many(fs, targets, NULL, FALSE, 0, FALSE, NULL, NULL,
+                           pool, pool));
+
+  SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(get_lock_count(&count, fs, "/", pool));
+  SVN_TEST_INT_ASSERT(count, 5);
+  SVN_ERR(get_lock_count(&count, fs, "/A/D", pool));
+  SVN_TEST_INT_ASSERT(count, 2);
+  SVN_ERR(get_lock_count(&count, fs, "/A/D/G/pi", pool));
+  SVN_TEST_INT_ASSERT(count, 1);
+  SVN_ERR(get_lock_count(&count, fs, "/A/D/H", pool));
+  SVN_TEST_INT_ASSERT(count, 0);
+
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/iota", pool));
+  SVN_TEST_ASSERT(lock && lock->expiration_date == 0);
+  SVN_TEST_STRING_ASSERT(lock->owner, "bubba");
+
+  /* Unlock through the database. */
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/A/D/G/pi", pool));
+  SVN_ERR(svn_fs_unlock(fs, "/A/D/G/pi", lock->token, FALSE, pool));
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/A/D/G/pi", pool));
+  SVN_TEST_ASSERT(lock == NULL);
+
+  /* Disabling the database moves the locks back into digest files. */
+  SVN_ERR(reopen_with_lock_database(&fs, FALSE, pool));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/A/D/gamma", NULL, NULL, FALSE, 0, rev,
+                      FALSE, pool));
+
+  SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(get_lock_count(&count, fs, "/", pool));
+  SVN_TEST_INT_ASSERT(count, 5);
+  SVN_ERR(get_lock_count(&count, fs, "/A/D", pool));
+  SVN_TEST_INT_ASSERT(count, 2);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-access-log"
+#define LOG_CAPACITY 16
+
+static svn_error_t *
+access_log(const svn_test_opts_t *opts,
+           apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_fs_id_t *root_id;
+  node_revision_t *noderev;
+  svn_revnum_t rev;
+  svn_stream_t *contents;
+  apr_hash_t *entries;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_pool_t *fs_pool = svn_pool_create(pool);
+  apr_array_header_t *accesses;
+  apr_uint32_t block_size, shard_size;
+  apr_file_t *file;
+  const char *conf = apr_psprintf(pool, "\n[%s]\n%s = access.log\n%s = %d\n",
+                                  CONFIG_SECTION_DEBUG,
+                                  CONFIG_OPTION_ACCESS_LOG,
+                                  CONFIG_OPTION_ACCESS_LOG_SIZE,
+                                  LOG_CAPACITY);
+  svn_boolean_t found_read = FALSE;
+  svn_boolean_t found_hit = FALSE;
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Enable access logging and start with cold caches. */
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(REPO_NAME, PATH_CONFIG,
+                                                  pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, fs_pool, fs_pool));
+  ffd = fs->fsap_data;
+  SVN_TEST_ASSERT(ffd->access_log);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, fs_pool));
+  SVN_ERR(svn_fs_file_contents(&contents, root, "/iota", fs_pool));
+  SVN_ERR(svn_stream_copy3(contents, svn_stream_empty(fs_pool), NULL, NULL,
+                           fs_pool));
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "/A/D/G", fs_pool));
+
+  /* The second lookup will be served from cache, if there is one. */
+  SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, rev, fs_pool, fs_pool));
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, root_id, fs_pool,
+                                       fs_pool));
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, root_id, fs_pool,
+                                       fs_pool));
+  found_hit = ffd->node_revision_cache == NULL;
+
+  /* Closing the FS writes the remaining records. */
+  svn_pool_destroy(fs_pool);
+
+  SVN_ERR(svn_fs__access_log_read(&accesses, &block_size, &shard_size,
+                                  svn_dirent_join(REPO_NAME, "access.log",
+                                                  pool),
+                                  pool, pool));
+  SVN_TEST_ASSERT(accesses->nelts > 0 && accesses->nelts <= LOG_CAPACITY);
+  SVN_TEST_ASSERT(block_size > 0);
+
+  for (i = 0; i < accesses->nelts; ++i)
+    {
+      svn_fs__access_t *access = &APR_ARRAY_IDX(accesses, i,
+                                                svn_fs__access_t);
+      SVN_TEST_ASSERT(access->revision >= 0 && access->revision <= rev);
+      SVN_TEST_ASSERT(access->item_type <= SVN_FS_FS__ITEM_TYPE_ANY_REP);
+
+      if (access->cache_hit)
+        {
+          SVN_TEST_ASSERT(access->offset == -1);
+          found_hit = TRUE;
+        }
+      else if (access->offset >= 0)
+        {
+          found_read = TRUE;
+        }
+    }
+
+  SVN_TEST_ASSERT(found_read);
+  SVN_TEST_ASSERT(found_hit);
+
+  return SVN_NO_ERROR;
+}
+
+#undef LOG_CAPACITY
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-revision_dates_index"
+
+static svn_error_t *
+revision_dates_index(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  apr_time_t start = apr_time_from_sec(1000000000);
+  const char *dir;
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't have a dates index");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  ffd->revision_dates_index = TRUE;
+
+  /* r1 .. r3, each adding a directory. */
+  for (i = 1; i <= 3; ++i)
+    {
+      SVN_ERR(svn_fs_youngest_rev(&rev, fs, pool));
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+      dir = apr_psprintf(pool, "dir%d", i);
+      SVN_ERR(svn_fs_make_dir(root, dir, pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+    }
+  SVN_TEST_INT_ASSERT(rev, 3);
+
+  /* Give the revisions dates one second apart.  This also updates the
+     index entries that the commits wrote. */
+  for (i = 0; i <= 3; ++i)
+    {
+      const char *date = svn_time_to_cstring(start + apr_time_from_sec(i),
+                                             pool);
+      SVN_ERR(svn_fs_change_rev_prop2(fs, i, SVN_PROP_REVISION_DATE, NULL,
+                                      svn_string_create(date, pool),
+                                      pool));
+    }
+
+  SVN_ERR(svn_fs__dated_revision(&rev, fs, start - 1, pool));
+  SVN_TEST_INT_ASSERT(rev, 0);
+  SVN_ERR(svn_fs__dated_revision(&rev, fs, start, pool));
+  SVN_TEST_INT_ASSERT(rev, 0);
+  SVN_ERR(svn_fs__dated_revision(&rev, fs, start + apr_time_from_sec(1),
+                                 pool));
+  SVN_TEST_INT_ASSERT(rev, 1);
+  SVN_ERR(svn_fs__dated_revision(&rev, fs,
+                                 start + apr_time_from_sec(2) + 500000,
+                                 pool));
+  SVN_TEST_INT_ASSERT(rev, 2);
+  SVN_ERR(svn_fs__dated_revision(&rev, fs, start + apr_time_from_sec(10),
+                                 pool));
+  SVN_TEST_INT_ASSERT(rev, 3);
+
+  /* A disabled index must not be used. */
+  ffd->revision_dates_index = FALSE;
+  SVN_ERR(svn_fs__dated_revision(&rev, fs, start, pool));
+  SVN_TEST_ASSERT(rev == SVN_INVALID_REVNUM);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+/* Idle rev file handles get reused and must not survive packing. */
+#define REPO_NAME "test-repo-file-handle-cache"
+#define SHARD_SIZE 4
+#define MAX_REV (SHARD_SIZE + 1)
+static svn_error_t *
+file_handle_cache(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_fs__revision_file_t *rev_file, *other_file;
+  apr_file_t *apr_file;
+  svn_node_kind_t kind;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+  ffd->cached_file_handles = 4;
+
+  /* A closed file will be handed out again. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, 1, pool, pool));
+  apr_file = rev_file->file;
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, 1, pool, pool));
+  SVN_TEST_ASSERT(rev_file->file == apr_file);
+  SVN_TEST_ASSERT(!rev_file->is_packed);
+
+  /* But never to two readers at the same time. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&other_file, fs, 1, pool, pool));
+  SVN_TEST_ASSERT(other_file->file != apr_file);
+  SVN_ERR(svn_fs_fs__close_revision_file(other_file));
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Packing closes the idle handles and removes the rev files. */
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_io_check_path(svn_dirent_join_many(pool, REPO_NAME, "revs",
+                                                 "0", SVN_VA_NULL),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, 1, pool, pool));
+  SVN_TEST_ASSERT(rev_file->is_packed);
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+/* Small transactions may be kept in memory, larger ones get written to
+   the txn directory part-way through. */
+#define REPO_NAME "test-repo-in-memory-txn"
+static svn_error_t *
+in_memory_txn(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  const char *txn_name;
+  svn_revnum_t rev;
+  svn_node_kind_t kind;
+  svn_stringbuf_t *contents;
+  svn_string_t *value;
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  ffd->in_memory_txn_size = 4096;
+
+  /* A small commit does not write its changes list to disk. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, 0, SVN_FS_TXN__IN_MEMORY, pool));
+  SVN_ERR(svn_fs_txn_name(&txn_name, txn, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/file", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "/file", "text\n", pool));
+  SVN_ERR(svn_fs_change_node_prop(txn_root, "/file", "prop",
+                                  svn_string_create("value", pool), pool));
+
+  SVN_ERR(svn_io_check_path(svn_dirent_join_many(pool, REPO_NAME,
+                                                 "transactions",
+                                                 apr_pstrcat(pool, txn_name,
+                                                             ".txn",
+                                                             SVN_VA_NULL),
+                                                 "changes", SVN_VA_NULL),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_INT_ASSERT(rev, 1);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "/file", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "text\n");
+  SVN_ERR(svn_fs_node_prop(&value, root, "/file", "prop", pool));
+  SVN_TEST_STRING_ASSERT(value->data, "value");
+
+  /* A larger one continues on disk once it exceeds the limit. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, rev, SVN_FS_TXN__IN_MEMORY, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  for (i = 0; i < 50; ++i)
+    {
+      const char *path = apr_psprintf(pool, "/file-%d", i);
+      SVN_ERR(svn_fs_make_file(txn_root, path, pool));
+      SVN_ERR(svn_fs_change_node_prop(txn_root, path, "prop",
+                                      svn_string_create(path, pool), pool));
+    }
+
+  SVN_ERR(svn_fs_delete(txn_root, "/file", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_INT_ASSERT(rev, 2);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, "/file", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  for (i = 0; i < 50; ++i)
+    {
+      const char *path = apr_psprintf(pool, "/file-%d", i);
+      SVN_ERR(svn_fs_node_prop(&value, root, path, "prop", pool));
+      SVN_TEST_STRING_ASSERT(value->data, path);
+    }
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+#define REPO_NAME "test-repo-compressed-changes"
+static svn_error_t *
+compressed_changes(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  enum { FILE_COUNT = 250 };
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config;
+  svn_stringbuf_t *format;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  apr_hash_t *changes;
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't support compressed changes");
+
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_COMPRESSED_CHANGES, "true");
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&format,
+                                   svn_dirent_join(REPO_NAME, "format", pool),
+                                   pool));
+  SVN_TEST_ASSERT(strstr(format->data, "changes lz4\n") != NULL);
+
+  /* r1 has several blocks worth of changes with long shared prefixes. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "/dir", pool));
+  for (i = 0; i < FILE_COUNT; ++i)
+    SVN_ERR(svn_fs_make_file(txn_root,
+                             apr_psprintf(pool, "/dir/file %d", i), pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_INT_ASSERT(rev, 1);
+
+  /* r2 has a copy, a modification and a deletion. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_copy(root, "/dir", txn_root, "/copy", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "/dir/file 1", "text\n",
+                                      pool));
+  SVN_ERR(svn_fs_delete(txn_root, "/dir/file 10", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_INT_ASSERT(rev, 2);
+
+  /* Read the lists back from disk, not from the caches. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  changes = apr_hash_make(pool);
+  SVN_ERR(svn_fs_revision_root(&root, fs, 1, pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, pool, pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      SVN_TEST_ASSERT(change->change_kind == svn_fs_path_change_add);
+      svn_hash_sets(changes, apr_pstrmemdup(pool, change->path.data,
+                                            change->path.len), change);
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  SVN_TEST_INT_ASSERT(apr_hash_count(changes), FILE_COUNT + 1);
+  SVN_TEST_ASSERT(svn_hash_gets(changes, "/dir"));
+  for (i = 0; i < FILE_COUNT; ++i)
+    SVN_TEST_ASSERT(svn_hash_gets(changes,
+                                  apr_psprintf(pool, "/dir/file %d", i)));
+
+  changes = apr_hash_make(pool);
+  SVN_ERR(svn_fs_revision_root(&root, fs, 2, pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, pool, pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      svn_hash_sets(changes, apr_pstrmemdup(pool, change->path.data,
+                                            change->path.len),
+                    svn_fs_path_change3_dup(change, pool));
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  SVN_TEST_INT_ASSERT(apr_hash_count(changes), 3);
+  change = svn_hash_gets(changes, "/copy");
+  SVN_TEST_ASSERT(change && change->change_kind == svn_fs_path_change_add);
+  SVN_TEST_INT_ASSERT(change->copyfrom_rev, 1);
+  SVN_TEST_STRING_ASSERT(change->copyfrom_path, "/dir");
+  change = svn_hash_gets(changes, "/dir/file 1");
+  SVN_TEST_ASSERT(change && change->text_mod);
+  change = svn_hash_gets(changes, "/dir/file 10");
+  SVN_TEST_ASSERT(change
+                  && change->change_kind == svn_fs_path_change_delete);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+#define REPO_NAME "test-repo-binary-properties"
+#define SHARD_SIZE 2
+static svn_error_t *
+binary_properties(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config, *props;
+  svn_stringbuf_t *content;
+  svn_string_t *value;
+  svn_boolean_t has_props;
+  const svn_string_t binary_value = { "a\0b", 3 };
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't support binary properties");
+
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_BINARY_PROPERTIES, "true");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE,
+                apr_itoa(pool, SHARD_SIZE));
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&content,
+                                   svn_dirent_join(REPO_NAME, "format", pool),
+                                   pool));
+  SVN_TEST_ASSERT(strstr(content->data, "properties binary\n") != NULL);
+
+  /* r1 .. r3, each with node properties and a log message. */
+  for (i = 1; i <= 3; ++i)
+    {
+      const char *path = apr_psprintf(pool, "/file-%d", i);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, i - 1, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_fs_make_file(txn_root, path, pool));
+      SVN_ERR(svn_fs_change_node_prop(txn_root, path, "binary",
+                                      &binary_value, pool));
+      SVN_ERR(svn_fs_change_node_prop(txn_root, path, "empty",
+                                      svn_string_create_empty(pool), pool));
+      SVN_ERR(svn_fs_change_node_prop(txn_root, "/", "dir",
+                                      svn_string_create(path, pool), pool));
+      SVN_ERR(svn_fs_change_txn_prop(txn, SVN_PROP_REVISION_LOG,
+                                     svn_string_create(path, pool), pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+      SVN_TEST_INT_ASSERT(rev, i);
+    }
+
+  /* Revision properties are stored in the binary encoding as well. */
+  SVN_ERR(svn_stringbuf_from_file2(&content,
+                                   svn_dirent_join_many(pool, REPO_NAME,
+                                                        "revprops", "1", "3",
+                                                        SVN_VA_NULL),
+                                   pool));
+  SVN_TEST_ASSERT(content->len > 0 && content->data[0] == '\0');
+
+  /* Pack both shards and modify a packed revprop. */
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_change_rev_prop2(fs, 1, "new", NULL,
+                                  svn_string_create("value", pool), pool));
+
+  /* Read everything back from disk, not from the caches. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  for (i = 1; i <= 3; ++i)
+    {
+      const char *path = apr_psprintf(pool, "/file-%d", i);
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, i, pool));
+      SVN_ERR(svn_fs_node_proplist(&props, root, path, pool));
+      SVN_TEST_INT_ASSERT(apr_hash_count(props), 2);
+      value = svn_hash_gets(props, "binary");
+      SVN_TEST_ASSERT(value && svn_string_compare(value, &binary_value));
+      value = svn_hash_gets(props, "empty");
+      SVN_TEST_ASSERT(value && value->len == 0 && value->data[0] == '\0');
+
+      SVN_ERR(svn_fs_node_prop(&value, root, "/", "dir", pool));
+      SVN_TEST_STRING_ASSERT(value->data, path);
+      SVN_ERR(svn_fs_node_has_props(&has_props, root, path, pool));
+      SVN_TEST_ASSERT(has_props);
+
+      SVN_ERR(svn_fs_revision_prop2(&value, fs, i, SVN_PROP_REVISION_LOG,
+                                    TRUE, pool, pool));
+      SVN_TEST_STRING_ASSERT(value->data, path);
+    }
+
+  SVN_ERR(svn_fs_revision_prop2(&value, fs, 1, "new", TRUE, pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, "value");
+
+  /* r0 still uses the hash dump format. */
+  SVN_ERR(svn_fs_revision_proplist2(&props, fs, 0, TRUE, pool, pool));
+  SVN_TEST_ASSERT(svn_hash_gets(props, SVN_PROP_REVISION_DATE));
+
+  return SVN_NO_ERROR;
+}
+#undef SHARD_SIZE
+#undef REPO_NAME
+
+#define REPO_NAME "test-repo-zstd-deltas"
+static svn_error_t *
+zstd_deltas(const svn_test_opts_t *opts,
+            apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config;
+  svn_stringbuf_t *format;
+  svn_stringbuf_t *contents;
+  const char *format_path;
+  const char *conf;
+  apr_file_t *file;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  if (opts->server_minor_version && (opts->server_minor_version < 10))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.10 SVN doesn't support zstd");
+
+  if (!svn__zstd_supported())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this build doesn't support zstd");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_ZSTD_DELTAS_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Select zstd compression and re-open the repository. */
+  conf = apr_psprintf(pool, "\n[%s]\n%s = zstd\n",
+                      CONFIG_SECTION_DELTIFICATION,
+                      CONFIG_OPTION_COMPRESSION);
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(REPO_NAME, PATH_CONFIG,
+                                                  pool),
+                           APR_WRITE | APR_APPEND, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, conf, strlen(conf), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* Nothing announces zstd deltas before the first commit. */
+  format_path = svn_dirent_join(REPO_NAME, "format", pool);
+  SVN_ERR(svn_stringbuf_from_file2(&format, format_path, pool));
+  SVN_TEST_ASSERT(strstr(format->data, "deltas zstd") == NULL);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/file", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "/file", "r1\n", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_INT_ASSERT(rev, 1);
+
+  /* Committing has announced them. */
+  SVN_ERR(svn_stringbuf_from_file2(&format, format_path, pool));
+  SVN_TEST_ASSERT(strstr(format->data, "\ndeltas zstd\n") != NULL);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "/file", "r2\n", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_INT_ASSERT(rev, 2);
+
+  /* Both revisions read back from disk, not from the caches, and the
+     option survives re-opening. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  ffd = fs->fsap_data;
+  SVN_TEST_ASSERT(ffd->zstd_deltas);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, 1, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "/file", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "r1\n");
+  SVN_ERR(svn_fs_revision_root(&root, fs, 2, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "/file", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "r2\n");
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, rev, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+#define REPO_NAME "test-repo-history-chunks"
+
+/* Walk the history of PATH@REVISION in FS across copies and check that
+   it reports the comma-separated "REV:PATH" list EXPECTED. */
+static svn_error_t *
+check_history(svn_fs_t *fs,
+              const char *path,
+              svn_revnum_t revision,
+              const char *expected,
+              apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  svn_fs_history_t *history;
+  svn_stringbuf_t *actual = svn_stringbuf_create_empty(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, pool));
+  SVN_ERR(svn_fs_node_history2(&history, root, path, pool, iterpool));
+  while (TRUE)
+    {
+      const char *history_path;
+      svn_revnum_t history_rev;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_history_prev2(&history, history, TRUE, pool,
+                                   iterpool));
+      if (! history)
+        break;
+
+      SVN_ERR(svn_fs_history_location(&history_path, &history_rev,
+                                      history, iterpool));
+      svn_stringbuf_appendcstr(actual,
+                               apr_psprintf(pool, "%s%ld:%s",
+                                            actual->len ? "," : "",
+                                            history_rev, history_path));
+    }
+  svn_pool_destroy(iterpool);
+
+  if (strcmp(actual->data, expected) != 0)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "History of %s@%ld is '%s', expected '%s'",
+                             path, revision, actual->data, expected);
+
+  return SVN_NO_ERROR;
+}
+
+/* Append "REV:PATH" for all revisions from START down to END to BUF. */
+static void
+append_history(svn_stringbuf_t *buf,
+               svn_revnum_t start,
+               svn_revnum_t end,
+               const char *path)
+{
+  svn_revnum_t rev;
+
+  for (rev = start; rev >= end; --rev)
+    svn_stringbuf_appendcstr(buf, apr_psprintf(buf->pool, "%s%ld:%s",
+                                               buf->len ? "," : "",
+                                               rev, path));
+}
+
+static svn_error_t *
+history_chunks(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config;
+  svn_stringbuf_t *trunk_history, *branch_history, *old_history;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* r1: Add /trunk/file.  r2 .. r100: Change it, building a linear
+     history longer than a history chunk. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "/trunk", pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "/trunk/file", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  for (rev = 1; rev < 100; )
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "/trunk/file",
+                                          apr_psprintf(iterpool, "%ld\n",
+                                                       rev + 1),
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+    }
+
+  /* r101: Branch /trunk.  r102 .. r110: Change the branch. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_copy(root, "/trunk", txn_root, "/branch", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  while (rev < 110)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "/branch/file",
+                                          apr_psprintf(iterpool,
+                                                       "branch %ld\n",
+                                                       rev + 1),
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+    }
+
+  /* r111: Change /trunk/file once more. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "/trunk/file", "111\n",
+                                      pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_INT_ASSERT(rev, 111);
+  svn_pool_destroy(iterpool);
+
+  trunk_history = svn_stringbuf_create("111:/trunk/file", pool);
+  append_history(trunk_history, 100, 1, "/trunk/file");
+
+  branch_history = svn_stringbuf_create_empty(pool);
+  append_history(branch_history, 110, 101, "/branch/file");
+  append_history(branch_history, 100, 1, "/trunk/file");
+
+  old_history = svn_stringbuf_create_empty(pool);
+  append_history(old_history, 50, 1, "/trunk/file");
+
+  /* Start with cold caches. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  /* Each walk must report the same, whether it builds history chunks,
+     continues along chunks that other walks built, or starts in the
+     middle of one. */
+  SVN_ERR(check_history(fs, "/trunk/file", 111, trunk_history->data, pool));
+  SVN_ERR(check_history(fs, "/trunk/file", 111, trunk_history->data, pool));
+  SVN_ERR(check_history(fs, "/branch/file", 110, branch_history->data,
+                        pool));
+  SVN_ERR(check_history(fs, "/branch/file", 110, branch_history->data,
+                        pool));
+  SVN_ERR(check_history(fs, "/trunk/file", 50, old_history->data, pool));
+  SVN_ERR(check_history(fs, "/trunk/file", 111, trunk_history->data, pool));
+
+  /* Again, with the chunks built from the branch history first. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  SVN_ERR(check_history(fs, "/trunk/file", 50, old_history->data, pool));
+  SVN_ERR(check_history(fs, "/branch/file", 110, branch_history->data,
+                        pool));
+  SVN_ERR(check_history(fs, "/trunk/file", 111, trunk_history->data, pool));
+  SVN_ERR(check_history(fs, "/branch/file", 110, branch_history->data,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
 
 static int max_threads = 4;
 
@@ -1902,6 +4115,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack FSFS where revs % shard = 0"),
     SVN_TEST_OPTS_PASS(read_packed_fs,
                        "read from a packed FSFS filesystem"),
+    SVN_TEST_OPTS_PASS(read_packed_fs_mmap,
+                       "read from memory-mapped FSFS pack files"),
+    SVN_TEST_OPTS_PASS(read_delta_chain_prefetch,
+                       "read delta chains with prefetching enabled"),
     SVN_TEST_OPTS_PASS(commit_packed_fs,
                        "commit to a packed FSFS filesystem"),
     SVN_TEST_OPTS_PASS(get_set_revprop_packed_fs,
@@ -1942,6 +4159,47 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack with limited memory for metadata"),
     SVN_TEST_OPTS_PASS(large_delta_against_plain,
                        "large deltas against PLAIN, issue #4658"),
+    SVN_TEST_OPTS_PASS(item_offsets_batch,
+                       "batched l2p index lookups"),
+    SVN_TEST_OPTS_PASS(rev_file_read_ahead,
+                       "read-ahead for sequential rev file access"),
+    SVN_TEST_OPTS_PASS(pack_concurrently,
+                       "pack several shards concurrently"),
+    SVN_TEST_OPTS_PASS(large_directory,
+                       "directories too large for the dir cache"),
+    SVN_TEST_OPTS_SKIP(group_commit,
+                       ! APR_HAS_THREADS,
+                       "group commit of concurrent commits"),
+    SVN_TEST_OPTS_PASS(sharded_rep_cache,
+                       "rep-cache split into several database files"),
+    SVN_TEST_OPTS_PASS(rep_cache_filter,
+                       "in-memory filter in front of the rep-cache"),
+    SVN_TEST_OPTS_PASS(changed_paths_index,
+                       "changed-paths index for path-restricted log"),
+    SVN_TEST_OPTS_PASS(mergeinfo_index,
+                       "mergeinfo index for descendant mergeinfo"),
+    SVN_TEST_OPTS_PASS(delta_base_policy,
+                       "cost-based delta base selection"),
+    SVN_TEST_OPTS_PASS(revprop_generation,
+                       "revprop generation shared between processes"),
+    SVN_TEST_OPTS_PASS(lock_database,
+                       "lock storage in an SQLite database"),
+    SVN_TEST_OPTS_PASS(access_log,
+                       "access log of rev and pack file reads"),
+    SVN_TEST_OPTS_PASS(revision_dates_index,
+                       "revision dates index for dated revisions"),
+    SVN_TEST_OPTS_PASS(file_handle_cache,
+                       "reuse of idle rev and pack file handles"),
+    SVN_TEST_OPTS_PASS(in_memory_txn,
+                       "transactions kept in memory"),
+    SVN_TEST_OPTS_PASS(compressed_changes,
+                       "compressed changed paths lists"),
+    SVN_TEST_OPTS_PASS(binary_properties,
+                       "binary property lists"),
+    SVN_TEST_OPTS_PASS(zstd_deltas,
+                       "announce zstd deltas in the format file"),
+    SVN_TEST_OPTS_PASS(history_chunks,
+                       "node history walks over cached chunks"),
     SVN_TEST_NULL
   };
 
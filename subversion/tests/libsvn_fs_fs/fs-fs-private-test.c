@@ -25,6 +25,7 @@
 
 #include "../svn_test.h"
 
+#include "svn_dirent_uri.h"
 #include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_props.h"
@@ -209,8 +210,8 @@ get_repo_stats(const svn_test_opts_t *opts,
   SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
 
   /* Gather statistics info on that repo. */
-  SVN_ERR(svn_fs_fs__get_stats(&stats, svn_repos_fs(repos), NULL, NULL,
-                               NULL, NULL, pool, pool));
+  SVN_ERR(svn_fs_fs__get_stats(&stats, svn_repos_fs(repos), 1, NULL, NULL,
+                               NULL, NULL, NULL, pool, pool));
 
   /* Check that the stats make sense. */
   SVN_TEST_ASSERT(stats->total_size > 1000 && stats->total_size < 10000);
@@ -267,6 +268,153 @@ get_repo_stats(const svn_test_opts_t *opts,
 
 /* ------------------------------------------------------------------------ */
 
+#define REPO_NAME "test-repo-get-repo-stats-incremental-test"
+#define SHARD_SIZE 3
+
+/* Verify that STATS and EXPECTED contain the same information. */
+static svn_error_t *
+verify_same_stats(const svn_fs_fs__stats_t *stats,
+                  const svn_fs_fs__stats_t *expected)
+{
+  apr_size_t i;
+
+  SVN_TEST_ASSERT(stats->total_size == expected->total_size);
+  SVN_TEST_ASSERT(stats->revision_count == expected->revision_count);
+  SVN_TEST_ASSERT(stats->change_count == expected->change_count);
+  SVN_TEST_ASSERT(stats->change_len == expected->change_len);
+
+  /* These are plain numbers. */
+#define SAME(member) \
+  SVN_TEST_ASSERT(memcmp(&stats->member, &expected->member, \
+                         sizeof(stats->member)) == 0)
+
+  SAME(total_rep_stats);
+  SAME(file_rep_stats);
+  SAME(dir_rep_stats);
+  SAME(file_prop_rep_stats);
+  SAME(dir_prop_rep_stats);
+  SAME(total_node_stats);
+  SAME(file_node_stats);
+  SAME(dir_node_stats);
+  SAME(rep_size_histogram);
+  SAME(node_size_histogram);
+  SAME(added_rep_size_histogram);
+  SAME(added_node_size_histogram);
+  SAME(unused_rep_histogram);
+  SAME(file_histogram);
+  SAME(file_rep_histogram);
+  SAME(file_prop_histogram);
+  SAME(file_prop_rep_histogram);
+  SAME(dir_histogram);
+  SAME(dir_rep_histogram);
+  SAME(dir_prop_histogram);
+  SAME(dir_prop_rep_histogram);
+
+#undef SAME
+
+  SVN_TEST_ASSERT(apr_hash_count(stats->by_extension)
+                  == apr_hash_count(expected->by_extension));
+  SVN_TEST_ASSERT(stats->largest_changes->min_size
+                  == expected->largest_changes->min_size);
+  for (i = 0; i < stats->largest_changes->count; ++i)
+    SVN_TEST_ASSERT(stats->largest_changes->changes[i]->size
+                    == expected->largest_changes->changes[i]->size);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_repo_stats_incremental(const svn_test_opts_t *opts,
+                           apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_fs_root_t *rev_root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config;
+  svn_fs_fs__stats_t *expected, *stats;
+  svn_node_kind_t kind;
+  const char *cache_dir;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 6))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.6 SVN doesn't support FSFS packing");
+
+  /* Create a repository with small shards. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE,
+                apr_itoa(pool, SHARD_SIZE));
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Delta chains and shared reps that span several shards. */
+  for (i = 0; i < 12; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, 1, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          apr_psprintf(iterpool,
+                                                       "iota %d\n", i),
+                                          iterpool));
+      SVN_ERR(svn_fs_copy(rev_root, "A/mu", txn_root,
+                          apr_psprintf(iterpool, "A/mu.%d", i), iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+    }
+
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+
+  /* Reference values, read one shard after another. */
+  SVN_ERR(svn_fs_fs__get_stats(&expected, fs, 1, NULL, NULL, NULL,
+                               NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(expected->revision_count == rev + 1);
+  SVN_TEST_ASSERT(expected->file_rep_stats.shared.count > 0);
+
+  /* Parallel reading must not change the results. */
+  SVN_ERR(svn_fs_fs__get_stats(&stats, fs, 4, NULL, NULL, NULL,
+                               NULL, NULL, pool, pool));
+  SVN_ERR(verify_same_stats(stats, expected));
+
+  /* The first run creates the summaries, the second one uses them. */
+  cache_dir = svn_test_data_path("get-repo-stats-incremental-cache", pool);
+  SVN_ERR(svn_io_remove_dir2(cache_dir, TRUE, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(cache_dir);
+
+  SVN_ERR(svn_fs_fs__get_stats(&stats, fs, 4, cache_dir, NULL, NULL,
+                               NULL, NULL, pool, pool));
+  SVN_ERR(verify_same_stats(stats, expected));
+
+  SVN_ERR(svn_io_check_path(svn_dirent_join(cache_dir, "0.stats", pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  SVN_ERR(svn_fs_fs__get_stats(&stats, fs, 1, cache_dir, NULL, NULL,
+                               NULL, NULL, pool, pool));
+  SVN_ERR(verify_same_stats(stats, expected));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef SHARD_SIZE
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
 #define REPO_NAME "test-repo-dump-index-test"
 
 typedef struct dump_baton_t
@@ -429,6 +577,8 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_OPTS_PASS(get_repo_stats,
                        "get statistics on a FSFS filesystem"),
+    SVN_TEST_OPTS_PASS(get_repo_stats_incremental,
+                       "get statistics in parallel and incrementally"),
     SVN_TEST_OPTS_PASS(dump_index,
                        "dump the P2L index"),
     SVN_TEST_OPTS_PASS(load_index,
@@ -88,13 +88,13 @@ store_and_load_table(string_table_t **table, apr_pool_t *pool)
   svn_stream_t *stream;
 
   stream = svn_stream_from_stringbuf(stream_buffer, pool);
-  SVN_ERR(svn_fs_x__write_string_table(stream, *table, pool));
+  SVN_ERR(svn_fs_x__write_string_table(stream, *table, NULL, pool));
   SVN_ERR(svn_stream_close(stream));
 
   *table = NULL;
 
   stream = svn_stream_from_stringbuf(stream_buffer, pool);
-  SVN_ERR(svn_fs_x__read_string_table(table, stream, pool, pool));
+  SVN_ERR(svn_fs_x__read_string_table(table, stream, NULL, pool, pool));
   SVN_ERR(svn_stream_close(stream));
 
   return SVN_NO_ERROR;
@@ -238,6 +238,46 @@ many_strings_table_body(svn_boolean_t do_load_store,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+path_table_body(svn_boolean_t do_load_store,
+                apr_pool_t *pool)
+{
+  /* many paths, each added several times, to fill multiple sub-tables */
+  enum { COUNT = 20000, DISTINCT = 5000 };
+
+  const char **paths = apr_palloc(pool, COUNT * sizeof(*paths));
+  apr_size_t *indexes = apr_palloc(pool, COUNT * sizeof(*indexes));
+
+  string_table_builder_t *builder;
+  string_table_t *table;
+  int i;
+
+  builder = svn_fs_x__string_table_builder_create(pool);
+  for (i = 0; i < COUNT; ++i)
+    {
+      int k = (i * 7919) % DISTINCT;
+      paths[i] = apr_psprintf(pool, "/trunk/subversion/dir%d/sub%d/file%d.c",
+                              k % 17, k % 101, k);
+      indexes[i] = svn_fs_x__string_table_builder_add(builder, paths[i], 0);
+    }
+
+  table = svn_fs_x__string_table_create(builder, pool);
+  if (do_load_store)
+    SVN_ERR(store_and_load_table(&table, pool));
+
+  for (i = 0; i < COUNT; ++i)
+    {
+      apr_size_t len;
+      const char *string
+        = svn_fs_x__string_table_get(table, indexes[i], &len, pool);
+
+      SVN_TEST_STRING_ASSERT(string, paths[i]);
+      SVN_TEST_ASSERT(len == strlen(paths[i]));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 create_empty_table(apr_pool_t *pool)
 {
@@ -286,6 +326,18 @@ store_load_many_strings_table(apr_pool_t *pool)
   return svn_error_trace(many_strings_table_body(TRUE, pool));
 }
 
+static svn_error_t *
+path_table(apr_pool_t *pool)
+{
+  return svn_error_trace(path_table_body(FALSE, pool));
+}
+
+static svn_error_t *
+store_load_path_table(apr_pool_t *pool)
+{
+  return svn_error_trace(path_table_body(TRUE, pool));
+}
+
 
 /* ------------------------------------------------------------------------ */
 
@@ -312,6 +364,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "store and load table with large strings only"),
     SVN_TEST_PASS2(store_load_many_strings_table,
                    "store and load string table with many strings"),
+    SVN_TEST_PASS2(path_table,
+                   "string table with many repeated paths"),
+    SVN_TEST_PASS2(store_load_path_table,
+                   "store and load string table with many paths"),
     SVN_TEST_NULL
   };
 
@@ -30,6 +30,7 @@
 
 #include "svn_error.h"
 #include "svn_delta.h"
+#include "svn_diff.h"
 #include "svn_ra.h"
 #include "svn_time.h"
 #include "svn_pools.h"
@@ -37,6 +38,8 @@
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
 
+#include "private/svn_ra_private.h"
+
 #include "../svn_test.h"
 #include "../svn_test_fs.h"
 #include "../../libsvn_ra_local/ra_local.h"
@@ -137,6 +140,42 @@ commit_tree(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+/* Commit TEXT as the new contents of the file "f", adding the file if
+   BASE_REV is SVN_INVALID_REVNUM. */
+static svn_error_t *
+commit_file_text(svn_ra_session_t *session,
+                 const char *text,
+                 svn_revnum_t base_rev,
+                 apr_pool_t *pool)
+{
+  apr_hash_t *revprop_table = apr_hash_make(pool);
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  void *root_baton, *file_baton;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+
+  SVN_ERR(svn_ra_get_commit_editor3(session, &editor, &edit_baton,
+                                    revprop_table,
+                                    NULL, NULL, NULL, TRUE, pool));
+
+  SVN_ERR(editor->open_root(edit_baton, SVN_INVALID_REVNUM,
+                            pool, &root_baton));
+  if (SVN_IS_VALID_REVNUM(base_rev))
+    SVN_ERR(editor->open_file("f", root_baton, base_rev, pool, &file_baton));
+  else
+    SVN_ERR(editor->add_file("f", root_baton, NULL, SVN_INVALID_REVNUM,
+                             pool, &file_baton));
+  SVN_ERR(editor->apply_textdelta(file_baton, NULL, pool,
+                                  &handler, &handler_baton));
+  SVN_ERR(svn_txdelta_send_string(svn_string_create(text, pool),
+                                  handler, handler_baton, pool));
+  SVN_ERR(editor->close_file(file_baton, NULL, pool));
+  SVN_ERR(editor->close_directory(root_baton, pool));
+  SVN_ERR(editor->close_edit(edit_baton, pool));
+  return SVN_NO_ERROR;
+}
+
 /* Baton for opening tunnels */
 typedef struct tunnel_baton_t
 {
@@ -1586,6 +1625,232 @@ tunnel_run_checkout(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+tunnel_stat_many(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  tunnel_baton_t *b = apr_pcalloc(pool, sizeof(*b));
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  const char *url;
+  svn_ra_callbacks2_t *cbtable;
+  svn_ra_session_t *session;
+  const char tunnel_repos_name[] = "test-stat-many";
+  apr_array_header_t *paths;
+  apr_hash_t *dirents;
+  svn_dirent_t *dirent;
+
+  b->magic = TUNNEL_MAGIC;
+
+  SVN_ERR(svn_test__create_repos(NULL, tunnel_repos_name, opts, scratch_pool));
+
+  /* Immediately close the repository to avoid race condition with svnserve
+  (and then the cleanup code) with BDB when our pool is cleared. */
+  svn_pool_clear(scratch_pool);
+
+  url = apr_pstrcat(pool, "svn+test://localhost/", tunnel_repos_name,
+    SVN_VA_NULL);
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, pool));
+  cbtable->check_tunnel_func = check_tunnel;
+  cbtable->open_tunnel_func = open_tunnel;
+  cbtable->tunnel_baton = b;
+  SVN_ERR(svn_cmdline_create_auth_baton2(&cbtable->auth_baton,
+    TRUE  /* non_interactive */,
+    "jrandom", "rayjandom",
+    NULL,
+    TRUE  /* no_auth_cache */,
+    FALSE /* trust_server_cert */,
+    FALSE, FALSE, FALSE, FALSE,
+    NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_ra_open4(&session, NULL, url, NULL, cbtable, NULL, NULL,
+                       scratch_pool));
+  SVN_ERR(commit_tree(session, pool));
+
+  /* Existing and non-existing paths, files and directories. */
+  paths = apr_array_make(pool, 4, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "A";
+  APR_ARRAY_PUSH(paths, const char *) = "A/B/f";
+  APR_ARRAY_PUSH(paths, const char *) = "A/missing";
+  APR_ARRAY_PUSH(paths, const char *) = "A/BB";
+
+  SVN_ERR(svn_ra__stat_many(session, &dirents, paths, 1, pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 3);
+
+  dirent = svn_hash_gets(dirents, "A");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+  dirent = svn_hash_gets(dirents, "A/B/f");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_file);
+  SVN_TEST_INT_ASSERT(dirent->created_rev, 1);
+  dirent = svn_hash_gets(dirents, "A/BB");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+
+  /* The session must still be in sync with the server. */
+  SVN_ERR(svn_ra_stat(session, "A/BB/g", 1, &dirent, pool));
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_file);
+
+  svn_pool_destroy(scratch_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra__blame_receiver_t for file_blame_test */
+static svn_error_t *
+blame_chunk_receiver(void *baton,
+                     apr_int64_t start_line,
+                     svn_revnum_t revision,
+                     apr_hash_t *rev_props,
+                     apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *chunks = baton;
+
+  svn_stringbuf_appendcstr(chunks,
+                           apr_psprintf(scratch_pool, "%d:%ld ",
+                                        (int)start_line, revision));
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+file_blame_test(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  svn_diff_file_options_t *diff_options;
+  svn_stringbuf_t *chunks;
+
+  SVN_ERR(make_and_open_repos(&session, "test-file-blame", opts, pool));
+  SVN_ERR(commit_file_text(session, "a\nb\nc\n", SVN_INVALID_REVNUM, pool));
+  SVN_ERR(commit_file_text(session, "a\nB\nc\nd\n", 1, pool));
+
+  diff_options = svn_diff_file_options_create(pool);
+
+  chunks = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_ra__get_file_blame(session, "f", 1, 2, diff_options,
+                                 blame_chunk_receiver, chunks, pool));
+  SVN_TEST_STRING_ASSERT(chunks->data, "0:1 1:2 2:1 3:2 4:1 ");
+
+  /* Lines from before the range are not blamed on any revision. */
+  chunks = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_ra__get_file_blame(session, "f", 2, 2, diff_options,
+                                 blame_chunk_receiver, chunks, pool));
+  SVN_TEST_STRING_ASSERT(chunks->data, "0:-1 1:2 2:-1 3:2 4:-1 ");
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra__async_stat_cb_t for async_requests_test */
+static svn_error_t *
+async_stat_cb(void *baton,
+              const char *path,
+              const svn_dirent_t *dirent,
+              apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *events = baton;
+
+  svn_stringbuf_appendcstr(events,
+                           apr_psprintf(scratch_pool, "stat:%s:%s ", path,
+                                        dirent ? "found" : "missing"));
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra__async_file_cb_t for async_requests_test */
+static svn_error_t *
+async_file_cb(void *baton,
+              const char *path,
+              svn_revnum_t fetched_rev,
+              apr_hash_t *props,
+              apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *events = baton;
+
+  svn_stringbuf_appendcstr(events,
+                           apr_psprintf(scratch_pool, "file:%s ", path));
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra__async_dir_cb_t for async_requests_test */
+static svn_error_t *
+async_dir_cb(void *baton,
+             const char *path,
+             apr_hash_t *dirents,
+             svn_revnum_t fetched_rev,
+             apr_hash_t *props,
+             apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *events = baton;
+
+  svn_stringbuf_appendcstr(events,
+                           apr_psprintf(scratch_pool, "dir:%u ",
+                                        apr_hash_count(dirents)));
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_log_entry_receiver_t for async_requests_test */
+static svn_error_t *
+async_log_receiver(void *baton,
+                   svn_log_entry_t *log_entry,
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *events = baton;
+
+  svn_stringbuf_appendcstr(events,
+                           apr_psprintf(pool, "log:%ld ",
+                                        log_entry->revision));
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra__async_log_cb_t for async_requests_test */
+static svn_error_t *
+async_log_cb(void *baton,
+             apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *events = baton;
+
+  svn_stringbuf_appendcstr(events, "log-done ");
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+async_requests_test(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  svn_ra__async_t *async;
+  svn_stringbuf_t *events = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(const char *));
+
+  SVN_ERR(make_and_open_repos(&session, "test-async-requests", opts, pool));
+  SVN_ERR(commit_file_text(session, "hello\n", SVN_INVALID_REVNUM, pool));
+
+  APR_ARRAY_PUSH(paths, const char *) = "";
+
+  SVN_ERR(svn_ra__async_create(&async, session, pool));
+  SVN_ERR(svn_ra__async_stat(async, "f", 1, async_stat_cb, events));
+  SVN_ERR(svn_ra__async_get_file(async, "f", 1,
+                                 svn_stream_from_stringbuf(contents, pool),
+                                 async_file_cb, events));
+  SVN_ERR(svn_ra__async_stat(async, "missing", 1, async_stat_cb, events));
+  SVN_ERR(svn_ra__async_get_dir(async, "", 1, SVN_DIRENT_KIND,
+                                async_dir_cb, events));
+  SVN_ERR(svn_ra__async_get_log(async, paths, 1, 1, 0, FALSE, FALSE, FALSE,
+                                NULL, async_log_receiver, events,
+                                async_log_cb, events));
+  SVN_ERR(svn_ra__async_stat(async, "f", 1, async_stat_cb, events));
+
+  /* Stat requests complete first, then the others in queue order. */
+  SVN_ERR(svn_ra__async_run(async, pool));
+  SVN_TEST_STRING_ASSERT(events->data,
+                         "stat:f:found stat:missing:missing stat:f:found "
+                         "file:f dir:1 log:1 log-done ");
+  SVN_TEST_STRING_ASSERT(contents->data, "hello\n");
+
+  /* The queue is empty after a run. */
+  svn_stringbuf_setempty(events);
+  SVN_ERR(svn_ra__async_run(async, pool));
+  SVN_TEST_STRING_ASSERT(events->data, "");
+
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_log_entry_receiver_t for commit_empty_last_change */
 static svn_error_t *
 AA_receiver(void *baton,
@@ -1716,6 +1981,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "verify checkout over a tunnel"),
     SVN_TEST_OPTS_PASS(commit_empty_last_change,
                        "check how last change applies to empty commit"),
+    SVN_TEST_OPTS_PASS(tunnel_stat_many,
+                       "stat many paths over a tunnel"),
+    SVN_TEST_OPTS_PASS(file_blame_test,
+                       "compute blame in the repository"),
+    SVN_TEST_OPTS_PASS(async_requests_test,
+                       "queue RA requests with completion callbacks"),
     SVN_TEST_NULL
   };
 
@@ -26,9 +26,11 @@
 
 #include "svn_pools.h"
 #include "svn_error.h"
+#include "svn_hash.h"
 #include "svn_fs.h"
 #include "svn_repos.h"
 #include "private/svn_repos_private.h"
+#include "private/svn_fspath.h"
 
 #include "../svn_test.h"
 #include "../svn_test_fs.h"
@@ -77,7 +79,7 @@ test_dump_bad_props(svn_stringbuf_t **dump_data_p,
 
   /* Test that a dump completes without error. */
   SVN_ERR(svn_repos_dump_fs4(repos, stream, start_rev, end_rev,
-                             FALSE, FALSE, TRUE, TRUE,
+                             FALSE, FALSE, TRUE, TRUE, NULL, NULL,
                              notify_func, notify_baton,
                              NULL, NULL,
                              pool));
@@ -120,13 +122,14 @@ test_load_bad_props(svn_stringbuf_t *dump_data,
   svn_revnum_t youngest_rev;
   svn_string_t *loaded_prop_val;
 
-  SVN_ERR(svn_repos_load_fs5(repos, stream,
+  SVN_ERR(svn_repos_load_fs6(repos, stream,
                              SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
                              svn_repos_load_uuid_default,
                              parent_fspath,
                              FALSE, FALSE, /*use_*_commit_hook*/
                              validate_props,
                              FALSE /*ignore_dates*/,
+                             FALSE /*pipelined*/,
                              notify_func, notify_baton,
                              NULL, NULL, /*cancellation*/
                              pool));
@@ -272,6 +275,343 @@ test_load_r0_mergeinfo(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Load DUMP_DATA into a new repository named NAME, with pipelining
+ * enabled as per PIPELINED, and return a full dump of the result in
+ * *RESULT_P.  Use OPTS and POOL as usual.
+ */
+static svn_error_t *
+load_and_dump(svn_stringbuf_t **result_p,
+              svn_stringbuf_t *dump_data,
+              const char *name,
+              svn_boolean_t pipelined,
+              const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_stream_t *stream;
+
+  SVN_ERR(svn_test__create_repos(&repos, name, opts, pool));
+
+  stream = svn_stream_from_stringbuf(dump_data, pool);
+  SVN_ERR(svn_repos_load_fs6(repos, stream,
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             svn_repos_load_uuid_default, NULL,
+                             FALSE, FALSE, /*use_*_commit_hook*/
+                             TRUE /*validate_props*/,
+                             FALSE /*ignore_dates*/,
+                             pipelined,
+                             NULL, NULL, NULL, NULL, pool));
+
+  *result_p = svn_stringbuf_create_empty(pool);
+  stream = svn_stream_from_stringbuf(*result_p, pool);
+  SVN_ERR(svn_repos_dump_fs4(repos, stream,
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, FALSE, TRUE, TRUE, NULL, NULL,
+                             NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_load_pipelined(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *dump_data = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *contents = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *sequential, *pipelined;
+  svn_stream_t *stream;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-load-pipelined",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2 .. r11: grow a file, change some properties and delete something.
+   * The file gets large enough to span several blocks in the pipeline. */
+  for (i = 0; i < 10; ++i)
+    {
+      int k;
+
+      for (k = 0; k < 20000; ++k)
+        svn_stringbuf_appendcstr(contents,
+                                 apr_psprintf(pool, "line %d.%d\n", i, k));
+
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", contents->data,
+                                          pool));
+      SVN_ERR(svn_fs_change_node_prop(txn_root, "A/B", "prop",
+                                      svn_string_createf(pool, "%d", i),
+                                      pool));
+      if (i == 5)
+        SVN_ERR(svn_fs_delete(txn_root, "A/D/H", pool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+    }
+
+  /* Dump with deltas, such that the loader has to decode them. */
+  stream = svn_stream_from_stringbuf(dump_data, pool);
+  SVN_ERR(svn_repos_dump_fs4(repos, stream,
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, TRUE, TRUE, TRUE, NULL, NULL,
+                             NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  /* Loading with and without pipelining must give the same result. */
+  SVN_ERR(load_and_dump(&sequential, dump_data,
+                        "test-repo-load-pipelined-1", FALSE, opts, pool));
+  SVN_ERR(load_and_dump(&pipelined, dump_data,
+                        "test-repo-load-pipelined-2", TRUE, opts, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(sequential, pipelined));
+
+  /* A truncated stream must be reported as an error. */
+  dump_data->len /= 2;
+  dump_data->data[dump_data->len] = '\0';
+  SVN_TEST_ASSERT_ANY_ERROR(load_and_dump(&pipelined, dump_data,
+                                          "test-repo-load-pipelined-3",
+                                          TRUE, opts, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_dump_segments(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  const char *repos_path = "test-repo-dump-segments";
+  const char *dir_path = "test-repo-dump-segments.d";
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  svn_repos_t *repos, *loaded;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *original, *reloaded;
+  svn_stream_t *stream;
+  apr_array_header_t *segments;
+  int i;
+
+  /* Use small shards, so we get several segments where supported. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FS_TYPE, opts->fs_type);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE, "4");
+  SVN_ERR(svn_io_remove_dir2(repos_path, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_io_remove_dir2(dir_path, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_repos_create(&repos, repos_path, NULL, NULL, NULL, fs_config,
+                           pool));
+  svn_test_add_dir_cleanup(repos_path);
+  svn_test_add_dir_cleanup(dir_path);
+  fs = svn_repos_fs(repos);
+
+  /* r1: the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2 .. r11: edits and copies from revisions in earlier segments. */
+  for (i = 0; i < 10; ++i)
+    {
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          apr_psprintf(pool, "%d\n", i),
+                                          pool));
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, 1, pool));
+      SVN_ERR(svn_fs_copy(rev_root, "A/B",
+                          txn_root, apr_psprintf(pool, "B%d", i), pool));
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+    }
+
+  SVN_ERR(svn_repos_dump_fs_segments(repos, dir_path,
+                                     SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                                     FALSE, TRUE, TRUE, TRUE, NULL, NULL, 3,
+                                     NULL, NULL, NULL, NULL, pool));
+
+  /* The manifest lists contiguous segments that cover all revisions. */
+  SVN_ERR(svn_repos__read_dump_manifest(&segments, dir_path, pool, pool));
+  SVN_TEST_ASSERT(segments->nelts >= 1);
+  if (strcmp(opts->fs_type, SVN_FS_TYPE_FSFS) == 0)
+    SVN_TEST_ASSERT(segments->nelts == 3);
+
+  /* Loading the segments must reproduce the original repository. */
+  SVN_ERR(svn_test__create_repos(&loaded, "test-repo-dump-segments-2",
+                                 opts, pool));
+  SVN_ERR(svn_repos_load_fs_segments(loaded, dir_path,
+                                     SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                                     svn_repos_load_uuid_default, NULL,
+                                     FALSE, FALSE, TRUE, FALSE, FALSE,
+                                     NULL, NULL, NULL, NULL, pool));
+
+  original = svn_stringbuf_create_empty(pool);
+  stream = svn_stream_from_stringbuf(original, pool);
+  SVN_ERR(svn_repos_dump_fs4(repos, stream,
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, FALSE, TRUE, TRUE, NULL, NULL,
+                             NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  reloaded = svn_stringbuf_create_empty(pool);
+  stream = svn_stream_from_stringbuf(reloaded, pool);
+  SVN_ERR(svn_repos_dump_fs4(loaded, stream,
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, FALSE, TRUE, TRUE, NULL, NULL,
+                             NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_TEST_ASSERT(svn_stringbuf_compare(original, reloaded));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for dump_filter. */
+typedef struct dump_filter_baton_t
+{
+  const char *prefix;
+  svn_boolean_t do_exclude;
+} dump_filter_baton_t;
+
+/* Implements svn_repos_dump_filter_func_t.  Include or exclude the
+ * prefix given in BATON.  When including, keep its parents as well. */
+static svn_error_t *
+dump_filter(svn_boolean_t *include,
+            svn_fs_root_t *root,
+            const char *path,
+            void *baton,
+            apr_pool_t *scratch_pool)
+{
+  dump_filter_baton_t *b = baton;
+
+  SVN_TEST_ASSERT(path[0] == '/');
+  if (b->do_exclude)
+    *include = !svn_fspath__skip_ancestor(b->prefix, path);
+  else
+    *include = svn_fspath__skip_ancestor(b->prefix, path)
+            || svn_fspath__skip_ancestor(path, b->prefix);
+
+  return SVN_NO_ERROR;
+}
+
+/* Dump REPOS non-incrementally into *DUMP_DATA, passing PREFIX and
+ * DO_EXCLUDE to dump_filter.  Use POOL for all allocations. */
+static svn_error_t *
+dump_filtered(svn_stringbuf_t **dump_data,
+              svn_repos_t *repos,
+              const char *prefix,
+              svn_boolean_t do_exclude,
+              apr_pool_t *pool)
+{
+  dump_filter_baton_t baton;
+  svn_stream_t *stream;
+
+  baton.prefix = prefix;
+  baton.do_exclude = do_exclude;
+
+  *dump_data = svn_stringbuf_create_empty(pool);
+  stream = svn_stream_from_stringbuf(*dump_data, pool);
+  SVN_ERR(svn_repos_dump_fs4(repos, stream,
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             FALSE, FALSE, TRUE, TRUE,
+                             dump_filter, &baton,
+                             NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_dump_filtered(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_repos_t *repos, *loaded;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *dump_data;
+  svn_stream_t *stream;
+  svn_node_kind_t kind;
+  svn_revnum_t copyfrom_rev;
+  const char *copyfrom_path;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-dump-filtered",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2: modify files inside and outside of A/B. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "iota", "new iota\n",
+                                      pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/lambda",
+                                      "new lambda\n", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r3: copy A/D into A/B. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, 1, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/D", txn_root, "A/B/D2", pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* Include A/B only.  The copy from A/D becomes a plain add. */
+  SVN_ERR(dump_filtered(&dump_data, repos, "/A/B", FALSE, pool));
+  SVN_TEST_ASSERT(strstr(dump_data->data, "Node-path: A\n"));
+  SVN_TEST_ASSERT(strstr(dump_data->data, "Node-path: A/B/lambda\n"));
+  SVN_TEST_ASSERT(strstr(dump_data->data, "Node-path: A/B/D2/G/pi\n"));
+  SVN_TEST_ASSERT(!strstr(dump_data->data, "Node-path: iota\n"));
+  SVN_TEST_ASSERT(!strstr(dump_data->data, "Node-path: A/mu\n"));
+  SVN_TEST_ASSERT(!strstr(dump_data->data, "Node-path: A/D\n"));
+  SVN_TEST_ASSERT(!strstr(dump_data->data, "Node-copyfrom-path"));
+
+  /* The result must be loadable. */
+  SVN_ERR(svn_test__create_repos(&loaded, "test-repo-dump-filtered-2",
+                                 opts, pool));
+  stream = svn_stream_from_stringbuf(dump_data, pool);
+  SVN_ERR(svn_repos_load_fs6(loaded, stream,
+                             SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
+                             svn_repos_load_uuid_default, NULL,
+                             FALSE, FALSE, TRUE, FALSE, FALSE,
+                             NULL, NULL, NULL, NULL, pool));
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, svn_repos_fs(loaded), pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, svn_repos_fs(loaded),
+                               youngest_rev, pool));
+  SVN_ERR(svn_fs_check_path(&kind, rev_root, "A/B/D2/G/pi", pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_fs_check_path(&kind, rev_root, "iota", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path, rev_root,
+                             "A/B/D2", pool));
+  SVN_TEST_ASSERT(copyfrom_path == NULL);
+
+  /* Exclude A/D.  Its copy still makes it into the dump. */
+  SVN_ERR(dump_filtered(&dump_data, repos, "/A/D", TRUE, pool));
+  SVN_TEST_ASSERT(strstr(dump_data->data, "Node-path: iota\n"));
+  SVN_TEST_ASSERT(strstr(dump_data->data, "Node-path: A/B/D2/G/pi\n"));
+  SVN_TEST_ASSERT(!strstr(dump_data->data, "Node-path: A/D\n"));
+  SVN_TEST_ASSERT(!strstr(dump_data->data, "Node-path: A/D/G/pi\n"));
+  SVN_TEST_ASSERT(!strstr(dump_data->data, "Node-copyfrom-path"));
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -283,6 +623,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test dumping with r0 mergeinfo"),
     SVN_TEST_OPTS_PASS(test_load_r0_mergeinfo,
                        "test loading with r0 mergeinfo"),
+    SVN_TEST_OPTS_PASS(test_load_pipelined,
+                       "test pipelined loading"),
+    SVN_TEST_OPTS_PASS(test_dump_segments,
+                       "test segmented dump and load"),
+    SVN_TEST_OPTS_PASS(test_dump_filtered,
+                       "test dumping with a path filter"),
     SVN_TEST_NULL
   };
 
@@ -24,6 +24,8 @@
 #include <string.h>
 
 #include <apr_pools.h>
+#include <apr_network_io.h>
+#include <apr_thread_proc.h>
 #include <apr_time.h>
 
 #include "../svn_test.h"
@@ -35,12 +37,14 @@
 #include "svn_repos.h"
 #include "svn_path.h"
 #include "svn_delta.h"
+#include "svn_diff.h"
 #include "svn_config.h"
 #include "svn_props.h"
 #include "svn_sorts.h"
 #include "svn_version.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_skel.h"
 
 /* be able to look into svn_config_t */
 #include "../../libsvn_subr/config_impl.h"
@@ -1501,6 +1505,54 @@ test_authz_wildcards(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Test complex wildcard patterns that share the same literal heads. */
+static svn_error_t *
+test_authz_complex_patterns(apr_pool_t *pool)
+{
+  svn_authz_t *authz_cfg;
+
+  const char *contents =
+    "[:glob:/A/team-*-docs]"                                                 NL
+    "plato = r"                                                              NL
+    ""                                                                       NL
+    "[:glob:/A/team-?]"                                                      NL
+    "plato = rw"                                                             NL
+    ""                                                                       NL
+    "[:glob:/A/tea*x]"                                                       NL
+    "plato = r"                                                              NL
+    ""                                                                       NL
+    "[:glob:/A/te[a-z]m]"                                                    NL
+    "plato = r"                                                              NL
+    ""                                                                       NL
+    "[:glob:/A/a\\*b?]"                                                      NL
+    "plato = r"                                                              NL
+    ""                                                                       NL
+    "[:glob:/A/*x?]"                                                         NL
+    "plato = rw"                                                             NL;
+
+  /* Definition of the paths to test and expected replies for each. */
+  struct check_access_tests test_set[] = {
+    { "/A/team-foo-docs", NULL, "plato", svn_authz_read, TRUE },
+    { "/A/team-foo-docs", NULL, "plato", svn_authz_write, FALSE },
+    { "/A/team-x", NULL, "plato", svn_authz_write, TRUE },
+    { "/A/team-yz", NULL, "plato", svn_authz_read, FALSE },
+    { "/A/teamx", NULL, "plato", svn_authz_read, TRUE },
+    { "/A/tebm", NULL, "plato", svn_authz_read, TRUE },
+    { "/A/te1m", NULL, "plato", svn_authz_read, FALSE },
+    { "/A/a*bc", NULL, "plato", svn_authz_read, TRUE },
+    { "/A/abc", NULL, "plato", svn_authz_read, FALSE },
+    { "/A/boxy", NULL, "plato", svn_authz_write, TRUE },
+    { "/B/team-x", NULL, "plato", svn_authz_read, FALSE },
+    /* Sentinel */
+    { NULL, NULL, NULL, svn_authz_none, FALSE }
+  };
+
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+  SVN_ERR(authz_check_access(authz_cfg, test_set, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Test the authz performance with wildcard rules. */
 static svn_error_t *
 test_authz_wildcard_performance(apr_pool_t *pool)
@@ -1725,6 +1777,94 @@ test_authz_recursive_override(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_authz_check_access_many(apr_pool_t *pool)
+{
+  svn_authz_t *authz_cfg;
+  apr_array_header_t *paths;
+  svn_boolean_t granted[16];
+  int i;
+
+  const char *contents =
+    "[:glob:/A]"                                                            NL
+    "plato = rw"                                                            NL
+    ""                                                                      NL
+    "[:glob:/A/B]"                                                          NL
+    "plato ="                                                               NL
+    ""                                                                      NL
+    "[:glob:/A/B/C]"                                                        NL
+    "plato = r"                                                             NL
+    ""                                                                      NL
+    "[:glob:/A/**/D]"                                                       NL
+    "plato ="                                                               NL
+    ""                                                                      NL
+    "[:glob:/X/Y]"                                                          NL
+    "* = r"                                                                 NL;
+
+  /* Sorted paths, with frequent jumps back to some ancestor level. */
+  const struct
+    {
+      const char *path;
+      svn_boolean_t expected;
+    } tests[] = {
+      { "/",          FALSE },
+      { "/A",         TRUE  },
+      { "/A/B",       FALSE },
+      { "/A/B/C",     TRUE  },
+      { "/A/B/C/D",   FALSE },
+      { "/A/B/C/D/E", FALSE },
+      { "/A/B/C/F",   TRUE  },
+      { "/A/B/F",     FALSE },
+      { "/A/D",       FALSE },
+      { "/A/G",       TRUE  },
+      { "/A/G/D",     FALSE },
+      { "/A/G/H",     TRUE  },
+      { "/X",         FALSE },
+      { "/X/Y/Z",     TRUE  },
+      { "/X/Y/Z/D",   TRUE  }
+    };
+
+  SVN_ERR(authz_get_handle(&authz_cfg, contents, FALSE, pool));
+
+  paths = apr_array_make(pool, 16, sizeof(const char *));
+  for (i = 0; i < (int)(sizeof(tests) / sizeof(tests[0])); ++i)
+    APR_ARRAY_PUSH(paths, const char *) = tests[i].path;
+
+  SVN_ERR(svn_repos__authz_check_access_many(granted, authz_cfg, NULL,
+                                             paths, "plato", svn_authz_read,
+                                             pool));
+  for (i = 0; i < paths->nelts; ++i)
+    if (granted[i] != tests[i].expected)
+      return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                               "Batch authz incorrectly %s read access "
+                               "to %s", granted[i] ? "grants" : "denies",
+                               tests[i].path);
+
+  /* Single lookups must give the same results in reverse order, i.e. with
+   * the lookup state left behind by deeper paths. */
+  for (i = paths->nelts - 1; i >= 0; --i)
+    {
+      svn_boolean_t access_granted;
+      SVN_ERR(svn_repos_authz_check_access(authz_cfg, NULL, tests[i].path,
+                                           "plato", svn_authz_read,
+                                           &access_granted, pool));
+      if (access_granted != tests[i].expected)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Authz incorrectly %s read access to %s",
+                                 access_granted ? "grants" : "denies",
+                                 tests[i].path);
+    }
+
+  /* Other users have only uniform, if any, access. */
+  SVN_ERR(svn_repos__authz_check_access_many(granted, authz_cfg, NULL,
+                                             paths, "socrates",
+                                             svn_authz_write, pool));
+  for (i = 0; i < paths->nelts; ++i)
+    SVN_TEST_ASSERT(!granted[i]);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_authz_pattern_tests(apr_pool_t *pool)
 {
@@ -3512,6 +3652,142 @@ get_logs(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Log receiver which appends the revision to the array BATON. */
+static svn_error_t *
+log_rev_receiver(void *baton,
+                 svn_log_entry_t *log_entry,
+                 apr_pool_t *pool)
+{
+  apr_array_header_t *revs = baton;
+
+  APR_ARRAY_PUSH(revs, svn_revnum_t) = log_entry->revision;
+  return SVN_NO_ERROR;
+}
+
+/* Check that the log of the comma-separated PATHS in REPOS from START to
+   END with LIMIT lists the comma-separated revisions EXPECTED. */
+static svn_error_t *
+check_multi_path_log(svn_repos_t *repos,
+                     const char *paths,
+                     svn_revnum_t start,
+                     svn_revnum_t end,
+                     int limit,
+                     const char *expected,
+                     apr_pool_t *pool)
+{
+  apr_array_header_t *revs = apr_array_make(pool, 8, sizeof(svn_revnum_t));
+  svn_stringbuf_t *actual = svn_stringbuf_create_empty(pool);
+  int i;
+
+  SVN_ERR(svn_repos_get_logs4(repos, svn_cstring_split(paths, ",", TRUE,
+                                                       pool),
+                              start, end, limit, FALSE, FALSE, FALSE,
+                              NULL, NULL, NULL, log_rev_receiver, revs,
+                              pool));
+
+  for (i = 0; i < revs->nelts; i++)
+    svn_stringbuf_appendcstr(actual,
+                             apr_psprintf(pool, i ? ",%ld" : "%ld",
+                                          APR_ARRAY_IDX(revs, i,
+                                                        svn_revnum_t)));
+
+  if (strcmp(actual->data, expected) != 0)
+    return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                             "Log of %s with start=%ld,end=%ld,limit=%d "
+                             "returned revisions '%s' (expected '%s')",
+                             paths, start, end, limit, actual->data,
+                             expected);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_logs_multiple_paths(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_test__create_repos(&repos,
+                                 "test-repo-get-logs-multiple-paths",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: Add the Greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* r2: Tweak A/mu and A/B/E/alpha. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "r2", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/E/alpha", "r2",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* r3: Tweak A/B/E/beta. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/E/beta", "r3",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* r4: Add A/new, so its history runs out here. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_make_file(txn_root, "A/new", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* r5: Tweak A/new and A/mu. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/new", "r5", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "r5", subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+
+  /* r6: Tweak A/B/E/alpha. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/B/E/alpha", "r6",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_INT_ASSERT(youngest_rev, 6);
+  svn_pool_clear(subpool);
+
+  /* Revisions changing several of the paths are reported only once. */
+  SVN_ERR(check_multi_path_log(repos, "/A/mu,/A/new,/A/B/E/alpha", 6, 1, 0,
+                               "6,5,4,2,1", subpool));
+  SVN_ERR(check_multi_path_log(repos, "/A/mu,/A/new,/A/B/E/alpha", 1, 6, 0,
+                               "1,2,4,5,6", subpool));
+
+  /* The history of A/new runs out before that of A/B/E/beta. */
+  SVN_ERR(check_multi_path_log(repos, "/A/new,/A/B/E/beta", 6, 1, 0,
+                               "5,4,3,1", subpool));
+  SVN_ERR(check_multi_path_log(repos, "/A/new,/A/B/E/beta", 1, 6, 0,
+                               "1,3,4,5", subpool));
+  SVN_ERR(check_multi_path_log(repos, "/A/new,/A/B/E/beta", 4, 2, 0,
+                               "4,3", subpool));
+
+  /* Limits stop the walk early, in either direction. */
+  SVN_ERR(check_multi_path_log(repos, "/A/mu,/A/new,/A/B/E/alpha", 6, 1, 3,
+                               "6,5,4", subpool));
+  SVN_ERR(check_multi_path_log(repos, "/A/mu,/A/new,/A/B/E/alpha", 1, 6, 2,
+                               "1,2", subpool));
+  SVN_ERR(check_multi_path_log(repos, "/A/new,/A/B/E/beta", 6, 1, 3,
+                               "5,4,3", subpool));
+  SVN_ERR(check_multi_path_log(repos, "/A/mu,/A/B/E/beta", 5, 1, 1,
+                               "5", subpool));
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
 
 /* Tests for svn_repos_get_file_revsN() */
 
@@ -3890,6 +4166,7 @@ test_config_pool(const svn_test_opts_t *opts,
   svn_error_t *err;
 
   svn_repos__config_pool_t *config_pool;
+  const char *cfg_path;
   apr_pool_t *subpool = svn_pool_create(pool);
 
   const char *wrk_dir = svn_test_data_path("config_pool", pool);
@@ -3988,6 +4265,32 @@ test_config_pool(const svn_test_opts_t *opts,
       svn_pool_clear(subpool);
     }
 
+  /* files that are old enough will be recognized by their timestamp.
+     Modifying them must still give us the new contents. */
+  cfg_path = svn_dirent_join(wrk_dir, "config-pool-test5.cfg", pool);
+  SVN_ERR(svn_io_write_atomic2(cfg_path, cfg_buffer1->data, cfg_buffer1->len,
+                               NULL, FALSE, pool));
+  SVN_ERR(svn_io_set_file_affected_time(apr_time_now()
+                                          - apr_time_from_sec(20),
+                                        cfg_path, pool));
+  for (i = 0; i < 2; ++i)
+    {
+      SVN_ERR(svn_repos__config_pool_get(&cfg, config_pool, cfg_path,
+                                         TRUE, NULL, subpool));
+      SVN_TEST_ASSERT(cfg->sections == sections1);
+      svn_pool_clear(subpool);
+    }
+
+  SVN_ERR(svn_io_write_atomic2(cfg_path, cfg_buffer2->data, cfg_buffer2->len,
+                               NULL, FALSE, pool));
+  SVN_ERR(svn_io_set_file_affected_time(apr_time_now()
+                                          - apr_time_from_sec(10),
+                                        cfg_path, pool));
+  SVN_ERR(svn_repos__config_pool_get(&cfg, config_pool, cfg_path,
+                                     TRUE, NULL, subpool));
+  SVN_TEST_ASSERT(cfg->sections == sections2);
+  svn_pool_clear(subpool);
+
   /* create an in-repo config */
   SVN_ERR(svn_dirent_get_absolute(&repo_root_url, repo_name, pool));
   SVN_ERR(svn_uri_get_file_url_from_dirent(&repo_root_url, repo_root_url,
@@ -4466,10 +4769,805 @@ test_list(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Test that the reporter sends the same edits with delta prefetching,
+   with and without sending fulltexts for added files. */
+static svn_error_t *
+test_report_prefetch(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_revnum_t start_rev;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-report-prefetch",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  svn_pool_clear(subpool);
+
+  /* r2: modify, add and delete files in several directories. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  {
+    static svn_test__txn_script_command_t script_entries[] = {
+      { 'e', "iota",      "Changed file 'iota'.\n" },
+      { 'e', "A/D/G/pi",  "Changed file 'pi'.\n" },
+      { 'e', "A/D/G/rho", "Changed file 'rho'.\n" },
+      { 'e', "A/mu",      "Changed file 'mu'.\n" },
+      { 'a', "A/D/foo",   "New file 'foo'.\n" },
+      { 'a', "A/B/bar",   "New file 'bar'.\n" },
+      { 'd', "A/D/H",     NULL },
+      { 'd', "A/B/E/beta", NULL }
+    };
+    SVN_ERR(svn_test__txn_script_exec(txn_root,
+                                      script_entries,
+                                      sizeof(script_entries)/
+                                       sizeof(script_entries[0]),
+                                      subpool));
+  }
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  svn_pool_clear(subpool);
+
+  /* Update from r1 to r2, then "check out" r2 into an empty tree. */
+  for (i = 0; i < 4; ++i)
+    {
+      start_rev = 1 - i % 2;
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, start_rev, subpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+      SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                                   txn_root, "", subpool));
+
+      SVN_ERR(svn_repos_begin_report3(&report_baton, youngest_rev, repos,
+                                      "/", "", NULL, TRUE,
+                                      svn_depth_infinity, FALSE, FALSE,
+                                      editor, edit_baton, NULL, NULL, 0,
+                                      subpool));
+      svn_repos__report_set_prefetch_jobs(report_baton, 4);
+      svn_repos__report_set_send_fulltexts(report_baton, i >= 2);
+      SVN_ERR(svn_repos_set_path3(report_baton, "", start_rev,
+                                  svn_depth_infinity, start_rev == 0,
+                                  NULL, subpool));
+      SVN_ERR(svn_repos_finish_report(report_baton, subpool));
+
+      /* The result must match r2 exactly. */
+      {
+        static svn_test__tree_entry_t entries[] = {
+          { "iota",        "Changed file 'iota'.\n" },
+          { "A",           0 },
+          { "A/mu",        "Changed file 'mu'.\n" },
+          { "A/B",         0 },
+          { "A/B/bar",     "New file 'bar'.\n" },
+          { "A/B/lambda",  "This is the file 'lambda'.\n" },
+          { "A/B/E",       0 },
+          { "A/B/E/alpha", "This is the file 'alpha'.\n" },
+          { "A/B/F",       0 },
+          { "A/C",         0 },
+          { "A/D",         0 },
+          { "A/D/foo",     "New file 'foo'.\n" },
+          { "A/D/gamma",   "This is the file 'gamma'.\n" },
+          { "A/D/G",       0 },
+          { "A/D/G/pi",    "Changed file 'pi'.\n" },
+          { "A/D/G/rho",   "Changed file 'rho'.\n" },
+          { "A/D/G/tau",   "This is the file 'tau'.\n" },
+        };
+        SVN_ERR(svn_test__validate_tree(txn_root,
+                                        entries,
+                                        sizeof(entries)/sizeof(entries[0]),
+                                        subpool));
+      }
+
+      SVN_ERR(svn_fs_abort_txn(txn, subpool));
+      svn_pool_clear(subpool);
+    }
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_report_out_of_order(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  const svn_delta_editor_t *editor;
+  void *edit_baton, *report_baton;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-report-out-of-order",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: the greek tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
+  svn_pool_clear(subpool);
+
+  /* Our "working copy" misses a few nodes. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/D/G/pi", subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/B/E", subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "iota", subpool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/B/lambda", subpool));
+  SVN_ERR(dir_delta_get_editor(&editor, &edit_baton, fs,
+                               txn_root, "", subpool));
+
+  /* Report them in no particular order, followed by enough bogus
+     entries, in reverse order, to make the reporter spill to disk. */
+  SVN_ERR(svn_repos_begin_report3(&report_baton, youngest_rev, repos,
+                                  "/", "", NULL, TRUE,
+                                  svn_depth_infinity, FALSE, FALSE,
+                                  editor, edit_baton, NULL, NULL, 0,
+                                  subpool));
+  SVN_ERR(svn_repos_set_path3(report_baton, "", youngest_rev,
+                              svn_depth_infinity, FALSE, NULL, subpool));
+  SVN_ERR(svn_repos_delete_path(report_baton, "A/D/G/pi", subpool));
+  SVN_ERR(svn_repos_delete_path(report_baton, "A/B/E", subpool));
+  SVN_ERR(svn_repos_delete_path(report_baton, "iota", subpool));
+  SVN_ERR(svn_repos_delete_path(report_baton, "A/B/lambda", subpool));
+  for (i = 99999; i >= 0; --i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_repos_delete_path(report_baton,
+                                    apr_psprintf(iterpool, "A/C/x%05d", i),
+                                    iterpool));
+    }
+  SVN_ERR(svn_repos_finish_report(report_baton, subpool));
+
+  /* The result must match r1 exactly. */
+  {
+    static svn_test__tree_entry_t entries[] = {
+      { "iota",        "This is the file 'iota'.\n" },
+      { "A",           0 },
+      { "A/mu",        "This is the file 'mu'.\n" },
+      { "A/B",         0 },
+      { "A/B/lambda",  "This is the file 'lambda'.\n" },
+      { "A/B/E",       0 },
+      { "A/B/E/alpha", "This is the file 'alpha'.\n" },
+      { "A/B/E/beta",  "This is the file 'beta'.\n" },
+      { "A/B/F",       0 },
+      { "A/C",         0 },
+      { "A/D",         0 },
+      { "A/D/gamma",   "This is the file 'gamma'.\n" },
+      { "A/D/G",       0 },
+      { "A/D/G/pi",    "This is the file 'pi'.\n" },
+      { "A/D/G/rho",   "This is the file 'rho'.\n" },
+      { "A/D/G/tau",   "This is the file 'tau'.\n" },
+      { "A/D/H",       0 },
+      { "A/D/H/chi",   "This is the file 'chi'.\n" },
+      { "A/D/H/psi",   "This is the file 'psi'.\n" },
+      { "A/D/H/omega", "This is the file 'omega'.\n" }
+    };
+    SVN_ERR(svn_test__validate_tree(txn_root,
+                                    entries,
+                                    sizeof(entries)/sizeof(entries[0]),
+                                    subpool));
+  }
+
+  SVN_ERR(svn_fs_abort_txn(txn, subpool));
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
 
+/* Implements svn_repos__blame_receiver_t for test_file_blame_cache. */
+static svn_error_t *
+blame_chunk_receiver(void *baton,
+                     apr_int64_t start_line,
+                     svn_revnum_t revision,
+                     apr_hash_t *rev_props,
+                     apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *chunks = baton;
+
+  /* Cached and computed chunks must both come with their revprops. */
+  if (SVN_IS_VALID_REVNUM(revision)
+      && !svn_hash_gets(rev_props, SVN_PROP_REVISION_DATE))
+    return svn_error_create(SVN_ERR_TEST_FAILED, NULL,
+                            "Missing revision properties");
+
+  svn_stringbuf_appendcstr(chunks,
+                           apr_psprintf(scratch_pool, "%d:%ld ",
+                                        (int)start_line, revision));
+  return SVN_NO_ERROR;
+}
+
+/* Set *CHUNKS to the blame of "f" in REPOS from 1 to END, as reported by
+   svn_repos__get_file_blame() with the blame cache set to USE_CACHE. */
+static svn_error_t *
+get_blame_chunks(const char **chunks,
+                 svn_repos_t *repos,
+                 svn_revnum_t end,
+                 svn_boolean_t use_cache,
+                 apr_pool_t *pool)
+{
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
+
+  SVN_ERR(svn_repos__get_file_blame(repos, "/f", 1, end,
+                                    svn_diff_file_options_create(pool),
+                                    NULL, NULL, use_cache,
+                                    blame_chunk_receiver, buf,
+                                    NULL, NULL, pool));
+  *chunks = buf->data;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_file_blame_cache(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  const char *chunks;
+  apr_pool_t *subpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-file-blame-cache",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: add f. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_fs_make_file(txn_root, "f", subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "f", "a\nb\nc\n",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* r2: change the middle line. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "f", "a\nB\nc\n",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  SVN_ERR(get_blame_chunks(&chunks, repos, 2, FALSE, pool));
+  SVN_TEST_STRING_ASSERT(chunks, "0:1 1:2 2:1 ");
+
+  /* Fill the cache, then read from it. */
+  SVN_ERR(get_blame_chunks(&chunks, repos, 2, TRUE, pool));
+  SVN_TEST_STRING_ASSERT(chunks, "0:1 1:2 2:1 ");
+  SVN_ERR(get_blame_chunks(&chunks, repos, 2, TRUE, pool));
+  SVN_TEST_STRING_ASSERT(chunks, "0:1 1:2 2:1 ");
+
+  /* r3: append a line. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, subpool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, subpool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "f", "a\nB\nc\nd\n",
+                                      subpool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, subpool));
+  svn_pool_clear(subpool);
+
+  /* Continuing from the cached blame of r2 must give the same result as
+     computing it from scratch. */
+  SVN_ERR(get_blame_chunks(&chunks, repos, 3, TRUE, pool));
+  SVN_TEST_STRING_ASSERT(chunks, "0:1 1:2 2:1 3:3 4:1 ");
+  SVN_ERR(get_blame_chunks(&chunks, repos, 3, FALSE, pool));
+  SVN_TEST_STRING_ASSERT(chunks, "0:1 1:2 2:1 3:3 4:1 ");
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Commit a revision to REPOS that sets PATH to CONTENTS, with log
+   message LOG. */
+static svn_error_t *
+commit_with_log(svn_repos_t *repos,
+                const char *path,
+                const char *contents,
+                const char *log,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev;
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, fs, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, youngest_rev, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_check_path(&kind, txn_root, path, pool));
+  if (kind == svn_node_none)
+    SVN_ERR(svn_fs_make_file(txn_root, path, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, path, contents, pool));
+  SVN_ERR(svn_fs_change_txn_prop(txn, SVN_PROP_REVISION_LOG,
+                                 svn_string_create(log, pool), pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_log_entry_receiver_t, appending the revision
+   number to the svn_stringbuf_t * BATON. */
+static svn_error_t *
+search_revision_receiver(void *baton,
+                         svn_repos_log_entry_t *log_entry,
+                         apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *revs = baton;
+
+  svn_stringbuf_appendcstr(revs, apr_psprintf(scratch_pool, "%ld ",
+                                              log_entry->revision));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_path_change_receiver_t, doing nothing. */
+static svn_error_t *
+search_path_change_receiver(void *baton,
+                            svn_repos_path_change_t *change,
+                            apr_pool_t *scratch_pool)
+{
+  return SVN_NO_ERROR;
+}
+
+/* Set *REVS to the revisions from START to END in REPOS that
+   svn_repos__get_logs_search() reports for SEARCH, in which '|' separates
+   groups and ' ' separates the patterns within a group. */
+static svn_error_t *
+get_searched_logs(const char **revs,
+                  svn_repos_t *repos,
+                  svn_revnum_t start,
+                  svn_revnum_t end,
+                  int limit,
+                  svn_boolean_t changed_paths,
+                  const char *search,
+                  apr_pool_t *pool)
+{
+  apr_array_header_t *groups = svn_cstring_split(search, "|", TRUE, pool);
+  apr_array_header_t *search_patterns
+    = apr_array_make(pool, groups->nelts, sizeof(apr_array_header_t *));
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  int i;
+
+  for (i = 0; i < groups->nelts; i++)
+    APR_ARRAY_PUSH(search_patterns, apr_array_header_t *)
+      = svn_cstring_split(APR_ARRAY_IDX(groups, i, const char *), " ",
+                          TRUE, pool);
+
+  SVN_ERR(svn_repos__get_logs_search(repos, NULL, start, end, limit,
+                                     FALSE, NULL, search_patterns,
+                                     NULL, NULL,
+                                     changed_paths
+                                       ? search_path_change_receiver
+                                       : NULL,
+                                     NULL,
+                                     search_revision_receiver, result,
+                                     pool));
+  *revs = result->data;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_get_logs_search(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  const char *revs;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-get-logs-search",
+                                 opts, pool));
+
+  SVN_ERR(commit_with_log(repos, "alpha", "a\n", "Initial import", pool));
+  SVN_ERR(commit_with_log(repos, "beta", "b\n", "Fix a BUG in beta", pool));
+  SVN_ERR(commit_with_log(repos, "alpha", "A\n", "Tweak", pool));
+
+  /* Log messages are matched case-insensitively. */
+  SVN_ERR(get_searched_logs(&revs, repos, 3, 1, 0, FALSE, "bug", pool));
+  SVN_TEST_STRING_ASSERT(revs, "2 ");
+  SVN_ERR(get_searched_logs(&revs, repos, 1, 3, 0, FALSE, "init*port", pool));
+  SVN_TEST_STRING_ASSERT(revs, "1 ");
+
+  /* Changed paths are only matched when they are requested. */
+  SVN_ERR(get_searched_logs(&revs, repos, 3, 1, 0, FALSE, "alpha", pool));
+  SVN_TEST_STRING_ASSERT(revs, "");
+  SVN_ERR(get_searched_logs(&revs, repos, 3, 1, 0, TRUE, "alpha", pool));
+  SVN_TEST_STRING_ASSERT(revs, "3 1 ");
+
+  /* All patterns within a group must match, any group may match. */
+  SVN_ERR(get_searched_logs(&revs, repos, 3, 1, 0, FALSE, "tweak bug",
+                            pool));
+  SVN_TEST_STRING_ASSERT(revs, "");
+  SVN_ERR(get_searched_logs(&revs, repos, 3, 1, 0, FALSE, "tweak|bug",
+                            pool));
+  SVN_TEST_STRING_ASSERT(revs, "3 2 ");
+
+  /* The limit counts the revisions examined, not the matching ones. */
+  SVN_ERR(get_searched_logs(&revs, repos, 3, 1, 1, FALSE, "bug", pool));
+  SVN_TEST_STRING_ASSERT(revs, "");
+  SVN_ERR(get_searched_logs(&revs, repos, 3, 1, 2, FALSE, "bug", pool));
+  SVN_TEST_STRING_ASSERT(revs, "2 ");
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS && defined(APR_UNIX)
+
+/* Data of the hook server thread of test_hook_server. */
+typedef struct hook_server_baton_t
+{
+  /* Socket to accept a single connection from. */
+  apr_socket_t *listener;
+
+  /* The request received, allocated in POOL. */
+  svn_stringbuf_t *request;
+  apr_pool_t *pool;
+
+  /* Error returned by the thread, if any. */
+  svn_error_t *err;
+} hook_server_baton_t;
+
+/* Accept a single hook request on BATON->LISTENER, record it and reject
+   the hook with exit code 1 and "denied by server" on stderr. */
+static svn_error_t *
+hook_server_worker(hook_server_baton_t *baton)
+{
+  apr_socket_t *conn;
+  apr_status_t status;
+  svn_skel_t *response;
+  svn_stringbuf_t *buf;
+  apr_size_t len;
+
+  status = apr_socket_accept(&conn, baton->listener, baton->pool);
+  if (status)
+    return svn_error_wrap_apr(status, "Can't accept connection");
+
+  baton->request = svn_stringbuf_create_empty(baton->pool);
+  do
+    {
+      char chunk[1024];
+
+      len = sizeof(chunk);
+      status = apr_socket_recv(conn, chunk, &len);
+      svn_stringbuf_appendbytes(baton->request, chunk, len);
+    }
+  while (!status);
+  if (!APR_STATUS_IS_EOF(status))
+    return svn_error_wrap_apr(status, "Can't read request");
+
+  response = svn_skel__make_empty_list(baton->pool);
+  svn_skel__append(response, svn_skel__str_atom("1", baton->pool));
+  svn_skel__append(response, svn_skel__str_atom("", baton->pool));
+  svn_skel__append(response, svn_skel__str_atom("denied by server",
+                                                baton->pool));
+  buf = svn_skel__unparse(response, baton->pool);
+
+  len = buf->len;
+  status = apr_socket_send(conn, buf->data, &len);
+  apr_socket_close(conn);
+  if (status || len != buf->len)
+    return svn_error_wrap_apr(status, "Can't send response");
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread entry point for hook_server_worker.  DATA is the
+   hook_server_baton_t. */
+static void * APR_THREAD_FUNC
+hook_server_thread(apr_thread_t *thread,
+                   void *data)
+{
+  hook_server_baton_t *baton = data;
+
+  baton->err = hook_server_worker(baton);
+  apr_thread_exit(thread, APR_SUCCESS);
+
+  return NULL;
+}
+
+/* Try to commit a new directory PATH to REPOS and set *ERR to the
+   result. */
+static svn_error_t *
+try_commit_dir(svn_error_t **err,
+               svn_repos_t *repos,
+               const char *path,
+               apr_pool_t *pool)
+{
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  const char *conflict;
+
+  SVN_ERR(svn_fs_youngest_rev(&rev, svn_repos_fs(repos), pool));
+  SVN_ERR(svn_repos_fs_begin_txn_for_commit2(&txn, repos, rev,
+                                             apr_hash_make(pool), pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, path, pool));
+  *err = svn_repos_fs_commit_txn(&conflict, repos, &rev, txn, pool);
+
+  return SVN_NO_ERROR;
+}
+
+#endif
+
+static svn_error_t *
+test_hook_server(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+#if APR_HAS_THREADS && defined(APR_UNIX)
+  svn_repos_t *repos;
+  const char *hook;
+  const char *socket_path = "test-repo-hook-server.sock";
+  apr_sockaddr_t *sa;
+  apr_socket_t *listener;
+  apr_thread_t *thread;
+  apr_status_t status, retval;
+  hook_server_baton_t baton;
+  svn_skel_t *request;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-hook-server", opts,
+                                 pool));
+  SVN_ERR(svn_repos_hooks_setenv(repos, NULL, pool));
+
+  /* An accepting pre-commit hook. */
+  hook = svn_repos_pre_commit_hook(repos, pool);
+  SVN_ERR(svn_io_file_create(hook,
+                             "#!/bin/sh" APR_EOL_STR "exit 0" APR_EOL_STR,
+                             pool));
+  SVN_ERR(svn_io_set_file_executable(hook, TRUE, FALSE, pool));
+
+  SVN_ERR(svn_io_file_create(svn_dirent_join(svn_repos_conf_dir(repos, pool),
+                                             "hooks-env", pool),
+                             "[hook-server]" NL
+                             "socket = test-repo-hook-server.sock" NL,
+                             pool));
+
+  /* Without a server listening, the hook gets started as usual. */
+  SVN_ERR(svn_io_remove_file2(socket_path, TRUE, pool));
+  SVN_ERR(try_commit_dir(&err, repos, "A", pool));
+  SVN_ERR(err);
+
+  /* With a server, it decides and gets the hook's arguments. */
+  status = apr_sockaddr_info_get(&sa, socket_path, APR_UNIX, 0, 0, pool);
+  if (!status)
+    status = apr_socket_create(&listener, APR_UNIX, SOCK_STREAM, 0, pool);
+  if (!status)
+    status = apr_socket_bind(listener, sa);
+  if (!status)
+    status = apr_socket_listen(listener, 1);
+  if (status)
+    return svn_error_wrap_apr(status, "Can't listen on '%s'", socket_path);
+
+  baton.listener = listener;
+  baton.request = NULL;
+  baton.pool = svn_pool_create(NULL);
+  baton.err = SVN_NO_ERROR;
+  status = apr_thread_create(&thread, NULL, hook_server_thread, &baton,
+                             pool);
+  if (status)
+    return svn_error_wrap_apr(status, "Can't create thread");
+
+  SVN_ERR(try_commit_dir(&err, repos, "B", pool));
+
+  status = apr_thread_join(&retval, thread);
+  apr_socket_close(listener);
+  SVN_ERR(svn_io_remove_file2(socket_path, TRUE, pool));
+  if (status)
+    return svn_error_wrap_apr(status, "Can't join thread");
+  SVN_ERR(baton.err);
+
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_REPOS_HOOK_FAILURE);
+
+  request = svn_skel__parse(baton.request->data, baton.request->len, pool);
+  SVN_TEST_ASSERT(request && svn_skel__list_length(request) == 5);
+  SVN_TEST_ASSERT(svn_skel__matches_atom(request->children, "pre-commit"));
+  SVN_TEST_ASSERT(svn_skel__matches_atom(request->children->next, hook));
+  SVN_TEST_ASSERT(svn_skel__list_length(request->children->next->next)
+                  == 2);
+
+  svn_pool_destroy(baton.pool);
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "hook servers need threads and Unix sockets");
+#endif
+}
+
+static svn_error_t *
+test_repos_pool(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  const char *repo_name = "test-repo-repos-pool";
+  svn_repos_t *repos, *repos1, *repos2, *repos3;
+  svn_repos__repos_pool_t *repos_pool;
+  svn_fs_access_t *access;
+  apr_pool_t *subpool1 = svn_pool_create(pool);
+  apr_pool_t *subpool2 = svn_pool_create(pool);
+
+  SVN_ERR(svn_test__create_repos(&repos, repo_name, opts, pool));
+  SVN_ERR(svn_repos__repos_pool_create(&repos_pool, TRUE, pool));
+
+  /* Concurrent users get different instances. */
+  SVN_ERR(svn_repos__repos_pool_get(&repos1, repos_pool, repo_name, NULL,
+                                    subpool1, pool));
+  SVN_ERR(svn_repos__repos_pool_get(&repos2, repos_pool, repo_name, NULL,
+                                    subpool2, pool));
+  SVN_TEST_ASSERT(repos1 != repos2);
+  SVN_TEST_STRING_ASSERT(svn_repos_path(repos1, pool),
+                         svn_repos_path(repos2, pool));
+
+  /* Released instances get reused. */
+  SVN_ERR(svn_fs_create_access(&access, "jrandom", subpool1));
+  SVN_ERR(svn_fs_set_access(svn_repos_fs(repos1), access));
+  svn_pool_clear(subpool1);
+  SVN_ERR(svn_repos__repos_pool_get(&repos3, repos_pool, repo_name, NULL,
+                                    subpool1, pool));
+  SVN_TEST_ASSERT(repos3 == repos1);
+
+  /* The previous user's access context must be gone. */
+  SVN_ERR(svn_fs_get_access(&access, svn_repos_fs(repos3)));
+  SVN_TEST_ASSERT(access == NULL);
+
+  svn_pool_destroy(subpool1);
+  svn_pool_destroy(subpool2);
+
+  return SVN_NO_ERROR;
+}
+
+/* Commit a new revision adding directory PATH to REPOS. */
+static svn_error_t *
+commit_mkdir(svn_repos_t *repos,
+             const char *path,
+             apr_pool_t *pool)
+{
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  const char *conflict;
+  svn_revnum_t new_rev, youngest_rev;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest_rev, svn_repos_fs(repos), pool));
+  SVN_ERR(svn_repos_fs_begin_txn_for_commit2(&txn, repos, youngest_rev,
+                                             apr_hash_make(pool), pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, path, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(&conflict, repos, &new_rev, txn, pool));
+  SVN_TEST_ASSERT(new_rev == youngest_rev + 1);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_post_commit_queue(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+#ifndef WIN32
+  svn_repos_t *repos;
+  const char *hook, *log_path, *queue_path;
+  apr_hash_t *dirents;
+  svn_stringbuf_t *log;
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-post-commit-queue",
+                                 opts, pool));
+  SVN_ERR(svn_dirent_get_absolute(&log_path,
+                                  "test-repo-post-commit-queue.log", pool));
+  SVN_ERR(svn_io_remove_file2(log_path, TRUE, pool));
+  queue_path = svn_dirent_join(svn_repos_path(repos, pool),
+                               "post-commit-queue", pool);
+
+  /* A post-commit hook that logs the revisions it gets run for. */
+  hook = svn_repos_post_commit_hook(repos, pool);
+  SVN_ERR(svn_io_file_create(hook,
+                             apr_psprintf(pool,
+                                          "#!/bin/sh" APR_EOL_STR
+                                          "echo $2 >> '%s'" APR_EOL_STR,
+                                          log_path),
+                             pool));
+  SVN_ERR(svn_io_set_file_executable(hook, TRUE, FALSE, pool));
+
+  /* Queued hooks don't run during the commit. */
+  svn_repos__set_async_post_commit(repos, TRUE);
+  SVN_ERR(commit_mkdir(repos, "/A", pool));
+  SVN_ERR(commit_mkdir(repos, "/B", pool));
+
+  SVN_ERR(svn_io_check_path(log_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_io_get_dirents3(&dirents, queue_path, TRUE, pool, pool));
+  SVN_TEST_ASSERT(svn_hash_gets(dirents, "1"));
+  SVN_TEST_ASSERT(svn_hash_gets(dirents, "2"));
+
+  /* Running the queue runs them in order and empties it. */
+  SVN_ERR(svn_repos__run_post_commit_queue(repos, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&log, log_path, pool));
+  SVN_TEST_STRING_ASSERT(log->data, "1" APR_EOL_STR "2" APR_EOL_STR);
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, queue_path, TRUE, pool, pool));
+  SVN_TEST_ASSERT(!svn_hash_gets(dirents, "1"));
+  SVN_TEST_ASSERT(!svn_hash_gets(dirents, "2"));
+
+  /* Without the option, the hook runs right away again. */
+  svn_repos__set_async_post_commit(repos, FALSE);
+  SVN_ERR(commit_mkdir(repos, "/C", pool));
+  SVN_ERR(svn_stringbuf_from_file2(&log, log_path, pool));
+  SVN_TEST_STRING_ASSERT(log->data,
+                         "1" APR_EOL_STR "2" APR_EOL_STR "3" APR_EOL_STR);
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "this test uses a shell script hook");
+#endif
+}
+
+static svn_error_t *
+test_dav_uri_revision(apr_pool_t *pool)
+{
+  /* Revision-specific resources. */
+  SVN_TEST_ASSERT(svn_repos__dav_uri_revision("/!svn/rev/5", "!svn") == 5);
+  SVN_TEST_ASSERT(svn_repos__dav_uri_revision("/!svn/rvr/12/trunk/a",
+                                              "!svn") == 12);
+  SVN_TEST_ASSERT(svn_repos__dav_uri_revision("/!svn/ver/0/trunk",
+                                              "!svn") == 0);
+  SVN_TEST_ASSERT(svn_repos__dav_uri_revision("/!svn/bc/7/", "!svn") == 7);
+  SVN_TEST_ASSERT(svn_repos__dav_uri_revision("/!svn/bln/3", "!svn") == 3);
+  SVN_TEST_ASSERT(svn_repos__dav_uri_revision("/special/rev/42",
+                                              "special") == 42);
+
+  /* Anything else does not address a revision. */
+  SVN_TEST_ASSERT(!SVN_IS_VALID_REVNUM(
+                     svn_repos__dav_uri_revision("/trunk/a", "!svn")));
+  SVN_TEST_ASSERT(!SVN_IS_VALID_REVNUM(
+                     svn_repos__dav_uri_revision("/!svn/me", "!svn")));
+  SVN_TEST_ASSERT(!SVN_IS_VALID_REVNUM(
+                     svn_repos__dav_uri_revision("/!svn/txn/5-1", "!svn")));
+  SVN_TEST_ASSERT(!SVN_IS_VALID_REVNUM(
+                     svn_repos__dav_uri_revision("/!svn/rev/", "!svn")));
+  SVN_TEST_ASSERT(!SVN_IS_VALID_REVNUM(
+                     svn_repos__dav_uri_revision("/!svn/rev/5x", "!svn")));
+  SVN_TEST_ASSERT(!SVN_IS_VALID_REVNUM(
+                     svn_repos__dav_uri_revision("/!svn/rev/-1", "!svn")));
+  SVN_TEST_ASSERT(!SVN_IS_VALID_REVNUM(
+                     svn_repos__dav_uri_revision("/!svn/revs/5", "!svn")));
+  SVN_TEST_ASSERT(!SVN_IS_VALID_REVNUM(
+                     svn_repos__dav_uri_revision("/!svnx/rev/5", "!svn")));
+  SVN_TEST_ASSERT(!SVN_IS_VALID_REVNUM(
+                     svn_repos__dav_uri_revision("!svn/rev/5", "!svn")));
+  SVN_TEST_ASSERT(!SVN_IS_VALID_REVNUM(
+                     svn_repos__dav_uri_revision("/!svn/rev/5", "special")));
+
+  return SVN_NO_ERROR;
+}
+
 static struct svn_test_descriptor_t test_funcs[] =
   {
     SVN_TEST_NULL,
@@ -4505,6 +5603,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test if revprops are validated by repos"),
     SVN_TEST_OPTS_PASS(get_logs,
                        "test svn_repos_get_logs ranges and limits"),
+    SVN_TEST_OPTS_PASS(get_logs_multiple_paths,
+                       "test svn_repos_get_logs with several paths"),
     SVN_TEST_OPTS_PASS(test_get_file_revs,
                        "test svn_repos_get_file_revsN"),
     SVN_TEST_OPTS_PASS(issue_4060,
@@ -4531,12 +5631,32 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test recursively authz rule override"),
     SVN_TEST_PASS2(test_authz_pattern_tests,
                    "test various basic authz pattern combinations"),
+    SVN_TEST_PASS2(test_authz_check_access_many,
+                   "test authz checks for many paths at once"),
     SVN_TEST_PASS2(test_authz_wildcards,
                    "test the different types of authz wildcards"),
+    SVN_TEST_PASS2(test_authz_complex_patterns,
+                   "test authz patterns with common literal heads"),
     SVN_TEST_SKIP2(test_authz_wildcard_performance, TRUE,
                    "optional authz wildcard performance test"),
     SVN_TEST_OPTS_PASS(test_list,
                        "test svn_repos_list"),
+    SVN_TEST_OPTS_PASS(test_report_prefetch,
+                       "test reporter with text delta prefetching"),
+    SVN_TEST_OPTS_PASS(test_report_out_of_order,
+                       "test reporter with unsorted, spilled reports"),
+    SVN_TEST_OPTS_PASS(test_file_blame_cache,
+                       "test incremental blame from the blame cache"),
+    SVN_TEST_OPTS_PASS(test_get_logs_search,
+                       "test svn_repos__get_logs_search"),
+    SVN_TEST_OPTS_PASS(test_hook_server,
+                       "test running hooks through a hook server"),
+    SVN_TEST_OPTS_PASS(test_repos_pool,
+                       "test reusing repositories from the repos pool"),
+    SVN_TEST_OPTS_PASS(test_post_commit_queue,
+                       "test the asynchronous post-commit queue"),
+    SVN_TEST_PASS2(test_dav_uri_revision,
+                   "test parsing revisions from DAV URIs"),
     SVN_TEST_NULL
   };
 
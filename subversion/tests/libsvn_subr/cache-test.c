@@ -26,10 +26,13 @@
 #include <apr_general.h>
 #include <apr_lib.h>
 #include <apr_time.h>
+#include <apr_thread_proc.h>
 
 #include "svn_pools.h"
+#include "svn_dirent_uri.h"
 
 #include "private/svn_cache.h"
+#include "private/svn_subr_private.h"
 #include "svn_private_config.h"
 
 #include "../svn_test.h"
@@ -175,6 +178,38 @@ test_inprocess_cache_basic(apr_pool_t *pool)
   return basic_cache_test(cache, TRUE, pool);
 }
 
+static svn_error_t *
+test_inprocess_cache_eviction(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_revnum_t one = 1, two = 2, three = 3, *answer;
+  svn_boolean_t found;
+
+  /* Two pages with one entry each. */
+  SVN_ERR(svn_cache__create_inprocess(&cache,
+                                      serialize_revnum,
+                                      deserialize_revnum,
+                                      APR_HASH_KEY_STRING,
+                                      2, 1, TRUE, "", pool));
+
+  SVN_ERR(svn_cache__set(cache, "one", &one, pool));
+  SVN_ERR(svn_cache__set(cache, "two", &two, pool));
+
+  /* Reading "one" must protect it from being evicted next. */
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "one", pool));
+  SVN_TEST_ASSERT(found && *answer == 1);
+
+  SVN_ERR(svn_cache__set(cache, "three", &three, pool));
+  SVN_ERR(svn_cache__has_key(&found, cache, "one", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_ERR(svn_cache__has_key(&found, cache, "two", pool));
+  SVN_TEST_ASSERT(! found);
+  SVN_ERR(svn_cache__has_key(&found, cache, "three", pool));
+  SVN_TEST_ASSERT(found);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_memcache_basic(const svn_test_opts_t *opts,
                     apr_pool_t *pool)
@@ -227,6 +262,31 @@ test_membuffer_cache_basic(apr_pool_t *pool)
   return basic_cache_test(cache, FALSE, pool);
 }
 
+static svn_error_t *
+test_membuffer_cache_placement(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+
+  /* Large enough for multiple segments of more than one huge page. */
+  SVN_ERR(svn_cache__membuffer_cache_create2(&membuffer, 0x1000000,
+                                             0x100000, 4, TRUE, TRUE,
+                                             TRUE, TRUE, pool));
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  return basic_cache_test(cache, FALSE, pool);
+}
+
 /* Implements svn_cache__deserialize_func_t */
 static svn_error_t *
 raise_error_deserialize_func(void **out,
@@ -489,6 +549,65 @@ test_null_cache(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_tiered_cache(apr_pool_t *pool)
+{
+  svn_cache__t *near_cache, *far_cache, *cache;
+  svn_revnum_t twenty = 20, thirty = 30, *answer;
+  apr_array_header_t *keys, *values;
+  svn_boolean_t found;
+
+  SVN_ERR(svn_cache__create_inprocess(&near_cache,
+                                      serialize_revnum,
+                                      deserialize_revnum,
+                                      APR_HASH_KEY_STRING,
+                                      4, 4, FALSE, "", pool));
+  SVN_ERR(svn_cache__create_inprocess(&far_cache,
+                                      serialize_revnum,
+                                      deserialize_revnum,
+                                      APR_HASH_KEY_STRING,
+                                      4, 4, FALSE, "", pool));
+  SVN_ERR(svn_cache__create_tiered(&cache, near_cache, far_cache, pool));
+
+  /* Items from the far cache get copied into the near one. */
+  SVN_ERR(svn_cache__set(far_cache, "twenty", &twenty, pool));
+  SVN_ERR(svn_cache__has_key(&found, near_cache, "twenty", pool));
+  SVN_TEST_ASSERT(! found);
+
+  SVN_ERR(svn_cache__get((void **) &answer, &found, cache, "twenty", pool));
+  SVN_TEST_ASSERT(found && *answer == 20);
+  SVN_ERR(svn_cache__get((void **) &answer, &found, near_cache, "twenty",
+                         pool));
+  SVN_TEST_ASSERT(found && *answer == 20);
+
+  /* Writes go to both tiers. */
+  SVN_ERR(svn_cache__set(cache, "thirty", &thirty, pool));
+  SVN_ERR(svn_cache__has_key(&found, near_cache, "thirty", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_ERR(svn_cache__has_key(&found, far_cache, "thirty", pool));
+  SVN_TEST_ASSERT(found);
+
+  /* Multi-key lookups report misses and NULL keys as NULL values. */
+  SVN_ERR(svn_cache__set(far_cache, "forty", &thirty, pool));
+  keys = apr_array_make(pool, 4, sizeof(const char *));
+  APR_ARRAY_PUSH(keys, const char *) = "thirty";
+  APR_ARRAY_PUSH(keys, const char *) = "missing";
+  APR_ARRAY_PUSH(keys, const char *) = NULL;
+  APR_ARRAY_PUSH(keys, const char *) = "forty";
+
+  SVN_ERR(svn_cache__get_multi(&values, cache, keys, pool));
+  SVN_TEST_ASSERT(values->nelts == 4);
+  SVN_TEST_ASSERT(*APR_ARRAY_IDX(values, 0, svn_revnum_t *) == 30);
+  SVN_TEST_ASSERT(APR_ARRAY_IDX(values, 1, svn_revnum_t *) == NULL);
+  SVN_TEST_ASSERT(APR_ARRAY_IDX(values, 2, svn_revnum_t *) == NULL);
+  SVN_TEST_ASSERT(*APR_ARRAY_IDX(values, 3, svn_revnum_t *) == 30);
+
+  SVN_ERR(svn_cache__has_key(&found, near_cache, "forty", pool));
+  SVN_TEST_ASSERT(found);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_membuffer_unaligned_string_keys(apr_pool_t *pool)
 {
@@ -591,6 +710,362 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
 }
 
 
+/* Create a small membuffer cache with a disk tier using the file at PATH
+ * and return front-end caches for string keys in *STRING_CACHE and for
+ * fixed-size keys in *FIXED_CACHE.  Allocate everything in POOL.
+ */
+static svn_error_t *
+create_disk_tier_caches(svn_cache__t **string_cache,
+                        svn_cache__t **fixed_cache,
+                        const char *path,
+                        apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__membuffer_enable_disk_tier(membuffer, path,
+                                                8 * 1024 * 1024, TRUE,
+                                                pool, pool));
+
+  SVN_ERR(svn_cache__create_membuffer_cache(string_cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(fixed_cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(apr_uint64_t),
+                                            "fixed:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Look up the first COUNT items written by test_membuffer_disk_tier in
+ * STRING_CACHE and FIXED_CACHE.  Set *FOUND_COUNT to the number of items
+ * found and fail if any of them has an unexpected value.  The value for
+ * key 0 in STRING_CACHE has been changed to CHANGED_VALUE.
+ */
+static svn_error_t *
+check_disk_tier_caches(int *found_count,
+                       svn_cache__t *string_cache,
+                       svn_cache__t *fixed_cache,
+                       int count,
+                       svn_revnum_t changed_value,
+                       apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t *answer;
+  svn_boolean_t found;
+  int i;
+
+  *found_count = 0;
+  for (i = 0; i < count; ++i)
+    {
+      const char *string_key;
+      apr_uint64_t fixed_key = i;
+      svn_revnum_t expected = i ? i : changed_value;
+
+      svn_pool_clear(iterpool);
+      string_key = apr_psprintf(iterpool, "key-%d", i);
+      SVN_ERR(svn_cache__get((void **) &answer, &found, string_cache,
+                             string_key, iterpool));
+      if (found)
+        {
+          SVN_TEST_ASSERT(*answer == expected);
+          ++*found_count;
+        }
+
+      SVN_ERR(svn_cache__get((void **) &answer, &found, fixed_cache,
+                             &fixed_key, iterpool));
+      if (found)
+        {
+          SVN_TEST_ASSERT(*answer == 2 * i + 1);
+          ++*found_count;
+        }
+    }
+
+  SVN_ERR(svn_cache__get((void **) &answer, &found, string_cache,
+                         "not-there", iterpool));
+  SVN_TEST_ASSERT(!found);
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_disk_tier(apr_pool_t *pool)
+{
+  enum { COUNT = 200 };
+
+  const char *sandbox;
+  const char *path;
+  svn_cache__t *string_cache;
+  svn_cache__t *fixed_cache;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_revnum_t new_value = 4711;
+  int found_count;
+  int i;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&sandbox, "membuffer-disk-tier", pool));
+  path = svn_dirent_join(sandbox, "cache", pool);
+
+  /* Write far more items than fit into memory. */
+  SVN_ERR(create_disk_tier_caches(&string_cache, &fixed_cache, path,
+                                  subpool));
+  for (i = 0; i < COUNT; ++i)
+    {
+      svn_revnum_t string_value = i;
+      svn_revnum_t fixed_value = 2 * i + 1;
+      apr_uint64_t fixed_key = i;
+
+      SVN_ERR(svn_cache__set(string_cache, apr_psprintf(subpool, "key-%d", i),
+                             &string_value, subpool));
+      SVN_ERR(svn_cache__set(fixed_cache, &fixed_key, &fixed_value,
+                             subpool));
+    }
+
+  /* Most items should have survived on disk.  Index collisions may cause
+   * a few to get lost. */
+  SVN_ERR(check_disk_tier_caches(&found_count, string_cache, fixed_cache,
+                                 COUNT, 0, subpool));
+  SVN_TEST_ASSERT(found_count > COUNT * 3 / 2);
+
+  /* Overwriting an item must not let older versions resurface. */
+  SVN_ERR(svn_cache__set(string_cache, "key-0", &new_value, subpool));
+  SVN_ERR(check_disk_tier_caches(&found_count, string_cache, fixed_cache,
+                                 COUNT, new_value, subpool));
+
+  /* "Restart" with the same disk file.  The data evicted to disk should
+   * be there again. */
+  svn_pool_clear(subpool);
+  SVN_ERR(create_disk_tier_caches(&string_cache, &fixed_cache, path,
+                                  subpool));
+  SVN_ERR(check_disk_tier_caches(&found_count, string_cache, fixed_cache,
+                                 COUNT, new_value, subpool));
+  SVN_TEST_ASSERT(found_count > COUNT);
+
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+/* Shared state of the concurrent membuffer access test.
+ */
+typedef struct concurrent_baton_t
+{
+  /* The cache to access. */
+  svn_cache__t *cache;
+
+  /* Used to distinguish the threads' data access patterns. */
+  int thread_no;
+
+  /* Error returned by the thread, if any. */
+  svn_error_t *err;
+} concurrent_baton_t;
+
+/* Number of different keys used by the concurrent access test. */
+#define CONCURRENT_KEY_COUNT 500
+
+/* Write and read back CONCURRENT_KEY_COUNT items to BATON->CACHE a few
+ * times.  The value stored under key "key-<n>" is always n, so any item
+ * returned by the cache must match its key.
+ */
+static svn_error_t *
+access_cache_concurrently(concurrent_baton_t *baton)
+{
+  apr_pool_t *pool = svn_pool_create(NULL);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; i < 20 * CONCURRENT_KEY_COUNT; ++i)
+    {
+      svn_revnum_t value = (i * 17 + baton->thread_no)
+                         % CONCURRENT_KEY_COUNT;
+      svn_revnum_t *found_value;
+      svn_boolean_t found;
+      const char *key;
+
+      svn_pool_clear(iterpool);
+      key = apr_psprintf(iterpool, "key-%ld", value);
+
+      if (i % 4 == 0)
+        SVN_ERR(svn_cache__set(baton->cache, key, &value, iterpool));
+
+      SVN_ERR(svn_cache__get((void **)&found_value, &found, baton->cache,
+                             key, iterpool));
+      if (found && *found_value != value)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "Found value %ld for key %s",
+                                 *found_value, key);
+    }
+
+  svn_pool_destroy(pool);
+  return SVN_NO_ERROR;
+}
+
+static void *
+APR_THREAD_FUNC concurrent_thread_func(apr_thread_t *tid, void *data)
+{
+  concurrent_baton_t *baton = data;
+
+  /* give all threads a good chance to get started by the scheduler */
+  apr_thread_yield();
+
+  baton->err = access_cache_concurrently(baton);
+  apr_thread_exit(tid, APR_SUCCESS);
+
+  return NULL;
+}
+#endif
+
+static svn_error_t *
+test_membuffer_concurrent_access(apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  /* Reads on the membuffer cache may bypass the segment lock.  Hammer a
+   * small, single-segment cache from several threads and verify that we
+   * never get inconsistent data back.
+   */
+  enum { THREAD_COUNT = 8 };
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  apr_thread_t *threads[THREAD_COUNT];
+  concurrent_baton_t batons[THREAD_COUNT];
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 1,
+                                            TRUE, TRUE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+
+  for (i = 0; i < THREAD_COUNT; ++i)
+    {
+      apr_status_t status;
+
+      batons[i].cache = cache;
+      batons[i].thread_no = i;
+      batons[i].err = SVN_NO_ERROR;
+
+      status = apr_thread_create(&threads[i], NULL, concurrent_thread_func,
+                                 &batons[i], pool);
+      if (status)
+        return svn_error_wrap_apr(status, "Can't create thread");
+    }
+
+  /* wait for the threads to finish */
+  for (i = 0; i < THREAD_COUNT; ++i)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, threads[i]);
+      if (status)
+        return svn_error_wrap_apr(status, "Can't join thread");
+
+      err = svn_error_compose_create(err, batons[i].err);
+    }
+
+  SVN_ERR(err);
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_partition_info(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *fixed_cache, *string_cache;
+  svn_cache__info_t info;
+  svn_revnum_t i;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024 * 1024, 1, 0,
+                                            TRUE, TRUE, pool));
+
+  /* One front-end with fixed-size and one with string keys, the latter
+   * not sharing the key prefix through the prefix pool. */
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &fixed_cache, membuffer, serialize_revnum, deserialize_revnum,
+            sizeof(svn_revnum_t), "fixed:",
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+            pool, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(
+            &string_cache, membuffer, serialize_revnum, deserialize_revnum,
+            APR_HASH_KEY_STRING, "string:",
+            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY, FALSE, FALSE,
+            pool, pool));
+
+  for (i = 0; i < 3; ++i)
+    SVN_ERR(svn_cache__set(fixed_cache, &i, &i, pool));
+  for (i = 0; i < 2; ++i)
+    SVN_ERR(svn_cache__set(string_cache, apr_psprintf(pool, "%ld", i), &i,
+                           pool));
+
+  /* Each front-end reports its own share of the shared capacity. */
+  SVN_ERR(svn_cache__get_info(fixed_cache, &info, FALSE, pool));
+  SVN_TEST_ASSERT(info.used_entries == 3);
+  SVN_TEST_ASSERT(info.used_size > 0);
+  SVN_TEST_ASSERT(info.data_size > info.used_size);
+
+  SVN_ERR(svn_cache__get_info(string_cache, &info, FALSE, pool));
+  SVN_TEST_ASSERT(info.used_entries == 2);
+  SVN_TEST_ASSERT(info.sets == 2);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_metrics_format(apr_pool_t *pool)
+{
+  static svn_metrics__counter_t counters[] =
+    {
+      { "svn_test_events_total", "Test events.", 0 }
+    };
+  static svn_metrics__group_t group = { counters, 1, NULL };
+  apr_array_header_t *segments;
+  svn_string_t *text;
+
+  svn_metrics__register(&group);
+  svn_metrics__register(&group);
+  SVN_METRICS__INC(counters[0]);
+  SVN_METRICS__INC(counters[0]);
+
+  text = svn_metrics__format_prometheus(pool);
+  SVN_TEST_ASSERT(strstr(text->data, "\nsvn_test_events_total 2\n"));
+  SVN_TEST_ASSERT(strstr(text->data,
+                         "# TYPE svn_test_events_total counter\n"));
+
+  /* Registering twice must not list the counter twice. */
+  SVN_TEST_ASSERT(!strstr(strstr(text->data, "\nsvn_test_events_total 2")
+                          + 1, "\nsvn_test_events_total 2"));
+
+  /* There is one line per cache segment, if there is a cache at all. */
+  segments = svn_cache__membuffer_get_global_segment_infos(pool);
+  if (segments->nelts)
+    SVN_TEST_ASSERT(strstr(text->data, "svn_cache_segment_used_bytes{"));
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -600,6 +1075,8 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_PASS2(test_inprocess_cache_basic,
                    "basic inprocess svn_cache test"),
+    SVN_TEST_PASS2(test_inprocess_cache_eviction,
+                   "test LRU eviction in inprocess svn_cache"),
     SVN_TEST_OPTS_PASS(test_memcache_basic,
                        "basic memcache svn_cache test"),
     SVN_TEST_OPTS_PASS(test_memcache_long_key,
@@ -612,10 +1089,23 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test clearing a membuffer svn_cache"),
     SVN_TEST_PASS2(test_null_cache,
                    "basic null svn_cache test"),
+    SVN_TEST_PASS2(test_tiered_cache,
+                   "test a near cache in front of a far cache"),
     SVN_TEST_PASS2(test_membuffer_unaligned_string_keys,
                    "test membuffer cache with unaligned string keys"),
     SVN_TEST_PASS2(test_membuffer_unaligned_fixed_keys,
                    "test membuffer cache with unaligned fixed keys"),
+    SVN_TEST_PASS2(test_membuffer_disk_tier,
+                   "test membuffer cache with disk tier"),
+    SVN_TEST_SKIP2(test_membuffer_concurrent_access,
+                   ! APR_HAS_THREADS,
+                   "test concurrent membuffer cache access"),
+    SVN_TEST_PASS2(test_membuffer_partition_info,
+                   "test per-front-end membuffer cache statistics"),
+    SVN_TEST_PASS2(test_metrics_format,
+                   "test metrics in Prometheus text format"),
+    SVN_TEST_PASS2(test_membuffer_cache_placement,
+                   "membuffer on huge pages, interleaved across nodes"),
     SVN_TEST_NULL
   };
 
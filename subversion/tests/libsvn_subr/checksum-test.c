@@ -27,6 +27,10 @@
 
 #include "svn_error.h"
 #include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
+#include "private/svn_subr_private.h"
 
 #include "../svn_test.h"
 
@@ -364,6 +368,123 @@ test_checksummed_stream_reset(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_sha1_vectors(apr_pool_t *pool)
+{
+  /* FIPS 180-2 test vectors. */
+  static const struct
+    {
+      const char *data;
+      apr_size_t repeat;
+      const char *digest;
+    } vectors[] =
+    {
+      { "", 1, "da39a3ee5e6b4b0d3255bfef95601890afd80709" },
+      { "abc", 1, "a9993e364706816aba3e25717850c26c9cd0d89d" },
+      { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+        "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+      { "a", 1000000, "34aa973cd4c4daa4f61eeb2bdbad27316534016f" }
+    };
+  static const apr_size_t chunk_sizes[] = { 1, 55, 63, 64, 65, 100000 };
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_size_t i, k;
+
+  for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); ++i)
+    {
+      svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+      svn_checksum_t *expected;
+      svn_checksum_t *actual;
+      apr_size_t n;
+
+      for (n = 0; n < vectors[i].repeat; ++n)
+        svn_stringbuf_appendcstr(data, vectors[i].data);
+
+      SVN_ERR(svn_checksum_parse_hex(&expected, svn_checksum_sha1,
+                                     vectors[i].digest, pool));
+
+      /* One-shot. */
+      SVN_ERR(svn_checksum(&actual, svn_checksum_sha1, data->data,
+                           data->len, pool));
+      SVN_TEST_ASSERT(svn_checksum_match(expected, actual));
+
+      /* Incremental, with various chunk sizes. */
+      for (k = 0; k < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); ++k)
+        {
+          svn_checksum_ctx_t *ctx;
+          apr_size_t offset;
+
+          svn_pool_clear(iterpool);
+          ctx = svn_checksum_ctx_create(svn_checksum_sha1, iterpool);
+          for (offset = 0; offset < data->len; offset += chunk_sizes[k])
+            SVN_ERR(svn_checksum_update(ctx, data->data + offset,
+                                        MIN(chunk_sizes[k],
+                                            data->len - offset)));
+
+          SVN_ERR(svn_checksum_final(&actual, ctx, iterpool));
+          SVN_TEST_ASSERT(svn_checksum_match(expected, actual));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_multi_checksum(apr_pool_t *pool)
+{
+  static const svn_checksum_kind_t kinds[]
+    = { svn_checksum_md5, svn_checksum_sha1, svn_checksum_fnv1a_32x4 };
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+  svn_checksum__multi_ctx_t *ctx;
+  svn_checksum_t *expected;
+  svn_checksum_t *md5_checksum;
+  svn_checksum_t *sha1_checksum;
+  svn_stream_t *stream;
+  svn_error_t *err;
+  int i;
+
+  /* Larger than the internal block size used by the multi context. */
+  for (i = 0; i < 100000; ++i)
+    svn_stringbuf_appendbyte(data, (char)(i * 7));
+
+  ctx = svn_checksum__multi_ctx_create(kinds, 3, pool);
+  SVN_ERR(svn_checksum__multi_update(ctx, data->data, 1));
+  SVN_ERR(svn_checksum__multi_update(ctx, data->data + 1, data->len - 1));
+
+  for (i = 0; i < 3; ++i)
+    {
+      svn_checksum_t *actual;
+
+      SVN_ERR(svn_checksum(&expected, kinds[i], data->data, data->len,
+                           pool));
+      SVN_ERR(svn_checksum__multi_final(&actual, ctx, kinds[i], pool));
+      SVN_TEST_ASSERT(svn_checksum_match(expected, actual));
+    }
+
+  /* Kinds not requested cannot be retrieved. */
+  ctx = svn_checksum__multi_ctx_create(kinds, 1, pool);
+  err = svn_checksum__multi_final(&md5_checksum, ctx, svn_checksum_sha1,
+                                  pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_BAD_CHECKSUM_KIND);
+
+  /* The stream wrapper. */
+  stream = svn_checksum__wrap_write_stream_multi(&md5_checksum,
+                                                 &sha1_checksum,
+                                                 svn_stream_empty(pool),
+                                                 pool);
+  SVN_ERR(svn_stream_write(stream, data->data, &data->len));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_ERR(svn_checksum(&expected, svn_checksum_md5, data->data, data->len,
+                       pool));
+  SVN_TEST_ASSERT(svn_checksum_match(expected, md5_checksum));
+  SVN_ERR(svn_checksum(&expected, svn_checksum_sha1, data->data, data->len,
+                       pool));
+  SVN_TEST_ASSERT(svn_checksum_match(expected, sha1_checksum));
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -389,6 +510,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "read from checksummed stream"),
     SVN_TEST_PASS2(test_checksummed_stream_reset,
                    "reset checksummed stream"),
+    SVN_TEST_PASS2(test_sha1_vectors,
+                   "SHA-1 test vectors"),
+    SVN_TEST_PASS2(test_multi_checksum,
+                   "multi-digest checksum context"),
     SVN_TEST_NULL
   };
 
@@ -21,6 +21,9 @@
  * ====================================================================
  */
 
+#include <string.h>
+
+#include "svn_delta.h"
 #include "svn_pools.h"
 #include "private/svn_subr_private.h"
 #include "../svn_test.h"
@@ -76,6 +79,147 @@ test_compress_lz4_empty(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_compress_zstd(apr_pool_t *pool)
+{
+  const char input[] =
+    "aaaabbbbccccaaaaccccbbbbaaaabbbb"
+    "aaaabbbbccccaaaaccccbbbbaaaabbbb"
+    "aaaabbbbccccaaaaccccbbbbaaaabbbb";
+  svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *decompressed = svn_stringbuf_create_empty(pool);
+
+  if (!svn__zstd_supported())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "zstd support not compiled in");
+
+  SVN_ERR(svn__compress_zstd(input, sizeof(input), compressed, 3));
+  SVN_TEST_ASSERT(compressed->len < sizeof(input));
+  SVN_ERR(svn__decompress_zstd(compressed->data, compressed->len,
+                               decompressed, 100));
+  SVN_TEST_STRING_ASSERT(decompressed->data, input);
+
+  /* The stored size must be checked against the limit. */
+  SVN_TEST_ASSERT_ERROR(svn__decompress_zstd(compressed->data,
+                                             compressed->len,
+                                             decompressed, 10),
+                        SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_compress_zstd_empty(apr_pool_t *pool)
+{
+  svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *decompressed = svn_stringbuf_create_empty(pool);
+
+  if (!svn__zstd_supported())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "zstd support not compiled in");
+
+  SVN_ERR(svn__compress_zstd("", 0, compressed, 3));
+  SVN_ERR(svn__decompress_zstd(compressed->data, compressed->len,
+                               decompressed, 100));
+  SVN_TEST_STRING_ASSERT(decompressed->data, "");
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_decompress_zlib(apr_pool_t *pool)
+{
+  /* Produced by the stock zlib at level 6.  Whatever backend we use,
+     we must be able to read that. */
+  const char input[] =
+    "\x85\x00\x78\x9c\x4b\x4c\x4c\x4c\x4c\x02\x82\x64\x20\x00\x32\x13"
+    "\x41\x34\x88\x9f\x08\x15\x4f\x1c\x95\x1f\x95\xa7\xa1\x3c\x00\x6a"
+    "\x26\xf4\xb1";
+  svn_stringbuf_t *decompressed = svn_stringbuf_create_empty(pool);
+  int i;
+
+  SVN_ERR(svn__decompress_zlib(input, sizeof(input) - 1, decompressed,
+                               1000));
+  SVN_TEST_INT_ASSERT(decompressed->len, 640);
+  for (i = 0; i < 20; ++i)
+    SVN_TEST_ASSERT(memcmp(decompressed->data + 32 * i,
+                           "aaaabbbbccccaaaaccccbbbbaaaabbbb", 32) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_compress_zlib(apr_pool_t *pool)
+{
+  svn_stringbuf_t *input = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *decompressed = svn_stringbuf_create_empty(pool);
+  int i;
+
+  /* Make the input large enough to actually get compressed. */
+  for (i = 0; i < 100; ++i)
+    svn_stringbuf_appendcstr(input, "aaaabbbbccccaaaaccccbbbbaaaabbbb");
+
+  SVN_ERR(svn__compress_zlib(input->data, input->len, compressed,
+                             SVN_DELTA_COMPRESSION_LEVEL_DEFAULT));
+  SVN_TEST_ASSERT(compressed->len < input->len);
+  SVN_ERR(svn__decompress_zlib(compressed->data, compressed->len,
+                               decompressed, input->len));
+  SVN_TEST_STRING_ASSERT(decompressed->data, input->data);
+
+  /* The stored size must be checked against the limit. */
+  SVN_TEST_ASSERT_ERROR(svn__decompress_zlib(compressed->data,
+                                             compressed->len,
+                                             decompressed, 100),
+                        SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA);
+
+  /* Corrupted data must be detected. */
+  compressed->data[compressed->len / 2] ^= 0x55;
+  SVN_TEST_ASSERT_ANY_ERROR(svn__decompress_zlib(compressed->data,
+                                                 compressed->len,
+                                                 decompressed, input->len));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_compress_zlib_dict(apr_pool_t *pool)
+{
+  const char input[] = "/trunk/subversion/libsvn_fs_x/pack.c";
+  svn_string_t *dictionary
+    = svn_string_create("/trunk/subversion/libsvn_fs_x/", pool);
+  svn_string_t *other
+    = svn_string_create("/branches/1.10.x/subversion/", pool);
+  svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *decompressed = svn_stringbuf_create_empty(pool);
+
+  /* Even short input compresses well with a matching dictionary. */
+  SVN_ERR(svn__compress_zlib_dict(input, sizeof(input), compressed,
+                                  SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                                  dictionary));
+  SVN_TEST_ASSERT(compressed->len < sizeof(input));
+  SVN_ERR(svn__decompress_zlib_dict(compressed->data, compressed->len,
+                                    decompressed, 100, dictionary));
+  SVN_TEST_STRING_ASSERT(decompressed->data, input);
+
+  /* The data cannot be restored with a different dictionary. */
+  SVN_TEST_ASSERT_ANY_ERROR(svn__decompress_zlib_dict(compressed->data,
+                                                      compressed->len,
+                                                      decompressed, 100,
+                                                      other));
+
+  /* Without a dictionary, we get the standard zlib behavior. */
+  SVN_ERR(svn__compress_zlib_dict(input, sizeof(input), compressed,
+                                  SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                                  NULL));
+  SVN_TEST_INT_ASSERT(compressed->len, sizeof(input) + 1);
+  SVN_ERR(svn__decompress_zlib(compressed->data, compressed->len,
+                               decompressed, 100));
+  SVN_TEST_STRING_ASSERT(decompressed->data, input);
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = -1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -87,6 +231,16 @@ static struct svn_test_descriptor_t test_funcs[] =
                  "test svn__compress_lz4()"),
   SVN_TEST_PASS2(test_compress_lz4_empty,
                  "test svn__compress_lz4() with empty input"),
+  SVN_TEST_PASS2(test_compress_zstd,
+                 "test svn__compress_zstd()"),
+  SVN_TEST_PASS2(test_compress_zstd_empty,
+                 "test svn__compress_zstd() with empty input"),
+  SVN_TEST_PASS2(test_decompress_zlib,
+                 "test svn__decompress_zlib() with zlib data"),
+  SVN_TEST_PASS2(test_compress_zlib,
+                 "test svn__compress_zlib()"),
+  SVN_TEST_PASS2(test_compress_zlib_dict,
+                 "test svn__compress_zlib_dict()"),
   SVN_TEST_NULL
 };
 
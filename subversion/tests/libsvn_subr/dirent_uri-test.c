@@ -364,6 +364,7 @@ test_relpath_join(apr_pool_t *pool)
 {
   int i;
   char *result;
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(pool);
 
   static const char * const joins[][3] = {
     { "abc", "def", "abc/def" },
@@ -387,6 +388,14 @@ test_relpath_join(apr_pool_t *pool)
                                  "\"%s\". expected \"%s\"",
                                  base, comp, result, expect);
 
+      /* Re-use BUF across iterations. */
+      svn_relpath__join_buf(buf, base, comp);
+      if (strcmp(buf->data, expect) || buf->len != strlen(expect))
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "svn_relpath__join_buf(\"%s\", \"%s\") "
+                                 "returned \"%s\". expected \"%s\"",
+                                 base, comp, buf->data, expect);
+
       /*result = svn_relpath_join_many(pool, base, comp, NULL);
       if (strcmp(result, expect))
         return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
@@ -798,6 +807,18 @@ test_relpath_canonicalize(apr_pool_t *pool)
                                  "svn_relpath_canonicalize(\"%s\") returned "
                                  "\"%s\" expected \"%s\"",
                                  t->path, canonical, t->result);
+
+      /* The lazy variant returns canonical input as-is. */
+      canonical = svn_relpath__canonicalize_lazy(t->path, pool);
+      if (strcmp(canonical, t->result))
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "svn_relpath__canonicalize_lazy(\"%s\") "
+                                 "returned \"%s\" expected \"%s\"",
+                                 t->path, canonical, t->result);
+      if (strcmp(t->path, t->result) == 0 && canonical != t->path)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "svn_relpath__canonicalize_lazy(\"%s\") "
+                                 "copied canonical input", t->path);
     }
 
   return SVN_NO_ERROR;
@@ -0,0 +1,147 @@
+/*
+ * hash-map-test.c:  a collection of svn_hash_map__* tests
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ====================================================================
+   To add tests, look toward the bottom of this file.
+
+*/
+
+
+
+#include <stdio.h>
+#include <string.h>
+#include <apr_pools.h>
+#include <apr_hash.h>
+
+#include "../svn_test.h"
+
+#include "svn_error.h"
+#include "svn_string.h"   /* This includes <apr_*.h> */
+#include "private/svn_subr_private.h"
+
+static svn_error_t *
+test_string_keys(apr_pool_t *pool)
+{
+  svn_hash_map__t *map = svn_hash_map__create(0, pool);
+
+  SVN_TEST_ASSERT(svn_hash_map__count(map) == 0);
+  SVN_TEST_ASSERT(svn_hash_map__get(map, "a", APR_HASH_KEY_STRING) == NULL);
+
+  svn_hash_map__set(map, "a", APR_HASH_KEY_STRING, "1");
+  svn_hash_map__set(map, "b", APR_HASH_KEY_STRING, "2");
+  svn_hash_map__set(map, "", APR_HASH_KEY_STRING, "empty");
+  SVN_TEST_ASSERT(svn_hash_map__count(map) == 3);
+  SVN_TEST_STRING_ASSERT(svn_hash_map__get(map, "a", APR_HASH_KEY_STRING),
+                         "1");
+  SVN_TEST_STRING_ASSERT(svn_hash_map__get(map, "b", 1), "2");
+  SVN_TEST_STRING_ASSERT(svn_hash_map__get(map, "", 0), "empty");
+  SVN_TEST_ASSERT(svn_hash_map__get(map, "ab", 2) == NULL);
+
+  /* Overwrite an existing entry. */
+  svn_hash_map__set(map, "a", APR_HASH_KEY_STRING, "3");
+  SVN_TEST_ASSERT(svn_hash_map__count(map) == 3);
+  SVN_TEST_STRING_ASSERT(svn_hash_map__get(map, "a", APR_HASH_KEY_STRING),
+                         "3");
+
+  /* Remove entries, including one that does not exist. */
+  svn_hash_map__set(map, "a", APR_HASH_KEY_STRING, NULL);
+  svn_hash_map__set(map, "x", APR_HASH_KEY_STRING, NULL);
+  SVN_TEST_ASSERT(svn_hash_map__count(map) == 2);
+  SVN_TEST_ASSERT(svn_hash_map__get(map, "a", APR_HASH_KEY_STRING) == NULL);
+  SVN_TEST_STRING_ASSERT(svn_hash_map__get(map, "b", 1), "2");
+
+  svn_hash_map__clear(map);
+  SVN_TEST_ASSERT(svn_hash_map__count(map) == 0);
+  SVN_TEST_ASSERT(svn_hash_map__get(map, "b", 1) == NULL);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_many_entries(apr_pool_t *pool)
+{
+  enum { COUNT = 100000 };
+  svn_hash_map__t *map = svn_hash_map__create(0, pool);
+  apr_int64_t *keys = apr_palloc(pool, COUNT * sizeof(*keys));
+  apr_size_t iter = 0;
+  const void *key;
+  apr_ssize_t klen;
+  void *value;
+  int i, found = 0;
+
+  /* Fixed-size keys, growing the map many times. */
+  for (i = 0; i < COUNT; ++i)
+    {
+      keys[i] = (apr_int64_t)i * 7919;
+      svn_hash_map__set(map, &keys[i], sizeof(keys[i]), &keys[i]);
+    }
+
+  SVN_TEST_ASSERT(svn_hash_map__count(map) == COUNT);
+  for (i = 0; i < COUNT; ++i)
+    SVN_TEST_ASSERT(svn_hash_map__get(map, &keys[i], sizeof(keys[i]))
+                    == &keys[i]);
+
+  /* Remove every other entry.  The remaining ones must still be found. */
+  for (i = 0; i < COUNT; i += 2)
+    svn_hash_map__set(map, &keys[i], sizeof(keys[i]), NULL);
+
+  SVN_TEST_ASSERT(svn_hash_map__count(map) == COUNT / 2);
+  for (i = 0; i < COUNT; ++i)
+    {
+      apr_int64_t probe = (apr_int64_t)i * 7919;
+      void *expected = (i % 2) ? &keys[i] : NULL;
+      SVN_TEST_ASSERT(svn_hash_map__get(map, &probe, sizeof(probe))
+                      == expected);
+    }
+
+  /* Iteration must visit each remaining entry exactly once. */
+  while (svn_hash_map__next(&key, &klen, &value, map, &iter))
+    {
+      const apr_int64_t *entry = value;
+
+      SVN_TEST_ASSERT(key == value);
+      SVN_TEST_ASSERT(klen == sizeof(*entry));
+      SVN_TEST_ASSERT((*entry / 7919) % 2 == 1);
+      ++found;
+    }
+
+  SVN_TEST_ASSERT(found == COUNT / 2);
+
+  return SVN_NO_ERROR;
+}
+
+/* An array of all test functions */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_string_keys,
+                   "set / get / remove string keys"),
+    SVN_TEST_PASS2(test_many_entries,
+                   "grow, shrink and iterate a large map"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
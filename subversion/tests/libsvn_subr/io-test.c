@@ -1147,6 +1147,61 @@ test_apr_trunc_workaround(apr_pool_t *pool)
   return SVN_NO_ERROR;  
 }
 
+static svn_error_t *
+test_file_copy_contents(apr_pool_t *pool)
+{
+  const char *tmp_dir;
+  const char *foo_path;
+  const char *bar_path;
+  const char *baz_path;
+  svn_stringbuf_t *content;
+  svn_stringbuf_t *actual_content;
+  apr_file_t *from_file;
+  apr_file_t *to_file;
+  int i;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&tmp_dir, "test_file_copy_contents",
+                                    pool));
+
+  foo_path = svn_dirent_join(tmp_dir, "foo", pool);
+  bar_path = svn_dirent_join(tmp_dir, "bar", pool);
+  baz_path = svn_dirent_join(tmp_dir, "baz", pool);
+
+  /* Large enough to need several rounds of in-kernel copying. */
+  content = svn_stringbuf_create_empty(pool);
+  for (i = 0; content->len < 3 * 1024 * 1024; i++)
+    svn_stringbuf_appendcstr(content,
+                             apr_psprintf(pool, "line %d\n", i));
+  SVN_ERR(svn_io_file_create_bytes(foo_path, content->data, content->len,
+                                   pool));
+
+  /* Through svn_io_copy_file(). */
+  SVN_ERR(svn_io_copy_file(foo_path, bar_path, FALSE, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, bar_path, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(actual_content, content));
+
+  /* Between open files, as the working copy installs files. */
+  SVN_ERR(svn_io_file_open(&from_file, foo_path, APR_READ | APR_BUFFERED,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_open(&to_file, baz_path,
+                           APR_WRITE | APR_CREATE | APR_BUFFERED,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io__file_copy_contents(from_file, to_file, pool));
+  SVN_ERR(svn_io_file_close(from_file, pool));
+  SVN_ERR(svn_io_file_close(to_file, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, baz_path, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(actual_content, content));
+
+  /* Empty files. */
+  SVN_ERR(svn_io_file_create_empty(foo_path, pool));
+  SVN_ERR(svn_io_copy_file(foo_path, bar_path, FALSE, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content, bar_path, pool));
+  SVN_TEST_ASSERT(actual_content->len == 0);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 3;
@@ -1184,6 +1239,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_io_open_uniquely_named()"),
     SVN_TEST_PASS2(test_apr_trunc_workaround,
                    "test workaround for APR in svn_io_file_trunc"),
+    SVN_TEST_PASS2(test_file_copy_contents,
+                   "test svn_io__file_copy_contents"),
     SVN_TEST_NULL
   };
 
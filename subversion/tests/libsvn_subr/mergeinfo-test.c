@@ -1857,6 +1857,62 @@ test_rangelist_loop(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Parse RANGELIST_STR, combine it with every rangelist in MERGEINFO_STR
+   through svn_rangelist__merge_many() or, if INTERSECT is TRUE, through
+   svn_rangelist__intersect_many() and CONSIDER_INHERITANCE, and compare
+   the result to EXPECTED. */
+static svn_error_t *
+verify_rangelist_many(const char *rangelist_str,
+                      const char *mergeinfo_str,
+                      svn_boolean_t intersect,
+                      svn_boolean_t consider_inheritance,
+                      const char *expected,
+                      apr_pool_t *pool)
+{
+  svn_rangelist_t *rangelist;
+  svn_mergeinfo_t mergeinfo;
+  svn_string_t *actual;
+
+  SVN_ERR(svn_rangelist__parse(&rangelist, rangelist_str, pool));
+  SVN_ERR(svn_mergeinfo_parse(&mergeinfo, mergeinfo_str, pool));
+
+  if (intersect)
+    SVN_ERR(svn_rangelist__intersect_many(rangelist, mergeinfo,
+                                          consider_inheritance, pool, pool));
+  else
+    SVN_ERR(svn_rangelist__merge_many(rangelist, mergeinfo, pool, pool));
+
+  SVN_TEST_ASSERT(svn_rangelist__is_canonical(rangelist));
+  SVN_ERR(svn_rangelist_to_string(&actual, rangelist, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_rangelist_many(apr_pool_t *pool)
+{
+  /* Merging: inheritable revisions win over non-inheritable ones. */
+  SVN_ERR(verify_rangelist_many("2-4*", "/a:1-5*,9\n/b:3-7,10*",
+                                FALSE, FALSE, "1-2*,3-7,9,10*", pool));
+  SVN_ERR(verify_rangelist_many("", "/a:3,5\n/b:4",
+                                FALSE, FALSE, "3-5", pool));
+  SVN_ERR(verify_rangelist_many("3-5", "",
+                                FALSE, FALSE, "3-5", pool));
+
+  /* Intersecting, with and without considering inheritance. */
+  SVN_ERR(verify_rangelist_many("1-10", "/a:1-5*,7-9\n/b:2-8",
+                                TRUE, FALSE, "2-5,7-8", pool));
+  SVN_ERR(verify_rangelist_many("1-10", "/a:1-5*,7-9\n/b:2-8",
+                                TRUE, TRUE, "7-8", pool));
+  SVN_ERR(verify_rangelist_many("1-10", "/a:1-3\n/b:5-7",
+                                TRUE, FALSE, "", pool));
+  SVN_ERR(verify_rangelist_many("1-10", "",
+                                TRUE, FALSE, "1-10", pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -1904,6 +1960,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "merge of rangelists with overlaps (issue 4686)"),
     SVN_TEST_XFAIL2(test_rangelist_loop,
                     "test rangelist edgecases via loop"),
+    SVN_TEST_PASS2(test_rangelist_many,
+                   "merge and intersect many rangelists at once"),
     SVN_TEST_NULL
   };
 
@@ -133,6 +133,23 @@ test_uint_stream(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_small_uint_stream(apr_pool_t *pool)
+{
+  /* long runs of single-byte values, interrupted by larger ones */
+  enum { COUNT = 1000 };
+  apr_uint64_t values[COUNT];
+  apr_size_t i;
+
+  for (i = 0; i < COUNT; ++i)
+    values[i] = i % 37 ? i % 0x80 : APR_UINT64_C(0x80) << (i % 57);
+
+  SVN_ERR(verify_uint_stream(values, COUNT, FALSE, pool));
+  SVN_ERR(verify_uint_stream(values, COUNT, TRUE, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Check that COUNT numbers from VALUES can be written as signed ints to a
  * packed data stream and can be read from that stream again.  Deltify
  * data in the stream if DIFF is set.  Use POOL for allocations.
@@ -564,6 +581,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test empty container"),
     SVN_TEST_PASS2(test_uint_stream,
                    "test a single uint stream"),
+    SVN_TEST_PASS2(test_small_uint_stream,
+                   "test a uint stream with mostly small values"),
     SVN_TEST_PASS2(test_int_stream,
                    "test a single int stream"),
     SVN_TEST_PASS2(test_byte_stream,
@@ -45,6 +45,9 @@
 #define SVN_DEPRECATED
 
 #include "svn_path.h"
+#include "svn_hash.h"
+#include "svn_sorts.h"
+#include "private/svn_sorts_private.h"
 
 
 /* Using a symbol, because I tried experimenting with different
@@ -1690,6 +1693,61 @@ test_path_resolve_repos_relative_url(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Sort enough paths to use the radix sort in svn_sort__array() and
+   svn_sort__hash() and verify the result against svn_path_compare_paths()
+   and a plain byte-wise comparison. */
+static svn_error_t *
+test_sort_paths(apr_pool_t *pool)
+{
+  /* Names chosen so that '/' needs to sort before smaller characters. */
+  static const char * const names[] = { "a", "a-b", "a.b", "b", "bb", "" };
+  apr_array_header_t *paths = apr_array_make(pool, 0, sizeof(const char *));
+  apr_hash_t *hash = apr_hash_make(pool);
+  apr_array_header_t *items;
+  int i, k;
+
+  for (i = 0; i < 3000; ++i)
+    {
+      const char *path = "";
+
+      for (k = i; k; k /= 6)
+        path = svn_path_join(path, names[k % 6], pool);
+
+      APR_ARRAY_PUSH(paths, const char *) = path;
+      svn_hash_sets(hash, path, path);
+    }
+
+  svn_sort__array(paths, svn_sort_compare_paths);
+  for (i = 1; i < paths->nelts; ++i)
+    {
+      const char *prev = APR_ARRAY_IDX(paths, i - 1, const char *);
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+
+      if (svn_path_compare_paths(prev, path) > 0)
+        return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                 "'%s' sorted before '%s'", prev, path);
+    }
+
+  items = svn_sort__hash(hash, svn_sort_compare_items_as_paths, pool);
+  SVN_TEST_ASSERT(items->nelts == (int)apr_hash_count(hash));
+  for (i = 1; i < items->nelts; ++i)
+    SVN_TEST_ASSERT(svn_sort_compare_items_as_paths(
+                      &APR_ARRAY_IDX(items, i - 1, svn_sort__item_t),
+                      &APR_ARRAY_IDX(items, i, svn_sort__item_t)) < 0);
+
+  items = svn_sort__hash(hash, svn_sort_compare_items_lexically, pool);
+  SVN_TEST_ASSERT(items->nelts == (int)apr_hash_count(hash));
+  for (i = 1; i < items->nelts; ++i)
+    {
+      const char *prev = APR_ARRAY_IDX(items, i - 1, svn_sort__item_t).key;
+      const char *path = APR_ARRAY_IDX(items, i, svn_sort__item_t).key;
+
+      SVN_TEST_ASSERT(strcmp(prev, path) < 0);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 /* local define to support XFail-ing tests on Windows/Cygwin only */
 #ifdef SVN_USE_DOS_PATHS
@@ -1760,6 +1818,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_path_is_repos_relative_url"),
     SVN_TEST_PASS2(test_path_resolve_repos_relative_url,
                    "test svn_path_resolve_repos_relative_url"),
+    SVN_TEST_PASS2(test_sort_paths,
+                   "test sorting large path arrays"),
     SVN_TEST_NULL
   };
 
@@ -135,6 +135,45 @@ test_string_comparison(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_string_lookup(apr_pool_t *pool)
+{
+  svn_prefix_tree__t *tree = svn_prefix_tree__create(pool);
+  svn_prefix_string__t *strings[TEST_CASE_COUNT];
+  int i;
+
+  SVN_TEST_ASSERT(svn_prefix_tree__count(tree) == 0);
+  SVN_TEST_ASSERT(svn_prefix_string__find(tree, "") == NULL);
+
+  /* add every other string only */
+  for (i = 0; i < TEST_CASE_COUNT; i += 2)
+    strings[i] = svn_prefix_string__create(tree, test_cases[i]);
+
+  SVN_TEST_ASSERT(svn_prefix_tree__count(tree) == (TEST_CASE_COUNT + 1) / 2);
+
+  /* we must find exactly those and get the same instances */
+  for (i = 0; i < TEST_CASE_COUNT; ++i)
+    if (i % 2)
+      SVN_TEST_ASSERT(svn_prefix_string__find(tree, test_cases[i]) == NULL);
+    else
+      SVN_TEST_ASSERT(svn_prefix_string__find(tree, test_cases[i])
+                      == strings[i]);
+
+  /* looking up strings must not have added anything */
+  SVN_TEST_ASSERT(svn_prefix_tree__count(tree) == (TEST_CASE_COUNT + 1) / 2);
+
+  /* adding the remaining strings and duplicates */
+  for (i = 0; i < TEST_CASE_COUNT; ++i)
+    strings[i] = svn_prefix_string__create(tree, test_cases[i]);
+
+  SVN_TEST_ASSERT(svn_prefix_tree__count(tree) == TEST_CASE_COUNT);
+  for (i = 0; i < TEST_CASE_COUNT; ++i)
+    SVN_TEST_ASSERT(svn_prefix_string__find(tree, test_cases[i])
+                    == strings[i]);
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -148,6 +187,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "create many strings"),
     SVN_TEST_PASS2(test_string_comparison,
                    "compare strings"),
+    SVN_TEST_PASS2(test_string_lookup,
+                   "find strings without adding them"),
     SVN_TEST_NULL
   };
 
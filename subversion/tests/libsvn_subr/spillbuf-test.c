@@ -143,6 +143,15 @@ test_spillbuf__callback(apr_pool_t *pool, svn_spillbuf_t *buf)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_spillbuf_basic_write_behind(apr_pool_t *pool)
+{
+  apr_size_t len = strlen(basic_data);  /* Don't include basic_data's NUL  */
+  svn_spillbuf_t *buf = svn_spillbuf__create_write_behind(len, 10 * len,
+                                                          pool);
+  return test_spillbuf__basic(pool, len, buf);
+}
+
 static svn_error_t *
 test_spillbuf_callback(apr_pool_t *pool)
 {
@@ -304,6 +313,79 @@ test_spillbuf_interleaving_spill_all(apr_pool_t *pool)
   return test_spillbuf__interleaving(pool, buf);
 }
 
+static svn_error_t *
+test_spillbuf_interleaving_write_behind(apr_pool_t *pool)
+{
+  svn_spillbuf_t *buf = svn_spillbuf__create_write_behind(8 /* blocksize */,
+                                                          15 /* maxsize */,
+                                                          pool);
+  return test_spillbuf__interleaving(pool, buf);
+}
+
+/* Verify that the LEN bytes at DATA continue the pattern written by
+   test_spillbuf_write_behind() at offset *OFFSET, and advance *OFFSET. */
+static svn_error_t *
+check_pattern(apr_size_t *offset,
+              const char *data,
+              apr_size_t len)
+{
+  apr_size_t i;
+
+  for (i = 0; i < len; i++)
+    SVN_TEST_ASSERT(data[i] == (char)((*offset + i) % 251));
+
+  *offset += len;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_spillbuf_write_behind(apr_pool_t *pool)
+{
+  svn_spillbuf_t *buf = svn_spillbuf__create_write_behind(4096, 8192, pool);
+  apr_size_t written = 0;
+  apr_size_t verified = 0;
+  const char *readptr;
+  apr_size_t readlen;
+  char chunk[1000];
+  int i;
+
+  /* Write several megabytes, which passes through both buffers of the
+     background writer many times, and read some of it in between. */
+  for (i = 0; i < 3000; i++)
+    {
+      apr_size_t j;
+
+      for (j = 0; j < sizeof(chunk); j++)
+        chunk[j] = (char)((written + j) % 251);
+
+      SVN_ERR(svn_spillbuf__write(buf, chunk, sizeof(chunk), pool));
+      written += sizeof(chunk);
+
+      if (i % 4 == 0)
+        {
+          SVN_ERR(svn_spillbuf__read(&readptr, &readlen, buf, pool));
+          SVN_TEST_ASSERT(readptr != NULL);
+          SVN_ERR(check_pattern(&verified, readptr, readlen));
+        }
+    }
+
+  SVN_TEST_ASSERT(svn_spillbuf__get_size(buf) == written - verified);
+
+  while (TRUE)
+    {
+      SVN_ERR(svn_spillbuf__read(&readptr, &readlen, buf, pool));
+      if (readptr == NULL)
+        break;
+
+      SVN_ERR(check_pattern(&verified, readptr, readlen));
+    }
+
+  SVN_TEST_ASSERT(verified == written);
+  SVN_TEST_ASSERT(svn_spillbuf__get_size(buf) == 0);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_spillbuf_reader(apr_pool_t *pool)
 {
@@ -568,6 +650,8 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_PASS2(test_spillbuf_basic, "basic spill buffer test"),
     SVN_TEST_PASS2(test_spillbuf_basic_spill_all,
                    "basic spill buffer test (spill-all-data)"),
+    SVN_TEST_PASS2(test_spillbuf_basic_write_behind,
+                   "basic spill buffer test (write-behind)"),
     SVN_TEST_PASS2(test_spillbuf_callback, "spill buffer read callback"),
     SVN_TEST_PASS2(test_spillbuf_callback_spill_all,
                    "spill buffer read callback (spill-all-data)"),
@@ -578,6 +662,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "interleaving reads and writes"),
     SVN_TEST_PASS2(test_spillbuf_interleaving_spill_all,
                    "interleaving reads and writes (spill-all-data)"),
+    SVN_TEST_PASS2(test_spillbuf_interleaving_write_behind,
+                   "interleaving reads and writes (write-behind)"),
     SVN_TEST_PASS2(test_spillbuf_reader, "spill buffer reader test"),
     SVN_TEST_PASS2(test_spillbuf_stream, "spill buffer stream test"),
     SVN_TEST_PASS2(test_spillbuf_rwfile, "read/write spill file"),
@@ -589,6 +675,8 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_PASS2(test_spillbuf_file_attrs, "check spill file properties"),
     SVN_TEST_PASS2(test_spillbuf_file_attrs_spill_all,
                    "check spill file properties (spill-all-data)"),
+    SVN_TEST_PASS2(test_spillbuf_write_behind,
+                   "spill in the background while reading"),
     SVN_TEST_NULL
   };
 
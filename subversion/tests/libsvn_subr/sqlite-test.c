@@ -170,6 +170,105 @@ test_sqlite_txn_commit_busy(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_sqlite_wal(apr_pool_t *pool)
+{
+  svn_sqlite__db_t *sdb1;
+  svn_sqlite__db_t *sdb2;
+  const char *db_abspath;
+  svn_boolean_t wal;
+
+  static const char *const statements[] = {
+    "CREATE TABLE test (one TEXT NOT NULL PRIMARY KEY)",
+
+    "INSERT INTO test(one) VALUES ('foo')",
+
+    "SELECT one from test",
+
+    NULL
+  };
+
+  SVN_ERR(open_db(&sdb1, &db_abspath, "wal", statements, 250, pool));
+  SVN_ERR(svn_sqlite__exec_statements(sdb1, 0));
+
+  SVN_ERR(svn_sqlite__set_wal(&wal, sdb1, TRUE, pool));
+  SVN_TEST_ASSERT(wal);
+
+  /* Opening the database again must not leave WAL mode. */
+  SVN_ERR(svn_sqlite__open(&sdb2, db_abspath, svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, 250, pool, pool));
+
+  /* A reader doesn't keep the writer from committing. */
+  SVN_ERR(svn_sqlite__begin_transaction(sdb2));
+  SVN_ERR(svn_sqlite__exec_statements(sdb2, 2 /* SELECT */));
+  SVN_ERR(svn_sqlite__begin_transaction(sdb1));
+  SVN_ERR(svn_sqlite__exec_statements(sdb1, 1 /* INSERT */));
+  SVN_ERR(svn_sqlite__finish_transaction(sdb1, SVN_NO_ERROR));
+  SVN_ERR(svn_sqlite__finish_transaction(sdb2, SVN_NO_ERROR));
+
+  SVN_ERR(svn_sqlite__close(sdb2));
+
+  SVN_ERR(svn_sqlite__set_wal(&wal, sdb1, FALSE, pool));
+  SVN_TEST_ASSERT(!wal);
+
+  SVN_ERR(svn_sqlite__close(sdb1));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_sqlite_incremental_vacuum(apr_pool_t *pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_boolean_t supported, done;
+  int i;
+
+  static const char *const statements[] = {
+    "CREATE TABLE test (one INTEGER NOT NULL PRIMARY KEY, two TEXT)",
+
+    "INSERT INTO test(one, two) VALUES (?1, ?2)",
+
+    "DELETE FROM test",
+
+    NULL
+  };
+
+  /* Without the pragma, there is nothing to do incrementally. */
+  SVN_ERR(open_db(&sdb, NULL, "plain", statements, 0, pool));
+  SVN_ERR(svn_sqlite__exec_statements(sdb, 0));
+  SVN_ERR(svn_sqlite__incremental_vacuum(&supported, &done, sdb, 10, pool));
+  SVN_TEST_ASSERT(!supported && !done);
+  SVN_ERR(svn_sqlite__close(sdb));
+
+  SVN_ERR(open_db(&sdb, NULL, "incremental", statements, 0, pool));
+  SVN_ERR(svn_sqlite__enable_incremental_vacuum(sdb));
+  SVN_ERR(svn_sqlite__exec_statements(sdb, 0));
+
+  /* Fill a few hundred pages and free them again. */
+  for (i = 0; i < 1000; ++i)
+    {
+      svn_sqlite__stmt_t *stmt;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, 1));
+      SVN_ERR(svn_sqlite__bindf(stmt, "is", (apr_int64_t)i,
+                                apr_psprintf(pool, "%01000d", i)));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+  SVN_ERR(svn_sqlite__exec_statements(sdb, 2));
+
+  /* Returning the pages takes several steps ... */
+  SVN_ERR(svn_sqlite__incremental_vacuum(&supported, &done, sdb, 10, pool));
+  SVN_TEST_ASSERT(supported && !done);
+
+  /* ... until everything is gone. */
+  SVN_ERR(svn_sqlite__incremental_vacuum(&supported, &done, sdb, 0, pool));
+  SVN_TEST_ASSERT(supported && done);
+
+  SVN_ERR(svn_sqlite__close(sdb));
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = 1;
 
@@ -180,6 +279,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "sqlite reset"),
     SVN_TEST_PASS2(test_sqlite_txn_commit_busy,
                    "sqlite busy on transaction commit"),
+    SVN_TEST_PASS2(test_sqlite_wal,
+                   "sqlite write-ahead logging"),
+    SVN_TEST_PASS2(test_sqlite_incremental_vacuum,
+                   "sqlite incremental vacuum"),
     SVN_TEST_NULL
   };
 
@@ -772,6 +772,91 @@ test_stream_base64_2(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Straightforward base64 encoding of LEN bytes from DATA, without line
+   breaks, to compare the optimized implementation against. */
+static const char *
+simple_base64_encode(const unsigned char *data,
+                     apr_size_t len,
+                     apr_pool_t *pool)
+{
+  static const char tab[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  apr_size_t i;
+
+  for (i = 0; i < len; i += 3)
+    {
+      apr_uint32_t group = (apr_uint32_t)data[i] << 16;
+      if (i + 1 < len)
+        group |= (apr_uint32_t)data[i + 1] << 8;
+      if (i + 2 < len)
+        group |= data[i + 2];
+
+      svn_stringbuf_appendbyte(result, tab[(group >> 18) & 0x3f]);
+      svn_stringbuf_appendbyte(result, tab[(group >> 12) & 0x3f]);
+      svn_stringbuf_appendbyte(result,
+                               i + 1 < len ? tab[(group >> 6) & 0x3f] : '=');
+      svn_stringbuf_appendbyte(result, i + 2 < len ? tab[group & 0x3f] : '=');
+    }
+
+  return result->data;
+}
+
+static svn_error_t *
+test_base64_all_bytes(apr_pool_t *pool)
+{
+  enum { MAX_LEN = 1000 };
+  unsigned char data[MAX_LEN];
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_uint32_t seed = 12345;
+  apr_size_t len;
+
+  /* Cover every byte value and then pseudo-random ones. */
+  for (len = 0; len < MAX_LEN; ++len)
+    data[len] = len < 256 ? (unsigned char)len
+                          : (unsigned char)svn_test_rand(&seed);
+
+  /* Use all lengths that are relevant for the block-wise and line-wise
+     processing and a few large ones. */
+  for (len = 0; len <= MAX_LEN; len = len < 200 ? len + 1 : len + 100)
+    {
+      svn_string_t str;
+      const char *expected;
+      const svn_string_t *encoded;
+      const svn_string_t *decoded;
+      svn_stringbuf_t *unwrapped;
+      apr_size_t i;
+
+      svn_pool_clear(iterpool);
+
+      str.data = (const char *)data;
+      str.len = len;
+      expected = simple_base64_encode(data, len, iterpool);
+
+      encoded = svn_base64_encode_string2(&str, FALSE, iterpool);
+      SVN_TEST_STRING_ASSERT(encoded->data, expected);
+      decoded = svn_base64_decode_string(encoded, iterpool);
+      SVN_TEST_ASSERT(decoded->len == len);
+      SVN_TEST_ASSERT(memcmp(decoded->data, data, len) == 0);
+
+      /* With line breaks, we must get the same chars plus newlines. */
+      encoded = svn_base64_encode_string2(&str, TRUE, iterpool);
+      unwrapped = svn_stringbuf_create_empty(iterpool);
+      for (i = 0; i < encoded->len; ++i)
+        if (encoded->data[i] != '\n')
+          svn_stringbuf_appendbyte(unwrapped, encoded->data[i]);
+
+      SVN_TEST_STRING_ASSERT(unwrapped->data, expected);
+      decoded = svn_base64_decode_string(encoded, iterpool);
+      SVN_TEST_ASSERT(decoded->len == len);
+      SVN_TEST_ASSERT(memcmp(decoded->data, data, len) == 0);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_stringbuf_from_stream(apr_pool_t *pool)
 {
@@ -1027,6 +1112,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test base64 encoding/decoding streams"),
     SVN_TEST_PASS2(test_stream_base64_2,
                    "base64 decoding allocation problem"),
+    SVN_TEST_PASS2(test_base64_all_bytes,
+                   "base64 encoding/decoding of all byte values"),
     SVN_TEST_PASS2(test_stringbuf_from_stream,
                    "test svn_stringbuf_from_stream"),
     SVN_TEST_PASS2(test_stream_compressed_read_full,
@@ -1013,6 +1013,31 @@ test_stringbuf_set(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_stringbuf_init(apr_pool_t *pool)
+{
+  char buffer[8];
+  svn_stringbuf_t str;
+
+  svn_stringbuf__init(&str, buffer, sizeof(buffer), pool);
+  SVN_TEST_STRING_ASSERT(str.data, "");
+  SVN_TEST_INT_ASSERT(str.len, 0);
+
+  /* Short contents stay in BUFFER. */
+  svn_stringbuf_appendcstr(&str, "0123456");
+  SVN_TEST_ASSERT(str.data == buffer);
+  SVN_TEST_STRING_ASSERT(str.data, "0123456");
+
+  /* Longer ones get moved into POOL. */
+  svn_stringbuf_appendcstr(&str, "789abcdef");
+  SVN_TEST_ASSERT(str.data != buffer);
+  SVN_TEST_STRING_ASSERT(str.data, "0123456789abcdef");
+  SVN_TEST_INT_ASSERT(str.len, 16);
+  SVN_TEST_STRING_ASSERT(buffer, "0123456");
+
+  return SVN_NO_ERROR;
+}
+
 /*
    ====================================================================
    If you add a new test to this file, update this array.
@@ -1095,6 +1120,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_stringbuf_leftchop"),
     SVN_TEST_PASS2(test_stringbuf_set,
                    "test svn_stringbuf_set()"),
+    SVN_TEST_PASS2(test_stringbuf_init,
+                   "test svn_stringbuf__init()"),
     SVN_TEST_NULL
   };
 
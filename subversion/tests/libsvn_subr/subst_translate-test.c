@@ -31,6 +31,7 @@
 #include "svn_string.h"
 #include "svn_subst.h"
 #include "svn_hash.h"
+#include "svn_pools.h"
 
 #define ARRAY_LEN(ary) ((sizeof (ary)) / (sizeof ((ary)[0])))
 
@@ -500,6 +501,50 @@ test_svn_subst_long_keywords(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Expand a keyword placed at various offsets within text that also
+   contains line endings and stray '$' which must be passed through. */
+static svn_error_t *
+test_svn_subst_keywords_at_offsets(apr_pool_t *pool)
+{
+  apr_hash_t *keywords = apr_hash_make(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  svn_hash_sets(keywords, "Rev", svn_string_create("42", pool));
+
+  for (i = 0; i < 70; ++i)
+    {
+      svn_stringbuf_t *padding;
+      const char *source;
+      const char *expected;
+      const char *result;
+
+      svn_pool_clear(iterpool);
+      padding = svn_stringbuf_create_empty(iterpool);
+      svn_stringbuf_appendfill(padding, 'x', i);
+
+      source = apr_psprintf(iterpool, "%s\r\n%s$ $Rev$ \n%s$",
+                            padding->data, padding->data, padding->data);
+      expected = apr_psprintf(iterpool, "%s\r\n%s$ $Rev: 42 $ \n%s$",
+                              padding->data, padding->data, padding->data);
+
+      SVN_ERR(svn_subst_translate_cstring2(source, &result, NULL, FALSE,
+                                           keywords, TRUE, iterpool));
+      SVN_TEST_STRING_ASSERT(result, expected);
+
+      /* Translating line endings as well must not affect the keyword. */
+      expected = apr_psprintf(iterpool, "%s\n%s$ $Rev: 42 $ \n%s$",
+                              padding->data, padding->data, padding->data);
+
+      SVN_ERR(svn_subst_translate_cstring2(source, &result, "\n", TRUE,
+                                           keywords, TRUE, iterpool));
+      SVN_TEST_STRING_ASSERT(result, expected);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -519,6 +564,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test truncated keywords (issue 4349)"),
     SVN_TEST_PASS2(test_svn_subst_long_keywords,
                    "test long keywords (issue 4350)"),
+    SVN_TEST_PASS2(test_svn_subst_keywords_at_offsets,
+                   "test keywords at various buffer offsets"),
     SVN_TEST_NULL
   };
 
@@ -0,0 +1,165 @@
+/*
+ * trace-test.c -- test the request tracing spans
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+#include <apr_general.h>
+#include <apr_time.h>
+
+#include "svn_pools.h"
+#include "private/svn_subr_private.h"
+
+#include "../svn_test.h"
+
+/* Number of spans kept by the tests below. */
+#define TEST_SPANS 8
+
+/* Return the number of occurrences of NEEDLE in HAYSTACK. */
+static int
+count_matches(const char *haystack,
+              const char *needle)
+{
+  int count = 0;
+  for (haystack = strstr(haystack, needle);
+       haystack;
+       haystack = strstr(haystack + 1, needle))
+    ++count;
+
+  return count;
+}
+
+static svn_error_t *
+test_disabled(apr_pool_t *pool)
+{
+  svn_trace__span_t *span;
+  svn_string_t *text;
+
+  if (svn_trace__is_enabled())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "tracing has already been enabled");
+
+  span = svn_trace__span_begin("test span", pool);
+  SVN_TEST_ASSERT(span == NULL);
+  svn_trace__span_attr(span, "key", "value");
+  svn_trace__span_end(span);
+
+  text = svn_trace__export(svn_trace__format_chrome, pool);
+  SVN_TEST_STRING_ASSERT(text->data, "{\"traceEvents\":[\n]}\n");
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_chrome_format(apr_pool_t *pool)
+{
+  svn_trace__span_t *span;
+  svn_string_t *text;
+
+  SVN_ERR(svn_trace__enable(TEST_SPANS));
+
+  span = svn_trace__span_begin("chrome span", pool);
+  SVN_TEST_ASSERT(span != NULL);
+  svn_trace__span_attr(span, "path", "/a \"quoted\"\\path");
+  svn_trace__span_attr_int(span, "revision", 42);
+  svn_trace__span_end(span);
+
+  text = svn_trace__export(svn_trace__format_chrome, pool);
+  SVN_TEST_ASSERT(strstr(text->data, "{\"name\":\"chrome span\""));
+  SVN_TEST_ASSERT(strstr(text->data,
+                         "\"args\":{\"path\":\"/a \\\"quoted\\\"\\\\path\","
+                         "\"revision\":\"42\"}"));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_otlp_nesting(apr_pool_t *pool)
+{
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_trace__span_t *outer, *inner;
+  svn_string_t *text;
+  const char *outer_name, *inner_name, *parent_id;
+
+  SVN_ERR(svn_trace__enable(TEST_SPANS));
+
+  outer = svn_trace__span_begin("outer span", pool);
+  inner = svn_trace__span_begin("inner span", subpool);
+  SVN_TEST_ASSERT(outer && inner);
+
+  /* Clearing the pool must end the inner span. */
+  apr_sleep(1000);
+  svn_pool_destroy(subpool);
+  apr_sleep(1000);
+  svn_trace__span_end(outer);
+
+  text = svn_trace__export(svn_trace__format_otlp, pool);
+  outer_name = strstr(text->data, "\"name\":\"outer span\"");
+  inner_name = strstr(text->data, "\"name\":\"inner span\"");
+  SVN_TEST_ASSERT(outer_name && inner_name && outer_name < inner_name);
+
+  /* Only the inner span has a parent.  Its ID precedes the name. */
+  SVN_TEST_INT_ASSERT(count_matches(text->data, "parentSpanId"), 1);
+  parent_id = strstr(outer_name, "parentSpanId");
+  SVN_TEST_ASSERT(parent_id && parent_id < inner_name);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_ring_buffer(apr_pool_t *pool)
+{
+  svn_string_t *text;
+  int i;
+
+  SVN_ERR(svn_trace__enable(TEST_SPANS));
+
+  for (i = 0; i < 2 * TEST_SPANS; ++i)
+    svn_trace__span_end(svn_trace__span_begin("ring span", pool));
+
+  /* Only the most recent spans are being kept. */
+  text = svn_trace__export(svn_trace__format_chrome, pool);
+  SVN_TEST_INT_ASSERT(count_matches(text->data, "\"name\":"), TEST_SPANS);
+  SVN_TEST_INT_ASSERT(count_matches(text->data, "ring span"), TEST_SPANS);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The test table.  */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_disabled,
+                   "tracing functions are no-ops when disabled"),
+    SVN_TEST_PASS2(test_chrome_format,
+                   "export spans in Chrome trace event format"),
+    SVN_TEST_PASS2(test_otlp_nesting,
+                   "export nested spans as OTLP/JSON"),
+    SVN_TEST_PASS2(test_ring_buffer,
+                   "keep only the most recent spans"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
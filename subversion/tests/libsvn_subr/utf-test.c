@@ -885,10 +885,23 @@ test_utf_normalize(apr_pool_t *pool)
     "\xe6"                      /* Invalid byte */
     "\xe1\xb9\x8b";             /* n with circumflex below */
 
+  /* Plain ASCII, including an embedded NUL */
+  static const char ascii[] = "trunk/subversion/libsvn_subr\0/x";
+
   const char *result;
   svn_membuf_t buf;
 
   svn_membuf__create(&buf, 0, pool);
+  SVN_ERR(svn_utf__normalize(&result, ascii, SVN_UTF__UNKNOWN_LENGTH, &buf));
+  SVN_TEST_STRING_ASSERT(result, ascii);
+  SVN_ERR(svn_utf__normalize(&result, ascii, sizeof(ascii) - 1, &buf));
+  SVN_TEST_ASSERT(memcmp(result, ascii, sizeof(ascii)) == 0);
+  SVN_ERR(svn_utf__normalize(&result, ascii, 5, &buf));
+  SVN_TEST_STRING_ASSERT(result, "trunk");
+  SVN_TEST_ASSERT(svn_utf__is_ascii(ascii, sizeof(ascii) - 1));
+  SVN_TEST_ASSERT(!svn_utf__is_ascii(nfc, strlen(nfc)));
+  SVN_TEST_ASSERT(!svn_utf__is_ascii(nfd, strlen(nfd)));
+
   SVN_ERR(svn_utf__normalize(&result, nfc, strlen(nfc), &buf));
   SVN_TEST_STRING_ASSERT(result, nfc);
   SVN_ERR(svn_utf__normalize(&result, nfd, strlen(nfd), &buf));
@@ -982,6 +995,38 @@ test_utf_xfrm(apr_pool_t *pool)
 
 /* The test table.  */
 
+/* Like utf_validate2 but with mostly ASCII strings, so that the
+   block-wise ASCII skipping gets exercised at all offsets. */
+static svn_error_t *
+utf_validate3(apr_pool_t *pool)
+{
+  int i;
+
+  seed_val();
+
+  for (i = 0; i < 100000; ++i)
+    {
+      unsigned int j;
+      char str[100];
+      apr_size_t len;
+      svn_boolean_t expected;
+
+      /* Sprinkle a few non-ASCII bytes into otherwise ASCII text. */
+      for (j = 0; j < sizeof(str) - 1; ++j)
+        str[j] = range_rand(0, 15) ? 'a' : (char)range_rand(0x80, 255);
+      str[sizeof(str) - 1] = 0;
+      len = strlen(str);
+
+      expected = svn_utf__last_valid2(str, len) == str + len;
+      if (svn_utf__last_valid(str, len) != svn_utf__last_valid2(str, len)
+          || svn_utf__is_valid(str, len) != expected)
+        return svn_error_createf
+          (SVN_ERR_TEST_FAILED, NULL, "is_valid3 test %d failed", i);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -991,6 +1036,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test is_valid/last_valid"),
     SVN_TEST_PASS2(utf_validate2,
                    "test last_valid/last_valid2"),
+    SVN_TEST_PASS2(utf_validate3,
+                   "test last_valid/is_valid on mostly ASCII"),
     SVN_TEST_PASS2(test_utf_cstring_to_utf8_ex2,
                    "test svn_utf_cstring_to_utf8_ex2"),
     SVN_TEST_PASS2(test_utf_cstring_from_utf8_ex2,
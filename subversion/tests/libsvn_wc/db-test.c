@@ -35,6 +35,7 @@
 #include "svn_io.h"
 
 #include "svn_dirent_uri.h"
+#include "svn_hash.h"
 #include "svn_pools.h"
 
 #include "private/svn_sqlite.h"
@@ -1525,6 +1526,78 @@ test_externals_store(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_read_cache(apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *local_abspath;
+  const char *a_abspath;
+  apr_hash_t *props;
+  svn_boolean_t props_mod;
+  const char *repos_relpath;
+  const svn_checksum_t *checksum;
+
+  SVN_ERR(create_open(&db, &local_abspath, "test_read_cache", pool));
+  a_abspath = svn_dirent_join(local_abspath, "A", pool);
+
+  svn_wc__db_read_cache_begin(db);
+
+  /* Reading twice gives the same results, in the caller's pool. */
+  SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL, &repos_relpath, NULL, NULL,
+                               NULL, NULL, NULL, NULL, &checksum, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, &props_mod, NULL,
+                               NULL, NULL,
+                               db, a_abspath, pool, pool));
+  SVN_TEST_STRING_ASSERT(repos_relpath, "A");
+  SVN_TEST_STRING_ASSERT(SHA1_1, svn_checksum_to_cstring(checksum, pool));
+  SVN_TEST_ASSERT(!props_mod);
+
+  SVN_ERR(svn_wc__db_read_props(&props, db, a_abspath, pool, pool));
+  svn_hash_sets(props, "test:prop", svn_string_create("value", pool));
+
+  SVN_ERR(svn_wc__db_read_props(&props, db, a_abspath, pool, pool));
+  SVN_TEST_ASSERT(svn_hash_gets(props, "test:prop") == NULL);
+
+  SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL, &repos_relpath, NULL, NULL,
+                               NULL, NULL, NULL, NULL, &checksum, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, &props_mod, NULL,
+                               NULL, NULL,
+                               db, a_abspath, pool, pool));
+  SVN_TEST_STRING_ASSERT(repos_relpath, "A");
+  SVN_TEST_STRING_ASSERT(SHA1_1, svn_checksum_to_cstring(checksum, pool));
+  SVN_TEST_ASSERT(!props_mod);
+
+  /* A modification is seen by the next read, also by nested users. */
+  svn_wc__db_read_cache_begin(db);
+
+  svn_hash_sets(props, "test:prop", svn_string_create("value", pool));
+  SVN_ERR(svn_wc__db_op_set_props(db, a_abspath, props, FALSE, NULL, NULL,
+                                  pool));
+
+  SVN_ERR(svn_wc__db_read_props(&props, db, a_abspath, pool, pool));
+  SVN_TEST_STRING_ASSERT(((svn_string_t *)svn_hash_gets(props,
+                                                        "test:prop"))->data,
+                         "value");
+
+  SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, &props_mod, NULL,
+                               NULL, NULL,
+                               db, a_abspath, pool, pool));
+  SVN_TEST_ASSERT(props_mod);
+
+  svn_wc__db_read_cache_end(db);
+  svn_wc__db_read_cache_end(db);
+
+  SVN_ERR(svn_wc__db_read_props(&props, db, a_abspath, pool, pool));
+  SVN_TEST_ASSERT(svn_hash_gets(props, "test:prop") != NULL);
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 2;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -1550,6 +1623,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "work queue processing"),
     SVN_TEST_PASS2(test_externals_store,
                    "externals store"),
+    SVN_TEST_PASS2(test_read_cache,
+                   "answering repeated reads from memory"),
     SVN_TEST_NULL
   };
 
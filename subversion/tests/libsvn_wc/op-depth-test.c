@@ -8179,6 +8179,129 @@ move_update_subtree(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Update a move of a nested subtree, where the incoming changes touch
+   only part of the moved tree.  The unchanged parts must still get the
+   new revision, and local changes in them must survive. */
+static svn_error_t *
+move_update_nested_subtree(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_stringbuf_t *contents;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "move_update_nested_subtree", opts,
+                                   pool));
+
+  /* r1: Create a tree several levels deep */
+  SVN_ERR(sbox_wc_mkdir(&b, "A"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/B"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/B/C"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/B/C/D"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/B/X"));
+  SVN_ERR(sbox_file_write(&b, "A/B/C/D/f", "r1 content\n"));
+  SVN_ERR(sbox_file_write(&b, "A/B/C/D/g", "r1 content\n"));
+  SVN_ERR(sbox_file_write(&b, "A/B/X/y", "r1 content\n"));
+  SVN_ERR(sbox_file_write(&b, "A/B/X/z", "r1 content\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/B/C/D/f"));
+  SVN_ERR(sbox_wc_add(&b, "A/B/C/D/g"));
+  SVN_ERR(sbox_wc_add(&b, "A/B/X/y"));
+  SVN_ERR(sbox_wc_add(&b, "A/B/X/z"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* r2: Modify 'f', add 'new' next to it and delete 'y' */
+  SVN_ERR(sbox_file_write(&b, "A/B/C/D/f", "r1 content\nr2 content\n"));
+  SVN_ERR(sbox_file_write(&b, "A/B/C/D/new", "r2 content\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/B/C/D/new"));
+  SVN_ERR(sbox_wc_delete(&b, "A/B/X/y"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  SVN_ERR(sbox_wc_update(&b, "", 1));
+  SVN_ERR(sbox_wc_move(&b, "A/B", "B2"));
+  SVN_ERR(sbox_file_write(&b, "B2/X/z", "r1 content\nlocal change\n"));
+  {
+    nodes_row_t nodes[] = {
+      {0, "",          "normal",       1, ""},
+      {0, "A",         "normal",       1, "A"},
+      {0, "A/B",       "normal",       1, "A/B"},
+      {0, "A/B/C",     "normal",       1, "A/B/C"},
+      {0, "A/B/C/D",   "normal",       1, "A/B/C/D"},
+      {0, "A/B/C/D/f", "normal",       1, "A/B/C/D/f"},
+      {0, "A/B/C/D/g", "normal",       1, "A/B/C/D/g"},
+      {0, "A/B/X",     "normal",       1, "A/B/X"},
+      {0, "A/B/X/y",   "normal",       1, "A/B/X/y"},
+      {0, "A/B/X/z",   "normal",       1, "A/B/X/z"},
+      {2, "A/B",       "base-deleted", NO_COPY_FROM, "B2"},
+      {2, "A/B/C",     "base-deleted", NO_COPY_FROM},
+      {2, "A/B/C/D",   "base-deleted", NO_COPY_FROM},
+      {2, "A/B/C/D/f", "base-deleted", NO_COPY_FROM},
+      {2, "A/B/C/D/g", "base-deleted", NO_COPY_FROM},
+      {2, "A/B/X",     "base-deleted", NO_COPY_FROM},
+      {2, "A/B/X/y",   "base-deleted", NO_COPY_FROM},
+      {2, "A/B/X/z",   "base-deleted", NO_COPY_FROM},
+      {1, "B2",        "normal",       1, "A/B", MOVED_HERE},
+      {1, "B2/C",      "normal",       1, "A/B/C", MOVED_HERE},
+      {1, "B2/C/D",    "normal",       1, "A/B/C/D", MOVED_HERE},
+      {1, "B2/C/D/f",  "normal",       1, "A/B/C/D/f", MOVED_HERE},
+      {1, "B2/C/D/g",  "normal",       1, "A/B/C/D/g", MOVED_HERE},
+      {1, "B2/X",      "normal",       1, "A/B/X", MOVED_HERE},
+      {1, "B2/X/y",    "normal",       1, "A/B/X/y", MOVED_HERE},
+      {1, "B2/X/z",    "normal",       1, "A/B/X/z", MOVED_HERE},
+      {0}
+    };
+    SVN_ERR(check_db_rows(&b, "", nodes));
+  }
+
+  /* Update raises a tree-conflict on A/B, resolving it updates the
+     whole move destination. */
+  SVN_ERR(sbox_wc_update(&b, "", 2));
+  SVN_ERR(sbox_wc_resolve(&b, "A/B", svn_depth_empty,
+                          svn_wc_conflict_choose_mine_conflict));
+  {
+    nodes_row_t nodes[] = {
+      {0, "",            "normal",       2, ""},
+      {0, "A",           "normal",       2, "A"},
+      {0, "A/B",         "normal",       2, "A/B"},
+      {0, "A/B/C",       "normal",       2, "A/B/C"},
+      {0, "A/B/C/D",     "normal",       2, "A/B/C/D"},
+      {0, "A/B/C/D/f",   "normal",       2, "A/B/C/D/f"},
+      {0, "A/B/C/D/g",   "normal",       2, "A/B/C/D/g"},
+      {0, "A/B/C/D/new", "normal",       2, "A/B/C/D/new"},
+      {0, "A/B/X",       "normal",       2, "A/B/X"},
+      {0, "A/B/X/z",     "normal",       2, "A/B/X/z"},
+      {2, "A/B",         "base-deleted", NO_COPY_FROM, "B2"},
+      {2, "A/B/C",       "base-deleted", NO_COPY_FROM},
+      {2, "A/B/C/D",     "base-deleted", NO_COPY_FROM},
+      {2, "A/B/C/D/f",   "base-deleted", NO_COPY_FROM},
+      {2, "A/B/C/D/g",   "base-deleted", NO_COPY_FROM},
+      {2, "A/B/C/D/new", "base-deleted", NO_COPY_FROM},
+      {2, "A/B/X",       "base-deleted", NO_COPY_FROM},
+      {2, "A/B/X/z",     "base-deleted", NO_COPY_FROM},
+      {1, "B2",          "normal",       2, "A/B", MOVED_HERE},
+      {1, "B2/C",        "normal",       2, "A/B/C", MOVED_HERE},
+      {1, "B2/C/D",      "normal",       2, "A/B/C/D", MOVED_HERE},
+      {1, "B2/C/D/f",    "normal",       2, "A/B/C/D/f", MOVED_HERE},
+      {1, "B2/C/D/g",    "normal",       2, "A/B/C/D/g", MOVED_HERE},
+      {1, "B2/C/D/new",  "normal",       2, "A/B/C/D/new", MOVED_HERE},
+      {1, "B2/X",        "normal",       2, "A/B/X", MOVED_HERE},
+      {1, "B2/X/z",      "normal",       2, "A/B/X/z", MOVED_HERE},
+      {0}
+    };
+    SVN_ERR(check_db_rows(&b, "", nodes));
+  }
+
+  /* The incoming changes arrived on disk and the local one is kept. */
+  SVN_ERR(svn_stringbuf_from_file2(&contents,
+                                   sbox_wc_path(&b, "B2/C/D/f"), pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "r1 content\nr2 content\n");
+  SVN_ERR(svn_stringbuf_from_file2(&contents,
+                                   sbox_wc_path(&b, "B2/C/D/new"), pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "r2 content\n");
+  SVN_ERR(svn_stringbuf_from_file2(&contents,
+                                   sbox_wc_path(&b, "B2/X/z"), pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "r1 content\nlocal change\n");
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 move_parent_into_child(const svn_test_opts_t *opts, apr_pool_t *pool)
 {
@@ -12026,6 +12149,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "move_back (issue 4302)"),
     SVN_TEST_OPTS_PASS(move_update_subtree,
                        "move_update_subtree (issue 4232)"),
+    SVN_TEST_OPTS_PASS(move_update_nested_subtree,
+                       "move_update_nested_subtree"),
     SVN_TEST_OPTS_PASS(move_parent_into_child,
                        "move_parent_into_child (issue 4333)"),
     SVN_TEST_OPTS_PASS(move_depth_expand,
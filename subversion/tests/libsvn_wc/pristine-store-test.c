@@ -34,6 +34,7 @@
 #define SVN_DEPRECATED
 #include "svn_io.h"
 
+#include "svn_config.h"
 #include "svn_dirent_uri.h"
 #include "svn_pools.h"
 #include "svn_repos.h"
@@ -47,6 +48,7 @@
 #include "../../libsvn_wc/wc-queries.h"
 #include "../../libsvn_wc/workqueue.h"
 
+#include "private/svn_skel.h"
 #include "private/svn_wc_private.h"
 
 #include "../svn_test.h"
@@ -306,6 +308,356 @@ reject_mismatching_text(const svn_test_opts_t *opts,
 #endif
 }
 
+/* Check that pristine texts are stored compressed when so configured and
+ * that they can be read back through all access paths. */
+static svn_error_t *
+pristine_compressed(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *wc_abspath;
+  svn_config_t *config;
+  svn_wc__db_install_data_t *install_data;
+  svn_stream_t *pristine_stream;
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+  svn_checksum_t *data_sha1, *data_md5;
+  const char *pristine_abspath;
+  apr_size_t sz;
+  int i;
+
+  SVN_ERR(create_repos_and_wc(&wc_abspath, &db,
+                              "pristine_compressed", opts, pool));
+
+  /* Use a DB context of our own that compresses new pristine texts. */
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set_bool(config, SVN_CONFIG_SECTION_WORKING_COPY,
+                      SVN_CONFIG_OPTION_COMPRESS_PRISTINES, TRUE);
+  SVN_ERR(svn_wc__db_open(&db, config, FALSE, TRUE, pool, pool));
+
+  for (i = 0; i < 1000; i++)
+    svn_stringbuf_appendcstr(data, "A reasonably compressible line.\n");
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                              &install_data,
+                                              &data_sha1, &data_md5,
+                                              db, wc_abspath,
+                                              pool, pool));
+  sz = data->len;
+  SVN_ERR(svn_stream_write(pristine_stream, data->data, &sz));
+  SVN_ERR(svn_stream_close(pristine_stream));
+  SVN_ERR(svn_wc__db_pristine_install(install_data,
+                                      data_sha1, data_md5, pool));
+
+  /* Only the compressed form should exist on disk. */
+  {
+    svn_boolean_t present;
+    svn_node_kind_t kind;
+
+    SVN_ERR(svn_wc__db_pristine_check(&present, db, wc_abspath, data_sha1,
+                                      pool));
+    SVN_TEST_ASSERT(present);
+
+    SVN_ERR(svn_wc__db_pristine_get_future_path(&pristine_abspath,
+                                                wc_abspath, data_sha1,
+                                                pool, pool));
+    SVN_ERR(svn_io_check_path(pristine_abspath, &kind, pool));
+    SVN_TEST_ASSERT(kind == svn_node_none);
+  }
+
+  /* Read it back, through the database and without it. */
+  {
+    svn_stream_t *data_read_back;
+    svn_filesize_t size;
+    svn_boolean_t same;
+
+    SVN_ERR(svn_wc__db_pristine_read(&data_read_back, &size, db, wc_abspath,
+                                     data_sha1, pool, pool));
+    SVN_TEST_ASSERT(size == data->len);
+    SVN_ERR(svn_stream_contents_same2(&same, data_read_back,
+                                      svn_stream_from_stringbuf(data, pool),
+                                      pool));
+    SVN_TEST_ASSERT(same);
+
+    SVN_ERR(svn_wc__db_pristine_read_future(&data_read_back,
+                                            pristine_abspath, pool, pool));
+    SVN_ERR(svn_stream_contents_same2(&same, data_read_back,
+                                      svn_stream_from_stringbuf(data, pool),
+                                      pool));
+    SVN_TEST_ASSERT(same);
+  }
+
+  /* Asking for a path expands the pristine text. */
+  {
+    const char *path;
+    svn_stringbuf_t *contents;
+
+    SVN_ERR(svn_wc__db_pristine_get_path(&path, db, wc_abspath, data_sha1,
+                                         pool, pool));
+    SVN_TEST_STRING_ASSERT(path, pristine_abspath);
+    SVN_ERR(svn_stringbuf_from_file2(&contents, path, pool));
+    SVN_TEST_ASSERT(svn_stringbuf_compare(contents, data));
+  }
+
+  /* Removing the pristine text removes both files. */
+  {
+    svn_boolean_t present;
+    svn_node_kind_t kind;
+
+    SVN_ERR(svn_wc__db_pristine_remove(db, wc_abspath, data_sha1, pool));
+    SVN_ERR(svn_wc__db_pristine_check(&present, db, wc_abspath, data_sha1,
+                                      pool));
+    SVN_TEST_ASSERT(! present);
+    SVN_ERR(svn_io_check_path(pristine_abspath, &kind, pool));
+    SVN_TEST_ASSERT(kind == svn_node_none);
+  }
+
+  return SVN_NO_ERROR;
+}
+
+/* Install DATA as a pristine text in the working copy at WC_ABSPATH
+ * through DB, and set *SHA1 to its checksum. */
+static svn_error_t *
+install_text(svn_checksum_t **sha1,
+             svn_wc__db_t *db,
+             const char *wc_abspath,
+             const char *data,
+             apr_pool_t *pool)
+{
+  svn_wc__db_install_data_t *install_data;
+  svn_stream_t *pristine_stream;
+  svn_checksum_t *md5;
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                              &install_data, sha1, &md5,
+                                              db, wc_abspath, pool, pool));
+  SVN_ERR(svn_stream_puts(pristine_stream, data));
+  SVN_ERR(svn_stream_close(pristine_stream));
+  SVN_ERR(svn_wc__db_pristine_install(install_data, *sha1, md5, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Check that working copies share pristine texts through a shared
+ * pristine store and that cleanup only removes unused shared texts. */
+static svn_error_t *
+pristine_shared_store(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *wc1_abspath, *wc2_abspath;
+  const char *shared_abspath;
+  const char *pristine_abspath;
+  svn_config_t *config;
+  svn_checksum_t *sha1;
+  apr_finfo_t finfo;
+  svn_node_kind_t kind;
+  const char data[] = "Shared text";
+
+  SVN_ERR(create_repos_and_wc(&wc1_abspath, &db,
+                              "pristine_shared_store_1", opts, pool));
+  SVN_ERR(create_repos_and_wc(&wc2_abspath, &db,
+                              "pristine_shared_store_2", opts, pool));
+
+  shared_abspath = svn_test_data_path("pristine_shared_store", pool);
+  SVN_ERR(svn_io_remove_dir2(shared_abspath, TRUE, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(shared_abspath);
+
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set(config, SVN_CONFIG_SECTION_WORKING_COPY,
+                 SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE, shared_abspath);
+  SVN_ERR(svn_wc__db_open(&db, config, FALSE, TRUE, pool, pool));
+
+  /* The first install fills the shared store, the second one links. */
+  SVN_ERR(install_text(&sha1, db, wc1_abspath, data, pool));
+  SVN_ERR(install_text(&sha1, db, wc2_abspath, data, pool));
+
+  SVN_ERR(svn_wc__db_pristine_get_future_path(&pristine_abspath,
+                                              wc2_abspath, sha1,
+                                              pool, pool));
+  SVN_ERR(svn_io_stat(&finfo, pristine_abspath, APR_FINFO_NLINK, pool));
+  SVN_TEST_INT_ASSERT(finfo.nlink, 3);
+
+  /* Removing it from one working copy leaves the other one intact. */
+  SVN_ERR(svn_wc__db_pristine_remove(db, wc1_abspath, sha1, pool));
+  SVN_ERR(svn_wc__db_pristine_cleanup(db, wc1_abspath, pool));
+  {
+    svn_stream_t *contents;
+    svn_boolean_t same;
+
+    SVN_ERR(svn_wc__db_pristine_read(&contents, NULL, db, wc2_abspath, sha1,
+                                     pool, pool));
+    SVN_ERR(svn_stream_contents_same2(&same, contents,
+                                      svn_stream_from_string(
+                                        svn_string_create(data, pool), pool),
+                                      pool));
+    SVN_TEST_ASSERT(same);
+  }
+  SVN_ERR(svn_io_stat(&finfo, pristine_abspath, APR_FINFO_NLINK, pool));
+  SVN_TEST_INT_ASSERT(finfo.nlink, 2);
+
+  /* Once no working copy uses it, cleanup removes the shared copy. */
+  SVN_ERR(svn_wc__db_pristine_remove(db, wc2_abspath, sha1, pool));
+  SVN_ERR(svn_wc__db_pristine_cleanup(db, wc2_abspath, pool));
+  SVN_ERR(svn_io_check_path(svn_dirent_join_many(pool, shared_abspath,
+                                                 svn_dirent_basename(
+                                                   svn_dirent_dirname(
+                                                     pristine_abspath,
+                                                     pool), NULL),
+                                                 svn_dirent_basename(
+                                                   pristine_abspath, NULL),
+                                                 SVN_VA_NULL),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for fetch_text(). */
+typedef struct fetch_baton_t
+{
+  const char *text;
+  const char *repos_relpath;
+  svn_revnum_t revision;
+  int calls;
+} fetch_baton_t;
+
+/* Implements svn_wc__pristine_fetch_func_t, serving BATON->text as the
+ * text of any node and recording the location it was asked for. */
+static svn_error_t *
+fetch_text(void *baton,
+           svn_stream_t *stream,
+           const char *repos_root_url,
+           const char *repos_relpath,
+           svn_revnum_t revision,
+           apr_pool_t *scratch_pool)
+{
+  fetch_baton_t *fb = baton;
+
+  fb->repos_relpath = apr_pstrdup(scratch_pool, repos_relpath);
+  fb->revision = revision;
+  fb->calls++;
+
+  return svn_error_trace(svn_stream_puts(stream, fb->text));
+}
+
+/* Check that lazy working copies drop the pristine texts of repository
+ * nodes and fetch them again when they are read. */
+static svn_error_t *
+pristine_lazy(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_wc__db_t *db;
+  svn_config_t *config;
+  const svn_checksum_t *sha1;
+  const char *pristine_abspath;
+  svn_stream_t *contents;
+  svn_boolean_t present;
+  svn_boolean_t same;
+  fetch_baton_t fb = { "Lazy text\n" };
+
+  SVN_ERR(svn_test__sandbox_create(&b, "pristine_lazy", opts, pool));
+  SVN_ERR(sbox_file_write(&b, "f", fb.text));
+  SVN_ERR(sbox_wc_add(&b, "f"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  SVN_ERR(svn_config_create2(&config, FALSE, FALSE, pool));
+  svn_config_set_bool(config, SVN_CONFIG_SECTION_WORKING_COPY,
+                      SVN_CONFIG_OPTION_LAZY_PRISTINES, TRUE);
+  SVN_ERR(svn_wc__db_open(&db, config, FALSE, TRUE, pool, pool));
+
+  SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, &sha1, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL,
+                               db, sbox_wc_path(&b, "f"), pool, pool));
+  SVN_ERR(svn_wc__db_pristine_get_future_path(&pristine_abspath,
+                                              b.wc_abspath, sha1,
+                                              pool, pool));
+
+  /* Dehydrating removes the file, but not the pristine row. */
+  SVN_ERR(svn_wc__db_pristine_dehydrate(db, b.wc_abspath, pool));
+  SVN_ERR(svn_wc__db_pristine_check(&present, db, b.wc_abspath, sha1,
+                                    pool));
+  SVN_TEST_ASSERT(! present);
+
+  /* Without a way to fetch it, reading fails. */
+  SVN_TEST_ASSERT_ANY_ERROR(svn_wc__db_pristine_read(&contents, NULL, db,
+                                                     b.wc_abspath, sha1,
+                                                     pool, pool));
+
+  /* With one, it gets fetched once and then stays. */
+  svn_wc__db_set_pristine_fetch(db, fetch_text, &fb);
+  SVN_ERR(svn_wc__db_pristine_read(&contents, NULL, db, b.wc_abspath, sha1,
+                                   pool, pool));
+  SVN_ERR(svn_stream_contents_same2(&same, contents,
+                                    svn_stream_from_string(
+                                      svn_string_create(fb.text, pool),
+                                      pool),
+                                    pool));
+  SVN_TEST_ASSERT(same);
+  SVN_TEST_INT_ASSERT(fb.calls, 1);
+  SVN_TEST_STRING_ASSERT(fb.repos_relpath, "f");
+  SVN_TEST_INT_ASSERT(fb.revision, 1);
+
+  SVN_ERR(svn_wc__db_pristine_check(&present, db, b.wc_abspath, sha1,
+                                    pool));
+  SVN_TEST_ASSERT(present);
+  SVN_ERR(svn_wc__db_pristine_hydrate(db, b.wc_abspath, sha1, pool));
+  SVN_TEST_INT_ASSERT(fb.calls, 1);
+
+  return SVN_NO_ERROR;
+}
+
+/* Check that cleanup removes unreferenced pristines in batches and that
+ * it leaves them alone while the work queue is not empty. */
+static svn_error_t *
+pristine_cleanup_batches(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *wc_abspath;
+  apr_array_header_t *texts = apr_array_make(pool, 0,
+                                             sizeof(svn_checksum_t *));
+  svn_checksum_t *sha1;
+  svn_skel_t *work_item;
+  svn_boolean_t present;
+  int i;
+
+  SVN_ERR(create_repos_and_wc(&wc_abspath, &db,
+                              "pristine_cleanup_batches", opts, pool));
+
+  /* More than a single batch. */
+  for (i = 0; i < 600; ++i)
+    {
+      SVN_ERR(install_text(&sha1, db, wc_abspath,
+                           apr_psprintf(pool, "text %d\n", i), pool));
+      APR_ARRAY_PUSH(texts, svn_checksum_t *) = sha1;
+    }
+
+  SVN_ERR(svn_wc__db_pristine_cleanup(db, wc_abspath, pool));
+  for (i = 0; i < texts->nelts; ++i)
+    {
+      SVN_ERR(svn_wc__db_pristine_check(&present, db, wc_abspath,
+                                        APR_ARRAY_IDX(texts, i,
+                                                      svn_checksum_t *),
+                                        pool));
+      SVN_TEST_ASSERT(! present);
+    }
+
+  /* Queued work may still need unreferenced pristines. */
+  SVN_ERR(install_text(&sha1, db, wc_abspath, "queued\n", pool));
+  work_item = svn_skel__make_empty_list(pool);
+  svn_skel__prepend_int(0, work_item, pool);
+  SVN_ERR(svn_wc__db_wq_add(db, wc_abspath, work_item, pool));
+
+  SVN_ERR(svn_wc__db_pristine_cleanup(db, wc_abspath, pool));
+  SVN_ERR(svn_wc__db_pristine_check(&present, db, wc_abspath, sha1, pool));
+  SVN_TEST_ASSERT(present);
+
+  return SVN_NO_ERROR;
+}
+
 
 static int max_threads = -1;
 
@@ -318,6 +670,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pristine_delete_while_open"),
     SVN_TEST_OPTS_PASS(reject_mismatching_text,
                        "reject_mismatching_text"),
+    SVN_TEST_OPTS_PASS(pristine_compressed,
+                       "pristine_compressed"),
+    SVN_TEST_OPTS_PASS(pristine_shared_store,
+                       "pristine_shared_store"),
+    SVN_TEST_OPTS_PASS(pristine_lazy,
+                       "pristine_lazy"),
+    SVN_TEST_OPTS_PASS(pristine_cleanup_batches,
+                       "pristine_cleanup_batches"),
     SVN_TEST_NULL
   };
 
@@ -106,6 +106,11 @@ static const int slow_statements[] =
   /* Designed as slow to avoid penalty on other queries */
   STMT_SELECT_UNREFERENCED_PRISTINES,
 
+  /* Only used for pristine texts that are not stored locally, as there
+     is no index on NODES.checksum */
+  STMT_SELECT_PRISTINE_ORIGIN,
+  STMT_SELECT_DEHYDRATABLE_PRISTINES,
+
   /* Slow, but just if foreign keys are enabled:
    * STMT_DELETE_PRISTINE_IF_UNREFERENCED,
    */
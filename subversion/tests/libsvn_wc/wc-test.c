@@ -493,6 +493,266 @@ test_internal_file_modified(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_wc_status_func4_t, collecting STATUS->node_status in
+   the apr_hash_t BATON, keyed by LOCAL_ABSPATH. */
+static svn_error_t *
+collect_node_status(void *baton,
+                    const char *local_abspath,
+                    const svn_wc_status3_t *status,
+                    apr_pool_t *scratch_pool)
+{
+  apr_hash_t *statuses = baton;
+  apr_pool_t *pool = apr_hash_pool_get(statuses);
+  enum svn_wc_status_kind *node_status = apr_palloc(pool,
+                                                    sizeof(*node_status));
+
+  *node_status = status->node_status;
+  svn_hash_sets(statuses, apr_pstrdup(pool, local_abspath), node_status);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_walk_status_deep(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  apr_hash_t *statuses = apr_hash_make(pool);
+  enum svn_wc_status_kind *node_status;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "walk_status_deep", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* Local changes spread over several directories. */
+  SVN_ERR(sbox_file_write(&b, "A/D/G/pi", "new pi"));
+  SVN_ERR(sbox_file_write(&b, "A/B/E/alpha", "new alpha"));
+  SVN_ERR(sbox_file_write(&b, "A/C/unversioned", "new file"));
+  SVN_ERR(svn_io_remove_file2(sbox_wc_path(&b, "A/D/H/chi"), FALSE, pool));
+
+  SVN_ERR(svn_wc_walk_status(b.wc_ctx, b.wc_abspath, svn_depth_infinity,
+                             TRUE /* get_all */, FALSE /* no_ignore */,
+                             FALSE /* ignore_text_mods */, NULL,
+                             collect_node_status, statuses,
+                             NULL, NULL, pool));
+
+  /* The wc root, the greek tree and the unversioned file. */
+  SVN_TEST_INT_ASSERT(apr_hash_count(statuses), 22);
+
+  node_status = svn_hash_gets(statuses, sbox_wc_path(&b, "A/D/G/pi"));
+  SVN_TEST_ASSERT(node_status && *node_status == svn_wc_status_modified);
+  node_status = svn_hash_gets(statuses, sbox_wc_path(&b, "A/B/E/alpha"));
+  SVN_TEST_ASSERT(node_status && *node_status == svn_wc_status_modified);
+  node_status = svn_hash_gets(statuses, sbox_wc_path(&b, "A/C/unversioned"));
+  SVN_TEST_ASSERT(node_status && *node_status == svn_wc_status_unversioned);
+  node_status = svn_hash_gets(statuses, sbox_wc_path(&b, "A/D/H/chi"));
+  SVN_TEST_ASSERT(node_status && *node_status == svn_wc_status_missing);
+  node_status = svn_hash_gets(statuses, sbox_wc_path(&b, "A/D/H/psi"));
+  SVN_TEST_ASSERT(node_status && *node_status == svn_wc_status_normal);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_wc__dir_changed_func_t, reporting the svn_boolean_t
+   at BATON for all directories. */
+static svn_error_t *
+fixed_dir_changed(svn_boolean_t *changed,
+                  void *baton,
+                  const char *local_abspath,
+                  apr_time_t since,
+                  apr_pool_t *scratch_pool)
+{
+  *changed = *(svn_boolean_t *)baton;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_walk_status_dirent_cache(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  apr_hash_t *statuses;
+  enum svn_wc_status_kind *node_status;
+  svn_boolean_t changed = FALSE;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "walk_status_dirent_cache",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+  SVN_ERR(svn_wc__status_set_dir_changed_func(b.wc_ctx, fixed_dir_changed,
+                                              &changed));
+
+  /* The first walk fills the cache. */
+  statuses = apr_hash_make(pool);
+  SVN_ERR(svn_wc_walk_status(b.wc_ctx, b.wc_abspath, svn_depth_infinity,
+                             TRUE, FALSE, FALSE, NULL,
+                             collect_node_status, statuses,
+                             NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(statuses), 21);
+
+  /* Change a file behind the back of the "watcher".  The walk trusts the
+     remembered listing and does not notice the new file size. */
+  SVN_ERR(sbox_file_write(&b, "A/D/G/pi", "a new and longer pi"));
+  statuses = apr_hash_make(pool);
+  SVN_ERR(svn_wc_walk_status(b.wc_ctx, b.wc_abspath, svn_depth_infinity,
+                             TRUE, FALSE, FALSE, NULL,
+                             collect_node_status, statuses,
+                             NULL, NULL, pool));
+  node_status = svn_hash_gets(statuses, sbox_wc_path(&b, "A/D/G/pi"));
+  SVN_TEST_ASSERT(node_status && *node_status == svn_wc_status_normal);
+
+  /* Once the change gets reported, the walk reads the directory again. */
+  changed = TRUE;
+  statuses = apr_hash_make(pool);
+  SVN_ERR(svn_wc_walk_status(b.wc_ctx, b.wc_abspath, svn_depth_infinity,
+                             TRUE, FALSE, FALSE, NULL,
+                             collect_node_status, statuses,
+                             NULL, NULL, pool));
+  node_status = svn_hash_gets(statuses, sbox_wc_path(&b, "A/D/G/pi"));
+  SVN_TEST_ASSERT(node_status && *node_status == svn_wc_status_modified);
+
+  SVN_ERR(svn_wc__status_set_dir_changed_func(b.wc_ctx, NULL, NULL));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_file_install_batch(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  apr_hash_t *statuses = apr_hash_make(pool);
+  apr_hash_index_t *hi;
+  svn_stringbuf_t *contents;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "file_install_batch", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* Remove everything, then install all files again in one go. */
+  SVN_ERR(sbox_wc_update(&b, "", 0));
+  SVN_ERR(sbox_wc_update(&b, "", 1));
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, sbox_wc_path(&b, "A/D/H/psi"),
+                                   pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'psi'.\n");
+  SVN_ERR(svn_stringbuf_from_file2(&contents, sbox_wc_path(&b, "iota"),
+                                   pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'iota'.\n");
+
+  /* All files must be unmodified, with their file info recorded. */
+  SVN_ERR(svn_wc_walk_status(b.wc_ctx, b.wc_abspath, svn_depth_infinity,
+                             TRUE, FALSE, FALSE, NULL,
+                             collect_node_status, statuses,
+                             NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(statuses), 21);
+
+  for (hi = apr_hash_first(pool, statuses); hi; hi = apr_hash_next(hi))
+    {
+      enum svn_wc_status_kind *node_status = apr_hash_this_val(hi);
+
+      SVN_TEST_ASSERT(*node_status == svn_wc_status_normal);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Assert that the working file, its text base and its text in the
+   HEAD revision of the repository of B have the same checksums. */
+static svn_error_t *
+check_committed_text(svn_test__sandbox_t *b,
+                     svn_fs_root_t *head,
+                     const char *path,
+                     apr_pool_t *scratch_pool)
+{
+  const char *local_abspath = sbox_wc_path(b, path);
+  svn_checksum_t *local_md5, *local_sha1;
+  svn_checksum_t *pristine_sha1, *repos_md5;
+  svn_stream_t *pristine;
+
+  SVN_ERR(svn_io_file_checksum2(&local_md5, local_abspath, svn_checksum_md5,
+                                scratch_pool));
+  SVN_ERR(svn_io_file_checksum2(&local_sha1, local_abspath,
+                                svn_checksum_sha1, scratch_pool));
+
+  SVN_ERR(svn_wc_get_pristine_contents2(&pristine, b->wc_ctx, local_abspath,
+                                        scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_contents_checksum(&pristine_sha1, pristine,
+                                       svn_checksum_sha1,
+                                       scratch_pool, scratch_pool));
+  SVN_TEST_ASSERT(svn_checksum_match(local_sha1, pristine_sha1));
+
+  SVN_ERR(svn_fs_file_checksum(&repos_md5, svn_checksum_md5, head,
+                               apr_pstrcat(scratch_pool, "/", path,
+                                           SVN_VA_NULL),
+                               TRUE, scratch_pool));
+  SVN_TEST_ASSERT(svn_checksum_match(local_md5, repos_md5));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_transmit_text_deltas_batch(const svn_test_opts_t *opts,
+                                apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_stringbuf_t *big = svn_stringbuf_create_empty(pool);
+  apr_uint32_t seed = 1;
+  svn_repos_t *repos;
+  svn_fs_root_t *head;
+  svn_revnum_t youngest;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "transmit_text_deltas_batch", opts,
+                                   pool));
+  SVN_ERR(sbox_wc_mkdir(&b, "A"));
+
+  /* Many more files than threads computing deltas. */
+  for (i = 0; i < 40; i++)
+    {
+      const char *path = apr_psprintf(pool, "A/f%d", i);
+
+      SVN_ERR(sbox_file_write(&b, path,
+                              apr_psprintf(pool, "This is file %d.\n", i)));
+      SVN_ERR(sbox_wc_add(&b, path));
+    }
+
+  /* And one whose delta does not fit into memory.  Pseudo-random text
+     can't be represented by a much smaller delta. */
+  while (big->len < 3 * 1024 * 1024)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(big, (char)('a' + (seed >> 16) % 26));
+    }
+  SVN_ERR(sbox_file_write(&b, "A/big", big->data));
+  SVN_ERR(sbox_wc_add(&b, "A/big"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* Now send deltas against the text bases. */
+  for (i = 0; i < 40; i++)
+    SVN_ERR(sbox_file_write(&b, apr_psprintf(pool, "A/f%d", i),
+                            apr_psprintf(pool, "This is file %d, modified.\n",
+                                         i)));
+  big->data[big->len / 2] = 'Z';
+  svn_stringbuf_appendcstr(big, "The end.\n");
+  SVN_ERR(sbox_file_write(&b, "A/big", big->data));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  SVN_ERR(svn_repos_open3(&repos, b.repos_dir, NULL, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, svn_repos_fs(repos), pool));
+  SVN_TEST_INT_ASSERT(youngest, 2);
+  SVN_ERR(svn_fs_revision_root(&head, svn_repos_fs(repos), youngest, pool));
+
+  for (i = 0; i < 40; i++)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_committed_text(&b, head,
+                                   apr_psprintf(iterpool, "A/f%d", i),
+                                   iterpool));
+    }
+  SVN_ERR(check_committed_text(&b, head, "A/big", iterpool));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* ---------------------------------------------------------------------- */
 /* The list of test functions */
 
@@ -515,6 +775,14 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test legacy commit2"),
     SVN_TEST_OPTS_PASS(test_internal_file_modified,
                        "test internal_file_modified"),
+    SVN_TEST_OPTS_PASS(test_walk_status_deep,
+                       "test svn_wc_walk_status on a deep tree"),
+    SVN_TEST_OPTS_PASS(test_walk_status_dirent_cache,
+                       "test status walks reusing directory listings"),
+    SVN_TEST_OPTS_PASS(test_file_install_batch,
+                       "test installing many files at once"),
+    SVN_TEST_OPTS_PASS(test_transmit_text_deltas_batch,
+                       "test committing many text deltas at once"),
     SVN_TEST_NULL
   };
 